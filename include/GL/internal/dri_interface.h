@@ -439,7 +439,7 @@ struct __DRIdamageExtensionRec {
  * SWRast Loader extension.
  */
 #define __DRI_SWRAST_LOADER "DRI_SWRastLoader"
-#define __DRI_SWRAST_LOADER_VERSION 1
+#define __DRI_SWRAST_LOADER_VERSION 2
 struct __DRIswrastLoaderExtensionRec {
     __DRIextension base;
 
@@ -463,6 +463,19 @@ struct __DRIswrastLoaderExtensionRec {
     void (*getImage)(__DRIdrawable *readable,
 		     int x, int y, int width, int height,
 		     char *data, void *loaderPrivate);
+
+    /**
+     * Put image to drawable, from a SysV shared memory segment the driver
+     * has attached at shmaddr.  The loader may display it with MIT-SHM
+     * instead of sending the pixels through the connection.  The driver
+     * may draw into the image again as soon as this returns.
+     *
+     * \since 2
+     */
+    void (*putImageShm)(__DRIdrawable *drawable, int op,
+			int x, int y, int width, int height, int stride,
+			int shmid, char *shmaddr, unsigned offset,
+			void *loaderPrivate);
 };
 
 /**
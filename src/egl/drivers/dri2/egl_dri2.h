@@ -178,6 +178,8 @@ struct dri2_egl_surface
    int                  bytes_per_pixel;
    xcb_gcontext_t       gc;
    xcb_gcontext_t       swapgc;
+   unsigned             back_name; /* name of the buffer rendered to */
+   int                  back_age;  /* EGL_BUFFER_AGE_EXT of back_name */
 #endif
 
 #ifdef HAVE_WAYLAND_PLATFORM
@@ -205,6 +205,8 @@ dri2_create_surface(_EGLDriver *drv, _EGLDisplay *disp, EGLint type,
       goto cleanup_surf;
 
    dri2_surf->region = XCB_NONE;
+   dri2_surf->back_name = 0;
+   dri2_surf->back_age = 0;
    if (type == EGL_PBUFFER_BIT) {
       dri2_surf->drawable = xcb_generate_id(dri2_dpy->conn);
       s = xcb_setup_roots_iterator(xcb_get_setup(dri2_dpy->conn));
@@ -355,6 +357,7 @@ dri2_process_buffers(struct dri2_egl_surface *dri2_surf,
    struct dri2_egl_display *dri2_dpy =
       dri2_egl_display(dri2_surf->base.Resource.Display);
    xcb_rectangle_t rectangle;
+   unsigned back_name = 0;
    unsigned i;
 
    dri2_surf->buffer_count = count;
@@ -376,6 +379,16 @@ dri2_process_buffers(struct dri2_egl_surface *dri2_surf,
        * to the same window must see the same aux buffers. */
       if (dri2_surf->buffers[i].attachment == __DRI_BUFFER_FAKE_FRONT_LEFT)
          dri2_surf->have_fake_front = 1;
+
+      if (dri2_surf->buffers[i].attachment == __DRI_BUFFER_FAKE_FRONT_LEFT ||
+          dri2_surf->buffers[i].attachment == __DRI_BUFFER_BACK_LEFT)
+         back_name = dri2_surf->buffers[i].name;
+   }
+
+   /* A new buffer to render to has no contents worth keeping */
+   if (back_name != dri2_surf->back_name) {
+      dri2_surf->back_name = back_name;
+      dri2_surf->back_age = 0;
    }
 
    if (dri2_surf->region != XCB_NONE)
@@ -704,6 +717,9 @@ dri2_copy_region(_EGLDriver *drv, _EGLDisplay *disp,
 					   render_attachment);
    free(xcb_dri2_copy_region_reply(dri2_dpy->conn, cookie, NULL));
 
+   /* The copy leaves the rendered frame in the buffer */
+   dri2_surf->back_age = 1;
+
    return EGL_TRUE;
 }
 
@@ -733,6 +749,11 @@ dri2_swap_buffers_msc(_EGLDriver *drv, _EGLDisplay *disp, _EGLSurface *draw,
    if (dri2_dpy->flush)
       (*dri2_dpy->flush->flush)(dri2_surf->dri_drawable);
 
+   /* The server may flip or exchange buffers, so the contents of the
+    * next back buffer are unknown.
+    */
+   dri2_surf->back_age = 0;
+
    cookie = xcb_dri2_swap_buffers_unchecked(dri2_dpy->conn, dri2_surf->drawable,
                   msc_hi, msc_lo, divisor_hi, divisor_lo, remainder_hi, remainder_lo);
 
@@ -770,11 +791,15 @@ dri2_swap_buffers_region(_EGLDriver *drv, _EGLDisplay *disp, _EGLSurface *draw,
    struct dri2_egl_surface *dri2_surf = dri2_egl_surface(draw);
    EGLBoolean ret;
    xcb_xfixes_region_t region;
-   xcb_rectangle_t rectangles[16];
+   xcb_rectangle_t stack_rectangles[16];
+   xcb_rectangle_t *rectangles = stack_rectangles;
    int i;
 
-   if (numRects > (int)ARRAY_SIZE(rectangles))
-      return dri2_copy_region(drv, disp, draw, dri2_surf->region);
+   if (numRects > (int)ARRAY_SIZE(stack_rectangles)) {
+      rectangles = malloc(numRects * sizeof(*rectangles));
+      if (!rectangles)
+         return dri2_copy_region(drv, disp, draw, dri2_surf->region);
+   }
 
    for (i = 0; i < numRects; i++) {
       rectangles[i].x = rects[i * 4];
@@ -788,9 +813,53 @@ dri2_swap_buffers_region(_EGLDriver *drv, _EGLDisplay *disp, _EGLSurface *draw,
    ret = dri2_copy_region(drv, disp, draw, region);
    xcb_xfixes_destroy_region(dri2_dpy->conn, region);
 
+   if (rectangles != stack_rectangles)
+      free(rectangles);
+
    return ret;
 }
 
+/**
+ * Called via eglSwapBuffersWithDamageEXT().  Only the damaged rectangles
+ * are copied to the window, which keeps the back buffer intact so that
+ * EGL_BUFFER_AGE_EXT stays useful.
+ */
+static EGLBoolean
+dri2_swap_buffers_with_damage(_EGLDriver *drv, _EGLDisplay *disp,
+                              _EGLSurface *draw,
+                              const EGLint *rects, EGLint n_rects)
+{
+   if (n_rects == 0)
+      return dri2_swap_buffers(drv, disp, draw);
+
+   return dri2_swap_buffers_region(drv, disp, draw, n_rects, rects);
+}
+
+static EGLint
+dri2_query_buffer_age(_EGLDriver *drv, _EGLDisplay *disp, _EGLSurface *surf)
+{
+   struct dri2_egl_display *dri2_dpy = dri2_egl_display(disp);
+   struct dri2_egl_surface *dri2_surf = dri2_egl_surface(surf);
+   xcb_get_geometry_cookie_t cookie;
+   xcb_get_geometry_reply_t *reply;
+   EGLint age = dri2_surf->back_age;
+
+   if (surf->Type != EGL_WINDOW_BIT || !age)
+      return 0;
+
+   /* A resized window gets new buffers the next time we render */
+   cookie = xcb_get_geometry(dri2_dpy->conn, dri2_surf->drawable);
+   reply = xcb_get_geometry_reply(dri2_dpy->conn, cookie, NULL);
+   if (!reply)
+      return 0;
+   if (reply->width != dri2_surf->base.Width ||
+       reply->height != dri2_surf->base.Height)
+      age = 0;
+   free(reply);
+
+   return age;
+}
+
 static EGLBoolean
 dri2_post_sub_buffer(_EGLDriver *drv, _EGLDisplay *disp, _EGLSurface *draw,
 		     EGLint x, EGLint y, EGLint width, EGLint height)
@@ -968,6 +1037,8 @@ dri2_initialize_x11_swrast(_EGLDriver *drv, _EGLDisplay *disp)
    drv->API.CopyBuffers = dri2_copy_buffers;
 
    drv->API.SwapBuffersRegionNOK = NULL;
+   drv->API.SwapBuffersWithDamageEXT = NULL;
+   drv->API.QueryBufferAge = NULL;
    drv->API.CreateImageKHR  = NULL;
    drv->API.DestroyImageKHR = NULL;
    drv->API.CreateDRMImageMESA = NULL;
@@ -1089,8 +1160,10 @@ dri2_initialize_x11_dri2(_EGLDriver *drv, _EGLDisplay *disp)
    drv->API.CopyBuffers = dri2_copy_buffers;
    drv->API.CreateImageKHR = dri2_x11_create_image_khr;
    drv->API.SwapBuffersRegionNOK = dri2_swap_buffers_region;
+   drv->API.SwapBuffersWithDamageEXT = dri2_swap_buffers_with_damage;
    drv->API.PostSubBufferNV = dri2_post_sub_buffer;
    drv->API.SwapInterval = dri2_swap_interval;
+   drv->API.QueryBufferAge = dri2_query_buffer_age;
 
    dri2_dpy = calloc(1, sizeof *dri2_dpy);
    if (!dri2_dpy)
@@ -1174,6 +1247,8 @@ dri2_initialize_x11_dri2(_EGLDriver *drv, _EGLDisplay *disp)
    disp->Extensions.NOK_swap_region = EGL_TRUE;
    disp->Extensions.NOK_texture_from_pixmap = EGL_TRUE;
    disp->Extensions.NV_post_sub_buffer = EGL_TRUE;
+   disp->Extensions.EXT_buffer_age = EGL_TRUE;
+   disp->Extensions.EXT_swap_buffers_with_damage = EGL_TRUE;
 
 #ifdef HAVE_WAYLAND_PLATFORM
    disp->Extensions.WL_bind_wayland_display = EGL_TRUE;
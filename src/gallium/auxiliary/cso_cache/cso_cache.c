@@ -162,6 +162,43 @@ static INLINE void sanitize_hash(struct cso_cache *sc,
 }
 
 
+static int compare_ages(const void *a, const void *b)
+{
+   const unsigned age_a = *(const unsigned *)a;
+   const unsigned age_b = *(const unsigned *)b;
+
+   /* oldest first */
+   return age_a < age_b ? 1 : age_a > age_b ? -1 : 0;
+}
+
+unsigned cso_cache_lru_age(struct cso_hash *hash, int count)
+{
+   int hash_size = cso_hash_size(hash);
+   struct cso_hash_iter iter;
+   unsigned *ages, age;
+   int i = 0;
+
+   if (count <= 0)
+      return ~0u;
+   if (count >= hash_size)
+      return 0;
+
+   ages = MALLOC(hash_size * sizeof(unsigned));
+   if (!ages)
+      return 0;
+
+   for (iter = cso_hash_first_node(hash); !cso_hash_iter_is_null(iter);
+        iter = cso_hash_iter_next(iter))
+      ages[i++] = cso_hash_iter_age(iter);
+   assert(i == hash_size);
+
+   qsort(ages, hash_size, sizeof(unsigned), compare_ages);
+   age = ages[count - 1];
+   FREE(ages);
+
+   return age;
+}
+
 static INLINE void sanitize_cb(struct cso_hash *hash, enum cso_cache_type type,
                                int max_size, void *user_data)
 {
@@ -170,15 +207,19 @@ static INLINE void sanitize_cb(struct cso_hash *hash, enum cso_cache_type type,
    int hash_size = cso_hash_size(hash);
    int max_entries = (max_size > hash_size) ? max_size : hash_size;
    int to_remove =  (max_size < max_entries) * max_entries/4;
+   struct cso_hash_iter iter = cso_hash_first_node(hash);
+   unsigned min_age;
    if (hash_size > max_size)
       to_remove += hash_size - max_size;
-   while (to_remove) {
-      /*remove elements until we're good */
-      /*fixme: currently we pick the nodes to remove at random*/
-      struct cso_hash_iter iter = cso_hash_first_node(hash);
-      void  *cso = cso_hash_take(hash, cso_hash_iter_key(iter));
-      delete_cso(cso, type);
-      --to_remove;
+   /* remove the least recently used elements until we're good */
+   min_age = cso_cache_lru_age(hash, to_remove);
+   while (to_remove && !cso_hash_iter_is_null(iter)) {
+      if (cso_hash_iter_age(iter) >= min_age) {
+         delete_cso(cso_hash_iter_data(iter), type);
+         iter = cso_hash_erase(hash, iter);
+         --to_remove;
+      } else
+         iter = cso_hash_iter_next(iter);
    }
 }
 
@@ -216,7 +257,7 @@ void *cso_hash_find_data_from_template( struct cso_hash *hash,
 	  */
          return iter_data;
       }
-      iter = cso_hash_iter_next(iter);
+      iter = cso_hash_find_next(iter);
    }
    return NULL;
 }
@@ -229,9 +270,11 @@ struct cso_hash_iter cso_find_state_template(struct cso_cache *sc,
    struct cso_hash_iter iter = cso_find_state(sc, hash_key, type);
    while (!cso_hash_iter_is_null(iter)) {
       void *iter_data = cso_hash_iter_data(iter);
-      if (!memcmp(iter_data, templ, size))
+      if (!memcmp(iter_data, templ, size)) {
+         cso_hash_iter_touch(iter);
          return iter;
-      iter = cso_hash_iter_next(iter);
+      }
+      iter = cso_hash_find_next(iter);
    }
    return iter;
 }
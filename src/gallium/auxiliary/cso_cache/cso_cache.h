@@ -165,6 +165,13 @@ void cso_for_each_state(struct cso_cache *sc, enum cso_cache_type type,
 void * cso_take_state(struct cso_cache *sc, unsigned hash_key,
                       enum cso_cache_type type);
 
+/**
+ * Returns the smallest age, as given by cso_hash_iter_age(), of the \p count
+ * least recently used states of \p hash.  Sanitize callbacks evict the
+ * states at least that old.
+ */
+unsigned cso_cache_lru_age(struct cso_hash *hash, int count);
+
 void cso_set_maximum_cache_size(struct cso_cache *sc, int number);
 int cso_maximum_cache_size(const struct cso_cache *sc);
 
@@ -76,11 +76,30 @@ struct sampler_info
 
 
 
+/**
+ * Number of recently used states of each type which are compared with the
+ * template before looking it up in the cache's hash.
+ */
+#define CSO_FRONT_CACHE_SIZE 4
+
+/**
+ * Recently set states of one type.  The iterators stay valid until the
+ * sanitize callback removes states from the hash, which flushes this.
+ */
+struct cso_front_cache
+{
+   struct cso_hash_iter entries[CSO_FRONT_CACHE_SIZE];
+   unsigned next;   /**< entry to be replaced next */
+};
+
+
 struct cso_context {
    struct pipe_context *pipe;
    struct cso_cache *cache;
    struct u_vbuf *vbuf;
 
+   struct cso_front_cache front[CSO_CACHE_MAX];
+
    boolean has_geometry_shader;
    boolean has_streamout;
 
@@ -220,13 +239,20 @@ sanitize_hash(struct cso_hash *hash, enum cso_cache_type type,
    int max_entries = (max_size > hash_size) ? max_size : hash_size;
    int to_remove =  (max_size < max_entries) * max_entries/4;
    struct cso_hash_iter iter = cso_hash_first_node(hash);
+   unsigned min_age;
    if (hash_size > max_size)
       to_remove += hash_size - max_size;
-   while (to_remove) {
-      /*remove elements until we're good */
-      /*fixme: currently we pick the nodes to remove at random*/
+   if (!to_remove)
+      return;
+
+   memset(&ctx->front[type], 0, sizeof(ctx->front[type]));
+
+   /* remove the least recently used elements until we're good, skipping
+    * the bound ones */
+   min_age = cso_cache_lru_age(hash, to_remove);
+   while (to_remove && !cso_hash_iter_is_null(iter)) {
       void *cso = cso_hash_iter_data(iter);
-      if (delete_cso(ctx, cso, type)) {
+      if (cso_hash_iter_age(iter) >= min_age && delete_cso(ctx, cso, type)) {
          iter = cso_hash_erase(hash, iter);
          --to_remove;
       } else
@@ -234,6 +260,39 @@ sanitize_hash(struct cso_hash *hash, enum cso_cache_type type,
    }
 }
 
+
+/**
+ * Look for the template among the recently used states of its type.
+ * \return the cso_blend, cso_rasterizer etc. or NULL
+ */
+static INLINE void *
+front_cache_find(struct cso_context *ctx, enum cso_cache_type type,
+                 const void *templ, unsigned key_size)
+{
+   struct cso_front_cache *front = &ctx->front[type];
+   unsigned i;
+
+   for (i = 0; i < CSO_FRONT_CACHE_SIZE; i++) {
+      void *cso = cso_hash_iter_data(front->entries[i]);
+      if (cso && !memcmp(cso, templ, key_size)) {
+         /* keep it from being evicted from the hash */
+         cso_hash_iter_touch(front->entries[i]);
+         return cso;
+      }
+   }
+   return NULL;
+}
+
+static INLINE void
+front_cache_add(struct cso_context *ctx, enum cso_cache_type type,
+                struct cso_hash_iter iter)
+{
+   struct cso_front_cache *front = &ctx->front[type];
+
+   front->entries[front->next] = iter;
+   front->next = (front->next + 1) % CSO_FRONT_CACHE_SIZE;
+}
+
 static void cso_init_vbuf(struct cso_context *cso)
 {
    struct u_vbuf_caps caps;
@@ -347,6 +406,7 @@ void cso_release_all( struct cso_context *ctx )
       cso_cache_delete( ctx->cache );
       ctx->cache = NULL;
    }
+   memset(ctx->front, 0, sizeof(ctx->front));
 }
 
 
@@ -379,11 +439,19 @@ enum pipe_error cso_set_blend(struct cso_context *ctx,
 {
    unsigned key_size, hash_key;
    struct cso_hash_iter iter;
+   struct cso_blend *cached;
    void *handle;
 
    key_size = templ->independent_blend_enable ?
       sizeof(struct pipe_blend_state) :
       (char *)&(templ->rt[1]) - (char *)templ;
+
+   cached = front_cache_find(ctx, CSO_BLEND, templ, key_size);
+   if (cached) {
+      handle = cached->data;
+      goto bind;
+   }
+
    hash_key = cso_construct_key((void*)templ, key_size);
    iter = cso_find_state_template(ctx->cache, hash_key, CSO_BLEND,
                                   (void*)templ, key_size);
@@ -410,7 +478,9 @@ enum pipe_error cso_set_blend(struct cso_context *ctx,
    else {
       handle = ((struct cso_blend *)cso_hash_iter_data(iter))->data;
    }
+   front_cache_add(ctx, CSO_BLEND, iter);
 
+bind:
    if (ctx->blend != handle) {
       ctx->blend = handle;
       ctx->pipe->bind_blend_state(ctx->pipe, handle);
@@ -440,13 +510,22 @@ cso_set_depth_stencil_alpha(struct cso_context *ctx,
                             const struct pipe_depth_stencil_alpha_state *templ)
 {
    unsigned key_size = sizeof(struct pipe_depth_stencil_alpha_state);
-   unsigned hash_key = cso_construct_key((void*)templ, key_size);
-   struct cso_hash_iter iter = cso_find_state_template(ctx->cache,
-                                                       hash_key,
-                                                       CSO_DEPTH_STENCIL_ALPHA,
-                                                       (void*)templ, key_size);
+   unsigned hash_key;
+   struct cso_hash_iter iter;
+   struct cso_depth_stencil_alpha *cached;
    void *handle;
 
+   cached = front_cache_find(ctx, CSO_DEPTH_STENCIL_ALPHA, templ, key_size);
+   if (cached) {
+      handle = cached->data;
+      goto bind;
+   }
+
+   hash_key = cso_construct_key((void*)templ, key_size);
+   iter = cso_find_state_template(ctx->cache, hash_key,
+                                  CSO_DEPTH_STENCIL_ALPHA,
+                                  (void*)templ, key_size);
+
    if (cso_hash_iter_is_null(iter)) {
       struct cso_depth_stencil_alpha *cso =
          MALLOC(sizeof(struct cso_depth_stencil_alpha));
@@ -473,7 +552,9 @@ cso_set_depth_stencil_alpha(struct cso_context *ctx,
       handle = ((struct cso_depth_stencil_alpha *)
                 cso_hash_iter_data(iter))->data;
    }
+   front_cache_add(ctx, CSO_DEPTH_STENCIL_ALPHA, iter);
 
+bind:
    if (ctx->depth_stencil != handle) {
       ctx->depth_stencil = handle;
       ctx->pipe->bind_depth_stencil_alpha_state(ctx->pipe, handle);
@@ -503,13 +584,21 @@ enum pipe_error cso_set_rasterizer(struct cso_context *ctx,
                                    const struct pipe_rasterizer_state *templ)
 {
    unsigned key_size = sizeof(struct pipe_rasterizer_state);
-   unsigned hash_key = cso_construct_key((void*)templ, key_size);
-   struct cso_hash_iter iter = cso_find_state_template(ctx->cache,
-                                                       hash_key,
-                                                       CSO_RASTERIZER,
-                                                       (void*)templ, key_size);
+   unsigned hash_key;
+   struct cso_hash_iter iter;
+   struct cso_rasterizer *cached;
    void *handle = NULL;
 
+   cached = front_cache_find(ctx, CSO_RASTERIZER, templ, key_size);
+   if (cached) {
+      handle = cached->data;
+      goto bind;
+   }
+
+   hash_key = cso_construct_key((void*)templ, key_size);
+   iter = cso_find_state_template(ctx->cache, hash_key, CSO_RASTERIZER,
+                                  (void*)templ, key_size);
+
    if (cso_hash_iter_is_null(iter)) {
       struct cso_rasterizer *cso = MALLOC(sizeof(struct cso_rasterizer));
       if (!cso)
@@ -532,7 +621,9 @@ enum pipe_error cso_set_rasterizer(struct cso_context *ctx,
    else {
       handle = ((struct cso_rasterizer *)cso_hash_iter_data(iter))->data;
    }
+   front_cache_add(ctx, CSO_RASTERIZER, iter);
 
+bind:
    if (ctx->rasterizer != handle) {
       ctx->rasterizer = handle;
       ctx->pipe->bind_rasterizer_state(ctx->pipe, handle);
@@ -847,6 +938,7 @@ cso_set_vertex_elements(struct cso_context *ctx,
    struct cso_hash_iter iter;
    void *handle;
    struct cso_velems_state velems_state;
+   struct cso_velements *cached;
 
    if (vbuf) {
       u_vbuf_set_vertex_elements(vbuf, count, states);
@@ -862,6 +954,13 @@ cso_set_vertex_elements(struct cso_context *ctx,
    velems_state.count = count;
    memcpy(velems_state.velems, states,
           sizeof(struct pipe_vertex_element) * count);
+
+   cached = front_cache_find(ctx, CSO_VELEMENTS, &velems_state, key_size);
+   if (cached) {
+      handle = cached->data;
+      goto bind;
+   }
+
    hash_key = cso_construct_key((void*)&velems_state, key_size);
    iter = cso_find_state_template(ctx->cache, hash_key, CSO_VELEMENTS,
                                   (void*)&velems_state, key_size);
@@ -889,7 +988,9 @@ cso_set_vertex_elements(struct cso_context *ctx,
    else {
       handle = ((struct cso_velements *)cso_hash_iter_data(iter))->data;
    }
+   front_cache_add(ctx, CSO_VELEMENTS, iter);
 
+bind:
    if (ctx->velements != handle) {
       ctx->velements = handle;
       ctx->pipe->bind_vertex_elements_state(ctx->pipe, handle);
@@ -1009,11 +1110,20 @@ single_sampler(struct cso_context *ctx,
 
    if (templ != NULL) {
       unsigned key_size = sizeof(struct pipe_sampler_state);
-      unsigned hash_key = cso_construct_key((void*)templ, key_size);
-      struct cso_hash_iter iter =
-         cso_find_state_template(ctx->cache,
-                                 hash_key, CSO_SAMPLER,
-                                 (void *) templ, key_size);
+      struct cso_sampler *cached =
+         front_cache_find(ctx, CSO_SAMPLER, templ, key_size);
+      unsigned hash_key;
+      struct cso_hash_iter iter;
+
+      if (cached) {
+         info->samplers[idx] = cached->data;
+         return PIPE_OK;
+      }
+
+      hash_key = cso_construct_key((void*)templ, key_size);
+      iter = cso_find_state_template(ctx->cache,
+                                     hash_key, CSO_SAMPLER,
+                                     (void *) templ, key_size);
 
       if (cso_hash_iter_is_null(iter)) {
          struct cso_sampler *cso = MALLOC(sizeof(struct cso_sampler));
@@ -1037,6 +1147,7 @@ single_sampler(struct cso_context *ctx,
       else {
          handle = ((struct cso_sampler *)cso_hash_iter_data(iter))->data;
       }
+      front_cache_add(ctx, CSO_SAMPLER, iter);
    }
 
    info->samplers[idx] = handle;
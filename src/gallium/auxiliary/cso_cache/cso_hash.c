@@ -35,361 +35,291 @@
 
 #include "cso_hash.h"
 
-#define MAX(a, b) ((a > b) ? (a) : (b))
-
-static const int MinNumBits = 4;
-
-static const unsigned char prime_deltas[] = {
-   0,  0,  1,  3,  1,  5,  3,  3,  1,  9,  7,  5,  3,  9, 25,  3,
-   1, 21,  3, 21,  7, 15,  9,  5,  3, 29, 15,  0,  0,  0,  0,  0
-};
-
-static int primeForNumBits(int numBits)
-{
-   return (1 << numBits) + prime_deltas[numBits];
-}
-
 /*
-    Returns the smallest integer n such that
-    primeForNumBits(n) >= hint.
-*/
-static int countBits(int hint)
-{
-   int numBits = 0;
-   int bits = hint;
-
-   while (bits > 1) {
-      bits >>= 1;
-      numBits++;
-   }
+ * Open addressing with linear probing.  The keys live inline in the slot
+ * array, so a probe walks consecutive memory and only dereferences a node
+ * once its key matched.  The nodes themselves are allocated separately and
+ * never move, which keeps iterators valid across inserts and rehashes.
+ *
+ * Probing never wraps around: the slot array has numBuckets / 2 extra slots
+ * past the last home slot and the table is rehashed before more than half
+ * of numBuckets are used (live or deleted), so a probe always hits an
+ * empty slot before the end of the array.  Hence all entries with a given
+ * key come after the first of them in slot order, as cso_hash_find() and
+ * cso_hash_iter_next() rely on.
+ */
 
-   if (numBits >= (int)sizeof(prime_deltas)) {
-      numBits = sizeof(prime_deltas) - 1;
-   } else if (primeForNumBits(numBits) < hint) {
-      ++numBits;
-   }
-   return numBits;
-}
+static const int MinNumBits = 4;
 
 struct cso_node {
-   struct cso_node *next;
    unsigned key;
+   unsigned stamp;   /**< value of the hash's clock when last used */
    void *value;
+   int slot;         /**< index of the node in cso_hash::slots */
 };
 
-struct cso_hash_data {
-   struct cso_node *fakeNext;
-   struct cso_node **buckets;
-   int size;
-   int nodeSize;
-   short userNumBits;
-   short numBits;
-   int numBuckets;
+struct cso_slot {
+   unsigned key;
+   struct cso_node *node;   /**< NULL if empty, deleted_node if erased */
 };
 
 struct cso_hash {
-   union {
-      struct cso_hash_data *d;
-      struct cso_node      *e;
-   } data;
+   struct cso_slot *slots;
+   int numSlots;
+   int numBuckets;
+   int numBits;
+   int size;
+   int deleted;      /**< number of slots holding deleted_node */
+   unsigned clock;   /**< incremented for each cso_hash_iter_touch() */
 };
 
-static void *cso_data_allocate_node(struct cso_hash_data *hash)
+/* Marks erased slots, which have to be probed past but can be reused */
+static struct cso_node deleted_node;
+
+
+static INLINE int home_slot(const struct cso_hash *hash, unsigned key)
 {
-   return MALLOC(hash->nodeSize);
+   /* Fibonacci hashing, as keys like (layer << 8) | level would pile up
+    * in a few slots if only their low bits were used */
+   return (int)((key * 2654435769u) >> (32 - hash->numBits));
 }
 
-static void cso_free_node(struct cso_node *node)
+static INLINE boolean slot_is_used(const struct cso_slot *slot)
 {
-   FREE(node);
+   return slot->node && slot->node != &deleted_node;
 }
 
-static struct cso_node *
-cso_hash_create_node(struct cso_hash *hash,
-                      unsigned akey, void *avalue,
-                      struct cso_node **anextNode)
+static boolean cso_hash_rehash(struct cso_hash *hash, int numBits)
 {
-   struct cso_node *node = cso_data_allocate_node(hash->data.d);
+   struct cso_slot *oldSlots = hash->slots;
+   int oldNumSlots = hash->numSlots;
+   int numBuckets = 1 << numBits;
+   int numSlots = numBuckets + numBuckets / 2;
+   struct cso_slot *slots = CALLOC(numSlots, sizeof(struct cso_slot));
+   int i;
+
+   if (!slots)
+      return FALSE;
+
+   hash->slots = slots;
+   hash->numSlots = numSlots;
+   hash->numBuckets = numBuckets;
+   hash->numBits = numBits;
+   hash->deleted = 0;
+
+   for (i = 0; i < oldNumSlots; ++i) {
+      if (slot_is_used(&oldSlots[i])) {
+         struct cso_node *node = oldSlots[i].node;
+         int s = home_slot(hash, node->key);
+         while (slots[s].node)
+            ++s;
+         assert(s < numSlots);
+         slots[s].key = node->key;
+         slots[s].node = node;
+         node->slot = s;
+      }
+   }
 
-   if (!node)
-      return NULL;
+   FREE(oldSlots);
+   return TRUE;
+}
+
+/**
+ * Make room for one more entry, growing the table when more than a quarter
+ * of the buckets are live and otherwise just dropping the deleted slots.
+ */
+static boolean cso_hash_might_grow(struct cso_hash *hash)
+{
+   int numBits;
 
-   node->key = akey;
-   node->value = avalue;
+   if ((hash->size + hash->deleted + 1) * 2 <= hash->numBuckets)
+      return TRUE;
 
-   node->next = (struct cso_node*)(*anextNode);
-   *anextNode = node;
-   ++hash->data.d->size;
-   return node;
+   numBits = hash->numBits ? hash->numBits : MinNumBits;
+   while ((hash->size + 1) * 4 > (1 << numBits))
+      ++numBits;
+   return cso_hash_rehash(hash, numBits);
 }
 
-static void cso_data_rehash(struct cso_hash_data *hash, int hint)
+static void cso_hash_has_shrunk(struct cso_hash *hash)
 {
-   if (hint < 0) {
-      hint = countBits(-hint);
-      if (hint < MinNumBits)
-         hint = MinNumBits;
-      hash->userNumBits = (short)hint;
-      while (primeForNumBits(hint) < (hash->size >> 1))
-         ++hint;
-   } else if (hint < MinNumBits) {
-      hint = MinNumBits;
-   }
-
-   if (hash->numBits != hint) {
-      struct cso_node *e = (struct cso_node *)(hash);
-      struct cso_node **oldBuckets = hash->buckets;
-      int oldNumBuckets = hash->numBuckets;
-      int  i = 0;
-
-      hash->numBits = (short)hint;
-      hash->numBuckets = primeForNumBits(hint);
-      hash->buckets = MALLOC(sizeof(struct cso_node*) * hash->numBuckets);
-      for (i = 0; i < hash->numBuckets; ++i)
-         hash->buckets[i] = e;
-
-      for (i = 0; i < oldNumBuckets; ++i) {
-         struct cso_node *firstNode = oldBuckets[i];
-         while (firstNode != e) {
-            unsigned h = firstNode->key;
-            struct cso_node *lastNode = firstNode;
-            struct cso_node *afterLastNode;
-            struct cso_node **beforeFirstNode;
-            
-            while (lastNode->next != e && lastNode->next->key == h)
-               lastNode = lastNode->next;
-
-            afterLastNode = lastNode->next;
-            beforeFirstNode = &hash->buckets[h % hash->numBuckets];
-            while (*beforeFirstNode != e)
-               beforeFirstNode = &(*beforeFirstNode)->next;
-            lastNode->next = *beforeFirstNode;
-            *beforeFirstNode = firstNode;
-            firstNode = afterLastNode;
-         }
-      }
-      FREE(oldBuckets);
+   if (hash->numBits > MinNumBits && hash->size * 16 <= hash->numBuckets) {
+      int numBits = MinNumBits;
+      while (hash->size * 4 > (1 << numBits))
+         ++numBits;
+      cso_hash_rehash(hash, numBits);
    }
 }
 
-static void cso_data_might_grow(struct cso_hash_data *hash)
+/**
+ * Index of the first slot at or after \p start, within the probe sequence
+ * of \p key, holding an entry with that key, or -1.
+ */
+static int cso_hash_probe(const struct cso_hash *hash, unsigned key,
+                          int start)
 {
-   if (hash->size >= hash->numBuckets)
-      cso_data_rehash(hash, hash->numBits + 1);
+   const struct cso_slot *slots = hash->slots;
+   int s;
+
+   for (s = start; s < hash->numSlots && slots[s].node; ++s) {
+      if (slots[s].key == key && slots[s].node != &deleted_node)
+         return s;
+   }
+   return -1;
 }
 
-static void cso_data_has_shrunk(struct cso_hash_data *hash)
+static int cso_hash_find_slot(const struct cso_hash *hash, unsigned key)
 {
-   if (hash->size <= (hash->numBuckets >> 3) &&
-       hash->numBits > hash->userNumBits) {
-      int max = MAX(hash->numBits-2, hash->userNumBits);
-      cso_data_rehash(hash,  max);
-   }
+   if (!hash->numBuckets)
+      return -1;
+   return cso_hash_probe(hash, key, home_slot(hash, key));
 }
 
-static struct cso_node *cso_data_first_node(struct cso_hash_data *hash)
+static struct cso_hash_iter cso_hash_iter_at(struct cso_hash *hash, int s)
 {
-   struct cso_node *e = (struct cso_node *)(hash);
-   struct cso_node **bucket = hash->buckets;
-   int n = hash->numBuckets;
-   while (n--) {
-      if (*bucket != e)
-         return *bucket;
-      ++bucket;
-   }
-   return e;
+   struct cso_hash_iter iter = {hash, s >= 0 ? hash->slots[s].node : NULL};
+   return iter;
 }
 
-static struct cso_node **cso_hash_find_node(struct cso_hash *hash, unsigned akey)
+static void cso_hash_remove_slot(struct cso_hash *hash, int s)
 {
-   struct cso_node **node;
-
-   if (hash->data.d->numBuckets) {
-      node = (struct cso_node **)(&hash->data.d->buckets[akey % hash->data.d->numBuckets]);
-      assert(*node == hash->data.e || (*node)->next);
-      while (*node != hash->data.e && (*node)->key != akey)
-         node = &(*node)->next;
-   } else {
-      node = (struct cso_node **)((const struct cso_node * const *)(&hash->data.e));
-   }
-   return node;
+   FREE(hash->slots[s].node);
+   hash->slots[s].node = &deleted_node;
+   --hash->size;
+   ++hash->deleted;
 }
 
 struct cso_hash_iter cso_hash_insert(struct cso_hash *hash,
                                        unsigned key, void *data)
 {
-   cso_data_might_grow(hash->data.d);
+   struct cso_hash_iter null_iter = {hash, NULL};
+   struct cso_node *node;
+   int s;
 
-   {
-      struct cso_node **nextNode = cso_hash_find_node(hash, key);
-      struct cso_node *node = cso_hash_create_node(hash, key, data, nextNode);
-      if (!node) {
-         struct cso_hash_iter null_iter = {hash, 0};
-         return null_iter;
-      }
+   if (!cso_hash_might_grow(hash))
+      return null_iter;
 
-      {
-         struct cso_hash_iter iter = {hash, node};
-         return iter;
-      }
+   node = MALLOC_STRUCT(cso_node);
+   if (!node)
+      return null_iter;
+
+   /* the first free slot of the probe sequence, deleted ones included */
+   s = home_slot(hash, key);
+   while (slot_is_used(&hash->slots[s]))
+      ++s;
+   assert(s < hash->numSlots);
+
+   if (hash->slots[s].node == &deleted_node)
+      --hash->deleted;
+
+   node->key = key;
+   node->value = data;
+   node->stamp = ++hash->clock;
+   node->slot = s;
+   hash->slots[s].key = key;
+   hash->slots[s].node = node;
+   ++hash->size;
+
+   {
+      struct cso_hash_iter iter = {hash, node};
+      return iter;
    }
 }
 
 struct cso_hash * cso_hash_create(void)
 {
-   struct cso_hash *hash = MALLOC_STRUCT(cso_hash);
+   struct cso_hash *hash = CALLOC_STRUCT(cso_hash);
    if (!hash)
       return NULL;
 
-   hash->data.d = MALLOC_STRUCT(cso_hash_data);
-   if (!hash->data.d) {
-      FREE(hash);
-      return NULL;
-   }
-
-   hash->data.d->fakeNext = 0;
-   hash->data.d->buckets = 0;
-   hash->data.d->size = 0;
-   hash->data.d->nodeSize = sizeof(struct cso_node);
-   hash->data.d->userNumBits = (short)MinNumBits;
-   hash->data.d->numBits = 0;
-   hash->data.d->numBuckets = 0;
-
    return hash;
 }
 
 void cso_hash_delete(struct cso_hash *hash)
 {
-   struct cso_node *e_for_x = (struct cso_node *)(hash->data.d);
-   struct cso_node **bucket = (struct cso_node **)(hash->data.d->buckets);
-   int n = hash->data.d->numBuckets;
-   while (n--) {
-      struct cso_node *cur = *bucket++;
-      while (cur != e_for_x) {
-         struct cso_node *next = cur->next;
-         cso_free_node(cur);
-         cur = next;
-      }
+   int i;
+
+   for (i = 0; i < hash->numSlots; ++i) {
+      if (slot_is_used(&hash->slots[i]))
+         FREE(hash->slots[i].node);
    }
-   FREE(hash->data.d->buckets);
-   FREE(hash->data.d);
+   FREE(hash->slots);
    FREE(hash);
 }
 
 struct cso_hash_iter cso_hash_find(struct cso_hash *hash,
                                      unsigned key)
 {
-   struct cso_node **nextNode = cso_hash_find_node(hash, key);
-   struct cso_hash_iter iter = {hash, *nextNode};
-   return iter;
+   return cso_hash_iter_at(hash, cso_hash_find_slot(hash, key));
+}
+
+struct cso_hash_iter cso_hash_find_next(struct cso_hash_iter iter)
+{
+   if (!iter.node)
+      return iter;
+   return cso_hash_iter_at(iter.hash,
+                           cso_hash_probe(iter.hash, iter.node->key,
+                                          iter.node->slot + 1));
 }
 
 unsigned cso_hash_iter_key(struct cso_hash_iter iter)
 {
-   if (!iter.node || iter.hash->data.e == iter.node)
+   if (!iter.node)
       return 0;
    return iter.node->key;
 }
 
 void * cso_hash_iter_data(struct cso_hash_iter iter)
 {
-   if (!iter.node || iter.hash->data.e == iter.node)
+   if (!iter.node)
       return 0;
    return iter.node->value;
 }
 
-static struct cso_node *cso_hash_data_next(struct cso_node *node)
+void cso_hash_iter_touch(struct cso_hash_iter iter)
 {
-   union {
-      struct cso_node *next;
-      struct cso_node *e;
-      struct cso_hash_data *d;
-   } a;
-   int start;
-   struct cso_node **bucket;
-   int n;
-
-   a.next = node->next;
-   if (!a.next) {
-      debug_printf("iterating beyond the last element\n");
-      return 0;
-   }
-   if (a.next->next)
-      return a.next;
-
-   start = (node->key % a.d->numBuckets) + 1;
-   bucket = a.d->buckets + start;
-   n = a.d->numBuckets - start;
-   while (n--) {
-      if (*bucket != a.e)
-         return *bucket;
-      ++bucket;
-   }
-   return a.e;
+   if (!iter.node)
+      return;
+   iter.node->stamp = ++iter.hash->clock;
 }
 
-
-static struct cso_node *cso_hash_data_prev(struct cso_node *node)
+unsigned cso_hash_iter_age(struct cso_hash_iter iter)
 {
-   union {
-      struct cso_node *e;
-      struct cso_hash_data *d;
-   } a;
-   int start;
-   struct cso_node *sentinel;
-   struct cso_node **bucket;
-
-   a.e = node;
-   while (a.e->next)
-      a.e = a.e->next;
-
-   if (node == a.e)
-      start = a.d->numBuckets - 1;
-   else
-      start = node->key % a.d->numBuckets;
-
-   sentinel = node;
-   bucket = a.d->buckets + start;
-   while (start >= 0) {
-      if (*bucket != sentinel) {
-         struct cso_node *prev = *bucket;
-         while (prev->next != sentinel)
-            prev = prev->next;
-         return prev;
-      }
-
-      sentinel = a.e;
-      --bucket;
-      --start;
-   }
-   debug_printf("iterating backward beyond first element\n");
-   return a.e;
+   if (!iter.node)
+      return 0;
+   /* Unsigned arithmetic keeps this right across wrap-arounds of the clock */
+   return iter.hash->clock - iter.node->stamp;
 }
 
 struct cso_hash_iter cso_hash_iter_next(struct cso_hash_iter iter)
 {
-   struct cso_hash_iter next = {iter.hash, cso_hash_data_next(iter.node)};
-   return next;
+   int s;
+
+   if (!iter.node) {
+      debug_printf("iterating beyond the last element\n");
+      return iter;
+   }
+
+   for (s = iter.node->slot + 1; s < iter.hash->numSlots; ++s) {
+      if (slot_is_used(&iter.hash->slots[s]))
+         return cso_hash_iter_at(iter.hash, s);
+   }
+   return cso_hash_iter_at(iter.hash, -1);
 }
 
 int cso_hash_iter_is_null(struct cso_hash_iter iter)
 {
-   if (!iter.node || iter.node == iter.hash->data.e)
-      return 1;
-   return 0;
+   return !iter.node;
 }
 
 void * cso_hash_take(struct cso_hash *hash,
                       unsigned akey)
 {
-   struct cso_node **node = cso_hash_find_node(hash, akey);
-   if (*node != hash->data.e) {
-      void *t = (*node)->value;
-      struct cso_node *next = (*node)->next;
-      cso_free_node(*node);
-      *node = next;
-      --hash->data.d->size;
-      cso_data_has_shrunk(hash->data.d);
+   int s = cso_hash_find_slot(hash, akey);
+   if (s >= 0) {
+      void *t = hash->slots[s].node->value;
+      cso_hash_remove_slot(hash, s);
+      cso_hash_has_shrunk(hash);
       return t;
    }
    return 0;
@@ -397,43 +327,47 @@ void * cso_hash_take(struct cso_hash *hash,
 
 struct cso_hash_iter cso_hash_iter_prev(struct cso_hash_iter iter)
 {
-   struct cso_hash_iter prev = {iter.hash,
-                                 cso_hash_data_prev(iter.node)};
-   return prev;
+   int s = iter.node ? iter.node->slot : iter.hash->numSlots;
+
+   while (--s >= 0) {
+      if (slot_is_used(&iter.hash->slots[s]))
+         return cso_hash_iter_at(iter.hash, s);
+   }
+   debug_printf("iterating backward beyond first element\n");
+   return cso_hash_iter_at(iter.hash, -1);
 }
 
 struct cso_hash_iter cso_hash_first_node(struct cso_hash *hash)
 {
-   struct cso_hash_iter iter = {hash, cso_data_first_node(hash->data.d)};
-   return iter;
+   int s;
+
+   for (s = 0; s < hash->numSlots; ++s) {
+      if (slot_is_used(&hash->slots[s]))
+         return cso_hash_iter_at(hash, s);
+   }
+   return cso_hash_iter_at(hash, -1);
 }
 
 int cso_hash_size(struct cso_hash *hash)
 {
-   return hash->data.d->size;
+   return hash->size;
 }
 
 struct cso_hash_iter cso_hash_erase(struct cso_hash *hash, struct cso_hash_iter iter)
 {
-   struct cso_hash_iter ret = iter;
-   struct cso_node *node = iter.node;
-   struct cso_node **node_ptr;
+   struct cso_hash_iter ret;
 
-   if (node == hash->data.e)
+   if (!iter.node)
       return iter;
 
-   ret = cso_hash_iter_next(ret);
-   node_ptr = (struct cso_node**)(&hash->data.d->buckets[node->key % hash->data.d->numBuckets]);
-   while (*node_ptr != node)
-      node_ptr = &(*node_ptr)->next;
-   *node_ptr = node->next;
-   cso_free_node(node);
-   --hash->data.d->size;
+   /* Erased slots are only reclaimed by the next rehash, so the slots of
+    * the remaining entries, and thus the iteration order, stay put */
+   ret = cso_hash_iter_next(iter);
+   cso_hash_remove_slot(hash, iter.node->slot);
    return ret;
 }
 
 boolean cso_hash_contains(struct cso_hash *hash, unsigned key)
 {
-   struct cso_node **node = cso_hash_find_node(hash, key);
-   return (*node != hash->data.e);
+   return cso_hash_find_slot(hash, key) >= 0;
 }
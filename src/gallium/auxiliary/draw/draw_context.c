@@ -930,6 +930,20 @@ draw_get_shader_param(unsigned shader, enum pipe_shader_cap param)
    return draw_get_shader_param_no_llvm(shader, param);
 }
 
+/**
+ * Bytes of machine code held by the LLVM vertex and geometry shader
+ * variants, for reporting.
+ */
+size_t
+draw_get_shader_code_size(const struct draw_context *draw)
+{
+#ifdef HAVE_LLVM
+   if (draw->llvm)
+      return draw->llvm->code_size;
+#endif
+   return 0;
+}
+
 /**
  * Enables or disables collection of statistics.
  *
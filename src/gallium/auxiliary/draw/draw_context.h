@@ -277,6 +277,9 @@ draw_get_shader_param(unsigned shader, enum pipe_shader_cap param);
 int
 draw_get_shader_param_no_llvm(unsigned shader, enum pipe_shader_cap param);
 
+size_t
+draw_get_shader_code_size(const struct draw_context *draw);
+
 #ifdef HAVE_LLVM
 boolean
 draw_get_option_use_llvm(void);
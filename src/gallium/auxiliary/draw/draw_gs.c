@@ -295,7 +295,7 @@ llvm_fetch_gs_outputs(struct draw_geometry_shader *shader,
    int max_prims_per_invocation = 0;
    char *output_ptr = (char*)shader->gs_output;
    int i, j, prim_idx;
-   unsigned next_prim_boundary = shader->primitive_boundary;
+   unsigned next_prim_boundary = shader->max_output_vertices;
 
    for (i = 0; i < shader->vector_length; ++i) {
       int prims = shader->llvm_emitted_primitives[i];
@@ -306,6 +306,9 @@ llvm_fetch_gs_outputs(struct draw_geometry_shader *shader,
       total_verts += shader->llvm_emitted_vertices[i];
    }
 
+   /* Each lane's vertices start at a multiple of max_output_vertices, so
+    * only the lanes which follow one that emitted fewer have to be moved.
+    */
    output_ptr += shader->emitted_vertices * shader->vertex_size;
    for (i = 0; i < shader->vector_length - 1; ++i) {
       int current_verts = shader->llvm_emitted_vertices[i];
@@ -322,7 +325,8 @@ llvm_fetch_gs_outputs(struct draw_geometry_shader *shader,
 #endif
       debug_assert(current_verts <= shader->max_output_vertices);
       debug_assert(next_verts <= shader->max_output_vertices);
-      if (next_verts) {
+      if (next_verts &&
+          vertex_count + current_verts != (i + 1) * next_prim_boundary) {
          memmove(output_ptr + (vertex_count + current_verts) * shader->vertex_size,
                  output_ptr + ((i + 1) * next_prim_boundary) * shader->vertex_size,
                  shader->vertex_size * next_verts);
@@ -782,6 +786,9 @@ draw_create_geometry_shader(struct draw_context *draw,
     * overflown.
     * So we need some scratch area where we can keep writing the overflown 
     * vertices without overwriting anything important or crashing.
+    * The llvm path lays the lanes out max_output_vertices apart and keeps
+    * a single scratch vertex after them, but the output buffer is still
+    * sized with the boundary.
     */
    gs->primitive_boundary = gs->max_output_vertices + 1;
 
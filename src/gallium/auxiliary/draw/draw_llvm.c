@@ -593,6 +593,8 @@ draw_llvm_create_variant(struct draw_llvm *llvm,
    variant->jit_func_elts = (draw_jit_vert_func_elts)
          gallivm_jit_function(variant->gallivm, variant->function_elts);
 
+   variant->code_size = variant->gallivm->code_size;
+
    variant->shader = shader;
    variant->list_item_global.base = variant;
    variant->list_item_local.base = variant;
@@ -637,6 +639,7 @@ generate_vs(struct draw_llvm_variant *variant,
                      outputs,
                      sampler,
                      &llvm->draw->vs.vertex_shader->info,
+                     NULL,
                      NULL);
 
    {
@@ -1383,18 +1386,33 @@ draw_gs_llvm_emit_vertex(const struct lp_build_tgsi_gs_iface *gs_base,
    LLVMValueRef clipmask = lp_build_const_int_vec(gallivm,
                                                   lp_int_type(gs_type), 0);
    LLVMValueRef indices[LP_MAX_VECTOR_LENGTH];
+   const unsigned max_output_vertices =
+      variant->shader->base.max_output_vertices;
    LLVMValueRef next_prim_offset =
-      lp_build_const_int32(gallivm, variant->shader->base.primitive_boundary);
+      lp_build_const_int32(gallivm, max_output_vertices);
+   LLVMValueRef scratch_index =
+      lp_build_const_int32(gallivm, gs_type.length * max_output_vertices);
    LLVMValueRef io = variant->io_ptr;
    unsigned i;
    const struct tgsi_shader_info *gs_info = &variant->shader->base.info;
 
+   /*
+    * Lane i writes its vertices at i * max_output_vertices, so lanes which
+    * emit the maximum end up packed already.  Channels which have
+    * overflown keep getting stored to, so they are sent to a scratch
+    * vertex past the last lane.
+    */
    for (i = 0; i < gs_type.length; ++i) {
       LLVMValueRef ind = lp_build_const_int32(gallivm, i);
       LLVMValueRef currently_emitted =
          LLVMBuildExtractElement(builder, emitted_vertices_vec, ind, "");
+      LLVMValueRef overflown =
+         LLVMBuildICmp(builder, LLVMIntUGE, currently_emitted,
+                       next_prim_offset, "");
       indices[i] = LLVMBuildMul(builder, ind, next_prim_offset, "");
       indices[i] = LLVMBuildAdd(builder, indices[i], currently_emitted, "");
+      indices[i] = LLVMBuildSelect(builder, overflown, scratch_index,
+                                   indices[i], "");
    }
 
    convert_to_aos(gallivm, io, indices,
@@ -1952,6 +1970,7 @@ draw_llvm_destroy_variant(struct draw_llvm_variant *variant)
    variant->shader->variants_cached--;
    remove_from_list(&variant->list_item_global);
    llvm->nr_variants--;
+   llvm->code_size -= variant->code_size;
    FREE(variant);
 }
 
@@ -2138,7 +2157,8 @@ draw_gs_llvm_generate(struct draw_llvm *llvm,
                      outputs,
                      sampler,
                      &llvm->draw->gs.geometry_shader->info,
-                     (const struct lp_build_tgsi_gs_iface *)&gs_iface);
+                     (const struct lp_build_tgsi_gs_iface *)&gs_iface,
+                     NULL);
 
    sampler->destroy(sampler);
 
@@ -2186,6 +2206,8 @@ draw_gs_llvm_create_variant(struct draw_llvm *llvm,
    variant->jit_func = (draw_gs_jit_func)
          gallivm_jit_function(variant->gallivm, variant->function);
 
+   variant->code_size = variant->gallivm->code_size;
+
    variant->list_item_global.base = variant;
    variant->list_item_local.base = variant;
    /*variant->no = */shader->variants_created++;
@@ -2210,6 +2232,7 @@ draw_gs_llvm_destroy_variant(struct draw_gs_llvm_variant *variant)
    variant->shader->variants_cached--;
    remove_from_list(&variant->list_item_global);
    llvm->nr_gs_variants--;
+   llvm->code_size -= variant->code_size;
    FREE(variant);
 }
 
@@ -387,6 +387,9 @@ struct draw_llvm_variant
    draw_jit_vert_func jit_func;
    draw_jit_vert_func_elts jit_func_elts;
 
+   /** Bytes of machine code held */
+   size_t code_size;
+
    struct llvm_vertex_shader *shader;
 
    struct draw_llvm *llvm;
@@ -413,6 +416,9 @@ struct draw_gs_llvm_variant
    LLVMValueRef function;
    draw_gs_jit_func jit_func;
 
+   /** Bytes of machine code held */
+   size_t code_size;
+
    struct llvm_geometry_shader *shader;
 
    struct draw_llvm *llvm;
@@ -453,6 +459,9 @@ struct draw_llvm {
 
    struct draw_gs_llvm_variant_list_item gs_variants_list;
    int nr_gs_variants;
+
+   /** Bytes of machine code held by all the vs and gs variants */
+   size_t code_size;
 };
 
 
@@ -109,19 +109,64 @@ void draw_pipeline_destroy( struct draw_context *draw )
 
 
 
+/**
+ * Note whether any of the vertices of a batch is outside a clip plane.
+ * The clip stage only passes on primitives whose vertices are all
+ * inside, so it can be skipped for batches which are trivially accepted
+ * as a whole.
+ */
+static void
+pipeline_begin_batch(struct draw_context *draw,
+                     const char *verts,
+                     unsigned stride,
+                     unsigned count)
+{
+   unsigned i;
+
+   draw->pipeline.bypass_clip = FALSE;
+
+   if (draw->pipeline.first != draw->pipeline.clip &&
+       draw->pipeline.first != draw->pipeline.validate)
+      return;
+
+   for (i = 0; i < count; i++) {
+      if (((const struct vertex_header *)(verts + i * stride))->clipmask)
+         return;
+   }
+
+   draw->pipeline.bypass_clip = TRUE;
+}
+
+
+/**
+ * The stage primitives enter the pipeline at.
+ */
+static INLINE struct draw_stage *
+pipeline_entry(struct draw_context *draw)
+{
+   struct draw_stage *first = draw->pipeline.first;
+
+   if (draw->pipeline.bypass_clip && first == draw->pipeline.clip)
+      return first->next;
+
+   return first;
+}
+
+
 /**
  * Build primitive to render a point with vertex at v0.
  */
 static void do_point( struct draw_context *draw,
 		      const char *v0 )
 {
+   struct draw_stage *stage = pipeline_entry(draw);
    struct prim_header prim;
    
    prim.flags = 0;
    prim.pad = 0;
    prim.v[0] = (struct vertex_header *)v0;
 
-   draw->pipeline.first->point( draw->pipeline.first, &prim );
+   stage->point( stage, &prim );
 }
 
 
@@ -134,6 +179,7 @@ static void do_line( struct draw_context *draw,
 		     const char *v0,
 		     const char *v1 )
 {
+   struct draw_stage *stage = pipeline_entry(draw);
    struct prim_header prim;
    
    prim.flags = flags;
@@ -141,7 +187,7 @@ static void do_line( struct draw_context *draw,
    prim.v[0] = (struct vertex_header *)v0;
    prim.v[1] = (struct vertex_header *)v1;
 
-   draw->pipeline.first->line( draw->pipeline.first, &prim );
+   stage->line( stage, &prim );
 }
 
 
@@ -155,6 +201,7 @@ static void do_triangle( struct draw_context *draw,
 			 char *v1,
 			 char *v2 )
 {
+   struct draw_stage *stage = pipeline_entry(draw);
    struct prim_header prim;
    
    prim.v[0] = (struct vertex_header *)v0;
@@ -163,7 +210,7 @@ static void do_triangle( struct draw_context *draw,
    prim.flags = flags;
    prim.pad = 0;
 
-   draw->pipeline.first->tri( draw->pipeline.first, &prim );
+   stage->tri( stage, &prim );
 }
 
 
@@ -233,6 +280,9 @@ void draw_pipeline_run( struct draw_context *draw,
    draw->pipeline.vertex_stride = vert_info->stride;
    draw->pipeline.vertex_count = vert_info->count;
 
+   pipeline_begin_batch(draw, draw->pipeline.verts,
+                        vert_info->stride, vert_info->count);
+
    for (start = i = 0;
         i < prim_info->primitive_count;
         start += prim_info->primitive_lengths[i], i++)
@@ -270,6 +320,7 @@ void draw_pipeline_run( struct draw_context *draw,
 
    draw->pipeline.verts = NULL;
    draw->pipeline.vertex_count = 0;
+   draw->pipeline.bypass_clip = FALSE;
 }
 
 
@@ -330,6 +381,8 @@ void draw_pipeline_run_linear( struct draw_context *draw,
 
       assert(count <= vert_info->count);
 
+      pipeline_begin_batch(draw, verts, vert_info->stride, count);
+
       pipe_run_linear(draw,
                       prim_info->prim,
                       prim_info->flags,
@@ -340,6 +393,7 @@ void draw_pipeline_run_linear( struct draw_context *draw,
 
    draw->pipeline.verts = NULL;
    draw->pipeline.vertex_count = 0;
+   draw->pipeline.bypass_clip = FALSE;
 }
 
 
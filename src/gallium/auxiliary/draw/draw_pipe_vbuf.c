@@ -450,6 +450,8 @@ struct draw_stage *draw_vbuf_stage( struct draw_context *draw,
    vbuf->cache = translate_cache_create();
    if (!vbuf->cache) 
       goto fail;
+
+   translate_cache_set_max_size(vbuf->cache, TRANSLATE_CACHE_DEFAULT_MAX_SIZE);
       
    
    vbuf->vertices = NULL;
@@ -99,6 +99,9 @@ struct vertex_header {
 /* maximum number of shader variants we can cache */
 #define DRAW_MAX_SHADER_VARIANTS 128
 
+/* maximum bytes of JIT'd code the vs and gs variants may hold together */
+#define DRAW_MAX_SHADER_CODE_SIZE (16*1024*1024)
+
 /**
  * Private context for the drawing module.
  */
@@ -138,6 +141,7 @@ struct draw_context
       char *verts;
       unsigned vertex_stride;
       unsigned vertex_count;
+      boolean bypass_clip; /**< no vertex of the batch needs clipping */
    } pipeline;
 
 
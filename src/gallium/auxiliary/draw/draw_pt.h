@@ -124,6 +124,11 @@ struct draw_pt_middle_end {
 
    int (*get_max_vertex_count)( struct draw_pt_middle_end * );
 
+   /* Optional.  Complete the processing of the vertices of the runs so
+    * far, which may have been deferred.  Called at the end of every draw.
+    */
+   void (*flush)( struct draw_pt_middle_end * );
+
    void (*finish)( struct draw_pt_middle_end * );
    void (*destroy)( struct draw_pt_middle_end * );
 };
@@ -214,6 +214,8 @@ draw_pt_fetch_create(struct draw_context *draw)
       return NULL;
    }
 
+   translate_cache_set_max_size(fetch->cache, TRANSLATE_CACHE_DEFAULT_MAX_SIZE);
+
    return fetch;
 }
 
@@ -319,6 +319,17 @@ static void fetch_pipeline_generic( struct draw_pt_middle_end *middle,
 
    draw_stats_clipper_primitives(draw, prim_info);
 
+   /* With rasterization discarded only the stream output matters, so
+    * skip clipping and the rest of the pipeline.
+    */
+   if (draw->rasterizer->rasterizer_discard) {
+      FREE(vert_info->verts);
+      if (free_prim_info) {
+         FREE(prim_info->primitive_lengths);
+      }
+      return;
+   }
+
    /*
     * if there's no position, need to stop now, or the latter stages
     * will try to access non-existent position output.
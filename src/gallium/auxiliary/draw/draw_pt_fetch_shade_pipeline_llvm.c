@@ -37,6 +37,46 @@
 #include "draw/draw_vs.h"
 #include "draw/draw_llvm.h"
 #include "gallivm/lp_bld_init.h"
+#include "os/os_thread.h"
+
+
+/** Max number of vertex shading threads, including the calling thread */
+#define DRAW_MAX_VS_THREADS 8
+
+/** Number of entries of the post-transform vertex cache (power of two) */
+#define DRAW_VCACHE_SIZE 1024
+
+
+struct llvm_middle_end;
+
+
+/**
+ * A run of the middle end whose vertices are shaded by one of the vertex
+ * shading threads.  The element lists are copied, as the front end
+ * reuses its buffers.
+ */
+struct llvm_segment {
+   struct draw_fetch_info fetch_info;
+   struct draw_prim_info prim_info;
+   unsigned draw_count;
+
+   unsigned *fetch_elts;
+   unsigned fetch_elts_size;
+   ushort *draw_elts;
+   unsigned draw_elts_size;
+
+   struct draw_vertex_info vert_info;
+   unsigned clipped;
+};
+
+
+struct llvm_vs_thread {
+   struct llvm_middle_end *fpme;
+   unsigned index;
+   pipe_thread thread;
+   pipe_semaphore work_ready;
+   pipe_semaphore work_done;
+};
 
 
 struct llvm_middle_end {
@@ -56,9 +96,49 @@ struct llvm_middle_end {
 
    struct draw_llvm *llvm;
    struct draw_llvm_variant *current_variant;
+
+   /*
+    * Parallel vertex shading (DRAW_VS_THREADS): runs are queued, one per
+    * thread, then shaded at once, and then go through the rest of the
+    * pipeline in order on the calling thread.
+    */
+   unsigned num_threads;
+   boolean threads_exit;
+   struct llvm_vs_thread threads[DRAW_MAX_VS_THREADS];
+   struct llvm_segment segments[DRAW_MAX_VS_THREADS];
+   unsigned num_segments;
+
+   /*
+    * Post-transform vertex cache for indexed runs, direct mapped on the
+    * fetch index.  An entry is only valid while its stamp matches, so
+    * bumping the stamp empties the cache; this is done at the end of
+    * each draw, as the vertex buffers and instance may change.
+    */
+   struct {
+      unsigned tags[DRAW_VCACHE_SIZE];
+      unsigned stamps[DRAW_VCACHE_SIZE];
+      unsigned stamp;
+      char *verts;
+      unsigned vertex_size;
+
+      unsigned *miss_elts;
+      unsigned miss_elts_size;
+      unsigned *miss_pos;
+      unsigned miss_pos_size;
+   } vcache;
 };
 
 
+static void
+vcache_invalidate(struct llvm_middle_end *fpme)
+{
+   if (++fpme->vcache.stamp == 0) {
+      memset(fpme->vcache.stamps, 0, sizeof fpme->vcache.stamps);
+      fpme->vcache.stamp = 1;
+   }
+}
+
+
 static void
 llvm_middle_end_prepare_gs(struct llvm_middle_end *fpme)
 {
@@ -94,11 +174,15 @@ llvm_middle_end_prepare_gs(struct llvm_middle_end *fpme)
       /* First check if we've created too many variants.  If so, free
        * 25% of the LRU to avoid using too much memory.
        */
-      if (fpme->llvm->nr_gs_variants >= DRAW_MAX_SHADER_VARIANTS) {
+      if (fpme->llvm->nr_gs_variants >= DRAW_MAX_SHADER_VARIANTS ||
+          fpme->llvm->code_size >= DRAW_MAX_SHADER_CODE_SIZE) {
          /*
           * XXX: should we flush here ?
           */
-         for (i = 0; i < DRAW_MAX_SHADER_VARIANTS / 4; i++) {
+         for (i = 0;
+              i < DRAW_MAX_SHADER_VARIANTS / 4 ||
+              fpme->llvm->code_size >= DRAW_MAX_SHADER_CODE_SIZE;
+              i++) {
             struct draw_gs_llvm_variant_list_item *item;
             if (is_empty_list(&fpme->llvm->gs_variants_list)) {
                break;
@@ -117,6 +201,7 @@ llvm_middle_end_prepare_gs(struct llvm_middle_end *fpme)
          insert_at_head(&fpme->llvm->gs_variants_list,
                         &variant->list_item_global);
          fpme->llvm->nr_gs_variants++;
+         fpme->llvm->code_size += variant->code_size;
          shader->variants_cached++;
       }
    }
@@ -216,11 +301,15 @@ llvm_middle_end_prepare( struct draw_pt_middle_end *middle,
          /* First check if we've created too many variants.  If so, free
           * 25% of the LRU to avoid using too much memory.
           */
-         if (fpme->llvm->nr_variants >= DRAW_MAX_SHADER_VARIANTS) {
+         if (fpme->llvm->nr_variants >= DRAW_MAX_SHADER_VARIANTS ||
+             fpme->llvm->code_size >= DRAW_MAX_SHADER_CODE_SIZE) {
             /*
              * XXX: should we flush here ?
              */
-            for (i = 0; i < DRAW_MAX_SHADER_VARIANTS / 4; i++) {
+            for (i = 0;
+                 i < DRAW_MAX_SHADER_VARIANTS / 4 ||
+                 fpme->llvm->code_size >= DRAW_MAX_SHADER_CODE_SIZE;
+                 i++) {
                struct draw_llvm_variant_list_item *item;
                if (is_empty_list(&fpme->llvm->vs_variants_list)) {
                   break;
@@ -239,6 +328,7 @@ llvm_middle_end_prepare( struct draw_pt_middle_end *middle,
             insert_at_head(&fpme->llvm->vs_variants_list,
                            &variant->list_item_global);
             fpme->llvm->nr_variants++;
+            fpme->llvm->code_size += variant->code_size;
             shader->variants_cached++;
          }
       }
@@ -246,6 +336,8 @@ llvm_middle_end_prepare( struct draw_pt_middle_end *middle,
       fpme->current_variant = variant;
    }
 
+   vcache_invalidate(fpme);
+
    if (gs) {
       llvm_middle_end_prepare_gs(fpme);
    }
@@ -308,46 +400,22 @@ static void emit(struct pt_emit *emit,
    }
 }
 
-static void
-llvm_pipeline_generic( struct draw_pt_middle_end *middle,
-                       const struct draw_fetch_info *fetch_info,
-                       const struct draw_prim_info *in_prim_info )
+/**
+ * Fetch, shade and cliptest the vertices.
+ * Doesn't touch any draw state, so it may run on the vertex shading
+ * threads too.
+ * \return  the clipping flags of the vertices
+ */
+static unsigned
+shade_vertices(struct llvm_middle_end *fpme,
+               const struct draw_fetch_info *fetch_info,
+               struct vertex_header *verts)
 {
-   struct llvm_middle_end *fpme = (struct llvm_middle_end *)middle;
    struct draw_context *draw = fpme->draw;
-   struct draw_geometry_shader *gshader = draw->gs.geometry_shader;
-   struct draw_prim_info gs_prim_info;
-   struct draw_vertex_info llvm_vert_info;
-   struct draw_vertex_info gs_vert_info;
-   struct draw_vertex_info *vert_info;
-   struct draw_prim_info ia_prim_info;
-   struct draw_vertex_info ia_vert_info;
-   const struct draw_prim_info *prim_info = in_prim_info;
-   boolean free_prim_info = FALSE;
-   unsigned opt = fpme->opt;
-   unsigned clipped = 0;
-
-   llvm_vert_info.count = fetch_info->count;
-   llvm_vert_info.vertex_size = fpme->vertex_size;
-   llvm_vert_info.stride = fpme->vertex_size;
-   llvm_vert_info.verts =
-      (struct vertex_header *)MALLOC(fpme->vertex_size *
-                                     align(fetch_info->count,  lp_native_vector_width / 32));
-   if (!llvm_vert_info.verts) {
-      assert(0);
-      return;
-   }
-
-   if (draw->collect_statistics) {
-      draw->statistics.ia_vertices += prim_info->count;
-      draw->statistics.ia_primitives +=
-         u_decomposed_prims_for_vertices(prim_info->prim, prim_info->count);
-      draw->statistics.vs_invocations += fetch_info->count;
-   }
 
    if (fetch_info->linear)
-      clipped = fpme->current_variant->jit_func( &fpme->llvm->jit_context,
-                                       llvm_vert_info.verts,
+      return fpme->current_variant->jit_func( &fpme->llvm->jit_context,
+                                       verts,
                                        draw->pt.user.vbuffer,
                                        fetch_info->start,
                                        fetch_info->count,
@@ -355,8 +423,8 @@ llvm_pipeline_generic( struct draw_pt_middle_end *middle,
                                        draw->pt.vertex_buffer,
                                        draw->instance_id);
    else
-      clipped = fpme->current_variant->jit_func_elts( &fpme->llvm->jit_context,
-                                            llvm_vert_info.verts,
+      return fpme->current_variant->jit_func_elts( &fpme->llvm->jit_context,
+                                            verts,
                                             draw->pt.user.vbuffer,
                                             fetch_info->elts,
                                             draw->pt.user.eltMax,
@@ -364,12 +432,181 @@ llvm_pipeline_generic( struct draw_pt_middle_end *middle,
                                             fpme->vertex_size,
                                             draw->pt.vertex_buffer,
                                             draw->instance_id);
+}
+
+
+static struct vertex_header *
+alloc_vertices(struct llvm_middle_end *fpme, unsigned count)
+{
+   return (struct vertex_header *)MALLOC(fpme->vertex_size *
+                                         align(count, lp_native_vector_width / 32));
+}
 
-   /* Finished with fetch and vs:
-    */
-   fetch_info = NULL;
-   vert_info = &llvm_vert_info;
 
+static boolean
+grow_elts(void **elts, unsigned *size, unsigned count, unsigned elt_size)
+{
+   if (count > *size) {
+      void *new_elts = REALLOC(*elts, *size * elt_size, count * elt_size);
+      if (!new_elts)
+         return FALSE;
+      *elts = new_elts;
+      *size = count;
+   }
+   return TRUE;
+}
+
+
+/**
+ * Make sure the cache storage matches the current vertex size.
+ */
+static boolean
+vcache_validate(struct llvm_middle_end *fpme, unsigned count)
+{
+   if (fpme->vcache.vertex_size != fpme->vertex_size) {
+      FREE(fpme->vcache.verts);
+      fpme->vcache.verts = MALLOC(DRAW_VCACHE_SIZE * fpme->vertex_size);
+      fpme->vcache.vertex_size = fpme->vcache.verts ? fpme->vertex_size : 0;
+      vcache_invalidate(fpme);
+   }
+
+   return fpme->vcache.verts &&
+          grow_elts((void **) &fpme->vcache.miss_elts,
+                    &fpme->vcache.miss_elts_size,
+                    count, sizeof fpme->vcache.miss_elts[0]) &&
+          grow_elts((void **) &fpme->vcache.miss_pos,
+                    &fpme->vcache.miss_pos_size,
+                    count, sizeof fpme->vcache.miss_pos[0]);
+}
+
+
+/**
+ * Like shade_vertices(), but for indexed runs: vertices already shaded
+ * earlier in the draw are copied out of the vertex cache, and only the
+ * remaining ones are run through the shader.
+ * \param num_shaded  returns the number of vertex shader invocations
+ */
+static unsigned
+shade_vertices_cached(struct llvm_middle_end *fpme,
+                      const struct draw_fetch_info *fetch_info,
+                      struct vertex_header *verts,
+                      unsigned *num_shaded)
+{
+   const unsigned vertex_size = fpme->vertex_size;
+   const unsigned count = fetch_info->count;
+   const unsigned *elts = fetch_info->elts;
+   unsigned *miss_elts, *miss_pos;
+   struct draw_fetch_info miss_info;
+   struct vertex_header *miss_verts;
+   unsigned num_misses = 0;
+   unsigned clipped = 0;
+   unsigned i;
+
+   if (!vcache_validate(fpme, count)) {
+      *num_shaded = count;
+      return shade_vertices(fpme, fetch_info, verts);
+   }
+
+   miss_elts = fpme->vcache.miss_elts;
+   miss_pos = fpme->vcache.miss_pos;
+
+   for (i = 0; i < count; i++) {
+      const unsigned slot = elts[i] & (DRAW_VCACHE_SIZE - 1);
+
+      if (fpme->vcache.stamps[slot] == fpme->vcache.stamp &&
+          fpme->vcache.tags[slot] == elts[i]) {
+         const struct vertex_header *vert = (const struct vertex_header *)
+            (fpme->vcache.verts + slot * vertex_size);
+
+         memcpy((char *)verts + i * vertex_size, vert, vertex_size);
+         if (vert->clipmask)
+            clipped = 1;
+      }
+      else {
+         miss_elts[num_misses] = elts[i];
+         miss_pos[num_misses] = i;
+         num_misses++;
+      }
+   }
+
+   *num_shaded = num_misses;
+   if (!num_misses)
+      return clipped;
+
+   /* With no hits at all the vertices can be shaded in place */
+   if (num_misses == count) {
+      miss_verts = verts;
+   }
+   else {
+      miss_verts = alloc_vertices(fpme, num_misses);
+      if (!miss_verts) {
+         *num_shaded = count;
+         return shade_vertices(fpme, fetch_info, verts);
+      }
+   }
+
+   miss_info = *fetch_info;
+   miss_info.elts = miss_elts;
+   miss_info.count = num_misses;
+
+   if (shade_vertices(fpme, &miss_info, miss_verts))
+      clipped = 1;
+
+   for (i = 0; i < num_misses; i++) {
+      const char *vert = (const char *)miss_verts + i * vertex_size;
+      const unsigned slot = miss_elts[i] & (DRAW_VCACHE_SIZE - 1);
+
+      if (miss_verts != verts)
+         memcpy((char *)verts + miss_pos[i] * vertex_size, vert, vertex_size);
+
+      memcpy(fpme->vcache.verts + slot * vertex_size, vert, vertex_size);
+      fpme->vcache.tags[slot] = miss_elts[i];
+      fpme->vcache.stamps[slot] = fpme->vcache.stamp;
+   }
+
+   if (miss_verts != verts)
+      FREE(miss_verts);
+
+   return clipped;
+}
+
+
+static void
+count_statistics(struct llvm_middle_end *fpme,
+                 const struct draw_prim_info *prim_info,
+                 unsigned vs_invocations)
+{
+   struct draw_context *draw = fpme->draw;
+
+   if (draw->collect_statistics) {
+      draw->statistics.ia_vertices += prim_info->count;
+      draw->statistics.ia_primitives +=
+         u_decomposed_prims_for_vertices(prim_info->prim, prim_info->count);
+      draw->statistics.vs_invocations += vs_invocations;
+   }
+}
+
+
+/**
+ * Run the shaded vertices through the rest of the pipeline: geometry
+ * shader, stream output, clipping and emit.  Frees the vertices.
+ */
+static void
+finish_vertices(struct llvm_middle_end *fpme,
+                struct draw_vertex_info *llvm_vert_info,
+                const struct draw_prim_info *in_prim_info,
+                unsigned clipped)
+{
+   struct draw_context *draw = fpme->draw;
+   struct draw_geometry_shader *gshader = draw->gs.geometry_shader;
+   struct draw_prim_info gs_prim_info;
+   struct draw_vertex_info gs_vert_info;
+   struct draw_vertex_info *vert_info = llvm_vert_info;
+   struct draw_prim_info ia_prim_info;
+   struct draw_vertex_info ia_vert_info;
+   const struct draw_prim_info *prim_info = in_prim_info;
+   boolean free_prim_info = FALSE;
+   unsigned opt = fpme->opt;
 
    if ((opt & PT_SHADE) && gshader) {
       struct draw_vertex_shader *vshader = draw->vs.vertex_shader;
@@ -413,6 +650,17 @@ llvm_pipeline_generic( struct draw_pt_middle_end *middle,
 
    draw_stats_clipper_primitives(draw, prim_info);
 
+   /* With rasterization discarded only the stream output matters, so
+    * skip clipping and the rest of the pipeline.
+    */
+   if (draw->rasterizer->rasterizer_discard) {
+      FREE(vert_info->verts);
+      if (free_prim_info) {
+         FREE(prim_info->primitive_lengths);
+      }
+      return;
+   }
+
    /*
     * if there's no position, need to stop now, or the latter stages
     * will try to access non-existent position output.
@@ -441,6 +689,154 @@ llvm_pipeline_generic( struct draw_pt_middle_end *middle,
 }
 
 
+static void
+shade_segment(struct llvm_middle_end *fpme, unsigned i)
+{
+   struct llvm_segment *seg = &fpme->segments[i];
+
+   seg->clipped = shade_vertices(fpme, &seg->fetch_info, seg->vert_info.verts);
+}
+
+
+static PIPE_THREAD_ROUTINE(vs_thread_function, init_data)
+{
+   struct llvm_vs_thread *thread = (struct llvm_vs_thread *) init_data;
+   struct llvm_middle_end *fpme = thread->fpme;
+
+   while (1) {
+      pipe_semaphore_wait(&thread->work_ready);
+
+      if (fpme->threads_exit)
+         break;
+
+      shade_segment(fpme, thread->index);
+
+      pipe_semaphore_signal(&thread->work_done);
+   }
+
+   return NULL;
+}
+
+
+/**
+ * Shade the queued segments in parallel, and finish them in order.
+ */
+static void
+flush_segments(struct llvm_middle_end *fpme)
+{
+   unsigned num_segments = fpme->num_segments;
+   unsigned i;
+
+   if (!num_segments)
+      return;
+
+   for (i = 1; i < num_segments; i++) {
+      pipe_semaphore_signal(&fpme->threads[i].work_ready);
+   }
+
+   shade_segment(fpme, 0);
+
+   for (i = 1; i < num_segments; i++) {
+      pipe_semaphore_wait(&fpme->threads[i].work_done);
+   }
+
+   fpme->num_segments = 0;
+
+   for (i = 0; i < num_segments; i++) {
+      struct llvm_segment *seg = &fpme->segments[i];
+
+      finish_vertices(fpme, &seg->vert_info, &seg->prim_info, seg->clipped);
+   }
+}
+
+
+static void
+queue_segment(struct llvm_middle_end *fpme,
+              const struct draw_fetch_info *fetch_info,
+              const struct draw_prim_info *prim_info)
+{
+   struct llvm_segment *seg = &fpme->segments[fpme->num_segments];
+
+   assert(prim_info->primitive_count == 1);
+
+   seg->fetch_info = *fetch_info;
+   seg->prim_info = *prim_info;
+   seg->draw_count = prim_info->count;
+   seg->prim_info.primitive_lengths = &seg->draw_count;
+
+   if (fetch_info->elts) {
+      if (!grow_elts((void **) &seg->fetch_elts, &seg->fetch_elts_size,
+                     fetch_info->count, sizeof seg->fetch_elts[0]))
+         return;
+      memcpy(seg->fetch_elts, fetch_info->elts,
+             fetch_info->count * sizeof seg->fetch_elts[0]);
+      seg->fetch_info.elts = seg->fetch_elts;
+   }
+
+   if (prim_info->elts) {
+      if (!grow_elts((void **) &seg->draw_elts, &seg->draw_elts_size,
+                     prim_info->count, sizeof seg->draw_elts[0]))
+         return;
+      memcpy(seg->draw_elts, prim_info->elts,
+             prim_info->count * sizeof seg->draw_elts[0]);
+      seg->prim_info.elts = seg->draw_elts;
+   }
+
+   seg->vert_info.count = fetch_info->count;
+   seg->vert_info.vertex_size = fpme->vertex_size;
+   seg->vert_info.stride = fpme->vertex_size;
+   seg->vert_info.verts = alloc_vertices(fpme, fetch_info->count);
+   if (!seg->vert_info.verts) {
+      assert(0);
+      return;
+   }
+
+   count_statistics(fpme, prim_info, fetch_info->count);
+
+   if (++fpme->num_segments == fpme->num_threads) {
+      flush_segments(fpme);
+   }
+}
+
+
+static void
+llvm_pipeline_generic( struct draw_pt_middle_end *middle,
+                       const struct draw_fetch_info *fetch_info,
+                       const struct draw_prim_info *prim_info )
+{
+   struct llvm_middle_end *fpme = (struct llvm_middle_end *)middle;
+   struct draw_vertex_info llvm_vert_info;
+   unsigned clipped, num_shaded;
+
+   if (fpme->num_threads > 1) {
+      queue_segment(fpme, fetch_info, prim_info);
+      return;
+   }
+
+   llvm_vert_info.count = fetch_info->count;
+   llvm_vert_info.vertex_size = fpme->vertex_size;
+   llvm_vert_info.stride = fpme->vertex_size;
+   llvm_vert_info.verts = alloc_vertices(fpme, fetch_info->count);
+   if (!llvm_vert_info.verts) {
+      assert(0);
+      return;
+   }
+
+   if (fetch_info->linear) {
+      clipped = shade_vertices(fpme, fetch_info, llvm_vert_info.verts);
+      num_shaded = fetch_info->count;
+   }
+   else {
+      clipped = shade_vertices_cached(fpme, fetch_info, llvm_vert_info.verts,
+                                      &num_shaded);
+   }
+
+   count_statistics(fpme, prim_info, num_shaded);
+
+   finish_vertices(fpme, &llvm_vert_info, prim_info, clipped);
+}
+
+
 static void llvm_middle_end_run( struct draw_pt_middle_end *middle,
                                  const unsigned *fetch_elts,
                                  unsigned fetch_count,
@@ -531,15 +927,89 @@ llvm_middle_end_linear_run_elts( struct draw_pt_middle_end *middle,
 
 
 
+static void llvm_middle_end_flush( struct draw_pt_middle_end *middle )
+{
+   struct llvm_middle_end *fpme = (struct llvm_middle_end *)middle;
+
+   flush_segments(fpme);
+   vcache_invalidate(fpme);
+}
+
+
 static void llvm_middle_end_finish( struct draw_pt_middle_end *middle )
 {
-   /* nothing to do */
+   struct llvm_middle_end *fpme = (struct llvm_middle_end *)middle;
+
+   flush_segments(fpme);
+   vcache_invalidate(fpme);
 }
 
+
+static void
+init_vs_threads(struct llvm_middle_end *fpme)
+{
+   unsigned num_threads;
+   unsigned i;
+
+   num_threads = debug_get_num_option("DRAW_VS_THREADS", 0);
+   num_threads = MIN2(num_threads, DRAW_MAX_VS_THREADS);
+   if (num_threads < 2)
+      return;
+
+   /* Thread 0 is the calling thread */
+   for (i = 0; i < num_threads; i++) {
+      struct llvm_vs_thread *thread = &fpme->threads[i];
+
+      thread->fpme = fpme;
+      thread->index = i;
+      if (i > 0) {
+         pipe_semaphore_init(&thread->work_ready, 0);
+         pipe_semaphore_init(&thread->work_done, 0);
+         thread->thread = pipe_thread_create(vs_thread_function, thread);
+      }
+   }
+
+   fpme->num_threads = num_threads;
+}
+
+
+static void
+destroy_vs_threads(struct llvm_middle_end *fpme)
+{
+   unsigned i;
+
+   fpme->threads_exit = TRUE;
+   for (i = 1; i < fpme->num_threads; i++) {
+      pipe_semaphore_signal(&fpme->threads[i].work_ready);
+   }
+
+   for (i = 1; i < fpme->num_threads; i++) {
+      struct llvm_vs_thread *thread = &fpme->threads[i];
+
+      pipe_thread_wait(thread->thread);
+      pipe_semaphore_destroy(&thread->work_ready);
+      pipe_semaphore_destroy(&thread->work_done);
+   }
+
+   for (i = 0; i < Elements(fpme->segments); i++) {
+      FREE(fpme->segments[i].fetch_elts);
+      FREE(fpme->segments[i].draw_elts);
+   }
+
+   fpme->num_threads = 0;
+}
+
+
 static void llvm_middle_end_destroy( struct draw_pt_middle_end *middle )
 {
    struct llvm_middle_end *fpme = (struct llvm_middle_end *)middle;
 
+   destroy_vs_threads(fpme);
+
+   FREE(fpme->vcache.verts);
+   FREE(fpme->vcache.miss_elts);
+   FREE(fpme->vcache.miss_pos);
+
    if (fpme->fetch)
       draw_pt_fetch_destroy( fpme->fetch );
 
@@ -573,6 +1043,7 @@ draw_pt_fetch_pipeline_or_emit_llvm(struct draw_context *draw)
    fpme->base.run             = llvm_middle_end_run;
    fpme->base.run_linear      = llvm_middle_end_linear_run;
    fpme->base.run_linear_elts = llvm_middle_end_linear_run_elts;
+   fpme->base.flush           = llvm_middle_end_flush;
    fpme->base.finish          = llvm_middle_end_finish;
    fpme->base.destroy         = llvm_middle_end_destroy;
 
@@ -599,6 +1070,9 @@ draw_pt_fetch_pipeline_or_emit_llvm(struct draw_context *draw)
       goto fail;
 
    fpme->current_variant = NULL;
+   fpme->vcache.stamp = 1;
+
+   init_vs_threads(fpme);
 
    return &fpme->base;
 
@@ -50,6 +50,22 @@ struct pt_so_emit {
    unsigned emitted_primitives;
    unsigned emitted_vertices;
    unsigned generated_primitives;
+
+   /*
+    * The stream output layout, flattened at prepare time.
+    */
+   struct {
+      unsigned register_index;
+      unsigned start_component;
+      unsigned num_components;
+      unsigned output_buffer;
+      unsigned dst_offset;        /**< in dwords */
+      boolean pre_clip_pos;       /**< take the pre-clip position instead */
+   } slot[PIPE_MAX_SO_OUTPUTS];
+   unsigned num_slots;
+   unsigned buffer_mask;          /**< buffers written by the slots */
+   unsigned buffer_stride[PIPE_MAX_SO_BUFFERS];  /**< in bytes */
+   unsigned buffer_extent[PIPE_MAX_SO_BUFFERS];  /**< bytes touched per vertex */
 };
 
 static const struct pipe_stream_output_info *
@@ -77,6 +93,38 @@ draw_has_so(const struct draw_context *draw)
    return FALSE;
 }
 
+static void
+so_emit_prepare_layout(struct pt_so_emit *emit)
+{
+   const struct pipe_stream_output_info *state = draw_so_info(emit->draw);
+   unsigned i;
+
+   emit->num_slots = state->num_outputs;
+   emit->buffer_mask = 0;
+
+   for (i = 0; i < PIPE_MAX_SO_BUFFERS; i++) {
+      emit->buffer_stride[i] = state->stride[i] * sizeof(float);
+      emit->buffer_extent[i] = 0;
+   }
+
+   for (i = 0; i < state->num_outputs; i++) {
+      const unsigned ob = state->output[i].output_buffer;
+      const unsigned end = (state->output[i].dst_offset +
+                            state->output[i].num_components) * sizeof(float);
+
+      emit->slot[i].register_index = state->output[i].register_index;
+      emit->slot[i].start_component = state->output[i].start_component;
+      emit->slot[i].num_components = state->output[i].num_components;
+      emit->slot[i].output_buffer = ob;
+      emit->slot[i].dst_offset = state->output[i].dst_offset;
+      emit->slot[i].pre_clip_pos = emit->use_pre_clip_pos &&
+         (int)state->output[i].register_index == emit->pos_idx;
+
+      emit->buffer_mask |= 1 << ob;
+      emit->buffer_extent[ob] = MAX2(emit->buffer_extent[ob], end);
+   }
+}
+
 void draw_pt_so_emit_prepare(struct pt_so_emit *emit, boolean use_pre_clip_pos)
 {
    struct draw_context *draw = emit->draw;
@@ -103,6 +151,8 @@ void draw_pt_so_emit_prepare(struct pt_so_emit *emit, boolean use_pre_clip_pos)
    if (!emit->has_so)
       return;
 
+   so_emit_prepare_layout(emit);
+
    /* XXX: need to flush to get prim_vbuf.c to release its allocation??
     */
    draw_do_flush( draw, DRAW_FLUSH_BACKEND );
@@ -112,87 +162,73 @@ static void so_emit_prim(struct pt_so_emit *so,
                          unsigned *indices,
                          unsigned num_vertices)
 {
-   unsigned slot, i;
+   unsigned slot, i, ob;
    unsigned input_vertex_stride = so->input_vertex_stride;
    struct draw_context *draw = so->draw;
-   const float (*input_ptr)[4];
-   const float *pcp_ptr = NULL;
-   const struct pipe_stream_output_info *state = draw_so_info(draw);
-   float *buffer;
-   int buffer_total_bytes[PIPE_MAX_SO_BUFFERS];
-   boolean buffer_written[PIPE_MAX_SO_BUFFERS] = {0};
-
-   input_ptr = so->inputs;
-   if (so->use_pre_clip_pos)
-      pcp_ptr = so->pre_clip_pos;
+   const char *input_ptr = (const char *)so->inputs;
+   const char *pcp_ptr = (const char *)so->pre_clip_pos;
+   char *buffer[PIPE_MAX_SO_BUFFERS];
 
    ++so->generated_primitives;
 
-   for (i = 0; i < draw->so.num_targets; i++) {
-      struct draw_so_target *target = draw->so.targets[i];
-      if (target) {
-         buffer_total_bytes[i] = target->internal_offset;
-      } else {
-         buffer_total_bytes[i] = 0;
-      }
+   /* check have we space to emit prim first - if not don't do anything */
+   for (ob = 0; ob < PIPE_MAX_SO_BUFFERS; ++ob) {
+      struct draw_so_target *target;
+
+      if (!(so->buffer_mask & (1 << ob)))
+         continue;
+
+      /* If a buffer is missing then that's equivalent to
+       * an overflow */
+      target = ob < draw->so.num_targets ? draw->so.targets[ob] : NULL;
+      if (!target)
+         return;
+
+      if (target->internal_offset +
+          (num_vertices - 1) * so->buffer_stride[ob] +
+          so->buffer_extent[ob] > target->target.buffer_size)
+         return;
+
+      buffer[ob] = (char *)target->mapping +
+                   target->target.buffer_offset +
+                   target->internal_offset;
    }
 
-   /* check have we space to emit prim first - if not don't do anything */
    for (i = 0; i < num_vertices; ++i) {
-      unsigned ob;
-      for (slot = 0; slot < state->num_outputs; ++slot) {
-         unsigned num_comps = state->output[slot].num_components;
-         int ob = state->output[slot].output_buffer;
-         unsigned dst_offset = state->output[slot].dst_offset * sizeof(float);
-         unsigned write_size = num_comps * sizeof(float);
-         /* If a buffer is missing then that's equivalent to
-          * an overflow */
-         if (!draw->so.targets[ob]) {
-            return;
-         }
-         if ((buffer_total_bytes[ob] + write_size + dst_offset) >
-             draw->so.targets[ob]->target.buffer_size) {
-            return;
+      const float (*input)[4] = (const float (*)[4])
+         (input_ptr + indices[i] * input_vertex_stride);
+      const float *pre_clip_pos = (const float *)
+         (pcp_ptr + indices[i] * input_vertex_stride);
+
+      for (slot = 0; slot < so->num_slots; ++slot) {
+         const unsigned start_comp = so->slot[slot].start_component;
+         const float *src = so->slot[slot].pre_clip_pos ?
+            &pre_clip_pos[start_comp] :
+            &input[so->slot[slot].register_index][start_comp];
+         float *dst = (float *)buffer[so->slot[slot].output_buffer] +
+                      so->slot[slot].dst_offset;
+
+         switch (so->slot[slot].num_components) {
+         case 4:
+            dst[3] = src[3];
+            /* fallthrough */
+         case 3:
+            dst[2] = src[2];
+            /* fallthrough */
+         case 2:
+            dst[1] = src[1];
+            /* fallthrough */
+         default:
+            dst[0] = src[0];
          }
       }
-      for (ob = 0; ob < draw->so.num_targets; ++ob) {
-         buffer_total_bytes[ob] += state->stride[ob] * sizeof(float);
-      }
-   }
 
-   for (i = 0; i < num_vertices; ++i) {
-      const float (*input)[4];
-      const float *pre_clip_pos = NULL;
-      int ob;
-
-      input = (const float (*)[4])(
-         (const char *)input_ptr + (indices[i] * input_vertex_stride));
-
-      if (pcp_ptr)
-         pre_clip_pos = (const float *)(
-         (const char *)pcp_ptr + (indices[i] * input_vertex_stride));
-
-      for (slot = 0; slot < state->num_outputs; ++slot) {
-         unsigned idx = state->output[slot].register_index;
-         unsigned start_comp = state->output[slot].start_component;
-         unsigned num_comps = state->output[slot].num_components;
-
-         ob = state->output[slot].output_buffer;
-         buffer_written[ob] = TRUE;
-
-         buffer = (float *)((char *)draw->so.targets[ob]->mapping +
-                            draw->so.targets[ob]->target.buffer_offset +
-                            draw->so.targets[ob]->internal_offset) + state->output[slot].dst_offset;
-         
-         if (idx == so->pos_idx && pcp_ptr)
-            memcpy(buffer, &pre_clip_pos[start_comp], num_comps * sizeof(float));
-         else
-            memcpy(buffer, &input[idx][start_comp], num_comps * sizeof(float));
-      }
-      for (ob = 0; ob < draw->so.num_targets; ++ob) {
-         struct draw_so_target *target = draw->so.targets[ob];
-         if (target && buffer_written[ob]) {
-            target->internal_offset += state->stride[ob] * sizeof(float);
+      for (ob = 0; ob < PIPE_MAX_SO_BUFFERS; ++ob) {
+         if (so->buffer_mask & (1 << ob)) {
+            struct draw_so_target *target = draw->so.targets[ob];
+
+            buffer[ob] += so->buffer_stride[ob];
+            target->internal_offset += so->buffer_stride[ob];
             target->emitted_vertices += 1;
          }
       }
@@ -261,8 +297,7 @@ void draw_pt_so_emit( struct pt_so_emit *emit,
    emit->emitted_primitives = 0;
    emit->generated_primitives = 0;
    emit->input_vertex_stride = input_verts->stride;
-   if (emit->use_pre_clip_pos)
-      emit->pre_clip_pos = input_verts->verts->pre_clip_pos;
+   emit->pre_clip_pos = input_verts->verts->pre_clip_pos;
 
    emit->inputs = (const float (*)[4])input_verts->verts->data;
 
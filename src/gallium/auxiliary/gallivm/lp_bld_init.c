@@ -30,6 +30,7 @@
 #include "pipe/p_compiler.h"
 #include "util/u_cpu_detect.h"
 #include "util/u_debug.h"
+#include "util/u_disk_cache.h"
 #include "util/u_memory.h"
 #include "util/u_simple_list.h"
 #include "lp_bld.h"
@@ -39,6 +40,9 @@
 
 #include <llvm-c/Analysis.h>
 #include <llvm-c/Transforms/Scalar.h>
+#if HAVE_LLVM >= 0x0303
+#include <llvm-c/Transforms/Vectorize.h>
+#endif
 #include <llvm-c/BitWriter.h>
 
 
@@ -63,6 +67,15 @@
 #  define HAVE_AVX 0
 #endif
 
+/**
+ * AVX2 intrinsics and encodings are complete from LLVM 3.3 onwards.
+ */
+#if HAVE_AVX && HAVE_LLVM >= 0x0303
+#  define HAVE_AVX2 1
+#else
+#  define HAVE_AVX2 0
+#endif
+
 
 #if USE_MCJIT
 void LLVMLinkInMCJIT();
@@ -142,7 +155,27 @@ create_pass_manager(struct gallivm_state *gallivm)
 
    LLVMAddTargetData(gallivm->target, gallivm->passmgr);
 
-   if ((gallivm_debug & GALLIVM_DEBUG_NO_OPT) == 0) {
+   switch (gallivm->opt_level) {
+   case GALLIVM_OPT_NONE:
+      /* We need at least this pass to prevent the backends to fail in
+       * unexpected ways.
+       */
+      LLVMAddPromoteMemoryToRegisterPass(gallivm->passmgr);
+      break;
+
+   case GALLIVM_OPT_FAST:
+      /* Just enough to undo the most obvious redundancy of the TGSI
+       * translation, at a fraction of the cost of the full list.
+       */
+      LLVMAddPromoteMemoryToRegisterPass(gallivm->passmgr);
+      LLVMAddCFGSimplificationPass(gallivm->passmgr);
+#if HAVE_LLVM >= 0x0301
+      LLVMAddEarlyCSEPass(gallivm->passmgr);
+#endif
+      break;
+
+   case GALLIVM_OPT_DEFAULT:
+   case GALLIVM_OPT_FULL:
       /* These are the passes currently listed in llvm-c/Transforms/Scalar.h,
        * but there are more on SVN.
        * TODO: Add more passes.
@@ -173,12 +206,20 @@ create_pass_manager(struct gallivm_state *gallivm)
          LLVMAddInstructionCombiningPass(gallivm->passmgr);
       }
       LLVMAddGVNPass(gallivm->passmgr);
-   }
-   else {
-      /* We need at least this pass to prevent the backends to fail in
-       * unexpected ways.
-       */
-      LLVMAddPromoteMemoryToRegisterPass(gallivm->passmgr);
+
+      if (gallivm->opt_level == GALLIVM_OPT_FULL) {
+         /* Only worth it for code that will run a lot: pack the scalar
+          * leftovers of the AoS/SoA paths into vectors, and clean up the
+          * stores and values made dead by that and by GVN.
+          */
+#if HAVE_LLVM >= 0x0303
+         LLVMAddSLPVectorizePass(gallivm->passmgr);
+#endif
+         LLVMAddDeadStoreEliminationPass(gallivm->passmgr);
+         LLVMAddAggressiveDCEPass(gallivm->passmgr);
+         LLVMAddCFGSimplificationPass(gallivm->passmgr);
+      }
+      break;
    }
 
    return TRUE;
@@ -236,6 +277,15 @@ free_gallivm_state(struct gallivm_state *gallivm)
    if (gallivm->builder)
       LLVMDisposeBuilder(gallivm->builder);
 
+   /* The engine referenced the object cache, so it must be gone by now */
+   lp_free_object_cache(gallivm->object_cache);
+   FREE(gallivm->cache_key);
+   FREE(gallivm->cached_object);
+
+   gallivm->object_cache = NULL;
+   gallivm->cache_key = NULL;
+   gallivm->cached_object = NULL;
+   gallivm->disk_cache = NULL;
    gallivm->engine = NULL;
    gallivm->target = NULL;
    gallivm->module = NULL;
@@ -255,11 +305,21 @@ init_gallivm_engine(struct gallivm_state *gallivm)
       char *error = NULL;
       int ret;
 
-      if (gallivm_debug & GALLIVM_DEBUG_NO_OPT) {
+      switch (gallivm->opt_level) {
+      case GALLIVM_OPT_NONE:
          optlevel = None;
-      }
-      else {
+         break;
+#if HAVE_LLVM >= 0x207
+      case GALLIVM_OPT_FAST:
+         optlevel = Less;
+         break;
+#endif
+      case GALLIVM_OPT_FULL:
+         optlevel = Aggressive;
+         break;
+      default:
          optlevel = Default;
+         break;
       }
 
 #if HAVE_LLVM >= 0x0301
@@ -267,6 +327,7 @@ init_gallivm_engine(struct gallivm_state *gallivm)
                                                     gallivm->module,
                                                     (unsigned) optlevel,
                                                     USE_MCJIT,
+                                                    &gallivm->code_size,
                                                     &error);
 #else
       ret = LLVMCreateJITCompiler(&gallivm->engine, gallivm->provider,
@@ -281,6 +342,12 @@ init_gallivm_engine(struct gallivm_state *gallivm)
 
    LLVMAddModuleProvider(gallivm->engine, gallivm->provider);//new
 
+#if USE_MCJIT
+   if (gallivm->disk_cache) {
+      gallivm->object_cache = lp_set_object_cache(gallivm->engine, gallivm);
+   }
+#endif
+
 #if !USE_MCJIT
    gallivm->target = LLVMGetExecutionEngineTargetData(gallivm->engine);
    if (!gallivm->target)
@@ -333,7 +400,7 @@ static LLVMContextRef gallivm_context = NULL;
  * \return  TRUE for success, FALSE for failure
  */
 static boolean
-init_gallivm_state(struct gallivm_state *gallivm)
+init_gallivm_state(struct gallivm_state *gallivm, LLVMContextRef context)
 {
    assert(!gallivm->context);
    assert(!gallivm->module);
@@ -341,10 +408,13 @@ init_gallivm_state(struct gallivm_state *gallivm)
 
    lp_build_init();
 
-   if (!gallivm_context) {
-      gallivm_context = LLVMContextCreate();
+   if (!context) {
+      if (!gallivm_context) {
+         gallivm_context = LLVMContextCreate();
+      }
+      context = gallivm_context;
    }
-   gallivm->context = gallivm_context;
+   gallivm->context = context;
    if (!gallivm->context)
       goto fail;
 
@@ -468,6 +538,10 @@ lp_build_init(void)
       util_cpu_caps.has_avx = 0;
    }
 
+   if (!HAVE_AVX2 || !util_cpu_caps.has_avx) {
+      util_cpu_caps.has_avx2 = 0;
+   }
+
    if (!HAVE_AVX) {
       /*
        * note these instructions are VEX-only, so can only emit if we use
@@ -504,6 +578,7 @@ lp_build_init(void)
    util_cpu_caps.has_ssse3 = 0;
    util_cpu_caps.has_sse4_1 = 0;
    util_cpu_caps.has_avx = 0;
+   util_cpu_caps.has_avx2 = 0;
    util_cpu_caps.has_f16c = 0;
 #endif
 }
@@ -516,6 +591,24 @@ lp_build_init(void)
  */
 struct gallivm_state *
 gallivm_create(void)
+{
+   return gallivm_create_in_context(NULL, GALLIVM_OPT_DEFAULT);
+}
+
+
+/**
+ * Create a new gallivm_state object in the given LLVM context, or in the
+ * shared one when NULL.  An LLVM context must only ever be used by one
+ * thread at a time, so building code on several threads at once requires
+ * a context per thread.
+ *
+ * \param opt_level  how much to trade compilation speed for code quality;
+ *                   code below GALLIVM_OPT_DEFAULT is never stored in the
+ *                   disk cache
+ */
+struct gallivm_state *
+gallivm_create_in_context(LLVMContextRef context,
+                          enum gallivm_opt_level opt_level)
 {
    struct gallivm_state *gallivm;
 
@@ -525,9 +618,17 @@ gallivm_create(void)
    }
 #endif
 
+   /* for gallivm_debug */
+   lp_build_init();
+
    gallivm = CALLOC_STRUCT(gallivm_state);
    if (gallivm) {
-      if (!init_gallivm_state(gallivm)) {
+      gallivm->opt_level = opt_level;
+      if (gallivm_debug & GALLIVM_DEBUG_NO_OPT) {
+         gallivm->opt_level = GALLIVM_OPT_NONE;
+      }
+
+      if (!init_gallivm_state(gallivm, context)) {
          FREE(gallivm);
          gallivm = NULL;
       }
@@ -583,6 +684,49 @@ gallivm_optimize_function(struct gallivm_state *gallivm,
 }
 
 
+/**
+ * Attach a persistent machine code cache to the module.
+ *
+ * Must be called before any function is verified.  The key must capture
+ * everything the generated code depends on, and the function names given
+ * to the module must not depend on per-process state.
+ *
+ * \return  TRUE if machine code for this key was found in the cache, in
+ *          which case the IR optimization passes are skipped.
+ */
+boolean
+gallivm_set_disk_cache(struct gallivm_state *gallivm,
+                       struct util_disk_cache *cache,
+                       const void *key, size_t key_size)
+{
+#if USE_MCJIT && HAVE_LLVM >= 0x0303
+   assert(!gallivm->compiled);
+   assert(!gallivm->disk_cache);
+
+   if (!cache)
+      return FALSE;
+
+   gallivm->cache_key = MALLOC(key_size);
+   if (!gallivm->cache_key)
+      return FALSE;
+
+   memcpy(gallivm->cache_key, key, key_size);
+   gallivm->cache_key_size = key_size;
+   gallivm->disk_cache = cache;
+
+   return util_disk_cache_get(cache, key, key_size,
+                              &gallivm->cached_object,
+                              &gallivm->cached_object_size);
+#else
+   (void) gallivm;
+   (void) cache;
+   (void) key;
+   (void) key_size;
+   return FALSE;
+#endif
+}
+
+
 /**
  * Validate a function.
  */
@@ -599,7 +743,10 @@ gallivm_verify_function(struct gallivm_state *gallivm,
    }
 #endif
 
-   gallivm_optimize_function(gallivm, func);
+   /* The cached machine code was produced from the optimized IR */
+   if (!gallivm->cached_object) {
+      gallivm_optimize_function(gallivm, func);
+   }
 
    if (gallivm_debug & GALLIVM_DEBUG_IR) {
       /* Print the LLVM IR to stderr */
@@ -36,6 +36,21 @@
 #include <llvm-c/ExecutionEngine.h>
 
 
+struct util_disk_cache;
+
+
+/**
+ * How much compile time to spend on making the generated code fast.
+ */
+enum gallivm_opt_level
+{
+   GALLIVM_OPT_NONE,     /**< -O0, only the passes the backends rely on */
+   GALLIVM_OPT_FAST,     /**< -O1, cheap cleanups for code used right away */
+   GALLIVM_OPT_DEFAULT,  /**< -O2, the regular scalar pass list */
+   GALLIVM_OPT_FULL      /**< -O3, plus vectorization, for hot code */
+};
+
+
 struct gallivm_state
 {
    LLVMModuleRef module;
@@ -46,6 +61,29 @@ struct gallivm_state
    LLVMContextRef context;
    LLVMBuilderRef builder;
    unsigned compiled;
+
+   enum gallivm_opt_level opt_level;
+
+   /*
+    * Persistent machine code cache.  Only effective with MC-JIT, as the old
+    * JIT offers no way of saving and restoring the generated code.
+    */
+   struct util_disk_cache *disk_cache;
+   void *cache_key;
+   size_t cache_key_size;
+   void *cached_object;
+   size_t cached_object_size;
+   void *object_cache;
+
+   /**
+    * Set when the IR embeds absolute host addresses (e.g. pointers to C
+    * helper functions), which makes the machine code unfit to be reused by
+    * another process.
+    */
+   boolean uses_host_pointers;
+
+   /** Bytes of machine code and data the JIT allocated for the module */
+   size_t code_size;
 };
 
 
@@ -56,10 +94,19 @@ lp_build_init(void);
 struct gallivm_state *
 gallivm_create(void);
 
+struct gallivm_state *
+gallivm_create_in_context(LLVMContextRef context,
+                          enum gallivm_opt_level opt_level);
+
 void
 gallivm_destroy(struct gallivm_state *gallivm);
 
 
+boolean
+gallivm_set_disk_cache(struct gallivm_state *gallivm,
+                       struct util_disk_cache *cache,
+                       const void *key, size_t key_size);
+
 void
 gallivm_verify_function(struct gallivm_state *gallivm,
                         LLVMValueRef func);
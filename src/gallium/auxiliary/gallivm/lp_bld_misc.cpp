@@ -71,12 +71,16 @@
 #include <llvm/IR/IRBuilder.h>
 #include <llvm/IR/Module.h>
 #include <llvm/Support/CBindingWrapping.h>
+#include <llvm/ExecutionEngine/ObjectCache.h>
+#include <llvm/Support/MemoryBuffer.h>
 #endif
 
 #include "pipe/p_config.h"
 #include "util/u_debug.h"
 #include "util/u_cpu_detect.h"
+#include "util/u_disk_cache.h"
 
+#include "lp_bld_init.h"
 #include "lp_bld_misc.h"
 
 namespace {
@@ -243,10 +247,161 @@ lp_set_store_alignment(LLVMValueRef Inst,
 
 #if HAVE_LLVM >= 0x301
 
+namespace {
+
+/**
+ * Forwards everything to the default JIT memory manager, adding up the
+ * sizes of what it allocates so that the callers can budget the memory
+ * held by their shader variants.
+ */
+class CountingJITMemoryManager : public llvm::JITMemoryManager {
+   llvm::JITMemoryManager *TheMM;
+   size_t *Size;
+
+public:
+   CountingJITMemoryManager(llvm::JITMemoryManager *MM, size_t *ByteCount)
+      : TheMM(MM), Size(ByteCount)
+   {
+      *Size = 0;
+   }
+
+   virtual ~CountingJITMemoryManager()
+   {
+      delete TheMM;
+   }
+
+   /*
+    * From JITMemoryManager
+    */
+   virtual void setMemoryWritable() {
+      TheMM->setMemoryWritable();
+   }
+   virtual void setMemoryExecutable() {
+      TheMM->setMemoryExecutable();
+   }
+   virtual void setPoisonMemory(bool poison) {
+      TheMM->setPoisonMemory(poison);
+   }
+   virtual void AllocateGOT() {
+      TheMM->AllocateGOT();
+      /*
+       * isManagingGOT() is not virtual, so mirror the value of HasGOT
+       * instead of delegating.
+       */
+      HasGOT = TheMM->isManagingGOT();
+   }
+   virtual uint8_t *getGOTBase() const {
+      return TheMM->getGOTBase();
+   }
+   virtual uint8_t *startFunctionBody(const llvm::Function *F,
+                                      uintptr_t &ActualSize) {
+      return TheMM->startFunctionBody(F, ActualSize);
+   }
+   virtual uint8_t *allocateStub(const llvm::GlobalValue *F,
+                                 unsigned StubSize,
+                                 unsigned Alignment) {
+      *Size += StubSize;
+      return TheMM->allocateStub(F, StubSize, Alignment);
+   }
+   virtual void endFunctionBody(const llvm::Function *F,
+                                uint8_t *FunctionStart,
+                                uint8_t *FunctionEnd) {
+      *Size += FunctionEnd - FunctionStart;
+      TheMM->endFunctionBody(F, FunctionStart, FunctionEnd);
+   }
+   virtual uint8_t *allocateSpace(intptr_t SpaceSize, unsigned Alignment) {
+      *Size += SpaceSize;
+      return TheMM->allocateSpace(SpaceSize, Alignment);
+   }
+   virtual uint8_t *allocateGlobal(uintptr_t GlobalSize, unsigned Alignment) {
+      *Size += GlobalSize;
+      return TheMM->allocateGlobal(GlobalSize, Alignment);
+   }
+   virtual void deallocateFunctionBody(void *Body) {
+      TheMM->deallocateFunctionBody(Body);
+   }
+   virtual uint8_t *startExceptionTable(const llvm::Function *F,
+                                        uintptr_t &ActualSize) {
+      return TheMM->startExceptionTable(F, ActualSize);
+   }
+   virtual void endExceptionTable(const llvm::Function *F,
+                                  uint8_t *TableStart,
+                                  uint8_t *TableEnd,
+                                  uint8_t *FrameRegister) {
+      *Size += TableEnd - TableStart;
+      TheMM->endExceptionTable(F, TableStart, TableEnd, FrameRegister);
+   }
+   virtual void deallocateExceptionTable(void *ET) {
+      TheMM->deallocateExceptionTable(ET);
+   }
+   virtual bool CheckInvariants(std::string &s) {
+      return TheMM->CheckInvariants(s);
+   }
+   virtual size_t GetDefaultCodeSlabSize() {
+      return TheMM->GetDefaultCodeSlabSize();
+   }
+   virtual size_t GetDefaultDataSlabSize() {
+      return TheMM->GetDefaultDataSlabSize();
+   }
+   virtual size_t GetDefaultStubSlabSize() {
+      return TheMM->GetDefaultStubSlabSize();
+   }
+   virtual unsigned GetNumCodeSlabs() {
+      return TheMM->GetNumCodeSlabs();
+   }
+   virtual unsigned GetNumDataSlabs() {
+      return TheMM->GetNumDataSlabs();
+   }
+   virtual unsigned GetNumStubSlabs() {
+      return TheMM->GetNumStubSlabs();
+   }
+
+   /*
+    * From RTDyldMemoryManager, used by MC-JIT
+    */
+   virtual uint8_t *allocateCodeSection(uintptr_t SectionSize,
+                                        unsigned Alignment,
+                                        unsigned SectionID) {
+      *Size += SectionSize;
+      return TheMM->allocateCodeSection(SectionSize, Alignment, SectionID);
+   }
+#if HAVE_LLVM >= 0x0303
+   virtual uint8_t *allocateDataSection(uintptr_t SectionSize,
+                                        unsigned Alignment,
+                                        unsigned SectionID,
+                                        bool IsReadOnly) {
+      *Size += SectionSize;
+      return TheMM->allocateDataSection(SectionSize, Alignment, SectionID,
+                                        IsReadOnly);
+   }
+   virtual void registerEHFrames(llvm::StringRef SectionData) {
+      TheMM->registerEHFrames(SectionData);
+   }
+   virtual bool applyPermissions(std::string *ErrMsg = 0) {
+      return TheMM->applyPermissions(ErrMsg);
+   }
+#else
+   virtual uint8_t *allocateDataSection(uintptr_t SectionSize,
+                                        unsigned Alignment,
+                                        unsigned SectionID) {
+      *Size += SectionSize;
+      return TheMM->allocateDataSection(SectionSize, Alignment, SectionID);
+   }
+#endif
+   virtual void *getPointerToNamedFunction(const std::string &Name,
+                                           bool AbortOnFailure = true) {
+      return TheMM->getPointerToNamedFunction(Name, AbortOnFailure);
+   }
+};
+
+} /* anonymous namespace */
+
+
 /**
  * Same as LLVMCreateJITCompilerForModule, but:
  * - allows using MCJIT and enabling AVX feature where available.
  * - set target options
+ * - count the bytes the JIT allocates into *CodeSize
  *
  * See also:
  * - llvm/lib/ExecutionEngine/ExecutionEngineBindings.cpp
@@ -259,6 +414,7 @@ lp_build_create_jit_compiler_for_module(LLVMExecutionEngineRef *OutJIT,
                                         LLVMModuleRef M,
                                         unsigned OptLevel,
                                         int useMCJIT,
+                                        size_t *CodeSize,
                                         char **OutError)
 {
    using namespace llvm;
@@ -306,9 +462,15 @@ lp_build_create_jit_compiler_for_module(LLVMExecutionEngineRef *OutJIT,
       if (util_cpu_caps.has_f16c) {
          MAttrs.push_back("+f16c");
       }
+      if (util_cpu_caps.has_avx2) {
+         /* 256bit integer operations */
+         MAttrs.push_back("+avx2");
+      }
       builder.setMAttrs(MAttrs);
    }
-   builder.setJITMemoryManager(JITMemoryManager::CreateDefaultMemManager());
+   builder.setJITMemoryManager(
+      new CountingJITMemoryManager(JITMemoryManager::CreateDefaultMemManager(),
+                                   CodeSize));
 
    ExecutionEngine *JIT;
 #if 0
@@ -331,3 +493,88 @@ lp_build_create_jit_compiler_for_module(LLVMExecutionEngineRef *OutJIT,
 }
 
 #endif /* HAVE_LLVM >= 0x301 */
+
+
+#if HAVE_LLVM >= 0x0303
+
+namespace {
+
+/**
+ * Adaptor between MC-JIT's object cache interface and util_disk_cache.
+ *
+ * The object code found at gallivm_set_disk_cache() time is handed back to
+ * MC-JIT instead of running the code generator, and freshly generated object
+ * code is written back to the disk cache.
+ */
+class DiskObjectCache : public llvm::ObjectCache {
+public:
+   DiskObjectCache(struct gallivm_state *gallivm) : gallivm(gallivm) {}
+
+   virtual void
+   notifyObjectCompiled(const llvm::Module *M, const llvm::MemoryBuffer *Obj)
+   {
+      if (gallivm->cached_object || gallivm->uses_host_pointers ||
+          gallivm->opt_level < GALLIVM_OPT_DEFAULT) {
+         return;
+      }
+
+      util_disk_cache_put(gallivm->disk_cache,
+                          gallivm->cache_key, gallivm->cache_key_size,
+                          Obj->getBufferStart(), Obj->getBufferSize());
+   }
+
+   virtual llvm::MemoryBuffer *
+   getObject(const llvm::Module *M)
+   {
+      if (!gallivm->cached_object) {
+         return NULL;
+      }
+
+      /* MC-JIT takes ownership of the returned buffer */
+      llvm::StringRef data((const char *)gallivm->cached_object,
+                           gallivm->cached_object_size);
+      return llvm::MemoryBuffer::getMemBufferCopy(data);
+   }
+
+private:
+   struct gallivm_state *gallivm;
+};
+
+}
+
+#endif /* HAVE_LLVM >= 0x0303 */
+
+
+/**
+ * Install a persistent object cache on a MC-JIT execution engine.
+ *
+ * Returns an opaque handle to be released with lp_free_object_cache() once
+ * the engine has been disposed, or NULL if not supported.
+ */
+extern "C"
+void *
+lp_set_object_cache(LLVMExecutionEngineRef EE,
+                    struct gallivm_state *gallivm)
+{
+#if HAVE_LLVM >= 0x0303
+   DiskObjectCache *cache = new DiskObjectCache(gallivm);
+   llvm::unwrap(EE)->setObjectCache(cache);
+   return cache;
+#else
+   (void) EE;
+   (void) gallivm;
+   return NULL;
+#endif
+}
+
+
+extern "C"
+void
+lp_free_object_cache(void *cache)
+{
+#if HAVE_LLVM >= 0x0303
+   delete static_cast<DiskObjectCache *>(cache);
+#else
+   assert(!cache);
+#endif
+}
@@ -57,8 +57,18 @@ lp_build_create_jit_compiler_for_module(LLVMExecutionEngineRef *OutJIT,
                                         LLVMModuleRef M,
                                         unsigned OptLevel,
                                         int useMCJIT,
+                                        size_t *CodeSize,
                                         char **OutError);
 
+struct gallivm_state;
+
+extern void *
+lp_set_object_cache(LLVMExecutionEngineRef EE,
+                    struct gallivm_state *gallivm);
+
+extern void
+lp_free_object_cache(void *cache);
+
 
 #ifdef __cplusplus
 }
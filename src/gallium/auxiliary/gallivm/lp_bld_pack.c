@@ -465,6 +465,44 @@ lp_build_pack2(struct gallivm_state *gallivm,
    assert(src_type.length * 2 == dst_type.length);
 
    /* Check for special cases first */
+   if (util_cpu_caps.has_avx2 &&
+       src_type.width * src_type.length == 256 &&
+       (src_type.width == 32 || src_type.width == 16)) {
+      const char *intrinsic = NULL;
+
+      if (src_type.width == 32) {
+         intrinsic = dst_type.sign ? "llvm.x86.avx2.packssdw" :
+                                     "llvm.x86.avx2.packusdw";
+      }
+      else {
+         intrinsic = dst_type.sign ? "llvm.x86.avx2.packsswb" :
+                                     "llvm.x86.avx2.packuswb";
+      }
+
+      /*
+       * The AVX2 packs work within each 128bit lane, giving
+       * lo0 hi0 lo1 hi1 (in 64bit pieces), so fix that up with a
+       * cross-lane permute.
+       */
+      {
+         struct lp_type qword_type = lp_type_uint_vec(64, 256);
+         LLVMTypeRef qword_vec_type = lp_build_vec_type(gallivm, qword_type);
+         LLVMValueRef shuffles[4];
+
+         res = lp_build_intrinsic_binary(builder, intrinsic,
+                                         lp_build_vec_type(gallivm, intr_type),
+                                         lo, hi);
+         res = LLVMBuildBitCast(builder, res, qword_vec_type, "");
+         shuffles[0] = lp_build_const_int32(gallivm, 0);
+         shuffles[1] = lp_build_const_int32(gallivm, 2);
+         shuffles[2] = lp_build_const_int32(gallivm, 1);
+         shuffles[3] = lp_build_const_int32(gallivm, 3);
+         res = LLVMBuildShuffleVector(builder, res, res,
+                                      LLVMConstVector(shuffles, 4), "");
+         return LLVMBuildBitCast(builder, res, dst_vec_type, "");
+      }
+   }
+
    if((util_cpu_caps.has_sse2 || util_cpu_caps.has_altivec) &&
        src_type.width * src_type.length >= 128) {
       const char *intrinsic = NULL;
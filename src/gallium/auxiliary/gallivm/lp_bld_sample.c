@@ -37,6 +37,7 @@
 #include "util/u_format.h"
 #include "util/u_math.h"
 #include "lp_bld_arit.h"
+#include "lp_bld_bitarit.h"
 #include "lp_bld_const.h"
 #include "lp_bld_debug.h"
 #include "lp_bld_printf.h"
@@ -192,6 +193,18 @@ lp_sampler_static_sampler_state(struct lp_static_sampler_state *state,
    }
 
    state->normalized_coords = sampler->normalized_coords;
+
+   /*
+    * Anisotropy only changes anything when minifying a mipmapped texture
+    * with linear filtering.
+    */
+   if (sampler->max_anisotropy > 1 &&
+       sampler->normalized_coords &&
+       sampler->min_img_filter == PIPE_TEX_FILTER_LINEAR &&
+       state->min_mip_filter != PIPE_TEX_MIPFILTER_NONE &&
+       !state->min_max_lod_equal) {
+      state->aniso = MIN2(sampler->max_anisotropy, LP_MAX_ANISO_PROBES);
+   }
 }
 
 
@@ -496,6 +509,110 @@ lp_build_rho(struct lp_build_sample_context *bld,
 }
 
 
+/**
+ * Generate code to compute the anisotropic filtering footprint.
+ *
+ * The pixel footprint is approximated by the parallelogram spanned by the
+ * x and y derivatives.  Its major axis is sampled with
+ * probes = min(ceil(|major| / |minor|), aniso) trilinear lookups, which
+ * are spread evenly along it, so each lookup only has to cover
+ * |major| / probes texels.
+ *
+ * The probe count and steps are left in bld->aniso_*, per quad like the
+ * lod, and the returned rho is scalar per quad.
+ */
+static LLVMValueRef
+lp_build_rho_aniso(struct lp_build_sample_context *bld,
+                   unsigned texture_unit,
+                   LLVMValueRef s,
+                   LLVMValueRef t,
+                   const struct lp_derivatives *derivs)
+{
+   struct gallivm_state *gallivm = bld->gallivm;
+   struct lp_build_context *int_size_bld = &bld->int_size_in_bld;
+   struct lp_build_context *float_size_bld = &bld->float_size_in_bld;
+   struct lp_build_context *coord_bld = &bld->coord_bld;
+   struct lp_build_context *perquadf_bld = &bld->perquadf_bld;
+   LLVMValueRef first_level, first_level_vec;
+   LLVMValueRef int_size, float_size;
+   LLVMValueRef width, height;
+   LLVMValueRef dsdx, dsdy, dtdx, dtdy;
+   LLVMValueRef sx, sy, tx, ty;
+   LLVMValueRef px2, py2, pmax2, pmin2, x_major;
+   LLVMValueRef ratio, probes, rho;
+
+   first_level = bld->dynamic_state->first_level(bld->dynamic_state,
+                                                 bld->gallivm, texture_unit);
+   first_level_vec = lp_build_broadcast_scalar(int_size_bld, first_level);
+   int_size = lp_build_minify(int_size_bld, bld->int_size, first_level_vec);
+   float_size = lp_build_int_to_float(float_size_bld, int_size);
+
+   width = lp_build_extract_broadcast(gallivm, bld->float_size_in_type,
+                                      coord_bld->type, float_size,
+                                      lp_build_const_int32(gallivm, 0));
+   height = lp_build_extract_broadcast(gallivm, bld->float_size_in_type,
+                                       coord_bld->type, float_size,
+                                       lp_build_const_int32(gallivm, 1));
+
+   if (derivs) {
+      dsdx = derivs->ddx[0];
+      dsdy = derivs->ddy[0];
+      dtdx = derivs->ddx[1];
+      dtdy = derivs->ddy[1];
+   }
+   else {
+      dsdx = lp_build_ddx(coord_bld, s);
+      dsdy = lp_build_ddy(coord_bld, s);
+      dtdx = lp_build_ddx(coord_bld, t);
+      dtdy = lp_build_ddy(coord_bld, t);
+   }
+
+   /* squared lengths of the footprint axes, in texels */
+   sx = lp_build_mul(coord_bld, dsdx, width);
+   tx = lp_build_mul(coord_bld, dtdx, height);
+   sy = lp_build_mul(coord_bld, dsdy, width);
+   ty = lp_build_mul(coord_bld, dtdy, height);
+   px2 = lp_build_add(coord_bld, lp_build_mul(coord_bld, sx, sx),
+                      lp_build_mul(coord_bld, tx, tx));
+   py2 = lp_build_add(coord_bld, lp_build_mul(coord_bld, sy, sy),
+                      lp_build_mul(coord_bld, ty, ty));
+
+   x_major = lp_build_cmp(coord_bld, PIPE_FUNC_GEQUAL, px2, py2);
+   pmax2 = lp_build_select(coord_bld, x_major, px2, py2);
+   pmin2 = lp_build_select(coord_bld, x_major, py2, px2);
+
+   /* probes = clamp(ceil(sqrt(pmax2 / pmin2)), 1, aniso) */
+   pmin2 = lp_build_max(coord_bld, pmin2,
+                        lp_build_const_vec(gallivm, coord_bld->type, 1e-20));
+   ratio = lp_build_div(coord_bld, pmax2, pmin2);
+   ratio = lp_build_sqrt(coord_bld, ratio);
+   ratio = lp_build_min(coord_bld, ratio,
+                        lp_build_const_vec(gallivm, coord_bld->type,
+                                           bld->static_sampler_state->aniso));
+   probes = lp_build_ceil(coord_bld, ratio);
+   probes = lp_build_max(coord_bld, probes, coord_bld->one);
+
+   /* one probe count per quad, as for the lod */
+   probes = lp_build_pack_aos_scalars(gallivm, coord_bld->type,
+                                      perquadf_bld->type, probes, 0);
+   bld->aniso_probes = lp_build_unpack_broadcast_aos_scalars(gallivm,
+                                                             perquadf_bld->type,
+                                                             coord_bld->type,
+                                                             probes);
+
+   /* step between the probes along the major axis, in normalized coords */
+   bld->aniso_ds = lp_build_select(coord_bld, x_major, dsdx, dsdy);
+   bld->aniso_dt = lp_build_select(coord_bld, x_major, dtdx, dtdy);
+   bld->aniso_ds = lp_build_div(coord_bld, bld->aniso_ds, bld->aniso_probes);
+   bld->aniso_dt = lp_build_div(coord_bld, bld->aniso_dt, bld->aniso_probes);
+
+   rho = lp_build_sqrt(coord_bld, pmax2);
+   rho = lp_build_pack_aos_scalars(gallivm, coord_bld->type,
+                                   perquadf_bld->type, rho, 0);
+   return lp_build_div(perquadf_bld, rho, probes);
+}
+
+
 /*
  * Bri-linear lod computation
  *
@@ -676,7 +793,15 @@ lp_build_lod_selector(struct lp_build_sample_context *bld,
       else {
          LLVMValueRef rho;
 
-         rho = lp_build_rho(bld, texture_unit, s, t, r, cube_rho, derivs);
+         if (bld->static_sampler_state->aniso &&
+             bld->dims == 2 &&
+             bld->static_texture_state->target != PIPE_TEXTURE_CUBE &&
+             bld->texel_type.floating) {
+            rho = lp_build_rho_aniso(bld, texture_unit, s, t, derivs);
+         }
+         else {
+            rho = lp_build_rho(bld, texture_unit, s, t, r, cube_rho, derivs);
+         }
 
          /*
           * Compute lod = log2(rho)
@@ -1752,16 +1877,63 @@ lp_build_sample_partial_offset(struct lp_build_context *bld,
 }
 
 
+/**
+ * Compute the x part of the offset of a texel in a tiled image, where
+ * the texels of each 4x4 block are stored together, row by row:
+ * (((x & ~3) << 2) | (x & 3)) * x_stride.
+ */
+LLVMValueRef
+lp_build_sample_tiled_offset_x(struct lp_build_context *bld,
+                               LLVMValueRef x,
+                               LLVMValueRef x_stride)
+{
+   LLVMValueRef mask = lp_build_const_int_vec(bld->gallivm, bld->type, 3);
+   LLVMValueRef block_x, sub_x;
+
+   block_x = lp_build_andnot(bld, x, mask);
+   block_x = lp_build_shl_imm(bld, block_x, 2);
+   sub_x = lp_build_and(bld, x, mask);
+
+   return lp_build_mul(bld, lp_build_or(bld, block_x, sub_x), x_stride);
+}
+
+
+/**
+ * Compute the y part of the offset of a texel in a tiled image:
+ * (y & ~3) * y_stride + (y & 3) * 4 * x_stride.  Every row of blocks
+ * takes the same space as four rows of the linear image.
+ */
+LLVMValueRef
+lp_build_sample_tiled_offset_y(struct lp_build_context *bld,
+                               LLVMValueRef y,
+                               LLVMValueRef y_stride,
+                               LLVMValueRef x_stride)
+{
+   LLVMValueRef mask = lp_build_const_int_vec(bld->gallivm, bld->type, 3);
+   LLVMValueRef block_y, sub_y;
+
+   block_y = lp_build_andnot(bld, y, mask);
+   block_y = lp_build_mul(bld, block_y, y_stride);
+   sub_y = lp_build_and(bld, y, mask);
+   sub_y = lp_build_mul(bld, lp_build_shl_imm(bld, sub_y, 2), x_stride);
+
+   return lp_build_add(bld, block_y, sub_y);
+}
+
+
 /**
  * Compute the offset of a pixel block.
  *
  * x, y, z, y_stride, z_stride are vectors, and they refer to pixels.
+ * If tiled, the image is stored in 4x4 blocks (which requires a format
+ * with 1x1 pixel blocks).
  *
  * Returns the relative offset and i,j sub-block coordinates
  */
 void
 lp_build_sample_offset(struct lp_build_context *bld,
                        const struct util_format_description *format_desc,
+                       boolean tiled,
                        LLVMValueRef x,
                        LLVMValueRef y,
                        LLVMValueRef z,
@@ -1777,17 +1949,32 @@ lp_build_sample_offset(struct lp_build_context *bld,
    x_stride = lp_build_const_vec(bld->gallivm, bld->type,
                                  format_desc->block.bits/8);
 
-   lp_build_sample_partial_offset(bld,
-                                  format_desc->block.width,
-                                  x, x_stride,
-                                  &offset, out_i);
+   if (tiled) {
+      assert(format_desc->block.width == 1);
+      assert(format_desc->block.height == 1);
+      offset = lp_build_sample_tiled_offset_x(bld, x, x_stride);
+      *out_i = bld->zero;
+   }
+   else {
+      lp_build_sample_partial_offset(bld,
+                                     format_desc->block.width,
+                                     x, x_stride,
+                                     &offset, out_i);
+   }
 
    if (y && y_stride) {
       LLVMValueRef y_offset;
-      lp_build_sample_partial_offset(bld,
-                                     format_desc->block.height,
-                                     y, y_stride,
-                                     &y_offset, out_j);
+      if (tiled) {
+         y_offset = lp_build_sample_tiled_offset_y(bld, y, y_stride,
+                                                   x_stride);
+         *out_j = bld->zero;
+      }
+      else {
+         lp_build_sample_partial_offset(bld,
+                                        format_desc->block.height,
+                                        y, y_stride,
+                                        &y_offset, out_j);
+      }
       offset = lp_build_add(bld, offset, y_offset);
    }
    else {
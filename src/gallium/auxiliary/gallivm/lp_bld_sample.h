@@ -82,6 +82,7 @@ struct lp_static_texture_state
    unsigned pot_height:1;
    unsigned pot_depth:1;
    unsigned level_zero_only:1;
+   unsigned tiled:1;         /**< texels stored in 4x4 blocks? */
 };
 
 
@@ -107,6 +108,7 @@ struct lp_static_sampler_state
    unsigned lod_bias_non_zero:1;
    unsigned apply_min_lod:1;  /**< min_lod > 0 ? */
    unsigned apply_max_lod:1;  /**< max_lod < last_level ? */
+   unsigned aniso:5;          /**< max anisotropic probes, 0 if isotropic */
 
    /* Hacks */
    unsigned force_nearest_s:1;
@@ -114,6 +116,14 @@ struct lp_static_sampler_state
 };
 
 
+/**
+ * Most anisotropic probes taken per pixel.  Each probe is a full trilinear
+ * lookup, so the count is picked per pixel from the footprint and never
+ * exceeds this, whatever max_anisotropy is.
+ */
+#define LP_MAX_ANISO_PROBES 16
+
+
 /**
  * Sampler dynamic state.
  *
@@ -284,6 +294,15 @@ struct lp_build_sample_context
 
    /** Integer vector with texture width, height, depth */
    LLVMValueRef int_size;
+
+   /**
+    * Anisotropic filtering footprint, set by the lod computation: the
+    * number of probes (float) and the normalized s/t step between them.
+    * NULL when sampling isotropically.
+    */
+   LLVMValueRef aniso_probes;
+   LLVMValueRef aniso_ds;
+   LLVMValueRef aniso_dt;
 };
 
 
@@ -305,6 +324,18 @@ lp_is_simple_wrap_mode(unsigned mode)
 }
 
 
+/**
+ * Return whether the given mode is supported by lp_build_sample_aos(),
+ * which does PIPE_TEX_WRAP_MIRROR_REPEAT with float address calcs.
+ */
+static INLINE boolean
+lp_is_aos_wrap_mode(unsigned mode)
+{
+   return lp_is_simple_wrap_mode(mode) ||
+          mode == PIPE_TEX_WRAP_MIRROR_REPEAT;
+}
+
+
 static INLINE void
 apply_sampler_swizzle(struct lp_build_sample_context *bld,
                       LLVMValueRef *texel)
@@ -450,9 +481,23 @@ lp_build_sample_partial_offset(struct lp_build_context *bld,
                                LLVMValueRef *out_i);
 
 
+LLVMValueRef
+lp_build_sample_tiled_offset_x(struct lp_build_context *bld,
+                               LLVMValueRef x,
+                               LLVMValueRef x_stride);
+
+
+LLVMValueRef
+lp_build_sample_tiled_offset_y(struct lp_build_context *bld,
+                               LLVMValueRef y,
+                               LLVMValueRef y_stride,
+                               LLVMValueRef x_stride);
+
+
 void
 lp_build_sample_offset(struct lp_build_context *bld,
                        const struct util_format_description *format_desc,
+                       boolean tiled,
                        LLVMValueRef x,
                        LLVMValueRef y,
                        LLVMValueRef z,
@@ -480,6 +525,11 @@ lp_build_sample_soa(struct gallivm_state *gallivm,
                     LLVMValueRef texel_out[4]);
 
 
+LLVMValueRef
+lp_build_coord_mirror(struct lp_build_sample_context *bld,
+                      LLVMValueRef coord);
+
+
 void
 lp_build_coord_repeat_npot_linear(struct lp_build_sample_context *bld,
                                   LLVMValueRef coord_f,
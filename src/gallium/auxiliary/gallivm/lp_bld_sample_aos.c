@@ -181,9 +181,23 @@ lp_build_sample_wrap_nearest_float(struct lp_build_sample_context *bld,
       *icoord = lp_build_itrunc(coord_bld, coord);
       break;
 
+   case PIPE_TEX_WRAP_MIRROR_REPEAT:
+      assert(bld->static_sampler_state->normalized_coords);
+      if (offset) {
+         offset = lp_build_int_to_float(coord_bld, offset);
+         offset = lp_build_div(coord_bld, offset, length);
+         coord = lp_build_add(coord_bld, coord, offset);
+      }
+      /* mirror, unnormalize, clamp the upper edge */
+      coord = lp_build_coord_mirror(bld, coord);
+      coord = lp_build_mul(coord_bld, coord, length);
+      length_minus_one = lp_build_sub(coord_bld, length, coord_bld->one);
+      coord = lp_build_min(coord_bld, coord, length_minus_one);
+      *icoord = lp_build_itrunc(coord_bld, coord);
+      break;
+
    case PIPE_TEX_WRAP_CLAMP:
    case PIPE_TEX_WRAP_CLAMP_TO_BORDER:
-   case PIPE_TEX_WRAP_MIRROR_REPEAT:
    case PIPE_TEX_WRAP_MIRROR_CLAMP:
    case PIPE_TEX_WRAP_MIRROR_CLAMP_TO_EDGE:
    case PIPE_TEX_WRAP_MIRROR_CLAMP_TO_BORDER:
@@ -473,6 +487,26 @@ lp_build_sample_wrap_linear_float(struct lp_build_sample_context *bld,
       *coord1 = lp_build_min(coord_bld, *coord1, length_minus_one);
       *coord1 = lp_build_itrunc(coord_bld, *coord1);
       break;
+   case PIPE_TEX_WRAP_MIRROR_REPEAT:
+      assert(bld->static_sampler_state->normalized_coords);
+      if (offset) {
+         offset = lp_build_int_to_float(coord_bld, offset);
+         offset = lp_build_div(coord_bld, offset, length);
+         coord = lp_build_add(coord_bld, coord, offset);
+      }
+      /* mirror to [0, 1], unnormalize and subtract 0.5 */
+      coord = lp_build_coord_mirror(bld, coord);
+      coord = lp_build_mul(coord_bld, coord, length);
+      if (!force_nearest)
+         coord = lp_build_sub(coord_bld, coord, half);
+      /* coord >= -0.5 so itrunc(coord + 1) == ifloor(coord) + 1 */
+      *coord1 = lp_build_add(coord_bld, coord, coord_bld->one);
+      *coord1 = lp_build_min(coord_bld, *coord1, length_minus_one);
+      *coord1 = lp_build_itrunc(coord_bld, *coord1);
+      /* convert to int, compute lerp weight */
+      lp_build_ifloor_fract(coord_bld, coord, coord0, weight);
+      *coord0 = lp_build_max(int_coord_bld, *coord0, int_coord_bld->zero);
+      break;
    default:
       assert(0);
       *coord0 = int_coord_bld->zero;
@@ -548,6 +582,23 @@ lp_build_sample_fetch_image_nearest(struct lp_build_sample_context *bld,
 }
 
 
+/**
+ * Whether the integer address calcs of lp_build_sample_image_nearest/linear()
+ * can't do the texture, because of a wrap mode or a tiled image.
+ */
+static boolean
+lp_build_sample_needs_float_addr(const struct lp_build_sample_context *bld)
+{
+   const struct lp_static_sampler_state *state = bld->static_sampler_state;
+   const unsigned dims = bld->dims;
+
+   return bld->static_texture_state->tiled ||
+          !lp_is_simple_wrap_mode(state->wrap_s) ||
+          (dims >= 2 && !lp_is_simple_wrap_mode(state->wrap_t)) ||
+          (dims >= 3 && !lp_is_simple_wrap_mode(state->wrap_r));
+}
+
+
 /**
  * Sample a single texture image with nearest sampling.
  * If sampling a cube texture, r = cube face in [0,5].
@@ -769,6 +820,7 @@ lp_build_sample_image_nearest_afloat(struct lp_build_sample_context *bld,
     */
    lp_build_sample_offset(&bld->int_coord_bld,
                           bld->format_desc,
+                          bld->static_texture_state->tiled,
                           x_icoord, y_icoord,
                           z_icoord,
                           row_stride_vec, img_stride_vec,
@@ -1259,14 +1311,23 @@ lp_build_sample_image_linear_afloat(struct lp_build_sample_context *bld,
     * cannot do offset calc with floats, difficult for block-based formats,
     * and not enough precision anyway.
     */
-   lp_build_sample_partial_offset(&bld->int_coord_bld,
-                                  bld->format_desc->block.width,
-                                  x_icoord0, x_stride,
-                                  &x_offset0, &x_subcoord[0]);
-   lp_build_sample_partial_offset(&bld->int_coord_bld,
-                                  bld->format_desc->block.width,
-                                  x_icoord1, x_stride,
-                                  &x_offset1, &x_subcoord[1]);
+   if (bld->static_texture_state->tiled) {
+      x_offset0 = lp_build_sample_tiled_offset_x(&bld->int_coord_bld,
+                                                 x_icoord0, x_stride);
+      x_offset1 = lp_build_sample_tiled_offset_x(&bld->int_coord_bld,
+                                                 x_icoord1, x_stride);
+      x_subcoord[0] = x_subcoord[1] = bld->int_coord_bld.zero;
+   }
+   else {
+      lp_build_sample_partial_offset(&bld->int_coord_bld,
+                                     bld->format_desc->block.width,
+                                     x_icoord0, x_stride,
+                                     &x_offset0, &x_subcoord[0]);
+      lp_build_sample_partial_offset(&bld->int_coord_bld,
+                                     bld->format_desc->block.width,
+                                     x_icoord1, x_stride,
+                                     &x_offset1, &x_subcoord[1]);
+   }
 
    /* add potential cube/array/mip offsets now as they are constant per pixel */
    if (bld->static_texture_state->target == PIPE_TEXTURE_CUBE ||
@@ -1291,14 +1352,25 @@ lp_build_sample_image_linear_afloat(struct lp_build_sample_context *bld,
    }
 
    if (dims >= 2) {
-      lp_build_sample_partial_offset(&bld->int_coord_bld,
-                                     bld->format_desc->block.height,
-                                     y_icoord0, y_stride,
-                                     &y_offset0, &y_subcoord[0]);
-      lp_build_sample_partial_offset(&bld->int_coord_bld,
-                                     bld->format_desc->block.height,
-                                     y_icoord1, y_stride,
-                                     &y_offset1, &y_subcoord[1]);
+      if (bld->static_texture_state->tiled) {
+         y_offset0 = lp_build_sample_tiled_offset_y(&bld->int_coord_bld,
+                                                    y_icoord0, y_stride,
+                                                    x_stride);
+         y_offset1 = lp_build_sample_tiled_offset_y(&bld->int_coord_bld,
+                                                    y_icoord1, y_stride,
+                                                    x_stride);
+         y_subcoord[0] = y_subcoord[1] = bld->int_coord_bld.zero;
+      }
+      else {
+         lp_build_sample_partial_offset(&bld->int_coord_bld,
+                                        bld->format_desc->block.height,
+                                        y_icoord0, y_stride,
+                                        &y_offset0, &y_subcoord[0]);
+         lp_build_sample_partial_offset(&bld->int_coord_bld,
+                                        bld->format_desc->block.height,
+                                        y_icoord1, y_stride,
+                                        &y_offset1, &y_subcoord[1]);
+      }
       for (z = 0; z < 2; z++) {
          for (x = 0; x < 2; x++) {
             offset[z][0][x] = lp_build_add(&bld->int_coord_bld,
@@ -1368,6 +1440,14 @@ lp_build_sample_mipmap(struct lp_build_sample_context *bld,
    LLVMValueRef mipoff1 = NULL;
    LLVMValueRef colors0;
    LLVMValueRef colors1;
+   /*
+    * The mirror wrap modes and tiled images are only done with float
+    * address calcs, which AVX prefers anyway as it has 8x32 floats but
+    * not 8x32 ints.
+    */
+   const boolean use_floats = (util_cpu_caps.has_avx &&
+                               bld->coord_type.length > 4) ||
+                              lp_build_sample_needs_float_addr(bld);
 
    /* sample the first mipmap level */
    lp_build_mipmap_level_sizes(bld, ilevel0,
@@ -1382,7 +1462,7 @@ lp_build_sample_mipmap(struct lp_build_sample_context *bld,
       mipoff0 = lp_build_get_mip_offsets(bld, ilevel0);
    }
 
-   if (util_cpu_caps.has_avx && bld->coord_type.length > 4) {
+   if (use_floats) {
       if (img_filter == PIPE_TEX_FILTER_NEAREST) {
          lp_build_sample_image_nearest_afloat(bld,
                                               size0,
@@ -1476,7 +1556,7 @@ lp_build_sample_mipmap(struct lp_build_sample_context *bld,
             mipoff1 = lp_build_get_mip_offsets(bld, ilevel1);
          }
 
-         if (util_cpu_caps.has_avx && bld->coord_type.length > 4) {
+         if (use_floats) {
             if (img_filter == PIPE_TEX_FILTER_NEAREST) {
                lp_build_sample_image_nearest_afloat(bld,
                                                     size1,
@@ -1557,7 +1637,7 @@ lp_build_sample_mipmap(struct lp_build_sample_context *bld,
 /**
  * Texture sampling in AoS format.  Used when sampling common 32-bit/texel
  * formats.  1D/2D/3D/cube texture supported.  All mipmap sampling modes
- * but only limited texture coord wrap modes.
+ * but only limited texture coord wrap modes (see lp_is_aos_wrap_mode()).
  */
 void
 lp_build_sample_aos(struct lp_build_sample_context *bld,
@@ -1583,11 +1663,11 @@ lp_build_sample_aos(struct lp_build_sample_context *bld,
    struct lp_build_context u8n_bld;
 
    /* we only support the common/simple wrap modes at this time */
-   assert(lp_is_simple_wrap_mode(bld->static_sampler_state->wrap_s));
+   assert(lp_is_aos_wrap_mode(bld->static_sampler_state->wrap_s));
    if (dims >= 2)
-      assert(lp_is_simple_wrap_mode(bld->static_sampler_state->wrap_t));
+      assert(lp_is_aos_wrap_mode(bld->static_sampler_state->wrap_t));
    if (dims >= 3)
-      assert(lp_is_simple_wrap_mode(bld->static_sampler_state->wrap_r));
+      assert(lp_is_aos_wrap_mode(bld->static_sampler_state->wrap_r));
 
 
    /* make 8-bit unorm builder context */
@@ -138,6 +138,7 @@ lp_build_sample_texel_soa(struct lp_build_sample_context *bld,
    /* convert x,y,z coords to linear offset from start of texture, in bytes */
    lp_build_sample_offset(&bld->int_coord_bld,
                           bld->format_desc,
+                          bld->static_texture_state->tiled,
                           x, y, z, y_stride, z_stride,
                           &offset, &i, &j);
    if (mipoffsets) {
@@ -205,7 +206,7 @@ lp_build_sample_texel_soa(struct lp_build_sample_context *bld,
 /**
  * Helper to compute the mirror function for the PIPE_WRAP_MIRROR modes.
  */
-static LLVMValueRef
+LLVMValueRef
 lp_build_coord_mirror(struct lp_build_sample_context *bld,
                       LLVMValueRef coord)
 {
@@ -1287,6 +1288,210 @@ lp_build_sample_general(struct lp_build_sample_context *bld,
  * This function handles texel fetch for all targets where texel fetch is supported
  * (no cube maps, but 1d, 2d, 3d are supported, arrays and buffers should be too).
  */
+/**
+ * Anisotropic texture sampling: average the trilinear lookups at the
+ * probes spread along the major axis of the footprint computed by
+ * lp_build_rho_aniso().  The probe count varies per quad, so the loop
+ * runs for the largest one and masks off the extra probes of the others.
+ */
+static void
+lp_build_sample_aniso(struct lp_build_sample_context *bld,
+                      unsigned sampler_unit,
+                      LLVMValueRef s,
+                      LLVMValueRef t,
+                      LLVMValueRef r,
+                      const LLVMValueRef *offsets,
+                      LLVMValueRef lod_ipart,
+                      LLVMValueRef lod_fpart,
+                      LLVMValueRef ilevel0,
+                      LLVMValueRef ilevel1,
+                      LLVMValueRef texel_out[4])
+{
+   struct gallivm_state *gallivm = bld->gallivm;
+   LLVMBuilderRef builder = gallivm->builder;
+   struct lp_build_context *coord_bld = &bld->coord_bld;
+   struct lp_build_context *texel_bld = &bld->texel_bld;
+   const unsigned num_quads = coord_bld->type.length / 4;
+   LLVMValueRef probes = bld->aniso_probes;
+   LLVMValueRef first, max_probes;
+   LLVMValueRef sum[4];
+   struct lp_build_loop_state loop;
+   unsigned chan, i;
+
+   assert(texel_bld->type.floating);
+
+   /* probe i is at coord + step * (i - (probes - 1) / 2) */
+   first = lp_build_sub(coord_bld, coord_bld->one, probes);
+   first = lp_build_mul(coord_bld, first,
+                        lp_build_const_vec(gallivm, coord_bld->type, 0.5));
+
+   max_probes = LLVMBuildExtractElement(builder, probes,
+                                        lp_build_const_int32(gallivm, 0), "");
+   for (i = 1; i < num_quads; i++) {
+      LLVMValueRef quad_probes =
+         LLVMBuildExtractElement(builder, probes,
+                                 lp_build_const_int32(gallivm, 4 * i), "");
+      max_probes = lp_build_max(&bld->float_bld, max_probes, quad_probes);
+   }
+   max_probes = LLVMBuildFPToSI(builder, max_probes,
+                                LLVMInt32TypeInContext(gallivm->context), "");
+
+   for (chan = 0; chan < 4; chan++) {
+      sum[chan] = lp_build_alloca(gallivm, texel_bld->vec_type, "aniso_sum");
+   }
+
+   lp_build_loop_begin(&loop, gallivm, lp_build_const_int32(gallivm, 0));
+   {
+      LLVMValueRef probe, active, pos, s_i, t_i;
+      LLVMValueRef texel[4];
+
+      probe = LLVMBuildSIToFP(builder, loop.counter,
+                              bld->float_bld.elem_type, "");
+      probe = lp_build_broadcast_scalar(coord_bld, probe);
+      active = lp_build_cmp(coord_bld, PIPE_FUNC_LESS, probe, probes);
+
+      pos = lp_build_add(coord_bld, first, probe);
+      s_i = lp_build_add(coord_bld, s,
+                         lp_build_mul(coord_bld, bld->aniso_ds, pos));
+      t_i = lp_build_add(coord_bld, t,
+                         lp_build_mul(coord_bld, bld->aniso_dt, pos));
+
+      lp_build_sample_general(bld, sampler_unit,
+                              s_i, t_i, r, offsets,
+                              lod_ipart, lod_fpart,
+                              ilevel0, ilevel1,
+                              texel);
+
+      for (chan = 0; chan < 4; chan++) {
+         LLVMValueRef acc = LLVMBuildLoad(builder, sum[chan], "");
+         texel[chan] = lp_build_select(texel_bld, active,
+                                       texel[chan], texel_bld->zero);
+         acc = lp_build_add(texel_bld, acc, texel[chan]);
+         LLVMBuildStore(builder, acc, sum[chan]);
+      }
+   }
+   lp_build_loop_end_cond(&loop, max_probes, NULL, LLVMIntSLT);
+
+   for (chan = 0; chan < 4; chan++) {
+      texel_out[chan] = lp_build_div(texel_bld,
+                                     LLVMBuildLoad(builder, sum[chan], ""),
+                                     probes);
+   }
+}
+
+
+/**
+ * Whether the sampler state lets lp_build_sample_unfiltered() be used:
+ * nearest filtering of a single, non-array 1D/2D image, with wrap modes
+ * which never touch the border color.
+ */
+static boolean
+lp_build_sample_is_unfiltered(const struct lp_build_sample_context *bld)
+{
+   const struct lp_static_sampler_state *sampler = bld->static_sampler_state;
+   const struct lp_static_texture_state *texture = bld->static_texture_state;
+
+   if (texture->target != PIPE_TEXTURE_1D &&
+       texture->target != PIPE_TEXTURE_2D &&
+       texture->target != PIPE_TEXTURE_RECT)
+      return FALSE;
+
+   if (sampler->min_img_filter != PIPE_TEX_FILTER_NEAREST ||
+       sampler->mag_img_filter != PIPE_TEX_FILTER_NEAREST ||
+       sampler->min_mip_filter != PIPE_TEX_MIPFILTER_NONE)
+      return FALSE;
+
+   if (sampler->wrap_s != PIPE_TEX_WRAP_CLAMP_TO_EDGE &&
+       !(sampler->wrap_s == PIPE_TEX_WRAP_REPEAT && texture->pot_width))
+      return FALSE;
+
+   if (bld->dims >= 2 &&
+       sampler->wrap_t != PIPE_TEX_WRAP_CLAMP_TO_EDGE &&
+       !(sampler->wrap_t == PIPE_TEX_WRAP_REPEAT && texture->pot_height))
+      return FALSE;
+
+   return TRUE;
+}
+
+
+/**
+ * Texture sampling specialized for lp_build_sample_is_unfiltered() states.
+ * No lod is needed, so this is just integer texel address math on the
+ * whole vector followed by a gather, instead of the per-quad paths.
+ */
+static void
+lp_build_sample_unfiltered(struct lp_build_sample_context *bld,
+                           unsigned texture_unit,
+                           unsigned sampler_unit,
+                           LLVMValueRef s,
+                           LLVMValueRef t,
+                           const LLVMValueRef *offsets,
+                           LLVMValueRef texel_out[4])
+{
+   const unsigned dims = bld->dims;
+   LLVMValueRef ilevel;
+   LLVMValueRef size;
+   LLVMValueRef row_stride_vec = NULL;
+   LLVMValueRef img_stride_vec = NULL;
+   LLVMValueRef data_ptr;
+   LLVMValueRef width_vec, height_vec, depth_vec;
+   LLVMValueRef flt_width_vec = NULL, flt_height_vec = NULL, flt_depth_vec;
+   LLVMValueRef x, y = NULL;
+
+   assert(bld->num_lods == 1);
+
+   if (bld->static_texture_state->level_zero_only) {
+      ilevel = lp_build_const_int32(bld->gallivm, 0);
+   }
+   else {
+      ilevel = bld->dynamic_state->first_level(bld->dynamic_state,
+                                               bld->gallivm, texture_unit);
+   }
+
+   lp_build_mipmap_level_sizes(bld, ilevel,
+                               &size,
+                               &row_stride_vec, &img_stride_vec);
+   data_ptr = lp_build_get_mipmap_level(bld, ilevel);
+
+   lp_build_extract_image_sizes(bld,
+                                &bld->int_size_bld,
+                                bld->int_coord_type,
+                                size,
+                                &width_vec, &height_vec, &depth_vec);
+
+   if (bld->static_sampler_state->normalized_coords) {
+      LLVMValueRef flt_size;
+
+      flt_size = lp_build_int_to_float(&bld->float_size_bld, size);
+
+      lp_build_extract_image_sizes(bld,
+                                   &bld->float_size_bld,
+                                   bld->coord_type,
+                                   flt_size,
+                                   &flt_width_vec, &flt_height_vec,
+                                   &flt_depth_vec);
+   }
+
+   x = lp_build_sample_wrap_nearest(bld, s, width_vec, flt_width_vec,
+                                    offsets[0], TRUE,
+                                    bld->static_sampler_state->wrap_s);
+   lp_build_name(x, "tex.x.wrapped");
+
+   if (dims >= 2) {
+      y = lp_build_sample_wrap_nearest(bld, t, height_vec, flt_height_vec,
+                                       offsets[1], TRUE,
+                                       bld->static_sampler_state->wrap_t);
+      lp_build_name(y, "tex.y.wrapped");
+   }
+
+   lp_build_sample_texel_soa(bld, sampler_unit,
+                             width_vec, height_vec, depth_vec,
+                             x, y, NULL,
+                             row_stride_vec, img_stride_vec,
+                             data_ptr, NULL, texel_out);
+}
+
+
 static void
 lp_build_fetch_texel(struct lp_build_sample_context *bld,
                      unsigned texture_unit,
@@ -1362,6 +1567,7 @@ lp_build_fetch_texel(struct lp_build_sample_context *bld,
 
    lp_build_sample_offset(int_coord_bld,
                           bld->format_desc,
+                          bld->static_texture_state->tiled,
                           x, y, z, row_stride_vec, img_stride_vec,
                           &offset, &i, &j);
 
@@ -1640,12 +1846,22 @@ lp_build_sample_soa(struct gallivm_state *gallivm,
                            texel_out);
    }
 
+   else if (lp_build_sample_is_unfiltered(&bld)) {
+      lp_build_sample_unfiltered(&bld, texture_index, sampler_index,
+                                 s, t, offsets,
+                                 texel_out);
+
+      lp_build_sample_compare(&bld, coords, texel_out);
+   }
+
    else {
       LLVMValueRef lod_ipart = NULL, lod_fpart = NULL;
       LLVMValueRef ilevel0 = NULL, ilevel1 = NULL;
       boolean use_aos = util_format_fits_8unorm(bld.format_desc) &&
-                        lp_is_simple_wrap_mode(static_sampler_state->wrap_s) &&
-                        lp_is_simple_wrap_mode(static_sampler_state->wrap_t);
+                        lp_is_aos_wrap_mode(static_sampler_state->wrap_s) &&
+                        lp_is_aos_wrap_mode(static_sampler_state->wrap_t) &&
+                        (dims < 3 ||
+                         lp_is_aos_wrap_mode(static_sampler_state->wrap_r));
 
       if ((gallivm_debug & GALLIVM_DEBUG_PERF) &&
           !use_aos && util_format_fits_8unorm(bld.format_desc)) {
@@ -1665,6 +1881,11 @@ lp_build_sample_soa(struct gallivm_state *gallivm,
                              &lod_ipart, &lod_fpart,
                              &ilevel0, &ilevel1);
 
+      /* the probes are only done with floats */
+      if (bld.aniso_probes) {
+         use_aos = FALSE;
+      }
+
       /*
        * we only try 8-wide sampling with soa as it appears to
        * be a loss with aos with AVX (but it should work).
@@ -1692,6 +1913,14 @@ lp_build_sample_soa(struct gallivm_state *gallivm,
                                 texel_out);
          }
 
+         else if (bld.aniso_probes) {
+            lp_build_sample_aniso(&bld, sampler_index,
+                                  s, t, r, offsets,
+                                  lod_ipart, lod_fpart,
+                                  ilevel0, ilevel1,
+                                  texel_out);
+         }
+
          else {
             lp_build_sample_general(&bld, sampler_index,
                                     s, t, r, offsets,
@@ -62,6 +62,7 @@ struct lp_build_mask_context;
 struct gallivm_state;
 struct lp_derivatives;
 struct lp_build_tgsi_gs_iface;
+struct lp_build_tgsi_cs_iface;
 
 
 enum lp_build_tex_modifier {
@@ -156,6 +157,12 @@ struct lp_bld_tgsi_system_values {
    LLVMValueRef instance_id;
    LLVMValueRef vertex_id;
    LLVMValueRef prim_id;
+
+   /* Compute shaders: thread_id is a vector, the others are scalars */
+   LLVMValueRef thread_id[3];
+   LLVMValueRef block_id[3];
+   LLVMValueRef block_size[3];
+   LLVMValueRef grid_size[3];
 };
 
 
@@ -226,7 +233,8 @@ lp_build_tgsi_soa(struct gallivm_state *gallivm,
                   LLVMValueRef (*outputs)[4],
                   struct lp_build_sampler_soa *sampler,
                   const struct tgsi_shader_info *info,
-                  const struct lp_build_tgsi_gs_iface *gs_iface);
+                  const struct lp_build_tgsi_gs_iface *gs_iface,
+                  const struct lp_build_tgsi_cs_iface *cs_iface);
 
 
 void
@@ -409,6 +417,56 @@ struct lp_build_tgsi_gs_iface
                        LLVMValueRef emitted_prims_vec);
 };
 
+/**
+ * Memory access and synchronization for compute shaders.
+ *
+ * The resource is either the index of a RES register bound with
+ * set_compute_resources(), or one of the TGSI_RESOURCE_* memory spaces.
+ * resource_index is NULL, unless the RES register is indirectly addressed.
+ * The coords are the x, y and z components of the address operand, whose
+ * meaning depends on the resource; values are integer vectors.  Only the
+ * lanes set in mask may access memory.
+ */
+struct lp_build_tgsi_cs_iface
+{
+   /** Instruction the kernel starts at, see pipe_context::launch_grid */
+   unsigned pc;
+
+   /** Fetch the channels in writemask into values[] */
+   void (*emit_load)(const struct lp_build_tgsi_cs_iface *cs_iface,
+                     struct lp_build_tgsi_context * bld_base,
+                     unsigned resource,
+                     LLVMValueRef resource_index,
+                     const LLVMValueRef *coords,
+                     unsigned writemask,
+                     LLVMValueRef mask,
+                     LLVMValueRef *values);
+   void (*emit_store)(const struct lp_build_tgsi_cs_iface *cs_iface,
+                      struct lp_build_tgsi_context * bld_base,
+                      unsigned resource,
+                      LLVMValueRef resource_index,
+                      const LLVMValueRef *coords,
+                      unsigned writemask,
+                      LLVMValueRef mask,
+                      const LLVMValueRef *values);
+   /**
+    * Apply the TGSI_OPCODE_ATOM* opcode to channel chan, returning the
+    * previous contents.  src1 is only used by ATOMCAS.
+    */
+   LLVMValueRef (*emit_atomic)(const struct lp_build_tgsi_cs_iface *cs_iface,
+                               struct lp_build_tgsi_context * bld_base,
+                               unsigned opcode,
+                               unsigned resource,
+                               LLVMValueRef resource_index,
+                               const LLVMValueRef *coords,
+                               unsigned chan,
+                               LLVMValueRef mask,
+                               LLVMValueRef src0,
+                               LLVMValueRef src1);
+   void (*emit_barrier)(const struct lp_build_tgsi_cs_iface *cs_iface,
+                        struct lp_build_tgsi_context * bld_base);
+};
+
 struct lp_build_tgsi_soa_context
 {
    struct lp_build_tgsi_context bld_base;
@@ -422,6 +480,8 @@ struct lp_build_tgsi_soa_context
    LLVMValueRef emitted_vertices_vec_ptr;
    LLVMValueRef max_output_vertices_vec;
 
+   const struct lp_build_tgsi_cs_iface *cs_iface;
+
    LLVMValueRef consts_ptr;
    const LLVMValueRef (*inputs)[TGSI_NUM_CHANNELS];
    LLVMValueRef (*outputs)[TGSI_NUM_CHANNELS];
@@ -437,9 +497,11 @@ struct lp_build_tgsi_soa_context
 
    /* We allocate/use this array of temps if (1 << TGSI_FILE_TEMPORARY) is
     * set in the indirect_files field.
-    * The temps[] array above is unused then.
+    * Only the temps flagged in indirect_temps live there then, the others
+    * still use the temps[] array above so they can be kept in registers.
     */
    LLVMValueRef temps_array;
+   uint32_t indirect_temps[(LP_MAX_TGSI_TEMPS + 31) / 32];
 
    /* We allocate/use this array of output if (1 << TGSI_FILE_OUTPUT) is
     * set in the indirect_files field.
@@ -529,9 +591,11 @@ struct lp_build_tgsi_aos_context
 
    /* We allocate/use this array of temps if (1 << TGSI_FILE_TEMPORARY) is
     * set in the indirect_files field.
-    * The temps[] array above is unused then.
+    * Only the temps flagged in indirect_temps live there then, the others
+    * still use the temps[] array above so they can be kept in registers.
     */
    LLVMValueRef temps_array;
+   uint32_t indirect_temps[(LP_MAX_TGSI_TEMPS + 31) / 32];
 
    /** bitmask indicating which register files are accessed indirectly */
    unsigned indirect_files;
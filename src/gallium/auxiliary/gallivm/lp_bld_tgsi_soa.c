@@ -38,6 +38,7 @@
 
 #include "pipe/p_config.h"
 #include "pipe/p_shader_tokens.h"
+#include "util/u_cpu_detect.h"
 #include "util/u_debug.h"
 #include "util/u_math.h"
 #include "util/u_memory.h"
@@ -54,6 +55,7 @@
 #include "lp_bld_bitarit.h"
 #include "lp_bld_gather.h"
 #include "lp_bld_init.h"
+#include "lp_bld_intr.h"
 #include "lp_bld_logic.h"
 #include "lp_bld_swizzle.h"
 #include "lp_bld_flow.h"
@@ -670,6 +672,14 @@ static void lp_exec_mask_endsub(struct lp_exec_mask *mask, int *pc)
  * \param index  which temporary register
  * \param chan  which channel of the temp register.
  */
+static INLINE boolean
+temp_is_indirect(const struct lp_build_tgsi_soa_context *bld,
+                 unsigned index)
+{
+   return (bld->indirect_files & (1 << TGSI_FILE_TEMPORARY)) &&
+          (bld->indirect_temps[index / 32] & (1u << (index % 32)));
+}
+
 LLVMValueRef
 lp_get_temp_ptr_soa(struct lp_build_tgsi_soa_context *bld,
              unsigned index,
@@ -677,7 +687,7 @@ lp_get_temp_ptr_soa(struct lp_build_tgsi_soa_context *bld,
 {
    LLVMBuilderRef builder = bld->bld_base.base.gallivm->builder;
    assert(chan < 4);
-   if (bld->indirect_files & (1 << TGSI_FILE_TEMPORARY)) {
+   if (temp_is_indirect(bld, index)) {
       LLVMValueRef lindex = lp_build_const_int32(bld->bld_base.base.gallivm, index * 4 + chan);
       return LLVMBuildGEP(builder, bld->temps_array, &lindex, 1, "");
    }
@@ -743,6 +753,26 @@ build_gather(struct lp_build_context *bld,
    LLVMValueRef res = bld->undef;
    unsigned i;
 
+#if HAVE_LLVM >= 0x0303
+   if (util_cpu_caps.has_avx2 &&
+       bld->type.floating && bld->type.width == 32 && bld->type.length == 8) {
+      LLVMContextRef context = bld->gallivm->context;
+      LLVMValueRef args[5];
+      LLVMValueRef mask;
+
+      mask = lp_build_const_int_vec(bld->gallivm, lp_int_type(bld->type), ~0);
+      args[0] = bld->undef;
+      args[1] = LLVMBuildBitCast(builder, base_ptr,
+                                 LLVMPointerType(LLVMInt8TypeInContext(context), 0),
+                                 "");
+      args[2] = indexes;
+      args[3] = LLVMConstBitCast(mask, bld->vec_type);
+      args[4] = LLVMConstInt(LLVMInt8TypeInContext(context), 4, 0);
+      return lp_build_intrinsic(builder, "llvm.x86.avx2.gather.d.ps.256",
+                                bld->vec_type, args, 5);
+   }
+#endif
+
    /*
     * Loop over elements of index_vec, load scalar value, insert it into 'res'.
     */
@@ -761,6 +791,54 @@ build_gather(struct lp_build_context *bld,
 }
 
 
+/**
+ * Gather vector from the constant buffer.
+ * The index is usually the same for all the pixels (the address register is
+ * loaded from a constant or a loop counter), in which case a single scalar
+ * load and broadcast is done instead of the gather.
+ */
+static LLVMValueRef
+build_const_gather(struct lp_build_tgsi_context *bld_base,
+                   LLVMValueRef base_ptr,
+                   LLVMValueRef indexes)
+{
+   struct lp_build_context *bld = &bld_base->base;
+   struct lp_build_context *uint_bld = &bld_base->uint_bld;
+   struct gallivm_state *gallivm = bld->gallivm;
+   LLVMBuilderRef builder = gallivm->builder;
+   struct lp_build_if_state ifthen;
+   LLVMValueRef first, divergent, scalar_ptr, scalar, res_ptr;
+
+   if (bld->type.length == 1) {
+      return build_gather(bld, base_ptr, indexes);
+   }
+
+   first = LLVMBuildExtractElement(builder, indexes,
+                                   lp_build_const_int32(gallivm, 0), "");
+   divergent = lp_build_compare(gallivm, uint_bld->type, PIPE_FUNC_NOTEQUAL,
+                                indexes,
+                                lp_build_broadcast_scalar(uint_bld, first));
+   divergent = lp_build_any_true_range(uint_bld, uint_bld->type.length,
+                                       divergent);
+
+   res_ptr = lp_build_alloca(gallivm, bld->vec_type, "const_gather");
+
+   lp_build_if(&ifthen, gallivm, divergent);
+   {
+      LLVMBuildStore(builder, build_gather(bld, base_ptr, indexes), res_ptr);
+   }
+   lp_build_else(&ifthen);
+   {
+      scalar_ptr = LLVMBuildGEP(builder, base_ptr, &first, 1, "");
+      scalar = LLVMBuildLoad(builder, scalar_ptr, "");
+      LLVMBuildStore(builder, lp_build_broadcast_scalar(bld, scalar), res_ptr);
+   }
+   lp_build_endif(&ifthen);
+
+   return LLVMBuildLoad(builder, res_ptr, "");
+}
+
+
 /**
  * Scatter/store vector.
  */
@@ -943,7 +1021,7 @@ emit_fetch_constant(
       index_vec = lp_build_add(uint_bld, index_vec, swizzle_vec);
 
       /* Gather values from the constant buffer */
-      res = build_gather(&bld_base->base, consts_ptr, index_vec);
+      res = build_const_gather(bld_base, consts_ptr, index_vec);
    }
    else {
       LLVMValueRef index;  /* index into the const buffer */
@@ -1218,6 +1296,26 @@ emit_fetch_temporary(
    return res;
 }
 
+/**
+ * Broadcast channel swizzle of a compute shader 3D index or size, with w
+ * reading as w_value.
+ */
+static LLVMValueRef
+emit_fetch_compute_size(
+   struct lp_build_tgsi_context * bld_base,
+   const LLVMValueRef *values,
+   unsigned swizzle,
+   unsigned w_value)
+{
+   struct lp_build_context *uint_bld = &bld_base->uint_bld;
+
+   if (swizzle < 3)
+      return lp_build_broadcast_scalar(uint_bld, values[swizzle]);
+
+   return lp_build_const_int_vec(bld_base->base.gallivm, uint_bld->type,
+                                 w_value);
+}
+
 static LLVMValueRef
 emit_fetch_system_value(
    struct lp_build_tgsi_context * bld_base,
@@ -1250,6 +1348,32 @@ emit_fetch_system_value(
       atype = TGSI_TYPE_UNSIGNED;
       break;
 
+   case TGSI_SEMANTIC_THREAD_ID:
+      if (swizzle < 3)
+         res = bld->system_values.thread_id[swizzle];
+      else
+         res = bld_base->uint_bld.zero;
+      atype = TGSI_TYPE_UNSIGNED;
+      break;
+
+   case TGSI_SEMANTIC_BLOCK_ID:
+      res = emit_fetch_compute_size(bld_base, bld->system_values.block_id,
+                                    swizzle, 0);
+      atype = TGSI_TYPE_UNSIGNED;
+      break;
+
+   case TGSI_SEMANTIC_BLOCK_SIZE:
+      res = emit_fetch_compute_size(bld_base, bld->system_values.block_size,
+                                    swizzle, 1);
+      atype = TGSI_TYPE_UNSIGNED;
+      break;
+
+   case TGSI_SEMANTIC_GRID_SIZE:
+      res = emit_fetch_compute_size(bld_base, bld->system_values.grid_size,
+                                    swizzle, 1);
+      atype = TGSI_TYPE_UNSIGNED;
+      break;
+
    default:
       assert(!"unexpected semantic in emit_fetch_system_value");
       res = bld_base->base.zero;
@@ -1548,7 +1672,8 @@ emit_store(
    unsigned chan_index;
    struct lp_build_tgsi_soa_context * bld = lp_soa_context(bld_base);
 
-   if(info->num_dst) {
+   /* STORE and the fences name the resource they write as dst */
+   if(info->num_dst && inst->Dst[0].Register.File != TGSI_FILE_RESOURCE) {
       LLVMValueRef pred[TGSI_NUM_CHANNELS];
 
       emit_fetch_predicate( bld, inst, pred );
@@ -2177,7 +2302,7 @@ lp_emit_declaration_soa(
       switch (decl->Declaration.File) {
       case TGSI_FILE_TEMPORARY:
          assert(idx < LP_MAX_TGSI_TEMPS);
-         if (!(bld->indirect_files & (1 << TGSI_FILE_TEMPORARY))) {
+         if (!temp_is_indirect(bld, idx)) {
             for (i = 0; i < TGSI_NUM_CHANNELS; i++)
                bld->temps[idx][i] = lp_build_alloca(gallivm, vec_type, "temp");
          }
@@ -2969,11 +3094,275 @@ nrm_emit(
    }
 }
 
+/**
+ * Lanes a compute shader memory access applies to.
+ */
+static LLVMValueRef
+get_cs_exec_mask(struct lp_build_tgsi_soa_context *bld)
+{
+   LLVMBuilderRef builder = bld->bld_base.base.gallivm->builder;
+   LLVMValueRef mask = lp_build_mask_value(bld->mask);
+
+   if (bld->exec_mask.has_mask) {
+      mask = LLVMBuildAnd(builder, mask, bld->exec_mask.exec_mask, "");
+   }
+   return mask;
+}
+
+/**
+ * Per-lane index of an indirectly addressed RES register, or NULL.
+ */
+static LLVMValueRef
+get_cs_resource_index(struct lp_build_tgsi_soa_context *bld,
+                      unsigned index, boolean indirect,
+                      const struct tgsi_ind_register *indirect_reg)
+{
+   if (!indirect)
+      return NULL;
+
+   return get_indirect_index(bld, TGSI_FILE_RESOURCE, index, indirect_reg);
+}
+
+/**
+ * Fetch the x, y and z components of the address operand of a memory
+ * access instruction as integers.
+ */
+static void
+fetch_cs_coords(struct lp_build_tgsi_context * bld_base,
+                const struct tgsi_full_instruction *inst,
+                unsigned src_op,
+                LLVMValueRef coords[3])
+{
+   LLVMBuilderRef builder = bld_base->base.gallivm->builder;
+   unsigned i;
+
+   for (i = 0; i < 3; i++) {
+      coords[i] = lp_build_emit_fetch(bld_base, inst, src_op, i);
+      coords[i] = LLVMBuildBitCast(builder, coords[i],
+                                   bld_base->uint_bld.vec_type, "");
+   }
+}
+
+static void
+load_emit(
+   const struct lp_build_tgsi_action * action,
+   struct lp_build_tgsi_context * bld_base,
+   struct lp_build_emit_data * emit_data)
+{
+   struct lp_build_tgsi_soa_context * bld = lp_soa_context(bld_base);
+   LLVMBuilderRef builder = bld_base->base.gallivm->builder;
+   const struct tgsi_full_instruction *inst = emit_data->inst;
+   const struct tgsi_full_src_register *res = &inst->Src[0];
+   LLVMValueRef coords[3];
+   LLVMValueRef values[TGSI_NUM_CHANNELS];
+   unsigned writemask = 0;
+   unsigned chan;
+
+   /* The resource operand's swizzle selects the loaded channels */
+   TGSI_FOR_EACH_DST0_ENABLED_CHANNEL(inst, chan) {
+      writemask |= 1 << tgsi_util_get_full_src_register_swizzle(res, chan);
+   }
+
+   fetch_cs_coords(bld_base, inst, 1, coords);
+
+   bld->cs_iface->emit_load(bld->cs_iface, bld_base,
+                            res->Register.Index,
+                            get_cs_resource_index(bld, res->Register.Index,
+                                                  res->Register.Indirect,
+                                                  &res->Indirect),
+                            coords, writemask, get_cs_exec_mask(bld),
+                            values);
+
+   TGSI_FOR_EACH_DST0_ENABLED_CHANNEL(inst, chan) {
+      unsigned swizzle = tgsi_util_get_full_src_register_swizzle(res, chan);
+      emit_data->output[chan] = LLVMBuildBitCast(builder, values[swizzle],
+                                                 bld_base->base.vec_type, "");
+   }
+}
+
+static void
+store_emit(
+   const struct lp_build_tgsi_action * action,
+   struct lp_build_tgsi_context * bld_base,
+   struct lp_build_emit_data * emit_data)
+{
+   struct lp_build_tgsi_soa_context * bld = lp_soa_context(bld_base);
+   LLVMBuilderRef builder = bld_base->base.gallivm->builder;
+   const struct tgsi_full_instruction *inst = emit_data->inst;
+   const struct tgsi_full_dst_register *res = &inst->Dst[0];
+   LLVMValueRef coords[3];
+   LLVMValueRef values[TGSI_NUM_CHANNELS];
+   unsigned chan;
+
+   fetch_cs_coords(bld_base, inst, 0, coords);
+
+   TGSI_FOR_EACH_DST0_ENABLED_CHANNEL(inst, chan) {
+      values[chan] = lp_build_emit_fetch(bld_base, inst, 1, chan);
+      values[chan] = LLVMBuildBitCast(builder, values[chan],
+                                      bld_base->uint_bld.vec_type, "");
+   }
+
+   bld->cs_iface->emit_store(bld->cs_iface, bld_base,
+                             res->Register.Index,
+                             get_cs_resource_index(bld, res->Register.Index,
+                                                   res->Register.Indirect,
+                                                   &res->Indirect),
+                             coords, res->Register.WriteMask,
+                             get_cs_exec_mask(bld), values);
+}
+
+static void
+atom_emit(
+   const struct lp_build_tgsi_action * action,
+   struct lp_build_tgsi_context * bld_base,
+   struct lp_build_emit_data * emit_data)
+{
+   struct lp_build_tgsi_soa_context * bld = lp_soa_context(bld_base);
+   LLVMBuilderRef builder = bld_base->base.gallivm->builder;
+   const struct tgsi_full_instruction *inst = emit_data->inst;
+   const struct tgsi_full_src_register *res = &inst->Src[0];
+   const unsigned opcode = inst->Instruction.Opcode;
+   LLVMValueRef resource_index;
+   LLVMValueRef coords[3];
+   LLVMValueRef mask;
+   unsigned chan;
+
+   resource_index = get_cs_resource_index(bld, res->Register.Index,
+                                          res->Register.Indirect,
+                                          &res->Indirect);
+   fetch_cs_coords(bld_base, inst, 1, coords);
+   mask = get_cs_exec_mask(bld);
+
+   TGSI_FOR_EACH_DST0_ENABLED_CHANNEL(inst, chan) {
+      LLVMValueRef src0, src1 = NULL;
+      LLVMValueRef old;
+
+      src0 = lp_build_emit_fetch(bld_base, inst, 2, chan);
+      src0 = LLVMBuildBitCast(builder, src0, bld_base->uint_bld.vec_type, "");
+      if (opcode == TGSI_OPCODE_ATOMCAS) {
+         src1 = lp_build_emit_fetch(bld_base, inst, 3, chan);
+         src1 = LLVMBuildBitCast(builder, src1,
+                                 bld_base->uint_bld.vec_type, "");
+      }
+
+      old = bld->cs_iface->emit_atomic(bld->cs_iface, bld_base, opcode,
+                                       res->Register.Index, resource_index,
+                                       coords, chan, mask, src0, src1);
+      emit_data->output[chan] = LLVMBuildBitCast(builder, old,
+                                                 bld_base->base.vec_type, "");
+   }
+}
+
+static void
+barrier_emit(
+   const struct lp_build_tgsi_action * action,
+   struct lp_build_tgsi_context * bld_base,
+   struct lp_build_emit_data * emit_data)
+{
+   struct lp_build_tgsi_soa_context * bld = lp_soa_context(bld_base);
+
+   bld->cs_iface->emit_barrier(bld->cs_iface, bld_base);
+}
+
+static void
+fence_emit(
+   const struct lp_build_tgsi_action * action,
+   struct lp_build_tgsi_context * bld_base,
+   struct lp_build_emit_data * emit_data)
+{
+   /* Memory accesses are done in program order: nothing to do */
+}
+
+static void
+mark_indirect_temps(struct lp_build_tgsi_soa_context *bld,
+                    unsigned first, unsigned last)
+{
+   unsigned i;
+
+   last = MIN2(last, LP_MAX_TGSI_TEMPS - 1);
+   for (i = first; i <= last; i++) {
+      bld->indirect_temps[i / 32] |= 1u << (i % 32);
+   }
+}
+
+/**
+ * Find the temporaries which may be indirectly addressed.
+ * An indirect operand with an ArrayID only accesses the temporary array
+ * declared with that ID, otherwise the whole file may be accessed.
+ */
+static void
+scan_indirect_temps(struct lp_build_tgsi_soa_context *bld,
+                    const struct tgsi_token *tokens)
+{
+   struct tgsi_parse_context parse;
+   struct {
+      unsigned first, count;
+   } arrays[LP_MAX_TGSI_TEMPS + 1];
+   unsigned i;
+
+   memset(arrays, 0, sizeof arrays);
+
+   tgsi_parse_init(&parse, tokens);
+
+   while (!tgsi_parse_end_of_tokens(&parse)) {
+      tgsi_parse_token(&parse);
+
+      if (parse.FullToken.Token.Type == TGSI_TOKEN_TYPE_DECLARATION) {
+         const struct tgsi_full_declaration *decl =
+            &parse.FullToken.FullDeclaration;
+
+         if (decl->Declaration.File == TGSI_FILE_TEMPORARY &&
+             decl->Declaration.Array &&
+             decl->Array.ArrayID <= LP_MAX_TGSI_TEMPS) {
+            arrays[decl->Array.ArrayID].first = decl->Range.First;
+            arrays[decl->Array.ArrayID].count =
+               decl->Range.Last - decl->Range.First + 1;
+         }
+      }
+      else if (parse.FullToken.Token.Type == TGSI_TOKEN_TYPE_INSTRUCTION) {
+         const struct tgsi_full_instruction *inst =
+            &parse.FullToken.FullInstruction;
+         const struct tgsi_ind_register *ind[TGSI_FULL_MAX_DST_REGISTERS +
+                                             TGSI_FULL_MAX_SRC_REGISTERS];
+         unsigned num_ind = 0;
+
+         for (i = 0; i < inst->Instruction.NumDstRegs; i++) {
+            if (inst->Dst[i].Register.File == TGSI_FILE_TEMPORARY &&
+                inst->Dst[i].Register.Indirect)
+               ind[num_ind++] = &inst->Dst[i].Indirect;
+         }
+         for (i = 0; i < inst->Instruction.NumSrcRegs; i++) {
+            if (inst->Src[i].Register.File == TGSI_FILE_TEMPORARY &&
+                inst->Src[i].Register.Indirect)
+               ind[num_ind++] = &inst->Src[i].Indirect;
+         }
+
+         for (i = 0; i < num_ind; i++) {
+            unsigned id = ind[i]->ArrayID;
+
+            if (id && id <= LP_MAX_TGSI_TEMPS && arrays[id].count) {
+               mark_indirect_temps(bld, arrays[id].first,
+                                   arrays[id].first + arrays[id].count - 1);
+            }
+            else {
+               mark_indirect_temps(bld, 0, LP_MAX_TGSI_TEMPS - 1);
+            }
+         }
+      }
+   }
+
+   tgsi_parse_free(&parse);
+}
+
 static void emit_prologue(struct lp_build_tgsi_context * bld_base)
 {
    struct lp_build_tgsi_soa_context * bld = lp_soa_context(bld_base);
    struct gallivm_state * gallivm = bld_base->base.gallivm;
 
+   if (bld->cs_iface) {
+      bld_base->pc = bld->cs_iface->pc;
+   }
+
    if (bld->indirect_files & (1 << TGSI_FILE_TEMPORARY)) {
       LLVMValueRef array_size =
          lp_build_const_int32(gallivm,
@@ -3097,7 +3486,8 @@ lp_build_tgsi_soa(struct gallivm_state *gallivm,
                   LLVMValueRef (*outputs)[TGSI_NUM_CHANNELS],
                   struct lp_build_sampler_soa *sampler,
                   const struct tgsi_shader_info *info,
-                  const struct lp_build_tgsi_gs_iface *gs_iface)
+                  const struct lp_build_tgsi_gs_iface *gs_iface,
+                  const struct lp_build_tgsi_cs_iface *cs_iface)
 {
    struct lp_build_tgsi_soa_context bld;
 
@@ -3122,6 +3512,9 @@ lp_build_tgsi_soa(struct gallivm_state *gallivm,
    bld.sampler = sampler;
    bld.bld_base.info = info;
    bld.indirect_files = info->indirect_files;
+   if (bld.indirect_files & (1 << TGSI_FILE_TEMPORARY)) {
+      scan_indirect_temps(&bld, tokens);
+   }
 
    bld.bld_base.soa = TRUE;
    bld.bld_base.emit_fetch_funcs[TGSI_FILE_CONSTANT] = emit_fetch_constant;
@@ -3206,6 +3599,26 @@ lp_build_tgsi_soa(struct gallivm_state *gallivm,
                                 max_output_vertices);
    }
 
+   if (cs_iface) {
+      bld.cs_iface = cs_iface;
+      bld.bld_base.op_actions[TGSI_OPCODE_LOAD].emit = load_emit;
+      bld.bld_base.op_actions[TGSI_OPCODE_STORE].emit = store_emit;
+      bld.bld_base.op_actions[TGSI_OPCODE_MFENCE].emit = fence_emit;
+      bld.bld_base.op_actions[TGSI_OPCODE_LFENCE].emit = fence_emit;
+      bld.bld_base.op_actions[TGSI_OPCODE_SFENCE].emit = fence_emit;
+      bld.bld_base.op_actions[TGSI_OPCODE_BARRIER].emit = barrier_emit;
+      bld.bld_base.op_actions[TGSI_OPCODE_ATOMUADD].emit = atom_emit;
+      bld.bld_base.op_actions[TGSI_OPCODE_ATOMXCHG].emit = atom_emit;
+      bld.bld_base.op_actions[TGSI_OPCODE_ATOMCAS].emit = atom_emit;
+      bld.bld_base.op_actions[TGSI_OPCODE_ATOMAND].emit = atom_emit;
+      bld.bld_base.op_actions[TGSI_OPCODE_ATOMOR].emit = atom_emit;
+      bld.bld_base.op_actions[TGSI_OPCODE_ATOMXOR].emit = atom_emit;
+      bld.bld_base.op_actions[TGSI_OPCODE_ATOMUMIN].emit = atom_emit;
+      bld.bld_base.op_actions[TGSI_OPCODE_ATOMUMAX].emit = atom_emit;
+      bld.bld_base.op_actions[TGSI_OPCODE_ATOMIMIN].emit = atom_emit;
+      bld.bld_base.op_actions[TGSI_OPCODE_ATOMIMAX].emit = atom_emit;
+   }
+
    lp_exec_mask_init(&bld.exec_mask, &bld.bld_base.int_bld);
 
    bld.system_values = *system_values;
@@ -34,12 +34,14 @@
  */
 
 #include <stdio.h>
+#include <inttypes.h>
 
 #include "hud/hud_context.h"
 #include "hud/hud_private.h"
 #include "hud/font.h"
 
 #include "cso_cache/cso_context.h"
+#include "os/os_time.h"
 #include "util/u_draw_quad.h"
 #include "util/u_inlines.h"
 #include "util/u_memory.h"
@@ -58,6 +60,9 @@ struct hud_context {
 
    struct list_head pane_list;
 
+   /* CSV file all graph values are streamed to, see GALLIUM_HUD_DUMP_FILE */
+   FILE *dump_file;
+
    /* states */
    struct pipe_blend_state alpha_blend;
    struct pipe_depth_stencil_alpha_state dsa;
@@ -648,6 +653,11 @@ hud_graph_add_value(struct hud_graph *gr, uint64_t value)
    if (value > gr->pane->max_value) {
       hud_pane_set_max_value(gr->pane, value);
    }
+
+   if (gr->dump_file) {
+      fprintf(gr->dump_file, "%"PRIu64",%s,%"PRIu64"\n",
+              os_time_get(), gr->name, value);
+   }
 }
 
 static void
@@ -737,12 +747,25 @@ hud_parse_env_var(struct hud_context *hud, const char *env)
       if (strcmp(name, "fps") == 0) {
          hud_fps_graph_install(pane);
       }
+      else if (strcmp(name, "frametime") == 0) {
+         hud_frametime_graph_install(pane, 0);
+      }
+      else if (sscanf(name, "frametime-p%u%s", &i, s) == 1 &&
+               i >= 1 && i <= 100) {
+         hud_frametime_graph_install(pane, i);
+      }
       else if (strcmp(name, "cpu") == 0) {
          hud_cpu_graph_install(pane, ALL_CPUS);
       }
       else if (sscanf(name, "cpu%u%s", &i, s) == 1) {
          hud_cpu_graph_install(pane, i);
       }
+      else if (strcmp(name, "process-cpu") == 0) {
+         hud_task_cpu_graph_install(pane, FALSE);
+      }
+      else if (strcmp(name, "thread-cpu") == 0) {
+         hud_task_cpu_graph_install(pane, TRUE);
+      }
       else if (strcmp(name, "samples-passed") == 0 &&
                has_occlusion_query(hud->pipe->screen)) {
          hud_pipe_query_install(pane, hud->pipe, "samples-passed",
@@ -857,6 +880,35 @@ hud_parse_env_var(struct hud_context *hud, const char *env)
    }
 }
 
+/**
+ * Open the file named by GALLIUM_HUD_DUMP_FILE, if any, and make all graphs
+ * write their values to it, so that stutter can be analyzed offline.
+ */
+static void
+hud_open_dump_file(struct hud_context *hud)
+{
+   const char *filename = debug_get_option("GALLIUM_HUD_DUMP_FILE", NULL);
+   struct hud_pane *pane;
+   struct hud_graph *gr;
+
+   if (!filename || !*filename)
+      return;
+
+   hud->dump_file = fopen(filename, "w");
+   if (!hud->dump_file) {
+      fprintf(stderr, "gallium_hud: can't open '%s' for writing\n", filename);
+      return;
+   }
+
+   fprintf(hud->dump_file, "time,name,value\n");
+
+   LIST_FOR_EACH_ENTRY(pane, &hud->pane_list, head) {
+      LIST_FOR_EACH_ENTRY(gr, &pane->graph_list, head) {
+         gr->dump_file = hud->dump_file;
+      }
+   }
+}
+
 static void
 print_help(struct pipe_screen *screen)
 {
@@ -876,13 +928,22 @@ print_help(struct pipe_screen *screen)
    puts("");
    puts("  Example: GALLIUM_HUD=\"cpu,fps;primitives-generated\"");
    puts("");
+   puts("  GALLIUM_HUD_DUMP_FILE=file also writes every value of every graph");
+   puts("  to the given file, as \"time in microseconds,name,value\" lines.");
+   puts("");
    puts("  Available names:");
    puts("    fps");
+   puts("    frametime (average time between frames in microseconds)");
+   puts("    frametime-pN (Nth percentile of the time between frames, e.g. "
+        "frametime-p99)");
    puts("    cpu");
 
    for (i = 0; i < num_cpus; i++)
       printf("    cpu%i\n", i);
 
+   puts("    process-cpu (CPU load of all threads of this process)");
+   puts("    thread-cpu (CPU load of the thread drawing the HUD)");
+
    if (has_occlusion_query(screen))
       puts("    samples-passed");
    if (has_streamout(screen))
@@ -1069,6 +1130,7 @@ hud_create(struct pipe_context *pipe, struct cso_context *cso)
    LIST_INITHEAD(&hud->pane_list);
 
    hud_parse_env_var(hud, env);
+   hud_open_dump_file(hud);
    return hud;
 }
 
@@ -1094,5 +1156,7 @@ hud_destroy(struct hud_context *hud)
    pipe_sampler_view_reference(&hud->font_sampler_view, NULL);
    pipe_resource_reference(&hud->font.texture, NULL);
    u_upload_destroy(hud->uploader);
+   if (hud->dump_file)
+      fclose(hud->dump_file);
    FREE(hud);
 }
@@ -34,6 +34,11 @@
 #include <stdio.h>
 #include <inttypes.h>
 
+#if defined(PIPE_OS_LINUX)
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
 static boolean
 get_cpu_stats(unsigned cpu_index, uint64_t *busy_time, uint64_t *total_time)
 {
@@ -163,6 +168,125 @@ hud_cpu_graph_install(struct hud_pane *pane, unsigned cpu_index)
    hud_pane_set_max_value(pane, 100);
 }
 
+/**
+ * Return the user + system time of the calling thread or of the whole
+ * process, in microseconds.
+ */
+static boolean
+get_task_cpu_time(boolean thread, uint64_t *time)
+{
+#if defined(PIPE_OS_LINUX)
+   char filename[64];
+   char line[1024];
+   const char *s;
+   uint64_t utime, stime;
+   long ticks_per_second = sysconf(_SC_CLK_TCK);
+   FILE *f;
+
+   if (ticks_per_second <= 0)
+      return FALSE;
+
+   if (thread)
+      sprintf(filename, "/proc/self/task/%li/stat", (long) syscall(SYS_gettid));
+   else
+      strcpy(filename, "/proc/self/stat");
+
+   f = fopen(filename, "r");
+   if (!f)
+      return FALSE;
+
+   s = fgets(line, sizeof(line), f);
+   fclose(f);
+   if (!s)
+      return FALSE;
+
+   /* The command name may contain spaces and parentheses, skip past it.
+    * utime and stime are the 12th and 13th fields after it.
+    */
+   s = strrchr(line, ')');
+   if (!s ||
+       sscanf(s + 1, " %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u"
+              " %"SCNu64" %"SCNu64, &utime, &stime) != 2)
+      return FALSE;
+
+   *time = (utime + stime) * 1000000 / ticks_per_second;
+   return TRUE;
+#else
+   return FALSE;
+#endif
+}
+
+struct task_cpu_info {
+   boolean thread;
+   uint64_t last_cpu_time, last_time;
+};
+
+static void
+query_task_cpu_load(struct hud_graph *gr)
+{
+   struct task_cpu_info *info = gr->query_data;
+   uint64_t now = os_time_get();
+
+   if (info->last_time) {
+      if (info->last_time + gr->pane->period <= now) {
+         uint64_t cpu_time = info->last_cpu_time;
+
+         get_task_cpu_time(info->thread, &cpu_time);
+
+         /* may exceed 100 for a process with several busy threads */
+         hud_graph_add_value(gr, (cpu_time - info->last_cpu_time) * 100 /
+                                 (now - info->last_time));
+
+         info->last_cpu_time = cpu_time;
+         info->last_time = now;
+      }
+   }
+   else {
+      /* initialize */
+      info->last_time = now;
+      get_task_cpu_time(info->thread, &info->last_cpu_time);
+   }
+}
+
+/**
+ * Install a graph of the CPU load of this process ("process-cpu") or of the
+ * thread drawing the HUD ("thread-cpu"), in percent of one CPU.
+ *
+ * Comparing the two shows how much of the load is carried by other threads,
+ * like the llvmpipe rasterizer or the radeon command submission threads.
+ */
+void
+hud_task_cpu_graph_install(struct hud_pane *pane, boolean thread)
+{
+   struct hud_graph *gr;
+   struct task_cpu_info *info;
+   uint64_t cpu_time;
+
+   if (!get_task_cpu_time(thread, &cpu_time))
+      return;
+
+   gr = CALLOC_STRUCT(hud_graph);
+   if (!gr)
+      return;
+
+   strcpy(gr->name, thread ? "thread-cpu" : "process-cpu");
+
+   gr->query_data = CALLOC_STRUCT(task_cpu_info);
+   if (!gr->query_data) {
+      FREE(gr);
+      return;
+   }
+
+   gr->query_new_value = query_task_cpu_load;
+   gr->free_query_data = free_query_data;
+
+   info = gr->query_data;
+   info->thread = thread;
+
+   hud_pane_add_graph(pane, gr);
+   hud_pane_set_max_value(pane, 100);
+}
+
 int
 hud_get_num_cpus(void)
 {
@@ -25,12 +25,16 @@
  *
  **************************************************************************/
 
-/* This file contains code for calculating framerate for displaying on the HUD.
+/* This file contains code for calculating framerate and frame times for
+ * displaying on the HUD.
  */
 
 #include "hud/hud_private.h"
 #include "os/os_time.h"
+#include "util/u_math.h"
 #include "util/u_memory.h"
+#include <stdio.h>
+#include <stdlib.h>
 
 struct fps_info {
    int frames;
@@ -60,6 +64,70 @@ query_fps(struct hud_graph *gr)
    }
 }
 
+/* Maximum number of frame times kept for one sample of the graph.  If more
+ * frames than that are drawn during a period, the sample is taken early.
+ */
+#define MAX_FRAME_TIMES 1024
+
+struct frametime_info {
+   unsigned percentile; /* 0 means the average */
+   uint64_t last_frame;
+   uint64_t last_time;
+   unsigned num_frames;
+   uint64_t frame_times[MAX_FRAME_TIMES]; /* in microseconds */
+};
+
+static int
+compare_uint64(const void *a, const void *b)
+{
+   uint64_t x = *(const uint64_t *)a;
+   uint64_t y = *(const uint64_t *)b;
+
+   return x < y ? -1 : x > y ? 1 : 0;
+}
+
+static uint64_t
+frametime_value(struct frametime_info *info)
+{
+   unsigned i;
+
+   if (!info->percentile) {
+      uint64_t sum = 0;
+
+      for (i = 0; i < info->num_frames; i++)
+         sum += info->frame_times[i];
+      return sum / info->num_frames;
+   }
+
+   /* nearest-rank percentile */
+   qsort(info->frame_times, info->num_frames, sizeof(info->frame_times[0]),
+         compare_uint64);
+   i = (info->num_frames * info->percentile + 99) / 100;
+   return info->frame_times[MAX2(i, 1) - 1];
+}
+
+static void
+query_frametime(struct hud_graph *gr)
+{
+   struct frametime_info *info = gr->query_data;
+   uint64_t now = os_time_get();
+
+   if (info->last_frame) {
+      info->frame_times[info->num_frames++] = now - info->last_frame;
+
+      if (info->last_time + gr->pane->period <= now ||
+          info->num_frames == MAX_FRAME_TIMES) {
+         hud_graph_add_value(gr, frametime_value(info));
+         info->num_frames = 0;
+         info->last_time = now;
+      }
+   }
+   else {
+      info->last_time = now;
+   }
+   info->last_frame = now;
+}
+
 static void
 free_query_data(void *p)
 {
@@ -90,3 +158,39 @@ hud_fps_graph_install(struct hud_pane *pane)
 
    hud_pane_add_graph(pane, gr);
 }
+
+/**
+ * Install a graph of the time between frames, in microseconds.
+ *
+ * Each sample is the average of the frames drawn during the period, or their
+ * given percentile if \p percentile is not zero, so that e.g. the 99th
+ * percentile shows the stutter the average hides.
+ */
+void
+hud_frametime_graph_install(struct hud_pane *pane, unsigned percentile)
+{
+   struct hud_graph *gr = CALLOC_STRUCT(hud_graph);
+   struct frametime_info *info;
+
+   if (!gr)
+      return;
+
+   if (percentile)
+      sprintf(gr->name, "frametime-p%u", percentile);
+   else
+      strcpy(gr->name, "frametime");
+
+   gr->query_data = CALLOC_STRUCT(frametime_info);
+   if (!gr->query_data) {
+      FREE(gr);
+      return;
+   }
+
+   gr->query_new_value = query_frametime;
+   gr->free_query_data = free_query_data;
+
+   info = gr->query_data;
+   info->percentile = MIN2(percentile, 100);
+
+   hud_pane_add_graph(pane, gr);
+}
@@ -30,6 +30,7 @@
 
 #include "pipe/p_context.h"
 #include "util/u_double_list.h"
+#include <stdio.h>
 
 struct hud_graph {
    /* initialized by common code */
@@ -43,6 +44,7 @@ struct hud_graph {
    void *query_data;
    void (*query_new_value)(struct hud_graph *gr);
    void (*free_query_data)(void *ptr); /**< do not use ordinary free() */
+   FILE *dump_file; /* every value is also written here if not NULL */
 
    /* mutable variables */
    unsigned num_vertices;
@@ -81,7 +83,9 @@ void hud_graph_add_value(struct hud_graph *gr, uint64_t value);
 int hud_get_num_cpus(void);
 
 void hud_fps_graph_install(struct hud_pane *pane);
+void hud_frametime_graph_install(struct hud_pane *pane, unsigned percentile);
 void hud_cpu_graph_install(struct hud_pane *pane, unsigned cpu_index);
+void hud_task_cpu_graph_install(struct hud_pane *pane, boolean thread);
 void hud_pipe_query_install(struct hud_pane *pane, struct pipe_context *pipe,
                             const char *name, unsigned query_type,
                             unsigned result_index,
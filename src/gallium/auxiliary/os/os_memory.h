@@ -77,4 +77,26 @@ os_free_aligned(void *ptr);
 
 #endif
 
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Big, long lived allocations (e.g. software rasterizer surfaces).
+ * They are backed by huge pages where the OS allows it and are returned
+ * zero-filled; the alignment must not exceed 4096.  The size passed to
+ * os_free_large() must be the one the memory was allocated with.
+ */
+
+void *
+os_malloc_large(size_t size, size_t alignment);
+
+void
+os_free_large(void *ptr, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* _OS_MEMORY_H_ */
@@ -0,0 +1,139 @@
+/**************************************************************************
+ *
+ * Copyright 2013 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+
+/*
+ * Large allocations.
+ *
+ * On Linux, allocations of at least OS_LARGE_ALLOC_SIZE are anonymous
+ * mappings rounded up to whole huge pages.  Explicit huge pages
+ * (MAP_HUGETLB) are used when the system has some reserved, otherwise
+ * the mapping is aligned to the huge page size and marked for transparent
+ * huge pages.
+ *
+ * The pages are not touched here, so with the default first-touch NUMA
+ * policy each one lands on the node of the thread which first writes it,
+ * i.e. the rasterizer thread binning or shading that part of the surface.
+ * Everything else comes from the regular aligned heap.
+ */
+
+
+#include "pipe/p_config.h"
+
+#include <assert.h>
+#include <string.h>
+
+#include "os_memory.h"
+
+#if defined(PIPE_OS_LINUX)
+#  include <sys/mman.h>
+#endif
+
+
+#define OS_HUGE_PAGE_SIZE    (2 * 1024 * 1024)
+#define OS_LARGE_ALLOC_SIZE  OS_HUGE_PAGE_SIZE
+
+
+#if defined(PIPE_OS_LINUX)
+
+static INLINE size_t
+large_mapping_size(size_t size)
+{
+   return (size + OS_HUGE_PAGE_SIZE - 1) & ~((size_t) OS_HUGE_PAGE_SIZE - 1);
+}
+
+
+static void *
+large_mmap(size_t length)
+{
+   const int prot = PROT_READ | PROT_WRITE;
+   const int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+   char *map, *ptr;
+
+#ifdef MAP_HUGETLB
+   map = mmap(NULL, length, prot, flags | MAP_HUGETLB, -1, 0);
+   if (map != MAP_FAILED)
+      return map;
+#endif
+
+   /* Over-allocate, then trim the mapping to a huge page boundary */
+   map = mmap(NULL, length + OS_HUGE_PAGE_SIZE, prot, flags, -1, 0);
+   if (map == MAP_FAILED)
+      return NULL;
+
+   ptr = (char *) (((uintptr_t) map + OS_HUGE_PAGE_SIZE - 1) &
+                   ~((uintptr_t) OS_HUGE_PAGE_SIZE - 1));
+   if (ptr != map)
+      munmap(map, ptr - map);
+   munmap(ptr + length, map + OS_HUGE_PAGE_SIZE - ptr);
+
+#ifdef MADV_HUGEPAGE
+   madvise(ptr, length, MADV_HUGEPAGE);
+#endif
+
+   return ptr;
+}
+
+#endif /* PIPE_OS_LINUX */
+
+
+void *
+os_malloc_large(size_t size, size_t alignment)
+{
+   void *ptr;
+
+   assert(alignment <= 4096);
+
+#if defined(PIPE_OS_LINUX)
+   if (size >= OS_LARGE_ALLOC_SIZE) {
+      /* anonymous mappings are zero-filled */
+      return large_mmap(large_mapping_size(size));
+   }
+#endif
+
+   ptr = os_malloc_aligned(size, alignment);
+   if (ptr)
+      memset(ptr, 0, size);
+   return ptr;
+}
+
+
+void
+os_free_large(void *ptr, size_t size)
+{
+   if (!ptr)
+      return;
+
+#if defined(PIPE_OS_LINUX)
+   if (size >= OS_LARGE_ALLOC_SIZE) {
+      munmap(ptr, large_mapping_size(size));
+      return;
+   }
+#endif
+
+   os_free_aligned(ptr);
+}
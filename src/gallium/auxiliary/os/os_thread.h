@@ -507,4 +507,37 @@ pipe_tsd_set(pipe_tsd *tsd, void *value)
 
 
 
+/*
+ * Thread affinity.
+ */
+
+/**
+ * Restrict a thread to run on the given CPU only.
+ * \return  0 on success, -1 if not supported / failed
+ */
+static INLINE int
+pipe_thread_set_affinity(pipe_thread thread, unsigned cpu)
+{
+#if defined(PIPE_OS_LINUX) && defined(_GNU_SOURCE) && defined(CPU_SET)
+   cpu_set_t set;
+
+   if (cpu >= CPU_SETSIZE)
+      return -1;
+
+   CPU_ZERO(&set);
+   CPU_SET(cpu, &set);
+   return pthread_setaffinity_np(thread, sizeof set, &set) == 0 ? 0 : -1;
+#elif defined(PIPE_SUBSYSTEM_WINDOWS_USER)
+   if (cpu >= 8 * sizeof(DWORD_PTR))
+      return -1;
+   return SetThreadAffinityMask(thread, (DWORD_PTR) 1 << cpu) ? 0 : -1;
+#else
+   (void) thread;
+   (void) cpu;
+   return -1;
+#endif
+}
+
+
+
 #endif /* OS_THREAD_H_ */
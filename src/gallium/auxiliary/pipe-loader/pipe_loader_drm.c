@@ -55,6 +55,7 @@ struct pipe_loader_drm_device {
    struct pipe_loader_device base;
    struct util_dl_library *lib;
    int fd;
+   boolean authenticated;
 };
 
 #define pipe_loader_drm_device(dev) ((struct pipe_loader_drm_device *)dev)
@@ -88,6 +89,9 @@ find_drm_pci_id(struct pipe_loader_drm_device *ddev)
               &ddev->base.u.pci.chip_id) != 2)
       goto fail;
 
+   udev_device_unref(device);
+   udev_unref(udev);
+
    return TRUE;
 
   fail:
@@ -192,8 +196,9 @@ pipe_loader_drm_probe_fd(struct pipe_loader_device **dev, int fd)
    ddev->base.ops = &pipe_loader_drm_ops;
    ddev->fd = fd;
 
-   pipe_loader_drm_x_auth(fd);
-
+   /* Probing only needs the PCI ID, which udev provides without access
+    * to the device, so X authentication is deferred to screen creation.
+    */
    if (!find_drm_pci_id(ddev))
       goto fail;
 
@@ -255,6 +260,11 @@ pipe_loader_drm_create_screen(struct pipe_loader_device *dev,
    struct pipe_loader_drm_device *ddev = pipe_loader_drm_device(dev);
    const struct drm_driver_descriptor *dd;
 
+   if (!ddev->authenticated) {
+      pipe_loader_drm_x_auth(ddev->fd);
+      ddev->authenticated = TRUE;
+   }
+
    if (!ddev->lib)
       ddev->lib = pipe_loader_find_module(dev, library_paths);
    if (!ddev->lib)
@@ -36,7 +36,7 @@
 struct pipe_loader_sw_device {
    struct pipe_loader_device base;
    struct util_dl_library *lib;
-   struct sw_winsys *ws;
+   struct sw_winsys *(*create_winsys)();
 };
 
 #define pipe_loader_sw_device(dev) ((struct pipe_loader_sw_device *)dev)
@@ -62,7 +62,10 @@ pipe_loader_sw_probe(struct pipe_loader_device **devs, int ndev)
          sdev->base.type = PIPE_LOADER_DEVICE_SOFTWARE;
          sdev->base.driver_name = "swrast";
          sdev->base.ops = &pipe_loader_sw_ops;
-         sdev->ws = backends[i]();
+         /* Creating a winsys may connect to the display, so leave it
+          * until a screen is actually created on the device.
+          */
+         sdev->create_winsys = backends[i];
          devs[i] = &sdev->base;
       }
    }
@@ -88,6 +91,8 @@ pipe_loader_sw_create_screen(struct pipe_loader_device *dev,
 {
    struct pipe_loader_sw_device *sdev = pipe_loader_sw_device(dev);
    struct pipe_screen *(*init)(struct sw_winsys *);
+   struct pipe_screen *screen;
+   struct sw_winsys *ws;
 
    if (!sdev->lib)
       sdev->lib = pipe_loader_find_module(dev, library_paths);
@@ -98,7 +103,16 @@ pipe_loader_sw_create_screen(struct pipe_loader_device *dev,
    if (!init)
       return NULL;
 
-   return init(sdev->ws);
+   ws = sdev->create_winsys();
+   if (!ws)
+      return NULL;
+
+   /* The screen takes ownership of the winsys. */
+   screen = init(ws);
+   if (!screen && ws->destroy)
+      ws->destroy(ws);
+
+   return screen;
 }
 
 static struct pipe_loader_ops pipe_loader_sw_ops = {
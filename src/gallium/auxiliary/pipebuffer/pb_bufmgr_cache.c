@@ -39,6 +39,7 @@
 #include "os/os_thread.h"
 #include "util/u_memory.h"
 #include "util/u_double_list.h"
+#include "util/u_math.h"
 #include "util/u_time.h"
 
 #include "pb_buffer.h"
@@ -51,6 +52,14 @@
 #define SUPER(__derived) (&(__derived)->base)
 
 
+/**
+ * Cached buffers are kept in one bucket per power of two of their size,
+ * so that a request only looks at the two buckets which may hold buffers
+ * in the [size, 2*size) range pb_cache_is_buffer_compat() accepts.
+ */
+#define PB_CACHE_NUM_BUCKETS (sizeof(pb_size) * 8)
+
+
 struct pb_cache_manager;
 
 
@@ -67,7 +76,11 @@ struct pb_cache_buffer
    /** Caching time interval */
    int64_t start, end;
 
+   /** Link in pb_cache_manager::delayed */
    struct list_head head;
+
+   /** Link in the pb_cache_manager::buckets list for the buffer size */
+   struct list_head bucket_head;
 };
 
 
@@ -80,8 +93,18 @@ struct pb_cache_manager
    
    pipe_mutex mutex;
    
+   /** All cached buffers, in the order they were released */
    struct list_head delayed;
    pb_size numDelayed;
+
+   /** The same buffers by size, each list in release order too */
+   struct list_head buckets[PB_CACHE_NUM_BUCKETS];
+
+   /** Total size of the cached buffers */
+   pb_size cacheSize;
+
+   /** Limit of cacheSize, or zero for no limit */
+   pb_size maxCacheSize;
 };
 
 
@@ -101,6 +124,13 @@ pb_cache_manager(struct pb_manager *mgr)
 }
 
 
+static INLINE unsigned
+pb_cache_bucket(pb_size size)
+{
+   return size ? util_logbase2(size) : 0;
+}
+
+
 /**
  * Actually destroy the buffer.
  */
@@ -110,8 +140,11 @@ _pb_cache_buffer_destroy(struct pb_cache_buffer *buf)
    struct pb_cache_manager *mgr = buf->mgr;
 
    LIST_DEL(&buf->head);
+   LIST_DEL(&buf->bucket_head);
    assert(mgr->numDelayed);
    --mgr->numDelayed;
+   assert(mgr->cacheSize >= buf->base.size);
+   mgr->cacheSize -= buf->base.size;
    assert(!pipe_is_referenced(&buf->base.reference));
    pb_reference(&buf->buffer, NULL);
    FREE(buf);
@@ -160,7 +193,17 @@ pb_cache_buffer_destroy(struct pb_buffer *_buf)
    buf->start = os_time_get();
    buf->end = buf->start + mgr->usecs;
    LIST_ADDTAIL(&buf->head, &mgr->delayed);
+   LIST_ADDTAIL(&buf->bucket_head,
+                &mgr->buckets[pb_cache_bucket(buf->base.size)]);
    ++mgr->numDelayed;
+   mgr->cacheSize += buf->base.size;
+
+   /* Over the limit: release the oldest buffers, even if not yet expired */
+   while (mgr->maxCacheSize && mgr->cacheSize > mgr->maxCacheSize) {
+      assert(!LIST_IS_EMPTY(&mgr->delayed));
+      _pb_cache_buffer_destroy(LIST_ENTRY(struct pb_cache_buffer,
+                                          mgr->delayed.next, head));
+   }
    pipe_mutex_unlock(mgr->mutex);
 }
 
@@ -256,6 +299,36 @@ pb_cache_is_buffer_compat(struct pb_cache_buffer *buf,
 }
 
 
+/**
+ * Find a compatible idle buffer in one bucket, oldest first.
+ */
+static struct pb_cache_buffer *
+pb_cache_bucket_find(struct pb_cache_manager *mgr,
+                     unsigned bucket,
+                     pb_size size,
+                     const struct pb_desc *desc)
+{
+   struct list_head *curr;
+
+   for (curr = mgr->buckets[bucket].next;
+        curr != &mgr->buckets[bucket];
+        curr = curr->next) {
+      struct pb_cache_buffer *buf =
+         LIST_ENTRY(struct pb_cache_buffer, curr, bucket_head);
+      int ret = pb_cache_is_buffer_compat(buf, size, desc);
+
+      if (ret > 0)
+         return buf;
+
+      /* Buffers released after a busy one are likely to be busy too */
+      if (ret == -1)
+         break;
+   }
+
+   return NULL;
+}
+
+
 static struct pb_buffer *
 pb_cache_manager_create_buffer(struct pb_manager *_mgr, 
                                pb_size size,
@@ -263,54 +336,30 @@ pb_cache_manager_create_buffer(struct pb_manager *_mgr,
 {
    struct pb_cache_manager *mgr = pb_cache_manager(_mgr);
    struct pb_cache_buffer *buf;
-   struct pb_cache_buffer *curr_buf;
-   struct list_head *curr, *next;
-   int64_t now;
-   int ret = 0;
+   unsigned bucket = pb_cache_bucket(size);
 
    pipe_mutex_lock(mgr->mutex);
 
-   buf = NULL;
-   curr = mgr->delayed.next;
-   next = curr->next;
-   
-   /* search in the expired buffers, freeing them in the process */
-   now = os_time_get();
-   while(curr != &mgr->delayed) {
-      curr_buf = LIST_ENTRY(struct pb_cache_buffer, curr, head);
-      if(!buf && (ret = pb_cache_is_buffer_compat(curr_buf, size, desc) > 0))
-         buf = curr_buf;
-      else if(os_time_timeout(curr_buf->start, curr_buf->end, now))
-         _pb_cache_buffer_destroy(curr_buf);
-      else
-         /* This buffer (and all hereafter) are still hot in cache */
-         break;
-      if (ret == -1)
-         break;
-      curr = next; 
-      next = curr->next;
-   }
+   /* Compatible buffers are less than twice as large as requested, so
+    * they are either in the bucket of the size or, unless the size is a
+    * power of two, in the next one.
+    */
+   buf = pb_cache_bucket_find(mgr, bucket, size, desc);
+   if (!buf && !util_is_power_of_two(size) &&
+       bucket + 1 < PB_CACHE_NUM_BUCKETS)
+      buf = pb_cache_bucket_find(mgr, bucket + 1, size, desc);
 
-   /* keep searching in the hot buffers */
-   if(!buf && ret != -1) {
-      while(curr != &mgr->delayed) {
-         curr_buf = LIST_ENTRY(struct pb_cache_buffer, curr, head);
-         ret = pb_cache_is_buffer_compat(curr_buf, size, desc);
-         if (ret > 0) {
-            buf = curr_buf;
-            break;
-         }
-         if (ret == -1)
-            break;
-         /* no need to check the timeout here */
-         curr = next;
-         next = curr->next;
-      }
-   }
-   
    if(buf) {
       LIST_DEL(&buf->head);
+      LIST_DEL(&buf->bucket_head);
       --mgr->numDelayed;
+      mgr->cacheSize -= buf->base.size;
+   }
+
+   /* free the expired buffers */
+   _pb_cache_buffer_list_check_free(mgr);
+
+   if(buf) {
       pipe_mutex_unlock(mgr->mutex);
       /* Increase refcount */
       pipe_reference_init(&buf->base.reference, 1);
@@ -387,9 +436,11 @@ pb_cache_manager_destroy(struct pb_manager *mgr)
 
 struct pb_manager *
 pb_cache_manager_create(struct pb_manager *provider, 
-                     	unsigned usecs) 
+                     	unsigned usecs,
+                        pb_size maximum_cache_size)
 {
    struct pb_cache_manager *mgr;
+   unsigned i;
 
    if(!provider)
       return NULL;
@@ -405,6 +456,10 @@ pb_cache_manager_create(struct pb_manager *provider,
    mgr->usecs = usecs;
    LIST_INITHEAD(&mgr->delayed);
    mgr->numDelayed = 0;
+   for (i = 0; i < PB_CACHE_NUM_BUCKETS; i++)
+      LIST_INITHEAD(&mgr->buckets[i]);
+   mgr->cacheSize = 0;
+   mgr->maxCacheSize = maximum_cache_size;
    pipe_mutex_init(mgr->mutex);
       
    return &mgr->base;
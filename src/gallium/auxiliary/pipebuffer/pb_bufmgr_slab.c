@@ -123,10 +123,15 @@ struct pb_slab_manager
    /** 
     * Partial slabs
     * 
-    * Full slabs are not stored in any list. Empty slabs are destroyed 
-    * immediatly.
+    * Full slabs are not stored in any list.  One empty slab is kept at the
+    * end of the list, so that a buffer freed and allocated again on a slab
+    * boundary doesn't create, map and destroy a slab each time; any other
+    * empty slab is destroyed immediately.
     */
    struct list_head slabs;
+
+   /** Number of empty slabs in the slabs list, zero or one */
+   unsigned numEmptySlabs;
    
    pipe_mutex mutex;
 };
@@ -187,6 +192,22 @@ pb_slab_range_manager(struct pb_manager *mgr)
 }
 
 
+/**
+ * Destroy an empty slab.  Called with the manager's mutex held.
+ */
+static void
+pb_slab_destroy(struct pb_slab *slab)
+{
+   struct list_head *list = &slab->head;
+
+   assert(slab->numFree == slab->numBuffers);
+   LIST_DELINIT(list);
+   pb_reference(&slab->bo, NULL);
+   FREE(slab->buffers);
+   FREE(slab);
+}
+
+
 /**
  * Delete a buffer from the slab delayed list and put
  * it on the slab FREE list.
@@ -212,13 +233,17 @@ pb_slab_buffer_destroy(struct pb_buffer *_buf)
    if (slab->head.next == &slab->head)
       LIST_ADDTAIL(&slab->head, &mgr->slabs);
 
-   /* If the slab becomes totally empty, free it */
+   /* If the slab becomes totally empty, keep it as the spare slab behind
+    * the partial ones, or free it if there already is one */
    if (slab->numFree == slab->numBuffers) {
-      list = &slab->head;
-      LIST_DELINIT(list);
-      pb_reference(&slab->bo, NULL);
-      FREE(slab->buffers);
-      FREE(slab);
+      if (mgr->numEmptySlabs) {
+         pb_slab_destroy(slab);
+      }
+      else {
+         LIST_DEL(&slab->head);
+         LIST_ADDTAIL(&slab->head, &mgr->slabs);
+         mgr->numEmptySlabs++;
+      }
    }
 
    pipe_mutex_unlock(mgr->mutex);
@@ -358,6 +383,7 @@ pb_slab_create(struct pb_slab_manager *mgr)
 
    /* Add this slab to the list of partial slabs */
    LIST_ADDTAIL(&slab->head, &mgr->slabs);
+   mgr->numEmptySlabs++;
 
    return PIPE_OK;
 
@@ -375,7 +401,7 @@ pb_slab_manager_create_buffer(struct pb_manager *_mgr,
                               const struct pb_desc *desc)
 {
    struct pb_slab_manager *mgr = pb_slab_manager(_mgr);
-   static struct pb_slab_buffer *buf;
+   struct pb_slab_buffer *buf;
    struct pb_slab *slab;
    struct list_head *list;
 
@@ -398,7 +424,8 @@ pb_slab_manager_create_buffer(struct pb_manager *_mgr,
 
    pipe_mutex_lock(mgr->mutex);
    
-   /* Create a new slab, if we run out of partial slabs */
+   /* Create a new slab, if we run out of partial slabs.  It becomes the
+    * empty slab until the buffer is taken from it below. */
    if (mgr->slabs.next == &mgr->slabs) {
       (void) pb_slab_create(mgr);
       if (mgr->slabs.next == &mgr->slabs) {
@@ -410,6 +437,11 @@ pb_slab_manager_create_buffer(struct pb_manager *_mgr,
    /* Allocate the buffer from a partial (or just created) slab */
    list = mgr->slabs.next;
    slab = LIST_ENTRY(struct pb_slab, list, head);
+
+   if (slab->numFree == slab->numBuffers) {
+      assert(mgr->numEmptySlabs);
+      mgr->numEmptySlabs--;
+   }
    
    /* If totally full remove from the partial slab list */
    if (--slab->numFree == 0)
@@ -429,11 +461,35 @@ pb_slab_manager_create_buffer(struct pb_manager *_mgr,
 }
 
 
+/**
+ * Destroy the spare empty slab, if any.
+ */
+static void
+pb_slab_manager_release_empty(struct pb_slab_manager *mgr)
+{
+   struct list_head *curr, *next;
+
+   pipe_mutex_lock(mgr->mutex);
+   for (curr = mgr->slabs.next, next = curr->next;
+        mgr->numEmptySlabs && curr != &mgr->slabs;
+        curr = next, next = curr->next) {
+      struct pb_slab *slab = LIST_ENTRY(struct pb_slab, curr, head);
+      if (slab->numFree == slab->numBuffers) {
+         pb_slab_destroy(slab);
+         mgr->numEmptySlabs--;
+      }
+   }
+   pipe_mutex_unlock(mgr->mutex);
+}
+
+
 static void
 pb_slab_manager_flush(struct pb_manager *_mgr)
 {
    struct pb_slab_manager *mgr = pb_slab_manager(_mgr);
 
+   pb_slab_manager_release_empty(mgr);
+
    assert(mgr->provider->flush);
    if(mgr->provider->flush)
       mgr->provider->flush(mgr->provider);
@@ -445,6 +501,8 @@ pb_slab_manager_destroy(struct pb_manager *_mgr)
 {
    struct pb_slab_manager *mgr = pb_slab_manager(_mgr);
 
+   pb_slab_manager_release_empty(mgr);
+
    /* TODO: cleanup all allocated buffers */
    FREE(mgr);
 }
@@ -472,6 +530,7 @@ pb_slab_manager_create(struct pb_manager *provider,
    mgr->desc = *desc;
 
    LIST_INITHEAD(&mgr->slabs);
+   mgr->numEmptySlabs = 0;
    
    pipe_mutex_init(mgr->mutex);
 
@@ -508,8 +567,12 @@ static void
 pb_slab_range_manager_flush(struct pb_manager *_mgr)
 {
    struct pb_slab_range_manager *mgr = pb_slab_range_manager(_mgr);
+   unsigned i;
 
-   /* Individual slabs don't hold any temporary buffers so no need to call them */
+   /* Release the spare slab of each bucket.  This also flushes the
+    * provider, once per bucket, which is harmless. */
+   for (i = 0; i < mgr->numBuckets; ++i)
+      mgr->buckets[i]->flush(mgr->buckets[i]);
    
    assert(mgr->provider->flush);
    if(mgr->provider->flush)
@@ -58,8 +58,13 @@ struct pp_queue_t
 
    struct pipe_surface *tmps[2], *inner_tmps[3], *stencils;
 
+   /* Sampler views of the above, kept alongside the surfaces */
+   struct pipe_sampler_view *tmp_views[2], *inner_tmp_views[3];
+   struct pipe_sampler_view *areamapview;
+
    void ***shaders;             /* Shaders in TGSI form */
    unsigned int *filters;       /* Active filter to filters.h mapping. */
+   unsigned int *nocolor_mask;  /* Channels zeroed by each colour pass */
    struct program *p;
 
    bool fbos_init;
@@ -28,6 +28,7 @@
 #include "postprocess/postprocess.h"
 #include "postprocess/pp_colors.h"
 #include "postprocess/pp_filters.h"
+#include "util/u_string.h"
 
 /** The run function of the color filters */
 void
@@ -37,8 +38,8 @@ pp_nocolor(struct pp_queue_t *ppq, struct pipe_resource *in,
 
    struct program *p = ppq->p;
 
-   pp_filter_setup_in(p, in);
-   pp_filter_setup_out(p, out);
+   pp_filter_setup_in(ppq, in);
+   pp_filter_setup_out(ppq, out);
 
    pp_filter_set_fb(p);
    pp_filter_misc_state(p);
@@ -57,33 +58,58 @@ pp_nocolor(struct pp_queue_t *ppq, struct pipe_resource *in,
 
 /* Init functions */
 
-bool
-pp_nored_init(struct pp_queue_t *ppq, unsigned int n, unsigned int val)
+/**
+ * Zero the given channels in pass n. Neighbouring colour filters are folded
+ * into the same pass by pp_init, so merge with what the pass already zeroes.
+ */
+static bool
+pp_nocolor_init_mask(struct pp_queue_t *ppq, unsigned int n,
+                     unsigned int mask)
 {
-   ppq->shaders[n][1] =
-      pp_tgsi_to_state(ppq->p->pipe, nored, false, "nored");
+   struct pipe_context *pipe = ppq->p->pipe;
+   char text[sizeof(nocolor) + 4];
+   char chans[5];
+   unsigned int i, c = 0;
+
+   if (ppq->shaders[n][1]) {
+      pipe->delete_fs_state(pipe, ppq->shaders[n][1]);
+      ppq->shaders[n][1] = NULL;
+   }
+
+   ppq->nocolor_mask[n] |= mask;
+
+   for (i = 0; i < 3; i++) {
+      if (ppq->nocolor_mask[n] & (1 << i))
+         chans[c++] = "xyz"[i];
+   }
+   chans[c] = '\0';
+
+   util_snprintf(text, sizeof(text), nocolor, chans);
+
+   ppq->shaders[n][1] = pp_tgsi_to_state(pipe, text, false, "nocolor");
 
    return (ppq->shaders[n][1] != NULL) ? TRUE : FALSE;
 }
 
 
 bool
-pp_nogreen_init(struct pp_queue_t *ppq, unsigned int n, unsigned int val)
+pp_nored_init(struct pp_queue_t *ppq, unsigned int n, unsigned int val)
 {
-   ppq->shaders[n][1] =
-      pp_tgsi_to_state(ppq->p->pipe, nogreen, false, "nogreen");
+   return pp_nocolor_init_mask(ppq, n, TGSI_WRITEMASK_X);
+}
 
-   return (ppq->shaders[n][1] != NULL) ? TRUE : FALSE;
+
+bool
+pp_nogreen_init(struct pp_queue_t *ppq, unsigned int n, unsigned int val)
+{
+   return pp_nocolor_init_mask(ppq, n, TGSI_WRITEMASK_Y);
 }
 
 
 bool
 pp_noblue_init(struct pp_queue_t *ppq, unsigned int n, unsigned int val)
 {
-   ppq->shaders[n][1] =
-      pp_tgsi_to_state(ppq->p->pipe, noblue, false, "noblue");
-
-   return (ppq->shaders[n][1] != NULL) ? TRUE : FALSE;
+   return pp_nocolor_init_mask(ppq, n, TGSI_WRITEMASK_Z);
 }
 
 /* Free functions */
@@ -43,8 +43,10 @@
 
 /* Helper functions for the filters */
 
-void pp_filter_setup_in(struct program *, struct pipe_resource *);
-void pp_filter_setup_out(struct program *, struct pipe_resource *);
+struct pipe_sampler_view *pp_get_view(struct pp_queue_t *,
+                                      struct pipe_resource *);
+void pp_filter_setup_in(struct pp_queue_t *, struct pipe_resource *);
+void pp_filter_setup_out(struct pp_queue_t *, struct pipe_resource *);
 void pp_filter_end_pass(struct program *);
 void *pp_tgsi_to_state(struct pipe_context *, const char *, bool,
                        const char *);
@@ -35,6 +35,7 @@
 #include "util/u_math.h"
 #include "util/u_debug.h"
 #include "util/u_memory.h"
+#include "util/u_sampler.h"
 #include "cso_cache/cso_context.h"
 
 /** Initialize the post-processing queue. */
@@ -71,9 +72,11 @@ pp_init(struct pipe_context *pipe, const unsigned int *enabled,
 
    ppq->shaders = CALLOC(num_filters, sizeof(void *));
    ppq->filters = CALLOC(num_filters, sizeof(unsigned int));
+   ppq->nocolor_mask = CALLOC(num_filters, sizeof(unsigned int));
 
    if ((ppq->shaders == NULL) ||
-       (ppq->filters == NULL)) {
+       (ppq->filters == NULL) ||
+       (ppq->nocolor_mask == NULL)) {
       pp_debug("Unable to allocate memory for shaders and filter arrays.\n");
       goto error;
    }
@@ -88,6 +91,21 @@ pp_init(struct pipe_context *pipe, const unsigned int *enabled,
    curpos = 0;
    for (i = 0; i < PP_FILTERS; i++) {
       if (enabled[i]) {
+         /*
+          * Filters that can share a pass are folded into the previous one
+          * when it is also fusable, saving a full-screen pass per filter.
+          */
+         if (curpos > 0 && pp_filters[i].fuse &&
+             pp_filters[ppq->filters[curpos - 1]].fuse) {
+            pp_debug("Fusing filter %u into pass %u.\n", i, curpos - 1);
+
+            if (!pp_filters[i].init(ppq, curpos - 1, enabled[i])) {
+               pp_debug("Initialization for filter %u failed.\n", i);
+               goto error;
+            }
+            continue;
+         }
+
          ppq->pp_queue[curpos] = pp_filters[i].main;
          tmp_req = MAX2(tmp_req, pp_filters[i].inner_tmps);
          ppq->filters[curpos] = i;
@@ -155,10 +173,12 @@ pp_free_fbos(struct pp_queue_t *ppq)
       return;
 
    for (i = 0; i < ppq->n_tmp; i++) {
+      pipe_sampler_view_reference(&ppq->tmp_views[i], NULL);
       pipe_surface_reference(&ppq->tmps[i], NULL);
       pipe_resource_reference(&ppq->tmp[i], NULL);
    }
    for (i = 0; i < ppq->n_inner_tmp; i++) {
+      pipe_sampler_view_reference(&ppq->inner_tmp_views[i], NULL);
       pipe_surface_reference(&ppq->inner_tmps[i], NULL);
       pipe_resource_reference(&ppq->inner_tmp[i], NULL);
    }
@@ -238,6 +258,7 @@ pp_free(struct pp_queue_t *ppq)
        * in the create path.
        */
       FREE(ppq->filters);
+      FREE(ppq->nocolor_mask);
       FREE(ppq->shaders);
       FREE(ppq->pp_queue);
   
@@ -271,6 +292,7 @@ pp_init_fbos(struct pp_queue_t *ppq, unsigned int w,
 
    unsigned int i;
    struct pipe_resource tmp_res;
+   struct pipe_sampler_view v_tmp;
 
    if (ppq->fbos_init)
       return;
@@ -299,6 +321,12 @@ pp_init_fbos(struct pp_queue_t *ppq, unsigned int w,
 
       if (!ppq->tmp[i] || !ppq->tmps[i])
          goto error;
+
+      u_sampler_view_default_template(&v_tmp, ppq->tmp[i], tmp_res.format);
+      ppq->tmp_views[i] = p->pipe->create_sampler_view(p->pipe, ppq->tmp[i],
+                                                       &v_tmp);
+      if (!ppq->tmp_views[i])
+         goto error;
    }
 
    for (i = 0; i < ppq->n_inner_tmp; i++) {
@@ -309,6 +337,13 @@ pp_init_fbos(struct pp_queue_t *ppq, unsigned int w,
 
       if (!ppq->inner_tmp[i] || !ppq->inner_tmps[i])
          goto error;
+
+      u_sampler_view_default_template(&v_tmp, ppq->inner_tmp[i],
+                                      tmp_res.format);
+      ppq->inner_tmp_views[i] =
+         p->pipe->create_sampler_view(p->pipe, ppq->inner_tmp[i], &v_tmp);
+      if (!ppq->inner_tmp_views[i])
+         goto error;
    }
 
    tmp_res.bind = PIPE_BIND_DEPTH_STENCIL;
@@ -79,7 +79,7 @@ pp_jimenezmlaa_run(struct pp_queue_t *ppq, struct pipe_resource *in,
    struct program *p = ppq->p;
 
    struct pipe_depth_stencil_alpha_state mstencil;
-   struct pipe_sampler_view v_tmp, *arr[3];
+   struct pipe_sampler_view *arr[3];
 
    unsigned int w = 0;
    unsigned int h = 0;
@@ -128,11 +128,11 @@ pp_jimenezmlaa_run(struct pp_queue_t *ppq, struct pipe_resource *in,
 
    /* First pass: depth edge detection */
    if (iscolor)
-      pp_filter_setup_in(p, in);
+      pp_filter_setup_in(ppq, in);
    else
-      pp_filter_setup_in(p, ppq->depth);
+      pp_filter_setup_in(ppq, ppq->depth);
 
-   pp_filter_setup_out(p, ppq->inner_tmp[0]);
+   pp_filter_setup_out(ppq, ppq->inner_tmp[0]);
 
    pp_filter_set_fb(p);
    pp_filter_misc_state(p);
@@ -157,13 +157,10 @@ pp_jimenezmlaa_run(struct pp_queue_t *ppq, struct pipe_resource *in,
    mstencil.stencil[0].zpass_op = PIPE_STENCIL_OP_KEEP;
    cso_set_depth_stencil_alpha(p->cso, &mstencil);
 
-   pp_filter_setup_in(p, ppq->areamaptex);
-   pp_filter_setup_out(p, ppq->inner_tmp[1]);
+   pp_filter_setup_in(ppq, ppq->areamaptex);
+   pp_filter_setup_out(ppq, ppq->inner_tmp[1]);
 
-   u_sampler_view_default_template(&v_tmp, ppq->inner_tmp[0],
-                                   ppq->inner_tmp[0]->format);
-   arr[1] = arr[2] = p->pipe->create_sampler_view(p->pipe,
-                                                  ppq->inner_tmp[0], &v_tmp);
+   arr[1] = arr[2] = pp_get_view(ppq, ppq->inner_tmp[0]);
 
    pp_filter_set_clear_fb(p);
 
@@ -185,8 +182,8 @@ pp_jimenezmlaa_run(struct pp_queue_t *ppq, struct pipe_resource *in,
 
    /* Third pass: smoothed edges */
    /* Sampler order: colormap, blendmap (wtf compiler) */
-   pp_filter_setup_in(p, ppq->inner_tmp[1]);
-   pp_filter_setup_out(p, out);
+   pp_filter_setup_in(ppq, ppq->inner_tmp[1]);
+   pp_filter_setup_out(ppq, out);
 
    pp_filter_set_fb(p);
 
@@ -196,8 +193,7 @@ pp_jimenezmlaa_run(struct pp_queue_t *ppq, struct pipe_resource *in,
                     0, 0, w, h, 0, PIPE_TEX_MIPFILTER_NEAREST,
                     TGSI_WRITEMASK_XYZW, 0);
 
-   u_sampler_view_default_template(&v_tmp, in, in->format);
-   arr[0] = p->pipe->create_sampler_view(p->pipe, in, &v_tmp);
+   arr[0] = pp_get_view(ppq, in);
 
    cso_single_sampler(p->cso, PIPE_SHADER_FRAGMENT, 0, &p->sampler_point);
    cso_single_sampler(p->cso, PIPE_SHADER_FRAGMENT, 1, &p->sampler_point);
@@ -228,6 +224,7 @@ pp_jimenezmlaa_init_run(struct pp_queue_t *ppq, unsigned int n,
 
    struct pipe_box box;
    struct pipe_resource res;
+   struct pipe_sampler_view v_tmp;
    char *tmp_text = NULL;
 
    tmp_text = CALLOC(sizeof(blend2fs_1) + sizeof(blend2fs_2) +
@@ -279,6 +276,16 @@ pp_jimenezmlaa_init_run(struct pp_queue_t *ppq, unsigned int n,
                                        PIPE_TRANSFER_WRITE, &box,
                                        areamap, 165 * 2, sizeof(areamap));
 
+   u_sampler_view_default_template(&v_tmp, ppq->areamaptex,
+                                   ppq->areamaptex->format);
+   ppq->areamapview = ppq->p->pipe->create_sampler_view(ppq->p->pipe,
+                                                        ppq->areamaptex,
+                                                        &v_tmp);
+   if (ppq->areamapview == NULL) {
+      pp_debug("Failed to create area map sampler view\n");
+      goto fail;
+   }
+
    ppq->shaders[n][1] = pp_tgsi_to_state(ppq->p->pipe, offsetvs, true,
                                          "offsetvs");
    if (iscolor)
@@ -348,6 +355,8 @@ pp_jimenezmlaa_color(struct pp_queue_t *ppq, struct pipe_resource *in,
 void
 pp_jimenezmlaa_free(struct pp_queue_t *ppq, unsigned int n)
 {
+   pipe_sampler_view_reference(&ppq->areamapview, NULL);
+
    if (ppq->areamaptex) {
       ppq->p->screen->resource_destroy(ppq->p->screen, ppq->areamaptex);
       ppq->areamaptex = NULL;
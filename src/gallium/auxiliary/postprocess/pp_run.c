@@ -168,19 +168,62 @@ pp_run(struct pp_queue_t *ppq, struct pipe_resource *in,
 /* Utility functions for the filters. You're not forced to use these if */
 /* your filter is more complicated. */
 
+/**
+ * Get a sampler view of the resource. The queue's own buffers keep theirs
+ * across frames, so only foreign resources get a new view here.
+ */
+struct pipe_sampler_view *
+pp_get_view(struct pp_queue_t *ppq, struct pipe_resource *res)
+{
+   struct pipe_context *pipe = ppq->p->pipe;
+   struct pipe_sampler_view v_tmp, *view = NULL;
+   unsigned int i;
+
+   for (i = 0; i < ppq->n_tmp; i++) {
+      if (res == ppq->tmp[i])
+         pipe_sampler_view_reference(&view, ppq->tmp_views[i]);
+   }
+   for (i = 0; i < ppq->n_inner_tmp; i++) {
+      if (res == ppq->inner_tmp[i])
+         pipe_sampler_view_reference(&view, ppq->inner_tmp_views[i]);
+   }
+   if (res == ppq->areamaptex)
+      pipe_sampler_view_reference(&view, ppq->areamapview);
+
+   if (view)
+      return view;
+
+   u_sampler_view_default_template(&v_tmp, res, res->format);
+   return pipe->create_sampler_view(pipe, res, &v_tmp);
+}
+
 /** Setup this resource as the filter input. */
 void
-pp_filter_setup_in(struct program *p, struct pipe_resource *in)
+pp_filter_setup_in(struct pp_queue_t *ppq, struct pipe_resource *in)
 {
-   struct pipe_sampler_view v_tmp;
-   u_sampler_view_default_template(&v_tmp, in, in->format);
-   p->view = p->pipe->create_sampler_view(p->pipe, in, &v_tmp);
+   ppq->p->view = pp_get_view(ppq, in);
 }
 
 /** Setup this resource as the filter output. */
 void
-pp_filter_setup_out(struct program *p, struct pipe_resource *out)
+pp_filter_setup_out(struct pp_queue_t *ppq, struct pipe_resource *out)
 {
+   struct program *p = ppq->p;
+   unsigned int i;
+
+   for (i = 0; i < ppq->n_tmp; i++) {
+      if (out == ppq->tmp[i]) {
+         pipe_surface_reference(&p->framebuffer.cbufs[0], ppq->tmps[i]);
+         return;
+      }
+   }
+   for (i = 0; i < ppq->n_inner_tmp; i++) {
+      if (out == ppq->inner_tmp[i]) {
+         pipe_surface_reference(&p->framebuffer.cbufs[0], ppq->inner_tmps[i]);
+         return;
+      }
+   }
+
    p->surf.format = out->format;
 
    p->framebuffer.cbufs[0] = p->pipe->create_surface(p->pipe, out, &p->surf);
@@ -60,6 +60,7 @@
 #include "tgsi_exec.h"
 #include "util/u_memory.h"
 #include "util/u_math.h"
+#include "util/u_sse.h"
 
 
 #define DEBUG_EXECUTION 0
@@ -72,6 +73,15 @@
 #define TILE_BOTTOM_LEFT  2
 #define TILE_BOTTOM_RIGHT 3
 
+#if defined(PIPE_ARCH_SSE)
+/*
+ * The common float micro ops below work on a whole channel with SSE.
+ * The results are the same as with the scalar code, including for NaNs.
+ */
+#define CHAN(c)         _mm_loadu_ps((c)->f)
+#define CHAN_BOOL(mask) _mm_and_ps(mask, _mm_set1_ps(1.0f))
+#endif
+
 static void
 micro_abs(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src)
@@ -275,10 +285,15 @@ micro_lrp(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src1,
           const union tgsi_exec_channel *src2)
 {
+#if defined(PIPE_ARCH_SSE)
+   _mm_storeu_ps(dst->f, _mm_add_ps(_mm_mul_ps(CHAN(src0), _mm_sub_ps(CHAN(src1), CHAN(src2))),
+                           CHAN(src2)));
+#else
    dst->f[0] = src0->f[0] * (src1->f[0] - src2->f[0]) + src2->f[0];
    dst->f[1] = src0->f[1] * (src1->f[1] - src2->f[1]) + src2->f[1];
    dst->f[2] = src0->f[2] * (src1->f[2] - src2->f[2]) + src2->f[2];
    dst->f[3] = src0->f[3] * (src1->f[3] - src2->f[3]) + src2->f[3];
+#endif
 }
 
 static void
@@ -287,20 +302,28 @@ micro_mad(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src1,
           const union tgsi_exec_channel *src2)
 {
+#if defined(PIPE_ARCH_SSE)
+   _mm_storeu_ps(dst->f, _mm_add_ps(_mm_mul_ps(CHAN(src0), CHAN(src1)), CHAN(src2)));
+#else
    dst->f[0] = src0->f[0] * src1->f[0] + src2->f[0];
    dst->f[1] = src0->f[1] * src1->f[1] + src2->f[1];
    dst->f[2] = src0->f[2] * src1->f[2] + src2->f[2];
    dst->f[3] = src0->f[3] * src1->f[3] + src2->f[3];
+#endif
 }
 
 static void
 micro_mov(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src)
 {
+#if defined(PIPE_ARCH_SSE)
+   _mm_storeu_ps(dst->f, CHAN(src));
+#else
    dst->u[0] = src->u[0];
    dst->u[1] = src->u[1];
    dst->u[2] = src->u[2];
    dst->u[3] = src->u[3];
+#endif
 }
 
 static void
@@ -313,10 +336,14 @@ micro_rcp(union tgsi_exec_channel *dst,
    assert(src->f[2] != 0.0f);
    assert(src->f[3] != 0.0f);
 #endif
+#if defined(PIPE_ARCH_SSE)
+   _mm_storeu_ps(dst->f, _mm_div_ps(_mm_set1_ps(1.0f), CHAN(src)));
+#else
    dst->f[0] = 1.0f / src->f[0];
    dst->f[1] = 1.0f / src->f[1];
    dst->f[2] = 1.0f / src->f[2];
    dst->f[3] = 1.0f / src->f[3];
+#endif
 }
 
 static void
@@ -360,10 +387,14 @@ micro_seq(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   _mm_storeu_ps(dst->f, CHAN_BOOL(_mm_cmpeq_ps(CHAN(src0), CHAN(src1))));
+#else
    dst->f[0] = src0->f[0] == src1->f[0] ? 1.0f : 0.0f;
    dst->f[1] = src0->f[1] == src1->f[1] ? 1.0f : 0.0f;
    dst->f[2] = src0->f[2] == src1->f[2] ? 1.0f : 0.0f;
    dst->f[3] = src0->f[3] == src1->f[3] ? 1.0f : 0.0f;
+#endif
 }
 
 static void
@@ -371,10 +402,14 @@ micro_sge(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   _mm_storeu_ps(dst->f, CHAN_BOOL(_mm_cmpge_ps(CHAN(src0), CHAN(src1))));
+#else
    dst->f[0] = src0->f[0] >= src1->f[0] ? 1.0f : 0.0f;
    dst->f[1] = src0->f[1] >= src1->f[1] ? 1.0f : 0.0f;
    dst->f[2] = src0->f[2] >= src1->f[2] ? 1.0f : 0.0f;
    dst->f[3] = src0->f[3] >= src1->f[3] ? 1.0f : 0.0f;
+#endif
 }
 
 static void
@@ -402,10 +437,14 @@ micro_sgt(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   _mm_storeu_ps(dst->f, CHAN_BOOL(_mm_cmpgt_ps(CHAN(src0), CHAN(src1))));
+#else
    dst->f[0] = src0->f[0] > src1->f[0] ? 1.0f : 0.0f;
    dst->f[1] = src0->f[1] > src1->f[1] ? 1.0f : 0.0f;
    dst->f[2] = src0->f[2] > src1->f[2] ? 1.0f : 0.0f;
    dst->f[3] = src0->f[3] > src1->f[3] ? 1.0f : 0.0f;
+#endif
 }
 
 static void
@@ -423,10 +462,14 @@ micro_sle(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   _mm_storeu_ps(dst->f, CHAN_BOOL(_mm_cmple_ps(CHAN(src0), CHAN(src1))));
+#else
    dst->f[0] = src0->f[0] <= src1->f[0] ? 1.0f : 0.0f;
    dst->f[1] = src0->f[1] <= src1->f[1] ? 1.0f : 0.0f;
    dst->f[2] = src0->f[2] <= src1->f[2] ? 1.0f : 0.0f;
    dst->f[3] = src0->f[3] <= src1->f[3] ? 1.0f : 0.0f;
+#endif
 }
 
 static void
@@ -434,10 +477,14 @@ micro_slt(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   _mm_storeu_ps(dst->f, CHAN_BOOL(_mm_cmplt_ps(CHAN(src0), CHAN(src1))));
+#else
    dst->f[0] = src0->f[0] < src1->f[0] ? 1.0f : 0.0f;
    dst->f[1] = src0->f[1] < src1->f[1] ? 1.0f : 0.0f;
    dst->f[2] = src0->f[2] < src1->f[2] ? 1.0f : 0.0f;
    dst->f[3] = src0->f[3] < src1->f[3] ? 1.0f : 0.0f;
+#endif
 }
 
 static void
@@ -445,10 +492,14 @@ micro_sne(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   _mm_storeu_ps(dst->f, CHAN_BOOL(_mm_cmpneq_ps(CHAN(src0), CHAN(src1))));
+#else
    dst->f[0] = src0->f[0] != src1->f[0] ? 1.0f : 0.0f;
    dst->f[1] = src0->f[1] != src1->f[1] ? 1.0f : 0.0f;
    dst->f[2] = src0->f[2] != src1->f[2] ? 1.0f : 0.0f;
    dst->f[3] = src0->f[3] != src1->f[3] ? 1.0f : 0.0f;
+#endif
 }
 
 static void
@@ -632,6 +683,11 @@ tgsi_check_soa_dependencies(const struct tgsi_full_instruction *inst)
 }
 
 
+static struct tgsi_exec_decoded_instruction *
+decode_instructions(const struct tgsi_full_instruction *instructions,
+                    uint count);
+
+
 /**
  * Initialize machine state by expanding tokens to full instructions,
  * allocating temporary storage, setting up constants, etc.
@@ -646,6 +702,7 @@ tgsi_exec_machine_bind_shader(
    uint k;
    struct tgsi_parse_context parse;
    struct tgsi_full_instruction *instructions;
+   struct tgsi_exec_decoded_instruction *decoded;
    struct tgsi_full_declaration *declarations;
    uint maxInstructions = 10, numInstructions = 0;
    uint maxDeclarations = 10, numDeclarations = 0;
@@ -667,7 +724,9 @@ tgsi_exec_machine_bind_shader(
       mach->NumDeclarations = 0;
 
       FREE(mach->Instructions);
+      FREE(mach->Decoded);
       mach->Instructions = NULL;
+      mach->Decoded = NULL;
       mach->NumInstructions = 0;
 
       return;
@@ -797,12 +856,21 @@ tgsi_exec_machine_bind_shader(
    }
    tgsi_parse_free (&parse);
 
+   decoded = decode_instructions(instructions, numInstructions);
+   if (!decoded) {
+      FREE( declarations );
+      FREE( instructions );
+      return;
+   }
+
    FREE(mach->Declarations);
    mach->Declarations = declarations;
    mach->NumDeclarations = numDeclarations;
 
    FREE(mach->Instructions);
+   FREE(mach->Decoded);
    mach->Instructions = instructions;
+   mach->Decoded = decoded;
    mach->NumInstructions = numInstructions;
 }
 
@@ -865,6 +933,7 @@ tgsi_exec_machine_destroy(struct tgsi_exec_machine *mach)
 {
    if (mach) {
       FREE(mach->Instructions);
+      FREE(mach->Decoded);
       FREE(mach->Declarations);
 
       align_free(mach->Inputs);
@@ -879,10 +948,14 @@ micro_add(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   _mm_storeu_ps(dst->f, _mm_add_ps(CHAN(src0), CHAN(src1)));
+#else
    dst->f[0] = src0->f[0] + src1->f[0];
    dst->f[1] = src0->f[1] + src1->f[1];
    dst->f[2] = src0->f[2] + src1->f[2];
    dst->f[3] = src0->f[3] + src1->f[3];
+#endif
 }
 
 static void
@@ -958,10 +1031,14 @@ micro_max(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   _mm_storeu_ps(dst->f, _mm_max_ps(CHAN(src0), CHAN(src1)));
+#else
    dst->f[0] = src0->f[0] > src1->f[0] ? src0->f[0] : src1->f[0];
    dst->f[1] = src0->f[1] > src1->f[1] ? src0->f[1] : src1->f[1];
    dst->f[2] = src0->f[2] > src1->f[2] ? src0->f[2] : src1->f[2];
    dst->f[3] = src0->f[3] > src1->f[3] ? src0->f[3] : src1->f[3];
+#endif
 }
 
 static void
@@ -969,10 +1046,14 @@ micro_min(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   _mm_storeu_ps(dst->f, _mm_min_ps(CHAN(src0), CHAN(src1)));
+#else
    dst->f[0] = src0->f[0] < src1->f[0] ? src0->f[0] : src1->f[0];
    dst->f[1] = src0->f[1] < src1->f[1] ? src0->f[1] : src1->f[1];
    dst->f[2] = src0->f[2] < src1->f[2] ? src0->f[2] : src1->f[2];
    dst->f[3] = src0->f[3] < src1->f[3] ? src0->f[3] : src1->f[3];
+#endif
 }
 
 static void
@@ -980,10 +1061,14 @@ micro_mul(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   _mm_storeu_ps(dst->f, _mm_mul_ps(CHAN(src0), CHAN(src1)));
+#else
    dst->f[0] = src0->f[0] * src1->f[0];
    dst->f[1] = src0->f[1] * src1->f[1];
    dst->f[2] = src0->f[2] * src1->f[2];
    dst->f[3] = src0->f[3] * src1->f[3];
+#endif
 }
 
 static void
@@ -1021,10 +1106,14 @@ micro_sub(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   _mm_storeu_ps(dst->f, _mm_sub_ps(CHAN(src0), CHAN(src1)));
+#else
    dst->f[0] = src0->f[0] - src1->f[0];
    dst->f[1] = src0->f[1] - src1->f[1];
    dst->f[2] = src0->f[2] - src1->f[2];
    dst->f[3] = src0->f[3] - src1->f[3];
+#endif
 }
 
 static void
@@ -3470,159 +3559,640 @@ micro_ucmp(union tgsi_exec_channel *dst,
    dst->u[3] = src0->u[3] ? src1->u[3] : src2->u[3];
 }
 
+/**
+ * Instructions that only apply a micro op channel-wise are resolved to
+ * their exec function and micro op once, when the shader is bound, so
+ * the interpreter loop can dispatch them with a single indirect call
+ * instead of walking the opcode switch for every quad.
+ */
+struct tgsi_exec_decoded_instruction
+{
+   void (*exec)(struct tgsi_exec_machine *mach,
+                const struct tgsi_full_instruction *inst,
+                const struct tgsi_exec_decoded_instruction *dec);
+   union {
+      micro_unary_op unary;
+      micro_binary_op binary;
+      micro_trinary_op trinary;
+   } op;
+   enum tgsi_exec_datatype dst_datatype;
+   enum tgsi_exec_datatype src_datatype;
+};
+
 static void
-exec_instruction(
-   struct tgsi_exec_machine *mach,
-   const struct tgsi_full_instruction *inst,
-   int *pc )
+decoded_vector_unary(struct tgsi_exec_machine *mach,
+                     const struct tgsi_full_instruction *inst,
+                     const struct tgsi_exec_decoded_instruction *dec)
 {
-   union tgsi_exec_channel r[10];
+   exec_vector_unary(mach, inst, dec->op.unary, dec->dst_datatype, dec->src_datatype);
+}
 
-   (*pc)++;
+static void
+decoded_scalar_unary(struct tgsi_exec_machine *mach,
+                     const struct tgsi_full_instruction *inst,
+                     const struct tgsi_exec_decoded_instruction *dec)
+{
+   exec_scalar_unary(mach, inst, dec->op.unary, dec->dst_datatype, dec->src_datatype);
+}
+
+static void
+decoded_vector_binary(struct tgsi_exec_machine *mach,
+                      const struct tgsi_full_instruction *inst,
+                      const struct tgsi_exec_decoded_instruction *dec)
+{
+   exec_vector_binary(mach, inst, dec->op.binary, dec->dst_datatype, dec->src_datatype);
+}
 
+static void
+decoded_scalar_binary(struct tgsi_exec_machine *mach,
+                      const struct tgsi_full_instruction *inst,
+                      const struct tgsi_exec_decoded_instruction *dec)
+{
+   exec_scalar_binary(mach, inst, dec->op.binary, dec->dst_datatype, dec->src_datatype);
+}
+
+static void
+decoded_vector_trinary(struct tgsi_exec_machine *mach,
+                       const struct tgsi_full_instruction *inst,
+                       const struct tgsi_exec_decoded_instruction *dec)
+{
+   exec_vector_trinary(mach, inst, dec->op.trinary, dec->dst_datatype, dec->src_datatype);
+}
+
+static void
+decode_instruction(const struct tgsi_full_instruction *inst,
+                   struct tgsi_exec_decoded_instruction *dec)
+{
    switch (inst->Instruction.Opcode) {
    case TGSI_OPCODE_ARL:
-      exec_vector_unary(mach, inst, micro_arl, TGSI_EXEC_DATA_INT, TGSI_EXEC_DATA_FLOAT);
+      dec->exec = decoded_vector_unary;
+      dec->op.unary = micro_arl;
+      dec->dst_datatype = TGSI_EXEC_DATA_INT;
+      dec->src_datatype = TGSI_EXEC_DATA_FLOAT;
       break;
 
    case TGSI_OPCODE_MOV:
-      exec_vector_unary(mach, inst, micro_mov, TGSI_EXEC_DATA_UINT, TGSI_EXEC_DATA_FLOAT);
-      break;
-
-   case TGSI_OPCODE_LIT:
-      exec_lit(mach, inst);
+      dec->exec = decoded_vector_unary;
+      dec->op.unary = micro_mov;
+      dec->dst_datatype = TGSI_EXEC_DATA_UINT;
+      dec->src_datatype = TGSI_EXEC_DATA_FLOAT;
       break;
 
    case TGSI_OPCODE_RCP:
-      exec_scalar_unary(mach, inst, micro_rcp, TGSI_EXEC_DATA_FLOAT, TGSI_EXEC_DATA_FLOAT);
+      dec->exec = decoded_scalar_unary;
+      dec->op.unary = micro_rcp;
+      dec->dst_datatype = TGSI_EXEC_DATA_FLOAT;
+      dec->src_datatype = TGSI_EXEC_DATA_FLOAT;
       break;
 
    case TGSI_OPCODE_RSQ:
-      exec_scalar_unary(mach, inst, micro_rsq, TGSI_EXEC_DATA_FLOAT, TGSI_EXEC_DATA_FLOAT);
-      break;
-
-   case TGSI_OPCODE_EXP:
-      exec_exp(mach, inst);
-      break;
-
-   case TGSI_OPCODE_LOG:
-      exec_log(mach, inst);
+      dec->exec = decoded_scalar_unary;
+      dec->op.unary = micro_rsq;
+      dec->dst_datatype = TGSI_EXEC_DATA_FLOAT;
+      dec->src_datatype = TGSI_EXEC_DATA_FLOAT;
       break;
 
    case TGSI_OPCODE_MUL:
-      exec_vector_binary(mach, inst, micro_mul, TGSI_EXEC_DATA_FLOAT, TGSI_EXEC_DATA_FLOAT);
+      dec->exec = decoded_vector_binary;
+      dec->op.binary = micro_mul;
+      dec->dst_datatype = TGSI_EXEC_DATA_FLOAT;
+      dec->src_datatype = TGSI_EXEC_DATA_FLOAT;
       break;
 
    case TGSI_OPCODE_ADD:
-      exec_vector_binary(mach, inst, micro_add, TGSI_EXEC_DATA_FLOAT, TGSI_EXEC_DATA_FLOAT);
-      break;
-
-   case TGSI_OPCODE_DP3:
-      exec_dp3(mach, inst);
-      break;
-
-   case TGSI_OPCODE_DP4:
-      exec_dp4(mach, inst);
-      break;
-
-   case TGSI_OPCODE_DST:
-      exec_dst(mach, inst);
+      dec->exec = decoded_vector_binary;
+      dec->op.binary = micro_add;
+      dec->dst_datatype = TGSI_EXEC_DATA_FLOAT;
+      dec->src_datatype = TGSI_EXEC_DATA_FLOAT;
       break;
 
    case TGSI_OPCODE_MIN:
-      exec_vector_binary(mach, inst, micro_min, TGSI_EXEC_DATA_FLOAT, TGSI_EXEC_DATA_FLOAT);
+      dec->exec = decoded_vector_binary;
+      dec->op.binary = micro_min;
+      dec->dst_datatype = TGSI_EXEC_DATA_FLOAT;
+      dec->src_datatype = TGSI_EXEC_DATA_FLOAT;
       break;
 
    case TGSI_OPCODE_MAX:
-      exec_vector_binary(mach, inst, micro_max, TGSI_EXEC_DATA_FLOAT, TGSI_EXEC_DATA_FLOAT);
+      dec->exec = decoded_vector_binary;
+      dec->op.binary = micro_max;
+      dec->dst_datatype = TGSI_EXEC_DATA_FLOAT;
+      dec->src_datatype = TGSI_EXEC_DATA_FLOAT;
       break;
 
    case TGSI_OPCODE_SLT:
-      exec_vector_binary(mach, inst, micro_slt, TGSI_EXEC_DATA_FLOAT, TGSI_EXEC_DATA_FLOAT);
+      dec->exec = decoded_vector_binary;
+      dec->op.binary = micro_slt;
+      dec->dst_datatype = TGSI_EXEC_DATA_FLOAT;
+      dec->src_datatype = TGSI_EXEC_DATA_FLOAT;
       break;
 
    case TGSI_OPCODE_SGE:
-      exec_vector_binary(mach, inst, micro_sge, TGSI_EXEC_DATA_FLOAT, TGSI_EXEC_DATA_FLOAT);
+      dec->exec = decoded_vector_binary;
+      dec->op.binary = micro_sge;
+      dec->dst_datatype = TGSI_EXEC_DATA_FLOAT;
+      dec->src_datatype = TGSI_EXEC_DATA_FLOAT;
       break;
 
    case TGSI_OPCODE_MAD:
-      exec_vector_trinary(mach, inst, micro_mad, TGSI_EXEC_DATA_FLOAT, TGSI_EXEC_DATA_FLOAT);
+      dec->exec = decoded_vector_trinary;
+      dec->op.trinary = micro_mad;
+      dec->dst_datatype = TGSI_EXEC_DATA_FLOAT;
+      dec->src_datatype = TGSI_EXEC_DATA_FLOAT;
       break;
 
    case TGSI_OPCODE_SUB:
-      exec_vector_binary(mach, inst, micro_sub, TGSI_EXEC_DATA_FLOAT, TGSI_EXEC_DATA_FLOAT);
+      dec->exec = decoded_vector_binary;
+      dec->op.binary = micro_sub;
+      dec->dst_datatype = TGSI_EXEC_DATA_FLOAT;
+      dec->src_datatype = TGSI_EXEC_DATA_FLOAT;
       break;
 
    case TGSI_OPCODE_LRP:
-      exec_vector_trinary(mach, inst, micro_lrp, TGSI_EXEC_DATA_FLOAT, TGSI_EXEC_DATA_FLOAT);
+      dec->exec = decoded_vector_trinary;
+      dec->op.trinary = micro_lrp;
+      dec->dst_datatype = TGSI_EXEC_DATA_FLOAT;
+      dec->src_datatype = TGSI_EXEC_DATA_FLOAT;
       break;
 
    case TGSI_OPCODE_CND:
-      exec_vector_trinary(mach, inst, micro_cnd, TGSI_EXEC_DATA_FLOAT, TGSI_EXEC_DATA_FLOAT);
+      dec->exec = decoded_vector_trinary;
+      dec->op.trinary = micro_cnd;
+      dec->dst_datatype = TGSI_EXEC_DATA_FLOAT;
+      dec->src_datatype = TGSI_EXEC_DATA_FLOAT;
       break;
 
    case TGSI_OPCODE_SQRT:
-      exec_vector_unary(mach, inst, micro_sqrt, TGSI_EXEC_DATA_FLOAT, TGSI_EXEC_DATA_FLOAT);
-      break;
-
-   case TGSI_OPCODE_DP2A:
-      exec_dp2a(mach, inst);
+      dec->exec = decoded_vector_unary;
+      dec->op.unary = micro_sqrt;
+      dec->dst_datatype = TGSI_EXEC_DATA_FLOAT;
+      dec->src_datatype = TGSI_EXEC_DATA_FLOAT;
       break;
 
    case TGSI_OPCODE_FRC:
-      exec_vector_unary(mach, inst, micro_frc, TGSI_EXEC_DATA_FLOAT, TGSI_EXEC_DATA_FLOAT);
+      dec->exec = decoded_vector_unary;
+      dec->op.unary = micro_frc;
+      dec->dst_datatype = TGSI_EXEC_DATA_FLOAT;
+      dec->src_datatype = TGSI_EXEC_DATA_FLOAT;
       break;
 
    case TGSI_OPCODE_CLAMP:
-      exec_vector_trinary(mach, inst, micro_clamp, TGSI_EXEC_DATA_FLOAT, TGSI_EXEC_DATA_FLOAT);
+      dec->exec = decoded_vector_trinary;
+      dec->op.trinary = micro_clamp;
+      dec->dst_datatype = TGSI_EXEC_DATA_FLOAT;
+      dec->src_datatype = TGSI_EXEC_DATA_FLOAT;
       break;
 
    case TGSI_OPCODE_FLR:
-      exec_vector_unary(mach, inst, micro_flr, TGSI_EXEC_DATA_FLOAT, TGSI_EXEC_DATA_FLOAT);
+      dec->exec = decoded_vector_unary;
+      dec->op.unary = micro_flr;
+      dec->dst_datatype = TGSI_EXEC_DATA_FLOAT;
+      dec->src_datatype = TGSI_EXEC_DATA_FLOAT;
       break;
 
    case TGSI_OPCODE_ROUND:
-      exec_vector_unary(mach, inst, micro_rnd, TGSI_EXEC_DATA_FLOAT, TGSI_EXEC_DATA_FLOAT);
+      dec->exec = decoded_vector_unary;
+      dec->op.unary = micro_rnd;
+      dec->dst_datatype = TGSI_EXEC_DATA_FLOAT;
+      dec->src_datatype = TGSI_EXEC_DATA_FLOAT;
       break;
 
    case TGSI_OPCODE_EX2:
-      exec_scalar_unary(mach, inst, micro_exp2, TGSI_EXEC_DATA_FLOAT, TGSI_EXEC_DATA_FLOAT);
+      dec->exec = decoded_scalar_unary;
+      dec->op.unary = micro_exp2;
+      dec->dst_datatype = TGSI_EXEC_DATA_FLOAT;
+      dec->src_datatype = TGSI_EXEC_DATA_FLOAT;
       break;
 
    case TGSI_OPCODE_LG2:
-      exec_scalar_unary(mach, inst, micro_lg2, TGSI_EXEC_DATA_FLOAT, TGSI_EXEC_DATA_FLOAT);
+      dec->exec = decoded_scalar_unary;
+      dec->op.unary = micro_lg2;
+      dec->dst_datatype = TGSI_EXEC_DATA_FLOAT;
+      dec->src_datatype = TGSI_EXEC_DATA_FLOAT;
       break;
 
    case TGSI_OPCODE_POW:
-      exec_scalar_binary(mach, inst, micro_pow, TGSI_EXEC_DATA_FLOAT, TGSI_EXEC_DATA_FLOAT);
-      break;
-
-   case TGSI_OPCODE_XPD:
-      exec_xpd(mach, inst);
+      dec->exec = decoded_scalar_binary;
+      dec->op.binary = micro_pow;
+      dec->dst_datatype = TGSI_EXEC_DATA_FLOAT;
+      dec->src_datatype = TGSI_EXEC_DATA_FLOAT;
       break;
 
    case TGSI_OPCODE_ABS:
-      exec_vector_unary(mach, inst, micro_abs, TGSI_EXEC_DATA_FLOAT, TGSI_EXEC_DATA_FLOAT);
+      dec->exec = decoded_vector_unary;
+      dec->op.unary = micro_abs;
+      dec->dst_datatype = TGSI_EXEC_DATA_FLOAT;
+      dec->src_datatype = TGSI_EXEC_DATA_FLOAT;
       break;
 
    case TGSI_OPCODE_RCC:
-      exec_scalar_unary(mach, inst, micro_rcc, TGSI_EXEC_DATA_FLOAT, TGSI_EXEC_DATA_FLOAT);
-      break;
-
-   case TGSI_OPCODE_DPH:
-      exec_dph(mach, inst);
+      dec->exec = decoded_scalar_unary;
+      dec->op.unary = micro_rcc;
+      dec->dst_datatype = TGSI_EXEC_DATA_FLOAT;
+      dec->src_datatype = TGSI_EXEC_DATA_FLOAT;
       break;
 
    case TGSI_OPCODE_COS:
-      exec_scalar_unary(mach, inst, micro_cos, TGSI_EXEC_DATA_FLOAT, TGSI_EXEC_DATA_FLOAT);
+      dec->exec = decoded_scalar_unary;
+      dec->op.unary = micro_cos;
+      dec->dst_datatype = TGSI_EXEC_DATA_FLOAT;
+      dec->src_datatype = TGSI_EXEC_DATA_FLOAT;
       break;
 
    case TGSI_OPCODE_DDX:
-      exec_vector_unary(mach, inst, micro_ddx, TGSI_EXEC_DATA_FLOAT, TGSI_EXEC_DATA_FLOAT);
+      dec->exec = decoded_vector_unary;
+      dec->op.unary = micro_ddx;
+      dec->dst_datatype = TGSI_EXEC_DATA_FLOAT;
+      dec->src_datatype = TGSI_EXEC_DATA_FLOAT;
       break;
 
    case TGSI_OPCODE_DDY:
-      exec_vector_unary(mach, inst, micro_ddy, TGSI_EXEC_DATA_FLOAT, TGSI_EXEC_DATA_FLOAT);
+      dec->exec = decoded_vector_unary;
+      dec->op.unary = micro_ddy;
+      dec->dst_datatype = TGSI_EXEC_DATA_FLOAT;
+      dec->src_datatype = TGSI_EXEC_DATA_FLOAT;
+      break;
+
+   case TGSI_OPCODE_SEQ:
+      dec->exec = decoded_vector_binary;
+      dec->op.binary = micro_seq;
+      dec->dst_datatype = TGSI_EXEC_DATA_FLOAT;
+      dec->src_datatype = TGSI_EXEC_DATA_FLOAT;
+      break;
+
+   case TGSI_OPCODE_SGT:
+      dec->exec = decoded_vector_binary;
+      dec->op.binary = micro_sgt;
+      dec->dst_datatype = TGSI_EXEC_DATA_FLOAT;
+      dec->src_datatype = TGSI_EXEC_DATA_FLOAT;
+      break;
+
+   case TGSI_OPCODE_SIN:
+      dec->exec = decoded_scalar_unary;
+      dec->op.unary = micro_sin;
+      dec->dst_datatype = TGSI_EXEC_DATA_FLOAT;
+      dec->src_datatype = TGSI_EXEC_DATA_FLOAT;
+      break;
+
+   case TGSI_OPCODE_SLE:
+      dec->exec = decoded_vector_binary;
+      dec->op.binary = micro_sle;
+      dec->dst_datatype = TGSI_EXEC_DATA_FLOAT;
+      dec->src_datatype = TGSI_EXEC_DATA_FLOAT;
+      break;
+
+   case TGSI_OPCODE_SNE:
+      dec->exec = decoded_vector_binary;
+      dec->op.binary = micro_sne;
+      dec->dst_datatype = TGSI_EXEC_DATA_FLOAT;
+      dec->src_datatype = TGSI_EXEC_DATA_FLOAT;
+      break;
+
+   case TGSI_OPCODE_ARR:
+      dec->exec = decoded_vector_unary;
+      dec->op.unary = micro_arr;
+      dec->dst_datatype = TGSI_EXEC_DATA_INT;
+      dec->src_datatype = TGSI_EXEC_DATA_FLOAT;
+      break;
+
+   case TGSI_OPCODE_SSG:
+      dec->exec = decoded_vector_unary;
+      dec->op.unary = micro_sgn;
+      dec->dst_datatype = TGSI_EXEC_DATA_FLOAT;
+      dec->src_datatype = TGSI_EXEC_DATA_FLOAT;
+      break;
+
+   case TGSI_OPCODE_CMP:
+      dec->exec = decoded_vector_trinary;
+      dec->op.trinary = micro_cmp;
+      dec->dst_datatype = TGSI_EXEC_DATA_FLOAT;
+      dec->src_datatype = TGSI_EXEC_DATA_FLOAT;
+      break;
+
+   case TGSI_OPCODE_DIV:
+      dec->exec = decoded_vector_binary;
+      dec->op.binary = micro_div;
+      dec->dst_datatype = TGSI_EXEC_DATA_FLOAT;
+      dec->src_datatype = TGSI_EXEC_DATA_FLOAT;
+      break;
+
+   case TGSI_OPCODE_CEIL:
+      dec->exec = decoded_vector_unary;
+      dec->op.unary = micro_ceil;
+      dec->dst_datatype = TGSI_EXEC_DATA_FLOAT;
+      dec->src_datatype = TGSI_EXEC_DATA_FLOAT;
+      break;
+
+   case TGSI_OPCODE_I2F:
+      dec->exec = decoded_vector_unary;
+      dec->op.unary = micro_i2f;
+      dec->dst_datatype = TGSI_EXEC_DATA_FLOAT;
+      dec->src_datatype = TGSI_EXEC_DATA_INT;
+      break;
+
+   case TGSI_OPCODE_NOT:
+      dec->exec = decoded_vector_unary;
+      dec->op.unary = micro_not;
+      dec->dst_datatype = TGSI_EXEC_DATA_UINT;
+      dec->src_datatype = TGSI_EXEC_DATA_UINT;
+      break;
+
+   case TGSI_OPCODE_TRUNC:
+      dec->exec = decoded_vector_unary;
+      dec->op.unary = micro_trunc;
+      dec->dst_datatype = TGSI_EXEC_DATA_FLOAT;
+      dec->src_datatype = TGSI_EXEC_DATA_FLOAT;
+      break;
+
+   case TGSI_OPCODE_SHL:
+      dec->exec = decoded_vector_binary;
+      dec->op.binary = micro_shl;
+      dec->dst_datatype = TGSI_EXEC_DATA_UINT;
+      dec->src_datatype = TGSI_EXEC_DATA_UINT;
+      break;
+
+   case TGSI_OPCODE_AND:
+      dec->exec = decoded_vector_binary;
+      dec->op.binary = micro_and;
+      dec->dst_datatype = TGSI_EXEC_DATA_UINT;
+      dec->src_datatype = TGSI_EXEC_DATA_UINT;
+      break;
+
+   case TGSI_OPCODE_OR:
+      dec->exec = decoded_vector_binary;
+      dec->op.binary = micro_or;
+      dec->dst_datatype = TGSI_EXEC_DATA_UINT;
+      dec->src_datatype = TGSI_EXEC_DATA_UINT;
+      break;
+
+   case TGSI_OPCODE_MOD:
+      dec->exec = decoded_vector_binary;
+      dec->op.binary = micro_mod;
+      dec->dst_datatype = TGSI_EXEC_DATA_INT;
+      dec->src_datatype = TGSI_EXEC_DATA_INT;
+      break;
+
+   case TGSI_OPCODE_XOR:
+      dec->exec = decoded_vector_binary;
+      dec->op.binary = micro_xor;
+      dec->dst_datatype = TGSI_EXEC_DATA_UINT;
+      dec->src_datatype = TGSI_EXEC_DATA_UINT;
+      break;
+
+   case TGSI_OPCODE_F2I:
+      dec->exec = decoded_vector_unary;
+      dec->op.unary = micro_f2i;
+      dec->dst_datatype = TGSI_EXEC_DATA_INT;
+      dec->src_datatype = TGSI_EXEC_DATA_FLOAT;
+      break;
+
+   case TGSI_OPCODE_IDIV:
+      dec->exec = decoded_vector_binary;
+      dec->op.binary = micro_idiv;
+      dec->dst_datatype = TGSI_EXEC_DATA_INT;
+      dec->src_datatype = TGSI_EXEC_DATA_INT;
+      break;
+
+   case TGSI_OPCODE_IMAX:
+      dec->exec = decoded_vector_binary;
+      dec->op.binary = micro_imax;
+      dec->dst_datatype = TGSI_EXEC_DATA_INT;
+      dec->src_datatype = TGSI_EXEC_DATA_INT;
+      break;
+
+   case TGSI_OPCODE_IMIN:
+      dec->exec = decoded_vector_binary;
+      dec->op.binary = micro_imin;
+      dec->dst_datatype = TGSI_EXEC_DATA_INT;
+      dec->src_datatype = TGSI_EXEC_DATA_INT;
+      break;
+
+   case TGSI_OPCODE_INEG:
+      dec->exec = decoded_vector_unary;
+      dec->op.unary = micro_ineg;
+      dec->dst_datatype = TGSI_EXEC_DATA_INT;
+      dec->src_datatype = TGSI_EXEC_DATA_INT;
+      break;
+
+   case TGSI_OPCODE_ISGE:
+      dec->exec = decoded_vector_binary;
+      dec->op.binary = micro_isge;
+      dec->dst_datatype = TGSI_EXEC_DATA_INT;
+      dec->src_datatype = TGSI_EXEC_DATA_INT;
+      break;
+
+   case TGSI_OPCODE_ISHR:
+      dec->exec = decoded_vector_binary;
+      dec->op.binary = micro_ishr;
+      dec->dst_datatype = TGSI_EXEC_DATA_INT;
+      dec->src_datatype = TGSI_EXEC_DATA_INT;
+      break;
+
+   case TGSI_OPCODE_ISLT:
+      dec->exec = decoded_vector_binary;
+      dec->op.binary = micro_islt;
+      dec->dst_datatype = TGSI_EXEC_DATA_INT;
+      dec->src_datatype = TGSI_EXEC_DATA_INT;
+      break;
+
+   case TGSI_OPCODE_F2U:
+      dec->exec = decoded_vector_unary;
+      dec->op.unary = micro_f2u;
+      dec->dst_datatype = TGSI_EXEC_DATA_UINT;
+      dec->src_datatype = TGSI_EXEC_DATA_FLOAT;
+      break;
+
+   case TGSI_OPCODE_U2F:
+      dec->exec = decoded_vector_unary;
+      dec->op.unary = micro_u2f;
+      dec->dst_datatype = TGSI_EXEC_DATA_FLOAT;
+      dec->src_datatype = TGSI_EXEC_DATA_UINT;
+      break;
+
+   case TGSI_OPCODE_UADD:
+      dec->exec = decoded_vector_binary;
+      dec->op.binary = micro_uadd;
+      dec->dst_datatype = TGSI_EXEC_DATA_INT;
+      dec->src_datatype = TGSI_EXEC_DATA_INT;
+      break;
+
+   case TGSI_OPCODE_UDIV:
+      dec->exec = decoded_vector_binary;
+      dec->op.binary = micro_udiv;
+      dec->dst_datatype = TGSI_EXEC_DATA_UINT;
+      dec->src_datatype = TGSI_EXEC_DATA_UINT;
+      break;
+
+   case TGSI_OPCODE_UMAD:
+      dec->exec = decoded_vector_trinary;
+      dec->op.trinary = micro_umad;
+      dec->dst_datatype = TGSI_EXEC_DATA_UINT;
+      dec->src_datatype = TGSI_EXEC_DATA_UINT;
+      break;
+
+   case TGSI_OPCODE_UMAX:
+      dec->exec = decoded_vector_binary;
+      dec->op.binary = micro_umax;
+      dec->dst_datatype = TGSI_EXEC_DATA_UINT;
+      dec->src_datatype = TGSI_EXEC_DATA_UINT;
+      break;
+
+   case TGSI_OPCODE_UMIN:
+      dec->exec = decoded_vector_binary;
+      dec->op.binary = micro_umin;
+      dec->dst_datatype = TGSI_EXEC_DATA_UINT;
+      dec->src_datatype = TGSI_EXEC_DATA_UINT;
+      break;
+
+   case TGSI_OPCODE_UMOD:
+      dec->exec = decoded_vector_binary;
+      dec->op.binary = micro_umod;
+      dec->dst_datatype = TGSI_EXEC_DATA_UINT;
+      dec->src_datatype = TGSI_EXEC_DATA_UINT;
+      break;
+
+   case TGSI_OPCODE_UMUL:
+      dec->exec = decoded_vector_binary;
+      dec->op.binary = micro_umul;
+      dec->dst_datatype = TGSI_EXEC_DATA_UINT;
+      dec->src_datatype = TGSI_EXEC_DATA_UINT;
+      break;
+
+   case TGSI_OPCODE_USEQ:
+      dec->exec = decoded_vector_binary;
+      dec->op.binary = micro_useq;
+      dec->dst_datatype = TGSI_EXEC_DATA_UINT;
+      dec->src_datatype = TGSI_EXEC_DATA_UINT;
+      break;
+
+   case TGSI_OPCODE_USGE:
+      dec->exec = decoded_vector_binary;
+      dec->op.binary = micro_usge;
+      dec->dst_datatype = TGSI_EXEC_DATA_UINT;
+      dec->src_datatype = TGSI_EXEC_DATA_UINT;
+      break;
+
+   case TGSI_OPCODE_USHR:
+      dec->exec = decoded_vector_binary;
+      dec->op.binary = micro_ushr;
+      dec->dst_datatype = TGSI_EXEC_DATA_UINT;
+      dec->src_datatype = TGSI_EXEC_DATA_UINT;
+      break;
+
+   case TGSI_OPCODE_USLT:
+      dec->exec = decoded_vector_binary;
+      dec->op.binary = micro_uslt;
+      dec->dst_datatype = TGSI_EXEC_DATA_UINT;
+      dec->src_datatype = TGSI_EXEC_DATA_UINT;
+      break;
+
+   case TGSI_OPCODE_USNE:
+      dec->exec = decoded_vector_binary;
+      dec->op.binary = micro_usne;
+      dec->dst_datatype = TGSI_EXEC_DATA_UINT;
+      dec->src_datatype = TGSI_EXEC_DATA_UINT;
+      break;
+
+   case TGSI_OPCODE_UARL:
+      dec->exec = decoded_vector_unary;
+      dec->op.unary = micro_uarl;
+      dec->dst_datatype = TGSI_EXEC_DATA_INT;
+      dec->src_datatype = TGSI_EXEC_DATA_UINT;
+      break;
+
+   case TGSI_OPCODE_UCMP:
+      dec->exec = decoded_vector_trinary;
+      dec->op.trinary = micro_ucmp;
+      dec->dst_datatype = TGSI_EXEC_DATA_UINT;
+      dec->src_datatype = TGSI_EXEC_DATA_UINT;
+      break;
+
+   case TGSI_OPCODE_IABS:
+      dec->exec = decoded_vector_unary;
+      dec->op.unary = micro_iabs;
+      dec->dst_datatype = TGSI_EXEC_DATA_INT;
+      dec->src_datatype = TGSI_EXEC_DATA_INT;
+      break;
+
+   case TGSI_OPCODE_ISSG:
+      dec->exec = decoded_vector_unary;
+      dec->op.unary = micro_isgn;
+      dec->dst_datatype = TGSI_EXEC_DATA_INT;
+      dec->src_datatype = TGSI_EXEC_DATA_INT;
+      break;
+
+   default:
+      /* handled by exec_instruction() */
+      dec->exec = NULL;
+      break;
+   }
+}
+
+static struct tgsi_exec_decoded_instruction *
+decode_instructions(const struct tgsi_full_instruction *instructions,
+                    uint count)
+{
+   struct tgsi_exec_decoded_instruction *decoded;
+   uint i;
+
+   decoded = (struct tgsi_exec_decoded_instruction *)
+      MALLOC( MAX2(count, 1) * sizeof(struct tgsi_exec_decoded_instruction) );
+   if (!decoded) {
+      return NULL;
+   }
+
+   for (i = 0; i < count; i++) {
+      decode_instruction(&instructions[i], &decoded[i]);
+   }
+
+   return decoded;
+}
+
+static void
+exec_instruction(
+   struct tgsi_exec_machine *mach,
+   const struct tgsi_full_instruction *inst,
+   int *pc )
+{
+   union tgsi_exec_channel r[10];
+
+   (*pc)++;
+
+   switch (inst->Instruction.Opcode) {
+   case TGSI_OPCODE_LIT:
+      exec_lit(mach, inst);
+      break;
+
+   case TGSI_OPCODE_EXP:
+      exec_exp(mach, inst);
+      break;
+
+   case TGSI_OPCODE_LOG:
+      exec_log(mach, inst);
+      break;
+
+   case TGSI_OPCODE_DP3:
+      exec_dp3(mach, inst);
+      break;
+
+   case TGSI_OPCODE_DP4:
+      exec_dp4(mach, inst);
+      break;
+
+   case TGSI_OPCODE_DST:
+      exec_dst(mach, inst);
+      break;
+
+   case TGSI_OPCODE_DP2A:
+      exec_dp2a(mach, inst);
+      break;
+
+   case TGSI_OPCODE_XPD:
+      exec_xpd(mach, inst);
+      break;
+
+   case TGSI_OPCODE_DPH:
+      exec_dph(mach, inst);
       break;
 
    case TGSI_OPCODE_KILP:
@@ -3653,30 +4223,10 @@ exec_instruction(
       exec_rfl(mach, inst);
       break;
 
-   case TGSI_OPCODE_SEQ:
-      exec_vector_binary(mach, inst, micro_seq, TGSI_EXEC_DATA_FLOAT, TGSI_EXEC_DATA_FLOAT);
-      break;
-
    case TGSI_OPCODE_SFL:
       exec_vector(mach, inst, micro_sfl, TGSI_EXEC_DATA_FLOAT);
       break;
 
-   case TGSI_OPCODE_SGT:
-      exec_vector_binary(mach, inst, micro_sgt, TGSI_EXEC_DATA_FLOAT, TGSI_EXEC_DATA_FLOAT);
-      break;
-
-   case TGSI_OPCODE_SIN:
-      exec_scalar_unary(mach, inst, micro_sin, TGSI_EXEC_DATA_FLOAT, TGSI_EXEC_DATA_FLOAT);
-      break;
-
-   case TGSI_OPCODE_SLE:
-      exec_vector_binary(mach, inst, micro_sle, TGSI_EXEC_DATA_FLOAT, TGSI_EXEC_DATA_FLOAT);
-      break;
-
-   case TGSI_OPCODE_SNE:
-      exec_vector_binary(mach, inst, micro_sne, TGSI_EXEC_DATA_FLOAT, TGSI_EXEC_DATA_FLOAT);
-      break;
-
    case TGSI_OPCODE_STR:
       exec_vector(mach, inst, micro_str, TGSI_EXEC_DATA_FLOAT);
       break;
@@ -3742,10 +4292,6 @@ exec_instruction(
       assert (0);
       break;
 
-   case TGSI_OPCODE_ARR:
-      exec_vector_unary(mach, inst, micro_arr, TGSI_EXEC_DATA_INT, TGSI_EXEC_DATA_FLOAT);
-      break;
-
    case TGSI_OPCODE_BRA:
       assert (0);
       break;
@@ -3834,14 +4380,6 @@ exec_instruction(
       }
       break;
 
-   case TGSI_OPCODE_SSG:
-      exec_vector_unary(mach, inst, micro_sgn, TGSI_EXEC_DATA_FLOAT, TGSI_EXEC_DATA_FLOAT);
-      break;
-
-   case TGSI_OPCODE_CMP:
-      exec_vector_trinary(mach, inst, micro_cmp, TGSI_EXEC_DATA_FLOAT, TGSI_EXEC_DATA_FLOAT);
-      break;
-
    case TGSI_OPCODE_SCS:
       exec_scs(mach, inst);
       break;
@@ -3854,10 +4392,6 @@ exec_instruction(
       exec_nrm4(mach, inst);
       break;
 
-   case TGSI_OPCODE_DIV:
-      exec_vector_binary(mach, inst, micro_div, TGSI_EXEC_DATA_FLOAT, TGSI_EXEC_DATA_FLOAT);
-      break;
-
    case TGSI_OPCODE_DP2:
       exec_dp2(mach, inst);
       break;
@@ -3941,42 +4475,6 @@ exec_instruction(
       assert (0);
       break;
 
-   case TGSI_OPCODE_CEIL:
-      exec_vector_unary(mach, inst, micro_ceil, TGSI_EXEC_DATA_FLOAT, TGSI_EXEC_DATA_FLOAT);
-      break;
-
-   case TGSI_OPCODE_I2F:
-      exec_vector_unary(mach, inst, micro_i2f, TGSI_EXEC_DATA_FLOAT, TGSI_EXEC_DATA_INT);
-      break;
-
-   case TGSI_OPCODE_NOT:
-      exec_vector_unary(mach, inst, micro_not, TGSI_EXEC_DATA_UINT, TGSI_EXEC_DATA_UINT);
-      break;
-
-   case TGSI_OPCODE_TRUNC:
-      exec_vector_unary(mach, inst, micro_trunc, TGSI_EXEC_DATA_FLOAT, TGSI_EXEC_DATA_FLOAT);
-      break;
-
-   case TGSI_OPCODE_SHL:
-      exec_vector_binary(mach, inst, micro_shl, TGSI_EXEC_DATA_UINT, TGSI_EXEC_DATA_UINT);
-      break;
-
-   case TGSI_OPCODE_AND:
-      exec_vector_binary(mach, inst, micro_and, TGSI_EXEC_DATA_UINT, TGSI_EXEC_DATA_UINT);
-      break;
-
-   case TGSI_OPCODE_OR:
-      exec_vector_binary(mach, inst, micro_or, TGSI_EXEC_DATA_UINT, TGSI_EXEC_DATA_UINT);
-      break;
-
-   case TGSI_OPCODE_MOD:
-      exec_vector_binary(mach, inst, micro_mod, TGSI_EXEC_DATA_INT, TGSI_EXEC_DATA_INT);
-      break;
-
-   case TGSI_OPCODE_XOR:
-      exec_vector_binary(mach, inst, micro_xor, TGSI_EXEC_DATA_UINT, TGSI_EXEC_DATA_UINT);
-      break;
-
    case TGSI_OPCODE_SAD:
       assert (0);
       break;
@@ -4104,94 +4602,6 @@ exec_instruction(
       UPDATE_EXEC_MASK(mach);
       break;
 
-   case TGSI_OPCODE_F2I:
-      exec_vector_unary(mach, inst, micro_f2i, TGSI_EXEC_DATA_INT, TGSI_EXEC_DATA_FLOAT);
-      break;
-
-   case TGSI_OPCODE_IDIV:
-      exec_vector_binary(mach, inst, micro_idiv, TGSI_EXEC_DATA_INT, TGSI_EXEC_DATA_INT);
-      break;
-
-   case TGSI_OPCODE_IMAX:
-      exec_vector_binary(mach, inst, micro_imax, TGSI_EXEC_DATA_INT, TGSI_EXEC_DATA_INT);
-      break;
-
-   case TGSI_OPCODE_IMIN:
-      exec_vector_binary(mach, inst, micro_imin, TGSI_EXEC_DATA_INT, TGSI_EXEC_DATA_INT);
-      break;
-
-   case TGSI_OPCODE_INEG:
-      exec_vector_unary(mach, inst, micro_ineg, TGSI_EXEC_DATA_INT, TGSI_EXEC_DATA_INT);
-      break;
-
-   case TGSI_OPCODE_ISGE:
-      exec_vector_binary(mach, inst, micro_isge, TGSI_EXEC_DATA_INT, TGSI_EXEC_DATA_INT);
-      break;
-
-   case TGSI_OPCODE_ISHR:
-      exec_vector_binary(mach, inst, micro_ishr, TGSI_EXEC_DATA_INT, TGSI_EXEC_DATA_INT);
-      break;
-
-   case TGSI_OPCODE_ISLT:
-      exec_vector_binary(mach, inst, micro_islt, TGSI_EXEC_DATA_INT, TGSI_EXEC_DATA_INT);
-      break;
-
-   case TGSI_OPCODE_F2U:
-      exec_vector_unary(mach, inst, micro_f2u, TGSI_EXEC_DATA_UINT, TGSI_EXEC_DATA_FLOAT);
-      break;
-
-   case TGSI_OPCODE_U2F:
-      exec_vector_unary(mach, inst, micro_u2f, TGSI_EXEC_DATA_FLOAT, TGSI_EXEC_DATA_UINT);
-      break;
-
-   case TGSI_OPCODE_UADD:
-      exec_vector_binary(mach, inst, micro_uadd, TGSI_EXEC_DATA_INT, TGSI_EXEC_DATA_INT);
-      break;
-
-   case TGSI_OPCODE_UDIV:
-      exec_vector_binary(mach, inst, micro_udiv, TGSI_EXEC_DATA_UINT, TGSI_EXEC_DATA_UINT);
-      break;
-
-   case TGSI_OPCODE_UMAD:
-      exec_vector_trinary(mach, inst, micro_umad, TGSI_EXEC_DATA_UINT, TGSI_EXEC_DATA_UINT);
-      break;
-
-   case TGSI_OPCODE_UMAX:
-      exec_vector_binary(mach, inst, micro_umax, TGSI_EXEC_DATA_UINT, TGSI_EXEC_DATA_UINT);
-      break;
-
-   case TGSI_OPCODE_UMIN:
-      exec_vector_binary(mach, inst, micro_umin, TGSI_EXEC_DATA_UINT, TGSI_EXEC_DATA_UINT);
-      break;
-
-   case TGSI_OPCODE_UMOD:
-      exec_vector_binary(mach, inst, micro_umod, TGSI_EXEC_DATA_UINT, TGSI_EXEC_DATA_UINT);
-      break;
-
-   case TGSI_OPCODE_UMUL:
-      exec_vector_binary(mach, inst, micro_umul, TGSI_EXEC_DATA_UINT, TGSI_EXEC_DATA_UINT);
-      break;
-
-   case TGSI_OPCODE_USEQ:
-      exec_vector_binary(mach, inst, micro_useq, TGSI_EXEC_DATA_UINT, TGSI_EXEC_DATA_UINT);
-      break;
-
-   case TGSI_OPCODE_USGE:
-      exec_vector_binary(mach, inst, micro_usge, TGSI_EXEC_DATA_UINT, TGSI_EXEC_DATA_UINT);
-      break;
-
-   case TGSI_OPCODE_USHR:
-      exec_vector_binary(mach, inst, micro_ushr, TGSI_EXEC_DATA_UINT, TGSI_EXEC_DATA_UINT);
-      break;
-
-   case TGSI_OPCODE_USLT:
-      exec_vector_binary(mach, inst, micro_uslt, TGSI_EXEC_DATA_UINT, TGSI_EXEC_DATA_UINT);
-      break;
-
-   case TGSI_OPCODE_USNE:
-      exec_vector_binary(mach, inst, micro_usne, TGSI_EXEC_DATA_UINT, TGSI_EXEC_DATA_UINT);
-      break;
-
    case TGSI_OPCODE_SWITCH:
       exec_switch(mach, inst);
       break;
@@ -4256,22 +4666,6 @@ exec_instruction(
       assert(0);
       break;
 
-   case TGSI_OPCODE_UARL:
-      exec_vector_unary(mach, inst, micro_uarl, TGSI_EXEC_DATA_INT, TGSI_EXEC_DATA_UINT);
-      break;
-
-   case TGSI_OPCODE_UCMP:
-      exec_vector_trinary(mach, inst, micro_ucmp, TGSI_EXEC_DATA_UINT, TGSI_EXEC_DATA_UINT);
-      break;
-
-   case TGSI_OPCODE_IABS:
-      exec_vector_unary(mach, inst, micro_iabs, TGSI_EXEC_DATA_INT, TGSI_EXEC_DATA_INT);
-      break;
-
-   case TGSI_OPCODE_ISSG:
-      exec_vector_unary(mach, inst, micro_isgn, TGSI_EXEC_DATA_INT, TGSI_EXEC_DATA_INT);
-      break;
-
    case TGSI_OPCODE_TEX2:
       /* simple texture lookup */
       /* src[0] = texcoord */
@@ -4300,14 +4694,14 @@ exec_instruction(
 
 
 /**
- * Run TGSI interpreter.
- * \return bitmask of "alive" quad components
+ * Reset the execution state and evaluate the declarations (interpolants):
+ * everything tgsi_exec_machine_run() does before the first instruction.
+ * For code which runs the instructions itself, see tgsi_sse2.h.
  */
-uint
-tgsi_exec_machine_run( struct tgsi_exec_machine *mach )
+void
+tgsi_exec_machine_begin_run( struct tgsi_exec_machine *mach )
 {
    uint i;
-   int pc = 0;
    uint default_mask = 0xf;
 
    mach->Temps[TEMP_KILMASK_I].xyzw[TEMP_KILMASK_C].u[0] = 0;
@@ -4340,6 +4734,39 @@ tgsi_exec_machine_run( struct tgsi_exec_machine *mach )
    for (i = 0; i < mach->NumDeclarations; i++) {
       exec_declaration( mach, mach->Declarations+i );
    }
+}
+
+
+/**
+ * Run the instruction at pc, which must not be a flow control one.
+ */
+void
+tgsi_exec_machine_run_instruction( struct tgsi_exec_machine *mach, uint pc )
+{
+   int next_pc = pc;
+
+   assert(pc < mach->NumInstructions);
+   if (mach->Decoded[pc].exec) {
+      mach->Decoded[pc].exec(mach, mach->Instructions + pc,
+                             mach->Decoded + pc);
+   }
+   else {
+      exec_instruction(mach, mach->Instructions + pc, &next_pc);
+      assert(next_pc == (int) pc + 1);
+   }
+}
+
+
+/**
+ * Run TGSI interpreter.
+ * \return bitmask of "alive" quad components
+ */
+uint
+tgsi_exec_machine_run( struct tgsi_exec_machine *mach )
+{
+   int pc = 0;
+
+   tgsi_exec_machine_begin_run(mach);
 
    {
 #if DEBUG_EXECUTION
@@ -4363,7 +4790,14 @@ tgsi_exec_machine_run( struct tgsi_exec_machine *mach )
 #endif
 
          assert(pc < (int) mach->NumInstructions);
-         exec_instruction(mach, mach->Instructions + pc, &pc);
+         if (mach->Decoded[pc].exec) {
+            mach->Decoded[pc].exec(mach, mach->Instructions + pc,
+                                   mach->Decoded + pc);
+            pc++;
+         }
+         else {
+            exec_instruction(mach, mach->Instructions + pc, &pc);
+         }
 
 #if DEBUG_EXECUTION
          for (i = 0; i < TGSI_EXEC_NUM_TEMPS + TGSI_EXEC_NUM_TEMP_EXTRAS; i++) {
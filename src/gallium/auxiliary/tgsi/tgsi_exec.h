@@ -348,6 +348,7 @@ struct tgsi_exec_machine
    int CallStackTop;
 
    struct tgsi_full_instruction *Instructions;
+   struct tgsi_exec_decoded_instruction *Decoded; /**< one per instruction */
    uint NumInstructions;
 
    struct tgsi_full_declaration *Declarations;
@@ -376,6 +377,15 @@ uint
 tgsi_exec_machine_run(
    struct tgsi_exec_machine *mach );
 
+void
+tgsi_exec_machine_begin_run(
+   struct tgsi_exec_machine *mach );
+
+void
+tgsi_exec_machine_run_instruction(
+   struct tgsi_exec_machine *mach,
+   uint pc );
+
 
 void
 tgsi_exec_machine_free_data(struct tgsi_exec_machine *mach);
@@ -0,0 +1,809 @@
+/**************************************************************************
+ *
+ * Copyright 2013 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/**
+ * TGSI to x86-64 SSE2 translation.  See tgsi_sse2.h.
+ *
+ * Registers live where the interpreter keeps them, in the machine, and
+ * every instruction loads its operands from and stores its results to
+ * there, a channel (four pixels) at a time.  The operations match the
+ * micro_*() functions of tgsi_exec.c bit for bit (short of which NaN comes
+ * out of an operation on two NaNs), so switching between the generated code
+ * and the interpreter at any instruction is invisible.
+ *
+ * Register usage:
+ *    rbx    - the tgsi_exec_machine
+ *    rbp    - the interpreter callback
+ *    rsi    - mach->Inputs
+ *    rdi    - mach->Outputs
+ *    rax    - constant buffer pointer
+ *    xmm0-2 - source operands
+ *    xmm3   - result
+ *    xmm4-5 - temporaries
+ *
+ * xmm6 and up are callee-saved on Win64, so they are left alone.
+ */
+
+#include "pipe/p_config.h"
+
+#if defined(PIPE_ARCH_X86_64)
+
+#include "pipe/p_compiler.h"
+#include "pipe/p_shader_tokens.h"
+#include "util/u_debug.h"
+#include "util/u_memory.h"
+#include "tgsi/tgsi_parse.h"
+#include "tgsi/tgsi_util.h"
+#include "rtasm/rtasm_x86sse.h"
+#include "tgsi_exec.h"
+#include "tgsi_sse2.h"
+
+
+#define CHAN_SIZE   sizeof(union tgsi_exec_channel)
+#define VEC_SIZE    sizeof(struct tgsi_exec_vector)
+
+#define TEMP_OFFSET(index, chan) \
+   (offsetof(struct tgsi_exec_machine, Temps) + (index) * VEC_SIZE + \
+    (chan) * CHAN_SIZE)
+
+
+struct sse2_compiler
+{
+   struct x86_function *func;
+
+   struct x86_reg machine;
+   struct x86_reg exec;
+   struct x86_reg inputs;
+   struct x86_reg outputs;
+   struct x86_reg tmp;
+
+   /** Stack space for results overwriting one of their own operands */
+   struct x86_reg scratch;
+   unsigned frame_size;
+
+   /** Do inputs/outputs hold the pointers (not clobbered by a call)? */
+   boolean pointers_loaded;
+};
+
+
+static struct x86_reg
+make_xmm(int xmm)
+{
+   return x86_make_reg(file_XMM, (enum x86_reg_name) xmm);
+}
+
+
+static boolean
+is_flow_control(unsigned opcode)
+{
+   switch (opcode) {
+   case TGSI_OPCODE_CAL:
+   case TGSI_OPCODE_RET:
+   case TGSI_OPCODE_IF:
+   case TGSI_OPCODE_UIF:
+   case TGSI_OPCODE_ELSE:
+   case TGSI_OPCODE_ENDIF:
+   case TGSI_OPCODE_BGNLOOP:
+   case TGSI_OPCODE_ENDLOOP:
+   case TGSI_OPCODE_BRK:
+   case TGSI_OPCODE_BREAKC:
+   case TGSI_OPCODE_CONT:
+   case TGSI_OPCODE_BGNSUB:
+   case TGSI_OPCODE_ENDSUB:
+   case TGSI_OPCODE_SWITCH:
+   case TGSI_OPCODE_CASE:
+   case TGSI_OPCODE_DEFAULT:
+   case TGSI_OPCODE_ENDSWITCH:
+   case TGSI_OPCODE_EMIT:
+   case TGSI_OPCODE_ENDPRIM:
+      return TRUE;
+   default:
+      return FALSE;
+   }
+}
+
+
+/**
+ * Can the source be read without the interpreter's help?
+ */
+static boolean
+is_native_src(const struct tgsi_full_src_register *reg)
+{
+   const int index = reg->Register.Index;
+
+   if (reg->Register.Indirect || index < 0)
+      return FALSE;
+
+   switch (reg->Register.File) {
+   case TGSI_FILE_CONSTANT:
+      return !reg->Register.Dimension ||
+             (!reg->Dimension.Indirect &&
+              reg->Dimension.Index < PIPE_MAX_CONSTANT_BUFFERS);
+   case TGSI_FILE_TEMPORARY:
+      return !reg->Register.Dimension && index < TGSI_EXEC_NUM_TEMPS;
+   case TGSI_FILE_IMMEDIATE:
+      return !reg->Register.Dimension && index < TGSI_EXEC_NUM_IMMEDIATES;
+   case TGSI_FILE_INPUT:
+   case TGSI_FILE_OUTPUT:
+      return !reg->Register.Dimension && index < PIPE_MAX_ATTRIBS;
+   default:
+      return FALSE;
+   }
+}
+
+
+static boolean
+is_native_dst(const struct tgsi_full_dst_register *reg)
+{
+   const int index = reg->Register.Index;
+
+   if (reg->Register.Indirect || reg->Register.Dimension || index < 0)
+      return FALSE;
+
+   switch (reg->Register.File) {
+   case TGSI_FILE_TEMPORARY:
+      return index < TGSI_EXEC_NUM_TEMPS;
+   case TGSI_FILE_OUTPUT:
+      return index < PIPE_MAX_ATTRIBS;
+   default:
+      return FALSE;
+   }
+}
+
+
+static boolean
+is_native_opcode(unsigned opcode)
+{
+   switch (opcode) {
+   case TGSI_OPCODE_MOV:
+   case TGSI_OPCODE_ABS:
+   case TGSI_OPCODE_ADD:
+   case TGSI_OPCODE_SUB:
+   case TGSI_OPCODE_MUL:
+   case TGSI_OPCODE_MIN:
+   case TGSI_OPCODE_MAX:
+   case TGSI_OPCODE_SLT:
+   case TGSI_OPCODE_SGE:
+   case TGSI_OPCODE_SEQ:
+   case TGSI_OPCODE_SNE:
+   case TGSI_OPCODE_SGT:
+   case TGSI_OPCODE_SLE:
+   case TGSI_OPCODE_MAD:
+   case TGSI_OPCODE_LRP:
+   case TGSI_OPCODE_CMP:
+   case TGSI_OPCODE_RCP:
+   case TGSI_OPCODE_RSQ:
+   case TGSI_OPCODE_SQRT:
+   case TGSI_OPCODE_DP2:
+   case TGSI_OPCODE_DP3:
+   case TGSI_OPCODE_DP4:
+   case TGSI_OPCODE_DPH:
+      return TRUE;
+   default:
+      return FALSE;
+   }
+}
+
+
+static boolean
+is_native(const struct tgsi_full_instruction *inst)
+{
+   uint i;
+
+   if (inst->Instruction.Opcode == TGSI_OPCODE_NOP)
+      return TRUE;
+
+   if (!is_native_opcode(inst->Instruction.Opcode) ||
+       inst->Instruction.Predicate ||
+       inst->Instruction.Saturate == TGSI_SAT_MINUS_PLUS_ONE ||
+       inst->Instruction.NumDstRegs != 1 ||
+       !is_native_dst(&inst->Dst[0]))
+      return FALSE;
+
+   for (i = 0; i < inst->Instruction.NumSrcRegs; i++) {
+      if (!is_native_src(&inst->Src[i]))
+         return FALSE;
+   }
+
+   return TRUE;
+}
+
+
+/**
+ * Does writing the destination change one of the sources?
+ */
+static boolean
+dst_aliases_src(const struct tgsi_full_instruction *inst)
+{
+   const struct tgsi_full_dst_register *dst = &inst->Dst[0];
+   uint i;
+
+   for (i = 0; i < inst->Instruction.NumSrcRegs; i++) {
+      if (inst->Src[i].Register.File == dst->Register.File &&
+          inst->Src[i].Register.Index == dst->Register.Index)
+         return TRUE;
+   }
+   return FALSE;
+}
+
+
+static void
+load_pointers(struct sse2_compiler *c)
+{
+   if (!c->pointers_loaded) {
+      x64_mov64(c->func, c->inputs,
+                x86_make_disp(c->machine,
+                              offsetof(struct tgsi_exec_machine, Inputs)));
+      x64_mov64(c->func, c->outputs,
+                x86_make_disp(c->machine,
+                              offsetof(struct tgsi_exec_machine, Outputs)));
+      c->pointers_loaded = TRUE;
+   }
+}
+
+
+/**
+ * Memory operand of a channel of a temporary, input or output register.
+ */
+static struct x86_reg
+get_chan(struct sse2_compiler *c, unsigned file, int index, unsigned chan)
+{
+   switch (file) {
+   case TGSI_FILE_TEMPORARY:
+      return x86_make_disp(c->machine, TEMP_OFFSET(index, chan));
+   case TGSI_FILE_INPUT:
+      return x86_make_disp(c->inputs, index * VEC_SIZE + chan * CHAN_SIZE);
+   case TGSI_FILE_OUTPUT:
+      return x86_make_disp(c->outputs, index * VEC_SIZE + chan * CHAN_SIZE);
+   default:
+      assert(0);
+      return c->machine;
+   }
+}
+
+
+/**
+ * Load one of the interpreter's constant channels, like the abs/sign masks.
+ */
+static void
+load_machine_const(struct sse2_compiler *c, struct x86_reg dst,
+                   int index, unsigned chan)
+{
+   sse_movups(c->func, dst, x86_make_disp(c->machine, TEMP_OFFSET(index, chan)));
+}
+
+
+/**
+ * Broadcast the float at mem to the four lanes of dst.
+ */
+static void
+emit_broadcast(struct sse2_compiler *c, struct x86_reg dst, struct x86_reg mem)
+{
+   sse_movss(c->func, dst, mem);
+   sse_shufps(c->func, dst, dst, SHUF(0, 0, 0, 0));
+}
+
+
+/**
+ * Fetch channel chan of source src into dst, like fetch_source() does for
+ * TGSI_EXEC_DATA_FLOAT.
+ */
+static void
+emit_fetch(struct sse2_compiler *c, struct x86_reg dst,
+           const struct tgsi_full_instruction *inst, uint src, uint chan)
+{
+   const struct tgsi_full_src_register *reg = &inst->Src[src];
+   const unsigned swizzle = tgsi_util_get_full_src_register_swizzle(reg, chan);
+   const int index = reg->Register.Index;
+   struct x86_reg mask = make_xmm(5);
+
+   switch (reg->Register.File) {
+   case TGSI_FILE_TEMPORARY:
+   case TGSI_FILE_INPUT:
+   case TGSI_FILE_OUTPUT:
+      sse_movups(c->func, dst, get_chan(c, reg->Register.File, index, swizzle));
+      break;
+
+   case TGSI_FILE_IMMEDIATE:
+      emit_broadcast(c, dst,
+                     x86_make_disp(c->machine,
+                                   offsetof(struct tgsi_exec_machine, Imms) +
+                                   (index * 4 + swizzle) * sizeof(float)));
+      break;
+
+   case TGSI_FILE_CONSTANT:
+      {
+         const unsigned buf =
+            reg->Register.Dimension ? reg->Dimension.Index : 0;
+         const int pos = index * 4 + swizzle;
+         int skip;
+
+         /* out of bounds reads give zero */
+         sse_xorps(c->func, dst, dst);
+         x86_cmp_imm(c->func,
+                     x86_make_disp(c->machine,
+                                   offsetof(struct tgsi_exec_machine,
+                                            ConstsSize[buf])),
+                     pos + 1);
+         skip = x86_jcc_forward(c->func, cc_NAE);
+         x64_mov64(c->func, c->tmp,
+                   x86_make_disp(c->machine,
+                                 offsetof(struct tgsi_exec_machine,
+                                          Consts[buf])));
+         emit_broadcast(c, dst, x86_make_disp(c->tmp, pos * sizeof(float)));
+         x86_fixup_fwd_jump(c->func, skip);
+      }
+      break;
+
+   default:
+      assert(0);
+      break;
+   }
+
+   if (reg->Register.Absolute) {
+      load_machine_const(c, mask, TGSI_EXEC_TEMP_7FFFFFFF_I,
+                         TGSI_EXEC_TEMP_7FFFFFFF_C);
+      sse_andps(c->func, dst, mask);
+   }
+   if (reg->Register.Negate) {
+      load_machine_const(c, mask, TGSI_EXEC_TEMP_80000000_I,
+                         TGSI_EXEC_TEMP_80000000_C);
+      sse_xorps(c->func, dst, mask);
+   }
+}
+
+
+/**
+ * Saturate src like store_dest() does.
+ * \return the register holding the value to store
+ */
+static struct x86_reg
+emit_saturate(struct sse2_compiler *c, struct x86_reg src,
+              const struct tgsi_full_instruction *inst)
+{
+   if (inst->Instruction.Saturate == TGSI_SAT_ZERO_ONE) {
+      struct x86_reg tmp = make_xmm(4);
+      struct x86_reg one = make_xmm(5);
+
+      /* x < 0 ? 0 : x, then x > 1 ? 1 : x, keeping NaNs */
+      sse_xorps(c->func, tmp, tmp);
+      sse_maxps(c->func, tmp, src);
+      load_machine_const(c, one, TGSI_EXEC_TEMP_ONE_I, TGSI_EXEC_TEMP_ONE_C);
+      sse_minps(c->func, one, tmp);
+      return one;
+   }
+   return src;
+}
+
+
+/**
+ * Store the result of a scalar operation to all the written channels.
+ */
+static void
+emit_store_scalar(struct sse2_compiler *c, struct x86_reg src,
+                  const struct tgsi_full_instruction *inst)
+{
+   const struct tgsi_full_dst_register *dst = &inst->Dst[0];
+   uint chan;
+
+   src = emit_saturate(c, src, inst);
+
+   for (chan = 0; chan < TGSI_NUM_CHANNELS; chan++) {
+      if (dst->Register.WriteMask & (1 << chan))
+         sse_movups(c->func,
+                    get_chan(c, dst->Register.File, dst->Register.Index, chan),
+                    src);
+   }
+}
+
+
+/**
+ * Compute channel chan of a vector operation into xmm3.
+ */
+static void
+emit_vector_op(struct sse2_compiler *c,
+               const struct tgsi_full_instruction *inst, uint chan)
+{
+   struct x86_function *func = c->func;
+   struct x86_reg src0 = make_xmm(0);
+   struct x86_reg src1 = make_xmm(1);
+   struct x86_reg src2 = make_xmm(2);
+   struct x86_reg dst = make_xmm(3);
+   struct x86_reg tmp = make_xmm(4);
+   uint i;
+
+   for (i = 0; i < inst->Instruction.NumSrcRegs; i++)
+      emit_fetch(c, make_xmm(i), inst, i, chan);
+
+   switch (inst->Instruction.Opcode) {
+   case TGSI_OPCODE_MOV:
+      sse_movaps(func, dst, src0);
+      break;
+   case TGSI_OPCODE_ABS:
+      load_machine_const(c, tmp, TGSI_EXEC_TEMP_7FFFFFFF_I,
+                         TGSI_EXEC_TEMP_7FFFFFFF_C);
+      sse_movaps(func, dst, src0);
+      sse_andps(func, dst, tmp);
+      break;
+   case TGSI_OPCODE_SQRT:
+      load_machine_const(c, tmp, TGSI_EXEC_TEMP_7FFFFFFF_I,
+                         TGSI_EXEC_TEMP_7FFFFFFF_C);
+      sse_andps(func, src0, tmp);
+      sse_sqrtps(func, dst, src0);
+      break;
+   case TGSI_OPCODE_ADD:
+      sse_movaps(func, dst, src0);
+      sse_addps(func, dst, src1);
+      break;
+   case TGSI_OPCODE_SUB:
+      sse_movaps(func, dst, src0);
+      sse_subps(func, dst, src1);
+      break;
+   case TGSI_OPCODE_MUL:
+      sse_movaps(func, dst, src0);
+      sse_mulps(func, dst, src1);
+      break;
+   case TGSI_OPCODE_MIN:
+      sse_movaps(func, dst, src0);
+      sse_minps(func, dst, src1);
+      break;
+   case TGSI_OPCODE_MAX:
+      sse_movaps(func, dst, src0);
+      sse_maxps(func, dst, src1);
+      break;
+   case TGSI_OPCODE_SLT:
+   case TGSI_OPCODE_SGE:
+   case TGSI_OPCODE_SEQ:
+   case TGSI_OPCODE_SNE:
+   case TGSI_OPCODE_SGT:
+   case TGSI_OPCODE_SLE:
+      {
+         /* a >= b and a > b are b <= a and b < a, which are false for NaNs */
+         boolean swap = FALSE;
+         enum sse_cc cc;
+
+         switch (inst->Instruction.Opcode) {
+         case TGSI_OPCODE_SLT:
+            cc = cc_LessThan;
+            break;
+         case TGSI_OPCODE_SGE:
+            cc = cc_LessThanEqual;
+            swap = TRUE;
+            break;
+         case TGSI_OPCODE_SEQ:
+            cc = cc_Equal;
+            break;
+         case TGSI_OPCODE_SNE:
+            cc = cc_NotEqual;
+            break;
+         case TGSI_OPCODE_SGT:
+            cc = cc_LessThan;
+            swap = TRUE;
+            break;
+         default:
+            cc = cc_LessThanEqual;
+            break;
+         }
+
+         sse_movaps(func, dst, swap ? src1 : src0);
+         sse_cmpps(func, dst, swap ? src0 : src1, cc);
+         load_machine_const(c, tmp, TGSI_EXEC_TEMP_ONE_I,
+                            TGSI_EXEC_TEMP_ONE_C);
+         sse_andps(func, dst, tmp);
+      }
+      break;
+   case TGSI_OPCODE_MAD:
+      sse_movaps(func, dst, src0);
+      sse_mulps(func, dst, src1);
+      sse_addps(func, dst, src2);
+      break;
+   case TGSI_OPCODE_LRP:
+      /* src0 * (src1 - src2) + src2 */
+      sse_subps(func, src1, src2);
+      sse_movaps(func, dst, src0);
+      sse_mulps(func, dst, src1);
+      sse_addps(func, dst, src2);
+      break;
+   case TGSI_OPCODE_CMP:
+      /* src0 < 0 ? src1 : src2 */
+      sse_xorps(func, tmp, tmp);
+      sse_cmpps(func, src0, tmp, cc_LessThan);
+      sse_movaps(func, dst, src0);
+      sse_andps(func, dst, src1);
+      sse_andnps(func, src0, src2);
+      sse_orps(func, dst, src0);
+      break;
+   default:
+      assert(0);
+      break;
+   }
+}
+
+
+/**
+ * Compute a scalar operation or dot product into xmm3.
+ */
+static void
+emit_scalar_op(struct sse2_compiler *c,
+               const struct tgsi_full_instruction *inst)
+{
+   struct x86_function *func = c->func;
+   struct x86_reg src0 = make_xmm(0);
+   struct x86_reg src1 = make_xmm(1);
+   struct x86_reg dst = make_xmm(3);
+   struct x86_reg tmp = make_xmm(4);
+   uint num_chans, chan;
+
+   switch (inst->Instruction.Opcode) {
+   case TGSI_OPCODE_RCP:
+      emit_fetch(c, src0, inst, 0, TGSI_CHAN_X);
+      load_machine_const(c, dst, TGSI_EXEC_TEMP_ONE_I, TGSI_EXEC_TEMP_ONE_C);
+      sse_divps(func, dst, src0);
+      return;
+   case TGSI_OPCODE_RSQ:
+      emit_fetch(c, src0, inst, 0, TGSI_CHAN_X);
+      load_machine_const(c, tmp, TGSI_EXEC_TEMP_7FFFFFFF_I,
+                         TGSI_EXEC_TEMP_7FFFFFFF_C);
+      sse_andps(func, src0, tmp);
+      sse_sqrtps(func, src0, src0);
+      load_machine_const(c, dst, TGSI_EXEC_TEMP_ONE_I, TGSI_EXEC_TEMP_ONE_C);
+      sse_divps(func, dst, src0);
+      return;
+   case TGSI_OPCODE_DP2:
+      num_chans = 2;
+      break;
+   case TGSI_OPCODE_DP3:
+   case TGSI_OPCODE_DPH:
+      num_chans = 3;
+      break;
+   default:
+      num_chans = 4;
+      break;
+   }
+
+   for (chan = 0; chan < num_chans; chan++) {
+      struct x86_reg prod = chan == 0 ? dst : src0;
+
+      emit_fetch(c, src0, inst, 0, chan);
+      emit_fetch(c, src1, inst, 1, chan);
+      if (chan == 0)
+         sse_movaps(func, dst, src0);
+      sse_mulps(func, prod, src1);
+      if (chan > 0)
+         sse_addps(func, dst, src0);
+   }
+
+   if (inst->Instruction.Opcode == TGSI_OPCODE_DPH) {
+      emit_fetch(c, src1, inst, 1, TGSI_CHAN_W);
+      sse_addps(func, dst, src1);
+   }
+}
+
+
+static void
+emit_instruction(struct sse2_compiler *c,
+                 const struct tgsi_full_instruction *inst)
+{
+   const struct tgsi_full_dst_register *dst = &inst->Dst[0];
+   const unsigned file = dst->Register.File;
+   const int index = dst->Register.Index;
+   struct x86_reg result = make_xmm(3);
+   uint chan;
+
+   load_pointers(c);
+
+   switch (inst->Instruction.Opcode) {
+   case TGSI_OPCODE_RCP:
+   case TGSI_OPCODE_RSQ:
+   case TGSI_OPCODE_DP2:
+   case TGSI_OPCODE_DP3:
+   case TGSI_OPCODE_DP4:
+   case TGSI_OPCODE_DPH:
+      emit_scalar_op(c, inst);
+      emit_store_scalar(c, result, inst);
+      break;
+
+   default:
+      if (dst_aliases_src(inst)) {
+         /* all the channels are computed before any is stored */
+         for (chan = 0; chan < TGSI_NUM_CHANNELS; chan++) {
+            if (dst->Register.WriteMask & (1 << chan)) {
+               emit_vector_op(c, inst, chan);
+               sse_movups(c->func,
+                          x86_make_disp(c->scratch, chan * CHAN_SIZE),
+                          emit_saturate(c, result, inst));
+            }
+         }
+         for (chan = 0; chan < TGSI_NUM_CHANNELS; chan++) {
+            if (dst->Register.WriteMask & (1 << chan)) {
+               sse_movups(c->func, result,
+                          x86_make_disp(c->scratch, chan * CHAN_SIZE));
+               sse_movups(c->func, get_chan(c, file, index, chan), result);
+            }
+         }
+      }
+      else {
+         for (chan = 0; chan < TGSI_NUM_CHANNELS; chan++) {
+            if (dst->Register.WriteMask & (1 << chan)) {
+               emit_vector_op(c, inst, chan);
+               sse_movups(c->func, get_chan(c, file, index, chan),
+                          emit_saturate(c, result, inst));
+            }
+         }
+      }
+      break;
+   }
+}
+
+
+/**
+ * Have the interpreter run instruction pc.
+ */
+static void
+emit_fallback(struct sse2_compiler *c, uint pc)
+{
+   x64_mov64(c->func, x86_fn_arg(c->func, 1), c->machine);
+   x86_mov_reg_imm(c->func, x86_fn_arg(c->func, 2), pc);
+   x86_call(c->func, c->exec);
+
+   /* rsi and rdi are only callee-saved on Win64 */
+   if (x86_target(c->func) != X86_64_WIN64_ABI)
+      c->pointers_loaded = FALSE;
+}
+
+
+static void
+emit_prologue(struct sse2_compiler *c)
+{
+   struct x86_function *func = c->func;
+   struct x86_reg sp = x86_make_reg(file_REG32, reg_SP);
+
+   if (x86_target(func) == X86_64_WIN64_ABI) {
+      x86_push(func, c->inputs);
+      x86_push(func, c->outputs);
+   }
+   x86_push(func, c->machine);
+   x86_push(func, c->exec);
+
+   /* keep the stack 16 byte aligned for the calls */
+   if (x86_target(func) == X86_64_WIN64_ABI) {
+      c->frame_size = 104;
+      c->scratch = x86_make_disp(sp, 32);   /* after the shadow space */
+   }
+   else {
+      c->frame_size = 72;
+      c->scratch = x86_make_disp(sp, 0);
+   }
+   x64_rexw(func);
+   x86_sub_imm(func, sp, c->frame_size);
+
+   x64_mov64(func, c->machine, x86_fn_arg(func, 1));
+   x64_mov64(func, c->exec, x86_fn_arg(func, 2));
+   c->pointers_loaded = FALSE;
+}
+
+
+static void
+emit_epilogue(struct sse2_compiler *c)
+{
+   struct x86_function *func = c->func;
+
+   x64_rexw(func);
+   x86_add_imm(func, x86_make_reg(file_REG32, reg_SP), c->frame_size);
+
+   x86_pop(func, c->exec);
+   x86_pop(func, c->machine);
+   if (x86_target(func) == X86_64_WIN64_ABI) {
+      x86_pop(func, c->outputs);
+      x86_pop(func, c->inputs);
+   }
+   x86_ret(func);
+}
+
+
+/**
+ * Translate the shader to a tgsi_sse2_func.
+ * \return FALSE if the shader has flow control (or nothing worth
+ *         translating), in which case it should be interpreted
+ */
+boolean
+tgsi_emit_sse2(const struct tgsi_token *tokens,
+               struct x86_function *func)
+{
+   struct sse2_compiler c;
+   struct tgsi_parse_context parse;
+   uint num_native = 0;
+   uint pc;
+
+   /* first pass: make sure the instructions can be run one by one */
+   if (tgsi_parse_init(&parse, tokens) != TGSI_PARSE_OK)
+      return FALSE;
+
+   while (!tgsi_parse_end_of_tokens(&parse)) {
+      tgsi_parse_token(&parse);
+      if (parse.FullToken.Token.Type == TGSI_TOKEN_TYPE_INSTRUCTION) {
+         const struct tgsi_full_instruction *inst =
+            &parse.FullToken.FullInstruction;
+
+         if (is_flow_control(inst->Instruction.Opcode)) {
+            tgsi_parse_free(&parse);
+            return FALSE;
+         }
+         if (is_native(inst) && inst->Instruction.Opcode != TGSI_OPCODE_NOP)
+            num_native++;
+      }
+   }
+   tgsi_parse_free(&parse);
+
+   if (!num_native)
+      return FALSE;
+
+   memset(&c, 0, sizeof c);
+   c.func = func;
+   c.machine = x86_make_reg(file_REG32, reg_BX);
+   c.exec = x86_make_reg(file_REG32, reg_BP);
+   c.inputs = x86_make_reg(file_REG32, reg_SI);
+   c.outputs = x86_make_reg(file_REG32, reg_DI);
+   c.tmp = x86_make_reg(file_REG32, reg_AX);
+
+   x86_init_func(func);
+   emit_prologue(&c);
+
+   /* second pass: the code */
+   tgsi_parse_init(&parse, tokens);
+   pc = 0;
+   while (!tgsi_parse_end_of_tokens(&parse)) {
+      tgsi_parse_token(&parse);
+      if (parse.FullToken.Token.Type == TGSI_TOKEN_TYPE_INSTRUCTION) {
+         const struct tgsi_full_instruction *inst =
+            &parse.FullToken.FullInstruction;
+
+         if (inst->Instruction.Opcode == TGSI_OPCODE_END)
+            break;
+
+         if (!is_native(inst))
+            emit_fallback(&c, pc);
+         else if (inst->Instruction.Opcode != TGSI_OPCODE_NOP)
+            emit_instruction(&c, inst);
+         pc++;
+      }
+   }
+   tgsi_parse_free(&parse);
+
+   emit_epilogue(&c);
+
+   if (!x86_get_func(func)) {
+      debug_printf("%s: out of memory\n", __FUNCTION__);
+      x86_release_func(func);
+      return FALSE;
+   }
+
+   return TRUE;
+}
+
+
+#endif /* PIPE_ARCH_X86_64 */
@@ -0,0 +1,86 @@
+/**************************************************************************
+ *
+ * Copyright 2013 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/**
+ * TGSI to x86-64 SSE2 translation, with rtasm.
+ *
+ * The generated code works on a tgsi_exec_machine bound to the same tokens
+ * and computes exactly what tgsi_exec_machine_run() would.  Only shaders
+ * without flow control are translated, and only the arithmetic instructions
+ * on directly addressed registers are turned into SSE2 code: every other
+ * instruction (texture sampling, KILL, ...) is handed back to the
+ * interpreter with a call to tgsi_exec_machine_run_instruction().
+ */
+
+#ifndef TGSI_SSE2_H
+#define TGSI_SSE2_H
+
+#include "pipe/p_config.h"
+
+#if defined(PIPE_ARCH_X86_64)
+
+#include "tgsi_exec.h"
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+struct tgsi_token;
+struct x86_function;
+
+
+typedef void (*tgsi_sse2_exec_func)(struct tgsi_exec_machine *mach, uint pc);
+
+typedef void (*tgsi_sse2_func)(struct tgsi_exec_machine *mach,
+                               tgsi_sse2_exec_func exec);
+
+
+boolean
+tgsi_emit_sse2(const struct tgsi_token *tokens,
+               struct x86_function *func);
+
+
+/**
+ * Run a shader translated by tgsi_emit_sse2().
+ * \return bitmask of "alive" quad components, like tgsi_exec_machine_run()
+ */
+static INLINE uint
+tgsi_sse2_run(struct tgsi_exec_machine *mach, tgsi_sse2_func func)
+{
+   tgsi_exec_machine_begin_run(mach);
+   func(mach, tgsi_exec_machine_run_instruction);
+   return ~mach->Temps[TGSI_EXEC_TEMP_KILMASK_I].xyzw[TGSI_EXEC_TEMP_KILMASK_C].u[0];
+}
+
+
+#if defined __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* PIPE_ARCH_X86_64 */
+
+#endif /* TGSI_SSE2_H */
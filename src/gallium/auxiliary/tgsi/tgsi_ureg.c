@@ -193,6 +193,11 @@ static void tokens_error( struct ureg_tokens *tokens )
 }
 
 
+/* Smallest token buffer allocated, big enough for most simple shaders
+ * so they get by without reallocating.
+ */
+#define UREG_MIN_TOKENS_ORDER 7
+
 static void tokens_expand( struct ureg_tokens *tokens,
                            unsigned count )
 {
@@ -202,6 +207,10 @@ static void tokens_expand( struct ureg_tokens *tokens,
       return;
    }
 
+   if (tokens->order < UREG_MIN_TOKENS_ORDER) {
+      tokens->order = UREG_MIN_TOKENS_ORDER - 1;
+   }
+
    while (tokens->count + count > tokens->size) {
       tokens->size = (1 << ++tokens->order);
    }
@@ -237,6 +246,27 @@ static union tgsi_any_token *get_tokens( struct ureg_program *ureg,
 }
 
 
+/* Rough number of tokens making up an instruction: the instruction token,
+ * a destination register and a few source registers.
+ */
+#define UREG_TOKENS_PER_INSN 6
+
+void ureg_reserve_instructions( struct ureg_program *ureg,
+                                unsigned nr_insns )
+{
+   struct ureg_tokens *insn = &ureg->domain[DOMAIN_INSN];
+   struct ureg_tokens *decl = &ureg->domain[DOMAIN_DECL];
+   unsigned count = nr_insns * UREG_TOKENS_PER_INSN;
+
+   if (insn->count + count > insn->size)
+      tokens_expand(insn, count);
+
+   /* The instructions are copied after the declarations when finalizing. */
+   if (decl->count + count + 64 > decl->size)
+      tokens_expand(decl, count + 64);
+}
+
+
 static union tgsi_any_token *retrieve_token( struct ureg_program *ureg,
                                             unsigned domain,
                                             unsigned nr )
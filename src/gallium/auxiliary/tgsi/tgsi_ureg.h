@@ -94,6 +94,13 @@ struct pipe_context;
 struct ureg_program *
 ureg_create( unsigned processor );
 
+/* Preallocate the token buffers for about nr_insns instructions,
+ * to avoid growing them repeatedly while the shader is built:
+ */
+void
+ureg_reserve_instructions( struct ureg_program *ureg,
+                           unsigned nr_insns );
+
 const struct tgsi_token *
 ureg_finalize( struct ureg_program * );
 
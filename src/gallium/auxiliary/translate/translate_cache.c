@@ -26,6 +26,9 @@
  **************************************************************************/
 
 #include "util/u_memory.h"
+#include "util/u_debug.h"
+#include "util/u_simple_list.h"
+#include "os/os_time.h"
 #include "pipe/p_state.h"
 #include "translate.h"
 #include "translate_cache.h"
@@ -33,37 +36,97 @@
 #include "cso_cache/cso_cache.h"
 #include "cso_cache/cso_hash.h"
 
+struct translate_cache_item {
+   struct translate_cache_item *next;
+   struct translate_cache_item *prev;
+   unsigned hash_key;
+   struct translate *translate;
+};
+
 struct translate_cache {
    struct cso_hash *hash;
+
+   /** Items, most recently used first */
+   struct translate_cache_item lru;
+   unsigned size;
+   unsigned max_size;
+
+   struct translate_cache_stats stats;
 };
 
 struct translate_cache * translate_cache_create( void )
 {
-   struct translate_cache *cache = MALLOC_STRUCT(translate_cache);
+   struct translate_cache *cache = CALLOC_STRUCT(translate_cache);
    if (cache == NULL) {
       return NULL;
    }
 
    cache->hash = cso_hash_create();
+   make_empty_list(&cache->lru);
    return cache;
 }
 
 
-static INLINE void delete_translates(struct translate_cache *cache)
+void translate_cache_set_max_size(struct translate_cache *cache,
+                                  unsigned max_size)
+{
+   cache->max_size = max_size;
+}
+
+
+void translate_cache_get_stats(const struct translate_cache *cache,
+                               struct translate_cache_stats *stats)
+{
+   *stats = cache->stats;
+}
+
+
+static void delete_item(struct translate_cache *cache,
+                        struct translate_cache_item *item)
 {
-   struct cso_hash *hash = cache->hash;
-   struct cso_hash_iter iter = cso_hash_first_node(hash);
+   struct cso_hash_iter iter = cso_hash_find(cache->hash, item->hash_key);
+
    while (!cso_hash_iter_is_null(iter)) {
-      struct translate *state = (struct translate*)cso_hash_iter_data(iter);
-      iter = cso_hash_iter_next(iter);
-      if (state) {
-         state->release(state);
+      if (cso_hash_iter_data(iter) == item) {
+         cso_hash_erase(cache->hash, iter);
+         break;
       }
+      iter = cso_hash_find_next(iter);
+   }
+
+   remove_from_list(item);
+   item->translate->release(item->translate);
+   FREE(item);
+   cache->size--;
+}
+
+
+static INLINE void delete_translates(struct translate_cache *cache)
+{
+   while (!is_empty_list(&cache->lru)) {
+      struct translate_cache_item *item = first_elem(&cache->lru);
+      remove_from_list(item);
+      item->translate->release(item->translate);
+      FREE(item);
    }
 }
 
 void translate_cache_destroy(struct translate_cache *cache)
 {
+   static int print_stats = -1;
+
+   if (print_stats == -1)
+      print_stats = debug_get_bool_option("TRANSLATE_CACHE_STATS", FALSE);
+
+   if (print_stats) {
+      debug_printf("translate cache %p: %u hits, %u misses, %u evictions, "
+                   "%llu us generating code\n",
+                   (void *) cache,
+                   cache->stats.hits, cache->stats.misses,
+                   cache->stats.evictions,
+                   (unsigned long long) (cache->stats.create_nsec / 1000));
+   }
+
    delete_translates(cache);
    cso_hash_delete(cache->hash);
    FREE(cache);
@@ -87,20 +150,73 @@ static INLINE unsigned create_key(struct translate_key *key)
    return hash_key;
 }
 
+static struct translate_cache_item *
+find_item(struct translate_cache *cache,
+          unsigned hash_key,
+          const struct translate_key *key)
+{
+   struct cso_hash_iter iter = cso_hash_find(cache->hash, hash_key);
+
+   while (!cso_hash_iter_is_null(iter)) {
+      struct translate_cache_item *item =
+         (struct translate_cache_item *) cso_hash_iter_data(iter);
+      if (translate_key_compare(&item->translate->key, key) == 0)
+         return item;
+      iter = cso_hash_find_next(iter);
+   }
+
+   return NULL;
+}
+
 struct translate * translate_cache_find(struct translate_cache *cache,
                                         struct translate_key *key)
 {
-   unsigned hash_key = create_key(key);
-   struct translate *translate = (struct translate*)
-      cso_hash_find_data_from_template(cache->hash,
-                                       hash_key,
-                                       key, sizeof(*key));
-
-   if (!translate) {
-      /* create/insert */
-      translate = translate_create(key);
-      cso_hash_insert(cache->hash, hash_key, translate);
+   struct translate_cache_item *item;
+   unsigned hash_key;
+   int64_t start;
+
+   /* The last used translate is at the head: check it without hashing */
+   if (!is_empty_list(&cache->lru)) {
+      item = first_elem(&cache->lru);
+      if (translate_key_compare(&item->translate->key, key) == 0) {
+         cache->stats.hits++;
+         return item->translate;
+      }
+   }
+
+   hash_key = create_key(key);
+   item = find_item(cache, hash_key, key);
+   if (item) {
+      cache->stats.hits++;
+      move_to_head(&cache->lru, item);
+      return item->translate;
+   }
+
+   /* create/insert */
+   cache->stats.misses++;
+
+   item = CALLOC_STRUCT(translate_cache_item);
+   if (!item)
+      return NULL;
+
+   start = os_time_get_nano();
+   item->translate = translate_create(key);
+   cache->stats.create_nsec += os_time_get_nano() - start;
+   if (!item->translate) {
+      FREE(item);
+      return NULL;
+   }
+
+   item->hash_key = hash_key;
+   cso_hash_insert(cache->hash, hash_key, item);
+   insert_at_head(&cache->lru, item);
+   cache->size++;
+
+   /* Evict the least recently used ones, never the one just created */
+   while (cache->max_size && cache->size > cache->max_size) {
+      delete_item(cache, last_elem(&cache->lru));
+      cache->stats.evictions++;
    }
 
-   return translate;
+   return item->translate;
 }
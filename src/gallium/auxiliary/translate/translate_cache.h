@@ -24,6 +24,8 @@
 #ifndef _TRANSLATE_CACHE_H
 #define _TRANSLATE_CACHE_H
 
+#include "pipe/p_compiler.h"
+
 
 /*******************************************************************************
  * Translate cache.
@@ -38,9 +40,31 @@ struct translate_cache;
 struct translate_key;
 struct translate;
 
+struct translate_cache_stats {
+   unsigned hits;
+   unsigned misses;
+   unsigned evictions;
+   uint64_t create_nsec;    /**< time spent creating translates */
+};
+
 struct translate_cache *translate_cache_create( void );
 void translate_cache_destroy(struct translate_cache *cache);
 
+/** A reasonable bound for translate_cache_set_max_size() */
+#define TRANSLATE_CACHE_DEFAULT_MAX_SIZE 64
+
+/**
+ * Bound the number of translates kept, evicting the least recently used
+ * ones.  Zero, the default, means no bound.  Only the translate returned
+ * by the latest translate_cache_find() is guaranteed to stay alive, so
+ * this is for caches whose user holds on to just that one.
+ */
+void translate_cache_set_max_size(struct translate_cache *cache,
+                                  unsigned max_size);
+
+void translate_cache_get_stats(const struct translate_cache *cache,
+                               struct translate_cache_stats *stats);
+
 /**
  * Will try to find a translate structure matched by the given key.
  * If such a structure doesn't exist in the cache the function
@@ -62,7 +62,7 @@ struct translate_buffer_variant {
 
 #define ELEMENT_BUFFER_INSTANCE_ID  1001
 
-#define NUM_CONSTS 7
+#define NUM_CONSTS 16
 
 enum
 {
@@ -72,7 +72,17 @@ enum
    CONST_INV_32767,
    CONST_INV_65535,
    CONST_INV_2147483647,
-   CONST_255
+   CONST_255,
+   CONST_HALF_MAGIC,
+   CONST_HALF_INF,
+   CONST_1010102_SCALE,
+   CONST_1010102_UNORM_SCALE,
+   /* bit patterns, see int_consts */
+   CONST_HALF_SIGN,
+   CONST_ABS_MASK,
+   CONST_INF_EXP,
+   CONST_1010102_MASK,
+   CONST_1010102_MASK_A
 };
 
 #define C(v) {(float)(v), (float)(v), (float)(v), (float)(v)}
@@ -83,10 +93,28 @@ static float consts[NUM_CONSTS][4] = {
       C(1.0 / 32767.0),
       C(1.0 / 65535.0),
       C(1.0 / 2147483647.0),
-      C(255.0)
+      C(255.0),
+      C(5192296858534827628530496329220096.0), /* 2^112 */
+      C(65536.0),
+      {1.0, 1.0 / (1 << 10), 1.0 / (1 << 20), 1.0 / (1 << 28)},
+      {1.0 / 1023.0, 1.0 / 1023.0 / (1 << 10), 1.0 / 1023.0 / (1 << 20),
+       1.0 / 3.0 / (1 << 28)},
 };
 #undef C
 
+#define I(v) {(v), (v), (v), (v)}
+static const struct {
+   unsigned id;
+   uint32_t bits[4];
+} int_consts[] = {
+   { CONST_HALF_SIGN, I(0x8000) },
+   { CONST_ABS_MASK, I(0x7fffffff) },
+   { CONST_INF_EXP, I(0x7f800000) },
+   { CONST_1010102_MASK, {0x3ff, 0x3ff << 10, 0x3ff << 20, 0} },
+   { CONST_1010102_MASK_A, {0, 0, 0, 0x3 << 28} }
+};
+#undef I
+
 struct translate_sse {
    struct translate translate;
 
@@ -214,6 +242,77 @@ static boolean emit_load_sse2( struct translate_sse *p,
    return TRUE;
 }
 
+/* convert the half floats in the low words of each dword to floats */
+static void emit_half_to_float( struct translate_sse *p,
+                                struct x86_reg data )
+{
+   struct x86_reg tmpXMM = x86_make_reg(file_XMM, 1);
+
+   /* split off the sign, and make exponent and mantissa a float with the
+    * exponent off by 2^112, which also takes care of denormals
+    */
+   sse_movaps(p->func, tmpXMM, data);
+   sse_andps(p->func, tmpXMM, get_const(p, CONST_HALF_SIGN));
+   sse_xorps(p->func, data, tmpXMM);
+   sse2_pslld_imm(p->func, tmpXMM, 16);
+   sse2_pslld_imm(p->func, data, 13);
+   sse_mulps(p->func, data, get_const(p, CONST_HALF_MAGIC));
+   sse_orps(p->func, data, tmpXMM);
+
+   /* infinities and NaNs end up at 65536 or above: force their exponent */
+   sse_movaps(p->func, tmpXMM, data);
+   sse_andps(p->func, tmpXMM, get_const(p, CONST_ABS_MASK));
+   sse_cmpps(p->func, tmpXMM, get_const(p, CONST_HALF_INF), cc_NotLessThan);
+   sse_andps(p->func, tmpXMM, get_const(p, CONST_INF_EXP));
+   sse_orps(p->func, data, tmpXMM);
+}
+
+/* whether the format is one of the unsigned 10_10_10_2 ones */
+static boolean is_unsigned_10_10_10_2( const struct util_format_description *desc )
+{
+   unsigned i;
+
+   if(desc->layout != UTIL_FORMAT_LAYOUT_PLAIN || desc->block.bits != 32 ||
+      desc->nr_channels != 4 || desc->channel[3].size != 2)
+      return FALSE;
+
+   for(i = 0; i < 4; ++i)
+   {
+      if(desc->channel[i].type != UTIL_FORMAT_TYPE_UNSIGNED ||
+         desc->channel[i].normalized != desc->channel[0].normalized ||
+         (i < 3 && desc->channel[i].size != 10))
+         return FALSE;
+   }
+
+   return TRUE;
+}
+
+/* load and unpack a 10_10_10_2 dword to four floats */
+static void emit_load_10_10_10_2( struct translate_sse *p,
+                                  struct x86_reg data,
+                                  struct x86_reg src,
+                                  boolean normalized )
+{
+   struct x86_reg tmpXMM = x86_make_reg(file_XMM, 1);
+
+   sse2_movd(p->func, data, src);
+   sse2_pshufd(p->func, data, data, SHUF(0, 0, 0, 0));
+
+   /* keep each channel in place, but move the top one down a bit so
+    * that it stays positive as a signed integer
+    */
+   sse2_movdqa(p->func, tmpXMM, data);
+   sse2_psrld_imm(p->func, tmpXMM, 2);
+   sse_andps(p->func, data, get_const(p, CONST_1010102_MASK));
+   sse_andps(p->func, tmpXMM, get_const(p, CONST_1010102_MASK_A));
+   sse_orps(p->func, data, tmpXMM);
+
+   sse2_cvtdq2ps(p->func, data, data);
+   sse_mulps(p->func, data, get_const(p, normalized ?
+                                      CONST_1010102_UNORM_SCALE :
+                                      CONST_1010102_SCALE));
+}
+
 /* this value can be passed for the out_chans argument */
 #define CHANNELS_0001 5
 
@@ -453,17 +552,20 @@ static boolean translate_attr_convert( struct translate_sse *p,
    unsigned swizzle[4] = {UTIL_FORMAT_SWIZZLE_NONE, UTIL_FORMAT_SWIZZLE_NONE, UTIL_FORMAT_SWIZZLE_NONE, UTIL_FORMAT_SWIZZLE_NONE};
    unsigned needed_chans = 0;
    unsigned imms[2] = {0, 0x3f800000};
+   boolean packed_10_10_10_2;
 
    if(a->output_format == PIPE_FORMAT_NONE || a->input_format == PIPE_FORMAT_NONE)
       return FALSE;
 
-   if(input_desc->channel[0].size & 7)
+   packed_10_10_10_2 = is_unsigned_10_10_10_2(input_desc);
+
+   if((input_desc->channel[0].size & 7) && !packed_10_10_10_2)
       return FALSE;
 
    if(input_desc->colorspace != output_desc->colorspace)
       return FALSE;
 
-   for(i = 1; i < input_desc->nr_channels; ++i)
+   for(i = 1; i < input_desc->nr_channels && !packed_10_10_10_2; ++i)
    {
       if(memcmp(&input_desc->channel[i], &input_desc->channel[0], sizeof(input_desc->channel[0])))
          return FALSE;
@@ -510,6 +612,11 @@ static boolean translate_attr_convert( struct translate_sse *p,
          case UTIL_FORMAT_TYPE_UNSIGNED:
             if(!(x86_target_caps(p->func) & X86_SSE2))
                return FALSE;
+            if(packed_10_10_10_2)
+            {
+               emit_load_10_10_10_2(p, dataXMM, src, input_desc->channel[0].normalized);
+               break;
+            }
             emit_load_sse2(p, dataXMM, src, input_desc->channel[0].size * input_desc->nr_channels >> 3);
 
             /* TODO: add support for SSE4.1 pmovzx */
@@ -608,6 +715,15 @@ static boolean translate_attr_convert( struct translate_sse *p,
 
             break;
          case UTIL_FORMAT_TYPE_FLOAT:
+            if(input_desc->channel[0].size == 16)
+            {
+               if(!(x86_target_caps(p->func) & X86_SSE2))
+                  return FALSE;
+               emit_load_sse2(p, dataXMM, src, input_desc->nr_channels * 2);
+               sse2_punpcklwd(p->func, dataXMM, get_const(p, CONST_IDENTITY));
+               emit_half_to_float(p, dataXMM);
+               break;
+            }
             if(input_desc->channel[0].size != 32 && input_desc->channel[0].size != 64)
                return FALSE;
             if(swizzle[3] == UTIL_FORMAT_SWIZZLE_1 && input_desc->nr_channels <= 3)
@@ -1465,6 +1581,9 @@ struct translate *translate_sse2_create( const struct translate_key *key )
       goto fail;
    memset(p, 0, sizeof(*p));
    memcpy(p->consts, consts, sizeof(consts));
+   for (i = 0; i < Elements(int_consts); i++)
+      memcpy(p->consts[int_consts[i].id], int_consts[i].bits,
+             sizeof(int_consts[i].bits));
 
    p->translate.key = *key;
    p->translate.release = translate_sse_release;
@@ -61,7 +61,8 @@ struct blitter_context_priv
 
    /* Templates for various state objects. */
 
-   /* Constant state objects. */
+   /* Constant state objects.  The shaders and blend states are created on
+    * first use, so contexts that never blit don't pay for them. */
    /* Vertex shaders. */
    void *vs; /**< Vertex shader which passes {pos, generic} to the output.*/
    void *vs_pos_only; /**< Vertex shader which passes pos to the output.*/
@@ -121,6 +122,10 @@ struct blitter_context_priv
    boolean has_stencil_export;
    boolean has_texture_multisample;
 
+   /* Whether the blitter changed the stencil reference value since it was
+    * saved, the only misc state it doesn't always override. */
+   boolean stencil_ref_changed;
+
    /* The Draw module overrides these functions.
     * Always create the blitter before Draw. */
    void   (*bind_fs_state)(struct pipe_context *, void *);
@@ -134,7 +139,6 @@ util_blitter_get_next_surface_layer(struct pipe_context *pipe,
 struct blitter_context *util_blitter_create(struct pipe_context *pipe)
 {
    struct blitter_context_priv *ctx;
-   struct pipe_blend_state blend;
    struct pipe_depth_stencil_alpha_state dsa;
    struct pipe_rasterizer_state rs_state;
    struct pipe_sampler_state sampler_state;
@@ -179,14 +183,6 @@ struct blitter_context *util_blitter_create(struct pipe_context *pipe)
    ctx->has_texture_multisample =
       pipe->screen->get_param(pipe->screen, PIPE_CAP_TEXTURE_MULTISAMPLE);
 
-   /* blend state objects */
-   memset(&blend, 0, sizeof(blend));
-
-   for (i = 0; i <= PIPE_MASK_RGBA; i++) {
-      blend.rt[0].colormask = i;
-      ctx->blend[i] = pipe->create_blend_state(pipe, &blend);
-   }
-
    /* depth stencil alpha state objects */
    memset(&dsa, 0, sizeof(dsa));
    ctx->dsa_keep_depth_stencil =
@@ -275,41 +271,6 @@ struct blitter_context *util_blitter_create(struct pipe_context *pipe)
       }
    }
 
-   /* Fragment shaders are created on-demand, except these.
-    * The interpolation must be constant for integer texture clearing to work.
-    */
-   ctx->fs_empty = util_make_empty_fragment_shader(pipe);
-   ctx->fs_write_one_cbuf =
-      util_make_fragment_passthrough_shader(pipe, TGSI_SEMANTIC_GENERIC,
-                                            TGSI_INTERPOLATE_CONSTANT, FALSE);
-   ctx->fs_write_all_cbufs =
-      util_make_fragment_passthrough_shader(pipe, TGSI_SEMANTIC_GENERIC,
-                                            TGSI_INTERPOLATE_CONSTANT, TRUE);
-
-   /* vertex shaders */
-   {
-      const uint semantic_names[] = { TGSI_SEMANTIC_POSITION,
-                                      TGSI_SEMANTIC_GENERIC };
-      const uint semantic_indices[] = { 0, 0 };
-      ctx->vs =
-         util_make_vertex_passthrough_shader(pipe, 2, semantic_names,
-                                             semantic_indices);
-   }
-   if (ctx->has_stream_out) {
-      struct pipe_stream_output_info so;
-      const uint semantic_names[] = { TGSI_SEMANTIC_POSITION };
-      const uint semantic_indices[] = { 0 };
-
-      memset(&so, 0, sizeof(so));
-      so.num_outputs = 1;
-      so.output[0].num_components = 1;
-      so.stride[0] = 1;
-
-      ctx->vs_pos_only =
-         util_make_vertex_passthrough_shader_with_so(pipe, 1, semantic_names,
-                                                     semantic_indices, &so);
-   }
-
    /* set invariant vertex coordinates */
    for (i = 0; i < 4; i++)
       ctx->vertices[i][0][3] = 1; /*v.w*/
@@ -326,7 +287,8 @@ void util_blitter_destroy(struct blitter_context *blitter)
    int i;
 
    for (i = 0; i <= PIPE_MASK_RGBA; i++) {
-      pipe->delete_blend_state(pipe, ctx->blend[i]);
+      if (ctx->blend[i])
+         pipe->delete_blend_state(pipe, ctx->blend[i]);
    }
    pipe->delete_depth_stencil_alpha_state(pipe, ctx->dsa_keep_depth_stencil);
    pipe->delete_depth_stencil_alpha_state(pipe,
@@ -338,7 +300,8 @@ void util_blitter_destroy(struct blitter_context *blitter)
    pipe->delete_rasterizer_state(pipe, ctx->rs_state_scissor);
    if (ctx->rs_discard_state)
       pipe->delete_rasterizer_state(pipe, ctx->rs_discard_state);
-   pipe->delete_vs_state(pipe, ctx->vs);
+   if (ctx->vs)
+      pipe->delete_vs_state(pipe, ctx->vs);
    if (ctx->vs_pos_only)
       pipe->delete_vs_state(pipe, ctx->vs_pos_only);
    pipe->delete_vertex_elements_state(pipe, ctx->velem_state);
@@ -358,9 +321,12 @@ void util_blitter_destroy(struct blitter_context *blitter)
       if (ctx->fs_texfetch_stencil[i])
          ctx->delete_fs_state(pipe, ctx->fs_texfetch_stencil[i]);
    }
-   ctx->delete_fs_state(pipe, ctx->fs_empty);
-   ctx->delete_fs_state(pipe, ctx->fs_write_one_cbuf);
-   ctx->delete_fs_state(pipe, ctx->fs_write_all_cbufs);
+   if (ctx->fs_empty)
+      ctx->delete_fs_state(pipe, ctx->fs_empty);
+   if (ctx->fs_write_one_cbuf)
+      ctx->delete_fs_state(pipe, ctx->fs_write_one_cbuf);
+   if (ctx->fs_write_all_cbufs)
+      ctx->delete_fs_state(pipe, ctx->fs_write_all_cbufs);
 
    pipe->delete_sampler_state(pipe, ctx->sampler_state_rect_linear);
    pipe->delete_sampler_state(pipe, ctx->sampler_state_rect);
@@ -478,7 +444,10 @@ static void blitter_restore_fragment_states(struct blitter_context_priv *ctx)
    /* Miscellaneous states. */
    /* XXX check whether these are saved and whether they need to be restored
     * (depending on the operation) */
-   pipe->set_stencil_ref(pipe, &ctx->base.saved_stencil_ref);
+   if (ctx->stencil_ref_changed) {
+      pipe->set_stencil_ref(pipe, &ctx->base.saved_stencil_ref);
+      ctx->stencil_ref_changed = FALSE;
+   }
    pipe->set_viewport_states(pipe, 0, 1, &ctx->base.saved_viewport);
 }
 
@@ -708,6 +677,82 @@ static void blitter_set_dst_dimensions(struct blitter_context_priv *ctx,
    ctx->dst_height = height;
 }
 
+static void *blitter_get_blend(struct blitter_context_priv *ctx,
+                               unsigned colormask)
+{
+   struct pipe_context *pipe = ctx->base.pipe;
+
+   assert(colormask <= PIPE_MASK_RGBA);
+
+   if (!ctx->blend[colormask]) {
+      struct pipe_blend_state blend;
+
+      memset(&blend, 0, sizeof(blend));
+      blend.rt[0].colormask = colormask;
+      ctx->blend[colormask] = pipe->create_blend_state(pipe, &blend);
+   }
+   return ctx->blend[colormask];
+}
+
+static void *blitter_get_vs(struct blitter_context_priv *ctx)
+{
+   if (!ctx->vs) {
+      const uint semantic_names[] = { TGSI_SEMANTIC_POSITION,
+                                      TGSI_SEMANTIC_GENERIC };
+      const uint semantic_indices[] = { 0, 0 };
+      ctx->vs =
+         util_make_vertex_passthrough_shader(ctx->base.pipe, 2, semantic_names,
+                                             semantic_indices);
+   }
+   return ctx->vs;
+}
+
+static void *blitter_get_vs_pos_only(struct blitter_context_priv *ctx)
+{
+   assert(ctx->has_stream_out);
+
+   if (!ctx->vs_pos_only) {
+      struct pipe_stream_output_info so;
+      const uint semantic_names[] = { TGSI_SEMANTIC_POSITION };
+      const uint semantic_indices[] = { 0 };
+
+      memset(&so, 0, sizeof(so));
+      so.num_outputs = 1;
+      so.output[0].num_components = 1;
+      so.stride[0] = 1;
+
+      ctx->vs_pos_only =
+         util_make_vertex_passthrough_shader_with_so(ctx->base.pipe, 1,
+                                                     semantic_names,
+                                                     semantic_indices, &so);
+   }
+   return ctx->vs_pos_only;
+}
+
+static void *blitter_get_fs_empty(struct blitter_context_priv *ctx)
+{
+   if (!ctx->fs_empty)
+      ctx->fs_empty = util_make_empty_fragment_shader(ctx->base.pipe);
+   return ctx->fs_empty;
+}
+
+/* The interpolation must be constant for integer texture clearing to work.
+ */
+static void *blitter_get_fs_write_cbufs(struct blitter_context_priv *ctx,
+                                        boolean write_all_cbufs)
+{
+   void **shader = write_all_cbufs ? &ctx->fs_write_all_cbufs
+                                   : &ctx->fs_write_one_cbuf;
+
+   if (!*shader)
+      *shader =
+         util_make_fragment_passthrough_shader(ctx->base.pipe,
+                                               TGSI_SEMANTIC_GENERIC,
+                                               TGSI_INTERPOLATE_CONSTANT,
+                                               write_all_cbufs);
+   return *shader;
+}
+
 static void *blitter_get_fs_texfetch_col(struct blitter_context_priv *ctx,
                                          enum pipe_texture_target target,
                                          unsigned nr_samples)
@@ -896,6 +941,13 @@ void util_blitter_cache_all_shaders(struct blitter_context *blitter)
          }
       }
    }
+
+   blitter_get_fs_empty(ctx);
+   blitter_get_fs_write_cbufs(ctx, FALSE);
+   blitter_get_fs_write_cbufs(ctx, TRUE);
+   blitter_get_vs(ctx);
+   if (ctx->has_stream_out)
+      blitter_get_vs_pos_only(ctx);
 }
 
 static void blitter_set_common_draw_rect_state(struct blitter_context_priv *ctx,
@@ -905,7 +957,7 @@ static void blitter_set_common_draw_rect_state(struct blitter_context_priv *ctx,
 
    pipe->bind_rasterizer_state(pipe, scissor ? ctx->rs_state_scissor
                                              : ctx->rs_state);
-   pipe->bind_vs_state(pipe, ctx->vs);
+   pipe->bind_vs_state(pipe, blitter_get_vs(ctx));
    if (ctx->has_geometry_shader)
       pipe->bind_gs_state(pipe, NULL);
    if (ctx->has_stream_out)
@@ -970,9 +1022,9 @@ static void util_blitter_clear_custom(struct blitter_context *blitter,
    if (custom_blend) {
       pipe->bind_blend_state(pipe, custom_blend);
    } else if (clear_buffers & PIPE_CLEAR_COLOR) {
-      pipe->bind_blend_state(pipe, ctx->blend[PIPE_MASK_RGBA]);
+      pipe->bind_blend_state(pipe, blitter_get_blend(ctx, PIPE_MASK_RGBA));
    } else {
-      pipe->bind_blend_state(pipe, ctx->blend[0]);
+      pipe->bind_blend_state(pipe, blitter_get_blend(ctx, 0));
    }
 
    if (custom_dsa) {
@@ -989,9 +1041,10 @@ static void util_blitter_clear_custom(struct blitter_context *blitter,
 
    sr.ref_value[0] = stencil & 0xff;
    pipe->set_stencil_ref(pipe, &sr);
+   ctx->stencil_ref_changed = TRUE;
 
    pipe->bind_vertex_elements_state(pipe, ctx->velem_state);
-   ctx->bind_fs_state(pipe, ctx->fs_write_all_cbufs);
+   ctx->bind_fs_state(pipe, blitter_get_fs_write_cbufs(ctx, TRUE));
    pipe->set_sample_mask(pipe, ~0);
 
    blitter_set_common_draw_rect_state(ctx, FALSE);
@@ -1245,7 +1298,7 @@ void util_blitter_blit_generic(struct blitter_context *blitter,
    fb_state.zsbuf = NULL;
 
    if (blit_depth || blit_stencil) {
-      pipe->bind_blend_state(pipe, ctx->blend[0]);
+      pipe->bind_blend_state(pipe, blitter_get_blend(ctx, 0));
 
       if (blit_depth && blit_stencil) {
          pipe->bind_depth_stencil_alpha_state(pipe,
@@ -1268,7 +1321,8 @@ void util_blitter_blit_generic(struct blitter_context *blitter,
       }
 
    } else {
-      pipe->bind_blend_state(pipe, ctx->blend[mask & PIPE_MASK_RGBA]);
+      pipe->bind_blend_state(pipe,
+                             blitter_get_blend(ctx, mask & PIPE_MASK_RGBA));
       pipe->bind_depth_stencil_alpha_state(pipe, ctx->dsa_keep_depth_stencil);
       ctx->bind_fs_state(pipe,
             blitter_get_fs_texfetch_col(ctx, src_target,
@@ -1490,9 +1544,9 @@ void util_blitter_clear_render_target(struct blitter_context *blitter,
    blitter_disable_render_cond(ctx);
 
    /* bind states */
-   pipe->bind_blend_state(pipe, ctx->blend[PIPE_MASK_RGBA]);
+   pipe->bind_blend_state(pipe, blitter_get_blend(ctx, PIPE_MASK_RGBA));
    pipe->bind_depth_stencil_alpha_state(pipe, ctx->dsa_keep_depth_stencil);
-   ctx->bind_fs_state(pipe, ctx->fs_write_one_cbuf);
+   ctx->bind_fs_state(pipe, blitter_get_fs_write_cbufs(ctx, FALSE));
    pipe->bind_vertex_elements_state(pipe, ctx->velem_state);
 
    /* set a framebuffer state */
@@ -1542,11 +1596,12 @@ void util_blitter_clear_depth_stencil(struct blitter_context *blitter,
    blitter_disable_render_cond(ctx);
 
    /* bind states */
-   pipe->bind_blend_state(pipe, ctx->blend[0]);
+   pipe->bind_blend_state(pipe, blitter_get_blend(ctx, 0));
    if ((clear_flags & PIPE_CLEAR_DEPTHSTENCIL) == PIPE_CLEAR_DEPTHSTENCIL) {
       sr.ref_value[0] = stencil & 0xff;
       pipe->bind_depth_stencil_alpha_state(pipe, ctx->dsa_write_depth_stencil);
       pipe->set_stencil_ref(pipe, &sr);
+      ctx->stencil_ref_changed = TRUE;
    }
    else if (clear_flags & PIPE_CLEAR_DEPTH) {
       pipe->bind_depth_stencil_alpha_state(pipe, ctx->dsa_write_depth_keep_stencil);
@@ -1555,12 +1610,13 @@ void util_blitter_clear_depth_stencil(struct blitter_context *blitter,
       sr.ref_value[0] = stencil & 0xff;
       pipe->bind_depth_stencil_alpha_state(pipe, ctx->dsa_keep_depth_write_stencil);
       pipe->set_stencil_ref(pipe, &sr);
+      ctx->stencil_ref_changed = TRUE;
    }
    else
       /* hmm that should be illegal probably, or make it a no-op somewhere */
       pipe->bind_depth_stencil_alpha_state(pipe, ctx->dsa_keep_depth_stencil);
 
-   ctx->bind_fs_state(pipe, ctx->fs_empty);
+   ctx->bind_fs_state(pipe, blitter_get_fs_empty(ctx));
    pipe->bind_vertex_elements_state(pipe, ctx->velem_state);
 
    /* set a framebuffer state */
@@ -1608,10 +1664,10 @@ void util_blitter_custom_depth_stencil(struct blitter_context *blitter,
    blitter_disable_render_cond(ctx);
 
    /* bind states */
-   pipe->bind_blend_state(pipe, cbsurf ? ctx->blend[PIPE_MASK_RGBA] :
-                                         ctx->blend[0]);
+   pipe->bind_blend_state(pipe,
+                          blitter_get_blend(ctx, cbsurf ? PIPE_MASK_RGBA : 0));
    pipe->bind_depth_stencil_alpha_state(pipe, dsa_stage);
-   ctx->bind_fs_state(pipe, ctx->fs_empty);
+   ctx->bind_fs_state(pipe, blitter_get_fs_empty(ctx));
    pipe->bind_vertex_elements_state(pipe, ctx->velem_state);
 
    /* set a framebuffer state */
@@ -1687,7 +1743,7 @@ void util_blitter_copy_buffer(struct blitter_context *blitter,
 
    pipe->set_vertex_buffers(pipe, ctx->base.vb_slot, 1, &vb);
    pipe->bind_vertex_elements_state(pipe, ctx->velem_state_readbuf[0]);
-   pipe->bind_vs_state(pipe, ctx->vs_pos_only);
+   pipe->bind_vs_state(pipe, blitter_get_vs_pos_only(ctx));
    if (ctx->has_geometry_shader)
       pipe->bind_gs_state(pipe, NULL);
    pipe->bind_rasterizer_state(pipe, ctx->rs_discard_state);
@@ -1746,7 +1802,7 @@ void util_blitter_clear_buffer(struct blitter_context *blitter,
    pipe->set_vertex_buffers(pipe, ctx->base.vb_slot, 1, &vb);
    pipe->bind_vertex_elements_state(pipe,
                                     ctx->velem_state_readbuf[num_channels-1]);
-   pipe->bind_vs_state(pipe, ctx->vs_pos_only);
+   pipe->bind_vs_state(pipe, blitter_get_vs_pos_only(ctx));
    if (ctx->has_geometry_shader)
       pipe->bind_gs_state(pipe, NULL);
    pipe->bind_rasterizer_state(pipe, ctx->rs_discard_state);
@@ -1788,7 +1844,7 @@ void util_blitter_custom_resolve_color(struct blitter_context *blitter,
    pipe->bind_blend_state(pipe, custom_blend);
    pipe->bind_depth_stencil_alpha_state(pipe, ctx->dsa_keep_depth_stencil);
    pipe->bind_vertex_elements_state(pipe, ctx->velem_state);
-   ctx->bind_fs_state(pipe, ctx->fs_write_one_cbuf);
+   ctx->bind_fs_state(pipe, blitter_get_fs_write_cbufs(ctx, FALSE));
    pipe->set_sample_mask(pipe, sample_mask);
 
    memset(&surf_tmpl, 0, sizeof(surf_tmpl));
@@ -1848,10 +1904,11 @@ void util_blitter_custom_color(struct blitter_context *blitter,
    blitter_disable_render_cond(ctx);
 
    /* bind states */
-   pipe->bind_blend_state(pipe, custom_blend ? custom_blend
-                                             : ctx->blend[PIPE_MASK_RGBA]);
+   if (!custom_blend)
+      custom_blend = blitter_get_blend(ctx, PIPE_MASK_RGBA);
+   pipe->bind_blend_state(pipe, custom_blend);
    pipe->bind_depth_stencil_alpha_state(pipe, ctx->dsa_keep_depth_stencil);
-   ctx->bind_fs_state(pipe, ctx->fs_write_one_cbuf);
+   ctx->bind_fs_state(pipe, blitter_get_fs_write_cbufs(ctx, FALSE));
    pipe->bind_vertex_elements_state(pipe, ctx->velem_state);
    pipe->set_sample_mask(pipe, (1ull << MAX2(1, dstsurf->texture->nr_samples)) - 1);
 
@@ -36,6 +36,7 @@
 
 #include "u_debug.h"
 #include "u_cpu_detect.h"
+#include "u_string.h"
 
 #if defined(PIPE_ARCH_PPC)
 #if defined(PIPE_OS_APPLE)
@@ -59,6 +60,9 @@
 
 #if defined(PIPE_OS_LINUX)
 #include <signal.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
 #endif
 
 #ifdef PIPE_OS_UNIX
@@ -211,6 +215,42 @@ cpuid(uint32_t ax, uint32_t *p)
    p[3] = 0;
 #endif
 }
+
+/**
+ * Same as cpuid(), for the leaves which take a sub-leaf index in ecx.
+ */
+static INLINE void
+cpuid_count(uint32_t ax, uint32_t cx, uint32_t *p)
+{
+#if (defined(PIPE_CC_GCC) || defined(PIPE_CC_SUNPRO)) && defined(PIPE_ARCH_X86)
+   __asm __volatile (
+     "xchgl %%ebx, %1\n\t"
+     "cpuid\n\t"
+     "xchgl %%ebx, %1"
+     : "=a" (p[0]),
+       "=S" (p[1]),
+       "=c" (p[2]),
+       "=d" (p[3])
+     : "0" (ax), "2" (cx)
+   );
+#elif (defined(PIPE_CC_GCC) || defined(PIPE_CC_SUNPRO)) && defined(PIPE_ARCH_X86_64)
+   __asm __volatile (
+     "cpuid\n\t"
+     : "=a" (p[0]),
+       "=b" (p[1]),
+       "=c" (p[2]),
+       "=d" (p[3])
+     : "0" (ax), "2" (cx)
+   );
+#elif defined(PIPE_CC_MSVC) && _MSC_VER >= 1500
+   __cpuidex(p, ax, cx);
+#else
+   p[0] = 0;
+   p[1] = 0;
+   p[2] = 0;
+   p[3] = 0;
+#endif
+}
 #endif /* X86 or X86_64 */
 
 void
@@ -293,6 +333,12 @@ util_cpu_detect(void)
             util_cpu_caps.cacheline = cacheline;
       }
 
+      if (regs[0] >= 0x00000007 && util_cpu_caps.has_avx) {
+         uint32_t regs7[4];
+         cpuid_count(0x00000007, 0x00000000, regs7);
+         util_cpu_caps.has_avx2 = (regs7[1] >> 5) & 1;
+      }
+
       if (regs[1] == 0x756e6547 && regs[2] == 0x6c65746e && regs[3] == 0x49656e69) {
          /* GenuineIntel */
          util_cpu_caps.has_intel = 1;
@@ -345,6 +391,7 @@ util_cpu_detect(void)
       debug_printf("util_cpu_caps.has_sse4_1 = %u\n", util_cpu_caps.has_sse4_1);
       debug_printf("util_cpu_caps.has_sse4_2 = %u\n", util_cpu_caps.has_sse4_2);
       debug_printf("util_cpu_caps.has_avx = %u\n", util_cpu_caps.has_avx);
+      debug_printf("util_cpu_caps.has_avx2 = %u\n", util_cpu_caps.has_avx2);
       debug_printf("util_cpu_caps.has_3dnow = %u\n", util_cpu_caps.has_3dnow);
       debug_printf("util_cpu_caps.has_3dnow_ext = %u\n", util_cpu_caps.has_3dnow_ext);
       debug_printf("util_cpu_caps.has_altivec = %u\n", util_cpu_caps.has_altivec);
@@ -353,3 +400,89 @@ util_cpu_detect(void)
 
    util_cpu_detect_initialized = TRUE;
 }
+
+
+/**
+ * Return the index of the CPU the calling thread is running on, or -1 if
+ * unknown.
+ */
+int
+util_cpu_get_current(void)
+{
+#if defined(PIPE_OS_LINUX) && defined(_GNU_SOURCE)
+   return sched_getcpu();
+#else
+   return -1;
+#endif
+}
+
+
+#if defined(PIPE_OS_LINUX)
+
+/**
+ * Whether a kernel CPU list string such as "0-7,16-23" contains cpu.
+ */
+static boolean
+cpulist_contains(const char *list, unsigned cpu)
+{
+   while (*list) {
+      char *end;
+      unsigned long first, last;
+
+      first = strtoul(list, &end, 10);
+      if (end == list)
+         return FALSE;
+      last = first;
+      list = end;
+      if (*list == '-') {
+         ++list;
+         last = strtoul(list, &end, 10);
+         if (end == list)
+            return FALSE;
+         list = end;
+      }
+      if (cpu >= first && cpu <= last)
+         return TRUE;
+      if (*list != ',')
+         break;
+      ++list;
+   }
+   return FALSE;
+}
+
+#endif /* PIPE_OS_LINUX */
+
+
+/**
+ * Return the NUMA node the given CPU belongs to, or -1 if unknown.
+ */
+int
+util_cpu_get_numa_node(unsigned cpu)
+{
+#if defined(PIPE_OS_LINUX)
+   unsigned node;
+
+   for (node = 0; node < 256; ++node) {
+      char path[64];
+      char list[1024];
+      FILE *fp;
+      boolean found;
+
+      util_snprintf(path, sizeof path,
+                    "/sys/devices/system/node/node%u/cpulist", node);
+      fp = fopen(path, "r");
+      if (!fp) {
+         /* node numbers are dense in practice */
+         break;
+      }
+      found = fgets(list, sizeof list, fp) && cpulist_contains(list, cpu);
+      fclose(fp);
+
+      if (found)
+         return node;
+   }
+#else
+   (void) cpu;
+#endif
+   return -1;
+}
@@ -64,6 +64,7 @@ struct util_cpu_caps {
    unsigned has_sse4_2:1;
    unsigned has_popcnt:1;
    unsigned has_avx:1;
+   unsigned has_avx2:1;
    unsigned has_f16c:1;
    unsigned has_3dnow:1;
    unsigned has_3dnow_ext:1;
@@ -75,6 +76,12 @@ util_cpu_caps;
 
 void util_cpu_detect(void);
 
+int
+util_cpu_get_current(void);
+
+int
+util_cpu_get_numa_node(unsigned cpu);
+
 
 #ifdef	__cplusplus
 }
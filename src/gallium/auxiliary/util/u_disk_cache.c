@@ -0,0 +1,311 @@
+/**************************************************************************
+ *
+ * Copyright 2013 The Mesa Authors
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/**
+ * @file
+ * Persistent on-disk cache of compiled shader code.
+ */
+
+
+#include "pipe/p_config.h"
+
+#include <stdio.h>
+
+#if defined(PIPE_OS_UNIX)
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#elif defined(PIPE_OS_WINDOWS)
+#include <direct.h>
+#include <process.h>
+#endif
+
+#include "os/os_thread.h"
+#include "util/u_debug.h"
+#include "util/u_hash.h"
+#include "util/u_math.h"
+#include "util/u_memory.h"
+#include "util/u_string.h"
+#include "util/u_disk_cache.h"
+
+
+#define UTIL_DISK_CACHE_MAGIC 0x4d444331 /* "MDC1" */
+
+
+struct util_disk_cache
+{
+   char *path;
+   char *id;
+   size_t id_size;
+   uint32_t id_crc;
+
+   /** Used to build unique temporary file names within the process */
+   pipe_mutex mutex;
+   unsigned serial;
+};
+
+
+/**
+ * Header preceding the identifier, key and data of every entry.
+ */
+struct util_disk_cache_header
+{
+   uint32_t magic;
+   uint32_t id_size;
+   uint32_t key_size;
+   uint32_t data_size;
+   uint32_t data_crc;
+};
+
+
+static int
+get_process_id(void)
+{
+#if defined(PIPE_OS_UNIX)
+   return (int) getpid();
+#elif defined(PIPE_OS_WINDOWS)
+   return _getpid();
+#else
+   return 0;
+#endif
+}
+
+
+static void
+make_directory(const char *path)
+{
+#if defined(PIPE_OS_UNIX)
+   mkdir(path, 0755);
+#elif defined(PIPE_OS_WINDOWS)
+   _mkdir(path);
+#else
+   (void) path;
+#endif
+}
+
+
+static boolean
+read_bytes(FILE *fp, void *dst, size_t size)
+{
+   return fread(dst, 1, size, fp) == size;
+}
+
+
+static boolean
+write_bytes(FILE *fp, const void *src, size_t size)
+{
+   return fwrite(src, 1, size, fp) == size;
+}
+
+
+struct util_disk_cache *
+util_disk_cache_create(const char *path, const char *id)
+{
+   struct util_disk_cache *cache;
+   size_t path_size;
+   FILE *fp;
+   char probe[4096];
+
+   if (!path || !*path || !id)
+      return NULL;
+
+   path_size = strlen(path) + 1;
+   if (path_size + 64 > sizeof probe)
+      return NULL;
+
+   make_directory(path);
+
+   /* Make sure we can actually create files there. */
+   util_snprintf(probe, sizeof probe, "%s/.probe.%d", path, get_process_id());
+   fp = fopen(probe, "wb");
+   if (!fp) {
+      debug_printf("%s: cache directory %s is not writable\n",
+                   __FUNCTION__, path);
+      return NULL;
+   }
+   fclose(fp);
+   remove(probe);
+
+   cache = CALLOC_STRUCT(util_disk_cache);
+   if (!cache)
+      return NULL;
+
+   cache->path = MALLOC(path_size);
+   cache->id_size = strlen(id);
+   cache->id = MALLOC(cache->id_size + 1);
+   if (!cache->path || !cache->id) {
+      FREE(cache->path);
+      FREE(cache->id);
+      FREE(cache);
+      return NULL;
+   }
+
+   memcpy(cache->path, path, path_size);
+   memcpy(cache->id, id, cache->id_size + 1);
+   cache->id_crc = util_hash_crc32(cache->id, cache->id_size);
+   pipe_mutex_init(cache->mutex);
+
+   return cache;
+}
+
+
+void
+util_disk_cache_destroy(struct util_disk_cache *cache)
+{
+   if (!cache)
+      return;
+
+   pipe_mutex_destroy(cache->mutex);
+   FREE(cache->path);
+   FREE(cache->id);
+   FREE(cache);
+}
+
+
+static void
+entry_filename(const struct util_disk_cache *cache,
+               const void *key, size_t key_size,
+               char *filename, size_t size)
+{
+   uint32_t key_crc = util_hash_crc32(key, key_size);
+
+   util_snprintf(filename, size, "%s/%08x-%08x-%08x",
+                 cache->path, cache->id_crc, key_crc, (unsigned) key_size);
+}
+
+
+boolean
+util_disk_cache_get(struct util_disk_cache *cache,
+                    const void *key, size_t key_size,
+                    void **data, size_t *data_size)
+{
+   struct util_disk_cache_header header;
+   char filename[4096];
+   void *buf = NULL;
+   void *tmp = NULL;
+   FILE *fp;
+
+   *data = NULL;
+   *data_size = 0;
+
+   if (!cache)
+      return FALSE;
+
+   entry_filename(cache, key, key_size, filename, sizeof filename);
+
+   fp = fopen(filename, "rb");
+   if (!fp)
+      return FALSE;
+
+   if (!read_bytes(fp, &header, sizeof header) ||
+       header.magic != UTIL_DISK_CACHE_MAGIC ||
+       header.id_size != cache->id_size ||
+       header.key_size != key_size ||
+       header.data_size == 0)
+      goto fail;
+
+   tmp = MALLOC(MAX2(header.id_size, header.key_size) + 1);
+   if (!tmp)
+      goto fail;
+
+   if (!read_bytes(fp, tmp, header.id_size) ||
+       memcmp(tmp, cache->id, header.id_size) != 0)
+      goto fail;
+
+   if (!read_bytes(fp, tmp, header.key_size) ||
+       memcmp(tmp, key, header.key_size) != 0)
+      goto fail;
+
+   buf = MALLOC(header.data_size);
+   if (!buf)
+      goto fail;
+
+   if (!read_bytes(fp, buf, header.data_size) ||
+       util_hash_crc32(buf, header.data_size) != header.data_crc)
+      goto fail;
+
+   fclose(fp);
+   FREE(tmp);
+
+   *data = buf;
+   *data_size = header.data_size;
+   return TRUE;
+
+fail:
+   fclose(fp);
+   FREE(tmp);
+   FREE(buf);
+   return FALSE;
+}
+
+
+void
+util_disk_cache_put(struct util_disk_cache *cache,
+                    const void *key, size_t key_size,
+                    const void *data, size_t data_size)
+{
+   struct util_disk_cache_header header;
+   char filename[4096];
+   char tmpname[4096 + 32];
+   unsigned serial;
+   boolean ok;
+   FILE *fp;
+
+   if (!cache || !data_size)
+      return;
+
+   entry_filename(cache, key, key_size, filename, sizeof filename);
+
+   pipe_mutex_lock(cache->mutex);
+   serial = cache->serial++;
+   pipe_mutex_unlock(cache->mutex);
+
+   util_snprintf(tmpname, sizeof tmpname, "%s.%d.%u.tmp",
+                 filename, get_process_id(), serial);
+
+   fp = fopen(tmpname, "wb");
+   if (!fp)
+      return;
+
+   header.magic = UTIL_DISK_CACHE_MAGIC;
+   header.id_size = (uint32_t) cache->id_size;
+   header.key_size = (uint32_t) key_size;
+   header.data_size = (uint32_t) data_size;
+   header.data_crc = util_hash_crc32(data, data_size);
+
+   ok = write_bytes(fp, &header, sizeof header) &&
+        write_bytes(fp, cache->id, cache->id_size) &&
+        write_bytes(fp, key, key_size) &&
+        write_bytes(fp, data, data_size);
+
+   if (fclose(fp) != 0)
+      ok = FALSE;
+
+   if (!ok || rename(tmpname, filename) != 0) {
+      remove(tmpname);
+   }
+}
@@ -0,0 +1,95 @@
+/**************************************************************************
+ *
+ * Copyright 2013 The Mesa Authors
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/**
+ * @file
+ * Persistent on-disk cache of compiled shader code.
+ *
+ * Each entry lives in its own file, named after a CRC32 of the cache
+ * identifier and of the key.  The file also stores the identifier and the
+ * key themselves, so hash collisions and stale entries from other driver
+ * versions are detected on lookup instead of being returned.
+ *
+ * Entries are written to a temporary file and renamed into place, so
+ * several processes can share the same cache directory.
+ */
+
+#ifndef U_DISK_CACHE_H_
+#define U_DISK_CACHE_H_
+
+
+#include "pipe/p_compiler.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+struct util_disk_cache;
+
+
+/**
+ * Create a cache rooted at the given directory.
+ *
+ * @param path directory holding the cache files; it is created when missing
+ * @param id string identifying the producer and its version, e.g. the
+ *        driver name and the compiler version; entries written with a
+ *        different id are never returned
+ * @return NULL if the directory is not usable
+ */
+struct util_disk_cache *
+util_disk_cache_create(const char *path, const char *id);
+
+void
+util_disk_cache_destroy(struct util_disk_cache *cache);
+
+/**
+ * Look up an entry.
+ *
+ * On success the data is returned in a newly allocated buffer, which the
+ * caller must release with FREE().
+ */
+boolean
+util_disk_cache_get(struct util_disk_cache *cache,
+                    const void *key, size_t key_size,
+                    void **data, size_t *data_size);
+
+/**
+ * Store an entry, replacing any previous entry with the same key.
+ */
+void
+util_disk_cache_put(struct util_disk_cache *cache,
+                    const void *key, size_t key_size,
+                    const void *data, size_t data_size);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* U_DISK_CACHE_H_ */
@@ -558,6 +558,66 @@ def generate_pack_kernel(format, src_channel, src_native_type):
         print '         memcpy(dst, &pixel, sizeof pixel);'
     
 
+def is_format_4x8_unorm(format):
+    '''Whether the SSSE3 kernels of u_format_sse.h handle the format.'''
+
+    if is_big_endian or format.layout != PLAIN or format.colorspace != RGB:
+        return False
+    if format.block_width != 1 or format.block_height != 1:
+        return False
+    for channel in format.channels:
+        if channel.size != 8:
+            return False
+        if channel.type != VOID and (channel.type != UNSIGNED or not channel.norm):
+            return False
+    return True
+
+
+def unpack_4x8_shuffle(format):
+    '''Byte shuffle and mask of 0xff bytes turning a pixel into RGBA.'''
+
+    shuffle = 0
+    ones = 0
+    for i in range(4):
+        swizzle = format.swizzles[i]
+        if swizzle < 4:
+            index = format.channels[swizzle].shift / 8
+        else:
+            index = 0x80
+            if swizzle == SWIZZLE_1:
+                ones |= 0xff << (8 * i)
+        shuffle |= index << (8 * i)
+    return shuffle, ones
+
+
+def pack_4x8_shuffle(format):
+    '''Byte shuffle turning an RGBA pixel into the format.'''
+
+    shuffle = 0
+    inv_swizzle = format.inv_swizzles()
+    for i in range(4):
+        channel = format.channels[i]
+        if channel.type == VOID or inv_swizzle[i] is None:
+            index = 0x80
+        else:
+            index = inv_swizzle[i]
+        shuffle |= index << channel.shift
+    return shuffle
+
+
+def generate_sse_row_start(kernel, shuffle, ones):
+    '''Emit the SSSE3 start of a row loop, leaving x at the first pixel
+    left to do.'''
+
+    print '#if defined(PIPE_ARCH_SSE)'
+    print '      if (util_cpu_caps.has_ssse3) {'
+    print '         x = %s(%s, %s, width, 0x%08x, 0x%08x);' % (kernel, 'dst_row', 'src_row', shuffle, ones)
+    print '         src += x * 4;'
+    print '         dst += x * 4;'
+    print '      }'
+    print '#endif'
+
+
 def generate_format_unpack(format, dst_channel, dst_native_type, dst_suffix):
     '''Generate the function to unpack pixels from a particular format'''
 
@@ -572,7 +632,17 @@ def generate_format_unpack(format, dst_channel, dst_native_type, dst_suffix):
         print '   for(y = 0; y < height; y += %u) {' % (format.block_height,)
         print '      %s *dst = dst_row;' % (dst_native_type)
         print '      const uint8_t *src = src_row;'
-        print '      for(x = 0; x < width; x += %u) {' % (format.block_width,)
+        if is_format_4x8_unorm(format) and dst_suffix in ('rgba_8unorm', 'rgba_float'):
+            if dst_suffix == 'rgba_8unorm':
+                kernel = 'util_format_swizzle_4x8_ssse3'
+            else:
+                kernel = 'util_format_unpack_4x8_float_ssse3'
+            shuffle, ones = unpack_4x8_shuffle(format)
+            print '      x = 0;'
+            generate_sse_row_start(kernel, shuffle, ones)
+            print '      for(; x < width; x += %u) {' % (format.block_width,)
+        else:
+            print '      for(x = 0; x < width; x += %u) {' % (format.block_width,)
         
         generate_unpack_kernel(format, dst_channel, dst_native_type)
     
@@ -601,7 +671,12 @@ def generate_format_pack(format, src_channel, src_native_type, src_suffix):
         print '   for(y = 0; y < height; y += %u) {' % (format.block_height,)
         print '      const %s *src = src_row;' % (src_native_type)
         print '      uint8_t *dst = dst_row;'
-        print '      for(x = 0; x < width; x += %u) {' % (format.block_width,)
+        if is_format_4x8_unorm(format) and src_suffix == 'rgba_8unorm':
+            print '      x = 0;'
+            generate_sse_row_start('util_format_swizzle_4x8_ssse3', pack_4x8_shuffle(format), 0)
+            print '      for(; x < width; x += %u) {' % (format.block_width,)
+        else:
+            print '      for(x = 0; x < width; x += %u) {' % (format.block_width,)
     
         generate_pack_kernel(format, src_channel, src_native_type)
             
@@ -646,6 +721,8 @@ def generate(formats):
     print '#include "u_format_srgb.h"'
     print '#include "u_format_yuv.h"'
     print '#include "u_format_zs.h"'
+    print '#include "u_format_sse.h"'
+    print '#include "u_cpu_detect.h"'
     print
 
     for format in formats:
@@ -39,6 +39,68 @@ static void u_format_signed_encode_rgtc_ubyte(int8_t *blkaddr, int8_t srccolors[
 static void u_format_signed_fetch_texel_rgtc(unsigned srcRowStride, const int8_t *pixdata,
 					       unsigned i, unsigned j, int8_t *value, unsigned comps);
 
+/*
+ * Decode all 16 texels of a single channel block at once.  The code
+ * indices are packed in the 48 bits after the two endpoints.
+ */
+void
+util_format_unsigned_decode_rgtc_block(const uint8_t *src, uint8_t texels[16])
+{
+   const int alpha0 = src[0];
+   const int alpha1 = src[1];
+   uint8_t palette[8];
+   uint64_t codes = 0;
+   int k;
+
+   palette[0] = alpha0;
+   palette[1] = alpha1;
+   if (alpha0 > alpha1) {
+      for (k = 2; k < 8; ++k)
+         palette[k] = (alpha0 * (8 - k) + alpha1 * (k - 1)) / 7;
+   }
+   else {
+      for (k = 2; k < 6; ++k)
+         palette[k] = (alpha0 * (6 - k) + alpha1 * (k - 1)) / 5;
+      palette[6] = 0;
+      palette[7] = 255;
+   }
+
+   for (k = 0; k < 6; ++k)
+      codes |= (uint64_t)src[2 + k] << (8 * k);
+
+   for (k = 0; k < 16; ++k)
+      texels[k] = palette[(codes >> (3 * k)) & 0x7];
+}
+
+void
+util_format_signed_decode_rgtc_block(const int8_t *src, int8_t texels[16])
+{
+   const int alpha0 = src[0];
+   const int alpha1 = src[1];
+   int8_t palette[8];
+   uint64_t codes = 0;
+   int k;
+
+   palette[0] = alpha0;
+   palette[1] = alpha1;
+   if (alpha0 > alpha1) {
+      for (k = 2; k < 8; ++k)
+         palette[k] = (alpha0 * (8 - k) + alpha1 * (k - 1)) / 7;
+   }
+   else {
+      for (k = 2; k < 6; ++k)
+         palette[k] = (alpha0 * (6 - k) + alpha1 * (k - 1)) / 5;
+      palette[6] = -128;
+      palette[7] = 127;
+   }
+
+   for (k = 0; k < 6; ++k)
+      codes |= (uint64_t)(uint8_t)src[2 + k] << (8 * k);
+
+   for (k = 0; k < 16; ++k)
+      texels[k] = palette[(codes >> (3 * k)) & 0x7];
+}
+
 void
 util_format_rgtc1_unorm_fetch_rgba_8unorm(uint8_t *dst, const uint8_t *src, unsigned i, unsigned j)
 {
@@ -58,10 +120,12 @@ util_format_rgtc1_unorm_unpack_rgba_8unorm(uint8_t *dst_row, unsigned dst_stride
    for(y = 0; y < height; y += bh) {
       const uint8_t *src = src_row;
       for(x = 0; x < width; x += bw) {
+         uint8_t texels_r[16];
+         util_format_unsigned_decode_rgtc_block(src, texels_r);
          for(j = 0; j < bh; ++j) {
             for(i = 0; i < bw; ++i) {
                uint8_t *dst = dst_row + (y + j)*dst_stride/sizeof(*dst_row) + (x + i)*comps;
-	       u_format_unsigned_fetch_texel_rgtc(0, src, i, j, dst, 1);
+	       dst[0] = texels_r[j*4 + i];
 	       dst[1] = 0;
 	       dst[2] = 0;
 	       dst[3] = 255;
@@ -104,11 +168,13 @@ util_format_rgtc1_unorm_unpack_rgba_float(float *dst_row, unsigned dst_stride, c
    for(y = 0; y < height; y += 4) {
       const uint8_t *src = src_row;
       for(x = 0; x < width; x += 4) {
+         uint8_t texels_r[16];
+         util_format_unsigned_decode_rgtc_block(src, texels_r);
          for(j = 0; j < 4; ++j) {
             for(i = 0; i < 4; ++i) {
                float *dst = dst_row + (y + j)*dst_stride/sizeof(*dst_row) + (x + i)*4;
                uint8_t tmp_r;
-               u_format_unsigned_fetch_texel_rgtc(0, src, i, j, &tmp_r, 1);
+               tmp_r = texels_r[j*4 + i];
                dst[0] = ubyte_to_float(tmp_r);
                dst[1] = 0.0;
                dst[2] = 0.0;
@@ -202,11 +268,13 @@ util_format_rgtc1_snorm_unpack_rgba_float(float *dst_row, unsigned dst_stride, c
    for(y = 0; y < height; y += 4) {
       const int8_t *src = (int8_t *)src_row;
       for(x = 0; x < width; x += 4) {
+         int8_t texels_r[16];
+         util_format_signed_decode_rgtc_block(src, texels_r);
          for(j = 0; j < 4; ++j) {
             for(i = 0; i < 4; ++i) {
                float *dst = dst_row + (y + j)*dst_stride/sizeof(*dst_row) + (x + i)*4;
                int8_t tmp_r;
-               u_format_signed_fetch_texel_rgtc(0, src, i, j, &tmp_r, 1);
+               tmp_r = texels_r[j*4 + i];
                dst[0] = byte_to_float_tex(tmp_r);
                dst[1] = 0.0;
                dst[2] = 0.0;
@@ -250,11 +318,15 @@ util_format_rgtc2_unorm_unpack_rgba_8unorm(uint8_t *dst_row, unsigned dst_stride
    for(y = 0; y < height; y += bh) {
       const uint8_t *src = src_row;
       for(x = 0; x < width; x += bw) {
+         uint8_t texels_r[16];
+         uint8_t texels_g[16];
+         util_format_unsigned_decode_rgtc_block(src, texels_r);
+         util_format_unsigned_decode_rgtc_block(src + 8, texels_g);
          for(j = 0; j < bh; ++j) {
             for(i = 0; i < bw; ++i) {
                uint8_t *dst = dst_row + (y + j)*dst_stride/sizeof(*dst_row) + (x + i)*comps;
-	       u_format_unsigned_fetch_texel_rgtc(0, src, i, j, dst, 2);
-	       u_format_unsigned_fetch_texel_rgtc(0, src + 8, i, j, dst + 1, 2);
+	       dst[0] = texels_r[j*4 + i];
+	       dst[1] = texels_g[j*4 + i];
 	       dst[2] = 0;
 	       dst[3] = 255;
 	    }
@@ -329,12 +401,16 @@ util_format_rgtc2_unorm_unpack_rgba_float(float *dst_row, unsigned dst_stride, c
    for(y = 0; y < height; y += 4) {
       const uint8_t *src = src_row;
       for(x = 0; x < width; x += 4) {
+         uint8_t texels_r[16];
+         uint8_t texels_g[16];
+         util_format_unsigned_decode_rgtc_block(src, texels_r);
+         util_format_unsigned_decode_rgtc_block(src + 8, texels_g);
          for(j = 0; j < 4; ++j) {
             for(i = 0; i < 4; ++i) {
                float *dst = dst_row + (y + j)*dst_stride/sizeof(*dst_row) + (x + i)*4;
                uint8_t tmp_r, tmp_g;
-               u_format_unsigned_fetch_texel_rgtc(0, src, i, j, &tmp_r, 2);
-               u_format_unsigned_fetch_texel_rgtc(0, src + 8, i, j, &tmp_g, 2);
+               tmp_r = texels_r[j*4 + i];
+               tmp_g = texels_g[j*4 + i];
                dst[0] = ubyte_to_float(tmp_r);
                dst[1] = ubyte_to_float(tmp_g);
                dst[2] = 0.0;
@@ -386,12 +462,16 @@ util_format_rgtc2_snorm_unpack_rgba_float(float *dst_row, unsigned dst_stride, c
    for(y = 0; y < height; y += 4) {
       const int8_t *src = (int8_t *)src_row;
       for(x = 0; x < width; x += 4) {
+         int8_t texels_r[16];
+         int8_t texels_g[16];
+         util_format_signed_decode_rgtc_block(src, texels_r);
+         util_format_signed_decode_rgtc_block(src + 8, texels_g);
          for(j = 0; j < 4; ++j) {
             for(i = 0; i < 4; ++i) {
                float *dst = dst_row + (y + j)*dst_stride/sizeof(*dst_row) + (x + i)*4;
                int8_t tmp_r, tmp_g;
-               u_format_signed_fetch_texel_rgtc(0, src, i, j, &tmp_r, 2);
-               u_format_signed_fetch_texel_rgtc(0, src + 8, i, j, &tmp_g, 2);
+               tmp_r = texels_r[j*4 + i];
+               tmp_g = texels_g[j*4 + i];
                dst[0] = byte_to_float_tex(tmp_r);
                dst[1] = byte_to_float_tex(tmp_g);
                dst[2] = 0.0;
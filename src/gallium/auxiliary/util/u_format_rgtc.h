@@ -28,6 +28,16 @@
 #ifndef U_FORMAT_RGTC_H_
 #define U_FORMAT_RGTC_H_
 
+/*
+ * Decode a whole 4x4 block of one RGTC channel, in row-major order.
+ */
+void
+util_format_unsigned_decode_rgtc_block(const uint8_t *src, uint8_t texels[16]);
+
+void
+util_format_signed_decode_rgtc_block(const int8_t *src, int8_t texels[16]);
+
+
 void
 util_format_rgtc1_unorm_fetch_rgba_8unorm(uint8_t *dst, const uint8_t *src, unsigned i, unsigned j);
 
@@ -0,0 +1,136 @@
+/**************************************************************************
+ *
+ * Copyright 2013 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDERS, AUTHORS AND/OR ITS SUPPLIERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ **************************************************************************/
+
+/**
+ * @file
+ * SSSE3 row kernels for the generated pack/unpack functions.
+ *
+ * They handle formats made of four 8 bit unorm channels (RGBA8 and its
+ * swizzled variants), four pixels at a time, with a single PSHUFB doing the
+ * swizzle.  Each takes the per-pixel byte shuffle and the mask of bytes to
+ * force to 0xff packed in 32 bit integers, one byte per channel, and returns
+ * the number of pixels done; the caller handles the rest of the row.
+ *
+ * u_format_pack.py only emits calls to them after checking
+ * util_cpu_caps.has_ssse3.
+ */
+
+#ifndef U_FORMAT_SSE_H_
+#define U_FORMAT_SSE_H_
+
+
+#include "pipe/p_config.h"
+
+#if defined(PIPE_ARCH_SSE)
+
+#include "pipe/p_compiler.h"
+#include "u_sse.h"
+
+
+/**
+ * Expand a per-pixel byte pattern to a four pixels one.  Shuffle indices
+ * with the top bit set (zero) stay that way.
+ */
+static INLINE __m128i
+util_format_shuffle_4x8(uint32_t pattern)
+{
+   return _mm_add_epi8(_mm_set1_epi32(pattern),
+                       _mm_set_epi32(0x0c0c0c0c, 0x08080808,
+                                     0x04040404, 0x00000000));
+}
+
+
+/**
+ * Swizzle a row of 4x8 unorm pixels to another 4x8 unorm layout.
+ */
+static INLINE unsigned
+util_format_swizzle_4x8_ssse3(uint8_t *dst, const uint8_t *src,
+                              unsigned width,
+                              uint32_t shuffle, uint32_t ones)
+{
+   const __m128i mask = util_format_shuffle_4x8(shuffle);
+   const __m128i one = _mm_set1_epi32(ones);
+   unsigned x;
+
+   for (x = 0; x + 4 <= width; x += 4) {
+      __m128i pixels = _mm_loadu_si128((const __m128i *)(src + 4*x));
+      pixels = _mm_or_si128(_mm_shuffle_epi8(pixels, mask), one);
+      _mm_storeu_si128((__m128i *)(dst + 4*x), pixels);
+   }
+
+   return x;
+}
+
+
+/**
+ * Swizzle a row of 4x8 unorm pixels to RGBA and convert to float, like
+ * ubyte_to_float() does.  Channels in "ones" become exactly 1.0f.
+ */
+static INLINE unsigned
+util_format_unpack_4x8_float_ssse3(float *dst, const uint8_t *src,
+                                   unsigned width,
+                                   uint32_t shuffle, uint32_t ones)
+{
+   const __m128i mask = util_format_shuffle_4x8(shuffle);
+   const __m128i zero = _mm_setzero_si128();
+   const __m128 scale = _mm_set1_ps(1.0f / 255.0f);
+   const __m128i ones_8 = _mm_cvtsi32_si128(ones);
+   const __m128i ones_16 = _mm_unpacklo_epi8(ones_8, ones_8);
+   const __m128 one_mask =
+      _mm_castsi128_ps(_mm_unpacklo_epi16(ones_16, ones_16));
+   const __m128 one = _mm_and_ps(one_mask, _mm_set1_ps(1.0f));
+   unsigned x;
+
+   for (x = 0; x + 4 <= width; x += 4) {
+      __m128i pixels = _mm_loadu_si128((const __m128i *)(src + 4*x));
+      __m128i lo, hi;
+      __m128 rgba[4];
+      unsigned i;
+
+      pixels = _mm_shuffle_epi8(pixels, mask);
+      lo = _mm_unpacklo_epi8(pixels, zero);
+      hi = _mm_unpackhi_epi8(pixels, zero);
+
+      rgba[0] = _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero));
+      rgba[1] = _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero));
+      rgba[2] = _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero));
+      rgba[3] = _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero));
+
+      for (i = 0; i < 4; i++) {
+         __m128 value = _mm_mul_ps(rgba[i], scale);
+         value = _mm_or_ps(_mm_andnot_ps(one_mask, value), one);
+         _mm_storeu_ps(dst + 4*(x + i), value);
+      }
+   }
+
+   return x;
+}
+
+
+#endif /* PIPE_ARCH_SSE */
+
+#endif /* U_FORMAT_SSE_H_ */
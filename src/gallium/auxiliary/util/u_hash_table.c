@@ -111,7 +111,7 @@ util_hash_table_find_iter(struct util_hash_table *ht,
       item = (struct util_hash_table_item *)cso_hash_iter_data(iter);
       if (!ht->compare(item->key, key))
          break;
-      iter = cso_hash_iter_next(iter);
+      iter = cso_hash_find_next(iter);
    }
    
    return iter;
@@ -131,7 +131,7 @@ util_hash_table_find_item(struct util_hash_table *ht,
       item = (struct util_hash_table_item *)cso_hash_iter_data(iter);
       if (!ht->compare(item->key, key))
          return item;
-      iter = cso_hash_iter_next(iter);
+      iter = cso_hash_find_next(iter);
    }
    
    return NULL;
@@ -63,6 +63,9 @@ extern "C" {
 #define align_malloc(_size, _alignment) os_malloc_aligned(_size, _alignment)
 #define align_free(_ptr) os_free_aligned(_ptr)
 
+#define large_malloc(_size, _alignment) os_malloc_large(_size, _alignment)
+#define large_free(_ptr, _size) os_free_large(_ptr, _size)
+
 
 /**
  * Duplicate a block of memory.
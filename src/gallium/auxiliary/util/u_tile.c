@@ -353,6 +353,32 @@ x32_s8_get_tile_rgba(const unsigned *src,
    }
 }
 
+/**
+ * Whether pipe_tile_raw_to_rgba() has its own conversion for the format,
+ * rather than going through util_format_read_4f().
+ */
+static boolean
+tile_has_zs_rgba_conversion(enum pipe_format format)
+{
+   switch (format) {
+   case PIPE_FORMAT_Z16_UNORM:
+   case PIPE_FORMAT_Z32_UNORM:
+   case PIPE_FORMAT_Z24_UNORM_S8_UINT:
+   case PIPE_FORMAT_Z24X8_UNORM:
+   case PIPE_FORMAT_S8_UINT:
+   case PIPE_FORMAT_X24S8_UINT:
+   case PIPE_FORMAT_S8_UINT_Z24_UNORM:
+   case PIPE_FORMAT_X8Z24_UNORM:
+   case PIPE_FORMAT_S8X24_UINT:
+   case PIPE_FORMAT_Z32_FLOAT:
+   case PIPE_FORMAT_Z32_FLOAT_S8X24_UINT:
+   case PIPE_FORMAT_X32_S8X24_UINT:
+      return TRUE;
+   default:
+      return FALSE;
+   }
+}
+
 void
 pipe_tile_raw_to_rgba(enum pipe_format format,
                       const void *src,
@@ -448,13 +474,22 @@ pipe_get_tile_rgba_format(struct pipe_transfer *pt,
       return;
    }
 
-   packed = MALLOC(util_format_get_nblocks(format, w, h) * util_format_get_blocksize(format));
-   if (!packed) {
+   if (format == PIPE_FORMAT_UYVY || format == PIPE_FORMAT_YUYV) {
+      assert((x & 1) == 0);
+   }
+
+   /* Formats without a special case convert straight from the mapping. */
+   if (!tile_has_zs_rgba_conversion(format)) {
+      util_format_read_4f(format,
+                          p, dst_stride * sizeof(float),
+                          src, pt->stride,
+                          x, y, w, h);
       return;
    }
 
-   if (format == PIPE_FORMAT_UYVY || format == PIPE_FORMAT_YUYV) {
-      assert((x & 1) == 0);
+   packed = MALLOC(util_format_get_nblocks(format, w, h) * util_format_get_blocksize(format));
+   if (!packed) {
+      return;
    }
 
    pipe_get_tile_raw(pt, src, x, y, w, h, packed, 0);
@@ -483,47 +518,27 @@ pipe_put_tile_rgba_format(struct pipe_transfer *pt,
                           const float *p)
 {
    unsigned src_stride = w * 4;
-   void *packed;
 
    if (u_clip_tile(x, y, &w, &h, &pt->box))
       return;
 
-   packed = MALLOC(util_format_get_nblocks(format, w, h) * util_format_get_blocksize(format));
-
-   if (!packed)
-      return;
-
    switch (format) {
    case PIPE_FORMAT_Z16_UNORM:
-      /*z16_put_tile_rgba((ushort *) packed, w, h, p, src_stride);*/
-      break;
    case PIPE_FORMAT_Z32_UNORM:
-      /*z32_put_tile_rgba((unsigned *) packed, w, h, p, src_stride);*/
-      break;
    case PIPE_FORMAT_Z24_UNORM_S8_UINT:
    case PIPE_FORMAT_Z24X8_UNORM:
-      /*s8z24_put_tile_rgba((unsigned *) packed, w, h, p, src_stride);*/
-      break;
    case PIPE_FORMAT_S8_UINT_Z24_UNORM:
    case PIPE_FORMAT_X8Z24_UNORM:
-      /*z24s8_put_tile_rgba((unsigned *) packed, w, h, p, src_stride);*/
-      break;
    case PIPE_FORMAT_Z32_FLOAT:
-      /*z32f_put_tile_rgba((unsigned *) packed, w, h, p, src_stride);*/
-      break;
    case PIPE_FORMAT_Z32_FLOAT_S8X24_UINT:
-      /*z32f_s8x24_put_tile_rgba((unsigned *) packed, w, h, p, src_stride);*/
+      /* Depth is written through pipe_put_tile_z(). */
       break;
    default:
       util_format_write_4f(format,
                            p, src_stride * sizeof(float),
-                           packed, util_format_get_stride(format, w),
-                           0, 0, w, h);
+                           dst, pt->stride,
+                           x, y, w, h);
    }
-
-   pipe_put_tile_raw(pt, dst, x, y, w, h, packed, 0);
-
-   FREE(packed);
 }
 
 void
@@ -534,24 +549,14 @@ pipe_put_tile_i_format(struct pipe_transfer *pt,
                        const int *p)
 {
    unsigned src_stride = w * 4;
-   void *packed;
 
    if (u_clip_tile(x, y, &w, &h, &pt->box))
       return;
 
-   packed = MALLOC(util_format_get_nblocks(format, w, h) * util_format_get_blocksize(format));
-
-   if (!packed)
-      return;
-
    util_format_write_4i(format,
                         p, src_stride * sizeof(float),
-                        packed, util_format_get_stride(format, w),
-                        0, 0, w, h);
-
-   pipe_put_tile_raw(pt, dst, x, y, w, h, packed, 0);
-
-   FREE(packed);
+                        dst, pt->stride,
+                        x, y, w, h);
 }
 
 void
@@ -562,24 +567,14 @@ pipe_put_tile_ui_format(struct pipe_transfer *pt,
                         const unsigned int *p)
 {
    unsigned src_stride = w * 4;
-   void *packed;
 
    if (u_clip_tile(x, y, &w, &h, &pt->box))
       return;
 
-   packed = MALLOC(util_format_get_nblocks(format, w, h) * util_format_get_blocksize(format));
-
-   if (!packed)
-      return;
-
    util_format_write_4ui(format,
                          p, src_stride * sizeof(float),
-                         packed, util_format_get_stride(format, w),
-                         0, 0, w, h);
-
-   pipe_put_tile_raw(pt, dst, x, y, w, h, packed, 0);
-
-   FREE(packed);
+                         dst, pt->stride,
+                         x, y, w, h);
 }
 
 /**
@@ -841,26 +836,19 @@ pipe_get_tile_ui_format(struct pipe_transfer *pt,
                         unsigned int *p)
 {
    unsigned dst_stride = w * 4;
-   void *packed;
 
    if (u_clip_tile(x, y, &w, &h, &pt->box)) {
       return;
    }
 
-   packed = MALLOC(util_format_get_nblocks(format, w, h) * util_format_get_blocksize(format));
-   if (!packed) {
-      return;
-   }
-
    if (format == PIPE_FORMAT_UYVY || format == PIPE_FORMAT_YUYV) {
       assert((x & 1) == 0);
    }
 
-   pipe_get_tile_raw(pt, src, x, y, w, h, packed, 0);
-
-   pipe_tile_raw_to_unsigned(format, packed, w, h, p, dst_stride);
-
-   FREE(packed);
+   util_format_read_4ui(format,
+                        p, dst_stride * sizeof(float),
+                        src, pt->stride,
+                        x, y, w, h);
 }
 
 
@@ -872,24 +860,17 @@ pipe_get_tile_i_format(struct pipe_transfer *pt,
                        int *p)
 {
    unsigned dst_stride = w * 4;
-   void *packed;
 
    if (u_clip_tile(x, y, &w, &h, &pt->box)) {
       return;
    }
 
-   packed = MALLOC(util_format_get_nblocks(format, w, h) * util_format_get_blocksize(format));
-   if (!packed) {
-      return;
-   }
-
    if (format == PIPE_FORMAT_UYVY || format == PIPE_FORMAT_YUYV) {
       assert((x & 1) == 0);
    }
 
-   pipe_get_tile_raw(pt, src, x, y, w, h, packed, 0);
-
-   pipe_tile_raw_to_signed(format, packed, w, h, p, dst_stride);
-
-   FREE(packed);
+   util_format_read_4i(format,
+                       p, dst_stride * sizeof(float),
+                       src, pt->stride,
+                       x, y, w, h);
 }
@@ -32,6 +32,7 @@
 #include "pipe/p_defines.h"
 #include "util/u_inlines.h"
 #include "pipe/p_context.h"
+#include "pipe/p_screen.h"
 #include "util/u_memory.h"
 #include "util/u_math.h"
 
@@ -51,6 +52,24 @@ struct u_upload_mgr {
    unsigned size;   /* Actual size of the upload buffer. */
    unsigned offset; /* Aligned offset to the upload buffer, pointing
                      * at the first unused byte. */
+
+   /* Ring mode: the upload buffer is mapped once and reused in a circle.
+    * Positions below count bytes handed out since the ring was created,
+    * so that "pos - size" is the last use of the bytes at "pos".
+    */
+   boolean ring;
+   uint64_t ring_pos;       /* Position of the first unused byte. */
+   uint64_t ring_completed; /* Everything below this is idle on the GPU. */
+   struct {
+      uint64_t pos;         /* Bytes below this were flushed with fence. */
+      struct pipe_fence_handle *fence;
+   } fences[U_UPLOAD_MAX_FENCES]; /* Oldest first. */
+   unsigned num_fences;
+
+   /* Ring mode: one-off buffer for an allocation bigger than the ring,
+    * kept mapped until the next allocation. */
+   struct pipe_resource *big_buffer;
+   struct pipe_transfer *big_transfer;
 };
 
 
@@ -72,8 +91,38 @@ struct u_upload_mgr *u_upload_create( struct pipe_context *pipe,
    return upload;
 }
 
+struct u_upload_mgr *u_upload_create_ring( struct pipe_context *pipe,
+                                           unsigned size,
+                                           unsigned alignment,
+                                           unsigned bind )
+{
+   struct u_upload_mgr *upload;
+
+   assert(alignment <= 4096);
+
+   upload = u_upload_create(pipe, align(size, 4096), alignment, bind);
+   if (!upload)
+      return NULL;
+
+   upload->ring = TRUE;
+   return upload;
+}
+
+static void u_upload_release_big( struct u_upload_mgr *upload )
+{
+   if (upload->big_transfer) {
+      pipe_transfer_unmap(upload->pipe, upload->big_transfer);
+      upload->big_transfer = NULL;
+   }
+   pipe_resource_reference(&upload->big_buffer, NULL);
+}
+
 void u_upload_unmap( struct u_upload_mgr *upload )
 {
+   /* The ring stays mapped, the drivers using it don't need the unmap. */
+   if (upload->ring)
+      return;
+
    if (upload->transfer) {
       struct pipe_box *box = &upload->transfer->box;
       if ((int) upload->offset > box->x) {
@@ -98,6 +147,10 @@ void u_upload_unmap( struct u_upload_mgr *upload )
  */
 void u_upload_flush( struct u_upload_mgr *upload )
 {
+   /* The ring is recycled through fences instead. */
+   if (upload->ring)
+      return;
+
    /* Unmap and unreference the upload buffer. */
    u_upload_unmap(upload);
    pipe_resource_reference( &upload->buffer, NULL );
@@ -107,11 +160,221 @@ void u_upload_flush( struct u_upload_mgr *upload )
 
 void u_upload_destroy( struct u_upload_mgr *upload )
 {
-   u_upload_flush( upload );
+   if (upload->ring) {
+      struct pipe_screen *screen = upload->pipe->screen;
+      unsigned i;
+
+      for (i = 0; i < upload->num_fences; i++)
+         screen->fence_reference(screen, &upload->fences[i].fence, NULL);
+
+      u_upload_release_big(upload);
+
+      if (upload->transfer)
+         pipe_transfer_unmap(upload->pipe, upload->transfer);
+      pipe_resource_reference(&upload->buffer, NULL);
+   }
+   else {
+      u_upload_flush( upload );
+   }
    FREE( upload );
 }
 
 
+void u_upload_fence( struct u_upload_mgr *upload,
+                     struct pipe_fence_handle *fence )
+{
+   struct pipe_screen *screen = upload->pipe->screen;
+   unsigned last;
+
+   if (!upload->ring || !fence)
+      return;
+
+   /* Nothing new since the last fence. */
+   if (upload->ring_pos == upload->ring_completed ||
+       (upload->num_fences &&
+        upload->fences[upload->num_fences - 1].pos == upload->ring_pos))
+      return;
+
+   /* When full, let the new fence cover the newest entry's bytes too.
+    * That only makes waiting for them a bit more conservative.
+    */
+   if (upload->num_fences == U_UPLOAD_MAX_FENCES)
+      last = upload->num_fences - 1;
+   else
+      last = upload->num_fences++;
+
+   upload->fences[last].pos = upload->ring_pos;
+   screen->fence_reference(screen, &upload->fences[last].fence, fence);
+}
+
+
+/* Retire the oldest fence, waiting for it if "wait" is set.
+ * Returns FALSE if it hasn't signalled yet and "wait" is not set.
+ */
+static boolean u_upload_retire_fence( struct u_upload_mgr *upload,
+                                      boolean wait )
+{
+   struct pipe_screen *screen = upload->pipe->screen;
+   struct pipe_fence_handle *fence = upload->fences[0].fence;
+
+   if (wait)
+      screen->fence_finish(screen, fence, PIPE_TIMEOUT_INFINITE);
+   else if (!screen->fence_signalled(screen, fence))
+      return FALSE;
+
+   upload->ring_completed = upload->fences[0].pos;
+   screen->fence_reference(screen, &upload->fences[0].fence, NULL);
+   upload->num_fences--;
+   memmove(&upload->fences[0], &upload->fences[1],
+           upload->num_fences * sizeof(upload->fences[0]));
+   upload->fences[upload->num_fences].fence = NULL;
+   return TRUE;
+}
+
+
+/* Make sure the GPU is done with all bytes of the ring below "end"
+ * minus the ring size, which are about to be overwritten.
+ */
+static void u_upload_ring_wait( struct u_upload_mgr *upload,
+                                uint64_t end )
+{
+   /* Drop what has signalled already without blocking. */
+   while (upload->num_fences && u_upload_retire_fence(upload, FALSE))
+      ;
+
+   while (end > upload->ring_completed + upload->size) {
+      if (!upload->num_fences) {
+         /* The ring wrapped within a single command stream.  Submit it to
+          * get a fence covering the bytes we need back.
+          */
+         struct pipe_screen *screen = upload->pipe->screen;
+         struct pipe_fence_handle *fence = NULL;
+
+         upload->pipe->flush(upload->pipe, &fence, 0);
+         u_upload_fence(upload, fence);
+         screen->fence_reference(screen, &fence, NULL);
+
+         assert(upload->num_fences);
+         if (!upload->num_fences)
+            return;
+      }
+      u_upload_retire_fence(upload, TRUE);
+   }
+}
+
+
+static enum pipe_error
+u_upload_ring_alloc_buffer( struct u_upload_mgr *upload )
+{
+   upload->buffer = pipe_buffer_create( upload->pipe->screen,
+                                        upload->bind,
+                                        PIPE_USAGE_STREAM,
+                                        upload->default_size );
+   if (upload->buffer == NULL)
+      return PIPE_ERROR_OUT_OF_MEMORY;
+
+   /* Mapped for the lifetime of the ring; the fences do the syncing. */
+   upload->map = pipe_buffer_map_range(upload->pipe, upload->buffer,
+                                       0, upload->default_size,
+                                       PIPE_TRANSFER_WRITE |
+                                       PIPE_TRANSFER_UNSYNCHRONIZED,
+                                       &upload->transfer);
+   if (upload->map == NULL) {
+      upload->transfer = NULL;
+      pipe_resource_reference(&upload->buffer, NULL);
+      return PIPE_ERROR_OUT_OF_MEMORY;
+   }
+
+   upload->size = upload->default_size;
+   upload->offset = 0;
+   return PIPE_OK;
+}
+
+
+/* An allocation that doesn't fit the ring gets a buffer of its own.
+ */
+static enum pipe_error
+u_upload_ring_alloc_big( struct u_upload_mgr *upload,
+                         unsigned min_size,
+                         struct pipe_resource **outbuf,
+                         void **ptr )
+{
+   upload->big_buffer = pipe_buffer_create( upload->pipe->screen,
+                                            upload->bind,
+                                            PIPE_USAGE_STREAM,
+                                            align(min_size, 4096) );
+   if (upload->big_buffer == NULL)
+      return PIPE_ERROR_OUT_OF_MEMORY;
+
+   *ptr = pipe_buffer_map_range(upload->pipe, upload->big_buffer,
+                                0, min_size, PIPE_TRANSFER_WRITE,
+                                &upload->big_transfer);
+   if (*ptr == NULL) {
+      upload->big_transfer = NULL;
+      pipe_resource_reference(&upload->big_buffer, NULL);
+      return PIPE_ERROR_OUT_OF_MEMORY;
+   }
+
+   pipe_resource_reference(outbuf, upload->big_buffer);
+   return PIPE_OK;
+}
+
+
+static enum pipe_error
+u_upload_ring_alloc( struct u_upload_mgr *upload,
+                     unsigned alloc_offset,
+                     unsigned alloc_size,
+                     unsigned *out_offset,
+                     struct pipe_resource **outbuf,
+                     void **ptr )
+{
+   uint64_t pos;
+   unsigned offset;
+
+   u_upload_release_big(upload);
+
+   if (!upload->buffer) {
+      enum pipe_error ret = u_upload_ring_alloc_buffer(upload);
+      if (ret != PIPE_OK)
+         return ret;
+   }
+
+   if (alloc_offset + alloc_size > upload->size) {
+      enum pipe_error ret = u_upload_ring_alloc_big(upload,
+                                                    alloc_offset + alloc_size,
+                                                    outbuf, ptr);
+      if (ret != PIPE_OK)
+         return ret;
+
+      *ptr = (uint8_t *)*ptr + alloc_offset;
+      *out_offset = alloc_offset;
+      return PIPE_OK;
+   }
+
+   /* Skip to the requested offset, or to the start of the next lap if the
+    * allocation doesn't fit before the end of the ring.
+    */
+   pos = upload->ring_pos;
+   offset = MAX2(upload->offset, alloc_offset);
+   if (offset + alloc_size > upload->size) {
+      pos += upload->size - upload->offset;
+      offset = alloc_offset;
+   }
+   pos += offset - (unsigned)(pos % upload->size);
+
+   u_upload_ring_wait(upload, pos + alloc_size);
+
+   /* Emit the return values: */
+   *ptr = upload->map + offset;
+   pipe_resource_reference(outbuf, upload->buffer);
+   *out_offset = offset;
+
+   upload->ring_pos = pos + alloc_size;
+   upload->offset = (offset + alloc_size) % upload->size;
+   return PIPE_OK;
+}
+
+
 static enum pipe_error 
 u_upload_alloc_buffer( struct u_upload_mgr *upload,
                        unsigned min_size )
@@ -170,6 +433,10 @@ enum pipe_error u_upload_alloc( struct u_upload_mgr *upload,
    pipe_resource_reference(outbuf, NULL);
    *ptr = NULL;
 
+   if (upload->ring)
+      return u_upload_ring_alloc(upload, alloc_offset, alloc_size,
+                                 out_offset, outbuf, ptr);
+
    /* Make sure we have enough space in the upload buffer
     * for the sub-allocation. */
    if (MAX2(upload->offset, alloc_offset) + alloc_size > upload->size) {
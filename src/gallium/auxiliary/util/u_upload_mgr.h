@@ -36,6 +36,10 @@
 
 struct pipe_context;
 struct pipe_resource;
+struct pipe_fence_handle;
+
+/** Number of flush fences a ring upload manager keeps track of. */
+#define U_UPLOAD_MAX_FENCES 16
 
 
 /**
@@ -51,6 +55,37 @@ struct u_upload_mgr *u_upload_create( struct pipe_context *pipe,
                                       unsigned alignment,
                                       unsigned bind );
 
+/**
+ * Create an upload manager suballocating from a single buffer used as a
+ * ring.
+ *
+ * The buffer stays mapped unsynchronized for the manager's lifetime and
+ * allocations are a pointer bump.  Before wrapping onto bytes the GPU may
+ * still read, the manager waits for the fences passed to u_upload_fence(),
+ * flushing the context itself if none covers them.  u_upload_unmap() and
+ * u_upload_flush() do nothing for it.
+ *
+ * Only for drivers whose buffer mappings stay valid and coherent while the
+ * buffer is referenced by submitted command streams.
+ *
+ * \param pipe          Pipe driver.
+ * \param size          Size of the ring, in bytes.
+ * \param alignment     Alignment of each suballocation in the ring.
+ * \param bind          Bitmask of PIPE_BIND_* flags.
+ */
+struct u_upload_mgr *u_upload_create_ring( struct pipe_context *pipe,
+                                           unsigned size,
+                                           unsigned alignment,
+                                           unsigned bind );
+
+/**
+ * Tell a ring upload manager that everything allocated so far has been
+ * submitted and will be idle once \p fence signals.  Does nothing for
+ * other upload managers.
+ */
+void u_upload_fence( struct u_upload_mgr *upload,
+                     struct pipe_fence_handle *fence );
+
 /**
  * Destroy the upload manager.
  */
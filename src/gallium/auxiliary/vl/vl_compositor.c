@@ -708,10 +708,22 @@ gen_vertex_data(struct vl_compositor *c, struct vl_compositor_state *s, struct u
    pipe_buffer_unmap(c->pipe, buf_transfer);
 }
 
+static INLINE bool
+same_layer_state(struct vl_compositor_layer *a, void *blend_a,
+                 struct vl_compositor_layer *b, void *blend_b)
+{
+   return blend_a == blend_b && a->fs == b->fs &&
+          !memcmp(a->samplers, b->samplers, sizeof(a->samplers)) &&
+          !memcmp(a->sampler_views, b->sampler_views, sizeof(a->sampler_views)) &&
+          !memcmp(&a->viewport, &b->viewport, sizeof(a->viewport));
+}
+
 static void
 draw_layers(struct vl_compositor *c, struct vl_compositor_state *s, struct u_rect *dirty)
 {
-   unsigned vb_index, i;
+   struct vl_compositor_layer *prev = NULL;
+   void *prev_blend = NULL;
+   unsigned vb_index, vb_start = 0, i;
 
    assert(c);
 
@@ -722,12 +734,24 @@ draw_layers(struct vl_compositor *c, struct vl_compositor_state *s, struct u_rec
          unsigned num_sampler_views = !samplers[1] ? 1 : !samplers[2] ? 2 : 3;
          void *blend = layer->blend ? layer->blend : i ? c->blend_add : c->blend_clear;
 
-         c->pipe->bind_blend_state(c->pipe, blend);
-         c->pipe->set_viewport_states(c->pipe, 0, 1, &layer->viewport);
-         c->pipe->bind_fs_state(c->pipe, layer->fs);
-         c->pipe->bind_fragment_sampler_states(c->pipe, num_sampler_views, layer->samplers);
-         c->pipe->set_fragment_sampler_views(c->pipe, num_sampler_views, samplers);
-         util_draw_arrays(c->pipe, PIPE_PRIM_QUADS, vb_index * 4, 4);
+         // Layers sharing all their state are drawn with a single draw call
+         if (!prev || !same_layer_state(prev, prev_blend, layer, blend)) {
+            if (prev)
+               util_draw_arrays(c->pipe, PIPE_PRIM_QUADS, vb_start * 4, (vb_index - vb_start) * 4);
+            vb_start = vb_index;
+
+            if (!prev || blend != prev_blend)
+               c->pipe->bind_blend_state(c->pipe, blend);
+            if (!prev || memcmp(&layer->viewport, &prev->viewport, sizeof(layer->viewport)))
+               c->pipe->set_viewport_states(c->pipe, 0, 1, &layer->viewport);
+            if (!prev || layer->fs != prev->fs)
+               c->pipe->bind_fs_state(c->pipe, layer->fs);
+            c->pipe->bind_fragment_sampler_states(c->pipe, num_sampler_views, layer->samplers);
+            c->pipe->set_fragment_sampler_views(c->pipe, num_sampler_views, samplers);
+
+            prev = layer;
+            prev_blend = blend;
+         }
          vb_index++;
 
          if (dirty) {
@@ -740,6 +764,9 @@ draw_layers(struct vl_compositor *c, struct vl_compositor_state *s, struct u_rec
          }
       }
    }
+
+   if (prev)
+      util_draw_arrays(c->pipe, PIPE_PRIM_QUADS, vb_start * 4, (vb_index - vb_start) * 4);
 }
 
 void
@@ -32,6 +32,8 @@
 #ifndef vl_vlc_h
 #define vl_vlc_h
 
+#include <string.h>
+
 #include "pipe/p_compiler.h"
 
 #include "util/u_math.h"
@@ -85,6 +87,20 @@ vl_vlc_init_table(struct vl_vlc_entry *dst, unsigned dst_size, const struct vl_v
    }
 }
 
+/**
+ * align the data pointer to the next dword boundary
+ */
+static INLINE void
+vl_vlc_align_data_ptr(struct vl_vlc *vlc)
+{
+   /* read in single bytes until the pointer is dword aligned */
+   while (vlc->data != vlc->end && pointer_to_uintptr(vlc->data) & 3) {
+      vlc->buffer |= (uint64_t)*vlc->data << (24 + vlc->invalid_bits);
+      ++vlc->data;
+      vlc->invalid_bits -= 8;
+   }
+}
+
 /**
  * switch over to next input buffer
  */
@@ -99,15 +115,9 @@ vl_vlc_next_input(struct vl_vlc *vlc)
 
    vlc->bytes_left -= len;
 
-   /* align the data pointer */
-   while (len && pointer_to_uintptr(data) & 3) {
-      vlc->buffer |= (uint64_t)*data << (24 + vlc->invalid_bits);
-      ++data;
-      --len;
-      vlc->invalid_bits -= 8;
-   }
    vlc->data = data;
    vlc->end = data + len;
+   vl_vlc_align_data_ptr(vlc);
 
    --vlc->num_inputs;
    ++vlc->inputs;
@@ -274,4 +284,61 @@ vl_vlc_get_vlclbf(struct vl_vlc *vlc, const struct vl_vlc_entry *tbl, unsigned n
    return tbl->value;
 }
 
+/**
+ * fast forward until the next byte is equal to value,
+ * the bit buffer must be byte aligned
+ */
+static INLINE boolean
+vl_vlc_search_byte(struct vl_vlc *vlc, uint8_t value)
+{
+   assert((vl_vlc_valid_bits(vlc) % 8) == 0);
+
+   /* deplete the bit buffer */
+   while (vl_vlc_valid_bits(vlc) > 0) {
+      if (vl_vlc_peekbits(vlc, 8) == value) {
+         vl_vlc_fillbits(vlc);
+         return TRUE;
+      }
+
+      vl_vlc_eatbits(vlc, 8);
+   }
+
+   /* now scan the input buffers directly, without going through the bit buffer */
+   vlc->buffer = 0;
+   vlc->invalid_bits = 32;
+   while (1) {
+      const uint8_t *found;
+
+      /* if this input is depleted */
+      if (vlc->data == vlc->end) {
+         if (!vlc->num_inputs)
+            /* give up since we don't have anymore inputs */
+            return FALSE;
+
+         /* go on to next input, bytes skipped for alignment are checked above */
+         vl_vlc_next_input(vlc);
+         while (vl_vlc_valid_bits(vlc) > 0) {
+            if (vl_vlc_peekbits(vlc, 8) == value) {
+               vl_vlc_fillbits(vlc);
+               return TRUE;
+            }
+            vl_vlc_eatbits(vlc, 8);
+         }
+         vlc->buffer = 0;
+         vlc->invalid_bits = 32;
+         continue;
+      }
+
+      found = memchr(vlc->data, value, vlc->end - vlc->data);
+      if (found) {
+         vlc->data = found;
+         vl_vlc_align_data_ptr(vlc);
+         vl_vlc_fillbits(vlc);
+         return TRUE;
+      }
+
+      vlc->data = vlc->end;
+   }
+}
+
 #endif /* vl_vlc_h */
@@ -39,6 +39,9 @@
 
 struct fd_vertex_stateobj;
 
+/* max # of distinct draw scissors tracked per batch for tile skipping: */
+#define FD_MAX_DRAW_SCISSORS 16
+
 struct fd_texture_stateobj {
 	struct pipe_sampler_view *textures[PIPE_MAX_SAMPLERS];
 	unsigned num_textures;
@@ -151,6 +154,14 @@ struct fd_context {
 	 */
 	struct pipe_scissor_state max_scissor;
 
+	/* The distinct scissors of the draws within a batch.  Used at the
+	 * tile rendering step to skip tiles which no draw touches.  If there
+	 * are more than FD_MAX_DRAW_SCISSORS, num_draw_scissors is set past
+	 * the end and every tile is rendered.
+	 */
+	struct pipe_scissor_state draw_scissors[FD_MAX_DRAW_SCISSORS];
+	unsigned num_draw_scissors;
+
 	/* Current gmem/tiling configuration.. gets updated on render_tiles()
 	 * if out of date with current maximal-scissor/cpp:
 	 */
@@ -232,6 +243,29 @@ fd_context_get_scissor(struct fd_context *ctx)
 	return &ctx->disabled_scissor;
 }
 
+/* track the scissor of the draws emitted after a scissor state change: */
+static INLINE void
+fd_context_track_scissor(struct fd_context *ctx,
+		const struct pipe_scissor_state *scissor)
+{
+	unsigned n = ctx->num_draw_scissors;
+
+	ctx->max_scissor.minx = MIN2(ctx->max_scissor.minx, scissor->minx);
+	ctx->max_scissor.miny = MIN2(ctx->max_scissor.miny, scissor->miny);
+	ctx->max_scissor.maxx = MAX2(ctx->max_scissor.maxx, scissor->maxx);
+	ctx->max_scissor.maxy = MAX2(ctx->max_scissor.maxy, scissor->maxy);
+
+	if (n > FD_MAX_DRAW_SCISSORS)
+		return;
+
+	if (n && !memcmp(&ctx->draw_scissors[n - 1], scissor, sizeof(*scissor)))
+		return;
+
+	if (n < FD_MAX_DRAW_SCISSORS)
+		ctx->draw_scissors[n] = *scissor;
+	ctx->num_draw_scissors = n + 1;
+}
+
 struct pipe_context * fd_context_init(struct fd_context *ctx,
 		struct pipe_screen *pscreen, void *priv);
 
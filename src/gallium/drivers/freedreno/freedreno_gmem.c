@@ -128,6 +128,27 @@ calculate_tiles(struct fd_context *ctx)
 	gmem->height = height;
 }
 
+/* does any draw within the batch touch the tile? */
+static bool
+tile_touched(struct fd_context *ctx, uint32_t xoff, uint32_t yoff,
+		uint32_t bin_w, uint32_t bin_h)
+{
+	unsigned i;
+
+	if (ctx->num_draw_scissors > FD_MAX_DRAW_SCISSORS)
+		return true;
+
+	for (i = 0; i < ctx->num_draw_scissors; i++) {
+		struct pipe_scissor_state *scissor = &ctx->draw_scissors[i];
+
+		if ((scissor->minx < (xoff + bin_w)) && (scissor->maxx > xoff) &&
+				(scissor->miny < (yoff + bin_h)) && (scissor->maxy > yoff))
+			return true;
+	}
+
+	return false;
+}
+
 static void
 render_tiles(struct fd_context *ctx)
 {
@@ -151,6 +172,16 @@ render_tiles(struct fd_context *ctx)
 			/* clip bin width: */
 			bw = MIN2(bw, gmem->width - xoff);
 
+			/* nothing drawn to the tile, so gmem2mem would just write
+			 * back what mem2gmem restored:
+			 */
+			if (!tile_touched(ctx, xoff, yoff, bw, bh)) {
+				DBG("skipping bin_h=%d, yoff=%d, bin_w=%d, xoff=%d",
+						bh, yoff, bw, xoff);
+				xoff += bw;
+				continue;
+			}
+
 			DBG("bin_h=%d, yoff=%d, bin_w=%d, xoff=%d",
 					bh, yoff, bw, xoff);
 
@@ -232,6 +263,7 @@ fd_gmem_render_tiles(struct pipe_context *pctx)
 	/* reset maximal bounds: */
 	ctx->max_scissor.minx = ctx->max_scissor.miny = ~0;
 	ctx->max_scissor.maxx = ctx->max_scissor.maxy = 0;
+	ctx->num_draw_scissors = 0;
 
 	/* Note that because the per-tile setup and mem2gmem/gmem2mem are emitted
 	 * after the draw/clear calls, but executed before, we need to preemptively
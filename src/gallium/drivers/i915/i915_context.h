@@ -140,6 +140,21 @@ struct i915_fragment_shader
 
 struct i915_cache_context;
 
+#define I915_VERTEX_LAYOUT_CACHE_SIZE 8
+
+/**
+ * A hardware vertex layout and what it was computed from.  The layout only
+ * depends on the vs/fs pair, the rasterizer color interpolation and the
+ * outputs draw adds for its own stages.
+ */
+struct i915_vertex_layout {
+   const void *vs;
+   const struct i915_fragment_shader *fs;
+   enum interp_mode color_interp;
+   uint num_outputs;
+   struct vertex_info vinfo;
+};
+
 /* Use to calculate differences between state emitted to hardware and
  * current driver-calculated state.  
  */
@@ -270,6 +285,12 @@ struct i915_context {
    unsigned vbo_flushed;
 
    struct i915_state current;
+
+   /** Recently computed vertex layouts, see i915_state_derived.c */
+   struct i915_vertex_layout vertex_layouts[I915_VERTEX_LAYOUT_CACHE_SIZE];
+   unsigned num_vertex_layouts;
+   unsigned next_vertex_layout;
+
    unsigned hardware_dirty;
    unsigned immediate_dirty : I915_MAX_IMMEDIATE;
    unsigned dynamic_dirty : I915_MAX_DYNAMIC;
@@ -39,6 +39,7 @@
 
 #include "i915_context.h"
 #include "i915_reg.h"
+#include "i915_state.h"
 #include "i915_state_inlines.h"
 #include "i915_fpc.h"
 #include "i915_resource.h"
@@ -593,6 +594,8 @@ void i915_delete_fs_state(struct pipe_context *pipe, void *shader)
 {
    struct i915_fragment_shader *ifs = (struct i915_fragment_shader *) shader;
 
+   i915_evict_vertex_layouts(i915_context(pipe), shader);
+
    FREE(ifs->decl);
    ifs->decl = NULL;
 
@@ -639,6 +642,8 @@ static void i915_delete_vs_state(struct pipe_context *pipe, void *shader)
 {
    struct i915_context *i915 = i915_context(pipe);
 
+   i915_evict_vertex_layouts(i915, shader);
+
    /* just pass-through to draw module */
    draw_delete_vertex_shader(i915->draw, (struct draw_vertex_shader *) shader);
 }
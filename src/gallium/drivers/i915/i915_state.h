@@ -52,6 +52,7 @@ extern struct i915_tracked_state i915_hw_dst_buf_vars;
 extern struct i915_tracked_state i915_hw_constants;
 
 void i915_update_derived(struct i915_context *i915);
+void i915_evict_vertex_layouts(struct i915_context *i915, const void *shader);
 void i915_emit_hardware_state(struct i915_context *i915);
 
 #endif
@@ -54,7 +54,8 @@ static uint find_mapping(const struct i915_fragment_shader* fs, int unit)
  * Determine the hardware vertex layout.
  * Depends on vertex/fragment shader state.
  */
-static void calculate_vertex_layout(struct i915_context *i915)
+static void compute_vertex_layout(struct i915_context *i915,
+                                  struct vertex_info *out)
 {
    const struct i915_fragment_shader *fs = i915->fs;
    const enum interp_mode colorInterp = i915->rasterizer->color_interp;
@@ -171,14 +172,84 @@ static void calculate_vertex_layout(struct i915_context *i915)
 
    draw_compute_vertex_size(&vinfo);
 
-   if (memcmp(&i915->current.vertex_info, &vinfo, sizeof(vinfo))) {
+   memcpy(out, &vinfo, sizeof(vinfo));
+}
+
+/**
+ * Look up the layout of the current shader pair, computing and caching it
+ * on a miss.  State trackers and the draw stages switch between a handful
+ * of shader pairs, and the layout is otherwise recomputed on every switch.
+ */
+static const struct vertex_info *
+lookup_vertex_layout(struct i915_context *i915)
+{
+   const enum interp_mode color_interp = i915->rasterizer->color_interp;
+   const uint num_outputs = draw_num_shader_outputs(i915->draw);
+   struct i915_vertex_layout *layout;
+   unsigned i;
+
+   for (i = 0; i < i915->num_vertex_layouts; i++) {
+      layout = &i915->vertex_layouts[i];
+
+      if (layout->vs == i915->vs &&
+          layout->fs == i915->fs &&
+          layout->color_interp == color_interp &&
+          layout->num_outputs == num_outputs)
+         return &layout->vinfo;
+   }
+
+   if (i915->num_vertex_layouts < I915_VERTEX_LAYOUT_CACHE_SIZE) {
+      layout = &i915->vertex_layouts[i915->num_vertex_layouts++];
+   }
+   else {
+      layout = &i915->vertex_layouts[i915->next_vertex_layout];
+      i915->next_vertex_layout =
+         (i915->next_vertex_layout + 1) % I915_VERTEX_LAYOUT_CACHE_SIZE;
+   }
+
+   layout->vs = i915->vs;
+   layout->fs = i915->fs;
+   layout->color_interp = color_interp;
+   layout->num_outputs = num_outputs;
+   compute_vertex_layout(i915, &layout->vinfo);
+
+   return &layout->vinfo;
+}
+
+/**
+ * Drop the cached layouts of a shader that is being deleted, as its
+ * address may be reused by a new one.
+ */
+void i915_evict_vertex_layouts(struct i915_context *i915, const void *shader)
+{
+   unsigned i = 0;
+
+   while (i < i915->num_vertex_layouts) {
+      struct i915_vertex_layout *layout = &i915->vertex_layouts[i];
+
+      if (layout->vs == shader || layout->fs == shader) {
+         *layout = i915->vertex_layouts[--i915->num_vertex_layouts];
+         continue;
+      }
+
+      i++;
+   }
+
+   i915->next_vertex_layout = 0;
+}
+
+static void calculate_vertex_layout(struct i915_context *i915)
+{
+   const struct vertex_info *vinfo = lookup_vertex_layout(i915);
+
+   if (memcmp(&i915->current.vertex_info, vinfo, sizeof(*vinfo))) {
       /* Need to set this flag so that the LIS2/4 registers get set.
        * It also means the i915_update_immediate() function must be called
        * after this one, in i915_update_derived().
        */
       i915->dirty |= I915_NEW_VERTEX_FORMAT;
 
-      memcpy(&i915->current.vertex_info, &vinfo, sizeof(vinfo));
+      memcpy(&i915->current.vertex_info, vinfo, sizeof(*vinfo));
    }
 }
 
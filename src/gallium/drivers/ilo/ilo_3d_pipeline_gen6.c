@@ -807,7 +807,7 @@ gen6_pipeline_state_cc(struct ilo_3d_pipeline *p,
    /* BLEND_STATE */
    if (DIRTY(BLEND) || DIRTY(FRAMEBUFFER) || DIRTY(DEPTH_STENCIL_ALPHA)) {
       p->state.BLEND_STATE = p->gen6_BLEND_STATE(p->dev,
-            ilo->blend, &ilo->fb, &ilo->dsa->alpha, p->cp);
+            ilo->blend, &ilo->fb, ilo->dsa, p->cp);
 
       session->cc_state_blend_changed = true;
    }
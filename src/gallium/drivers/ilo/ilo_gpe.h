@@ -148,6 +148,9 @@ struct ilo_dsa_state {
    uint32_t payload[3];
 
    struct pipe_alpha_state alpha;
+
+   /* alpha test bits of BLEND_STATE */
+   uint32_t dw_alpha;
 };
 
 struct ilo_blend_cso {
@@ -245,9 +248,19 @@ struct ilo_surface_cso {
    } u;
 };
 
+struct ilo_fb_blend_caps {
+   bool can_logicop;
+   bool can_blend;
+   bool can_alpha_test;
+   bool dst_alpha_forced_one;
+};
+
 struct ilo_fb_state {
    struct pipe_framebuffer_state state;
 
+   /* what BLEND_STATE may enable for each render target */
+   struct ilo_fb_blend_caps blend_caps[ILO_MAX_DRAW_BUFFERS];
+
    struct ilo_zs_surface null_zs;
    unsigned num_samples;
 };
@@ -296,6 +309,11 @@ ilo_gpe_set_scissor(const struct ilo_dev_info *dev,
                     const struct pipe_scissor_state *states,
                     struct ilo_scissor_state *scissor);
 
+void
+ilo_gpe_set_fb(const struct ilo_dev_info *dev,
+               const struct pipe_framebuffer_state *state,
+               struct ilo_fb_state *fb);
+
 void
 ilo_gpe_set_scissor_null(const struct ilo_dev_info *dev,
                          struct ilo_scissor_state *scissor);
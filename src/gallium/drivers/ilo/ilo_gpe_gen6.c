@@ -3548,11 +3548,114 @@ ilo_gpe_init_blend(const struct ilo_dev_info *dev,
    }
 }
 
+static void
+fb_set_blend_caps(const struct ilo_dev_info *dev,
+                  enum pipe_format format,
+                  struct ilo_fb_blend_caps *caps)
+{
+   const struct util_format_description *desc =
+      util_format_description(format);
+   bool rt_is_unorm, rt_is_pure_integer;
+   int ch;
+
+   ILO_GPE_VALID_GEN(dev, 6, 7);
+
+   caps->dst_alpha_forced_one = false;
+
+   switch (format) {
+   case PIPE_FORMAT_B8G8R8X8_UNORM:
+      /* force alpha to one when the HW format has alpha */
+      assert(ilo_translate_render_format(PIPE_FORMAT_B8G8R8X8_UNORM)
+            == BRW_SURFACEFORMAT_B8G8R8A8_UNORM);
+      caps->dst_alpha_forced_one = true;
+      break;
+   default:
+      break;
+   }
+
+   rt_is_unorm = true;
+   rt_is_pure_integer = false;
+
+   for (ch = 0; ch < 4; ch++) {
+      if (desc->channel[ch].type == UTIL_FORMAT_TYPE_VOID)
+         continue;
+
+      if (desc->channel[ch].pure_integer) {
+         rt_is_unorm = false;
+         rt_is_pure_integer = true;
+         break;
+      }
+
+      if (!desc->channel[ch].normalized ||
+          desc->channel[ch].type != UTIL_FORMAT_TYPE_UNSIGNED)
+         rt_is_unorm = false;
+   }
+
+   /*
+    * From the Sandy Bridge PRM, volume 2 part 1, page 365:
+    *
+    *     "Logic Ops are only supported on *_UNORM surfaces (excluding
+    *      _SRGB variants), otherwise Logic Ops must be DISABLED."
+    *
+    * Since logicop is ignored for non-UNORM color buffers, no special care
+    * is needed.
+    */
+   caps->can_logicop = rt_is_unorm;
+
+   /*
+    * From the Sandy Bridge PRM, volume 2 part 1, page 382:
+    *
+    *     "Alpha Test can only be enabled if Pixel Shader outputs a float
+    *      alpha value."
+    */
+   caps->can_blend = !rt_is_pure_integer;
+   caps->can_alpha_test = !rt_is_pure_integer;
+}
+
+void
+ilo_gpe_set_fb(const struct ilo_dev_info *dev,
+               const struct pipe_framebuffer_state *state,
+               struct ilo_fb_state *fb)
+{
+   unsigned i;
+
+   ILO_GPE_VALID_GEN(dev, 6, 7);
+
+   /*
+    * Pre-bake the per-target format checks so that BLEND_STATE emission
+    * does not repeat them on every blend or DSA change.  Targets without a
+    * color buffer may still be referenced for the alpha test.
+    */
+   for (i = 0; i < Elements(fb->blend_caps); i++) {
+      struct ilo_fb_blend_caps *caps = &fb->blend_caps[i];
+
+      if (i < state->nr_cbufs) {
+         fb_set_blend_caps(dev, state->cbufs[i]->format, caps);
+      }
+      else {
+         caps->can_logicop = true;
+         caps->can_blend = true;
+         caps->can_alpha_test = true;
+         caps->dst_alpha_forced_one = false;
+      }
+   }
+
+   if (state->nr_cbufs)
+      fb->num_samples = state->cbufs[0]->texture->nr_samples;
+   else if (state->zsbuf)
+      fb->num_samples = state->zsbuf->texture->nr_samples;
+   else
+      fb->num_samples = 1;
+
+   if (!fb->num_samples)
+      fb->num_samples = 1;
+}
+
 static uint32_t
 gen6_emit_BLEND_STATE(const struct ilo_dev_info *dev,
                       const struct ilo_blend_state *blend,
                       const struct ilo_fb_state *fb,
-                      const struct pipe_alpha_state *alpha,
+                      const struct ilo_dsa_state *dsa,
                       struct ilo_cp *cp)
 {
    const int state_align = 64 / 4;
@@ -3571,7 +3674,7 @@ gen6_emit_BLEND_STATE(const struct ilo_dev_info *dev,
    assert(num_targets <= 8);
 
    if (!num_targets) {
-      if (!alpha->enabled)
+      if (!dsa->alpha.enabled)
          return 0;
       /* to be able to reference alpha func */
       num_targets = 1;
@@ -3585,66 +3688,19 @@ gen6_emit_BLEND_STATE(const struct ilo_dev_info *dev,
    for (i = 0; i < num_targets; i++) {
       const unsigned idx = (blend->independent_blend_enable) ? i : 0;
       const struct ilo_blend_cso *cso = &blend->cso[idx];
-      const int num_samples = fb->num_samples;
-      const struct util_format_description *format_desc =
-         (idx < fb->state.nr_cbufs) ?
-         util_format_description(fb->state.cbufs[idx]->format) : NULL;
-      bool rt_is_unorm, rt_is_pure_integer, rt_dst_alpha_forced_one;
-
-      rt_is_unorm = true;
-      rt_is_pure_integer = false;
-      rt_dst_alpha_forced_one = false;
-
-      if (format_desc) {
-         int ch;
-
-         switch (format_desc->format) {
-         case PIPE_FORMAT_B8G8R8X8_UNORM:
-            /* force alpha to one when the HW format has alpha */
-            assert(ilo_translate_render_format(PIPE_FORMAT_B8G8R8X8_UNORM)
-                  == BRW_SURFACEFORMAT_B8G8R8A8_UNORM);
-            rt_dst_alpha_forced_one = true;
-            break;
-         default:
-            break;
-         }
-
-         for (ch = 0; ch < 4; ch++) {
-            if (format_desc->channel[ch].type == UTIL_FORMAT_TYPE_VOID)
-               continue;
-
-            if (format_desc->channel[ch].pure_integer) {
-               rt_is_unorm = false;
-               rt_is_pure_integer = true;
-               break;
-            }
-
-            if (!format_desc->channel[ch].normalized ||
-                format_desc->channel[ch].type != UTIL_FORMAT_TYPE_UNSIGNED)
-               rt_is_unorm = false;
-         }
-      }
+      const struct ilo_fb_blend_caps *caps = &fb->blend_caps[idx];
 
       dw[0] = cso->payload[0];
       dw[1] = cso->payload[1];
 
-      if (!rt_is_pure_integer) {
-         if (rt_dst_alpha_forced_one)
+      if (caps->can_blend) {
+         if (caps->dst_alpha_forced_one)
             dw[0] |= cso->dw_blend_dst_alpha_forced_one;
          else
             dw[0] |= cso->dw_blend;
       }
 
-      /*
-       * From the Sandy Bridge PRM, volume 2 part 1, page 365:
-       *
-       *     "Logic Ops are only supported on *_UNORM surfaces (excluding
-       *      _SRGB variants), otherwise Logic Ops must be DISABLED."
-       *
-       * Since logicop is ignored for non-UNORM color buffers, no special care
-       * is needed.
-       */
-      if (rt_is_unorm)
+      if (caps->can_logicop)
          dw[1] |= cso->dw_logicop;
 
       /*
@@ -3656,19 +3712,11 @@ gen6_emit_BLEND_STATE(const struct ilo_dev_info *dev,
        * There is no such limitation on GEN7, or for AlphaToOne.  But GL
        * requires that anyway.
        */
-      if (num_samples > 1)
+      if (fb->num_samples > 1)
          dw[1] |= cso->dw_alpha_mod;
 
-      /*
-       * From the Sandy Bridge PRM, volume 2 part 1, page 382:
-       *
-       *     "Alpha Test can only be enabled if Pixel Shader outputs a float
-       *      alpha value."
-       */
-      if (alpha->enabled && !rt_is_pure_integer) {
-         dw[1] |= 1 << 16 |
-                  gen6_translate_dsa_func(alpha->func) << 13;
-      }
+      if (caps->can_alpha_test)
+         dw[1] |= dsa->dw_alpha;
 
       dw += 2;
    }
@@ -3691,6 +3739,14 @@ ilo_gpe_init_dsa(const struct ilo_dev_info *dev,
    /* copy alpha state for later use */
    dsa->alpha = state->alpha;
 
+   if (state->alpha.enabled) {
+      dsa->dw_alpha = 1 << 16 |
+                      gen6_translate_dsa_func(state->alpha.func) << 13;
+   }
+   else {
+      dsa->dw_alpha = 0;
+   }
+
    STATIC_ASSERT(Elements(dsa->payload) >= 3);
    dw = dsa->payload;
 
@@ -404,7 +404,7 @@ typedef uint32_t
 (*ilo_gpe_gen6_BLEND_STATE)(const struct ilo_dev_info *dev,
                             const struct ilo_blend_state *blend,
                             const struct ilo_fb_state *fb,
-                            const struct pipe_alpha_state *alpha,
+                            const struct ilo_dsa_state *dsa,
                             struct ilo_cp *cp);
 
 typedef uint32_t
@@ -634,16 +634,7 @@ ilo_set_framebuffer_state(struct pipe_context *pipe,
    struct ilo_context *ilo = ilo_context(pipe);
 
    util_copy_framebuffer_state(&ilo->fb.state, state);
-
-   if (state->nr_cbufs)
-      ilo->fb.num_samples = state->cbufs[0]->texture->nr_samples;
-   else if (state->zsbuf)
-      ilo->fb.num_samples = state->zsbuf->texture->nr_samples;
-   else
-      ilo->fb.num_samples = 1;
-
-   if (!ilo->fb.num_samples)
-      ilo->fb.num_samples = 1;
+   ilo_gpe_set_fb(ilo->dev, state, &ilo->fb);
 
    ilo->dirty |= ILO_DIRTY_FRAMEBUFFER;
 }
@@ -1233,6 +1224,7 @@ ilo_init_states(struct ilo_context *ilo)
 
    ilo_gpe_init_zs_surface(ilo->dev, NULL,
          PIPE_FORMAT_NONE, 0, 0, 1, &ilo->fb.null_zs);
+   ilo_gpe_set_fb(ilo->dev, &ilo->fb.state, &ilo->fb);
 
    ilo->dirty = ILO_DIRTY_ALL;
 }
@@ -40,8 +40,10 @@
 #include "lp_clear.h"
 #include "lp_context.h"
 #include "lp_flush.h"
+#include "lp_fs_async.h"
 #include "lp_perf.h"
 #include "lp_state.h"
+#include "lp_state_cs.h"
 #include "lp_surface.h"
 #include "lp_query.h"
 #include "lp_setup.h"
@@ -85,6 +87,8 @@ static void llvmpipe_destroy( struct pipe_context *pipe )
       pipe_sampler_view_reference(&llvmpipe->sampler_views[PIPE_SHADER_GEOMETRY][i], NULL);
    }
 
+   llvmpipe_cleanup_compute(llvmpipe);
+
    for (i = 0; i < Elements(llvmpipe->constants); i++) {
       for (j = 0; j < Elements(llvmpipe->constants[i]); j++) {
          pipe_resource_reference(&llvmpipe->constants[i][j].buffer, NULL);
@@ -95,7 +99,10 @@ static void llvmpipe_destroy( struct pipe_context *pipe )
       pipe_resource_reference(&llvmpipe->vertex_buffer[i].buffer, NULL);
    }
 
-   lp_delete_setup_variants(llvmpipe);
+   lp_release_setup_variant(llvmpipe);
+
+   if (llvmpipe->fs_async)
+      lp_fs_async_destroy(llvmpipe->fs_async);
 
    align_free( llvmpipe );
 }
@@ -137,8 +144,6 @@ llvmpipe_create_context( struct pipe_screen *screen, void *priv )
 
    make_empty_list(&llvmpipe->fs_variants_list);
 
-   make_empty_list(&llvmpipe->setup_variants_list);
-
 
    llvmpipe->pipe.screen = screen;
    llvmpipe->pipe.priv = priv;
@@ -161,6 +166,7 @@ llvmpipe_create_context( struct pipe_screen *screen, void *priv )
    llvmpipe_init_fs_funcs(llvmpipe);
    llvmpipe_init_vs_funcs(llvmpipe);
    llvmpipe_init_gs_funcs(llvmpipe);
+   llvmpipe_init_compute_funcs(llvmpipe);
    llvmpipe_init_rasterizer_funcs(llvmpipe);
    llvmpipe_init_context_resource_funcs( &llvmpipe->pipe );
    llvmpipe_init_surface_functions(llvmpipe);
@@ -179,6 +185,9 @@ llvmpipe_create_context( struct pipe_screen *screen, void *priv )
    if (!llvmpipe->setup)
       goto fail;
 
+   /* optional, compile fs variants synchronously without it */
+   llvmpipe->fs_async = lp_fs_async_create();
+
    llvmpipe->blitter = util_blitter_create(&llvmpipe->pipe);
    if (!llvmpipe->blitter) {
       goto fail;
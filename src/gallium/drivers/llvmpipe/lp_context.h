@@ -47,6 +47,8 @@ struct llvmpipe_vbuf_render;
 struct draw_context;
 struct draw_stage;
 struct lp_fragment_shader;
+struct lp_compute_shader;
+struct lp_fs_async;
 struct lp_vertex_shader;
 struct lp_blend_state;
 struct lp_setup_context;
@@ -67,6 +69,7 @@ struct llvmpipe_context {
    const struct lp_geometry_shader *gs;
    const struct lp_velems_state *velems;
    const struct lp_so_state *so;
+   struct lp_compute_shader *cs;
 
    /** Other rendering state */
    struct pipe_blend_color blend_color;
@@ -89,6 +92,10 @@ struct llvmpipe_context {
 
    unsigned num_vertex_buffers;
 
+   /** Compute state, see lp_state_cs.c */
+   struct pipe_surface *cs_resources[PIPE_MAX_SHADER_RESOURCES];
+   struct pipe_resource *global_buffers[LP_MAX_GLOBAL_BUFFERS];
+
    struct draw_so_target *so_targets[PIPE_MAX_SO_BUFFERS];
    int num_so_targets;
    struct pipe_query_data_so_statistics so_stats;
@@ -129,6 +136,9 @@ struct llvmpipe_context {
    struct lp_setup_context *setup;
    struct lp_setup_variant setup_variant;
 
+   /** The screen's setup variant in use, we hold a reference to it */
+   struct lp_setup_variant *current_setup_variant;
+
    /** The primitive drawing context */
    struct draw_context *draw;
 
@@ -140,10 +150,11 @@ struct llvmpipe_context {
    /** List of all fragment shader variants */
    struct lp_fs_variant_list_item fs_variants_list;
    unsigned nr_fs_variants;
-   unsigned nr_fs_instrs;
 
-   struct lp_setup_variant_list_item setup_variants_list;
-   unsigned nr_setup_variants;
+   /** Background fs variant compilation, NULL when disabled */
+   struct lp_fs_async *fs_async;
+   unsigned nr_fs_instrs;
+   size_t fs_code_size;
 
    /** Conditional query object and mode */
    struct pipe_query *render_cond_query;
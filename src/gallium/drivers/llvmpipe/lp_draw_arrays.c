@@ -36,6 +36,7 @@
 #include "util/u_prim.h"
 
 #include "lp_context.h"
+#include "lp_fs_async.h"
 #include "lp_state.h"
 #include "lp_query.h"
 
@@ -57,9 +58,12 @@ llvmpipe_draw_vbo(struct pipe_context *pipe, const struct pipe_draw_info *info)
    const void *mapped_indices = NULL;
    unsigned i;
 
-   if (!llvmpipe_check_render_cond(lp))
+   if (!llvmpipe_check_render_cond_binned(lp))
       return;
 
+   if (lp->fs_async)
+      lp->fs_code_size += lp_fs_async_update(lp->fs_async);
+
    if (lp->dirty)
       llvmpipe_update_derived( lp );
 
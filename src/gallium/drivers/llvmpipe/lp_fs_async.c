@@ -0,0 +1,451 @@
+/**************************************************************************
+ *
+ * Copyright 2013 The Mesa Authors
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/**
+ * Background compilation of fragment shader variants.
+ *
+ * Building a variant with all the LLVM optimizations takes long enough to
+ * cause visible hitches whenever the state changes mid-frame.  So new
+ * variants are first built with only the cheap optimizations
+ * (GALLIVM_OPT_FAST), which is several times faster, and drawn with until a
+ * pool of threads has built the fully optimized (GALLIVM_OPT_FULL) code of
+ * the same variant.  The optimized code replaces the quickly built one at
+ * the first draw after it is ready.
+ *
+ * LLVM contexts must not be used by two threads at once, so every thread
+ * compiles in its own context.  Freeing code built in a context is
+ * serialized with the thread compiling in it by the thread's
+ * context_mutex.
+ *
+ * Setting LP_ASYNC_COMPILE_THREADS=0 turns this off and makes every
+ * variant be fully optimized before it is first drawn with.
+ */
+
+
+#include "util/u_atomic.h"
+#include "util/u_cpu_detect.h"
+#include "util/u_debug.h"
+#include "util/u_math.h"
+#include "util/u_memory.h"
+#include "util/u_simple_list.h"
+#include "os/os_thread.h"
+#include "os/os_time.h"
+#include "gallivm/lp_bld_init.h"
+#include "lp_debug.h"
+#include "lp_fs_async.h"
+#include "lp_state.h"
+
+
+#define LP_MAX_ASYNC_COMPILE_THREADS 4
+
+
+enum lp_fs_async_status
+{
+   LP_FS_ASYNC_QUEUED,
+   LP_FS_ASYNC_RUNNING,
+   LP_FS_ASYNC_DONE,       /**< waiting for lp_fs_async_update() */
+   LP_FS_ASYNC_INSTALLED   /**< the variant draws with the optimized code */
+};
+
+
+struct lp_fs_async_thread
+{
+   struct lp_fs_async *async;
+   pipe_thread thread;
+   LLVMContextRef context;
+   pipe_mutex context_mutex;  /**< held while context is in use */
+};
+
+
+struct lp_fs_async_job
+{
+   struct lp_fs_async_job *next, *prev;  /**< in the queued or done list */
+
+   struct lp_fragment_shader_variant *variant;  /**< the context's variant */
+   struct lp_fragment_shader_variant *opt;      /**< its optimized build */
+   struct lp_fs_async_thread *thread;           /**< which built opt */
+   enum lp_fs_async_status status;
+
+   struct util_disk_cache *cache;
+   void *cache_key;
+   unsigned cache_key_size;
+};
+
+
+struct lp_fs_async
+{
+   pipe_mutex mutex;
+   pipe_condvar cond;  /**< a job was queued or finished, or exit was set */
+
+   struct lp_fs_async_job queued;
+   struct lp_fs_async_job done;
+   int32_t num_done;
+   boolean exit;
+
+   unsigned num_threads;
+   struct lp_fs_async_thread threads[LP_MAX_ASYNC_COMPILE_THREADS];
+};
+
+
+/*
+ * LLVM contexts are never freed (see gallivm_context in lp_bld_init.c),
+ * so keep the ones of destroyed pools for the next pools.
+ */
+pipe_static_mutex(context_pool_mutex);
+static LLVMContextRef context_pool[LP_MAX_ASYNC_COMPILE_THREADS * 4];
+static unsigned context_pool_size = 0;
+
+
+static LLVMContextRef
+get_context(void)
+{
+   LLVMContextRef context = NULL;
+
+   pipe_mutex_lock(context_pool_mutex);
+   if (context_pool_size) {
+      context = context_pool[--context_pool_size];
+   }
+   pipe_mutex_unlock(context_pool_mutex);
+
+   return context ? context : LLVMContextCreate();
+}
+
+
+static void
+put_context(LLVMContextRef context)
+{
+   pipe_mutex_lock(context_pool_mutex);
+   if (context_pool_size < Elements(context_pool)) {
+      context_pool[context_pool_size++] = context;
+   }
+   pipe_mutex_unlock(context_pool_mutex);
+}
+
+
+/**
+ * Build the optimized code.  Called with the thread's context_mutex held.
+ */
+static void
+compile_job(struct lp_fs_async_thread *thread, struct lp_fs_async_job *job)
+{
+   struct lp_fragment_shader_variant *opt = job->opt;
+   int64_t t0 = 0;
+
+   if (LP_DEBUG & DEBUG_FS) {
+      t0 = os_time_get();
+   }
+
+   /* Off the draw path, so the extra compile time of vectorization is
+    * affordable.
+    */
+   opt->gallivm = gallivm_create_in_context(thread->context, GALLIVM_OPT_FULL);
+   if (!opt->gallivm)
+      return;
+
+   if (job->cache_key) {
+      gallivm_set_disk_cache(opt->gallivm, job->cache,
+                             job->cache_key, job->cache_key_size);
+   }
+
+   llvmpipe_compile_fs_variant(opt);
+
+   if (LP_DEBUG & DEBUG_FS) {
+      debug_printf("llvmpipe: fs #%u variant #%u optimized in %u ms\n",
+                   opt->shader->no, opt->no,
+                   (unsigned) ((os_time_get() - t0) / 1000));
+   }
+}
+
+
+static PIPE_THREAD_ROUTINE(async_thread_function, init_data)
+{
+   struct lp_fs_async_thread *thread = (struct lp_fs_async_thread *) init_data;
+   struct lp_fs_async *async = thread->async;
+
+   pipe_mutex_lock(async->mutex);
+
+   while (!async->exit) {
+      struct lp_fs_async_job *job;
+
+      if (is_empty_list(&async->queued)) {
+         pipe_condvar_wait(async->cond, async->mutex);
+         continue;
+      }
+
+      job = first_elem(&async->queued);
+      remove_from_list(job);
+      job->status = LP_FS_ASYNC_RUNNING;
+      job->thread = thread;
+      pipe_mutex_unlock(async->mutex);
+
+      pipe_mutex_lock(thread->context_mutex);
+      compile_job(thread, job);
+      pipe_mutex_unlock(thread->context_mutex);
+
+      pipe_mutex_lock(async->mutex);
+      job->status = LP_FS_ASYNC_DONE;
+      insert_at_tail(&async->done, job);
+      async->num_done++;
+      pipe_condvar_broadcast(async->cond);
+   }
+
+   pipe_mutex_unlock(async->mutex);
+
+   return NULL;
+}
+
+
+/**
+ * Create the compilation threads of a context.
+ * \return  NULL if background compilation is disabled or not possible.
+ */
+struct lp_fs_async *
+lp_fs_async_create(void)
+{
+#if HAVE_LLVM > 0x0206
+   struct lp_fs_async *async;
+   unsigned num_threads;
+   unsigned i;
+
+   util_cpu_detect();
+
+   num_threads = debug_get_num_option("LP_ASYNC_COMPILE_THREADS",
+                                      util_cpu_caps.nr_cpus > 1 ? 1 : 0);
+   num_threads = MIN2(num_threads, LP_MAX_ASYNC_COMPILE_THREADS);
+   if (!num_threads)
+      return NULL;
+
+   async = CALLOC_STRUCT(lp_fs_async);
+   if (!async)
+      return NULL;
+
+   pipe_mutex_init(async->mutex);
+   pipe_condvar_init(async->cond);
+   make_empty_list(&async->queued);
+   make_empty_list(&async->done);
+
+   for (i = 0; i < num_threads; i++) {
+      struct lp_fs_async_thread *thread = &async->threads[i];
+
+      thread->async = async;
+      thread->context = get_context();
+      if (!thread->context)
+         break;
+
+      pipe_mutex_init(thread->context_mutex);
+      thread->thread = pipe_thread_create(async_thread_function, thread);
+      async->num_threads = i + 1;
+   }
+
+   if (!async->num_threads) {
+      lp_fs_async_destroy(async);
+      return NULL;
+   }
+
+   return async;
+#else
+   /* There is a single gallivm_state, shared by everything */
+   return NULL;
+#endif
+}
+
+
+/**
+ * Stop the threads.  Variants still queued then never get optimized code.
+ */
+void
+lp_fs_async_destroy(struct lp_fs_async *async)
+{
+   unsigned i;
+
+   pipe_mutex_lock(async->mutex);
+   async->exit = TRUE;
+   pipe_condvar_broadcast(async->cond);
+   pipe_mutex_unlock(async->mutex);
+
+   for (i = 0; i < async->num_threads; i++) {
+      struct lp_fs_async_thread *thread = &async->threads[i];
+
+      pipe_thread_wait(thread->thread);
+      pipe_mutex_destroy(thread->context_mutex);
+      put_context(thread->context);
+   }
+
+   pipe_condvar_destroy(async->cond);
+   pipe_mutex_destroy(async->mutex);
+   FREE(async);
+}
+
+
+/**
+ * Queue the optimized build of a variant which was just built with
+ * GALLIVM_OPT_FAST.
+ * \param cache  disk cache to store the optimized code in, or NULL
+ */
+void
+lp_fs_async_queue(struct lp_fs_async *async,
+                  struct lp_fragment_shader_variant *variant,
+                  struct util_disk_cache *cache,
+                  const void *cache_key, unsigned cache_key_size)
+{
+   struct lp_fs_async_job *job;
+   struct lp_fragment_shader_variant *opt;
+
+   assert(!variant->async);
+
+   job = CALLOC_STRUCT(lp_fs_async_job);
+   opt = MALLOC_STRUCT(lp_fragment_shader_variant);
+   if (!job || !opt) {
+      FREE(job);
+      FREE(opt);
+      return;
+   }
+
+   /* Same key and derived state, but the LLVM objects are built anew */
+   memcpy(opt, variant, sizeof *opt);
+   opt->gallivm = NULL;
+   opt->jit_context_ptr_type = NULL;
+   opt->jit_thread_data_ptr_type = NULL;
+   opt->jit_linear_context_ptr_type = NULL;
+   memset(opt->function, 0, sizeof opt->function);
+   memset(opt->jit_function, 0, sizeof opt->jit_function);
+   opt->nr_instrs = 0;
+   opt->code_size = 0;
+   opt->async = NULL;
+
+   if (cache && cache_key) {
+      job->cache_key = MALLOC(cache_key_size);
+      if (job->cache_key) {
+         memcpy(job->cache_key, cache_key, cache_key_size);
+         job->cache_key_size = cache_key_size;
+         job->cache = cache;
+      }
+   }
+
+   job->variant = variant;
+   job->opt = opt;
+   job->status = LP_FS_ASYNC_QUEUED;
+   variant->async = job;
+
+   pipe_mutex_lock(async->mutex);
+   insert_at_tail(&async->queued, job);
+   pipe_condvar_broadcast(async->cond);
+   pipe_mutex_unlock(async->mutex);
+}
+
+
+/**
+ * Make the variants whose optimized code is ready draw with it.
+ *
+ * The quickly built code stays around until the variant is removed, as
+ * scenes being rasterized may still be calling it.
+ *
+ * \return  bytes of machine code the variants hold now on top of before
+ */
+size_t
+lp_fs_async_update(struct lp_fs_async *async)
+{
+   size_t code_size = 0;
+
+   if (!p_atomic_read(&async->num_done))
+      return 0;
+
+   pipe_mutex_lock(async->mutex);
+
+   while (!is_empty_list(&async->done)) {
+      struct lp_fs_async_job *job = first_elem(&async->done);
+      struct lp_fragment_shader_variant *variant = job->variant;
+      struct lp_fragment_shader_variant *opt = job->opt;
+
+      remove_from_list(job);
+
+      if (opt->jit_function[RAST_EDGE_TEST] &&
+          opt->jit_function[RAST_WHOLE]) {
+         variant->jit_function[RAST_EDGE_TEST] =
+            opt->jit_function[RAST_EDGE_TEST];
+         variant->jit_function[RAST_WHOLE] = opt->jit_function[RAST_WHOLE];
+         variant->code_size += opt->code_size;
+         code_size += opt->code_size;
+      }
+
+      job->status = LP_FS_ASYNC_INSTALLED;
+   }
+
+   async->num_done = 0;
+
+   pipe_mutex_unlock(async->mutex);
+
+   return code_size;
+}
+
+
+/**
+ * Free a variant's optimized build, waiting for it to finish if needed.
+ * The variant must not be referenced by any scene anymore.
+ */
+void
+lp_fs_async_release(struct lp_fs_async *async, struct lp_fs_async_job *job)
+{
+   struct lp_fragment_shader_variant *opt = job->opt;
+   unsigned i;
+
+   pipe_mutex_lock(async->mutex);
+
+   while (job->status == LP_FS_ASYNC_RUNNING) {
+      pipe_condvar_wait(async->cond, async->mutex);
+   }
+
+   if (job->status == LP_FS_ASYNC_QUEUED) {
+      remove_from_list(job);
+   }
+   else if (job->status == LP_FS_ASYNC_DONE) {
+      remove_from_list(job);
+      async->num_done--;
+   }
+
+   pipe_mutex_unlock(async->mutex);
+
+   if (opt->gallivm) {
+      pipe_mutex_lock(job->thread->context_mutex);
+
+      for (i = 0; i < Elements(opt->function); i++) {
+         if (opt->function[i]) {
+            gallivm_free_function(opt->gallivm,
+                                  opt->function[i],
+                                  opt->jit_function[i]);
+         }
+      }
+
+      gallivm_destroy(opt->gallivm);
+
+      pipe_mutex_unlock(job->thread->context_mutex);
+   }
+
+   FREE(opt);
+   FREE(job->cache_key);
+   FREE(job);
+}
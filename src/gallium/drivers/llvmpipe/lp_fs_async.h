@@ -0,0 +1,59 @@
+/**************************************************************************
+ *
+ * Copyright 2013 The Mesa Authors
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+#ifndef LP_FS_ASYNC_H
+#define LP_FS_ASYNC_H
+
+#include "pipe/p_compiler.h"
+
+
+struct lp_fs_async;
+struct lp_fs_async_job;
+struct lp_fragment_shader_variant;
+struct util_disk_cache;
+
+
+struct lp_fs_async *
+lp_fs_async_create(void);
+
+void
+lp_fs_async_destroy(struct lp_fs_async *async);
+
+void
+lp_fs_async_queue(struct lp_fs_async *async,
+                  struct lp_fragment_shader_variant *variant,
+                  struct util_disk_cache *cache,
+                  const void *cache_key, unsigned cache_key_size);
+
+size_t
+lp_fs_async_update(struct lp_fs_async *async);
+
+void
+lp_fs_async_release(struct lp_fs_async *async, struct lp_fs_async_job *job);
+
+
+#endif /* LP_FS_ASYNC_H */
@@ -38,16 +38,18 @@
 #include "gallivm/lp_bld_debug.h"
 #include "lp_context.h"
 #include "lp_jit.h"
+#include "lp_state_cs.h"
 
 
-static void
-lp_jit_create_types(struct lp_fragment_shader_variant *lp)
+/**
+ * struct lp_jit_texture
+ */
+static LLVMTypeRef
+create_jit_texture_type(struct gallivm_state *gallivm)
 {
-   struct gallivm_state *gallivm = lp->gallivm;
    LLVMContextRef lc = gallivm->context;
-   LLVMTypeRef texture_type, sampler_type;
+   LLVMTypeRef texture_type;
 
-   /* struct lp_jit_texture */
    {
       LLVMTypeRef elem_types[LP_JIT_TEXTURE_NUM_FIELDS];
 
@@ -101,8 +103,21 @@ lp_jit_create_types(struct lp_fragment_shader_variant *lp)
                            gallivm->target, texture_type);
    }
 
+   return texture_type;
+}
+
+
+/**
+ * struct lp_jit_sampler
+ */
+static LLVMTypeRef
+create_jit_sampler_type(struct gallivm_state *gallivm,
+                        LLVMTypeRef texture_type)
+{
+   LLVMContextRef lc = gallivm->context;
+   LLVMTypeRef sampler_type;
+
    {
-   /* struct lp_jit_sampler */
       LLVMTypeRef elem_types[LP_JIT_SAMPLER_NUM_FIELDS];
       elem_types[LP_JIT_SAMPLER_MIN_LOD] =
       elem_types[LP_JIT_SAMPLER_MAX_LOD] =
@@ -134,10 +149,25 @@ lp_jit_create_types(struct lp_fragment_shader_variant *lp)
                            gallivm->target, sampler_type);
    }
 
-   /* struct lp_jit_context */
+   return sampler_type;
+}
+
+
+/**
+ * struct lp_jit_context
+ */
+static LLVMTypeRef
+create_jit_context_type(struct gallivm_state *gallivm)
+{
+   LLVMContextRef lc = gallivm->context;
+   LLVMTypeRef texture_type, sampler_type;
+   LLVMTypeRef context_type;
+
+   texture_type = create_jit_texture_type(gallivm);
+   sampler_type = create_jit_sampler_type(gallivm, texture_type);
+
    {
       LLVMTypeRef elem_types[LP_JIT_CTX_COUNT];
-      LLVMTypeRef context_type;
 
       elem_types[LP_JIT_CTX_CONSTANTS] =
             LLVMArrayType(LLVMPointerType(LLVMFloatTypeInContext(lc), 0), LP_MAX_TGSI_CONST_BUFFERS);
@@ -186,10 +216,21 @@ lp_jit_create_types(struct lp_fragment_shader_variant *lp)
                              LP_JIT_CTX_SAMPLERS);
       LP_CHECK_STRUCT_SIZE(struct lp_jit_context,
                            gallivm->target, context_type);
-
-      lp->jit_context_ptr_type = LLVMPointerType(context_type, 0);
    }
 
+   return context_type;
+}
+
+
+static void
+lp_jit_create_types(struct lp_fragment_shader_variant *lp)
+{
+   struct gallivm_state *gallivm = lp->gallivm;
+   LLVMContextRef lc = gallivm->context;
+
+   lp->jit_context_ptr_type =
+      LLVMPointerType(create_jit_context_type(gallivm), 0);
+
    /* struct lp_jit_thread_data */
    {
       LLVMTypeRef elem_types[LP_JIT_THREAD_DATA_COUNT];
@@ -235,3 +276,102 @@ lp_jit_init_types(struct lp_fragment_shader_variant *lp)
    if (!lp->jit_context_ptr_type)
       lp_jit_create_types(lp);
 }
+
+
+void
+lp_jit_init_cs_types(struct lp_compute_shader_variant *lp)
+{
+   struct gallivm_state *gallivm = lp->gallivm;
+   LLVMContextRef lc = gallivm->context;
+   LLVMTypeRef resource_type;
+
+   if (lp->jit_cs_context_ptr_type)
+      return;
+
+   /* struct lp_jit_cs_resource */
+   {
+      LLVMTypeRef elem_types[LP_JIT_CS_RESOURCE_NUM_FIELDS];
+
+      elem_types[LP_JIT_CS_RESOURCE_BASE] =
+         LLVMPointerType(LLVMInt8TypeInContext(lc), 0);
+      elem_types[LP_JIT_CS_RESOURCE_WIDTH] =
+      elem_types[LP_JIT_CS_RESOURCE_HEIGHT] =
+      elem_types[LP_JIT_CS_RESOURCE_ROW_STRIDE] = LLVMInt32TypeInContext(lc);
+
+      resource_type = LLVMStructTypeInContext(lc, elem_types,
+                                              Elements(elem_types), 0);
+#if HAVE_LLVM < 0x0300
+      LLVMAddTypeName(gallivm->module, "cs_resource", resource_type);
+
+      LLVMInvalidateStructLayout(gallivm->target, resource_type);
+#endif
+
+      LP_CHECK_MEMBER_OFFSET(struct lp_jit_cs_resource, base,
+                             gallivm->target, resource_type,
+                             LP_JIT_CS_RESOURCE_BASE);
+      LP_CHECK_MEMBER_OFFSET(struct lp_jit_cs_resource, width,
+                             gallivm->target, resource_type,
+                             LP_JIT_CS_RESOURCE_WIDTH);
+      LP_CHECK_MEMBER_OFFSET(struct lp_jit_cs_resource, height,
+                             gallivm->target, resource_type,
+                             LP_JIT_CS_RESOURCE_HEIGHT);
+      LP_CHECK_MEMBER_OFFSET(struct lp_jit_cs_resource, row_stride,
+                             gallivm->target, resource_type,
+                             LP_JIT_CS_RESOURCE_ROW_STRIDE);
+      LP_CHECK_STRUCT_SIZE(struct lp_jit_cs_resource,
+                           gallivm->target, resource_type);
+   }
+
+   /* struct lp_jit_cs_context */
+   {
+      LLVMTypeRef elem_types[LP_JIT_CS_CTX_COUNT];
+      LLVMTypeRef context_type;
+
+      elem_types[LP_JIT_CS_CTX_BASE] = create_jit_context_type(gallivm);
+      elem_types[LP_JIT_CS_CTX_RESOURCES] =
+         LLVMArrayType(resource_type, PIPE_MAX_SHADER_RESOURCES);
+      elem_types[LP_JIT_CS_CTX_GLOBALS] =
+         LLVMArrayType(resource_type, LP_MAX_GLOBAL_BUFFERS);
+      elem_types[LP_JIT_CS_CTX_INPUT] =
+         LLVMPointerType(LLVMInt8TypeInContext(lc), 0);
+      elem_types[LP_JIT_CS_CTX_GRID_SIZE] =
+      elem_types[LP_JIT_CS_CTX_BLOCK_SIZE] =
+         LLVMArrayType(LLVMInt32TypeInContext(lc), 3);
+
+      context_type = LLVMStructTypeInContext(lc, elem_types,
+                                             Elements(elem_types), 0);
+
+#if HAVE_LLVM < 0x0300
+      LLVMInvalidateStructLayout(gallivm->target, context_type);
+
+      LLVMAddTypeName(gallivm->module, "cs_context", context_type);
+#endif
+
+      LP_CHECK_MEMBER_OFFSET(struct lp_jit_cs_context, base,
+                             gallivm->target, context_type,
+                             LP_JIT_CS_CTX_BASE);
+      LP_CHECK_MEMBER_OFFSET(struct lp_jit_cs_context, resources,
+                             gallivm->target, context_type,
+                             LP_JIT_CS_CTX_RESOURCES);
+      LP_CHECK_MEMBER_OFFSET(struct lp_jit_cs_context, globals,
+                             gallivm->target, context_type,
+                             LP_JIT_CS_CTX_GLOBALS);
+      LP_CHECK_MEMBER_OFFSET(struct lp_jit_cs_context, input,
+                             gallivm->target, context_type,
+                             LP_JIT_CS_CTX_INPUT);
+      LP_CHECK_MEMBER_OFFSET(struct lp_jit_cs_context, grid_size,
+                             gallivm->target, context_type,
+                             LP_JIT_CS_CTX_GRID_SIZE);
+      LP_CHECK_MEMBER_OFFSET(struct lp_jit_cs_context, block_size,
+                             gallivm->target, context_type,
+                             LP_JIT_CS_CTX_BLOCK_SIZE);
+      LP_CHECK_STRUCT_SIZE(struct lp_jit_cs_context,
+                           gallivm->target, context_type);
+
+      lp->jit_cs_context_ptr_type = LLVMPointerType(context_type, 0);
+   }
+
+   if (gallivm_debug & GALLIVM_DEBUG_IR) {
+      LLVMDumpModule(gallivm->module);
+   }
+}
@@ -44,6 +44,7 @@
 
 
 struct lp_fragment_shader_variant;
+struct lp_compute_shader_variant;
 struct llvmpipe_screen;
 
 
@@ -211,6 +212,113 @@ typedef void
                     unsigned depth_stride);
 
 
+/**
+ * A compute shader resource or global buffer: width bytes by height rows.
+ * Buffers have a single row.
+ */
+struct lp_jit_cs_resource
+{
+   uint8_t *base;
+   uint32_t width;
+   uint32_t height;
+   uint32_t row_stride;
+};
+
+
+enum {
+   LP_JIT_CS_RESOURCE_BASE = 0,
+   LP_JIT_CS_RESOURCE_WIDTH,
+   LP_JIT_CS_RESOURCE_HEIGHT,
+   LP_JIT_CS_RESOURCE_ROW_STRIDE,
+   LP_JIT_CS_RESOURCE_NUM_FIELDS  /* number of fields above */
+};
+
+
+/**
+ * Global addresses hold the binding slot in the top bits and the offset
+ * into the buffer below.
+ */
+#define LP_GLOBAL_OFFSET_BITS 27
+
+
+/**
+ * This structure is passed directly to the generated compute shader.
+ *
+ * The fragment shader context comes first, for the constants, textures and
+ * samplers, so that the TGSI translation can be shared.
+ */
+struct lp_jit_cs_context
+{
+   struct lp_jit_context base;
+
+   struct lp_jit_cs_resource resources[PIPE_MAX_SHADER_RESOURCES];
+   struct lp_jit_cs_resource globals[LP_MAX_GLOBAL_BUFFERS];
+
+   const uint8_t *input;
+
+   uint32_t grid_size[3];
+   uint32_t block_size[3];
+};
+
+
+/**
+ * These enum values must match the position of the fields in the
+ * lp_jit_cs_context struct above.
+ */
+enum {
+   LP_JIT_CS_CTX_BASE = 0,
+   LP_JIT_CS_CTX_RESOURCES,
+   LP_JIT_CS_CTX_GLOBALS,
+   LP_JIT_CS_CTX_INPUT,
+   LP_JIT_CS_CTX_GRID_SIZE,
+   LP_JIT_CS_CTX_BLOCK_SIZE,
+   LP_JIT_CS_CTX_COUNT
+};
+
+
+#define lp_jit_cs_context_base(_gallivm, _ptr) \
+   lp_build_struct_get_ptr(_gallivm, _ptr, LP_JIT_CS_CTX_BASE, "base")
+
+#define lp_jit_cs_context_resources(_gallivm, _ptr) \
+   lp_build_struct_get_ptr(_gallivm, _ptr, LP_JIT_CS_CTX_RESOURCES, "resources")
+
+#define lp_jit_cs_context_globals(_gallivm, _ptr) \
+   lp_build_struct_get_ptr(_gallivm, _ptr, LP_JIT_CS_CTX_GLOBALS, "globals")
+
+#define lp_jit_cs_context_input(_gallivm, _ptr) \
+   lp_build_struct_get(_gallivm, _ptr, LP_JIT_CS_CTX_INPUT, "input")
+
+#define lp_jit_cs_context_grid_size(_gallivm, _ptr) \
+   lp_build_struct_get_ptr(_gallivm, _ptr, LP_JIT_CS_CTX_GRID_SIZE, "grid_size")
+
+#define lp_jit_cs_context_block_size(_gallivm, _ptr) \
+   lp_build_struct_get_ptr(_gallivm, _ptr, LP_JIT_CS_CTX_BLOCK_SIZE, "block_size")
+
+
+/**
+ * typedef for compute shader function, running one SIMD vector worth of
+ * invocations of a work group
+ *
+ * @param context       jit context
+ * @param block_id_x    work group x
+ * @param block_id_y    work group y
+ * @param block_id_z    work group z
+ * @param invocation    index of the first invocation within the group
+ * @param local_mem     the group's shared memory
+ * @param private_mem   private memory of the group's invocations
+ * @param barrier_data  passed to lp_cs_barrier(), NULL if never waited on
+ */
+typedef void
+(*lp_jit_cs_func)(const struct lp_jit_cs_context *context,
+                  uint32_t block_id_x,
+                  uint32_t block_id_y,
+                  uint32_t block_id_z,
+                  uint32_t invocation,
+                  uint8_t *local_mem,
+                  uint8_t *private_mem,
+                  void *barrier_data);
+
+
 void
 lp_jit_screen_cleanup(struct llvmpipe_screen *screen);
 
@@ -223,4 +331,8 @@ void
 lp_jit_init_types(struct lp_fragment_shader_variant *lp);
 
 
+void
+lp_jit_init_cs_types(struct lp_compute_shader_variant *lp);
+
+
 #endif /* LP_JIT_H */
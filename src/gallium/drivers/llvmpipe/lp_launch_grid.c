@@ -0,0 +1,452 @@
+/**************************************************************************
+ *
+ * Copyright 2013 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDERS, AUTHORS AND/OR ITS SUPPLIERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ **************************************************************************/
+
+/**
+ * launch_grid(): running compute shaders on the rasterizer threads.
+ *
+ * The threads claim work groups one at a time from a shared counter and run
+ * the invocations of each group a vector at a time.  A group whose shader
+ * has barriers and which takes more than one vector is run as fibers, one
+ * per vector: lp_cs_barrier() switches back to the thread's scheduler, which
+ * resumes the fibers round-robin, so all of them have reached the barrier
+ * before any goes past it.
+ */
+
+#include "pipe/p_config.h"
+
+#if defined(PIPE_OS_UNIX) && !defined(PIPE_OS_ANDROID)
+#define LP_CS_HAVE_FIBERS 1
+#include <ucontext.h>
+#else
+#define LP_CS_HAVE_FIBERS 0
+#endif
+
+#include "util/u_atomic.h"
+#include "util/u_format.h"
+#include "util/u_inlines.h"
+#include "util/u_math.h"
+#include "util/u_memory.h"
+#include "lp_context.h"
+#include "lp_debug.h"
+#include "lp_flush.h"
+#include "lp_rast.h"
+#include "lp_screen.h"
+#include "lp_setup.h"
+#include "lp_state_cs.h"
+#include "lp_texture.h"
+
+
+/** Stack size of the fibers */
+#define LP_CS_FIBER_STACK_SIZE (64 * 1024)
+
+
+struct lp_cs_job
+{
+   const struct lp_compute_shader_variant *variant;
+   const struct lp_jit_cs_context *context;
+
+   unsigned grid_size[3];
+   unsigned num_groups;
+   unsigned invocations_per_group;
+   unsigned num_vectors;       /**< vectors per group */
+   boolean use_fibers;
+
+   /** Next work group to run */
+   int32_t next_group;
+};
+
+
+struct lp_cs_fiber_scheduler;
+
+
+struct lp_cs_fiber
+{
+#if LP_CS_HAVE_FIBERS
+   ucontext_t context;
+#endif
+   struct lp_cs_fiber_scheduler *scheduler;
+   unsigned invocation;
+   boolean done;
+};
+
+
+/**
+ * Per-thread state of a job.
+ */
+struct lp_cs_fiber_scheduler
+{
+   const struct lp_cs_job *job;
+   unsigned block_id[3];
+   uint8_t *local_mem;
+   uint8_t *private_mem;
+
+#if LP_CS_HAVE_FIBERS
+   ucontext_t context;
+#endif
+   struct lp_cs_fiber *fibers;
+   uint8_t *stacks;
+};
+
+
+/**
+ * Called by the generated code at barriers: let the other fibers of the
+ * group catch up.
+ */
+void
+lp_cs_barrier(void *barrier_data)
+{
+#if LP_CS_HAVE_FIBERS
+   struct lp_cs_fiber *fiber = (struct lp_cs_fiber *) barrier_data;
+
+   if (fiber) {
+      swapcontext(&fiber->context, &fiber->scheduler->context);
+   }
+#endif
+}
+
+
+static void
+run_vector(struct lp_cs_fiber_scheduler *sched, unsigned invocation,
+           void *barrier_data)
+{
+   const struct lp_cs_job *job = sched->job;
+
+   job->variant->jit_function(job->context,
+                              sched->block_id[0],
+                              sched->block_id[1],
+                              sched->block_id[2],
+                              invocation,
+                              sched->local_mem,
+                              sched->private_mem,
+                              barrier_data);
+}
+
+
+#if LP_CS_HAVE_FIBERS
+
+/**
+ * Fiber entry point.  makecontext() only passes ints, so the fiber pointer
+ * comes in two halves.
+ */
+static void
+fiber_main(int ptr_lo, int ptr_hi)
+{
+   uint64_t ptr = ((uint64_t) (unsigned) ptr_hi << 32) | (unsigned) ptr_lo;
+   struct lp_cs_fiber *fiber = (struct lp_cs_fiber *) (uintptr_t) ptr;
+
+   run_vector(fiber->scheduler, fiber->invocation, fiber);
+
+   fiber->done = TRUE;
+   /* returns to the scheduler through uc_link */
+}
+
+
+static void
+run_group_fibers(struct lp_cs_fiber_scheduler *sched)
+{
+   const struct lp_cs_job *job = sched->job;
+   unsigned remaining;
+   unsigned i;
+
+   for (i = 0; i < job->num_vectors; i++) {
+      struct lp_cs_fiber *fiber = &sched->fibers[i];
+      uint64_t ptr = (uint64_t) (uintptr_t) fiber;
+
+      fiber->scheduler = sched;
+      fiber->invocation = i * job->variant->vector_length;
+      fiber->done = FALSE;
+
+      getcontext(&fiber->context);
+      fiber->context.uc_stack.ss_sp = sched->stacks + i * LP_CS_FIBER_STACK_SIZE;
+      fiber->context.uc_stack.ss_size = LP_CS_FIBER_STACK_SIZE;
+      fiber->context.uc_link = &sched->context;
+      makecontext(&fiber->context, (void (*)(void)) fiber_main, 2,
+                  (int) (ptr & 0xffffffff), (int) (ptr >> 32));
+   }
+
+   do {
+      remaining = 0;
+      for (i = 0; i < job->num_vectors; i++) {
+         struct lp_cs_fiber *fiber = &sched->fibers[i];
+
+         if (!fiber->done) {
+            swapcontext(&sched->context, &fiber->context);
+            if (!fiber->done)
+               remaining++;
+         }
+      }
+   } while (remaining);
+}
+
+#endif /* LP_CS_HAVE_FIBERS */
+
+
+/**
+ * Claim the next work group, returns FALSE once there are none left.
+ */
+static boolean
+claim_group(struct lp_cs_job *job, unsigned *group)
+{
+   int32_t next;
+
+   do {
+      next = job->next_group;
+      if ((unsigned) next >= job->num_groups)
+         return FALSE;
+   } while (p_atomic_cmpxchg(&job->next_group, next, next + 1) != next);
+
+   *group = next;
+   return TRUE;
+}
+
+
+/**
+ * The function run by each rasterizer thread.
+ */
+static void
+cs_run_job(void *data, unsigned thread_index)
+{
+   struct lp_cs_job *job = (struct lp_cs_job *) data;
+   const struct lp_compute_shader *shader = job->variant->shader;
+   struct lp_cs_fiber_scheduler sched;
+   unsigned group;
+
+   memset(&sched, 0, sizeof sched);
+   sched.job = job;
+   sched.local_mem = align_malloc(MAX2(shader->base.req_local_mem, 16), 16);
+   sched.private_mem =
+      align_malloc(MAX2(shader->base.req_private_mem *
+                        job->num_vectors * job->variant->vector_length, 16),
+                   16);
+   if (job->use_fibers) {
+      sched.fibers = CALLOC(job->num_vectors, sizeof *sched.fibers);
+      sched.stacks = align_malloc(job->num_vectors * LP_CS_FIBER_STACK_SIZE,
+                                  16);
+   }
+
+   if (!sched.local_mem || !sched.private_mem ||
+       (job->use_fibers && (!sched.fibers || !sched.stacks))) {
+      debug_printf("llvmpipe: out of memory for compute shader\n");
+      goto out;
+   }
+
+   while (claim_group(job, &group)) {
+      unsigned i;
+
+      sched.block_id[0] = group % job->grid_size[0];
+      sched.block_id[1] = (group / job->grid_size[0]) % job->grid_size[1];
+      sched.block_id[2] = group / (job->grid_size[0] * job->grid_size[1]);
+
+#if LP_CS_HAVE_FIBERS
+      if (job->use_fibers) {
+         run_group_fibers(&sched);
+         continue;
+      }
+#endif
+
+      for (i = 0; i < job->num_vectors; i++) {
+         run_vector(&sched, i * job->variant->vector_length, NULL);
+      }
+   }
+
+out:
+   align_free(sched.stacks);
+   FREE(sched.fibers);
+   align_free(sched.private_mem);
+   align_free(sched.local_mem);
+}
+
+
+/**
+ * Describe a resource bound with set_compute_resources() to the generated
+ * code, mapping it.
+ */
+static void
+setup_cs_resource(struct lp_jit_cs_resource *jit_res,
+                  struct pipe_surface *surf)
+{
+   struct pipe_resource *res = surf->texture;
+   const unsigned blocksize = util_format_get_blocksize(surf->format);
+
+   if (llvmpipe_resource_is_texture(res)) {
+      const unsigned level = surf->u.tex.level;
+
+      jit_res->base = llvmpipe_resource_map(res, level, surf->u.tex.first_layer,
+                                            LP_TEX_USAGE_READ_WRITE);
+      jit_res->width = u_minify(res->width0, level) * blocksize;
+      jit_res->height = u_minify(res->height0, level);
+      jit_res->row_stride = llvmpipe_resource_stride(res, level);
+   }
+   else {
+      const unsigned offset = surf->u.buf.first_element * blocksize;
+      const unsigned size =
+         (surf->u.buf.last_element - surf->u.buf.first_element + 1) * blocksize;
+
+      jit_res->base = (uint8_t *) llvmpipe_resource_data(res) + offset;
+      jit_res->width = offset < res->width0 ?
+                       MIN2(size, res->width0 - offset) : 0;
+      jit_res->height = 1;
+      jit_res->row_stride = 0;
+   }
+
+   if (!jit_res->base) {
+      jit_res->width = 0;
+      jit_res->height = 0;
+   }
+}
+
+
+static void
+llvmpipe_launch_grid(struct pipe_context *pipe,
+                     const uint *block_layout, const uint *grid_layout,
+                     uint32_t pc, const void *input)
+{
+   struct llvmpipe_context *llvmpipe = llvmpipe_context(pipe);
+   struct llvmpipe_screen *screen = llvmpipe_screen(pipe->screen);
+   struct lp_compute_shader *shader = llvmpipe->cs;
+   struct lp_compute_shader_variant *variant;
+   struct lp_jit_cs_context *context;
+   struct lp_cs_job job;
+   unsigned i;
+
+   if (!shader)
+      return;
+
+   /* the shader may read what was rendered, and write what is sampled */
+   llvmpipe_finish(pipe, __FUNCTION__);
+
+   variant = llvmpipe_get_cs_variant(llvmpipe, pc);
+   if (!variant)
+      return;
+
+   context = CALLOC_STRUCT(lp_jit_cs_context);
+   if (!context)
+      return;
+
+   for (i = 0; i < LP_MAX_TGSI_CONST_BUFFERS; i++) {
+      const struct pipe_constant_buffer *cb =
+         &llvmpipe->constants[PIPE_SHADER_COMPUTE][i];
+      const ubyte *data = NULL;
+
+      if (cb->buffer)
+         data = (const ubyte *) llvmpipe_resource_data(cb->buffer);
+      else if (cb->user_buffer)
+         data = (const ubyte *) cb->user_buffer;
+
+      if (data)
+         data += cb->buffer_offset;
+
+      context->base.constants[i] = (const float *) data;
+   }
+
+   for (i = 0; i < llvmpipe->num_sampler_views[PIPE_SHADER_COMPUTE]; i++) {
+      const struct pipe_sampler_view *view =
+         llvmpipe->sampler_views[PIPE_SHADER_COMPUTE][i];
+
+      if (view)
+         lp_setup_jit_texture(&context->base.textures[i], view);
+   }
+
+   for (i = 0; i < llvmpipe->num_samplers[PIPE_SHADER_COMPUTE]; i++) {
+      const struct pipe_sampler_state *sampler =
+         llvmpipe->samplers[PIPE_SHADER_COMPUTE][i];
+
+      if (sampler) {
+         struct lp_jit_sampler *jit_sam = &context->base.samplers[i];
+
+         jit_sam->min_lod = sampler->min_lod;
+         jit_sam->max_lod = sampler->max_lod;
+         jit_sam->lod_bias = sampler->lod_bias;
+         COPY_4V(jit_sam->border_color, sampler->border_color.f);
+      }
+   }
+
+   for (i = 0; i < PIPE_MAX_SHADER_RESOURCES; i++) {
+      if (llvmpipe->cs_resources[i])
+         setup_cs_resource(&context->resources[i], llvmpipe->cs_resources[i]);
+   }
+
+   for (i = 0; i < LP_MAX_GLOBAL_BUFFERS; i++) {
+      struct pipe_resource *res = llvmpipe->global_buffers[i];
+
+      if (res) {
+         context->globals[i].base = llvmpipe_resource_data(res);
+         context->globals[i].width = res->width0;
+         context->globals[i].height = 1;
+      }
+   }
+
+   context->input = (const uint8_t *) input;
+
+   memset(&job, 0, sizeof job);
+   job.variant = variant;
+   job.context = context;
+   job.invocations_per_group = 1;
+   job.num_groups = 1;
+   for (i = 0; i < 3; i++) {
+      context->grid_size[i] = grid_layout[i];
+      context->block_size[i] = block_layout[i];
+      job.grid_size[i] = grid_layout[i];
+      job.num_groups *= grid_layout[i];
+      job.invocations_per_group *= block_layout[i];
+   }
+   job.num_vectors = (job.invocations_per_group +
+                      variant->vector_length - 1) / variant->vector_length;
+   job.use_fibers = shader->has_barrier && job.num_vectors > 1;
+
+#if !LP_CS_HAVE_FIBERS
+   if (job.use_fibers) {
+      debug_warn_once("llvmpipe: compute barriers aren't supported here");
+      job.use_fibers = FALSE;
+   }
+#endif
+
+   if (job.num_groups && job.num_vectors) {
+      uint64_t wait_nano = 0;
+      struct lp_rasterizer *rast = lp_screen_acquire_rast(screen, &wait_nano);
+      lp_rast_run_job(rast, cs_run_job, &job);
+      lp_screen_release_rast(screen, rast);
+   }
+
+   for (i = 0; i < PIPE_MAX_SHADER_RESOURCES; i++) {
+      struct pipe_surface *surf = llvmpipe->cs_resources[i];
+
+      if (surf && llvmpipe_resource_is_texture(surf->texture)) {
+         llvmpipe_resource_unmap(surf->texture, surf->u.tex.level,
+                                 surf->u.tex.first_layer);
+      }
+   }
+
+   FREE(context);
+}
+
+
+void
+llvmpipe_init_launch_grid_funcs(struct llvmpipe_context *llvmpipe)
+{
+   llvmpipe->pipe.launch_grid = llvmpipe_launch_grid;
+}
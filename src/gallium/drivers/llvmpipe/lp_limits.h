@@ -35,10 +35,23 @@
 
 /**
  * Tile size (width and height). This needs to be a power of two.
+ *
+ * It can be chosen at build time by defining LP_TILE_ORDER, to 5, 6 or 7
+ * (i.e. 32x32, 64x64 or 128x128 tiles).  Smaller tiles spread the work
+ * better among threads on small render targets, bigger ones reduce the
+ * binning overhead on very large ones.
  */
+#ifdef LP_TILE_ORDER
+#define TILE_ORDER LP_TILE_ORDER
+#else
 #define TILE_ORDER 6
+#endif
 #define TILE_SIZE (1 << TILE_ORDER)
 
+#if TILE_ORDER < 5 || TILE_ORDER > 7
+#error "unsupported llvmpipe tile size"
+#endif
+
 
 /**
  * Max texture sizes
@@ -61,7 +74,25 @@
 #define LP_MAX_WIDTH  (1 << (LP_MAX_TEXTURE_LEVELS - 1))
 
 
-#define LP_MAX_THREADS 16
+/**
+ * Max number of rasterizer threads.  The default thread count is the number
+ * of CPUs, clamped to this.
+ */
+#define LP_MAX_THREADS 64
+
+
+/**
+ * Max number of rasterizers a screen splits its threads into, see
+ * LP_NUM_RASTERIZERS.
+ */
+#define LP_MAX_RASTERIZERS 32
+
+
+/**
+ * Max number of scenes a context can have in flight, i.e. being binned,
+ * queued or rasterized.  The actual number is set with LP_NUM_SCENES.
+ */
+#define LP_MAX_SCENES 8
 
 
 /**
@@ -81,6 +112,12 @@
  */
 #define LP_MAX_SHADER_INSTRUCTIONS (128*1024)
 
+/**
+ * Max bytes of JIT'd code (for all fragment shaders combined per context)
+ * that will be kept around.
+ */
+#define LP_MAX_SHADER_CODE_SIZE (32*1024*1024)
+
 /**
  * Max number of setup variants that will be kept around.
  *
@@ -91,4 +128,16 @@
  */
 #define LP_MAX_SETUP_VARIANTS 64
 
+/**
+ * Max bytes of JIT'd code for the setup variants of a screen.
+ */
+#define LP_MAX_SETUP_CODE_SIZE (2*1024*1024)
+
+/**
+ * Max invocations per compute work group, and number of buffers
+ * set_global_binding() can bind.
+ */
+#define LP_MAX_CS_THREADS_PER_BLOCK 256
+#define LP_MAX_GLOBAL_BUFFERS 32
+
 #endif /* LP_LIMITS_H */
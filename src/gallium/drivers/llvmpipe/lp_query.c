@@ -39,6 +39,7 @@
 #include "lp_fence.h"
 #include "lp_query.h"
 #include "lp_screen.h"
+#include "lp_setup.h"
 #include "lp_state.h"
 #include "lp_rast.h"
 
@@ -54,7 +55,8 @@ llvmpipe_create_query(struct pipe_context *pipe,
 {
    struct llvmpipe_query *pq;
 
-   assert(type < PIPE_QUERY_TYPES);
+   assert(type < PIPE_QUERY_TYPES ||
+          (type >= PIPE_QUERY_DRIVER_SPECIFIC && type < LP_QUERY_TYPES));
 
    pq = CALLOC_STRUCT( llvmpipe_query );
 
@@ -66,24 +68,42 @@ llvmpipe_create_query(struct pipe_context *pipe,
 }
 
 
+/**
+ * Wait for the scene of a fence to be rasterized, flushing it first if
+ * it's still being binned.
+ */
+static void
+llvmpipe_query_wait_fence(struct pipe_context *pipe, struct lp_fence *fence)
+{
+   if (!lp_fence_issued(fence))
+      llvmpipe_flush(pipe, NULL, __FUNCTION__);
+
+   if (!lp_fence_signalled(fence))
+      lp_fence_wait(fence);
+}
+
+
 static void
 llvmpipe_destroy_query(struct pipe_context *pipe, struct pipe_query *q)
 {
+   struct llvmpipe_context *llvmpipe = llvmpipe_context( pipe );
    struct llvmpipe_query *pq = llvmpipe_query(q);
 
+   lp_setup_forget_query(llvmpipe->setup, pq);
+
    /* Ideally we would refcount queries & not get destroyed until the
     * last scene had finished with us.
     */
    if (pq->fence) {
-      if (!lp_fence_issued(pq->fence))
-         llvmpipe_flush(pipe, NULL, __FUNCTION__);
-
-      if (!lp_fence_signalled(pq->fence))
-         lp_fence_wait(pq->fence);
-
+      llvmpipe_query_wait_fence(pipe, pq->fence);
       lp_fence_reference(&pq->fence, NULL);
    }
 
+   if (pq->render_cond_fence) {
+      llvmpipe_query_wait_fence(pipe, pq->render_cond_fence);
+      lp_fence_reference(&pq->render_cond_fence, NULL);
+   }
+
    FREE(pq);
 }
 
@@ -103,8 +123,18 @@ llvmpipe_get_query_result(struct pipe_context *pipe,
    if (pq->fence) {
       /* only have a fence if there was a scene */
       if (!lp_fence_signalled(pq->fence)) {
-         if (!lp_fence_issued(pq->fence))
+         if (!lp_fence_issued(pq->fence)) {
+            /* The first poll for the result leaves the scene alone, as
+             * results are often polled for long before they're needed.
+             * The next one flushes, so that polling until the result is
+             * available terminates.
+             */
+            if (!wait && !pq->polled) {
+               pq->polled = TRUE;
+               return FALSE;
+            }
             llvmpipe_flush(pipe, NULL, __FUNCTION__);
+         }
 
          if (!wait)
             return FALSE;
@@ -175,7 +205,10 @@ llvmpipe_get_query_result(struct pipe_context *pipe,
    }
       break;
    default:
-      assert(0);
+      assert(pq->type >= PIPE_QUERY_DRIVER_SPECIFIC);
+      for (i = 0; i < num_threads; i++) {
+         *result += pq->end[i];
+      }
       break;
    }
 
@@ -183,21 +216,63 @@ llvmpipe_get_query_result(struct pipe_context *pipe,
 }
 
 
+int
+llvmpipe_get_driver_query_info(struct pipe_screen *screen,
+                               unsigned index,
+                               struct pipe_driver_query_info *info)
+{
+   static const struct pipe_driver_query_info queries[] = {
+      {"prims-binned", LP_QUERY_PRIMS_BINNED, 0, FALSE},
+      {"setup-ns", LP_QUERY_SETUP_TIME, 0, FALSE},
+      {"rast-wait-ns", LP_QUERY_RAST_WAIT_TIME, 0, FALSE},
+      {"jit-code-size", LP_QUERY_JIT_CODE_SIZE, 0, TRUE},
+      {"tiles-rasterized", LP_QUERY_TILES, 0, FALSE},
+      {"blocks-full", LP_QUERY_BLOCKS_FULL, 0, FALSE},
+      {"blocks-partial", LP_QUERY_BLOCKS_PARTIAL, 0, FALSE},
+      {"fs-invocations", LP_QUERY_FS_INVOCATIONS, 0, FALSE},
+      {"rast-ns", LP_QUERY_RAST_TIME, 0, FALSE}
+   };
+   struct llvmpipe_screen *lp_screen = llvmpipe_screen(screen);
+   unsigned num_threads = MAX2(1, lp_screen->num_threads);
+
+   if (!info)
+      return Elements(queries) + num_threads;
+
+   if (index < Elements(queries)) {
+      *info = queries[index];
+      return 1;
+   }
+
+   index -= Elements(queries);
+   if (index >= num_threads)
+      return 0;
+
+   info->name = lp_screen->rast_thread_query_names[index];
+   info->query_type = LP_QUERY_RAST_THREAD_TIME + index;
+   info->max_value = 0;
+   info->uses_byte_units = FALSE;
+   return 1;
+}
+
+
 static void
 llvmpipe_begin_query(struct pipe_context *pipe, struct pipe_query *q)
 {
    struct llvmpipe_context *llvmpipe = llvmpipe_context( pipe );
    struct llvmpipe_query *pq = llvmpipe_query(q);
 
-   /* Check if the query is already in the scene.  If so, we need to
-    * flush the scene now.  Real apps shouldn't re-use a query in a
-    * frame of rendering.
+   /* Check if the query is still in a scene, or is the render condition
+    * of one.  If so, we need to wait for the scene now.  Real apps
+    * shouldn't re-use a query in a frame of rendering.
     */
-   if (pq->fence && !lp_fence_issued(pq->fence)) {
-      llvmpipe_finish(pipe, __FUNCTION__);
+   if (pq->fence) {
+      llvmpipe_query_wait_fence(pipe, pq->fence);
+   }
+   if (pq->render_cond_fence) {
+      llvmpipe_query_wait_fence(pipe, pq->render_cond_fence);
    }
 
-
+   pq->polled = FALSE;
    memset(pq->start, 0, sizeof(pq->start));
    memset(pq->end, 0, sizeof(pq->end));
    lp_setup_begin_query(llvmpipe->setup, pq);
@@ -250,6 +325,14 @@ llvmpipe_end_query(struct pipe_context *pipe, struct pipe_query *q)
 
    switch (pq->type) {
 
+   case LP_QUERY_JIT_CODE_SIZE: {
+      struct llvmpipe_screen *screen = llvmpipe_screen(pipe->screen);
+      pq->end[0] = llvmpipe->fs_code_size +
+                   screen->setup_code_size +
+                   draw_get_shader_code_size(llvmpipe->draw);
+   }
+      break;
+
    case PIPE_QUERY_PRIMITIVES_EMITTED:
       pq->num_primitives_written = llvmpipe->so_stats.num_primitives_written;
       break;
@@ -299,15 +382,19 @@ boolean
 llvmpipe_check_render_cond(struct llvmpipe_context *lp)
 {
    struct pipe_context *pipe = &lp->pipe;
+   struct llvmpipe_query *pq = llvmpipe_query(lp->render_cond_query);
    boolean b, wait;
    uint64_t result;
 
-   if (!lp->render_cond_query)
+   if (!pq)
       return TRUE; /* no query predicate, draw normally */
 
    wait = (lp->render_cond_mode == PIPE_RENDER_COND_WAIT ||
            lp->render_cond_mode == PIPE_RENDER_COND_BY_REGION_WAIT);
 
+   if (!wait && pq->fence && !lp_fence_signalled(pq->fence))
+      return TRUE; /* no result yet, and no need to flush for it */
+
    b = pipe->get_query_result(pipe, lp->render_cond_query, wait, (void*)&result);
    if (b)
       return (!result == lp->render_cond_cond);
@@ -315,6 +402,35 @@ llvmpipe_check_render_cond(struct llvmpipe_context *lp)
       return TRUE;
 }
 
+
+/**
+ * As llvmpipe_check_render_cond(), for draws.  Rather than waiting for the
+ * result of an occlusion query which is still being rendered, the scene it
+ * ended in is flushed and the rasterizer checks the result before carrying
+ * out what's binned from now on.
+ */
+boolean
+llvmpipe_check_render_cond_binned(struct llvmpipe_context *lp)
+{
+   struct llvmpipe_query *pq = llvmpipe_query(lp->render_cond_query);
+   const boolean wait = (lp->render_cond_mode == PIPE_RENDER_COND_WAIT ||
+                         lp->render_cond_mode == PIPE_RENDER_COND_BY_REGION_WAIT);
+
+   if (pq && wait && pq->fence && !lp_fence_signalled(pq->fence) &&
+       (pq->type == PIPE_QUERY_OCCLUSION_COUNTER ||
+        pq->type == PIPE_QUERY_OCCLUSION_PREDICATE)) {
+      if (!lp_fence_issued(pq->fence))
+         llvmpipe_flush(&lp->pipe, NULL, __FUNCTION__);
+
+      lp_setup_set_render_condition(lp->setup, pq, lp->render_cond_cond);
+      return TRUE;
+   }
+
+   lp_setup_set_render_condition(lp->setup, NULL, FALSE);
+
+   return llvmpipe_check_render_cond(lp);
+}
+
 void llvmpipe_init_query_funcs(struct llvmpipe_context *llvmpipe )
 {
    llvmpipe->pipe.create_query = llvmpipe_create_query;
@@ -35,16 +35,49 @@
 
 #include <limits.h>
 #include "os/os_thread.h"
+#include "pipe/p_defines.h"
 #include "lp_limits.h"
 
 
 struct llvmpipe_context;
+struct pipe_screen;
+struct pipe_driver_query_info;
+
+
+/**
+ * Driver-specific query types, see llvmpipe_get_driver_query_info().
+ *
+ * The setup counters are sampled directly at begin/end_query time, the
+ * rasterizer counters are binned like occlusion queries and summed over
+ * the threads.  LP_QUERY_RAST_THREAD_TIME + i is the busy time of
+ * rasterizer thread i alone.  LP_QUERY_JIT_CODE_SIZE is not a count but
+ * the bytes of JIT'd code held at end_query time.
+ */
+enum lp_query_type {
+   LP_QUERY_PRIMS_BINNED = PIPE_QUERY_DRIVER_SPECIFIC,
+   LP_QUERY_SETUP_TIME,
+   LP_QUERY_RAST_WAIT_TIME,
+   LP_QUERY_JIT_CODE_SIZE,
+   LP_QUERY_TILES,
+   LP_QUERY_BLOCKS_FULL,
+   LP_QUERY_BLOCKS_PARTIAL,
+   LP_QUERY_FS_INVOCATIONS,
+   LP_QUERY_RAST_TIME,
+   LP_QUERY_RAST_THREAD_TIME
+};
+
+#define LP_QUERY_TYPES (LP_QUERY_RAST_THREAD_TIME + LP_MAX_THREADS)
+
+/** Number of per-task rasterizer counters, indexed by type - LP_QUERY_TILES */
+#define LP_RAST_COUNTERS (LP_QUERY_RAST_TIME - LP_QUERY_TILES + 1)
 
 
 struct llvmpipe_query {
    uint64_t start[LP_MAX_THREADS];  /* start count value for each thread */
    uint64_t end[LP_MAX_THREADS];    /* end count value for each thread */
    struct lp_fence *fence;          /* fence from last scene this was binned in */
+   struct lp_fence *render_cond_fence; /* last scene drawing conditionally on it */
+   boolean polled;                  /* result asked for and not yet flushed */
    unsigned type;                   /* PIPE_QUERY_* */
    unsigned num_primitives_generated;
    unsigned num_primitives_written;
@@ -58,4 +91,30 @@ extern void llvmpipe_init_query_funcs(struct llvmpipe_context * );
 
 extern boolean llvmpipe_check_render_cond(struct llvmpipe_context *);
 
+extern boolean llvmpipe_check_render_cond_binned(struct llvmpipe_context *);
+
+
+/**
+ * Whether an occlusion query with a complete result lets drawing with the
+ * given render condition go ahead.
+ */
+static INLINE boolean
+lp_query_render_cond_passes(const struct llvmpipe_query *pq,
+                            boolean condition)
+{
+   uint64_t result = 0;
+   unsigned i;
+
+   for (i = 0; i < LP_MAX_THREADS; i++) {
+      result |= pq->end[i];
+   }
+
+   return (!result) == condition;
+}
+
+extern int
+llvmpipe_get_driver_query_info(struct pipe_screen *screen,
+                               unsigned index,
+                               struct pipe_driver_query_info *info);
+
 #endif /* LP_QUERY_H */
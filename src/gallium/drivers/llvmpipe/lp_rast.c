@@ -31,6 +31,7 @@
 #include "util/u_rect.h"
 #include "util/u_surface.h"
 #include "util/u_pack_color.h"
+#include "util/u_cpu_detect.h"
 
 #include "os/os_time.h"
 
@@ -66,7 +67,7 @@ lp_rast_begin( struct lp_rasterizer *rast,
    LP_DBG(DEBUG_RAST, "%s\n", __FUNCTION__);
 
    lp_scene_begin_rasterization( scene );
-   lp_scene_bin_iter_begin( scene );
+   lp_scene_bin_iter_begin( scene, rast->num_threads );
 }
 
 
@@ -102,22 +103,33 @@ lp_rast_tile_begin(struct lp_rasterizer_task *task,
    task->thread_data.vis_counter = 0;
    task->ps_invocations = 0;
 
+   memset(task->counters, 0, sizeof(task->counters));
+   LP_RAST_COUNT(task, LP_QUERY_TILES, 1);
+   task->tile_start = os_time_get_nano();
+
    /* reset pointers to color and depth tile(s) */
    memset(task->color_tiles, 0, sizeof(task->color_tiles));
    task->depth_tile = NULL;
+
+   memset(task->hiz.valid, 0, sizeof(task->hiz.valid));
+
+   task->clear.color = FALSE;
+   task->clear.zstencil = FALSE;
 }
 
 
 /**
- * Clear the rasterizer's current color tile.
- * This is a bin command called during bin processing.
+ * Fill the rasterizer's current color tile with the clear color.
  * Clear commands always clear all bound layers.
  */
 static void
-lp_rast_clear_color(struct lp_rasterizer_task *task,
-                    const union lp_rast_cmd_arg arg)
+lp_rast_do_clear_color(struct lp_rasterizer_task *task,
+                       const union pipe_color_union *color)
 {
    const struct lp_scene *scene = task->scene;
+   union lp_rast_cmd_arg arg;
+
+   arg.clear_color = *color;
 
    if (scene->fb.nr_cbufs) {
       unsigned i;
@@ -195,20 +207,33 @@ lp_rast_clear_color(struct lp_rasterizer_task *task,
 }
 
 
+/**
+ * Clear the rasterizer's current color tile.
+ * This is a bin command called during bin processing.
+ * The clear is only recorded here, see lp_rast_resolve_clears().
+ */
+static void
+lp_rast_clear_color(struct lp_rasterizer_task *task,
+                    const union lp_rast_cmd_arg arg)
+{
+   task->clear.color = TRUE;
+   task->clear.color_value = arg.clear_color;
+}
+
+
 
 
 /**
- * Clear the rasterizer's current z/stencil tile.
- * This is a bin command called during bin processing.
+ * Write the masked z/stencil clear value to the rasterizer's current
+ * z/stencil tile.
  * Clear commands always clear all bound layers.
  */
 static void
-lp_rast_clear_zstencil(struct lp_rasterizer_task *task,
-                       const union lp_rast_cmd_arg arg)
+lp_rast_do_clear_zstencil(struct lp_rasterizer_task *task,
+                          uint64_t clear_value64,
+                          uint64_t clear_mask64)
 {
    const struct lp_scene *scene = task->scene;
-   uint64_t clear_value64 = arg.clear_zstencil.value;
-   uint64_t clear_mask64 = arg.clear_zstencil.mask;
    uint32_t clear_value = (uint32_t) clear_value64;
    uint32_t clear_mask = (uint32_t) clear_mask64;
    const unsigned height = task->height;
@@ -230,6 +255,8 @@ lp_rast_clear_zstencil(struct lp_rasterizer_task *task,
       uint8_t *dst_layer = lp_rast_get_unswizzled_depth_tile_pointer(task, LP_TEX_USAGE_READ_WRITE);
       block_size = util_format_get_blocksize(scene->fb.zsbuf->format);
 
+      memset(task->hiz.valid, 0, sizeof(task->hiz.valid));
+
       clear_value &= clear_mask;
 
       for (layer = 0; layer <= scene->fb_max_layer; layer++) {
@@ -312,6 +339,75 @@ lp_rast_clear_zstencil(struct lp_rasterizer_task *task,
 }
 
 
+/**
+ * Clear the rasterizer's current z/stencil tile.
+ * This is a bin command called during bin processing.
+ * The clear is only recorded here, merged with any other still pending,
+ * see lp_rast_resolve_clears().
+ */
+static void
+lp_rast_clear_zstencil(struct lp_rasterizer_task *task,
+                       const union lp_rast_cmd_arg arg)
+{
+   const uint64_t value = arg.clear_zstencil.value;
+   const uint64_t mask = arg.clear_zstencil.mask;
+
+   if (task->clear.zstencil) {
+      task->clear.zstencil_value = (task->clear.zstencil_value & ~mask) |
+                                   (value & mask);
+      task->clear.zstencil_mask |= mask;
+   }
+   else {
+      task->clear.zstencil = TRUE;
+      task->clear.zstencil_value = value & mask;
+      task->clear.zstencil_mask = mask;
+   }
+}
+
+
+/**
+ * Carry out the clears still pending for the tile, before the bin
+ * command cmd (or at the end of the tile if cmd is LP_RAST_OP_MAX) gets
+ * to the buffers.  A tile shaded by an opaque shader doesn't need a color
+ * clear, as long as it only has the one layer which gets overwritten.
+ */
+static void
+lp_rast_resolve_clears(struct lp_rasterizer_task *task,
+                       unsigned cmd,
+                       const union lp_rast_cmd_arg arg)
+{
+   switch (cmd) {
+   case LP_RAST_OP_CLEAR_COLOR:
+   case LP_RAST_OP_CLEAR_ZSTENCIL:
+   case LP_RAST_OP_BEGIN_QUERY:
+   case LP_RAST_OP_END_QUERY:
+   case LP_RAST_OP_SET_STATE:
+      return;
+   case LP_RAST_OP_SHADE_TILE_OPAQUE:
+      if (!arg.shade_tile->disable && task->scene->fb_max_layer == 0) {
+         if (task->clear.color)
+            LP_COUNT(nr_color_tile_clear_skipped);
+         task->clear.color = FALSE;
+         return;
+      }
+      break;
+   default:
+      break;
+   }
+
+   if (task->clear.color) {
+      task->clear.color = FALSE;
+      lp_rast_do_clear_color(task, &task->clear.color_value);
+   }
+
+   if (task->clear.zstencil) {
+      task->clear.zstencil = FALSE;
+      lp_rast_do_clear_zstencil(task, task->clear.zstencil_value,
+                                task->clear.zstencil_mask);
+   }
+}
+
+
 
 /**
  * Run the shader on all blocks in a tile.  This is used when a tile is
@@ -352,6 +448,14 @@ lp_rast_shade_tile(struct lp_rasterizer_task *task,
          unsigned depth_stride = 0;
          unsigned i;
 
+         if (lp_rast_hiz_reject(task, inputs, tile_x + x, tile_y + y))
+            continue;
+
+         lp_rast_hiz_invalidate(task, inputs, tile_x + x, tile_y + y);
+
+         LP_RAST_COUNT(task, LP_QUERY_BLOCKS_FULL, 1);
+         LP_RAST_COUNT(task, LP_QUERY_FS_INVOCATIONS, 16);
+
          /* color buffer */
          for (i = 0; i < scene->fb.nr_cbufs; i++){
             stride[i] = scene->cbufs[i].stride;
@@ -457,9 +561,16 @@ lp_rast_shade_quads_mask(struct lp_rasterizer_task *task,
     * allocated 4x4 blocks hence need to filter them out here.
     */
    if ((x % TILE_SIZE) < task->width && (y % TILE_SIZE) < task->height) {
+      if (lp_rast_hiz_reject(task, inputs, x, y))
+         return;
+
+      lp_rast_hiz_invalidate(task, inputs, x, y);
+
       /* not very accurate would need a popcount on the mask */
       /* always count this not worth bothering? */
       task->ps_invocations++;
+      LP_RAST_COUNT(task, LP_QUERY_BLOCKS_PARTIAL, 1);
+      LP_RAST_COUNT(task, LP_QUERY_FS_INVOCATIONS, util_bitcount(mask));
 
       /* run shader on 4x4 block */
       BEGIN_JIT_CALL(state, task);
@@ -481,6 +592,125 @@ lp_rast_shade_quads_mask(struct lp_rasterizer_task *task,
 
 
 
+/**
+ * Coarse depth test of a 4x4 block of pixels, done before running the
+ * shader on it.
+ *
+ * The triangle's depth plane is bounded over the block and compared with
+ * the block's min/max depth, which is read back from the depth buffer the
+ * first time it is needed and kept until the block gets shaded again.
+ *
+ * \param x  X position of quad in window coords
+ * \param y  Y position of quad in window coords
+ * \return TRUE if no fragment of the block can pass the depth test
+ */
+boolean
+lp_rast_hiz_reject(struct lp_rasterizer_task *task,
+                   const struct lp_rast_shader_inputs *inputs,
+                   unsigned x, unsigned y)
+{
+   const struct lp_scene *scene = task->scene;
+   const struct lp_fragment_shader_variant *variant = task->state->variant;
+   const float (*a0)[4];
+   const float (*dadx)[4];
+   const float (*dady)[4];
+   unsigned i;
+   float z0, zx, zy, zmin, zmax;
+   float eps;
+
+   if (variant->hiz_func == PIPE_FUNC_ALWAYS ||
+       inputs->layer != 0 ||
+       !scene->zsbuf.map) {
+      return FALSE;
+   }
+
+   i = ((y % TILE_SIZE) / 4) * (TILE_SIZE / 4) + (x % TILE_SIZE) / 4;
+
+   if (!task->hiz.valid[i]) {
+      const struct util_format_description *desc =
+         util_format_description(scene->fb.zsbuf->format);
+      const uint8_t *depth =
+         lp_rast_get_unswizzled_depth_block_pointer(task, x, y, 0);
+      float z[4][4];
+      unsigned j;
+
+      desc->unpack_z_float(&z[0][0], sizeof z[0],
+                           depth, scene->zsbuf.stride, 4, 4);
+
+      zmin = zmax = z[0][0];
+      for (j = 1; j < 16; j++) {
+         zmin = MIN2(zmin, z[j / 4][j % 4]);
+         zmax = MAX2(zmax, z[j / 4][j % 4]);
+      }
+
+      task->hiz.zmin[i] = zmin;
+      task->hiz.zmax[i] = zmax;
+      task->hiz.valid[i] = TRUE;
+   }
+
+   /*
+    * Depth range of the triangle's plane over the block.  Take a pixel of
+    * margin around it so the pixel center convention doesn't matter.
+    */
+   a0 = GET_A0(inputs);
+   dadx = GET_DADX(inputs);
+   dady = GET_DADY(inputs);
+   z0 = a0[0][2] + dadx[0][2] * ((float)x - 1.0f) + dady[0][2] * ((float)y - 1.0f);
+   zx = dadx[0][2] * 6.0f;
+   zy = dady[0][2] * 6.0f;
+   zmin = z0 + MIN2(zx, 0.0f) + MIN2(zy, 0.0f);
+   zmax = z0 + MAX2(zx, 0.0f) + MAX2(zy, 0.0f);
+
+   /* Fixed point depth formats clamp the fragments' depth */
+   zmin = MIN2(zmin, 1.0f);
+   zmax = MAX2(zmax, 0.0f);
+
+   eps = variant->hiz_epsilon;
+
+   switch (variant->hiz_func) {
+   case PIPE_FUNC_NEVER:
+      break;
+   case PIPE_FUNC_LESS:
+   case PIPE_FUNC_LEQUAL:
+      if (zmin <= task->hiz.zmax[i] + eps)
+         return FALSE;
+      break;
+   case PIPE_FUNC_GREATER:
+   case PIPE_FUNC_GEQUAL:
+      if (zmax >= task->hiz.zmin[i] - eps)
+         return FALSE;
+      break;
+   case PIPE_FUNC_EQUAL:
+      if (zmin <= task->hiz.zmax[i] + eps &&
+          zmax >= task->hiz.zmin[i] - eps)
+         return FALSE;
+      break;
+   default:
+      return FALSE;
+   }
+
+   LP_COUNT(nr_hiz_rejected_4);
+   return TRUE;
+}
+
+
+static uint64_t
+lp_rast_driver_counter(const struct lp_rasterizer_task *task, unsigned type)
+{
+   if (type >= LP_QUERY_RAST_THREAD_TIME) {
+      /* only the thread being asked about contributes */
+      if (type - LP_QUERY_RAST_THREAD_TIME != task->thread_index)
+         return 0;
+      type = LP_QUERY_RAST_TIME;
+   }
+
+   if (type == LP_QUERY_RAST_TIME)
+      return os_time_get_nano() - task->tile_start;
+
+   return task->counters[type - LP_QUERY_TILES];
+}
+
+
 /**
  * Begin a new occlusion query.
  * This is a bin command put in all bins.
@@ -492,6 +722,11 @@ lp_rast_begin_query(struct lp_rasterizer_task *task,
 {
    struct llvmpipe_query *pq = arg.query_obj;
 
+   if (pq->type >= LP_QUERY_TILES) {
+      pq->start[task->thread_index] = lp_rast_driver_counter(task, pq->type);
+      return;
+   }
+
    switch (pq->type) {
    case PIPE_QUERY_OCCLUSION_COUNTER:
    case PIPE_QUERY_OCCLUSION_PREDICATE:
@@ -518,6 +753,13 @@ lp_rast_end_query(struct lp_rasterizer_task *task,
 {
    struct llvmpipe_query *pq = arg.query_obj;
 
+   if (pq->type >= LP_QUERY_TILES) {
+      pq->end[task->thread_index] +=
+         lp_rast_driver_counter(task, pq->type) - pq->start[task->thread_index];
+      pq->start[task->thread_index] = 0;
+      return;
+   }
+
    switch (pq->type) {
    case PIPE_QUERY_OCCLUSION_COUNTER:
    case PIPE_QUERY_OCCLUSION_PREDICATE:
@@ -544,7 +786,13 @@ void
 lp_rast_set_state(struct lp_rasterizer_task *task,
                   const union lp_rast_cmd_arg arg)
 {
-   task->state = arg.state;
+   const struct lp_rast_state *state = arg.state;
+
+   task->state = state;
+   task->render_cond_skip =
+      state->render_cond_query &&
+      !lp_query_render_cond_passes(state->render_cond_query,
+                                   state->render_cond_cond);
 }
 
 
@@ -555,8 +803,11 @@ lp_rast_set_state(struct lp_rasterizer_task *task,
 static void
 lp_rast_tile_end(struct lp_rasterizer_task *task)
 {
+   union lp_rast_cmd_arg dummy = {0};
    unsigned i;
 
+   lp_rast_resolve_clears(task, LP_RAST_OP_MAX, dummy);
+
    for (i = 0; i < task->scene->num_active_queries; ++i) {
       lp_rast_end_query(task, lp_rast_arg_query(task->scene->active_queries[i]));
    }
@@ -583,6 +834,7 @@ static lp_rast_cmd_func dispatch[LP_RAST_OP_MAX] =
    lp_rast_triangle_3_4,
    lp_rast_triangle_3_16,
    lp_rast_triangle_4_16,
+   lp_rast_rectangle,
    lp_rast_shade_tile,
    lp_rast_shade_tile_opaque,
    lp_rast_begin_query,
@@ -604,6 +856,13 @@ do_rasterize_bin(struct lp_rasterizer_task *task,
 
    for (block = bin->head; block; block = block->next) {
       for (k = 0; k < block->count; k++) {
+         /* skip the draw commands failing the render condition */
+         if (task->render_cond_skip &&
+             block->cmd[k] >= LP_RAST_OP_TRIANGLE_1 &&
+             block->cmd[k] <= LP_RAST_OP_SHADE_TILE_OPAQUE)
+            continue;
+
+         lp_rast_resolve_clears(task, block->cmd[k], block->arg[k]);
          dispatch[block->cmd[k]]( task, block->arg[k] );
       }
    }
@@ -670,7 +929,8 @@ rasterize_scene(struct lp_rasterizer_task *task,
          int i, j;
 
          assert(scene);
-         while ((bin = lp_scene_bin_iter_next(scene, &i, &j))) {
+         while ((bin = lp_scene_bin_iter_next(scene, task->thread_index,
+                                              &i, &j))) {
             if (!is_empty_bin( bin ))
                rasterize_bin(task, bin, i, j);
          }
@@ -739,6 +999,40 @@ lp_rast_finish( struct lp_rasterizer *rast )
 }
 
 
+/**
+ * Run func on every rasterizer thread, or on the calling thread when there
+ * are none, and wait for all of them to return.  For work that isn't a
+ * scene, like compute grids.  The caller must have acquired the rasterizer
+ * with lp_screen_acquire_rast() and have no scene in flight.
+ */
+void
+lp_rast_run_job( struct lp_rasterizer *rast,
+                 lp_rast_job_func func,
+                 void *data )
+{
+   unsigned i;
+
+   if (rast->num_threads == 0) {
+      func(data, 0);
+      return;
+   }
+
+   rast->job_func = func;
+   rast->job_data = data;
+
+   for (i = 0; i < rast->num_threads; i++) {
+      pipe_semaphore_signal(&rast->tasks[i].work_ready);
+   }
+
+   for (i = 0; i < rast->num_threads; i++) {
+      pipe_semaphore_wait(&rast->tasks[i].work_done);
+   }
+
+   rast->job_func = NULL;
+   rast->job_data = NULL;
+}
+
+
 /**
  * This is the thread's main entrypoint.
  * It's a simple loop:
@@ -761,6 +1055,12 @@ static PIPE_THREAD_ROUTINE( thread_function, init_data )
       if (rast->exit_flag)
          break;
 
+      if (rast->job_func) {
+         rast->job_func(rast->job_data, task->thread_index);
+         pipe_semaphore_signal(&task->work_done);
+         continue;
+      }
+
       if (task->thread_index == 0) {
          /* thread[0]:
           *  - get next scene to rasterize
@@ -802,20 +1102,65 @@ static PIPE_THREAD_ROUTINE( thread_function, init_data )
 }
 
 
+/**
+ * Choose the CPU each rasterizer thread gets pinned to.
+ *
+ * The scene's bins are allocated and first touched by the thread doing the
+ * binning, so their memory normally lives on the NUMA node of the calling
+ * thread.  Fill the CPUs of that node first, and only then spill over to the
+ * CPUs of the other nodes.
+ *
+ * \return  number of entries written to cpus
+ */
+static unsigned
+choose_rast_thread_cpus(unsigned num_threads, unsigned *cpus)
+{
+   unsigned nr_cpus = util_cpu_caps.nr_cpus;
+   int current = util_cpu_get_current();
+   int home_node = current >= 0 ? util_cpu_get_numa_node(current) : -1;
+   unsigned count = 0;
+   unsigned pass, cpu;
+
+   for (pass = 0; pass < 2 && count < num_threads; pass++) {
+      for (cpu = 0; cpu < nr_cpus && count < num_threads; cpu++) {
+         boolean local = home_node < 0 ||
+                         util_cpu_get_numa_node(cpu) == home_node;
+         if (local == (pass == 0)) {
+            cpus[count++] = cpu;
+         }
+      }
+   }
+
+   return count;
+}
+
+
 /**
  * Initialize semaphores and spawn the threads.
  */
 static void
-create_rast_threads(struct lp_rasterizer *rast)
+create_rast_threads(struct lp_rasterizer *rast, unsigned first_thread)
 {
+   unsigned cpus[LP_MAX_THREADS];
+   unsigned nr_cpus = 0;
    unsigned i;
 
+   if (rast->num_threads &&
+       debug_get_bool_option("LP_PIN_THREADS", FALSE)) {
+      nr_cpus = choose_rast_thread_cpus(first_thread + rast->num_threads,
+                                        cpus);
+   }
+
    /* NOTE: if num_threads is zero, we won't use any threads */
    for (i = 0; i < rast->num_threads; i++) {
       pipe_semaphore_init(&rast->tasks[i].work_ready, 0);
       pipe_semaphore_init(&rast->tasks[i].work_done, 0);
       rast->threads[i] = pipe_thread_create(thread_function,
                                             (void *) &rast->tasks[i]);
+      if (nr_cpus) {
+         pipe_thread_set_affinity(rast->threads[i],
+                                  cpus[(first_thread + i) % nr_cpus]);
+      }
    }
 }
 
@@ -825,9 +1170,12 @@ create_rast_threads(struct lp_rasterizer *rast)
  * Create new lp_rasterizer.  If num_threads is zero, don't create any
  * new threads, do rendering synchronously.
  * \param num_threads  number of rasterizer threads to create
+ * \param first_thread  screen-wide index of the first thread, so that
+ *                      rasterizers sharing a screen get pinned to
+ *                      different CPUs
  */
 struct lp_rasterizer *
-lp_rast_create( unsigned num_threads )
+lp_rast_create( unsigned num_threads, unsigned first_thread )
 {
    struct lp_rasterizer *rast;
    unsigned i;
@@ -852,7 +1200,7 @@ lp_rast_create( unsigned num_threads )
 
    rast->no_rast = debug_get_bool_option("LP_NO_RAST", FALSE);
 
-   create_rast_threads(rast);
+   create_rast_threads(rast, first_thread);
 
    /* for synchronizing rasterization threads */
    pipe_barrier_init( &rast->barrier, rast->num_threads );
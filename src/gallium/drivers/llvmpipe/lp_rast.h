@@ -38,7 +38,9 @@
 #define LP_RAST_H
 
 #include "pipe/p_compiler.h"
+#include "util/u_rect.h"
 #include "lp_jit.h"
+#include "lp_limits.h"
 
 
 struct lp_rasterizer;
@@ -55,6 +57,13 @@ struct cmd_bin;
 
 #define LP_MAX_ACTIVE_BINNED_QUERIES 16
 
+/* Binned driver queries (see lp_query.h) are counted apart, with room for
+ * every rasterizer counter plus the per-thread times */
+#define LP_MAX_ACTIVE_DRIVER_QUERIES (16 + LP_MAX_THREADS)
+
+#define LP_MAX_ACTIVE_QUERIES \
+   (LP_MAX_ACTIVE_BINNED_QUERIES + LP_MAX_ACTIVE_DRIVER_QUERIES)
+
 
 struct lp_rasterizer_task;
 
@@ -74,6 +83,13 @@ struct lp_rast_state {
     * the tile color/z/stencil data somehow
      */
    struct lp_fragment_shader_variant *variant;
+
+   /* Occlusion query deciding, with render_cond_cond, whether to draw
+    * anything with this state.  It was ended in an earlier scene, so its
+    * result is there by the time this state is rasterized.
+    */
+   struct llvmpipe_query *render_cond_query;
+   boolean render_cond_cond;
 };
 
 
@@ -126,6 +142,22 @@ struct lp_rast_triangle {
 };
 
 
+/**
+ * An axis aligned rectangle of pixels known to be in this bin, such as a
+ * point, plus inputs to run the shader.  Its coverage follows directly
+ * from the bounds, so no edge functions are needed.
+ * Objects of this type are put into the lp_setup_context::data buffer.
+ */
+struct lp_rast_rectangle {
+   /* inclusive pixel bounds, already clipped to the scissor */
+   struct u_rect box;
+
+   /* inputs for the shader */
+   struct lp_rast_shader_inputs inputs;
+   /* a0, dadx, dady are also allocated here */
+};
+
+
 #define GET_A0(inputs) ((float (*)[4])((inputs)+1))
 #define GET_DADX(inputs) ((float (*)[4])((char *)((inputs) + 1) + (inputs)->stride))
 #define GET_DADY(inputs) ((float (*)[4])((char *)((inputs) + 1) + 2 * (inputs)->stride))
@@ -134,7 +166,7 @@ struct lp_rast_triangle {
 
 
 struct lp_rasterizer *
-lp_rast_create( unsigned num_threads );
+lp_rast_create( unsigned num_threads, unsigned first_thread );
 
 void
 lp_rast_destroy( struct lp_rasterizer * );
@@ -150,12 +182,25 @@ void
 lp_rast_finish( struct lp_rasterizer *rast );
 
 
+/**
+ * Function run on each rasterizer thread by lp_rast_run_job().
+ * \param thread_index  index of the calling thread, below the thread count
+ */
+typedef void (*lp_rast_job_func)(void *data, unsigned thread_index);
+
+void
+lp_rast_run_job( struct lp_rasterizer *rast,
+                 lp_rast_job_func func,
+                 void *data );
+
+
 union lp_rast_cmd_arg {
    const struct lp_rast_shader_inputs *shade_tile;
    struct {
       const struct lp_rast_triangle *tri;
       unsigned plane_mask;
    } triangle;
+   const struct lp_rast_rectangle *rectangle;
    const struct lp_rast_state *set_state;
    union pipe_color_union clear_color;
    struct {
@@ -204,6 +249,14 @@ lp_rast_arg_triangle_contained( const struct lp_rast_triangle *triangle,
    return arg;
 }
 
+static INLINE union lp_rast_cmd_arg
+lp_rast_arg_rectangle( const struct lp_rast_rectangle *rectangle )
+{
+   union lp_rast_cmd_arg arg;
+   arg.rectangle = rectangle;
+   return arg;
+}
+
 static INLINE union lp_rast_cmd_arg
 lp_rast_arg_state( const struct lp_rast_state *state )
 {
@@ -266,13 +319,14 @@ lp_rast_arg_null( void )
 #define LP_RAST_OP_TRIANGLE_3_4      0xa
 #define LP_RAST_OP_TRIANGLE_3_16     0xb
 #define LP_RAST_OP_TRIANGLE_4_16     0xc
-#define LP_RAST_OP_SHADE_TILE        0xd
-#define LP_RAST_OP_SHADE_TILE_OPAQUE 0xe
-#define LP_RAST_OP_BEGIN_QUERY       0xf
-#define LP_RAST_OP_END_QUERY         0x10
-#define LP_RAST_OP_SET_STATE         0x11
-
-#define LP_RAST_OP_MAX               0x12
+#define LP_RAST_OP_RECTANGLE         0xd
+#define LP_RAST_OP_SHADE_TILE        0xe
+#define LP_RAST_OP_SHADE_TILE_OPAQUE 0xf
+#define LP_RAST_OP_BEGIN_QUERY       0x10
+#define LP_RAST_OP_END_QUERY         0x11
+#define LP_RAST_OP_SET_STATE         0x12
+
+#define LP_RAST_OP_MAX               0x13
 #define LP_RAST_OP_MASK              0xff
 
 void
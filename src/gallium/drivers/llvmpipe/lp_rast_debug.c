@@ -38,6 +38,7 @@ static const char *cmd_names[LP_RAST_OP_MAX] =
    "triangle_3_4",
    "triangle_3_16",
    "triangle_4_16",
+   "rectangle",
    "shade_tile",
    "shade_tile_opaque",
    "begin_query",
@@ -61,6 +62,7 @@ get_variant( const struct lp_rast_state *state,
 
    if (block->cmd[k] == LP_RAST_OP_SHADE_TILE ||
        block->cmd[k] == LP_RAST_OP_SHADE_TILE_OPAQUE ||
+       block->cmd[k] == LP_RAST_OP_RECTANGLE ||
        block->cmd[k] == LP_RAST_OP_TRIANGLE_1 ||
        block->cmd[k] == LP_RAST_OP_TRIANGLE_2 ||
        block->cmd[k] == LP_RAST_OP_TRIANGLE_3 ||
@@ -355,12 +357,12 @@ lp_debug_draw_bins_by_coverage( struct lp_scene *scene )
             do_debug_bin(&tile, bin, x, y, FALSE);
 
             total += tile.coverage;
-            possible += 64*64;
+            possible += TILE_SIZE*TILE_SIZE;
 
-            if (tile.coverage == 64*64)
+            if (tile.coverage == TILE_SIZE*TILE_SIZE)
                debug_printf("*");
             else if (tile.coverage) {
-               int bit = tile.coverage/(64.0*64.0)*10;
+               int bit = tile.coverage/((double)TILE_SIZE*TILE_SIZE)*10;
                debug_printf("%c", bits[MIN2(bit,10)]);
             }
             else
@@ -37,6 +37,7 @@
 #include "lp_state.h"
 #include "lp_texture.h"
 #include "lp_limits.h"
+#include "lp_query.h"
 
 
 #define TILE_VECTOR_HEIGHT 4
@@ -76,6 +77,13 @@ extern const struct lp_rasterizer_task *jit_task;
 struct lp_rasterizer;
 struct cmd_bin;
 
+/** Bump one of the per-tile driver query counters */
+#define LP_RAST_COUNT(task, type, n) \
+   ((task)->counters[(type) - LP_QUERY_TILES] += (n))
+
+/** Number of 4x4 blocks in a tile */
+#define LP_HIZ_BLOCKS ((TILE_SIZE / 4) * (TILE_SIZE / 4))
+
 /**
  * Per-thread rasterization state
  */
@@ -83,6 +91,7 @@ struct lp_rasterizer_task
 {
    const struct cmd_bin *bin;
    const struct lp_rast_state *state;
+   boolean render_cond_skip;  /**< state's render condition failed */
 
    struct lp_scene *scene;
    unsigned x, y;          /**< Pos of this tile in framebuffer, in pixels */
@@ -101,6 +110,35 @@ struct lp_rasterizer_task
    struct lp_jit_thread_data thread_data;
    uint64_t ps_invocations;
 
+   /* driver query counters for the current tile, see lp_query.h */
+   uint64_t counters[LP_RAST_COUNTERS];
+   int64_t tile_start;     /**< os_time_get_nano() at lp_rast_tile_begin */
+
+   /**
+    * Min/max depth of each 4x4 block of the tile (layer 0 only), read
+    * from the depth buffer when first needed and dropped whenever the
+    * block's depth values may change.
+    */
+   struct {
+      float zmin[LP_HIZ_BLOCKS];
+      float zmax[LP_HIZ_BLOCKS];
+      boolean valid[LP_HIZ_BLOCKS];
+   } hiz;
+
+   /**
+    * Clears of the tile which haven't been written out yet.  They're done
+    * right before the first command touching the buffers, or at the end of
+    * the tile, and a color clear is dropped altogether when an opaque
+    * shader covers the whole tile.
+    */
+   struct {
+      boolean color;
+      union pipe_color_union color_value;
+      boolean zstencil;
+      uint64_t zstencil_value;
+      uint64_t zstencil_mask;
+   } clear;
+
    pipe_semaphore work_ready;
    pipe_semaphore work_done;
 };
@@ -130,6 +168,10 @@ struct lp_rasterizer
 
    /** For synchronizing the rasterization threads */
    pipe_barrier barrier;
+
+   /** Job run instead of a scene, see lp_rast_run_job() */
+   lp_rast_job_func job_func;
+   void *job_data;
 };
 
 
@@ -139,6 +181,28 @@ lp_rast_shade_quads_mask(struct lp_rasterizer_task *task,
                          unsigned x, unsigned y,
                          unsigned mask);
 
+boolean
+lp_rast_hiz_reject(struct lp_rasterizer_task *task,
+                   const struct lp_rast_shader_inputs *inputs,
+                   unsigned x, unsigned y);
+
+
+/**
+ * Drop the coarse depth of a 4x4 block about to be shaded, if the shader
+ * may change it.
+ * \param x, y location of 4x4 block in window coords
+ */
+static INLINE void
+lp_rast_hiz_invalidate(struct lp_rasterizer_task *task,
+                       const struct lp_rast_shader_inputs *inputs,
+                       unsigned x, unsigned y)
+{
+   if (task->state->variant->writes_depth && inputs->layer == 0) {
+      unsigned i = ((y % TILE_SIZE) / 4) * (TILE_SIZE / 4) + (x % TILE_SIZE) / 4;
+      task->hiz.valid[i] = FALSE;
+   }
+}
+
 
 
 /**
@@ -306,9 +370,16 @@ lp_rast_shade_quads_all( struct lp_rasterizer_task *task,
     * allocated 4x4 blocks hence need to filter them out here.
     */
    if ((x % TILE_SIZE) < task->width && (y % TILE_SIZE) < task->height) {
+      if (lp_rast_hiz_reject(task, inputs, x, y))
+         return;
+
+      lp_rast_hiz_invalidate(task, inputs, x, y);
+
       /* not very accurate would need a popcount on the mask */
       /* always count this not worth bothering? */
       task->ps_invocations++;
+      LP_RAST_COUNT(task, LP_QUERY_BLOCKS_FULL, 1);
+      LP_RAST_COUNT(task, LP_QUERY_FS_INVOCATIONS, 16);
 
       /* run shader on 4x4 block */
       BEGIN_JIT_CALL(state, task);
@@ -354,6 +425,9 @@ void lp_rast_triangle_3_16( struct lp_rasterizer_task *,
 void lp_rast_triangle_4_16( struct lp_rasterizer_task *, 
                             const union lp_rast_cmd_arg );
 
+void lp_rast_rectangle( struct lp_rasterizer_task *,
+                        const union lp_rast_cmd_arg );
+
 void
 lp_rast_set_state(struct lp_rasterizer_task *task,
                   const union lp_rast_cmd_arg arg);
@@ -36,6 +36,17 @@
 #include "lp_rast_priv.h"
 
 
+/**
+ * Triangles are scanned over 64x64 areas, split in 4x4 blocks of 16x16
+ * pixels.  This is the mask of those blocks which are inside the tile, as
+ * tiles smaller than 64x64 only cover part of the area.
+ */
+#if TILE_SIZE >= 64
+#define BLOCK16_MASK 0xffff
+#else
+#define BLOCK16_MASK 0x0033
+#endif
+
 
 
 /**
@@ -487,3 +498,47 @@ lp_rast_triangle_3_4(struct lp_rasterizer_task *task,
 #define NR_PLANES 8
 #include "lp_rast_tri_tmp.h"
 
+
+
+/**
+ * Rasterize the part of an axis aligned rectangle which is in the tile.
+ * The coverage of each 4x4 block comes straight from the bounds.
+ * This is a bin command called during bin processing.
+ */
+void
+lp_rast_rectangle(struct lp_rasterizer_task *task,
+                  const union lp_rast_cmd_arg arg)
+{
+   const struct lp_rast_rectangle *rect = arg.rectangle;
+   const struct lp_rast_shader_inputs *inputs = &rect->inputs;
+   int x0, y0, x1, y1;
+   int x, y;
+
+   if (inputs->disable) {
+      /* This command was partially binned and has been disabled */
+      return;
+   }
+
+   /* Clip to the tile */
+   x0 = MAX2(rect->box.x0, (int) task->x);
+   y0 = MAX2(rect->box.y0, (int) task->y);
+   x1 = MIN2(rect->box.x1, (int) task->x + TILE_SIZE - 1);
+   y1 = MIN2(rect->box.y1, (int) task->y + TILE_SIZE - 1);
+
+   for (y = y0 & ~3; y <= y1; y += 4) {
+      /* one bit per covered row of the block, at the row's first pixel */
+      unsigned rows = ((0x1111 << (4 * MAX2(y0 - y, 0))) &
+                       (0x1111 >> (4 * MAX2(y + 3 - y1, 0))));
+
+      for (x = x0 & ~3; x <= x1; x += 4) {
+         unsigned cols = ((0xf << MAX2(x0 - x, 0)) &
+                          (0xf >> MAX2(x + 3 - x1, 0)));
+         unsigned mask = rows * cols;
+
+         if (mask == 0xffff)
+            lp_rast_shade_quads_all(task, inputs, x, y);
+         else
+            lp_rast_shade_quads_mask(task, inputs, x, y, mask);
+      }
+   }
+}
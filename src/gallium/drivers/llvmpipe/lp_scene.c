@@ -25,6 +25,8 @@
  *
  **************************************************************************/
 
+#include <stdlib.h>
+#include "util/u_atomic.h"
 #include "util/u_framebuffer.h"
 #include "util/u_math.h"
 #include "util/u_memory.h"
@@ -41,6 +43,7 @@
 /** List of resource references */
 struct resource_ref {
    struct pipe_resource *resource[RESOURCE_REF_SZ];
+   unsigned level_mask[RESOURCE_REF_SZ];  /**< mipmap levels read */
    int count;
    struct resource_ref *next;
 };
@@ -62,8 +65,6 @@ lp_scene_create( struct pipe_context *pipe )
    scene->data.head =
       CALLOC_STRUCT(data_block);
 
-   pipe_mutex_init(scene->mutex);
-
 #ifdef DEBUG
    /* Do some scene limit sanity checks here */
    {
@@ -90,13 +91,44 @@ void
 lp_scene_destroy(struct lp_scene *scene)
 {
    lp_fence_reference(&scene->fence, NULL);
-   pipe_mutex_destroy(scene->mutex);
    assert(scene->data.head->next == NULL);
    FREE(scene->data.head);
+
+   while (scene->data.free) {
+      struct data_block *block = scene->data.free;
+      scene->data.free = block->next;
+      FREE(block);
+   }
+
    FREE(scene);
 }
 
 
+/**
+ * Get a data block from the scene's free list, or allocate a new one.
+ */
+static struct data_block *
+lp_scene_get_data_block(struct lp_scene *scene)
+{
+   struct data_block_list *list = &scene->data;
+   struct data_block *block = list->free;
+
+   if (block) {
+      list->free = block->next;
+      list->num_free--;
+   }
+   else {
+      block = MALLOC_STRUCT(data_block);
+      if (!block)
+         return NULL;
+   }
+
+   block->used = 0;
+   block->next = NULL;
+   return block;
+}
+
+
 /**
  * Check if the scene's bins are all empty.
  * For debugging purposes.
@@ -269,7 +301,7 @@ lp_scene_end_rasterization(struct lp_scene *scene )
                       j, scene->resource_reference_size);
    }
 
-   /* Free all scene data blocks:
+   /* Free all scene data blocks, keeping some for the next scene:
     */
    {
       struct data_block_list *list = &scene->data;
@@ -277,7 +309,14 @@ lp_scene_end_rasterization(struct lp_scene *scene )
 
       for (block = list->head->next; block; block = tmp) {
          tmp = block->next;
-	 FREE(block);
+         if (list->num_free < LP_SCENE_MAX_FREE_BLOCKS) {
+            block->next = list->free;
+            list->free = block;
+            list->num_free++;
+         }
+         else {
+            FREE(block);
+         }
       }
 
       list->head->next = NULL;
@@ -301,6 +340,74 @@ lp_scene_end_rasterization(struct lp_scene *scene )
 
 
 
+/**
+ * Move all the commands and data of src to the end of dst, bin by bin.
+ *
+ * This is used to combine scenes binned in parallel: since src's commands
+ * come after dst's ones in each bin, primitive order is kept as long as src
+ * holds primitives which come after those of dst.  Every bin of src starts
+ * with its own LP_RAST_OP_SET_STATE command, so no state is lost.
+ *
+ * src is left without bins or data, but must still be ended with
+ * lp_scene_end_rasterization() to release its framebuffer references.
+ *
+ * \return FALSE if out of memory, in which case nothing is moved
+ */
+boolean
+lp_scene_merge(struct lp_scene *dst, struct lp_scene *src)
+{
+   struct data_block *block, *last;
+   unsigned x, y;
+
+   assert(dst->tiles_x == src->tiles_x);
+   assert(dst->tiles_y == src->tiles_y);
+
+   /* src's current data block goes along with the others, so src needs a
+    * new one.
+    */
+   block = lp_scene_get_data_block(src);
+   if (!block)
+      return FALSE;
+
+   for (y = 0; y < src->tiles_y; y++) {
+      for (x = 0; x < src->tiles_x; x++) {
+         struct cmd_bin *sbin = lp_scene_get_bin(src, x, y);
+         struct cmd_bin *dbin;
+
+         if (!sbin->head)
+            continue;
+
+         dbin = lp_scene_get_bin(dst, x, y);
+         if (dbin->tail)
+            dbin->tail->next = sbin->head;
+         else
+            dbin->head = sbin->head;
+         dbin->tail = sbin->tail;
+         dbin->last_state = sbin->last_state;
+
+         sbin->head = NULL;
+         sbin->tail = NULL;
+         sbin->last_state = NULL;
+      }
+   }
+
+   /* Splice src's data blocks right after dst's current block, so dst
+    * keeps allocating from where it was.
+    */
+   last = src->data.head;
+   while (last->next)
+      last = last->next;
+   last->next = dst->data.head->next;
+   dst->data.head->next = src->data.head;
+   src->data.head = block;
+
+   dst->scene_size += src->scene_size;
+   src->scene_size = 0;
+
+   return TRUE;
+}
+
+
 struct cmd_block *
 lp_scene_new_cmd_block( struct lp_scene *scene,
                         struct cmd_bin *bin )
@@ -332,13 +439,12 @@ lp_scene_new_data_block( struct lp_scene *scene )
       return NULL;
    }
    else {
-      struct data_block *block = MALLOC_STRUCT(data_block);
+      struct data_block *block = lp_scene_get_data_block(scene);
       if (block == NULL)
          return NULL;
-      
+
       scene->scene_size += sizeof *block;
 
-      block->used = 0;
       block->next = scene->data.head;
       scene->data.head = block;
 
@@ -365,11 +471,13 @@ lp_scene_data_size( const struct lp_scene *scene )
 
 
 /**
- * Add a reference to a resource by the scene.
+ * Add a reference to a resource by the scene, which may read the mipmap
+ * levels in level_mask.
  */
 boolean
 lp_scene_add_resource_reference(struct lp_scene *scene,
                                 struct pipe_resource *resource,
+                                unsigned level_mask,
                                 boolean initializing_scene)
 {
    struct resource_ref *ref, **last = &scene->resources;
@@ -382,9 +490,12 @@ lp_scene_add_resource_reference(struct lp_scene *scene,
 
       /* Search for this resource:
        */
-      for (i = 0; i < ref->count; i++)
-         if (ref->resource[i] == resource)
+      for (i = 0; i < ref->count; i++) {
+         if (ref->resource[i] == resource) {
+            ref->level_mask[i] |= level_mask;
             return TRUE;
+         }
+      }
 
       if (ref->count < RESOURCE_REF_SZ) {
          /* If the block is half-empty, then append the reference here.
@@ -407,6 +518,7 @@ lp_scene_add_resource_reference(struct lp_scene *scene,
 
    /* Append the reference to the reference block.
     */
+   ref->level_mask[ref->count] = level_mask;
    pipe_resource_reference(&ref->resource[ref->count++], resource);
    scene->resource_reference_size += llvmpipe_resource_size(resource);
 
@@ -424,11 +536,12 @@ lp_scene_add_resource_reference(struct lp_scene *scene,
 
 
 /**
- * Does this scene have a reference to the given resource?
+ * Does this scene read the given mipmap level of the resource?
  */
 boolean
 lp_scene_is_resource_referenced(const struct lp_scene *scene,
-                                const struct pipe_resource *resource)
+                                const struct pipe_resource *resource,
+                                unsigned level)
 {
    const struct resource_ref *ref;
    int i;
@@ -436,7 +549,7 @@ lp_scene_is_resource_referenced(const struct lp_scene *scene,
    for (ref = scene->resources; ref; ref = ref->next) {
       for (i = 0; i < ref->count; i++)
          if (ref->resource[i] == resource)
-            return TRUE;
+            return (ref->level_mask[i] >> level) & 1;
    }
 
    return FALSE;
@@ -445,61 +558,112 @@ lp_scene_is_resource_referenced(const struct lp_scene *scene,
 
 
 
-/** advance curr_x,y to the next bin */
-static boolean
-next_bin(struct lp_scene *scene)
+static int
+compare_bin_work(const void *a, const void *b)
 {
-   scene->curr_x++;
-   if (scene->curr_x >= scene->tiles_x) {
-      scene->curr_x = 0;
-      scene->curr_y++;
+   const struct lp_scene_bin_work *wa = (const struct lp_scene_bin_work *) a;
+   const struct lp_scene_bin_work *wb = (const struct lp_scene_bin_work *) b;
+
+   if (wa->cost != wb->cost)
+      return wa->cost > wb->cost ? -1 : 1;
+   if (wa->y != wb->y)
+      return wa->y < wb->y ? -1 : 1;
+   return wa->x < wb->x ? -1 : (wa->x > wb->x ? 1 : 0);
+}
+
+
+/**
+ * Prepare the per-thread bin queues.
+ * Called once per scene by one thread, before any lp_scene_bin_iter_next().
+ */
+void
+lp_scene_bin_iter_begin( struct lp_scene *scene, unsigned num_threads )
+{
+   unsigned num_queues = MAX2(1, MIN2(num_threads, LP_MAX_THREADS));
+   unsigned x, y, i;
+
+   scene->num_bin_work = 0;
+
+   for (y = 0; y < scene->tiles_y; y++) {
+      for (x = 0; x < scene->tiles_x; x++) {
+         const struct cmd_bin *bin = lp_scene_get_bin(scene, x, y);
+         const struct cmd_block *block;
+         unsigned cost = 0;
+
+         for (block = bin->head; block; block = block->next)
+            cost += block->count;
+
+         if (cost) {
+            struct lp_scene_bin_work *work =
+               &scene->bin_work[scene->num_bin_work++];
+            work->cost = cost;
+            work->x = x;
+            work->y = y;
+         }
+      }
    }
-   if (scene->curr_y >= scene->tiles_y) {
-      /* no more bins */
-      return FALSE;
+
+   /* Hand out the most expensive bins first, to reduce the scene's tail */
+   if (num_queues > 1) {
+      qsort(scene->bin_work, scene->num_bin_work,
+            sizeof scene->bin_work[0], compare_bin_work);
+   }
+
+   scene->num_bin_queues = num_queues;
+   for (i = 0; i < num_queues; i++) {
+      scene->bin_queue[i].next = 0;
+      scene->bin_queue[i].count =
+         (scene->num_bin_work + num_queues - 1 - i) / num_queues;
    }
-   return TRUE;
 }
 
 
-void
-lp_scene_bin_iter_begin( struct lp_scene *scene )
+/**
+ * Try to claim the next entry of the given queue.
+ * \return  index into scene->bin_work, or -1 when the queue is empty
+ */
+static int
+claim_bin_work(struct lp_scene *scene, unsigned queue)
 {
-   scene->curr_x = scene->curr_y = -1;
+   int32_t *next = &scene->bin_queue[queue].next;
+   int32_t count = scene->bin_queue[queue].count;
+   int32_t old;
+
+   do {
+      old = p_atomic_read(next);
+      if (old >= count)
+         return -1;
+   } while (p_atomic_cmpxchg(next, old, old + 1) != old);
+
+   return queue + old * scene->num_bin_queues;
 }
 
 
 /**
- * Return pointer to next bin to be rendered.
- * The lp_scene::curr_x and ::curr_y fields will be advanced.
+ * Return pointer to next bin to be rendered by the given thread.
  * Multiple rendering threads will call this function to get a chunk
- * of work (a bin) to work on.
+ * of work (a bin) to work on.  Threads take bins from their own queue
+ * first and steal from the other threads' queues afterwards.
  */
 struct cmd_bin *
-lp_scene_bin_iter_next( struct lp_scene *scene , int *x, int *y)
+lp_scene_bin_iter_next( struct lp_scene *scene, unsigned thread_index,
+                        int *x, int *y )
 {
-   struct cmd_bin *bin = NULL;
-
-   pipe_mutex_lock(scene->mutex);
-
-   if (scene->curr_x < 0) {
-      /* first bin */
-      scene->curr_x = 0;
-      scene->curr_y = 0;
-   }
-   else if (!next_bin(scene)) {
-      /* no more bins left */
-      goto end;
+   unsigned num_queues = scene->num_bin_queues;
+   unsigned own = thread_index % num_queues;
+   unsigned i;
+
+   for (i = 0; i < num_queues; i++) {
+      int index = claim_bin_work(scene, (own + i) % num_queues);
+      if (index >= 0) {
+         const struct lp_scene_bin_work *work = &scene->bin_work[index];
+         *x = work->x;
+         *y = work->y;
+         return lp_scene_get_bin(scene, work->x, work->y);
+      }
    }
 
-   bin = lp_scene_get_bin(scene, scene->curr_x, scene->curr_y);
-   *x = scene->curr_x;
-   *y = scene->curr_y;
-
-end:
-   /*printf("return bin %p at %d, %d\n", (void *) bin, *bin_x, *bin_y);*/
-   pipe_mutex_unlock(scene->mutex);
-   return bin;
+   return NULL;
 }
 
 
@@ -62,6 +62,11 @@ struct lp_rast_state;
  */
 #define LP_SCENE_MAX_SIZE (9*1024*1024)
 
+/* Data blocks kept around for the next use of a scene, instead of being
+ * freed when it's been rasterized:
+ */
+#define LP_SCENE_MAX_FREE_BLOCKS ((4*1024*1024) / DATA_BLOCK_SIZE)
+
 /* The maximum amount of texture storage referenced by a scene is
  * clamped ot this size:
  */
@@ -113,10 +118,23 @@ struct cmd_bin {
 struct data_block_list {
    struct data_block first;
    struct data_block *head;
+
+   /** Blocks of previous uses of the scene, ready to be reused */
+   struct data_block *free;
+   unsigned num_free;
 };
 
 struct resource_ref;
 
+/**
+ * A bin to be rasterized, and its estimated cost.
+ */
+struct lp_scene_bin_work {
+   unsigned cost;
+   unsigned short x, y;
+};
+
+
 /**
  * All bins and bin data are contained here.
  * Per-bin data goes into the 'tile' bins.
@@ -130,7 +148,7 @@ struct lp_scene {
    struct lp_fence *fence;
 
    /* The queries still active at end of scene */
-   struct llvmpipe_query *active_queries[LP_MAX_ACTIVE_BINNED_QUERIES];
+   struct llvmpipe_query *active_queries[LP_MAX_ACTIVE_QUERIES];
    unsigned num_active_queries;
    /* If queries were either active or there were begin/end query commands */
    boolean had_queries;
@@ -173,8 +191,25 @@ struct lp_scene {
     */
    unsigned tiles_x, tiles_y;
 
-   int curr_x, curr_y;  /**< for iterating over bins */
-   pipe_mutex mutex;
+   /**
+    * Non-empty bins, sorted by decreasing number of commands.  Filled in by
+    * lp_scene_bin_iter_begin().
+    */
+   struct lp_scene_bin_work bin_work[TILES_X * TILES_Y];
+   unsigned num_bin_work;
+
+   /**
+    * One queue per rasterizer thread.  Queue i holds the bin_work entries
+    * i, i + num_bin_queues, i + 2 * num_bin_queues, ..., so every thread
+    * starts on the most expensive bins.  Entries are claimed with an atomic
+    * compare-and-swap on ::next, by the owning thread first, and by the
+    * other threads once their own queue is drained.
+    */
+   struct {
+      int32_t next;
+      int32_t count;
+   } bin_queue[LP_MAX_THREADS];
+   unsigned num_bin_queues;
 
    struct cmd_bin tile[TILES_X][TILES_Y];
    struct data_block_list data;
@@ -197,10 +232,14 @@ struct cmd_block *lp_scene_new_cmd_block( struct lp_scene *scene,
 
 boolean lp_scene_add_resource_reference(struct lp_scene *scene,
                                         struct pipe_resource *resource,
+                                        unsigned level_mask,
                                         boolean initializing_scene);
 
+boolean lp_scene_merge(struct lp_scene *dst, struct lp_scene *src);
+
 boolean lp_scene_is_resource_referenced(const struct lp_scene *scene,
-                                        const struct pipe_resource *resource );
+                                        const struct pipe_resource *resource,
+                                        unsigned level);
 
 
 /**
@@ -379,10 +418,11 @@ lp_scene_get_num_bins( const struct lp_scene *scene )
 
 
 void
-lp_scene_bin_iter_begin( struct lp_scene *scene );
+lp_scene_bin_iter_begin( struct lp_scene *scene, unsigned num_threads );
 
 struct cmd_bin *
-lp_scene_bin_iter_next( struct lp_scene *scene, int *x, int *y );
+lp_scene_bin_iter_next( struct lp_scene *scene, unsigned thread_index,
+                        int *x, int *y );
 
 
 
@@ -29,8 +29,10 @@
 #include "util/u_memory.h"
 #include "util/u_math.h"
 #include "util/u_cpu_detect.h"
+#include "util/u_disk_cache.h"
 #include "util/u_format.h"
 #include "util/u_string.h"
+#include "util/u_simple_list.h"
 #include "util/u_format_s3tc.h"
 #include "pipe/p_defines.h"
 #include "pipe/p_screen.h"
@@ -45,11 +47,17 @@
 #include "lp_context.h"
 #include "lp_debug.h"
 #include "lp_public.h"
+#include "lp_query.h"
 #include "lp_limits.h"
 #include "lp_rast.h"
 
 #include "state_tracker/sw_winsys.h"
 
+#if defined(PIPE_OS_UNIX)
+#include <dlfcn.h>
+#include <sys/stat.h>
+#endif
+
 #ifdef DEBUG
 int LP_DEBUG = 0;
 
@@ -80,6 +88,8 @@ static const struct debug_named_value lp_perf_flags[] = {
    { "no_blend",       PERF_NO_BLEND, NULL },
    { "no_depth",       PERF_NO_DEPTH, NULL },
    { "no_alphatest",   PERF_NO_ALPHATEST, NULL },
+   { "no_hiz",         PERF_NO_HIZ, NULL },
+   { "tiled_tex",      PERF_TILED_TEX, NULL },
    DEBUG_NAMED_VALUE_END
 };
 
@@ -203,7 +213,7 @@ llvmpipe_get_param(struct pipe_screen *screen, enum pipe_cap param)
    case PIPE_CAP_QUADS_FOLLOW_PROVOKING_VERTEX_CONVENTION:
       return 0;
    case PIPE_CAP_COMPUTE:
-      return 0;
+      return 1;
    case PIPE_CAP_USER_VERTEX_BUFFERS:
    case PIPE_CAP_USER_INDEX_BUFFERS:
       return 1;
@@ -246,6 +256,7 @@ llvmpipe_get_shader_param(struct pipe_screen *screen, unsigned shader, enum pipe
    switch(shader)
    {
    case PIPE_SHADER_FRAGMENT:
+   case PIPE_SHADER_COMPUTE:
       switch (param) {
       default:
          return gallivm_get_shader_param(param);
@@ -270,6 +281,82 @@ llvmpipe_get_shader_param(struct pipe_screen *screen, unsigned shader, enum pipe
    }
 }
 
+static int
+llvmpipe_get_compute_param(struct pipe_screen *screen,
+                           enum pipe_compute_cap param,
+                           void *ret)
+{
+   switch (param) {
+   case PIPE_COMPUTE_CAP_IR_TARGET:
+      if (ret)
+         strcpy(ret, "llvmpipe");
+      return strlen("llvmpipe") + 1;
+   case PIPE_COMPUTE_CAP_GRID_DIMENSION:
+      if (ret) {
+         uint64_t *grid_dimension = ret;
+         grid_dimension[0] = 3;
+      }
+      return sizeof(uint64_t);
+   case PIPE_COMPUTE_CAP_MAX_GRID_SIZE:
+      if (ret) {
+         uint64_t *grid_size = ret;
+         grid_size[0] = 65535;
+         grid_size[1] = 65535;
+         grid_size[2] = 65535;
+      }
+      return 3 * sizeof(uint64_t);
+   case PIPE_COMPUTE_CAP_MAX_BLOCK_SIZE:
+      if (ret) {
+         uint64_t *block_size = ret;
+         block_size[0] = LP_MAX_CS_THREADS_PER_BLOCK;
+         block_size[1] = LP_MAX_CS_THREADS_PER_BLOCK;
+         block_size[2] = LP_MAX_CS_THREADS_PER_BLOCK;
+      }
+      return 3 * sizeof(uint64_t);
+   case PIPE_COMPUTE_CAP_MAX_THREADS_PER_BLOCK:
+      if (ret) {
+         uint64_t *max_threads_per_block = ret;
+         *max_threads_per_block = LP_MAX_CS_THREADS_PER_BLOCK;
+      }
+      return sizeof(uint64_t);
+   case PIPE_COMPUTE_CAP_MAX_GLOBAL_SIZE:
+      if (ret) {
+         /* every global buffer must be addressable with the offset bits */
+         uint64_t *max_global_size = ret;
+         *max_global_size = (uint64_t) LP_MAX_GLOBAL_BUFFERS <<
+                            LP_GLOBAL_OFFSET_BITS;
+      }
+      return sizeof(uint64_t);
+   case PIPE_COMPUTE_CAP_MAX_LOCAL_SIZE:
+      if (ret) {
+         uint64_t *max_local_size = ret;
+         *max_local_size = 32768;
+      }
+      return sizeof(uint64_t);
+   case PIPE_COMPUTE_CAP_MAX_PRIVATE_SIZE:
+      if (ret) {
+         uint64_t *max_private_size = ret;
+         *max_private_size = 4096;
+      }
+      return sizeof(uint64_t);
+   case PIPE_COMPUTE_CAP_MAX_INPUT_SIZE:
+      if (ret) {
+         uint64_t *max_input_size = ret;
+         *max_input_size = 4096;
+      }
+      return sizeof(uint64_t);
+   case PIPE_COMPUTE_CAP_MAX_MEM_ALLOC_SIZE:
+      if (ret) {
+         uint64_t *max_mem_alloc_size = ret;
+         *max_mem_alloc_size = 1 << LP_GLOBAL_OFFSET_BITS;
+      }
+      return sizeof(uint64_t);
+   }
+   /* should only get here on unhandled cases */
+   debug_printf("Unexpected PIPE_COMPUTE_CAP %d query\n", param);
+   return 0;
+}
+
 static float
 llvmpipe_get_paramf(struct pipe_screen *screen, enum pipe_capf param)
 {
@@ -283,7 +370,7 @@ llvmpipe_get_paramf(struct pipe_screen *screen, enum pipe_capf param)
    case PIPE_CAPF_MAX_POINT_WIDTH_AA:
       return 255.0; /* arbitrary */
    case PIPE_CAPF_MAX_TEXTURE_ANISOTROPY:
-      return 16.0; /* not actually signficant at this time */
+      return (float) LP_MAX_ANISO_PROBES;
    case PIPE_CAPF_MAX_TEXTURE_LOD_BIAS:
       return 16.0; /* arbitrary */
    case PIPE_CAPF_GUARD_BAND_LEFT:
@@ -416,21 +503,100 @@ llvmpipe_destroy_screen( struct pipe_screen *_screen )
 {
    struct llvmpipe_screen *screen = llvmpipe_screen(_screen);
    struct sw_winsys *winsys = screen->winsys;
+   unsigned i;
+
+   for (i = 0; i < screen->num_rasts; i++)
+      lp_rast_destroy(screen->rast[i]);
 
-   if (screen->rast)
-      lp_rast_destroy(screen->rast);
+   lp_delete_setup_variants(screen);
+   pipe_mutex_destroy(screen->setup_variants_mutex);
 
    lp_jit_screen_cleanup(screen);
 
+   util_disk_cache_destroy(screen->fs_cache);
+
    if(winsys->destroy)
       winsys->destroy(winsys);
 
    pipe_mutex_destroy(screen->rast_mutex);
+   pipe_condvar_destroy(screen->rast_cond);
 
    FREE(screen);
 }
 
 
+/**
+ * Borrow a rasterizer for one scene, waiting for one to be free if needed.
+ * Callers get rasterizers in the order they asked for them.
+ * \param wait_nano  incremented by the time spent waiting
+ */
+struct lp_rasterizer *
+lp_screen_acquire_rast(struct llvmpipe_screen *screen, uint64_t *wait_nano)
+{
+   struct lp_rasterizer *rast = NULL;
+   int64_t start = 0;
+   unsigned ticket;
+   unsigned i;
+
+   pipe_mutex_lock(screen->rast_mutex);
+
+   ticket = screen->rast_next_ticket++;
+
+   while (1) {
+      if (ticket == screen->rast_serving) {
+         for (i = 0; i < screen->num_rasts; i++) {
+            if (!screen->rast_busy[i])
+               break;
+         }
+         if (i < screen->num_rasts)
+            break;
+      }
+
+      if (!start)
+         start = os_time_get_nano();
+      pipe_condvar_wait(screen->rast_cond, screen->rast_mutex);
+   }
+
+   screen->rast_busy[i] = TRUE;
+   rast = screen->rast[i];
+   screen->rast_serving++;
+
+   /* the next waiter may be able to take another free rasterizer */
+   if (screen->rast_serving != screen->rast_next_ticket)
+      pipe_condvar_broadcast(screen->rast_cond);
+
+   pipe_mutex_unlock(screen->rast_mutex);
+
+   if (start)
+      *wait_nano += os_time_get_nano() - start;
+
+   return rast;
+}
+
+
+void
+lp_screen_release_rast(struct llvmpipe_screen *screen,
+                       struct lp_rasterizer *rast)
+{
+   unsigned i;
+
+   pipe_mutex_lock(screen->rast_mutex);
+
+   for (i = 0; i < screen->num_rasts; i++) {
+      if (screen->rast[i] == rast) {
+         assert(screen->rast_busy[i]);
+         screen->rast_busy[i] = FALSE;
+         break;
+      }
+   }
+
+   if (screen->rast_serving != screen->rast_next_ticket)
+      pipe_condvar_broadcast(screen->rast_cond);
+
+   pipe_mutex_unlock(screen->rast_mutex);
+}
+
+
 
 
 /**
@@ -480,6 +646,39 @@ llvmpipe_get_timestamp(struct pipe_screen *_screen)
    return os_time_get_nano();
 }
 
+/**
+ * Open the fragment shader cache in LP_SHADER_CACHE_DIR, if that is set.
+ */
+static struct util_disk_cache *
+lp_fs_cache_create(void)
+{
+#if defined(PIPE_OS_UNIX)
+   const char *cache_dir = debug_get_option("LP_SHADER_CACHE_DIR", NULL);
+   struct stat st;
+   Dl_info info;
+   char id[128];
+
+   if (!cache_dir)
+      return NULL;
+
+   /* The JIT context layouts may change on every rebuild, and we use the
+    * driver's own file to tell builds apart.
+    */
+   if (!dladdr((void *) lp_fs_cache_create, &info) ||
+       info.dli_fname == NULL ||
+       stat(info.dli_fname, &st) != 0)
+      return NULL;
+
+   util_snprintf(id, sizeof id, "llvmpipe fs LLVM %u.%u %lx %lx",
+                 HAVE_LLVM >> 8, HAVE_LLVM & 0xff,
+                 (unsigned long) st.st_mtime, (unsigned long) st.st_size);
+   return util_disk_cache_create(cache_dir, id);
+#else
+   return NULL;
+#endif
+}
+
+
 /**
  * Create a new pipe_screen object
  * Note: we're not presently subclassing pipe_screen (no llvmpipe_screen).
@@ -488,6 +687,7 @@ struct pipe_screen *
 llvmpipe_create_screen(struct sw_winsys *winsys)
 {
    struct llvmpipe_screen *screen;
+   unsigned i;
 
    util_cpu_detect();
 
@@ -515,6 +715,7 @@ llvmpipe_create_screen(struct sw_winsys *winsys)
    screen->base.get_vendor = llvmpipe_get_vendor;
    screen->base.get_param = llvmpipe_get_param;
    screen->base.get_shader_param = llvmpipe_get_shader_param;
+   screen->base.get_compute_param = llvmpipe_get_compute_param;
    screen->base.get_paramf = llvmpipe_get_paramf;
    screen->base.is_format_supported = llvmpipe_is_format_supported;
 
@@ -525,6 +726,7 @@ llvmpipe_create_screen(struct sw_winsys *winsys)
    screen->base.fence_finish = llvmpipe_fence_finish;
 
    screen->base.get_timestamp = llvmpipe_get_timestamp;
+   screen->base.get_driver_query_info = llvmpipe_get_driver_query_info;
 
    llvmpipe_init_screen_resource_funcs(&screen->base);
 
@@ -537,13 +739,41 @@ llvmpipe_create_screen(struct sw_winsys *winsys)
    screen->num_threads = debug_get_num_option("LP_NUM_THREADS", screen->num_threads);
    screen->num_threads = MIN2(screen->num_threads, LP_MAX_THREADS);
 
-   screen->rast = lp_rast_create(screen->num_threads);
-   if (!screen->rast) {
-      lp_jit_screen_cleanup(screen);
-      FREE(screen);
-      return NULL;
+   /* Split the threads evenly into LP_NUM_RASTERIZERS rasterizers, so that
+    * that many contexts can rasterize at the same time.  Without threads
+    * each rasterizer runs on the thread of the context using it.
+    */
+   screen->num_rasts = debug_get_num_option("LP_NUM_RASTERIZERS", 1);
+   screen->num_rasts = CLAMP(screen->num_rasts, 1, LP_MAX_RASTERIZERS);
+   if (screen->num_threads) {
+      screen->num_rasts = MIN2(screen->num_rasts, screen->num_threads);
+      screen->num_threads /= screen->num_rasts;
+   }
+
+   for (i = 0; i < MAX2(1, screen->num_threads); i++) {
+      util_snprintf(screen->rast_thread_query_names[i],
+                    sizeof screen->rast_thread_query_names[i],
+                    "rast-thread%u-ns", i);
+   }
+
+   for (i = 0; i < screen->num_rasts; i++) {
+      screen->rast[i] = lp_rast_create(screen->num_threads,
+                                       i * screen->num_threads);
+      if (!screen->rast[i]) {
+         while (i--)
+            lp_rast_destroy(screen->rast[i]);
+         lp_jit_screen_cleanup(screen);
+         FREE(screen);
+         return NULL;
+      }
    }
    pipe_mutex_init(screen->rast_mutex);
+   pipe_condvar_init(screen->rast_cond);
+
+   make_empty_list(&screen->setup_variants_list);
+   pipe_mutex_init(screen->setup_variants_mutex);
+
+   screen->fs_cache = lp_fs_cache_create();
 
    util_format_s3tc_init();
 
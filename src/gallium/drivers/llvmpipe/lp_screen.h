@@ -38,9 +38,12 @@
 #include "pipe/p_defines.h"
 #include "os/os_thread.h"
 #include "gallivm/lp_bld.h"
+#include "lp_limits.h"
+#include "lp_state_setup.h"
 
 
 struct sw_winsys;
+struct util_disk_cache;
 
 
 struct llvmpipe_screen
@@ -49,14 +52,36 @@ struct llvmpipe_screen
 
    struct sw_winsys *winsys;
 
-   unsigned num_threads;
+   unsigned num_threads;   /**< threads per rasterizer */
 
    /* Increments whenever textures are modified.  Contexts can track this.
     */
    unsigned timestamp;
 
-   struct lp_rasterizer *rast;
+   /**
+    * The rasterizers.  Contexts borrow one per scene, with
+    * lp_screen_acquire_rast(), so that scenes of different contexts are
+    * rasterized concurrently.  Waiting contexts are served in order.
+    */
+   struct lp_rasterizer *rast[LP_MAX_RASTERIZERS];
+   boolean rast_busy[LP_MAX_RASTERIZERS];
+   unsigned num_rasts;
+   unsigned rast_next_ticket;   /**< next ticket to hand to a waiter */
+   unsigned rast_serving;       /**< ticket allowed to take a rasterizer */
    pipe_mutex rast_mutex;
+   pipe_condvar rast_cond;
+
+   /** Setup variants, shared by all the contexts, most recently used first */
+   struct lp_setup_variant_list_item setup_variants_list;
+   unsigned nr_setup_variants;
+   size_t setup_code_size;
+   pipe_mutex setup_variants_mutex;
+
+   /** Persistent cache of fragment shader machine code, may be NULL */
+   struct util_disk_cache *fs_cache;
+
+   /** Names of the per-thread LP_QUERY_RAST_THREAD_TIME driver queries */
+   char rast_thread_query_names[LP_MAX_THREADS][24];
 };
 
 
@@ -70,4 +95,13 @@ llvmpipe_screen( struct pipe_screen *pipe )
 
 
 
+struct lp_rasterizer *
+lp_screen_acquire_rast(struct llvmpipe_screen *screen, uint64_t *wait_nano);
+
+void
+lp_screen_release_rast(struct llvmpipe_screen *screen,
+                       struct lp_rasterizer *rast);
+
+
+
 #endif /* LP_SCREEN_H */
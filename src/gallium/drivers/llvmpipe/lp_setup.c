@@ -68,13 +68,40 @@ lp_setup_get_empty_scene(struct lp_setup_context *setup)
    struct llvmpipe_context *lp = llvmpipe_context(setup->pipe);
    boolean discard = lp->rasterizer ? lp->rasterizer->rasterizer_discard : FALSE;
 
+   unsigned queued_size = 0;
+   unsigned i;
+
    assert(setup->scene == NULL);
 
    setup->scene_idx++;
-   setup->scene_idx %= Elements(setup->scenes);
+   setup->scene_idx %= setup->num_scenes;
 
    setup->scene = setup->scenes[setup->scene_idx];
 
+   /* Besides waiting for the scene we're about to reuse, throttle on the
+    * memory held by the scenes still waiting to be rasterized, oldest
+    * first, so that a deep pipeline of big scenes doesn't exhaust memory.
+    */
+   for (i = 1; i < setup->num_scenes; i++) {
+      struct lp_scene *scene =
+         setup->scenes[(setup->scene_idx + i) % setup->num_scenes];
+      if (scene->fence && !lp_fence_signalled(scene->fence))
+         queued_size += scene->scene_size;
+   }
+
+   for (i = 1; i < setup->num_scenes &&
+               queued_size > setup->max_queued_scene_size; i++) {
+      struct lp_scene *scene =
+         setup->scenes[(setup->scene_idx + i) % setup->num_scenes];
+      if (scene->fence && !lp_fence_signalled(scene->fence)) {
+         if (LP_DEBUG & DEBUG_SETUP)
+            debug_printf("%s: throttle on scene %d (%u bytes queued)\n",
+                         __FUNCTION__, scene->fence->id, queued_size);
+         queued_size -= MIN2(queued_size, scene->scene_size);
+         lp_fence_wait(scene->fence);
+      }
+   }
+
    if (setup->scene->fence) {
       if (LP_DEBUG & DEBUG_SETUP)
          debug_printf("%s: wait for scene %d\n",
@@ -154,6 +181,7 @@ lp_setup_rasterize_scene( struct lp_setup_context *setup )
 {
    struct lp_scene *scene = setup->scene;
    struct llvmpipe_screen *screen = llvmpipe_screen(scene->pipe->screen);
+   struct lp_rasterizer *rast;
 
    scene->num_active_queries = setup->active_binned_queries;
    memcpy(scene->active_queries, setup->active_queries,
@@ -166,10 +194,10 @@ lp_setup_rasterize_scene( struct lp_setup_context *setup )
    if (setup->last_fence)
       setup->last_fence->issued = TRUE;
 
-   pipe_mutex_lock(screen->rast_mutex);
-   lp_rast_queue_scene(screen->rast, scene);
-   lp_rast_finish(screen->rast);
-   pipe_mutex_unlock(screen->rast_mutex);
+   rast = lp_screen_acquire_rast(screen, &setup->rast_wait_nano);
+   lp_rast_queue_scene(rast, scene);
+   lp_rast_finish(rast);
+   lp_screen_release_rast(screen, rast);
 
    lp_scene_end_rasterization(setup->scene);
    lp_setup_reset( setup );
@@ -647,6 +675,144 @@ lp_setup_set_vertex_info( struct lp_setup_context *setup,
 }
 
 
+/**
+ * Describe a sampler view to the generated code.  The caller must keep a
+ * reference to the view's texture while jit_tex is in use.
+ */
+void
+lp_setup_jit_texture(struct lp_jit_texture *jit_tex,
+                     const struct pipe_sampler_view *view)
+{
+   struct pipe_resource *res = view->texture;
+   struct llvmpipe_resource *lp_tex = llvmpipe_resource(res);
+
+   if (!lp_tex->dt) {
+      /* regular texture - setup array of mipmap level offsets */
+      void *mip_ptr;
+      int j;
+      unsigned first_level = 0;
+      unsigned last_level = 0;
+
+      if (llvmpipe_resource_is_texture(res)) {
+         first_level = view->u.tex.first_level;
+         last_level = view->u.tex.last_level;
+         assert(first_level <= last_level);
+         assert(last_level <= res->last_level);
+
+         /*
+          * The complexity here should no longer be necessary.
+          */
+         mip_ptr = llvmpipe_get_texture_image_all(lp_tex, first_level,
+                                                  LP_TEX_USAGE_READ);
+         jit_tex->base = lp_tex->linear_img.data;
+      }
+      else {
+         mip_ptr = lp_tex->data;
+         jit_tex->base = mip_ptr;
+      }
+
+      if ((LP_PERF & PERF_TEX_MEM) || !mip_ptr) {
+         /* out of memory - use dummy tile memory */
+         /* Note if using PERF_TEX_MEM will also skip tile conversion */
+         jit_tex->base = lp_dummy_tile;
+         jit_tex->width = TILE_SIZE/8;
+         jit_tex->height = TILE_SIZE/8;
+         jit_tex->depth = 1;
+         jit_tex->first_level = 0;
+         jit_tex->last_level = 0;
+         jit_tex->mip_offsets[0] = 0;
+         jit_tex->row_stride[0] = 0;
+         jit_tex->img_stride[0] = 0;
+      }
+      else {
+         jit_tex->width = res->width0;
+         jit_tex->height = res->height0;
+         jit_tex->depth = res->depth0;
+         jit_tex->first_level = first_level;
+         jit_tex->last_level = last_level;
+
+         if (llvmpipe_resource_is_texture(res)) {
+            for (j = first_level; j <= last_level; j++) {
+               mip_ptr = llvmpipe_get_texture_image_all(lp_tex, j,
+                                                        LP_TEX_USAGE_READ);
+               jit_tex->mip_offsets[j] = (uint8_t *)mip_ptr - (uint8_t *)jit_tex->base;
+               /*
+                * could get mip offset directly but need call above to
+                * invoke tiled->linear conversion.
+                */
+               assert(lp_tex->linear_mip_offsets[j] == jit_tex->mip_offsets[j]);
+               jit_tex->row_stride[j] = lp_tex->row_stride[j];
+               jit_tex->img_stride[j] = lp_tex->img_stride[j];
+            }
+
+            if (lp_tex->tiled) {
+               /*
+                * The tiled copy shares the mip offsets and strides of the
+                * linear image, the shaders do the swizzling.
+                */
+               llvmpipe_update_tiled_texture(lp_tex, first_level, last_level);
+               jit_tex->base = lp_tex->tiled_img.data;
+            }
+
+            if (res->target == PIPE_TEXTURE_1D_ARRAY ||
+                res->target == PIPE_TEXTURE_2D_ARRAY) {
+               /*
+                * For array textures, we don't have first_layer, instead
+                * adjust last_layer (stored as depth) plus the mip level offsets
+                * (as we have mip-first layout can't just adjust base ptr).
+                * XXX For mip levels, could do something similar.
+                */
+               jit_tex->depth = view->u.tex.last_layer - view->u.tex.first_layer + 1;
+               for (j = first_level; j <= last_level; j++) {
+                  jit_tex->mip_offsets[j] += view->u.tex.first_layer *
+                                             lp_tex->img_stride[j];
+               }
+               assert(view->u.tex.first_layer <= view->u.tex.last_layer);
+               assert(view->u.tex.last_layer < res->array_size);
+            }
+         }
+         else {
+            /*
+             * For buffers, we don't have first_element, instead adjust
+             * last_element (stored as width) plus the base pointer.
+             */
+            unsigned view_blocksize = util_format_get_blocksize(view->format);
+            /* probably don't really need to fill that out */
+            jit_tex->mip_offsets[0] = 0;
+            jit_tex->row_stride[0] = 0;
+            jit_tex->row_stride[0] = 0;
+
+            /* everything specified in number of elements here. */
+            jit_tex->width = view->u.buf.last_element - view->u.buf.first_element + 1;
+            jit_tex->base = (uint8_t *)jit_tex->base + view->u.buf.first_element *
+                            view_blocksize;
+            /* XXX Unsure if we need to sanitize parameters? */
+            assert(view->u.buf.first_element <= view->u.buf.last_element);
+            assert(view->u.buf.last_element * view_blocksize < res->width0);
+         }
+      }
+   }
+   else {
+      /* display target texture/surface */
+      /*
+       * XXX: Where should this be unmapped?
+       */
+      struct llvmpipe_screen *screen = llvmpipe_screen(res->screen);
+      struct sw_winsys *winsys = screen->winsys;
+      jit_tex->base = winsys->displaytarget_map(winsys, lp_tex->dt,
+                                                   PIPE_TRANSFER_READ);
+      jit_tex->row_stride[0] = lp_tex->row_stride[0];
+      jit_tex->img_stride[0] = lp_tex->img_stride[0];
+      jit_tex->mip_offsets[0] = 0;
+      jit_tex->width = res->width0;
+      jit_tex->height = res->height0;
+      jit_tex->depth = res->depth0;
+      jit_tex->first_level = jit_tex->last_level = 0;
+      assert(jit_tex->base);
+   }
+}
+
+
 /**
  * Called during state validation when LP_NEW_SAMPLER_VIEW is set.
  */
@@ -665,131 +831,23 @@ lp_setup_set_fragment_sampler_views(struct lp_setup_context *setup,
       struct pipe_sampler_view *view = i < num ? views[i] : NULL;
 
       if (view) {
-         struct pipe_resource *res = view->texture;
-         struct llvmpipe_resource *lp_tex = llvmpipe_resource(res);
-         struct lp_jit_texture *jit_tex;
-         jit_tex = &setup->fs.current.jit_context.textures[i];
-
          /* We're referencing the texture's internal data, so save a
           * reference to it.
           */
-         pipe_resource_reference(&setup->fs.current_tex[i], res);
-
-         if (!lp_tex->dt) {
-            /* regular texture - setup array of mipmap level offsets */
-            void *mip_ptr;
-            int j;
-            unsigned first_level = 0;
-            unsigned last_level = 0;
+         pipe_resource_reference(&setup->fs.current_tex[i], view->texture);
 
-            if (llvmpipe_resource_is_texture(res)) {
-               first_level = view->u.tex.first_level;
-               last_level = view->u.tex.last_level;
-               assert(first_level <= last_level);
-               assert(last_level <= res->last_level);
-
-               /*
-                * The complexity here should no longer be necessary.
-                */
-               mip_ptr = llvmpipe_get_texture_image_all(lp_tex, first_level,
-                                                        LP_TEX_USAGE_READ);
-               jit_tex->base = lp_tex->linear_img.data;
-            }
-            else {
-               mip_ptr = lp_tex->data;
-               jit_tex->base = mip_ptr;
-            }
-
-            if ((LP_PERF & PERF_TEX_MEM) || !mip_ptr) {
-               /* out of memory - use dummy tile memory */
-               /* Note if using PERF_TEX_MEM will also skip tile conversion */
-               jit_tex->base = lp_dummy_tile;
-               jit_tex->width = TILE_SIZE/8;
-               jit_tex->height = TILE_SIZE/8;
-               jit_tex->depth = 1;
-               jit_tex->first_level = 0;
-               jit_tex->last_level = 0;
-               jit_tex->mip_offsets[0] = 0;
-               jit_tex->row_stride[0] = 0;
-               jit_tex->img_stride[0] = 0;
-            }
-            else {
-               jit_tex->width = res->width0;
-               jit_tex->height = res->height0;
-               jit_tex->depth = res->depth0;
-               jit_tex->first_level = first_level;
-               jit_tex->last_level = last_level;
-
-               if (llvmpipe_resource_is_texture(res)) {
-                  for (j = first_level; j <= last_level; j++) {
-                     mip_ptr = llvmpipe_get_texture_image_all(lp_tex, j,
-                                                              LP_TEX_USAGE_READ);
-                     jit_tex->mip_offsets[j] = (uint8_t *)mip_ptr - (uint8_t *)jit_tex->base;
-                     /*
-                      * could get mip offset directly but need call above to
-                      * invoke tiled->linear conversion.
-                      */
-                     assert(lp_tex->linear_mip_offsets[j] == jit_tex->mip_offsets[j]);
-                     jit_tex->row_stride[j] = lp_tex->row_stride[j];
-                     jit_tex->img_stride[j] = lp_tex->img_stride[j];
-                  }
-
-                  if (res->target == PIPE_TEXTURE_1D_ARRAY ||
-                      res->target == PIPE_TEXTURE_2D_ARRAY) {
-                     /*
-                      * For array textures, we don't have first_layer, instead
-                      * adjust last_layer (stored as depth) plus the mip level offsets
-                      * (as we have mip-first layout can't just adjust base ptr).
-                      * XXX For mip levels, could do something similar.
-                      */
-                     jit_tex->depth = view->u.tex.last_layer - view->u.tex.first_layer + 1;
-                     for (j = first_level; j <= last_level; j++) {
-                        jit_tex->mip_offsets[j] += view->u.tex.first_layer *
-                                                   lp_tex->img_stride[j];
-                     }
-                     assert(view->u.tex.first_layer <= view->u.tex.last_layer);
-                     assert(view->u.tex.last_layer < res->array_size);
-                  }
-               }
-               else {
-                  /*
-                   * For buffers, we don't have first_element, instead adjust
-                   * last_element (stored as width) plus the base pointer.
-                   */
-                  unsigned view_blocksize = util_format_get_blocksize(view->format);
-                  /* probably don't really need to fill that out */
-                  jit_tex->mip_offsets[0] = 0;
-                  jit_tex->row_stride[0] = 0;
-                  jit_tex->row_stride[0] = 0;
-
-                  /* everything specified in number of elements here. */
-                  jit_tex->width = view->u.buf.last_element - view->u.buf.first_element + 1;
-                  jit_tex->base = (uint8_t *)jit_tex->base + view->u.buf.first_element *
-                                  view_blocksize;
-                  /* XXX Unsure if we need to sanitize parameters? */
-                  assert(view->u.buf.first_element <= view->u.buf.last_element);
-                  assert(view->u.buf.last_element * view_blocksize < res->width0);
-               }
-            }
-         }
-         else {
-            /* display target texture/surface */
-            /*
-             * XXX: Where should this be unmapped?
-             */
-            struct llvmpipe_screen *screen = llvmpipe_screen(res->screen);
-            struct sw_winsys *winsys = screen->winsys;
-            jit_tex->base = winsys->displaytarget_map(winsys, lp_tex->dt,
-                                                         PIPE_TRANSFER_READ);
-            jit_tex->row_stride[0] = lp_tex->row_stride[0];
-            jit_tex->img_stride[0] = lp_tex->img_stride[0];
-            jit_tex->mip_offsets[0] = 0;
-            jit_tex->width = res->width0;
-            jit_tex->height = res->height0;
-            jit_tex->depth = res->depth0;
-            jit_tex->first_level = jit_tex->last_level = 0;
-            assert(jit_tex->base);
-         }
+         /* Only the view's levels are read, so maps of the others need
+          * not wait for the scene.
+          */
+         if (view->texture->target == PIPE_BUFFER)
+            setup->fs.current_tex_levels[i] = 1;
+         else
+            setup->fs.current_tex_levels[i] =
+               ((2u << view->u.tex.last_level) - 1) &
+               ~((1u << view->u.tex.first_level) - 1);
+
+         lp_setup_jit_texture(&setup->fs.current.jit_context.textures[i],
+                              view);
       }
    }
 
@@ -829,6 +887,17 @@ lp_setup_set_fragment_sampler_state(struct lp_setup_context *setup,
 }
 
 
+/**
+ * Whether a bound surface renders to the given level of its resource.
+ */
+static INLINE boolean
+surface_has_level(const struct pipe_surface *surf, unsigned level)
+{
+   return surf->texture->target == PIPE_BUFFER ||
+          surf->u.tex.level == level;
+}
+
+
 /**
  * Is the given texture referenced by any scene?
  * Note: we have to check all scenes including any scenes currently
@@ -836,22 +905,25 @@ lp_setup_set_fragment_sampler_state(struct lp_setup_context *setup,
  */
 unsigned
 lp_setup_is_resource_referenced( const struct lp_setup_context *setup,
-                                const struct pipe_resource *texture )
+                                const struct pipe_resource *texture,
+                                unsigned level )
 {
    unsigned i;
 
    /* check the render targets */
    for (i = 0; i < setup->fb.nr_cbufs; i++) {
-      if (setup->fb.cbufs[i]->texture == texture)
+      if (setup->fb.cbufs[i]->texture == texture &&
+          surface_has_level(setup->fb.cbufs[i], level))
          return LP_REFERENCED_FOR_READ | LP_REFERENCED_FOR_WRITE;
    }
-   if (setup->fb.zsbuf && setup->fb.zsbuf->texture == texture) {
+   if (setup->fb.zsbuf && setup->fb.zsbuf->texture == texture &&
+       surface_has_level(setup->fb.zsbuf, level)) {
       return LP_REFERENCED_FOR_READ | LP_REFERENCED_FOR_WRITE;
    }
 
    /* check textures referenced by the scene */
-   for (i = 0; i < Elements(setup->scenes); i++) {
-      if (lp_scene_is_resource_referenced(setup->scenes[i], texture)) {
+   for (i = 0; i < setup->num_scenes; i++) {
+      if (lp_scene_is_resource_referenced(setup->scenes[i], texture, level)) {
          return LP_REFERENCED_FOR_READ;
       }
    }
@@ -980,6 +1052,12 @@ try_update_scene_state( struct lp_setup_context *setup )
                 &setup->fs.current,
                 sizeof setup->fs.current);
          setup->fs.stored = stored;
+
+         /* The query must stay around until the scene is rasterized. */
+         if (stored->render_cond_query) {
+            lp_fence_reference(&stored->render_cond_query->render_cond_fence,
+                               scene->fence);
+         }
          
          /* The scene now references the textures in the rasterization
           * state record.  Note that now.
@@ -988,6 +1066,7 @@ try_update_scene_state( struct lp_setup_context *setup )
             if (setup->fs.current_tex[i]) {
                if (!lp_scene_add_resource_reference(scene,
                                                     setup->fs.current_tex[i],
+                                                    setup->fs.current_tex_levels[i],
                                                     new_scene)) {
                   assert(!new_scene);
                   return FALSE;
@@ -1028,22 +1107,32 @@ boolean
 lp_setup_update_state( struct lp_setup_context *setup,
                        boolean update_scene )
 {
+   struct llvmpipe_context *lp = llvmpipe_context(setup->pipe);
+
+   /* Fast path for runs of draws with unchanged state: nothing to
+    * revalidate, and the scene already holds the current state.
+    */
+   if (!lp->dirty && !setup->dirty &&
+       (!update_scene || setup->state == SETUP_ACTIVE)) {
+      assert(setup->setup.variant);
+      assert(!update_scene || setup->fs.stored);
+      return TRUE;
+   }
+
    /* Some of the 'draw' pipeline stages may have changed some driver state.
     * Make sure we've processed those state changes before anything else.
     *
     * XXX this is the only place where llvmpipe_context is used in the
     * setup code.  This may get refactored/changed...
+    *
+    * The setup variant only depends on context state, so it is updated
+    * from llvmpipe_update_derived(), not on every setup state change.
     */
    {
-      struct llvmpipe_context *lp = llvmpipe_context(setup->pipe);
       if (lp->dirty) {
          llvmpipe_update_derived(lp);
       }
 
-      if (lp->setup->dirty) {
-         llvmpipe_update_setup(lp);
-      }
-
       assert(setup->setup.variant);
 
       /* Will probably need to move this somewhere else, just need  
@@ -1108,6 +1197,8 @@ lp_setup_destroy( struct lp_setup_context *setup )
 
    lp_setup_reset( setup );
 
+   lp_setup_destroy_parallel( setup );
+
    util_unreference_framebuffer_state(&setup->fb);
 
    for (i = 0; i < Elements(setup->fs.current_tex); i++) {
@@ -1119,7 +1210,7 @@ lp_setup_destroy( struct lp_setup_context *setup )
    }
 
    /* free the scenes in the 'empty' queue */
-   for (i = 0; i < Elements(setup->scenes); i++) {
+   for (i = 0; i < setup->num_scenes; i++) {
       struct lp_scene *scene = setup->scenes[i];
 
       if (scene->fence)
@@ -1168,8 +1259,20 @@ lp_setup_create( struct pipe_context *pipe,
    draw_set_rasterize_stage(draw, setup->vbuf);
    draw_set_render(draw, &setup->base);
 
+   /* With more than two scenes, binning can run further ahead of the
+    * rasterizer, but by default never hold more binned data than two full
+    * scenes would.
+    */
+   setup->num_scenes = debug_get_num_option("LP_NUM_SCENES",
+                                            DEFAULT_NUM_SCENES);
+   setup->num_scenes = CLAMP(setup->num_scenes, 1, LP_MAX_SCENES);
+   setup->max_queued_scene_size =
+      MIN2(debug_get_num_option("LP_MAX_QUEUED_SCENE_MB",
+                                DEFAULT_NUM_SCENES * LP_SCENE_MAX_SIZE /
+                                (1024 * 1024)), 4095) * 1024 * 1024;
+
    /* create some empty scenes */
-   for (i = 0; i < MAX_SCENES; i++) {
+   for (i = 0; i < setup->num_scenes; i++) {
       setup->scenes[i] = lp_scene_create( pipe );
       if (!setup->scenes[i]) {
          goto no_scenes;
@@ -1182,10 +1285,12 @@ lp_setup_create( struct pipe_context *pipe,
    
    setup->dirty = ~0;
 
+   lp_setup_init_parallel( setup );
+
    return setup;
 
 no_scenes:
-   for (i = 0; i < MAX_SCENES; i++) {
+   for (i = 0; i < setup->num_scenes; i++) {
       if (setup->scenes[i]) {
          lp_scene_destroy(setup->scenes[i]);
       }
@@ -1209,16 +1314,43 @@ lp_setup_begin_query(struct lp_setup_context *setup,
 
    set_scene_state(setup, SETUP_ACTIVE, "begin_query");
 
+   /* setup counters are sampled here, no need to bin anything */
+   switch (pq->type) {
+   case LP_QUERY_PRIMS_BINNED:
+      pq->start[0] = setup->prims_binned;
+      return;
+   case LP_QUERY_SETUP_TIME:
+      pq->start[0] = setup->setup_nano;
+      return;
+   case LP_QUERY_RAST_WAIT_TIME:
+      pq->start[0] = setup->rast_wait_nano;
+      return;
+   default:
+      break;
+   }
+
    if (!(pq->type == PIPE_QUERY_OCCLUSION_COUNTER ||
          pq->type == PIPE_QUERY_OCCLUSION_PREDICATE ||
-         pq->type == PIPE_QUERY_PIPELINE_STATISTICS))
+         pq->type == PIPE_QUERY_PIPELINE_STATISTICS ||
+         pq->type >= LP_QUERY_TILES))
       return;
 
    /* init the query to its beginning state */
-   assert(setup->active_binned_queries < LP_MAX_ACTIVE_BINNED_QUERIES);
-   /* exceeding list size so just ignore the query */
-   if (setup->active_binned_queries >= LP_MAX_ACTIVE_BINNED_QUERIES) {
-      return;
+   if (pq->type >= LP_QUERY_TILES) {
+      /* exceeding list size so just ignore the query */
+      if (setup->active_driver_queries >= LP_MAX_ACTIVE_DRIVER_QUERIES)
+         return;
+      setup->active_driver_queries++;
+   }
+   else {
+      unsigned active_api_queries =
+         setup->active_binned_queries - setup->active_driver_queries;
+
+      assert(active_api_queries < LP_MAX_ACTIVE_BINNED_QUERIES);
+      /* exceeding list size so just ignore the query */
+      if (active_api_queries >= LP_MAX_ACTIVE_BINNED_QUERIES) {
+         return;
+      }
    }
    assert(setup->active_queries[setup->active_binned_queries] == NULL);
    setup->active_queries[setup->active_binned_queries] = pq;
@@ -1252,6 +1384,20 @@ lp_setup_end_query(struct lp_setup_context *setup, struct llvmpipe_query *pq)
 {
    set_scene_state(setup, SETUP_ACTIVE, "end_query");
 
+   switch (pq->type) {
+   case LP_QUERY_PRIMS_BINNED:
+      pq->end[0] = setup->prims_binned - pq->start[0];
+      return;
+   case LP_QUERY_SETUP_TIME:
+      pq->end[0] = setup->setup_nano - pq->start[0];
+      return;
+   case LP_QUERY_RAST_WAIT_TIME:
+      pq->end[0] = setup->rast_wait_nano - pq->start[0];
+      return;
+   default:
+      break;
+   }
+
    assert(setup->scene);
    if (setup->scene) {
       /* pq->fence should be the fence of the *last* scene which
@@ -1262,7 +1408,8 @@ lp_setup_end_query(struct lp_setup_context *setup, struct llvmpipe_query *pq)
       if (pq->type == PIPE_QUERY_OCCLUSION_COUNTER ||
           pq->type == PIPE_QUERY_OCCLUSION_PREDICATE ||
           pq->type == PIPE_QUERY_PIPELINE_STATISTICS ||
-          pq->type == PIPE_QUERY_TIMESTAMP) {
+          pq->type == PIPE_QUERY_TIMESTAMP ||
+          pq->type >= LP_QUERY_TILES) {
          if (!lp_scene_bin_everywhere(setup->scene,
                                       LP_RAST_OP_END_QUERY,
                                       lp_rast_arg_query(pq))) {
@@ -1288,7 +1435,8 @@ fail:
     */
    if (pq->type == PIPE_QUERY_OCCLUSION_COUNTER ||
       pq->type == PIPE_QUERY_OCCLUSION_PREDICATE ||
-      pq->type == PIPE_QUERY_PIPELINE_STATISTICS) {
+      pq->type == PIPE_QUERY_PIPELINE_STATISTICS ||
+      pq->type >= LP_QUERY_TILES) {
       unsigned i;
 
       /* remove from active binned query list */
@@ -1300,12 +1448,45 @@ fail:
       if (i == setup->active_binned_queries)
          return;
       setup->active_binned_queries--;
+      if (pq->type >= LP_QUERY_TILES)
+         setup->active_driver_queries--;
       setup->active_queries[i] = setup->active_queries[setup->active_binned_queries];
       setup->active_queries[setup->active_binned_queries] = NULL;
    }
 }
 
 
+/**
+ * Have the rasterizer check the result of occlusion query pq against
+ * condition before drawing anything binned from now on, or stop doing so
+ * if pq is NULL.  The query must have been ended in an earlier scene.
+ */
+void
+lp_setup_set_render_condition(struct lp_setup_context *setup,
+                              struct llvmpipe_query *pq,
+                              boolean condition)
+{
+   if (setup->fs.current.render_cond_query != pq ||
+       setup->fs.current.render_cond_cond != (pq ? condition : FALSE)) {
+      setup->fs.current.render_cond_query = pq;
+      setup->fs.current.render_cond_cond = pq ? condition : FALSE;
+      setup->dirty |= LP_SETUP_NEW_FS;
+   }
+}
+
+
+/**
+ * Drop any reference to a query which is being destroyed.
+ */
+void
+lp_setup_forget_query(struct lp_setup_context *setup,
+                      struct llvmpipe_query *pq)
+{
+   if (setup->fs.current.render_cond_query == pq)
+      lp_setup_set_render_condition(setup, NULL, FALSE);
+}
+
+
 boolean
 lp_setup_flush_and_restart(struct lp_setup_context *setup)
 {
@@ -120,6 +120,10 @@ void
 lp_setup_set_scissors( struct lp_setup_context *setup,
                        const struct pipe_scissor_state *scissors );
 
+void
+lp_setup_jit_texture(struct lp_jit_texture *jit_tex,
+                     const struct pipe_sampler_view *view);
+
 void
 lp_setup_set_fragment_sampler_views(struct lp_setup_context *setup,
                                     unsigned num,
@@ -132,7 +136,8 @@ lp_setup_set_fragment_sampler_state(struct lp_setup_context *setup,
 
 unsigned
 lp_setup_is_resource_referenced( const struct lp_setup_context *setup,
-                                const struct pipe_resource *texture );
+                                const struct pipe_resource *texture,
+                                unsigned level );
 
 void
 lp_setup_set_flatshade_first( struct lp_setup_context *setup, 
@@ -154,6 +159,15 @@ void
 lp_setup_end_query(struct lp_setup_context *setup,
                    struct llvmpipe_query *pq);
 
+void
+lp_setup_set_render_condition(struct lp_setup_context *setup,
+                              struct llvmpipe_query *pq,
+                              boolean condition);
+
+void
+lp_setup_forget_query(struct lp_setup_context *setup,
+                      struct llvmpipe_query *pq);
+
 static INLINE unsigned
 lp_clamp_scissor_idx(int idx)
 {
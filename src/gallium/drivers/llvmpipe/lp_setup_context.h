@@ -52,8 +52,13 @@
 struct lp_setup_variant;
 
 
-/** Max number of scenes */
-#define MAX_SCENES 2
+/** Default number of scenes */
+#define DEFAULT_NUM_SCENES 2
+
+/** Max number of threads binning triangles in parallel, see LP_SETUP_THREADS */
+#define LP_MAX_SETUP_THREADS 8
+
+struct lp_setup_bin_task;
 
 
 
@@ -85,12 +90,27 @@ struct lp_setup_context
    struct draw_stage *vbuf;
    unsigned num_threads;
    unsigned scene_idx;
-   struct lp_scene *scenes[MAX_SCENES];  /**< all the scenes */
+   unsigned num_scenes;
+   unsigned max_queued_scene_size;      /**< in bytes, see LP_MAX_QUEUED_SCENE_MB */
+   struct lp_scene *scenes[LP_MAX_SCENES];  /**< all the scenes */
    struct lp_scene *scene;               /**< current scene being built */
 
+   unsigned num_bin_tasks;               /**< 0 if no parallel binning */
+   struct lp_setup_bin_task *bin_tasks;  /**< see lp_setup_parallel.c */
+   boolean bin_exit;                     /**< tell binning threads to quit */
+   boolean bin_worker;     /**< this is a binning thread's private copy */
+   boolean bin_failed;     /**< binning thread ran out of scene memory */
+
    struct lp_fence *last_fence;
-   struct llvmpipe_query *active_queries[LP_MAX_ACTIVE_BINNED_QUERIES];
+   struct llvmpipe_query *active_queries[LP_MAX_ACTIVE_QUERIES];
    unsigned active_binned_queries;
+   unsigned active_driver_queries;   /**< those of active_binned_queries
+                                          with type >= LP_QUERY_TILES */
+
+   /* driver query counters, see lp_query.h */
+   uint64_t prims_binned;
+   uint64_t setup_nano;    /**< time spent in the draw_elements/arrays hooks */
+   uint64_t rast_wait_nano; /**< time spent waiting for a free rasterizer */
 
    boolean subdivide_large_triangles;
    boolean flatshade_first;
@@ -129,6 +149,7 @@ struct lp_setup_context
       const struct lp_rast_state *stored; /**< what's in the scene */
       struct lp_rast_state current;  /**< currently set state */
       struct pipe_resource *current_tex[PIPE_MAX_SHADER_SAMPLER_VIEWS];
+      unsigned current_tex_levels[PIPE_MAX_SHADER_SAMPLER_VIEWS];
    } fs;
 
    /** fragment shader constants */
@@ -176,6 +197,16 @@ void lp_setup_destroy( struct lp_setup_context *setup );
 
 boolean lp_setup_flush_and_restart(struct lp_setup_context *setup);
 
+void lp_setup_init_parallel(struct lp_setup_context *setup);
+void lp_setup_destroy_parallel(struct lp_setup_context *setup);
+
+unsigned
+lp_setup_parallel_triangles(struct lp_setup_context *setup,
+                            const void *vertex_buffer,
+                            unsigned stride,
+                            const ushort *indices,
+                            unsigned nr);
+
 void
 lp_setup_print_triangle(struct lp_setup_context *setup,
                         const float (*v0)[4],
@@ -194,6 +225,20 @@ lp_setup_alloc_triangle(struct lp_scene *scene,
                         unsigned nr_planes,
                         unsigned *tri_size);
 
+unsigned
+lp_setup_scissor_plane_mask(const struct u_rect *scissor,
+                            const struct u_rect *bbox);
+
+void
+lp_setup_scissor_planes(const struct u_rect *scissor,
+                        unsigned mask,
+                        struct lp_rast_plane *plane);
+
+boolean
+lp_setup_whole_tile(struct lp_setup_context *setup,
+                    const struct lp_rast_shader_inputs *inputs,
+                    int tx, int ty);
+
 boolean
 lp_setup_bin_triangle( struct lp_setup_context *setup,
                        struct lp_rast_triangle *tri,
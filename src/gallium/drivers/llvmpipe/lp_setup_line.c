@@ -292,6 +292,7 @@ try_setup_line( struct lp_setup_context *setup,
    int i;
    int nr_planes = 4;
    unsigned scissor_index = 0;
+   unsigned scissor_planes = 0;
    unsigned layer = 0;
    
    /* linewidth should be interpreted as integer */
@@ -318,15 +319,11 @@ try_setup_line( struct lp_setup_context *setup,
       print_line(setup, v1, v2);
 
    if (setup->scissor_test) {
-      nr_planes = 8;
       if (setup->viewport_index_slot > 0) {
          unsigned *udata = (unsigned*)v1[setup->viewport_index_slot];
          scissor_index = lp_clamp_scissor_idx(*udata);
       }
    }
-   else {
-      nr_planes = 4;
-   }
 
    if (setup->layer_slot > 0) {
       layer = *(unsigned*)v1[setup->layer_slot];
@@ -581,6 +578,12 @@ try_setup_line( struct lp_setup_context *setup,
    bbox.x0 = MAX2(bbox.x0, 0);
    bbox.y0 = MAX2(bbox.y0, 0);
 
+   if (setup->scissor_test) {
+      scissor_planes =
+         lp_setup_scissor_plane_mask(&setup->scissors[scissor_index], &bbox);
+      nr_planes += util_bitcount(scissor_planes);
+   }
+
    line = lp_setup_alloc_triangle(scene,
                                   key->num_inputs,
                                   nr_planes,
@@ -685,32 +688,16 @@ try_setup_line( struct lp_setup_context *setup,
     * and even then only on state-changes.  Could alternatively store
     * these planes elsewhere.
     */
-   if (nr_planes == 8) {
-      const struct u_rect *scissor =
-         &setup->scissors[scissor_index];
-
-      plane[4].dcdx = -1;
-      plane[4].dcdy = 0;
-      plane[4].c = 1-scissor->x0;
-      plane[4].eo = 1;
-
-      plane[5].dcdx = 1;
-      plane[5].dcdy = 0;
-      plane[5].c = scissor->x1+1;
-      plane[5].eo = 0;
-
-      plane[6].dcdx = 0;
-      plane[6].dcdy = 1;
-      plane[6].c = 1-scissor->y0;
-      plane[6].eo = 1;
-
-      plane[7].dcdx = 0;
-      plane[7].dcdy = -1;
-      plane[7].c = scissor->y1+1;
-      plane[7].eo = 0;
+   if (scissor_planes) {
+      lp_setup_scissor_planes(&setup->scissors[scissor_index],
+                              scissor_planes, &plane[4]);
    }
 
-   return lp_setup_bin_triangle(setup, line, &bbox, nr_planes, scissor_index);
+   if (!lp_setup_bin_triangle(setup, line, &bbox, nr_planes, scissor_index))
+      return FALSE;
+
+   setup->prims_binned++;
+   return TRUE;
 }
 
 
@@ -0,0 +1,293 @@
+/**************************************************************************
+ *
+ * Copyright 2013 The Mesa Authors
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/**
+ * Parallel binning of triangle lists.
+ *
+ * Big triangle lists are split into contiguous ranges of primitives, and
+ * each range is binned by a different thread into a private scene, using a
+ * private copy of the setup context.  The private scenes are then appended
+ * to the context's scene in range order.  Since each bin's commands are
+ * concatenated in that same order, the API primitive order is kept within
+ * every tile.
+ *
+ * Workers can't flush the scene when running out of memory.  Instead, they
+ * stop and the first failed range and everything after it is binned again
+ * by the caller, the usual way.
+ */
+
+
+#include "util/u_memory.h"
+#include "util/u_math.h"
+#include "os/os_thread.h"
+#include "lp_context.h"
+#include "lp_debug.h"
+#include "lp_scene.h"
+#include "lp_setup_context.h"
+
+
+/** Don't bother for fewer triangles than this, per thread */
+#define MIN_TRIANGLES_PER_TASK 512
+
+
+struct lp_setup_bin_task
+{
+   struct lp_setup_context *setup;  /**< the context's setup */
+   struct lp_setup_context *copy;   /**< private copy to bin with */
+   struct lp_scene *scene;          /**< private scene to bin into */
+
+   unsigned index;
+   pipe_thread thread;
+   pipe_semaphore work_ready;
+   pipe_semaphore work_done;
+
+   /* The current job: triangles [first, last) */
+   const void *vertex_buffer;
+   const ushort *indices;
+   unsigned stride;
+   unsigned first, last;
+};
+
+
+static INLINE const float (*
+get_vert(const struct lp_setup_bin_task *task, unsigned i))[4]
+{
+   unsigned index = task->indices ? task->indices[i] : i;
+   return (const float (*)[4])((const char *)task->vertex_buffer +
+                               index * task->stride);
+}
+
+
+static void
+bin_triangles(struct lp_setup_bin_task *task)
+{
+   struct lp_setup_context *setup = task->copy;
+   unsigned i;
+
+   for (i = task->first; i < task->last && !setup->bin_failed; i++) {
+      setup->triangle(setup,
+                      get_vert(task, 3 * i + 0),
+                      get_vert(task, 3 * i + 1),
+                      get_vert(task, 3 * i + 2));
+   }
+}
+
+
+static PIPE_THREAD_ROUTINE(bin_thread_function, init_data)
+{
+   struct lp_setup_bin_task *task = (struct lp_setup_bin_task *) init_data;
+
+   while (1) {
+      pipe_semaphore_wait(&task->work_ready);
+
+      if (task->setup->bin_exit)
+         break;
+
+      bin_triangles(task);
+
+      pipe_semaphore_signal(&task->work_done);
+   }
+
+   return NULL;
+}
+
+
+/**
+ * Create the binning threads requested with LP_SETUP_THREADS (the calling
+ * thread counts as one of them).  Parallel binning stays disabled if
+ * anything fails.
+ */
+void
+lp_setup_init_parallel(struct lp_setup_context *setup)
+{
+   unsigned num_tasks;
+   unsigned i;
+
+   num_tasks = debug_get_num_option("LP_SETUP_THREADS", 0);
+   num_tasks = MIN2(num_tasks, LP_MAX_SETUP_THREADS);
+   if (num_tasks < 2)
+      return;
+
+   setup->bin_tasks = CALLOC(num_tasks, sizeof *setup->bin_tasks);
+   if (!setup->bin_tasks)
+      return;
+
+   for (i = 0; i < num_tasks; i++) {
+      struct lp_setup_bin_task *task = &setup->bin_tasks[i];
+
+      task->setup = setup;
+      task->index = i;
+      task->copy = MALLOC_STRUCT(lp_setup_context);
+      task->scene = lp_scene_create(setup->pipe);
+      if (!task->copy || !task->scene) {
+         FREE(task->copy);
+         if (task->scene)
+            lp_scene_destroy(task->scene);
+         break;
+      }
+
+      /* Task 0 is run by the calling thread */
+      if (i > 0) {
+         pipe_semaphore_init(&task->work_ready, 0);
+         pipe_semaphore_init(&task->work_done, 0);
+         task->thread = pipe_thread_create(bin_thread_function, task);
+      }
+
+      setup->num_bin_tasks = i + 1;
+   }
+
+   if (setup->num_bin_tasks < 2) {
+      lp_setup_destroy_parallel(setup);
+   }
+}
+
+
+void
+lp_setup_destroy_parallel(struct lp_setup_context *setup)
+{
+   unsigned i;
+
+   if (!setup->bin_tasks)
+      return;
+
+   setup->bin_exit = TRUE;
+   for (i = 1; i < setup->num_bin_tasks; i++) {
+      pipe_semaphore_signal(&setup->bin_tasks[i].work_ready);
+   }
+
+   for (i = 0; i < setup->num_bin_tasks; i++) {
+      struct lp_setup_bin_task *task = &setup->bin_tasks[i];
+
+      if (i > 0) {
+         pipe_thread_wait(task->thread);
+         pipe_semaphore_destroy(&task->work_ready);
+         pipe_semaphore_destroy(&task->work_done);
+      }
+      lp_scene_destroy(task->scene);
+      FREE(task->copy);
+   }
+
+   FREE(setup->bin_tasks);
+   setup->bin_tasks = NULL;
+   setup->num_bin_tasks = 0;
+}
+
+
+/**
+ * Bin a PIPE_PRIM_TRIANGLES list in parallel.
+ *
+ * Must be called with an up to date, active scene.
+ *
+ * \param indices  vertex indices, or NULL for consecutive vertices
+ * \param nr  number of vertices
+ * \return  number of vertices consumed, always a multiple of three; the
+ *          caller must bin the remaining ones itself
+ */
+unsigned
+lp_setup_parallel_triangles(struct lp_setup_context *setup,
+                            const void *vertex_buffer,
+                            unsigned stride,
+                            const ushort *indices,
+                            unsigned nr)
+{
+   struct llvmpipe_context *lp = (struct llvmpipe_context *)setup->pipe;
+   struct lp_scene *scene = setup->scene;
+   unsigned num_tris = nr / 3;
+   unsigned num_tasks;
+   unsigned per_task;
+   unsigned done;
+   boolean failed;
+   unsigned i;
+
+   if (setup->num_bin_tasks < 2 ||
+       num_tris < 2 * MIN_TRIANGLES_PER_TASK ||
+       setup->state != SETUP_ACTIVE ||
+       !scene ||
+       lp->active_statistics_queries) {
+      return 0;
+   }
+
+   /* Make sure the workers don't see the lazy first_triangle() hook */
+   lp_setup_choose_triangle(setup);
+
+   num_tasks = MIN2(setup->num_bin_tasks, num_tris / MIN_TRIANGLES_PER_TASK);
+   per_task = (num_tris + num_tasks - 1) / num_tasks;
+
+   for (i = 0; i < num_tasks; i++) {
+      struct lp_setup_bin_task *task = &setup->bin_tasks[i];
+
+      memcpy(task->copy, setup, sizeof *setup);
+      task->copy->scene = task->scene;
+      task->copy->bin_worker = TRUE;
+      task->copy->bin_failed = FALSE;
+      task->copy->prims_binned = 0;
+
+      lp_scene_begin_binning(task->scene, &setup->fb, scene->discard);
+      task->scene->fb_max_layer = scene->fb_max_layer;
+      task->scene->had_queries = scene->had_queries;
+
+      task->vertex_buffer = vertex_buffer;
+      task->indices = indices;
+      task->stride = stride;
+      task->first = MIN2(i * per_task, num_tris);
+      task->last = MIN2(task->first + per_task, num_tris);
+   }
+
+   for (i = 1; i < num_tasks; i++) {
+      pipe_semaphore_signal(&setup->bin_tasks[i].work_ready);
+   }
+
+   bin_triangles(&setup->bin_tasks[0]);
+
+   for (i = 1; i < num_tasks; i++) {
+      pipe_semaphore_wait(&setup->bin_tasks[i].work_done);
+   }
+
+   /* Append the private scenes in order, up to the first failure */
+   done = 0;
+   failed = FALSE;
+   for (i = 0; i < num_tasks; i++) {
+      struct lp_setup_bin_task *task = &setup->bin_tasks[i];
+
+      if (!failed) {
+         if (task->copy->bin_failed ||
+             !lp_scene_merge(scene, task->scene)) {
+            LP_DBG(DEBUG_SETUP, "%s: task %u failed, %u/%u tris binned\n",
+                   __FUNCTION__, i, done, num_tris);
+            failed = TRUE;
+         }
+         else {
+            done = task->last;
+            setup->prims_binned += task->copy->prims_binned;
+         }
+      }
+
+      lp_scene_end_rasterization(task->scene);
+   }
+
+   return 3 * done;
+}
@@ -299,6 +299,75 @@ subpixel_snap(float a)
 }
 
 
+/**
+ * Alloc space for a point, which is rasterized as a rectangle and needs
+ * no edge functions.
+ */
+static struct lp_rast_rectangle *
+alloc_rectangle(struct lp_scene *scene,
+                unsigned nr_inputs)
+{
+   unsigned input_array_sz = NUM_CHANNELS * (nr_inputs + 1) * sizeof(float);
+   struct lp_rast_rectangle *rect;
+
+   rect = lp_scene_alloc_aligned(scene,
+                                 sizeof *rect + 3 * input_array_sz,
+                                 16);
+   if (rect == NULL)
+      return NULL;
+
+   rect->inputs.stride = input_array_sz;
+
+   return rect;
+}
+
+
+/**
+ * Put the rectangle in the bins of the tiles it touches.  Tiles it covers
+ * entirely get shaded whole, like with triangles.
+ */
+static boolean
+bin_rectangle(struct lp_setup_context *setup,
+              struct lp_rast_rectangle *rect)
+{
+   struct lp_scene *scene = setup->scene;
+   const struct u_rect *box = &rect->box;
+   int ix0 = box->x0 / TILE_SIZE;
+   int iy0 = box->y0 / TILE_SIZE;
+   int ix1 = box->x1 / TILE_SIZE;
+   int iy1 = box->y1 / TILE_SIZE;
+   int x, y;
+
+   for (y = iy0; y <= iy1; y++) {
+      boolean rows_covered = (box->y0 <= y * TILE_SIZE &&
+                              box->y1 >= (y + 1) * TILE_SIZE - 1);
+
+      for (x = ix0; x <= ix1; x++) {
+         if (rows_covered &&
+             box->x0 <= x * TILE_SIZE &&
+             box->x1 >= (x + 1) * TILE_SIZE - 1) {
+            if (!lp_setup_whole_tile(setup, &rect->inputs, x, y))
+               goto fail;
+         }
+         else {
+            if (!lp_scene_bin_cmd_with_state(scene, x, y,
+                                             setup->fs.stored,
+                                             LP_RAST_OP_RECTANGLE,
+                                             lp_rast_arg_rectangle(rect)))
+               goto fail;
+         }
+      }
+   }
+
+   return TRUE;
+
+fail:
+   /* Disable the partially binned rectangle, see lp_setup_bin_triangle() */
+   rect->inputs.disable = TRUE;
+   return FALSE;
+}
+
+
 static boolean
 try_setup_point( struct lp_setup_context *setup,
                  const float (*v0)[4] )
@@ -321,10 +390,8 @@ try_setup_point( struct lp_setup_context *setup,
    const int y0 = subpixel_snap(v0[0][1] - setup->pixel_offset) - fixed_width/2;
      
    struct lp_scene *scene = setup->scene;
-   struct lp_rast_triangle *point;
-   unsigned bytes;
+   struct lp_rast_rectangle *point;
    struct u_rect bbox;
-   unsigned nr_planes = 4;
    struct point_info info;
    unsigned scissor_index = 0;
    unsigned layer = 0;
@@ -366,18 +433,10 @@ try_setup_point( struct lp_setup_context *setup,
 
    u_rect_find_intersection(&setup->draw_regions[scissor_index], &bbox);
 
-   point = lp_setup_alloc_triangle(scene,
-                                   key->num_inputs,
-                                   nr_planes,
-                                   &bytes);
+   point = alloc_rectangle(scene, key->num_inputs);
    if (!point)
       return FALSE;
 
-#ifdef DEBUG
-   point->v[0][0] = v0[0][0];
-   point->v[0][1] = v0[0][1];
-#endif
-
    LP_COUNT(nr_tris);
 
    if (lp_context->active_statistics_queries) {
@@ -401,32 +460,13 @@ try_setup_point( struct lp_setup_context *setup,
    point->inputs.disable = FALSE;
    point->inputs.opaque = FALSE;
    point->inputs.layer = layer;
+   point->box = bbox;
 
-   {
-      struct lp_rast_plane *plane = GET_PLANES(point);
-
-      plane[0].dcdx = -1;
-      plane[0].dcdy = 0;
-      plane[0].c = 1-bbox.x0;
-      plane[0].eo = 1;
-
-      plane[1].dcdx = 1;
-      plane[1].dcdy = 0;
-      plane[1].c = bbox.x1+1;
-      plane[1].eo = 0;
-
-      plane[2].dcdx = 0;
-      plane[2].dcdy = 1;
-      plane[2].c = 1-bbox.y0;
-      plane[2].eo = 1;
-
-      plane[3].dcdx = 0;
-      plane[3].dcdy = -1;
-      plane[3].c = bbox.y1+1;
-      plane[3].eo = 0;
-   }
+   if (!bin_rectangle(setup, point))
+      return FALSE;
 
-   return lp_setup_bin_triangle(setup, point, &bbox, nr_planes, scissor_index);
+   setup->prims_binned++;
+   return TRUE;
 }
 
 
@@ -108,6 +108,73 @@ lp_setup_alloc_triangle(struct lp_scene *scene,
    return tri;
 }
 
+/**
+ * Return the mask of the edges of the scissor rect (left, right, top,
+ * bottom) which cut into the bounding box of a primitive.  The primitive
+ * is on the inner side of all the other edges, so their planes can't
+ * reject anything.
+ */
+unsigned
+lp_setup_scissor_plane_mask(const struct u_rect *scissor,
+                            const struct u_rect *bbox)
+{
+   unsigned mask = 0;
+
+   if (scissor->x0 > bbox->x0)
+      mask |= 0x1;
+   if (scissor->x1 < bbox->x1)
+      mask |= 0x2;
+   if (scissor->y0 > bbox->y0)
+      mask |= 0x4;
+   if (scissor->y1 < bbox->y1)
+      mask |= 0x8;
+
+   return mask;
+}
+
+
+/**
+ * Write the planes of the scissor rect edges in mask (see
+ * lp_setup_scissor_plane_mask()) to consecutive entries of plane.
+ */
+void
+lp_setup_scissor_planes(const struct u_rect *scissor,
+                        unsigned mask,
+                        struct lp_rast_plane *plane)
+{
+   if (mask & 0x1) {
+      plane->dcdx = -1;
+      plane->dcdy = 0;
+      plane->c = 1-scissor->x0;
+      plane->eo = 1;
+      plane++;
+   }
+
+   if (mask & 0x2) {
+      plane->dcdx = 1;
+      plane->dcdy = 0;
+      plane->c = scissor->x1+1;
+      plane->eo = 0;
+      plane++;
+   }
+
+   if (mask & 0x4) {
+      plane->dcdx = 0;
+      plane->dcdy = 1;
+      plane->c = 1-scissor->y0;
+      plane->eo = 1;
+      plane++;
+   }
+
+   if (mask & 0x8) {
+      plane->dcdx = 0;
+      plane->dcdy = -1;
+      plane->c = scissor->y1+1;
+      plane->eo = 0;
+   }
+}
+
+
 void
 lp_setup_print_vertex(struct lp_setup_context *setup,
                       const char *name,
@@ -194,7 +261,7 @@ lp_rast_tri_tab[MAX_PLANES+1] = {
  *
  * \param tx, ty  the tile position in tiles, not pixels
  */
-static boolean
+boolean
 lp_setup_whole_tile(struct lp_setup_context *setup,
                     const struct lp_rast_shader_inputs *inputs,
                     int tx, int ty)
@@ -216,8 +283,11 @@ lp_setup_whole_tile(struct lp_setup_context *setup,
        * were just active we also can't do the optimization since to get
        * accurate query results we unfortunately need to execute the rendering
        * commands.
+       * - If the rasterizer is to check a render condition, the tile might
+       * not get drawn after all.
        */
-      if (!scene->fb.zsbuf && scene->fb_max_layer == 0 && !scene->had_queries) {
+      if (!scene->fb.zsbuf && scene->fb_max_layer == 0 && !scene->had_queries &&
+          !setup->fs.stored->render_cond_query) {
          /*
           * All previous rendering will be overwritten so reset the bin.
           */
@@ -261,6 +331,7 @@ do_triangle_ccw(struct lp_setup_context *setup,
    unsigned tri_bytes;
    int nr_planes = 3;
    unsigned scissor_index = 0;
+   unsigned scissor_planes = 0;
    unsigned layer = 0;
 
    /* Area should always be positive here */
@@ -270,15 +341,11 @@ do_triangle_ccw(struct lp_setup_context *setup,
       lp_setup_print_triangle(setup, v0, v1, v2);
 
    if (setup->scissor_test) {
-      nr_planes = 7;
       if (setup->viewport_index_slot > 0) {
          unsigned *udata = (unsigned*)v0[setup->viewport_index_slot];
          scissor_index = lp_clamp_scissor_idx(*udata);
       }
    }
-   else {
-      nr_planes = 3;
-   }
    if (setup->layer_slot > 0) {
       layer = *(unsigned*)v1[setup->layer_slot];
       layer = MIN2(layer, scene->fb_max_layer);
@@ -322,6 +389,12 @@ do_triangle_ccw(struct lp_setup_context *setup,
    bbox.x0 = MAX2(bbox.x0, 0);
    bbox.y0 = MAX2(bbox.y0, 0);
 
+   if (setup->scissor_test) {
+      scissor_planes =
+         lp_setup_scissor_plane_mask(&setup->scissors[scissor_index], &bbox);
+      nr_planes += util_bitcount(scissor_planes);
+   }
+
    tri = lp_setup_alloc_triangle(scene,
                                  key->num_inputs,
                                  nr_planes,
@@ -518,32 +591,21 @@ do_triangle_ccw(struct lp_setup_context *setup,
     * Note that otherwise, the scissor planes only vary in 'C' value,
     * and even then only on state-changes.  Could alternatively store
     * these planes elsewhere.
+    *
+    * Only the edges of the scissor rect which cut the bounding box get
+    * a plane, which keeps the triangle smaller in the scene and mostly
+    * lets scissored triangles use the 3-plane rasterization paths.
     */
-   if (nr_planes == 7) {
-      const struct u_rect *scissor = &setup->scissors[scissor_index];
-
-      plane[3].dcdx = -1;
-      plane[3].dcdy = 0;
-      plane[3].c = 1-scissor->x0;
-      plane[3].eo = 1;
-
-      plane[4].dcdx = 1;
-      plane[4].dcdy = 0;
-      plane[4].c = scissor->x1+1;
-      plane[4].eo = 0;
-
-      plane[5].dcdx = 0;
-      plane[5].dcdy = 1;
-      plane[5].c = 1-scissor->y0;
-      plane[5].eo = 1;
-
-      plane[6].dcdx = 0;
-      plane[6].dcdy = -1;
-      plane[6].c = scissor->y1+1;
-      plane[6].eo = 0;
+   if (scissor_planes) {
+      lp_setup_scissor_planes(&setup->scissors[scissor_index],
+                              scissor_planes, &plane[3]);
    }
 
-   return lp_setup_bin_triangle(setup, tri, &bbox, nr_planes, scissor_index);
+   if (!lp_setup_bin_triangle(setup, tri, &bbox, nr_planes, scissor_index))
+      return FALSE;
+
+   setup->prims_binned++;
+   return TRUE;
 }
 
 /*
@@ -609,8 +671,8 @@ lp_setup_bin_triangle( struct lp_setup_context *setup,
    {
       int ix0 = bbox->x0 / TILE_SIZE;
       int iy0 = bbox->y0 / TILE_SIZE;
-      unsigned px = bbox->x0 & 63 & ~3;
-      unsigned py = bbox->y0 & 63 & ~3;
+      unsigned px = bbox->x0 & (TILE_SIZE - 1) & ~3;
+      unsigned py = bbox->y0 & (TILE_SIZE - 1) & ~3;
 
       assert(iy0 == bbox->y1 / TILE_SIZE &&
 	     ix0 == bbox->x1 / TILE_SIZE);
@@ -794,6 +856,12 @@ static void retry_triangle_ccw( struct lp_setup_context *setup,
 {
    if (!do_triangle_ccw( setup, position, v0, v1, v2, front ))
    {
+      /* Binning threads can't flush, see lp_setup_parallel.c */
+      if (setup->bin_worker) {
+         setup->bin_failed = TRUE;
+         return;
+      }
+
       if (!lp_setup_flush_and_restart(setup))
          return;
 
@@ -0,0 +1,1177 @@
+/**************************************************************************
+ *
+ * Copyright 2013 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDERS, AUTHORS AND/OR ITS SUPPLIERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ **************************************************************************/
+
+/**
+ * Compute shader state and code generation.  See lp_state_cs.h.
+ *
+ * The invocations of a vector are numbered invocation .. invocation + n - 1
+ * within their group, and the lanes past the end of the group are masked
+ * off.  Memory accesses are done a lane at a time: an access which is out
+ * of bounds, or from a masked off lane, goes to a scratch "sink" on the
+ * stack instead, and loads return zero for it.
+ */
+
+#include "pipe/p_defines.h"
+#include "pipe/p_shader_tokens.h"
+#include "util/u_atomic.h"
+#include "util/u_format.h"
+#include "util/u_inlines.h"
+#include "util/u_math.h"
+#include "util/u_memory.h"
+#include "util/u_simple_list.h"
+#include "util/u_string.h"
+#include "tgsi/tgsi_dump.h"
+#include "tgsi/tgsi_parse.h"
+#include "gallivm/lp_bld_arit.h"
+#include "gallivm/lp_bld_const.h"
+#include "gallivm/lp_bld_debug.h"
+#include "gallivm/lp_bld_flow.h"
+#include "gallivm/lp_bld_init.h"
+#include "gallivm/lp_bld_logic.h"
+#include "gallivm/lp_bld_tgsi.h"
+#include "gallivm/lp_bld_type.h"
+#include "lp_context.h"
+#include "lp_debug.h"
+#include "lp_state.h"
+#include "lp_state_cs.h"
+#include "lp_tex_sample.h"
+#include "lp_texture.h"
+
+
+/** Bytes of the sink, enough for any access of a single texel */
+#define LP_CS_SINK_SIZE 16
+
+
+/**
+ * Our implementation of the TGSI memory access and barrier callbacks.
+ */
+struct lp_cs_iface
+{
+   struct lp_build_tgsi_cs_iface base;
+
+   const struct lp_compute_shader *shader;
+   const struct lp_compute_shader_variant_key *key;
+
+   LLVMValueRef context_ptr;
+   LLVMValueRef invocation;
+   LLVMValueRef local_mem;
+   LLVMValueRef private_mem;
+   LLVMValueRef barrier_data;
+
+   /** Where out of bounds and masked off accesses go */
+   LLVMValueRef sink;
+
+   /** Scratch texel for the format conversion helpers */
+   LLVMValueRef texel;
+};
+
+
+static INLINE const struct lp_cs_iface *
+lp_cs_iface(const struct lp_build_tgsi_cs_iface *iface)
+{
+   return (const struct lp_cs_iface *) iface;
+}
+
+
+/**
+ * Load a field of element index of an array of struct lp_jit_cs_resource.
+ */
+static LLVMValueRef
+cs_resource_field(struct gallivm_state *gallivm,
+                  LLVMValueRef array_ptr,
+                  LLVMValueRef index,
+                  unsigned field)
+{
+   LLVMBuilderRef builder = gallivm->builder;
+   LLVMValueRef indices[3];
+   LLVMValueRef ptr;
+
+   indices[0] = lp_build_const_int32(gallivm, 0);
+   indices[1] = index;
+   indices[2] = lp_build_const_int32(gallivm, field);
+   ptr = LLVMBuildGEP(builder, array_ptr, indices, Elements(indices), "");
+   return LLVMBuildLoad(builder, ptr, "");
+}
+
+
+/**
+ * Bytes per element of a resource, 0 for raw ones.
+ */
+static unsigned
+cs_resource_blocksize(const struct lp_cs_iface *iface, unsigned resource)
+{
+   if (resource < PIPE_MAX_SHADER_RESOURCES &&
+       iface->key->resource_format[resource] != PIPE_FORMAT_NONE) {
+      return util_format_get_blocksize(iface->key->resource_format[resource]);
+   }
+   return 0;
+}
+
+
+/**
+ * Work out where an access of one lane goes.
+ *
+ * Raw resources are addressed in bytes and typed ones in elements, and the
+ * access spans size bytes.  Returns an i8 pointer, to the sink when the
+ * access is out of bounds or the lane is masked off, and the condition for
+ * it not to in *valid.
+ */
+static LLVMValueRef
+cs_lane_address(const struct lp_cs_iface *iface,
+                struct lp_build_tgsi_context *bld_base,
+                unsigned resource,
+                LLVMValueRef resource_index,
+                const LLVMValueRef *coords,
+                LLVMValueRef mask,
+                unsigned lane,
+                unsigned size,
+                LLVMValueRef *valid)
+{
+   struct gallivm_state *gallivm = bld_base->base.gallivm;
+   LLVMBuilderRef builder = gallivm->builder;
+   const struct lp_compute_shader *shader = iface->shader;
+   LLVMTypeRef i64t = LLVMInt64TypeInContext(gallivm->context);
+   LLVMValueRef lane_index = lp_build_const_int32(gallivm, lane);
+   LLVMValueRef zero = lp_build_const_int32(gallivm, 0);
+   LLVMValueRef x, y;
+   LLVMValueRef base, width, height, row_stride;
+   LLVMValueRef in_bounds, offset, ptr;
+   unsigned blocksize = 0;
+
+   x = LLVMBuildExtractElement(builder, coords[0], lane_index, "");
+   y = LLVMBuildExtractElement(builder, coords[1], lane_index, "");
+   height = lp_build_const_int32(gallivm, 1);
+   row_stride = zero;
+   in_bounds = LLVMBuildICmp(builder, LLVMIntNE,
+                             LLVMBuildExtractElement(builder, mask,
+                                                     lane_index, ""),
+                             zero, "");
+
+   switch (resource) {
+   case TGSI_RESOURCE_GLOBAL:
+      {
+         LLVMValueRef globals_ptr =
+            lp_jit_cs_context_globals(gallivm, iface->context_ptr);
+         LLVMValueRef slot;
+
+         slot = LLVMBuildLShr(builder, x,
+                              lp_build_const_int32(gallivm,
+                                                   LP_GLOBAL_OFFSET_BITS), "");
+         x = LLVMBuildAnd(builder, x,
+                          lp_build_const_int32(gallivm,
+                                               (1 << LP_GLOBAL_OFFSET_BITS) - 1),
+                          "");
+         in_bounds = LLVMBuildAnd(builder, in_bounds,
+                                  LLVMBuildICmp(builder, LLVMIntULT, slot,
+                                                lp_build_const_int32(gallivm,
+                                                   LP_MAX_GLOBAL_BUFFERS), ""),
+                                  "");
+         slot = LLVMBuildSelect(builder, in_bounds, slot, zero, "");
+
+         base = cs_resource_field(gallivm, globals_ptr, slot,
+                                  LP_JIT_CS_RESOURCE_BASE);
+         width = cs_resource_field(gallivm, globals_ptr, slot,
+                                   LP_JIT_CS_RESOURCE_WIDTH);
+         y = zero;
+      }
+      break;
+
+   case TGSI_RESOURCE_LOCAL:
+      base = iface->local_mem;
+      width = lp_build_const_int32(gallivm, shader->base.req_local_mem);
+      y = zero;
+      break;
+
+   case TGSI_RESOURCE_PRIVATE:
+      {
+         LLVMValueRef index;
+
+         index = LLVMBuildAdd(builder, iface->invocation, lane_index, "");
+         index = LLVMBuildMul(builder, index,
+                              lp_build_const_int32(gallivm,
+                                                   shader->base.req_private_mem),
+                              "");
+         base = LLVMBuildGEP(builder, iface->private_mem, &index, 1, "");
+         width = lp_build_const_int32(gallivm, shader->base.req_private_mem);
+         y = zero;
+      }
+      break;
+
+   case TGSI_RESOURCE_INPUT:
+      base = lp_jit_cs_context_input(gallivm, iface->context_ptr);
+      width = lp_build_const_int32(gallivm, shader->base.req_input_mem);
+      y = zero;
+      break;
+
+   default:
+      {
+         LLVMValueRef resources_ptr =
+            lp_jit_cs_context_resources(gallivm, iface->context_ptr);
+         LLVMValueRef index;
+
+         /*
+          * The elements of an indirectly addressed resource array are
+          * assumed to have the format of the first one.
+          */
+         blocksize = cs_resource_blocksize(iface, resource);
+
+         if (resource_index) {
+            index = LLVMBuildExtractElement(builder, resource_index,
+                                            lane_index, "");
+            in_bounds = LLVMBuildAnd(builder, in_bounds,
+                                     LLVMBuildICmp(builder, LLVMIntULT, index,
+                                                   lp_build_const_int32(gallivm,
+                                                      PIPE_MAX_SHADER_RESOURCES),
+                                                   ""),
+                                     "");
+            index = LLVMBuildSelect(builder, in_bounds, index, zero, "");
+         }
+         else {
+            assert(resource < PIPE_MAX_SHADER_RESOURCES);
+            index = lp_build_const_int32(gallivm,
+                                         MIN2(resource,
+                                              PIPE_MAX_SHADER_RESOURCES - 1));
+         }
+
+         base = cs_resource_field(gallivm, resources_ptr, index,
+                                  LP_JIT_CS_RESOURCE_BASE);
+         width = cs_resource_field(gallivm, resources_ptr, index,
+                                   LP_JIT_CS_RESOURCE_WIDTH);
+         height = cs_resource_field(gallivm, resources_ptr, index,
+                                    LP_JIT_CS_RESOURCE_HEIGHT);
+         row_stride = cs_resource_field(gallivm, resources_ptr, index,
+                                        LP_JIT_CS_RESOURCE_ROW_STRIDE);
+      }
+      break;
+   }
+
+   if (blocksize) {
+      LLVMValueRef num_elems;
+
+      num_elems = LLVMBuildUDiv(builder, width,
+                                lp_build_const_int32(gallivm, blocksize), "");
+      in_bounds = LLVMBuildAnd(builder, in_bounds,
+                               LLVMBuildICmp(builder, LLVMIntULT, x,
+                                             num_elems, ""), "");
+      offset = LLVMBuildMul(builder, LLVMBuildZExt(builder, x, i64t, ""),
+                            LLVMConstInt(i64t, blocksize, 0), "");
+   }
+   else {
+      /* width >= size && x <= width - size, without wrapping around */
+      LLVMValueRef size_value = lp_build_const_int32(gallivm, size);
+      LLVMValueRef fits;
+
+      fits = LLVMBuildAnd(builder,
+                          LLVMBuildICmp(builder, LLVMIntUGE, width,
+                                        size_value, ""),
+                          LLVMBuildICmp(builder, LLVMIntULE, x,
+                                        LLVMBuildSub(builder, width,
+                                                     size_value, ""), ""),
+                          "");
+      in_bounds = LLVMBuildAnd(builder, in_bounds, fits, "");
+      offset = LLVMBuildZExt(builder, x, i64t, "");
+   }
+
+   in_bounds = LLVMBuildAnd(builder, in_bounds,
+                            LLVMBuildICmp(builder, LLVMIntULT, y, height, ""),
+                            "");
+
+   offset = LLVMBuildAdd(builder, offset,
+                         LLVMBuildMul(builder,
+                                      LLVMBuildZExt(builder, y, i64t, ""),
+                                      LLVMBuildZExt(builder, row_stride,
+                                                    i64t, ""), ""), "");
+   ptr = LLVMBuildGEP(builder, base, &offset, 1, "");
+
+   *valid = in_bounds;
+   return LLVMBuildSelect(builder, in_bounds, ptr, iface->sink, "");
+}
+
+
+/**
+ * Pointer to the 32 bit word chan of an access.
+ */
+static LLVMValueRef
+cs_word_ptr(struct gallivm_state *gallivm, LLVMValueRef ptr, unsigned chan)
+{
+   LLVMBuilderRef builder = gallivm->builder;
+   LLVMValueRef offset = lp_build_const_int32(gallivm, chan * 4);
+
+   ptr = LLVMBuildGEP(builder, ptr, &offset, 1, "");
+   return LLVMBuildBitCast(builder, ptr,
+                           LLVMPointerType(LLVMInt32TypeInContext(gallivm->context), 0),
+                           "");
+}
+
+
+/**
+ * Call one of the lp_cs_load_texel()/lp_cs_store_texel() helpers.
+ */
+static void
+cs_call_texel_helper(struct gallivm_state *gallivm,
+                     const void *helper,
+                     enum pipe_format format,
+                     LLVMValueRef ptr,
+                     LLVMValueRef texel)
+{
+   LLVMBuilderRef builder = gallivm->builder;
+   LLVMTypeRef arg_types[3];
+   LLVMValueRef args[3];
+   LLVMValueRef function;
+
+   arg_types[0] = LLVMInt32TypeInContext(gallivm->context);
+   arg_types[1] = LLVMPointerType(LLVMInt8TypeInContext(gallivm->context), 0);
+   arg_types[2] = LLVMPointerType(LLVMInt32TypeInContext(gallivm->context), 0);
+
+   function = lp_build_const_func_pointer(gallivm, helper,
+                                          LLVMVoidTypeInContext(gallivm->context),
+                                          arg_types, Elements(arg_types),
+                                          "texel_helper");
+
+   args[0] = lp_build_const_int32(gallivm, format);
+   args[1] = ptr;
+   args[2] = LLVMBuildBitCast(builder, texel, arg_types[2], "");
+   LLVMBuildCall(builder, function, args, Elements(args), "");
+}
+
+
+static LLVMValueRef
+cs_texel_chan_ptr(struct gallivm_state *gallivm, LLVMValueRef texel,
+                  unsigned chan)
+{
+   LLVMValueRef indices[2];
+
+   indices[0] = lp_build_const_int32(gallivm, 0);
+   indices[1] = lp_build_const_int32(gallivm, chan);
+   return LLVMBuildGEP(gallivm->builder, texel, indices, 2, "");
+}
+
+
+static void
+cs_emit_load(const struct lp_build_tgsi_cs_iface *cs_iface,
+             struct lp_build_tgsi_context *bld_base,
+             unsigned resource,
+             LLVMValueRef resource_index,
+             const LLVMValueRef *coords,
+             unsigned writemask,
+             LLVMValueRef mask,
+             LLVMValueRef *values)
+{
+   const struct lp_cs_iface *iface = lp_cs_iface(cs_iface);
+   struct gallivm_state *gallivm = bld_base->base.gallivm;
+   LLVMBuilderRef builder = gallivm->builder;
+   struct lp_build_context *uint_bld = &bld_base->uint_bld;
+   const unsigned blocksize = cs_resource_blocksize(iface, resource);
+   const unsigned size = 4 * util_last_bit(writemask);
+   LLVMValueRef zero = lp_build_const_int32(gallivm, 0);
+   unsigned lane, chan;
+
+   for (chan = 0; chan < TGSI_NUM_CHANNELS; chan++) {
+      values[chan] = uint_bld->undef;
+   }
+
+   for (lane = 0; lane < uint_bld->type.length; lane++) {
+      LLVMValueRef lane_index = lp_build_const_int32(gallivm, lane);
+      LLVMValueRef valid;
+      LLVMValueRef ptr;
+
+      ptr = cs_lane_address(iface, bld_base, resource, resource_index,
+                            coords, mask, lane, size, &valid);
+
+      if (blocksize) {
+         cs_call_texel_helper(gallivm, (const void *) lp_cs_load_texel,
+                              iface->key->resource_format[resource],
+                              ptr, iface->texel);
+      }
+
+      for (chan = 0; chan < TGSI_NUM_CHANNELS; chan++) {
+         LLVMValueRef value;
+
+         if (!(writemask & (1 << chan)))
+            continue;
+
+         if (blocksize) {
+            value = LLVMBuildLoad(builder,
+                                  cs_texel_chan_ptr(gallivm, iface->texel,
+                                                    chan), "");
+         }
+         else {
+            value = LLVMBuildLoad(builder, cs_word_ptr(gallivm, ptr, chan),
+                                  "");
+            LLVMSetAlignment(value, 1);
+         }
+
+         value = LLVMBuildSelect(builder, valid, value, zero, "");
+         values[chan] = LLVMBuildInsertElement(builder, values[chan], value,
+                                               lane_index, "");
+      }
+   }
+}
+
+
+static void
+cs_emit_store(const struct lp_build_tgsi_cs_iface *cs_iface,
+              struct lp_build_tgsi_context *bld_base,
+              unsigned resource,
+              LLVMValueRef resource_index,
+              const LLVMValueRef *coords,
+              unsigned writemask,
+              LLVMValueRef mask,
+              const LLVMValueRef *values)
+{
+   const struct lp_cs_iface *iface = lp_cs_iface(cs_iface);
+   struct gallivm_state *gallivm = bld_base->base.gallivm;
+   LLVMBuilderRef builder = gallivm->builder;
+   struct lp_build_context *uint_bld = &bld_base->uint_bld;
+   const unsigned blocksize = cs_resource_blocksize(iface, resource);
+   const unsigned size = 4 * util_last_bit(writemask);
+   unsigned lane, chan;
+
+   for (lane = 0; lane < uint_bld->type.length; lane++) {
+      LLVMValueRef lane_index = lp_build_const_int32(gallivm, lane);
+      LLVMValueRef valid;
+      LLVMValueRef ptr;
+
+      ptr = cs_lane_address(iface, bld_base, resource, resource_index,
+                            coords, mask, lane, size, &valid);
+
+      if (blocksize && writemask != TGSI_WRITEMASK_XYZW) {
+         /* keep the channels which aren't written */
+         cs_call_texel_helper(gallivm, (const void *) lp_cs_load_texel,
+                              iface->key->resource_format[resource],
+                              ptr, iface->texel);
+      }
+
+      for (chan = 0; chan < TGSI_NUM_CHANNELS; chan++) {
+         LLVMValueRef value;
+
+         if (!(writemask & (1 << chan)))
+            continue;
+
+         value = LLVMBuildExtractElement(builder, values[chan], lane_index, "");
+
+         if (blocksize) {
+            LLVMBuildStore(builder, value,
+                           cs_texel_chan_ptr(gallivm, iface->texel, chan));
+         }
+         else {
+            LLVMValueRef store;
+
+            store = LLVMBuildStore(builder, value,
+                                   cs_word_ptr(gallivm, ptr, chan));
+            LLVMSetAlignment(store, 1);
+         }
+      }
+
+      if (blocksize) {
+         cs_call_texel_helper(gallivm, (const void *) lp_cs_store_texel,
+                              iface->key->resource_format[resource],
+                              ptr, iface->texel);
+      }
+   }
+}
+
+
+static LLVMValueRef
+cs_emit_atomic(const struct lp_build_tgsi_cs_iface *cs_iface,
+               struct lp_build_tgsi_context *bld_base,
+               unsigned opcode,
+               unsigned resource,
+               LLVMValueRef resource_index,
+               const LLVMValueRef *coords,
+               unsigned chan,
+               LLVMValueRef mask,
+               LLVMValueRef src0,
+               LLVMValueRef src1)
+{
+   const struct lp_cs_iface *iface = lp_cs_iface(cs_iface);
+   struct gallivm_state *gallivm = bld_base->base.gallivm;
+   LLVMBuilderRef builder = gallivm->builder;
+   struct lp_build_context *uint_bld = &bld_base->uint_bld;
+   LLVMTypeRef int32_type = LLVMInt32TypeInContext(gallivm->context);
+   const unsigned blocksize = cs_resource_blocksize(iface, resource);
+   LLVMValueRef zero = lp_build_const_int32(gallivm, 0);
+   LLVMTypeRef arg_types[4];
+   LLVMValueRef function;
+   LLVMValueRef result = uint_bld->undef;
+   unsigned lane;
+
+   arg_types[0] = LLVMPointerType(int32_type, 0);
+   arg_types[1] = int32_type;
+   arg_types[2] = int32_type;
+   arg_types[3] = int32_type;
+
+   function = lp_build_const_func_pointer(gallivm, (const void *) lp_cs_atomic,
+                                          int32_type,
+                                          arg_types, Elements(arg_types),
+                                          "lp_cs_atomic");
+
+   for (lane = 0; lane < uint_bld->type.length; lane++) {
+      LLVMValueRef lane_index = lp_build_const_int32(gallivm, lane);
+      LLVMValueRef args[4];
+      LLVMValueRef valid;
+      LLVMValueRef ptr;
+      LLVMValueRef old;
+
+      /* typed resources are operated on as if they were raw */
+      ptr = cs_lane_address(iface, bld_base, resource, resource_index,
+                            coords, mask, lane, 4 * (chan + 1), &valid);
+      if (blocksize && blocksize < 4 * (chan + 1)) {
+         valid = LLVMConstInt(LLVMInt1TypeInContext(gallivm->context), 0, 0);
+         ptr = iface->sink;
+      }
+
+      args[0] = cs_word_ptr(gallivm, ptr, chan);
+      args[1] = lp_build_const_int32(gallivm, opcode);
+      args[2] = LLVMBuildExtractElement(builder, src0, lane_index, "");
+      args[3] = src1 ? LLVMBuildExtractElement(builder, src1, lane_index, "")
+                     : zero;
+
+      old = LLVMBuildCall(builder, function, args, Elements(args), "");
+      old = LLVMBuildSelect(builder, valid, old, zero, "");
+      result = LLVMBuildInsertElement(builder, result, old, lane_index, "");
+   }
+
+   return result;
+}
+
+
+static void
+cs_emit_barrier(const struct lp_build_tgsi_cs_iface *cs_iface,
+                struct lp_build_tgsi_context *bld_base)
+{
+   const struct lp_cs_iface *iface = lp_cs_iface(cs_iface);
+   struct gallivm_state *gallivm = bld_base->base.gallivm;
+   LLVMTypeRef arg_type = LLVMPointerType(LLVMInt8TypeInContext(gallivm->context), 0);
+   LLVMValueRef function;
+   LLVMValueRef arg = iface->barrier_data;
+
+   function = lp_build_const_func_pointer(gallivm, (const void *) lp_cs_barrier,
+                                          LLVMVoidTypeInContext(gallivm->context),
+                                          &arg_type, 1, "lp_cs_barrier");
+
+   LLVMBuildCall(gallivm->builder, function, &arg, 1, "");
+}
+
+
+/**
+ * Generate the compute shader function.
+ */
+static void
+generate_compute(struct lp_compute_shader *shader,
+                 struct lp_compute_shader_variant *variant)
+{
+   struct gallivm_state *gallivm = variant->gallivm;
+   const struct lp_compute_shader_variant_key *key = &variant->key;
+   LLVMContextRef lc = gallivm->context;
+   LLVMTypeRef int8_type = LLVMInt8TypeInContext(lc);
+   LLVMTypeRef int32_type = LLVMInt32TypeInContext(lc);
+   LLVMTypeRef arg_types[8];
+   LLVMTypeRef func_type;
+   LLVMValueRef function;
+   LLVMValueRef context_ptr, base_ptr;
+   LLVMValueRef block_id[3];
+   LLVMValueRef consts_ptr;
+   LLVMBasicBlockRef block;
+   LLVMBuilderRef builder;
+   struct lp_build_sampler_soa *sampler;
+   struct lp_build_mask_context mask;
+   struct lp_bld_tgsi_system_values system_values;
+   struct lp_build_context uint_bld;
+   struct lp_type cs_type;
+   struct lp_cs_iface iface;
+   LLVMValueRef outputs[1][TGSI_NUM_CHANNELS];
+   LLVMValueRef inv, x, y, z, num_invocations;
+   char func_name[64];
+   unsigned i;
+
+   memset(&cs_type, 0, sizeof cs_type);
+   cs_type.floating = TRUE;      /* floating point values */
+   cs_type.sign = TRUE;          /* values are signed */
+   cs_type.norm = FALSE;         /* values are not limited to [0,1] or [-1,1] */
+   cs_type.width = 32;           /* 32-bit float */
+   cs_type.length = MIN2(lp_native_vector_width / 32, 16);
+
+   variant->vector_length = cs_type.length;
+
+   util_snprintf(func_name, sizeof(func_name), "cs%u_variant%u",
+                 shader->no, variant->no);
+
+   /*
+    * Generate the function prototype. Any change here must be reflected in
+    * lp_jit.h's lp_jit_cs_func function pointer type, and vice-versa.
+    */
+   arg_types[0] = variant->jit_cs_context_ptr_type;  /* context */
+   arg_types[1] = int32_type;                        /* block_id_x */
+   arg_types[2] = int32_type;                        /* block_id_y */
+   arg_types[3] = int32_type;                        /* block_id_z */
+   arg_types[4] = int32_type;                        /* invocation */
+   arg_types[5] = LLVMPointerType(int8_type, 0);     /* local_mem */
+   arg_types[6] = LLVMPointerType(int8_type, 0);     /* private_mem */
+   arg_types[7] = LLVMPointerType(int8_type, 0);     /* barrier_data */
+
+   func_type = LLVMFunctionType(LLVMVoidTypeInContext(lc),
+                                arg_types, Elements(arg_types), 0);
+
+   function = LLVMAddFunction(gallivm->module, func_name, func_type);
+   LLVMSetFunctionCallConv(function, LLVMCCallConv);
+
+   variant->function = function;
+
+   context_ptr = LLVMGetParam(function, 0);
+   for (i = 0; i < 3; i++)
+      block_id[i] = LLVMGetParam(function, 1 + i);
+
+   memset(&iface, 0, sizeof iface);
+   iface.base.pc = key->pc;
+   iface.base.emit_load = cs_emit_load;
+   iface.base.emit_store = cs_emit_store;
+   iface.base.emit_atomic = cs_emit_atomic;
+   iface.base.emit_barrier = cs_emit_barrier;
+   iface.shader = shader;
+   iface.key = key;
+   iface.context_ptr = context_ptr;
+   iface.invocation = LLVMGetParam(function, 4);
+   iface.local_mem = LLVMGetParam(function, 5);
+   iface.private_mem = LLVMGetParam(function, 6);
+   iface.barrier_data = LLVMGetParam(function, 7);
+
+   lp_build_name(context_ptr, "context");
+   lp_build_name(block_id[0], "block_id_x");
+   lp_build_name(block_id[1], "block_id_y");
+   lp_build_name(block_id[2], "block_id_z");
+   lp_build_name(iface.invocation, "invocation");
+   lp_build_name(iface.local_mem, "local_mem");
+   lp_build_name(iface.private_mem, "private_mem");
+   lp_build_name(iface.barrier_data, "barrier_data");
+
+   /*
+    * Function body
+    */
+
+   block = LLVMAppendBasicBlockInContext(lc, function, "entry");
+   builder = gallivm->builder;
+   assert(builder);
+   LLVMPositionBuilderAtEnd(builder, block);
+
+   lp_build_context_init(&uint_bld, gallivm, lp_uint_type(cs_type));
+
+   iface.sink = lp_build_alloca(gallivm,
+                                LLVMArrayType(int8_type, LP_CS_SINK_SIZE),
+                                "sink");
+   iface.sink = LLVMBuildBitCast(builder, iface.sink,
+                                 LLVMPointerType(int8_type, 0), "");
+   iface.texel = lp_build_alloca(gallivm,
+                                 LLVMArrayType(int32_type, 4), "texel");
+
+   memset(&system_values, 0, sizeof system_values);
+
+   {
+      LLVMValueRef grid_size_ptr =
+         lp_jit_cs_context_grid_size(gallivm, context_ptr);
+      LLVMValueRef block_size_ptr =
+         lp_jit_cs_context_block_size(gallivm, context_ptr);
+
+      for (i = 0; i < 3; i++) {
+         LLVMValueRef index = lp_build_const_int32(gallivm, i);
+
+         system_values.block_id[i] = block_id[i];
+         system_values.grid_size[i] =
+            lp_build_pointer_get(builder, grid_size_ptr, index);
+         system_values.block_size[i] =
+            lp_build_pointer_get(builder, block_size_ptr, index);
+      }
+   }
+
+   /* the invocations of this vector, and their position in the group */
+   {
+      LLVMValueRef elems[LP_MAX_VECTOR_LENGTH];
+
+      for (i = 0; i < uint_bld.type.length; i++)
+         elems[i] = lp_build_const_int32(gallivm, i);
+      inv = LLVMBuildAdd(builder,
+                         lp_build_broadcast_scalar(&uint_bld, iface.invocation),
+                         LLVMConstVector(elems, uint_bld.type.length), "");
+   }
+
+   {
+      LLVMValueRef bx = lp_build_broadcast_scalar(&uint_bld,
+                                                  system_values.block_size[0]);
+      LLVMValueRef by = lp_build_broadcast_scalar(&uint_bld,
+                                                  system_values.block_size[1]);
+      LLVMValueRef bz = lp_build_broadcast_scalar(&uint_bld,
+                                                  system_values.block_size[2]);
+      LLVMValueRef bxy = LLVMBuildMul(builder, bx, by, "");
+
+      x = LLVMBuildURem(builder, inv, bx, "");
+      y = LLVMBuildURem(builder, LLVMBuildUDiv(builder, inv, bx, ""), by, "");
+      z = LLVMBuildUDiv(builder, inv, bxy, "");
+      num_invocations = LLVMBuildMul(builder, bxy, bz, "");
+   }
+
+   system_values.thread_id[0] = x;
+   system_values.thread_id[1] = y;
+   system_values.thread_id[2] = z;
+
+   lp_build_mask_begin(&mask, gallivm, cs_type,
+                       lp_build_cmp(&uint_bld, PIPE_FUNC_LESS,
+                                    inv, num_invocations));
+
+   base_ptr = lp_jit_cs_context_base(gallivm, context_ptr);
+   consts_ptr = lp_jit_context_constants(gallivm, base_ptr);
+
+   /* code generated texture sampling */
+   sampler = lp_llvm_sampler_soa_create(key->state, base_ptr);
+
+   lp_build_tgsi_soa(gallivm, shader->base.prog, cs_type, &mask,
+                     consts_ptr, &system_values,
+                     NULL, outputs, sampler, &shader->info.base,
+                     NULL, &iface.base);
+
+   sampler->destroy(sampler);
+
+   lp_build_mask_end(&mask);
+
+   LLVMBuildRetVoid(builder);
+
+   gallivm_verify_function(gallivm, function);
+}
+
+
+static struct lp_compute_shader_variant *
+generate_variant(struct llvmpipe_context *lp,
+                 struct lp_compute_shader *shader,
+                 const struct lp_compute_shader_variant_key *key)
+{
+   struct lp_compute_shader_variant *variant;
+
+   variant = CALLOC_STRUCT(lp_compute_shader_variant);
+   if (!variant)
+      return NULL;
+
+   variant->gallivm = gallivm_create_in_context(NULL, GALLIVM_OPT_DEFAULT);
+   if (!variant->gallivm) {
+      FREE(variant);
+      return NULL;
+   }
+
+   variant->shader = shader;
+   variant->list_item.base = variant;
+   variant->no = shader->variants_created++;
+   variant->key = *key;
+
+   lp_jit_init_cs_types(variant);
+
+   generate_compute(shader, variant);
+
+   gallivm_compile_module(variant->gallivm);
+
+   variant->jit_function = (lp_jit_cs_func)
+      gallivm_jit_function(variant->gallivm, variant->function);
+
+   return variant;
+}
+
+
+static void
+delete_variant(struct lp_compute_shader_variant *variant)
+{
+   if (variant->function) {
+      gallivm_free_function(variant->gallivm, variant->function,
+                            variant->jit_function);
+   }
+
+   gallivm_destroy(variant->gallivm);
+
+   remove_from_list(&variant->list_item);
+
+   FREE(variant);
+}
+
+
+static void
+make_variant_key(struct llvmpipe_context *lp,
+                 struct lp_compute_shader *shader,
+                 unsigned pc,
+                 struct lp_compute_shader_variant_key *key)
+{
+   const struct tgsi_shader_info *info = &shader->info.base;
+   unsigned i;
+
+   memset(key, 0, sizeof *key);
+
+   key->pc = pc;
+
+   for (i = 0; i < PIPE_MAX_SHADER_RESOURCES; i++) {
+      const struct pipe_surface *surf = lp->cs_resources[i];
+
+      if ((shader->resource_mask & ~shader->raw_resource_mask & (1 << i)) &&
+          surf) {
+         key->resource_format[i] = surf->format;
+      }
+      else {
+         key->resource_format[i] = PIPE_FORMAT_NONE;
+      }
+   }
+
+   key->nr_samplers = info->file_max[TGSI_FILE_SAMPLER] + 1;
+
+   for (i = 0; i < key->nr_samplers; ++i) {
+      if (info->file_mask[TGSI_FILE_SAMPLER] & (1 << i)) {
+         lp_sampler_static_sampler_state(&key->state[i].sampler_state,
+                                         lp->samplers[PIPE_SHADER_COMPUTE][i]);
+      }
+   }
+
+   if (info->file_max[TGSI_FILE_SAMPLER_VIEW] != -1) {
+      key->nr_sampler_views = info->file_max[TGSI_FILE_SAMPLER_VIEW] + 1;
+      for (i = 0; i < key->nr_sampler_views; ++i) {
+         if (info->file_mask[TGSI_FILE_SAMPLER_VIEW] & (1 << i)) {
+            lp_sampler_static_texture_state(&key->state[i].texture_state,
+                                            lp->sampler_views[PIPE_SHADER_COMPUTE][i]);
+            key->state[i].texture_state.tiled =
+               llvmpipe_sampler_view_is_tiled(lp->sampler_views[PIPE_SHADER_COMPUTE][i]);
+         }
+      }
+   }
+   else {
+      key->nr_sampler_views = key->nr_samplers;
+      for (i = 0; i < key->nr_sampler_views; ++i) {
+         if (info->file_mask[TGSI_FILE_SAMPLER] & (1 << i)) {
+            lp_sampler_static_texture_state(&key->state[i].texture_state,
+                                            lp->sampler_views[PIPE_SHADER_COMPUTE][i]);
+            key->state[i].texture_state.tiled =
+               llvmpipe_sampler_view_is_tiled(lp->sampler_views[PIPE_SHADER_COMPUTE][i]);
+         }
+      }
+   }
+}
+
+
+/**
+ * Get the variant of the bound compute shader for the current state,
+ * generating it if necessary.
+ */
+struct lp_compute_shader_variant *
+llvmpipe_get_cs_variant(struct llvmpipe_context *lp, unsigned pc)
+{
+   struct lp_compute_shader *shader = lp->cs;
+   struct lp_compute_shader_variant_key key;
+   struct lp_cs_variant_list_item *li;
+   struct lp_compute_shader_variant *variant;
+
+   make_variant_key(lp, shader, pc, &key);
+
+   foreach(li, &shader->variants) {
+      if (memcmp(&li->base->key, &key, sizeof key) == 0) {
+         /* move it to the front, it's likely to be needed again soon */
+         move_to_head(&shader->variants, li);
+         return li->base;
+      }
+   }
+
+   if (LP_DEBUG & DEBUG_FS) {
+      debug_printf("llvmpipe: compiling cs #%u variant #%u\n",
+                   shader->no, shader->variants_created);
+   }
+
+   variant = generate_variant(lp, shader, &key);
+   if (variant)
+      insert_at_head(&shader->variants, &variant->list_item);
+
+   return variant;
+}
+
+
+static void *
+llvmpipe_create_compute_state(struct pipe_context *pipe,
+                              const struct pipe_compute_state *templ)
+{
+   static unsigned cs_no = 0;
+   struct lp_compute_shader *shader;
+   struct tgsi_parse_context parse;
+
+   shader = CALLOC_STRUCT(lp_compute_shader);
+   if (!shader)
+      return NULL;
+
+   shader->no = cs_no++;
+   make_empty_list(&shader->variants);
+
+   /* debug */
+   if (LP_DEBUG & DEBUG_TGSI) {
+      debug_printf("llvmpipe: Create compute shader %p:\n", (void *) shader);
+      tgsi_dump(templ->prog, 0);
+   }
+
+   /* we need to keep a local copy of the tokens */
+   shader->base = *templ;
+   shader->base.prog = tgsi_dup_tokens(templ->prog);
+   if (!shader->base.prog) {
+      FREE(shader);
+      return NULL;
+   }
+
+   /* get/save the summary info for this shader */
+   lp_build_tgsi_info(shader->base.prog, &shader->info);
+
+   /* find the resources, and whether they are raw, and the barriers */
+   tgsi_parse_init(&parse, shader->base.prog);
+   while (!tgsi_parse_end_of_tokens(&parse)) {
+      tgsi_parse_token(&parse);
+
+      if (parse.FullToken.Token.Type == TGSI_TOKEN_TYPE_DECLARATION &&
+          parse.FullToken.FullDeclaration.Declaration.File ==
+          TGSI_FILE_RESOURCE) {
+         const struct tgsi_full_declaration *decl =
+            &parse.FullToken.FullDeclaration;
+         unsigned i;
+
+         for (i = decl->Range.First;
+              i <= decl->Range.Last && i < PIPE_MAX_SHADER_RESOURCES; i++) {
+            shader->resource_mask |= 1 << i;
+            if (decl->Resource.Raw)
+               shader->raw_resource_mask |= 1 << i;
+         }
+      }
+      else if (parse.FullToken.Token.Type == TGSI_TOKEN_TYPE_INSTRUCTION &&
+               parse.FullToken.FullInstruction.Instruction.Opcode ==
+               TGSI_OPCODE_BARRIER) {
+         shader->has_barrier = TRUE;
+      }
+   }
+   tgsi_parse_free(&parse);
+
+   return shader;
+}
+
+
+static void
+llvmpipe_bind_compute_state(struct pipe_context *pipe, void *cs)
+{
+   struct llvmpipe_context *llvmpipe = llvmpipe_context(pipe);
+
+   llvmpipe->cs = (struct lp_compute_shader *) cs;
+}
+
+
+static void
+llvmpipe_delete_compute_state(struct pipe_context *pipe, void *cs)
+{
+   struct llvmpipe_context *llvmpipe = llvmpipe_context(pipe);
+   struct lp_compute_shader *shader = (struct lp_compute_shader *) cs;
+   struct lp_cs_variant_list_item *li;
+
+   if (llvmpipe->cs == shader)
+      llvmpipe->cs = NULL;
+
+   li = first_elem(&shader->variants);
+   while (!at_end(&shader->variants, li)) {
+      struct lp_cs_variant_list_item *next = next_elem(li);
+      delete_variant(li->base);
+      li = next;
+   }
+
+   FREE((void *) shader->base.prog);
+   FREE(shader);
+}
+
+
+static void
+llvmpipe_set_compute_resources(struct pipe_context *pipe,
+                               unsigned start, unsigned count,
+                               struct pipe_surface **resources)
+{
+   struct llvmpipe_context *llvmpipe = llvmpipe_context(pipe);
+   unsigned i;
+
+   assert(start + count <= Elements(llvmpipe->cs_resources));
+
+   for (i = 0; i < count; i++) {
+      pipe_surface_reference(&llvmpipe->cs_resources[start + i],
+                             resources ? resources[i] : NULL);
+   }
+}
+
+
+/**
+ * Global buffers are addressed with their binding slot in the top bits of
+ * the address, see LP_GLOBAL_OFFSET_BITS.  The handles are patched with the
+ * slot, added to the offset into the buffer they already hold.
+ */
+static void
+llvmpipe_set_global_binding(struct pipe_context *pipe,
+                            unsigned first, unsigned count,
+                            struct pipe_resource **resources,
+                            uint32_t **handles)
+{
+   struct llvmpipe_context *llvmpipe = llvmpipe_context(pipe);
+   unsigned i;
+
+   assert(first + count <= Elements(llvmpipe->global_buffers));
+
+   for (i = 0; i < count; i++) {
+      struct pipe_resource *res = resources ? resources[i] : NULL;
+
+      pipe_resource_reference(&llvmpipe->global_buffers[first + i], res);
+
+      if (res && handles && handles[i]) {
+         *handles[i] += (first + i) << LP_GLOBAL_OFFSET_BITS;
+      }
+   }
+}
+
+
+void
+llvmpipe_cleanup_compute(struct llvmpipe_context *llvmpipe)
+{
+   unsigned i;
+
+   for (i = 0; i < Elements(llvmpipe->cs_resources); i++) {
+      pipe_surface_reference(&llvmpipe->cs_resources[i], NULL);
+   }
+
+   for (i = 0; i < Elements(llvmpipe->global_buffers); i++) {
+      pipe_resource_reference(&llvmpipe->global_buffers[i], NULL);
+   }
+
+   for (i = 0; i < Elements(llvmpipe->sampler_views[0]); i++) {
+      pipe_sampler_view_reference(&llvmpipe->sampler_views[PIPE_SHADER_COMPUTE][i], NULL);
+   }
+}
+
+
+void
+llvmpipe_init_compute_funcs(struct llvmpipe_context *llvmpipe)
+{
+   llvmpipe->pipe.create_compute_state = llvmpipe_create_compute_state;
+   llvmpipe->pipe.bind_compute_state = llvmpipe_bind_compute_state;
+   llvmpipe->pipe.delete_compute_state = llvmpipe_delete_compute_state;
+   llvmpipe->pipe.set_compute_resources = llvmpipe_set_compute_resources;
+   llvmpipe->pipe.set_global_binding = llvmpipe_set_global_binding;
+
+   llvmpipe_init_launch_grid_funcs(llvmpipe);
+}
+
+
+/**
+ * Called by the generated code to read a texel of a typed resource, as
+ * floats, or integers for the pure integer formats.
+ */
+void
+lp_cs_load_texel(uint32_t format, const uint8_t *src, uint32_t *values)
+{
+   const struct util_format_description *desc =
+      util_format_description((enum pipe_format) format);
+
+   if (util_format_is_pure_sint((enum pipe_format) format)) {
+      desc->unpack_rgba_sint((int32_t *) values, 0, src, 0, 1, 1);
+   }
+   else if (util_format_is_pure_uint((enum pipe_format) format)) {
+      desc->unpack_rgba_uint(values, 0, src, 0, 1, 1);
+   }
+   else {
+      desc->unpack_rgba_float((float *) values, 0, src, 0, 1, 1);
+   }
+}
+
+
+/**
+ * Called by the generated code to write a texel of a typed resource.
+ */
+void
+lp_cs_store_texel(uint32_t format, uint8_t *dst, const uint32_t *values)
+{
+   const struct util_format_description *desc =
+      util_format_description((enum pipe_format) format);
+
+   if (util_format_is_pure_sint((enum pipe_format) format)) {
+      desc->pack_rgba_sint(dst, 0, (const int32_t *) values, 0, 1, 1);
+   }
+   else if (util_format_is_pure_uint((enum pipe_format) format)) {
+      desc->pack_rgba_uint(dst, 0, values, 0, 1, 1);
+   }
+   else {
+      desc->pack_rgba_float(dst, 0, (const float *) values, 0, 1, 1);
+   }
+}
+
+
+/**
+ * Called by the generated code for the ATOM* opcodes.
+ * \return the previous value
+ */
+uint32_t
+lp_cs_atomic(uint32_t *ptr, uint32_t opcode, uint32_t src0, uint32_t src1)
+{
+   int32_t *v = (int32_t *) ptr;
+   uint32_t old, val;
+
+   do {
+      old = (uint32_t) *(volatile int32_t *) v;
+
+      switch (opcode) {
+      case TGSI_OPCODE_ATOMUADD:
+         val = old + src0;
+         break;
+      case TGSI_OPCODE_ATOMXCHG:
+         val = src0;
+         break;
+      case TGSI_OPCODE_ATOMCAS:
+         if (old != src0)
+            return old;
+         val = src1;
+         break;
+      case TGSI_OPCODE_ATOMAND:
+         val = old & src0;
+         break;
+      case TGSI_OPCODE_ATOMOR:
+         val = old | src0;
+         break;
+      case TGSI_OPCODE_ATOMXOR:
+         val = old ^ src0;
+         break;
+      case TGSI_OPCODE_ATOMUMIN:
+         val = MIN2(old, src0);
+         break;
+      case TGSI_OPCODE_ATOMUMAX:
+         val = MAX2(old, src0);
+         break;
+      case TGSI_OPCODE_ATOMIMIN:
+         val = MIN2((int32_t) old, (int32_t) src0);
+         break;
+      case TGSI_OPCODE_ATOMIMAX:
+         val = MAX2((int32_t) old, (int32_t) src0);
+         break;
+      default:
+         assert(0);
+         return old;
+      }
+   } while (p_atomic_cmpxchg(v, (int32_t) old, (int32_t) val) != (int32_t) old);
+
+   return old;
+}
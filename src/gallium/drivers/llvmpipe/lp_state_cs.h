@@ -0,0 +1,148 @@
+/**************************************************************************
+ *
+ * Copyright 2013 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDERS, AUTHORS AND/OR ITS SUPPLIERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ **************************************************************************/
+
+/**
+ * Compute shaders.
+ *
+ * A TGSI compute program is turned into a function running one SIMD vector
+ * worth of the invocations of a work group, with one invocation per vector
+ * lane.  launch_grid() deals the work groups out to the rasterizer threads,
+ * which run each group a vector at a time (see lp_launch_grid.c).
+ */
+
+#ifndef LP_STATE_CS_H_
+#define LP_STATE_CS_H_
+
+
+#include "pipe/p_compiler.h"
+#include "pipe/p_state.h"
+#include "gallivm/lp_bld_tgsi.h" /* for lp_tgsi_info */
+#include "lp_jit.h"
+#include "lp_state_fs.h" /* for struct lp_sampler_static_state */
+
+
+struct llvmpipe_context;
+struct lp_compute_shader;
+
+
+struct lp_compute_shader_variant_key
+{
+   unsigned pc;                 /**< first instruction to run */
+   unsigned nr_samplers:8;
+   unsigned nr_sampler_views:8;
+
+   /** Formats of the typed resources, PIPE_FORMAT_NONE for raw ones */
+   enum pipe_format resource_format[PIPE_MAX_SHADER_RESOURCES];
+
+   struct lp_sampler_static_state state[PIPE_MAX_SHADER_SAMPLER_VIEWS];
+};
+
+
+/** doubly-linked list item */
+struct lp_cs_variant_list_item
+{
+   struct lp_compute_shader_variant *base;
+   struct lp_cs_variant_list_item *next, *prev;
+};
+
+
+struct lp_compute_shader_variant
+{
+   struct lp_compute_shader_variant_key key;
+
+   struct gallivm_state *gallivm;
+
+   LLVMTypeRef jit_cs_context_ptr_type;
+
+   LLVMValueRef function;
+
+   lp_jit_cs_func jit_function;
+
+   /** Number of invocations the function runs */
+   unsigned vector_length;
+
+   struct lp_cs_variant_list_item list_item;
+   struct lp_compute_shader *shader;
+
+   /* For debugging/profiling purposes */
+   unsigned no;
+};
+
+
+/** Subclass of pipe_compute_state */
+struct lp_compute_shader
+{
+   struct pipe_compute_state base;   /**< prog holds our copy of the tokens */
+
+   struct lp_tgsi_info info;
+
+   /** Masks of the declared RES[0..31] registers, and the raw ones */
+   uint32_t resource_mask;
+   uint32_t raw_resource_mask;
+
+   /** Whether the invocations of a group must be run as fibers */
+   boolean has_barrier;
+
+   struct lp_cs_variant_list_item variants;
+   unsigned variants_created;
+
+   /* For debugging/profiling purposes */
+   unsigned no;
+};
+
+
+struct lp_compute_shader_variant *
+llvmpipe_get_cs_variant(struct llvmpipe_context *lp, unsigned pc);
+
+void
+llvmpipe_init_compute_funcs(struct llvmpipe_context *lp);
+
+void
+llvmpipe_init_launch_grid_funcs(struct llvmpipe_context *lp);
+
+void
+llvmpipe_cleanup_compute(struct llvmpipe_context *lp);
+
+
+/*
+ * Called by the generated code.
+ */
+
+void
+lp_cs_barrier(void *barrier_data);
+
+void
+lp_cs_load_texel(uint32_t format, const uint8_t *src, uint32_t *values);
+
+void
+lp_cs_store_texel(uint32_t format, uint8_t *dst, const uint32_t *values);
+
+uint32_t
+lp_cs_atomic(uint32_t *ptr, uint32_t opcode, uint32_t src0, uint32_t src1);
+
+
+#endif /* LP_STATE_CS_H_ */
@@ -178,7 +178,12 @@ void llvmpipe_update_derived( struct llvmpipe_context *llvmpipe )
                           LP_NEW_OCCLUSION_QUERY))
       llvmpipe_update_fs( llvmpipe );
 
+   /* The setup variant key also uses the vertex slots (VS) and the
+    * depth format's minimum resolvable depth (FRAMEBUFFER).
+    */
    if (llvmpipe->dirty & (LP_NEW_FS |
+                          LP_NEW_VS |
+                          LP_NEW_FRAMEBUFFER |
 			  LP_NEW_RASTERIZER))
       llvmpipe_update_setup( llvmpipe );
 
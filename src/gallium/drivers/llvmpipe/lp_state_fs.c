@@ -67,6 +67,8 @@
 #include "util/u_string.h"
 #include "util/u_simple_list.h"
 #include "util/u_dual_blend.h"
+#include "util/u_cpu_detect.h"
+#include "util/u_disk_cache.h"
 #include "os/os_time.h"
 #include "pipe/p_shader_tokens.h"
 #include "draw/draw_context.h"
@@ -93,6 +95,7 @@
 #include "lp_bld_depth.h"
 #include "lp_bld_interp.h"
 #include "lp_context.h"
+#include "lp_fs_async.h"
 #include "lp_debug.h"
 #include "lp_perf.h"
 #include "lp_setup.h"
@@ -100,7 +103,9 @@
 #include "lp_tex_sample.h"
 #include "lp_flush.h"
 #include "lp_state_fs.h"
+#include "lp_texture.h"
 #include "lp_rast.h"
+#include "lp_screen.h"
 
 
 /** Fragment shader number (for debugging) */
@@ -390,7 +395,7 @@ generate_fs_loop(struct gallivm_state *gallivm,
    lp_build_tgsi_soa(gallivm, tokens, type, &mask,
                      consts_ptr, &system_values,
                      interp->inputs,
-                     outputs, sampler, &shader->info.base, NULL);
+                     outputs, sampler, &shader->info.base, NULL, NULL);
 
    /* Alpha test */
    if (key->alpha.enabled) {
@@ -1855,8 +1860,7 @@ generate_unswizzled_blend(struct gallivm_state *gallivm,
  * 2x2 pixels.
  */
 static void
-generate_fragment(struct llvmpipe_context *lp,
-                  struct lp_fragment_shader *shader,
+generate_fragment(struct lp_fragment_shader *shader,
                   struct lp_fragment_shader_variant *variant,
                   unsigned partial_mask)
 {
@@ -1950,8 +1954,15 @@ generate_fragment(struct llvmpipe_context *lp,
 
    blend_vec_type = lp_build_vec_type(gallivm, blend_type);
 
-   util_snprintf(func_name, sizeof(func_name), "fs%u_variant%u_%s", 
-		 shader->no, variant->no, partial_mask ? "partial" : "whole");
+   if (gallivm->disk_cache) {
+      /* Cached machine code is looked up by name across processes */
+      util_snprintf(func_name, sizeof(func_name), "fs_variant_%s",
+                    partial_mask ? "partial" : "whole");
+   }
+   else {
+      util_snprintf(func_name, sizeof(func_name), "fs%u_variant%u_%s",
+                    shader->no, variant->no, partial_mask ? "partial" : "whole");
+   }
 
    arg_types[0] = variant->jit_context_ptr_type;       /* context */
    arg_types[1] = int32_type;                          /* x */
@@ -2211,6 +2222,7 @@ dump_fs_variant_key(const struct lp_fragment_shader_variant_key *key)
       debug_printf("  .lod_bias_non_zero = %u\n", sampler->lod_bias_non_zero);
       debug_printf("  .apply_min_lod = %u\n", sampler->apply_min_lod);
       debug_printf("  .apply_max_lod = %u\n", sampler->apply_max_lod);
+      debug_printf("  .aniso = %u\n", sampler->aniso);
    }
    for (i = 0; i < key->nr_sampler_views; ++i) {
       const struct lp_static_texture_state *texture = &key->state[i].texture_state;
@@ -2225,6 +2237,7 @@ dump_fs_variant_key(const struct lp_fragment_shader_variant_key *key)
                    texture->pot_width,
                    texture->pot_height,
                    texture->pot_depth);
+      debug_printf("  .tiled = %u\n", texture->tiled);
    }
 }
 
@@ -2237,10 +2250,97 @@ lp_debug_fs_variant(const struct lp_fragment_shader_variant *variant)
    tgsi_dump(variant->shader->base.tokens, 0);
    dump_fs_variant_key(&variant->key);
    debug_printf("variant->opaque = %u\n", variant->opaque);
+   debug_printf("variant->hiz_func = %s\n",
+                util_dump_func(variant->hiz_func, TRUE));
    debug_printf("\n");
 }
 
 
+/**
+ * Make the key of the variant's machine code in the screen's persistent
+ * cache.
+ *
+ * The cache key is made of the TGSI tokens, the variant key and the host
+ * properties which affect code generation.
+ * \return  the key, to be freed with FREE(), or NULL on OOM
+ */
+static ubyte *
+make_variant_disk_cache_key(const struct lp_fragment_shader *shader,
+                            const struct lp_fragment_shader_variant *variant,
+                            unsigned *key_size)
+{
+   unsigned tokens_size;
+   ubyte *key;
+   ubyte *p;
+
+   tokens_size = tgsi_num_tokens(shader->base.tokens) *
+                 sizeof(struct tgsi_token);
+   *key_size = tokens_size + shader->variant_key_size +
+               sizeof lp_native_vector_width + sizeof util_cpu_caps;
+
+   key = MALLOC(*key_size);
+   if (!key)
+      return NULL;
+
+   p = key;
+   memcpy(p, shader->base.tokens, tokens_size);
+   p += tokens_size;
+   memcpy(p, &variant->key, shader->variant_key_size);
+   p += shader->variant_key_size;
+   memcpy(p, &lp_native_vector_width, sizeof lp_native_vector_width);
+   p += sizeof lp_native_vector_width;
+   memcpy(p, &util_cpu_caps, sizeof util_cpu_caps);
+
+   return key;
+}
+
+
+/**
+ * Build all the variant's functions in variant->gallivm and JIT them.
+ * Only depends on the shader and on the variant, so it is also called from
+ * the background compilation threads (see lp_fs_async.c).
+ */
+void
+llvmpipe_compile_fs_variant(struct lp_fragment_shader_variant *variant)
+{
+   struct lp_fragment_shader *shader = variant->shader;
+
+   lp_jit_init_types(variant);
+   
+   if (variant->jit_function[RAST_EDGE_TEST] == NULL)
+      generate_fragment(shader, variant, RAST_EDGE_TEST);
+
+   if (variant->jit_function[RAST_WHOLE] == NULL) {
+      if (variant->opaque) {
+         /* Specialized shader, which doesn't need to read the color buffer. */
+         generate_fragment(shader, variant, RAST_WHOLE);
+      }
+   }
+
+   /*
+    * Compile everything
+    */
+
+   gallivm_compile_module(variant->gallivm);
+
+   if (variant->function[RAST_EDGE_TEST]) {
+      variant->jit_function[RAST_EDGE_TEST] = (lp_jit_frag_func)
+            gallivm_jit_function(variant->gallivm,
+                                 variant->function[RAST_EDGE_TEST]);
+   }
+
+   if (variant->function[RAST_WHOLE]) {
+         variant->jit_function[RAST_WHOLE] = (lp_jit_frag_func)
+               gallivm_jit_function(variant->gallivm,
+                                    variant->function[RAST_WHOLE]);
+   } else if (!variant->jit_function[RAST_WHOLE]) {
+      variant->jit_function[RAST_WHOLE] = variant->jit_function[RAST_EDGE_TEST];
+   }
+
+   variant->code_size = variant->gallivm->code_size;
+}
+
+
 /**
  * Generate a new fragment shader variant from the shader code and
  * other state indicated by the key.
@@ -2250,15 +2350,26 @@ generate_variant(struct llvmpipe_context *lp,
                  struct lp_fragment_shader *shader,
                  const struct lp_fragment_shader_variant_key *key)
 {
+   struct llvmpipe_screen *screen = llvmpipe_screen(lp->pipe.screen);
    struct lp_fragment_shader_variant *variant;
    const struct util_format_description *cbuf0_format_desc;
    boolean fullcolormask;
+   boolean cached = FALSE;
+   ubyte *cache_key = NULL;
+   unsigned cache_key_size = 0;
 
    variant = CALLOC_STRUCT(lp_fragment_shader_variant);
    if(!variant)
       return NULL;
 
-   variant->gallivm = gallivm_create();
+   /*
+    * With background compilation, quickly build lightly optimized code to
+    * draw with until the fully optimized code is ready.
+    */
+   variant->gallivm = gallivm_create_in_context(NULL,
+                                                lp->fs_async ?
+                                                GALLIVM_OPT_FAST :
+                                                GALLIVM_OPT_DEFAULT);
    if (!variant->gallivm) {
       FREE(variant);
       return NULL;
@@ -2271,6 +2382,19 @@ generate_variant(struct llvmpipe_context *lp,
 
    memcpy(&variant->key, key, shader->variant_key_size);
 
+   if (screen->fs_cache) {
+      cache_key = make_variant_disk_cache_key(shader, variant, &cache_key_size);
+      if (cache_key &&
+          gallivm_set_disk_cache(variant->gallivm, screen->fs_cache,
+                                 cache_key, cache_key_size)) {
+         if (LP_DEBUG & DEBUG_FS) {
+            debug_printf("llvmpipe: fs #%u variant #%u found in disk cache\n",
+                         shader->no, variant->no);
+         }
+         cached = TRUE;
+      }
+   }
+
    /*
     * Determine whether we are touching all channels in the color buffer.
     */
@@ -2290,41 +2414,50 @@ generate_variant(struct llvmpipe_context *lp,
          !shader->info.base.uses_kill
          ? TRUE : FALSE;
 
-   if ((LP_DEBUG & DEBUG_FS) || (gallivm_debug & GALLIVM_DEBUG_IR)) {
-      lp_debug_fs_variant(variant);
-   }
+   variant->writes_depth = key->depth.enabled &&
+                           (key->depth.writemask ||
+                            shader->info.base.writes_z);
 
-   lp_jit_init_types(variant);
-   
-   if (variant->jit_function[RAST_EDGE_TEST] == NULL)
-      generate_fragment(lp, shader, variant, RAST_EDGE_TEST);
-
-   if (variant->jit_function[RAST_WHOLE] == NULL) {
-      if (variant->opaque) {
-         /* Specialized shader, which doesn't need to read the color buffer. */
-         generate_fragment(lp, shader, variant, RAST_WHOLE);
+   /*
+    * Blocks can be rejected when the fragments' depth can be bounded from
+    * the triangle's plane alone, and when failing the depth test has no
+    * side effects.
+    */
+   variant->hiz_func = PIPE_FUNC_ALWAYS;
+   variant->hiz_epsilon = 0.0f;
+   if (key->depth.enabled &&
+       !key->stencil[0].enabled &&
+       !shader->info.base.writes_z &&
+       !(LP_PERF & PERF_NO_HIZ)) {
+      const struct util_format_description *zs_format_desc =
+         util_format_description(key->zsbuf_format);
+
+      if (util_format_has_depth(zs_format_desc)) {
+         const struct util_format_channel_description *chan =
+            &zs_format_desc->channel[zs_format_desc->swizzle[0]];
+
+         variant->hiz_func = key->depth.func;
+         variant->hiz_epsilon = 1e-6f;
+         if (chan->type == UTIL_FORMAT_TYPE_UNSIGNED && chan->size < 32) {
+            /* allow for the rounding to the fixed point depth values */
+            variant->hiz_epsilon += 2.0f / (float)((1 << chan->size) - 1);
+         }
       }
    }
 
-   /*
-    * Compile everything
-    */
+   if ((LP_DEBUG & DEBUG_FS) || (gallivm_debug & GALLIVM_DEBUG_IR)) {
+      lp_debug_fs_variant(variant);
+   }
 
-   gallivm_compile_module(variant->gallivm);
+   llvmpipe_compile_fs_variant(variant);
 
-   if (variant->function[RAST_EDGE_TEST]) {
-      variant->jit_function[RAST_EDGE_TEST] = (lp_jit_frag_func)
-            gallivm_jit_function(variant->gallivm,
-                                 variant->function[RAST_EDGE_TEST]);
+   /* Cached code already is optimized */
+   if (lp->fs_async && !cached) {
+      lp_fs_async_queue(lp->fs_async, variant,
+                        screen->fs_cache, cache_key, cache_key_size);
    }
 
-   if (variant->function[RAST_WHOLE]) {
-         variant->jit_function[RAST_WHOLE] = (lp_jit_frag_func)
-               gallivm_jit_function(variant->gallivm,
-                                    variant->function[RAST_WHOLE]);
-   } else if (!variant->jit_function[RAST_WHOLE]) {
-      variant->jit_function[RAST_WHOLE] = variant->jit_function[RAST_EDGE_TEST];
-   }
+   FREE(cache_key);
 
    return variant;
 }
@@ -2462,6 +2595,12 @@ llvmpipe_remove_shader_variant(struct llvmpipe_context *lp,
                    lp->nr_fs_variants);
    }
 
+   /* wait for, and free, the optimized code being built in the background */
+   if (variant->async) {
+      lp_fs_async_release(lp->fs_async, variant->async);
+      variant->async = NULL;
+   }
+
    /* free all the variant's JIT'd functions */
    for (i = 0; i < Elements(variant->function); i++) {
       if (variant->function[i]) {
@@ -2481,6 +2620,7 @@ llvmpipe_remove_shader_variant(struct llvmpipe_context *lp,
    remove_from_list(&variant->list_item_global);
    lp->nr_fs_variants--;
    lp->nr_fs_instrs -= variant->nr_instrs;
+   lp->fs_code_size -= variant->code_size;
 
    FREE(variant);
 }
@@ -2727,6 +2867,8 @@ make_variant_key(struct llvmpipe_context *lp,
          if(shader->info.base.file_mask[TGSI_FILE_SAMPLER_VIEW] & (1 << i)) {
             lp_sampler_static_texture_state(&key->state[i].texture_state,
                                             lp->sampler_views[PIPE_SHADER_FRAGMENT][i]);
+            key->state[i].texture_state.tiled =
+               llvmpipe_sampler_view_is_tiled(lp->sampler_views[PIPE_SHADER_FRAGMENT][i]);
          }
       }
    }
@@ -2736,6 +2878,8 @@ make_variant_key(struct llvmpipe_context *lp,
          if(shader->info.base.file_mask[TGSI_FILE_SAMPLER] & (1 << i)) {
             lp_sampler_static_texture_state(&key->state[i].texture_state,
                                             lp->sampler_views[PIPE_SHADER_FRAGMENT][i]);
+            key->state[i].texture_state.tiled =
+               llvmpipe_sampler_view_is_tiled(lp->sampler_views[PIPE_SHADER_FRAGMENT][i]);
          }
       }
    }
@@ -2792,7 +2936,8 @@ llvmpipe_update_fs(struct llvmpipe_context *lp)
       variants_to_cull = lp->nr_fs_variants >= LP_MAX_SHADER_VARIANTS ? LP_MAX_SHADER_VARIANTS / 4 : 0;
 
       if (variants_to_cull ||
-          lp->nr_fs_instrs >= LP_MAX_SHADER_INSTRUCTIONS) {
+          lp->nr_fs_instrs >= LP_MAX_SHADER_INSTRUCTIONS ||
+          lp->fs_code_size >= LP_MAX_SHADER_CODE_SIZE) {
          struct pipe_context *pipe = &lp->pipe;
 
          /*
@@ -2808,7 +2953,11 @@ llvmpipe_update_fs(struct llvmpipe_context *lp)
           * pending for destruction on flush.
           */
 
-         for (i = 0; i < variants_to_cull || lp->nr_fs_instrs >= LP_MAX_SHADER_INSTRUCTIONS; i++) {
+         for (i = 0;
+              i < variants_to_cull ||
+              lp->nr_fs_instrs >= LP_MAX_SHADER_INSTRUCTIONS ||
+              lp->fs_code_size >= LP_MAX_SHADER_CODE_SIZE;
+              i++) {
             struct lp_fs_variant_list_item *item;
             if (is_empty_list(&lp->fs_variants_list)) {
                break;
@@ -2838,6 +2987,7 @@ llvmpipe_update_fs(struct llvmpipe_context *lp)
          insert_at_head(&lp->fs_variants_list, &variant->list_item_global);
          lp->nr_fs_variants++;
          lp->nr_fs_instrs += variant->nr_instrs;
+         lp->fs_code_size += variant->code_size;
          shader->variants_cached++;
       }
    }
@@ -40,6 +40,7 @@
 
 struct tgsi_token;
 struct lp_fragment_shader;
+struct lp_fs_async_job;
 
 
 /** Indexes into jit_function[] array */
@@ -98,6 +99,17 @@ struct lp_fragment_shader_variant
 
    boolean opaque;
 
+   /**
+    * Coarse depth rejection (see lp_rast_hiz_reject()): the depth func to
+    * test blocks with, PIPE_FUNC_ALWAYS when it can't be done, and the
+    * margin accounting for the depth format's precision.
+    */
+   unsigned hiz_func;
+   float hiz_epsilon;
+
+   /** Whether the depth buffer may be modified */
+   boolean writes_depth;
+
    struct gallivm_state *gallivm;
 
    LLVMTypeRef jit_context_ptr_type;
@@ -111,9 +123,18 @@ struct lp_fragment_shader_variant
    /* Total number of LLVM instructions generated */
    unsigned nr_instrs;
 
+   /** Bytes of machine code held, including the optimized build */
+   size_t code_size;
+
    struct lp_fs_variant_list_item list_item_global, list_item_local;
    struct lp_fragment_shader *shader;
 
+   /**
+    * Optimized build of this variant in progress or done in the background
+    * (see lp_fs_async.c), NULL if jit_function[] is final.
+    */
+   struct lp_fs_async_job *async;
+
    /* For debugging/profiling purposes */
    unsigned no;
 };
@@ -144,6 +165,9 @@ struct lp_fragment_shader
 void
 lp_debug_fs_variant(const struct lp_fragment_shader_variant *variant);
 
+void
+llvmpipe_compile_fs_variant(struct lp_fragment_shader_variant *variant);
+
 void
 llvmpipe_remove_shader_variant(struct llvmpipe_context *lp,
                                struct lp_fragment_shader_variant *variant);
@@ -133,6 +133,16 @@ llvmpipe_bind_geometry_sampler_states(struct pipe_context *pipe,
    llvmpipe_bind_sampler_states(pipe, PIPE_SHADER_GEOMETRY, 0, num, samplers);
 }
 
+
+static void
+llvmpipe_bind_compute_sampler_states(struct pipe_context *pipe,
+                                     unsigned start_slot,
+                                     unsigned num, void **samplers)
+{
+   llvmpipe_bind_sampler_states(pipe, PIPE_SHADER_COMPUTE, start_slot, num,
+                                samplers);
+}
+
 static void
 llvmpipe_set_sampler_views(struct pipe_context *pipe,
                            unsigned shader,
@@ -208,6 +218,16 @@ llvmpipe_set_geometry_sampler_views(struct pipe_context *pipe,
    llvmpipe_set_sampler_views(pipe, PIPE_SHADER_GEOMETRY, 0, num, views);
 }
 
+
+static void
+llvmpipe_set_compute_sampler_views(struct pipe_context *pipe,
+                                   unsigned start_slot, unsigned num,
+                                   struct pipe_sampler_view **views)
+{
+   llvmpipe_set_sampler_views(pipe, PIPE_SHADER_COMPUTE, start_slot, num,
+                              views);
+}
+
 static struct pipe_sampler_view *
 llvmpipe_create_sampler_view(struct pipe_context *pipe,
                             struct pipe_resource *texture,
@@ -420,9 +440,11 @@ llvmpipe_init_sampler_funcs(struct llvmpipe_context *llvmpipe)
    llvmpipe->pipe.bind_fragment_sampler_states  = llvmpipe_bind_fragment_sampler_states;
    llvmpipe->pipe.bind_vertex_sampler_states  = llvmpipe_bind_vertex_sampler_states;
    llvmpipe->pipe.bind_geometry_sampler_states  = llvmpipe_bind_geometry_sampler_states;
+   llvmpipe->pipe.bind_compute_sampler_states  = llvmpipe_bind_compute_sampler_states;
    llvmpipe->pipe.set_fragment_sampler_views = llvmpipe_set_fragment_sampler_views;
    llvmpipe->pipe.set_vertex_sampler_views = llvmpipe_set_vertex_sampler_views;
    llvmpipe->pipe.set_geometry_sampler_views = llvmpipe_set_geometry_sampler_views;
+   llvmpipe->pipe.set_compute_sampler_views = llvmpipe_set_compute_sampler_views;
    llvmpipe->pipe.create_sampler_view = llvmpipe_create_sampler_view;
    llvmpipe->pipe.sampler_view_destroy = llvmpipe_sampler_view_destroy;
    llvmpipe->pipe.delete_sampler_state = llvmpipe_delete_sampler_state;
@@ -41,7 +41,6 @@
 
 #include "lp_perf.h"
 #include "lp_debug.h"
-#include "lp_flush.h"
 #include "lp_screen.h"
 #include "lp_context.h"
 #include "lp_state.h"
@@ -784,6 +783,8 @@ generate_setup_variant(struct lp_setup_variant_key *key,
    if (!variant->jit_function)
       goto fail;
 
+   variant->code_size = gallivm->code_size;
+
    /*
     * Update timing information:
     */
@@ -855,13 +856,19 @@ lp_make_setup_variant_key(struct llvmpipe_context *lp,
 }
 
 
+/**
+ * Free a setup variant.  Called with the screen's setup_variants_mutex
+ * held, the variant must not be bound to any context.
+ */
 static void
-remove_setup_variant(struct llvmpipe_context *lp,
+remove_setup_variant(struct llvmpipe_screen *screen,
 		     struct lp_setup_variant *variant)
 {
+   assert(!variant->refcount);
+
    if (gallivm_debug & GALLIVM_DEBUG_IR) {
       debug_printf("llvmpipe: del setup_variant #%u total %u\n",
-		   variant->no, lp->nr_setup_variants);
+		   variant->no, screen->nr_setup_variants);
    }
 
    if (variant->function) {
@@ -875,37 +882,38 @@ remove_setup_variant(struct llvmpipe_context *lp,
    }
 
    remove_from_list(&variant->list_item_global);
-   lp->nr_setup_variants--;
+   screen->nr_setup_variants--;
+   screen->setup_code_size -= variant->code_size;
    FREE(variant);
 }
 
 
 
 /* When the number of setup variants exceeds a threshold, cull a
- * fraction (currently a quarter) of them.
+ * fraction (currently a quarter) of them, or more if their code is
+ * still over budget.
+ *
+ * Setup functions are only called while binning, from the thread of the
+ * context which has them bound, so no flush is needed: skipping the
+ * variants some context holds a reference to is enough.
  */
 static void
-cull_setup_variants(struct llvmpipe_context *lp)
+cull_setup_variants(struct llvmpipe_screen *screen)
 {
-   struct pipe_context *pipe = &lp->pipe;
-   int i;
-
-   /*
-    * XXX: we need to flush the context until we have some sort of reference
-    * counting in fragment shaders as they may still be binned
-    * Flushing alone might not be sufficient we need to wait on it too.
-    */
-   llvmpipe_finish(pipe, __FUNCTION__);
-
-   for (i = 0; i < LP_MAX_SETUP_VARIANTS / 4; i++) {
-      struct lp_setup_variant_list_item *item;
-      if (is_empty_list(&lp->setup_variants_list)) {
-         break;
-      }
-      item = last_elem(&lp->setup_variants_list);
-      assert(item);
+   struct lp_setup_variant_list_item *item;
+   int i = 0;
+
+   item = last_elem(&screen->setup_variants_list);
+   while (!at_end(&screen->setup_variants_list, item) &&
+          (i < LP_MAX_SETUP_VARIANTS / 4 ||
+           screen->setup_code_size >= LP_MAX_SETUP_CODE_SIZE)) {
+      struct lp_setup_variant_list_item *prev = prev_elem(item);
       assert(item->base);
-      remove_setup_variant(lp, item->base);
+      if (!item->base->refcount) {
+         remove_setup_variant(screen, item->base);
+         i++;
+      }
+      item = prev;
    }
 }
 
@@ -914,17 +922,23 @@ cull_setup_variants(struct llvmpipe_context *lp)
  * Update fragment/vertex shader linkage state.  This is called just
  * prior to drawing something when some fragment-related state has
  * changed.
+ *
+ * The variants live in the screen, so that contexts drawing with the same
+ * state share the generated code.
  */
 void 
 llvmpipe_update_setup(struct llvmpipe_context *lp)
 {
+   struct llvmpipe_screen *screen = llvmpipe_screen(lp->pipe.screen);
    struct lp_setup_variant_key *key = &lp->setup_variant.key;
    struct lp_setup_variant *variant = NULL;
    struct lp_setup_variant_list_item *li;
 
    lp_make_setup_variant_key(lp, key);
 
-   foreach(li, &lp->setup_variants_list) {
+   pipe_mutex_lock(screen->setup_variants_mutex);
+
+   foreach(li, &screen->setup_variants_list) {
       if(li->base->key.size == key->size &&
 	 memcmp(&li->base->key, key, key->size) == 0) {
          variant = li->base;
@@ -933,33 +947,65 @@ llvmpipe_update_setup(struct llvmpipe_context *lp)
    }
 
    if (variant) {
-      move_to_head(&lp->setup_variants_list, &variant->list_item_global);
+      move_to_head(&screen->setup_variants_list, &variant->list_item_global);
    }
    else {
-      if (lp->nr_setup_variants >= LP_MAX_SETUP_VARIANTS) {
-	 cull_setup_variants(lp);
+      if (screen->nr_setup_variants >= LP_MAX_SETUP_VARIANTS ||
+          screen->setup_code_size >= LP_MAX_SETUP_CODE_SIZE) {
+	 cull_setup_variants(screen);
       }
 
       variant = generate_setup_variant(key, lp);
       if (variant) {
-         insert_at_head(&lp->setup_variants_list, &variant->list_item_global);
-         lp->nr_setup_variants++;
+         insert_at_head(&screen->setup_variants_list,
+                        &variant->list_item_global);
+         screen->nr_setup_variants++;
+         screen->setup_code_size += variant->code_size;
          llvmpipe_variant_count++;
       }
    }
 
+   if (variant != lp->current_setup_variant) {
+      if (variant)
+         variant->refcount++;
+      if (lp->current_setup_variant)
+         lp->current_setup_variant->refcount--;
+      lp->current_setup_variant = variant;
+   }
+
+   pipe_mutex_unlock(screen->setup_variants_mutex);
+
    lp_setup_set_setup_variant(lp->setup,
 			      variant);
 }
 
+
+/**
+ * Drop the context's reference to its setup variant.  The variant itself
+ * stays cached in the screen.
+ */
+void
+lp_release_setup_variant(struct llvmpipe_context *lp)
+{
+   struct llvmpipe_screen *screen = llvmpipe_screen(lp->pipe.screen);
+
+   if (lp->current_setup_variant) {
+      pipe_mutex_lock(screen->setup_variants_mutex);
+      lp->current_setup_variant->refcount--;
+      lp->current_setup_variant = NULL;
+      pipe_mutex_unlock(screen->setup_variants_mutex);
+   }
+}
+
+
 void
-lp_delete_setup_variants(struct llvmpipe_context *lp)
+lp_delete_setup_variants(struct llvmpipe_screen *screen)
 {
    struct lp_setup_variant_list_item *li;
-   li = first_elem(&lp->setup_variants_list);
-   while(!at_end(&lp->setup_variants_list, li)) {
+   li = first_elem(&screen->setup_variants_list);
+   while(!at_end(&screen->setup_variants_list, li)) {
       struct lp_setup_variant_list_item *next = next_elem(li);
-      remove_setup_variant(lp, li->base);
+      remove_setup_variant(screen, li->base);
       li = next;
    }
 }
@@ -5,6 +5,7 @@
 
 
 struct llvmpipe_context;
+struct llvmpipe_screen;
 struct lp_setup_variant;
 
 struct lp_setup_variant_list_item
@@ -57,6 +58,11 @@ struct lp_setup_variant {
    
    struct lp_setup_variant_list_item list_item_global;
 
+   /** Number of contexts with this variant bound, under the screen's
+    * setup_variants_mutex.  Only unreferenced variants get culled.
+    */
+   unsigned refcount;
+
    struct gallivm_state *gallivm;
 
    /* XXX: this is a pointer to the LLVM IR.  Once jit_function is
@@ -70,10 +76,15 @@ struct lp_setup_variant {
     */
    lp_jit_setup_triangle jit_function;
 
+   /** Bytes of machine code held */
+   size_t code_size;
+
    unsigned no;
 };
 
-void lp_delete_setup_variants(struct llvmpipe_context *lp);
+void lp_release_setup_variant(struct llvmpipe_context *lp);
+
+void lp_delete_setup_variants(struct llvmpipe_screen *screen);
 
 void
 lp_dump_setup_coef( const struct lp_setup_variant_key *key,
@@ -44,6 +44,7 @@
 #include "util/u_transfer.h"
 
 #include "lp_context.h"
+#include "lp_debug.h"
 #include "lp_flush.h"
 #include "lp_screen.h"
 #include "lp_texture.h"
@@ -166,6 +167,48 @@ fail:
 }
 
 
+/**
+ * Whether a texture gets a tiled copy for sampling (see
+ * llvmpipe_resource::tiled_img).  The copy has the linear image's layout
+ * with the texels of each 4x4 block moved together, so it needs 1x1 blocks
+ * of a power of two size and rows padded to whole 4x4 blocks.
+ */
+static boolean
+llvmpipe_texture_can_tile(const struct llvmpipe_resource *lpr)
+{
+   const struct pipe_resource *pt = &lpr->base;
+   const struct util_format_description *desc =
+      util_format_description(pt->format);
+   unsigned level;
+
+   if (!(LP_PERF & PERF_TILED_TEX))
+      return FALSE;
+
+   if (!(pt->bind & PIPE_BIND_SAMPLER_VIEW) ||
+       (pt->bind & (PIPE_BIND_RENDER_TARGET |
+                    PIPE_BIND_DEPTH_STENCIL |
+                    PIPE_BIND_SHADER_RESOURCE |
+                    PIPE_BIND_COMPUTE_RESOURCE)) ||
+       pt->usage == PIPE_USAGE_STAGING)
+      return FALSE;
+
+   if (llvmpipe_resource_is_1d(pt))
+      return FALSE;
+
+   if (desc->block.width != 1 || desc->block.height != 1 ||
+       desc->block.bits < 8 || desc->block.bits > 128 ||
+       !util_is_power_of_two(desc->block.bits))
+      return FALSE;
+
+   for (level = 0; level <= pt->last_level; level++) {
+      if (lpr->row_stride[level] % (4 * desc->block.bits / 8))
+         return FALSE;
+   }
+
+   return TRUE;
+}
+
+
 /**
  * Check the size of the texture specified by 'res'.
  * \return TRUE if OK, FALSE if too large.
@@ -247,6 +290,8 @@ llvmpipe_resource_create(struct pipe_screen *_screen,
          /* texture map */
          if (!llvmpipe_texture_layout(screen, lpr))
             goto fail;
+
+         lpr->tiled = llvmpipe_texture_can_tile(lpr);
       }
    }
    else {
@@ -300,11 +345,15 @@ llvmpipe_resource_destroy(struct pipe_screen *pscreen,
       winsys->displaytarget_destroy(winsys, lpr->dt);
    }
    else if (llvmpipe_resource_is_texture(pt)) {
-      /* free linear image data */
-      if (lpr->linear_img.data) {
-         align_free(lpr->linear_img.data);
+      /* free linear image data, unless it is user memory */
+      if (lpr->linear_img.data && !lpr->userBuffer) {
+         large_free(lpr->linear_img.data, lpr->linear_img.size);
          lpr->linear_img.data = NULL;
       }
+      if (lpr->tiled_img.data) {
+         large_free(lpr->tiled_img.data, lpr->tiled_img.size);
+         lpr->tiled_img.data = NULL;
+      }
    }
    else if (!lpr->userBuffer) {
       assert(lpr->data);
@@ -603,10 +652,15 @@ llvmpipe_transfer_unmap(struct pipe_context *pipe,
                            transfer->level,
                            transfer->box.z);
 
-   /* Effectively do the texture_update work here - if texture images
-    * needed post-processing to put them into hardware layout, this is
-    * where it would happen.  For llvmpipe, nothing to do.
+   /* Effectively do the texture_update work here: bring the tiled copy
+    * of the level up to date with what was just written.
     */
+   if (transfer->usage & PIPE_TRANSFER_WRITE) {
+      struct llvmpipe_resource *lpr = llvmpipe_resource(transfer->resource);
+
+      if (lpr->tiled)
+         llvmpipe_update_tiled_texture(lpr, transfer->level, transfer->level);
+   }
    assert (transfer->resource);
    pipe_resource_reference(&transfer->resource, NULL);
    FREE(transfer);
@@ -630,7 +684,7 @@ llvmpipe_is_resource_referenced( struct pipe_context *pipe,
                             PIPE_BIND_SAMPLER_VIEW)))
       return LP_UNREFERENCED;
 
-   return lp_setup_is_resource_referenced(llvmpipe->setup, presource);
+   return lp_setup_is_resource_referenced(llvmpipe->setup, presource, level);
 }
 
 
@@ -695,6 +749,78 @@ llvmpipe_user_buffer_create(struct pipe_screen *screen,
 }
 
 
+/**
+ * Create a resource backed by user memory, without copying it.
+ * Buffers and single-level 2D textures whose rows are tightly packed
+ * (row stride = width * block size) are supported.
+ */
+static struct pipe_resource *
+llvmpipe_resource_from_user_memory(struct pipe_screen *screen,
+                                   const struct pipe_resource *templat,
+                                   void *user_memory)
+{
+   struct llvmpipe_resource *lpr;
+   unsigned stride = 0;
+
+   if (llvmpipe_resource_is_texture(templat)) {
+      /* Only layouts llvmpipe_texture_layout() could have produced itself:
+       * whole 4x4 raster blocks and 16-byte aligned rows.
+       */
+      if ((templat->target != PIPE_TEXTURE_2D &&
+           templat->target != PIPE_TEXTURE_RECT) ||
+          templat->last_level != 0 ||
+          templat->depth0 != 1 ||
+          templat->array_size != 1 ||
+          templat->nr_samples > 1 ||
+          util_format_is_compressed(templat->format) ||
+          templat->width0 % LP_RASTER_BLOCK_SIZE ||
+          templat->height0 % LP_RASTER_BLOCK_SIZE)
+         return NULL;
+
+      stride = util_format_get_stride(templat->format, templat->width0);
+      if (stride % 16 || (uintptr_t) user_memory % 16 ||
+          stride > LP_MAX_TEXTURE_SIZE / templat->height0)
+         return NULL;
+   }
+   else {
+      /* Render targets need the extra padding llvmpipe_resource_create()
+       * reserves past the end.
+       */
+      if (templat->bind & PIPE_BIND_RENDER_TARGET)
+         return NULL;
+   }
+
+   lpr = CALLOC_STRUCT(llvmpipe_resource);
+   if (!lpr)
+      return NULL;
+
+   lpr->base = *templat;
+   pipe_reference_init(&lpr->base.reference, 1);
+   lpr->base.screen = screen;
+   lpr->userBuffer = TRUE;
+
+   if (llvmpipe_resource_is_texture(templat)) {
+      lpr->row_stride[0] = stride;
+      lpr->img_stride[0] = stride * templat->height0;
+      lpr->num_slices_faces[0] = 1;
+      lpr->linear_mip_offsets[0] = 0;
+      lpr->linear_img.data = user_memory;
+   }
+   else {
+      lpr->row_stride[0] = templat->width0;
+      lpr->data = user_memory;
+   }
+
+   lpr->id = id_counter++;
+
+#ifdef DEBUG
+   insert_at_tail(&resource_list, lpr);
+#endif
+
+   return &lpr->base;
+}
+
+
 /**
  * Compute size (in bytes) need to store a texture image / mipmap level,
  * for just one cube face, one array layer or one 3D texture slice
@@ -774,9 +900,22 @@ alloc_image_data(struct llvmpipe_resource *lpr)
          lpr->linear_mip_offsets[level] = offset;
          offset += align(buffer_size, alignment);
       }
-      lpr->linear_img.data = align_malloc(offset, alignment);
-      if (lpr->linear_img.data) {
-         memset(lpr->linear_img.data, 0, offset);
+      /*
+       * Zero-filled, and for big images left untouched so that the pages
+       * get placed near the rasterizer threads which first write them.
+       */
+      lpr->linear_img.data = large_malloc(offset, alignment);
+      lpr->linear_img.size = offset;
+
+      if (lpr->tiled && lpr->linear_img.data) {
+         /* zeros are tiled zeros, so both images start out matching */
+         lpr->tiled_img.data = large_malloc(offset, alignment);
+         lpr->tiled_img.size = offset;
+         if (!lpr->tiled_img.data) {
+            /* the sampling code was generated for the tiled layout */
+            large_free(lpr->linear_img.data, lpr->linear_img.size);
+            lpr->linear_img.data = NULL;
+         }
       }
    }
 }
@@ -818,6 +957,10 @@ llvmpipe_get_texture_image(struct llvmpipe_resource *lpr,
       target_data = target_img->data;
    }
 
+   if (usage != LP_TEX_USAGE_READ && lpr->tiled) {
+      lpr->tiled_dirty |= 1 << level;
+   }
+
    target_offset = target_off_ptr[level];
 
    if (face_slice > 0) {
@@ -855,6 +998,65 @@ llvmpipe_get_texture_image_all(struct llvmpipe_resource *lpr,
 }
 
 
+/**
+ * Copy a level of the linear image to the tiled one, with the 4x4 blocks
+ * of texels in row-major order and the texels in each in row-major order.
+ */
+static void
+tile_texture_level(struct llvmpipe_resource *lpr, unsigned level)
+{
+   const unsigned texel_size = util_format_get_blocksize(lpr->base.format);
+   const unsigned tile_row_size = 4 * texel_size;
+   const unsigned row_stride = lpr->row_stride[level];
+   const unsigned num_rows = lpr->img_stride[level] / row_stride;
+   const unsigned num_tiles_x = row_stride / tile_row_size;
+   unsigned slice, x, y, i;
+
+   assert(num_rows % 4 == 0);
+
+   for (slice = 0; slice < lpr->num_slices_faces[level]; slice++) {
+      const unsigned offset = lpr->linear_mip_offsets[level] +
+                              slice * tex_image_face_size(lpr, level);
+      const ubyte *src = (const ubyte *) lpr->linear_img.data + offset;
+      ubyte *dst = (ubyte *) lpr->tiled_img.data + offset;
+
+      for (y = 0; y < num_rows; y += 4) {
+         for (x = 0; x < num_tiles_x; x++) {
+            for (i = 0; i < 4; i++) {
+               memcpy(dst, src + i * row_stride + x * tile_row_size,
+                      tile_row_size);
+               dst += tile_row_size;
+            }
+         }
+         src += 4 * row_stride;
+      }
+   }
+}
+
+
+/**
+ * Bring the levels of the tiled copy of a texture up to date with the
+ * linear image.
+ */
+void
+llvmpipe_update_tiled_texture(struct llvmpipe_resource *lpr,
+                              unsigned first_level,
+                              unsigned last_level)
+{
+   unsigned level;
+
+   if (!lpr->tiled || !lpr->tiled_img.data)
+      return;
+
+   for (level = first_level; level <= last_level; level++) {
+      if (lpr->tiled_dirty & (1 << level)) {
+         tile_texture_level(lpr, level);
+         lpr->tiled_dirty &= ~(1 << level);
+      }
+   }
+}
+
+
 /**
  * Get pointer to a linear image (not the tile!) at tile (x,y).
  * \return pointer to start of image/face (not the tile)
@@ -879,6 +1081,10 @@ llvmpipe_get_texture_tile_linear(struct llvmpipe_resource *lpr,
    }
    assert(linear_img->data);
 
+   if (usage != LP_TEX_USAGE_READ && lpr->tiled) {
+      lpr->tiled_dirty |= 1 << level;
+   }
+
    /* compute address of the slice/face of the image that contains the tile */
    linear_image = llvmpipe_get_texture_image_address(lpr, face_slice, level);
 
@@ -899,6 +1105,8 @@ llvmpipe_resource_size(const struct pipe_resource *resource)
       for (lvl = 0; lvl <= lpr->base.last_level; lvl++) {
          if (lpr->linear_img.data)
             size += tex_image_size(lpr, lvl);
+         if (lpr->tiled_img.data)
+            size += tex_image_size(lpr, lvl);
       }
    }
    else {
@@ -949,6 +1157,7 @@ llvmpipe_init_screen_resource_funcs(struct pipe_screen *screen)
    screen->resource_create = llvmpipe_resource_create;
    screen->resource_destroy = llvmpipe_resource_destroy;
    screen->resource_from_handle = llvmpipe_resource_from_handle;
+   screen->resource_from_user_memory = llvmpipe_resource_from_user_memory;
    screen->resource_get_handle = llvmpipe_resource_get_handle;
    screen->can_create_resource = llvmpipe_can_create_resource;
 }
@@ -53,6 +53,7 @@ struct sw_displaytarget;
 struct llvmpipe_texture_image
 {
    void *data;
+   unsigned size;  /**< of data, when allocated with large_malloc() */
 };
 
 
@@ -87,6 +88,17 @@ struct llvmpipe_resource
     */
    struct llvmpipe_texture_image linear_img;
 
+   /**
+    * Copy of linear_img with each 4x4 block of texels stored contiguously,
+    * which is what gets sampled when 'tiled' is set.  Only textures which
+    * are never rendered to get one; it has the same size and mip offsets
+    * as linear_img.  tiled_dirty has a bit for each level whose copy is
+    * older than linear_img.
+    */
+   boolean tiled;
+   struct llvmpipe_texture_image tiled_img;
+   unsigned tiled_dirty;
+
    /**
     * Data for non-texture resources.
     */
@@ -180,6 +192,17 @@ llvmpipe_resource_is_1d(const struct pipe_resource *resource)
 }
 
 
+/**
+ * Whether the view samples the tiled copy of its texture.
+ */
+static INLINE boolean
+llvmpipe_sampler_view_is_tiled(const struct pipe_sampler_view *view)
+{
+   return view && view->texture &&
+          llvmpipe_resource_const(view->texture)->tiled;
+}
+
+
 static INLINE unsigned
 llvmpipe_layer_stride(struct pipe_resource *resource,
                       unsigned level)
@@ -234,6 +257,11 @@ llvmpipe_get_texture_image_all(struct llvmpipe_resource *lpr,
                                unsigned level,
                                enum lp_texture_usage usage);
 
+void
+llvmpipe_update_tiled_texture(struct llvmpipe_resource *lpr,
+                              unsigned first_level,
+                              unsigned last_level);
+
 ubyte *
 llvmpipe_get_texture_tile_linear(struct llvmpipe_resource *lpr,
                                  unsigned face_slice, unsigned level,
@@ -13,6 +13,11 @@
 
 #define NOUVEAU_TRANSFER_PUSHBUF_THRESHOLD 192
 
+/* VRAM buffers whose contents had to be copied back this many times are
+ * moved to GART, where the CPU can access them directly.
+ */
+#define NOUVEAU_BUFFER_MIGRATE_READBACKS 4
+
 struct nouveau_transfer {
    struct pipe_transfer base;
 
@@ -165,6 +170,9 @@ nouveau_transfer_read(struct nouveau_context *nv, struct nouveau_transfer *tx)
 
    NOUVEAU_DRV_STAT(nv->screen, buf_read_bytes_staging_vid, size);
 
+   if (buf->readbacks < NOUVEAU_BUFFER_MIGRATE_READBACKS)
+      buf->readbacks++;
+
    nv->copy_data(nv, tx->bo, tx->offset, NOUVEAU_BO_GART,
                  buf->bo, buf->offset + base, buf->domain, size);
 
@@ -313,14 +321,55 @@ nouveau_buffer_cache(struct nouveau_context *nv, struct nv04_resource *buf)
 #define NOUVEAU_TRANSFER_DISCARD \
    (PIPE_TRANSFER_DISCARD_RANGE | PIPE_TRANSFER_DISCARD_WHOLE_RESOURCE)
 
+/* Buffers with a dedicated bo (!buf->mm) rely on kernel fences. */
+static INLINE boolean
+nouveau_buffer_bo_busy(struct nouveau_context *nv, struct nv04_resource *buf,
+                       unsigned rw)
+{
+   const uint32_t access =
+      (rw & PIPE_TRANSFER_WRITE) ? NOUVEAU_BO_WR : NOUVEAU_BO_RD;
+
+   return nouveau_bo_wait(buf->bo, access | NOUVEAU_BO_NOBLOCK,
+                          nv->client) != 0;
+}
+
 static INLINE boolean
-nouveau_buffer_should_discard(struct nv04_resource *buf, unsigned usage)
+nouveau_buffer_should_discard(struct nouveau_context *nv,
+                              struct nv04_resource *buf, unsigned usage)
 {
    if (!(usage & PIPE_TRANSFER_DISCARD_WHOLE_RESOURCE))
       return FALSE;
    if (unlikely(buf->base.bind & PIPE_BIND_SHARED))
       return FALSE;
-   return buf->mm && nouveau_buffer_busy(buf, PIPE_TRANSFER_WRITE);
+   if (!buf->mm)
+      return nouveau_buffer_bo_busy(nv, buf, PIPE_TRANSFER_WRITE);
+   return nouveau_buffer_busy(buf, PIPE_TRANSFER_WRITE);
+}
+
+/* Move a VRAM buffer the CPU keeps reading back to GART. */
+static void
+nouveau_buffer_migrate_to_gart(struct nouveau_context *nv,
+                               struct nv04_resource *buf)
+{
+   int ref = buf->base.reference.count - 1;
+
+   if (!nouveau_buffer_migrate(nv, buf, NOUVEAU_BO_GART))
+      return;
+   buf->readbacks = 0;
+
+   /* The system memory copy is only maintained for VRAM buffers. */
+   if (buf->data) {
+      align_free(buf->data);
+      buf->data = NULL;
+   }
+   buf->status &= ~NOUVEAU_BUFFER_STATUS_DIRTY;
+
+   /* The CPU must not access the new storage before the copy is done. */
+   nouveau_fence_ref(nv->screen->fence.current, &buf->fence);
+   nouveau_fence_ref(nv->screen->fence.current, &buf->fence_wr);
+
+   if (ref > 0) /* any references inside context possible ? */
+      nv->invalidate_resource_storage(nv, &buf->base, ref);
 }
 
 static void *
@@ -346,6 +395,12 @@ nouveau_buffer_transfer_map(struct pipe_context *pipe,
    if (usage & PIPE_TRANSFER_WRITE)
       NOUVEAU_DRV_STAT(nv->screen, buf_transfers_wr, 1);
 
+   if (buf->domain == NOUVEAU_BO_VRAM &&
+       buf->readbacks >= NOUVEAU_BUFFER_MIGRATE_READBACKS &&
+       !(usage & NOUVEAU_TRANSFER_DISCARD) &&
+       !(buf->base.bind & PIPE_BIND_SHARED))
+      nouveau_buffer_migrate_to_gart(nv, buf);
+
    if (buf->domain == NOUVEAU_BO_VRAM) {
       if (usage & NOUVEAU_TRANSFER_DISCARD) {
          if (usage & PIPE_TRANSFER_DISCARD_WHOLE_RESOURCE)
@@ -372,13 +427,25 @@ nouveau_buffer_transfer_map(struct pipe_context *pipe,
       return buf->data + box->x;
    }
 
-   if (nouveau_buffer_should_discard(buf, usage)) {
+   if (nouveau_buffer_should_discard(nv, buf, usage)) {
       int ref = buf->base.reference.count - 1;
       nouveau_buffer_reallocate(nv->screen, buf, buf->domain);
       if (ref > 0) /* any references inside context possible ? */
          nv->invalidate_resource_storage(nv, &buf->base, ref);
    }
 
+   /* Don't let the kernel wait for the GPU if we can write through a staging
+    * buffer instead.
+    */
+   if (!buf->mm && (usage & PIPE_TRANSFER_DISCARD_RANGE) &&
+       !(usage & PIPE_TRANSFER_UNSYNCHRONIZED) &&
+       nouveau_buffer_bo_busy(nv, buf, PIPE_TRANSFER_WRITE)) {
+      map = nouveau_transfer_staging(nv, tx, TRUE);
+      if (!map)
+         FREE(tx);
+      return map;
+   }
+
    ret = nouveau_bo_map(buf->bo,
                         buf->mm ? 0 : nouveau_screen_transfer_flags(usage),
                         nv->client);
@@ -39,6 +39,7 @@ struct nv04_resource {
 
    uint8_t status;
    uint8_t domain;
+   uint8_t readbacks; /* number of VRAM -> CPU copies, see transfer_map */
 
    struct nouveau_fence *fence;
    struct nouveau_fence *fence_wr;
@@ -21,6 +21,7 @@
  */
 
 #include "util/u_double_list.h"
+#include "os/os_time.h"
 
 #include "nouveau_screen.h"
 #include "nouveau_winsys.h"
@@ -66,6 +67,10 @@ nouveau_fence_work(struct nouveau_fence *fence,
 {
    struct nouveau_fence_work *work;
 
+   /* the fence may well be done already, don't hold on to the data then */
+   if (fence && fence->state >= NOUVEAU_FENCE_STATE_EMITTED)
+      nouveau_fence_update(fence->screen, FALSE);
+
    if (!fence || fence->state == NOUVEAU_FENCE_STATE_SIGNALLED) {
       func(data);
       return TRUE;
@@ -169,11 +174,21 @@ nouveau_fence_update(struct nouveau_screen *screen, boolean flushed)
 
 #define NOUVEAU_FENCE_MAX_SPINS (1 << 31)
 
+/* Waits poll the fence busily at first, then yield, then sleep with an
+ * exponential backoff so that long waits don't burn a CPU core.
+ */
+#define NOUVEAU_FENCE_BUSY_SPINS   16
+#define NOUVEAU_FENCE_YIELD_SPINS  64
+#define NOUVEAU_FENCE_MAX_SLEEP_US 500
+
 boolean
 nouveau_fence_signalled(struct nouveau_fence *fence)
 {
    struct nouveau_screen *screen = fence->screen;
 
+   if (fence->state == NOUVEAU_FENCE_STATE_SIGNALLED)
+      return TRUE;
+
    if (fence->state >= NOUVEAU_FENCE_STATE_EMITTED)
       nouveau_fence_update(screen, FALSE);
 
@@ -185,6 +200,10 @@ nouveau_fence_wait(struct nouveau_fence *fence)
 {
    struct nouveau_screen *screen = fence->screen;
    uint32_t spins = 0;
+   unsigned sleep_us = 1;
+
+   if (fence->state == NOUVEAU_FENCE_STATE_SIGNALLED)
+      return TRUE;
 
    /* wtf, someone is waiting on a fence in flush_notify handler? */
    assert(fence->state != NOUVEAU_FENCE_STATE_EMITTING);
@@ -208,8 +227,13 @@ nouveau_fence_wait(struct nouveau_fence *fence)
       if (!spins)
          NOUVEAU_DRV_STAT(screen, any_non_kernel_fence_sync_count, 1);
       spins++;
+
+      if (spins > NOUVEAU_FENCE_YIELD_SPINS) {
+         os_time_sleep(sleep_us);
+         sleep_us = MIN2(sleep_us * 2, NOUVEAU_FENCE_MAX_SLEEP_US);
+      }
 #ifdef PIPE_OS_UNIX
-      if (!(spins % 8)) /* donate a few cycles */
+      else if (spins > NOUVEAU_FENCE_BUSY_SPINS) /* donate a few cycles */
          sched_yield();
 #endif
    } while (spins < NOUVEAU_FENCE_MAX_SPINS);
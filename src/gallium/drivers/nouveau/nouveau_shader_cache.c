@@ -0,0 +1,146 @@
+/*
+ * Copyright 2013 The Mesa Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <dlfcn.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "os/os_thread.h"
+#include "tgsi/tgsi_parse.h"
+#include "util/u_disk_cache.h"
+#include "util/u_memory.h"
+
+#include "nouveau_shader_cache.h"
+
+/* The cache is shared by all screens of the process, programs are translated
+ * without access to their screen.
+ */
+static struct util_disk_cache *shader_cache;
+static boolean shader_cache_init;
+pipe_static_mutex(shader_cache_mutex);
+
+static void
+make_dir(char *path)
+{
+   char *p;
+
+   /* Create the missing parents first, like mkdir -p. */
+   for (p = strchr(path + 1, '/'); p; p = strchr(p + 1, '/')) {
+      *p = '\0';
+      mkdir(path, 0755);
+      *p = '/';
+   }
+   mkdir(path, 0755);
+}
+
+static struct util_disk_cache *
+nouveau_shader_cache_create(void)
+{
+   char path[PATH_MAX];
+   char id[64];
+   struct stat st;
+   Dl_info info;
+   const char *dir;
+   int n = -1;
+
+   /* An empty NOUVEAU_SHADER_CACHE_DIR disables the cache. */
+   if ((dir = getenv("NOUVEAU_SHADER_CACHE_DIR")) != NULL)
+      n = snprintf(path, sizeof(path), "%s", dir);
+   else if ((dir = getenv("XDG_CACHE_HOME")) != NULL)
+      n = snprintf(path, sizeof(path), "%s/mesa/nouveau", dir);
+   else if ((dir = getenv("HOME")) != NULL)
+      n = snprintf(path, sizeof(path), "%s/.cache/mesa/nouveau", dir);
+
+   if (n <= 0 || n >= (int)sizeof(path))
+      return NULL;
+
+   /* The programs are stored as raw structs, whose layout may change with
+    * any rebuild of the driver just like the code generation, and we use
+    * the driver's own file to tell builds apart.
+    */
+   if (!dladdr((void *)nouveau_shader_cache_create, &info) ||
+       info.dli_fname == NULL ||
+       stat(info.dli_fname, &st) != 0)
+      return NULL;
+
+   make_dir(path);
+
+   snprintf(id, sizeof(id), "nouveau %lx %lx",
+            (unsigned long)st.st_mtime, (unsigned long)st.st_size);
+   return util_disk_cache_create(path, id);
+}
+
+static struct util_disk_cache *
+nouveau_shader_cache(void)
+{
+   struct util_disk_cache *cache;
+
+   pipe_mutex_lock(shader_cache_mutex);
+   if (!shader_cache_init) {
+      shader_cache = nouveau_shader_cache_create();
+      shader_cache_init = TRUE;
+   }
+   cache = shader_cache;
+   pipe_mutex_unlock(shader_cache_mutex);
+
+   return cache;
+}
+
+void *
+nouveau_shader_cache_key(const void *fixed, size_t fixed_size,
+                         const struct tgsi_token *tokens, size_t *key_size)
+{
+   const size_t tokens_size = tgsi_num_tokens(tokens) * sizeof(*tokens);
+   uint8_t *key;
+
+   if (!nouveau_shader_cache())
+      return NULL;
+
+   *key_size = fixed_size + tokens_size;
+   key = MALLOC(*key_size);
+   if (!key)
+      return NULL;
+
+   memcpy(key, fixed, fixed_size);
+   memcpy(key + fixed_size, tokens, tokens_size);
+   return key;
+}
+
+boolean
+nouveau_shader_cache_get(const void *key, size_t key_size,
+                         void **data, size_t *data_size)
+{
+   return util_disk_cache_get(nouveau_shader_cache(), key, key_size,
+                              data, data_size);
+}
+
+void
+nouveau_shader_cache_put(const void *key, size_t key_size,
+                         const void *data, size_t data_size)
+{
+   util_disk_cache_put(nouveau_shader_cache(), key, key_size,
+                       data, data_size);
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright 2013 The Mesa Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __NOUVEAU_SHADER_CACHE_H__
+#define __NOUVEAU_SHADER_CACHE_H__
+
+#include "pipe/p_compiler.h"
+
+struct tgsi_token;
+
+/* Build a cache key from the driver specific part (which must not contain
+ * uninitialized padding) and the TGSI tokens of the shader.
+ *
+ * Returns NULL if the cache is disabled, the key must be FREE'd otherwise.
+ */
+void *
+nouveau_shader_cache_key(const void *fixed, size_t fixed_size,
+                         const struct tgsi_token *tokens, size_t *key_size);
+
+/* On success, the entry is returned in a buffer to be FREE'd by the caller. */
+boolean
+nouveau_shader_cache_get(const void *key, size_t key_size,
+                         void **data, size_t *data_size);
+
+void
+nouveau_shader_cache_put(const void *key, size_t key_size,
+                         const void *data, size_t data_size);
+
+#endif
@@ -209,6 +209,9 @@ extern void nv50_ir_relocate_code(void *relocData, uint32_t *code,
                                   uint32_t libPos,
                                   uint32_t dataPos);
 
+/* size of the relocation data in bytes, to be able to store it elsewhere */
+extern uint32_t nv50_ir_get_reloc_size(const void *relocData);
+
 /* obtain code that will be shared among programs */
 extern void nv50_ir_get_target_library(uint32_t chipset,
                                        const uint32_t **code, uint32_t *size);
@@ -25,11 +25,16 @@
 
 #include <stack>
 #include <limits>
+#include <algorithm>
 
 namespace nv50_ir {
 
 #define MAX_REGISTER_FILE_SIZE 256
 
+// Functions with at least this many instructions are allocated with a linear
+// scan over the live intervals instead of graph colouring.
+#define LINEAR_SCAN_MIN_INSNS 2048
+
 class RegisterSet
 {
 public:
@@ -691,6 +696,9 @@ private:
    void calculateSpillWeights();
    void simplify();
    bool selectRegisters();
+   bool linearScan();
+   void setRegisterIds();
+   void resetRegisters();
    void cleanup(const bool success);
 
    void simplifyEdge(RIG_Node *, RIG_Node *);
@@ -700,9 +708,10 @@ private:
    void resolveSplitsAndMerges();
    void makeCompound(Instruction *, bool isSplit);
 
-   inline void checkInterference(const RIG_Node *, Graph::EdgeIterator&);
+   inline void checkInterference(const RIG_Node *, const RIG_Node *);
 
    inline void insertOrderedTail(std::list<RIG_Node *>&, RIG_Node *);
+   static bool livenessOrder(const RIG_Node *, const RIG_Node *);
    void checkList(std::list<RIG_Node *>&);
 
 private:
@@ -1219,10 +1228,8 @@ GCRA::simplify()
 }
 
 void
-GCRA::checkInterference(const RIG_Node *node, Graph::EdgeIterator& ei)
+GCRA::checkInterference(const RIG_Node *node, const RIG_Node *intf)
 {
-   const RIG_Node *intf = RIG_Node::get(ei);
-
    if (intf->reg < 0)
       return;
    const LValue *vA = node->getValue();
@@ -1285,9 +1292,9 @@ GCRA::selectRegisters()
                node->getValue()->id, node->colors);
 
       for (Graph::EdgeIterator ei = node->outgoing(); !ei.end(); ei.next())
-         checkInterference(node, ei);
+         checkInterference(node, RIG_Node::get(ei));
       for (Graph::EdgeIterator ei = node->incident(); !ei.end(); ei.next())
-         checkInterference(node, ei);
+         checkInterference(node, RIG_Node::get(ei));
 
       if (!node->prefRegs.empty()) {
          for (std::list<RIG_Node *>::const_iterator it = node->prefRegs.begin();
@@ -1320,13 +1327,113 @@ GCRA::selectRegisters()
    }
    if (!mustSpill.empty())
       return false;
+   setRegisterIds();
+   return true;
+}
+
+bool
+GCRA::livenessOrder(const RIG_Node *a, const RIG_Node *b)
+{
+   return a->livei.begin() < b->livei.begin();
+}
+
+// Assign registers in the order in which the values become live, checking
+// only against the values still live at that point. This skips building the
+// interference graph, which is what makes large shaders slow to compile, but
+// it can't choose good spill candidates: if we run out of registers, we just
+// fail and let the caller fall back to graph colouring.
+bool
+GCRA::linearScan()
+{
+   std::vector<RIG_Node *> values;
+   std::list<RIG_Node *> active, fixed;
+
+   INFO_DBG(prog->dbgFlags, REG_ALLOC, "\nLINEAR SCAN phase\n");
+
+   for (unsigned int i = 0; i < nodeCount; ++i) {
+      RIG_Node *const n = &nodes[i];
+      if (!n->colors || n->livei.isEmpty())
+         continue;
+      if (n->reg >= 0) {
+         // update max reg, and check against these even before they're live
+         regs.occupy(n->f, n->reg, n->colors);
+         fixed.push_back(n);
+      }
+      values.push_back(n);
+   }
+   std::stable_sort(values.begin(), values.end(), livenessOrder);
+
+   for (std::vector<RIG_Node *>::iterator v = values.begin();
+        v != values.end(); ++v) {
+      RIG_Node *node = *v;
+      std::list<RIG_Node *>::iterator it;
+
+      for (it = active.begin(); it != active.end();) {
+         if ((*it)->livei.end() <= node->livei.begin())
+            it = active.erase(it);
+         else
+            ++it;
+      }
+      active.push_back(node);
+
+      if (node->reg >= 0)
+         continue;
+
+      regs.reset(node->f);
+
+      for (it = active.begin(); it != active.end(); ++it)
+         if (*it != node && (*it)->f == node->f &&
+             (*it)->livei.overlaps(node->livei))
+            checkInterference(node, *it);
+      for (it = fixed.begin(); it != fixed.end(); ++it)
+         if ((*it)->f == node->f && (*it)->livei.overlaps(node->livei))
+            checkInterference(node, *it);
+
+      for (it = node->prefRegs.begin(); it != node->prefRegs.end(); ++it) {
+         if ((*it)->reg >= 0 &&
+             regs.testOccupy(node->f, (*it)->reg, node->colors)) {
+            node->reg = (*it)->reg;
+            break;
+         }
+      }
+      if (node->reg >= 0)
+         continue;
+      if (!regs.assign(node->reg, node->f, node->colors)) {
+         INFO_DBG(prog->dbgFlags, REG_ALLOC, "out of registers at %%%i\n",
+                  node->getValue()->id);
+         return false;
+      }
+      node->getValue()->compMask = node->getCompMask();
+   }
+
+   setRegisterIds();
+   return true;
+}
+
+void
+GCRA::setRegisterIds()
+{
    for (unsigned int i = 0; i < nodeCount; ++i) {
       LValue *lval = nodes[i].getValue();
       if (nodes[i].reg >= 0 && nodes[i].colors > 0)
          lval->reg.data.id =
             regs.unitsToId(nodes[i].f, nodes[i].reg, lval->reg.size);
    }
-   return true;
+}
+
+// Undo the assignments of a failed linearScan().
+void
+GCRA::resetRegisters()
+{
+   for (unsigned int i = 0; i < nodeCount; ++i) {
+      LValue *lval = nodes[i].getValue();
+      if (!nodes[i].colors || lval->reg.data.id >= 0)
+         continue;
+      nodes[i].reg = -1;
+      lval->compMask = 0;
+   }
+   for (unsigned int f = 0; f <= LAST_REGISTER_FILE; ++f)
+      regs.reset(static_cast<DataFile>(f), true);
 }
 
 bool
@@ -1357,11 +1464,22 @@ GCRA::allocateRegisters(ArrayList& insns)
    if (func->getProgram()->dbgFlags & NV50_IR_DEBUG_REG_ALLOC)
       func->printLiveIntervals();
 
-   buildRIG(insns);
-   calculateSpillWeights();
-   simplify();
+   ret = false;
+   if (prog->optLevel < 1 || insns.getSize() >= LINEAR_SCAN_MIN_INSNS) {
+      ret = linearScan();
+      if (!ret) {
+         INFO_DBG(prog->dbgFlags, REG_ALLOC,
+                  "linear scan failed, using graph colouring ...\n");
+         resetRegisters();
+      }
+   }
+   if (!ret) {
+      buildRIG(insns);
+      calculateSpillWeights();
+      simplify();
 
-   ret = selectRegisters();
+      ret = selectRegisters();
+   }
    if (!ret) {
       INFO_DBG(prog->dbgFlags, REG_ALLOC,
                "selectRegisters failed, inserting spill code ...\n");
@@ -23,6 +23,8 @@
 #include "nv50_program.h"
 #include "nv50_context.h"
 
+#include "nouveau/nouveau_shader_cache.h"
+
 #include "codegen/nv50_ir_driver.h"
 
 static INLINE unsigned
@@ -299,10 +301,144 @@ nv50_program_create_strmout_state(const struct nv50_ir_prog_info *info,
    return so;
 }
 
+/* Fixed part of the shader cache key, followed by the TGSI tokens. */
+struct nv50_program_cache_key {
+   uint16_t chipset;
+   uint8_t type;
+   uint8_t opt_level;
+   uint8_t clpd_nr;
+   struct pipe_stream_output_info so;
+};
+
+/* Shader cache data, followed by the code, the relocations and the stream
+ * output state.
+ */
+struct nv50_program_cache_entry {
+   struct nv50_program prog; /* pointers are not valid */
+   uint32_t reloc_size;
+   uint32_t so_size;
+};
+
+static void *
+nv50_program_cache_key(const struct nv50_program *prog,
+                       const struct nv50_ir_prog_info *info, size_t *key_size)
+{
+   struct nv50_program_cache_key key;
+
+   memset(&key, 0, sizeof(key));
+   key.chipset = info->target;
+   key.type = prog->type;
+   key.opt_level = info->optLevel;
+   key.clpd_nr = prog->vp.clpd_nr;
+   key.so = prog->pipe.stream_output;
+
+   return nouveau_shader_cache_key(&key, sizeof(key), prog->pipe.tokens,
+                                   key_size);
+}
+
+static boolean
+nv50_program_cache_load(const void *key, size_t key_size,
+                        struct nv50_program *prog)
+{
+   const struct nv50_program orig = *prog;
+   struct nv50_program_cache_entry *entry;
+   const uint8_t *data;
+   size_t size;
+   void *buf;
+
+   if (!nouveau_shader_cache_get(key, key_size, &buf, &size))
+      return FALSE;
+
+   entry = buf;
+   data = (const uint8_t *)(entry + 1);
+   if (size < sizeof(*entry) ||
+       size != sizeof(*entry) + entry->prog.code_size +
+               entry->reloc_size + entry->so_size ||
+       (entry->so_size &&
+        entry->so_size != sizeof(struct nv50_stream_output_state)))
+      goto fail;
+
+   *prog = entry->prog;
+   prog->pipe = orig.pipe;
+   prog->translated = FALSE;
+   prog->code = NULL;
+   prog->immd = NULL;
+   prog->fixups = NULL;
+   prog->so = NULL;
+   prog->mem = NULL;
+
+   if (prog->code_size) {
+      prog->code = MALLOC(prog->code_size);
+      if (!prog->code)
+         goto fail_prog;
+      memcpy(prog->code, data, prog->code_size);
+      data += prog->code_size;
+   }
+   if (entry->reloc_size) {
+      prog->fixups = MALLOC(entry->reloc_size);
+      if (!prog->fixups)
+         goto fail_prog;
+      memcpy(prog->fixups, data, entry->reloc_size);
+      data += entry->reloc_size;
+   }
+   if (entry->so_size) {
+      prog->so = MALLOC(entry->so_size);
+      if (!prog->so)
+         goto fail_prog;
+      memcpy(prog->so, data, entry->so_size);
+   }
+
+   FREE(buf);
+   return TRUE;
+
+fail_prog:
+   FREE(prog->code);
+   FREE(prog->fixups);
+   *prog = orig;
+fail:
+   FREE(buf);
+   return FALSE;
+}
+
+static void
+nv50_program_cache_store(const void *key, size_t key_size,
+                         const struct nv50_program *prog)
+{
+   struct nv50_program_cache_entry *entry;
+   uint32_t reloc_size =
+      prog->fixups ? nv50_ir_get_reloc_size(prog->fixups) : 0;
+   uint32_t so_size = prog->so ? sizeof(*prog->so) : 0;
+   size_t size = sizeof(*entry) + prog->code_size + reloc_size + so_size;
+   uint8_t *data;
+
+   entry = CALLOC(1, size);
+   if (!entry)
+      return;
+
+   entry->prog = *prog;
+   entry->reloc_size = reloc_size;
+   entry->so_size = so_size;
+
+   data = (uint8_t *)(entry + 1);
+   if (prog->code_size)
+      memcpy(data, prog->code, prog->code_size);
+   data += prog->code_size;
+   if (reloc_size)
+      memcpy(data, prog->fixups, reloc_size);
+   data += reloc_size;
+   if (so_size)
+      memcpy(data, prog->so, so_size);
+
+   nouveau_shader_cache_put(key, key_size, entry, size);
+   FREE(entry);
+}
+
 boolean
 nv50_program_translate(struct nv50_program *prog, uint16_t chipset)
 {
    struct nv50_ir_prog_info *info;
+   size_t key_size = 0;
+   void *key;
    int ret;
    const uint8_t map_undef = (prog->type == PIPE_SHADER_VERTEX) ? 0x40 : 0x80;
 
@@ -338,6 +474,13 @@ nv50_program_translate(struct nv50_program *prog, uint16_t chipset)
    info->optLevel = 3;
 #endif
 
+   key = nv50_program_cache_key(prog, info, &key_size);
+   if (key && nv50_program_cache_load(key, key_size, prog)) {
+      FREE(key);
+      FREE(info);
+      return TRUE;
+   }
+
    ret = nv50_ir_generate_code(info);
    if (ret) {
       NOUVEAU_ERR("shader translation failed: %i\n", ret);
@@ -365,6 +508,11 @@ nv50_program_translate(struct nv50_program *prog, uint16_t chipset)
                                                    &prog->pipe.stream_output);
 
 out:
+   if (key) {
+      if (!ret)
+         nv50_program_cache_store(key, key_size, prog);
+      FREE(key);
+   }
    FREE(info);
    return !ret;
 }
@@ -351,7 +351,13 @@ nvc0_screen_get_video_param(struct pipe_screen *pscreen,
                             enum pipe_video_profile profile,
                             enum pipe_video_cap param);
 
-/* nvc0_push.c */
+/* nvc0_vbo_translate.c */
+
+/* Draws using at most this many words of translated vertex data are written
+ * directly into the push buffer as inline VERTEX_DATA.
+ */
+#define NVC0_PUSH_INLINE_MAX_WORDS 512
+
 void nvc0_push_vbo(struct nvc0_context *, const struct pipe_draw_info *);
 
 /* nve4_compute.c */
@@ -24,6 +24,7 @@
 
 #include "nvc0_context.h"
 
+#include "nouveau/nouveau_shader_cache.h"
 #include "nv50/codegen/nv50_ir_driver.h"
 #include "nve4_compute.h"
 
@@ -521,10 +522,160 @@ nvc0_program_dump(struct nvc0_program *prog)
 }
 #endif
 
+/* Fixed part of the shader cache key, followed by the TGSI tokens. */
+struct nvc0_program_cache_key {
+   uint16_t chipset;
+   uint8_t type;
+   uint8_t opt_level;
+   uint8_t num_ucps;
+   struct pipe_stream_output_info so;
+};
+
+/* Shader cache data, followed by the code, the immediates, the relocations
+ * and the transform feedback state.
+ */
+struct nvc0_program_cache_entry {
+   struct nvc0_program prog; /* pointers are not valid */
+   uint32_t reloc_size;
+   uint32_t tfb_size;
+};
+
+static void *
+nvc0_program_cache_key(const struct nvc0_program *prog,
+                       const struct nv50_ir_prog_info *info, size_t *key_size)
+{
+   struct nvc0_program_cache_key key;
+
+   /* compute programs also need their symbol table, don't bother */
+   if (prog->type == PIPE_SHADER_COMPUTE)
+      return NULL;
+
+   memset(&key, 0, sizeof(key));
+   key.chipset = info->target;
+   key.type = prog->type;
+   key.opt_level = info->optLevel;
+   key.num_ucps = prog->vp.num_ucps;
+   key.so = prog->pipe.stream_output;
+
+   return nouveau_shader_cache_key(&key, sizeof(key), prog->pipe.tokens,
+                                   key_size);
+}
+
+static boolean
+nvc0_program_cache_load(const void *key, size_t key_size,
+                        struct nvc0_program *prog)
+{
+   const struct nvc0_program orig = *prog;
+   struct nvc0_program_cache_entry *entry;
+   const uint8_t *data;
+   size_t size;
+   void *buf;
+
+   if (!nouveau_shader_cache_get(key, key_size, &buf, &size))
+      return FALSE;
+
+   entry = buf;
+   data = (const uint8_t *)(entry + 1);
+   if (size < sizeof(*entry) ||
+       size != sizeof(*entry) + entry->prog.code_size +
+               entry->prog.immd_size + entry->reloc_size + entry->tfb_size ||
+       (entry->tfb_size &&
+        entry->tfb_size != sizeof(struct nvc0_transform_feedback_state)))
+      goto fail;
+
+   *prog = entry->prog;
+   prog->pipe = orig.pipe;
+   prog->translated = FALSE;
+   prog->code = NULL;
+   prog->immd_data = NULL;
+   prog->relocs = NULL;
+   prog->tfb = NULL;
+   prog->mem = NULL;
+
+   if (prog->code_size) {
+      prog->code = MALLOC(prog->code_size);
+      if (!prog->code)
+         goto fail_prog;
+      memcpy(prog->code, data, prog->code_size);
+      data += prog->code_size;
+   }
+   if (prog->immd_size) {
+      prog->immd_data = MALLOC(prog->immd_size);
+      if (!prog->immd_data)
+         goto fail_prog;
+      memcpy(prog->immd_data, data, prog->immd_size);
+      data += prog->immd_size;
+   }
+   if (entry->reloc_size) {
+      prog->relocs = MALLOC(entry->reloc_size);
+      if (!prog->relocs)
+         goto fail_prog;
+      memcpy(prog->relocs, data, entry->reloc_size);
+      data += entry->reloc_size;
+   }
+   if (entry->tfb_size) {
+      prog->tfb = MALLOC(entry->tfb_size);
+      if (!prog->tfb)
+         goto fail_prog;
+      memcpy(prog->tfb, data, entry->tfb_size);
+   }
+
+   FREE(buf);
+   return TRUE;
+
+fail_prog:
+   FREE(prog->code);
+   FREE(prog->immd_data);
+   FREE(prog->relocs);
+   *prog = orig;
+fail:
+   FREE(buf);
+   return FALSE;
+}
+
+static void
+nvc0_program_cache_store(const void *key, size_t key_size,
+                         const struct nvc0_program *prog)
+{
+   struct nvc0_program_cache_entry *entry;
+   uint32_t reloc_size =
+      prog->relocs ? nv50_ir_get_reloc_size(prog->relocs) : 0;
+   uint32_t tfb_size = prog->tfb ? sizeof(*prog->tfb) : 0;
+   size_t size = sizeof(*entry) + prog->code_size + prog->immd_size +
+                 reloc_size + tfb_size;
+   uint8_t *data;
+
+   entry = CALLOC(1, size);
+   if (!entry)
+      return;
+
+   entry->prog = *prog;
+   entry->reloc_size = reloc_size;
+   entry->tfb_size = tfb_size;
+
+   data = (uint8_t *)(entry + 1);
+   if (prog->code_size)
+      memcpy(data, prog->code, prog->code_size);
+   data += prog->code_size;
+   if (prog->immd_size)
+      memcpy(data, prog->immd_data, prog->immd_size);
+   data += prog->immd_size;
+   if (reloc_size)
+      memcpy(data, prog->relocs, reloc_size);
+   data += reloc_size;
+   if (tfb_size)
+      memcpy(data, prog->tfb, tfb_size);
+
+   nouveau_shader_cache_put(key, key_size, entry, size);
+   FREE(entry);
+}
+
 boolean
 nvc0_program_translate(struct nvc0_program *prog, uint16_t chipset)
 {
    struct nv50_ir_prog_info *info;
+   size_t key_size = 0;
+   void *key;
    int ret;
 
    info = CALLOC_STRUCT(nv50_ir_prog_info);
@@ -568,6 +719,13 @@ nvc0_program_translate(struct nvc0_program *prog, uint16_t chipset)
    info->optLevel = 3;
 #endif
 
+   key = nvc0_program_cache_key(prog, info, &key_size);
+   if (key && nvc0_program_cache_load(key, key_size, prog)) {
+      FREE(key);
+      FREE(info);
+      return TRUE;
+   }
+
    ret = nv50_ir_generate_code(info);
    if (ret) {
       NOUVEAU_ERR("shader translation failed: %i\n", ret);
@@ -645,6 +803,11 @@ nvc0_program_translate(struct nvc0_program *prog, uint16_t chipset)
                                                 &prog->pipe.stream_output);
 
 out:
+   if (key) {
+      if (!ret)
+         nvc0_program_cache_store(key, key_size, prog);
+      FREE(key);
+   }
    FREE(info);
    return !ret;
 }
@@ -806,9 +806,13 @@ nvc0_draw_vbo(struct pipe_context *pipe, const struct pipe_draw_info *info)
 
    /* For picking only a few vertices from a large user buffer, push is better,
     * if index count is larger and we expect repeated vertices, suggest upload.
+    * Very small draws are cheapest to emit inline in the push buffer.
     */
    nvc0->vbo_push_hint =
       info->indexed && (nvc0->vb_elt_limit >= (info->count * 2));
+   if (!info->count_from_stream_output &&
+       info->count * nvc0->vertex->size <= NVC0_PUSH_INLINE_MAX_WORDS * 4)
+      nvc0->vbo_push_hint = TRUE;
 
    /* Check whether we want to switch vertex-submission mode. */
    if (nvc0->vbo_user && !(nvc0->dirty & (NVC0_NEW_ARRAYS | NVC0_NEW_VERTEX))) {
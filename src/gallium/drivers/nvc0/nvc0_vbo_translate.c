@@ -397,6 +397,51 @@ disp_vertices_seq(struct push_context *ctx, unsigned start, unsigned count)
    } while (count);
 }
 
+/* Translate the vertices straight into the push buffer, avoiding the scratch
+ * upload and the vertex array setup for small draws.
+ */
+static boolean
+nvc0_push_inline_possible(const struct push_context *ctx, unsigned count)
+{
+   if (ctx->edgeflag.enabled || ctx->need_vertex_id || ctx->prim_restart)
+      return FALSE;
+   return ctx->vertex_size &&
+      count * ctx->vertex_size <= NVC0_PUSH_INLINE_MAX_WORDS * 4;
+}
+
+static void
+disp_vertices_inline(struct push_context *ctx, unsigned index_size,
+                     unsigned start, unsigned count)
+{
+   struct nouveau_pushbuf *push = ctx->push;
+   struct translate *translate = ctx->translate;
+   const unsigned size = count * (ctx->vertex_size / 4);
+
+   if (!count)
+      return;
+
+   BEGIN_NIC0(push, NVC0_3D(VERTEX_DATA), size);
+   switch (index_size) {
+   case 1:
+      translate->run_elts8(translate, (const uint8_t *)ctx->idxbuf + start,
+                           count, ctx->instance_id, push->cur);
+      break;
+   case 2:
+      translate->run_elts16(translate, (const uint16_t *)ctx->idxbuf + start,
+                            count, ctx->instance_id, push->cur);
+      break;
+   case 4:
+      translate->run_elts(translate, (const uint32_t *)ctx->idxbuf + start,
+                          count, ctx->instance_id, push->cur);
+      break;
+   default:
+      assert(index_size == 0);
+      translate->run(translate, start, count, ctx->instance_id, push->cur);
+      break;
+   }
+   push->cur += size;
+}
+
 
 #define NVC0_PRIM_GL_CASE(n) \
    case PIPE_PRIM_##n: return NVC0_3D_VERTEX_BEGIN_GL_PRIMITIVE_##n
@@ -473,7 +518,33 @@ nvc0_push_vbo(struct nvc0_context *nvc0, const struct pipe_draw_info *info)
    ctx.instance_id = info->start_instance;
 
    prim = nvc0_prim_gl(info->mode);
-   do {
+
+   if (nvc0_push_inline_possible(&ctx, vert_count)) {
+      const unsigned size = vert_count * (ctx.vertex_size / 4);
+
+      /* vertex data comes from the push buffer, don't fetch array 0 */
+      PUSH_SPACE(ctx.push, 2);
+      IMMED_NVC0(ctx.push, NVC0_3D(VERTEX_ARRAY_FETCH(0)), 0);
+      while (inst_count) {
+         PUSH_SPACE(ctx.push, size + 4);
+         BEGIN_NVC0(ctx.push, NVC0_3D(VERTEX_BEGIN_GL), 1);
+         PUSH_DATA (ctx.push, prim);
+         disp_vertices_inline(&ctx, index_size, info->start, vert_count);
+         IMMED_NVC0(ctx.push, NVC0_3D(VERTEX_END_GL), 0);
+
+         if (--inst_count) {
+            prim |= NVC0_3D_VERTEX_BEGIN_GL_INSTANCE_NEXT;
+            ++ctx.instance_id;
+         }
+      }
+
+      PUSH_SPACE(ctx.push, 2);
+      BEGIN_NVC0(ctx.push, NVC0_3D(VERTEX_ARRAY_FETCH(0)), 1);
+      PUSH_DATA (ctx.push, NVC0_3D_VERTEX_ARRAY_FETCH_ENABLE | ctx.vertex_size);
+      inst_count = 0;
+   }
+
+   while (inst_count) {
       PUSH_SPACE(ctx.push, 9);
 
       ctx.dest = nvc0_push_setup_vertex_array(nvc0, vert_count);
@@ -510,7 +581,7 @@ nvc0_push_vbo(struct nvc0_context *nvc0, const struct pipe_draw_info *info)
       }
       nouveau_bufctx_reset(nvc0->bufctx_3d, NVC0_BIND_VTX_TMP);
       nouveau_scratch_done(&nvc0->base);
-   } while (inst_count);
+   }
 
 
    /* reset state and unmap buffers (no-op) */
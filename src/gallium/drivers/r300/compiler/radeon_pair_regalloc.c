@@ -441,6 +441,47 @@ error:
 	}
 }
 
+/**
+ * Compute a single interval that covers the live intervals of all the
+ * channels of a variable and its friends.
+ */
+static void get_variable_live_range(
+	struct rc_variable * var,
+	struct live_intervals * range)
+{
+	unsigned int chan;
+	range->Used = 0;
+	for ( ; var; var = var->Friend) {
+		for (chan = 0; chan < 4; chan++) {
+			struct live_intervals * live = &var->Live[chan];
+			if (!live->Used) {
+				continue;
+			}
+			if (!range->Used || live->Start < range->Start) {
+				range->Start = live->Start;
+			}
+			if (!range->Used || live->End > range->End) {
+				range->End = live->End;
+			}
+			range->Used = 1;
+		}
+	}
+}
+
+/**
+ * @return 0 if no channel of a can overlap a channel of b, which saves
+ * comparing all the channels of both variables and their friends.
+ */
+static unsigned int live_ranges_may_overlap(
+	struct live_intervals * a,
+	struct live_intervals * b)
+{
+	if (!a->Used || !b->Used) {
+		return 0;
+	}
+	return a->Start <= b->End && b->Start <= a->End;
+}
+
 static unsigned int overlap_live_intervals_array(
 	struct live_intervals * a,
 	struct live_intervals * b)
@@ -512,6 +553,7 @@ static void do_advanced_regalloc(struct regalloc_state * s)
 
 	unsigned int i, input_node, node_count, node_index;
 	unsigned int * node_classes;
+	struct live_intervals * node_ranges;
 	struct rc_instruction * inst;
 	struct rc_list * var_ptr;
 	struct rc_list * variables;
@@ -523,12 +565,15 @@ static void do_advanced_regalloc(struct regalloc_state * s)
 	node_count = rc_list_count(variables);
 	node_classes = memory_pool_malloc(&s->C->Pool,
 			node_count * sizeof(unsigned int));
+	node_ranges = memory_pool_malloc(&s->C->Pool,
+			node_count * sizeof(struct live_intervals));
 
 	for (var_ptr = variables, node_index = 0; var_ptr;
 					var_ptr = var_ptr->Next, node_index++) {
 		unsigned int class_index;
 		/* Compute the live intervals */
 		rc_variable_compute_live_intervals(var_ptr->Item);
+		get_variable_live_range(var_ptr->Item, &node_ranges[node_index]);
 
 		class_index = variable_get_class(var_ptr->Item,	rc_class_list);
 		node_classes[node_index] = ra_state->class_ids[class_index];
@@ -575,6 +620,10 @@ static void do_advanced_regalloc(struct regalloc_state * s)
 		for (a = var_ptr, b = var_ptr->Next, b_index = node_index + 1;
 						b; b = b->Next, b_index++) {
 			struct rc_variable * var_a = a->Item;
+			if (!live_ranges_may_overlap(&node_ranges[node_index],
+						&node_ranges[b_index])) {
+				continue;
+			}
 			while (var_a) {
 				struct rc_variable * var_b = b->Item;
 				while (var_b) {
@@ -297,8 +297,15 @@ static void get_variable_helper(
 {
 	struct rc_list * list_ptr;
 	for (list_ptr = *variable_list; list_ptr; list_ptr = list_ptr->Next) {
-		struct rc_variable * var;
-		for (var = list_ptr->Item; var; var = var->Friend) {
+		struct rc_variable * var = list_ptr->Item;
+		/* Variables that share a reader write the same register, and
+		 * all the friends of a variable have the same index, so
+		 * there is no need to compare the readers of other
+		 * registers. */
+		if (var->Dst.Index != variable->Dst.Index) {
+			continue;
+		}
+		for ( ; var; var = var->Friend) {
 			if (readers_intersect(var, variable)) {
 				rc_variable_add_friend(var, variable);
 				return;
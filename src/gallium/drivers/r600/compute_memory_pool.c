@@ -64,7 +64,6 @@ static void compute_memory_pool_init(struct compute_memory_pool * pool,
 	COMPUTE_DBG(pool->screen, "* compute_memory_pool_init() initial_size_in_dw = %ld\n",
 		initial_size_in_dw);
 
-	pool->shadow = (uint32_t*)CALLOC(initial_size_in_dw, 4);
 	pool->next_id = 1;
 	pool->size_in_dw = initial_size_in_dw;
 	pool->bo = (struct r600_resource*)r600_compute_buffer_alloc_vram(pool->screen,
@@ -77,7 +76,6 @@ static void compute_memory_pool_init(struct compute_memory_pool * pool,
 void compute_memory_pool_delete(struct compute_memory_pool* pool)
 {
 	COMPUTE_DBG(pool->screen, "* compute_memory_pool_delete()\n");
-	free(pool->shadow);
 	if (pool->bo) {
 		pool->screen->screen.resource_destroy((struct pipe_screen *)
 			pool->screen, (struct pipe_resource *)pool->bo);
@@ -157,6 +155,11 @@ struct compute_memory_item* compute_memory_postalloc_chunk(
 
 /**
  * Reallocates pool, conserves data
+ *
+ * The old contents are copied into the new buffer on the GPU, so growing
+ * doesn't wait for pending kernels or go through host memory.  Items keep
+ * their offsets.  The pool at least doubles, so that a burst of
+ * allocations only grows it a few times.
  */
 void compute_memory_grow_pool(struct compute_memory_pool* pool,
 	struct pipe_context * pipe, int new_size_in_dw)
@@ -169,42 +172,30 @@ void compute_memory_grow_pool(struct compute_memory_pool* pool,
 	if (!pool->bo) {
 		compute_memory_pool_init(pool, MAX2(new_size_in_dw, 1024 * 16));
 	} else {
+		struct r600_resource *old_bo = pool->bo;
+		struct pipe_box box;
+
+		new_size_in_dw = MAX2(new_size_in_dw, pool->size_in_dw * 2);
 		new_size_in_dw += 1024 - (new_size_in_dw % 1024);
 
 		COMPUTE_DBG(pool->screen, "  Aligned size = %d\n", new_size_in_dw);
 
-		compute_memory_shadow(pool, pipe, 1);
-		pool->shadow = realloc(pool->shadow, new_size_in_dw*4);
+		pool->bo = (struct r600_resource*)r600_compute_buffer_alloc_vram(
+							pool->screen,
+							new_size_in_dw * 4);
+		u_box_1d(0, pool->size_in_dw * 4, &box);
+		pipe->resource_copy_region(pipe,
+			(struct pipe_resource *)pool->bo, 0, 0, 0, 0,
+			(struct pipe_resource *)old_bo, 0, &box);
 		pool->size_in_dw = new_size_in_dw;
+
+		/* The CS doing the copy holds its own reference. */
 		pool->screen->screen.resource_destroy(
 			(struct pipe_screen *)pool->screen,
-			(struct pipe_resource *)pool->bo);
-		pool->bo = (struct r600_resource*)r600_compute_buffer_alloc_vram(
-							pool->screen,
-							pool->size_in_dw * 4);
-		compute_memory_shadow(pool, pipe, 0);
+			(struct pipe_resource *)old_bo);
 	}
 }
 
-/**
- * Copy pool from device to host, or host to device.
- */
-void compute_memory_shadow(struct compute_memory_pool* pool,
-	struct pipe_context * pipe, int device_to_host)
-{
-	struct compute_memory_item chunk;
-
-	COMPUTE_DBG(pool->screen, "* compute_memory_shadow() device_to_host = %d\n",
-		device_to_host);
-
-	chunk.id = 0;
-	chunk.start_in_dw = 0;
-	chunk.size_in_dw = pool->size_in_dw;
-	chunk.prev = chunk.next = NULL;
-	compute_memory_transfer(pool, pipe, device_to_host, &chunk,
-				pool->shadow, 0, pool->size_in_dw*4);
-}
-
 /**
  * Allocates pending allocations in the pool
  */
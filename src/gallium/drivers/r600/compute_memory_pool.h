@@ -33,7 +33,7 @@ struct compute_memory_item
 {
 	int64_t id; ///ID of the memory chunk
 
-	int untouched; ///True if the memory contains only junk, no need to save it for defrag
+	int untouched; ///True if the memory contains only junk
 
 	int64_t start_in_dw; ///Start pointer in dwords relative in the pool bo
 	int64_t size_in_dw; ///Size of the chunk in dwords
@@ -52,8 +52,6 @@ struct compute_memory_pool
 	struct r600_resource *bo; ///The pool buffer object resource
 	struct compute_memory_item* item_list; ///Allocated memory chunks in the buffer,they must be ordered by "start_in_dw"
 	struct r600_screen *screen;
-
-	uint32_t *shadow; ///host copy of the pool, used for defragmentation
 };
 
 
@@ -65,23 +63,16 @@ int64_t compute_memory_prealloc_chunk(struct compute_memory_pool* pool, int64_t
 struct compute_memory_item* compute_memory_postalloc_chunk(struct compute_memory_pool* pool, int64_t start_in_dw); ///search for the chunk where we can link our new chunk after it
 
 /** 
- * reallocates pool, conserves data
+ * reallocates pool, conserves data, items never move
  */
 void compute_memory_grow_pool(struct compute_memory_pool* pool, struct pipe_context * pipe,
 	int new_size_in_dw);
 
-/**
- * Copy pool from device to host, or host to device
- */
-void compute_memory_shadow(struct compute_memory_pool* pool,
-	struct pipe_context * pipe, int device_to_host);
-
 /**
  * Allocates pending allocations in the pool
  */
 void compute_memory_finalize_pending(struct compute_memory_pool* pool,
 	struct pipe_context * pipe);
-void compute_memory_defrag(struct compute_memory_pool* pool); ///Defragment the memory pool, always heavy memory usage
 void compute_memory_free(struct compute_memory_pool* pool, int64_t id);
 struct compute_memory_item* compute_memory_alloc(struct compute_memory_pool* pool, int64_t size_in_dw); ///Creates pending allocations
 
@@ -201,6 +201,11 @@ static void r600_flush_from_st(struct pipe_context *ctx,
 		rctx->rings.dma.flush(rctx, fflags);
 	}
 	rctx->rings.gfx.flush(rctx, fflags);
+
+	/* Let the upload ring know when it can reuse what was just flushed. */
+	if (rfence && rctx->uploader) {
+		u_upload_fence(rctx->uploader, *fence);
+	}
 }
 
 static void r600_flush_gfx_ring(void *ctx, unsigned flags)
@@ -460,9 +465,9 @@ static struct pipe_context *r600_create_context(struct pipe_screen *screen, void
 		rctx->rings.dma.flushing = false;
 	}
 
-	rctx->uploader = u_upload_create(&rctx->context, 1024 * 1024, 256,
-					PIPE_BIND_INDEX_BUFFER |
-					PIPE_BIND_CONSTANT_BUFFER);
+	rctx->uploader = u_upload_create_ring(&rctx->context, 4 * 1024 * 1024, 256,
+					     PIPE_BIND_INDEX_BUFFER |
+					     PIPE_BIND_CONSTANT_BUFFER);
 	if (!rctx->uploader)
 		goto fail;
 
@@ -974,6 +979,8 @@ static void r600_destroy_screen(struct pipe_screen* pscreen)
 		compute_memory_pool_delete(rscreen->global_pool);
 	}
 
+	r600_shader_cache_destroy(rscreen->shader_cache);
+
 	if (rscreen->fences.bo) {
 		struct r600_fence_block *entry, *tmp;
 
@@ -1193,7 +1200,9 @@ static int r600_get_driver_query_info(struct pipe_screen *screen,
 		{"draw-calls", R600_QUERY_DRAW_CALLS, 0},
 		{"requested-VRAM", R600_QUERY_REQUESTED_VRAM, rscreen->info.vram_size, TRUE},
 		{"requested-GTT", R600_QUERY_REQUESTED_GTT, rscreen->info.gart_size, TRUE},
-		{"buffer-wait-time", R600_QUERY_BUFFER_WAIT_TIME, 0, FALSE}
+		{"buffer-wait-time", R600_QUERY_BUFFER_WAIT_TIME, 0, FALSE},
+		{"cs-thread-busy", R600_QUERY_CS_THREAD_BUSY, 0, FALSE},
+		{"cs-sync-wait-time", R600_QUERY_CS_SYNC_WAIT_TIME, 0, FALSE}
 	};
 
 	if (!info)
@@ -1328,6 +1337,7 @@ struct pipe_screen *r600_screen_create(struct radeon_winsys *ws)
 	pipe_mutex_init(rscreen->fences.mutex);
 
 	rscreen->global_pool = compute_memory_pool_new(rscreen);
+	rscreen->shader_cache = r600_shader_cache_create(rscreen);
 
 	rscreen->cs_count = 0;
 	if (rscreen->info.drm_minor >= 28 && (rscreen->debug_flags & DBG_TRACE_CS)) {
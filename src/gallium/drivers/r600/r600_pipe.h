@@ -77,6 +77,8 @@
 #define R600_QUERY_REQUESTED_VRAM	(PIPE_QUERY_DRIVER_SPECIFIC + 1)
 #define R600_QUERY_REQUESTED_GTT	(PIPE_QUERY_DRIVER_SPECIFIC + 2)
 #define R600_QUERY_BUFFER_WAIT_TIME	(PIPE_QUERY_DRIVER_SPECIFIC + 3)
+#define R600_QUERY_CS_THREAD_BUSY	(PIPE_QUERY_DRIVER_SPECIFIC + 4)
+#define R600_QUERY_CS_SYNC_WAIT_TIME	(PIPE_QUERY_DRIVER_SPECIFIC + 5)
 
 struct r600_context;
 struct r600_bytecode;
@@ -275,6 +277,8 @@ struct r600_screen {
 	 * XXX: Not sure if this is the best place for global_pool.  Also,
 	 * it's not thread safe, so it won't work with multiple contexts. */
 	struct compute_memory_pool *global_pool;
+	/* on-disk bytecode cache, NULL if disabled */
+	struct r600_shader_cache	*shader_cache;
 	struct r600_resource		*trace_bo;
 	uint32_t			*trace_ptr;
 	unsigned			cs_count;
@@ -669,6 +673,17 @@ static INLINE void r600_set_cso_state_with_cb(struct r600_cso_state *state, void
 	r600_set_cso_state(state, cso);
 }
 
+/* r600_shader_cache.c */
+struct r600_shader_cache;
+struct r600_shader_cache *r600_shader_cache_create(struct r600_screen *rscreen);
+void r600_shader_cache_destroy(struct r600_shader_cache *cache);
+boolean r600_shader_cache_load(struct r600_screen *rscreen,
+			       struct r600_pipe_shader *shader,
+			       struct r600_shader_key key);
+void r600_shader_cache_store(struct r600_screen *rscreen,
+			     struct r600_pipe_shader *shader,
+			     struct r600_shader_key key);
+
 /* compute_memory_pool.c */
 struct compute_memory_pool;
 void compute_memory_pool_delete(struct compute_memory_pool* pool);
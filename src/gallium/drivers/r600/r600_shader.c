@@ -145,6 +145,11 @@ int r600_pipe_shader_create(struct pipe_context *ctx,
 
 	shader->shader.bc.isa = rctx->isa;
 
+	/* Shaders built by an earlier run are loaded as is.  Dumps come from
+	 * the compile, so dumped shaders are always built. */
+	if (!dump && r600_shader_cache_load(rctx->screen, shader, key))
+		goto upload;
+
 	if (dump) {
 		fprintf(stderr, "--------------------------------------------------------------\n");
 		tgsi_dump(sel->tokens, 0);
@@ -177,13 +182,19 @@ int r600_pipe_shader_create(struct pipe_context *ctx,
 		fprintf(stderr, "______________________________________________________________\n");
 	} else if ((dump && sb_disasm) || use_sb) {
 		r = r600_sb_bytecode_process(rctx, &shader->shader.bc, &shader->shader,
-		                             dump, use_sb);
+		                             dump, use_sb, !shader->sb_no_budget);
 		if (r) {
 			R600_ERR("r600_sb_bytecode_process failed !\n");
 			return r;
 		}
 	}
 
+	/* Don't keep shaders sb only partially optimized, they would never be
+	 * built with the full pipeline again. */
+	if (!dump && !shader->shader.sb_partial)
+		r600_shader_cache_store(rctx->screen, shader, key);
+
+upload:
 	/* Store the shader in a buffer. */
 	if (shader->bo == NULL) {
 		shader->bo = (struct r600_resource*)
@@ -314,7 +325,7 @@ int r600_compute_shader_create(struct pipe_context * ctx,
 	if (dump && !sb_disasm) {
 		r600_bytecode_disasm(shader_ctx.bc);
 	} else if ((dump && sb_disasm) || use_sb) {
-		if (r600_sb_bytecode_process(r600_ctx, shader_ctx.bc, NULL, dump, use_sb))
+		if (r600_sb_bytecode_process(r600_ctx, shader_ctx.bc, NULL, dump, use_sb, 0))
 			R600_ERR("r600_sb_bytecode_process failed!\n");
 	}
 
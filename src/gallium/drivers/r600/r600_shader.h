@@ -63,6 +63,8 @@ struct r600_shader {
 	boolean			vs_out_point_size;
 	boolean			has_txq_cube_array_z_comp;
 	boolean			uses_tex_buffers;
+	/* sb skipped some optimizations to stay within its compile time budget */
+	boolean			sb_partial;
 
 	unsigned		indirect_files;
 	unsigned		max_arrays;
@@ -95,6 +97,10 @@ struct r600_pipe_shader {
 	struct r600_shader_key	key;
 	unsigned		db_shader_control;
 	unsigned		ps_depth_export;
+	/* build with the full sb pipeline, ignoring the time budget */
+	boolean			sb_no_budget;
+	/* draws with this variant while it's only partially optimized */
+	unsigned		hot_draws;
 };
 
 #endif
@@ -0,0 +1,326 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * on the rights to use, copy, modify, merge, publish, distribute, sub
+ * license, and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHOR(S) AND/OR THEIR SUPPLIERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* On-disk cache of the final bytecode of graphics shader variants, so that
+ * a shader seen by an earlier run doesn't go through the TGSI translation
+ * and sb again.
+ *
+ * Each entry is a file named after a hash of everything the compile depends
+ * on: the driver binary, the chip, the debug flags, the shader key, the
+ * stream output info and the TGSI tokens.  That whole identity is stored in
+ * the file too and compared on load, so a hash collision only costs a
+ * compile.  Next to it are the r600_shader info and the bytecode.
+ */
+
+#include "r600_pipe.h"
+#include "r600_shader.h"
+
+#include "tgsi/tgsi_parse.h"
+#include "util/u_hash.h"
+#include "util/u_memory.h"
+
+#include <dlfcn.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#define R600_SHADER_CACHE_MAGIC		0x43363052 /* "R06C" */
+#define R600_SHADER_CACHE_VERSION	1
+
+/* Largest bytecode we expect to read back, to reject corrupt files. */
+#define R600_SHADER_CACHE_MAX_NDW	(1024 * 1024)
+
+struct r600_shader_cache {
+	char		path[PATH_MAX];
+
+	/* Modification time and size of the driver binary. */
+	uint64_t	driver_mtime;
+	uint64_t	driver_size;
+};
+
+/* Fixed part of the identity, followed by the TGSI tokens. */
+struct r600_shader_cache_ident {
+	uint64_t			driver_mtime;
+	uint64_t			driver_size;
+	uint32_t			version;
+	uint32_t			family;
+	uint32_t			chip_class;
+	uint32_t			has_compressed_msaa_texturing;
+	uint32_t			debug_flags;
+	uint32_t			shader_size;
+	struct r600_shader_key		key;
+	struct pipe_stream_output_info	so;
+	uint32_t			num_tokens;
+};
+
+struct r600_shader_cache_header {
+	uint32_t	magic;
+	uint32_t	ident_size;
+	uint32_t	ndw;
+};
+
+static void make_dir(char *path)
+{
+	char *p;
+
+	/* Create the missing parents first, like mkdir -p. */
+	for (p = strchr(path + 1, '/'); p; p = strchr(p + 1, '/')) {
+		*p = '\0';
+		mkdir(path, 0755);
+		*p = '/';
+	}
+	mkdir(path, 0755);
+}
+
+/* Returns the cache for a new screen, or NULL if it can't be used. */
+struct r600_shader_cache *r600_shader_cache_create(struct r600_screen *rscreen)
+{
+	struct r600_shader_cache *cache;
+	struct stat st;
+	Dl_info info;
+	const char *dir;
+	int n = -1;
+
+	/* Shader dumps come from the compile itself, and the sb range
+	 * debugging options depend on the order shaders are compiled in. */
+	if ((rscreen->debug_flags & (DBG_FS | DBG_VS | DBG_PS | DBG_CS |
+				     DBG_SB_DUMP | DBG_SB_STAT | DBG_SB_DRY_RUN)) ||
+	    debug_get_num_option("R600_SB_DSKIP_MODE", 0))
+		return NULL;
+
+	/* Bytecode is only valid for the driver build that generated it, and
+	 * we use the driver's own file to tell builds apart. */
+	if (!dladdr((void *)r600_shader_cache_create, &info) ||
+	    info.dli_fname == NULL ||
+	    stat(info.dli_fname, &st) != 0)
+		return NULL;
+
+	cache = CALLOC_STRUCT(r600_shader_cache);
+	if (!cache)
+		return NULL;
+
+	cache->driver_mtime = st.st_mtime;
+	cache->driver_size = st.st_size;
+
+	if ((dir = getenv("R600_SHADER_CACHE_DIR")) != NULL)
+		n = snprintf(cache->path, sizeof(cache->path), "%s", dir);
+	else if ((dir = getenv("XDG_CACHE_HOME")) != NULL)
+		n = snprintf(cache->path, sizeof(cache->path), "%s/mesa/r600", dir);
+	else if ((dir = getenv("HOME")) != NULL)
+		n = snprintf(cache->path, sizeof(cache->path), "%s/.cache/mesa/r600", dir);
+
+	/* Leave room for the entry names. */
+	if (n <= 0 || n >= (int)sizeof(cache->path) - 32) {
+		FREE(cache);
+		return NULL;
+	}
+
+	make_dir(cache->path);
+	if (stat(cache->path, &st) != 0 || !S_ISDIR(st.st_mode) ||
+	    access(cache->path, W_OK) != 0) {
+		FREE(cache);
+		return NULL;
+	}
+
+	return cache;
+}
+
+void r600_shader_cache_destroy(struct r600_shader_cache *cache)
+{
+	FREE(cache);
+}
+
+/* Returns the identity of the compile of \p shader with \p key, to be freed
+ * by the caller. */
+static char *make_ident(struct r600_screen *rscreen,
+			struct r600_pipe_shader *shader,
+			struct r600_shader_key key, unsigned *ident_size)
+{
+	struct r600_shader_cache *cache = rscreen->shader_cache;
+	struct r600_pipe_shader_selector *sel = shader->selector;
+	struct r600_shader_cache_ident *id;
+	unsigned num_tokens = tgsi_num_tokens(sel->tokens);
+	unsigned tokens_size = num_tokens * sizeof(struct tgsi_token);
+	char *ident;
+
+	*ident_size = sizeof(*id) + tokens_size;
+	ident = CALLOC(1, *ident_size);
+	if (!ident)
+		return NULL;
+
+	id = (struct r600_shader_cache_ident *)ident;
+	id->driver_mtime = cache->driver_mtime;
+	id->driver_size = cache->driver_size;
+	id->version = R600_SHADER_CACHE_VERSION;
+	id->family = rscreen->family;
+	id->chip_class = rscreen->chip_class;
+	id->has_compressed_msaa_texturing = rscreen->has_compressed_msaa_texturing;
+	id->debug_flags = rscreen->debug_flags;
+	id->shader_size = sizeof(struct r600_shader);
+	id->key = key;
+	id->so = sel->so;
+	id->num_tokens = num_tokens;
+	memcpy(ident + sizeof(*id), sel->tokens, tokens_size);
+	return ident;
+}
+
+static void make_entry_path(struct r600_shader_cache *cache, char *path,
+			    const char *ident, unsigned ident_size)
+{
+	snprintf(path, PATH_MAX, "%s/%08x", cache->path,
+		 util_hash_crc32(ident, ident_size));
+}
+
+/* Fills in \p shader from the cache.  Returns false if there is no usable
+ * entry, in which case the shader has to be compiled. */
+boolean r600_shader_cache_load(struct r600_screen *rscreen,
+			       struct r600_pipe_shader *shader,
+			       struct r600_shader_key key)
+{
+	struct r600_shader_cache *cache = rscreen->shader_cache;
+	struct r600_shader_cache_header header;
+	struct r600_shader stored;
+	struct r600_bytecode *bc = &shader->shader.bc;
+	char path[PATH_MAX];
+	char *ident, *stored_ident = NULL;
+	uint32_t *bytecode = NULL;
+	unsigned ident_size;
+	boolean ok = FALSE;
+	FILE *file;
+
+	if (!cache)
+		return FALSE;
+
+	ident = make_ident(rscreen, shader, key, &ident_size);
+	if (!ident)
+		return FALSE;
+
+	make_entry_path(cache, path, ident, ident_size);
+	file = fopen(path, "rb");
+	if (!file) {
+		FREE(ident);
+		return FALSE;
+	}
+
+	if (fread(&header, sizeof(header), 1, file) != 1 ||
+	    header.magic != R600_SHADER_CACHE_MAGIC ||
+	    header.ident_size != ident_size ||
+	    header.ndw == 0 || header.ndw > R600_SHADER_CACHE_MAX_NDW)
+		goto out;
+
+	stored_ident = MALLOC(ident_size);
+	/* Freed with free() by r600_bytecode_clear. */
+	bytecode = malloc(header.ndw * 4);
+	if (!stored_ident || !bytecode ||
+	    fread(stored_ident, ident_size, 1, file) != 1 ||
+	    memcmp(stored_ident, ident, ident_size) != 0 ||
+	    fread(&stored, sizeof(stored), 1, file) != 1 ||
+	    fread(bytecode, 4, header.ndw, file) != header.ndw)
+		goto out;
+
+	/* The stored bytecode struct only provides the values the state
+	 * setup needs; everything else is set up like for a new one. */
+	stored.bc.isa = bc->isa;
+	r600_bytecode_init(&stored.bc, rscreen->chip_class, rscreen->family,
+			   rscreen->has_compressed_msaa_texturing);
+	stored.bc.type = stored.processor_type;
+	stored.bc.ndw = header.ndw;
+	stored.bc.bytecode = bytecode;
+	stored.bc.cf_last = NULL;
+	stored.arrays = NULL;
+	stored.num_arrays = 0;
+	stored.max_arrays = 0;
+
+	shader->shader = stored;
+	bytecode = NULL;
+	ok = TRUE;
+
+out:
+	fclose(file);
+	free(bytecode);
+	FREE(stored_ident);
+	FREE(ident);
+	return ok;
+}
+
+/* Stores the compiled \p shader.  Failures are silently ignored, the cache
+ * is only an optimization. */
+void r600_shader_cache_store(struct r600_screen *rscreen,
+			     struct r600_pipe_shader *shader,
+			     struct r600_shader_key key)
+{
+	struct r600_shader_cache *cache = rscreen->shader_cache;
+	struct r600_shader_cache_header header;
+	struct r600_shader stored;
+	char path[PATH_MAX], tmp_path[PATH_MAX];
+	char *ident;
+	unsigned ident_size;
+	boolean ok;
+	FILE *file;
+
+	if (!cache || !shader->shader.bc.bytecode)
+		return;
+
+	ident = make_ident(rscreen, shader, key, &ident_size);
+	if (!ident)
+		return;
+
+	/* Pointers are meaningless in another process, don't store them. */
+	stored = shader->shader;
+	memset(&stored.bc, 0, sizeof(stored.bc));
+	stored.bc.ngpr = shader->shader.bc.ngpr;
+	stored.bc.nstack = shader->shader.bc.nstack;
+	stored.bc.nresource = shader->shader.bc.nresource;
+	stored.arrays = NULL;
+	stored.num_arrays = 0;
+	stored.max_arrays = 0;
+
+	header.magic = R600_SHADER_CACHE_MAGIC;
+	header.ident_size = ident_size;
+	header.ndw = shader->shader.bc.ndw;
+
+	/* Write to a file of our own and rename it into place, so that other
+	 * processes never see a partial entry. */
+	make_entry_path(cache, path, ident, ident_size);
+	snprintf(tmp_path, sizeof(tmp_path), "%s.%d", path, (int)getpid());
+	file = fopen(tmp_path, "wb");
+	if (!file) {
+		FREE(ident);
+		return;
+	}
+
+	ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+	     fwrite(ident, ident_size, 1, file) == 1 &&
+	     fwrite(&stored, sizeof(stored), 1, file) == 1 &&
+	     fwrite(shader->shader.bc.bytecode, 4, header.ndw, file) == header.ndw;
+
+	if (fclose(file) != 0)
+		ok = FALSE;
+
+	if (!ok || rename(tmp_path, path) != 0)
+		unlink(tmp_path);
+
+	FREE(ident);
+}
@@ -783,6 +783,41 @@ static int r600_shader_select(struct pipe_context *ctx,
 	return 0;
 }
 
+DEBUG_GET_ONCE_NUM_OPTION(sb_hot_draws, "R600_SB_HOT_DRAWS", 256)
+
+/* Rebuild the current variant without the sb time budget once it has been
+ * used for enough draws, if the budget made sb skip some optimizations.
+ * Returns true if the variant was replaced. */
+static bool r600_shader_rebuild_hot(struct pipe_context *ctx,
+		struct r600_pipe_shader_selector *sel)
+{
+	struct r600_pipe_shader *old = sel->current, *shader;
+
+	if (likely(!old->shader.sb_partial ||
+		   ++old->hot_draws < debug_get_option_sb_hot_draws()))
+		return false;
+
+	shader = CALLOC(1, sizeof(struct r600_pipe_shader));
+	shader->selector = sel;
+	shader->sb_no_budget = TRUE;
+
+	if (unlikely(r600_pipe_shader_create(ctx, shader, old->key))) {
+		/* Keep using the variant we have and don't try again. */
+		old->shader.sb_partial = FALSE;
+		r600_pipe_shader_destroy(ctx, shader);
+		FREE(shader);
+		return false;
+	}
+
+	memcpy(&shader->key, &old->key, sizeof(shader->key));
+	shader->next_variant = old->next_variant;
+	sel->current = shader;
+
+	r600_pipe_shader_destroy(ctx, old);
+	FREE(old);
+	return true;
+}
+
 static void *r600_create_shader_state(struct pipe_context *ctx,
 			       const struct pipe_shader_state *state,
 			       unsigned pipe_shader_type)
@@ -1223,6 +1258,15 @@ static bool r600_update_derived_state(struct r600_context *rctx)
 
 	r600_shader_select(ctx, rctx->ps_shader, &ps_dirty);
 
+	if (r600_shader_rebuild_hot(ctx, rctx->ps_shader)) {
+		r600_context_add_resource_size(ctx, (struct pipe_resource *)rctx->ps_shader->current->bo);
+		ps_dirty = true;
+	}
+	if (rctx->vs_shader && r600_shader_rebuild_hot(ctx, rctx->vs_shader)) {
+		r600_context_add_resource_size(ctx, (struct pipe_resource *)rctx->vs_shader->current->bo);
+		rctx->vertex_shader.atom.dirty = true;
+	}
+
 	if (rctx->ps_shader && rctx->rasterizer &&
 	    ((rctx->rasterizer->sprite_coord_enable != rctx->ps_shader->current->sprite_coord_enable) ||
 	     (rctx->rasterizer->flatshade != rctx->ps_shader->current->flatshade))) {
@@ -626,6 +626,9 @@ public:
 	static unsigned dskip_end;
 	static unsigned dskip_mode;
 
+	/* compile time budget per shader in microseconds, 0 - unlimited */
+	static unsigned time_budget;
+
 	sb_context() : src_stats(), opt_stats(), isa(0),
 			hw_chip(HW_CHIP_UNKNOWN), hw_class(HW_CLASS_UNKNOWN) {}
 
@@ -68,6 +68,8 @@ sb_context *r600_sb_context_create(struct r600_context *rctx) {
 	sb_context::dskip_end = debug_get_num_option("R600_SB_DSKIP_END", 0);
 	sb_context::dskip_mode = debug_get_num_option("R600_SB_DSKIP_MODE", 0);
 
+	sb_context::time_budget = debug_get_num_option("R600_SB_TIME_BUDGET", 0);
+
 	return sctx;
 }
 
@@ -92,7 +94,8 @@ int r600_sb_bytecode_process(struct r600_context *rctx,
                              struct r600_bytecode *bc,
                              struct r600_shader *pshader,
                              int dump_bytecode,
-                             int optimize) {
+                             int optimize,
+                             int use_budget) {
 	int r = 0;
 	unsigned shader_id = bc->debug_id;
 
@@ -101,8 +104,10 @@ int r600_sb_bytecode_process(struct r600_context *rctx,
 		rctx->sb_context = ctx = r600_sb_context_create(rctx);
 	}
 
+	use_budget = use_budget && sb_context::time_budget;
+
 	int64_t time_start = 0;
-	if (sb_context::dump_stat) {
+	if (sb_context::dump_stat || use_budget) {
 		time_start = os_time_get_nano();
 	}
 
@@ -160,6 +165,9 @@ int r600_sb_bytecode_process(struct r600_context *rctx,
 
 #define SB_RUN_PASS(n, dump) \
 	do { \
+		int64_t pass_start = 0; \
+		if (sb_context::dump_stat) \
+			pass_start = os_time_get_nano(); \
 		r = n(*sh).run(); \
 		if (r) { \
 			sblog << "sb: error (" << r << ") in the " << #n << " pass.\n"; \
@@ -169,6 +177,8 @@ int r600_sb_bytecode_process(struct r600_context *rctx,
 			delete sh; \
 			return 0; \
 		} \
+		SB_DUMP_STAT( sblog << "sb:   " << #n << " ( " \
+			<< (os_time_get_nano() - pass_start) / 1000000.0 << " ms )\n"; ); \
 		if (dump) { \
 			SB_DUMP_PASS( sblog << "\n\n###### after " << #n << "\n"; \
 				sh->dump_ir();); \
@@ -176,6 +186,15 @@ int r600_sb_bytecode_process(struct r600_context *rctx,
 		assert(!r); \
 	} while (0)
 
+	/* With a time budget, optional passes are skipped once it's used up,
+	 * and the shader is reported as partially optimized so that the
+	 * driver can rebuild it without the budget if it turns out to be hot. */
+#define SB_OVER_BUDGET() \
+	(use_budget && (os_time_get_nano() - time_start) / 1000 > \
+			sb_context::time_budget)
+
+	bool partial = false;
+
 	SB_RUN_PASS(ssa_prepare,		0);
 	SB_RUN_PASS(ssa_rename,			1);
 
@@ -188,21 +207,41 @@ int r600_sb_bytecode_process(struct r600_context *rctx,
 
 	sh->set_undef(sh->root->live_before);
 
-	SB_RUN_PASS(if_conversion,		1);
-
-	// if_conversion breaks info about uses, but next pass (peephole)
-	// doesn't need it, so we can skip def/use update here
-	// until it's really required
-	//SB_RUN_PASS(def_use,			0);
-
-	SB_RUN_PASS(peephole,			1);
-	SB_RUN_PASS(def_use,			0);
-
-	SB_RUN_PASS(gvn,				1);
-
-	SB_RUN_PASS(liveness,			0);
-	SB_RUN_PASS(dce_cleanup,		1);
-	SB_RUN_PASS(def_use,			0);
+	if (!SB_OVER_BUDGET()) {
+		SB_RUN_PASS(if_conversion,		1);
+
+		// if_conversion breaks info about uses, but next pass (peephole)
+		// doesn't need it, so we can skip def/use update here
+		// until it's really required
+		//SB_RUN_PASS(def_use,			0);
+
+		SB_RUN_PASS(peephole,			1);
+		SB_RUN_PASS(def_use,			0);
+	} else
+		partial = true;
+
+	if (!SB_OVER_BUDGET()) {
+		SB_RUN_PASS(gvn,				1);
+
+		SB_RUN_PASS(liveness,			0);
+		SB_RUN_PASS(dce_cleanup,		1);
+		SB_RUN_PASS(def_use,			0);
+	} else
+		partial = true;
+
+	if (pshader)
+		pshader->sb_partial = partial;
+
+	// the passes below are required to produce the optimized bytecode,
+	// if we're already out of time the source bytecode is used instead
+	if (SB_OVER_BUDGET()) {
+		SB_DUMP_STAT( sblog << "sb: shader " << shader_id
+				<< " is over the time budget, using unoptimized bytecode\n"; );
+		if (pshader)
+			pshader->sb_partial = true;
+		delete sh;
+		return 0;
+	}
 
 	SB_RUN_PASS(ra_split,			0);
 	SB_RUN_PASS(def_use,			0);
@@ -35,6 +35,7 @@ int r600_sb_bytecode_process(struct r600_context *rctx,
                              struct r600_bytecode *bc,
                              struct r600_shader *pshader,
                              int dump_source_bytecode,
-                             int optimize);
+                             int optimize,
+                             int use_budget);
 
 #endif //R600_SB_H_
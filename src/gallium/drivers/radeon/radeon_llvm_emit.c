@@ -24,6 +24,7 @@
  *
  */
 #include "radeon_llvm_emit.h"
+#include "os/os_thread.h"
 #include "util/u_memory.h"
 
 #include <llvm-c/Target.h>
@@ -52,8 +53,13 @@ void radeon_llvm_shader_type(LLVMValueRef F, unsigned type)
   LLVMAddTargetDependentFunctionAttr(F, "ShaderType", Str);
 }
 
+/* Drivers may compile shaders on several threads at once. */
+pipe_static_mutex(init_r600_target_mutex);
+
 static void init_r600_target() {
 	static unsigned initialized = 0;
+
+	pipe_mutex_lock(init_r600_target_mutex);
 	if (!initialized) {
 		LLVMInitializeR600TargetInfo();
 		LLVMInitializeR600Target();
@@ -61,6 +67,7 @@ static void init_r600_target() {
 		LLVMInitializeR600AsmPrinter();
 		initialized = 1;
 	}
+	pipe_mutex_unlock(init_r600_target_mutex);
 }
 
 static LLVMTargetRef get_r600_target() {
@@ -49,7 +49,11 @@ struct r600_query {
 		uint64_t			u64;
 		boolean				b;
 		struct pipe_query_data_so_statistics so;
+		struct pipe_query_data_pipeline_statistics pipeline_statistics;
 	} result;
+	/* Values of the counters of non-GPU queries at begin and end */
+	uint64_t				begin_result;
+	uint64_t				end_result;
 	/* The kind of query */
 	unsigned				type;
 	/* Offset of the first result for current query */
@@ -98,6 +102,9 @@ void r600_context_queries_suspend(struct r600_context *ctx);
 void r600_context_queries_resume(struct r600_context *ctx);
 void r600_query_predication(struct r600_context *ctx, struct r600_query *query, int operation,
 			    int flag_wait);
+void si_ib_timestamp_begin(struct r600_context *ctx);
+boolean si_ib_gpu_time(struct r600_context *ctx, unsigned first_ib,
+		       unsigned end_ib, boolean wait, uint64_t *result);
 void si_context_emit_fence(struct r600_context *ctx, struct si_resource *fence,
                            unsigned offset, unsigned value);
 
@@ -374,10 +374,13 @@ static void r600_resource_copy_region(struct pipe_context *ctx,
 
 	memset(orig_info, 0, sizeof(orig_info));
 
-	/* Fallback for buffers. */
+	/* Buffers go through the DMA engine if we have one. */
 	if (dst->target == PIPE_BUFFER && src->target == PIPE_BUFFER) {
-		util_resource_copy_region(ctx, dst, dst_level, dstx, dsty, dstz,
-                                          src, src_level, src_box);
+		if (!si_dma_copy(ctx, dst, dst_level, dstx, dsty, dstz,
+				 src, src_level, src_box)) {
+			util_resource_copy_region(ctx, dst, dst_level, dstx, dsty, dstz,
+						  src, src_level, src_box);
+		}
 		return;
 	}
 
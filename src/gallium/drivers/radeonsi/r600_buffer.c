@@ -34,6 +34,7 @@
 
 #include "r600.h"
 #include "radeonsi_pipe.h"
+#include "r600_resource.h"
 
 static void r600_buffer_destroy(struct pipe_screen *screen,
 				struct pipe_resource *buf)
@@ -52,31 +53,59 @@ static void *r600_buffer_transfer_map(struct pipe_context *ctx,
                                       struct pipe_transfer **ptransfer)
 {
 	struct r600_context *rctx = (struct r600_context*)ctx;
-	struct pipe_transfer *transfer;
-        struct si_resource *rbuffer = si_resource(resource);
-        uint8_t *data;
+	struct r600_transfer *transfer;
+	struct si_resource *rbuffer = si_resource(resource);
+	struct si_resource *staging = NULL;
+	unsigned offset = 0;
+	uint8_t *data;
+
+	if ((usage & PIPE_TRANSFER_DISCARD_RANGE) &&
+	    !(usage & PIPE_TRANSFER_UNSYNCHRONIZED) &&
+	    rctx->dma_cs &&
+	    (si_rings_is_buffer_referenced(rctx, rbuffer->cs_buf, RADEON_USAGE_READWRITE) ||
+	     rctx->ws->buffer_is_busy(rbuffer->buf, RADEON_USAGE_READWRITE))) {
+		/* Do a wait-free write-only transfer using a temporary buffer,
+		 * which the DMA engine copies into place at unmap time. */
+		u_upload_alloc(rctx->uploader, 0, box->width, &offset,
+			       (struct pipe_resource**)&staging, (void**)&data);
+	}
 
-	data = rctx->ws->buffer_map(rbuffer->cs_buf, rctx->cs, usage);
-        if (!data) {
-		return NULL;
-        }
+	if (!staging) {
+		data = si_buffer_map_sync_with_rings(rctx, rbuffer, usage);
+		if (!data) {
+			return NULL;
+		}
+		data += box->x;
+	}
 
 	transfer = util_slab_alloc(&rctx->pool_transfers);
-	transfer->resource = resource;
-	transfer->level = level;
-	transfer->usage = usage;
-	transfer->box = *box;
-	transfer->stride = 0;
-	transfer->layer_stride = 0;
-        *ptransfer = transfer;
-
-	return (uint8_t*)data + transfer->box.x;
+	transfer->transfer.resource = resource;
+	transfer->transfer.level = level;
+	transfer->transfer.usage = usage;
+	transfer->transfer.box = *box;
+	transfer->transfer.stride = 0;
+	transfer->transfer.layer_stride = 0;
+	transfer->buffer_transfer = NULL;
+	transfer->offset = offset;
+	transfer->staging = staging ? &staging->b.b : NULL;
+	*ptransfer = &transfer->transfer;
+
+	return data;
 }
 
 static void r600_buffer_transfer_unmap(struct pipe_context *ctx,
 					struct pipe_transfer *transfer)
 {
 	struct r600_context *rctx = (struct r600_context*)ctx;
+	struct r600_transfer *rtransfer = (struct r600_transfer*)transfer;
+
+	if (rtransfer->staging) {
+		/* Copy the staging buffer into the original one. */
+		si_dma_copy_buffer(rctx, transfer->resource, rtransfer->staging,
+				   transfer->box.x, rtransfer->offset,
+				   transfer->box.width);
+		pipe_resource_reference(&rtransfer->staging, NULL);
+	}
 	util_slab_free(&rctx->pool_transfers, transfer);
 }
 
@@ -136,6 +136,14 @@ void si_need_cs_space(struct r600_context *ctx, unsigned num_dw,
 		num_dw += 3;
 	}
 
+	/* Count in the IB timestamps.  The end one is written at the end of
+	 * CS, the start one before the first draw. */
+	if (ctx->ib_ts_started) {
+		num_dw += R600_IB_TIMESTAMP_DWORDS / 2;
+	} else if (count_draw_in && ctx->num_ib_time_queries) {
+		num_dw += R600_IB_TIMESTAMP_DWORDS;
+	}
+
 	/* Count in framebuffer cache flushes at the end of CS. */
 	num_dw += 7; /* one SURFACE_SYNC and CACHE_FLUSH_AND_INV (r6xx-only) */
 
@@ -178,6 +186,97 @@ static void r600_flush_framebuffer(struct r600_context *ctx)
 	ctx->flags &= ~R600_CONTEXT_DST_CACHES_DIRTY;
 }
 
+static void si_emit_ib_timestamp(struct r600_context *ctx, unsigned offset)
+{
+	struct radeon_winsys_cs *cs = ctx->cs;
+	uint64_t va;
+
+	va = r600_resource_va(&ctx->screen->screen, (void*)ctx->ib_ts_buffer);
+	va += offset;
+
+	cs->buf[cs->cdw++] = PKT3(PKT3_EVENT_WRITE_EOP, 4, 0);
+	cs->buf[cs->cdw++] = EVENT_TYPE(EVENT_TYPE_BOTTOM_OF_PIPE_TS) | EVENT_INDEX(5);
+	cs->buf[cs->cdw++] = va;
+	cs->buf[cs->cdw++] = (3 << 29) | ((va >> 32UL) & 0xFF);
+	cs->buf[cs->cdw++] = 0;
+	cs->buf[cs->cdw++] = 0;
+	cs->buf[cs->cdw++] = PKT3(PKT3_NOP, 0, 0);
+	cs->buf[cs->cdw++] = r600_context_bo_reloc(ctx, ctx->ib_ts_buffer, RADEON_USAGE_WRITE);
+}
+
+/* Writes the start timestamp of the current IB, if there are IB GPU time
+ * queries and it isn't written yet.  Called before each draw, so IBs
+ * without draws don't get timestamps. */
+void si_ib_timestamp_begin(struct r600_context *ctx)
+{
+	unsigned slot;
+	uint64_t *ts;
+
+	if (!ctx->num_ib_time_queries || ctx->ib_ts_started)
+		return;
+
+	slot = ctx->ib_ts_index % R600_IB_TIMESTAMP_SLOTS;
+
+	/* Zeroes mark the timestamps the GPU hasn't written yet.  The slot
+	 * was last used R600_IB_TIMESTAMP_SLOTS IBs ago, so don't wait. */
+	ts = ctx->ws->buffer_map(ctx->ib_ts_buffer->cs_buf, NULL,
+				 PIPE_TRANSFER_WRITE | PIPE_TRANSFER_UNSYNCHRONIZED);
+	if (!ts)
+		return;
+	ts[slot * 2] = 0;
+	ts[slot * 2 + 1] = 0;
+	ctx->ws->buffer_unmap(ctx->ib_ts_buffer->cs_buf);
+
+	si_emit_ib_timestamp(ctx, slot * 16);
+	ctx->ib_ts_started = TRUE;
+}
+
+/* Sums the GPU time of the IBs with index first_ib to end_ib - 1, which
+ * must all be flushed.  Returns FALSE if some haven't finished executing
+ * and wait is FALSE. */
+boolean si_ib_gpu_time(struct r600_context *ctx, unsigned first_ib,
+		       unsigned end_ib, boolean wait, uint64_t *result)
+{
+	uint64_t ticks = 0;
+	uint64_t *ts;
+	unsigned i;
+
+	*result = 0;
+	if (first_ib == end_ib)
+		return TRUE;
+
+	/* The timestamps of older IBs were overwritten. */
+	if (end_ib - first_ib > R600_IB_TIMESTAMP_SLOTS)
+		first_ib = end_ib - R600_IB_TIMESTAMP_SLOTS;
+
+	if (wait) {
+		ctx->ws->cs_sync_flush(ctx->cs);
+		ctx->ws->buffer_wait(ctx->ib_ts_buffer->buf, RADEON_USAGE_WRITE);
+	}
+
+	/* The current IB may write the buffer, but not the slots read. */
+	ts = ctx->ws->buffer_map(ctx->ib_ts_buffer->cs_buf, NULL,
+				 PIPE_TRANSFER_READ | PIPE_TRANSFER_UNSYNCHRONIZED);
+	if (!ts)
+		return FALSE;
+
+	for (i = first_ib; i != end_ib; i++) {
+		unsigned slot = i % R600_IB_TIMESTAMP_SLOTS;
+		uint64_t start = ts[slot * 2];
+		uint64_t end = ts[slot * 2 + 1];
+
+		if (!start || !end) {
+			ctx->ws->buffer_unmap(ctx->ib_ts_buffer->cs_buf);
+			return FALSE;
+		}
+		ticks += end - start;
+	}
+	ctx->ws->buffer_unmap(ctx->ib_ts_buffer->cs_buf);
+
+	*result = (1000000 * ticks) / ctx->screen->info.r600_clock_crystal_freq;
+	return TRUE;
+}
+
 void si_context_flush(struct r600_context *ctx, unsigned flags)
 {
 	struct radeon_winsys_cs *cs = ctx->cs;
@@ -209,6 +308,13 @@ void si_context_flush(struct r600_context *ctx, unsigned flags)
 	cs->buf[cs->cdw++] = PKT3(PKT3_EVENT_WRITE, 0, 0);
 	cs->buf[cs->cdw++] = EVENT_TYPE(EVENT_TYPE_PS_PARTIAL_FLUSH) | EVENT_INDEX(4);
 
+	/* end the GPU time of this IB */
+	if (ctx->ib_ts_started) {
+		si_emit_ib_timestamp(ctx, (ctx->ib_ts_index % R600_IB_TIMESTAMP_SLOTS) * 16 + 8);
+		ctx->ib_ts_started = FALSE;
+		ctx->ib_ts_index++;
+	}
+
 	/* force to keep tiling flags */
 	flags |= RADEON_FLUSH_KEEP_TILING_FLAGS;
 
@@ -381,6 +487,33 @@ static boolean r600_query_result(struct r600_context *ctx, struct r600_query *qu
 			results_base = (results_base + query->result_size) % query->buffer->b.b.width0;
 		}
 		break;
+	case PIPE_QUERY_PIPELINE_STATISTICS:
+		while (results_base != query->results_end) {
+			query->result.pipeline_statistics.ps_invocations +=
+				r600_query_read_result(map + results_base, 0, 22, false);
+			query->result.pipeline_statistics.c_primitives +=
+				r600_query_read_result(map + results_base, 2, 24, false);
+			query->result.pipeline_statistics.c_invocations +=
+				r600_query_read_result(map + results_base, 4, 26, false);
+			query->result.pipeline_statistics.vs_invocations +=
+				r600_query_read_result(map + results_base, 6, 28, false);
+			query->result.pipeline_statistics.gs_invocations +=
+				r600_query_read_result(map + results_base, 8, 30, false);
+			query->result.pipeline_statistics.gs_primitives +=
+				r600_query_read_result(map + results_base, 10, 32, false);
+			query->result.pipeline_statistics.ia_primitives +=
+				r600_query_read_result(map + results_base, 12, 34, false);
+			query->result.pipeline_statistics.ia_vertices +=
+				r600_query_read_result(map + results_base, 14, 36, false);
+			query->result.pipeline_statistics.hs_invocations +=
+				r600_query_read_result(map + results_base, 16, 38, false);
+			query->result.pipeline_statistics.ds_invocations +=
+				r600_query_read_result(map + results_base, 18, 40, false);
+			query->result.pipeline_statistics.cs_invocations +=
+				r600_query_read_result(map + results_base, 20, 42, false);
+			results_base = (results_base + query->result_size) % query->buffer->b.b.width0;
+		}
+		break;
 	default:
 		assert(0);
 	}
@@ -430,6 +563,7 @@ void r600_query_begin(struct r600_context *ctx, struct r600_query *query)
 	case PIPE_QUERY_PRIMITIVES_GENERATED:
 	case PIPE_QUERY_SO_STATISTICS:
 	case PIPE_QUERY_SO_OVERFLOW_PREDICATE:
+	case PIPE_QUERY_PIPELINE_STATISTICS:
 		results = ctx->ws->buffer_map(query->buffer->cs_buf, ctx->cs, PIPE_TRANSFER_WRITE);
 		results = (uint32_t*)((char*)results + query->results_end);
 		memset(results, 0, query->result_size);
@@ -468,6 +602,17 @@ void r600_query_begin(struct r600_context *ctx, struct r600_query *query)
 		cs->buf[cs->cdw++] = 0;
 		cs->buf[cs->cdw++] = 0;
 		break;
+	case PIPE_QUERY_PIPELINE_STATISTICS:
+		if (!ctx->num_pipelinestat_queries) {
+			cs->buf[cs->cdw++] = PKT3(PKT3_EVENT_WRITE, 0, 0);
+			cs->buf[cs->cdw++] = EVENT_TYPE(EVENT_TYPE_PIPELINESTAT_START) | EVENT_INDEX(0);
+		}
+		ctx->num_pipelinestat_queries++;
+		cs->buf[cs->cdw++] = PKT3(PKT3_EVENT_WRITE, 2, 0);
+		cs->buf[cs->cdw++] = EVENT_TYPE(EVENT_TYPE_SAMPLE_PIPELINESTAT) | EVENT_INDEX(2);
+		cs->buf[cs->cdw++] = va;
+		cs->buf[cs->cdw++] = (va >> 32UL) & 0xFF;
+		break;
 	default:
 		assert(0);
 	}
@@ -511,6 +656,19 @@ void r600_query_end(struct r600_context *ctx, struct r600_query *query)
 		cs->buf[cs->cdw++] = 0;
 		cs->buf[cs->cdw++] = 0;
 		break;
+	case PIPE_QUERY_PIPELINE_STATISTICS:
+		assert(ctx->num_pipelinestat_queries > 0);
+		ctx->num_pipelinestat_queries--;
+		if (!ctx->num_pipelinestat_queries) {
+			cs->buf[cs->cdw++] = PKT3(PKT3_EVENT_WRITE, 0, 0);
+			cs->buf[cs->cdw++] = EVENT_TYPE(EVENT_TYPE_PIPELINESTAT_STOP) | EVENT_INDEX(0);
+		}
+		va += query->results_end + query->result_size/2;
+		cs->buf[cs->cdw++] = PKT3(PKT3_EVENT_WRITE, 2, 0);
+		cs->buf[cs->cdw++] = EVENT_TYPE(EVENT_TYPE_SAMPLE_PIPELINESTAT) | EVENT_INDEX(2);
+		cs->buf[cs->cdw++] = va;
+		cs->buf[cs->cdw++] = (va >> 32UL) & 0xFF;
+		break;
 	default:
 		assert(0);
 	}
@@ -593,6 +751,28 @@ struct r600_query *r600_context_query_create(struct r600_context *ctx, unsigned
 		query->result_size = 32;
 		query->num_cs_dw = 6;
 		break;
+	case PIPE_QUERY_PIPELINE_STATISTICS:
+		/* 11 values */
+		query->result_size = 11 * 16;
+		query->num_cs_dw = 8;
+		break;
+	/* Non-GPU queries. */
+	case R600_QUERY_IB_GPU_TIME:
+		if (!ctx->ib_ts_buffer) {
+			ctx->ib_ts_buffer = si_resource_create_custom(&ctx->screen->screen,
+								      PIPE_USAGE_STAGING,
+								      R600_IB_TIMESTAMP_SLOTS * 16);
+			if (!ctx->ib_ts_buffer) {
+				FREE(query);
+				return NULL;
+			}
+		}
+		ctx->num_ib_time_queries++;
+		return query;
+	case R600_QUERY_CS_THREAD_BUSY:
+	case R600_QUERY_CS_SYNC_WAIT_TIME:
+	case R600_QUERY_FENCE_WAIT_TIME:
+		return query;
 	default:
 		assert(0);
 		FREE(query);
@@ -618,6 +798,9 @@ struct r600_query *r600_context_query_create(struct r600_context *ctx, unsigned
 
 void r600_context_query_destroy(struct r600_context *ctx, struct r600_query *query)
 {
+	if (query->type == R600_QUERY_IB_GPU_TIME)
+		ctx->num_ib_time_queries--;
+
 	si_resource_reference(&query->buffer, NULL);
 	free(query);
 }
@@ -630,6 +813,8 @@ boolean r600_context_query_result(struct r600_context *ctx,
 	uint64_t *result_u64 = (uint64_t*)vresult;
 	struct pipe_query_data_so_statistics *result_so =
 		(struct pipe_query_data_so_statistics*)vresult;
+	struct pipe_query_data_pipeline_statistics *result_ps =
+		(struct pipe_query_data_pipeline_statistics*)vresult;
 
 	if (!r600_query_result(ctx, query, wait))
 		return FALSE;
@@ -650,6 +835,9 @@ boolean r600_context_query_result(struct r600_context *ctx,
 	case PIPE_QUERY_SO_STATISTICS:
 		*result_so = query->result.so;
 		break;
+	case PIPE_QUERY_PIPELINE_STATISTICS:
+		*result_ps = query->result.pipeline_statistics;
+		break;
 	default:
 		assert(0);
 	}
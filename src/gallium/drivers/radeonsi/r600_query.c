@@ -42,6 +42,22 @@ static void r600_begin_query(struct pipe_context *ctx, struct pipe_query *query)
 	struct r600_context *rctx = (struct r600_context *)ctx;
 	struct r600_query *rquery = (struct r600_query *)query;
 
+	/* Non-GPU queries. */
+	switch (rquery->type) {
+	case R600_QUERY_IB_GPU_TIME:
+		rquery->begin_result = rctx->ib_ts_index;
+		return;
+	case R600_QUERY_CS_THREAD_BUSY:
+		rquery->begin_result = rctx->ws->query_value(rctx->ws, RADEON_CS_THREAD_TIME_NS);
+		return;
+	case R600_QUERY_CS_SYNC_WAIT_TIME:
+		rquery->begin_result = rctx->ws->query_value(rctx->ws, RADEON_CS_SYNC_WAIT_TIME_NS);
+		return;
+	case R600_QUERY_FENCE_WAIT_TIME:
+		rquery->begin_result = rctx->screen->fence_wait_time;
+		return;
+	}
+
 	memset(&rquery->result, 0, sizeof(rquery->result));
 	rquery->results_start = rquery->results_end;
 	r600_query_begin(rctx, (struct r600_query *)query);
@@ -53,6 +69,23 @@ static void r600_end_query(struct pipe_context *ctx, struct pipe_query *query)
 	struct r600_context *rctx = (struct r600_context *)ctx;
 	struct r600_query *rquery = (struct r600_query *)query;
 
+	/* Non-GPU queries. */
+	switch (rquery->type) {
+	case R600_QUERY_IB_GPU_TIME:
+		/* The current IB is left to the next query. */
+		rquery->end_result = rctx->ib_ts_index;
+		return;
+	case R600_QUERY_CS_THREAD_BUSY:
+		rquery->end_result = rctx->ws->query_value(rctx->ws, RADEON_CS_THREAD_TIME_NS);
+		return;
+	case R600_QUERY_CS_SYNC_WAIT_TIME:
+		rquery->end_result = rctx->ws->query_value(rctx->ws, RADEON_CS_SYNC_WAIT_TIME_NS);
+		return;
+	case R600_QUERY_FENCE_WAIT_TIME:
+		rquery->end_result = rctx->screen->fence_wait_time;
+		return;
+	}
+
 	r600_query_end(rctx, rquery);
 	LIST_DELINIT(&rquery->list);
 }
@@ -64,6 +97,18 @@ static boolean r600_get_query_result(struct pipe_context *ctx,
 	struct r600_context *rctx = (struct r600_context *)ctx;
 	struct r600_query *rquery = (struct r600_query *)query;
 
+	/* Non-GPU queries. */
+	switch (rquery->type) {
+	case R600_QUERY_IB_GPU_TIME:
+		return si_ib_gpu_time(rctx, rquery->begin_result, rquery->end_result,
+				      wait, &vresult->u64);
+	case R600_QUERY_CS_THREAD_BUSY:
+	case R600_QUERY_CS_SYNC_WAIT_TIME:
+	case R600_QUERY_FENCE_WAIT_TIME:
+		vresult->u64 = rquery->end_result - rquery->begin_result;
+		return TRUE;
+	}
+
 	return r600_context_query_result(rctx, rquery, wait, vresult);
 }
 
@@ -42,9 +42,12 @@ static void r600_copy_to_staging_texture(struct pipe_context *ctx, struct r600_t
 	struct pipe_transfer *transfer = (struct pipe_transfer*)rtransfer;
 	struct pipe_resource *texture = transfer->resource;
 
-	ctx->resource_copy_region(ctx, rtransfer->staging,
-				0, 0, 0, 0, texture, transfer->level,
-				&transfer->box);
+	if (!si_dma_copy(ctx, rtransfer->staging, 0, 0, 0, 0,
+			 texture, transfer->level, &transfer->box)) {
+		ctx->resource_copy_region(ctx, rtransfer->staging,
+					  0, 0, 0, 0, texture, transfer->level,
+					  &transfer->box);
+	}
 }
 
 /* Copy from a transfer's staging texture to a full GPU one. */
@@ -56,10 +59,14 @@ static void r600_copy_from_staging_texture(struct pipe_context *ctx, struct r600
 
 	u_box_3d(0, 0, 0, transfer->box.width, transfer->box.height, transfer->box.depth, &sbox);
 
-	ctx->resource_copy_region(ctx, texture, transfer->level,
-				  transfer->box.x, transfer->box.y, transfer->box.z,
-				  rtransfer->staging,
-				  0, &sbox);
+	if (!si_dma_copy(ctx, texture, transfer->level,
+			 transfer->box.x, transfer->box.y, transfer->box.z,
+			 rtransfer->staging, 0, &sbox)) {
+		ctx->resource_copy_region(ctx, texture, transfer->level,
+					  transfer->box.x, transfer->box.y, transfer->box.z,
+					  rtransfer->staging,
+					  0, &sbox);
+	}
 }
 
 static unsigned r600_texture_get_offset(struct r600_resource_texture *rtex,
@@ -236,7 +243,7 @@ static void *si_texture_transfer_map(struct pipe_context *ctx,
 	struct r600_resource_texture *rtex = (struct r600_resource_texture*)texture;
 	struct r600_transfer *trans;
 	boolean use_staging_texture = FALSE;
-	struct radeon_winsys_cs_handle *buf;
+	struct si_resource *buf;
 	enum pipe_format format = texture->format;
 	unsigned offset = 0;
 	char *map;
@@ -351,9 +358,9 @@ static void *si_texture_transfer_map(struct pipe_context *ctx,
 	}
 
 	if (trans->staging) {
-		buf = si_resource(trans->staging)->cs_buf;
+		buf = si_resource(trans->staging);
 	} else {
-		buf = rtex->resource.cs_buf;
+		buf = &rtex->resource;
 	}
 
 	if (rtex->is_depth || !trans->staging)
@@ -361,7 +368,7 @@ static void *si_texture_transfer_map(struct pipe_context *ctx,
 			box->y / util_format_get_blockheight(format) * trans->transfer.stride +
 			box->x / util_format_get_blockwidth(format) * util_format_get_blocksize(format);
 
-	if (!(map = rctx->ws->buffer_map(buf, rctx->cs, usage))) {
+	if (!(map = si_buffer_map_sync_with_rings(rctx, buf, usage))) {
 		pipe_resource_reference(&trans->staging, NULL);
 		pipe_resource_reference(&trans->transfer.resource, NULL);
 		FREE(trans);
@@ -52,6 +52,7 @@
 #include "radeonsi_pipe.h"
 #include "r600_hw_context_priv.h"
 #include "si_state.h"
+#include "radeonsi_shader.h"
 
 /*
  * pipe_context
@@ -154,6 +155,10 @@ void radeonsi_flush(struct pipe_context *ctx, struct pipe_fence_handle **fence,
 		ctx->render_condition(ctx, NULL, FALSE, 0);
 	}
 
+	/* The DMA ring goes first, so that the next IB of the gfx ring
+	 * sees what was uploaded through it. */
+	if (rctx->dma_cs)
+		si_flush_dma_ring(rctx, flags);
 	si_context_flush(rctx, flags);
 
 	/* Re-enable render condition. */
@@ -166,8 +171,14 @@ static void r600_flush_from_st(struct pipe_context *ctx,
 			       struct pipe_fence_handle **fence,
                                unsigned flags)
 {
+	struct r600_context *rctx = (struct r600_context *)ctx;
+
 	radeonsi_flush(ctx, fence,
                        flags & PIPE_FLUSH_END_OF_FRAME ? RADEON_FLUSH_END_OF_FRAME : 0);
+
+	/* Let the upload ring know when it can reuse what was just flushed. */
+	if (fence && rctx->uploader)
+		u_upload_fence(rctx->uploader, *fence);
 }
 
 static void r600_flush_from_winsys(void *ctx, unsigned flags)
@@ -175,11 +186,78 @@ static void r600_flush_from_winsys(void *ctx, unsigned flags)
 	radeonsi_flush((struct pipe_context*)ctx, NULL, flags);
 }
 
+void si_flush_dma_ring(struct r600_context *rctx, unsigned flags)
+{
+	struct radeon_winsys_cs *cs = rctx->dma_cs;
+	unsigned padding_dw, i;
+
+	if (!cs->cdw)
+		return;
+
+	/* Pad the DMA CS to a multiple of 8 dwords. */
+	padding_dw = 8 - cs->cdw % 8;
+	if (padding_dw < 8) {
+		for (i = 0; i < padding_dw; i++)
+			cs->buf[cs->cdw++] = SI_DMA_PACKET(SI_DMA_PACKET_NOP, 0, 0);
+	}
+
+	rctx->ws->cs_flush(cs, flags, 0);
+}
+
+static void si_flush_dma_from_winsys(void *ctx, unsigned flags)
+{
+	si_flush_dma_ring((struct r600_context*)ctx, flags);
+}
+
+boolean si_rings_is_buffer_referenced(struct r600_context *rctx,
+				      struct radeon_winsys_cs_handle *buf,
+				      enum radeon_bo_usage usage)
+{
+	if (rctx->ws->cs_is_buffer_referenced(rctx->cs, buf, usage))
+		return TRUE;
+	if (rctx->dma_cs &&
+	    rctx->ws->cs_is_buffer_referenced(rctx->dma_cs, buf, usage))
+		return TRUE;
+	return FALSE;
+}
+
+/* Map a buffer, waiting for both rings if needed. The winsys only knows
+ * about the gfx CS, so the DMA CS is flushed here first if it uses
+ * the buffer. */
+void *si_buffer_map_sync_with_rings(struct r600_context *rctx,
+				    struct si_resource *resource,
+				    unsigned usage)
+{
+	enum radeon_bo_usage rusage = RADEON_USAGE_READWRITE;
+
+	if (rctx->dma_cs && rctx->dma_cs->cdw &&
+	    !(usage & PIPE_TRANSFER_UNSYNCHRONIZED)) {
+		if (!(usage & PIPE_TRANSFER_WRITE)) {
+			/* have to wait for pending writes only */
+			rusage = RADEON_USAGE_WRITE;
+		}
+
+		if (rctx->ws->cs_is_buffer_referenced(rctx->dma_cs, resource->cs_buf, rusage)) {
+			if (usage & PIPE_TRANSFER_DONTBLOCK) {
+				si_flush_dma_ring(rctx, RADEON_FLUSH_ASYNC);
+				return NULL;
+			}
+			si_flush_dma_ring(rctx, 0);
+		}
+	}
+
+	return rctx->ws->buffer_map(resource->cs_buf, rctx->cs, usage);
+}
+
 static void r600_destroy_context(struct pipe_context *context)
 {
 	struct r600_context *rctx = (struct r600_context *)context;
 
 	si_resource_reference(&rctx->border_color_table, NULL);
+	si_resource_reference(&rctx->ib_ts_buffer, NULL);
+
+	if (rctx->dma_cs)
+		rctx->ws->cs_destroy(rctx->dma_cs);
 
 	if (rctx->dummy_pixel_shader) {
 		rctx->context.delete_fs_state(&rctx->context, rctx->dummy_pixel_shader);
@@ -248,13 +326,19 @@ static struct pipe_context *r600_create_context(struct pipe_screen *screen, void
 
 	rctx->ws->cs_set_flush_callback(rctx->cs, r600_flush_from_winsys, rctx);
 
+	if (rscreen->info.r600_has_dma &&
+	    debug_get_bool_option("RADEONSI_ASYNC_DMA", TRUE)) {
+		rctx->dma_cs = rctx->ws->cs_create(rctx->ws, RING_DMA, NULL);
+		rctx->ws->cs_set_flush_callback(rctx->dma_cs, si_flush_dma_from_winsys, rctx);
+	}
+
 	util_slab_create(&rctx->pool_transfers,
-			 sizeof(struct pipe_transfer), 64,
+			 sizeof(struct r600_transfer), 64,
 			 UTIL_SLAB_SINGLETHREADED);
 
-        rctx->uploader = u_upload_create(&rctx->context, 1024 * 1024, 256,
-                                         PIPE_BIND_INDEX_BUFFER |
-                                         PIPE_BIND_CONSTANT_BUFFER);
+        rctx->uploader = u_upload_create_ring(&rctx->context, 4 * 1024 * 1024, 256,
+                                              PIPE_BIND_INDEX_BUFFER |
+                                              PIPE_BIND_CONSTANT_BUFFER);
         if (!rctx->uploader) {
 		r600_destroy_context(&rctx->context);
 		return NULL;
@@ -356,6 +440,7 @@ static int r600_get_param(struct pipe_screen* pscreen, enum pipe_cap param)
         case PIPE_CAP_PREFER_BLIT_BASED_TEXTURE_TRANSFER:
 	case PIPE_CAP_TGSI_INSTANCEID:
 	case PIPE_CAP_COMPUTE:
+	case PIPE_CAP_QUERY_PIPELINE_STATISTICS:
 		return 1;
 	case PIPE_CAP_TGSI_TEXCOORD:
 		return 0;
@@ -381,7 +466,6 @@ static int r600_get_param(struct pipe_screen* pscreen, enum pipe_cap param)
 	case PIPE_CAP_USER_VERTEX_BUFFERS:
 	case PIPE_CAP_TEXTURE_MULTISAMPLE:
 	case PIPE_CAP_QUERY_TIMESTAMP:
-	case PIPE_CAP_QUERY_PIPELINE_STATISTICS:
 	case PIPE_CAP_CUBE_MAP_ARRAY:
 	case PIPE_CAP_TEXTURE_BUFFER_OBJECTS:
 	case PIPE_CAP_TEXTURE_BUFFER_OFFSET_ALIGNMENT:
@@ -614,6 +698,8 @@ static void r600_destroy_screen(struct pipe_screen* pscreen)
 	if (rscreen == NULL)
 		return;
 
+	si_shader_queue_destroy(rscreen->shader_queue);
+
 	if (rscreen->fences.bo) {
 		struct r600_fence_block *entry, *tmp;
 
@@ -673,8 +759,14 @@ static boolean r600_fence_finish(struct pipe_screen *pscreen,
 	struct r600_screen *rscreen = (struct r600_screen *)pscreen;
 	struct r600_fence *rfence = (struct r600_fence*)fence;
 	int64_t start_time = 0;
+	uint64_t wait_start;
 	unsigned spins = 0;
 
+	if (rscreen->fences.data[rfence->index] != 0)
+		return TRUE;
+
+	wait_start = os_time_get_nano();
+
 	if (timeout != PIPE_TIMEOUT_INFINITE) {
 		start_time = os_time_get();
 
@@ -707,6 +799,7 @@ static boolean r600_fence_finish(struct pipe_screen *pscreen,
 		}
 	}
 
+	rscreen->fence_wait_time += os_time_get_nano() - wait_start;
 	return rscreen->fences.data[rfence->index] != 0;
 }
 
@@ -780,6 +873,27 @@ static unsigned radeon_family_from_device(unsigned device)
 	}
 }
 
+static int r600_get_driver_query_info(struct pipe_screen *screen,
+				      unsigned index,
+				      struct pipe_driver_query_info *info)
+{
+	struct pipe_driver_query_info list[] = {
+		{"ib-gpu-time", R600_QUERY_IB_GPU_TIME, 0, FALSE},
+		{"cs-thread-busy", R600_QUERY_CS_THREAD_BUSY, 0, FALSE},
+		{"cs-sync-wait-time", R600_QUERY_CS_SYNC_WAIT_TIME, 0, FALSE},
+		{"fence-wait-time", R600_QUERY_FENCE_WAIT_TIME, 0, FALSE}
+	};
+
+	if (!info)
+		return Elements(list);
+
+	if (index >= Elements(list))
+		return 0;
+
+	*info = list[index];
+	return 1;
+}
+
 struct pipe_screen *radeonsi_screen_create(struct radeon_winsys *ws)
 {
 	struct r600_screen *rscreen = CALLOC_STRUCT(r600_screen);
@@ -823,6 +937,7 @@ struct pipe_screen *radeonsi_screen_create(struct radeon_winsys *ws)
 	rscreen->screen.fence_reference = r600_fence_reference;
 	rscreen->screen.fence_signalled = r600_fence_signalled;
 	rscreen->screen.fence_finish = r600_fence_finish;
+	rscreen->screen.get_driver_query_info = r600_get_driver_query_info;
 	r600_init_screen_resource_functions(&rscreen->screen);
 
 	if (rscreen->info.has_uvd) {
@@ -842,6 +957,8 @@ struct pipe_screen *radeonsi_screen_create(struct radeon_winsys *ws)
 	LIST_INITHEAD(&rscreen->fences.blocks);
 	pipe_mutex_init(rscreen->fences.mutex);
 
+	rscreen->shader_queue = si_shader_queue_create(rscreen);
+
 #if R600_TRACE_CS
 	rscreen->cs_count = 0;
 	if (rscreen->info.drm_minor >= 28) {
@@ -50,6 +50,16 @@
 #define R600_TRACE_CS 0
 #define R600_TRACE_CS_DWORDS		6
 
+#define R600_QUERY_IB_GPU_TIME		(PIPE_QUERY_DRIVER_SPECIFIC + 0)
+#define R600_QUERY_CS_THREAD_BUSY	(PIPE_QUERY_DRIVER_SPECIFIC + 1)
+#define R600_QUERY_CS_SYNC_WAIT_TIME	(PIPE_QUERY_DRIVER_SPECIFIC + 2)
+#define R600_QUERY_FENCE_WAIT_TIME	(PIPE_QUERY_DRIVER_SPECIFIC + 3)
+
+/* Number of IBs whose start and end timestamps are kept */
+#define R600_IB_TIMESTAMP_SLOTS		256
+/* start and end EVENT_WRITE_EOP with their relocs */
+#define R600_IB_TIMESTAMP_DWORDS	16
+
 struct si_pipe_compute;
 
 struct r600_pipe_fences {
@@ -72,6 +82,10 @@ struct r600_screen {
 	struct r600_tiling_info		tiling_info;
 	struct util_slab_mempool	pool_buffers;
 	struct r600_pipe_fences		fences;
+	/* background shader compiles and their disk cache */
+	struct si_shader_queue		*shader_queue;
+	/* time spent in fence_finish in ns */
+	uint64_t			fence_wait_time;
 #if R600_TRACE_CS
 	struct si_resource		*trace_bo;
 	uint32_t			*trace_ptr;
@@ -174,6 +188,8 @@ struct r600_context {
 	/* Below are variables from the old r600_context.
 	 */
 	struct radeon_winsys_cs	*cs;
+	/* Async DMA ring, NULL if the kernel doesn't support it. */
+	struct radeon_winsys_cs	*dma_cs;
 
 	unsigned		pm4_dirty_cdwords;
 
@@ -181,6 +197,15 @@ struct r600_context {
 	struct list_head	active_query_list;
 	unsigned		num_cs_dw_queries_suspend;
 	unsigned		num_cs_dw_streamout_end;
+	unsigned		num_pipelinestat_queries;
+
+	/* Timestamps of the start and end of each IB, written while IB GPU
+	 * time queries exist.  Slot (ib_ts_index % R600_IB_TIMESTAMP_SLOTS)
+	 * is the one of the current IB. */
+	struct si_resource	*ib_ts_buffer;
+	unsigned		num_ib_time_queries;
+	unsigned		ib_ts_index;
+	boolean			ib_ts_started;
 
 	unsigned		backend_mask;
 	unsigned                max_db; /* for OQ */
@@ -233,6 +258,13 @@ void r600_upload_index_buffer(struct r600_context *rctx,
 /* r600_pipe.c */
 void radeonsi_flush(struct pipe_context *ctx, struct pipe_fence_handle **fence,
 		    unsigned flags);
+void si_flush_dma_ring(struct r600_context *rctx, unsigned flags);
+boolean si_rings_is_buffer_referenced(struct r600_context *rctx,
+				      struct radeon_winsys_cs_handle *buf,
+				      enum radeon_bo_usage usage);
+void *si_buffer_map_sync_with_rings(struct r600_context *rctx,
+				    struct si_resource *resource,
+				    unsigned usage);
 const char *r600_get_llvm_processor_name(enum radeon_family family);
 
 /* r600_query.c */
@@ -257,6 +289,22 @@ void r600_trace_emit(struct r600_context *rctx);
 /* radeonsi_compute.c */
 void si_init_compute_functions(struct r600_context *rctx);
 
+/* si_dma.c */
+void si_need_dma_space(struct r600_context *rctx, unsigned num_dw);
+void si_dma_copy_buffer(struct r600_context *rctx,
+			struct pipe_resource *dst,
+			struct pipe_resource *src,
+			uint64_t dst_offset,
+			uint64_t src_offset,
+			uint64_t size);
+boolean si_dma_copy(struct pipe_context *ctx,
+		    struct pipe_resource *dst,
+		    unsigned dst_level,
+		    unsigned dst_x, unsigned dst_y, unsigned dst_z,
+		    struct pipe_resource *src,
+		    unsigned src_level,
+		    const struct pipe_box *src_box);
+
 /* radeonsi_uvd.c */
 struct pipe_video_decoder *radeonsi_uvd_create_decoder(struct pipe_context *context,
 						       enum pipe_video_profile profile,
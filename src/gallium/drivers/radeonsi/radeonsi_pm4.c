@@ -169,6 +169,25 @@ void si_pm4_free_state(struct r600_context *rctx,
 	FREE(state);
 }
 
+/* Returns true if emitting \p b after \p a would have no effect, that is,
+ * if they write the same registers and data and reference the same BOs. */
+bool si_pm4_state_equal(const struct si_pm4_state *a,
+			const struct si_pm4_state *b)
+{
+	if (!a || !b)
+		return false;
+
+	return a->ndw == b->ndw &&
+	       a->nbo == b->nbo &&
+	       a->nrelocs == b->nrelocs &&
+	       a->cp_coher_cntl == b->cp_coher_cntl &&
+	       a->compute_pkt == b->compute_pkt &&
+	       memcmp(a->pm4, b->pm4, a->ndw * 4) == 0 &&
+	       memcmp(a->bo, b->bo, a->nbo * sizeof(a->bo[0])) == 0 &&
+	       memcmp(a->bo_usage, b->bo_usage, a->nbo * sizeof(a->bo_usage[0])) == 0 &&
+	       memcmp(a->relocs, b->relocs, a->nrelocs * sizeof(a->relocs[0])) == 0;
+}
+
 uint32_t si_pm4_sync_flags(struct r600_context *rctx)
 {
 	uint32_t cp_coher_cntl = 0;
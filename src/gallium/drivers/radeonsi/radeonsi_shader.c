@@ -1219,19 +1219,27 @@ static void preload_samplers(struct si_shader_context *si_shader_ctx)
 	}
 }
 
-int si_compile_llvm(struct r600_context *rctx, struct si_pipe_shader *shader,
-							LLVMModuleRef mod)
+/* Compiles \p mod and keeps the machine code in shader->code, to be uploaded
+ * by si_shader_binary_upload.  Doesn't touch any context, so it can run on
+ * the shader compiler thread. */
+static int si_compile_llvm_binary(struct r600_screen *rscreen,
+				  struct si_pipe_shader *shader,
+				  LLVMModuleRef mod)
 {
 	unsigned i;
-	uint32_t *ptr;
 	bool dump;
 	struct radeon_llvm_binary binary;
 
 	dump = debug_get_bool_option("RADEON_DUMP_SHADERS", FALSE);
 
 	memset(&binary, 0, sizeof(binary));
-	radeon_llvm_compile(mod, &binary,
-		r600_get_llvm_processor_name(rctx->screen->family), dump);
+	if (radeon_llvm_compile(mod, &binary,
+			r600_get_llvm_processor_name(rscreen->family), dump) ||
+	    !binary.code_size) {
+		FREE(binary.code);
+		FREE(binary.config);
+		return -EINVAL;
+	}
 	if (dump) {
 		fprintf(stderr, "SI CODE:\n");
 		for (i = 0; i < binary.code_size; i+=4 ) {
@@ -1265,35 +1273,64 @@ int si_compile_llvm(struct r600_context *rctx, struct si_pipe_shader *shader,
 		}
 	}
 
+	FREE(shader->code);
+	shader->code = binary.code;
+	shader->code_size = binary.code_size;
+	FREE(binary.config);
+
+	return 0;
+}
+
+/* Copies the machine code left by the compile into a new buffer. */
+int si_shader_binary_upload(struct r600_context *rctx,
+			    struct si_pipe_shader *shader)
+{
+	unsigned i;
+	uint32_t *ptr;
+
 	/* copy new shader */
 	si_resource_reference(&shader->bo, NULL);
 	shader->bo = si_resource_create_custom(rctx->context.screen, PIPE_USAGE_IMMUTABLE,
-					       binary.code_size);
+					       shader->code_size);
 	if (shader->bo == NULL) {
 		return -ENOMEM;
 	}
 
 	ptr = (uint32_t*)rctx->ws->buffer_map(shader->bo->cs_buf, rctx->cs, PIPE_TRANSFER_WRITE);
 	if (0 /*R600_BIG_ENDIAN*/) {
-		for (i = 0; i < binary.code_size / 4; ++i) {
-			ptr[i] = util_bswap32(*(uint32_t*)(binary.code + i*4));
+		for (i = 0; i < shader->code_size / 4; ++i) {
+			ptr[i] = util_bswap32(*(uint32_t*)(shader->code + i*4));
 		}
 	} else {
-		memcpy(ptr, binary.code, binary.code_size);
+		memcpy(ptr, shader->code, shader->code_size);
 	}
 	rctx->ws->buffer_unmap(shader->bo->cs_buf);
 
-	free(binary.code);
-	free(binary.config);
+	FREE(shader->code);
+	shader->code = NULL;
+	shader->code_size = 0;
 
 	return 0;
 }
 
-int si_pipe_shader_create(
-	struct pipe_context *ctx,
-	struct si_pipe_shader *shader)
+int si_compile_llvm(struct r600_context *rctx, struct si_pipe_shader *shader,
+							LLVMModuleRef mod)
+{
+	int r;
+
+	r = si_compile_llvm_binary(rctx->screen, shader, mod);
+	if (r)
+		return r;
+
+	return si_shader_binary_upload(rctx, shader);
+}
+
+/* Translates the TGSI of the variant and compiles it, leaving the machine
+ * code for si_shader_binary_upload.  Everything the result depends on comes
+ * from the selector and the key, so this may run on any thread. */
+int si_pipe_shader_compile(struct r600_screen *rscreen,
+			   struct si_pipe_shader *shader)
 {
-	struct r600_context *rctx = (struct r600_context*)ctx;
 	struct si_pipe_shader_selector *sel = shader->selector;
 	struct si_shader_context si_shader_ctx;
 	struct tgsi_shader_info shader_info;
@@ -1338,7 +1375,10 @@ int si_pipe_shader_create(
 	preload_constants(&si_shader_ctx);
 	preload_samplers(&si_shader_ctx);
 
-	shader->shader.nr_cbufs = rctx->framebuffer.nr_cbufs;
+	/* The key only holds the number of color buffers for shaders that
+	 * write all of them, which are the only ones that use it. */
+	if (sel->type == PIPE_SHADER_FRAGMENT)
+		shader->shader.nr_cbufs = shader->key.ps.nr_cbufs;
 
 	/* Dump TGSI code before doing TGSI->LLVM conversion in case the
 	 * conversion fails. */
@@ -1357,7 +1397,7 @@ int si_pipe_shader_create(
 	radeon_llvm_finalize_module(&si_shader_ctx.radeon_bld);
 
 	mod = bld_base->base.gallivm->module;
-	r = si_compile_llvm(rctx, shader, mod);
+	r = si_compile_llvm_binary(rscreen, shader, mod);
 
 	radeon_llvm_dispose(&si_shader_ctx.radeon_bld);
 	tgsi_parse_free(&si_shader_ctx.parse);
@@ -1371,5 +1411,9 @@ int si_pipe_shader_create(
 
 void si_pipe_shader_destroy(struct pipe_context *ctx, struct si_pipe_shader *shader)
 {
+	struct r600_context *rctx = (struct r600_context*)ctx;
+
+	si_shader_queue_cancel(rctx->screen->shader_queue, shader);
+	FREE(shader->code);
 	si_resource_reference(&shader->bo, NULL);
 }
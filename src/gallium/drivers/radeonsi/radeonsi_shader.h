@@ -30,6 +30,7 @@
 #define RADEONSI_SHADER_H
 
 #include <llvm-c/Core.h> /* LLVMModuleRef */
+#include "util/u_double_list.h"
 
 #define SI_SGPR_CONST		0
 #define SI_SGPR_SAMPLER		2
@@ -130,6 +131,15 @@ union si_shader_key {
 	} vs;
 };
 
+/* Where a variant is in the shader compiler queue */
+enum si_shader_status {
+	SI_SHADER_IDLE = 0,	/* not queued, or compiled synchronously */
+	SI_SHADER_QUEUED,
+	SI_SHADER_COMPILING,
+	SI_SHADER_COMPILED,	/* code waits for si_shader_binary_upload */
+	SI_SHADER_READY		/* uploaded, the variant can be drawn with */
+};
+
 struct si_pipe_shader {
 	struct si_pipe_shader_selector	*selector;
 	struct si_pipe_shader		*next_variant;
@@ -144,13 +154,36 @@ struct si_pipe_shader {
 	unsigned			sprite_coord_enable;
 	unsigned			so_strides[4];
 	union si_shader_key		key;
+
+	/* Machine code not uploaded yet */
+	unsigned char			*code;
+	unsigned			code_size;
+
+	/* Protected by the shader queue mutex, except for the
+	 * SI_SHADER_READY transition which only the context makes. */
+	enum si_shader_status		status;
+	int				compile_result;
+	struct list_head		queue_head;
 };
 
 /* radeonsi_shader.c */
-int si_pipe_shader_create(struct pipe_context *ctx, struct si_pipe_shader *shader);
-int si_pipe_shader_create(struct pipe_context *ctx, struct si_pipe_shader *shader);
+int si_pipe_shader_compile(struct r600_screen *rscreen,
+			   struct si_pipe_shader *shader);
+int si_shader_binary_upload(struct r600_context *rctx,
+			    struct si_pipe_shader *shader);
 int si_compile_llvm(struct r600_context *rctx, struct si_pipe_shader *shader,
 							LLVMModuleRef mod);
 void si_pipe_shader_destroy(struct pipe_context *ctx, struct si_pipe_shader *shader);
 
+/* radeonsi_shader_queue.c */
+struct si_shader_queue;
+struct si_shader_queue *si_shader_queue_create(struct r600_screen *rscreen);
+void si_shader_queue_destroy(struct si_shader_queue *queue);
+void si_shader_queue_add(struct si_shader_queue *queue,
+			 struct si_pipe_shader *shader);
+int si_shader_queue_finish(struct r600_context *rctx,
+			   struct si_pipe_shader *shader);
+void si_shader_queue_cancel(struct si_shader_queue *queue,
+			    struct si_pipe_shader *shader);
+
 #endif
@@ -0,0 +1,400 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * on the rights to use, copy, modify, merge, publish, distribute, sub
+ * license, and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHOR(S) AND/OR THEIR SUPPLIERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Background compilation of shader variants, and an on-disk cache of their
+ * machine code.
+ *
+ * Variants are queued when they are created, which for the first variant of
+ * a shader is at create_*_state time, and a screen thread translates and
+ * compiles them.  The upload and the state setup stay on the context's
+ * thread, at the first draw using the variant.  If that draw comes before
+ * the thread got to the variant, the context compiles it itself rather
+ * than wait for the jobs queued ahead of it.
+ *
+ * Before compiling, the disk cache is looked up with the TGSI tokens, the
+ * stream output info and the variant key.  The cache id covers the driver
+ * build and the LLVM version.
+ */
+
+#include "radeonsi_pipe.h"
+#include "radeonsi_shader.h"
+
+#include "os/os_thread.h"
+#include "tgsi/tgsi_parse.h"
+#include "util/u_cpu_detect.h"
+#include "util/u_disk_cache.h"
+#include "util/u_memory.h"
+
+#include <dlfcn.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+struct si_shader_queue {
+	struct r600_screen	*screen;
+	struct util_disk_cache	*cache;
+
+	/* Only valid if threaded */
+	boolean			threaded;
+	pipe_thread		thread;
+	pipe_mutex		mutex;
+	/* a job was queued or compiled, or exit was set */
+	pipe_condvar		cond;
+	struct list_head	jobs;
+	boolean			exit;
+};
+
+/* Fixed part of the cache key, followed by the TGSI tokens. */
+struct si_shader_cache_key {
+	uint32_t			family;
+	uint32_t			type;
+	union si_shader_key		key;
+	struct pipe_stream_output_info	so;
+};
+
+/* Cache data, followed by the machine code. */
+struct si_shader_cache_entry {
+	struct si_shader	shader;
+	uint32_t		num_sgprs;
+	uint32_t		num_vgprs;
+	uint32_t		spi_ps_input_ena;
+	uint32_t		code_size;
+};
+
+static void make_dir(char *path)
+{
+	char *p;
+
+	/* Create the missing parents first, like mkdir -p. */
+	for (p = strchr(path + 1, '/'); p; p = strchr(p + 1, '/')) {
+		*p = '\0';
+		mkdir(path, 0755);
+		*p = '/';
+	}
+	mkdir(path, 0755);
+}
+
+static struct util_disk_cache *si_shader_cache_create(void)
+{
+	char path[PATH_MAX];
+	char id[128];
+	struct stat st;
+	Dl_info info;
+	const char *dir;
+	int n = -1;
+
+	/* An empty RADEONSI_SHADER_CACHE_DIR disables the cache. */
+	if ((dir = getenv("RADEONSI_SHADER_CACHE_DIR")) != NULL)
+		n = snprintf(path, sizeof(path), "%s", dir);
+	else if ((dir = getenv("XDG_CACHE_HOME")) != NULL)
+		n = snprintf(path, sizeof(path), "%s/mesa/radeonsi", dir);
+	else if ((dir = getenv("HOME")) != NULL)
+		n = snprintf(path, sizeof(path), "%s/.cache/mesa/radeonsi", dir);
+
+	if (n <= 0 || n >= (int)sizeof(path))
+		return NULL;
+
+	/* The shader info layout and the code generation may change with any
+	 * rebuild of the driver, and we use the driver's own file to tell
+	 * builds apart. */
+	if (!dladdr((void *)si_shader_cache_create, &info) ||
+	    info.dli_fname == NULL ||
+	    stat(info.dli_fname, &st) != 0)
+		return NULL;
+
+	make_dir(path);
+
+	snprintf(id, sizeof(id), "radeonsi LLVM %u.%u %lx %lx",
+		 HAVE_LLVM >> 8, HAVE_LLVM & 0xff,
+		 (unsigned long)st.st_mtime, (unsigned long)st.st_size);
+	return util_disk_cache_create(path, id);
+}
+
+/* Returns the cache key of \p shader, to be freed by the caller. */
+static void *make_cache_key(struct r600_screen *rscreen,
+			    struct si_pipe_shader *shader, size_t *key_size)
+{
+	struct si_pipe_shader_selector *sel = shader->selector;
+	struct si_shader_cache_key *key;
+	unsigned tokens_size = tgsi_num_tokens(sel->tokens) *
+			       sizeof(struct tgsi_token);
+
+	*key_size = sizeof(*key) + tokens_size;
+	key = CALLOC(1, *key_size);
+	if (!key)
+		return NULL;
+
+	key->family = rscreen->family;
+	key->type = sel->type;
+	memcpy(&key->key, &shader->key, sizeof(key->key));
+	memcpy(&key->so, &sel->so, sizeof(key->so));
+	memcpy(key + 1, sel->tokens, tokens_size);
+	return key;
+}
+
+static boolean si_shader_cache_load(struct util_disk_cache *cache,
+				    const void *key, size_t key_size,
+				    struct si_pipe_shader *shader)
+{
+	struct si_shader_cache_entry *entry;
+	size_t data_size;
+	void *data;
+
+	if (!util_disk_cache_get(cache, key, key_size, &data, &data_size))
+		return FALSE;
+
+	entry = data;
+	if (data_size < sizeof(*entry) ||
+	    data_size != sizeof(*entry) + entry->code_size ||
+	    !entry->code_size) {
+		FREE(data);
+		return FALSE;
+	}
+
+	shader->code = MALLOC(entry->code_size);
+	if (!shader->code) {
+		FREE(data);
+		return FALSE;
+	}
+
+	shader->shader = entry->shader;
+	shader->num_sgprs = entry->num_sgprs;
+	shader->num_vgprs = entry->num_vgprs;
+	shader->spi_ps_input_ena = entry->spi_ps_input_ena;
+	shader->code_size = entry->code_size;
+	memcpy(shader->code, entry + 1, entry->code_size);
+
+	FREE(data);
+	return TRUE;
+}
+
+static void si_shader_cache_store(struct util_disk_cache *cache,
+				  const void *key, size_t key_size,
+				  struct si_pipe_shader *shader)
+{
+	struct si_shader_cache_entry *entry;
+	size_t data_size = sizeof(*entry) + shader->code_size;
+
+	entry = CALLOC(1, data_size);
+	if (!entry)
+		return;
+
+	entry->shader = shader->shader;
+	entry->num_sgprs = shader->num_sgprs;
+	entry->num_vgprs = shader->num_vgprs;
+	entry->spi_ps_input_ena = shader->spi_ps_input_ena;
+	entry->code_size = shader->code_size;
+	memcpy(entry + 1, shader->code, shader->code_size);
+
+	util_disk_cache_put(cache, key, key_size, entry, data_size);
+	FREE(entry);
+}
+
+/* Leaves the machine code of \p shader in shader->code, from the disk cache
+ * or from a compile. */
+static int si_shader_build(struct r600_screen *rscreen,
+			   struct si_pipe_shader *shader)
+{
+	struct si_shader_queue *queue = rscreen->shader_queue;
+	struct util_disk_cache *cache = queue ? queue->cache : NULL;
+	size_t key_size = 0;
+	void *key = NULL;
+	int r;
+
+	if (cache) {
+		key = make_cache_key(rscreen, shader, &key_size);
+		if (key && si_shader_cache_load(cache, key, key_size, shader)) {
+			FREE(key);
+			return 0;
+		}
+	}
+
+	r = si_pipe_shader_compile(rscreen, shader);
+	if (!r && key)
+		si_shader_cache_store(cache, key, key_size, shader);
+
+	FREE(key);
+	return r;
+}
+
+static PIPE_THREAD_ROUTINE(si_shader_queue_thread, param)
+{
+	struct si_shader_queue *queue = param;
+	struct si_pipe_shader *shader;
+	int r;
+
+	pipe_mutex_lock(queue->mutex);
+	for (;;) {
+		while (!queue->exit && LIST_IS_EMPTY(&queue->jobs))
+			pipe_condvar_wait(queue->cond, queue->mutex);
+		if (queue->exit)
+			break;
+
+		shader = LIST_ENTRY(struct si_pipe_shader, queue->jobs.next,
+				    queue_head);
+		LIST_DELINIT(&shader->queue_head);
+		shader->status = SI_SHADER_COMPILING;
+		pipe_mutex_unlock(queue->mutex);
+
+		r = si_shader_build(queue->screen, shader);
+
+		pipe_mutex_lock(queue->mutex);
+		shader->compile_result = r;
+		shader->status = SI_SHADER_COMPILED;
+		pipe_condvar_broadcast(queue->cond);
+	}
+	pipe_mutex_unlock(queue->mutex);
+
+	return NULL;
+}
+
+/* Returns the queue for a new screen.  Without a thread, variants are
+ * compiled at their first draw, and the disk cache is still used. */
+struct si_shader_queue *si_shader_queue_create(struct r600_screen *rscreen)
+{
+	struct si_shader_queue *queue;
+
+	queue = CALLOC_STRUCT(si_shader_queue);
+	if (!queue)
+		return NULL;
+
+	queue->screen = rscreen;
+
+	/* Dumps come from the compile itself, and must come in order. */
+	if (debug_get_bool_option("RADEON_DUMP_SHADERS", FALSE))
+		return queue;
+
+	queue->cache = si_shader_cache_create();
+
+	util_cpu_detect();
+	if (!debug_get_bool_option("RADEONSI_ASYNC_COMPILE",
+				   util_cpu_caps.nr_cpus > 1))
+		return queue;
+
+	pipe_mutex_init(queue->mutex);
+	pipe_condvar_init(queue->cond);
+	LIST_INITHEAD(&queue->jobs);
+	queue->thread = pipe_thread_create(si_shader_queue_thread, queue);
+	queue->threaded = TRUE;
+
+	return queue;
+}
+
+void si_shader_queue_destroy(struct si_shader_queue *queue)
+{
+	if (!queue)
+		return;
+
+	if (queue->threaded) {
+		pipe_mutex_lock(queue->mutex);
+		queue->exit = TRUE;
+		pipe_condvar_broadcast(queue->cond);
+		pipe_mutex_unlock(queue->mutex);
+
+		pipe_thread_wait(queue->thread);
+		pipe_condvar_destroy(queue->cond);
+		pipe_mutex_destroy(queue->mutex);
+	}
+
+	util_disk_cache_destroy(queue->cache);
+	FREE(queue);
+}
+
+/* Starts compiling a new variant in the background. */
+void si_shader_queue_add(struct si_shader_queue *queue,
+			 struct si_pipe_shader *shader)
+{
+	if (!queue || !queue->threaded)
+		return;
+
+	pipe_mutex_lock(queue->mutex);
+	shader->status = SI_SHADER_QUEUED;
+	LIST_ADDTAIL(&shader->queue_head, &queue->jobs);
+	pipe_condvar_broadcast(queue->cond);
+	pipe_mutex_unlock(queue->mutex);
+}
+
+/* Makes the variant ready to be drawn with: finishes its compile if needed
+ * and uploads the code.  Returns the compile or upload error, if any. */
+int si_shader_queue_finish(struct r600_context *rctx,
+			   struct si_pipe_shader *shader)
+{
+	struct si_shader_queue *queue = rctx->screen->shader_queue;
+	int r;
+
+	if (shader->status == SI_SHADER_READY)
+		return 0;
+
+	if (queue && queue->threaded) {
+		pipe_mutex_lock(queue->mutex);
+		if (shader->status == SI_SHADER_QUEUED) {
+			/* Don't wait for the jobs queued before this one. */
+			LIST_DELINIT(&shader->queue_head);
+			shader->status = SI_SHADER_COMPILING;
+			pipe_mutex_unlock(queue->mutex);
+
+			r = si_shader_build(rctx->screen, shader);
+
+			pipe_mutex_lock(queue->mutex);
+			shader->compile_result = r;
+			shader->status = SI_SHADER_COMPILED;
+		}
+		while (shader->status == SI_SHADER_COMPILING)
+			pipe_condvar_wait(queue->cond, queue->mutex);
+		pipe_mutex_unlock(queue->mutex);
+	}
+
+	if (shader->status == SI_SHADER_IDLE) {
+		shader->compile_result = si_shader_build(rctx->screen, shader);
+		shader->status = SI_SHADER_COMPILED;
+	}
+
+	r = shader->compile_result;
+	if (r)
+		return r;
+
+	r = si_shader_binary_upload(rctx, shader);
+	if (r)
+		return r;
+
+	shader->status = SI_SHADER_READY;
+	return 0;
+}
+
+/* Makes sure the thread no longer uses a variant that is being destroyed. */
+void si_shader_queue_cancel(struct si_shader_queue *queue,
+			    struct si_pipe_shader *shader)
+{
+	if (!queue || !queue->threaded)
+		return;
+
+	pipe_mutex_lock(queue->mutex);
+	if (shader->status == SI_SHADER_QUEUED) {
+		LIST_DELINIT(&shader->queue_head);
+		shader->status = SI_SHADER_IDLE;
+	}
+	while (shader->status == SI_SHADER_COMPILING)
+		pipe_condvar_wait(queue->cond, queue->mutex);
+	pipe_mutex_unlock(queue->mutex);
+}
@@ -0,0 +1,302 @@
+/*
+ * Copyright 2013 Advanced Micro Devices, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * on the rights to use, copy, modify, merge, publish, distribute, sub
+ * license, and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHOR(S) AND/OR THEIR SUPPLIERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "util/u_format.h"
+#include "radeonsi_pipe.h"
+#include "r600_resource.h"
+#include "sid.h"
+
+/* Tiling index of 1D tiled scanout surfaces, see the kernel tile mode table.
+ * The other 1D color modes use thin micro tiling. */
+#define SI_TILE_MODE_COLOR_1D_SCANOUT	9
+
+#define SI_DMA_MICRO_TILING_DISPLAY	0
+#define SI_DMA_MICRO_TILING_THIN	1
+
+void si_need_dma_space(struct r600_context *rctx, unsigned num_dw)
+{
+	/* The number of dwords we already used in the DMA so far,
+	 * plus the padding added at flush time. */
+	num_dw += rctx->dma_cs->cdw + 8;
+	/* Flush if there's not enough space. */
+	if (num_dw > RADEON_MAX_CMDBUF_DWORDS)
+		si_flush_dma_ring(rctx, RADEON_FLUSH_ASYNC);
+}
+
+static void si_dma_add_reloc(struct r600_context *rctx, struct si_resource *rbo,
+			     enum radeon_bo_usage usage)
+{
+	rctx->ws->cs_add_reloc(rctx->dma_cs, rbo->cs_buf, usage, rbo->domains);
+}
+
+/* The kernel orders the IBs of different rings that use the same buffer
+ * in submission order, so the gfx IB is only submitted first if it can
+ * still write the source or access the destination. */
+static void si_dma_sync_gfx(struct r600_context *rctx,
+			    struct si_resource *rdst,
+			    struct si_resource *rsrc)
+{
+	if (rctx->ws->cs_is_buffer_referenced(rctx->cs, rdst->cs_buf, RADEON_USAGE_READWRITE) ||
+	    rctx->ws->cs_is_buffer_referenced(rctx->cs, rsrc->cs_buf, RADEON_USAGE_WRITE))
+		radeonsi_flush(&rctx->context, NULL, RADEON_FLUSH_ASYNC);
+}
+
+void si_dma_copy_buffer(struct r600_context *rctx,
+			struct pipe_resource *dst,
+			struct pipe_resource *src,
+			uint64_t dst_offset,
+			uint64_t src_offset,
+			uint64_t size)
+{
+	struct radeon_winsys_cs *cs = rctx->dma_cs;
+	struct si_resource *rdst = si_resource(dst);
+	struct si_resource *rsrc = si_resource(src);
+	unsigned i, ncopy, csize, max_csize, sub_cmd, shift;
+
+	si_dma_sync_gfx(rctx, rdst, rsrc);
+
+	dst_offset += r600_resource_va(&rctx->screen->screen, dst);
+	src_offset += r600_resource_va(&rctx->screen->screen, src);
+
+	/* see if we use dword or byte copy */
+	if (!(dst_offset & 0x3) && !(src_offset & 0x3) && !(size & 0x3)) {
+		size >>= 2;
+		sub_cmd = SI_DMA_COPY_DWORD_ALIGNED;
+		shift = 2;
+		max_csize = SI_DMA_COPY_MAX_SIZE_DW;
+	} else {
+		sub_cmd = SI_DMA_COPY_BYTE_ALIGNED;
+		shift = 0;
+		max_csize = SI_DMA_COPY_MAX_SIZE;
+	}
+	ncopy = (size / max_csize) + !!(size % max_csize);
+
+	si_need_dma_space(rctx, ncopy * 5);
+
+	/* emit relocs before writing cs so that cs is always in consistent state */
+	si_dma_add_reloc(rctx, rsrc, RADEON_USAGE_READ);
+	si_dma_add_reloc(rctx, rdst, RADEON_USAGE_WRITE);
+
+	for (i = 0; i < ncopy; i++) {
+		csize = size < max_csize ? size : max_csize;
+		cs->buf[cs->cdw++] = SI_DMA_PACKET(SI_DMA_PACKET_COPY, sub_cmd, csize);
+		cs->buf[cs->cdw++] = dst_offset & 0xffffffff;
+		cs->buf[cs->cdw++] = src_offset & 0xffffffff;
+		cs->buf[cs->cdw++] = (dst_offset >> 32UL) & 0xff;
+		cs->buf[cs->cdw++] = (src_offset >> 32UL) & 0xff;
+		dst_offset += csize << shift;
+		src_offset += csize << shift;
+		size -= csize;
+	}
+}
+
+static unsigned si_dma_pipe_config(struct r600_screen *rscreen)
+{
+	/* What the kernel tile mode table uses for each chip. */
+	switch (rscreen->info.r600_num_tile_pipes) {
+	case 8:
+		return 10; /* ADDR_SURF_P8_32x32_8x16 */
+	case 4:
+		return 4; /* ADDR_SURF_P4_8x16 */
+	default:
+		return 0; /* ADDR_SURF_P2 */
+	}
+}
+
+/* Copy between a linear and a 1D tiled surface. The DMA engine can also
+ * do 2D tiling, but that needs the bank and pipe settings of each tile
+ * mode, which the kernel doesn't give us. */
+static void si_dma_copy_tile(struct r600_context *rctx,
+			     struct pipe_resource *dst,
+			     unsigned dst_level,
+			     unsigned dst_x,
+			     unsigned dst_y,
+			     unsigned dst_z,
+			     struct pipe_resource *src,
+			     unsigned src_level,
+			     unsigned src_x,
+			     unsigned src_y,
+			     unsigned src_z,
+			     unsigned copy_height,
+			     unsigned pitch,
+			     unsigned bpp)
+{
+	struct radeon_winsys_cs *cs = rctx->dma_cs;
+	struct r600_resource_texture *rsrc = (struct r600_resource_texture*)src;
+	struct r600_resource_texture *rdst = (struct r600_resource_texture*)dst;
+	struct r600_resource_texture *rlinear, *rtiled;
+	unsigned linear_lvl, tiled_lvl;
+	unsigned lbpp, pitch_tile_max, slice_tile_max, size;
+	unsigned ncopy, height, cheight, detile, i, dst_mode;
+	unsigned linear_x, linear_y, linear_z, tiled_x, tiled_y, tiled_z;
+	unsigned pipe_config, mt;
+	uint64_t base, addr;
+
+	si_dma_sync_gfx(rctx, &rdst->resource, &rsrc->resource);
+
+	dst_mode = rdst->surface.level[dst_level].mode;
+
+	lbpp = util_logbase2(bpp);
+	pitch_tile_max = ((pitch / bpp) / 8) - 1;
+
+	detile = dst_mode == RADEON_SURF_MODE_LINEAR ||
+		 dst_mode == RADEON_SURF_MODE_LINEAR_ALIGNED;
+	rlinear = detile ? rdst : rsrc;
+	rtiled = detile ? rsrc : rdst;
+	linear_lvl = detile ? dst_level : src_level;
+	tiled_lvl = detile ? src_level : dst_level;
+	linear_x = detile ? dst_x : src_x;
+	linear_y = detile ? dst_y : src_y;
+	linear_z = detile ? dst_z : src_z;
+	tiled_x = detile ? src_x : dst_x;
+	tiled_y = detile ? src_y : dst_y;
+	tiled_z = detile ? src_z : dst_z;
+
+	slice_tile_max = (rtiled->surface.level[tiled_lvl].nblk_x *
+			  rtiled->surface.level[tiled_lvl].nblk_y) / (8*8) - 1;
+	/* linear height must be the same as the slice tile max height, it's ok even
+	 * if the linear destination/source have smaller height as the size of the
+	 * dma packet will be using the copy_height which is always smaller or equal
+	 * to the linear height
+	 */
+	height = rtiled->surface.level[tiled_lvl].nblk_y;
+	base = rtiled->surface.level[tiled_lvl].offset;
+	addr = rlinear->surface.level[linear_lvl].offset;
+	addr += rlinear->surface.level[linear_lvl].slice_size * linear_z;
+	addr += linear_y * pitch + linear_x * bpp;
+	base += r600_resource_va(&rctx->screen->screen, &rtiled->resource.b.b);
+	addr += r600_resource_va(&rctx->screen->screen, &rlinear->resource.b.b);
+
+	pipe_config = si_dma_pipe_config(rctx->screen);
+	mt = rtiled->surface.tiling_index[tiled_lvl] == SI_TILE_MODE_COLOR_1D_SCANOUT ?
+		SI_DMA_MICRO_TILING_DISPLAY : SI_DMA_MICRO_TILING_THIN;
+
+	size = (copy_height * pitch) / 4;
+	ncopy = (size / SI_DMA_COPY_MAX_SIZE_DW) + !!(size % SI_DMA_COPY_MAX_SIZE_DW);
+	si_need_dma_space(rctx, ncopy * 9);
+
+	si_dma_add_reloc(rctx, &rsrc->resource, RADEON_USAGE_READ);
+	si_dma_add_reloc(rctx, &rdst->resource, RADEON_USAGE_WRITE);
+
+	for (i = 0; i < ncopy; i++) {
+		cheight = copy_height;
+		if (((cheight * pitch) / 4) > SI_DMA_COPY_MAX_SIZE_DW) {
+			cheight = (SI_DMA_COPY_MAX_SIZE_DW * 4) / pitch;
+		}
+		size = (cheight * pitch) / 4;
+		cs->buf[cs->cdw++] = SI_DMA_PACKET(SI_DMA_PACKET_COPY, SI_DMA_COPY_TILED, size);
+		cs->buf[cs->cdw++] = base >> 8;
+		cs->buf[cs->cdw++] = (detile << 31) |
+				     (V_009910_ARRAY_1D_TILED_THIN1 << 27) |
+				     (lbpp << 24);
+		cs->buf[cs->cdw++] = (pitch_tile_max << 0) | ((height - 1) << 16);
+		cs->buf[cs->cdw++] = (slice_tile_max << 0) | (pipe_config << 26);
+		cs->buf[cs->cdw++] = (tiled_x << 0) | (tiled_z << 18);
+		cs->buf[cs->cdw++] = (tiled_y << 0) | (mt << 27);
+		cs->buf[cs->cdw++] = addr & 0xfffffffc;
+		cs->buf[cs->cdw++] = (addr >> 32UL) & 0xff;
+		copy_height -= cheight;
+		addr += cheight * pitch;
+		tiled_y += cheight;
+	}
+}
+
+/* Copy a region with the DMA engine. Returns FALSE if it can't be done,
+ * in which case the caller must fall back to a blit. */
+boolean si_dma_copy(struct pipe_context *ctx,
+		    struct pipe_resource *dst,
+		    unsigned dst_level,
+		    unsigned dst_x, unsigned dst_y, unsigned dst_z,
+		    struct pipe_resource *src,
+		    unsigned src_level,
+		    const struct pipe_box *src_box)
+{
+	struct r600_context *rctx = (struct r600_context *)ctx;
+	struct r600_resource_texture *rsrc = (struct r600_resource_texture*)src;
+	struct r600_resource_texture *rdst = (struct r600_resource_texture*)dst;
+	unsigned dst_pitch, src_pitch, bpp, dst_mode, src_mode, copy_height;
+	unsigned src_y, z;
+
+	if (rctx->dma_cs == NULL)
+		return FALSE;
+
+	if (dst->target == PIPE_BUFFER && src->target == PIPE_BUFFER) {
+		si_dma_copy_buffer(rctx, dst, src, dst_x, src_box->x, src_box->width);
+		return TRUE;
+	}
+
+	if (dst->target == PIPE_BUFFER || src->target == PIPE_BUFFER ||
+	    src->format != dst->format ||
+	    src->nr_samples > 1 || dst->nr_samples > 1 ||
+	    rsrc->is_depth || rdst->is_depth)
+		return FALSE;
+
+	bpp = rdst->surface.bpe;
+	dst_pitch = rdst->surface.level[dst_level].pitch_bytes;
+	src_pitch = rsrc->surface.level[src_level].pitch_bytes;
+	copy_height = util_format_get_nblocksy(src->format, src_box->height);
+	src_y = util_format_get_nblocksy(src->format, src_box->y);
+	dst_y = util_format_get_nblocksy(dst->format, dst_y);
+
+	/* Only whole rows are copied. */
+	if (src_pitch != dst_pitch || src_box->x || dst_x ||
+	    src_box->width != rsrc->surface.level[src_level].npix_x ||
+	    src_box->width != rdst->surface.level[dst_level].npix_x)
+		return FALSE;
+
+	dst_mode = rdst->surface.level[dst_level].mode;
+	src_mode = rsrc->surface.level[src_level].mode;
+	/* downcast linear aligned to linear to simplify test */
+	src_mode = src_mode == RADEON_SURF_MODE_LINEAR_ALIGNED ? RADEON_SURF_MODE_LINEAR : src_mode;
+	dst_mode = dst_mode == RADEON_SURF_MODE_LINEAR_ALIGNED ? RADEON_SURF_MODE_LINEAR : dst_mode;
+
+	if (src_mode != dst_mode) {
+		if (src_mode > RADEON_SURF_MODE_1D || dst_mode > RADEON_SURF_MODE_1D)
+			return FALSE;
+		/* The tiled side is addressed in whole 8x8 tiles. */
+		if ((src_pitch & 0x7) || (src_y & 0x7) || (dst_y & 0x7))
+			return FALSE;
+	} else if (src_mode != RADEON_SURF_MODE_LINEAR) {
+		return FALSE;
+	}
+
+	for (z = 0; z < src_box->depth; z++) {
+		if (src_mode == dst_mode) {
+			uint64_t dst_offset, src_offset;
+
+			src_offset = rsrc->surface.level[src_level].offset;
+			src_offset += rsrc->surface.level[src_level].slice_size * (src_box->z + z);
+			src_offset += src_y * src_pitch;
+			dst_offset = rdst->surface.level[dst_level].offset;
+			dst_offset += rdst->surface.level[dst_level].slice_size * (dst_z + z);
+			dst_offset += dst_y * dst_pitch;
+			si_dma_copy_buffer(rctx, dst, src, dst_offset, src_offset,
+					   copy_height * src_pitch);
+		} else {
+			si_dma_copy_tile(rctx, dst, dst_level, 0, dst_y, dst_z + z,
+					 src, src_level, 0, src_y, src_box->z + z,
+					 copy_height, dst_pitch, bpp);
+		}
+	}
+	return TRUE;
+}
@@ -33,6 +33,7 @@
 #include "util/u_upload_mgr.h"
 #include "util/u_format_s3tc.h"
 #include "tgsi/tgsi_parse.h"
+#include "tgsi/tgsi_scan.h"
 #include "radeonsi_pipe.h"
 #include "radeonsi_shader.h"
 #include "si_state.h"
@@ -1911,6 +1912,7 @@ int si_shader_select(struct pipe_context *ctx,
 		     struct si_pipe_shader_selector *sel,
 		     unsigned *dirty)
 {
+	struct r600_context *rctx = (struct r600_context *)ctx;
 	union si_shader_key key;
 	struct si_pipe_shader * shader = NULL;
 	int r;
@@ -1922,56 +1924,51 @@ int si_shader_select(struct pipe_context *ctx,
 	 * variants, it will cost just a computation of the key and this
 	 * test. */
 	if (likely(sel->current && memcmp(&sel->current->key, &key, sizeof(key)) == 0)) {
-		return 0;
-	}
-
-	/* lookup if we have other variants in the list */
-	if (sel->num_shaders > 1) {
-		struct si_pipe_shader *p = sel->current, *c = p->next_variant;
+		shader = sel->current;
+		if (likely(shader->status == SI_SHADER_READY))
+			return 0;
+	} else {
+		/* lookup if we have other variants in the list */
+		if (sel->num_shaders > 1) {
+			struct si_pipe_shader *p = sel->current, *c = p->next_variant;
 
-		while (c && memcmp(&c->key, &key, sizeof(key)) != 0) {
-			p = c;
-			c = c->next_variant;
-		}
+			while (c && memcmp(&c->key, &key, sizeof(key)) != 0) {
+				p = c;
+				c = c->next_variant;
+			}
 
-		if (c) {
-			p->next_variant = c->next_variant;
-			shader = c;
+			if (c) {
+				p->next_variant = c->next_variant;
+				shader = c;
+			}
 		}
-	}
 
-	if (unlikely(!shader)) {
-		shader = CALLOC(1, sizeof(struct si_pipe_shader));
-		shader->selector = sel;
-		shader->key = key;
-
-		r = si_pipe_shader_create(ctx, shader);
-		if (unlikely(r)) {
-			R600_ERR("Failed to build shader variant (type=%u) %d\n",
-				 sel->type, r);
-			sel->current = NULL;
-			FREE(shader);
-			return r;
+		if (unlikely(!shader)) {
+			shader = CALLOC(1, sizeof(struct si_pipe_shader));
+			shader->selector = sel;
+			shader->key = key;
+			sel->num_shaders++;
 		}
 
-		/* We don't know the value of fs_write_all property until we built
-		 * at least one variant, so we may need to recompute the key (include
-		 * rctx->framebuffer.nr_cbufs) after building first variant. */
-		if (sel->type == PIPE_SHADER_FRAGMENT &&
-		    sel->num_shaders == 0 &&
-		    shader->shader.fs_write_all) {
-			sel->fs_write_all = 1;
-			si_shader_selector_key(ctx, sel, &shader->key);
-		}
+		if (dirty)
+			*dirty = 1;
 
-		sel->num_shaders++;
+		shader->next_variant = sel->current;
+		sel->current = shader;
 	}
 
-	if (dirty)
-		*dirty = 1;
-
-	shader->next_variant = sel->current;
-	sel->current = shader;
+	/* Variants made at create time are normally compiled by the
+	 * shader queue by now.  Otherwise it's compiled here. */
+	r = si_shader_queue_finish(rctx, shader);
+	if (unlikely(r)) {
+		R600_ERR("Failed to build shader variant (type=%u) %d\n",
+			 sel->type, r);
+		sel->current = shader->next_variant;
+		sel->num_shaders--;
+		si_pipe_shader_destroy(ctx, shader);
+		FREE(shader);
+		return r;
+	}
 
 	return 0;
 }
@@ -1980,19 +1977,35 @@ static void *si_create_shader_state(struct pipe_context *ctx,
 				    const struct pipe_shader_state *state,
 				    unsigned pipe_shader_type)
 {
+	struct r600_context *rctx = (struct r600_context *)ctx;
 	struct si_pipe_shader_selector *sel = CALLOC_STRUCT(si_pipe_shader_selector);
-	int r;
+	struct si_pipe_shader *shader;
+	struct tgsi_shader_info info;
+	unsigned i;
 
 	sel->type = pipe_shader_type;
 	sel->tokens = tgsi_dup_tokens(state->tokens);
 	sel->so = state->stream_output;
 
-	r = si_shader_select(ctx, sel, NULL);
-	if (r) {
-	    free(sel);
-	    return NULL;
+	/* Whether the key includes nr_cbufs must be known before the first
+	 * variant is made. */
+	tgsi_scan_shader(sel->tokens, &info);
+	for (i = 0; i < info.num_properties; i++) {
+		if (info.properties[i].name ==
+		    TGSI_PROPERTY_FS_COLOR0_WRITES_ALL_CBUFS)
+			sel->fs_write_all = 1;
 	}
 
+	/* Start compiling the variant for the current state, so it's
+	 * likely to be ready by the time it's drawn with. */
+	shader = CALLOC(1, sizeof(struct si_pipe_shader));
+	shader->selector = sel;
+	si_shader_selector_key(ctx, sel, &shader->key);
+	sel->current = shader;
+	sel->num_shaders = 1;
+
+	si_shader_queue_add(rctx->screen->shader_queue, shader);
+
 	return sel;
 }
 
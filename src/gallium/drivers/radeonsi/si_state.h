@@ -133,6 +133,19 @@ union si_state {
 		} \
 	} while(0)
 
+/* Like si_pm4_set_state, but keeps the queued state if the new one is
+ * identical, so that it isn't emitted again.  Only for states that just
+ * set registers; draw packets and syncs must be emitted every time. */
+#define si_pm4_set_state_if_changed(rctx, member, value) \
+	do { \
+		if (si_pm4_state_equal((struct si_pm4_state *)(rctx)->queued.named.member, \
+				       (struct si_pm4_state *)(value))) { \
+			si_pm4_free_state(rctx, (struct si_pm4_state *)(value), ~0); \
+		} else { \
+			si_pm4_set_state(rctx, member, value); \
+		} \
+	} while(0)
+
 /* si_state.c */
 struct si_pipe_shader_selector;
 
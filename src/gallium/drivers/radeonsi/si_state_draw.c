@@ -321,7 +321,8 @@ static bool si_update_draw_info_state(struct r600_context *rctx,
 		       (vs->clip_dist_write ? 0 :
 			rctx->queued.named.rasterizer->clip_plane_enable & 0x3F));
 
-	si_pm4_set_state(rctx, draw_info, pm4);
+	/* Most draws in a row use the same values. */
+	si_pm4_set_state_if_changed(rctx, draw_info, pm4);
 	return true;
 }
 
@@ -379,7 +380,7 @@ bcolor:
 		}
 	}
 
-	si_pm4_set_state(rctx, spi, pm4);
+	si_pm4_set_state_if_changed(rctx, spi, pm4);
 }
 
 static void si_update_derived_state(struct r600_context *rctx)
@@ -674,6 +675,7 @@ void si_draw_vbo(struct pipe_context *ctx, const struct pipe_draw_info *info)
 
 	si_need_cs_space(rctx, 0, TRUE);
 
+	si_ib_timestamp_begin(rctx);
 	si_pm4_emit_dirty(rctx);
 	rctx->pm4_dirty_cdwords = 0;
 
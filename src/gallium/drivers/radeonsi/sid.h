@@ -37,8 +37,12 @@
 #define EVENT_TYPE_CACHE_FLUSH_AND_INV_TS_EVENT 0x14
 #define EVENT_TYPE_ZPASS_DONE                  0x15
 #define EVENT_TYPE_CACHE_FLUSH_AND_INV_EVENT   0x16
+#define EVENT_TYPE_PIPELINESTAT_START		0x19
+#define EVENT_TYPE_PIPELINESTAT_STOP		0x1a
+#define EVENT_TYPE_SAMPLE_PIPELINESTAT		0x1e
 #define EVENT_TYPE_SO_VGTSTREAMOUT_FLUSH	0x1f
 #define EVENT_TYPE_SAMPLE_STREAMOUTSTATS	0x20
+#define EVENT_TYPE_BOTTOM_OF_PIPE_TS		0x28
 #define		EVENT_TYPE(x)                           ((x) << 0)
 #define		EVENT_INDEX(x)                          ((x) << 8)
                 /* 0 - any non-TS event
@@ -131,6 +135,22 @@
 #define PKT0(index, count) (PKT_TYPE_S(0) | PKT0_BASE_INDEX_S(index) | PKT_COUNT_S(count))
 #define PKT3(op, count, predicate) (PKT_TYPE_S(3) | PKT3_IT_OPCODE_S(op) | PKT_COUNT_S(count) | PKT3_PREDICATE(predicate))
 
+/* async DMA packets */
+#define SI_DMA_PACKET(cmd, sub_cmd, n) ((((cmd) & 0xF) << 28) |    \
+                                       (((sub_cmd) & 0xFF) << 20) |\
+                                       (((n) & 0xFFFFF) << 0))
+/* async DMA Packet types */
+#define    SI_DMA_PACKET_WRITE                  0x2
+#define    SI_DMA_PACKET_COPY                   0x3
+#define    SI_DMA_PACKET_CONSTANT_FILL          0xd
+#define    SI_DMA_PACKET_NOP                    0xf
+/* copy sub commands */
+#define    SI_DMA_COPY_DWORD_ALIGNED            0x00
+#define    SI_DMA_COPY_BYTE_ALIGNED             0x40
+#define    SI_DMA_COPY_TILED                    0x8
+#define    SI_DMA_COPY_MAX_SIZE                 0xfffe0
+#define    SI_DMA_COPY_MAX_SIZE_DW              0xffff8
+
 #define R_0084FC_CP_STRMOUT_CNTL		                        0x0084FC
 #define   S_0084FC_OFFSET_UPDATE_DONE(x)		              (((x) & 0x1) << 0)
 #define R_0085F0_CP_COHER_CNTL                                          0x0085F0
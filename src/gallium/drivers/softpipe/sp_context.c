@@ -44,6 +44,7 @@
 #include "sp_context.h"
 #include "sp_flush.h"
 #include "sp_prim_vbuf.h"
+#include "sp_rast.h"
 #include "sp_state.h"
 #include "sp_surface.h"
 #include "sp_tile_cache.h"
@@ -75,24 +76,12 @@ softpipe_destroy( struct pipe_context *pipe )
    if (softpipe->draw)
       draw_destroy( softpipe->draw );
 
-   if (softpipe->quad.shade)
-      softpipe->quad.shade->destroy( softpipe->quad.shade );
-
-   if (softpipe->quad.depth_test)
-      softpipe->quad.depth_test->destroy( softpipe->quad.depth_test );
-
-   if (softpipe->quad.blend)
-      softpipe->quad.blend->destroy( softpipe->quad.blend );
-
-   if (softpipe->quad.pstipple)
-      softpipe->quad.pstipple->destroy( softpipe->quad.pstipple );
+   sp_destroy_rast_threads(softpipe);
 
    for (i = 0; i < PIPE_MAX_COLOR_BUFS; i++) {
-      sp_destroy_tile_cache(softpipe->cbuf_cache[i]);
       pipe_surface_reference(&softpipe->framebuffer.cbufs[i], NULL);
    }
 
-   sp_destroy_tile_cache(softpipe->zsbuf_cache);
    pipe_surface_reference(&softpipe->framebuffer.zsbuf, NULL);
 
    for (sh = 0; sh < Elements(softpipe->tex_cache); sh++) {
@@ -114,8 +103,6 @@ softpipe_destroy( struct pipe_context *pipe )
       pipe_resource_reference(&softpipe->vertex_buffer[i].buffer, NULL);
    }
 
-   tgsi_exec_machine_destroy(softpipe->fs_machine);
-
    for (i = 0; i < PIPE_SHADER_TYPES; i++) {
       FREE(softpipe->tgsi.sampler[i]);
    }
@@ -208,6 +195,9 @@ softpipe_create_context( struct pipe_screen *screen,
    softpipe->pipe.destroy = softpipe_destroy;
    softpipe->pipe.priv = priv;
 
+   softpipe->sample_mask = ~0;
+   softpipe->nr_samples = 1;
+
    /* state setters */
    softpipe_init_blend_funcs(&softpipe->pipe);
    softpipe_init_clip_funcs(&softpipe->pipe);
@@ -231,14 +221,6 @@ softpipe_create_context( struct pipe_screen *screen,
    softpipe->pipe.create_video_decoder = vl_create_decoder;
    softpipe->pipe.create_video_buffer = vl_video_buffer_create;
 
-   /*
-    * Alloc caches for accessing drawing surfaces and textures.
-    * Must be before quad stage setup!
-    */
-   for (i = 0; i < PIPE_MAX_COLOR_BUFS; i++)
-      softpipe->cbuf_cache[i] = sp_create_tile_cache( &softpipe->pipe );
-   softpipe->zsbuf_cache = sp_create_tile_cache( &softpipe->pipe );
-
    /* Allocate texture caches */
    for (sh = 0; sh < Elements(softpipe->tex_cache); sh++) {
       for (i = 0; i < Elements(softpipe->tex_cache[0]); i++) {
@@ -248,13 +230,9 @@ softpipe_create_context( struct pipe_screen *screen,
       }
    }
 
-   softpipe->fs_machine = tgsi_exec_machine_create();
-
-   /* setup quad rendering stages */
-   softpipe->quad.shade = sp_quad_shade_stage(softpipe);
-   softpipe->quad.depth_test = sp_quad_depth_test_stage(softpipe);
-   softpipe->quad.blend = sp_quad_blend_stage(softpipe);
-   softpipe->quad.pstipple = sp_quad_polygon_stipple_stage(softpipe);
+   /* setup surface caches and quad rendering stages */
+   if (!sp_create_rast_threads(softpipe))
+      goto fail;
 
 
    /*
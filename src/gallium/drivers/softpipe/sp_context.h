@@ -36,6 +36,7 @@
 
 #include "draw/draw_vertex.h"
 
+#include "sp_limits.h"
 #include "sp_quad_pipe.h"
 
 
@@ -47,6 +48,7 @@
 
 
 struct softpipe_vbuf_render;
+struct sp_rast_thread;
 struct draw_context;
 struct draw_stage;
 struct softpipe_tile_cache;
@@ -80,6 +82,7 @@ struct softpipe_context {
    struct pipe_framebuffer_state framebuffer;
    struct pipe_poly_stipple poly_stipple;
    struct pipe_scissor_state scissor;
+   unsigned sample_mask;
    struct pipe_sampler_view *sampler_views[PIPE_SHADER_TYPES][PIPE_MAX_SHADER_SAMPLER_VIEWS];
 
    struct pipe_viewport_state viewport;
@@ -108,6 +111,9 @@ struct softpipe_context {
    uint64_t occlusion_count;
    unsigned active_query_count;
 
+   /** Number of active SP_QUERY_x counter queries, see sp_rast_count_time() */
+   unsigned active_counter_queries;
+
    /** Mapped vertex buffers */
    ubyte *mapped_vbuffer[PIPE_MAX_ATTRIBS];
 
@@ -138,6 +144,9 @@ struct softpipe_context {
    /** Derived from scissor and surface bounds: */
    struct pipe_scissor_state cliprect;
 
+   /** Samples per pixel of the bound surfaces, 1 without multisampling */
+   unsigned nr_samples;
+
    unsigned line_stipple_counter;
 
    /** Conditional query object and mode */
@@ -152,22 +161,18 @@ struct softpipe_context {
       struct pipe_sampler_view *sampler_view;
    } pstipple;
 
-   /** Software quad rendering pipeline */
-   struct {
-      struct quad_stage *shade;
-      struct quad_stage *depth_test;
-      struct quad_stage *blend;
-      struct quad_stage *pstipple;
-      struct quad_stage *first; /**< points to one of the above stages */
-   } quad;
+   /**
+    * Rasterizer threads, each with its own setup, quad pipeline and
+    * drawing surface tile caches.  rast[0] runs on the application's thread.
+    */
+   struct sp_rast_thread *rast[SP_MAX_THREADS];
+   unsigned num_threads;
 
    /** TGSI exec things */
    struct {
       struct sp_tgsi_sampler *sampler[PIPE_SHADER_TYPES];
    } tgsi;
 
-   struct tgsi_exec_machine *fs_machine;
-
    /** The primitive drawing context */
    struct draw_context *draw;
 
@@ -179,9 +184,6 @@ struct softpipe_context {
 
    boolean dirty_render_cache;
 
-   struct softpipe_tile_cache *cbuf_cache[PIPE_MAX_COLOR_BUFS];
-   struct softpipe_tile_cache *zsbuf_cache;
-
    unsigned tex_timestamp;
 
    /*
@@ -35,6 +35,7 @@
 #include "draw/draw_context.h"
 #include "sp_flush.h"
 #include "sp_context.h"
+#include "sp_rast.h"
 #include "sp_state.h"
 #include "sp_tile_cache.h"
 #include "sp_tex_tile_cache.h"
@@ -48,7 +49,7 @@ softpipe_flush( struct pipe_context *pipe,
                 struct pipe_fence_handle **fence )
 {
    struct softpipe_context *softpipe = softpipe_context(pipe);
-   uint i;
+   uint i, t;
 
    draw_flush(softpipe->draw);
 
@@ -60,6 +61,13 @@ softpipe_flush( struct pipe_context *pipe,
             sp_flush_tex_tile_cache(softpipe->tex_cache[sh][i]);
          }
       }
+
+      for (t = 1; t < softpipe->num_threads; t++) {
+         for (i = 0; i < softpipe->num_sampler_views[PIPE_SHADER_FRAGMENT]; i++) {
+            if (softpipe->rast[t]->tex_cache[i])
+               sp_flush_tex_tile_cache(softpipe->rast[t]->tex_cache[i]);
+         }
+      }
    }
 
    /* If this is a swapbuffers, just flush color buffers.
@@ -67,12 +75,14 @@ softpipe_flush( struct pipe_context *pipe,
     * The zbuffer changes are not discarded, but held in the cache
     * in the hope that a later clear will wipe them out.
     */
-   for (i = 0; i < softpipe->framebuffer.nr_cbufs; i++)
-      if (softpipe->cbuf_cache[i])
-         sp_flush_tile_cache(softpipe->cbuf_cache[i]);
+   for (t = 0; t < softpipe->num_threads; t++) {
+      struct sp_rast_thread *thread = softpipe->rast[t];
 
-   if (softpipe->zsbuf_cache)
-      sp_flush_tile_cache(softpipe->zsbuf_cache);
+      for (i = 0; i < softpipe->framebuffer.nr_cbufs; i++)
+         sp_flush_tile_cache(thread->cbuf_cache[i]);
+
+      sp_flush_tile_cache(thread->zsbuf_cache);
+   }
 
    softpipe->dirty_render_cache = FALSE;
 
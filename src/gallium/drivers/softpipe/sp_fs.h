@@ -36,13 +36,23 @@ struct sp_fragment_shader_variant *
 softpipe_create_fs_variant_exec(struct softpipe_context *softpipe,
                                 const struct pipe_shader_state *templ);
 
+struct sp_fragment_shader_variant *
+softpipe_create_fs_variant_sse(struct softpipe_context *softpipe,
+                               const struct pipe_shader_state *templ);
+
 
 struct tgsi_interp_coef;
 struct tgsi_exec_vector;
+struct tgsi_exec_machine;
+struct quad_header;
 
 void sp_setup_pos_vector(const struct tgsi_interp_coef *coef,
 			 float x, float y,
 			 struct tgsi_exec_vector *quadpos);
 
+void sp_fs_store_outputs(const struct sp_fragment_shader_variant *var,
+                         const struct tgsi_exec_machine *machine,
+                         struct quad_header *quad);
+
 
 #endif
@@ -79,8 +79,8 @@ exec_prepare( const struct sp_fragment_shader_variant *var,
  *
  * This should really be part of the compiled shader.
  */
-static void
-setup_pos_vector(const struct tgsi_interp_coef *coef,
+void
+sp_setup_pos_vector(const struct tgsi_interp_coef *coef,
                  float x, float y,
                  struct tgsi_exec_vector *quadpos)
 {
@@ -110,6 +110,55 @@ setup_pos_vector(const struct tgsi_interp_coef *coef,
 }
 
 
+/**
+ * Copy the shader outputs from the machine to the quad.
+ */
+void
+sp_fs_store_outputs(const struct sp_fragment_shader_variant *var,
+                    const struct tgsi_exec_machine *machine,
+                    struct quad_header *quad)
+{
+   const ubyte *sem_name = var->info.output_semantic_name;
+   const ubyte *sem_index = var->info.output_semantic_index;
+   const uint n = var->info.num_outputs;
+   uint i;
+
+   for (i = 0; i < n; i++) {
+      switch (sem_name[i]) {
+      case TGSI_SEMANTIC_COLOR:
+         {
+            uint cbuf = sem_index[i];
+
+            assert(sizeof(quad->output.color[cbuf]) ==
+                   sizeof(machine->Outputs[i]));
+
+            /* copy float[4][4] result */
+            memcpy(quad->output.color[cbuf],
+                   &machine->Outputs[i],
+                   sizeof(quad->output.color[0]) );
+         }
+         break;
+      case TGSI_SEMANTIC_POSITION:
+         {
+            uint j;
+
+            for (j = 0; j < 4; j++)
+               quad->output.depth[j] = machine->Outputs[i].xyzw[2].f[j];
+         }
+         break;
+      case TGSI_SEMANTIC_STENCIL:
+         {
+            uint j;
+
+            for (j = 0; j < 4; j++)
+               quad->output.stencil[j] = (unsigned)machine->Outputs[i].xyzw[1].f[j];
+         }
+         break;
+      }
+   }
+}
+
+
 /* TODO: hide the machine struct in here somewhere, remove from this
  * interface:
  */
@@ -119,9 +168,9 @@ exec_run( const struct sp_fragment_shader_variant *var,
 	  struct quad_header *quad )
 {
    /* Compute X, Y, Z, W vals for this quad */
-   setup_pos_vector(quad->posCoef, 
-                    (float)quad->input.x0, (float)quad->input.y0, 
-                    &machine->QuadPos);
+   sp_setup_pos_vector(quad->posCoef, 
+                       (float)quad->input.x0, (float)quad->input.y0, 
+                       &machine->QuadPos);
 
    /* convert 0 to 1.0 and 1 to -1.0 */
    machine->Face = (float) (quad->input.facing * -2 + 1);
@@ -130,46 +179,7 @@ exec_run( const struct sp_fragment_shader_variant *var,
    if (quad->inout.mask == 0)
       return FALSE;
 
-   /* store outputs */
-   {
-      const ubyte *sem_name = var->info.output_semantic_name;
-      const ubyte *sem_index = var->info.output_semantic_index;
-      const uint n = var->info.num_outputs;
-      uint i;
-      for (i = 0; i < n; i++) {
-         switch (sem_name[i]) {
-         case TGSI_SEMANTIC_COLOR:
-            {
-               uint cbuf = sem_index[i];
-
-               assert(sizeof(quad->output.color[cbuf]) ==
-                      sizeof(machine->Outputs[i]));
-
-               /* copy float[4][4] result */
-               memcpy(quad->output.color[cbuf],
-                      &machine->Outputs[i],
-                      sizeof(quad->output.color[0]) );
-            }
-            break;
-         case TGSI_SEMANTIC_POSITION:
-            {
-               uint j;
-
-               for (j = 0; j < 4; j++)
-                  quad->output.depth[j] = machine->Outputs[i].xyzw[2].f[j];
-            }
-            break;
-         case TGSI_SEMANTIC_STENCIL:
-            {
-               uint j;
-
-               for (j = 0; j < 4; j++)
-                  quad->output.stencil[j] = (unsigned)machine->Outputs[i].xyzw[1].f[j];
-            }
-            break;
-         }
-      }
-   }
+   sp_fs_store_outputs(var, machine, quad);
 
    return TRUE;
 }
@@ -0,0 +1,173 @@
+/**************************************************************************
+ *
+ * Copyright 2013 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/**
+ * Execute fragment shader with x86-64 SSE2 code generated by rtasm.
+ *
+ * Only shaders without flow control are translated; the instructions the
+ * code generator doesn't handle are still run by the interpreter, on the
+ * same machine.  See tgsi_sse2.h.
+ */
+
+#include "sp_context.h"
+#include "sp_state.h"
+#include "sp_fs.h"
+#include "sp_quad.h"
+
+#include "pipe/p_config.h"
+
+
+#if defined(PIPE_ARCH_X86_64)
+
+#include "pipe/p_state.h"
+#include "pipe/p_defines.h"
+#include "util/u_memory.h"
+#include "tgsi/tgsi_exec.h"
+#include "tgsi/tgsi_sse2.h"
+#include "rtasm/rtasm_cpu.h"
+#include "rtasm/rtasm_x86sse.h"
+
+
+/**
+ * Subclass of sp_fragment_shader_variant
+ */
+struct sp_sse_fragment_shader
+{
+   struct sp_fragment_shader_variant base;
+   struct x86_function sse2_program;
+   tgsi_sse2_func func;
+};
+
+
+/** cast wrapper */
+static INLINE struct sp_sse_fragment_shader *
+sp_sse_fragment_shader(const struct sp_fragment_shader_variant *var)
+{
+   return (struct sp_sse_fragment_shader *) var;
+}
+
+
+static void
+fs_sse_prepare( const struct sp_fragment_shader_variant *var,
+                struct tgsi_exec_machine *machine,
+                struct tgsi_sampler *sampler )
+{
+   /*
+    * The generated code keeps the registers in the interpreter's machine
+    * and calls back into it, so bind the shader there as well.
+    */
+   tgsi_exec_machine_bind_shader(machine,
+                                 var->tokens,
+                                 sampler);
+}
+
+
+static unsigned
+fs_sse_run( const struct sp_fragment_shader_variant *var,
+            struct tgsi_exec_machine *machine,
+            struct quad_header *quad )
+{
+   struct sp_sse_fragment_shader *shader = sp_sse_fragment_shader(var);
+
+   /* Compute X, Y, Z, W vals for this quad */
+   sp_setup_pos_vector(quad->posCoef,
+                       (float)quad->input.x0, (float)quad->input.y0,
+                       &machine->QuadPos);
+
+   /* convert 0 to 1.0 and 1 to -1.0 */
+   machine->Face = (float) (quad->input.facing * -2 + 1);
+
+   quad->inout.mask &= tgsi_sse2_run(machine, shader->func);
+   if (quad->inout.mask == 0)
+      return FALSE;
+
+   sp_fs_store_outputs(var, machine, quad);
+
+   return TRUE;
+}
+
+
+static void
+fs_sse_delete(struct sp_fragment_shader_variant *var,
+              struct tgsi_exec_machine *machine)
+{
+   struct sp_sse_fragment_shader *shader = sp_sse_fragment_shader(var);
+
+   if (machine->Tokens == var->tokens) {
+      tgsi_exec_machine_bind_shader(machine, NULL, NULL);
+   }
+
+   x86_release_func( &shader->sse2_program );
+   FREE( (void *) var->tokens );
+   FREE(shader);
+}
+
+
+/**
+ * \return NULL if the CPU/shader can't be handled, in which case the
+ *         interpreter variant should be used
+ */
+struct sp_fragment_shader_variant *
+softpipe_create_fs_variant_sse(struct softpipe_context *softpipe,
+                               const struct pipe_shader_state *templ)
+{
+   struct sp_sse_fragment_shader *shader;
+
+   if (!rtasm_cpu_has_sse2())
+      return NULL;
+
+   shader = CALLOC_STRUCT(sp_sse_fragment_shader);
+   if (!shader)
+      return NULL;
+
+   if (!tgsi_emit_sse2(templ->tokens, &shader->sse2_program)) {
+      FREE(shader);
+      return NULL;
+   }
+
+   shader->func = (tgsi_sse2_func) x86_get_func( &shader->sse2_program );
+
+   shader->base.prepare = fs_sse_prepare;
+   shader->base.run = fs_sse_run;
+   shader->base.delete = fs_sse_delete;
+
+   return &shader->base;
+}
+
+
+#else /* !PIPE_ARCH_X86_64 */
+
+
+struct sp_fragment_shader_variant *
+softpipe_create_fs_variant_sse(struct softpipe_context *softpipe,
+                               const struct pipe_shader_state *templ)
+{
+   return NULL;
+}
+
+
+#endif /* PIPE_ARCH_X86_64 */
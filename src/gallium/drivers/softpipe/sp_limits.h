@@ -39,5 +39,11 @@
 #define MAX_WIDTH (1 << (SP_MAX_TEXTURE_2D_LEVELS - 1))
 #define MAX_HEIGHT (1 << (SP_MAX_TEXTURE_2D_LEVELS - 1))
 
+/** Max number of rasterizer threads, including the application's */
+#define SP_MAX_THREADS 8
+
+/** Samples per pixel of multisample surfaces, the only count supported */
+#define SP_MAX_SAMPLES 4
+
 
 #endif /* SP_LIMITS_H */
@@ -37,6 +37,7 @@
 
 
 #include "sp_context.h"
+#include "sp_rast.h"
 #include "sp_setup.h"
 #include "sp_state.h"
 #include "sp_prim_vbuf.h"
@@ -58,7 +59,6 @@ struct softpipe_vbuf_render
 {
    struct vbuf_render base;
    struct softpipe_context *softpipe;
-   struct setup_context *setup;
 
    uint prim;
    uint vertex_size;
@@ -68,6 +68,18 @@ struct softpipe_vbuf_render
 };
 
 
+/**
+ * A draw_elements/draw_arrays call, as run by each rasterizer thread.
+ */
+struct sp_vbuf_draw_job
+{
+   struct softpipe_vbuf_render *cvbr;
+   const ushort *indices;
+   uint start;
+   uint nr;
+};
+
+
 /** cast wrapper */
 static struct softpipe_vbuf_render *
 softpipe_vbuf_render(struct vbuf_render *vbr)
@@ -136,9 +148,11 @@ static void
 sp_vbuf_set_primitive(struct vbuf_render *vbr, unsigned prim)
 {
    struct softpipe_vbuf_render *cvbr = softpipe_vbuf_render(vbr);
-   struct setup_context *setup_ctx = cvbr->setup;
-   
-   sp_setup_prepare( setup_ctx );
+   unsigned i;
+
+   /* the first one validates state, which may change num_threads */
+   for (i = 0; i < cvbr->softpipe->num_threads; i++)
+      sp_setup_prepare( cvbr->softpipe->rast[i]->setup );
 
    cvbr->softpipe->reduced_prim = u_reduced_prim(prim);
    cvbr->prim = prim;
@@ -157,14 +171,17 @@ static INLINE cptrf4 get_vert( const void *vertex_buffer,
  * draw elements / indexed primitives
  */
 static void
-sp_vbuf_draw_elements(struct vbuf_render *vbr, const ushort *indices, uint nr)
+draw_elements_job(struct sp_rast_thread *thread, void *data)
 {
-   struct softpipe_vbuf_render *cvbr = softpipe_vbuf_render(vbr);
+   const struct sp_vbuf_draw_job *job = (const struct sp_vbuf_draw_job *) data;
+   struct softpipe_vbuf_render *cvbr = job->cvbr;
    struct softpipe_context *softpipe = cvbr->softpipe;
    const unsigned stride = softpipe->vertex_info_vbuf.size * sizeof(float);
    const void *vertex_buffer = cvbr->vertex_buffer;
-   struct setup_context *setup = cvbr->setup;
+   struct setup_context *setup = thread->setup;
    const boolean flatshade_first = softpipe->rasterizer->flatshade_first;
+   const ushort *indices = job->indices;
+   const uint nr = job->nr;
    unsigned i;
 
    switch (cvbr->prim) {
@@ -348,20 +365,36 @@ sp_vbuf_draw_elements(struct vbuf_render *vbr, const ushort *indices, uint nr)
 }
 
 
+static void
+sp_vbuf_draw_elements(struct vbuf_render *vbr, const ushort *indices, uint nr)
+{
+   struct sp_vbuf_draw_job job;
+
+   job.cvbr = softpipe_vbuf_render(vbr);
+   job.indices = indices;
+   job.start = 0;
+   job.nr = nr;
+
+   sp_rast_run(job.cvbr->softpipe, draw_elements_job, &job);
+}
+
+
 /**
  * This function is hit when the draw module is working in pass-through mode.
  * It's up to us to convert the vertex array into point/line/tri prims.
  */
 static void
-sp_vbuf_draw_arrays(struct vbuf_render *vbr, uint start, uint nr)
+draw_arrays_job(struct sp_rast_thread *thread, void *data)
 {
-   struct softpipe_vbuf_render *cvbr = softpipe_vbuf_render(vbr);
+   const struct sp_vbuf_draw_job *job = (const struct sp_vbuf_draw_job *) data;
+   struct softpipe_vbuf_render *cvbr = job->cvbr;
    struct softpipe_context *softpipe = cvbr->softpipe;
-   struct setup_context *setup = cvbr->setup;
+   struct setup_context *setup = thread->setup;
    const unsigned stride = softpipe->vertex_info_vbuf.size * sizeof(float);
    const void *vertex_buffer =
-      (void *) get_vert(cvbr->vertex_buffer, start, stride);
+      (void *) get_vert(cvbr->vertex_buffer, job->start, stride);
    const boolean flatshade_first = softpipe->rasterizer->flatshade_first;
+   const uint nr = job->nr;
    unsigned i;
 
    switch (cvbr->prim) {
@@ -587,6 +620,20 @@ sp_vbuf_draw_arrays(struct vbuf_render *vbr, uint start, uint nr)
    }
 }
 
+
+static void
+sp_vbuf_draw_arrays(struct vbuf_render *vbr, uint start, uint nr)
+{
+   struct sp_vbuf_draw_job job;
+
+   job.cvbr = softpipe_vbuf_render(vbr);
+   job.indices = NULL;
+   job.start = start;
+   job.nr = nr;
+
+   sp_rast_run(job.cvbr->softpipe, draw_arrays_job, &job);
+}
+
 static void
 sp_vbuf_so_info(struct vbuf_render *vbr, uint primitives, uint vertices,
                 uint prim_generated)
@@ -629,7 +676,6 @@ sp_vbuf_destroy(struct vbuf_render *vbr)
    struct softpipe_vbuf_render *cvbr = softpipe_vbuf_render(vbr);
    if (cvbr->vertex_buffer)
       align_free(cvbr->vertex_buffer);
-   sp_setup_destroy_context(cvbr->setup);
    FREE(cvbr);
 }
 
@@ -661,7 +707,5 @@ sp_create_vbuf_backend(struct softpipe_context *sp)
 
    cvbr->softpipe = sp;
 
-   cvbr->setup = sp_setup_create_context(cvbr->softpipe);
-
    return &cvbr->base;
 }
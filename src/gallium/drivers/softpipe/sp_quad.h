@@ -33,6 +33,7 @@
 
 #include "pipe/p_state.h"
 #include "tgsi/tgsi_exec.h"
+#include "sp_limits.h"
 
 
 #define QUAD_PRIM_POINT 1
@@ -56,6 +57,14 @@
 #define MASK_ALL          0xf
 
 
+/**
+ * Positions of the samples in a pixel of a multisample surface, the usual
+ * rotated grid.  Sample s of pixel (x, y) is at (x + pos[s][0], y + pos[s][1])
+ * with the pixel centre at (x + 0.5, y + 0.5).
+ */
+extern const float sp_sample_positions[SP_MAX_SAMPLES][2];
+
+
 /**
  * Quad stage inputs (pos, coverage, front/back face, etc)
  */
@@ -74,6 +83,12 @@ struct quad_header_input
 struct quad_header_inout
 {
    unsigned mask:4;
+   /**
+    * The samples covered when multisampling: bit 4 * s + j for sample s of
+    * pixel j.  Only those of the pixels in mask count, so a quad whose
+    * pixels are fully covered can just set all of them.
+    */
+   unsigned coverage:16;
 };
 
 
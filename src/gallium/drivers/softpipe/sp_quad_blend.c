@@ -35,11 +35,13 @@
 #include "util/u_memory.h"
 #include "util/u_format.h"
 #include "util/u_dual_blend.h"
+#include "util/u_sse.h"
 #include "sp_context.h"
 #include "sp_state.h"
 #include "sp_quad.h"
 #include "sp_tile_cache.h"
 #include "sp_quad_pipe.h"
+#include "sp_rast.h"
 
 
 enum format
@@ -59,6 +61,9 @@ struct blend_quad_stage
    boolean clamp[PIPE_MAX_COLOR_BUFS];  /**< clamp colors to [0,1]? */
    enum format base_format[PIPE_MAX_COLOR_BUFS];
    enum util_format_type format_type[PIPE_MAX_COLOR_BUFS];
+   /** for multisample surfaces, what blend_msaa() runs for each sample */
+   void (*run_sample)(struct quad_stage *qs,
+                      struct quad_header *quads[], unsigned nr);
 };
 
 
@@ -146,6 +151,63 @@ do { \
 
 
 
+#if defined(PIPE_ARCH_SSE)
+
+/**
+ * float_to_ubyte() on four floats, giving four ints.
+ */
+static INLINE __m128i
+float4_to_ubyte4(__m128 f)
+{
+   const __m128i bits = _mm_castps_si128(f);
+   const __m128i negative = _mm_cmplt_epi32(bits, _mm_setzero_si128());
+   const __m128i one_or_more = _mm_cmpgt_epi32(bits, _mm_set1_epi32(0x3f7fffff));
+   __m128i ub;
+
+   ub = _mm_castps_si128(_mm_add_ps(_mm_mul_ps(f, _mm_set1_ps(255.0f/256.0f)),
+                                    _mm_set1_ps(32768.0f)));
+   ub = _mm_and_si128(_mm_or_si128(ub, one_or_more), _mm_set1_epi32(0xff));
+   return _mm_andnot_si128(negative, ub);
+}
+
+
+/**
+ * The logic op, all channels of the quad at once.  Bit i of the
+ * PIPE_LOGICOP_x value is the result for the source and destination bits
+ * (i >> 1, i & 1) negated, so the op is the OR of the four minterms it
+ * selects.
+ */
+static void
+logicop_quad(struct quad_stage *qs, 
+             float (*quadColor)[4],
+             float (*dest)[4])
+{
+   const unsigned func = qs->softpipe->blend->logicop_func;
+   const __m128i m_sd = _mm_set1_epi32(-(int) ((func >> 3) & 1));
+   const __m128i m_s = _mm_set1_epi32(-(int) ((func >> 2) & 1));
+   const __m128i m_d = _mm_set1_epi32(-(int) ((func >> 1) & 1));
+   const __m128i m_none = _mm_set1_epi32(-(int) (func & 1));
+   const __m128 scale = _mm_set1_ps(1.0f / 255.0f);
+   uint j;
+
+   for (j = 0; j < 4; j++) { /* loop over R,G,B,A channels */
+      const __m128i src = float4_to_ubyte4(_mm_loadu_ps(quadColor[j]));
+      const __m128i dst = float4_to_ubyte4(_mm_loadu_ps(dest[j]));
+      __m128i res;
+
+      res = _mm_or_si128(
+               _mm_or_si128(_mm_and_si128(m_sd, _mm_and_si128(src, dst)),
+                            _mm_and_si128(m_s, _mm_andnot_si128(dst, src))),
+               _mm_or_si128(_mm_and_si128(m_d, _mm_andnot_si128(src, dst)),
+                            _mm_andnot_si128(_mm_or_si128(src, dst), m_none)));
+      res = _mm_and_si128(res, _mm_set1_epi32(0xff));
+
+      _mm_storeu_ps(quadColor[j], _mm_mul_ps(_mm_cvtepi32_ps(res), scale));
+   }
+}
+
+#else /* !PIPE_ARCH_SSE */
+
 static void
 logicop_quad(struct quad_stage *qs, 
              float (*quadColor)[4],
@@ -249,6 +311,8 @@ logicop_quad(struct quad_stage *qs,
    }
 }
 
+#endif /* !PIPE_ARCH_SSE */
+
 
 
 /**
@@ -858,6 +922,17 @@ colormask_quad(unsigned colormask,
 static void
 clamp_colors(float (*quadColor)[4])
 {
+#if defined(PIPE_ARCH_SSE)
+   const __m128 zero = _mm_setzero_ps();
+   const __m128 one = _mm_set1_ps(1.0f);
+   unsigned i;
+
+   for (i = 0; i < 4; i++) {
+      /* operands in this order keep NaNs, like CLAMP() */
+      __m128 c = _mm_max_ps(zero, _mm_loadu_ps(quadColor[i]));
+      _mm_storeu_ps(quadColor[i], _mm_min_ps(one, c));
+   }
+#else
    unsigned i, j;
 
    for (j = 0; j < TGSI_QUAD_SIZE; j++) {
@@ -865,6 +940,7 @@ clamp_colors(float (*quadColor)[4])
          quadColor[i][j] = CLAMP(quadColor[i][j], 0.0F, 1.0F);
       }
    }
+#endif
 }
 
 
@@ -914,6 +990,116 @@ rebase_colors(enum format base_format, float (*quadColor)[4])
    }
 }
 
+/**
+ * Get the colors of a quad's pixels from a color tile.
+ * \param x, y  position of the quad in the tile
+ */
+static INLINE void
+get_quad_dest(const struct softpipe_tile_cache *tc,
+              const struct softpipe_cached_tile *tile,
+              int x, int y, float dest[4][TGSI_QUAD_SIZE])
+{
+   uint i, j;
+
+   switch (tc->layout) {
+   case SP_TILE_UNORM8:
+      for (j = 0; j < TGSI_QUAD_SIZE; j++) {
+         const ubyte *p =
+            (const ubyte *) &tile->data.color32[y + (j >> 1)][x + (j & 1)];
+         for (i = 0; i < 4; i++) {
+            const ubyte swz = tc->swizzle[i];
+            if (swz < 4)
+               dest[i][j] = ubyte_to_float(p[swz]);
+            else
+               dest[i][j] = swz == UTIL_FORMAT_SWIZZLE_1 ? 1.0f : 0.0f;
+         }
+      }
+      break;
+   case SP_TILE_PACKED:
+      {
+         const unsigned cpp = tc->cpp;
+         float rgba[TGSI_QUAD_SIZE][4];
+
+         tc->format_desc->unpack_rgba_float(&rgba[0][0], 2 * sizeof(rgba[0]),
+                                            tile->data.any +
+                                            (y * TILE_SIZE + x) * cpp,
+                                            TILE_SIZE * cpp, 2, 2);
+         for (j = 0; j < TGSI_QUAD_SIZE; j++) {
+            for (i = 0; i < 4; i++) {
+               dest[i][j] = rgba[j][i];
+            }
+         }
+      }
+      break;
+   default:
+      for (j = 0; j < TGSI_QUAD_SIZE; j++) {
+         for (i = 0; i < 4; i++) {
+            dest[i][j] = tile->data.color[y + (j >> 1)][x + (j & 1)][i];
+         }
+      }
+   }
+}
+
+
+/**
+ * Write the colors of a quad's pixels in mask to a color tile.
+ * \param x, y  position of the quad in the tile
+ */
+static INLINE void
+put_quad_color(const struct softpipe_tile_cache *tc,
+               struct softpipe_cached_tile *tile,
+               int x, int y, float (*quadColor)[4], unsigned mask)
+{
+   uint i, j;
+
+   switch (tc->layout) {
+   case SP_TILE_UNORM8:
+      for (j = 0; j < TGSI_QUAD_SIZE; j++) {
+         if (mask & (1 << j)) {
+            ubyte *p =
+               (ubyte *) &tile->data.color32[y + (j >> 1)][x + (j & 1)];
+            for (i = 0; i < 4; i++) {
+               const ubyte chan = tc->unswizzle[i];
+               p[i] = chan < 4 ? float_to_ubyte(quadColor[chan][j]) : 0;
+            }
+         }
+      }
+      break;
+   case SP_TILE_PACKED:
+      {
+         const unsigned cpp = tc->cpp;
+         float rgba[TGSI_QUAD_SIZE][4];
+         ubyte packed[TGSI_QUAD_SIZE * 8];
+
+         for (j = 0; j < TGSI_QUAD_SIZE; j++) {
+            for (i = 0; i < 4; i++) {
+               rgba[j][i] = quadColor[i][j];
+            }
+         }
+         tc->format_desc->pack_rgba_float(packed, 2 * cpp,
+                                          &rgba[0][0], 2 * sizeof(rgba[0]),
+                                          2, 2);
+         for (j = 0; j < TGSI_QUAD_SIZE; j++) {
+            if (mask & (1 << j)) {
+               memcpy(tile->data.any +
+                      ((y + (j >> 1)) * TILE_SIZE + x + (j & 1)) * cpp,
+                      packed + j * cpp, cpp);
+            }
+         }
+      }
+      break;
+   default:
+      for (j = 0; j < TGSI_QUAD_SIZE; j++) {
+         if (mask & (1 << j)) {
+            for (i = 0; i < 4; i++) { /* loop over color chans */
+               tile->data.color[y + (j >> 1)][x + (j & 1)][i] = quadColor[i][j];
+            }
+         }
+      }
+   }
+}
+
+
 static void
 blend_fallback(struct quad_stage *qs, 
                struct quad_header *quads[],
@@ -932,8 +1118,9 @@ blend_fallback(struct quad_stage *qs,
       /* which blend/mask state index to use: */
       const uint blend_buf = blend->independent_blend_enable ? cbuf : 0;
       float dest[4][TGSI_QUAD_SIZE];
+      struct softpipe_tile_cache *tc = qs->thread->cbuf_cache[cbuf];
       struct softpipe_cached_tile *tile
-         = sp_get_cached_tile(softpipe->cbuf_cache[cbuf],
+         = sp_get_cached_tile(tc,
                               quads[0]->input.x0, 
                               quads[0]->input.y0);
       const boolean clamp = bqs->clamp[cbuf];
@@ -974,15 +1161,8 @@ blend_fallback(struct quad_stage *qs,
             clamp_colors(quadColor);
          }
 
-         /* get/swizzle dest colors
-          */
-         for (j = 0; j < TGSI_QUAD_SIZE; j++) {
-            int x = itx + (j & 1);
-            int y = ity + (j >> 1);
-            for (i = 0; i < 4; i++) {
-               dest[i][j] = tile->data.color[y][x][i];
-            }
-         }
+         /* get/swizzle dest colors */
+         get_quad_dest(tc, tile, itx, ity, dest);
 
 
          if (blend->logicop_enable) {
@@ -1008,108 +1188,116 @@ blend_fallback(struct quad_stage *qs,
    
          /* Output color values
           */
-         for (j = 0; j < TGSI_QUAD_SIZE; j++) {
-            if (quad->inout.mask & (1 << j)) {
-               int x = itx + (j & 1);
-               int y = ity + (j >> 1);
-               for (i = 0; i < 4; i++) { /* loop over color chans */
-                  tile->data.color[y][x][i] = quadColor[i][j];
-               }
-            }
-         }
+         put_quad_color(tc, tile, itx, ity, quadColor, quad->inout.mask);
       }
    }
 }
 
 
-static void
-blend_single_add_src_alpha_inv_src_alpha(struct quad_stage *qs, 
-                                         struct quad_header *quads[],
-                                         unsigned nr)
+/**
+ * The blend equations handled by the single color buffer fast paths.
+ * All use PIPE_BLEND_ADD and the same factors for RGB and alpha.
+ */
+enum blend_single_mode
 {
-   const struct blend_quad_stage *bqs = blend_quad_stage(qs);
-   static const float one[4] = { 1, 1, 1, 1 };
-   float one_minus_alpha[TGSI_QUAD_SIZE];
-   float dest[4][TGSI_QUAD_SIZE];
-   float source[4][TGSI_QUAD_SIZE];
-   uint i, j, q;
-
-   struct softpipe_cached_tile *tile
-      = sp_get_cached_tile(qs->softpipe->cbuf_cache[0],
-                           quads[0]->input.x0, 
-                           quads[0]->input.y0);
+   BLEND_SINGLE_COPY,        /**< blending disabled */
+   BLEND_SINGLE_ONE_ONE,     /**< additive */
+   BLEND_SINGLE_SRC_ALPHA,   /**< SRC_ALPHA, INV_SRC_ALPHA */
+   BLEND_SINGLE_PREMULT      /**< ONE, INV_SRC_ALPHA (premultiplied alpha) */
+};
 
-   for (q = 0; q < nr; q++) {
-      struct quad_header *quad = quads[q];
-      float (*quadColor)[4] = quad->output.color[0];
-      const float *alpha = quadColor[3];
-      const int itx = (quad->input.x0 & (TILE_SIZE-1));
-      const int ity = (quad->input.y0 & (TILE_SIZE-1));
-      
-      /* get/swizzle dest colors */
-      for (j = 0; j < TGSI_QUAD_SIZE; j++) {
-         int x = itx + (j & 1);
-         int y = ity + (j >> 1);
-         for (i = 0; i < 4; i++) {
-            dest[i][j] = tile->data.color[y][x][i];
-         }
-      }
 
-      /* If fixed-point dest color buffer, need to clamp the incoming
-       * fragment colors now.
-       */
-      if (bqs->clamp[0] || qs->softpipe->rasterizer->clamp_fragment_color) {
-         clamp_colors(quadColor);
-      }
+/**
+ * Blend a quad with one of the fixed equations, doing the same operations
+ * as blend_quad() would.
+ */
+static INLINE void
+blend_single_quad(enum blend_single_mode mode,
+                  float (*quadColor)[4],
+                  float (*dest)[4])
+{
+#if defined(PIPE_ARCH_SSE)
+   const __m128 alpha = _mm_loadu_ps(quadColor[3]);
+   const __m128 one_minus_alpha = _mm_sub_ps(_mm_set1_ps(1.0f), alpha);
+   unsigned i;
 
-      VEC4_MUL(source[0], quadColor[0], alpha); /* R */
-      VEC4_MUL(source[1], quadColor[1], alpha); /* G */
-      VEC4_MUL(source[2], quadColor[2], alpha); /* B */
-      VEC4_MUL(source[3], quadColor[3], alpha); /* A */
-
-      VEC4_SUB(one_minus_alpha, one, alpha);
-      VEC4_MUL(dest[0], dest[0], one_minus_alpha); /* R */
-      VEC4_MUL(dest[1], dest[1], one_minus_alpha); /* G */
-      VEC4_MUL(dest[2], dest[2], one_minus_alpha); /* B */
-      VEC4_MUL(dest[3], dest[3], one_minus_alpha); /* A */
-
-      VEC4_ADD(quadColor[0], source[0], dest[0]); /* R */
-      VEC4_ADD(quadColor[1], source[1], dest[1]); /* G */
-      VEC4_ADD(quadColor[2], source[2], dest[2]); /* B */
-      VEC4_ADD(quadColor[3], source[3], dest[3]); /* A */
-
-      /* If fixed-point dest color buffer, need to clamp the outgoing
-       * fragment colors now.
-       */
-      if (bqs->clamp[0]) {
-         clamp_colors(quadColor);
+   for (i = 0; i < 4; i++) {
+      __m128 src = _mm_loadu_ps(quadColor[i]);
+      __m128 dst = _mm_loadu_ps(dest[i]);
+
+      switch (mode) {
+      case BLEND_SINGLE_ONE_ONE:
+         src = _mm_add_ps(src, dst);
+         break;
+      case BLEND_SINGLE_SRC_ALPHA:
+         src = _mm_add_ps(_mm_mul_ps(src, alpha),
+                          _mm_mul_ps(dst, one_minus_alpha));
+         break;
+      case BLEND_SINGLE_PREMULT:
+         src = _mm_add_ps(src, _mm_mul_ps(dst, one_minus_alpha));
+         break;
+      default:
+         break;
       }
 
-      rebase_colors(bqs->base_format[0], quadColor);
+      _mm_storeu_ps(quadColor[i], src);
+   }
+#else
+   static const float one[4] = { 1, 1, 1, 1 };
+   float alpha[TGSI_QUAD_SIZE];
+   float one_minus_alpha[TGSI_QUAD_SIZE];
+   unsigned i;
 
-      for (j = 0; j < TGSI_QUAD_SIZE; j++) {
-         if (quad->inout.mask & (1 << j)) {
-            int x = itx + (j & 1);
-            int y = ity + (j >> 1);
-            for (i = 0; i < 4; i++) { /* loop over color chans */
-               tile->data.color[y][x][i] = quadColor[i][j];
-            }
-         }
+   VEC4_COPY(alpha, quadColor[3]);
+   VEC4_SUB(one_minus_alpha, one, alpha);
+
+   for (i = 0; i < 4; i++) {
+      switch (mode) {
+      case BLEND_SINGLE_ONE_ONE:
+         VEC4_ADD(quadColor[i], quadColor[i], dest[i]);
+         break;
+      case BLEND_SINGLE_SRC_ALPHA:
+         VEC4_MUL(quadColor[i], quadColor[i], alpha);
+         VEC4_MUL(dest[i], dest[i], one_minus_alpha);
+         VEC4_ADD(quadColor[i], quadColor[i], dest[i]);
+         break;
+      case BLEND_SINGLE_PREMULT:
+         VEC4_MUL(dest[i], dest[i], one_minus_alpha);
+         VEC4_ADD(quadColor[i], quadColor[i], dest[i]);
+         break;
+      default:
+         break;
       }
    }
+#endif
 }
 
-static void
-blend_single_add_one_one(struct quad_stage *qs, 
-                         struct quad_header *quads[],
-                         unsigned nr)
+
+/**
+ * Blend and write a batch of quads to the only color buffer, which has
+ * its colormask all set.  Always inlined with a constant mode, so each
+ * of the wrappers below gets its own straight-line loop.
+ */
+static INLINE void
+blend_single(struct quad_stage *qs,
+             struct quad_header *quads[],
+             unsigned nr,
+             enum blend_single_mode mode)
 {
    const struct blend_quad_stage *bqs = blend_quad_stage(qs);
+   /* If fixed-point dest color buffer, need to clamp the incoming and
+    * outgoing fragment colors when blending.  Without blending, clamping
+    * will be done, if needed, when we write/pack the colors later.
+    */
+   const boolean clamp = mode != BLEND_SINGLE_COPY && bqs->clamp[0];
+   const boolean clamp_in =
+      clamp || qs->softpipe->rasterizer->clamp_fragment_color;
    float dest[4][TGSI_QUAD_SIZE];
-   uint i, j, q;
+   uint q;
 
+   struct softpipe_tile_cache *tc = qs->thread->cbuf_cache[0];
    struct softpipe_cached_tile *tile
-      = sp_get_cached_tile(qs->softpipe->cbuf_cache[0],
+      = sp_get_cached_tile(tc,
                            quads[0]->input.x0, 
                            quads[0]->input.y0);
 
@@ -1118,90 +1306,64 @@ blend_single_add_one_one(struct quad_stage *qs,
       float (*quadColor)[4] = quad->output.color[0];
       const int itx = (quad->input.x0 & (TILE_SIZE-1));
       const int ity = (quad->input.y0 & (TILE_SIZE-1));
-      
-      /* get/swizzle dest colors */
-      for (j = 0; j < TGSI_QUAD_SIZE; j++) {
-         int x = itx + (j & 1);
-         int y = ity + (j >> 1);
-         for (i = 0; i < 4; i++) {
-            dest[i][j] = tile->data.color[y][x][i];
-         }
-      }
-     
-      /* If fixed-point dest color buffer, need to clamp the incoming
-       * fragment colors now.
-       */
-      if (bqs->clamp[0] || qs->softpipe->rasterizer->clamp_fragment_color) {
+
+      if (clamp_in)
          clamp_colors(quadColor);
-      }
 
-      VEC4_ADD(quadColor[0], quadColor[0], dest[0]); /* R */
-      VEC4_ADD(quadColor[1], quadColor[1], dest[1]); /* G */
-      VEC4_ADD(quadColor[2], quadColor[2], dest[2]); /* B */
-      VEC4_ADD(quadColor[3], quadColor[3], dest[3]); /* A */
+      if (mode != BLEND_SINGLE_COPY) {
+         /* get/swizzle dest colors */
+         get_quad_dest(tc, tile, itx, ity, dest);
 
-      /* If fixed-point dest color buffer, need to clamp the outgoing
-       * fragment colors now.
-       */
-      if (bqs->clamp[0]) {
-         clamp_colors(quadColor);
+         blend_single_quad(mode, quadColor, dest);
+
+         if (clamp)
+            clamp_colors(quadColor);
       }
 
       rebase_colors(bqs->base_format[0], quadColor);
 
-      for (j = 0; j < TGSI_QUAD_SIZE; j++) {
-         if (quad->inout.mask & (1 << j)) {
-            int x = itx + (j & 1);
-            int y = ity + (j >> 1);
-            for (i = 0; i < 4; i++) { /* loop over color chans */
-               tile->data.color[y][x][i] = quadColor[i][j];
-            }
-         }
-      }
+      put_quad_color(tc, tile, itx, ity, quadColor, quad->inout.mask);
    }
 }
 
 
+static void
+blend_single_add_src_alpha_inv_src_alpha(struct quad_stage *qs, 
+                                         struct quad_header *quads[],
+                                         unsigned nr)
+{
+   blend_single(qs, quads, nr, BLEND_SINGLE_SRC_ALPHA);
+}
+
+
+static void
+blend_single_add_one_inv_src_alpha(struct quad_stage *qs, 
+                                   struct quad_header *quads[],
+                                   unsigned nr)
+{
+   blend_single(qs, quads, nr, BLEND_SINGLE_PREMULT);
+}
+
+
+static void
+blend_single_add_one_one(struct quad_stage *qs, 
+                         struct quad_header *quads[],
+                         unsigned nr)
+{
+   blend_single(qs, quads, nr, BLEND_SINGLE_ONE_ONE);
+}
+
+
 /**
  * Just copy the quad color to the framebuffer tile (respecting the writemask),
  * for one color buffer.
- * Clamping will be done, if needed (depending on the color buffer's
- * datatype) when we write/pack the colors later.
  */
 static void
 single_output_color(struct quad_stage *qs, 
                     struct quad_header *quads[],
                     unsigned nr)
 {
-   const struct blend_quad_stage *bqs = blend_quad_stage(qs);
-   uint i, j, q;
-
-   struct softpipe_cached_tile *tile
-      = sp_get_cached_tile(qs->softpipe->cbuf_cache[0],
-                           quads[0]->input.x0, 
-                           quads[0]->input.y0);
-
-   for (q = 0; q < nr; q++) {
-      struct quad_header *quad = quads[q];
-      float (*quadColor)[4] = quad->output.color[0];
-      const int itx = (quad->input.x0 & (TILE_SIZE-1));
-      const int ity = (quad->input.y0 & (TILE_SIZE-1));
-
-      if (qs->softpipe->rasterizer->clamp_fragment_color)
-         clamp_colors(quadColor);
-
-      rebase_colors(bqs->base_format[0], quadColor);
-
-      for (j = 0; j < TGSI_QUAD_SIZE; j++) {
-         if (quad->inout.mask & (1 << j)) {
-            int x = itx + (j & 1);
-            int y = ity + (j >> 1);
-            for (i = 0; i < 4; i++) { /* loop over color chans */
-               tile->data.color[y][x][i] = quadColor[i][j];
-            }
-         }
-      }
-   }
+   blend_single(qs, quads, nr, BLEND_SINGLE_COPY);
 }
 
 static void
@@ -1212,6 +1374,53 @@ blend_noop(struct quad_stage *qs,
 }
 
 
+/**
+ * Blend to multisample surfaces: the quad's colour is blended into the
+ * plane of each sample it covers in turn, by the function chosen for
+ * single-sample ones.  Those change the quad's colours, so they're put
+ * back before each sample.
+ */
+static void
+blend_msaa(struct quad_stage *qs, 
+           struct quad_header *quads[],
+           unsigned nr)
+{
+   const struct blend_quad_stage *bqs = blend_quad_stage(qs);
+   const unsigned nr_cbufs = qs->softpipe->framebuffer.nr_cbufs;
+   uint q, s, cbuf;
+
+   for (q = 0; q < nr; q++) {
+      struct quad_header *quad = quads[q];
+      const unsigned mask = quad->inout.mask;
+      const unsigned coverage = quad->inout.coverage & (mask * 0x1111);
+      float color[PIPE_MAX_COLOR_BUFS][TGSI_NUM_CHANNELS][TGSI_QUAD_SIZE];
+      boolean saved = FALSE;
+
+      for (s = 0; s < SP_MAX_SAMPLES; s++) {
+         quad->inout.mask = (coverage >> (4 * s)) & MASK_ALL;
+         if (!quad->inout.mask)
+            continue;
+
+         if (saved)
+            memcpy(quad->output.color, color, nr_cbufs * sizeof(color[0]));
+         else
+            memcpy(color, quad->output.color, nr_cbufs * sizeof(color[0]));
+         saved = TRUE;
+
+         for (cbuf = 0; cbuf < nr_cbufs; cbuf++)
+            qs->thread->cbuf_cache[cbuf]->sample = s;
+
+         bqs->run_sample(qs, &quad, 1);
+      }
+
+      quad->inout.mask = mask;
+   }
+
+   for (cbuf = 0; cbuf < nr_cbufs; cbuf++)
+      qs->thread->cbuf_cache[cbuf]->sample = 0;
+}
+
+
 static void
 choose_blend_quad(struct quad_stage *qs, 
                   struct quad_header *quads[],
@@ -1224,7 +1433,7 @@ choose_blend_quad(struct quad_stage *qs,
 
    qs->run = blend_fallback;
    
-   if (softpipe->framebuffer.nr_cbufs == 0) {
+   if (!sp_quad_writes_color(softpipe)) {
       qs->run = blend_noop;
    }
    else if (!softpipe->blend->logicop_enable &&
@@ -1246,6 +1455,9 @@ choose_blend_quad(struct quad_stage *qs,
             else if (blend->rt[0].rgb_src_factor == PIPE_BLENDFACTOR_SRC_ALPHA &&
                 blend->rt[0].rgb_dst_factor == PIPE_BLENDFACTOR_INV_SRC_ALPHA)
                qs->run = blend_single_add_src_alpha_inv_src_alpha;
+            else if (blend->rt[0].rgb_src_factor == PIPE_BLENDFACTOR_ONE &&
+                blend->rt[0].rgb_dst_factor == PIPE_BLENDFACTOR_INV_SRC_ALPHA)
+               qs->run = blend_single_add_one_inv_src_alpha;
 
          }
       }
@@ -1274,6 +1486,11 @@ choose_blend_quad(struct quad_stage *qs,
          bqs->base_format[i] = RGBA;
    }
 
+   if (softpipe->nr_samples > 1 && qs->run != blend_noop) {
+      bqs->run_sample = qs->run;
+      qs->run = blend_msaa;
+   }
+
    qs->run(qs, quads, nr);
 }
 
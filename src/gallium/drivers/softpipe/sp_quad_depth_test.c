@@ -38,6 +38,7 @@
 #include "sp_context.h"
 #include "sp_quad.h"
 #include "sp_quad_pipe.h"
+#include "sp_rast.h"
 #include "sp_tile_cache.h"
 #include "sp_state.h"           /* for sp_fragment_shader */
 
@@ -785,7 +786,7 @@ depth_test_quads_fallback(struct quad_stage *qs,
 
       data.ps = qs->softpipe->framebuffer.zsbuf;
       data.format = data.ps->format;
-      data.tile = sp_get_cached_tile(qs->softpipe->zsbuf_cache, 
+      data.tile = sp_get_cached_tile(qs->thread->zsbuf_cache, 
                                      quads[0]->input.x0, 
                                      quads[0]->input.y0);
 
@@ -822,14 +823,120 @@ depth_test_quads_fallback(struct quad_stage *qs,
 
    if (qs->softpipe->active_query_count) {
       for (i = 0; i < nr; i++) 
-         qs->softpipe->occlusion_count += mask_count[quads[i]->inout.mask];
+         qs->thread->occlusion_count += mask_count[quads[i]->inout.mask];
    }
 
+   sp_rast_count_time(qs->thread, SP_RAST_DEPTH_TIME);
+
    if (nr)
       qs->next->run(qs->next, quads, nr);
 }
 
 
+/**
+ * Depth/stencil test for multisample surfaces, one sample at a time, each
+ * against its own plane of the depth/stencil buffer.  The alpha test is
+ * per pixel.  When multisampling is enabled the interpolated depth is
+ * offset to each sample's position.  Occlusion queries count samples.
+ */
+static void
+depth_test_quads_msaa(struct quad_stage *qs,
+                      struct quad_header *quads[],
+                      unsigned nr)
+{
+   struct softpipe_context *softpipe = qs->softpipe;
+   const struct pipe_depth_stencil_alpha_state *dsa = softpipe->depth_stencil;
+   const struct tgsi_shader_info *fsInfo = &softpipe->fs_variant->info;
+   struct softpipe_tile_cache *tc = qs->thread->zsbuf_cache;
+   const boolean interp_depth = !fsInfo->writes_z;
+   const boolean sample_depth = interp_depth && softpipe->rasterizer->multisample;
+   const boolean test = softpipe->framebuffer.zsbuf &&
+                        (dsa->depth.enabled || dsa->stencil[0].enabled);
+   unsigned i, s, pass = 0;
+   struct depth_data data;
+
+   data.use_shader_stencil_refs = FALSE;
+
+   if (dsa->alpha.enabled) {
+      nr = alpha_test_quads(qs, quads, nr);
+   }
+
+   if (test) {
+      data.ps = softpipe->framebuffer.zsbuf;
+      data.format = data.ps->format;
+   }
+
+   for (i = 0; i < nr; i++) {
+      struct quad_header *quad = quads[i];
+      unsigned coverage = quad->inout.coverage & (quad->inout.mask * 0x1111);
+
+      if (test) {
+         float depth[TGSI_QUAD_SIZE];
+         unsigned j;
+
+         if (dsa->depth.enabled && interp_depth)
+            interpolate_quad_depth(quad);
+         memcpy(depth, quad->output.depth, sizeof(depth));
+
+         if (dsa->stencil[0].enabled && fsInfo->writes_stencil)
+            convert_quad_stencil(&data, quad);
+
+         for (s = 0; s < SP_MAX_SAMPLES; s++) {
+            quad->inout.mask = (coverage >> (4 * s)) & MASK_ALL;
+            if (!quad->inout.mask)
+               continue;
+
+            tc->sample = s;
+            data.tile = sp_get_cached_tile(tc, quad->input.x0, quad->input.y0);
+            get_depth_stencil_values(&data, quad);
+
+            if (dsa->depth.enabled) {
+               if (sample_depth) {
+                  const float dz =
+                     quad->posCoef->dadx[2] * (sp_sample_positions[s][0] - 0.5f) +
+                     quad->posCoef->dady[2] * (sp_sample_positions[s][1] - 0.5f);
+
+                  for (j = 0; j < TGSI_QUAD_SIZE; j++)
+                     quad->output.depth[j] = depth[j] + dz;
+               }
+               convert_quad_depth(&data, quad);
+            }
+
+            if (dsa->stencil[0].enabled) {
+               depth_stencil_test_quad(qs, &data, quad);
+               write_depth_stencil_values(&data, quad);
+            }
+            else if (depth_test_quad(qs, &data, quad) &&
+                     dsa->depth.writemask) {
+               write_depth_stencil_values(&data, quad);
+            }
+
+            coverage = (coverage & ~(MASK_ALL << (4 * s))) |
+                       (quad->inout.mask << (4 * s));
+         }
+
+         tc->sample = 0;
+      }
+
+      if (softpipe->active_query_count)
+         qs->thread->occlusion_count += util_bitcount(coverage);
+
+      if (!coverage)
+         continue;
+
+      quad->inout.coverage = coverage;
+      quad->inout.mask = (coverage | coverage >> 4 |
+                          coverage >> 8 | coverage >> 12) & MASK_ALL;
+      quads[pass++] = quad;
+   }
+
+   sp_rast_count_time(qs->thread, SP_RAST_DEPTH_TIME);
+
+   if (pass)
+      qs->next->run(qs->next, quads, pass);
+}
+
+
 /**
  * Special-case Z testing for 16-bit Zbuffer and Z buffer writes enabled.
  */
@@ -869,6 +976,7 @@ depth_noop(struct quad_stage *qs,
            struct quad_header *quads[],
            unsigned nr)
 {
+   sp_rast_count_time(qs->thread, SP_RAST_DEPTH_TIME);
    qs->next->run(qs->next, quads, nr);
 }
 
@@ -908,6 +1016,9 @@ choose_depth_test(struct quad_stage *qs,
        !stencil) {
       qs->run = depth_noop;
    }
+   else if (qs->softpipe->nr_samples > 1) {
+      qs->run = depth_test_quads_msaa;
+   }
    else if (!alpha && 
             interp_depth && 
             depth && 
@@ -71,7 +71,7 @@ NAME(struct quad_stage *qs,
 
    depth_step = (ushort)(dzdx * scale);
 
-   tile = sp_get_cached_tile(qs->softpipe->zsbuf_cache, ix, iy);
+   tile = sp_get_cached_tile(qs->thread->zsbuf_cache, ix, iy);
 
    for (i = 0; i < nr; i++) {
       const unsigned outmask = quads[i]->inout.mask;
@@ -137,6 +137,8 @@ NAME(struct quad_stage *qs,
          quads[pass++] = quads[i];
    }
 
+   sp_rast_count_time(qs->thread, SP_RAST_DEPTH_TIME);
+
    if (pass)
       qs->next->run(qs->next, quads, pass);
 }
@@ -45,6 +45,7 @@
 #include "sp_state.h"
 #include "sp_quad.h"
 #include "sp_quad_pipe.h"
+#include "sp_rast.h"
 
 
 struct quad_shade_stage
@@ -71,11 +72,10 @@ static INLINE boolean
 shade_quad(struct quad_stage *qs, struct quad_header *quad)
 {
    struct softpipe_context *softpipe = qs->softpipe;
-   struct tgsi_exec_machine *machine = softpipe->fs_machine;
+   struct tgsi_exec_machine *machine = qs->thread->fs_machine;
 
    if (softpipe->active_statistics_queries) {
-      softpipe->pipeline_statistics.ps_invocations +=
-         util_bitcount(quad->inout.mask);         
+      qs->thread->ps_invocations += util_bitcount(quad->inout.mask);
    }
 
    /* run shader */
@@ -114,7 +114,7 @@ shade_quads(struct quad_stage *qs,
             unsigned nr)
 {
    struct softpipe_context *softpipe = qs->softpipe;
-   struct tgsi_exec_machine *machine = softpipe->fs_machine;
+   struct tgsi_exec_machine *machine = qs->thread->fs_machine;
    unsigned i, nr_quads = 0;
 
    tgsi_exec_set_constant_buffers(machine, PIPE_MAX_CONSTANT_BUFFERS,
@@ -141,7 +141,10 @@ shade_quads(struct quad_stage *qs,
 
       quads[nr_quads++] = quads[i];
    }
-   
+
+   sp_rast_count_quads(qs->thread, SP_RAST_QUADS_SHADED, nr);
+   sp_rast_count_time(qs->thread, SP_RAST_SHADE_TIME);
+
    if (nr_quads)
       qs->next->run(qs->next, quads, nr_quads);
 }
@@ -27,43 +27,93 @@
 
 
 #include "sp_context.h"
+#include "sp_rast.h"
 #include "sp_state.h"
 #include "pipe/p_shader_tokens.h"
 
 
 static void
-insert_stage_at_head(struct softpipe_context *sp, struct quad_stage *quad)
+insert_stage_at_head(struct sp_rast_thread *thread, struct quad_stage *quad)
 {
-   quad->next = sp->quad.first;
-   sp->quad.first = quad;
+   quad->next = thread->quad.first;
+   thread->quad.first = quad;
 }
 
 
-void
-sp_build_quad_pipeline(struct softpipe_context *sp)
+/**
+ * Can any colour buffer be written?
+ */
+boolean
+sp_quad_writes_color(const struct softpipe_context *sp)
 {
-   boolean early_depth_test =
-      sp->depth_stencil->depth.enabled &&
-      sp->framebuffer.zsbuf &&
-      !sp->depth_stencil->alpha.enabled &&
-      !sp->fs_variant->info.uses_kill &&
-      !sp->fs_variant->info.writes_z &&
-      !sp->fs_variant->info.writes_stencil;
+   const struct pipe_blend_state *blend = sp->blend;
+   unsigned i;
+
+   for (i = 0; i < sp->framebuffer.nr_cbufs; i++) {
+      if (blend->rt[blend->independent_blend_enable ? i : 0].colormask)
+         return TRUE;
+   }
+   return FALSE;
+}
 
-   sp->quad.first = sp->quad.blend;
 
-   if (early_depth_test) {
-      insert_stage_at_head( sp, sp->quad.shade );
-      insert_stage_at_head( sp, sp->quad.depth_test );
+/**
+ * \param early_depth_test  run the depth/stencil test before shading
+ * \param shade  run the fragment shader at all; when not, the quads
+ *               surviving the depth/stencil test go straight to blending
+ *               (which then has nothing to write)
+ */
+static void
+build_thread_quad_pipeline(struct sp_rast_thread *thread,
+                           boolean early_depth_test,
+                           boolean shade)
+{
+   thread->quad.first = thread->quad.blend;
+
+   if (!shade) {
+      insert_stage_at_head( thread, thread->quad.depth_test );
+   }
+   else if (early_depth_test) {
+      insert_stage_at_head( thread, thread->quad.shade );
+      insert_stage_at_head( thread, thread->quad.depth_test );
    }
    else {
-      insert_stage_at_head( sp, sp->quad.depth_test );
-      insert_stage_at_head( sp, sp->quad.shade );
+      insert_stage_at_head( thread, thread->quad.depth_test );
+      insert_stage_at_head( thread, thread->quad.shade );
    }
 
 #if !DO_PSTIPPLE_IN_DRAW_MODULE && !DO_PSTIPPLE_IN_HELPER_MODULE
-   if (sp->rasterizer->poly_stipple_enable)
-      insert_stage_at_head( sp, sp->quad.pstipple );
+   if (thread->softpipe->rasterizer->poly_stipple_enable)
+      insert_stage_at_head( thread, thread->quad.pstipple );
 #endif
 }
 
+
+/**
+ * The depth/stencil test goes before shading whenever the shader can't
+ * change its outcome: it neither kills fragments nor writes depth or
+ * stencil, and there's no alpha test.  If then nothing can be written to
+ * the colour buffers either (depth prepass, shadow maps) and no pipeline
+ * statistics query counts the shader invocations, shading is skipped
+ * altogether.
+ */
+void
+sp_build_quad_pipeline(struct softpipe_context *sp)
+{
+   boolean early_depth_test =
+      (sp->depth_stencil->depth.enabled ||
+       sp->depth_stencil->stencil[0].enabled) &&
+      sp->framebuffer.zsbuf &&
+      !sp->depth_stencil->alpha.enabled &&
+      !sp->fs_variant->info.uses_kill &&
+      !sp->fs_variant->info.writes_z &&
+      !sp->fs_variant->info.writes_stencil;
+   boolean shade =
+      !early_depth_test ||
+      sp->active_statistics_queries ||
+      sp_quad_writes_color(sp);
+   unsigned i;
+
+   for (i = 0; i < sp->num_threads; i++)
+      build_thread_quad_pipeline(sp->rast[i], early_depth_test, shade);
+}
@@ -31,8 +31,10 @@
 #ifndef SP_QUAD_PIPE_H
 #define SP_QUAD_PIPE_H
 
+#include "pipe/p_compiler.h"
 
 struct softpipe_context;
+struct sp_rast_thread;
 struct quad_header;
 
 
@@ -43,6 +45,7 @@ struct quad_header;
  */
 struct quad_stage {
    struct softpipe_context *softpipe;
+   struct sp_rast_thread *thread;  /**< the thread running this stage */
 
    struct quad_stage *next;
 
@@ -67,6 +70,8 @@ struct quad_stage *sp_quad_blend_stage( struct softpipe_context *softpipe );
 struct quad_stage *sp_quad_colormask_stage( struct softpipe_context *softpipe );
 struct quad_stage *sp_quad_output_stage( struct softpipe_context *softpipe );
 
+boolean sp_quad_writes_color(const struct softpipe_context *sp);
+
 void sp_build_quad_pipeline(struct softpipe_context *sp);
 
 #endif /* SP_QUAD_PIPE_H */
@@ -35,7 +35,10 @@
 #include "util/u_memory.h"
 #include "sp_context.h"
 #include "sp_query.h"
+#include "sp_rast.h"
+#include "sp_screen.h"
 #include "sp_state.h"
+#include "sp_tex_tile_cache.h"
 
 struct softpipe_query {
    unsigned type;
@@ -53,6 +56,92 @@ static struct softpipe_query *softpipe_query( struct pipe_query *p )
    return (struct softpipe_query *)p;
 }
 
+/**
+ * Add up the texture cache counter of one of the SP_QUERY_TEX_CACHE_x
+ * queries, over the context's caches and the rasterizer threads' copies.
+ */
+static uint64_t
+tex_cache_count(const struct softpipe_context *softpipe, unsigned type)
+{
+   boolean hits;
+   unsigned sh, i, t;
+   uint64_t count = 0;
+
+   if (type >= SP_QUERY_TEX_CACHE_UNIT_HITS) {
+      const unsigned unit = (type - SP_QUERY_TEX_CACHE_UNIT_HITS) %
+                            PIPE_MAX_SAMPLERS;
+      const struct softpipe_tex_tile_cache *tc;
+
+      hits = type < SP_QUERY_TEX_CACHE_UNIT_MISSES;
+
+      for (t = 0; t < Elements(softpipe->rast); t++) {
+         if (t == 0)
+            tc = softpipe->tex_cache[PIPE_SHADER_FRAGMENT][unit];
+         else if (softpipe->rast[t])
+            tc = softpipe->rast[t]->tex_cache[unit];
+         else
+            continue;
+         if (tc)
+            count += hits ? tc->hits : tc->misses;
+      }
+      return count;
+   }
+
+   hits = type == SP_QUERY_TEX_CACHE_HITS;
+
+   for (sh = 0; sh < Elements(softpipe->tex_cache); sh++) {
+      for (i = 0; i < Elements(softpipe->tex_cache[0]); i++) {
+         const struct softpipe_tex_tile_cache *tc = softpipe->tex_cache[sh][i];
+         if (tc)
+            count += hits ? tc->hits : tc->misses;
+      }
+   }
+
+   for (t = 1; t < Elements(softpipe->rast); t++) {
+      if (!softpipe->rast[t])
+         continue;
+      for (i = 0; i < Elements(softpipe->rast[t]->tex_cache); i++) {
+         const struct softpipe_tex_tile_cache *tc =
+            softpipe->rast[t]->tex_cache[i];
+         if (tc)
+            count += hits ? tc->hits : tc->misses;
+      }
+   }
+
+   return count;
+}
+
+
+/**
+ * Add up the counter of one of the SP_QUERY_SETUP_TIME ..
+ * SP_QUERY_TILE_FLUSH_TIME queries over the rasterizer threads.
+ */
+static uint64_t
+rast_count(const struct softpipe_context *softpipe, unsigned type)
+{
+   unsigned t, i;
+   uint64_t count = 0;
+
+   for (t = 0; t < Elements(softpipe->rast); t++) {
+      const struct sp_rast_thread *thread = softpipe->rast[t];
+
+      if (!thread)
+         continue;
+
+      if (type == SP_QUERY_TILE_FLUSH_TIME) {
+         for (i = 0; i < PIPE_MAX_COLOR_BUFS; i++)
+            count += thread->cbuf_cache[i]->flush_time;
+         count += thread->zsbuf_cache->flush_time;
+      }
+      else {
+         count += thread->counters[type - SP_QUERY_SETUP_TIME];
+      }
+   }
+
+   return count;
+}
+
+
 static struct pipe_query *
 softpipe_create_query(struct pipe_context *pipe, 
 		      unsigned type)
@@ -69,7 +158,8 @@ softpipe_create_query(struct pipe_context *pipe,
           type == PIPE_QUERY_PIPELINE_STATISTICS ||
           type == PIPE_QUERY_GPU_FINISHED ||
           type == PIPE_QUERY_TIMESTAMP ||
-          type == PIPE_QUERY_TIMESTAMP_DISJOINT);
+          type == PIPE_QUERY_TIMESTAMP_DISJOINT ||
+          (type >= SP_QUERY_TEX_CACHE_HITS && type < SP_QUERY_TYPES));
    sq = CALLOC_STRUCT( softpipe_query );
    sq->type = type;
 
@@ -131,6 +221,15 @@ softpipe_begin_query(struct pipe_context *pipe, struct pipe_query *q)
       softpipe->active_statistics_queries++;
       break;
    default:
+      if (sq->type >= SP_QUERY_SETUP_TIME && sq->type < SP_QUERY_TYPES) {
+         softpipe->active_counter_queries++;
+         sq->start = rast_count(softpipe, sq->type);
+         break;
+      }
+      if (sq->type >= SP_QUERY_TEX_CACHE_HITS && sq->type < SP_QUERY_TYPES) {
+         sq->start = tex_cache_count(softpipe, sq->type);
+         break;
+      }
       assert(0);
       break;
    }
@@ -198,6 +297,15 @@ softpipe_end_query(struct pipe_context *pipe, struct pipe_query *q)
       softpipe->active_statistics_queries--;
       break;
    default:
+      if (sq->type >= SP_QUERY_SETUP_TIME && sq->type < SP_QUERY_TYPES) {
+         sq->end = rast_count(softpipe, sq->type);
+         softpipe->active_counter_queries--;
+         break;
+      }
+      if (sq->type >= SP_QUERY_TEX_CACHE_HITS && sq->type < SP_QUERY_TYPES) {
+         sq->end = tex_cache_count(softpipe, sq->type);
+         break;
+      }
       assert(0);
       break;
    }
@@ -284,6 +392,46 @@ softpipe_check_render_cond(struct softpipe_context *sp)
 }
 
 
+int
+softpipe_get_driver_query_info(struct pipe_screen *screen,
+                               unsigned index,
+                               struct pipe_driver_query_info *info)
+{
+   static const struct pipe_driver_query_info queries[] = {
+      {"tex-cache-hits", SP_QUERY_TEX_CACHE_HITS, 0, FALSE},
+      {"tex-cache-misses", SP_QUERY_TEX_CACHE_MISSES, 0, FALSE},
+      {"setup-ns", SP_QUERY_SETUP_TIME, 0, FALSE},
+      {"shade-ns", SP_QUERY_SHADE_TIME, 0, FALSE},
+      {"tex-ns", SP_QUERY_TEX_TIME, 0, FALSE},
+      {"depth-ns", SP_QUERY_DEPTH_TIME, 0, FALSE},
+      {"blend-ns", SP_QUERY_BLEND_TIME, 0, FALSE},
+      {"quads-rasterized", SP_QUERY_QUADS_RASTERIZED, 0, FALSE},
+      {"quads-shaded", SP_QUERY_QUADS_SHADED, 0, FALSE},
+      {"tile-flush-ns", SP_QUERY_TILE_FLUSH_TIME, 0, FALSE}
+   };
+   struct softpipe_screen *sp_screen = softpipe_screen(screen);
+
+   if (!info)
+      return Elements(queries) + 2 * PIPE_MAX_SAMPLERS;
+
+   if (index < Elements(queries)) {
+      *info = queries[index];
+      return 1;
+   }
+
+   index -= Elements(queries);
+   if (index >= 2 * PIPE_MAX_SAMPLERS)
+      return 0;
+
+   info->name = sp_screen->tex_cache_query_names[index / PIPE_MAX_SAMPLERS]
+                                                [index % PIPE_MAX_SAMPLERS];
+   info->query_type = SP_QUERY_TEX_CACHE_UNIT_HITS + index;
+   info->max_value = 0;
+   info->uses_byte_units = FALSE;
+   return 1;
+}
+
+
 void softpipe_init_query_funcs(struct softpipe_context *softpipe )
 {
    softpipe->pipe.create_query = softpipe_create_query;
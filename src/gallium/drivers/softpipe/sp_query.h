@@ -32,6 +32,41 @@
 #ifndef SP_QUERY_H
 #define SP_QUERY_H
 
+#include "pipe/p_defines.h"
+#include "pipe/p_state.h"
+
+
+/**
+ * Driver specific queries.
+ *
+ * The TEX_CACHE ones count texture tile cache lookups.  The TEX_CACHE_UNIT
+ * ones count those of fragment sampler view unit i alone, at
+ * SP_QUERY_TEX_CACHE_UNIT_x + i.  See struct softpipe_tex_tile_cache.
+ *
+ * SETUP_TIME .. QUADS_SHADED add up the rasterizer threads' counters, in
+ * the order of enum sp_rast_counter; the times are in nanoseconds.
+ * TILE_FLUSH_TIME is the time spent writing back colour and depth tiles.
+ */
+enum sp_query_type {
+   SP_QUERY_TEX_CACHE_HITS = PIPE_QUERY_DRIVER_SPECIFIC,
+   SP_QUERY_TEX_CACHE_MISSES,
+   SP_QUERY_TEX_CACHE_UNIT_HITS,
+   SP_QUERY_TEX_CACHE_UNIT_MISSES =
+      SP_QUERY_TEX_CACHE_UNIT_HITS + PIPE_MAX_SAMPLERS,
+   SP_QUERY_SETUP_TIME =
+      SP_QUERY_TEX_CACHE_UNIT_MISSES + PIPE_MAX_SAMPLERS,
+   SP_QUERY_SHADE_TIME,
+   SP_QUERY_TEX_TIME,
+   SP_QUERY_DEPTH_TIME,
+   SP_QUERY_BLEND_TIME,
+   SP_QUERY_QUADS_RASTERIZED,
+   SP_QUERY_QUADS_SHADED,
+   SP_QUERY_TILE_FLUSH_TIME
+};
+
+#define SP_QUERY_TYPES (SP_QUERY_TILE_FLUSH_TIME + 1)
+
+
 extern boolean
 softpipe_check_render_cond(struct softpipe_context *sp);
 
@@ -39,5 +74,12 @@ softpipe_check_render_cond(struct softpipe_context *sp);
 struct softpipe_context;
 extern void softpipe_init_query_funcs(struct softpipe_context * );
 
+struct pipe_screen;
+struct pipe_driver_query_info;
+extern int
+softpipe_get_driver_query_info(struct pipe_screen *screen,
+                               unsigned index,
+                               struct pipe_driver_query_info *info);
+
 
 #endif /* SP_QUERY_H */
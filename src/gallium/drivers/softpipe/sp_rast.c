@@ -0,0 +1,377 @@
+/**************************************************************************
+ *
+ * Copyright 2013 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/**
+ * Rasterizer thread pool.  See sp_rast.h.
+ */
+
+#include "util/u_cpu_detect.h"
+#include "util/u_debug.h"
+#include "util/u_memory.h"
+#include "tgsi/tgsi_exec.h"
+
+#include "sp_context.h"
+#include "sp_quad_pipe.h"
+#include "sp_rast.h"
+#include "sp_setup.h"
+#include "sp_texture.h"
+#include "sp_tex_sample.h"
+#include "sp_tex_tile_cache.h"
+#include "sp_tile_cache.h"
+
+
+/**
+ * Run a job on the calling thread, timing it as setup unless the quad
+ * stages claim the time.
+ */
+static void
+rast_run_job(struct sp_rast_thread *thread, sp_rast_func func, void *data)
+{
+   if (thread->softpipe->active_counter_queries)
+      thread->timestamp = os_time_get_nano();
+
+   func(thread, data);
+
+   sp_rast_count_time(thread, SP_RAST_SETUP_TIME);
+}
+
+
+static PIPE_THREAD_ROUTINE( rast_thread_function, init_data )
+{
+   struct sp_rast_thread *thread = (struct sp_rast_thread *) init_data;
+
+   while (1) {
+      pipe_semaphore_wait(&thread->work_ready);
+
+      if (!thread->func)
+         break;
+
+      rast_run_job(thread, thread->func, thread->data);
+
+      pipe_semaphore_signal(&thread->work_done);
+   }
+
+   return NULL;
+}
+
+
+static struct softpipe_tile_cache *
+create_band_tile_cache(struct softpipe_context *sp, unsigned band)
+{
+   struct softpipe_tile_cache *tc = sp_create_tile_cache(&sp->pipe);
+
+   if (tc) {
+      tc->band = band;
+      tc->num_bands = sp->num_threads;
+   }
+   return tc;
+}
+
+
+static void
+destroy_rast_thread(struct sp_rast_thread *thread)
+{
+   uint i;
+
+   if (thread->index > 0 && thread->thread) {
+      thread->func = NULL;
+      pipe_semaphore_signal(&thread->work_ready);
+      pipe_thread_wait(thread->thread);
+      pipe_semaphore_destroy(&thread->work_ready);
+      pipe_semaphore_destroy(&thread->work_done);
+   }
+
+   if (thread->quad.shade)
+      thread->quad.shade->destroy(thread->quad.shade);
+   if (thread->quad.depth_test)
+      thread->quad.depth_test->destroy(thread->quad.depth_test);
+   if (thread->quad.blend)
+      thread->quad.blend->destroy(thread->quad.blend);
+   if (thread->quad.pstipple)
+      thread->quad.pstipple->destroy(thread->quad.pstipple);
+
+   if (thread->setup)
+      sp_setup_destroy_context(thread->setup);
+
+   if (thread->fs_machine)
+      tgsi_exec_machine_destroy(thread->fs_machine);
+
+   if (thread->index > 0) {
+      for (i = 0; i < Elements(thread->tex_cache); i++)
+         sp_destroy_tex_tile_cache(thread->tex_cache[i]);
+      FREE(thread->fs_sampler);
+   }
+
+   for (i = 0; i < PIPE_MAX_COLOR_BUFS; i++)
+      sp_destroy_tile_cache(thread->cbuf_cache[i]);
+   sp_destroy_tile_cache(thread->zsbuf_cache);
+
+   FREE(thread);
+}
+
+
+static struct sp_rast_thread *
+create_rast_thread(struct softpipe_context *sp, unsigned index)
+{
+   struct sp_rast_thread *thread = CALLOC_STRUCT(sp_rast_thread);
+   uint i;
+
+   if (!thread)
+      return NULL;
+
+   thread->softpipe = sp;
+   thread->index = index;
+
+   /* Must be before quad stage setup! */
+   for (i = 0; i < PIPE_MAX_COLOR_BUFS; i++) {
+      thread->cbuf_cache[i] = create_band_tile_cache(sp, index);
+      if (!thread->cbuf_cache[i])
+         goto fail;
+   }
+   thread->zsbuf_cache = create_band_tile_cache(sp, index);
+   if (!thread->zsbuf_cache)
+      goto fail;
+
+   if (index == 0) {
+      thread->fs_sampler = sp->tgsi.sampler[PIPE_SHADER_FRAGMENT];
+   }
+   else {
+      /* texture caches are created as views get bound */
+      thread->fs_sampler = sp_create_tgsi_sampler();
+      if (!thread->fs_sampler)
+         goto fail;
+   }
+
+   thread->fs_sampler->thread = thread;
+
+   thread->fs_machine = tgsi_exec_machine_create();
+   if (!thread->fs_machine)
+      goto fail;
+
+   thread->quad.shade = sp_quad_shade_stage(sp);
+   thread->quad.depth_test = sp_quad_depth_test_stage(sp);
+   thread->quad.blend = sp_quad_blend_stage(sp);
+   thread->quad.pstipple = sp_quad_polygon_stipple_stage(sp);
+   if (!thread->quad.shade || !thread->quad.depth_test ||
+       !thread->quad.blend || !thread->quad.pstipple)
+      goto fail;
+
+   thread->quad.shade->thread = thread;
+   thread->quad.depth_test->thread = thread;
+   thread->quad.blend->thread = thread;
+   thread->quad.pstipple->thread = thread;
+
+   thread->setup = sp_setup_create_context(thread);
+   if (!thread->setup)
+      goto fail;
+
+   if (index > 0) {
+      pipe_semaphore_init(&thread->work_ready, 0);
+      pipe_semaphore_init(&thread->work_done, 0);
+      thread->thread = pipe_thread_create(rast_thread_function, thread);
+      if (!thread->thread) {
+         pipe_semaphore_destroy(&thread->work_ready);
+         pipe_semaphore_destroy(&thread->work_done);
+         goto fail;
+      }
+   }
+
+   return thread;
+
+fail:
+   destroy_rast_thread(thread);
+   return NULL;
+}
+
+
+/**
+ * Create the rasterizer state for the application's thread and spawn the
+ * worker threads.
+ *
+ * The number of threads defaults to the number of CPUs and can be set with
+ * SOFTPIPE_NUM_THREADS; 1 keeps all rendering on the application's thread.
+ */
+boolean
+sp_create_rast_threads(struct softpipe_context *sp)
+{
+   unsigned num_threads;
+   unsigned i;
+
+   util_cpu_detect();
+   num_threads = MAX2(util_cpu_caps.nr_cpus, 1);
+
+#ifdef PIPE_SUBSYSTEM_EMBEDDED
+   num_threads = 1;
+#endif
+   num_threads = debug_get_num_option("SOFTPIPE_NUM_THREADS", num_threads);
+   sp->num_threads = CLAMP(num_threads, 1, SP_MAX_THREADS);
+
+   sp->rast[0] = create_rast_thread(sp, 0);
+   if (!sp->rast[0])
+      return FALSE;
+
+   for (i = 1; i < sp->num_threads; i++) {
+      sp->rast[i] = create_rast_thread(sp, i);
+      if (!sp->rast[i])
+         break;
+   }
+
+   if (i < sp->num_threads) {
+      /* Couldn't get all the threads: redo the bands for those we have. */
+      unsigned j, k;
+
+      sp->num_threads = i;
+      for (j = 0; j < sp->num_threads; j++) {
+         for (k = 0; k < PIPE_MAX_COLOR_BUFS; k++)
+            sp->rast[j]->cbuf_cache[k]->num_bands = sp->num_threads;
+         sp->rast[j]->zsbuf_cache->num_bands = sp->num_threads;
+      }
+   }
+
+   return TRUE;
+}
+
+
+void
+sp_destroy_rast_threads(struct softpipe_context *sp)
+{
+   unsigned i;
+
+   for (i = 0; i < Elements(sp->rast); i++) {
+      if (sp->rast[i]) {
+         destroy_rast_thread(sp->rast[i]);
+         sp->rast[i] = NULL;
+      }
+   }
+}
+
+
+/**
+ * Run func on every rasterizer thread and wait for all of them to finish.
+ */
+void
+sp_rast_run(struct softpipe_context *sp, sp_rast_func func, void *data)
+{
+   unsigned i;
+
+   for (i = 1; i < sp->num_threads; i++) {
+      sp->rast[i]->func = func;
+      sp->rast[i]->data = data;
+      pipe_semaphore_signal(&sp->rast[i]->work_ready);
+   }
+
+   rast_run_job(sp->rast[0], func, data);
+
+   for (i = 1; i < sp->num_threads; i++)
+      pipe_semaphore_wait(&sp->rast[i]->work_done);
+
+   for (i = 0; i < sp->num_threads; i++) {
+      struct sp_rast_thread *thread = sp->rast[i];
+
+      sp->occlusion_count += thread->occlusion_count;
+      sp->pipeline_statistics.ps_invocations += thread->ps_invocations;
+      thread->occlusion_count = 0;
+      thread->ps_invocations = 0;
+   }
+}
+
+
+/**
+ * Go back to rasterizing everything on the application's thread, after
+ * writing back what the other threads have cached.
+ */
+static void
+rast_single_thread(struct softpipe_context *sp)
+{
+   unsigned i, j;
+
+   for (i = 0; i < sp->num_threads; i++) {
+      struct sp_rast_thread *thread = sp->rast[i];
+
+      for (j = 0; j < PIPE_MAX_COLOR_BUFS; j++) {
+         sp_flush_tile_cache(thread->cbuf_cache[j]);
+         if (i > 0)
+            sp_tile_cache_set_surface(thread->cbuf_cache[j], NULL);
+         thread->cbuf_cache[j]->num_bands = 1;
+      }
+      sp_flush_tile_cache(thread->zsbuf_cache);
+      if (i > 0)
+         sp_tile_cache_set_surface(thread->zsbuf_cache, NULL);
+      thread->zsbuf_cache->num_bands = 1;
+   }
+
+   sp->num_threads = 1;
+}
+
+
+/**
+ * Mirror the context's fragment samplers and sampler views into the other
+ * threads' samplers and texture caches.  Called during state validation.
+ */
+void
+sp_rast_update_samplers(struct softpipe_context *sp)
+{
+   const struct sp_tgsi_sampler *src = sp->tgsi.sampler[PIPE_SHADER_FRAGMENT];
+   unsigned t, i;
+
+   for (t = 1; t < sp->num_threads; t++) {
+      struct sp_rast_thread *thread = sp->rast[t];
+      struct sp_tgsi_sampler *dst = thread->fs_sampler;
+
+      memcpy(dst->sp_sampler, src->sp_sampler, sizeof(dst->sp_sampler));
+
+      for (i = 0; i < PIPE_MAX_SHADER_SAMPLER_VIEWS; i++) {
+         struct pipe_sampler_view *view =
+            sp->sampler_views[PIPE_SHADER_FRAGMENT][i];
+         struct softpipe_tex_tile_cache *tc = thread->tex_cache[i];
+
+         if (view && !tc) {
+            tc = sp_create_tex_tile_cache(&sp->pipe);
+            if (!tc) {
+               rast_single_thread(sp);
+               return;
+            }
+            thread->tex_cache[i] = tc;
+         }
+
+         if (tc) {
+            sp_tex_tile_cache_set_sampler_view(tc, view);
+            if (tc->texture) {
+               struct softpipe_resource *spt = softpipe_resource(tc->texture);
+               if (spt->timestamp != tc->timestamp) {
+                  sp_tex_tile_cache_validate_texture(tc);
+                  tc->timestamp = spt->timestamp;
+               }
+            }
+         }
+
+         dst->sp_sview[i] = src->sp_sview[i];
+         if (view)
+            dst->sp_sview[i].cache = tc;
+      }
+   }
+}
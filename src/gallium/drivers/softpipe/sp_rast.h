@@ -0,0 +1,216 @@
+/**************************************************************************
+ *
+ * Copyright 2013 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/**
+ * Rasterizer threads.
+ *
+ * The framebuffer is split into horizontal bands of TILE_SIZE rows, dealt
+ * out to the rasterizer threads round-robin.  Every thread runs setup for
+ * all the primitives of a vertex buffer but only passes the quads of its
+ * own bands down its quad pipeline.  So each thread has its own setup
+ * context, quad stages, shader machine, fragment texture caches and
+ * surface tile caches, and a tile is only ever touched by the thread owning
+ * it.  The results match single-threaded rendering, except for the few
+ * colour formats whose tiles are kept as floats (SP_TILE_FLOAT): those are
+ * only rounded to the surface's precision when evicted, which the threads
+ * do at other times, so blended pixels may differ in the last bit.
+ *
+ * Thread 0 is the application's thread.  sp_rast_run() returns once all
+ * threads are done, so the workers are idle whenever the state tracker
+ * can do anything else with the context.
+ */
+
+#ifndef SP_RAST_H
+#define SP_RAST_H
+
+
+#include "pipe/p_compiler.h"
+#include "pipe/p_state.h"
+#include "os/os_thread.h"
+#include "os/os_time.h"
+#include "util/u_math.h"
+#include "sp_context.h"
+#include "sp_tile_cache.h"
+
+
+struct setup_context;
+struct quad_stage;
+struct tgsi_exec_machine;
+struct sp_tgsi_sampler;
+struct softpipe_tex_tile_cache;
+struct sp_rast_thread;
+
+
+typedef void (*sp_rast_func)(struct sp_rast_thread *thread, void *data);
+
+
+/**
+ * Per-thread counters behind the SP_QUERY_SETUP_TIME .. SP_QUERY_QUADS_SHADED
+ * queries, in the same order.  They only advance while such a query is
+ * active.  Times are in nanoseconds and exclusive: the stages charge the
+ * time since the previous charge to themselves when they hand their quads
+ * on, see sp_rast_count_time().  So setup covers rasterization and polygon
+ * stipple too, shading doesn't include texture sampling, and blending, the
+ * last stage, gets whatever is left until the quad pipeline returns.
+ */
+enum sp_rast_counter
+{
+   SP_RAST_SETUP_TIME,
+   SP_RAST_SHADE_TIME,
+   SP_RAST_TEX_TIME,
+   SP_RAST_DEPTH_TIME,
+   SP_RAST_BLEND_TIME,
+   SP_RAST_QUADS_RASTERIZED,
+   SP_RAST_QUADS_SHADED,
+   SP_RAST_COUNTERS
+};
+
+
+struct sp_rast_thread
+{
+   struct softpipe_context *softpipe;
+   unsigned index;
+
+   /** The primitive setup/rasterization state */
+   struct setup_context *setup;
+
+   /** Software quad rendering pipeline */
+   struct {
+      struct quad_stage *shade;
+      struct quad_stage *depth_test;
+      struct quad_stage *blend;
+      struct quad_stage *pstipple;
+      struct quad_stage *first; /**< points to one of the above stages */
+   } quad;
+
+   struct tgsi_exec_machine *fs_machine;
+
+   /**
+    * Fragment shader sampler.  Thread 0 uses the context's, the others a
+    * copy of it which reads through their own texture caches.
+    */
+   struct sp_tgsi_sampler *fs_sampler;
+   struct softpipe_tex_tile_cache *tex_cache[PIPE_MAX_SHADER_SAMPLER_VIEWS];
+
+   struct softpipe_tile_cache *cbuf_cache[PIPE_MAX_COLOR_BUFS];
+   struct softpipe_tile_cache *zsbuf_cache;
+
+   /** Counted while rasterizing, added to the context's afterwards */
+   uint64_t occlusion_count;
+   uint64_t ps_invocations;
+
+   /** Running totals, see enum sp_rast_counter */
+   uint64_t counters[SP_RAST_COUNTERS];
+   int64_t timestamp;    /**< time of the last sp_rast_count_time() */
+
+   /** Current job, for worker threads */
+   sp_rast_func func;
+   void *data;
+
+   pipe_thread thread;
+   pipe_semaphore work_ready;
+   pipe_semaphore work_done;
+};
+
+
+boolean
+sp_create_rast_threads(struct softpipe_context *sp);
+
+void
+sp_destroy_rast_threads(struct softpipe_context *sp);
+
+void
+sp_rast_run(struct softpipe_context *sp, sp_rast_func func, void *data);
+
+void
+sp_rast_update_samplers(struct softpipe_context *sp);
+
+
+/**
+ * Charge the time since the previous call to counter, while any counter
+ * query is active.
+ */
+static INLINE void
+sp_rast_count_time(struct sp_rast_thread *thread, enum sp_rast_counter counter)
+{
+   if (thread->softpipe->active_counter_queries) {
+      const int64_t now = os_time_get_nano();
+      thread->counters[counter] += now - thread->timestamp;
+      thread->timestamp = now;
+   }
+}
+
+
+/**
+ * Add n to one of the thread's quad counters, while any counter query is
+ * active.
+ */
+static INLINE void
+sp_rast_count_quads(struct sp_rast_thread *thread,
+                    enum sp_rast_counter counter, unsigned n)
+{
+   if (thread->softpipe->active_counter_queries)
+      thread->counters[counter] += n;
+}
+
+
+/**
+ * Does the thread rasterize pixel row y?
+ */
+static INLINE boolean
+sp_rast_owns_row(const struct sp_rast_thread *thread, int y)
+{
+   const unsigned num_threads = thread->softpipe->num_threads;
+
+   return num_threads == 1 ||
+          ((unsigned) y / TILE_SIZE) % num_threads == thread->index;
+}
+
+
+/**
+ * Does the thread rasterize any of pixel rows y0..y1?
+ */
+static INLINE boolean
+sp_rast_owns_rows(const struct sp_rast_thread *thread, int y0, int y1)
+{
+   const unsigned num_threads = thread->softpipe->num_threads;
+   const unsigned band0 = (unsigned) MAX2(y0, 0) / TILE_SIZE;
+   const unsigned band1 = (unsigned) MAX2(y1, 0) / TILE_SIZE;
+   unsigned band;
+
+   if (band1 - band0 + 1 >= num_threads)
+      return TRUE;
+
+   for (band = band0; band <= band1; band++) {
+      if (band % num_threads == thread->index)
+         return TRUE;
+   }
+   return FALSE;
+}
+
+
+#endif /* SP_RAST_H */
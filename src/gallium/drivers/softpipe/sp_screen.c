@@ -29,6 +29,7 @@
 #include "util/u_memory.h"
 #include "util/u_format.h"
 #include "util/u_format_s3tc.h"
+#include "util/u_string.h"
 #include "util/u_video.h"
 #include "os/os_time.h"
 #include "pipe/p_defines.h"
@@ -44,6 +45,7 @@
 #include "sp_screen.h"
 #include "sp_context.h"
 #include "sp_fence.h"
+#include "sp_query.h"
 #include "sp_public.h"
 
 DEBUG_GET_ONCE_BOOL_OPTION(use_llvm, "SOFTPIPE_USE_LLVM", FALSE)
@@ -302,8 +304,19 @@ softpipe_is_format_supported( struct pipe_screen *screen,
    if (!format_desc)
       return FALSE;
 
-   if (sample_count > 1)
-      return FALSE;
+   /* Multisampling is only for rendering: the samples can be resolved but
+    * not sampled or displayed.
+    */
+   if (sample_count > 1) {
+      if (sample_count != SP_MAX_SAMPLES ||
+          (target != PIPE_TEXTURE_2D && target != PIPE_TEXTURE_RECT) ||
+          !(bind & (PIPE_BIND_RENDER_TARGET | PIPE_BIND_DEPTH_STENCIL)) ||
+          (bind & (PIPE_BIND_SAMPLER_VIEW |
+                   PIPE_BIND_DISPLAY_TARGET |
+                   PIPE_BIND_SCANOUT |
+                   PIPE_BIND_SHARED)))
+         return FALSE;
+   }
 
    if (bind & (PIPE_BIND_DISPLAY_TARGET |
                PIPE_BIND_SCANOUT |
@@ -390,6 +403,7 @@ struct pipe_screen *
 softpipe_create_screen(struct sw_winsys *winsys)
 {
    struct softpipe_screen *screen = CALLOC_STRUCT(softpipe_screen);
+   unsigned i;
 
    if (!screen)
       return NULL;
@@ -405,6 +419,7 @@ softpipe_create_screen(struct sw_winsys *winsys)
    screen->base.get_paramf = softpipe_get_paramf;
    screen->base.get_video_param = softpipe_get_video_param;
    screen->base.get_timestamp = softpipe_get_timestamp;
+   screen->base.get_driver_query_info = softpipe_get_driver_query_info;
    screen->base.is_format_supported = softpipe_is_format_supported;
    screen->base.is_video_format_supported = vl_video_buffer_is_format_supported;
    screen->base.context_create = softpipe_create_context;
@@ -412,6 +427,15 @@ softpipe_create_screen(struct sw_winsys *winsys)
 
    screen->use_llvm = debug_get_option_use_llvm();
 
+   for (i = 0; i < PIPE_MAX_SAMPLERS; i++) {
+      util_snprintf(screen->tex_cache_query_names[0][i],
+                    sizeof screen->tex_cache_query_names[0][i],
+                    "tex-cache-hits-unit%u", i);
+      util_snprintf(screen->tex_cache_query_names[1][i],
+                    sizeof screen->tex_cache_query_names[1][i],
+                    "tex-cache-misses-unit%u", i);
+   }
+
    util_format_s3tc_init();
 
    softpipe_init_screen_texture_funcs(&screen->base);
@@ -33,6 +33,7 @@
 
 #include "pipe/p_screen.h"
 #include "pipe/p_defines.h"
+#include "pipe/p_state.h"
 
 
 struct sw_winsys;
@@ -47,6 +48,9 @@ struct softpipe_screen {
     */
    unsigned timestamp;
    boolean use_llvm;
+
+   /** Names of the per-unit texture cache driver queries, hits then misses */
+   char tex_cache_query_names[2][PIPE_MAX_SAMPLERS][32];
 };
 
 static INLINE struct softpipe_screen *
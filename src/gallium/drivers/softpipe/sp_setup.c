@@ -35,6 +35,7 @@
 #include "sp_context.h"
 #include "sp_quad.h"
 #include "sp_quad_pipe.h"
+#include "sp_rast.h"
 #include "sp_setup.h"
 #include "sp_state.h"
 #include "draw/draw_context.h"
@@ -60,6 +61,18 @@ struct edge {
 };
 
 
+/**
+ * Multisample rasterization: a triangle edge as the function
+ * E(x, y) = a * x + b * y + c, positive inside the triangle.
+ */
+struct msaa_edge {
+   float a, b, c;
+   boolean inclusive;  /**< are the samples right on the edge inside? */
+   /** E at the sample of each coverage bit, relative to the quad's origin */
+   float offset[4 * SP_MAX_SAMPLES];
+};
+
+
 /**
  * Max number of quads (2x2 pixel blocks) to process per batch.
  * This can't be arbitrarily increased since we depend on some 32-bit
@@ -74,6 +87,7 @@ struct edge {
  */
 struct setup_context {
    struct softpipe_context *softpipe;
+   struct sp_rast_thread *thread;
 
    /* Vertices are just an array of floats making up each attribute in
     * turn.  Currently fixed at 4 floats, but should change in time.
@@ -93,6 +107,16 @@ struct setup_context {
 
    float pixel_offset;
 
+   /**
+    * Rasterize triangles sample by sample, for a multisample surface with
+    * multisampling enabled.  Otherwise all the samples of the pixels whose
+    * centre is covered are.
+    */
+   boolean multisample;
+   struct msaa_edge msaa_edge[3];
+   /** The samples the quads may cover at all, from the sample mask */
+   unsigned coverage;
+
    struct quad_header quad[MAX_QUADS];
    struct quad_header *quad_ptrs[MAX_QUADS];
    unsigned count;
@@ -116,6 +140,14 @@ struct setup_context {
 };
 
 
+const float sp_sample_positions[SP_MAX_SAMPLES][2] = {
+   { 0.375f, 0.125f },
+   { 0.875f, 0.375f },
+   { 0.125f, 0.625f },
+   { 0.625f, 0.875f }
+};
+
+
 
 
 
@@ -160,14 +192,20 @@ clip_emit_quad(struct setup_context *setup, struct quad_header *quad)
 {
    quad_clip( setup, quad );
 
-   if (quad->inout.mask) {
-      struct softpipe_context *sp = setup->softpipe;
+   if (quad->inout.mask &&
+       sp_rast_owns_row(setup->thread, quad->input.y0)) {
+      struct quad_stage *pipe = setup->thread->quad.first;
 
 #if DEBUG_FRAGS
       setup->numFragsEmitted += util_bitcount(quad->inout.mask);
 #endif
 
-      sp->quad.first->run( sp->quad.first, &quad, 1 );
+      quad->inout.coverage = setup->coverage;
+
+      sp_rast_count_quads(setup->thread, SP_RAST_QUADS_RASTERIZED, 1);
+      sp_rast_count_time(setup->thread, SP_RAST_SETUP_TIME);
+      pipe->run( pipe, &quad, 1 );
+      sp_rast_count_time(setup->thread, SP_RAST_BLEND_TIME);
    }
 }
 
@@ -191,6 +229,17 @@ block_x(int x)
 }
 
 
+static INLINE void
+reset_spans(struct setup_context *setup)
+{
+   setup->span.y = 0;
+   setup->span.right[0] = 0;
+   setup->span.right[1] = 0;
+   setup->span.left[0] = 1000000;     /* greater than right[0] */
+   setup->span.left[1] = 1000000;     /* greater than right[1] */
+}
+
+
 /**
  * Render a horizontal span of quads
  */
@@ -202,12 +251,18 @@ flush_spans(struct setup_context *setup)
    const int xleft1 = setup->span.left[1];
    const int xright0 = setup->span.right[0];
    const int xright1 = setup->span.right[1];
-   struct quad_stage *pipe = setup->softpipe->quad.first;
+   struct quad_stage *pipe = setup->thread->quad.first;
 
    const int minleft = block_x(MIN2(xleft0, xleft1));
    const int maxright = MAX2(xright0, xright1);
    int x;
 
+   /* both rows are in the same tile, rasterized by the thread owning it */
+   if (!sp_rast_owns_row(setup->thread, setup->span.y)) {
+      reset_spans(setup);
+      return;
+   }
+
    /* process quads in horizontal chunks of 16 */
    for (x = minleft; x < maxright; x += step) {
       unsigned skip_left0 = CLAMP(xleft0 - x, 0, step);
@@ -236,6 +291,7 @@ flush_spans(struct setup_context *setup)
                setup->quad[q].input.y0 = setup->span.y;
                setup->quad[q].input.facing = setup->facing;
                setup->quad[q].inout.mask = quadmask;
+               setup->quad[q].inout.coverage = setup->coverage;
                setup->quad_ptrs[q] = &setup->quad[q];
                q++;
 #if DEBUG_FRAGS
@@ -247,16 +303,15 @@ flush_spans(struct setup_context *setup)
             lx += 2;
          } while (mask0 | mask1);
 
+         sp_rast_count_quads(setup->thread, SP_RAST_QUADS_RASTERIZED, q);
+         sp_rast_count_time(setup->thread, SP_RAST_SETUP_TIME);
          pipe->run( pipe, setup->quad_ptrs, q );
+         sp_rast_count_time(setup->thread, SP_RAST_BLEND_TIME);
       }
    }
 
 
-   setup->span.y = 0;
-   setup->span.right[0] = 0;
-   setup->span.right[1] = 0;
-   setup->span.left[0] = 1000000;     /* greater than right[0] */
-   setup->span.left[1] = 1000000;     /* greater than right[1] */
+   reset_spans(setup);
 }
 
 
@@ -775,6 +830,183 @@ subtriangle(struct setup_context *setup,
 }
 
 
+/**
+ * Set up the edge functions of the triangle for multisample rasterization.
+ */
+static void
+setup_msaa_edges(struct setup_context *setup)
+{
+   const float (*v[3])[4] = { setup->vmin, setup->vmid, setup->vmax };
+   /* the area is positive when vmin, vmid, vmax go clockwise (Y down) */
+   const float sign = setup->oneoverarea > 0.0f ? -1.0f : 1.0f;
+   unsigned i, s, j;
+
+   for (i = 0; i < 3; i++) {
+      const float (*p)[4] = v[i];
+      const float (*q)[4] = v[(i + 1) % 3];
+      struct msaa_edge *edge = &setup->msaa_edge[i];
+
+      edge->a = (p[0][1] - q[0][1]) * sign;
+      edge->b = (q[0][0] - p[0][0]) * sign;
+      edge->c = -(edge->a * p[0][0] + edge->b * p[0][1]);
+
+      /* top-left rule: (a, b) points inside, so a left edge has a > 0 and
+       * a top one a == 0, b > 0
+       */
+      edge->inclusive = edge->a > 0.0f || (edge->a == 0.0f && edge->b > 0.0f);
+
+      for (s = 0; s < SP_MAX_SAMPLES; s++) {
+         for (j = 0; j < TGSI_QUAD_SIZE; j++) {
+            edge->offset[4 * s + j] =
+               edge->a * ((j & 1) + sp_sample_positions[s][0]) +
+               edge->b * ((j >> 1) + sp_sample_positions[s][1]);
+         }
+      }
+   }
+}
+
+
+/**
+ * Samples of the quad at (x0, y0) inside the triangle, as
+ * quad_header_inout::coverage.
+ */
+static INLINE unsigned
+msaa_quad_coverage(const struct setup_context *setup, int x0, int y0)
+{
+   /* sample positions are relative to the pixel's corner */
+   const float fx = x0 + setup->pixel_offset - 0.5f;
+   const float fy = y0 + setup->pixel_offset - 0.5f;
+   unsigned coverage = setup->coverage;
+   unsigned i, bit;
+
+   for (i = 0; i < 3 && coverage; i++) {
+      const struct msaa_edge *edge = &setup->msaa_edge[i];
+      const float e0 = edge->a * fx + edge->b * fy + edge->c;
+      unsigned inside = 0;
+
+      for (bit = 0; bit < 4 * SP_MAX_SAMPLES; bit++) {
+         const float e = e0 + edge->offset[bit];
+
+         if (e > 0.0f || (e == 0.0f && edge->inclusive))
+            inside |= 1 << bit;
+      }
+
+      coverage &= inside;
+   }
+
+   return coverage;
+}
+
+
+/**
+ * Widen [*xmin, *xmax] to the part of segment p-q between ylo and yhi.
+ */
+static void
+segment_extent(const float *p, const float *q, float ylo, float yhi,
+               float *xmin, float *xmax)
+{
+   float x0, x1;
+
+   if (p[1] > q[1]) {
+      const float *t = p;
+      p = q;
+      q = t;
+   }
+
+   if (q[1] < ylo || p[1] > yhi)
+      return;
+
+   if (q[1] == p[1]) {
+      x0 = p[0];
+      x1 = q[0];
+   }
+   else {
+      const float dxdy = (q[0] - p[0]) / (q[1] - p[1]);
+
+      x0 = p[0] + (MAX2(ylo, p[1]) - p[1]) * dxdy;
+      x1 = p[0] + (MIN2(yhi, q[1]) - p[1]) * dxdy;
+   }
+
+   *xmin = MIN3(*xmin, x0, x1);
+   *xmax = MAX3(*xmax, x0, x1);
+}
+
+
+/**
+ * Render a triangle sample by sample, for multisampling.  Each pair of
+ * rows is only scanned where the triangle crosses it, in the same chunks
+ * of quads as flush_spans() uses.
+ */
+static void
+msaa_triangle(struct setup_context *setup)
+{
+   const struct pipe_scissor_state *cliprect = &setup->softpipe->cliprect;
+   const float off = setup->pixel_offset - 0.5f;
+   const float *v0 = setup->vmin[0];
+   const float *v1 = setup->vmid[0];
+   const float *v2 = setup->vmax[0];
+   struct quad_stage *pipe = setup->thread->quad.first;
+   int ystart, yend, y;
+
+   setup_msaa_edges(setup);
+
+   /* the samples are strictly inside their pixel */
+   ystart = MAX2((int) floorf(v0[1] - off) - 1, (int) cliprect->miny);
+   yend = MIN2((int) floorf(v2[1] - off), (int) cliprect->maxy - 1);
+
+   for (y = block(ystart); y <= yend; y += 2) {
+      float xmin = 1e30f, xmax = -1e30f;
+      int xstart, xend, x;
+
+      if (!sp_rast_owns_row(setup->thread, y))
+         continue;
+
+      segment_extent(v0, v1, y + off, y + 2 + off, &xmin, &xmax);
+      segment_extent(v1, v2, y + off, y + 2 + off, &xmin, &xmax);
+      segment_extent(v2, v0, y + off, y + 2 + off, &xmin, &xmax);
+      if (xmin > xmax)
+         continue;
+
+      xstart = MAX2((int) floorf(xmin - off) - 1, (int) cliprect->minx);
+      xend = MIN2((int) floorf(xmax - off), (int) cliprect->maxx - 1);
+
+      for (x = block_x(xstart); x <= xend; x += MAX_QUADS) {
+         unsigned q = 0;
+         int lx;
+
+         for (lx = MAX2(x, block(xstart));
+              lx < x + MAX_QUADS && lx <= xend;
+              lx += 2) {
+            struct quad_header *quad = &setup->quad[q];
+            unsigned coverage = msaa_quad_coverage(setup, lx, y);
+
+            if (!coverage)
+               continue;
+
+            quad->input.x0 = lx;
+            quad->input.y0 = y;
+            quad->input.facing = setup->facing;
+            quad->inout.mask = (coverage | coverage >> 4 |
+                                coverage >> 8 | coverage >> 12) & MASK_ALL;
+            quad_clip(setup, quad);
+            if (!quad->inout.mask)
+               continue;
+
+            quad->inout.coverage = coverage & (quad->inout.mask * 0x1111);
+            setup->quad_ptrs[q++] = quad;
+         }
+
+         if (q) {
+            sp_rast_count_quads(setup->thread, SP_RAST_QUADS_RASTERIZED, q);
+            sp_rast_count_time(setup->thread, SP_RAST_SETUP_TIME);
+            pipe->run( pipe, setup->quad_ptrs, q );
+            sp_rast_count_time(setup->thread, SP_RAST_BLEND_TIME);
+         }
+      }
+   }
+}
+
+
 /**
  * Recalculate prim's determinant.  This is needed as we don't have
  * get this information through the vbuf_render interface & we must
@@ -830,7 +1062,29 @@ sp_setup_tri(struct setup_context *setup,
    if (!setup_sort_vertices( setup, det, v0, v1, v2 ))
       return;
 
+   /* every thread sees every triangle, count them once */
+   if (setup->softpipe->active_statistics_queries &&
+       setup->thread->index == 0) {
+      setup->softpipe->pipeline_statistics.c_primitives++;
+   }
+
+   /* skip the setup work if all the rows are another thread's */
+   {
+      const struct pipe_scissor_state *cliprect = &setup->softpipe->cliprect;
+      const float ymin = MAX2(setup->vmin[0][1] - 1.0f, (float) cliprect->miny);
+      const float ymax = MIN2(setup->vmax[0][1] + 1.0f, (float) cliprect->maxy);
+
+      if (!sp_rast_owns_rows(setup->thread, (int) ymin, (int) ymax))
+         return;
+   }
+
    setup_tri_coefficients( setup );
+
+   if (setup->multisample) {
+      msaa_triangle( setup );
+      return;
+   }
+
    setup_tri_edges( setup );
 
    assert(setup->softpipe->reduced_prim == PIPE_PRIM_TRIANGLES);
@@ -857,10 +1111,6 @@ sp_setup_tri(struct setup_context *setup,
 
    flush_spans( setup );
 
-   if (setup->softpipe->active_statistics_queries) {
-      setup->softpipe->pipeline_statistics.c_primitives++;
-   }
-
 #if DEBUG_FRAGS
    printf("Tri: %u frags emitted, %u written\n",
           setup->numFragsEmitted,
@@ -1414,7 +1664,18 @@ sp_setup_prepare(struct setup_context *setup)
    /* Note: nr_attrs is only used for debugging (vertex printing) */
    setup->nr_vertex_attrs = draw_num_shader_outputs(sp->draw);
 
-   sp->quad.first->begin( sp->quad.first );
+   setup->thread->quad.first->begin( setup->thread->quad.first );
+
+   setup->multisample = sp->nr_samples > 1 && sp->rasterizer->multisample;
+   setup->coverage = 0xffff;
+   if (setup->multisample) {
+      unsigned s;
+
+      for (s = 0; s < SP_MAX_SAMPLES; s++) {
+         if (!(sp->sample_mask & (1 << s)))
+            setup->coverage &= ~(MASK_ALL << (4 * s));
+      }
+   }
 
    if (sp->reduced_api_prim == PIPE_PRIM_TRIANGLES &&
        sp->rasterizer->fill_front == PIPE_POLYGON_MODE_FILL &&
@@ -1440,12 +1701,16 @@ sp_setup_destroy_context(struct setup_context *setup)
  * Create a new primitive setup/render stage.
  */
 struct setup_context *
-sp_setup_create_context(struct softpipe_context *softpipe)
+sp_setup_create_context(struct sp_rast_thread *thread)
 {
    struct setup_context *setup = CALLOC_STRUCT(setup_context);
    unsigned i;
 
-   setup->softpipe = softpipe;
+   if (!setup)
+      return NULL;
+
+   setup->softpipe = thread->softpipe;
+   setup->thread = thread;
 
    for (i = 0; i < MAX_QUADS; i++) {
       setup->quad[i].coef = setup->coef;
@@ -32,6 +32,7 @@
 #include "util/u_memory.h"
 #include "draw/draw_context.h"
 #include "sp_context.h"
+#include "sp_quad.h"
 #include "sp_state.h"
 
 
@@ -128,6 +129,25 @@ static void
 softpipe_set_sample_mask(struct pipe_context *pipe,
                          unsigned sample_mask)
 {
+   struct softpipe_context *softpipe = softpipe_context(pipe);
+
+   draw_flush(softpipe->draw);
+
+   softpipe->sample_mask = sample_mask;
+}
+
+
+static void
+softpipe_get_sample_position(struct pipe_context *pipe,
+                             unsigned sample_count,
+                             unsigned sample_index,
+                             float *out_value)
+{
+   assert(sample_count == SP_MAX_SAMPLES);
+   assert(sample_index < SP_MAX_SAMPLES);
+
+   out_value[0] = sp_sample_positions[sample_index][0];
+   out_value[1] = sp_sample_positions[sample_index][1];
 }
 
 
@@ -147,4 +167,5 @@ softpipe_init_blend_funcs(struct pipe_context *pipe)
    pipe->set_stencil_ref = softpipe_set_stencil_ref;
 
    pipe->set_sample_mask = softpipe_set_sample_mask;
+   pipe->get_sample_position = softpipe_get_sample_position;
 }
@@ -33,6 +33,7 @@
 #include "draw/draw_context.h"
 #include "draw/draw_vertex.h"
 #include "sp_context.h"
+#include "sp_rast.h"
 #include "sp_screen.h"
 #include "sp_state.h"
 #include "sp_texture.h"
@@ -247,6 +248,8 @@ update_tgsi_samplers( struct softpipe_context *softpipe )
          }
       }
    }
+
+   sp_rast_update_samplers(softpipe);
 }
 
 
@@ -261,14 +264,20 @@ update_fragment_shader(struct softpipe_context *softpipe, unsigned prim)
       key.polygon_stipple = softpipe->rasterizer->poly_stipple_enable;
 
    if (softpipe->fs) {
+      unsigned i;
+
       softpipe->fs_variant = softpipe_find_fs_variant(softpipe,
                                                       softpipe->fs, &key);
 
-      /* prepare the TGSI interpreter for FS execution */
-      softpipe->fs_variant->prepare(softpipe->fs_variant, 
-                                    softpipe->fs_machine,
-                                    (struct tgsi_sampler *) softpipe->
-                                    tgsi.sampler[PIPE_SHADER_FRAGMENT]);
+      /* prepare the TGSI interpreters for FS execution */
+      for (i = 0; i < softpipe->num_threads; i++) {
+         struct sp_rast_thread *thread = softpipe->rast[i];
+
+         softpipe->fs_variant->prepare(softpipe->fs_variant,
+                                       thread->fs_machine,
+                                       (struct tgsi_sampler *)
+                                       thread->fs_sampler);
+      }
    }
    else {
       softpipe->fs_variant = NULL;
@@ -396,7 +405,8 @@ softpipe_update_derived(struct softpipe_context *softpipe, unsigned prim)
    if (softpipe->dirty & (SP_NEW_BLEND |
                           SP_NEW_DEPTH_STENCIL_ALPHA |
                           SP_NEW_FRAMEBUFFER |
-                          SP_NEW_FS))
+                          SP_NEW_FS |
+                          SP_NEW_QUERY))
       sp_build_quad_pipeline(softpipe);
 
    softpipe->dirty = 0;
@@ -71,6 +71,11 @@ softpipe_bind_sampler_states(struct pipe_context *pipe,
       softpipe->samplers[shader][start + i] = samplers[i];
    }
 
+   /* the views' filters were chosen for the old ones */
+   for (i = 0; i < PIPE_MAX_SHADER_SAMPLER_VIEWS; i++) {
+      softpipe->tgsi.sampler[shader]->sp_sview[i].filter_samp = NULL;
+   }
+
    /* find highest non-null samplers[] entry */
    {
       unsigned j = MAX2(softpipe->num_samplers[shader], start + num);
@@ -28,6 +28,7 @@
 #include "sp_context.h"
 #include "sp_state.h"
 #include "sp_fs.h"
+#include "sp_rast.h"
 #include "sp_texture.h"
 
 #include "pipe/p_defines.h"
@@ -38,6 +39,7 @@
 #include "draw/draw_vs.h"
 #include "draw/draw_gs.h"
 #include "tgsi/tgsi_dump.h"
+#include "tgsi/tgsi_exec.h"
 #include "tgsi/tgsi_scan.h"
 #include "tgsi/tgsi_parse.h"
 
@@ -64,7 +66,9 @@ create_fs_variant(struct softpipe_context *softpipe,
 #endif
 
    /* codegen, create variant object */
-   var = softpipe_create_fs_variant_exec(softpipe, curfs);
+   var = softpipe_create_fs_variant_sse(softpipe, curfs);
+   if (!var)
+      var = softpipe_create_fs_variant_exec(softpipe, curfs);
 
    if (var) {
       var->key = *key;
@@ -178,6 +182,7 @@ softpipe_delete_fs_state(struct pipe_context *pipe, void *fs)
    struct softpipe_context *softpipe = softpipe_context(pipe);
    struct sp_fragment_shader *state = fs;
    struct sp_fragment_shader_variant *var, *next_var;
+   unsigned i;
 
    assert(fs != softpipe->fs);
 
@@ -192,7 +197,16 @@ softpipe_delete_fs_state(struct pipe_context *pipe, void *fs)
       draw_delete_fragment_shader(softpipe->draw, var->draw_shader);
 #endif
 
-      var->delete(var, softpipe->fs_machine);
+      /* the variant only unbinds itself from the first thread's machine */
+      for (i = 1; i < Elements(softpipe->rast); i++) {
+         struct tgsi_exec_machine *machine =
+            softpipe->rast[i] ? softpipe->rast[i]->fs_machine : NULL;
+
+         if (machine && machine->Tokens == var->tokens)
+            tgsi_exec_machine_bind_shader(machine, NULL, NULL);
+      }
+
+      var->delete(var, softpipe->rast[0]->fs_machine);
    }
 
    draw_delete_fragment_shader(softpipe->draw, state->draw_shader);
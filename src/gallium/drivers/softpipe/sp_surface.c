@@ -26,10 +26,164 @@
  **************************************************************************/
 
 #include "util/u_format.h"
+#include "util/u_inlines.h"
+#include "util/u_memory.h"
 #include "util/u_surface.h"
 #include "sp_context.h"
 #include "sp_surface.h"
 #include "sp_query.h"
+#include "sp_texture.h"
+
+
+/**
+ * Resolve a multisample resource into a single-sample one.  Colours are
+ * averaged over the samples, integer, depth and stencil values are those of
+ * the first sample.  The rectangles must be the same size, but may be
+ * mirrored.
+ */
+static void
+sp_blit_resolve(struct pipe_context *pipe,
+                const struct pipe_blit_info *info)
+{
+   const enum pipe_format src_format = info->src.format;
+   const enum pipe_format dst_format = info->dst.format;
+   const unsigned samples = sp_resource_samples(info->src.resource);
+   const boolean zs = util_format_is_depth_or_stencil(src_format);
+   const boolean uint = util_format_is_pure_uint(src_format);
+   const boolean sint = util_format_is_pure_sint(src_format);
+   const unsigned w = abs(info->src.box.width);
+   const unsigned h = abs(info->src.box.height);
+   const int src_x = MIN2(info->src.box.x, info->src.box.x + info->src.box.width);
+   const int src_y = MIN2(info->src.box.y, info->src.box.y + info->src.box.height);
+   const int dst_x = MIN2(info->dst.box.x, info->dst.box.x + info->dst.box.width);
+   const int dst_y = MIN2(info->dst.box.y, info->dst.box.y + info->dst.box.height);
+   const boolean flip_x = (info->src.box.width < 0) != (info->dst.box.width < 0);
+   const boolean flip_y = (info->src.box.height < 0) != (info->dst.box.height < 0);
+   int x0 = dst_x, y0 = dst_y, x1 = dst_x + w, y1 = dst_y + h;
+   struct pipe_transfer *src_trans, *dst_trans;
+   const ubyte *src_map;
+   ubyte *dst_map;
+   int x, y;
+
+   if (abs(info->dst.box.width) != w || abs(info->dst.box.height) != h ||
+       (zs && util_format_get_blocksize(src_format) !=
+              util_format_get_blocksize(dst_format)) ||
+       uint != util_format_is_pure_uint(dst_format) ||
+       sint != util_format_is_pure_sint(dst_format)) {
+      debug_printf("softpipe: resolve unsupported %s -> %s\n",
+                   util_format_short_name(src_format),
+                   util_format_short_name(dst_format));
+      return;
+   }
+
+   if (info->scissor_enable) {
+      x0 = MAX2(x0, (int) info->scissor.minx);
+      y0 = MAX2(y0, (int) info->scissor.miny);
+      x1 = MIN2(x1, (int) info->scissor.maxx);
+      y1 = MIN2(y1, (int) info->scissor.maxy);
+   }
+   if (x0 >= x1 || y0 >= y1)
+      return;
+
+   src_map = pipe_transfer_map_3d(pipe, info->src.resource, info->src.level,
+                                  PIPE_TRANSFER_READ,
+                                  src_x, src_y, info->src.box.z * samples,
+                                  w, h, samples, &src_trans);
+   if (!src_map)
+      return;
+
+   dst_map = pipe_transfer_map(pipe, info->dst.resource, info->dst.level,
+                               info->dst.box.z, PIPE_TRANSFER_WRITE,
+                               x0, y0, x1 - x0, y1 - y0, &dst_trans);
+   if (!dst_map) {
+      pipe->transfer_unmap(pipe, src_trans);
+      return;
+   }
+
+   if (zs) {
+      const unsigned bpp = util_format_get_blocksize(src_format);
+
+      for (y = y0; y < y1; y++) {
+         const int sy = flip_y ? dst_y + (int) h - 1 - y : y - dst_y;
+         ubyte *dst_row = dst_map + (y - y0) * dst_trans->stride;
+
+         for (x = x0; x < x1; x++) {
+            const int sx = flip_x ? dst_x + (int) w - 1 - x : x - dst_x;
+
+            memcpy(dst_row + (x - x0) * bpp,
+                   src_map + sy * src_trans->stride + sx * bpp, bpp);
+         }
+      }
+   }
+   else {
+      /* the samples' texels, summed for colours, in rows of w */
+      float *texels = MALLOC(w * h * 4 * sizeof(float));
+      float *row = MALLOC(w * 4 * sizeof(float));
+      unsigned s, i;
+
+      if (texels && row) {
+         for (y = 0; y < (int) h; y++) {
+            float *texel_row = texels + y * w * 4;
+            const ubyte *src_row = src_map + y * src_trans->stride;
+
+            if (uint) {
+               util_format_read_4ui(src_format, (unsigned *) texel_row, 0,
+                                    src_row, src_trans->stride, 0, 0, w, 1);
+               continue;
+            }
+            if (sint) {
+               util_format_read_4i(src_format, (int *) texel_row, 0,
+                                   src_row, src_trans->stride, 0, 0, w, 1);
+               continue;
+            }
+
+            util_format_read_4f(src_format, texel_row, 0,
+                                src_row, src_trans->stride, 0, 0, w, 1);
+            for (s = 1; s < samples; s++) {
+               util_format_read_4f(src_format, row, 0,
+                                   src_row + s * src_trans->layer_stride,
+                                   src_trans->stride, 0, 0, w, 1);
+               for (i = 0; i < w * 4; i++)
+                  texel_row[i] += row[i];
+            }
+            for (i = 0; i < w * 4; i++)
+               texel_row[i] *= 1.0f / samples;
+         }
+
+         for (y = y0; y < y1; y++) {
+            const int sy = flip_y ? dst_y + (int) h - 1 - y : y - dst_y;
+            ubyte *dst_row = dst_map + (y - y0) * dst_trans->stride;
+
+            for (x = x0; x < x1; x++) {
+               const int sx = flip_x ? dst_x + (int) w - 1 - x : x - dst_x;
+
+               memcpy(row + (x - x0) * 4, texels + (sy * w + sx) * 4,
+                      4 * sizeof(float));
+            }
+
+            if (uint)
+               util_format_write_4ui(dst_format, (const unsigned *) row, 0,
+                                     dst_row, dst_trans->stride,
+                                     0, 0, x1 - x0, 1);
+            else if (sint)
+               util_format_write_4i(dst_format, (const int *) row, 0,
+                                    dst_row, dst_trans->stride,
+                                    0, 0, x1 - x0, 1);
+            else
+               util_format_write_4f(dst_format, row, 0,
+                                    dst_row, dst_trans->stride,
+                                    0, 0, x1 - x0, 1);
+         }
+      }
+
+      FREE(texels);
+      FREE(row);
+   }
+
+   pipe->transfer_unmap(pipe, dst_trans);
+   pipe->transfer_unmap(pipe, src_trans);
+}
+
 
 static void sp_blit(struct pipe_context *pipe,
                     const struct pipe_blit_info *info)
@@ -37,10 +191,8 @@ static void sp_blit(struct pipe_context *pipe,
    struct softpipe_context *sp = softpipe_context(pipe);
 
    if (info->src.resource->nr_samples > 1 &&
-       info->dst.resource->nr_samples <= 1 &&
-       !util_format_is_depth_or_stencil(info->src.resource->format) &&
-       !util_format_is_pure_integer(info->src.resource->format)) {
-      debug_printf("softpipe: color resolve unimplemented\n");
+       info->dst.resource->nr_samples <= 1) {
+      sp_blit_resolve(pipe, info);
       return;
    }
 
@@ -83,6 +235,47 @@ static void sp_blit(struct pipe_context *pipe,
    util_blitter_blit(sp->blitter, info);
 }
 
+/**
+ * The samples of a multisample resource are layers to transfers, see
+ * sp_resource_samples().  Copies and clears have their layers scaled.
+ */
+static void
+softpipe_resource_copy_region(struct pipe_context *pipe,
+                              struct pipe_resource *dst,
+                              unsigned dst_level,
+                              unsigned dstx, unsigned dsty, unsigned dstz,
+                              struct pipe_resource *src,
+                              unsigned src_level,
+                              const struct pipe_box *src_box)
+{
+   const unsigned samples = sp_resource_samples(src);
+   struct pipe_box box = *src_box;
+
+   assert(sp_resource_samples(dst) == samples);
+
+   box.z *= samples;
+   box.depth *= samples;
+
+   util_resource_copy_region(pipe, dst, dst_level, dstx, dsty, dstz * samples,
+                             src, src_level, &box);
+}
+
+
+/**
+ * A copy of ps with the layers of all the samples.
+ */
+static INLINE void
+sample_layers_surface(struct pipe_surface *samples_ps,
+                      const struct pipe_surface *ps)
+{
+   const unsigned samples = sp_resource_samples(ps->texture);
+
+   *samples_ps = *ps;
+   samples_ps->u.tex.first_layer = ps->u.tex.first_layer * samples;
+   samples_ps->u.tex.last_layer = ps->u.tex.last_layer * samples + samples - 1;
+}
+
+
 static void
 softpipe_clear_render_target(struct pipe_context *pipe,
                              struct pipe_surface *dst,
@@ -95,6 +288,15 @@ softpipe_clear_render_target(struct pipe_context *pipe,
    if (!softpipe_check_render_cond(softpipe))
       return;
 
+   if (dst->texture->nr_samples > 1) {
+      struct pipe_surface samples_surf;
+
+      sample_layers_surface(&samples_surf, dst);
+      util_clear_render_target(pipe, &samples_surf, color,
+                               dstx, dsty, width, height);
+      return;
+   }
+
    util_clear_render_target(pipe, dst, color,
                             dstx, dsty, width, height);
 }
@@ -114,6 +316,16 @@ softpipe_clear_depth_stencil(struct pipe_context *pipe,
    if (!softpipe_check_render_cond(softpipe))
       return;
 
+   if (dst->texture->nr_samples > 1) {
+      struct pipe_surface samples_surf;
+
+      sample_layers_surface(&samples_surf, dst);
+      util_clear_depth_stencil(pipe, &samples_surf, clear_flags,
+                               depth, stencil,
+                               dstx, dsty, width, height);
+      return;
+   }
+
    util_clear_depth_stencil(pipe, dst, clear_flags,
                             depth, stencil,
                             dstx, dsty, width, height);
@@ -123,7 +335,7 @@ softpipe_clear_depth_stencil(struct pipe_context *pipe,
 void
 sp_init_surface_functions(struct softpipe_context *sp)
 {
-   sp->pipe.resource_copy_region = util_resource_copy_region;
+   sp->pipe.resource_copy_region = softpipe_resource_copy_region;
    sp->pipe.clear_render_target = softpipe_clear_render_target;
    sp->pipe.clear_depth_stencil = softpipe_clear_depth_stencil;
    sp->pipe.blit = sp_blit;
@@ -42,6 +42,7 @@
 #include "util/u_memory.h"
 #include "util/u_inlines.h"
 #include "sp_quad.h"   /* only for #define QUAD_* tokens */
+#include "sp_rast.h"
 #include "sp_tex_sample.h"
 #include "sp_texture.h"
 #include "sp_tex_tile_cache.h"
@@ -1047,6 +1048,64 @@ img_filter_2d_nearest_clamp_POT(struct sp_sampler_view *sp_sview,
 }
 
 
+static INLINE void
+img_filter_2d_linear_clamp_POT(struct sp_sampler_view *sp_sview,
+                               struct sp_sampler *sp_samp,
+                               float s,
+                               float t,
+                               float p,
+                               unsigned level,
+                               unsigned face_id,
+                               float *rgba)
+{
+   unsigned xpot = pot_level_size(sp_sview->xpot, level);
+   unsigned ypot = pot_level_size(sp_sview->ypot, level);
+   union tex_tile_address addr;
+   int c;
+
+   float u = CLAMP(s, 0.0F, 1.0F) * xpot - 0.5F;
+   float v = CLAMP(t, 0.0F, 1.0F) * ypot - 0.5F;
+
+   int uflr = util_ifloor(u);
+   int vflr = util_ifloor(v);
+
+   float xw = u - (float)uflr;
+   float yw = v - (float)vflr;
+
+   int x0 = MAX2(uflr, 0);
+   int y0 = MAX2(vflr, 0);
+   int x1 = MIN2(uflr + 1, (int) xpot - 1);
+   int y1 = MIN2(vflr + 1, (int) ypot - 1);
+
+   const float *tx[4];
+
+   addr.value = 0;
+   addr.bits.level = level;
+
+   /* Can we fetch all four at once:
+    */
+   if (x1 == x0 + 1 && y1 == y0 + 1 &&
+       (x0 % TEX_TILE_SIZE) != TEX_TILE_SIZE - 1 &&
+       (y0 % TEX_TILE_SIZE) != TEX_TILE_SIZE - 1) {
+      get_texel_quad_2d_no_border_single_tile(sp_sview, addr, x0, y0, tx);
+   }
+   else {
+      get_texel_quad_2d_no_border(sp_sview, addr, x0, y0, x1, y1, tx);
+   }
+
+   /* interpolate R, G, B, A */
+   for (c = 0; c < TGSI_QUAD_SIZE; c++) {
+      rgba[TGSI_NUM_CHANNELS*c] = lerp_2d(xw, yw,
+                                       tx[0][c], tx[1][c],
+                                       tx[2][c], tx[3][c]);
+   }
+
+   if (DEBUG_TEX) {
+      print_sample(__FUNCTION__, rgba);
+   }
+}
+
+
 static void
 img_filter_1d_nearest(struct sp_sampler_view *sp_sview,
                       struct sp_sampler *sp_samp,
@@ -1895,6 +1954,82 @@ mip_filter_none_no_filter_select(struct sp_sampler_view *sp_sview,
 }
 
 
+/**
+ * mip_filter_none_no_filter_select() with a known image filter, which
+ * gets inlined into the specialized versions below.
+ */
+static INLINE void
+mip_filter_none_2d_POT(struct sp_sampler_view *sp_sview,
+                       struct sp_sampler *sp_samp,
+                       img_filter_func filter,
+                       const float s[TGSI_QUAD_SIZE],
+                       const float t[TGSI_QUAD_SIZE],
+                       const float p[TGSI_QUAD_SIZE],
+                       float rgba[TGSI_NUM_CHANNELS][TGSI_QUAD_SIZE])
+{
+   const unsigned level = sp_sview->base.u.tex.first_level;
+   int j;
+
+   for (j = 0; j < TGSI_QUAD_SIZE; j++)
+      filter(sp_sview, sp_samp, s[j], t[j], p[j], level,
+             sp_sview->faces[j], &rgba[0][j]);
+}
+
+
+static void
+mip_filter_none_2d_linear_repeat_POT(struct sp_sampler_view *sp_sview,
+                                     struct sp_sampler *sp_samp,
+                                     img_filter_func min_filter,
+                                     img_filter_func mag_filter,
+                                     const float s[TGSI_QUAD_SIZE],
+                                     const float t[TGSI_QUAD_SIZE],
+                                     const float p[TGSI_QUAD_SIZE],
+                                     const float c0[TGSI_QUAD_SIZE],
+                                     const float lod_in[TGSI_QUAD_SIZE],
+                                     enum tgsi_sampler_control control,
+                                     float rgba[TGSI_NUM_CHANNELS][TGSI_QUAD_SIZE])
+{
+   mip_filter_none_2d_POT(sp_sview, sp_samp, img_filter_2d_linear_repeat_POT,
+                          s, t, p, rgba);
+}
+
+
+static void
+mip_filter_none_2d_linear_clamp_POT(struct sp_sampler_view *sp_sview,
+                                    struct sp_sampler *sp_samp,
+                                    img_filter_func min_filter,
+                                    img_filter_func mag_filter,
+                                    const float s[TGSI_QUAD_SIZE],
+                                    const float t[TGSI_QUAD_SIZE],
+                                    const float p[TGSI_QUAD_SIZE],
+                                    const float c0[TGSI_QUAD_SIZE],
+                                    const float lod_in[TGSI_QUAD_SIZE],
+                                    enum tgsi_sampler_control control,
+                                    float rgba[TGSI_NUM_CHANNELS][TGSI_QUAD_SIZE])
+{
+   mip_filter_none_2d_POT(sp_sview, sp_samp, img_filter_2d_linear_clamp_POT,
+                          s, t, p, rgba);
+}
+
+
+static void
+mip_filter_none_2d_nearest_repeat_POT(struct sp_sampler_view *sp_sview,
+                                      struct sp_sampler *sp_samp,
+                                      img_filter_func min_filter,
+                                      img_filter_func mag_filter,
+                                      const float s[TGSI_QUAD_SIZE],
+                                      const float t[TGSI_QUAD_SIZE],
+                                      const float p[TGSI_QUAD_SIZE],
+                                      const float c0[TGSI_QUAD_SIZE],
+                                      const float lod_in[TGSI_QUAD_SIZE],
+                                      enum tgsi_sampler_control control,
+                                      float rgba[TGSI_NUM_CHANNELS][TGSI_QUAD_SIZE])
+{
+   mip_filter_none_2d_POT(sp_sview, sp_samp, img_filter_2d_nearest_repeat_POT,
+                          s, t, p, rgba);
+}
+
+
 /* For anisotropic filtering */
 #define WEIGHT_LUT_SIZE 1024
 
@@ -2614,6 +2749,17 @@ get_img_filter(const struct sp_sampler_view *sp_sview,
             default:
                break;
             }
+            break;
+         case PIPE_TEX_WRAP_CLAMP_TO_EDGE:
+            switch (filter) {
+            case PIPE_TEX_FILTER_NEAREST:
+               return img_filter_2d_nearest_clamp_POT;
+            case PIPE_TEX_FILTER_LINEAR:
+               return img_filter_2d_linear_clamp_POT;
+            default:
+               break;
+            }
+            break;
          }
       }
       /* Otherwise use default versions:
@@ -2654,6 +2800,49 @@ get_img_filter(const struct sp_sampler_view *sp_sview,
 }
 
 
+/**
+ * Pick the mip and image filters for sampling the view with the sampler,
+ * using the specialized versions where the state allows.
+ */
+static void
+choose_filters(struct sp_sampler_view *sp_sview,
+               struct sp_sampler *sp_samp)
+{
+   const struct pipe_sampler_state *sampler = &sp_samp->base;
+
+   sp_sview->filter_samp = sp_samp;
+   sp_sview->min_img_filter = NULL;
+   sp_sview->mag_img_filter = NULL;
+
+   if (sp_sview->pot2d & sp_samp->min_mag_equal_repeat_linear) {
+      sp_sview->mip_filter = mip_filter_linear_2d_linear_repeat_POT;
+      return;
+   }
+
+   sp_sview->min_img_filter =
+      get_img_filter(sp_sview, sampler, sp_samp->min_img_filter);
+   if (sp_samp->min_mag_equal) {
+      sp_sview->mag_img_filter = sp_sview->min_img_filter;
+   }
+   else {
+      sp_sview->mag_img_filter =
+         get_img_filter(sp_sview, sampler, sampler->mag_img_filter);
+   }
+
+   sp_sview->mip_filter = sp_samp->mip_filter;
+
+   /* no mipmapping and nothing to select: sample the quad in one go */
+   if (sp_samp->mip_filter == mip_filter_none_no_filter_select) {
+      if (sp_sview->mag_img_filter == img_filter_2d_linear_repeat_POT)
+         sp_sview->mip_filter = mip_filter_none_2d_linear_repeat_POT;
+      else if (sp_sview->mag_img_filter == img_filter_2d_linear_clamp_POT)
+         sp_sview->mip_filter = mip_filter_none_2d_linear_clamp_POT;
+      else if (sp_sview->mag_img_filter == img_filter_2d_nearest_repeat_POT)
+         sp_sview->mip_filter = mip_filter_none_2d_nearest_repeat_POT;
+   }
+}
+
+
 static void
 sample_mip(struct sp_sampler_view *sp_sview,
            struct sp_sampler *sp_samp,
@@ -2665,26 +2854,12 @@ sample_mip(struct sp_sampler_view *sp_sview,
            enum tgsi_sampler_control control,
            float rgba[TGSI_NUM_CHANNELS][TGSI_QUAD_SIZE])
 {
-   mip_filter_func mip_filter;
-   img_filter_func min_img_filter = NULL;
-   img_filter_func mag_img_filter = NULL;
-
-   if (sp_sview->pot2d & sp_samp->min_mag_equal_repeat_linear) {
-      mip_filter = mip_filter_linear_2d_linear_repeat_POT;
-   }
-   else {
-      mip_filter = sp_samp->mip_filter;
-      min_img_filter = get_img_filter(sp_sview, &sp_samp->base, sp_samp->min_img_filter);
-      if (sp_samp->min_mag_equal) {
-         mag_img_filter = min_img_filter;
-      }
-      else {
-         mag_img_filter = get_img_filter(sp_sview, &sp_samp->base, sp_samp->base.mag_img_filter);
-      }
-   }
+   if (sp_sview->filter_samp != sp_samp)
+      choose_filters(sp_sview, sp_samp);
 
-   mip_filter(sp_sview, sp_samp, min_img_filter, mag_img_filter,
-              s, t, p, c0, lod, control, rgba);
+   sp_sview->mip_filter(sp_sview, sp_samp,
+                        sp_sview->min_img_filter, sp_sview->mag_img_filter,
+                        s, t, p, c0, lod, control, rgba);
 
    if (sp_samp->base.compare_mode != PIPE_TEX_COMPARE_NONE) {
       sample_compare(sp_sview, sp_samp, s, t, p, c0, lod, control, rgba);
@@ -2718,9 +2893,10 @@ sample_cube(struct sp_sampler_view *sp_sview,
    float ssss[4], tttt[4];
 
    /* Not actually used, but the intermediate steps that do the
-    * dereferencing don't know it.
+    * dereferencing don't know it.  Not static: rasterizer threads may be
+    * sampling at the same time.
     */
-   static float pppp[4] = { 0, 0, 0, 0 };
+   float pppp[4];
 
    pppp[0] = c0[0];
    pppp[1] = c0[1];
@@ -3118,9 +3294,13 @@ sp_tgsi_get_samples(struct tgsi_sampler *tgsi_sampler,
    assert(sp_samp->sp_sampler[sampler_index]);
    /* FIXME should have defined behavior if no texture is bound. */
    assert(sp_samp->sp_sview[sview_index].get_samples);
+   if (sp_samp->thread)
+      sp_rast_count_time(sp_samp->thread, SP_RAST_SHADE_TIME);
    sp_samp->sp_sview[sview_index].get_samples(&sp_samp->sp_sview[sview_index],
                                               sp_samp->sp_sampler[sampler_index],
                                               s, t, p, c0, lod, control, rgba);
+   if (sp_samp->thread)
+      sp_rast_count_time(sp_samp->thread, SP_RAST_TEX_TIME);
 }
 
 
@@ -3137,7 +3317,11 @@ sp_tgsi_get_texel(struct tgsi_sampler *tgsi_sampler,
    assert(sview_index < PIPE_MAX_SHADER_SAMPLER_VIEWS);
    /* FIXME should have defined behavior if no texture is bound. */
    assert(sp_samp->sp_sview[sview_index].base.texture);
+   if (sp_samp->thread)
+      sp_rast_count_time(sp_samp->thread, SP_RAST_SHADE_TIME);
    sp_get_texels(&sp_samp->sp_sview[sview_index], i, j, k, lod, offset, rgba);
+   if (sp_samp->thread)
+      sp_rast_count_time(sp_samp->thread, SP_RAST_TEX_TIME);
 }
 
 
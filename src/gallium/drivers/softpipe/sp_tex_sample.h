@@ -33,6 +33,9 @@
 #include "tgsi/tgsi_exec.h"
 
 
+struct sp_rast_thread;
+
+
 struct sp_sampler_view;
 struct sp_sampler;
 
@@ -105,6 +108,14 @@ struct sp_sampler_view
 
    filter_func get_samples;
 
+   /* Filters sample_mip() chose for filter_samp, the sampler the view was
+    * last used with.  Reset whenever samplers get bound.
+    */
+   const struct sp_sampler *filter_samp;
+   mip_filter_func mip_filter;
+   img_filter_func min_img_filter;
+   img_filter_func mag_img_filter;
+
    /* this is just abusing the sampler_view object as local storage */
    unsigned faces[TGSI_QUAD_SIZE];
 
@@ -143,6 +154,8 @@ struct sp_tgsi_sampler
    struct sp_sampler *sp_sampler[PIPE_MAX_SAMPLERS];
    struct sp_sampler_view sp_sview[PIPE_MAX_SHADER_SAMPLER_VIEWS];
 
+   /** The rasterizer thread of a fragment sampler, to time sampling */
+   struct sp_rast_thread *thread;
 };
 
 compute_lambda_func
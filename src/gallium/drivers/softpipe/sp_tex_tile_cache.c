@@ -41,25 +41,63 @@
 #include "sp_texture.h"
 #include "sp_tex_tile_cache.h"
 
-   
+
+
+DEBUG_GET_ONCE_NUM_OPTION(tex_cache_tiles, "SOFTPIPE_TEX_CACHE_TILES",
+                          DEFAULT_TEX_TILE_ENTRIES)
+
+
+/**
+ * Mark all cached tiles as invalid/empty.
+ */
+static void
+tex_cache_invalidate(struct softpipe_tex_tile_cache *tc)
+{
+   uint pos;
+
+   for (pos = 0; pos < tc->num_sets * TEX_TILE_WAYS; pos++) {
+      if (tc->entries[pos])
+         tc->entries[pos]->addr.bits.invalid = 1;
+   }
+}
+
 
 struct softpipe_tex_tile_cache *
 sp_create_tex_tile_cache( struct pipe_context *pipe )
 {
    struct softpipe_tex_tile_cache *tc;
-   uint pos;
+   long num_tiles;
 
    /* make sure max texture size works */
    assert((TEX_TILE_SIZE << TEX_ADDR_BITS) >= (1 << (SP_MAX_TEXTURE_2D_LEVELS-1)));
 
    tc = CALLOC_STRUCT( softpipe_tex_tile_cache );
-   if (tc) {
-      tc->pipe = pipe;
-      for (pos = 0; pos < Elements(tc->entries); pos++) {
-         tc->entries[pos].addr.bits.invalid = 1;
-      }
-      tc->last_tile = &tc->entries[0]; /* any tile */
+   if (!tc)
+      return NULL;
+
+   tc->pipe = pipe;
+
+   num_tiles = debug_get_option_tex_cache_tiles();
+   num_tiles = CLAMP(num_tiles, TEX_TILE_WAYS, 1 << 16);
+   tc->num_sets = util_next_power_of_two(num_tiles / TEX_TILE_WAYS);
+
+   tc->entries = CALLOC(tc->num_sets * TEX_TILE_WAYS, sizeof tc->entries[0]);
+   if (!tc->entries) {
+      FREE(tc);
+      return NULL;
+   }
+
+   /* last_tile must always point at a tile */
+   tc->entries[0] = MALLOC_STRUCT(softpipe_tex_cached_tile);
+   if (!tc->entries[0]) {
+      FREE(tc->entries);
+      FREE(tc);
+      return NULL;
    }
+   tc->entries[0]->addr.value = 0;
+   tc->entries[0]->addr.bits.invalid = 1;
+   tc->last_tile = tc->entries[0];
+
    return tc;
 }
 
@@ -70,8 +108,8 @@ sp_destroy_tex_tile_cache(struct softpipe_tex_tile_cache *tc)
    if (tc) {
       uint pos;
 
-      for (pos = 0; pos < Elements(tc->entries); pos++) {
-         /*assert(tc->entries[pos].x < 0);*/
+      for (pos = 0; pos < tc->num_sets * TEX_TILE_WAYS; pos++) {
+         FREE(tc->entries[pos]);
       }
       if (tc->transfer) {
          tc->pipe->transfer_unmap(tc->pipe, tc->transfer);
@@ -80,6 +118,7 @@ sp_destroy_tex_tile_cache(struct softpipe_tex_tile_cache *tc)
          tc->pipe->transfer_unmap(tc->pipe, tc->tex_trans);
       }
 
+      FREE( tc->entries );
       FREE( tc );
    }
 }
@@ -92,14 +131,10 @@ sp_destroy_tex_tile_cache(struct softpipe_tex_tile_cache *tc)
 void
 sp_tex_tile_cache_validate_texture(struct softpipe_tex_tile_cache *tc)
 {
-   unsigned i;
-
    assert(tc);
    assert(tc->texture);
 
-   for (i = 0; i < Elements(tc->entries); i++) {
-      tc->entries[i].addr.bits.invalid = 1;
-   }
+   tex_cache_invalidate(tc);
 }
 
 static boolean
@@ -124,7 +159,6 @@ sp_tex_tile_cache_set_sampler_view(struct softpipe_tex_tile_cache *tc,
                                    struct pipe_sampler_view *view)
 {
    struct pipe_resource *texture = view ? view->texture : NULL;
-   uint i;
 
    assert(!tc->transfer);
 
@@ -147,9 +181,7 @@ sp_tex_tile_cache_set_sampler_view(struct softpipe_tex_tile_cache *tc,
 
       /* mark as entries as invalid/empty */
       /* XXX we should try to avoid this when the teximage hasn't changed */
-      for (i = 0; i < Elements(tc->entries); i++) {
-         tc->entries[i].addr.bits.invalid = 1;
-      }
+      tex_cache_invalidate(tc);
 
       tc->tex_face = -1; /* any invalid value here */
    }
@@ -165,13 +197,9 @@ sp_tex_tile_cache_set_sampler_view(struct softpipe_tex_tile_cache *tc,
 void
 sp_flush_tex_tile_cache(struct softpipe_tex_tile_cache *tc)
 {
-   int pos;
-
    if (tc->texture) {
       /* caching a texture, mark all entries as empty */
-      for (pos = 0; pos < Elements(tc->entries); pos++) {
-         tc->entries[pos].addr.bits.invalid = 1;
-      }
+      tex_cache_invalidate(tc);
       tc->tex_face = -1;
    }
 
@@ -180,13 +208,11 @@ sp_flush_tex_tile_cache(struct softpipe_tex_tile_cache *tc)
 
 /**
  * Given the texture face, level, zslice, x and y values, compute
- * the cache entry position/index where we'd hope to find the
- * cached texture tile.
- * This is basically a direct-map cache.
- * XXX There's probably lots of ways in which we can improve this.
+ * the cache set where we'd hope to find the cached texture tile.
  */
 static INLINE uint
-tex_cache_pos( union tex_tile_address addr )
+tex_cache_set( const struct softpipe_tex_tile_cache *tc,
+               union tex_tile_address addr )
 {
    uint entry = (addr.bits.x + 
                  addr.bits.y * 9 + 
@@ -194,7 +220,7 @@ tex_cache_pos( union tex_tile_address addr )
                  addr.bits.face + 
                  addr.bits.level * 7);
 
-   return entry % NUM_TEX_TILE_ENTRIES;
+   return entry & (tc->num_sets - 1);
 }
 
 /**
@@ -205,24 +231,52 @@ const struct softpipe_tex_cached_tile *
 sp_find_cached_tile_tex(struct softpipe_tex_tile_cache *tc, 
                         union tex_tile_address addr )
 {
-   struct softpipe_tex_cached_tile *tile;
+   struct softpipe_tex_cached_tile **set =
+      tc->entries + tex_cache_set(tc, addr) * TEX_TILE_WAYS;
+   struct softpipe_tex_cached_tile *tile = NULL;
    boolean zs = util_format_is_depth_or_stencil(tc->format);
+   uint way;
 
-   tile = tc->entries + tex_cache_pos( addr );
-
-   if (addr.value != tile->addr.value) {
+   for (way = 0; way < TEX_TILE_WAYS; way++) {
+      tile = set[way];
+      if (!tile || tile->addr.value == addr.value)
+         break;
+   }
 
+   if (way < TEX_TILE_WAYS && tile) {
+      tc->hits++;
+   }
+   else {
       /* cache miss.  Most misses are because we've invalidated the
        * texture cache previously -- most commonly on binding a new
        * texture.  Currently we effectively flush the cache on texture
        * bind.
        */
-#if 0
-      _debug_printf("miss at %u:  x=%d y=%d z=%d face=%d level=%d\n"
-                    "   tile %u:  x=%d y=%d z=%d face=%d level=%d\n",
-                    pos, x/TILE_SIZE, y/TILE_SIZE, z, face, level,
-                    pos, tile->addr.bits.x, tile->addr.bits.y, tile->z, tile->face, tile->level);
-#endif
+      tc->misses++;
+
+      if (way == TEX_TILE_WAYS) {
+         /* replace the least recently used tile */
+         way = TEX_TILE_WAYS - 1;
+         tile = set[way];
+      }
+      else {
+         tile = MALLOC_STRUCT(softpipe_tex_cached_tile);
+         if (tile) {
+            set[way] = tile;
+         }
+         else if (way > 0) {
+            way--;
+            tile = set[way];
+         }
+         else {
+            /* Out of memory with an empty set: reuse the last tile where it
+             * is.  Its new address doesn't hash to that set, so it is never
+             * found there again, only replaced.
+             */
+            way = TEX_TILE_WAYS;
+            tile = tc->last_tile;
+         }
+      }
 
       /* check if we need to get a new transfer */
       if (!tc->tex_trans ||
@@ -291,6 +345,12 @@ sp_find_cached_tile_tex(struct softpipe_tex_tile_cache *tc,
       tile->addr = addr;
    }
 
+   if (way < TEX_TILE_WAYS) {
+      /* move the tile to the front of its set */
+      memmove(set + 1, set, way * sizeof set[0]);
+      set[0] = tile;
+   }
+
    tc->last_tile = tile;
    return tile;
 }
@@ -74,12 +74,15 @@ struct softpipe_tex_cached_tile
 };
 
 /*
- * The number of cache entries.
- * Should not be decreased to lower than 16, and even that
- * seems too low to avoid cache thrashing in some cases (because
- * the cache is direct mapped, see tex_cache_pos() function).
+ * The cache is set associative: a tile can go in any of the TEX_TILE_WAYS
+ * entries of the set its address hashes to (see tex_cache_set()), and the
+ * least recently used one is replaced on a miss.  The number of entries
+ * can be set with SOFTPIPE_TEX_CACHE_TILES; it is rounded up to a power of
+ * two number of sets.  Tiles are only allocated when first needed, so the
+ * caches of unused sampler views cost next to nothing.
  */
-#define NUM_TEX_TILE_ENTRIES 16
+#define TEX_TILE_WAYS 4
+#define DEFAULT_TEX_TILE_ENTRIES 64
 
 struct softpipe_tex_tile_cache
 {
@@ -90,7 +93,19 @@ struct softpipe_tex_tile_cache
    struct pipe_resource *texture;  /**< if caching a texture */
    unsigned timestamp;
 
-   struct softpipe_tex_cached_tile entries[NUM_TEX_TILE_ENTRIES];
+   /**
+    * num_sets * TEX_TILE_WAYS tiles.  Each set is kept most recently used
+    * first, with the not yet allocated entries (NULL) at its end.
+    */
+   struct softpipe_tex_cached_tile **entries;
+   unsigned num_sets;
+
+   /**
+    * Lookups which missed last_tile and found the tile in its set, and
+    * those which had to fetch it from the texture.
+    */
+   uint64_t hits;
+   uint64_t misses;
 
    struct pipe_transfer *tex_trans;
    void *tex_trans_map;
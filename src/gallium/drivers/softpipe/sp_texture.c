@@ -70,7 +70,7 @@ softpipe_resource_layout(struct pipe_screen *screen,
       else if (pt->target == PIPE_TEXTURE_3D)
          slices = depth;
       else
-         slices = pt->array_size;
+         slices = pt->array_size * sp_resource_samples(pt);
 
       spr->stride[level] = util_format_get_stride(pt->format, width);
 
@@ -369,7 +369,8 @@ softpipe_transfer_map(struct pipe_context *pipe,
    else {
       assert(box->y + box->height <= u_minify(resource->height0, level));
       if (resource->target == PIPE_TEXTURE_2D_ARRAY) {
-         assert(box->z + box->depth <= resource->array_size);
+         assert(box->z + box->depth <=
+                resource->array_size * sp_resource_samples(resource));
       }
       else if (resource->target == PIPE_TEXTURE_CUBE) {
          assert(box->z < 6);
@@ -378,7 +379,8 @@ softpipe_transfer_map(struct pipe_context *pipe,
          assert(box->z <= resource->array_size);
       }
       else {
-         assert(box->z + box->depth <= (u_minify(resource->depth0, level)));
+         assert(box->z + box->depth <= (u_minify(resource->depth0, level)) *
+                sp_resource_samples(resource));
       }
    }
 
@@ -93,6 +93,19 @@ softpipe_transfer(struct pipe_transfer *pt)
 }
 
 
+/**
+ * Number of samples per pixel.  The samples of a multisample resource are
+ * stored as separate images, one after the other for each layer, so layer
+ * l's sample s is image l * samples + s.  Transfers address them by that
+ * image index in box->z.
+ */
+static INLINE unsigned
+sp_resource_samples(const struct pipe_resource *pt)
+{
+   return pt->nr_samples > 1 ? pt->nr_samples : 1;
+}
+
+
 extern void
 softpipe_init_screen_texture_funcs(struct pipe_screen *screen);
 
@@ -32,6 +32,7 @@
  *    Brian Paul
  */
 
+#include "os/os_time.h"
 #include "util/u_inlines.h"
 #include "util/u_format.h"
 #include "util/u_memory.h"
@@ -47,9 +48,11 @@ sp_alloc_tile(struct softpipe_tile_cache *tc);
  * We currently use a direct mapped cache so this is like a hack key.
  * At some point we should investige something more sophisticated, like
  * a LRU replacement policy.
+ * The sample planes of a tile go to different positions, as the quad
+ * stages use them in turn.
  */
-#define CACHE_POS(x, y) \
-   (((x) + (y) * 5) % NUM_ENTRIES)
+#define CACHE_POS(x, y, sample) \
+   (((x) + (y) * 5 + (sample) * 13) % NUM_ENTRIES)
 
 
 
@@ -103,6 +106,8 @@ sp_create_tile_cache( struct pipe_context *pipe )
          tc->tile_addrs[pos].bits.invalid = 1;
       }
       tc->last_tile_addr.bits.invalid = 1;
+      tc->num_bands = 1;
+      tc->nr_samples = 1;
 
       /* this allocation allows us to guarantee that allocation
        * failures are never fatal later
@@ -149,6 +154,145 @@ sp_destroy_tile_cache(struct softpipe_tile_cache *tc)
 }
 
 
+/**
+ * Choose how to store the colour tiles of a surface.
+ */
+static void
+choose_tile_layout(struct softpipe_tile_cache *tc, enum pipe_format format)
+{
+   const struct util_format_description *desc = util_format_description(format);
+   uint i;
+
+   tc->layout = SP_TILE_FLOAT;
+   tc->format_desc = desc;
+   tc->cpp = util_format_get_blocksize(format);
+
+   if (tc->depth_stencil ||
+       desc->layout != UTIL_FORMAT_LAYOUT_PLAIN ||
+       desc->block.width != 1 || desc->block.height != 1 ||
+       desc->block.bits < 8 || desc->block.bits > 64 ||
+       !util_is_power_of_two(desc->block.bits) ||
+       util_format_is_pure_integer(format) ||
+       !desc->pack_rgba_float || !desc->unpack_rgba_float)
+      return;
+
+   tc->layout = SP_TILE_PACKED;
+
+   /* RGBA8 and its swizzles get converted inline by the blend stage */
+   if (!desc->is_array || desc->nr_channels != 4 || desc->block.bits != 32 ||
+       desc->colorspace != UTIL_FORMAT_COLORSPACE_RGB)
+      return;
+
+   for (i = 0; i < 4; i++) {
+      const struct util_format_channel_description *chan = &desc->channel[i];
+
+      if (chan->type != UTIL_FORMAT_TYPE_VOID &&
+          (chan->type != UTIL_FORMAT_TYPE_UNSIGNED || !chan->normalized))
+         return;
+   }
+
+   for (i = 0; i < 4; i++)
+      tc->unswizzle[i] = 4;
+   for (i = 0; i < 4; i++) {
+      tc->swizzle[i] = desc->swizzle[i];
+      if (desc->swizzle[i] < 4)
+         tc->unswizzle[desc->swizzle[i]] = i;
+   }
+
+   tc->layout = SP_TILE_UNORM8;
+}
+
+
+/**
+ * Are the tiles kept in the surface's format, so they can be copied?
+ */
+static INLINE boolean
+tile_is_raw(const struct softpipe_tile_cache *tc)
+{
+   return tc->depth_stencil || tc->layout != SP_TILE_FLOAT;
+}
+
+
+/**
+ * Where the transfer maps a sample plane.
+ */
+static INLINE void *
+plane_map(const struct softpipe_tile_cache *tc, unsigned sample)
+{
+   return (ubyte *) tc->transfer_map + sample * tc->transfer->layer_stride;
+}
+
+
+/**
+ * Write a tile back to the surface.
+ */
+static void
+put_tile(struct softpipe_tile_cache *tc,
+         struct softpipe_cached_tile *tile,
+         union tile_address addr)
+{
+   struct pipe_transfer *pt = tc->transfer;
+   void *map = plane_map(tc, addr.bits.sample);
+   const unsigned x = addr.bits.x * TILE_SIZE;
+   const unsigned y = addr.bits.y * TILE_SIZE;
+
+   if (tile_is_raw(tc)) {
+      pipe_put_tile_raw(pt, map, x, y, TILE_SIZE, TILE_SIZE,
+                        tile->data.depth32, 0/*STRIDE*/);
+   }
+   else if (util_format_is_pure_uint(tc->surface->format)) {
+      pipe_put_tile_ui_format(pt, map, x, y, TILE_SIZE, TILE_SIZE,
+                              tc->surface->format,
+                              (unsigned *) tile->data.colorui128);
+   }
+   else if (util_format_is_pure_sint(tc->surface->format)) {
+      pipe_put_tile_i_format(pt, map, x, y, TILE_SIZE, TILE_SIZE,
+                             tc->surface->format,
+                             (int *) tile->data.colori128);
+   }
+   else {
+      pipe_put_tile_rgba_format(pt, map, x, y, TILE_SIZE, TILE_SIZE,
+                                tc->surface->format,
+                                (float *) tile->data.color);
+   }
+}
+
+
+/**
+ * Read a tile from the surface.
+ */
+static void
+get_tile(struct softpipe_tile_cache *tc,
+         struct softpipe_cached_tile *tile,
+         union tile_address addr)
+{
+   struct pipe_transfer *pt = tc->transfer;
+   void *map = plane_map(tc, addr.bits.sample);
+   const unsigned x = addr.bits.x * TILE_SIZE;
+   const unsigned y = addr.bits.y * TILE_SIZE;
+
+   if (tile_is_raw(tc)) {
+      pipe_get_tile_raw(pt, map, x, y, TILE_SIZE, TILE_SIZE,
+                        tile->data.depth32, 0/*STRIDE*/);
+   }
+   else if (util_format_is_pure_uint(tc->surface->format)) {
+      pipe_get_tile_ui_format(pt, map, x, y, TILE_SIZE, TILE_SIZE,
+                              tc->surface->format,
+                              (unsigned *) tile->data.colorui128);
+   }
+   else if (util_format_is_pure_sint(tc->surface->format)) {
+      pipe_get_tile_i_format(pt, map, x, y, TILE_SIZE, TILE_SIZE,
+                             tc->surface->format,
+                             (int *) tile->data.colori128);
+   }
+   else {
+      pipe_get_tile_rgba_format(pt, map, x, y, TILE_SIZE, TILE_SIZE,
+                                tc->surface->format,
+                                (float *) tile->data.color);
+   }
+}
+
+
 /**
  * Specify the surface to cache.
  */
@@ -168,15 +312,22 @@ sp_tile_cache_set_surface(struct softpipe_tile_cache *tc,
    }
 
    tc->surface = ps;
+   tc->sample = 0;
 
    if (ps) {
       if (ps->texture->target != PIPE_BUFFER) {
-         tc->transfer_map = pipe_transfer_map(pipe, ps->texture,
-                                              ps->u.tex.level, ps->u.tex.first_layer,
-                                              PIPE_TRANSFER_READ_WRITE |
-                                              PIPE_TRANSFER_UNSYNCHRONIZED,
-                                              0, 0, ps->width, ps->height,
-                                              &tc->transfer);
+         /* all the sample planes of the layer, see sp_resource_samples() */
+         tc->nr_samples = sp_resource_samples(ps->texture);
+         tc->transfer_map = pipe_transfer_map_3d(pipe, ps->texture,
+                                                 ps->u.tex.level,
+                                                 PIPE_TRANSFER_READ_WRITE |
+                                                 PIPE_TRANSFER_UNSYNCHRONIZED,
+                                                 0, 0,
+                                                 ps->u.tex.first_layer *
+                                                 tc->nr_samples,
+                                                 ps->width, ps->height,
+                                                 tc->nr_samples,
+                                                 &tc->transfer);
       }
       else {
          /* can't render to buffers */
@@ -184,6 +335,7 @@ sp_tile_cache_set_surface(struct softpipe_tile_cache *tc,
       }
 
       tc->depth_stencil = util_format_is_depth_or_stencil(ps->format);
+      choose_tile_layout(tc, ps->format);
    }
 }
 
@@ -312,7 +464,7 @@ sp_tile_cache_flush_clear(struct softpipe_tile_cache *tc)
    struct pipe_transfer *pt = tc->transfer;
    const uint w = tc->transfer->box.width;
    const uint h = tc->transfer->box.height;
-   uint x, y;
+   uint x, y, s;
    uint numCleared = 0;
 
    assert(pt->resource);
@@ -320,7 +472,7 @@ sp_tile_cache_flush_clear(struct softpipe_tile_cache *tc)
       tc->tile = sp_alloc_tile(tc);
 
    /* clear the scratch tile to the clear value */
-   if (tc->depth_stencil) {
+   if (tile_is_raw(tc)) {
       clear_tile(tc->tile, pt->resource->format, tc->clear_val);
    } else {
       clear_tile_rgba(tc->tile, pt->resource->format, &tc->clear_color);
@@ -328,31 +480,39 @@ sp_tile_cache_flush_clear(struct softpipe_tile_cache *tc)
 
    /* push the tile to all positions marked as clear */
    for (y = 0; y < h; y += TILE_SIZE) {
+      /* other bands are written back by their own thread's cache */
+      if ((y / TILE_SIZE) % tc->num_bands != tc->band)
+         continue;
+
       for (x = 0; x < w; x += TILE_SIZE) {
-         union tile_address addr = tile_address(x, y);
+         union tile_address addr = tile_address(x, y, 0);
 
          if (is_clear_flag_set(tc->clear_flags, addr)) {
             /* write the scratch tile to the surface */
-            if (tc->depth_stencil) {
-               pipe_put_tile_raw(pt, tc->transfer_map,
-                                 x, y, TILE_SIZE, TILE_SIZE,
-                                 tc->tile->data.any, 0/*STRIDE*/);
-            }
-            else {
-               if (util_format_is_pure_uint(tc->surface->format)) {
-                  pipe_put_tile_ui_format(pt, tc->transfer_map,
-                                          x, y, TILE_SIZE, TILE_SIZE,
-                                          pt->resource->format,
-                                          (unsigned *) tc->tile->data.colorui128);
-               } else if (util_format_is_pure_sint(tc->surface->format)) {
-                  pipe_put_tile_i_format(pt, tc->transfer_map,
-                                         x, y, TILE_SIZE, TILE_SIZE,
-                                         pt->resource->format,
-                                         (int *) tc->tile->data.colori128);
-               } else {
-                  pipe_put_tile_rgba(pt, tc->transfer_map,
-                                     x, y, TILE_SIZE, TILE_SIZE,
-                                     (float *) tc->tile->data.color);
+            for (s = 0; s < tc->nr_samples; s++) {
+               void *map = plane_map(tc, s);
+
+               if (tile_is_raw(tc)) {
+                  pipe_put_tile_raw(pt, map,
+                                    x, y, TILE_SIZE, TILE_SIZE,
+                                    tc->tile->data.any, 0/*STRIDE*/);
+               }
+               else {
+                  if (util_format_is_pure_uint(tc->surface->format)) {
+                     pipe_put_tile_ui_format(pt, map,
+                                             x, y, TILE_SIZE, TILE_SIZE,
+                                             pt->resource->format,
+                                             (unsigned *) tc->tile->data.colorui128);
+                  } else if (util_format_is_pure_sint(tc->surface->format)) {
+                     pipe_put_tile_i_format(pt, map,
+                                            x, y, TILE_SIZE, TILE_SIZE,
+                                            pt->resource->format,
+                                            (int *) tc->tile->data.colori128);
+                  } else {
+                     pipe_put_tile_rgba(pt, map,
+                                        x, y, TILE_SIZE, TILE_SIZE,
+                                        (float *) tc->tile->data.color);
+                  }
                }
             }
             numCleared++;
@@ -372,37 +532,7 @@ static void
 sp_flush_tile(struct softpipe_tile_cache* tc, unsigned pos)
 {
    if (!tc->tile_addrs[pos].bits.invalid) {
-      if (tc->depth_stencil) {
-         pipe_put_tile_raw(tc->transfer, tc->transfer_map,
-                           tc->tile_addrs[pos].bits.x * TILE_SIZE,
-                           tc->tile_addrs[pos].bits.y * TILE_SIZE,
-                           TILE_SIZE, TILE_SIZE,
-                           tc->entries[pos]->data.depth32, 0/*STRIDE*/);
-      }
-      else {
-         if (util_format_is_pure_uint(tc->surface->format)) {
-            pipe_put_tile_ui_format(tc->transfer, tc->transfer_map,
-                                    tc->tile_addrs[pos].bits.x * TILE_SIZE,
-                                    tc->tile_addrs[pos].bits.y * TILE_SIZE,
-                                    TILE_SIZE, TILE_SIZE,
-                                    tc->surface->format,
-                                    (unsigned *) tc->entries[pos]->data.colorui128);
-         } else if (util_format_is_pure_sint(tc->surface->format)) {
-            pipe_put_tile_i_format(tc->transfer, tc->transfer_map,
-                                   tc->tile_addrs[pos].bits.x * TILE_SIZE,
-                                   tc->tile_addrs[pos].bits.y * TILE_SIZE,
-                                   TILE_SIZE, TILE_SIZE,
-                                   tc->surface->format,
-                                   (int *) tc->entries[pos]->data.colori128);
-         } else {
-            pipe_put_tile_rgba_format(tc->transfer, tc->transfer_map,
-                                      tc->tile_addrs[pos].bits.x * TILE_SIZE,
-                                      tc->tile_addrs[pos].bits.y * TILE_SIZE,
-                                      TILE_SIZE, TILE_SIZE,
-                                      tc->surface->format,
-                                      (float *) tc->entries[pos]->data.color);
-         }
-      }
+      put_tile(tc, tc->entries[pos], tc->tile_addrs[pos]);
       tc->tile_addrs[pos].bits.invalid = 1;  /* mark as empty */
    }
 }
@@ -418,6 +548,8 @@ sp_flush_tile_cache(struct softpipe_tile_cache *tc)
    int inuse = 0, pos;
 
    if (pt) {
+      const int64_t start = os_time_get_nano();
+
       /* caching a drawing transfer */
       for (pos = 0; pos < Elements(tc->entries); pos++) {
          struct softpipe_cached_tile *tile = tc->entries[pos];
@@ -435,6 +567,8 @@ sp_flush_tile_cache(struct softpipe_tile_cache *tc)
 
 
       tc->last_tile_addr.bits.invalid = 1;
+
+      tc->flush_time += os_time_get_nano() - start;
    }
 
 #if 0
@@ -486,7 +620,8 @@ sp_find_cached_tile(struct softpipe_tile_cache *tc,
    struct pipe_transfer *pt = tc->transfer;
    /* cache pos/entry: */
    const int pos = CACHE_POS(addr.bits.x,
-                             addr.bits.y);
+                             addr.bits.y,
+                             addr.bits.sample);
    struct softpipe_cached_tile *tile = tc->entries[pos];
 
    if (!tile) {
@@ -499,84 +634,36 @@ sp_find_cached_tile(struct softpipe_tile_cache *tc,
       assert(pt->resource);
       if (tc->tile_addrs[pos].bits.invalid == 0) {
          /* put dirty tile back in framebuffer */
-         if (tc->depth_stencil) {
-            pipe_put_tile_raw(pt, tc->transfer_map,
-                              tc->tile_addrs[pos].bits.x * TILE_SIZE,
-                              tc->tile_addrs[pos].bits.y * TILE_SIZE,
-                              TILE_SIZE, TILE_SIZE,
-                              tile->data.depth32, 0/*STRIDE*/);
-         }
-         else {
-            if (util_format_is_pure_uint(tc->surface->format)) {
-               pipe_put_tile_ui_format(pt, tc->transfer_map,
-                                      tc->tile_addrs[pos].bits.x * TILE_SIZE,
-                                      tc->tile_addrs[pos].bits.y * TILE_SIZE,
-                                      TILE_SIZE, TILE_SIZE,
-                                      tc->surface->format,
-                                      (unsigned *) tile->data.colorui128);
-            } else if (util_format_is_pure_sint(tc->surface->format)) {
-               pipe_put_tile_i_format(pt, tc->transfer_map,
-                                      tc->tile_addrs[pos].bits.x * TILE_SIZE,
-                                      tc->tile_addrs[pos].bits.y * TILE_SIZE,
-                                      TILE_SIZE, TILE_SIZE,
-                                      tc->surface->format,
-                                      (int *) tile->data.colori128);
-            } else {
-               pipe_put_tile_rgba_format(pt, tc->transfer_map,
-                                         tc->tile_addrs[pos].bits.x * TILE_SIZE,
-                                         tc->tile_addrs[pos].bits.y * TILE_SIZE,
-                                         TILE_SIZE, TILE_SIZE,
-                                         tc->surface->format,
-                                         (float *) tile->data.color);
-            }
-         }
+         put_tile(tc, tile, tc->tile_addrs[pos]);
       }
 
       tc->tile_addrs[pos] = addr;
 
       if (is_clear_flag_set(tc->clear_flags, addr)) {
+         unsigned s;
+
          /* don't get tile from framebuffer, just clear it */
-         if (tc->depth_stencil) {
+         if (tile_is_raw(tc)) {
             clear_tile(tile, pt->resource->format, tc->clear_val);
          }
          else {
             clear_tile_rgba(tile, pt->resource->format, &tc->clear_color);
          }
          clear_clear_flag(tc->clear_flags, addr);
+
+         /* the flag was for the tile's other sample planes too */
+         for (s = 0; s < tc->nr_samples; s++) {
+            if (s != addr.bits.sample) {
+               union tile_address plane = addr;
+
+               plane.bits.sample = s;
+               put_tile(tc, tile, plane);
+            }
+         }
       }
       else {
          /* get new tile data from transfer */
-         if (tc->depth_stencil) {
-            pipe_get_tile_raw(pt, tc->transfer_map,
-                              tc->tile_addrs[pos].bits.x * TILE_SIZE,
-                              tc->tile_addrs[pos].bits.y * TILE_SIZE,
-                              TILE_SIZE, TILE_SIZE,
-                              tile->data.depth32, 0/*STRIDE*/);
-         }
-         else {
-            if (util_format_is_pure_uint(tc->surface->format)) {
-               pipe_get_tile_ui_format(pt, tc->transfer_map,
-                                         tc->tile_addrs[pos].bits.x * TILE_SIZE,
-                                         tc->tile_addrs[pos].bits.y * TILE_SIZE,
-                                         TILE_SIZE, TILE_SIZE,
-                                         tc->surface->format,
-                                         (unsigned *) tile->data.colorui128);
-            } else if (util_format_is_pure_sint(tc->surface->format)) {
-               pipe_get_tile_i_format(pt, tc->transfer_map,
-                                         tc->tile_addrs[pos].bits.x * TILE_SIZE,
-                                         tc->tile_addrs[pos].bits.y * TILE_SIZE,
-                                         TILE_SIZE, TILE_SIZE,
-                                         tc->surface->format,
-                                         (int *) tile->data.colori128);
-            } else {
-               pipe_get_tile_rgba_format(pt, tc->transfer_map,
-                                         tc->tile_addrs[pos].bits.x * TILE_SIZE,
-                                         tc->tile_addrs[pos].bits.y * TILE_SIZE,
-                                         TILE_SIZE, TILE_SIZE,
-                                         tc->surface->format,
-                                         (float *) tile->data.color);
-            }
-         }
+         get_tile(tc, tile, addr);
       }
    }
 
@@ -605,6 +692,34 @@ sp_tile_cache_clear(struct softpipe_tile_cache *tc,
 
    tc->clear_val = clearValue;
 
+   if (!tc->depth_stencil && tc->layout != SP_TILE_FLOAT) {
+      /* pack the colour the way clear_tile() wants it */
+      union {
+         ubyte ub;
+         ushort us;
+         uint ui;
+         uint64_t u64;
+      } packed;
+
+      packed.u64 = 0;
+      tc->format_desc->pack_rgba_float((uint8_t *) &packed, 0,
+                                       color->f, 0, 1, 1);
+      switch (tc->cpp) {
+      case 1:
+         tc->clear_val = packed.ub;
+         break;
+      case 2:
+         tc->clear_val = packed.us;
+         break;
+      case 4:
+         tc->clear_val = packed.ui;
+         break;
+      default:
+         tc->clear_val = packed.u64;
+         break;
+      }
+   }
+
    /* set flags to indicate all the tiles are cleared */
    memset(tc->clear_flags, 255, sizeof(tc->clear_flags));
 
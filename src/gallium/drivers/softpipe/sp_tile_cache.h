@@ -34,6 +34,7 @@
 
 
 struct softpipe_tile_cache;
+struct util_format_description;
 
 
 /**
@@ -53,8 +54,9 @@ union tile_address {
    struct {
       unsigned x:TILE_ADDR_BITS;     /* 16K / TILE_SIZE */
       unsigned y:TILE_ADDR_BITS;     /* 16K / TILE_SIZE */
+      unsigned sample:2;             /* SP_MAX_SAMPLES */
       unsigned invalid:1;
-      unsigned pad:15;
+      unsigned pad:13;
    } bits;
    unsigned value;
 };
@@ -78,6 +80,17 @@ struct softpipe_cached_tile
 #define NUM_ENTRIES 50
 
 
+/**
+ * How the pixels of colour tiles are stored.
+ */
+enum sp_tile_layout
+{
+   SP_TILE_FLOAT,   /**< data.color/colorui128/colori128, four channels */
+   SP_TILE_UNORM8,  /**< data.color32, the surface's four 8 bit channels */
+   SP_TILE_PACKED   /**< data.any, in the surface's format */
+};
+
+
 struct softpipe_tile_cache
 {
    struct pipe_context *pipe;
@@ -92,10 +105,42 @@ struct softpipe_tile_cache
    uint64_t clear_val;        /**< for z+stencil */
    boolean depth_stencil; /**< Is the surface a depth/stencil format? */
 
+   /**
+    * Colour tiles are kept in the surface's own format when it is a plain
+    * non-integer one of 8, 16, 32 or 64 bits, so fetching and flushing them
+    * are copies.  See choose_tile_layout().
+    */
+   enum sp_tile_layout layout;
+   const struct util_format_description *format_desc;
+   unsigned cpp;              /**< bytes per pixel, for SP_TILE_PACKED */
+   /** SP_TILE_UNORM8: the byte each RGBA channel is in, or SWIZZLE_0/1 */
+   ubyte swizzle[4];
+   /** SP_TILE_UNORM8: the RGBA channel each byte holds, or 4 if none */
+   ubyte unswizzle[4];
+
+   /**
+    * Rows of tiles this cache writes back clears for: those whose index
+    * modulo num_bands is band.  See sp_rast.h.
+    */
+   unsigned band;
+   unsigned num_bands;
+
    struct softpipe_cached_tile *tile;  /**< scratch tile for clears */
 
    union tile_address last_tile_addr;
    struct softpipe_cached_tile *last_tile;  /**< most recently retrieved tile */
+
+   /** Nanoseconds spent in sp_flush_tile_cache(), see SP_QUERY_TILE_FLUSH_TIME */
+   uint64_t flush_time;
+
+   /**
+    * Multisample surfaces have a plane of tiles per sample, all mapped by
+    * the one transfer.  sp_get_cached_tile() returns those of plane sample,
+    * which the quad stages set as they go through the samples.  A tile's
+    * clear flag covers all its planes.
+    */
+   unsigned nr_samples;
+   unsigned sample;
 };
 
 
@@ -127,13 +172,15 @@ sp_find_cached_tile(struct softpipe_tile_cache *tc,
 
 static INLINE union tile_address
 tile_address( unsigned x,
-              unsigned y )
+              unsigned y,
+              unsigned sample )
 {
    union tile_address addr;
 
    addr.value = 0;
    addr.bits.x = x / TILE_SIZE;
    addr.bits.y = y / TILE_SIZE;
+   addr.bits.sample = sample;
       
    return addr;
 }
@@ -144,7 +191,7 @@ static INLINE struct softpipe_cached_tile *
 sp_get_cached_tile(struct softpipe_tile_cache *tc, 
                    int x, int y )
 {
-   union tile_address addr = tile_address( x, y );
+   union tile_address addr = tile_address( x, y, tc->sample );
 
    if (tc->last_tile_addr.value == addr.value)
       return tc->last_tile;
@@ -450,7 +450,8 @@ SVGA3D_SurfaceDMA(struct svga_winsys_context *swc,
    if (!cmd)
       return PIPE_ERROR_OUT_OF_MEMORY;
 
-   swc->region_relocation(swc, &cmd->guest.ptr, st->hwbuf, 0, region_flags);
+   swc->region_relocation(swc, &cmd->guest.ptr, st->hwbuf, st->hw_offset,
+                          region_flags);
    cmd->guest.pitch = st->base.stride;
 
    swc->surface_relocation(swc, &cmd->host.sid, texture->handle, surface_flags);
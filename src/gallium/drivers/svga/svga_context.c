@@ -72,6 +72,11 @@ static void svga_destroy( struct pipe_context *pipe )
    u_upload_destroy( svga->upload_vb );
    u_upload_destroy( svga->upload_ib );
 
+   if (svga->tex_upload.buf) {
+      struct svga_winsys_screen *sws = svga_screen(pipe->screen)->sws;
+      sws->buffer_destroy(sws, svga->tex_upload.buf);
+   }
+
    util_bitmask_destroy( svga->vs_bm );
    util_bitmask_destroy( svga->fs_bm );
 
@@ -48,12 +48,17 @@
 #define SVGA_QUERY_MEMORY_USED  (PIPE_QUERY_DRIVER_SPECIFIC + 2)
 
 
+/** Size of the DMA buffer texture uploads are staged in */
+#define SVGA_TEX_UPLOAD_SIZE    (1024 * 1024)
+
+
 struct draw_vertex_shader;
 struct draw_fragment_shader;
 struct svga_shader_result;
 struct SVGACmdMemory;
 struct util_bitmask;
 struct u_upload_mgr;
+struct svga_winsys_buffer;
 
 
 struct svga_shader
@@ -371,6 +376,16 @@ struct svga_context
    struct u_upload_mgr *upload_vb;
    struct svga_hwtnl *hwtnl;
 
+   /**
+    * DMA buffer small texture uploads are sub-allocated from, instead of
+    * creating a DMA buffer for every transfer.
+    */
+   struct {
+      struct svga_winsys_buffer *buf;
+      unsigned offset;
+      unsigned users;    /**< transfers currently mapping buf */
+   } tex_upload;
+
    /** The occlusion query currently in progress */
    struct svga_query *sq;
 
@@ -236,6 +236,71 @@ svga_texture_destroy(struct pipe_screen *screen,
 }
 
 
+/**
+ * Sub-allocate the staging memory of a texture upload from the context's
+ * texture upload buffer, so that a stream of small uploads doesn't create
+ * (and fence) a DMA buffer for each transfer.
+ *
+ * Returns FALSE if the transfer needs a DMA buffer of its own.
+ */
+static boolean
+svga_texture_upload_alloc(struct svga_context *svga,
+                          struct svga_transfer *st,
+                          unsigned size)
+{
+   struct svga_winsys_screen *sws = svga_screen(svga->pipe.screen)->sws;
+   unsigned offset = align(svga->tex_upload.offset, 16);
+
+   /* Only one transfer maps the upload buffer at a time, so that the
+    * buffer is never validated for a DMA while it's mapped.
+    */
+   if (size > SVGA_TEX_UPLOAD_SIZE / 4 || svga->tex_upload.users)
+      return FALSE;
+
+   if (!svga->tex_upload.buf || offset + size > SVGA_TEX_UPLOAD_SIZE) {
+      /* DMAs already queued keep a reference to the old buffer, so it
+       * doesn't need to be waited on.
+       */
+      if (svga->tex_upload.buf)
+         sws->buffer_destroy(sws, svga->tex_upload.buf);
+
+      svga->tex_upload.buf = svga_winsys_buffer_create(svga, 16, 0,
+                                                       SVGA_TEX_UPLOAD_SIZE);
+      svga->tex_upload.offset = 0;
+      if (!svga->tex_upload.buf)
+         return FALSE;
+
+      offset = 0;
+   }
+
+   st->hwbuf = svga->tex_upload.buf;
+   st->hw_offset = offset;
+   st->upload = TRUE;
+
+   svga->tex_upload.offset = offset + size;
+   svga->tex_upload.users++;
+
+   return TRUE;
+}
+
+
+static void
+svga_texture_release_hwbuf(struct svga_context *svga,
+                           struct svga_transfer *st)
+{
+   struct svga_winsys_screen *sws = svga_screen(svga->pipe.screen)->sws;
+
+   if (st->upload) {
+      assert(svga->tex_upload.users);
+      svga->tex_upload.users--;
+   }
+   else {
+      sws->buffer_destroy(sws, st->hwbuf);
+   }
+   st->hwbuf = NULL;
+}
+
+
 /* XXX: Still implementing this as if it was a screen function, but
  * can now modify it to queue transfers on the context.
  */
@@ -271,6 +336,25 @@ svga_texture_transfer_map(struct pipe_context *pipe,
 
    st->hw_nblocksy = nblocksy;
 
+   /* Regions of the upload buffer are never handed out twice, so writes
+    * into it don't need to wait for earlier DMAs.
+    */
+   if (!(usage & PIPE_TRANSFER_READ) &&
+       svga_texture_upload_alloc(svga, st,
+                                 st->hw_nblocksy * st->base.stride * box->depth)) {
+      void *map = sws->buffer_map(sws, st->hwbuf,
+                                  PIPE_TRANSFER_WRITE |
+                                  PIPE_TRANSFER_UNSYNCHRONIZED);
+      if (!map) {
+         svga_texture_release_hwbuf(svga, st);
+         FREE(st);
+         return NULL;
+      }
+
+      *ptransfer = &st->base;
+      return (uint8_t *)map + st->hw_offset;
+   }
+
    st->hwbuf = svga_winsys_buffer_create(svga,
                                          1, 
                                          0,
@@ -369,7 +453,7 @@ svga_texture_transfer_unmap(struct pipe_context *pipe,
    }
 
    FREE(st->swbuf);
-   sws->buffer_destroy(sws, st->hwbuf);
+   svga_texture_release_hwbuf(svga, st);
    FREE(st);
 }
 
@@ -92,6 +92,12 @@ struct svga_transfer
 
    struct svga_winsys_buffer *hwbuf;
 
+   /* Offset of the transfer data in hwbuf */
+   unsigned hw_offset;
+
+   /* Whether hwbuf is the context's shared texture upload buffer */
+   boolean upload;
+
    /* Height of the hardware buffer in pixel blocks */
    unsigned hw_nblocksy;
 
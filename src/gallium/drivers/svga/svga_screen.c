@@ -526,6 +526,7 @@ svga_destroy_screen( struct pipe_screen *screen )
    struct svga_screen *svgascreen = svga_screen(screen);
    
    svga_screen_cache_cleanup(svgascreen);
+   svga_shader_cache_cleanup(svgascreen);
 
    pipe_mutex_destroy(svgascreen->swc_mutex);
    pipe_mutex_destroy(svgascreen->tex_mutex);
@@ -660,6 +661,7 @@ svga_screen_create(struct svga_winsys_screen *sws)
    pipe_mutex_init(svgascreen->swc_mutex);
 
    svga_screen_cache_init(svgascreen);
+   svga_shader_cache_init(svgascreen);
 
    return screen;
 error2:
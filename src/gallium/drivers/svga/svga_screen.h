@@ -38,6 +38,7 @@
 struct svga_winsys_screen;
 struct svga_winsys_context;
 struct SVGACmdMemory;
+struct util_hash_table;
 
 /**
  * Subclass of pipe_screen
@@ -74,6 +75,13 @@ struct svga_screen
 
    struct svga_host_surface_cache cache;
 
+   /** TGSI to SVGA3D shader translations, shared by all contexts */
+   struct {
+      pipe_mutex mutex;
+      struct util_hash_table *table;
+      unsigned count;
+   } shader_cache;
+
    /** Memory used by all resources (buffers and surfaces) */
    uint64_t total_resource_bytes;
 };
@@ -108,7 +108,7 @@ static enum pipe_error compile_fs( struct svga_context *svga,
    struct svga_shader_result *result;
    enum pipe_error ret = PIPE_ERROR;
 
-   result = svga_translate_fragment_program( fs, key );
+   result = svga_translate_fragment_program( svga, fs, key );
    if (result == NULL) {
       /* some problem during translation, try the dummy shader */
       const struct tgsi_token *dummy = get_dummy_fragment_shader();
@@ -119,7 +119,7 @@ static enum pipe_error compile_fs( struct svga_context *svga,
       debug_printf("Failed to compile fragment shader, using dummy shader instead.\n");
       FREE((void *) fs->base.tokens);
       fs->base.tokens = dummy;
-      result = svga_translate_fragment_program(fs, key);
+      result = svga_translate_fragment_program(svga, fs, key);
       if (result == NULL) {
          ret = PIPE_ERROR;
          goto fail;
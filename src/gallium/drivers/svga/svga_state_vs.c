@@ -106,7 +106,7 @@ static enum pipe_error compile_vs( struct svga_context *svga,
    struct svga_shader_result *result;
    enum pipe_error ret = PIPE_ERROR;
 
-   result = svga_translate_vertex_program( vs, key );
+   result = svga_translate_vertex_program( svga, vs, key );
    if (result == NULL) {
       /* some problem during translation, try the dummy shader */
       const struct tgsi_token *dummy = get_dummy_vertex_shader();
@@ -117,7 +117,7 @@ static enum pipe_error compile_vs( struct svga_context *svga,
       debug_printf("Failed to compile vertex shader, using dummy shader instead.\n");
       FREE((void *) vs->base.tokens);
       vs->base.tokens = dummy;
-      result = svga_translate_vertex_program(vs, key);
+      result = svga_translate_vertex_program(svga, vs, key);
       if (result == NULL) {
          ret = PIPE_ERROR;
          goto fail;
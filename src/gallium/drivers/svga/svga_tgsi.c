@@ -33,10 +33,13 @@
 #include "util/u_math.h"
 #include "util/u_memory.h"
 #include "util/u_bitmask.h"
+#include "util/u_hash.h"
+#include "util/u_hash_table.h"
 
 #include "svgadump/svga_shader_dump.h"
 
 #include "svga_context.h"
+#include "svga_screen.h"
 #include "svga_tgsi.h"
 #include "svga_tgsi_emit.h"
 #include "svga_debug.h"
@@ -256,6 +259,163 @@ svga_remap_generic_index(int8_t remap_table[MAX_GENERIC_VARYING],
 }
 
 
+/**
+ * Upper bound on the number of translations kept in the screen's
+ * shader cache.
+ */
+#define SVGA_MAX_CACHED_SHADERS 1024
+
+
+/**
+ * A translated shader in the screen's shader cache.  It is looked up by
+ * the TGSI tokens, the shader unit and the compile key.
+ */
+struct svga_shader_cache_entry
+{
+   unsigned hash;
+   unsigned unit;
+   struct svga_compile_key key;
+
+   const struct tgsi_token *tgsi_tokens;
+   unsigned nr_tgsi_tokens;
+
+   unsigned *tokens;
+   unsigned nr_tokens;
+};
+
+
+static unsigned
+svga_shader_cache_hash(void *key)
+{
+   return ((const struct svga_shader_cache_entry *)key)->hash;
+}
+
+
+static int
+svga_shader_cache_compare(void *key1, void *key2)
+{
+   const struct svga_shader_cache_entry *a = key1;
+   const struct svga_shader_cache_entry *b = key2;
+
+   if (a->unit != b->unit ||
+       a->nr_tgsi_tokens != b->nr_tgsi_tokens)
+      return 1;
+
+   if (memcmp(&a->key, &b->key, sizeof a->key) != 0)
+      return 1;
+
+   return memcmp(a->tgsi_tokens, b->tgsi_tokens,
+                 a->nr_tgsi_tokens * sizeof a->tgsi_tokens[0]);
+}
+
+
+static enum pipe_error
+svga_shader_cache_destroy_entry(void *key, void *value, void *data)
+{
+   struct svga_shader_cache_entry *entry = value;
+
+   FREE((void *) entry->tgsi_tokens);
+   FREE(entry->tokens);
+   FREE(entry);
+
+   return PIPE_OK;
+}
+
+
+void
+svga_shader_cache_init(struct svga_screen *svgascreen)
+{
+   pipe_mutex_init(svgascreen->shader_cache.mutex);
+   svgascreen->shader_cache.table =
+      util_hash_table_create(svga_shader_cache_hash,
+                             svga_shader_cache_compare);
+   svgascreen->shader_cache.count = 0;
+}
+
+
+void
+svga_shader_cache_cleanup(struct svga_screen *svgascreen)
+{
+   if (svgascreen->shader_cache.table) {
+      util_hash_table_foreach(svgascreen->shader_cache.table,
+                              svga_shader_cache_destroy_entry, NULL);
+      util_hash_table_destroy(svgascreen->shader_cache.table);
+   }
+   pipe_mutex_destroy(svgascreen->shader_cache.mutex);
+}
+
+
+/**
+ * Look up a previous translation of the shader, done by any context of
+ * the screen, and return a copy of its tokens.
+ */
+static unsigned *
+svga_shader_cache_lookup(struct svga_screen *svgascreen,
+                         const struct svga_shader_cache_entry *templ,
+                         unsigned *nr_tokens)
+{
+   struct svga_shader_cache_entry *entry;
+   unsigned *tokens = NULL;
+
+   if (!svgascreen->shader_cache.table)
+      return NULL;
+
+   pipe_mutex_lock(svgascreen->shader_cache.mutex);
+   entry = util_hash_table_get(svgascreen->shader_cache.table,
+                               (void *) templ);
+   if (entry) {
+      tokens = MALLOC(entry->nr_tokens * sizeof tokens[0]);
+      if (tokens) {
+         memcpy(tokens, entry->tokens, entry->nr_tokens * sizeof tokens[0]);
+         *nr_tokens = entry->nr_tokens;
+      }
+   }
+   pipe_mutex_unlock(svgascreen->shader_cache.mutex);
+
+   return tokens;
+}
+
+
+static void
+svga_shader_cache_add(struct svga_screen *svgascreen,
+                      const struct svga_shader_cache_entry *templ,
+                      const unsigned *tokens, unsigned nr_tokens)
+{
+   struct svga_shader_cache_entry *entry;
+   unsigned tgsi_size = templ->nr_tgsi_tokens * sizeof templ->tgsi_tokens[0];
+
+   if (!svgascreen->shader_cache.table ||
+       svgascreen->shader_cache.count >= SVGA_MAX_CACHED_SHADERS)
+      return;
+
+   entry = CALLOC_STRUCT(svga_shader_cache_entry);
+   if (!entry)
+      return;
+
+   *entry = *templ;
+   entry->tgsi_tokens = mem_dup(templ->tgsi_tokens, tgsi_size);
+   entry->tokens = mem_dup(tokens, nr_tokens * sizeof tokens[0]);
+   entry->nr_tokens = nr_tokens;
+   if (!entry->tgsi_tokens || !entry->tokens) {
+      svga_shader_cache_destroy_entry(NULL, entry, NULL);
+      return;
+   }
+
+   pipe_mutex_lock(svgascreen->shader_cache.mutex);
+   if (svgascreen->shader_cache.count < SVGA_MAX_CACHED_SHADERS &&
+       !util_hash_table_get(svgascreen->shader_cache.table, entry) &&
+       util_hash_table_set(svgascreen->shader_cache.table,
+                           entry, entry) == PIPE_OK) {
+      svgascreen->shader_cache.count++;
+      entry = NULL;
+   }
+   pipe_mutex_unlock(svgascreen->shader_cache.mutex);
+
+   if (entry)
+      svga_shader_cache_destroy_entry(NULL, entry, NULL);
+}
+
+
 /**
  * Parse TGSI shader and translate to SVGA/DX9 serialized
  * representation.
@@ -265,14 +425,45 @@ svga_remap_generic_index(int8_t remap_table[MAX_GENERIC_VARYING],
  * it is, it will be copied to a hardware buffer for upload.
  */
 static struct svga_shader_result *
-svga_tgsi_translate(const struct svga_shader *shader,
+svga_tgsi_translate(struct svga_context *svga,
+                    const struct svga_shader *shader,
                     struct svga_compile_key key, unsigned unit)
 {
+   struct svga_screen *svgascreen = svga_screen(svga->pipe.screen);
    struct svga_shader_result *result = NULL;
    struct svga_shader_emitter emit;
+   struct svga_shader_cache_entry templ;
+   unsigned cached_tokens;
+
+   memset(&templ, 0, sizeof(templ));
+   templ.unit = unit;
+   templ.key = key;
+   templ.tgsi_tokens = shader->tokens;
+   templ.nr_tgsi_tokens = tgsi_num_tokens(shader->tokens);
+   templ.hash = util_hash_crc32(shader->tokens,
+                                templ.nr_tgsi_tokens *
+                                sizeof shader->tokens[0]);
+   templ.hash ^= util_hash_crc32(&key, sizeof key);
+   templ.hash ^= unit;
 
    memset(&emit, 0, sizeof(emit));
 
+   /* Another context may already have translated this variant */
+   emit.buf = (char *) svga_shader_cache_lookup(svgascreen, &templ,
+                                                &cached_tokens);
+   if (emit.buf) {
+      result = CALLOC_STRUCT(svga_shader_result);
+      if (result == NULL)
+         goto fail;
+
+      result->shader = shader;
+      result->tokens = (const unsigned *) emit.buf;
+      result->nr_tokens = cached_tokens;
+      memcpy(&result->key, &key, sizeof key);
+      result->id = UTIL_BITMASK_INVALID_INDEX;
+      return result;
+   }
+
    emit.size = 1024;
    emit.buf = MALLOC(emit.size);
    if (emit.buf == NULL) {
@@ -338,6 +529,9 @@ svga_tgsi_translate(const struct svga_shader *shader,
       debug_printf("#####################################\n");
    }
 
+   svga_shader_cache_add(svgascreen, &templ,
+                         result->tokens, result->nr_tokens);
+
    return result;
 
  fail:
@@ -348,7 +542,8 @@ svga_tgsi_translate(const struct svga_shader *shader,
 
 
 struct svga_shader_result *
-svga_translate_fragment_program(const struct svga_fragment_shader *fs,
+svga_translate_fragment_program(struct svga_context *svga,
+                                const struct svga_fragment_shader *fs,
                                 const struct svga_fs_compile_key *fkey)
 {
    struct svga_compile_key key;
@@ -360,12 +555,13 @@ svga_translate_fragment_program(const struct svga_fragment_shader *fs,
    memcpy(key.generic_remap_table, fs->generic_remap_table,
           sizeof(fs->generic_remap_table));
 
-   return svga_tgsi_translate(&fs->base, key, PIPE_SHADER_FRAGMENT);
+   return svga_tgsi_translate(svga, &fs->base, key, PIPE_SHADER_FRAGMENT);
 }
 
 
 struct svga_shader_result *
-svga_translate_vertex_program(const struct svga_vertex_shader *vs,
+svga_translate_vertex_program(struct svga_context *svga,
+                              const struct svga_vertex_shader *vs,
                               const struct svga_vs_compile_key *vkey)
 {
    struct svga_compile_key key;
@@ -379,7 +575,7 @@ svga_translate_vertex_program(const struct svga_vertex_shader *vs,
     */
    svga_remap_generics(vkey->fs_generic_inputs, key.generic_remap_table);
 
-   return svga_tgsi_translate(&vs->base, key, PIPE_SHADER_VERTEX);
+   return svga_tgsi_translate(svga, &vs->base, key, PIPE_SHADER_VERTEX);
 }
 
 
@@ -37,8 +37,10 @@
 #define MAX_GENERIC_VARYING 32
 
 
+struct svga_context;
 struct svga_fragment_shader;
 struct svga_vertex_shader;
+struct svga_screen;
 struct svga_shader;
 struct tgsi_shader_info;
 struct tgsi_token;
@@ -144,13 +146,19 @@ static INLINE unsigned svga_fs_key_size( const struct svga_fs_compile_key *key )
 }
 
 struct svga_shader_result *
-svga_translate_fragment_program( const struct svga_fragment_shader *fs,
+svga_translate_fragment_program( struct svga_context *svga,
+                                 const struct svga_fragment_shader *fs,
                                  const struct svga_fs_compile_key *fkey );
 
 struct svga_shader_result *
-svga_translate_vertex_program( const struct svga_vertex_shader *fs,
+svga_translate_vertex_program( struct svga_context *svga,
+                               const struct svga_vertex_shader *fs,
                                const struct svga_vs_compile_key *vkey );
 
+void svga_shader_cache_init( struct svga_screen *svgascreen );
+
+void svga_shader_cache_cleanup( struct svga_screen *svgascreen );
+
 
 void svga_destroy_shader_result( struct svga_shader_result *result );
 
@@ -37,6 +37,7 @@
 #include "tr_public.h"
 #include "tr_screen.h"
 #include "tr_texture.h"
+#include "tr_timeline.h"
 #include "tr_context.h"
 
 
@@ -88,6 +89,7 @@ trace_context_draw_vbo(struct pipe_context *_pipe,
 {
    struct trace_context *tr_ctx = trace_context(_pipe);
    struct pipe_context *pipe = tr_ctx->pipe;
+   int64_t start;
 
    trace_dump_call_begin("pipe_context", "draw_vbo");
 
@@ -96,7 +98,9 @@ trace_context_draw_vbo(struct pipe_context *_pipe,
 
    trace_dump_trace_flush();
 
+   start = trace_timeline_start();
    pipe->draw_vbo(pipe, info);
+   trace_timeline_record(TRACE_TIMELINE_DRAW, pipe, info->count, start);
 
    trace_dump_call_end();
 }
@@ -512,10 +516,13 @@ trace_context_delete_depth_stencil_alpha_state(struct pipe_context *_pipe,
       struct trace_context *tr_ctx = trace_context(_pipe); \
       struct pipe_context *pipe = tr_ctx->pipe; \
       void * result; \
+      int64_t start; \
       trace_dump_call_begin("pipe_context", "create_" #shader_type "_state"); \
       trace_dump_arg(ptr, pipe); \
       trace_dump_arg(shader_state, state); \
+      start = trace_timeline_start(); \
       result = pipe->create_##shader_type##_state(pipe, state); \
+      trace_timeline_record(TRACE_TIMELINE_SHADER_CREATE, pipe, 0, start); \
       trace_dump_ret(ptr, result); \
       trace_dump_call_end(); \
       return result; \
@@ -1191,6 +1198,7 @@ trace_context_blit(struct pipe_context *_pipe,
    struct trace_context *tr_ctx = trace_context(_pipe);
    struct pipe_context *pipe = tr_ctx->pipe;
    struct pipe_blit_info info = *_info;
+   int64_t start;
 
    info.dst.resource = trace_resource_unwrap(tr_ctx, info.dst.resource);
    info.src.resource = trace_resource_unwrap(tr_ctx, info.src.resource);
@@ -1200,7 +1208,9 @@ trace_context_blit(struct pipe_context *_pipe,
    trace_dump_arg(ptr, pipe);
    trace_dump_arg(blit_info, _info);
 
+   start = trace_timeline_start();
    pipe->blit(pipe, &info);
+   trace_timeline_record(TRACE_TIMELINE_BLIT, pipe, info.mask, start);
 
    trace_dump_call_end();
 }
@@ -1215,6 +1225,7 @@ trace_context_clear(struct pipe_context *_pipe,
 {
    struct trace_context *tr_ctx = trace_context(_pipe);
    struct pipe_context *pipe = tr_ctx->pipe;
+   int64_t start;
 
    trace_dump_call_begin("pipe_context", "clear");
 
@@ -1229,7 +1240,9 @@ trace_context_clear(struct pipe_context *_pipe,
    trace_dump_arg(float, depth);
    trace_dump_arg(uint, stencil);
 
+   start = trace_timeline_start();
    pipe->clear(pipe, buffers, color, depth, stencil);
+   trace_timeline_record(TRACE_TIMELINE_CLEAR, pipe, buffers, start);
 
    trace_dump_call_end();
 }
@@ -1301,13 +1314,16 @@ trace_context_flush(struct pipe_context *_pipe,
 {
    struct trace_context *tr_ctx = trace_context(_pipe);
    struct pipe_context *pipe = tr_ctx->pipe;
+   int64_t start;
 
    trace_dump_call_begin("pipe_context", "flush");
 
    trace_dump_arg(ptr, pipe);
    trace_dump_arg(uint, flags);
 
+   start = trace_timeline_start();
    pipe->flush(pipe, fence, flags);
+   trace_timeline_record(TRACE_TIMELINE_FLUSH, pipe, flags, start);
 
    if(fence)
       trace_dump_ret(ptr, *fence);
@@ -1351,6 +1367,7 @@ trace_context_transfer_map(struct pipe_context *_context,
    struct pipe_resource *texture = tr_res->resource;
    struct pipe_transfer *result = NULL;
    void *map;
+   int64_t start;
 
    assert(texture->screen == context->screen);
 
@@ -1359,7 +1376,9 @@ trace_context_transfer_map(struct pipe_context *_context,
     * to transfer_inline_write and ignore read transfers.
     */
 
+   start = trace_timeline_start();
    map = context->transfer_map(context, texture, level, usage, box, &result);
+   trace_timeline_record(TRACE_TIMELINE_TRANSFER_MAP, context, usage, start);
    if (!map)
       return NULL;
 
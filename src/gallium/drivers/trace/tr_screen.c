@@ -32,6 +32,7 @@
 #include "tr_dump.h"
 #include "tr_dump_state.h"
 #include "tr_texture.h"
+#include "tr_timeline.h"
 #include "tr_context.h"
 #include "tr_screen.h"
 #include "tr_public.h"
@@ -379,6 +380,7 @@ trace_screen_fence_finish(struct pipe_screen *_screen,
    struct trace_screen *tr_scr = trace_screen(_screen);
    struct pipe_screen *screen = tr_scr->screen;
    int result;
+   int64_t start;
 
    trace_dump_call_begin("pipe_screen", "fence_finish");
 
@@ -386,7 +388,9 @@ trace_screen_fence_finish(struct pipe_screen *_screen,
    trace_dump_arg(ptr, fence);
    trace_dump_arg(uint, timeout);
 
+   start = trace_timeline_start();
    result = screen->fence_finish(screen, fence, timeout);
+   trace_timeline_record(TRACE_TIMELINE_FENCE_WAIT, screen, timeout, start);
 
    trace_dump_ret(bool, result);
 
@@ -447,6 +451,9 @@ trace_enabled(void)
       trace = TRUE;
    }
 
+   if (trace_timeline_begin())
+      trace = TRUE;
+
    return trace;
 }
 
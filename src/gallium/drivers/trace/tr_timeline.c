@@ -0,0 +1,155 @@
+/**************************************************************************
+ *
+ * Copyright 2013 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDERS, AUTHORS AND/OR ITS SUPPLIERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ **************************************************************************/
+
+/**
+ * @file
+ * Binary timeline writer.
+ *
+ * Events are accumulated in a memory buffer and only written to the file
+ * when it is full and at exit, so recording one costs a time stamp, a mutex
+ * and a few stores.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "os/os_thread.h"
+#include "util/u_debug.h"
+#include "util/u_memory.h"
+
+#include "tr_timeline.h"
+
+
+#define TRACE_TIMELINE_BUFFER_EVENTS (16 * 1024)
+
+static FILE *stream = NULL;
+pipe_static_mutex(timeline_mutex);
+static struct trace_timeline_event *events = NULL;
+static unsigned num_events = 0;
+
+
+static void
+trace_timeline_flush_locked(void)
+{
+   if (num_events) {
+      fwrite(events, sizeof(events[0]), num_events, stream);
+      num_events = 0;
+   }
+}
+
+
+static void
+trace_timeline_close(void)
+{
+   pipe_mutex_lock(timeline_mutex);
+   if (stream) {
+      trace_timeline_flush_locked();
+      fclose(stream);
+      stream = NULL;
+   }
+   FREE(events);
+   events = NULL;
+   pipe_mutex_unlock(timeline_mutex);
+}
+
+
+/**
+ * Open the file named by GALLIUM_TRACE_TIMELINE, if any.
+ */
+boolean
+trace_timeline_begin(void)
+{
+   const char *filename;
+   uint32_t header[2] = { TRACE_TIMELINE_MAGIC, TRACE_TIMELINE_VERSION };
+
+   filename = debug_get_option("GALLIUM_TRACE_TIMELINE", NULL);
+   if (!filename)
+      return FALSE;
+
+   if (!stream) {
+      events = MALLOC(TRACE_TIMELINE_BUFFER_EVENTS * sizeof(events[0]));
+      if (!events)
+         return FALSE;
+
+      stream = fopen(filename, "wb");
+      if (!stream) {
+         FREE(events);
+         events = NULL;
+         return FALSE;
+      }
+
+      fwrite(header, sizeof(header), 1, stream);
+
+      /* Like the XML dump, only close the file at exit, as many applications
+       * create and destroy several screens.
+       */
+      atexit(trace_timeline_close);
+   }
+
+   return TRUE;
+}
+
+
+boolean
+trace_timeline_enabled(void)
+{
+   return stream ? TRUE : FALSE;
+}
+
+
+/**
+ * Record a call on \p object which started at \p start, as returned by
+ * trace_timeline_start(), and ends now.
+ */
+void
+trace_timeline_record(enum trace_timeline_event_type type,
+                      const void *object, uint64_t arg,
+                      int64_t start)
+{
+   int64_t end;
+   struct trace_timeline_event *event;
+
+   if (!start)
+      return;
+
+   end = os_time_get();
+
+   pipe_mutex_lock(timeline_mutex);
+   if (stream) {
+      if (num_events == TRACE_TIMELINE_BUFFER_EVENTS)
+         trace_timeline_flush_locked();
+
+      event = &events[num_events++];
+      event->start = start;
+      event->duration = end - start;
+      event->object = (uint64_t) (uintptr_t) object;
+      event->arg = arg;
+      event->type = type;
+      event->padding = 0;
+   }
+   pipe_mutex_unlock(timeline_mutex);
+}
@@ -0,0 +1,96 @@
+/**************************************************************************
+ *
+ * Copyright 2013 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDERS, AUTHORS AND/OR ITS SUPPLIERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ **************************************************************************/
+
+/**
+ * @file
+ * Lightweight binary timeline of the trace driver calls.
+ *
+ * Unlike the XML dump, this only records when draws, flushes, transfer
+ * maps, fence waits and shader creations started and how long they took,
+ * into a memory buffer which is written out in large blocks, so that it can
+ * be left enabled while running real workloads.
+ *
+ * It is enabled with GALLIUM_TRACE_TIMELINE=filename, independently of
+ * GALLIUM_TRACE.  src/gallium/tools/trace/timeline.py converts the file to
+ * the Chrome trace event format (chrome://tracing).
+ */
+
+#ifndef TR_TIMELINE_H
+#define TR_TIMELINE_H
+
+
+#include "pipe/p_compiler.h"
+#include "os/os_time.h"
+
+
+#define TRACE_TIMELINE_MAGIC   0x4c545447 /* "GTTL" */
+#define TRACE_TIMELINE_VERSION 1
+
+enum trace_timeline_event_type {
+   TRACE_TIMELINE_DRAW,
+   TRACE_TIMELINE_CLEAR,
+   TRACE_TIMELINE_BLIT,
+   TRACE_TIMELINE_FLUSH,
+   TRACE_TIMELINE_TRANSFER_MAP,
+   TRACE_TIMELINE_FENCE_WAIT,
+   TRACE_TIMELINE_SHADER_CREATE,
+};
+
+/**
+ * One event, as written to the file in host byte order, after a header
+ * made of TRACE_TIMELINE_MAGIC and TRACE_TIMELINE_VERSION as 32 bit values.
+ */
+struct trace_timeline_event {
+   int64_t start;    /**< os_time_get() before the call, in microseconds */
+   int64_t duration; /**< in microseconds */
+   uint64_t object;  /**< context or screen the call was made on */
+   uint64_t arg;     /**< vertex count, flags, usage, ... depending on type */
+   uint32_t type;    /**< enum trace_timeline_event_type */
+   uint32_t padding;
+};
+
+
+boolean trace_timeline_begin(void);
+boolean trace_timeline_enabled(void);
+
+void trace_timeline_record(enum trace_timeline_event_type type,
+                           const void *object, uint64_t arg,
+                           int64_t start);
+
+
+/**
+ * Time stamp to pass to trace_timeline_record() once the call is done, or
+ * zero if the timeline is disabled.
+ */
+static INLINE int64_t
+trace_timeline_start(void)
+{
+   return trace_timeline_enabled() ? os_time_get() : 0;
+}
+
+
+#endif /* TR_TIMELINE_H */
@@ -160,6 +160,17 @@ struct pipe_screen {
 						  const struct pipe_resource *templat,
 						  struct winsys_handle *handle);
 
+   /**
+    * Create a resource that uses the given user memory as its storage,
+    * without copying it.  The memory must stay valid for the lifetime of
+    * the resource.  Optional; NULL if the driver cannot address user
+    * memory directly, and the function itself returns NULL for templates
+    * it cannot wrap (callers must then fall back to resource_create).
+    */
+   struct pipe_resource * (*resource_from_user_memory)(struct pipe_screen *,
+                                                       const struct pipe_resource *templat,
+                                                       void *user_memory);
+
    /**
     * Get a winsys_handle from a texture. Some platforms/winsys requires
     * that the texture is created with a special usage flag like
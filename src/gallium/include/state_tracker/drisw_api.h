@@ -13,6 +13,14 @@ struct drisw_loader_funcs
 {
    void (*put_image) (struct dri_drawable *dri_drawable,
                       void *data, unsigned width, unsigned height);
+
+   /**
+    * Like put_image, for data in SysV shared memory segment shmid, which
+    * is attached at shmaddr.  width is stride / cpp as for put_image.
+    */
+   void (*put_image_shm) (struct dri_drawable *dri_drawable,
+                          int shmid, char *shmaddr, unsigned offset,
+                          unsigned width, unsigned height, unsigned stride);
 };
 
 /**
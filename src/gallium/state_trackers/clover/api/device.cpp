@@ -204,7 +204,7 @@ clGetDeviceInfo(cl_device_id dev, cl_device_info param,
 
    case CL_DEVICE_QUEUE_PROPERTIES:
       return scalar_property<cl_command_queue_properties>(buf, size, size_ret,
-         CL_QUEUE_PROFILING_ENABLE);
+         CL_QUEUE_PROFILING_ENABLE | CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE);
 
    case CL_DEVICE_NAME:
       return string_property(buf, size, size_ret, dev->device_name());
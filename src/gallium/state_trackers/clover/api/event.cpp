@@ -181,7 +181,13 @@ clEnqueueBarrier(cl_command_queue q) {
    if (!q)
       return CL_INVALID_COMMAND_QUEUE;
 
-   // No need to do anything, q preserves data ordering strictly.
+   // No need to do anything if q preserves data ordering strictly.
+   if (q->props() & CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE) {
+      // Otherwise create a synchronization point: subsequent commands
+      // in the same queue will wait for every command before it.
+      ref_ptr<hard_event> hev = transfer(new hard_event(*q, 0, {}));
+   }
+
    return CL_SUCCESS;
 }
 
@@ -108,7 +108,7 @@ clSetKernelArg(cl_kernel kern, cl_uint idx, size_t size,
    if (idx >= kern->args.size())
       throw error(CL_INVALID_ARG_INDEX);
 
-   kern->args[idx]->set(size, value);
+   kern->set_arg(idx, size, value);
 
    return CL_SUCCESS;
 
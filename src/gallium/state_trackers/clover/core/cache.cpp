@@ -0,0 +1,143 @@
+//
+// Copyright 2013 The Mesa Authors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+// OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#include <cstdlib>
+#include <dlfcn.h>
+#include <sys/stat.h>
+
+#include "core/cache.hpp"
+#include "util/u_disk_cache.h"
+#include "util/u_memory.h"
+
+using namespace clover;
+
+namespace {
+   std::string
+   cache_dir() {
+      const char *dir;
+
+      // An empty CLOVER_CACHE_DIR disables the cache.
+      if ((dir = std::getenv("CLOVER_CACHE_DIR")))
+         return dir;
+      else if ((dir = std::getenv("XDG_CACHE_HOME")))
+         return std::string(dir) + "/mesa/clover";
+      else if ((dir = std::getenv("HOME")))
+         return std::string(dir) + "/.cache/mesa/clover";
+      else
+         return "";
+   }
+
+   void
+   make_dir(const std::string &path) {
+      for (size_t i = path.find('/', 1); i != std::string::npos;
+           i = path.find('/', i + 1))
+         mkdir(path.substr(0, i).c_str(), 0755);
+
+      mkdir(path.c_str(), 0755);
+   }
+
+   // Neither the module layout nor the code generation are stable
+   // across builds of the library, which we tell apart by its file.
+   // Returns an empty string if the file can't be found.
+   std::string
+   cache_id() {
+      Dl_info info;
+      struct stat st;
+
+      if (!dladdr(reinterpret_cast<void *>(&cache_id), &info) ||
+          !info.dli_fname || stat(info.dli_fname, &st))
+         return "";
+
+      return "clover " + std::to_string((unsigned long)st.st_mtime) +
+         " " + std::to_string((unsigned long)st.st_size);
+   }
+}
+
+program_cache::program_cache() : cache(NULL) {
+   std::string path = cache_dir();
+   std::string id = cache_id();
+
+   if (!path.empty() && !id.empty()) {
+      make_dir(path);
+      cache = util_disk_cache_create(path.c_str(), id.c_str());
+   }
+}
+
+program_cache::~program_cache() {
+   if (cache)
+      util_disk_cache_destroy(cache);
+}
+
+std::string
+program_cache::key(const device &dev, const std::string &source,
+                   const std::string &opts) const {
+   std::string k;
+
+   k += std::to_string((int)dev.ir_format()) + '\0';
+   k += dev.ir_target() + '\0';
+   k += dev.device_name() + '\0';
+   k += opts + '\0';
+   k += source;
+
+   return k;
+}
+
+bool
+program_cache::get(const device &dev, const std::string &source,
+                   const std::string &opts, module &m) {
+   void *data;
+   size_t size;
+
+   if (!cache)
+      return false;
+
+   std::string k = key(dev, source, opts);
+   if (!util_disk_cache_get(cache, k.data(), k.size(), &data, &size))
+      return false;
+
+   try {
+      compat::istream::buffer_t bin((const unsigned char *)data, size);
+      compat::istream s(bin);
+
+      m = module::deserialize(s);
+      FREE(data);
+      return true;
+
+   } catch (compat::istream::error &e) {
+      FREE(data);
+      return false;
+   }
+}
+
+void
+program_cache::put(const device &dev, const std::string &source,
+                   const std::string &opts, const module &m) {
+   if (!cache)
+      return;
+
+   compat::ostream::buffer_t bin;
+   compat::ostream s(bin);
+   std::string k = key(dev, source, opts);
+
+   m.serialize(s);
+   util_disk_cache_put(cache, k.data(), k.size(), bin.begin(), bin.size());
+}
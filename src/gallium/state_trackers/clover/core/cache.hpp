@@ -0,0 +1,65 @@
+//
+// Copyright 2013 The Mesa Authors
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// to deal in the Software without restriction, including without limitation
+// the rights to use, copy, modify, merge, publish, distribute, sublicense,
+// and/or sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+// THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+// OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+// ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+//
+
+#ifndef __CORE_CACHE_HPP__
+#define __CORE_CACHE_HPP__
+
+#include <string>
+
+#include "core/device.hpp"
+#include "core/module.hpp"
+
+struct util_disk_cache;
+
+namespace clover {
+   ///
+   /// Persistent on-disk cache of the modules built from program
+   /// source, keyed by the source, the build options and the device.
+   ///
+   class program_cache {
+   public:
+      program_cache();
+      program_cache(const program_cache &) = delete;
+      ~program_cache();
+
+      program_cache &
+      operator=(const program_cache &) = delete;
+
+      ///
+      /// Look up the module built from \a source with \a opts for
+      /// \a dev.  Returns false if there is none.
+      ///
+      bool get(const device &dev, const std::string &source,
+               const std::string &opts, module &m);
+
+      void put(const device &dev, const std::string &source,
+               const std::string &opts, const module &m);
+
+   private:
+      std::string key(const device &dev, const std::string &source,
+                      const std::string &opts) const;
+
+      util_disk_cache *cache;
+   };
+}
+
+#endif
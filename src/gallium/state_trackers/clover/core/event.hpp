@@ -88,8 +88,9 @@ namespace clover {
    /// Similar to a normal clover::event.  In addition it's associated
    /// with a given command queue \a q and a given OpenCL \a command.
    /// hard_event instances created for the same queue are implicitly
-   /// ordered with respect to each other, and they are implicitly
-   /// triggered on construction.
+   /// ordered with respect to each other unless the queue is in
+   /// out-of-order mode, and they are implicitly triggered on
+   /// construction.
    ///
    /// A hard_event is considered complete when the associated
    /// hardware task finishes execution.
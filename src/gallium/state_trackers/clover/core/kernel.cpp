@@ -89,7 +89,12 @@ _cl_kernel::launch(clover::command_queue &q,
    q.pipe->set_compute_resources(q.pipe, 0, exec.resources.size(), NULL);
    q.pipe->set_compute_sampler_views(q.pipe, 0, exec.sviews.size(), NULL);
    q.pipe->bind_compute_sampler_states(q.pipe, 0, exec.samplers.size(), NULL);
+}
+
+void
+_cl_kernel::set_arg(size_t idx, size_t size, const void *value) {
    exec.unbind();
+   args[idx]->set(size, value);
 }
 
 size_t
@@ -131,21 +136,31 @@ _cl_kernel::module(const clover::command_queue &q) const {
 
 
 _cl_kernel::exec_context::exec_context(clover::kernel &kern) :
-   kern(kern), q(NULL), mem_local(0), st(NULL) {
+   kern(kern), q(NULL), mem_local(0), valid(false), st(NULL) {
 }
 
 _cl_kernel::exec_context::~exec_context() {
+   unbind();
+
    if (st)
       q->pipe->delete_compute_state(q->pipe, st);
 }
 
 void *
 _cl_kernel::exec_context::bind(clover::command_queue *__q) {
+   // Nothing to do if the arguments haven't changed since the last
+   // launch on this queue.
+   if (valid && q == __q)
+      return st;
+
+   unbind();
    std::swap(q, __q);
 
    for (auto &arg : kern.args)
       arg->bind(*this);
 
+   valid = true;
+
    // Create a new compute state if anything changed.
    if (!st || q != __q ||
        cs.req_local_mem != mem_local ||
@@ -164,9 +179,16 @@ _cl_kernel::exec_context::bind(clover::command_queue *__q) {
 
 void
 _cl_kernel::exec_context::unbind() {
+   if (!valid)
+      return;
+
    for (auto &arg : kern.args)
       arg->unbind(*this);
 
+   mem_objs.clear();
+   sampler_objs.clear();
+   valid = false;
+
    input.clear();
    samplers.clear();
    sviews.clear();
@@ -237,6 +259,7 @@ _cl_kernel::global_argument::bind(exec_context &ctx) {
 
    ctx.g_buffers.resize(idx + 1);
    ctx.g_buffers[idx] = obj->resource(ctx.q).pipe;
+   ctx.mem_objs.emplace_back(obj);
 
    ctx.g_handles.resize(idx + 1);
    ctx.g_handles[idx] = offset;
@@ -305,6 +328,7 @@ _cl_kernel::constant_argument::bind(exec_context &ctx) {
 
    ctx.resources.resize(idx + 1);
    ctx.resources[idx] = st = obj->resource(ctx.q).bind_surface(*ctx.q, false);
+   ctx.mem_objs.emplace_back(obj);
 }
 
 void
@@ -338,6 +362,7 @@ _cl_kernel::image_rd_argument::bind(exec_context &ctx) {
 
    ctx.sviews.resize(idx + 1);
    ctx.sviews[idx] = st = obj->resource(ctx.q).bind_sampler_view(*ctx.q);
+   ctx.mem_objs.emplace_back(obj);
 }
 
 void
@@ -371,6 +396,7 @@ _cl_kernel::image_wr_argument::bind(exec_context &ctx) {
 
    ctx.resources.resize(idx + 1);
    ctx.resources[idx] = st = obj->resource(ctx.q).bind_surface(*ctx.q, true);
+   ctx.mem_objs.emplace_back(obj);
 }
 
 void
@@ -397,6 +423,7 @@ _cl_kernel::sampler_argument::bind(exec_context &ctx) {
 
    ctx.samplers.resize(idx + 1);
    ctx.samplers[idx] = st = obj->bind(*ctx.q);
+   ctx.sampler_objs.emplace_back(obj);
 }
 
 void
@@ -40,7 +40,8 @@ struct _cl_kernel : public clover::ref_counter {
 private:
    ///
    /// Class containing all the state required to execute a compute
-   /// kernel.
+   /// kernel.  It's kept around after a launch so that later launches
+   /// on the same queue with the same arguments can reuse it.
    ///
    struct exec_context {
       exec_context(clover::kernel &kern);
@@ -60,7 +61,13 @@ private:
       std::vector<size_t> g_handles;
       size_t mem_local;
 
+      /// Objects referenced by the bound state, kept alive until it's
+      /// released.
+      std::vector<clover::ref_ptr<clover::memory_obj>> mem_objs;
+      std::vector<clover::ref_ptr<clover::sampler>> sampler_objs;
+
    private:
+      bool valid;
       void *st;
       pipe_compute_state cs;
    };
@@ -98,6 +105,10 @@ public:
               const std::string &name,
               const std::vector<clover::module::argument> &args);
 
+   /// Set argument \a idx, dropping any state bound for its
+   /// previous value.
+   void set_arg(size_t idx, size_t size, const void *value);
+
    void launch(clover::command_queue &q,
                const std::vector<size_t> &grid_offset,
                const std::vector<size_t> &grid_size,
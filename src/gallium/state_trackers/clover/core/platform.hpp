@@ -26,6 +26,7 @@
 #include <vector>
 
 #include "core/base.hpp"
+#include "core/cache.hpp"
 #include "core/device.hpp"
 
 namespace clover {
@@ -59,6 +60,11 @@ public:
    }
    /// @}
 
+   ///
+   /// Modules built for the devices of this platform.
+   ///
+   clover::program_cache cache;
+
 protected:
    std::vector<clover::device> devs;
 };
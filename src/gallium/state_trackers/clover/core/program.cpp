@@ -22,6 +22,7 @@
 
 #include "core/program.hpp"
 #include "core/compiler.hpp"
+#include "core/platform.hpp"
 
 using namespace clover;
 
@@ -45,17 +46,33 @@ _cl_program::build(const std::vector<clover::device *> &devs,
                    const char *opts) {
 
    for (auto dev : devs) {
+      // Programs created from binaries have nothing to compile, the
+      // binaries are used as they are.
+      if (__source.empty()) {
+         if (!__binaries.count(dev))
+            throw error(CL_INVALID_BINARY);
+
+         __opts.erase(dev);
+         __opts.insert({ dev, opts });
+         continue;
+      }
+
       __binaries.erase(dev);
       __logs.erase(dev);
       __opts.erase(dev);
 
       __opts.insert({ dev, opts });
       try {
-         auto module = (dev->ir_format() == PIPE_SHADER_IR_TGSI ?
-                        compile_program_tgsi(__source) :
-                        compile_program_llvm(__source, dev->ir_format(),
-                        dev->ir_target(), build_opts(dev)));
-         __binaries.insert({ dev, module });
+         module m;
+
+         if (!dev->platform.cache.get(*dev, __source, opts, m)) {
+            m = (dev->ir_format() == PIPE_SHADER_IR_TGSI ?
+                 compile_program_tgsi(__source) :
+                 compile_program_llvm(__source, dev->ir_format(),
+                                      dev->ir_target(), build_opts(dev)));
+            dev->platform.cache.put(*dev, __source, opts, m);
+         }
+         __binaries.insert({ dev, m });
 
       } catch (build_error &e) {
          __logs.insert({ dev, e.what() });
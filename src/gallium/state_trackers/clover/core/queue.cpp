@@ -47,10 +47,17 @@ _cl_command_queue::flush() {
    pipe_fence_handle *fence = NULL;
 
    if (!queued_events.empty()) {
-      // Find out which events have already been signalled.
+      // Find out which events have already been signalled.  They
+      // don't have to be contiguous in out-of-order mode, so move
+      // them to the front first.
       auto first = queued_events.begin();
-      auto last = std::find_if(queued_events.begin(), queued_events.end(),
-                               [](event_ptr &ev) { return !ev->signalled(); });
+      auto last = std::stable_partition(
+         queued_events.begin(), queued_events.end(),
+         [](const event_ptr &ev) { return ev->signalled(); });
+
+      // Nothing was submitted to the pipe since the last flush.
+      if (first == last)
+         return;
 
       // Flush and fence them.
       pipe->flush(pipe, &fence, 0);
@@ -62,8 +69,24 @@ _cl_command_queue::flush() {
 
 void
 _cl_command_queue::sequence(clover::hard_event *ev) {
-   if (!queued_events.empty())
+   if (__props & CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE) {
+      // Markers and synchronization points (hard events without a
+      // command type) wait for everything queued before them, the
+      // rest only wait for the last synchronization point and for
+      // their own wait list.
+      if (ev->command() == CL_COMMAND_MARKER || !ev->command()) {
+         for (auto &qev : queued_events)
+            qev->chain(ev);
+      } else if (last_barrier) {
+         last_barrier->chain(ev);
+      }
+
+      if (!ev->command())
+         last_barrier = ev;
+
+   } else if (!queued_events.empty()) {
       queued_events.back()->chain(ev);
+   }
 
    queued_events.push_back(ev);
 }
@@ -59,7 +59,9 @@ public:
 
 private:
    /// Serialize a hardware event with respect to the previous ones,
-   /// and push it to the pending list.
+   /// and push it to the pending list.  In out-of-order mode only
+   /// markers and synchronization points are serialized, other
+   /// events just wait for the last synchronization point.
    void sequence(clover::hard_event *ev);
 
    cl_command_queue_properties __props;
@@ -67,6 +69,7 @@ private:
 
    typedef clover::ref_ptr<clover::hard_event> event_ptr;
    std::vector<event_ptr> queued_events;
+   event_ptr last_barrier;
 };
 
 #endif
@@ -137,16 +137,30 @@ root_resource::root_resource(clover::device &dev, clover::memory_obj &obj,
                 PIPE_BIND_TRANSFER_READ |
                 PIPE_BIND_TRANSFER_WRITE);
 
+   if ((obj.flags() & CL_MEM_USE_HOST_PTR) &&
+       dev.pipe->resource_from_user_memory) {
+      // Let the device work on the application's memory directly, so
+      // that neither the upload nor later mappings need a copy.
+      pipe = dev.pipe->resource_from_user_memory(dev.pipe, &info,
+                                                  obj.host_ptr());
+      if (pipe)
+         return;
+   }
+
    pipe = dev.pipe->resource_create(dev.pipe, &info);
    if (!pipe)
       throw error(CL_OUT_OF_RESOURCES);
 
-   if (!data.empty()) {
+   const char *src = (obj.flags() & CL_MEM_USE_HOST_PTR ?
+                      (const char *)obj.host_ptr() :
+                      data.empty() ? NULL : data.data());
+
+   if (src) {
       box rect { { 0, 0, 0 }, { info.width0, info.height0, info.depth0 } };
       unsigned cpp = util_format_get_blocksize(info.format);
 
       q.pipe->transfer_inline_write(q.pipe, pipe, 0, PIPE_TRANSFER_WRITE,
-                                    rect, data.data(), cpp * info.width0,
+                                    rect, src, cpp * info.width0,
                                     cpp * info.width0 * info.height0);
    }
 }
@@ -69,6 +69,9 @@ struct dri_drawable
 
    /* used only by DRISW */
    struct pipe_surface *drisw_surface;
+   /* window-space rectangle being presented by glXCopySubBufferMESA,
+    * drisw_sub_w is 0 when presenting the whole buffer */
+   int drisw_sub_x, drisw_sub_y, drisw_sub_w, drisw_sub_h;
 
    /* hooks filled in by dri2 & drisw */
    void (*allocate_textures)(struct dri_drawable *drawable,
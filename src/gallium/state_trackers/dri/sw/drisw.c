@@ -28,10 +28,10 @@
 
 /* TODO:
  *
- * xshm / EGLImage:
+ * EGLImage:
  *
- * Allow the loaders to use the XSHM extension. It probably requires callbacks
- * for createImage/destroyImage similar to DRI2 getBuffers.
+ * It probably requires callbacks for createImage/destroyImage similar to
+ * DRI2 getBuffers.
  */
 
 #include "util/u_format.h"
@@ -70,6 +70,19 @@ put_image(__DRIdrawable *dPriv, void *data, unsigned width, unsigned height)
                     data, dPriv->loaderPrivate);
 }
 
+static INLINE void
+put_image_shm(__DRIdrawable *dPriv, int shmid, char *shmaddr,
+              unsigned offset, int x, int y, unsigned width, unsigned height,
+              unsigned stride)
+{
+   __DRIscreen *sPriv = dPriv->driScreenPriv;
+   const __DRIswrastLoaderExtension *loader = sPriv->swrast_loader;
+
+   loader->putImageShm(dPriv, __DRI_SWRAST_IMAGE_OP_SWAP,
+                       x, y, width, height, stride,
+                       shmid, shmaddr, offset, dPriv->loaderPrivate);
+}
+
 static INLINE void
 get_image(__DRIdrawable *dPriv, int x, int y, int width, int height, void *data)
 {
@@ -99,6 +112,39 @@ drisw_put_image(struct dri_drawable *drawable,
    put_image(dPriv, data, width, height);
 }
 
+static void
+drisw_put_image_shm(struct dri_drawable *drawable,
+                    int shmid, char *shmaddr, unsigned offset,
+                    unsigned width, unsigned height, unsigned stride)
+{
+   __DRIdrawable *dPriv = drawable->dPriv;
+   const __DRIswrastLoaderExtension *loader =
+      dPriv->driScreenPriv->swrast_loader;
+   int x = 0, y = 0, x1 = width, y1 = height;
+
+   /* older loaders can still read the segment through our mapping */
+   if (loader->base.version < 2 || !loader->putImageShm) {
+      put_image(dPriv, shmaddr + offset, width, height);
+      return;
+   }
+
+   /* With MIT-SHM only the rectangle being presented is sent over. */
+   if (drawable->drisw_sub_w) {
+      const unsigned cpp = stride / width;
+
+      x = MAX2(drawable->drisw_sub_x, 0);
+      y = MAX2(drawable->drisw_sub_y, 0);
+      x1 = MIN2(drawable->drisw_sub_x + drawable->drisw_sub_w, (int) width);
+      y1 = MIN2(drawable->drisw_sub_y + drawable->drisw_sub_h, (int) height);
+      if (x >= x1 || y >= y1)
+         return;
+
+      offset += y * stride + x * cpp;
+   }
+
+   put_image_shm(dPriv, shmid, shmaddr, offset, x, y, x1 - x, y1 - y, stride);
+}
+
 static INLINE void
 drisw_present_texture(__DRIdrawable *dPriv,
                       struct pipe_resource *ptex)
@@ -148,7 +194,12 @@ drisw_swap_buffers(__DRIdrawable *dPriv)
    ptex = drawable->textures[ST_ATTACHMENT_BACK_LEFT];
 
    if (ptex) {
-      if (ctx->pp && drawable->textures[ST_ATTACHMENT_DEPTH_STENCIL])
+      if (drawable->stvis.samples > 1) {
+         /* Resolve the MSAA back buffer. */
+         dri_pipe_blit(ctx->st->pipe, ptex,
+                       drawable->msaa_textures[ST_ATTACHMENT_BACK_LEFT]);
+      }
+      else if (ctx->pp && drawable->textures[ST_ATTACHMENT_DEPTH_STENCIL])
          pp_run(ctx->pp, ptex, ptex, drawable->textures[ST_ATTACHMENT_DEPTH_STENCIL]);
 
       ctx->st->flush(ctx->st, ST_FLUSH_FRONT, NULL);
@@ -157,6 +208,43 @@ drisw_swap_buffers(__DRIdrawable *dPriv)
    }
 }
 
+/**
+ * glXCopySubBufferMESA: present a rectangle of the back buffer.
+ */
+static void
+drisw_copy_sub_buffer(__DRIdrawable *dPriv, int x, int y, int w, int h)
+{
+   struct dri_context *ctx = dri_get_current(dPriv->driScreenPriv);
+   struct dri_drawable *drawable = dri_drawable(dPriv);
+   struct pipe_resource *ptex;
+
+   if (!ctx)
+      return;
+
+   ptex = drawable->textures[ST_ATTACHMENT_BACK_LEFT];
+
+   if (ptex) {
+      if (drawable->stvis.samples > 1) {
+         /* Resolve the MSAA back buffer. */
+         dri_pipe_blit(ctx->st->pipe, ptex,
+                       drawable->msaa_textures[ST_ATTACHMENT_BACK_LEFT]);
+      }
+
+      ctx->st->flush(ctx->st, ST_FLUSH_FRONT, NULL);
+
+      /* GL's y axis points up, the window's down. */
+      drawable->drisw_sub_x = x;
+      drawable->drisw_sub_y = dPriv->h - y - h;
+      drawable->drisw_sub_w = w;
+      drawable->drisw_sub_h = h;
+
+      if (w > 0 && h > 0)
+         drisw_present_texture(dPriv, ptex);
+
+      drawable->drisw_sub_w = 0;
+   }
+}
+
 static void
 drisw_flush_frontbuffer(struct dri_context *ctx,
                         struct dri_drawable *drawable,
@@ -170,6 +258,14 @@ drisw_flush_frontbuffer(struct dri_context *ctx,
    ptex = drawable->textures[statt];
 
    if (ptex) {
+      if (drawable->stvis.samples > 1) {
+         struct pipe_context *pipe = ctx->st->pipe;
+
+         /* Resolve the MSAA front buffer. */
+         dri_pipe_blit(pipe, ptex, drawable->msaa_textures[statt]);
+         pipe->flush(pipe, NULL, 0);
+      }
+
       drisw_copy_to_front(ctx->dPriv, ptex);
    }
 }
@@ -180,6 +276,10 @@ drisw_flush_frontbuffer(struct dri_context *ctx,
  * During fixed-size operation, the function keeps allocating new attachments
  * as they are requested. Unused attachments are not removed, not until the
  * framebuffer is resized or destroyed.
+ *
+ * Multisample visuals render to private MSAA attachments, which are resolved
+ * into the single-sample colour attachments before presenting, like dri2
+ * does.  The depth-stencil attachment is then only allocated multisampled.
  */
 static void
 drisw_allocate_textures(struct dri_drawable *drawable,
@@ -200,8 +300,10 @@ drisw_allocate_textures(struct dri_drawable *drawable,
 
    /* remove outdated textures */
    if (resized) {
-      for (i = 0; i < ST_ATTACHMENT_COUNT; i++)
+      for (i = 0; i < ST_ATTACHMENT_COUNT; i++) {
          pipe_resource_reference(&drawable->textures[i], NULL);
+         pipe_resource_reference(&drawable->msaa_textures[i], NULL);
+      }
    }
 
    memset(&templ, 0, sizeof(templ));
@@ -216,19 +318,32 @@ drisw_allocate_textures(struct dri_drawable *drawable,
       enum pipe_format format;
       unsigned bind;
 
-      /* the texture already exists or not requested */
-      if (drawable->textures[statts[i]])
+      dri_drawable_get_format(drawable, statts[i], &format, &bind);
+
+      if (format == PIPE_FORMAT_NONE)
          continue;
 
-      dri_drawable_get_format(drawable, statts[i], &format, &bind);
+      if (drawable->stvis.samples > 1 &&
+          !drawable->msaa_textures[statts[i]]) {
+         templ.format = format;
+         templ.bind = bind;
+         templ.nr_samples = drawable->stvis.samples;
+
+         drawable->msaa_textures[statts[i]] =
+            screen->base.screen->resource_create(screen->base.screen, &templ);
+         templ.nr_samples = 0;
+      }
+
+      /* the texture already exists or not requested */
+      if (drawable->textures[statts[i]] ||
+          (drawable->stvis.samples > 1 &&
+           statts[i] == ST_ATTACHMENT_DEPTH_STENCIL))
+         continue;
 
       /* if we don't do any present, no need for display targets */
       if (statts[i] != ST_ATTACHMENT_DEPTH_STENCIL && !swrast_no_present)
          bind |= PIPE_BIND_DISPLAY_TARGET;
 
-      if (format == PIPE_FORMAT_NONE)
-         continue;
-
       templ.format = format;
       templ.bind = bind;
 
@@ -281,13 +396,20 @@ drisw_update_tex_buffer(struct dri_drawable *drawable,
  * Backend function for init_screen.
  */
 
+static const __DRIcopySubBufferExtension drisw_copy_sub_buffer_extension = {
+   .base = { __DRI_COPY_SUB_BUFFER, __DRI_COPY_SUB_BUFFER_VERSION },
+   .copySubBuffer = drisw_copy_sub_buffer,
+};
+
 static const __DRIextension *drisw_screen_extensions[] = {
    &driTexBufferExtension.base,
+   &drisw_copy_sub_buffer_extension.base,
    NULL
 };
 
 static struct drisw_loader_funcs drisw_lf = {
-   .put_image = drisw_put_image
+   .put_image = drisw_put_image,
+   .put_image_shm = drisw_put_image_shm
 };
 
 static const __DRIconfig **
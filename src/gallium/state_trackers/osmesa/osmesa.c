@@ -38,9 +38,12 @@
  * With llvmpipe we could only render directly into the user's buffer when its
  * width and height is a multiple of the tile size (64 pixels).
  *
- * Because of these constraints we always render into ordinary resources then
- * copy the results to the user's buffer in the flush_front() function which
- * is called when the app calls glFlush/Finish.
+ * So when the driver can wrap user memory in a resource (see
+ * pipe_screen::resource_from_user_memory) and the user's buffer is laid
+ * out the way the driver wants it (Y down, no padding between rows) we
+ * render straight into it.  Otherwise we render into ordinary resources
+ * then copy the results to the user's buffer in the flush_front() function
+ * which is called when the app calls glFlush/Finish.
  *
  * In general, the OSMesa interface is pretty ugly and not a good match
  * for Gallium.  But we're interested in doing the best we can to preserve
@@ -57,6 +60,8 @@
 #include "pipe/p_screen.h"
 #include "pipe/p_state.h"
 
+#include "os/os_thread.h"
+
 #include "util/u_atomic.h"
 #include "util/u_box.h"
 #include "util/u_format.h"
@@ -81,6 +86,10 @@ struct osmesa_buffer
    struct pipe_resource *textures[ST_ATTACHMENT_COUNT];
 
    void *map;
+   GLboolean render_direct; /*< TRUE -> map may back the color buffer */
+   GLboolean direct;        /*< TRUE -> map backs the color buffer */
+
+   struct osmesa_context *context; /*< context last bound to, if any */
 
    struct osmesa_buffer *next;  /**< next in linked list */
 };
@@ -109,9 +118,18 @@ struct osmesa_context
  * We have to do this to be compatible with the original OSMesa implementation
  * because some apps call OSMesaMakeCurrent() several times during rendering
  * a frame.
+ * A buffer is only reused by the context it was last bound to, or once
+ * that context is destroyed, so that contexts rendering concurrently in
+ * different threads never share a framebuffer.
  */
 static struct osmesa_buffer *BufferList = NULL;
 
+/**
+ * Protects BufferList and the creation of the st_api and st_manager
+ * singletons, for apps using several contexts in different threads.
+ */
+pipe_static_mutex(osmesa_mutex);
+
 
 /**
  * Called from the ST manager.
@@ -131,9 +149,11 @@ static struct st_api *
 get_st_api(void)
 {
    static struct st_api *stapi = NULL;
+   pipe_mutex_lock(osmesa_mutex);
    if (!stapi) {
       stapi = st_gl_api_create();
    }
+   pipe_mutex_unlock(osmesa_mutex);
    return stapi;
 }
 
@@ -145,6 +165,7 @@ static struct st_manager *
 get_st_manager(void)
 {
    static struct st_manager *stmgr = NULL;
+   pipe_mutex_lock(osmesa_mutex);
    if (!stmgr) {
       stmgr = CALLOC_STRUCT(st_manager);
       if (stmgr) {
@@ -153,6 +174,7 @@ get_st_manager(void)
          stmgr->get_egl_image = NULL;
       }         
    }
+   pipe_mutex_unlock(osmesa_mutex);
    return stmgr;
 }
 
@@ -302,6 +324,19 @@ osmesa_st_framebuffer_flush_front(struct st_context_iface *stctx,
    unsigned y, bytes, bpp;
    int dst_stride;
 
+   if (osbuffer->direct) {
+      /* Rendering went straight into the user's buffer, just wait for it */
+      struct pipe_screen *screen = get_st_manager()->screen;
+      struct pipe_fence_handle *fence = NULL;
+
+      pipe->flush(pipe, &fence, 0);
+      if (fence) {
+         screen->fence_finish(screen, fence, PIPE_TIMEOUT_INFINITE);
+         screen->fence_reference(screen, &fence, NULL);
+      }
+      return TRUE;
+   }
+
    u_box_2d(0, 0, res->width0, res->height0, &box);
 
    map = pipe->transfer_map(pipe, res, 0, PIPE_TRANSFER_READ, &box,
@@ -364,6 +399,8 @@ osmesa_st_framebuffer_validate(struct st_framebuffer_iface *stfbi,
    templat.bind = 0; /* setup below */
    templat.flags = 0;
 
+   osbuffer->direct = GL_FALSE;
+
    for (i = 0; i < count; i++) {
       enum pipe_format format = PIPE_FORMAT_NONE;
       unsigned bind = 0;
@@ -392,8 +429,20 @@ osmesa_st_framebuffer_validate(struct st_framebuffer_iface *stfbi,
 
       templat.format = format;
       templat.bind = bind;
-      out[i] = osbuffer->textures[i] =
-         screen->resource_create(screen, &templat);
+      out[i] = NULL;
+
+      if (statts[i] == ST_ATTACHMENT_FRONT_LEFT &&
+          osbuffer->render_direct &&
+          screen->resource_from_user_memory) {
+         out[i] = screen->resource_from_user_memory(screen, &templat,
+                                                    osbuffer->map);
+         osbuffer->direct = out[i] != NULL;
+      }
+
+      if (!out[i])
+         out[i] = screen->resource_create(screen, &templat);
+
+      osbuffer->textures[i] = out[i];
    }
 
    return TRUE;
@@ -441,24 +490,51 @@ osmesa_create_buffer(enum pipe_format color_format,
 
 
 /**
- * Search linked list for a buffer with matching pixel formats.
+ * Search linked list for a buffer with matching pixel formats that the
+ * given context may use, preferring the one it was last bound to.
+ * The caller must hold osmesa_mutex.
  */
 static struct osmesa_buffer *
-osmesa_find_buffer(enum pipe_format color_format,
+osmesa_find_buffer(struct osmesa_context *osmesa,
+                   enum pipe_format color_format,
                    enum pipe_format ds_format,
                    enum pipe_format accum_format)
 {
-   struct osmesa_buffer *b;
+   struct osmesa_buffer *b, *unbound = NULL;
 
    /* Check if we already have a suitable buffer for the given formats */
    for (b = BufferList; b; b = b->next) {
       if (b->visual.color_format == color_format &&
           b->visual.depth_stencil_format == ds_format &&
           b->visual.accum_format == accum_format) {
-         return b;
+         if (b->context == osmesa)
+            return b;
+         if (!b->context && !unbound)
+            unbound = b;
       }
    }
-   return NULL;
+   return unbound;
+}
+
+
+/**
+ * Check whether the user's buffer, as currently described by the context's
+ * pixel store state, can back the color buffer directly.  Invalidate the
+ * framebuffer if that changed so that it is validated again.
+ */
+static void
+osmesa_update_render_direct(OSMesaContext osmesa,
+                            struct osmesa_buffer *osbuffer)
+{
+   GLboolean render_direct =
+      !osmesa->y_up &&
+      (osmesa->user_row_length == 0 ||
+       osmesa->user_row_length == (GLint) osbuffer->width);
+
+   if (render_direct != osbuffer->render_direct) {
+      osbuffer->render_direct = render_direct;
+      p_atomic_inc(&osbuffer->stfb->stamp);
+   }
 }
 
 
@@ -575,7 +651,18 @@ GLAPI void GLAPIENTRY
 OSMesaDestroyContext(OSMesaContext osmesa)
 {
    if (osmesa) {
+      struct osmesa_buffer *b;
+
       osmesa->stctx->destroy(osmesa->stctx);
+
+      /* let other contexts reuse the buffers this one was bound to */
+      pipe_mutex_lock(osmesa_mutex);
+      for (b = BufferList; b; b = b->next) {
+         if (b->context == osmesa)
+            b->context = NULL;
+      }
+      pipe_mutex_unlock(osmesa_mutex);
+
       FREE(osmesa);
    }
 }
@@ -625,7 +712,8 @@ OSMesaMakeCurrent(OSMesaContext osmesa, void *buffer, GLenum type,
    }
 
    /* See if we already have a buffer that uses these pixel formats */
-   osbuffer = osmesa_find_buffer(color_format,
+   pipe_mutex_lock(osmesa_mutex);
+   osbuffer = osmesa_find_buffer(osmesa, color_format,
                                  osmesa->depth_stencil_format,
                                  osmesa->accum_format);
    if (!osbuffer) {
@@ -634,11 +722,23 @@ OSMesaMakeCurrent(OSMesaContext osmesa, void *buffer, GLenum type,
                                       osmesa->depth_stencil_format,
                                       osmesa->accum_format);
    }
+   if (osbuffer)
+      osbuffer->context = osmesa;
+   pipe_mutex_unlock(osmesa_mutex);
+
+   if (!osbuffer)
+      return GL_FALSE;
+
+   /* A color buffer rendering into the old user buffer can't be reused */
+   if (osbuffer->direct && osbuffer->map != buffer)
+      p_atomic_inc(&osbuffer->stfb->stamp);
 
    osbuffer->width = width;
    osbuffer->height = height;
    osbuffer->map = buffer;
 
+   osmesa_update_render_direct(osmesa, osbuffer);
+
    /* XXX unused for now */
    (void) osmesa_destroy_buffer;
 
@@ -678,6 +778,9 @@ OSMesaPixelStore(GLint pname, GLint value)
       fprintf(stderr, "Invalid pname in OSMesaPixelStore()\n");
       return;
    }
+
+   if (osmesa->current_buffer)
+      osmesa_update_render_direct(osmesa, osmesa->current_buffer);
 }
 
 
@@ -71,6 +71,10 @@ struct path {
       VGfloat miter_limit;
       VGCapStyle cap_style;
       VGJoinStyle join_style;
+      VGint dash_pattern_num;
+      VGfloat dash_pattern[VEGA_MAX_DASH_COUNT];
+      VGfloat dash_phase;
+      VGboolean dash_phase_reset;
    } stroked;
 };
 
@@ -1227,6 +1231,30 @@ void path_clear(struct path *p, VGbitfield capabilities)
    p->dirty_stroke = VG_TRUE;
 }
 
+/* Whether the cached stroke was made with the current stroke parameters */
+static VGboolean stroke_params_match(struct path *p,
+                                     struct vg_state *vg_state)
+{
+   VGint i;
+
+   if (!floatsEqual(p->stroked.stroke_width, vg_state->stroke.line_width.f) ||
+       !floatsEqual(p->stroked.miter_limit, vg_state->stroke.miter_limit.f) ||
+       p->stroked.cap_style != vg_state->stroke.cap_style ||
+       p->stroked.join_style != vg_state->stroke.join_style ||
+       p->stroked.dash_pattern_num != vg_state->stroke.dash_pattern_num)
+      return VG_FALSE;
+
+   if (!p->stroked.dash_pattern_num)
+      return VG_TRUE;
+
+   for (i = 0; i < p->stroked.dash_pattern_num; ++i) {
+      if (p->stroked.dash_pattern[i] != vg_state->stroke.dash_pattern[i].f)
+         return VG_FALSE;
+   }
+   return p->stroked.dash_phase == vg_state->stroke.dash_phase.f &&
+          p->stroked.dash_phase_reset == vg_state->stroke.dash_phase_reset;
+}
+
 struct path * path_create_stroke(struct path *p,
                                  struct matrix *matrix)
 {
@@ -1241,17 +1269,11 @@ struct path * path_create_stroke(struct path *p,
 
    if (p->stroked.path)
    {
-      /* ### compare the dash patterns to see if we can cache them.
-       *     for now we simply always bail out if the path is dashed.
-       */
       if (memcmp( &p->stroked.matrix,
                   matrix,
                   sizeof *matrix ) == 0 &&
-          !dashed && !p->dirty_stroke &&
-          floatsEqual(p->stroked.stroke_width, vg_state->stroke.line_width.f) &&
-          floatsEqual(p->stroked.miter_limit, vg_state->stroke.miter_limit.f) &&
-          p->stroked.cap_style == vg_state->stroke.cap_style &&
-          p->stroked.join_style == vg_state->stroke.join_style)
+          !p->dirty_stroke &&
+          stroke_params_match(p, vg_state))
       {
          return p->stroked.path;
       }
@@ -1542,6 +1564,11 @@ struct path * path_create_stroke(struct path *p,
    p->stroked.miter_limit = vg_state->stroke.miter_limit.f;
    p->stroked.cap_style = vg_state->stroke.cap_style;
    p->stroked.join_style = vg_state->stroke.join_style;
+   p->stroked.dash_pattern_num = vg_state->stroke.dash_pattern_num;
+   for (i = 0; i < vg_state->stroke.dash_pattern_num; ++i)
+      p->stroked.dash_pattern[i] = vg_state->stroke.dash_pattern[i].f;
+   p->stroked.dash_phase = vg_state->stroke.dash_phase.f;
+   p->stroked.dash_phase_reset = vg_state->stroke.dash_phase_reset;
 
    return stroker.base.path;
 }
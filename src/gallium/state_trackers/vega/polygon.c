@@ -57,8 +57,8 @@ struct polygon
    VGint    num_verts;
 
    VGboolean dirty;
-   void *user_vbuf;
-   struct pipe_screen *screen;
+   /* the vertices, uploaded once and reused until they change */
+   struct pipe_resource *vbuf;
 };
 
 static float *ptr_to_vertex(float *data, int idx)
@@ -89,7 +89,7 @@ struct polygon * polygon_create(int size)
    poly->size = size;
    poly->num_verts = 0;
    poly->dirty = VG_TRUE;
-   poly->user_vbuf = NULL;
+   poly->vbuf = NULL;
 
    return poly;
 }
@@ -101,13 +101,13 @@ struct polygon * polygon_create_from_data(float *data, int size)
    memcpy(poly->data, data, sizeof(float) * COMPONENTS * size);
    poly->num_verts = size;
    poly->dirty = VG_TRUE;
-   poly->user_vbuf = NULL;
 
    return poly;
 }
 
 void polygon_destroy(struct polygon *poly)
 {
+   pipe_resource_reference(&poly->vbuf, NULL);
    free(poly->data);
    free(poly);
 }
@@ -229,6 +229,7 @@ void polygon_append_polygon(struct polygon *dst,
    memcpy(ptr_to_vertex(dst->data, dst->num_verts),
           src->data, src->num_verts * COMPONENTS * sizeof(VGfloat));
    dst->num_verts += src->num_verts;
+   dst->dirty = VG_TRUE;
 }
 
 VGboolean polygon_is_closed(struct polygon *p)
@@ -242,19 +243,38 @@ VGboolean polygon_is_closed(struct polygon *p)
 }
 
 static void polygon_prepare_buffer(struct vg_context *ctx,
-                                   struct polygon *poly)
+                                   struct polygon *poly,
+                                   struct pipe_vertex_buffer *vbuffer)
 {
    struct pipe_context *pipe;
+   unsigned size = poly->num_verts * COMPONENTS * sizeof(float);
 
    /*polygon_print(poly);*/
 
    pipe = ctx->pipe;
 
-   if (poly->user_vbuf == NULL || poly->dirty) {
-      poly->screen = pipe->screen;
-      poly->user_vbuf = poly->data;
+   if (poly->dirty ||
+       (poly->vbuf && poly->vbuf->screen != pipe->screen)) {
+      pipe_resource_reference(&poly->vbuf, NULL);
+      if (size) {
+         poly->vbuf = pipe_buffer_create(pipe->screen,
+                                         PIPE_BIND_VERTEX_BUFFER,
+                                         PIPE_USAGE_IMMUTABLE, size);
+         if (poly->vbuf)
+            pipe_buffer_write(pipe, poly->vbuf, 0, size, poly->data);
+      }
       poly->dirty = VG_FALSE;
    }
+
+   /* fall back to user memory if the buffer couldn't be created */
+   if (poly->vbuf) {
+      vbuffer->buffer = poly->vbuf;
+      vbuffer->user_buffer = NULL;
+   }
+   else {
+      vbuffer->buffer = NULL;
+      vbuffer->user_buffer = poly->data;
+   }
 }
 
 void polygon_fill(struct polygon *poly, struct vg_context *ctx)
@@ -276,8 +296,6 @@ void polygon_fill(struct polygon *poly, struct vg_context *ctx)
                 min_x, min_y, max_x, max_y);
 #endif
 
-   polygon_prepare_buffer(ctx, poly);
-
    /* tell renderer about the vertex attributes */
    memset(&velement, 0, sizeof(velement));
    velement.src_offset = 0;
@@ -287,8 +305,8 @@ void polygon_fill(struct polygon *poly, struct vg_context *ctx)
 
    /* tell renderer about the vertex buffer */
    memset(&vbuffer, 0, sizeof(vbuffer));
-   vbuffer.user_buffer = poly->user_vbuf;
    vbuffer.stride = COMPONENTS * sizeof(float);  /* vertex size */
+   polygon_prepare_buffer(ctx, poly, &vbuffer);
 
    renderer_polygon_stencil_begin(ctx->renderer,
          &velement, ctx->state.vg.fill_rule, VG_FALSE);
@@ -336,8 +354,7 @@ void polygon_array_fill(struct polygon_array *polyarray, struct vg_context *ctx)
    for (i = 0; i < polys->num_elements; ++i) {
       struct polygon *poly = (((struct polygon**)polys->data)[i]);
 
-      polygon_prepare_buffer(ctx, poly);
-      vbuffer.user_buffer = poly->user_vbuf;
+      polygon_prepare_buffer(ctx, poly, &vbuffer);
 
       renderer_polygon_stencil(ctx->renderer, &vbuffer,
             PIPE_PRIM_TRIANGLE_FAN, 0, (VGuint) poly->num_verts);
@@ -387,9 +387,7 @@ bind_samplers(struct xa_context *ctx,
 {
     struct pipe_sampler_state *samplers[PIPE_MAX_SAMPLERS];
     struct pipe_sampler_state src_sampler, mask_sampler;
-    struct pipe_sampler_view view_templ;
-    struct pipe_sampler_view *src_view;
-    struct pipe_context *pipe = ctx->pipe;
+    struct pipe_sampler_view *mask_view;
     struct xa_picture *src_pic = comp->src;
     struct xa_picture *mask_pic = comp->mask;
 
@@ -416,13 +414,7 @@ bind_samplers(struct xa_context *ctx,
 	    src_sampler.normalized_coords = 1;
 	    samplers[0] = &src_sampler;
 	    ctx->num_bound_samplers = 1;
-	    u_sampler_view_default_template(&view_templ,
-					    src_pic->srf->tex,
-					    src_pic->srf->tex->format);
-	    src_view = pipe->create_sampler_view(pipe, src_pic->srf->tex,
-						 &view_templ);
-	    pipe_sampler_view_reference(&ctx->bound_sampler_views[0], NULL);
-	    ctx->bound_sampler_views[0] = src_view;
+	    xa_ctx_sampler_view(ctx, 0, src_pic->srf->tex);
 	}
     }
 
@@ -440,13 +432,7 @@ bind_samplers(struct xa_context *ctx,
 	mask_sampler.normalized_coords = 1;
 	samplers[1] = &mask_sampler;
 	ctx->num_bound_samplers = 2;
-	u_sampler_view_default_template(&view_templ,
-					mask_pic->srf->tex,
-					mask_pic->srf->tex->format);
-	src_view = pipe->create_sampler_view(pipe, mask_pic->srf->tex,
-					     &view_templ);
-	pipe_sampler_view_reference(&ctx->bound_sampler_views[1], NULL);
-	ctx->bound_sampler_views[1] = src_view;
+	mask_view = xa_ctx_sampler_view(ctx, 1, mask_pic->srf->tex);
 
 
 	/*
@@ -455,7 +441,7 @@ bind_samplers(struct xa_context *ctx,
 	 */
 	if (ctx->bound_sampler_views[0] == NULL)
 	    pipe_sampler_view_reference(&ctx->bound_sampler_views[0],
-					src_view);
+					mask_view);
 
     }
 
@@ -531,7 +517,8 @@ xa_composite_done(struct xa_context *ctx)
 
     ctx->comp = NULL;
     ctx->has_solid_color = FALSE;
-    xa_ctx_sampler_views_destroy(ctx);
+    /* the sampler views are kept for the next composite */
+    ctx->num_bound_samplers = 0;
 }
 
 static const struct xa_composite_allocation a = {
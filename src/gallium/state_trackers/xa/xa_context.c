@@ -31,6 +31,7 @@
 #include "cso_cache/cso_context.h"
 #include "util/u_inlines.h"
 #include "util/u_rect.h"
+#include "util/u_sampler.h"
 #include "util/u_surface.h"
 #include "pipe/p_context.h"
 
@@ -385,12 +386,34 @@ xa_fence_destroy(struct xa_fence *fence)
     free(fence);
 }
 
+/*
+ * Return a sampler view of tex for the given unit. The views are kept
+ * across operations, so a picture used by consecutive composites or
+ * video frames doesn't get a new view every time.
+ */
+struct pipe_sampler_view *
+xa_ctx_sampler_view(struct xa_context *ctx, unsigned int unit,
+		    struct pipe_resource *tex)
+{
+    struct pipe_sampler_view **view = &ctx->bound_sampler_views[unit];
+    struct pipe_sampler_view view_templ;
+
+    if (*view && (*view)->texture == tex && (*view)->format == tex->format)
+	return *view;
+
+    pipe_sampler_view_reference(view, NULL);
+    u_sampler_view_default_template(&view_templ, tex, tex->format);
+    *view = ctx->pipe->create_sampler_view(ctx->pipe, tex, &view_templ);
+
+    return *view;
+}
+
 void
 xa_ctx_sampler_views_destroy(struct xa_context *ctx)
 {
     int i;
 
-    for (i = 0; i < ctx->num_bound_samplers; ++i)
+    for (i = 0; i < XA_MAX_SAMPLERS; ++i)
 	pipe_sampler_view_reference(&ctx->bound_sampler_views[i], NULL);
     ctx->num_bound_samplers = 0;
 }
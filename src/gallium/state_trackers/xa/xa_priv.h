@@ -44,7 +44,7 @@
 #define XA_EXPORT
 #endif
 
-#define XA_VB_SIZE (100 * 4 * 3 * 4)
+#define XA_VB_SIZE (512 * 4 * 3 * 4)
 #define XA_LAST_SURFACE_TYPE (xa_type_yuv_component + 1)
 #define XA_MAX_SAMPLERS 3
 
@@ -211,6 +211,10 @@ xa_ctx_srf_create(struct xa_context *ctx, struct xa_surface *dst);
 extern void
 xa_ctx_srf_destroy(struct xa_context *ctx);
 
+extern struct pipe_sampler_view *
+xa_ctx_sampler_view(struct xa_context *ctx, unsigned int unit,
+		    struct pipe_resource *tex);
+
 extern void
 xa_ctx_sampler_views_destroy(struct xa_context *ctx);
 
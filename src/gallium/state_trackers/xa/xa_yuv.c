@@ -30,7 +30,6 @@
 #include "xa_context.h"
 #include "xa_priv.h"
 #include "util/u_inlines.h"
-#include "util/u_sampler.h"
 #include "util/u_surface.h"
 #include "cso_cache/cso_context.h"
 
@@ -71,7 +70,6 @@ xa_yuv_bind_samplers(struct xa_context *r, struct xa_surface *yuv[])
 {
     struct pipe_sampler_state *samplers[3];
     struct pipe_sampler_state sampler;
-    struct pipe_sampler_view view_templ;
     unsigned int i;
 
     memset(&sampler, 0, sizeof(struct pipe_sampler_state));
@@ -85,11 +83,7 @@ xa_yuv_bind_samplers(struct xa_context *r, struct xa_surface *yuv[])
 
     for (i = 0; i < 3; ++i) {
 	samplers[i] = &sampler;
-	u_sampler_view_default_template(&view_templ, yuv[i]->tex,
-					yuv[i]->tex->format);
-
-	r->bound_sampler_views[i] =
-	    r->pipe->create_sampler_view(r->pipe, yuv[i]->tex, &view_templ);
+	xa_ctx_sampler_view(r, i, yuv[i]->tex);
     }
     r->num_bound_samplers = 3;
     cso_set_samplers(r->cso, PIPE_SHADER_FRAGMENT, 3, (const struct pipe_sampler_state **)samplers);
@@ -155,7 +149,8 @@ xa_yuv_planar_blit(struct xa_context *r,
 
     r->pipe->flush(r->pipe, &r->last_fence, 0);
 
-    xa_ctx_sampler_views_destroy(r);
+    /* the sampler views are kept for the next frame */
+    r->num_bound_samplers = 0;
     xa_ctx_srf_destroy(r);
 
     return XA_ERR_NONE;
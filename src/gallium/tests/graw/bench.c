@@ -0,0 +1,437 @@
+/* Microbenchmarks for common driver hot paths.
+ *
+ * Each test runs a fixed amount of work, waits for the GPU to finish and
+ * prints one line of comma-separated output:
+ *
+ *    driver,test,value,unit
+ *
+ * so that results from different drivers and releases can be collected and
+ * compared by scripts.  Use "-n <scale>" to scale the amount of work.
+ */
+
+#include <stdio.h>
+#include "graw_util.h"
+#include "os/os_time.h"
+
+static struct graw_info info;
+
+static const int WIDTH = 512;
+static const int HEIGHT = 512;
+
+#define GRID 64                  /* tiny triangles per row/column */
+#define TEX_SIZE 1024
+
+static unsigned scale = 1;
+
+
+struct vertex {
+   float position[4];
+   float color[4];
+};
+
+/* 0..5: full screen quad, 6..8: small triangle, 9..: triangle grid */
+#define QUAD_START 0
+#define TRI_START 6
+#define GRID_START 9
+#define NUM_VERTICES (GRID_START + GRID * GRID * 3)
+
+static struct pipe_resource *vbuf;
+static void *fs[2], *blend[2];
+
+
+static void set_vertex(struct vertex *v, float x, float y)
+{
+   v->position[0] = x;
+   v->position[1] = y;
+   v->position[2] = 0.0f;
+   v->position[3] = 1.0f;
+   v->color[0] = 1.0f;
+   v->color[1] = 0.5f;
+   v->color[2] = 0.0f;
+   v->color[3] = 1.0f;
+}
+
+
+static void set_vertices( void )
+{
+   struct pipe_vertex_element ve[2];
+   struct pipe_vertex_buffer vb;
+   struct vertex *verts;
+   void *handle;
+   int i, j;
+
+   verts = MALLOC(NUM_VERTICES * sizeof(*verts));
+   if (!verts)
+      exit(1);
+
+   set_vertex(&verts[QUAD_START + 0], -1.0f, -1.0f);
+   set_vertex(&verts[QUAD_START + 1],  1.0f, -1.0f);
+   set_vertex(&verts[QUAD_START + 2],  1.0f,  1.0f);
+   set_vertex(&verts[QUAD_START + 3], -1.0f, -1.0f);
+   set_vertex(&verts[QUAD_START + 4],  1.0f,  1.0f);
+   set_vertex(&verts[QUAD_START + 5], -1.0f,  1.0f);
+
+   set_vertex(&verts[TRI_START + 0],  0.00f, -0.05f);
+   set_vertex(&verts[TRI_START + 1], -0.05f,  0.05f);
+   set_vertex(&verts[TRI_START + 2],  0.05f,  0.05f);
+
+   for (i = 0; i < GRID; i++) {
+      for (j = 0; j < GRID; j++) {
+         struct vertex *v = &verts[GRID_START + (i * GRID + j) * 3];
+         float x = -1.0f + 2.0f * j / GRID;
+         float y = -1.0f + 2.0f * i / GRID;
+         float d = 1.0f / GRID;
+
+         set_vertex(&v[0], x, y);
+         set_vertex(&v[1], x + d, y);
+         set_vertex(&v[2], x, y + d);
+      }
+   }
+
+   memset(ve, 0, sizeof ve);
+
+   ve[0].src_offset = Offset(struct vertex, position);
+   ve[0].src_format = PIPE_FORMAT_R32G32B32A32_FLOAT;
+   ve[1].src_offset = Offset(struct vertex, color);
+   ve[1].src_format = PIPE_FORMAT_R32G32B32A32_FLOAT;
+
+   handle = info.ctx->create_vertex_elements_state(info.ctx, 2, ve);
+   info.ctx->bind_vertex_elements_state(info.ctx, handle);
+
+   vbuf = pipe_buffer_create_with_data(info.ctx,
+                                       PIPE_BIND_VERTEX_BUFFER,
+                                       PIPE_USAGE_STATIC,
+                                       NUM_VERTICES * sizeof(*verts),
+                                       verts);
+   FREE(verts);
+
+   memset(&vb, 0, sizeof vb);
+   vb.stride = sizeof(struct vertex);
+   vb.buffer_offset = 0;
+   vb.buffer = vbuf;
+
+   info.ctx->set_vertex_buffers(info.ctx, 0, 1, &vb);
+}
+
+
+static const char *vs_text =
+   "VERT\n"
+   "DCL IN[0]\n"
+   "DCL IN[1]\n"
+   "DCL OUT[0], POSITION\n"
+   "DCL OUT[1], COLOR\n"
+   "  0: MOV OUT[1], IN[1]\n"
+   "  1: MOV OUT[0], IN[0]\n"
+   "  2: END\n";
+
+static const char *fs_text[2] = {
+   "FRAG\n"
+   "DCL IN[0], COLOR, LINEAR\n"
+   "DCL OUT[0], COLOR\n"
+   "  0: MOV OUT[0], IN[0]\n"
+   "  1: END\n",
+
+   "FRAG\n"
+   "DCL IN[0], COLOR, LINEAR\n"
+   "DCL OUT[0], COLOR\n"
+   "  0: MOV OUT[0], IN[0].zyxw\n"
+   "  1: END\n"
+};
+
+
+static void set_state( void )
+{
+   struct pipe_blend_state b;
+   int i;
+
+   info.ctx->bind_vs_state(info.ctx,
+                           graw_parse_vertex_shader(info.ctx, vs_text));
+
+   for (i = 0; i < 2; i++)
+      fs[i] = graw_parse_fragment_shader(info.ctx, fs_text[i]);
+   info.ctx->bind_fs_state(info.ctx, fs[0]);
+
+   memset(&b, 0, sizeof b);
+   b.rt[0].colormask = PIPE_MASK_RGBA;
+   blend[0] = info.ctx->create_blend_state(info.ctx, &b);
+
+   b.rt[0].blend_enable = 1;
+   b.rt[0].rgb_func = b.rt[0].alpha_func = PIPE_BLEND_ADD;
+   b.rt[0].rgb_src_factor = b.rt[0].alpha_src_factor = PIPE_BLENDFACTOR_ONE;
+   b.rt[0].rgb_dst_factor = b.rt[0].alpha_dst_factor = PIPE_BLENDFACTOR_ONE;
+   blend[1] = info.ctx->create_blend_state(info.ctx, &b);
+
+   info.ctx->bind_blend_state(info.ctx, blend[0]);
+}
+
+
+/** Flush and wait until the driver is idle. */
+static void finish( void )
+{
+   struct pipe_fence_handle *fence = NULL;
+
+   info.ctx->flush(info.ctx, &fence, 0);
+   if (fence) {
+      info.screen->fence_finish(info.screen, fence, PIPE_TIMEOUT_INFINITE);
+      info.screen->fence_reference(info.screen, &fence, NULL);
+   }
+}
+
+
+static void report(const char *test, double value, const char *unit)
+{
+   printf("%s,%s,%.3f,%s\n", info.screen->get_name(info.screen),
+          test, value, unit);
+   fflush(stdout);
+}
+
+
+static double seconds_since(int64_t start)
+{
+   return (os_time_get_nano() - start) / 1e9;
+}
+
+
+static void bench_draws(boolean state_changes)
+{
+   unsigned n = 20000 * scale, i;
+   int64_t start;
+
+   finish();
+   start = os_time_get_nano();
+
+   for (i = 0; i < n; i++) {
+      if (state_changes) {
+         info.ctx->bind_fs_state(info.ctx, fs[i & 1]);
+         info.ctx->bind_blend_state(info.ctx, blend[i & 1]);
+      }
+      util_draw_arrays(info.ctx, PIPE_PRIM_TRIANGLES, TRI_START, 3);
+   }
+   finish();
+
+   report(state_changes ? "draws_state_change" : "draws",
+          n / seconds_since(start), "draws/s");
+
+   info.ctx->bind_fs_state(info.ctx, fs[0]);
+   info.ctx->bind_blend_state(info.ctx, blend[0]);
+}
+
+
+static void bench_triangles( void )
+{
+   unsigned n = 200 * scale, i;
+   int64_t start;
+
+   finish();
+   start = os_time_get_nano();
+
+   for (i = 0; i < n; i++)
+      util_draw_arrays(info.ctx, PIPE_PRIM_TRIANGLES, GRID_START,
+                       GRID * GRID * 3);
+   finish();
+
+   report("triangles", (double) n * GRID * GRID / seconds_since(start) / 1e6,
+          "Mtris/s");
+}
+
+
+static void bench_fill( void )
+{
+   unsigned n = 200 * scale, i;
+   int64_t start;
+
+   finish();
+   start = os_time_get_nano();
+
+   for (i = 0; i < n; i++)
+      util_draw_arrays(info.ctx, PIPE_PRIM_TRIANGLES, QUAD_START, 6);
+   finish();
+
+   report("fill", (double) n * WIDTH * HEIGHT / seconds_since(start) / 1e6,
+          "Mpixels/s");
+}
+
+
+static void bench_texture_upload( void )
+{
+   const unsigned stride = TEX_SIZE * 4;
+   unsigned n = 50 * scale, i;
+   struct pipe_resource *tex;
+   struct pipe_box box;
+   void *data;
+   int64_t start;
+
+   data = CALLOC(TEX_SIZE * TEX_SIZE, 4);
+   if (!data)
+      return;
+
+   tex = graw_util_create_tex2d(&info, TEX_SIZE, TEX_SIZE,
+                                PIPE_FORMAT_B8G8R8A8_UNORM, data);
+   if (!tex) {
+      FREE(data);
+      return;
+   }
+
+   u_box_2d(0, 0, TEX_SIZE, TEX_SIZE, &box);
+
+   finish();
+   start = os_time_get_nano();
+
+   for (i = 0; i < n; i++)
+      info.ctx->transfer_inline_write(info.ctx, tex, 0, PIPE_TRANSFER_WRITE,
+                                      &box, data, stride,
+                                      stride * TEX_SIZE);
+   finish();
+
+   report("texture_upload",
+          (double) n * stride * TEX_SIZE / seconds_since(start) / (1 << 20),
+          "MB/s");
+
+   pipe_resource_reference(&tex, NULL);
+   FREE(data);
+}
+
+
+static void bench_readback( void )
+{
+   const unsigned row = WIDTH *
+      util_format_get_blocksize(info.color_buf[0]->format);
+   const unsigned size = row * HEIGHT;
+   unsigned n = 50 * scale, i;
+   int y;
+   struct pipe_transfer *transfer;
+   void *data, *map;
+   int64_t start;
+
+   data = MALLOC(size);
+   if (!data)
+      return;
+
+   finish();
+   start = os_time_get_nano();
+
+   for (i = 0; i < n; i++) {
+      /* Dirty the buffer so each readback has to wait for rendering */
+      util_draw_arrays(info.ctx, PIPE_PRIM_TRIANGLES, TRI_START, 3);
+
+      map = pipe_transfer_map(info.ctx, info.color_buf[0], 0, 0,
+                              PIPE_TRANSFER_READ, 0, 0, WIDTH, HEIGHT,
+                              &transfer);
+      if (!map)
+         break;
+      for (y = 0; y < HEIGHT; y++)
+         memcpy((ubyte *) data + y * row, (ubyte *) map + y * transfer->stride,
+                row);
+      info.ctx->transfer_unmap(info.ctx, transfer);
+   }
+
+   report("readback", (double) i * size / seconds_since(start) / (1 << 20),
+          "MB/s");
+
+   FREE(data);
+}
+
+
+static void bench_shader_create( void )
+{
+   unsigned n = 500 * scale, i;
+   int64_t start;
+   void *handle;
+
+   start = os_time_get_nano();
+
+   for (i = 0; i < n; i++) {
+      handle = graw_parse_fragment_shader(info.ctx, fs_text[i & 1]);
+      info.ctx->delete_fs_state(info.ctx, handle);
+   }
+
+   report("shader_create", seconds_since(start) / n * 1e6, "us");
+}
+
+
+static void bench_buffer_map( void )
+{
+   unsigned n = 20000 * scale, i;
+   struct pipe_resource *buf;
+   struct pipe_transfer *transfer;
+   int64_t start;
+   void *map;
+
+   buf = pipe_buffer_create(info.screen, PIPE_BIND_VERTEX_BUFFER,
+                            PIPE_USAGE_STREAM, 64 * 1024);
+   if (!buf)
+      return;
+
+   finish();
+   start = os_time_get_nano();
+
+   for (i = 0; i < n; i++) {
+      map = pipe_buffer_map(info.ctx, buf,
+                            PIPE_TRANSFER_WRITE |
+                            PIPE_TRANSFER_DISCARD_WHOLE_RESOURCE,
+                            &transfer);
+      if (!map)
+         break;
+      memset(map, 0, 64);
+      pipe_buffer_unmap(info.ctx, transfer);
+   }
+   finish();
+
+   report("buffer_map", i / seconds_since(start), "maps/s");
+
+   pipe_resource_reference(&buf, NULL);
+}
+
+
+static void init( void )
+{
+   if (!graw_util_create_window(&info, WIDTH, HEIGHT, 1, FALSE))
+      exit(1);
+
+   graw_util_default_state(&info, FALSE);
+   graw_util_viewport(&info, 0, 0, WIDTH, HEIGHT, 30, 1000);
+
+   set_vertices();
+   set_state();
+}
+
+
+static void args(int argc, char *argv[])
+{
+   int i;
+
+   for (i = 1; i < argc; ) {
+      if (graw_parse_args(&i, argc, argv)) {
+         /* ok */
+      }
+      else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+         scale = MAX2(atoi(argv[i + 1]), 1);
+         i += 2;
+      }
+      else {
+         printf("Invalid arg %s\n", argv[i]);
+         exit(1);
+      }
+   }
+}
+
+
+int main( int argc, char *argv[] )
+{
+   args(argc, argv);
+   init();
+
+   printf("driver,test,value,unit\n");
+
+   bench_draws(FALSE);
+   bench_draws(TRUE);
+   bench_triangles();
+   bench_fill();
+   bench_texture_upload();
+   bench_readback();
+   bench_shader_create();
+   bench_buffer_map();
+
+   pipe_resource_reference(&vbuf, NULL);
+   return 0;
+}
@@ -0,0 +1,363 @@
+/**************************************************************************
+ *
+ * Copyright 2013 The Mesa Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/*
+ * Throughput of the format conversion kernels that u_format_test and
+ * translate_test check for correctness:
+ *
+ *  - util_format pack/unpack, float and 8unorm, for every format
+ *  - translate, generic and SSE, for every vertex format to and from
+ *    R32G32B32A32_FLOAT
+ *  - u_indices translators for every primitive and index size
+ *
+ * Each kernel runs for about BENCH_TIME_NS; one comma-separated line
+ * "suite,kernel,op,MB/s" is printed per kernel, the MB being those of
+ * the packed (format or index) side.  Usage:
+ *
+ *    conversion_bench [format|translate|indices]
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "os/os_time.h"
+#include "util/u_cpu_detect.h"
+#include "util/u_format.h"
+#include "util/u_format_s3tc.h"
+#include "util/u_memory.h"
+#include "util/u_prim.h"
+#include "util/u_string.h"
+#include "translate/translate.h"
+#include "indices/u_indices.h"
+#include "pipe/p_defines.h"
+
+
+#define BENCH_TIME_NS   (50 * 1000 * 1000)
+#define BUFFER_SIZE     (1024 * 1024)
+
+#define WIDTH  256
+#define HEIGHT 64
+
+#define NUM_VERTICES 4096
+#define NUM_INDICES  (64 * 1024)
+
+static uint8_t *src_buffer, *dst_buffer;
+
+
+/** Run func(data) until BENCH_TIME_NS have passed, return runs per second */
+static double
+bench_rate(void (*func)(void *), void *data)
+{
+   int64_t start = os_time_get_nano();
+   int64_t elapsed;
+   unsigned runs = 0;
+
+   do {
+      func(data);
+      runs++;
+      elapsed = os_time_get_nano() - start;
+   } while (elapsed < BENCH_TIME_NS);
+
+   return runs * 1e9 / elapsed;
+}
+
+
+static void
+report(const char *suite, const char *kernel, const char *op,
+       double runs_per_sec, unsigned bytes_per_run)
+{
+   printf("%s,%s,%s,%.1f\n", suite, kernel, op,
+          runs_per_sec * bytes_per_run / (1024 * 1024));
+}
+
+
+/*
+ * util_format
+ */
+
+struct format_run {
+   const struct util_format_description *desc;
+   unsigned stride;
+};
+
+static void
+unpack_float(void *data)
+{
+   const struct format_run *run = data;
+   run->desc->unpack_rgba_float((float *) dst_buffer, WIDTH * 4 * sizeof(float),
+                                src_buffer, run->stride, WIDTH, HEIGHT);
+}
+
+static void
+pack_float(void *data)
+{
+   const struct format_run *run = data;
+   run->desc->pack_rgba_float(dst_buffer, run->stride,
+                              (const float *) src_buffer,
+                              WIDTH * 4 * sizeof(float), WIDTH, HEIGHT);
+}
+
+static void
+unpack_8unorm(void *data)
+{
+   const struct format_run *run = data;
+   run->desc->unpack_rgba_8unorm(dst_buffer, WIDTH * 4,
+                                 src_buffer, run->stride, WIDTH, HEIGHT);
+}
+
+static void
+pack_8unorm(void *data)
+{
+   const struct format_run *run = data;
+   run->desc->pack_rgba_8unorm(dst_buffer, run->stride,
+                               src_buffer, WIDTH * 4, WIDTH, HEIGHT);
+}
+
+static void
+bench_formats(void)
+{
+   enum pipe_format format;
+
+   for (format = 1; format < PIPE_FORMAT_COUNT; format++) {
+      struct format_run run;
+      unsigned bytes;
+
+      run.desc = util_format_description(format);
+      if (!run.desc)
+         continue;
+
+      if (run.desc->layout == UTIL_FORMAT_LAYOUT_S3TC &&
+          !util_format_s3tc_enabled)
+         continue;
+
+      if (WIDTH % run.desc->block.width || HEIGHT % run.desc->block.height)
+         continue;
+
+      run.stride = util_format_get_stride(format, WIDTH);
+      bytes = run.stride * util_format_get_nblocksy(format, HEIGHT);
+
+      /* 0x3f bytes are sane values in every float and integer layout */
+      memset(src_buffer, 0x3f, BUFFER_SIZE);
+
+      if (run.desc->unpack_rgba_float)
+         report("format", run.desc->short_name, "unpack_float",
+                bench_rate(unpack_float, &run), bytes);
+      if (run.desc->pack_rgba_float)
+         report("format", run.desc->short_name, "pack_float",
+                bench_rate(pack_float, &run), bytes);
+      if (run.desc->unpack_rgba_8unorm)
+         report("format", run.desc->short_name, "unpack_8unorm",
+                bench_rate(unpack_8unorm, &run), bytes);
+      if (run.desc->pack_rgba_8unorm)
+         report("format", run.desc->short_name, "pack_8unorm",
+                bench_rate(pack_8unorm, &run), bytes);
+   }
+}
+
+
+/*
+ * translate
+ */
+
+static unsigned elts[NUM_VERTICES];
+
+static void
+translate_elts(void *data)
+{
+   struct translate *translate = data;
+   translate->run_elts(translate, elts, NUM_VERTICES, 0, dst_buffer);
+}
+
+static void
+translate_linear(void *data)
+{
+   struct translate *translate = data;
+   translate->run(translate, 0, NUM_VERTICES, 0, dst_buffer);
+}
+
+static void
+bench_translate_key(const char *impl,
+                    struct translate *(*create)(const struct translate_key *),
+                    enum pipe_format input_format,
+                    enum pipe_format output_format,
+                    unsigned format_size, const char *name, const char *dir)
+{
+   struct translate_key key;
+   struct translate *translate;
+   char op[64];
+
+   memset(&key, 0, sizeof(key));
+   key.nr_elements = 1;
+   key.output_stride = util_format_get_blocksize(output_format);
+   key.element[0].type = TRANSLATE_ELEMENT_NORMAL;
+   key.element[0].input_format = input_format;
+   key.element[0].output_format = output_format;
+
+   translate = create(&key);
+   if (!translate)
+      return;
+
+   translate->set_buffer(translate, 0, src_buffer,
+                         util_format_get_blocksize(input_format),
+                         NUM_VERTICES - 1);
+
+   util_snprintf(op, sizeof(op), "%s_%s_linear", dir, impl);
+   report("translate", name, op, bench_rate(translate_linear, translate),
+          NUM_VERTICES * format_size);
+
+   util_snprintf(op, sizeof(op), "%s_%s_elts", dir, impl);
+   report("translate", name, op, bench_rate(translate_elts, translate),
+          NUM_VERTICES * format_size);
+
+   translate->release(translate);
+}
+
+static void
+bench_translate(void)
+{
+   const enum pipe_format float4 = PIPE_FORMAT_R32G32B32A32_FLOAT;
+   enum pipe_format format;
+   unsigned i;
+
+   for (i = 0; i < NUM_VERTICES; i++)
+      elts[i] = (i * 7) % NUM_VERTICES;
+
+   memset(src_buffer, 0x3f, BUFFER_SIZE);
+
+   for (format = 1; format < PIPE_FORMAT_COUNT; format++) {
+      const struct util_format_description *desc =
+         util_format_description(format);
+      unsigned size;
+
+      if (!desc || desc->layout != UTIL_FORMAT_LAYOUT_PLAIN ||
+          desc->colorspace != UTIL_FORMAT_COLORSPACE_RGB ||
+          !translate_is_output_format_supported(format))
+         continue;
+
+      size = util_format_get_blocksize(format);
+
+      bench_translate_key("generic", translate_generic_create,
+                          format, float4, size, desc->short_name, "fetch");
+      bench_translate_key("sse", translate_sse2_create,
+                          format, float4, size, desc->short_name, "fetch");
+      bench_translate_key("generic", translate_generic_create,
+                          float4, format, size, desc->short_name, "emit");
+      bench_translate_key("sse", translate_sse2_create,
+                          float4, format, size, desc->short_name, "emit");
+   }
+}
+
+
+/*
+ * u_indices
+ */
+
+struct index_run {
+   u_translate_func translate;
+   unsigned nr;
+};
+
+static void
+translate_indices(void *data)
+{
+   const struct index_run *run = data;
+   run->translate(src_buffer, run->nr, dst_buffer);
+}
+
+static void
+bench_indices(void)
+{
+   static const char *pv_names[PV_COUNT] = { "first", "last" };
+   unsigned prim, index_size, in_pv, out_pv;
+
+   for (index_size = 1; index_size <= 4; index_size *= 2) {
+      /* Valid indices for any vertex count */
+      memset(src_buffer, 0, BUFFER_SIZE);
+
+      for (prim = PIPE_PRIM_POINTS; prim <= PIPE_PRIM_POLYGON; prim++) {
+         for (in_pv = 0; in_pv < PV_COUNT; in_pv++) {
+            for (out_pv = 0; out_pv < PV_COUNT; out_pv++) {
+               struct index_run run;
+               unsigned out_prim, out_index_size, out_nr;
+               char name[64], op[32];
+
+               /* Hardware with points, lines and triangles only */
+               if (u_index_translator((1 << PIPE_PRIM_POINTS) |
+                                      (1 << PIPE_PRIM_LINES) |
+                                      (1 << PIPE_PRIM_TRIANGLES),
+                                      prim, index_size, NUM_INDICES,
+                                      in_pv, out_pv, &out_prim,
+                                      &out_index_size, &out_nr,
+                                      &run.translate) == U_TRANSLATE_ERROR)
+                  continue;
+
+               run.nr = out_nr;
+
+               util_snprintf(name, sizeof(name), "%s_uint%u",
+                             u_prim_name(prim), index_size * 8);
+               util_snprintf(op, sizeof(op), "pv_%s_to_%s",
+                             pv_names[in_pv], pv_names[out_pv]);
+               report("indices", name, op,
+                      bench_rate(translate_indices, &run),
+                      NUM_INDICES * index_size);
+            }
+         }
+      }
+   }
+}
+
+
+int main(int argc, char **argv)
+{
+   const char *suite = argc > 1 ? argv[1] : NULL;
+
+   if (suite && strcmp(suite, "format") && strcmp(suite, "translate") &&
+       strcmp(suite, "indices")) {
+      printf("Usage: %s [format|translate|indices]\n", argv[0]);
+      return 2;
+   }
+
+   util_cpu_detect();
+   util_format_s3tc_init();
+
+   src_buffer = align_malloc(BUFFER_SIZE, 64);
+   dst_buffer = align_malloc(BUFFER_SIZE, 64);
+   if (!src_buffer || !dst_buffer)
+      return 1;
+
+   printf("suite,kernel,op,MB/s\n");
+
+   if (!suite || !strcmp(suite, "format"))
+      bench_formats();
+   if (!suite || !strcmp(suite, "translate"))
+      bench_translate();
+   if (!suite || !strcmp(suite, "indices"))
+      bench_indices();
+
+   align_free(src_buffer);
+   align_free(dst_buffer);
+
+   return 0;
+}
@@ -0,0 +1,139 @@
+#!/usr/bin/env python
+##########################################################################
+#
+# Copyright 2013 VMware, Inc.
+# All Rights Reserved.
+#
+# Permission is hereby granted, free of charge, to any person obtaining a
+# copy of this software and associated documentation files (the
+# "Software"), to deal in the Software without restriction, including
+# without limitation the rights to use, copy, modify, merge, publish,
+# distribute, sub license, and/or sell copies of the Software, and to
+# permit persons to whom the Software is furnished to do so, subject to
+# the following conditions:
+#
+# The above copyright notice and this permission notice (including the
+# next paragraph) shall be included in all copies or substantial portions
+# of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+# OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+# IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+# ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+# TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+# SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#
+##########################################################################
+
+'''Convert a GALLIUM_TRACE_TIMELINE file to the Chrome trace event format.
+
+The layout of the file is described in src/gallium/drivers/trace/tr_timeline.h.
+Each context or screen the calls were made on gets its own row.
+'''
+
+
+import json
+import optparse
+import struct
+import sys
+
+
+TIMELINE_MAGIC = 0x4c545447
+TIMELINE_VERSION = 1
+
+header_struct = struct.Struct('=II')
+event_struct = struct.Struct('=qqQQII')
+
+# enum trace_timeline_event_type
+event_names = [
+    ('draw_vbo', 'count'),
+    ('clear', 'buffers'),
+    ('blit', 'mask'),
+    ('flush', 'flags'),
+    ('transfer_map', 'usage'),
+    ('fence_finish', 'timeout'),
+    ('create_shader_state', None),
+]
+
+
+def read_events(stream):
+    header = stream.read(header_struct.size)
+    if len(header) != header_struct.size:
+        raise ValueError('truncated header')
+    magic, version = header_struct.unpack(header)
+    if magic != TIMELINE_MAGIC:
+        raise ValueError('not a timeline file (or written on a host of '
+                         'different endianness)')
+    if version != TIMELINE_VERSION:
+        raise ValueError('unsupported timeline version %u' % version)
+
+    while True:
+        data = stream.read(event_struct.size)
+        if len(data) < event_struct.size:
+            break
+        yield event_struct.unpack(data)
+
+
+def convert(stream):
+    objects = {}
+    trace_events = []
+
+    for start, duration, obj, arg, type, padding in read_events(stream):
+        if type < len(event_names):
+            name, arg_name = event_names[type]
+        else:
+            name, arg_name = 'unknown %u' % type, 'arg'
+
+        tid = objects.setdefault(obj, len(objects))
+
+        event = {
+            'name': name,
+            'ph': 'X',
+            'ts': start,
+            'dur': duration,
+            'pid': 0,
+            'tid': tid,
+        }
+        if arg_name is not None:
+            event['args'] = {arg_name: arg}
+        trace_events.append(event)
+
+    for obj, tid in objects.items():
+        trace_events.append({
+            'name': 'thread_name',
+            'ph': 'M',
+            'pid': 0,
+            'tid': tid,
+            'args': {'name': '0x%x' % obj},
+        })
+
+    return {'traceEvents': trace_events}
+
+
+def main():
+    optparser = optparse.OptionParser(
+        usage="\n\t%prog [options] timeline")
+    optparser.add_option(
+        '-o', '--output', metavar='FILE',
+        type="string", dest="output",
+        help="write the JSON to FILE instead of stdout")
+    (options, args) = optparser.parse_args(sys.argv[1:])
+
+    if len(args) != 1:
+        optparser.error('incorrect number of arguments')
+
+    stream = open(args[0], 'rb')
+    result = convert(stream)
+    stream.close()
+
+    if options.output:
+        output = open(options.output, 'wt')
+    else:
+        output = sys.stdout
+    json.dump(result, output)
+    output.write('\n')
+
+
+if __name__ == '__main__':
+    main()
@@ -29,6 +29,7 @@
 
 #include "util/u_hash_table.h"
 #include "util/u_memory.h"
+#include "util/u_math.h"
 #include "util/u_simple_list.h"
 #include "util/u_double_list.h"
 #include "os/os_thread.h"
@@ -103,9 +104,42 @@ static INLINE struct radeon_bo *radeon_bo(struct pb_buffer *bo)
 }
 
 struct radeon_bo_va_hole {
-    struct list_head list;
+    struct radeon_bo_va_hole *left, *right;
     uint64_t         offset;
     uint64_t         size;
+    uint64_t         max_size; /* largest hole in this subtree */
+    int              height;
+};
+
+/* Small buffers are suballocated from slabs of RADEON_SLAB_SIZE bytes, with
+ * one list of slabs per power-of-two entry size between the minimum and
+ * maximum order.  This is only done with virtual memory, where the buffer's
+ * address can include its offset in the slab.
+ */
+#define RADEON_SLAB_MIN_ORDER   8   /* 256 bytes */
+#define RADEON_SLAB_MAX_ORDER   14  /* 16 KB */
+#define RADEON_SLAB_NUM_ORDERS  (RADEON_SLAB_MAX_ORDER - RADEON_SLAB_MIN_ORDER + 1)
+#define RADEON_SLAB_SIZE        (64 * 1024)
+
+struct radeon_bo_slab {
+    struct list_head head;
+
+    /* The GEM object all the entries live in. */
+    struct radeon_bo *real;
+    enum radeon_bo_domain domain;
+    unsigned order;
+
+    struct radeon_bo *entries;
+    unsigned num_entries;
+    /* Number of entries currently owned by someone. */
+    unsigned num_used;
+
+    /* Indices of entries that can be handed out, and of entries that were
+     * destroyed while the GPU may still be using the slab. */
+    unsigned *free;
+    unsigned num_free;
+    unsigned *pending;
+    unsigned num_pending;
 };
 
 struct radeon_bomgr {
@@ -125,7 +159,12 @@ struct radeon_bomgr {
     /* is virtual address supported */
     bool va;
     uint64_t va_offset;
-    struct list_head va_holes;
+    /* Unused ranges below va_offset.  Protected by bo_va_mutex. */
+    struct radeon_bo_va_hole *va_holes;
+
+    /* Slabs for suballocation, by entry size.  Protected by bo_slab_mutex. */
+    pipe_mutex bo_slab_mutex;
+    struct list_head slabs[RADEON_SLAB_NUM_ORDERS];
 };
 
 static INLINE struct radeon_bomgr *radeon_bomgr(struct pb_manager *mgr)
@@ -153,7 +192,7 @@ static struct radeon_bo *get_radeon_bo(struct pb_buffer *_buf)
 
 static void radeon_bo_wait(struct pb_buffer *_buf, enum radeon_bo_usage usage)
 {
-    struct radeon_bo *bo = get_radeon_bo(_buf);
+    struct radeon_bo *bo = radeon_bo_real(get_radeon_bo(_buf));
 
     while (p_atomic_read(&bo->num_active_ioctls)) {
         sched_yield();
@@ -178,7 +217,7 @@ static void radeon_bo_wait(struct pb_buffer *_buf, enum radeon_bo_usage usage)
 static boolean radeon_bo_is_busy(struct pb_buffer *_buf,
                                  enum radeon_bo_usage usage)
 {
-    struct radeon_bo *bo = get_radeon_bo(_buf);
+    struct radeon_bo *bo = radeon_bo_real(get_radeon_bo(_buf));
 
     if (p_atomic_read(&bo->num_active_ioctls)) {
         return TRUE;
@@ -200,62 +239,263 @@ static boolean radeon_bo_is_busy(struct pb_buffer *_buf,
     }
 }
 
-static uint64_t radeon_bomgr_find_va(struct radeon_bomgr *mgr, uint64_t size, uint64_t alignment)
+/*
+ * The holes in the VA space below va_offset are kept in an AVL tree ordered
+ * by offset, where every node also records the size of the largest hole in
+ * its subtree.  That lets allocation skip whole subtrees that can't satisfy
+ * a request, and lets freeing find the neighbouring holes to merge with, in
+ * O(log n) instead of walking a list of every hole.
+ */
+
+static INLINE int va_hole_height(struct radeon_bo_va_hole *hole)
 {
-    struct radeon_bo_va_hole *hole, *n;
-    uint64_t offset = 0, waste = 0;
+    return hole ? hole->height : 0;
+}
 
-    pipe_mutex_lock(mgr->bo_va_mutex);
-    /* first look for a hole */
-    LIST_FOR_EACH_ENTRY_SAFE(hole, n, &mgr->va_holes, list) {
-        offset = hole->offset;
-        waste = 0;
-        if (alignment) {
-            waste = offset % alignment;
-            waste = waste ? alignment - waste : 0;
-        }
-        offset += waste;
-        if (offset >= (hole->offset + hole->size)) {
-            continue;
-        }
-        if (!waste && hole->size == size) {
-            offset = hole->offset;
-            list_del(&hole->list);
-            FREE(hole);
-            pipe_mutex_unlock(mgr->bo_va_mutex);
-            return offset;
-        }
-        if ((hole->size - waste) > size) {
-            if (waste) {
-                n = CALLOC_STRUCT(radeon_bo_va_hole);
-                n->size = waste;
-                n->offset = hole->offset;
-                list_add(&n->list, &hole->list);
-            }
-            hole->size -= (size + waste);
-            hole->offset += size + waste;
-            pipe_mutex_unlock(mgr->bo_va_mutex);
-            return offset;
+static INLINE uint64_t va_hole_max_size(struct radeon_bo_va_hole *hole)
+{
+    return hole ? hole->max_size : 0;
+}
+
+static void va_hole_update(struct radeon_bo_va_hole *hole)
+{
+    hole->height = 1 + MAX2(va_hole_height(hole->left),
+                            va_hole_height(hole->right));
+    hole->max_size = MAX2(hole->size,
+                          MAX2(va_hole_max_size(hole->left),
+                               va_hole_max_size(hole->right)));
+}
+
+static struct radeon_bo_va_hole *
+va_hole_rotate_right(struct radeon_bo_va_hole *hole)
+{
+    struct radeon_bo_va_hole *left = hole->left;
+
+    hole->left = left->right;
+    left->right = hole;
+    va_hole_update(hole);
+    va_hole_update(left);
+    return left;
+}
+
+static struct radeon_bo_va_hole *
+va_hole_rotate_left(struct radeon_bo_va_hole *hole)
+{
+    struct radeon_bo_va_hole *right = hole->right;
+
+    hole->right = right->left;
+    right->left = hole;
+    va_hole_update(hole);
+    va_hole_update(right);
+    return right;
+}
+
+static struct radeon_bo_va_hole *va_hole_balance(struct radeon_bo_va_hole *hole)
+{
+    int balance;
+
+    va_hole_update(hole);
+    balance = va_hole_height(hole->left) - va_hole_height(hole->right);
+
+    if (balance > 1) {
+        if (va_hole_height(hole->left->left) < va_hole_height(hole->left->right))
+            hole->left = va_hole_rotate_left(hole->left);
+        return va_hole_rotate_right(hole);
+    }
+    if (balance < -1) {
+        if (va_hole_height(hole->right->right) < va_hole_height(hole->right->left))
+            hole->right = va_hole_rotate_right(hole->right);
+        return va_hole_rotate_left(hole);
+    }
+    return hole;
+}
+
+static struct radeon_bo_va_hole *
+va_hole_insert(struct radeon_bo_va_hole *root, struct radeon_bo_va_hole *hole)
+{
+    if (!root) {
+        hole->left = hole->right = NULL;
+        va_hole_update(hole);
+        return hole;
+    }
+
+    if (hole->offset < root->offset)
+        root->left = va_hole_insert(root->left, hole);
+    else
+        root->right = va_hole_insert(root->right, hole);
+    return va_hole_balance(root);
+}
+
+static struct radeon_bo_va_hole *
+va_hole_remove_min(struct radeon_bo_va_hole *root,
+                   struct radeon_bo_va_hole **min)
+{
+    if (!root->left) {
+        *min = root;
+        return root->right;
+    }
+    root->left = va_hole_remove_min(root->left, min);
+    return va_hole_balance(root);
+}
+
+/* Unlink the given hole from the tree; the caller owns it afterwards. */
+static struct radeon_bo_va_hole *
+va_hole_remove(struct radeon_bo_va_hole *root, struct radeon_bo_va_hole *hole)
+{
+    if (hole->offset < root->offset) {
+        root->left = va_hole_remove(root->left, hole);
+    } else if (hole->offset > root->offset) {
+        root->right = va_hole_remove(root->right, hole);
+    } else {
+        struct radeon_bo_va_hole *left = root->left, *right = root->right;
+        struct radeon_bo_va_hole *min;
+
+        assert(root == hole);
+        if (!right)
+            return left;
+        right = va_hole_remove_min(right, &min);
+        min->left = left;
+        min->right = right;
+        return va_hole_balance(min);
+    }
+    return va_hole_balance(root);
+}
+
+/* Return the hole with the highest offset below the given one, if any. */
+static struct radeon_bo_va_hole *
+va_hole_find_below(struct radeon_bo_va_hole *root, uint64_t offset)
+{
+    struct radeon_bo_va_hole *found = NULL;
+
+    while (root) {
+        if (root->offset < offset) {
+            found = root;
+            root = root->right;
+        } else {
+            root = root->left;
         }
-        if ((hole->size - waste) == size) {
-            hole->size = waste;
-            pipe_mutex_unlock(mgr->bo_va_mutex);
-            return offset;
+    }
+    return found;
+}
+
+/* Return the hole with the lowest offset at or above the given one, if any. */
+static struct radeon_bo_va_hole *
+va_hole_find_above(struct radeon_bo_va_hole *root, uint64_t offset)
+{
+    struct radeon_bo_va_hole *found = NULL;
+
+    while (root) {
+        if (root->offset >= offset) {
+            found = root;
+            root = root->left;
+        } else {
+            root = root->right;
         }
     }
+    return found;
+}
+
+static INLINE uint64_t va_alignment_waste(uint64_t offset, uint64_t alignment)
+{
+    uint64_t waste = 0;
 
-    offset = mgr->va_offset;
-    waste = 0;
     if (alignment) {
         waste = offset % alignment;
         waste = waste ? alignment - waste : 0;
     }
-    if (waste) {
-        n = CALLOC_STRUCT(radeon_bo_va_hole);
-        n->size = waste;
-        n->offset = offset;
-        list_add(&n->list, &mgr->va_holes);
+    return waste;
+}
+
+/* Return the lowest hole that can fit an allocation of the given size and
+ * alignment.  Subtrees without a large enough hole are skipped, so unless
+ * alignment rejects many candidates this only visits O(log n) nodes.
+ */
+static struct radeon_bo_va_hole *
+va_hole_find_fit(struct radeon_bo_va_hole *root, uint64_t size,
+                 uint64_t alignment)
+{
+    struct radeon_bo_va_hole *hole;
+
+    if (va_hole_max_size(root) < size)
+        return NULL;
+
+    hole = va_hole_find_fit(root->left, size, alignment);
+    if (hole)
+        return hole;
+
+    if (root->size >= size &&
+        root->size - size >= va_alignment_waste(root->offset, alignment))
+        return root;
+
+    return va_hole_find_fit(root->right, size, alignment);
+}
+
+static void radeon_bomgr_add_hole(struct radeon_bomgr *mgr,
+                                  uint64_t offset, uint64_t size)
+{
+    struct radeon_bo_va_hole *hole;
+
+    /* FIXME on allocation failure we just lose virtual address space
+     * maybe print a warning
+     */
+    hole = CALLOC_STRUCT(radeon_bo_va_hole);
+    if (hole) {
+        hole->offset = offset;
+        hole->size = size;
+        mgr->va_holes = va_hole_insert(mgr->va_holes, hole);
     }
+}
+
+static void va_hole_free_all(struct radeon_bo_va_hole *hole)
+{
+    if (hole) {
+        va_hole_free_all(hole->left);
+        va_hole_free_all(hole->right);
+        FREE(hole);
+    }
+}
+
+static uint64_t radeon_bomgr_find_va(struct radeon_bomgr *mgr, uint64_t size, uint64_t alignment)
+{
+    struct radeon_bo_va_hole *hole;
+    uint64_t offset, waste;
+
+    pipe_mutex_lock(mgr->bo_va_mutex);
+    /* first look for a hole */
+    hole = va_hole_find_fit(mgr->va_holes, size, alignment);
+    if (hole) {
+        uint64_t hole_end = hole->offset + hole->size;
+
+        waste = va_alignment_waste(hole->offset, alignment);
+        offset = hole->offset + waste;
+        mgr->va_holes = va_hole_remove(mgr->va_holes, hole);
+
+        /* Put back what's left on either side of the allocation. */
+        if (waste) {
+            hole->size = waste;
+            mgr->va_holes = va_hole_insert(mgr->va_holes, hole);
+            hole = NULL;
+        }
+        if (offset + size < hole_end) {
+            if (hole) {
+                hole->offset = offset + size;
+                hole->size = hole_end - hole->offset;
+                mgr->va_holes = va_hole_insert(mgr->va_holes, hole);
+                hole = NULL;
+            } else {
+                radeon_bomgr_add_hole(mgr, offset + size,
+                                      hole_end - (offset + size));
+            }
+        }
+        FREE(hole);
+        pipe_mutex_unlock(mgr->bo_va_mutex);
+        return offset;
+    }
+
+    offset = mgr->va_offset;
+    waste = va_alignment_waste(offset, alignment);
+    if (waste)
+        radeon_bomgr_add_hole(mgr, offset, waste);
     offset += waste;
     mgr->va_offset += size + waste;
     pipe_mutex_unlock(mgr->bo_va_mutex);
@@ -264,113 +504,109 @@ static uint64_t radeon_bomgr_find_va(struct radeon_bomgr *mgr, uint64_t size, ui
 
 static void radeon_bomgr_force_va(struct radeon_bomgr *mgr, uint64_t va, uint64_t size)
 {
+    uint64_t va_end = va + size;
+
     pipe_mutex_lock(mgr->bo_va_mutex);
     if (va >= mgr->va_offset) {
-        if (va > mgr->va_offset) {
-            struct radeon_bo_va_hole *hole;
-            hole = CALLOC_STRUCT(radeon_bo_va_hole);
-            if (hole) {
-                hole->size = va - mgr->va_offset;
-                hole->offset = mgr->va_offset;
-                list_add(&hole->list, &mgr->va_holes);
-            }
-        }
-        mgr->va_offset = va + size;
+        if (va > mgr->va_offset)
+            radeon_bomgr_add_hole(mgr, mgr->va_offset, va - mgr->va_offset);
+        mgr->va_offset = va_end;
     } else {
-        struct radeon_bo_va_hole *hole, *n;
-        uint64_t hole_end, va_end;
+        struct radeon_bo_va_hole *hole;
+        uint64_t hole_end;
 
-        /* Prune/free all holes that fall into the range
+        /* Prune/free all holes that fall into the range, starting with one
+         * that begins below it and reaches into it.
          */
-        LIST_FOR_EACH_ENTRY_SAFE(hole, n, &mgr->va_holes, list) {
+        hole = va_hole_find_below(mgr->va_holes, va);
+        if (hole && hole->offset + hole->size > va) {
             hole_end = hole->offset + hole->size;
-            va_end = va + size;
-            if (hole->offset >= va_end || hole_end <= va)
-                continue;
-            if (hole->offset >= va && hole_end <= va_end) {
-                list_del(&hole->list);
-                FREE(hole);
-                continue;
-            }
-            if (hole->offset >= va)
+            mgr->va_holes = va_hole_remove(mgr->va_holes, hole);
+            hole->size = va - hole->offset;
+            mgr->va_holes = va_hole_insert(mgr->va_holes, hole);
+            if (hole_end > va_end)
+                radeon_bomgr_add_hole(mgr, va_end, hole_end - va_end);
+        }
+
+        while ((hole = va_hole_find_above(mgr->va_holes, va)) &&
+               hole->offset < va_end) {
+            hole_end = hole->offset + hole->size;
+            mgr->va_holes = va_hole_remove(mgr->va_holes, hole);
+            if (hole_end > va_end) {
                 hole->offset = va_end;
-            else
-                hole_end = va;
-            hole->size = hole_end - hole->offset;
+                hole->size = hole_end - va_end;
+                mgr->va_holes = va_hole_insert(mgr->va_holes, hole);
+                break;
+            }
+            FREE(hole);
         }
+
+        if (va_end > mgr->va_offset)
+            mgr->va_offset = va_end;
     }
     pipe_mutex_unlock(mgr->bo_va_mutex);
 }
 
 static void radeon_bomgr_free_va(struct radeon_bomgr *mgr, uint64_t va, uint64_t size)
 {
-    struct radeon_bo_va_hole *hole;
+    struct radeon_bo_va_hole *below, *above;
 
     pipe_mutex_lock(mgr->bo_va_mutex);
+    below = va_hole_find_below(mgr->va_holes, va);
+    if (below && below->offset + below->size != va)
+        below = NULL;
+
     if ((va + size) == mgr->va_offset) {
         mgr->va_offset = va;
         /* Delete uppermost hole if it reaches the new top */
-        if (!LIST_IS_EMPTY(&mgr->va_holes)) {
-            hole = container_of(mgr->va_holes.next, hole, list);
-            if ((hole->offset + hole->size) == va) {
-                mgr->va_offset = hole->offset;
-                list_del(&hole->list);
-                FREE(hole);
-            }
+        if (below) {
+            mgr->va_offset = below->offset;
+            mgr->va_holes = va_hole_remove(mgr->va_holes, below);
+            FREE(below);
         }
     } else {
-        struct radeon_bo_va_hole *next;
-
-        hole = container_of(&mgr->va_holes, hole, list);
-        LIST_FOR_EACH_ENTRY(next, &mgr->va_holes, list) {
-	    if (next->offset < va)
-	        break;
-            hole = next;
-        }
-
-        if (&hole->list != &mgr->va_holes) {
-            /* Grow upper hole if it's adjacent */
-            if (hole->offset == (va + size)) {
-                hole->offset = va;
-                hole->size += size;
-                /* Merge lower hole if it's adjacent */
-                if (next != hole && &next->list != &mgr->va_holes &&
-                    (next->offset + next->size) == va) {
-                    next->size += hole->size;
-                    list_del(&hole->list);
-                    FREE(hole);
-                }
-                goto out;
-            }
-        }
-
-        /* Grow lower hole if it's adjacent */
-        if (next != hole && &next->list != &mgr->va_holes &&
-            (next->offset + next->size) == va) {
-            next->size += size;
-            goto out;
-        }
-
-        /* FIXME on allocation failure we just lose virtual address space
-         * maybe print a warning
-         */
-        next = CALLOC_STRUCT(radeon_bo_va_hole);
-        if (next) {
-            next->size = size;
-            next->offset = va;
-            list_add(&next->list, &hole->list);
+        above = va_hole_find_above(mgr->va_holes, va + size);
+        if (above && above->offset != va + size)
+            above = NULL;
+
+        if (below && above) {
+            /* Merge both adjacent holes into the lower one */
+            mgr->va_holes = va_hole_remove(mgr->va_holes, above);
+            mgr->va_holes = va_hole_remove(mgr->va_holes, below);
+            below->size += size + above->size;
+            mgr->va_holes = va_hole_insert(mgr->va_holes, below);
+            FREE(above);
+        } else if (below) {
+            /* Grow lower hole */
+            mgr->va_holes = va_hole_remove(mgr->va_holes, below);
+            below->size += size;
+            mgr->va_holes = va_hole_insert(mgr->va_holes, below);
+        } else if (above) {
+            /* Grow upper hole */
+            mgr->va_holes = va_hole_remove(mgr->va_holes, above);
+            above->offset = va;
+            above->size += size;
+            mgr->va_holes = va_hole_insert(mgr->va_holes, above);
+        } else {
+            radeon_bomgr_add_hole(mgr, va, size);
         }
     }
-out:
     pipe_mutex_unlock(mgr->bo_va_mutex);
 }
 
+static void radeon_bo_slab_free_entry(struct radeon_bo *bo);
+
 static void radeon_bo_destroy(struct pb_buffer *_buf)
 {
     struct radeon_bo *bo = radeon_bo(_buf);
     struct radeon_bomgr *mgr = bo->mgr;
     struct drm_gem_close args;
 
+    if (bo->slab) {
+        radeon_bo_slab_free_entry(bo);
+        return;
+    }
+
     memset(&args, 0, sizeof(args));
 
     pipe_mutex_lock(bo->mgr->bo_handles_mutex);
@@ -406,6 +642,11 @@ void *radeon_bo_do_map(struct radeon_bo *bo)
     struct drm_radeon_gem_mmap args = {0};
     void *ptr;
 
+    if (bo->real) {
+        ptr = radeon_bo_do_map(bo->real);
+        return ptr ? (char*)ptr + bo->slab_offset : NULL;
+    }
+
     /* Return the pointer if it's already mapped. */
     if (bo->ptr)
         return bo->ptr;
@@ -504,7 +745,7 @@ static void *radeon_bo_map(struct radeon_winsys_cs_handle *buf,
                     cs->flush_cs(cs->flush_data, 0);
                 } else {
                     /* Try to avoid busy-waiting in radeon_bo_wait. */
-                    if (p_atomic_read(&bo->num_active_ioctls))
+                    if (p_atomic_read(&radeon_bo_real(bo)->num_active_ioctls))
                         radeon_drm_cs_sync_flush(rcs);
                 }
 
@@ -637,6 +878,145 @@ static struct pb_buffer *radeon_bomgr_create_bo(struct pb_manager *_mgr,
     return &bo->base;
 }
 
+static boolean radeon_bo_slab_is_idle(struct radeon_bo_slab *slab)
+{
+    return !radeon_bo_is_referenced_by_any_cs(slab->real) &&
+           !radeon_bo_is_busy(&slab->real->base, RADEON_USAGE_READWRITE);
+}
+
+static void radeon_bo_slab_destroy(struct radeon_bo_slab *slab)
+{
+    /* Command streams still using the slab hold their own references to the
+     * real buffer, so it's fine to let go of it here. */
+    radeon_bo_reference(&slab->real, NULL);
+    FREE(slab->entries);
+    FREE(slab->free);
+    FREE(slab->pending);
+    FREE(slab);
+}
+
+static struct radeon_bo_slab *
+radeon_bo_slab_create(struct radeon_bomgr *mgr, unsigned order,
+                      enum radeon_bo_domain domain)
+{
+    struct radeon_bo_slab *slab;
+    struct radeon_bo_desc desc;
+    unsigned i;
+
+    slab = CALLOC_STRUCT(radeon_bo_slab);
+    if (!slab)
+        return NULL;
+
+    memset(&desc, 0, sizeof(desc));
+    desc.base.alignment = 1 << RADEON_SLAB_MAX_ORDER;
+    desc.base.usage = domain;
+    desc.initial_domains = domain;
+
+    slab->real = (struct radeon_bo*)
+        radeon_bomgr_create_bo(&mgr->base, RADEON_SLAB_SIZE, &desc.base);
+    slab->domain = domain;
+    slab->order = order;
+    slab->num_entries = RADEON_SLAB_SIZE >> order;
+    slab->entries = CALLOC(slab->num_entries, sizeof(struct radeon_bo));
+    slab->free = MALLOC(slab->num_entries * sizeof(unsigned));
+    slab->pending = MALLOC(slab->num_entries * sizeof(unsigned));
+    if (!slab->real || !slab->entries || !slab->free || !slab->pending) {
+        radeon_bo_slab_destroy(slab);
+        return NULL;
+    }
+
+    for (i = 0; i < slab->num_entries; i++) {
+        struct radeon_bo *bo = &slab->entries[i];
+
+        bo->base.vtbl = &radeon_bo_vtbl;
+        bo->mgr = mgr;
+        bo->rws = mgr->rws;
+        bo->real = slab->real;
+        bo->slab = slab;
+        bo->slab_offset = i << order;
+        bo->handle = slab->real->handle;
+        bo->va = slab->real->va + bo->slab_offset;
+        bo->initial_domain = domain;
+
+        /* Hand out the lowest addresses first. */
+        slab->free[slab->num_free++] = slab->num_entries - 1 - i;
+    }
+    return slab;
+}
+
+static struct pb_buffer *radeon_bomgr_create_slab_bo(struct radeon_bomgr *mgr,
+                                                     unsigned size,
+                                                     unsigned alignment,
+                                                     enum radeon_bo_domain domain)
+{
+    unsigned order = MAX2(util_logbase2(util_next_power_of_two(size)),
+                          RADEON_SLAB_MIN_ORDER);
+    struct list_head *slabs = &mgr->slabs[order - RADEON_SLAB_MIN_ORDER];
+    struct radeon_bo_slab *slab, *found = NULL;
+    struct radeon_bo *bo;
+
+    pipe_mutex_lock(mgr->bo_slab_mutex);
+    LIST_FOR_EACH_ENTRY(slab, slabs, head) {
+        if (slab->domain != domain)
+            continue;
+
+        /* Entries destroyed while the slab was in use become available
+         * again once the GPU is done with it. */
+        if (!slab->num_free && slab->num_pending &&
+            radeon_bo_slab_is_idle(slab)) {
+            memcpy(slab->free, slab->pending,
+                   slab->num_pending * sizeof(unsigned));
+            slab->num_free = slab->num_pending;
+            slab->num_pending = 0;
+        }
+
+        if (slab->num_free) {
+            found = slab;
+            break;
+        }
+    }
+
+    if (!found) {
+        found = radeon_bo_slab_create(mgr, order, domain);
+        if (!found) {
+            pipe_mutex_unlock(mgr->bo_slab_mutex);
+            return NULL;
+        }
+        LIST_ADD(&found->head, slabs);
+    }
+
+    bo = &found->entries[found->free[--found->num_free]];
+    found->num_used++;
+    pipe_mutex_unlock(mgr->bo_slab_mutex);
+
+    pipe_reference_init(&bo->base.reference, 1);
+    bo->base.alignment = alignment;
+    bo->base.usage = domain;
+    bo->base.size = size;
+    return &bo->base;
+}
+
+static void radeon_bo_slab_free_entry(struct radeon_bo *bo)
+{
+    struct radeon_bo_slab *slab = bo->slab;
+    struct radeon_bomgr *mgr = bo->mgr;
+
+    pipe_mutex_lock(mgr->bo_slab_mutex);
+    slab->pending[slab->num_pending++] = bo - slab->entries;
+    slab->num_used--;
+
+    /* Release slabs that became empty, but keep the last one of each size
+     * around so that allocating and freeing a single buffer doesn't create
+     * and destroy a GEM object every time. */
+    if (!slab->num_used &&
+        !(slab->head.next == slab->head.prev &&
+          slab->head.next == &mgr->slabs[slab->order - RADEON_SLAB_MIN_ORDER])) {
+        LIST_DEL(&slab->head);
+        radeon_bo_slab_destroy(slab);
+    }
+    pipe_mutex_unlock(mgr->bo_slab_mutex);
+}
+
 static void radeon_bomgr_flush(struct pb_manager *mgr)
 {
     /* NOP */
@@ -662,10 +1042,21 @@ static boolean radeon_bomgr_is_buffer_busy(struct pb_manager *_mgr,
 static void radeon_bomgr_destroy(struct pb_manager *_mgr)
 {
     struct radeon_bomgr *mgr = radeon_bomgr(_mgr);
+    struct radeon_bo_slab *slab, *next;
+    unsigned i;
+
+    for (i = 0; i < RADEON_SLAB_NUM_ORDERS; i++) {
+        LIST_FOR_EACH_ENTRY_SAFE(slab, next, &mgr->slabs[i], head) {
+            radeon_bo_slab_destroy(slab);
+        }
+    }
+    pipe_mutex_destroy(mgr->bo_slab_mutex);
+
     util_hash_table_destroy(mgr->bo_names);
     util_hash_table_destroy(mgr->bo_handles);;
     pipe_mutex_destroy(mgr->bo_handles_mutex);
     pipe_mutex_destroy(mgr->bo_va_mutex);
+    va_hole_free_all(mgr->va_holes);
     FREE(mgr);
 }
 
@@ -684,6 +1075,7 @@ static int handle_compare(void *key1, void *key2)
 struct pb_manager *radeon_bomgr_create(struct radeon_drm_winsys *rws)
 {
     struct radeon_bomgr *mgr;
+    unsigned i;
 
     mgr = CALLOC_STRUCT(radeon_bomgr);
     if (!mgr)
@@ -702,7 +1094,11 @@ struct pb_manager *radeon_bomgr_create(struct radeon_drm_winsys *rws)
 
     mgr->va = rws->info.r600_virtual_address;
     mgr->va_offset = rws->info.r600_va_start;
-    list_inithead(&mgr->va_holes);
+    mgr->va_holes = NULL;
+
+    pipe_mutex_init(mgr->bo_slab_mutex);
+    for (i = 0; i < RADEON_SLAB_NUM_ORDERS; i++)
+        list_inithead(&mgr->slabs[i]);
 
     return &mgr->base;
 }
@@ -744,7 +1140,7 @@ static void radeon_bo_get_tiling(struct pb_buffer *_buf,
                                  unsigned *stencil_tile_split,
                                  unsigned *mtilea)
 {
-    struct radeon_bo *bo = get_radeon_bo(_buf);
+    struct radeon_bo *bo = radeon_bo_real(get_radeon_bo(_buf));
     struct drm_radeon_gem_set_tiling args;
 
     memset(&args, 0, sizeof(args));
@@ -783,7 +1179,7 @@ static void radeon_bo_set_tiling(struct pb_buffer *_buf,
                                  unsigned mtilea,
                                  uint32_t pitch)
 {
-    struct radeon_bo *bo = get_radeon_bo(_buf);
+    struct radeon_bo *bo = radeon_bo_real(get_radeon_bo(_buf));
     struct radeon_drm_cs *cs = radeon_drm_cs(rcs);
     struct drm_radeon_gem_set_tiling args;
 
@@ -857,6 +1253,19 @@ radeon_winsys_bo_create(struct radeon_winsys *rws,
     desc.base.usage = domain;
     desc.initial_domains = domain;
 
+    /* Small buffers that won't be shared are suballocated from slabs, so
+     * that they don't each cost a GEM object and a relocation per CS.
+     * Without virtual memory, the kernel would patch in the address of the
+     * slab instead of the buffer, so this needs VM. */
+    if (use_reusable_pool && mgr->va &&
+        size <= (1 << RADEON_SLAB_MAX_ORDER) &&
+        alignment <= MAX2(util_next_power_of_two(size),
+                          1 << RADEON_SLAB_MIN_ORDER)) {
+        buffer = radeon_bomgr_create_slab_bo(mgr, size, alignment, domain);
+        if (buffer)
+            return buffer;
+    }
+
     /* Assign a buffer manager. */
     if (use_reusable_pool)
         provider = ws->cman;
@@ -1006,7 +1415,7 @@ static boolean radeon_winsys_bo_get_handle(struct pb_buffer *buffer,
                                            struct winsys_handle *whandle)
 {
     struct drm_gem_flink flink;
-    struct radeon_bo *bo = get_radeon_bo(buffer);
+    struct radeon_bo *bo = radeon_bo_real(get_radeon_bo(buffer));
 
     memset(&flink, 0, sizeof(flink));
 
@@ -37,6 +37,8 @@
 #include "os/os_thread.h"
 
 struct radeon_bomgr;
+struct radeon_bo_slab;
+struct radeon_cs_context;
 
 struct radeon_bo_desc {
     struct pb_desc base;
@@ -66,8 +68,22 @@ struct radeon_bo {
      * thread, is this bo referenced in? */
     int num_active_ioctls;
 
+    /* The CS context this bo was last added to and its reloc index there.
+     * Only a hint: it's checked against the context's reloc list before
+     * use, so it never needs to be invalidated. */
+    struct radeon_cs_context *last_csc;
+    unsigned last_reloc_index;
+
     boolean flinked;
     uint32_t flink;
+
+    /* Set for small buffers suballocated from a slab: the GEM object holding
+     * the slab, the slab itself and where in it this buffer lives.  Anything
+     * the kernel knows about (relocations, busy state, tiling, mappings) is
+     * handled through the real buffer; va already includes the offset. */
+    struct radeon_bo *real;
+    struct radeon_bo_slab *slab;
+    unsigned slab_offset;
 };
 
 struct pb_manager *radeon_bomgr_create(struct radeon_drm_winsys *rws);
@@ -79,6 +95,13 @@ void radeon_bo_reference(struct radeon_bo **dst, struct radeon_bo *src)
     pb_reference((struct pb_buffer**)dst, (struct pb_buffer*)src);
 }
 
+/* Return the buffer backed by a GEM object that contains the given one. */
+static INLINE
+struct radeon_bo *radeon_bo_real(struct radeon_bo *bo)
+{
+    return bo->real ? bo->real : bo;
+}
+
 void *radeon_bo_do_map(struct radeon_bo *bo);
 
 #endif
@@ -65,6 +65,7 @@
 #include "radeon_drm_cs.h"
 
 #include "util/u_memory.h"
+#include "os/os_time.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -146,6 +147,12 @@ static void radeon_cs_context_cleanup(struct radeon_cs_context *csc)
     unsigned i;
 
     for (i = 0; i < csc->crelocs; i++) {
+        /* Only clear the hash slots that are in use instead of the whole
+         * table, most CS have far fewer relocs than slots.  Slots left set
+         * by relocs dropped in cs_validate are harmless, since lookups
+         * check the index against crelocs. */
+        csc->is_handle_added[csc->relocs[i].handle &
+                             (sizeof(csc->is_handle_added)-1)] = 0;
         p_atomic_dec(&csc->relocs_bo[i]->num_cs_references);
         radeon_bo_reference(&csc->relocs_bo[i], NULL);
     }
@@ -156,7 +163,6 @@ static void radeon_cs_context_cleanup(struct radeon_cs_context *csc)
     csc->chunks[1].length_dw = 0;
     csc->used_gart = 0;
     csc->used_vram = 0;
-    memset(csc->is_handle_added, 0, sizeof(csc->is_handle_added));
 }
 
 static void radeon_destroy_cs_context(struct radeon_cs_context *csc)
@@ -216,16 +222,33 @@ static INLINE void update_reloc_domains(struct drm_radeon_cs_reloc *reloc,
     reloc->write_domain |= wd;
 }
 
+/* Return the reloc index cached in the bo if it's still valid for this CS
+ * context, -1 otherwise.  The cache may be stale or written concurrently
+ * by another CS, which is why the reloc list is always checked. */
+static INLINE int radeon_get_cached_reloc(struct radeon_cs_context *csc,
+                                          struct radeon_bo *bo)
+{
+    unsigned i = bo->last_reloc_index;
+
+    if (bo->last_csc == csc && i < csc->crelocs && csc->relocs_bo[i] == bo)
+        return i;
+    return -1;
+}
+
 int radeon_get_reloc(struct radeon_cs_context *csc, struct radeon_bo *bo)
 {
     struct drm_radeon_cs_reloc *reloc;
     unsigned i;
     unsigned hash = bo->handle & (sizeof(csc->is_handle_added)-1);
+    int cached = radeon_get_cached_reloc(csc, bo);
+
+    if (cached != -1)
+        return cached;
 
     if (csc->is_handle_added[hash]) {
         i = csc->reloc_indices_hashlist[hash];
         reloc = &csc->relocs[i];
-        if (reloc->handle == bo->handle) {
+        if (i < csc->crelocs && reloc->handle == bo->handle) {
             return i;
         }
 
@@ -268,10 +291,18 @@ static unsigned radeon_add_reloc(struct radeon_drm_cs *cs,
     int i;
 
     *added_domains = 0;
-    if (csc->is_handle_added[hash]) {
+
+    /* Fast path: the bo is usually added several times in a row. */
+    i = radeon_get_cached_reloc(csc, bo);
+    if (i != -1) {
+        update_reloc_domains(&csc->relocs[i], rd, wd, added_domains);
+        if (cs->base.ring_type != RING_DMA)
+            return i;
+        update_hash = FALSE;
+    } else if (csc->is_handle_added[hash]) {
         i = csc->reloc_indices_hashlist[hash];
         reloc = &csc->relocs[i];
-        if (reloc->handle != bo->handle) {
+        if (i >= csc->crelocs || reloc->handle != bo->handle) {
             /* Hash collision, look for the BO in the list of relocs linearly. */
             for (i = csc->crelocs - 1; i >= 0; i--) {
                 reloc = &csc->relocs[i];
@@ -296,6 +327,8 @@ static unsigned radeon_add_reloc(struct radeon_drm_cs *cs,
             update_reloc_domains(reloc, rd, wd, added_domains);
             if (cs->base.ring_type != RING_DMA) {
                 csc->reloc_indices_hashlist[hash] = i;
+                bo->last_csc = csc;
+                bo->last_reloc_index = i;
                 return i;
             }
         }
@@ -327,7 +360,10 @@ static unsigned radeon_add_reloc(struct radeon_drm_cs *cs,
 
     csc->is_handle_added[hash] = TRUE;
     if (update_hash) {
+        /* On the DMA ring, keep both pointing at the first reloc. */
         csc->reloc_indices_hashlist[hash] = csc->crelocs;
+        bo->last_csc = csc;
+        bo->last_reloc_index = csc->crelocs;
     }
 
     csc->chunks[1].length_dw += RELOC_DWORDS;
@@ -342,7 +378,8 @@ static unsigned radeon_drm_cs_add_reloc(struct radeon_winsys_cs *rcs,
                                         enum radeon_bo_domain domains)
 {
     struct radeon_drm_cs *cs = radeon_drm_cs(rcs);
-    struct radeon_bo *bo = (struct radeon_bo*)buf;
+    /* Suballocated buffers are relocated as the slab they live in. */
+    struct radeon_bo *bo = radeon_bo_real((struct radeon_bo*)buf);
     enum radeon_bo_domain added_domains;
     unsigned index = radeon_add_reloc(cs, bo, usage, domains, &added_domains);
 
@@ -404,7 +441,7 @@ static void radeon_drm_cs_write_reloc(struct radeon_winsys_cs *rcs,
                                       struct radeon_winsys_cs_handle *buf)
 {
     struct radeon_drm_cs *cs = radeon_drm_cs(rcs);
-    struct radeon_bo *bo = (struct radeon_bo*)buf;
+    struct radeon_bo *bo = radeon_bo_real((struct radeon_bo*)buf);
     unsigned index = radeon_get_reloc(cs->csc, bo);
 
     if (index == -1) {
@@ -454,8 +491,11 @@ void radeon_drm_cs_sync_flush(struct radeon_winsys_cs *rcs)
 
     /* Wait for any pending ioctl to complete. */
     if (cs->ws->thread && cs->flush_started) {
+        uint64_t time = os_time_get_nano();
+
         pipe_semaphore_wait(&cs->flush_completed);
         cs->flush_started = 0;
+        cs->ws->cs_sync_wait_time += os_time_get_nano() - time;
     }
 }
 
@@ -581,7 +621,7 @@ static boolean radeon_bo_is_referenced(struct radeon_winsys_cs *rcs,
                                        enum radeon_bo_usage usage)
 {
     struct radeon_drm_cs *cs = radeon_drm_cs(rcs);
-    struct radeon_bo *bo = (struct radeon_bo*)_buf;
+    struct radeon_bo *bo = radeon_bo_real((struct radeon_bo*)_buf);
     int index;
 
     if (!bo->num_cs_references)
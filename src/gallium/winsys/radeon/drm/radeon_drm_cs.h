@@ -93,7 +93,10 @@ static INLINE boolean
 radeon_bo_is_referenced_by_cs(struct radeon_drm_cs *cs,
                               struct radeon_bo *bo)
 {
-    int num_refs = bo->num_cs_references;
+    int num_refs;
+
+    bo = radeon_bo_real(bo);
+    num_refs = bo->num_cs_references;
     return num_refs == bo->rws->num_cs ||
            (num_refs && radeon_get_reloc(cs->csc, bo) != -1);
 }
@@ -104,6 +107,7 @@ radeon_bo_is_referenced_by_cs_for_write(struct radeon_drm_cs *cs,
 {
     int index;
 
+    bo = radeon_bo_real(bo);
     if (!bo->num_cs_references)
         return FALSE;
 
@@ -117,7 +121,7 @@ radeon_bo_is_referenced_by_cs_for_write(struct radeon_drm_cs *cs,
 static INLINE boolean
 radeon_bo_is_referenced_by_any_cs(struct radeon_bo *bo)
 {
-    return bo->num_cs_references != 0;
+    return radeon_bo_real(bo)->num_cs_references != 0;
 }
 
 void radeon_drm_cs_sync_flush(struct radeon_winsys_cs *rcs);
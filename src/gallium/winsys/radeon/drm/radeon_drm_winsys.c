@@ -36,6 +36,7 @@
 #include "radeon_drm_public.h"
 
 #include "pipebuffer/pb_bufmgr.h"
+#include "os/os_time.h"
 #include "util/u_memory.h"
 #include "util/u_hash_table.h"
 
@@ -513,6 +514,10 @@ static uint64_t radeon_query_value(struct radeon_winsys *rws,
         radeon_get_drm_value(ws->fd, RADEON_INFO_TIMESTAMP, "timestamp",
                              (uint32_t*)&ts);
         return ts;
+    case RADEON_CS_THREAD_TIME_NS:
+        return ws->cs_thread_time;
+    case RADEON_CS_SYNC_WAIT_TIME_NS:
+        return ws->cs_sync_wait_time;
     }
     return 0;
 }
@@ -558,7 +563,10 @@ next:
         pipe_mutex_unlock(ws->cs_stack_lock);
 
         if (cs) {
+            uint64_t time = os_time_get_nano();
+
             radeon_drm_cs_emit_ioctl_oneshot(cs, cs->cst);
+            ws->cs_thread_time += os_time_get_nano() - time;
 
             pipe_mutex_lock(ws->cs_stack_lock);
             for (i = 1; i < p_atomic_read(&ws->ncs); i++) {
@@ -620,7 +628,7 @@ struct radeon_winsys *radeon_drm_winsys_create(int fd)
     ws->kman = radeon_bomgr_create(ws);
     if (!ws->kman)
         goto fail;
-    ws->cman = pb_cache_manager_create(ws->kman, 1000000);
+    ws->cman = pb_cache_manager_create(ws->kman, 1000000, 0);
     if (!ws->cman)
         goto fail;
 
@@ -49,6 +49,8 @@ struct radeon_drm_winsys {
     uint64_t allocated_vram;
     uint64_t allocated_gtt;
     uint64_t buffer_wait_time; /* time spent in buffer_wait in ns */
+    uint64_t cs_thread_time; /* time the CS thread spent in the CS ioctl in ns */
+    uint64_t cs_sync_wait_time; /* time spent waiting for the CS thread in ns */
 
     enum radeon_generation gen;
     struct radeon_info info;
@@ -151,7 +151,9 @@ enum radeon_value_id {
     RADEON_REQUESTED_VRAM_MEMORY,
     RADEON_REQUESTED_GTT_MEMORY,
     RADEON_BUFFER_WAIT_TIME_NS,
-    RADEON_TIMESTAMP
+    RADEON_TIMESTAMP,
+    RADEON_CS_THREAD_TIME_NS,    /* time the CS thread spent in the CS ioctl */
+    RADEON_CS_SYNC_WAIT_TIME_NS  /* time spent in cs_sync_flush waiting for it */
 };
 
 struct winsys_handle;
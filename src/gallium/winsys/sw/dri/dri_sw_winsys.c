@@ -26,6 +26,9 @@
  *
  **************************************************************************/
 
+#include <sys/ipc.h>
+#include <sys/shm.h>
+
 #include "pipe/p_compiler.h"
 #include "pipe/p_format.h"
 #include "util/u_inlines.h"
@@ -46,6 +49,12 @@ struct dri_sw_displaytarget
 
    void *data;
    void *mapped;
+
+   /**
+    * SysV shared memory segment data is in, or -1 if it was malloc'ed.
+    * The loader can then show it with MIT-SHM rather than send it over.
+    */
+   int shmid;
 };
 
 struct dri_sw_winsys
@@ -77,6 +86,25 @@ dri_sw_is_displaytarget_format_supported( struct sw_winsys *ws,
    return TRUE;
 }
 
+static char *
+alloc_shm(struct dri_sw_displaytarget *dri_sw_dt, unsigned size)
+{
+   char *addr;
+
+   dri_sw_dt->shmid = shmget(IPC_PRIVATE, size, IPC_CREAT | 0600);
+   if (dri_sw_dt->shmid < 0)
+      return NULL;
+
+   addr = (char *) shmat(dri_sw_dt->shmid, 0, 0);
+   if (addr == (char *) -1) {
+      shmctl(dri_sw_dt->shmid, IPC_RMID, 0);
+      dri_sw_dt->shmid = -1;
+      return NULL;
+   }
+
+   return addr;
+}
+
 static struct sw_displaytarget *
 dri_sw_displaytarget_create(struct sw_winsys *winsys,
                             unsigned tex_usage,
@@ -102,7 +130,15 @@ dri_sw_displaytarget_create(struct sw_winsys *winsys,
    nblocksy = util_format_get_nblocksy(format, height);
    size = dri_sw_dt->stride * nblocksy;
 
-   dri_sw_dt->data = align_malloc(size, alignment);
+   dri_sw_dt->shmid = -1;
+
+   /* shmat() returns page aligned memory */
+   if (dri_sw_winsys(winsys)->lf->put_image_shm &&
+       (tex_usage & PIPE_BIND_DISPLAY_TARGET))
+      dri_sw_dt->data = alloc_shm(dri_sw_dt, size);
+
+   if(!dri_sw_dt->data)
+      dri_sw_dt->data = align_malloc(size, alignment);
    if(!dri_sw_dt->data)
       goto no_data;
 
@@ -121,7 +157,13 @@ dri_sw_displaytarget_destroy(struct sw_winsys *ws,
 {
    struct dri_sw_displaytarget *dri_sw_dt = dri_sw_displaytarget(dt);
 
-   FREE(dri_sw_dt->data);
+   if (dri_sw_dt->shmid >= 0) {
+      shmdt(dri_sw_dt->data);
+      shmctl(dri_sw_dt->shmid, IPC_RMID, 0);
+   }
+   else {
+      align_free(dri_sw_dt->data);
+   }
 
    FREE(dri_sw_dt);
 }
@@ -181,6 +223,13 @@ dri_sw_displaytarget_display(struct sw_winsys *ws,
 
    height = dri_sw_dt->height;
 
+   if (dri_sw_dt->shmid >= 0) {
+      dri_sw_ws->lf->put_image_shm(dri_drawable, dri_sw_dt->shmid,
+                                   dri_sw_dt->data, 0,
+                                   width, height, dri_sw_dt->stride);
+      return;
+   }
+
    dri_sw_ws->lf->put_image(dri_drawable, dri_sw_dt->data, width, height);
 }
 
@@ -49,23 +49,22 @@ struct YYLTYPE;
  */
 class ast_node {
 public:
-   /* Callers of this ralloc-based new need not call delete. It's
-    * easier to just ralloc_free 'ctx' (or any of its ancestors). */
-   static void* operator new(size_t size, void *ctx)
+   /* AST nodes are allocated out of the linear context of the parse
+    * state (see ralloc.h), and all go away with it. */
+   static void* operator new(size_t size, void *linalloc)
    {
       void *node;
 
-      node = rzalloc_size(ctx, size);
+      node = linear_zalloc(linalloc, size);
       assert(node != NULL);
 
       return node;
    }
 
-   /* If the user *does* call delete, that's OK, we will just
-    * ralloc_free in that case. */
-   static void operator delete(void *table)
+   /* Linear allocations can't be freed individually, so this only exists
+    * to keep delete from being an error. */
+   static void operator delete(void *)
    {
-      ralloc_free(table);
    }
 
    /**
@@ -338,23 +337,22 @@ enum {
 };
 
 struct ast_type_qualifier {
-   /* Callers of this ralloc-based new need not call delete. It's
-    * easier to just ralloc_free 'ctx' (or any of its ancestors). */
-   static void* operator new(size_t size, void *ctx)
+   /* AST nodes are allocated out of the linear context of the parse
+    * state (see ralloc.h), and all go away with it. */
+   static void* operator new(size_t size, void *linalloc)
    {
       void *node;
 
-      node = rzalloc_size(ctx, size);
+      node = linear_zalloc(linalloc, size);
       assert(node != NULL);
 
       return node;
    }
 
-   /* If the user *does* call delete, that's OK, we will just
-    * ralloc_free in that case. */
-   static void operator delete(void *table)
+   /* Linear allocations can't be freed individually, so this only exists
+    * to keep delete from being an error. */
+   static void operator delete(void *)
    {
-      ralloc_free(table);
    }
 
    union {
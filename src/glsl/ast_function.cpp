@@ -405,7 +405,7 @@ match_function_by_name(const char *name,
    _mesa_glsl_initialize_functions(state);
    for (unsigned i = 0; i < state->num_builtins_to_link; i++) {
       ir_function *builtin =
-	 state->builtins_to_link[i]->symbols->get_function(name);
+	 _mesa_glsl_get_builtin_function(state->builtins_to_link[i], name);
       if (builtin == NULL)
 	 continue;
 
@@ -462,9 +462,9 @@ no_matching_function_error(const char *name,
    const char *prefix = "candidates are: ";
 
    for (int i = -1; i < (int) state->num_builtins_to_link; i++) {
-      glsl_symbol_table *syms = i >= 0 ? state->builtins_to_link[i]->symbols
-				       : state->symbols;
-      ir_function *f = syms->get_function(name);
+      ir_function *f = i >= 0
+	 ? _mesa_glsl_get_builtin_function(state->builtins_to_link[i], name)
+	 : state->symbols->get_function(name);
       if (f == NULL)
 	 continue;
 
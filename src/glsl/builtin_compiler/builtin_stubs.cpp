@@ -23,6 +23,7 @@
 
 #include <stdio.h>
 #include "glsl_parser_extras.h"
+#include "ir.h"
 
 /* A dummy file.  When compiling prototypes, we don't care about builtins.
  * We really don't want to half-compile builtin_functions.cpp and fail, though.
@@ -37,3 +38,11 @@ _mesa_glsl_initialize_functions(_mesa_glsl_parse_state *state)
 {
    (void) state;
 }
+
+ir_function *
+_mesa_glsl_get_builtin_function(struct gl_shader *sh, const char *name)
+{
+   (void) sh;
+   (void) name;
+   return NULL;
+}
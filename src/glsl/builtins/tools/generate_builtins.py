@@ -118,6 +118,13 @@ def write_profile(filename, profile):
         print '   builtin_' + func + ','
     print '};'
 
+    # The names, in the same (strcmp) order, so a body can be found by
+    # binary search when it is first needed.
+    print 'static const char *function_names_for_' + profile + ' [] = {'
+    for func in sorted(function_names):
+        print '   "' + func + '",'
+    print '};'
+
 def write_profiles():
     profiles = get_profile_list()
     for (filename, profile) in profiles:
@@ -165,22 +172,26 @@ if __name__ == "__main__":
 #include "ir_reader.h"
 #include "program.h"
 #include "ast.h"
+#include "ir_hierarchical_visitor.h"
 
 extern "C" struct gl_shader *
 _mesa_new_shader(struct gl_context *ctx, GLuint name, GLenum type);
 
-gl_shader *
-read_builtins(GLenum target, const char *protos, const char **functions, unsigned count)
+static void
+init_builtin_context(struct gl_context *fakeCtx)
+{
+   fakeCtx->API = API_OPENGL_COMPAT;
+   fakeCtx->Const.GLSLVersion = 150;
+   fakeCtx->Extensions.ARB_ES2_compatibility = true;
+   fakeCtx->Extensions.ARB_ES3_compatibility = true;
+   fakeCtx->Const.ForceGLSLExtensionsWarn = false;
+}
+
+static struct _mesa_glsl_parse_state *
+create_builtin_state(struct gl_context *fakeCtx, GLenum target, void *mem_ctx)
 {
-   struct gl_context fakeCtx;
-   fakeCtx.API = API_OPENGL_COMPAT;
-   fakeCtx.Const.GLSLVersion = 150;
-   fakeCtx.Extensions.ARB_ES2_compatibility = true;
-   fakeCtx.Extensions.ARB_ES3_compatibility = true;
-   fakeCtx.Const.ForceGLSLExtensionsWarn = false;
-   gl_shader *sh = _mesa_new_shader(NULL, 0, target);
    struct _mesa_glsl_parse_state *st =
-      new(sh) _mesa_glsl_parse_state(&fakeCtx, target, sh);
+      new(mem_ctx) _mesa_glsl_parse_state(fakeCtx, target, mem_ctx);
 
    st->language_version = 150;
    st->symbols->separate_function_namespace = false;
@@ -195,25 +206,36 @@ read_builtins(GLenum target, const char *protos, const char **functions, unsigne
    st->ARB_gpu_shader5_enable = true;
    _mesa_glsl_initialize_types(st);
 
+   return st;
+}
+
+/**
+ * Read the prototypes of a built-in profile.
+ *
+ * Only the signatures are created here.  The bodies are read one function
+ * at a time by read_builtin_body() the first time a shader calls them, so
+ * a shader that uses a handful of built-ins does not pay for parsing the
+ * hundreds of others in its profile.
+ */
+gl_shader *
+read_builtins(GLenum target, const char *protos)
+{
+   struct gl_context fakeCtx;
+   init_builtin_context(&fakeCtx);
+   gl_shader *sh = _mesa_new_shader(NULL, 0, target);
+   struct _mesa_glsl_parse_state *st = create_builtin_state(&fakeCtx, target, sh);
+
    sh->ir = new(sh) exec_list;
    sh->symbols = st->symbols;
 
    /* Read the IR containing the prototypes */
    _mesa_glsl_read_ir(st, sh->ir, protos, true);
 
-   /* Read ALL the function bodies, telling the IR reader not to scan for
-    * prototypes (we've already created them).  The IR reader will skip any
-    * signature that does not already exist as a prototype.
-    */
-   for (unsigned i = 0; i < count; i++) {
-      _mesa_glsl_read_ir(st, sh->ir, functions[i], false);
-
-      if (st->error) {
-         printf("error reading builtin: %.35s ...\\n", functions[i]);
-         printf("Info log:\\n%s\\n", st->info_log);
-         ralloc_free(sh);
-         return NULL;
-      }
+   if (st->error) {
+      printf("error reading builtin prototypes: %.35s ...\\n", protos);
+      printf("Info log:\\n%s\\n", st->info_log);
+      ralloc_free(sh);
+      return NULL;
    }
 
    reparent_ir(sh->ir, sh);
@@ -221,6 +243,52 @@ read_builtins(GLenum target, const char *protos, const char **functions, unsigne
 
    return sh;
 }
+
+/**
+ * Fill in the signatures of one built-in function from its IR.
+ *
+ * Other threads may be looking up functions in \\c sh while this runs, so
+ * the body is read through a private symbol table rather than the shader's
+ * own one.  The prototypes being filled in are not visible to anyone until
+ * the caller marks the function as loaded.
+ */
+static bool
+read_builtin_body(gl_shader *sh, ir_function *f, const char *body)
+{
+   void *mem_ctx = ralloc_context(NULL);
+   struct gl_context fakeCtx;
+   init_builtin_context(&fakeCtx);
+   struct _mesa_glsl_parse_state *st =
+      create_builtin_state(&fakeCtx, sh->Type, mem_ctx);
+
+   foreach_list(node, sh->ir) {
+      ir_function *f = ((ir_instruction *) node)->as_function();
+      if (f != NULL)
+         st->symbols->add_function(f);
+   }
+
+   /* Tell the IR reader not to scan for prototypes (we've already created
+    * them).  The IR reader will skip any signature that does not already
+    * exist as a prototype.
+    */
+   exec_list instructions;
+   _mesa_glsl_read_ir(st, &instructions, body, false);
+
+   bool ok = !st->error;
+   if (!ok) {
+      printf("error reading builtin: %.35s ...\\n", body);
+      printf("Info log:\\n%s\\n", st->info_log);
+   }
+
+   foreach_list(node, &f->signatures) {
+      ir_function_signature *sig = (ir_function_signature *) node;
+      reparent_ir(&sig->parameters, sh);
+      reparent_ir(&sig->body, sh);
+   }
+
+   ralloc_free(mem_ctx);
+   return ok;
+}
 """
 
     write_function_definitions()
@@ -228,32 +296,144 @@ read_builtins(GLenum target, const char *protos, const char **functions, unsigne
 
     profiles = get_profile_list()
 
+    print 'struct builtin_profile_functions {'
+    print '   const char *const *names;'
+    print '   const char *const *bodies;'
+    print '   unsigned count;'
+    print '};'
+    print
+    print 'static const struct builtin_profile_functions builtin_functions[%d] = {' % len(profiles)
+    for (filename, profile) in profiles:
+        print '   { function_names_for_' + profile + ', functions_for_' + profile + ','
+        print '     Elements(functions_for_' + profile + ') },'
+    print '};'
+    print
     print 'static gl_shader *builtin_profiles[%d];' % len(profiles)
+    print 'static bool *builtin_loaded[%d];' % len(profiles)
 
     print """
 static void *builtin_mem_ctx = NULL;
 
+/**
+ * Protects builtin_mem_ctx, builtin_profiles and builtin_loaded, which are
+ * filled in lazily, from contexts compiling shaders on several threads at
+ * once.  Once a function's body has been loaded it is only ever read.
+ */
+_glthread_DECLARE_STATIC_MUTEX(builtin_mutex);
+
 void
 _mesa_glsl_release_functions(void)
 {
+   _glthread_LOCK_MUTEX(builtin_mutex);
    ralloc_free(builtin_mem_ctx);
    builtin_mem_ctx = NULL;
    memset(builtin_profiles, 0, sizeof(builtin_profiles));
+   memset(builtin_loaded, 0, sizeof(builtin_loaded));
+   _glthread_UNLOCK_MUTEX(builtin_mutex);
+}
+
+static void
+load_builtin_function(int profile_index, const char *name);
+
+/**
+ * Loads every built-in called from a freshly read body, so that any
+ * signature an ir_call can point at already has its body and is never
+ * modified again.
+ */
+class builtin_call_visitor : public ir_hierarchical_visitor {
+public:
+   builtin_call_visitor(int profile_index)
+      : profile_index(profile_index)
+   {
+   }
+
+   virtual ir_visitor_status visit_enter(ir_call *ir)
+   {
+      load_builtin_function(this->profile_index, ir->callee_name());
+      return visit_continue;
+   }
+
+private:
+   int profile_index;
+};
+
+/**
+ * Read the body of the built-in \\c name of a profile, if it has not been
+ * read yet.  builtin_mutex must be held.
+ */
+static void
+load_builtin_function(int profile_index, const char *name)
+{
+   const struct builtin_profile_functions *funcs =
+      &builtin_functions[profile_index];
+   gl_shader *sh = builtin_profiles[profile_index];
+   unsigned lo = 0;
+   unsigned hi = funcs->count;
+
+   while (lo < hi) {
+      const unsigned mid = (lo + hi) / 2;
+      const int cmp = strcmp(name, funcs->names[mid]);
+
+      if (cmp < 0) {
+         hi = mid;
+      } else if (cmp > 0) {
+         lo = mid + 1;
+      } else {
+         if (builtin_loaded[profile_index][mid])
+            return;
+
+         /* Mark it first; built-ins are not recursive, but a bad body must
+          * not be re-read on every call either.
+          */
+         builtin_loaded[profile_index][mid] = true;
+
+         ir_function *f = sh->symbols->get_function(name);
+         if (f == NULL || !read_builtin_body(sh, f, funcs->bodies[mid]))
+            return;
+
+         builtin_call_visitor v(profile_index);
+         foreach_list(node, &f->signatures) {
+            ir_function_signature *sig = (ir_function_signature *) node;
+            v.run(&sig->body);
+         }
+         return;
+      }
+   }
+}
+
+ir_function *
+_mesa_glsl_get_builtin_function(gl_shader *sh, const char *name)
+{
+   ir_function *f = sh->symbols->get_function(name);
+   if (f == NULL)
+      return NULL;
+
+   _glthread_LOCK_MUTEX(builtin_mutex);
+   for (unsigned i = 0; i < Elements(builtin_profiles); i++) {
+      if (builtin_profiles[i] == sh) {
+         load_builtin_function(i, name);
+         break;
+      }
+   }
+   _glthread_UNLOCK_MUTEX(builtin_mutex);
+
+   return f;
 }
 
 static void
 _mesa_read_profile(struct _mesa_glsl_parse_state *state,
                    int profile_index,
-		   const char *prototypes,
-		   const char **functions,
-                   int count)
+		   const char *prototypes)
 {
    gl_shader *sh = builtin_profiles[profile_index];
 
    if (sh == NULL) {
-      sh = read_builtins(GL_VERTEX_SHADER, prototypes, functions, count);
+      sh = read_builtins(GL_VERTEX_SHADER, prototypes);
       ralloc_steal(builtin_mem_ctx, sh);
       builtin_profiles[profile_index] = sh;
+      builtin_loaded[profile_index] =
+         rzalloc_array(builtin_mem_ctx, bool,
+                       builtin_functions[profile_index].count);
    }
 
    state->builtins_to_link[state->num_builtins_to_link] = sh;
@@ -267,6 +447,8 @@ _mesa_glsl_initialize_functions(struct _mesa_glsl_parse_state *state)
    if (state->num_builtins_to_link > 0)
       return;
 
+   _glthread_LOCK_MUTEX(builtin_mutex);
+
    if (builtin_mem_ctx == NULL) {
       builtin_mem_ctx = ralloc_context(NULL); // "GLSL built-in functions"
       memset(&builtin_profiles, 0, sizeof(builtin_profiles));
@@ -294,11 +476,10 @@ _mesa_glsl_initialize_functions(struct _mesa_glsl_parse_state *state)
 
         print '   if (' + check + ') {'
         print '      _mesa_read_profile(state, %d,' % i
-        print '                         prototypes_for_' + profile + ','
-        print '                         functions_for_' + profile + ','
-        print '                         Elements(functions_for_' + profile + '));'
+        print '                         prototypes_for_' + profile + ');'
         print '   }'
         print
         i = i + 1
+    print '   _glthread_UNLOCK_MUTEX(builtin_mutex);'
     print '}'
 
@@ -1636,9 +1636,24 @@ _glcpp_parser_expand_node (glcpp_parser_t *parser,
 		if (macro->replacements == NULL)
 			return _token_list_create_with_one_space (parser);
 
-		replacement = _token_list_copy (parser, macro->replacements);
-		_glcpp_parser_apply_pastes (parser, replacement);
-		return replacement;
+		/* Pasting depends only on the replacement list, so do it
+		 * once per macro. A paste that raised an error is redone
+		 * each time so that every use is reported. */
+		if (macro->pasted == NULL) {
+			int error = parser->error;
+
+			parser->error = 0;
+			replacement = _token_list_copy (parser, macro->replacements);
+			_glcpp_parser_apply_pastes (parser, replacement);
+			if (parser->error)
+				return replacement;
+			parser->error = error;
+
+			macro->pasted = replacement;
+			ralloc_steal (macro, replacement);
+		}
+
+		return _token_list_copy (parser, macro->pasted);
 	}
 
 	return _glcpp_parser_expand_function (parser, node, last);
@@ -1834,6 +1849,7 @@ _define_object_macro (glcpp_parser_t *parser,
 	macro->parameters = NULL;
 	macro->identifier = ralloc_strdup (macro, identifier);
 	macro->replacements = replacements;
+	macro->pasted = NULL;
 	ralloc_steal (macro, replacements);
 
 	previous = hash_table_find (parser->defines, identifier);
@@ -1868,6 +1884,7 @@ _define_function_macro (glcpp_parser_t *parser,
 	macro->parameters = parameters;
 	macro->identifier = ralloc_strdup (macro, identifier);
 	macro->replacements = replacements;
+	macro->pasted = NULL;
 	previous = hash_table_find (parser->defines, identifier);
 	if (previous) {
 		if (_macro_equal (macro, previous)) {
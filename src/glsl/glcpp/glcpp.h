@@ -137,6 +137,9 @@ typedef struct {
 	string_list_t *parameters;
 	const char *identifier;
 	token_list_t *replacements;
+	/* Object-like macros only: the replacement list after pasting,
+	 * built on first use and copied for each later expansion. */
+	token_list_t *pasted;
 } macro_t;
 
 typedef struct expansion_node {
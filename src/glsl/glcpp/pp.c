@@ -134,12 +134,100 @@ remove_line_continuations(glcpp_parser_t *ctx, const char *shader)
 	return clean;
 }
 
+/* Returns false if the shader can be handed to the compiler without
+ * running the preprocessor: no directives, comments or line continuations,
+ * and no identifier that could name a macro (all the pre-defined macros
+ * start with "GL_" or "__", and user macros need a #define).
+ */
+static bool
+needs_preprocessing(const char *shader)
+{
+	const char *s;
+
+	for (s = shader; *s; s++) {
+		switch (*s) {
+		case '#':
+		case '\\':
+		case '\r':
+		case '\v':
+		case '\f':
+			return true;
+		case '/':
+			if (s[1] == '/' || s[1] == '*')
+				return true;
+			break;
+		case '_':
+			if (s[1] == '_')
+				return true;
+			break;
+		case 'G':
+			if (s[1] == 'L' && s[2] == '_')
+				return true;
+			break;
+		case 'd':
+			if (strncmp(s, "defined", 7) == 0)
+				return true;
+			break;
+		}
+	}
+
+	return false;
+}
+
+/* Produce the same output the preprocessor would for a shader that passed
+ * needs_preprocessing(): runs of blanks become a single space, trailing
+ * blanks are dropped from non-blank lines, and the end of input adds a
+ * final newline.
+ */
+static char *
+copy_without_preprocessing(void *ctx, const char *shader)
+{
+	char *out = ralloc_size(ctx, strlen(shader) + 2);
+	char *o = out;
+	const char *s = shader;
+
+	for (;;) {
+		bool blank = false, tokens = false;
+
+		while (*s && *s != '\n') {
+			if (*s == ' ' || *s == '\t') {
+				blank = true;
+				s++;
+				continue;
+			}
+			if (blank)
+				*o++ = ' ';
+			blank = false;
+			tokens = true;
+			*o++ = *s++;
+		}
+
+		if (blank && !tokens)
+			*o++ = ' ';
+		*o++ = '\n';
+
+		if (*s == '\0')
+			break;
+		s++;
+	}
+
+	*o = '\0';
+	return out;
+}
+
 int
 glcpp_preprocess(void *ralloc_ctx, const char **shader, char **info_log,
 	   const struct gl_extensions *extensions, struct gl_context *gl_ctx)
 {
 	int errors;
-	glcpp_parser_t *parser = glcpp_parser_create (extensions, gl_ctx->API);
+	glcpp_parser_t *parser;
+
+	if (! needs_preprocessing(*shader)) {
+		*shader = copy_without_preprocessing(ralloc_ctx, *shader);
+		return 0;
+	}
+
+	parser = glcpp_parser_create (extensions, gl_ctx->API);
 
 	if (! gl_ctx->Const.DisableGLSLLineContinuations)
 		*shader = remove_line_continuations(parser, *shader);
@@ -345,35 +345,35 @@ variable_identifier:
 primary_expression:
 	variable_identifier
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_expression(ast_identifier, NULL, NULL, NULL);
 	   $$->set_location(yylloc);
 	   $$->primary_expression.identifier = $1;
 	}
 	| INTCONSTANT
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_expression(ast_int_constant, NULL, NULL, NULL);
 	   $$->set_location(yylloc);
 	   $$->primary_expression.int_constant = $1;
 	}
 	| UINTCONSTANT
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_expression(ast_uint_constant, NULL, NULL, NULL);
 	   $$->set_location(yylloc);
 	   $$->primary_expression.uint_constant = $1;
 	}
 	| FLOATCONSTANT
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_expression(ast_float_constant, NULL, NULL, NULL);
 	   $$->set_location(yylloc);
 	   $$->primary_expression.float_constant = $1;
 	}
 	| BOOLCONSTANT
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_expression(ast_bool_constant, NULL, NULL, NULL);
 	   $$->set_location(yylloc);
 	   $$->primary_expression.bool_constant = $1;
@@ -388,7 +388,7 @@ postfix_expression:
 	primary_expression
 	| postfix_expression '[' integer_expression ']'
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_expression(ast_array_index, $1, $3, NULL);
 	   $$->set_location(yylloc);
 	}
@@ -398,20 +398,20 @@ postfix_expression:
 	}
 	| postfix_expression '.' any_identifier
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_expression(ast_field_selection, $1, NULL, NULL);
 	   $$->set_location(yylloc);
 	   $$->primary_expression.identifier = $3;
 	}
 	| postfix_expression INC_OP
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_expression(ast_post_inc, $1, NULL, NULL);
 	   $$->set_location(yylloc);
 	}
 	| postfix_expression DEC_OP
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_expression(ast_post_dec, $1, NULL, NULL);
 	   $$->set_location(yylloc);
 	}
@@ -429,7 +429,7 @@ function_call_or_method:
 	function_call_generic
 	| postfix_expression '.' method_call_generic
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_expression(ast_field_selection, $1, $3, NULL);
 	   $$->set_location(yylloc);
 	}
@@ -470,20 +470,20 @@ function_call_header:
 function_identifier:
 	type_specifier
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_function_expression($1);
 	   $$->set_location(yylloc);
    	}
 	| variable_identifier
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   ast_expression *callee = new(ctx) ast_expression($1);
 	   $$ = new(ctx) ast_function_expression(callee);
 	   $$->set_location(yylloc);
    	}
 	| FIELD_SELECTION
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   ast_expression *callee = new(ctx) ast_expression($1);
 	   $$ = new(ctx) ast_function_expression(callee);
 	   $$->set_location(yylloc);
@@ -521,7 +521,7 @@ method_call_header_with_parameters:
 method_call_header:
 	variable_identifier '('
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   ast_expression *callee = new(ctx) ast_expression($1);
 	   $$ = new(ctx) ast_function_expression(callee);
 	   $$->set_location(yylloc);
@@ -533,19 +533,19 @@ unary_expression:
 	postfix_expression
 	| INC_OP unary_expression
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_expression(ast_pre_inc, $2, NULL, NULL);
 	   $$->set_location(yylloc);
 	}
 	| DEC_OP unary_expression
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_expression(ast_pre_dec, $2, NULL, NULL);
 	   $$->set_location(yylloc);
 	}
 	| unary_operator unary_expression
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_expression($1, $2, NULL, NULL);
 	   $$->set_location(yylloc);
 	}
@@ -563,19 +563,19 @@ multiplicative_expression:
 	unary_expression
 	| multiplicative_expression '*' unary_expression
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_expression_bin(ast_mul, $1, $3);
 	   $$->set_location(yylloc);
 	}
 	| multiplicative_expression '/' unary_expression
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_expression_bin(ast_div, $1, $3);
 	   $$->set_location(yylloc);
 	}
 	| multiplicative_expression '%' unary_expression
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_expression_bin(ast_mod, $1, $3);
 	   $$->set_location(yylloc);
 	}
@@ -585,13 +585,13 @@ additive_expression:
 	multiplicative_expression
 	| additive_expression '+' multiplicative_expression
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_expression_bin(ast_add, $1, $3);
 	   $$->set_location(yylloc);
 	}
 	| additive_expression '-' multiplicative_expression
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_expression_bin(ast_sub, $1, $3);
 	   $$->set_location(yylloc);
 	}
@@ -601,13 +601,13 @@ shift_expression:
 	additive_expression
 	| shift_expression LEFT_OP additive_expression
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_expression_bin(ast_lshift, $1, $3);
 	   $$->set_location(yylloc);
 	}
 	| shift_expression RIGHT_OP additive_expression
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_expression_bin(ast_rshift, $1, $3);
 	   $$->set_location(yylloc);
 	}
@@ -617,25 +617,25 @@ relational_expression:
 	shift_expression
 	| relational_expression '<' shift_expression
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_expression_bin(ast_less, $1, $3);
 	   $$->set_location(yylloc);
 	}
 	| relational_expression '>' shift_expression
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_expression_bin(ast_greater, $1, $3);
 	   $$->set_location(yylloc);
 	}
 	| relational_expression LE_OP shift_expression
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_expression_bin(ast_lequal, $1, $3);
 	   $$->set_location(yylloc);
 	}
 	| relational_expression GE_OP shift_expression
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_expression_bin(ast_gequal, $1, $3);
 	   $$->set_location(yylloc);
 	}
@@ -645,13 +645,13 @@ equality_expression:
 	relational_expression
 	| equality_expression EQ_OP relational_expression
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_expression_bin(ast_equal, $1, $3);
 	   $$->set_location(yylloc);
 	}
 	| equality_expression NE_OP relational_expression
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_expression_bin(ast_nequal, $1, $3);
 	   $$->set_location(yylloc);
 	}
@@ -661,7 +661,7 @@ and_expression:
 	equality_expression
 	| and_expression '&' equality_expression
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_expression_bin(ast_bit_and, $1, $3);
 	   $$->set_location(yylloc);
 	}
@@ -671,7 +671,7 @@ exclusive_or_expression:
 	and_expression
 	| exclusive_or_expression '^' and_expression
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_expression_bin(ast_bit_xor, $1, $3);
 	   $$->set_location(yylloc);
 	}
@@ -681,7 +681,7 @@ inclusive_or_expression:
 	exclusive_or_expression
 	| inclusive_or_expression '|' exclusive_or_expression
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_expression_bin(ast_bit_or, $1, $3);
 	   $$->set_location(yylloc);
 	}
@@ -691,7 +691,7 @@ logical_and_expression:
 	inclusive_or_expression
 	| logical_and_expression AND_OP inclusive_or_expression
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_expression_bin(ast_logic_and, $1, $3);
 	   $$->set_location(yylloc);
 	}
@@ -701,7 +701,7 @@ logical_xor_expression:
 	logical_and_expression
 	| logical_xor_expression XOR_OP logical_and_expression
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_expression_bin(ast_logic_xor, $1, $3);
 	   $$->set_location(yylloc);
 	}
@@ -711,7 +711,7 @@ logical_or_expression:
 	logical_xor_expression
 	| logical_or_expression OR_OP logical_xor_expression
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_expression_bin(ast_logic_or, $1, $3);
 	   $$->set_location(yylloc);
 	}
@@ -721,7 +721,7 @@ conditional_expression:
 	logical_or_expression
 	| logical_or_expression '?' expression ':' assignment_expression
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_expression(ast_conditional, $1, $3, $5);
 	   $$->set_location(yylloc);
 	}
@@ -731,7 +731,7 @@ assignment_expression:
 	conditional_expression
 	| unary_expression assignment_operator assignment_expression
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_expression($2, $1, $3, NULL);
 	   $$->set_location(yylloc);
 	}
@@ -758,7 +758,7 @@ expression:
 	}
 	| expression ',' assignment_expression
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   if ($1->oper != ast_sequence) {
 	      $$ = new(ctx) ast_expression(ast_sequence, NULL, NULL, NULL);
 	      $$->set_location(yylloc);
@@ -822,7 +822,7 @@ function_header_with_parameters:
 function_header:
 	fully_specified_type variable_identifier '('
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_function();
 	   $$->set_location(yylloc);
 	   $$->return_type = $1;
@@ -836,7 +836,7 @@ function_header:
 parameter_declarator:
 	type_specifier any_identifier
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_parameter_declarator();
 	   $$->set_location(yylloc);
 	   $$->type = new(ctx) ast_fully_specified_type();
@@ -846,7 +846,7 @@ parameter_declarator:
 	}
 	| type_specifier any_identifier '[' constant_expression ']'
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_parameter_declarator();
 	   $$->set_location(yylloc);
 	   $$->type = new(ctx) ast_fully_specified_type();
@@ -873,7 +873,7 @@ parameter_declaration:
 	}
 	| parameter_type_qualifier parameter_qualifier parameter_type_specifier
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $1.flags.i |= $2.flags.i;
 
 	   $$ = new(ctx) ast_parameter_declarator();
@@ -884,7 +884,7 @@ parameter_declaration:
 	}
 	| parameter_qualifier parameter_type_specifier
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_parameter_declarator();
 	   $$->set_location(yylloc);
 	   $$->type = new(ctx) ast_fully_specified_type();
@@ -924,7 +924,7 @@ init_declarator_list:
 	single_declaration
 	| init_declarator_list ',' any_identifier
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   ast_declaration *decl = new(ctx) ast_declaration($3, false, NULL, NULL);
 	   decl->set_location(yylloc);
 
@@ -934,7 +934,7 @@ init_declarator_list:
 	}
 	| init_declarator_list ',' any_identifier '[' ']'
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   ast_declaration *decl = new(ctx) ast_declaration($3, true, NULL, NULL);
 	   decl->set_location(yylloc);
 
@@ -944,7 +944,7 @@ init_declarator_list:
 	}
 	| init_declarator_list ',' any_identifier '[' constant_expression ']'
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   ast_declaration *decl = new(ctx) ast_declaration($3, true, $5, NULL);
 	   decl->set_location(yylloc);
 
@@ -954,7 +954,7 @@ init_declarator_list:
 	}
 	| init_declarator_list ',' any_identifier '[' ']' '=' initializer
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   ast_declaration *decl = new(ctx) ast_declaration($3, true, NULL, $7);
 	   decl->set_location(yylloc);
 
@@ -964,7 +964,7 @@ init_declarator_list:
 	}
 	| init_declarator_list ',' any_identifier '[' constant_expression ']' '=' initializer
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   ast_declaration *decl = new(ctx) ast_declaration($3, true, $5, $8);
 	   decl->set_location(yylloc);
 
@@ -974,7 +974,7 @@ init_declarator_list:
 	}
 	| init_declarator_list ',' any_identifier '=' initializer
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   ast_declaration *decl = new(ctx) ast_declaration($3, false, NULL, $5);
 	   decl->set_location(yylloc);
 
@@ -988,14 +988,14 @@ init_declarator_list:
 single_declaration:
 	fully_specified_type
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   /* Empty declaration list is valid. */
 	   $$ = new(ctx) ast_declarator_list($1);
 	   $$->set_location(yylloc);
 	}
 	| fully_specified_type any_identifier
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   ast_declaration *decl = new(ctx) ast_declaration($2, false, NULL, NULL);
 
 	   $$ = new(ctx) ast_declarator_list($1);
@@ -1004,7 +1004,7 @@ single_declaration:
 	}
 	| fully_specified_type any_identifier '[' ']'
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   ast_declaration *decl = new(ctx) ast_declaration($2, true, NULL, NULL);
 
 	   $$ = new(ctx) ast_declarator_list($1);
@@ -1013,7 +1013,7 @@ single_declaration:
 	}
 	| fully_specified_type any_identifier '[' constant_expression ']'
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   ast_declaration *decl = new(ctx) ast_declaration($2, true, $4, NULL);
 
 	   $$ = new(ctx) ast_declarator_list($1);
@@ -1022,7 +1022,7 @@ single_declaration:
 	}
 	| fully_specified_type any_identifier '[' ']' '=' initializer
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   ast_declaration *decl = new(ctx) ast_declaration($2, true, NULL, $6);
 
 	   $$ = new(ctx) ast_declarator_list($1);
@@ -1031,7 +1031,7 @@ single_declaration:
 	}
 	| fully_specified_type any_identifier '[' constant_expression ']' '=' initializer
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   ast_declaration *decl = new(ctx) ast_declaration($2, true, $4, $7);
 
 	   $$ = new(ctx) ast_declarator_list($1);
@@ -1040,7 +1040,7 @@ single_declaration:
 	}
 	| fully_specified_type any_identifier '=' initializer
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   ast_declaration *decl = new(ctx) ast_declaration($2, false, NULL, $4);
 
 	   $$ = new(ctx) ast_declarator_list($1);
@@ -1049,7 +1049,7 @@ single_declaration:
 	}
 	| INVARIANT variable_identifier // Vertex only.
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   ast_declaration *decl = new(ctx) ast_declaration($2, false, NULL, NULL);
 
 	   $$ = new(ctx) ast_declarator_list(NULL);
@@ -1063,14 +1063,14 @@ single_declaration:
 fully_specified_type:
 	type_specifier
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_fully_specified_type();
 	   $$->set_location(yylloc);
 	   $$->specifier = $1;
 	}
 	| type_qualifier type_specifier
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_fully_specified_type();
 	   $$->set_location(yylloc);
 	   $$->qualifier = $1;
@@ -1390,19 +1390,19 @@ type_specifier_no_prec:
 type_specifier_nonarray:
 	basic_type_specifier_nonarray
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_type_specifier($1);
 	   $$->set_location(yylloc);
 	}
 	| struct_specifier
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_type_specifier($1);
 	   $$->set_location(yylloc);
 	}
 	| TYPE_IDENTIFIER
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_type_specifier($1);
 	   $$->set_location(yylloc);
 	}
@@ -1499,14 +1499,14 @@ precision_qualifier:
 struct_specifier:
 	STRUCT any_identifier '{' struct_declaration_list '}'
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_struct_specifier($2, $4);
 	   $$->set_location(yylloc);
 	   state->symbols->add_type($2, glsl_type::void_type);
 	}
 	| STRUCT '{' struct_declaration_list '}'
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_struct_specifier(NULL, $3);
 	   $$->set_location(yylloc);
 	}
@@ -1528,7 +1528,7 @@ struct_declaration_list:
 struct_declaration:
 	type_specifier struct_declarator_list ';'
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   ast_fully_specified_type *type = new(ctx) ast_fully_specified_type();
 	   type->set_location(yylloc);
 
@@ -1556,13 +1556,13 @@ struct_declarator_list:
 struct_declarator:
 	any_identifier
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_declaration($1, false, NULL, NULL);
 	   $$->set_location(yylloc);
 	}
 	| any_identifier '[' constant_expression ']'
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_declaration($1, true, $3, NULL);
 	   $$->set_location(yylloc);
 	}
@@ -1595,7 +1595,7 @@ simple_statement:
 compound_statement:
 	'{' '}'
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_compound_statement(true, NULL);
 	   $$->set_location(yylloc);
 	}
@@ -1605,7 +1605,7 @@ compound_statement:
 	}
 	statement_list '}'
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_compound_statement(true, $3);
 	   $$->set_location(yylloc);
 	   state->symbols->pop_scope();
@@ -1620,13 +1620,13 @@ statement_no_new_scope:
 compound_statement_no_new_scope:
 	'{' '}'
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_compound_statement(false, NULL);
 	   $$->set_location(yylloc);
 	}
 	| '{' statement_list '}'
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_compound_statement(false, $2);
 	   $$->set_location(yylloc);
 	}
@@ -1657,13 +1657,13 @@ statement_list:
 expression_statement:
 	';'
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_expression_statement(NULL);
 	   $$->set_location(yylloc);
 	}
 	| expression ';'
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_expression_statement($1);
 	   $$->set_location(yylloc);
 	}
@@ -1672,8 +1672,8 @@ expression_statement:
 selection_statement:
 	IF '(' expression ')' selection_rest_statement
 	{
-	   $$ = new(state) ast_selection_statement($3, $5.then_statement,
-						   $5.else_statement);
+	   $$ = new(state->linalloc) ast_selection_statement($3, $5.then_statement,
+							     $5.else_statement);
 	   $$->set_location(yylloc);
 	}
 	;
@@ -1698,7 +1698,7 @@ condition:
 	}
 	| fully_specified_type any_identifier '=' initializer
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   ast_declaration *decl = new(ctx) ast_declaration($2, false, NULL, $4);
 	   ast_declarator_list *declarator = new(ctx) ast_declarator_list($1);
 	   decl->set_location(yylloc);
@@ -1716,7 +1716,7 @@ condition:
 switch_statement:
 	SWITCH '(' expression ')' switch_body
 	{
-	   $$ = new(state) ast_switch_statement($3, $5);
+	   $$ = new(state->linalloc) ast_switch_statement($3, $5);
 	   $$->set_location(yylloc);
 	}
 	;
@@ -1724,12 +1724,12 @@ switch_statement:
 switch_body:
 	'{' '}'
 	{
-	   $$ = new(state) ast_switch_body(NULL);
+	   $$ = new(state->linalloc) ast_switch_body(NULL);
 	   $$->set_location(yylloc);
 	}
 	| '{' case_statement_list '}'
 	{
-	   $$ = new(state) ast_switch_body($2);
+	   $$ = new(state->linalloc) ast_switch_body($2);
 	   $$->set_location(yylloc);
 	}
 	;
@@ -1737,12 +1737,12 @@ switch_body:
 case_label:
 	CASE expression ':'
 	{
-	   $$ = new(state) ast_case_label($2);
+	   $$ = new(state->linalloc) ast_case_label($2);
 	   $$->set_location(yylloc);
 	}
 	| DEFAULT ':'
 	{
-	   $$ = new(state) ast_case_label(NULL);
+	   $$ = new(state->linalloc) ast_case_label(NULL);
 	   $$->set_location(yylloc);
 	}
 	;
@@ -1750,7 +1750,7 @@ case_label:
 case_label_list:
 	case_label
 	{
-	   ast_case_label_list *labels = new(state) ast_case_label_list();
+	   ast_case_label_list *labels = new(state->linalloc) ast_case_label_list();
 
 	   labels->labels.push_tail(& $1->link);
 	   $$ = labels;
@@ -1766,7 +1766,7 @@ case_label_list:
 case_statement:
 	case_label_list statement
 	{
-	   ast_case_statement *stmts = new(state) ast_case_statement($1);
+	   ast_case_statement *stmts = new(state->linalloc) ast_case_statement($1);
 	   stmts->set_location(yylloc);
 
 	   stmts->stmts.push_tail(& $2->link);
@@ -1782,7 +1782,7 @@ case_statement:
 case_statement_list:
 	case_statement
 	{
-	   ast_case_statement_list *cases= new(state) ast_case_statement_list();
+	   ast_case_statement_list *cases= new(state->linalloc) ast_case_statement_list();
 	   cases->set_location(yylloc);
 
 	   cases->cases.push_tail(& $1->link);
@@ -1798,21 +1798,21 @@ case_statement_list:
 iteration_statement:
 	WHILE '(' condition ')' statement_no_new_scope
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_iteration_statement(ast_iteration_statement::ast_while,
 	   					    NULL, $3, NULL, $5);
 	   $$->set_location(yylloc);
 	}
 	| DO statement WHILE '(' expression ')' ';'
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_iteration_statement(ast_iteration_statement::ast_do_while,
 						    NULL, $5, NULL, $2);
 	   $$->set_location(yylloc);
 	}
 	| FOR '(' for_init_statement for_rest_statement ')' statement_no_new_scope
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_iteration_statement(ast_iteration_statement::ast_for,
 						    $3, $4.cond, $4.rest, $6);
 	   $$->set_location(yylloc);
@@ -1849,31 +1849,31 @@ for_rest_statement:
 jump_statement:
 	CONTINUE ';' 
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_jump_statement(ast_jump_statement::ast_continue, NULL);
 	   $$->set_location(yylloc);
 	}
 	| BREAK ';'
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_jump_statement(ast_jump_statement::ast_break, NULL);
 	   $$->set_location(yylloc);
 	}
 	| RETURN ';'
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_jump_statement(ast_jump_statement::ast_return, NULL);
 	   $$->set_location(yylloc);
 	}
 	| RETURN expression ';'
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_jump_statement(ast_jump_statement::ast_return, $2);
 	   $$->set_location(yylloc);
 	}
 	| DISCARD ';' // Fragment shader only.
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_jump_statement(ast_jump_statement::ast_discard, NULL);
 	   $$->set_location(yylloc);
 	}
@@ -1889,7 +1889,7 @@ external_declaration:
 function_definition:
 	function_prototype compound_statement_no_new_scope
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   $$ = new(ctx) ast_function_definition();
 	   $$->set_location(yylloc);
 	   $$->prototype = $1;
@@ -2033,30 +2033,30 @@ interface_qualifier:
 instance_name_opt:
 	/* empty */
 	{
-	   $$ = new(state) ast_interface_block(*state->default_uniform_qualifier,
-					     NULL,
-					     NULL);
+	   $$ = new(state->linalloc) ast_interface_block(*state->default_uniform_qualifier,
+						       NULL,
+						       NULL);
 	}
 	| NEW_IDENTIFIER
 	{
-	   $$ = new(state) ast_interface_block(*state->default_uniform_qualifier,
-					     $1,
-					     NULL);
+	   $$ = new(state->linalloc) ast_interface_block(*state->default_uniform_qualifier,
+						       $1,
+						       NULL);
 	}
 	| NEW_IDENTIFIER '[' constant_expression ']'
 	{
-	   $$ = new(state) ast_interface_block(*state->default_uniform_qualifier,
-					     $1,
-					     $3);
+	   $$ = new(state->linalloc) ast_interface_block(*state->default_uniform_qualifier,
+						       $1,
+						       $3);
 	}
 	| NEW_IDENTIFIER '[' ']'
 	{
 	   _mesa_glsl_error(& @1, state,
 			    "instance block arrays must be explicitly sized\n");
 
-	   $$ = new(state) ast_interface_block(*state->default_uniform_qualifier,
-					     $1,
-					     NULL);
+	   $$ = new(state->linalloc) ast_interface_block(*state->default_uniform_qualifier,
+						       $1,
+						       NULL);
 	}
 	;
 
@@ -2076,7 +2076,7 @@ member_list:
 member_declaration:
 	fully_specified_type struct_declarator_list ';'
 	{
-	   void *ctx = state;
+	   void *ctx = state->linalloc;
 	   ast_fully_specified_type *type = $1;
 	   type->set_location(yylloc);
 
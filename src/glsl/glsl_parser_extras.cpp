@@ -37,6 +37,8 @@ extern "C" {
 #include "glsl_parser.h"
 #include "ir_optimization.h"
 #include "loop_analysis.h"
+#include "shader_cache.h"
+#include "pass_stats.h"
 
 /**
  * Format a short human-readable description of the given GLSL version.
@@ -64,6 +66,7 @@ _mesa_glsl_parse_state::_mesa_glsl_parse_state(struct gl_context *_ctx,
    }
 
    this->scanner = NULL;
+   this->linalloc = linear_alloc_context(this);
    this->translation_unit.make_empty();
    this->symbols = new(mem_ctx) glsl_symbol_table;
    this->info_log = ralloc_strdup(mem_ctx, "");
@@ -155,7 +158,7 @@ _mesa_glsl_parse_state::_mesa_glsl_parse_state(struct gl_context *_ctx,
    if (ctx->Const.ForceGLSLExtensionsWarn)
       _mesa_glsl_process_extension("all", NULL, "warn", NULL, this);
 
-   this->default_uniform_qualifier = new(this) ast_type_qualifier();
+   this->default_uniform_qualifier = new(this->linalloc) ast_type_qualifier();
    this->default_uniform_qualifier->flags.q.shared = 1;
    this->default_uniform_qualifier->flags.q.column_major = 1;
 }
@@ -1238,23 +1241,53 @@ ast_struct_specifier::ast_struct_specifier(const char *identifier,
    this->declarations.push_degenerate_list_at_head(&declarator_list->link);
 }
 
+/** Last value handed out for gl_shader::CompileSerial */
+static unsigned compile_serial = 0;
+_glthread_DECLARE_STATIC_MUTEX(compile_serial_mutex);
+
+static void
+assign_compile_serial(struct gl_shader *shader)
+{
+   _glthread_LOCK_MUTEX(compile_serial_mutex);
+   if (++compile_serial == 0)
+      compile_serial = 1;
+   shader->CompileSerial = compile_serial;
+   _glthread_UNLOCK_MUTEX(compile_serial_mutex);
+}
+
 extern "C" {
 
 void
 _mesa_glsl_compile_shader(struct gl_context *ctx, struct gl_shader *shader,
                           bool dump_ast, bool dump_hir)
 {
+   const bool use_cache = !dump_ast && !dump_hir;
+
+   assign_compile_serial(shader);
+
+   if (use_cache && shader_cache_lookup(ctx, shader))
+      return;
+
+   const bool collect_stats = glsl_pass_stats_begin(ctx, "compile");
+   struct glsl_pass_stats *const stats =
+      ctx->ShaderCompilerOptions[_mesa_shader_type_to_index(shader->Type)].PassStats;
+   exec_list no_ir;
+
    struct _mesa_glsl_parse_state *state =
       new(shader) _mesa_glsl_parse_state(ctx, shader->Type, shader);
    const char *source = shader->Source;
 
+   glsl_pass_timer preprocess_timer(stats, "preprocess", &no_ir);
    state->error = glcpp_preprocess(state, &source, &state->info_log,
                              &ctx->Extensions, ctx);
+   preprocess_timer.done(!state->error);
 
    if (!state->error) {
+     glsl_pass_timer parse_timer(stats, "parse", &no_ir);
      _mesa_glsl_lexer_ctor(state, source);
      _mesa_glsl_parse(state);
      _mesa_glsl_lexer_dtor(state);
+     parse_timer.done(!state->error);
    }
 
    if (dump_ast) {
@@ -1267,8 +1300,11 @@ _mesa_glsl_compile_shader(struct gl_context *ctx, struct gl_shader *shader,
 
    ralloc_free(shader->ir);
    shader->ir = new(shader) exec_list;
-   if (!state->error && !state->translation_unit.is_empty())
+   if (!state->error && !state->translation_unit.is_empty()) {
+      glsl_pass_timer hir_timer(stats, "ast_to_hir", shader->ir);
       _mesa_ast_to_hir(shader->ir, state);
+      hir_timer.done(!state->error);
+   }
 
    if (!state->error) {
       validate_ir_tree(shader->ir);
@@ -1287,8 +1323,7 @@ _mesa_glsl_compile_shader(struct gl_context *ctx, struct gl_shader *shader,
       /* Do some optimization at compile time to reduce shader IR size
        * and reduce later work if the same shader is linked multiple times
        */
-      while (do_common_optimization(shader->ir, false, false, 32, options))
-         ;
+      do_common_optimization_loop(shader->ir, false, false, 32, options);
 
       validate_ir_tree(shader->ir);
    }
@@ -1317,9 +1352,213 @@ _mesa_glsl_compile_shader(struct gl_context *ctx, struct gl_shader *shader,
    reparent_ir(shader->ir, shader->ir);
 
    ralloc_free(state);
+
+   if (collect_stats)
+      glsl_pass_stats_end(ctx);
+
+   if (use_cache)
+      shader_cache_insert(ctx, shader);
 }
 
 } /* extern "C" */
+
+/**
+ * The passes of do_common_optimization(), in the order they are run.
+ */
+enum common_optimization_pass {
+   PASS_LOWER_SUB,
+   PASS_FUNCTION_INLINING,
+   PASS_DEAD_FUNCTIONS,
+   PASS_STRUCTURE_SPLITTING,
+   PASS_IF_SIMPLIFICATION,
+   PASS_FLATTEN_NESTED_IF_BLOCKS,
+   PASS_COPY_PROPAGATION,
+   PASS_COPY_PROPAGATION_ELEMENTS,
+   PASS_FLIP_MATRICES,
+   PASS_DEAD_CODE,
+   PASS_DEAD_CODE_LOCAL,
+   PASS_TREE_GRAFTING,
+   PASS_CONSTANT_PROPAGATION,
+   PASS_CONSTANT_VARIABLE,
+   PASS_CONSTANT_FOLDING,
+   PASS_ALGEBRAIC,
+   PASS_LOWER_JUMPS,
+   PASS_VEC_INDEX_TO_SWIZZLE,
+   PASS_LOWER_VECTOR_INSERT,
+   PASS_SWIZZLE_SWIZZLE,
+   PASS_NOOP_SWIZZLE,
+   PASS_SPLIT_ARRAYS,
+   PASS_REDUNDANT_JUMPS,
+   PASS_LOOPS,
+   NUM_COMMON_OPTIMIZATION_PASSES
+};
+
+
+/** Names of the passes above, as reported by MESA_GLSL=stats */
+static const char *const common_pass_names[NUM_COMMON_OPTIMIZATION_PASSES] = {
+   "lower_sub",
+   "function_inlining",
+   "dead_functions",
+   "structure_splitting",
+   "if_simplification",
+   "flatten_nested_if_blocks",
+   "copy_propagation",
+   "copy_propagation_elements",
+   "flip_matrices",
+   "dead_code",
+   "dead_code_local",
+   "tree_grafting",
+   "constant_propagation",
+   "constant_variable",
+   "constant_folding",
+   "algebraic",
+   "lower_jumps",
+   "vec_index_to_swizzle",
+   "lower_vector_insert",
+   "swizzle_swizzle",
+   "noop_swizzle",
+   "split_arrays",
+   "redundant_jumps",
+   "loops",
+};
+
+
+/**
+ * Whether a pass of do_common_optimization() applies to this kind of IR.
+ */
+static bool
+common_pass_enabled(enum common_optimization_pass pass, bool linked,
+                    const struct gl_shader_compiler_options *options)
+{
+   switch (pass) {
+   case PASS_FUNCTION_INLINING:
+   case PASS_DEAD_FUNCTIONS:
+   case PASS_STRUCTURE_SPLITTING:
+      return linked;
+   case PASS_FLIP_MATRICES:
+      return options->PreferDP4 && !linked;
+   default:
+      return true;
+   }
+}
+
+
+/**
+ * Run a single pass of do_common_optimization().
+ *
+ * \param may_have_loops  If not NULL, whether \c ir may contain loops.
+ *                        The loop pass is skipped while this is false and
+ *                        clears it when its analysis finds no loop; only
+ *                        function inlining can add a loop back, and sets
+ *                        it again when it makes progress.
+ * \return  true if the pass made progress
+ */
+static bool
+run_common_pass(enum common_optimization_pass pass, exec_list *ir,
+                bool linked, bool uniform_locations_assigned,
+                unsigned max_unroll_iterations,
+                const struct gl_shader_compiler_options *options,
+                bool *may_have_loops)
+{
+   switch (pass) {
+   case PASS_LOWER_SUB:
+      return lower_instructions(ir, SUB_TO_ADD_NEG);
+   case PASS_FUNCTION_INLINING:
+      if (!do_function_inlining(ir))
+         return false;
+      if (may_have_loops)
+         *may_have_loops = true;
+      return true;
+   case PASS_DEAD_FUNCTIONS:
+      return do_dead_functions(ir);
+   case PASS_STRUCTURE_SPLITTING:
+      return do_structure_splitting(ir);
+   case PASS_IF_SIMPLIFICATION:
+      return do_if_simplification(ir);
+   case PASS_FLATTEN_NESTED_IF_BLOCKS:
+      return opt_flatten_nested_if_blocks(ir);
+   case PASS_COPY_PROPAGATION:
+      return do_copy_propagation(ir);
+   case PASS_COPY_PROPAGATION_ELEMENTS:
+      return do_copy_propagation_elements(ir);
+   case PASS_FLIP_MATRICES:
+      return opt_flip_matrices(ir);
+   case PASS_DEAD_CODE:
+      if (linked)
+         return do_dead_code(ir, uniform_locations_assigned);
+      else
+         return do_dead_code_unlinked(ir);
+   case PASS_DEAD_CODE_LOCAL:
+      return do_dead_code_local(ir);
+   case PASS_TREE_GRAFTING:
+      return do_tree_grafting(ir);
+   case PASS_CONSTANT_PROPAGATION:
+      return do_constant_propagation(ir);
+   case PASS_CONSTANT_VARIABLE:
+      if (linked)
+         return do_constant_variable(ir);
+      else
+         return do_constant_variable_unlinked(ir);
+   case PASS_CONSTANT_FOLDING:
+      return do_constant_folding(ir);
+   case PASS_ALGEBRAIC:
+      return do_algebraic(ir);
+   case PASS_LOWER_JUMPS:
+      return do_lower_jumps(ir);
+   case PASS_VEC_INDEX_TO_SWIZZLE:
+      return do_vec_index_to_swizzle(ir);
+   case PASS_LOWER_VECTOR_INSERT:
+      return lower_vector_insert(ir, false);
+   case PASS_SWIZZLE_SWIZZLE:
+      return do_swizzle_swizzle(ir);
+   case PASS_NOOP_SWIZZLE:
+      return do_noop_swizzle(ir);
+   case PASS_SPLIT_ARRAYS:
+      return optimize_split_arrays(ir, linked);
+   case PASS_REDUNDANT_JUMPS:
+      return optimize_redundant_jumps(ir);
+   case PASS_LOOPS: {
+      if (may_have_loops && !*may_have_loops)
+         return false;
+
+      bool progress = false;
+      loop_state *ls = analyze_loop_variables(ir);
+      if (ls->loop_found) {
+         progress = set_loop_controls(ir, ls) || progress;
+         progress = unroll_loops(ir, ls, max_unroll_iterations, options)
+            || progress;
+      } else if (may_have_loops) {
+         *may_have_loops = false;
+      }
+      delete ls;
+      return progress;
+   }
+   default:
+      assert(0);
+      return false;
+   }
+}
+
+
+/**
+ * run_common_pass(), timed when statistics are being collected.
+ */
+static bool
+run_timed_common_pass(enum common_optimization_pass pass, exec_list *ir,
+                      bool linked, bool uniform_locations_assigned,
+                      unsigned max_unroll_iterations,
+                      const struct gl_shader_compiler_options *options,
+                      bool *may_have_loops)
+{
+   glsl_pass_timer timer(options->PassStats, common_pass_names[pass], ir);
+
+   return timer.done(run_common_pass(pass, ir, linked,
+                                     uniform_locations_assigned,
+                                     max_unroll_iterations, options,
+                                     may_have_loops));
+}
+
+
 /**
  * Do the set of common optimizations passes
  *
@@ -1345,52 +1584,69 @@ do_common_optimization(exec_list *ir, bool linked,
                        const struct gl_shader_compiler_options *options)
 {
    GLboolean progress = GL_FALSE;
+   unsigned i;
 
-   progress = lower_instructions(ir, SUB_TO_ADD_NEG) || progress;
+   for (i = 0; i < NUM_COMMON_OPTIMIZATION_PASSES; i++) {
+      enum common_optimization_pass pass = (enum common_optimization_pass) i;
 
-   if (linked) {
-      progress = do_function_inlining(ir) || progress;
-      progress = do_dead_functions(ir) || progress;
-      progress = do_structure_splitting(ir) || progress;
+      if (common_pass_enabled(pass, linked, options))
+         progress = run_timed_common_pass(pass, ir, linked,
+                                          uniform_locations_assigned,
+                                          max_unroll_iterations,
+                                          options, NULL) || progress;
    }
-   progress = do_if_simplification(ir) || progress;
-   progress = opt_flatten_nested_if_blocks(ir) || progress;
-   progress = do_copy_propagation(ir) || progress;
-   progress = do_copy_propagation_elements(ir) || progress;
 
-   if (options->PreferDP4 && !linked)
-      progress = opt_flip_matrices(ir) || progress;
+   return progress;
+}
 
-   if (linked)
-      progress = do_dead_code(ir, uniform_locations_assigned) || progress;
-   else
-      progress = do_dead_code_unlinked(ir) || progress;
-   progress = do_dead_code_local(ir) || progress;
-   progress = do_tree_grafting(ir) || progress;
-   progress = do_constant_propagation(ir) || progress;
-   if (linked)
-      progress = do_constant_variable(ir) || progress;
-   else
-      progress = do_constant_variable_unlinked(ir) || progress;
-   progress = do_constant_folding(ir) || progress;
-   progress = do_algebraic(ir) || progress;
-   progress = do_lower_jumps(ir) || progress;
-   progress = do_vec_index_to_swizzle(ir) || progress;
-   progress = lower_vector_insert(ir, false) || progress;
-   progress = do_swizzle_swizzle(ir) || progress;
-   progress = do_noop_swizzle(ir) || progress;
-
-   progress = optimize_split_arrays(ir, linked) || progress;
-   progress = optimize_redundant_jumps(ir) || progress;
-
-   loop_state *ls = analyze_loop_variables(ir);
-   if (ls->loop_found) {
-      progress = set_loop_controls(ir, ls) || progress;
-      progress = unroll_loops(ir, ls, max_unroll_iterations) || progress;
+
+/**
+ * Run the passes of do_common_optimization() until none of them makes
+ * progress.
+ *
+ * This runs the same passes in the same order as calling
+ * do_common_optimization() until it returns false, and so gives the same
+ * result, but it stops as soon as every pass has looked at the IR since
+ * the last change to it, instead of finishing the current round and then
+ * running one more round in which nothing happens.  A pass that found
+ * nothing to do is not run again until another pass changes the IR.  Once
+ * the loop analysis has found no loop at all, it is not repeated until
+ * function inlining, the only pass that can bring a loop in, makes
+ * progress.
+ *
+ * Parameters are as for do_common_optimization().
+ */
+void
+do_common_optimization_loop(exec_list *ir, bool linked,
+                            bool uniform_locations_assigned,
+                            unsigned max_unroll_iterations,
+                            const struct gl_shader_compiler_options *options)
+{
+   enum common_optimization_pass passes[NUM_COMMON_OPTIMIZATION_PASSES];
+   unsigned num_passes = 0;
+   unsigned idle = 0;
+   bool may_have_loops = true;
+   unsigned i;
+
+   for (i = 0; i < NUM_COMMON_OPTIMIZATION_PASSES; i++) {
+      enum common_optimization_pass pass = (enum common_optimization_pass) i;
+
+      if (common_pass_enabled(pass, linked, options))
+         passes[num_passes++] = pass;
    }
-   delete ls;
 
-   return progress;
+   /* Number of passes in a row which made no progress: once all of them
+    * did, all of them have seen the current IR.
+    */
+   for (i = 0; idle < num_passes; i = (i + 1) % num_passes) {
+      if (run_timed_common_pass(passes[i], ir, linked,
+                                uniform_locations_assigned,
+                                max_unroll_iterations, options,
+                                &may_have_loops))
+         idle = 0;
+      else
+         idle++;
+   }
 }
 
 extern "C" {
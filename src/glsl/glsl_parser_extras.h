@@ -141,6 +141,10 @@ struct _mesa_glsl_parse_state {
 
    struct gl_context *const ctx;
    void *scanner;
+
+   /** Linear context the AST and the lexer's strings are allocated from */
+   void *linalloc;
+
    exec_list translation_unit;
    glsl_symbol_table *symbols;
 
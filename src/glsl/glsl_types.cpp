@@ -31,6 +31,14 @@ extern "C" {
 #include "program/hash_table.h"
 }
 
+/**
+ * Serializes the creation of types, which share mem_ctx and the type
+ * caches below, so that several contexts can compile shaders at once.  The
+ * built-in types are created at static initialization time and need no
+ * locking.
+ */
+_glthread_DECLARE_STATIC_MUTEX(glsl_type_mutex);
+
 hash_table *glsl_type::array_types = NULL;
 hash_table *glsl_type::record_types = NULL;
 hash_table *glsl_type::interface_types = NULL;
@@ -239,6 +247,8 @@ const glsl_type *glsl_type::get_scalar_type() const
 void
 _mesa_glsl_release_types(void)
 {
+   _glthread_LOCK_MUTEX(glsl_type_mutex);
+
    if (glsl_type::array_types != NULL) {
       hash_table_dtor(glsl_type::array_types);
       glsl_type::array_types = NULL;
@@ -248,6 +258,8 @@ _mesa_glsl_release_types(void)
       hash_table_dtor(glsl_type::record_types);
       glsl_type::record_types = NULL;
    }
+
+   _glthread_UNLOCK_MUTEX(glsl_type_mutex);
 }
 
 
@@ -394,12 +406,6 @@ glsl_type::get_instance(unsigned base_type, unsigned rows, unsigned columns)
 const glsl_type *
 glsl_type::get_array_instance(const glsl_type *base, unsigned array_size)
 {
-
-   if (array_types == NULL) {
-      array_types = hash_table_ctor(64, hash_table_string_hash,
-				    hash_table_string_compare);
-   }
-
    /* Generate a name using the base type pointer in the key.  This is
     * done because the name of the base type may not be unique across
     * shaders.  For example, two shaders may have different record types
@@ -408,6 +414,13 @@ glsl_type::get_array_instance(const glsl_type *base, unsigned array_size)
    char key[128];
    snprintf(key, sizeof(key), "%p[%u]", (void *) base, array_size);
 
+   _glthread_LOCK_MUTEX(glsl_type_mutex);
+
+   if (array_types == NULL) {
+      array_types = hash_table_ctor(64, hash_table_string_hash,
+				    hash_table_string_compare);
+   }
+
    const glsl_type *t = (glsl_type *) hash_table_find(array_types, key);
    if (t == NULL) {
       t = new glsl_type(base, array_size);
@@ -415,6 +428,8 @@ glsl_type::get_array_instance(const glsl_type *base, unsigned array_size)
       hash_table_insert(array_types, (void *) t, ralloc_strdup(mem_ctx, key));
    }
 
+   _glthread_UNLOCK_MUTEX(glsl_type_mutex);
+
    assert(t->base_type == GLSL_TYPE_ARRAY);
    assert(t->length == array_size);
    assert(t->fields.array == base);
@@ -482,19 +497,28 @@ glsl_type::get_record_instance(const glsl_struct_field *fields,
 			       unsigned num_fields,
 			       const char *name)
 {
-   const glsl_type key(fields, num_fields, name);
+   const glsl_type *t;
 
-   if (record_types == NULL) {
-      record_types = hash_table_ctor(64, record_key_hash, record_key_compare);
-   }
+   _glthread_LOCK_MUTEX(glsl_type_mutex);
 
-   const glsl_type *t = (glsl_type *) hash_table_find(record_types, & key);
-   if (t == NULL) {
-      t = new glsl_type(fields, num_fields, name);
+   /* The key's constructor allocates out of mem_ctx too */
+   {
+      const glsl_type key(fields, num_fields, name);
+
+      if (record_types == NULL) {
+         record_types = hash_table_ctor(64, record_key_hash, record_key_compare);
+      }
+
+      t = (glsl_type *) hash_table_find(record_types, & key);
+      if (t == NULL) {
+         t = new glsl_type(fields, num_fields, name);
 
-      hash_table_insert(record_types, (void *) t, t);
+         hash_table_insert(record_types, (void *) t, t);
+      }
    }
 
+   _glthread_UNLOCK_MUTEX(glsl_type_mutex);
+
    assert(t->base_type == GLSL_TYPE_STRUCT);
    assert(t->length == num_fields);
    assert(strcmp(t->name, name) == 0);
@@ -509,19 +533,29 @@ glsl_type::get_interface_instance(const glsl_struct_field *fields,
 				  enum glsl_interface_packing packing,
 				  const char *name)
 {
-   const glsl_type key(fields, num_fields, packing, name);
+   const glsl_type *t;
 
-   if (interface_types == NULL) {
-      interface_types = hash_table_ctor(64, record_key_hash, record_key_compare);
-   }
+   _glthread_LOCK_MUTEX(glsl_type_mutex);
 
-   const glsl_type *t = (glsl_type *) hash_table_find(interface_types, & key);
-   if (t == NULL) {
-      t = new glsl_type(fields, num_fields, packing, name);
+   /* The key's constructor allocates out of mem_ctx too */
+   {
+      const glsl_type key(fields, num_fields, packing, name);
+
+      if (interface_types == NULL) {
+         interface_types = hash_table_ctor(64, record_key_hash,
+                                           record_key_compare);
+      }
 
-      hash_table_insert(interface_types, (void *) t, t);
+      t = (glsl_type *) hash_table_find(interface_types, & key);
+      if (t == NULL) {
+         t = new glsl_type(fields, num_fields, packing, name);
+
+         hash_table_insert(interface_types, (void *) t, t);
+      }
    }
 
+   _glthread_UNLOCK_MUTEX(glsl_type_mutex);
+
    assert(t->base_type == GLSL_TYPE_INTERFACE);
    assert(t->length == num_fields);
    assert(strcmp(t->name, name) == 0);
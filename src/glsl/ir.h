@@ -2032,6 +2032,16 @@ _mesa_glsl_initialize_functions(_mesa_glsl_parse_state *state);
 extern void
 _mesa_glsl_release_functions(void);
 
+/**
+ * Look up \c name in \c sh, which may be one of the built-in profiles.
+ *
+ * Built-in bodies are read the first time they are looked up through this
+ * function, so linking and constant folding must go through it rather than
+ * the profile's symbol table.
+ */
+extern ir_function *
+_mesa_glsl_get_builtin_function(struct gl_shader *sh, const char *name);
+
 extern void
 reparent_ir(exec_list *list, void *mem_ctx);
 
@@ -0,0 +1,345 @@
+/*
+ * Copyright © 2013 The Mesa Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file link_cache.cpp
+ * Per-context cache of linked shader stages.
+ *
+ * Programs built from a few shared vertex shaders and many fragment shaders
+ * link the same set of vertex shaders over and over.  What
+ * link_intrastage_shaders() makes of one stage only depends on the shaders
+ * attached to that stage, so its result is kept, keyed by those shaders and
+ * by the compile that produced each of them, and later programs get a clone
+ * of it.  Everything after that point (interface matching, location
+ * assignment and the post-link optimizations) depends on the other stages
+ * and is still done for every program.
+ *
+ * Setting MESA_GLSL=nocache disables the cache.
+ */
+
+#include "main/core.h"
+#include "main/hash_table.h"
+#include "glsl_symbol_table.h"
+#include "ir.h"
+#include "program.h"
+#include "link_cache.h"
+
+
+/** Most linked stages kept per context; the oldest ones go first */
+#define LINK_CACHE_MAX_ENTRIES 256
+
+
+struct link_cache_shader
+{
+   const struct gl_shader *shader;
+   unsigned serial;             /**< gl_shader::CompileSerial */
+};
+
+
+struct link_cache_entry
+{
+   struct exec_node link;       /**< in glsl_link_cache::entries */
+   uint32_t hash;
+
+   struct link_cache_shader *shaders;
+   unsigned num_shaders;
+
+   GLenum type;
+   exec_list *ir;
+   struct gl_uniform_block *uniform_blocks;
+   unsigned num_uniform_blocks;
+   char *info_log;
+};
+
+
+struct glsl_link_cache
+{
+   struct hash_table *ht;
+   exec_list entries;           /**< oldest first */
+   unsigned num_entries;
+};
+
+
+static uint32_t
+entry_hash(const struct link_cache_shader *shaders, unsigned num_shaders)
+{
+   uint32_t hash = num_shaders;
+
+   for (unsigned i = 0; i < num_shaders; i++) {
+      hash = hash * 31 + (uint32_t) (uintptr_t) shaders[i].shader;
+      hash = hash * 31 + shaders[i].serial;
+   }
+
+   return hash;
+}
+
+
+static bool
+entry_equal(const void *a, const void *b)
+{
+   const struct link_cache_entry *ea = (const struct link_cache_entry *) a;
+   const struct link_cache_entry *eb = (const struct link_cache_entry *) b;
+
+   return ea->num_shaders == eb->num_shaders &&
+      memcmp(ea->shaders, eb->shaders,
+             sizeof(ea->shaders[0]) * ea->num_shaders) == 0;
+}
+
+
+static struct glsl_link_cache *
+get_cache(struct gl_context *ctx)
+{
+   struct glsl_link_cache *cache = ctx->Shader.LinkCache;
+
+   if (cache || (ctx->Shader.Flags & GLSL_NO_CACHE))
+      return cache;
+
+   cache = rzalloc(NULL, struct glsl_link_cache);
+   if (!cache)
+      return NULL;
+
+   cache->ht = _mesa_hash_table_create(cache, entry_equal);
+   if (!cache->ht) {
+      ralloc_free(cache);
+      return NULL;
+   }
+   cache->entries.make_empty();
+
+   ctx->Shader.LinkCache = cache;
+   return cache;
+}
+
+
+/**
+ * Build the key for a stage made of \c shader_list.
+ *
+ * \return false if the stage cannot be cached, i.e. one of its shaders was
+ *         not produced by the GLSL compiler (fixed-function shaders are made
+ *         directly in IR and have no compile serial).
+ */
+static bool
+make_key(struct link_cache_shader *key, struct gl_shader **shader_list,
+         unsigned num_shaders)
+{
+   for (unsigned i = 0; i < num_shaders; i++) {
+      if (shader_list[i]->CompileSerial == 0)
+         return false;
+
+      key[i].shader = shader_list[i];
+      key[i].serial = shader_list[i]->CompileSerial;
+   }
+
+   return true;
+}
+
+
+static struct link_cache_entry *
+find_entry(struct glsl_link_cache *cache, struct link_cache_shader *shaders,
+           unsigned num_shaders)
+{
+   struct link_cache_entry key;
+   struct hash_entry *he;
+
+   key.shaders = shaders;
+   key.num_shaders = num_shaders;
+
+   he = _mesa_hash_table_search(cache->ht, entry_hash(shaders, num_shaders),
+                                &key);
+   return he ? (struct link_cache_entry *) he->data : NULL;
+}
+
+
+static void
+evict_oldest(struct glsl_link_cache *cache)
+{
+   struct link_cache_entry *entry =
+      exec_node_data(struct link_cache_entry, cache->entries.head, link);
+   struct hash_entry *he;
+
+   he = _mesa_hash_table_search(cache->ht, entry->hash, entry);
+   if (he)
+      _mesa_hash_table_remove(cache->ht, he);
+
+   entry->link.remove();
+   cache->num_entries--;
+   ralloc_free(entry);
+}
+
+
+/**
+ * Deep copy of a shader's uniform blocks, names included.
+ */
+struct gl_uniform_block *
+copy_uniform_blocks(void *mem_ctx, const struct gl_uniform_block *blocks,
+                    unsigned num_blocks)
+{
+   if (num_blocks == 0)
+      return NULL;
+
+   struct gl_uniform_block *copy =
+      ralloc_array(mem_ctx, struct gl_uniform_block, num_blocks);
+
+   memcpy(copy, blocks, sizeof(*copy) * num_blocks);
+
+   for (unsigned i = 0; i < num_blocks; i++) {
+      copy[i].Name = ralloc_strdup(copy, blocks[i].Name);
+      copy[i].Uniforms = ralloc_array(copy, struct gl_uniform_buffer_variable,
+                                      blocks[i].NumUniforms);
+      memcpy(copy[i].Uniforms, blocks[i].Uniforms,
+             sizeof(*copy[i].Uniforms) * blocks[i].NumUniforms);
+
+      for (unsigned j = 0; j < blocks[i].NumUniforms; j++) {
+         const struct gl_uniform_buffer_variable *src = &blocks[i].Uniforms[j];
+         struct gl_uniform_buffer_variable *dst = &copy[i].Uniforms[j];
+
+         dst->Name = ralloc_strdup(copy, src->Name);
+         dst->IndexName = (src->IndexName == src->Name)
+            ? dst->Name : ralloc_strdup(copy, src->IndexName);
+      }
+   }
+
+   return copy;
+}
+
+
+/**
+ * Look for an earlier link of the same shaders for one stage.
+ *
+ * \return a new linked shader, with its IR allocated from \c mem_ctx like
+ *         link_intrastage_shaders() does, or NULL on a miss
+ */
+struct gl_shader *
+link_cache_lookup(struct gl_context *ctx, struct gl_shader_program *prog,
+                  void *mem_ctx, struct gl_shader **shader_list,
+                  unsigned num_shaders)
+{
+   struct glsl_link_cache *cache = get_cache(ctx);
+   struct link_cache_entry *entry;
+
+   if (!cache)
+      return NULL;
+
+   struct link_cache_shader *key = (struct link_cache_shader *)
+      calloc(num_shaders, sizeof(*key));
+   if (!key)
+      return NULL;
+
+   entry = make_key(key, shader_list, num_shaders)
+      ? find_entry(cache, key, num_shaders) : NULL;
+   free(key);
+
+   if (!entry)
+      return NULL;
+
+   gl_shader *linked = ctx->Driver.NewShader(NULL, 0, entry->type);
+   linked->ir = new(linked) exec_list;
+   clone_ir_list(mem_ctx, linked->ir, entry->ir);
+
+   linked->UniformBlocks = copy_uniform_blocks(linked, entry->uniform_blocks,
+                                               entry->num_uniform_blocks);
+   linked->NumUniformBlocks = entry->num_uniform_blocks;
+
+   linked->symbols = new(linked) glsl_symbol_table;
+   foreach_list(node, linked->ir) {
+      ir_instruction *const inst = (ir_instruction *) node;
+      ir_variable *var;
+      ir_function *func;
+
+      if ((func = inst->as_function()) != NULL) {
+         linked->symbols->add_function(func);
+      } else if ((var = inst->as_variable()) != NULL) {
+         linked->symbols->add_variable(var);
+      }
+   }
+
+   /* Replay any warnings from the original link. */
+   ralloc_strcat(&prog->InfoLog, entry->info_log);
+
+   return linked;
+}
+
+
+/**
+ * Remember the result of linking \c shader_list into one stage.
+ *
+ * This must be called before anything outside link_intrastage_shaders()
+ * touches \c linked.  \c info_log holds what linking the stage added to the
+ * program's info log.
+ */
+void
+link_cache_insert(struct gl_context *ctx, struct gl_shader **shader_list,
+                  unsigned num_shaders, const struct gl_shader *linked,
+                  const char *info_log)
+{
+   struct glsl_link_cache *cache = get_cache(ctx);
+   struct link_cache_entry *entry;
+
+   if (!cache)
+      return;
+
+   entry = rzalloc(cache, struct link_cache_entry);
+   if (!entry)
+      return;
+
+   entry->shaders = rzalloc_array(entry, struct link_cache_shader, num_shaders);
+   entry->num_shaders = num_shaders;
+   if (!entry->shaders ||
+       !make_key(entry->shaders, shader_list, num_shaders) ||
+       find_entry(cache, entry->shaders, num_shaders)) {
+      ralloc_free(entry);
+      return;
+   }
+
+   if (cache->num_entries >= LINK_CACHE_MAX_ENTRIES)
+      evict_oldest(cache);
+
+   entry->hash = entry_hash(entry->shaders, num_shaders);
+   entry->type = linked->Type;
+
+   entry->ir = new(entry) exec_list;
+   clone_ir_list(entry, entry->ir, linked->ir);
+
+   entry->uniform_blocks = copy_uniform_blocks(entry, linked->UniformBlocks,
+                                               linked->NumUniformBlocks);
+   entry->num_uniform_blocks = linked->NumUniformBlocks;
+   entry->info_log = ralloc_strdup(entry, info_log);
+
+   _mesa_hash_table_insert(cache->ht, entry->hash, entry, entry);
+   cache->entries.push_tail(&entry->link);
+   cache->num_entries++;
+}
+
+
+extern "C" {
+
+/**
+ * Free the context's linked stage cache.
+ */
+void
+_mesa_glsl_destroy_link_cache(struct gl_context *ctx)
+{
+   ralloc_free(ctx->Shader.LinkCache);
+   ctx->Shader.LinkCache = NULL;
+}
+
+} /* extern "C" */
@@ -0,0 +1,43 @@
+/* -*- c++ -*- */
+/*
+ * Copyright © 2013 The Mesa Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+#ifndef GLSL_LINK_CACHE_H
+#define GLSL_LINK_CACHE_H
+
+extern struct gl_shader *
+link_cache_lookup(struct gl_context *ctx, struct gl_shader_program *prog,
+                  void *mem_ctx, struct gl_shader **shader_list,
+                  unsigned num_shaders);
+
+extern void
+link_cache_insert(struct gl_context *ctx, struct gl_shader **shader_list,
+                  unsigned num_shaders, const struct gl_shader *linked,
+                  const char *info_log);
+
+extern struct gl_uniform_block *
+copy_uniform_blocks(void *mem_ctx, const struct gl_uniform_block *blocks,
+                    unsigned num_blocks);
+
+#endif /* GLSL_LINK_CACHE_H */
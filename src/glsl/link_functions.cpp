@@ -251,7 +251,9 @@ find_matching_signature(const char *name, const exec_list *actual_parameters,
 			bool use_builtin)
 {
    for (unsigned i = 0; i < num_shaders; i++) {
-      ir_function *const f = shader_list[i]->symbols->get_function(name);
+      ir_function *const f = use_builtin
+	 ? _mesa_glsl_get_builtin_function(shader_list[i], name)
+	 : shader_list[i]->symbols->get_function(name);
 
       if (f == NULL)
 	 continue;
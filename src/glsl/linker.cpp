@@ -71,6 +71,8 @@
 #include "program.h"
 #include "program/hash_table.h"
 #include "linker.h"
+#include "link_cache.h"
+#include "pass_stats.h"
 #include "link_varyings.h"
 #include "ir_optimization.h"
 
@@ -1092,6 +1094,42 @@ link_intrastage_shaders(void *mem_ctx,
    return linked;
 }
 
+
+/**
+ * Link the shaders of one stage, or reuse an earlier link of the very same
+ * shaders (see link_cache.cpp).
+ */
+static struct gl_shader *
+link_stage(void *mem_ctx, struct gl_context *ctx,
+	   struct gl_shader_program *prog, struct gl_shader **shader_list,
+	   unsigned num_shaders)
+{
+   const unsigned stage = _mesa_shader_type_to_index(shader_list[0]->Type);
+   struct glsl_pass_stats *const stats =
+      ctx->ShaderCompilerOptions[stage].PassStats;
+   const int64_t start = stats ? glsl_pass_stats_time_ns() : 0;
+   const char *pass = "link_intrastage_cached";
+
+   gl_shader *sh = link_cache_lookup(ctx, prog, mem_ctx, shader_list,
+				     num_shaders);
+   if (sh == NULL) {
+      const size_t log_start = strlen(prog->InfoLog);
+
+      pass = "link_intrastage";
+      sh = link_intrastage_shaders(mem_ctx, ctx, prog, shader_list,
+				   num_shaders);
+      if (sh != NULL)
+	 link_cache_insert(ctx, shader_list, num_shaders, sh,
+			   prog->InfoLog + log_start);
+   }
+
+   if (stats && sh != NULL)
+      glsl_pass_stats_record(stats, pass, glsl_pass_stats_time_ns() - start,
+			     0, glsl_count_ir_nodes(sh->ir), true);
+
+   return sh;
+}
+
 /**
  * Update the sizes of linked shader uniform arrays to the maximum
  * array index used.
@@ -1618,6 +1656,7 @@ link_shaders(struct gl_context *ctx, struct gl_shader_program *prog)
    unsigned num_tfeedback_decls = prog->TransformFeedback.NumVarying;
 
    void *mem_ctx = ralloc_context(NULL); // temporary linker context
+   const bool collect_stats = glsl_pass_stats_begin(ctx, "link");
 
    prog->LinkStatus = false;
    prog->Validated = false;
@@ -1702,8 +1741,7 @@ link_shaders(struct gl_context *ctx, struct gl_shader_program *prog)
     */
    if (num_vert_shaders > 0) {
       gl_shader *const sh =
-	 link_intrastage_shaders(mem_ctx, ctx, prog, vert_shader_list,
-				 num_vert_shaders);
+	 link_stage(mem_ctx, ctx, prog, vert_shader_list, num_vert_shaders);
 
       if (sh == NULL)
 	 goto done;
@@ -1717,8 +1755,7 @@ link_shaders(struct gl_context *ctx, struct gl_shader_program *prog)
 
    if (num_frag_shaders > 0) {
       gl_shader *const sh =
-	 link_intrastage_shaders(mem_ctx, ctx, prog, frag_shader_list,
-				 num_frag_shaders);
+	 link_stage(mem_ctx, ctx, prog, frag_shader_list, num_frag_shaders);
 
       if (sh == NULL)
 	 goto done;
@@ -1768,8 +1805,13 @@ link_shaders(struct gl_context *ctx, struct gl_shader_program *prog)
 
 
    for (unsigned int i = 0; i < MESA_SHADER_TYPES; i++) {
-      if (prog->_LinkedShaders[i] != NULL)
+      if (prog->_LinkedShaders[i] != NULL) {
+         glsl_pass_timer timer(ctx->ShaderCompilerOptions[i].PassStats,
+                               "lower_named_interface_blocks",
+                               prog->_LinkedShaders[i]->ir);
          lower_named_interface_blocks(mem_ctx, prog->_LinkedShaders[i]);
+         timer.done(true);
+      }
    }
 
    /* Implement the GLSL 1.30+ rule for discard vs infinite loops Do
@@ -1781,7 +1823,10 @@ link_shaders(struct gl_context *ctx, struct gl_shader_program *prog)
    if (max_version >= (is_es_prog ? 300 : 130)) {
       struct gl_shader *sh = prog->_LinkedShaders[MESA_SHADER_FRAGMENT];
       if (sh) {
+	 glsl_pass_timer timer(ctx->ShaderCompilerOptions[MESA_SHADER_FRAGMENT].PassStats,
+			       "lower_discard_flow", sh->ir);
 	 lower_discard_flow(sh->ir);
+	 timer.done(true);
       }
    }
 
@@ -1801,13 +1846,16 @@ link_shaders(struct gl_context *ctx, struct gl_shader_program *prog)
 	 goto done;
 
       if (ctx->ShaderCompilerOptions[i].LowerClipDistance) {
-         lower_clip_distance(prog->_LinkedShaders[i]);
+         glsl_pass_timer timer(ctx->ShaderCompilerOptions[i].PassStats,
+                               "lower_clip_distance",
+                               prog->_LinkedShaders[i]->ir);
+         timer.done(lower_clip_distance(prog->_LinkedShaders[i]));
       }
 
       unsigned max_unroll = ctx->ShaderCompilerOptions[i].MaxUnrollIterations;
 
-      while (do_common_optimization(prog->_LinkedShaders[i]->ir, true, false, max_unroll, &ctx->ShaderCompilerOptions[i]))
-	 ;
+      do_common_optimization_loop(prog->_LinkedShaders[i]->ir, true, false,
+                                  max_unroll, &ctx->ShaderCompilerOptions[i]);
    }
 
    /* Mark all generic shader inputs and outputs as unpaired. */
@@ -1968,5 +2016,8 @@ done:
       prog->_LinkedShaders[i]->symbols = NULL;
    }
 
+   if (collect_stats)
+      glsl_pass_stats_end(ctx);
+
    ralloc_free(mem_ctx);
 }
@@ -57,7 +57,8 @@ set_loop_controls(exec_list *instructions, loop_state *ls);
 
 
 extern bool
-unroll_loops(exec_list *instructions, loop_state *ls, unsigned max_iterations);
+unroll_loops(exec_list *instructions, loop_state *ls, unsigned max_iterations,
+             const struct gl_shader_compiler_options *options);
 
 
 /**
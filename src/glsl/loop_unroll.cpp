@@ -21,17 +21,20 @@
  * DEALINGS IN THE SOFTWARE.
  */
 
+#include "main/core.h" /* for struct gl_shader_compiler_options */
 #include "glsl_types.h"
 #include "loop_analysis.h"
 #include "ir_hierarchical_visitor.h"
 
 class loop_unroll_visitor : public ir_hierarchical_visitor {
 public:
-   loop_unroll_visitor(loop_state *state, unsigned max_iterations)
+   loop_unroll_visitor(loop_state *state, unsigned max_iterations,
+                       const struct gl_shader_compiler_options *options)
    {
       this->state = state;
       this->progress = false;
       this->max_iterations = max_iterations;
+      this->options = options;
    }
 
    virtual ir_visitor_status visit_leave(ir_loop *ir);
@@ -40,6 +43,7 @@ public:
 
    bool progress;
    unsigned max_iterations;
+   const struct gl_shader_compiler_options *options;
 };
 
 
@@ -50,15 +54,30 @@ is_break(ir_instruction *ir)
 		     && ((ir_loop_jump *) ir)->is_break();
 }
 
+/**
+ * Estimates the cost of one iteration of a loop body.
+ *
+ * \c nodes counts the instructions that survive into the generated code:
+ * assignments, expressions, texture lookups and calls.  \c
+ * unsupported_variable_indexing is set when the body indexes an array with
+ * a non-constant index in a storage class that \c options says the driver
+ * cannot address indirectly.  Such accesses get lowered to a chain of
+ * conditional moves across the whole array, which costs far more than the
+ * unrolled code, in which the loop counter becomes a constant.
+ */
 class loop_unroll_count : public ir_hierarchical_visitor {
 public:
    int nodes;
    bool fail;
+   bool unsupported_variable_indexing;
 
-   loop_unroll_count(exec_list *list)
+   loop_unroll_count(exec_list *list,
+                     const struct gl_shader_compiler_options *options)
+      : options(options)
    {
       nodes = 0;
       fail = false;
+      unsupported_variable_indexing = false;
 
       run(list);
    }
@@ -75,11 +94,60 @@ public:
       return visit_continue;
    }
 
+   virtual ir_visitor_status visit_enter(ir_texture *ir)
+   {
+      nodes++;
+      return visit_continue;
+   }
+
+   virtual ir_visitor_status visit_enter(ir_call *ir)
+   {
+      nodes++;
+      return visit_continue;
+   }
+
    virtual ir_visitor_status visit_enter(ir_loop *ir)
    {
       fail = true;
       return visit_continue;
    }
+
+   virtual ir_visitor_status visit_enter(ir_dereference_array *ir)
+   {
+      if (options == NULL || ir->array_index->as_constant() != NULL)
+         return visit_continue;
+
+      ir_variable *const array = ir->variable_referenced();
+      if (array == NULL)
+         return visit_continue;
+
+      switch (array->mode) {
+      case ir_var_auto:
+      case ir_var_temporary:
+         if (options->EmitNoIndirectTemp)
+            unsupported_variable_indexing = true;
+         break;
+      case ir_var_uniform:
+         if (options->EmitNoIndirectUniform)
+            unsupported_variable_indexing = true;
+         break;
+      case ir_var_shader_in:
+         if (options->EmitNoIndirectInput)
+            unsupported_variable_indexing = true;
+         break;
+      case ir_var_shader_out:
+         if (options->EmitNoIndirectOutput)
+            unsupported_variable_indexing = true;
+         break;
+      default:
+         break;
+      }
+
+      return visit_continue;
+   }
+
+private:
+   const struct gl_shader_compiler_options *options;
 };
 
 
@@ -110,11 +178,19 @@ loop_unroll_visitor::visit_leave(ir_loop *ir)
    if (iterations > (int) max_iterations)
       return visit_continue;
 
-   /* Don't try to unroll nested loops and loops with a huge body.
+   /* Don't try to unroll nested loops and loops with a huge body.  The
+    * unrolled size is weighed against a budget proportional to the
+    * iteration limit; a body whose indexing the driver would otherwise have
+    * to lower gets a larger budget, since unrolling makes that indexing
+    * constant.
     */
-   loop_unroll_count count(&ir->body_instructions);
+   loop_unroll_count count(&ir->body_instructions, this->options);
+   int budget = (int) max_iterations * 5;
 
-   if (count.fail || count.nodes * iterations > (int)max_iterations * 5)
+   if (count.unsupported_variable_indexing)
+      budget *= 4;
+
+   if (count.fail || count.nodes * iterations > budget)
       return visit_continue;
 
    if (ls->num_loop_jumps > 1)
@@ -242,10 +318,20 @@ loop_unroll_visitor::visit_leave(ir_loop *ir)
 }
 
 
+/**
+ * Unroll the loops of \c instructions whose trip count \c ls knows,
+ * where that count is at most \c max_iterations and the unrolled body
+ * stays within the size budget described in
+ * loop_unroll_visitor::visit_leave().
+ *
+ * \param options  The driver's shader options, used to tell which array
+ *                 indexing it cannot do; may be NULL.
+ */
 bool
-unroll_loops(exec_list *instructions, loop_state *ls, unsigned max_iterations)
+unroll_loops(exec_list *instructions, loop_state *ls, unsigned max_iterations,
+             const struct gl_shader_compiler_options *options)
 {
-   loop_unroll_visitor v(ls, max_iterations);
+   loop_unroll_visitor v(ls, max_iterations, options);
 
    v.run(instructions);
 
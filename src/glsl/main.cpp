@@ -37,6 +37,7 @@
 #include "program.h"
 #include "loop_analysis.h"
 #include "standalone_scaffolding.h"
+#include "pass_stats.h"
 
 static void
 initialize_context(struct gl_context *ctx, gl_api api)
@@ -108,6 +109,8 @@ int dump_ast = 0;
 int dump_hir = 0;
 int dump_lir = 0;
 int do_link = 0;
+int print_stats = 0;
+int bench_iterations = 0;
 
 const struct option compiler_opts[] = {
    { "glsl-es",  0, &glsl_es,  1 },
@@ -115,6 +118,8 @@ const struct option compiler_opts[] = {
    { "dump-hir", 0, &dump_hir, 1 },
    { "dump-lir", 0, &dump_lir, 1 },
    { "link",     0, &do_link,  1 },
+   { "stats",    0, &print_stats, 1 },
+   { "bench",    1, NULL,      'b' },
    { NULL, 0, NULL, 0 }
 };
 
@@ -131,12 +136,34 @@ usage_fail(const char *name)
       "Possible options are:\n";
    printf(header, name, name);
    for (const struct option *o = compiler_opts; o->name != 0; ++o) {
-      printf("    --%s\n", o->name);
+      printf("    --%s%s\n", o->name, o->has_arg ? "=<n>" : "");
    }
    exit(EXIT_FAILURE);
 }
 
 
+/**
+ * Shader stage of a file, from its extension, or 0 if it has none we know.
+ */
+static GLenum
+shader_type_for_file(const char *file_name)
+{
+   const unsigned len = strlen(file_name);
+   if (len < 6)
+      return 0;
+
+   const char *const ext = &file_name[len - 5];
+   if (strncmp(".vert", ext, 5) == 0 || strncmp(".glsl", ext, 5) == 0)
+      return GL_VERTEX_SHADER;
+   else if (strncmp(".geom", ext, 5) == 0)
+      return GL_GEOMETRY_SHADER;
+   else if (strncmp(".frag", ext, 5) == 0)
+      return GL_FRAGMENT_SHADER;
+
+   return 0;
+}
+
+
 void
 compile_shader(struct gl_context *ctx, struct gl_shader *shader)
 {
@@ -153,6 +180,162 @@ compile_shader(struct gl_context *ctx, struct gl_shader *shader)
    return;
 }
 
+/**
+ * One program of a benchmark corpus: the shaders whose file names only
+ * differ in their extension, e.g. foo.vert and foo.frag.
+ */
+struct bench_program {
+   const char *name;
+   unsigned num_shaders;
+   GLenum types[MESA_SHADER_TYPES];
+   const char *sources[MESA_SHADER_TYPES];
+};
+
+
+static int
+compare_file_names(const void *a, const void *b)
+{
+   return strcmp(*(const char *const *) a, *(const char *const *) b);
+}
+
+
+/**
+ * Compile and link every program of the corpus \c iterations times, with
+ * the shader and link caches off, and print the per-pass statistics of all
+ * runs added up, then one summary line.
+ *
+ * \return EXIT_FAILURE if a file can't be used, EXIT_SUCCESS otherwise;
+ *         programs that fail to compile or link are counted and skipped.
+ */
+static int
+run_bench(struct gl_context *ctx, int num_files, char **files,
+          unsigned iterations)
+{
+   void *mem_ctx = ralloc_context(NULL);
+   struct bench_program *programs =
+      rzalloc_array(mem_ctx, struct bench_program, num_files);
+   unsigned num_programs = 0;
+
+   /* Group the files into programs by the name without the extension. */
+   qsort(files, num_files, sizeof(files[0]), compare_file_names);
+
+   for (int i = 0; i < num_files; i++) {
+      const GLenum type = shader_type_for_file(files[i]);
+      if (type == 0) {
+         printf("File \"%s\" is not a shader.\n", files[i]);
+         ralloc_free(mem_ctx);
+         return EXIT_FAILURE;
+      }
+
+      const char *name = ralloc_strndup(mem_ctx, files[i],
+                                        strlen(files[i]) - 5);
+      struct bench_program *prog = num_programs > 0 ?
+         &programs[num_programs - 1] : NULL;
+
+      if (prog == NULL || strcmp(prog->name, name) != 0 ||
+          prog->num_shaders == MESA_SHADER_TYPES) {
+         prog = &programs[num_programs++];
+         prog->name = name;
+      }
+
+      prog->types[prog->num_shaders] = type;
+      prog->sources[prog->num_shaders] = load_text_file(mem_ctx, files[i]);
+      if (prog->sources[prog->num_shaders] == NULL) {
+         printf("File \"%s\" does not exist.\n", files[i]);
+         ralloc_free(mem_ctx);
+         return EXIT_FAILURE;
+      }
+      prog->num_shaders++;
+   }
+
+   /* Measure the work itself, not the reuse of earlier results. */
+   ctx->Shader.Flags |= GLSL_NO_CACHE;
+
+   struct glsl_pass_stats *compile_stats[MESA_SHADER_TYPES];
+   struct glsl_pass_stats *link_stats[MESA_SHADER_TYPES];
+   static const GLenum stage_types[MESA_SHADER_TYPES] = {
+      GL_VERTEX_SHADER, GL_GEOMETRY_SHADER, GL_FRAGMENT_SHADER
+   };
+   for (unsigned t = 0; t < MESA_SHADER_TYPES; t++) {
+      const unsigned i = _mesa_shader_type_to_index(stage_types[t]);
+      const char *stage = _mesa_glsl_shader_target_name(stage_types[t]);
+
+      compile_stats[i] = glsl_pass_stats_create(mem_ctx, "compile", stage);
+      link_stats[i] = glsl_pass_stats_create(mem_ctx, "link", stage);
+   }
+
+   unsigned failures = 0;
+   const int64_t start = glsl_pass_stats_time_ns();
+
+   for (unsigned iter = 0; iter < iterations; iter++) {
+      for (unsigned p = 0; p < num_programs; p++) {
+         const struct bench_program *prog = &programs[p];
+         struct gl_shader_program *whole_program =
+            rzalloc(NULL, struct gl_shader_program);
+         bool ok = true;
+
+         whole_program->InfoLog = ralloc_strdup(whole_program, "");
+         whole_program->Shaders =
+            rzalloc_array(whole_program, struct gl_shader *,
+                          prog->num_shaders);
+
+         /* While PassStats is set, compiles and links record into it. */
+         for (unsigned i = 0; i < MESA_SHADER_TYPES; i++)
+            ctx->ShaderCompilerOptions[i].PassStats = compile_stats[i];
+
+         for (unsigned s = 0; s < prog->num_shaders && ok; s++) {
+            struct gl_shader *shader = rzalloc(whole_program, gl_shader);
+
+            shader->Type = prog->types[s];
+            shader->Source = ralloc_strdup(whole_program, prog->sources[s]);
+            whole_program->Shaders[whole_program->NumShaders++] = shader;
+
+            compile_shader(ctx, shader);
+            ok = shader->CompileStatus;
+         }
+
+         if (ok) {
+            for (unsigned i = 0; i < MESA_SHADER_TYPES; i++)
+               ctx->ShaderCompilerOptions[i].PassStats = link_stats[i];
+
+            link_shaders(ctx, whole_program);
+            ok = whole_program->LinkStatus;
+         }
+
+         for (unsigned i = 0; i < MESA_SHADER_TYPES; i++)
+            ctx->ShaderCompilerOptions[i].PassStats = NULL;
+
+         if (!ok) {
+            if (iter == 0)
+               printf("Program %s failed to compile or link\n", prog->name);
+            failures++;
+         }
+
+         for (unsigned i = 0; i < MESA_SHADER_TYPES; i++)
+            ralloc_free(whole_program->_LinkedShaders[i]);
+         ralloc_free(whole_program);
+      }
+   }
+
+   const int64_t time_ns = glsl_pass_stats_time_ns() - start;
+
+   for (unsigned i = 0; i < MESA_SHADER_TYPES; i++)
+      glsl_pass_stats_report(ctx, compile_stats[i]);
+   for (unsigned i = 0; i < MESA_SHADER_TYPES; i++)
+      glsl_pass_stats_report(ctx, link_stats[i]);
+
+   printf("GLSL bench: programs=%u iterations=%u failures=%u time_us=%u "
+          "time_per_program_us=%u\n",
+          num_programs, iterations, failures,
+          (unsigned) (time_ns / 1000),
+          num_programs ?
+          (unsigned) (time_ns / 1000 / (iterations * num_programs)) : 0);
+
+   ralloc_free(mem_ctx);
+   return EXIT_SUCCESS;
+}
+
+
 int
 main(int argc, char **argv)
 {
@@ -162,8 +345,12 @@ main(int argc, char **argv)
 
    int c;
    int idx = 0;
-   while ((c = getopt_long(argc, argv, "", compiler_opts, &idx)) != -1)
-      /* empty */ ;
+   while ((c = getopt_long(argc, argv, "", compiler_opts, &idx)) != -1) {
+      if (c == 'b')
+         bench_iterations = atoi(optarg);
+      else if (c == '?')
+         usage_fail(argv[0]);
+   }
 
 
    if (argc <= optind)
@@ -171,6 +358,17 @@ main(int argc, char **argv)
 
    initialize_context(ctx, (glsl_es) ? API_OPENGLES2 : API_OPENGL_COMPAT);
 
+   if (bench_iterations > 0) {
+      status = run_bench(ctx, argc - optind, &argv[optind], bench_iterations);
+      _mesa_glsl_release_types();
+      _mesa_glsl_release_functions();
+      return status;
+   }
+
+   /* Per-pass statistics, one "GLSL stats:" line per pass and stage. */
+   if (print_stats)
+      ctx->Shader.Flags |= GLSL_STATS;
+
    struct gl_shader_program *whole_program;
 
    whole_program = rzalloc (NULL, struct gl_shader_program);
@@ -188,18 +386,8 @@ main(int argc, char **argv)
       whole_program->Shaders[whole_program->NumShaders] = shader;
       whole_program->NumShaders++;
 
-      const unsigned len = strlen(argv[optind]);
-      if (len < 6)
-	 usage_fail(argv[0]);
-
-      const char *const ext = & argv[optind][len - 5];
-      if (strncmp(".vert", ext, 5) == 0 || strncmp(".glsl", ext, 5) == 0)
-	 shader->Type = GL_VERTEX_SHADER;
-      else if (strncmp(".geom", ext, 5) == 0)
-	 shader->Type = GL_GEOMETRY_SHADER;
-      else if (strncmp(".frag", ext, 5) == 0)
-	 shader->Type = GL_FRAGMENT_SHADER;
-      else
+      shader->Type = shader_type_for_file(argv[optind]);
+      if (shader->Type == 0)
 	 usage_fail(argv[0]);
 
       shader->Source = load_text_file(whole_program, argv[optind]);
@@ -0,0 +1,456 @@
+/*
+ * Copyright © 2013 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file opt_vectorize.cpp
+ *
+ * Recombines scalarized operations into vector operations.
+ *
+ * Inlining, matrix lowering and the structure and array splitting passes
+ * leave behind runs of assignments like
+ *
+ *    (assign (x) (var_ref a) (expression float + (swiz x (var_ref b))
+ *                                                (swiz x (var_ref c))))
+ *    (assign (y) (var_ref a) (expression float + (swiz y (var_ref b))
+ *                                                (swiz y (var_ref c))))
+ *
+ * which a vec4 back-end would emit as two instructions where one would do.
+ * This pass looks for adjacent assignments within a basic block that each
+ * write a single, distinct channel of the same variable with expression
+ * trees that differ only in which component their single-channel swizzles
+ * select, and packs them into one masked assignment:
+ *
+ *    (assign (xy) (var_ref a) (expression vec2 + (swiz xy (var_ref b))
+ *                                                (swiz xy (var_ref c))))
+ *
+ * Scalar constants and scalar variables may appear in the trees as long as
+ * they are the same in every lane; the operations that accept a scalar
+ * operand alongside a vector one keep it as is.
+ *
+ * Because the combined assignment evaluates every lane before writing any
+ * of them, an assignment whose right-hand side reads the variable being
+ * written ends the run.
+ *
+ * This is meant for vector back-ends only, and is not part of
+ * do_common_optimization(): back-ends that scalarize (e.g. with
+ * brw_do_channel_expressions()) would undo it on every iteration.
+ */
+
+#include "ir.h"
+#include "ir_basic_block.h"
+#include "ir_optimization.h"
+#include "glsl_types.h"
+
+namespace {
+
+struct vectorize_info {
+   bool progress;
+};
+
+/**
+ * Whether \c ir is a dereference this pass can treat as a leaf: a variable,
+ * a structure field or a constant-indexed array element of one.
+ */
+static bool
+is_simple_deref(ir_rvalue *ir, ir_variable *lhs_var)
+{
+   if (ir_dereference_variable *deref = ir->as_dereference_variable())
+      return deref->var != lhs_var;
+
+   if (ir_dereference_record *deref = ir->as_dereference_record())
+      return is_simple_deref(deref->record, lhs_var);
+
+   if (ir_dereference_array *deref = ir->as_dereference_array()) {
+      return deref->array_index->as_constant() != NULL &&
+	     is_simple_deref(deref->array, lhs_var);
+   }
+
+   return false;
+}
+
+static bool
+same_deref(ir_rvalue *a, ir_rvalue *b)
+{
+   if (a->ir_type != b->ir_type)
+      return false;
+
+   if (ir_dereference_variable *da = a->as_dereference_variable())
+      return da->var == b->as_dereference_variable()->var;
+
+   if (ir_dereference_record *da = a->as_dereference_record()) {
+      ir_dereference_record *db = b->as_dereference_record();
+      return strcmp(da->field, db->field) == 0 &&
+	     same_deref(da->record, db->record);
+   }
+
+   if (ir_dereference_array *da = a->as_dereference_array()) {
+      ir_dereference_array *db = b->as_dereference_array();
+      return da->array_index->as_constant()->has_value(
+		db->array_index->as_constant()) &&
+	     same_deref(da->array, db->array);
+   }
+
+   return false;
+}
+
+/**
+ * Whether every lane of a widened expression may be computed by \c op
+ * at once, given which of its operands carry per-lane values.
+ */
+static bool
+can_widen_operation(ir_expression_operation op, const bool *lane,
+		    unsigned num_operands)
+{
+   switch (op) {
+   case ir_unop_bit_not:
+   case ir_unop_logic_not:
+   case ir_unop_neg:
+   case ir_unop_abs:
+   case ir_unop_sign:
+   case ir_unop_rcp:
+   case ir_unop_rsq:
+   case ir_unop_sqrt:
+   case ir_unop_exp:
+   case ir_unop_log:
+   case ir_unop_exp2:
+   case ir_unop_log2:
+   case ir_unop_f2i:
+   case ir_unop_f2u:
+   case ir_unop_i2f:
+   case ir_unop_f2b:
+   case ir_unop_b2f:
+   case ir_unop_i2b:
+   case ir_unop_b2i:
+   case ir_unop_u2f:
+   case ir_unop_i2u:
+   case ir_unop_u2i:
+   case ir_unop_bitcast_i2f:
+   case ir_unop_bitcast_f2i:
+   case ir_unop_bitcast_u2f:
+   case ir_unop_bitcast_f2u:
+   case ir_unop_trunc:
+   case ir_unop_ceil:
+   case ir_unop_floor:
+   case ir_unop_fract:
+   case ir_unop_round_even:
+   case ir_unop_sin:
+   case ir_unop_cos:
+   case ir_unop_sin_reduced:
+   case ir_unop_cos_reduced:
+      return true;
+
+   /* These accept a scalar operand alongside a vector one. */
+   case ir_binop_add:
+   case ir_binop_sub:
+   case ir_binop_mul:
+   case ir_binop_div:
+   case ir_binop_mod:
+   case ir_binop_min:
+   case ir_binop_max:
+   case ir_binop_pow:
+      return true;
+
+   case ir_binop_lshift:
+   case ir_binop_rshift:
+      return lane[0];
+
+   case ir_binop_less:
+   case ir_binop_greater:
+   case ir_binop_lequal:
+   case ir_binop_gequal:
+   case ir_binop_equal:
+   case ir_binop_nequal:
+   case ir_binop_bit_and:
+   case ir_binop_bit_xor:
+   case ir_binop_bit_or:
+   case ir_binop_logic_and:
+   case ir_binop_logic_xor:
+   case ir_binop_logic_or:
+      assert(num_operands == 2);
+      return lane[0] && lane[1];
+
+   default:
+      return false;
+   }
+}
+
+/**
+ * Whether \c ir is a scalar tree this pass knows how to widen.
+ *
+ * \c has_lane is set if the tree contains a single-channel swizzle, i.e.
+ * if its value differs from lane to lane.  Trees that read \c lhs_var are
+ * rejected.
+ */
+static bool
+is_lane_tree(ir_rvalue *ir, ir_variable *lhs_var, bool *has_lane)
+{
+   *has_lane = false;
+
+   if (!ir->type->is_scalar())
+      return false;
+
+   if (ir_swizzle *swiz = ir->as_swizzle()) {
+      *has_lane = true;
+      return is_simple_deref(swiz->val, lhs_var);
+   }
+
+   if (ir->as_constant())
+      return true;
+
+   if (ir->as_dereference())
+      return is_simple_deref(ir, lhs_var);
+
+   ir_expression *expr = ir->as_expression();
+   if (!expr)
+      return false;
+
+   const unsigned num_operands = expr->get_num_operands();
+   bool lane[4];
+   bool any_lane = false;
+
+   for (unsigned i = 0; i < num_operands; i++) {
+      if (!is_lane_tree(expr->operands[i], lhs_var, &lane[i]))
+	 return false;
+      any_lane = any_lane || lane[i];
+   }
+
+   /* An expression of lane-invariant operands is itself lane-invariant. */
+   if (!any_lane)
+      return true;
+
+   *has_lane = true;
+   return can_widen_operation(expr->operation, lane, num_operands);
+}
+
+/**
+ * Whether the lane trees \c a and \c b are the same except for the
+ * components selected by their single-channel swizzles.
+ */
+static bool
+same_lane_tree(ir_rvalue *a, ir_rvalue *b)
+{
+   if (a->ir_type != b->ir_type || a->type != b->type)
+      return false;
+
+   if (ir_swizzle *sa = a->as_swizzle())
+      return same_deref(sa->val, b->as_swizzle()->val);
+
+   if (ir_constant *ca = a->as_constant())
+      return ca->has_value(b->as_constant());
+
+   if (a->as_dereference())
+      return same_deref(a, b);
+
+   ir_expression *ea = a->as_expression();
+   ir_expression *eb = b->as_expression();
+   if (ea->operation != eb->operation)
+      return false;
+
+   for (unsigned i = 0; i < ea->get_num_operands(); i++) {
+      if (!same_lane_tree(ea->operands[i], eb->operands[i]))
+	 return false;
+   }
+
+   return true;
+}
+
+/**
+ * Combines the matching lane trees \c trees[0..n-1], ordered by the channel
+ * they are written to, into a single tree of \c n components.
+ *
+ * \c trees[0] is reused for the result.
+ */
+static ir_rvalue *
+widen_lane_trees(ir_rvalue **trees, unsigned n)
+{
+   if (ir_swizzle *swiz = trees[0]->as_swizzle()) {
+      unsigned components[4];
+
+      for (unsigned k = 0; k < n; k++)
+	 components[k] = trees[k]->as_swizzle()->mask.x;
+
+      return new(ralloc_parent(swiz)) ir_swizzle(swiz->val, components, n);
+   }
+
+   ir_expression *expr = trees[0]->as_expression();
+   if (!expr)
+      return trees[0];
+
+   bool widened = false;
+
+   for (unsigned i = 0; i < expr->get_num_operands(); i++) {
+      ir_rvalue *operands[4];
+
+      for (unsigned k = 0; k < n; k++)
+	 operands[k] = trees[k]->as_expression()->operands[i];
+
+      expr->operands[i] = widen_lane_trees(operands, n);
+      widened = widened || !expr->operands[i]->type->is_scalar();
+   }
+
+   if (widened)
+      expr->type = glsl_type::get_instance(expr->type->base_type, n, 1);
+
+   return expr;
+}
+
+/**
+ * Whether \c ir may start or join a run of assignments to vectorize.
+ */
+static bool
+is_lane_assignment(ir_assignment *ir)
+{
+   ir_dereference_variable *lhs = ir->lhs->as_dereference_variable();
+   bool has_lane;
+
+   if (!lhs || !lhs->type->is_vector())
+      return false;
+
+   /* Exactly one channel written. */
+   if (ir->write_mask == 0 || (ir->write_mask & (ir->write_mask - 1)) != 0)
+      return false;
+
+   if (ir->condition && !is_simple_deref(ir->condition, lhs->var))
+      return false;
+
+   return is_lane_tree(ir->rhs, lhs->var, &has_lane) && has_lane;
+}
+
+static bool
+can_join_run(ir_assignment **run, unsigned run_mask, ir_assignment *ir)
+{
+   ir_assignment *first = NULL;
+
+   for (unsigned i = 0; i < 4; i++) {
+      if (run[i]) {
+	 first = run[i];
+	 break;
+      }
+   }
+
+   if (first == NULL)
+      return true;
+
+   if ((run_mask & ir->write_mask) != 0)
+      return false;
+
+   if (ir->lhs->as_dereference_variable()->var !=
+       first->lhs->as_dereference_variable()->var)
+      return false;
+
+   if ((ir->condition == NULL) != (first->condition == NULL))
+      return false;
+
+   if (ir->condition && !same_deref(ir->condition, first->condition))
+      return false;
+
+   return same_lane_tree(ir->rhs, first->rhs);
+}
+
+/**
+ * Replaces the assignments of the run with a single one, writing all of
+ * their channels.
+ */
+static bool
+flush_run(ir_assignment **run, unsigned &run_mask)
+{
+   ir_assignment *lanes[4];
+   ir_rvalue *trees[4];
+   unsigned n = 0;
+
+   for (unsigned i = 0; i < 4; i++) {
+      if (run[i]) {
+	 lanes[n] = run[i];
+	 trees[n] = run[i]->rhs;
+	 n++;
+      }
+      run[i] = NULL;
+   }
+
+   const unsigned write_mask = run_mask;
+   run_mask = 0;
+
+   if (n < 2)
+      return false;
+
+   lanes[0]->rhs = widen_lane_trees(trees, n);
+   lanes[0]->write_mask = write_mask;
+
+   for (unsigned k = 1; k < n; k++)
+      lanes[k]->remove();
+
+   return true;
+}
+
+static void
+vectorize_basic_block(ir_instruction *bb_first,
+		      ir_instruction *bb_last,
+		      void *data)
+{
+   struct vectorize_info *info = (struct vectorize_info *) data;
+   ir_assignment *run[4] = { NULL, NULL, NULL, NULL };
+   unsigned run_mask = 0;
+   ir_instruction *ir, *next;
+
+   /* The run's assignments are only removed when it is flushed, which
+    * never happens to an instruction past the current one.
+    */
+   for (ir = bb_first, next = (ir_instruction *)ir->next;
+	ir != bb_last->next;
+	ir = next, next = (ir_instruction *)ir->next) {
+      ir_assignment *assign = ir->as_assignment();
+
+      if (!assign || !is_lane_assignment(assign)) {
+	 info->progress = flush_run(run, run_mask) || info->progress;
+	 continue;
+      }
+
+      if (!can_join_run(run, run_mask, assign))
+	 info->progress = flush_run(run, run_mask) || info->progress;
+
+      for (unsigned i = 0; i < 4; i++) {
+	 if (assign->write_mask & (1 << i))
+	    run[i] = assign;
+      }
+      run_mask |= assign->write_mask;
+   }
+
+   info->progress = flush_run(run, run_mask) || info->progress;
+}
+
+} /* unnamed namespace */
+
+/**
+ * Packs runs of single-channel assignments into vector assignments.
+ */
+bool
+do_vectorize(exec_list *instructions)
+{
+   struct vectorize_info info;
+
+   info.progress = false;
+
+   call_for_basic_blocks(instructions, vectorize_basic_block, &info);
+
+   return info.progress;
+}
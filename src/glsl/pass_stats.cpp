@@ -0,0 +1,268 @@
+/*
+ * Copyright © 2013 The Mesa Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+/**
+ * \file pass_stats.cpp
+ * Collection and reporting of per-pass compiler statistics.
+ *
+ * Enabled with MESA_GLSL=stats, or --stats in the standalone compiler.
+ * Every compile and link then prints one line per pass, in the order the
+ * passes first ran:
+ *
+ *    GLSL stats: phase=link stage=fragment pass=copy_propagation runs=6
+ *    progress=2 time_us=85 nodes_delta=-40
+ *
+ * followed by a \c pass=total line whose \c nodes field is the size of the
+ * final IR.  The same text is sent through GL_ARB_debug_output as a
+ * performance message.  All fields are \c key=value pairs so the output
+ * can be collected by scripts.
+ *
+ * The standalone compiler's --bench=<n> adds up the statistics of n
+ * compiles and links of a whole corpus and reports them once.
+ */
+
+#include <stdio.h>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#include <sys/time.h>
+#endif
+
+#include "main/core.h"
+#include "main/errors.h"
+#include "main/shaderobj.h"
+#include "glsl_parser_extras.h"
+#include "ir.h"
+#include "ir_hierarchical_visitor.h"
+#include "pass_stats.h"
+
+
+struct glsl_pass_stat
+{
+   const char *pass;
+   unsigned runs;
+   unsigned progress;
+   int64_t time_ns;
+   int nodes_delta;
+};
+
+
+struct glsl_pass_stats
+{
+   const char *phase;
+   const char *stage;
+
+   struct glsl_pass_stat *passes;   /**< in the order they first ran */
+   unsigned num_passes;
+
+   int64_t time_ns;
+   unsigned nodes;                   /**< IR size after the last pass */
+};
+
+
+int64_t
+glsl_pass_stats_time_ns(void)
+{
+#if defined(__linux__)
+   struct timespec tv;
+   clock_gettime(CLOCK_MONOTONIC, &tv);
+   return tv.tv_nsec + tv.tv_sec * INT64_C(1000000000);
+#elif defined(_WIN32)
+   static LARGE_INTEGER frequency;
+   LARGE_INTEGER counter;
+   if (!frequency.QuadPart)
+      QueryPerformanceFrequency(&frequency);
+   QueryPerformanceCounter(&counter);
+   return counter.QuadPart * INT64_C(1000000000) / frequency.QuadPart;
+#else
+   struct timeval tv;
+   gettimeofday(&tv, NULL);
+   return tv.tv_usec * INT64_C(1000) + tv.tv_sec * INT64_C(1000000000);
+#endif
+}
+
+
+static void
+count_node(ir_instruction *ir, void *data)
+{
+   (void) ir;
+   (*(unsigned *) data)++;
+}
+
+
+/**
+ * Number of IR nodes, expressions and dereferences included, in \c ir.
+ */
+unsigned
+glsl_count_ir_nodes(exec_list *ir)
+{
+   unsigned count = 0;
+
+   foreach_list(node, ir) {
+      visit_tree((ir_instruction *) node, count_node, &count);
+   }
+
+   return count;
+}
+
+
+struct glsl_pass_stats *
+glsl_pass_stats_create(void *mem_ctx, const char *phase, const char *stage)
+{
+   struct glsl_pass_stats *stats = rzalloc(mem_ctx, struct glsl_pass_stats);
+
+   if (stats) {
+      stats->phase = phase;
+      stats->stage = stage;
+   }
+   return stats;
+}
+
+
+void
+glsl_pass_stats_record(struct glsl_pass_stats *stats, const char *pass,
+                       int64_t time_ns, unsigned nodes_before,
+                       unsigned nodes_after, bool progress)
+{
+   struct glsl_pass_stat *stat = NULL;
+
+   /* Pass names are string literals, so comparing pointers almost always
+    * finds them; strcmp catches the same name spelled in two places.
+    */
+   for (unsigned i = 0; i < stats->num_passes; i++) {
+      if (stats->passes[i].pass == pass ||
+          strcmp(stats->passes[i].pass, pass) == 0) {
+         stat = &stats->passes[i];
+         break;
+      }
+   }
+
+   if (stat == NULL) {
+      struct glsl_pass_stat *passes =
+         reralloc(stats, stats->passes, struct glsl_pass_stat,
+                  stats->num_passes + 1);
+      if (passes == NULL)
+         return;
+
+      stats->passes = passes;
+      stat = &passes[stats->num_passes++];
+      memset(stat, 0, sizeof(*stat));
+      stat->pass = pass;
+   }
+
+   stat->runs++;
+   if (progress)
+      stat->progress++;
+   stat->time_ns += time_ns;
+   stat->nodes_delta += (int) nodes_after - (int) nodes_before;
+
+   stats->time_ns += time_ns;
+   stats->nodes = nodes_after;
+}
+
+
+/**
+ * Print the statistics and send them through GL_ARB_debug_output, unless
+ * no pass ran.
+ */
+void
+glsl_pass_stats_report(struct gl_context *ctx,
+                       const struct glsl_pass_stats *stats)
+{
+   static GLuint msg_id = 0;
+
+   if (stats->num_passes == 0)
+      return;
+
+   char *report = ralloc_strdup(NULL, "");
+
+   for (unsigned i = 0; i < stats->num_passes; i++) {
+      const struct glsl_pass_stat *stat = &stats->passes[i];
+
+      ralloc_asprintf_append(&report,
+                             "GLSL stats: phase=%s stage=%s pass=%s runs=%u "
+                             "progress=%u time_us=%u nodes_delta=%d\n",
+                             stats->phase, stats->stage, stat->pass,
+                             stat->runs, stat->progress,
+                             (unsigned) (stat->time_ns / 1000),
+                             stat->nodes_delta);
+   }
+
+   ralloc_asprintf_append(&report,
+                          "GLSL stats: phase=%s stage=%s pass=total "
+                          "time_us=%u nodes=%u\n",
+                          stats->phase, stats->stage,
+                          (unsigned) (stats->time_ns / 1000), stats->nodes);
+
+   printf("%s", report);
+   _mesa_shader_debug(ctx, GL_DEBUG_TYPE_PERFORMANCE_ARB, &msg_id,
+                      report, strlen(report));
+
+   ralloc_free(report);
+}
+
+
+/**
+ * Start collecting statistics for every stage of \c ctx, if MESA_GLSL=stats
+ * is set and no collection is running yet.
+ *
+ * \return true if the caller must call glsl_pass_stats_end() when done
+ */
+bool
+glsl_pass_stats_begin(struct gl_context *ctx, const char *phase)
+{
+   if (!(ctx->Shader.Flags & GLSL_STATS) ||
+       ctx->ShaderCompilerOptions[0].PassStats != NULL)
+      return false;
+
+   for (unsigned i = 0; i < MESA_SHADER_TYPES; i++) {
+      const char *stage =
+         _mesa_glsl_shader_target_name(_mesa_shader_index_to_type(i));
+
+      ctx->ShaderCompilerOptions[i].PassStats =
+         glsl_pass_stats_create(NULL, phase, stage);
+   }
+
+   return true;
+}
+
+
+/**
+ * Report what glsl_pass_stats_begin() started collecting, for each stage
+ * that ran any pass, and stop collecting.
+ */
+void
+glsl_pass_stats_end(struct gl_context *ctx)
+{
+   for (unsigned i = 0; i < MESA_SHADER_TYPES; i++) {
+      struct glsl_pass_stats *stats = ctx->ShaderCompilerOptions[i].PassStats;
+
+      if (stats)
+         glsl_pass_stats_report(ctx, stats);
+
+      ralloc_free(stats);
+      ctx->ShaderCompilerOptions[i].PassStats = NULL;
+   }
+}
@@ -0,0 +1,112 @@
+/* -*- c++ -*- */
+/*
+ * Copyright © 2013 The Mesa Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+#ifndef GLSL_PASS_STATS_H
+#define GLSL_PASS_STATS_H
+
+#include <stdint.h>
+
+struct exec_list;
+struct gl_context;
+struct glsl_pass_stats;
+
+/**
+ * \file pass_stats.h
+ * Per-pass timings and IR sizes of one compile or link (MESA_GLSL=stats).
+ *
+ * While a compile or link is collecting statistics, the
+ * gl_shader_compiler_options::PassStats of each stage it works on points
+ * at a glsl_pass_stats, which the passes run through glsl_pass_timer
+ * report to.
+ */
+
+extern bool
+glsl_pass_stats_begin(struct gl_context *ctx, const char *phase);
+
+extern void
+glsl_pass_stats_end(struct gl_context *ctx);
+
+extern struct glsl_pass_stats *
+glsl_pass_stats_create(void *mem_ctx, const char *phase, const char *stage);
+
+extern void
+glsl_pass_stats_record(struct glsl_pass_stats *stats, const char *pass,
+                       int64_t time_ns, unsigned nodes_before,
+                       unsigned nodes_after, bool progress);
+
+extern void
+glsl_pass_stats_report(struct gl_context *ctx,
+                       const struct glsl_pass_stats *stats);
+
+extern unsigned
+glsl_count_ir_nodes(exec_list *ir);
+
+extern int64_t
+glsl_pass_stats_time_ns(void);
+
+
+/**
+ * Times one run of a pass over \c ir and counts the IR nodes around it.
+ *
+ * Does nothing, and costs nothing beyond a NULL check, when \c stats is
+ * NULL.
+ */
+class glsl_pass_timer {
+public:
+   glsl_pass_timer(struct glsl_pass_stats *stats, const char *pass,
+                   exec_list *ir)
+      : stats(stats), pass(pass), ir(ir), nodes_before(0), start(0)
+   {
+      if (stats) {
+         this->nodes_before = glsl_count_ir_nodes(ir);
+         this->start = glsl_pass_stats_time_ns();
+      }
+   }
+
+   /**
+    * Record the run.
+    * \return \c progress, so that a pass call can be wrapped in it
+    */
+   bool done(bool progress)
+   {
+      if (this->stats) {
+         const int64_t time = glsl_pass_stats_time_ns() - this->start;
+
+         glsl_pass_stats_record(this->stats, this->pass, time,
+                                this->nodes_before, glsl_count_ir_nodes(ir),
+                                progress);
+      }
+      return progress;
+   }
+
+private:
+   struct glsl_pass_stats *stats;
+   const char *pass;
+   exec_list *ir;
+   unsigned nodes_before;
+   int64_t start;
+};
+
+#endif /* GLSL_PASS_STATS_H */
@@ -32,6 +32,12 @@ extern void
 _mesa_glsl_compile_shader(struct gl_context *ctx, struct gl_shader *shader,
 			  bool dump_ast, bool dump_hir);
 
+extern void
+_mesa_glsl_destroy_shader_cache(struct gl_context *ctx);
+
+extern void
+_mesa_glsl_destroy_link_cache(struct gl_context *ctx);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
@@ -125,10 +125,8 @@ ralloc_size(const void *ctx, size_t size)
 void *
 rzalloc_size(const void *ctx, size_t size)
 {
-   void *ptr = ralloc_size(ctx, size);
-   if (likely(ptr != NULL))
-      memset(ptr, 0, size);
-   return ptr;
+   /* ralloc_size() gets its memory from calloc already */
+   return ralloc_size(ctx, size);
 }
 
 /* helper function - assumes ptr != NULL */
@@ -484,3 +482,83 @@ ralloc_vasprintf_rewrite_tail(char **str, size_t *start, const char *fmt,
    *start += new_length;
    return true;
 }
+
+/*
+ * Linear allocator
+ *
+ * Objects are carved out of large ralloc'd blocks, children of the linear
+ * context, so they have no header of their own and cost no malloc.  The
+ * blocks come from rzalloc and are never reused, so all objects start out
+ * zeroed.
+ */
+
+#define LINEAR_BLOCK_SIZE  (4096 - sizeof(ralloc_header))
+#define LINEAR_ALIGNMENT   8
+
+struct linear_ctx
+{
+   char *next;   /* first free byte of the current block */
+   char *end;    /* end of the current block */
+};
+
+void *
+linear_alloc_context(const void *ctx)
+{
+   return rzalloc(ctx, struct linear_ctx);
+}
+
+void *
+linear_alloc(void *lin_ctx, size_t size)
+{
+   struct linear_ctx *lin = (struct linear_ctx *) lin_ctx;
+   void *ptr;
+
+   size = (size + LINEAR_ALIGNMENT - 1) & ~(size_t) (LINEAR_ALIGNMENT - 1);
+
+   if (unlikely(size > (size_t) (lin->end - lin->next))) {
+      char *block;
+
+      /* Big objects get a block of their own, so that the rest of the
+       * current block isn't wasted.
+       */
+      if (size > LINEAR_BLOCK_SIZE / 4)
+         return rzalloc_size(lin, size);
+
+      block = rzalloc_size(lin, LINEAR_BLOCK_SIZE);
+      if (unlikely(block == NULL))
+         return NULL;
+
+      lin->next = block;
+      lin->end = block + LINEAR_BLOCK_SIZE;
+   }
+
+   ptr = lin->next;
+   lin->next += size;
+   return ptr;
+}
+
+void *
+linear_zalloc(void *lin_ctx, size_t size)
+{
+   /* Linear memory is never reused, so it is still zeroed */
+   return linear_alloc(lin_ctx, size);
+}
+
+char *
+linear_strdup(void *lin_ctx, const char *str)
+{
+   size_t n;
+   char *ptr;
+
+   if (unlikely(str == NULL))
+      return NULL;
+
+   n = strlen(str);
+   ptr = linear_alloc(lin_ctx, n + 1);
+   if (unlikely(ptr == NULL))
+      return NULL;
+
+   memcpy(ptr, str, n);
+   ptr[n] = '\0';
+   return ptr;
+}
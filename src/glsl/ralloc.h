@@ -400,6 +400,41 @@ bool ralloc_asprintf_append (char **str, const char *fmt, ...)
 bool ralloc_vasprintf_append(char **str, const char *fmt, va_list args);
 /// @}
 
+/// \defgroup linear Linear Allocators @{
+
+/**
+ * Allocate a linear context chained off of the given ralloc context.
+ *
+ * Objects allocated out of a linear context are packed into large blocks,
+ * without a ralloc header or a malloc call of their own.  They can't be
+ * freed, resized or stolen individually: they all go away together when
+ * the linear context, or one of its ancestors, is freed.  This suits
+ * large numbers of small objects with the same lifetime, e.g. the AST of a
+ * shader.
+ *
+ * The linear context itself is an ordinary ralloc pointer, so it can be
+ * freed with ralloc_free() and used as the parent of other allocations.
+ */
+void *linear_alloc_context(const void *ctx);
+
+/**
+ * Allocate memory out of a linear context.
+ *
+ * The memory is aligned to 8 bytes.
+ */
+void *linear_alloc(void *lin_ctx, size_t size);
+
+/**
+ * Allocate zero-initialized memory out of a linear context.
+ */
+void *linear_zalloc(void *lin_ctx, size_t size);
+
+/**
+ * Duplicate a string, allocating the memory out of a linear context.
+ */
+char *linear_strdup(void *lin_ctx, const char *str);
+/// @}
+
 #ifdef __cplusplus
 } /* end of extern "C" */
 #endif
@@ -0,0 +1,277 @@
+/*
+ * Copyright © 2013 The Mesa Authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file shader_cache.cpp
+ * Per-context cache of compiled shaders, keyed by their source.
+ *
+ * Applications commonly compile the same source many times, e.g. one vertex
+ * shader for each of the programs using it.  What _mesa_glsl_compile_shader()
+ * leaves in a gl_shader only depends on the shader stage, the source and on
+ * context state that is fixed once the context is created (API, extensions,
+ * limits and compiler options).  So a copy of the optimized IR of every
+ * successful compile is kept, and later shaders with the same stage and
+ * source get a clone of it instead of being preprocessed, parsed and
+ * optimized again.  The shader's uniform blocks are kept along with it.
+ *
+ * The cache only lives in memory, for the life of the context: the IR
+ * holds pointers to glsl_types and to the built-in shaders, and there is
+ * no serialization format for it that could be stored on disk.
+ *
+ * The linker only ever works on clones of the IR, so whatever it does to a
+ * shader's variables does not leak into the cached copy.
+ *
+ * Setting MESA_GLSL=nocache disables the cache.
+ */
+
+#include "main/core.h"
+#include "main/hash_table.h"
+#include "glsl_symbol_table.h"
+#include "ir.h"
+#include "link_cache.h"
+#include "program.h"
+#include "shader_cache.h"
+
+
+/** Most compiled shaders kept per context; the oldest ones go first */
+#define SHADER_CACHE_MAX_ENTRIES 1024
+
+
+struct shader_cache_entry
+{
+   struct exec_node link;       /**< in glsl_shader_cache::entries */
+   uint32_t hash;
+
+   GLenum type;
+   char *source;
+
+   exec_list *ir;
+   char *info_log;
+   unsigned version;
+   bool is_es;
+   struct gl_shader *builtins_to_link[16];
+   unsigned num_builtins_to_link;
+   struct gl_uniform_block *uniform_blocks;
+   unsigned num_uniform_blocks;
+};
+
+
+struct glsl_shader_cache
+{
+   struct hash_table *ht;
+   exec_list entries;           /**< oldest first */
+   unsigned num_entries;
+};
+
+
+static uint32_t
+entry_hash(GLenum type, const char *source)
+{
+   return _mesa_hash_string(source) ^ type;
+}
+
+
+static bool
+entry_equal(const void *a, const void *b)
+{
+   const struct shader_cache_entry *ea = (const struct shader_cache_entry *) a;
+   const struct shader_cache_entry *eb = (const struct shader_cache_entry *) b;
+
+   return ea->type == eb->type && strcmp(ea->source, eb->source) == 0;
+}
+
+
+static struct glsl_shader_cache *
+get_cache(struct gl_context *ctx)
+{
+   struct glsl_shader_cache *cache = ctx->Shader.CompileCache;
+
+   if (cache || (ctx->Shader.Flags & GLSL_NO_CACHE))
+      return cache;
+
+   cache = rzalloc(NULL, struct glsl_shader_cache);
+   if (!cache)
+      return NULL;
+
+   cache->ht = _mesa_hash_table_create(cache, entry_equal);
+   if (!cache->ht) {
+      ralloc_free(cache);
+      return NULL;
+   }
+   cache->entries.make_empty();
+
+   ctx->Shader.CompileCache = cache;
+   return cache;
+}
+
+
+static struct shader_cache_entry *
+find_entry(struct glsl_shader_cache *cache, GLenum type, const char *source)
+{
+   struct shader_cache_entry key;
+   struct hash_entry *he;
+
+   key.type = type;
+   key.source = (char *) source;
+
+   he = _mesa_hash_table_search(cache->ht, entry_hash(type, source), &key);
+   return he ? (struct shader_cache_entry *) he->data : NULL;
+}
+
+
+static void
+evict_oldest(struct glsl_shader_cache *cache)
+{
+   struct shader_cache_entry *entry =
+      exec_node_data(struct shader_cache_entry, cache->entries.head, link);
+   struct hash_entry *he;
+
+   he = _mesa_hash_table_search(cache->ht, entry->hash, entry);
+   if (he)
+      _mesa_hash_table_remove(cache->ht, he);
+
+   entry->link.remove();
+   cache->num_entries--;
+   ralloc_free(entry);
+}
+
+
+/**
+ * Give \c shader the result of an earlier compile of the same source.
+ *
+ * \return true on a hit, in which case \c shader is compiled, false if it
+ *         still needs to be compiled
+ */
+bool
+shader_cache_lookup(struct gl_context *ctx, struct gl_shader *shader)
+{
+   struct glsl_shader_cache *cache = get_cache(ctx);
+   struct shader_cache_entry *entry;
+
+   if (!cache || !shader->Source)
+      return false;
+
+   entry = find_entry(cache, shader->Type, shader->Source);
+   if (!entry)
+      return false;
+
+   ralloc_free(shader->ir);
+   shader->ir = new(shader) exec_list;
+   clone_ir_list(shader, shader->ir, entry->ir);
+
+   /* The linker looks up main() and the built-in variables here */
+   shader->symbols = new(shader) glsl_symbol_table;
+   foreach_list(node, shader->ir) {
+      ir_instruction *const inst = (ir_instruction *) node;
+      ir_variable *var;
+      ir_function *func;
+
+      if ((func = inst->as_function()) != NULL) {
+         shader->symbols->add_function(func);
+      } else if ((var = inst->as_variable()) != NULL) {
+         shader->symbols->add_variable(var);
+      }
+   }
+
+   if (shader->InfoLog)
+      ralloc_free(shader->InfoLog);
+   shader->InfoLog = ralloc_strdup(shader, entry->info_log);
+
+   shader->CompileStatus = true;
+   shader->Version = entry->version;
+   shader->IsES = entry->is_es;
+
+   memcpy(shader->builtins_to_link, entry->builtins_to_link,
+          sizeof(shader->builtins_to_link[0]) * entry->num_builtins_to_link);
+   shader->num_builtins_to_link = entry->num_builtins_to_link;
+
+   if (shader->UniformBlocks)
+      ralloc_free(shader->UniformBlocks);
+   shader->UniformBlocks = copy_uniform_blocks(shader, entry->uniform_blocks,
+                                               entry->num_uniform_blocks);
+   shader->NumUniformBlocks = entry->num_uniform_blocks;
+
+   return true;
+}
+
+
+/**
+ * Remember the result of compiling \c shader.
+ */
+void
+shader_cache_insert(struct gl_context *ctx, const struct gl_shader *shader)
+{
+   struct glsl_shader_cache *cache = get_cache(ctx);
+   struct shader_cache_entry *entry;
+
+   if (!cache || !shader->Source || !shader->CompileStatus)
+      return;
+
+   if (find_entry(cache, shader->Type, shader->Source))
+      return;
+
+   if (cache->num_entries >= SHADER_CACHE_MAX_ENTRIES)
+      evict_oldest(cache);
+
+   entry = rzalloc(cache, struct shader_cache_entry);
+   if (!entry)
+      return;
+
+   entry->type = shader->Type;
+   entry->source = ralloc_strdup(entry, shader->Source);
+   entry->hash = entry_hash(entry->type, entry->source);
+
+   entry->ir = new(entry) exec_list;
+   clone_ir_list(entry, entry->ir, shader->ir);
+
+   entry->info_log = ralloc_strdup(entry, shader->InfoLog ? shader->InfoLog : "");
+   entry->version = shader->Version;
+   entry->is_es = shader->IsES;
+
+   memcpy(entry->builtins_to_link, shader->builtins_to_link,
+          sizeof(entry->builtins_to_link[0]) * shader->num_builtins_to_link);
+   entry->num_builtins_to_link = shader->num_builtins_to_link;
+
+   entry->uniform_blocks = copy_uniform_blocks(entry, shader->UniformBlocks,
+                                               shader->NumUniformBlocks);
+   entry->num_uniform_blocks = shader->NumUniformBlocks;
+
+   _mesa_hash_table_insert(cache->ht, entry->hash, entry, entry);
+   cache->entries.push_tail(&entry->link);
+   cache->num_entries++;
+}
+
+
+extern "C" {
+
+/**
+ * Free the context's compiled shader cache.
+ */
+void
+_mesa_glsl_destroy_shader_cache(struct gl_context *ctx)
+{
+   ralloc_free(ctx->Shader.CompileCache);
+   ctx->Shader.CompileCache = NULL;
+}
+
+} /* extern "C" */
@@ -24,6 +24,7 @@
 #if defined(GLX_DIRECT_RENDERING) && !defined(GLX_USE_APPLEGL)
 
 #include <X11/Xlib.h>
+#include <X11/extensions/XShm.h>
 #include "glxclient.h"
 #include <dlfcn.h>
 #include "dri_common.h"
@@ -49,6 +50,7 @@ struct drisw_screen
    const __DRIcoreExtension *core;
    const __DRIswrastExtension *swrast;
    const __DRItexBufferExtension *texBuffer;
+   const __DRIcopySubBufferExtension *copySubBuffer;
 
    const __DRIconfig **driver_configs;
 
@@ -65,6 +67,10 @@ struct drisw_drawable
    __DRIdrawable *driDrawable;
    XVisualInfo *visinfo;
    XImage *ximage;
+
+   /* the driver's shared memory segment attached to the server, if any */
+   Bool xshm;
+   XShmSegmentInfo shminfo;
 };
 
 static Bool
@@ -111,12 +117,18 @@ XCreateDrawable(struct drisw_drawable * pdp,
   if (pdp->ximage->bits_per_pixel == 24)
      pdp->ximage->bits_per_pixel = 32;
 
+   pdp->xshm = XShmQueryExtension(dpy);
+   pdp->shminfo.shmid = -1;
+
    return True;
 }
 
 static void
 XDestroyDrawable(struct drisw_drawable * pdp, Display * dpy, XID drawable)
 {
+   if (pdp->shminfo.shmid >= 0)
+      XShmDetach(dpy, &pdp->shminfo);
+
    XDestroyImage(pdp->ximage);
    free(pdp->visinfo);
 
@@ -206,6 +218,104 @@ swrastPutImage(__DRIdrawable * draw, int op,
    ximage->data = NULL;
 }
 
+static int xshm_error = 0;
+
+static int
+handle_xerror(Display *dpy, XErrorEvent *event)
+{
+   (void) dpy;
+   xshm_error = event->error_code;
+   return 0;
+}
+
+/**
+ * Attach the driver's segment shmid to the server instead of the one
+ * attached before.  That fails when the server can't see our memory, eg.
+ * over the network, and we then stop trying.
+ */
+static Bool
+XAttachShm(struct drisw_drawable * pdp, Display * dpy,
+           int shmid, char *shmaddr)
+{
+   int (*old_handler)(Display *, XErrorEvent *);
+
+   if (pdp->shminfo.shmid >= 0) {
+      XShmDetach(dpy, &pdp->shminfo);
+      pdp->shminfo.shmid = -1;
+   }
+
+   pdp->shminfo.shmseg = 0;
+   pdp->shminfo.shmid = shmid;
+   pdp->shminfo.shmaddr = shmaddr;
+   pdp->shminfo.readOnly = True;
+
+   XSync(dpy, False);
+   xshm_error = 0;
+   old_handler = XSetErrorHandler(handle_xerror);
+   XShmAttach(dpy, &pdp->shminfo);
+   XSync(dpy, False);
+   XSetErrorHandler(old_handler);
+
+   if (xshm_error) {
+      pdp->shminfo.shmid = -1;
+      pdp->xshm = False;
+      return False;
+   }
+
+   return True;
+}
+
+static void
+swrastPutImageShm(__DRIdrawable * draw, int op,
+                  int x, int y, int w, int h, int stride,
+                  int shmid, char *shmaddr, unsigned offset,
+                  void *loaderPrivate)
+{
+   struct drisw_drawable *pdp = loaderPrivate;
+   __GLXDRIdrawable *pdraw = &(pdp->base);
+   Display *dpy = pdraw->psc->dpy;
+   Drawable drawable;
+   XImage *ximage;
+   GC gc;
+
+   switch (op) {
+   case __DRI_SWRAST_IMAGE_OP_DRAW:
+      gc = pdp->gc;
+      break;
+   case __DRI_SWRAST_IMAGE_OP_SWAP:
+      gc = pdp->swapgc;
+      break;
+   default:
+      return;
+   }
+
+   drawable = pdraw->xDrawable;
+
+   ximage = pdp->ximage;
+   ximage->data = shmaddr + offset;
+   ximage->width = stride * 8 / ximage->bits_per_pixel;
+   ximage->height = h;
+   ximage->bytes_per_line = stride;
+
+   if (pdp->xshm &&
+       (pdp->shminfo.shmid == shmid || XAttachShm(pdp, dpy, shmid, shmaddr))) {
+      /* XShmPutImage() takes the segment from obdata, which XDestroyImage()
+       * would free.
+       */
+      ximage->obdata = (char *) &pdp->shminfo;
+      XShmPutImage(dpy, drawable, gc, ximage, 0, 0, x, y, w, h, False);
+      ximage->obdata = NULL;
+
+      /* the driver may draw into the image as soon as we return */
+      XSync(dpy, False);
+   }
+   else {
+      XPutImage(dpy, drawable, gc, ximage, 0, 0, x, y, w, h);
+   }
+
+   ximage->data = NULL;
+}
+
 static void
 swrastGetImage(__DRIdrawable * read,
                int x, int y, int w, int h,
@@ -234,7 +344,8 @@ static const __DRIswrastLoaderExtension swrastLoaderExtension = {
    {__DRI_SWRAST_LOADER, __DRI_SWRAST_LOADER_VERSION},
    swrastGetDrawableInfo,
    swrastPutImage,
-   swrastGetImage
+   swrastGetImage,
+   swrastPutImageShm
 };
 
 static const __DRIextension *loader_extensions[] = {
@@ -570,6 +681,21 @@ driswSwapBuffers(__GLXDRIdrawable * pdraw,
    return 0;
 }
 
+static void
+driswCopySubBuffer(__GLXDRIdrawable * pdraw,
+                   int x, int y, int width, int height, Bool flush)
+{
+   struct drisw_drawable *pdp = (struct drisw_drawable *) pdraw;
+   struct drisw_screen *psc = (struct drisw_screen *) pdp->base.psc;
+
+   if (flush) {
+      glFlush();
+   }
+
+   (*psc->copySubBuffer->copySubBuffer) (pdp->driDrawable,
+					 x, y, width, height);
+}
+
 static void
 driswDestroyScreen(struct glx_screen *base)
 {
@@ -624,6 +750,11 @@ driswBindExtensions(struct drisw_screen *psc, const __DRIextension **extensions)
 	 psc->texBuffer = (__DRItexBufferExtension *) extensions[i];
 	 __glXEnableDirectExtension(&psc->base, "GLX_EXT_texture_from_pixmap");
       }
+
+      if (strcmp(extensions[i]->name, __DRI_COPY_SUB_BUFFER) == 0) {
+	 psc->copySubBuffer = (__DRIcopySubBufferExtension *) extensions[i];
+	 __glXEnableDirectExtension(&psc->base, "GLX_MESA_copy_sub_buffer");
+      }
    }
 }
 
@@ -699,6 +830,9 @@ driswCreateScreen(int screen, struct glx_display *priv)
    psp->createDrawable = driswCreateDrawable;
    psp->swapBuffers = driswSwapBuffers;
 
+   if (psc->copySubBuffer)
+      psp->copySubBuffer = driswCopySubBuffer;
+
    return &psc->base;
 
  handle_error:
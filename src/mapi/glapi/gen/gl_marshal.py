@@ -0,0 +1,269 @@
+#!/usr/bin/env python
+
+# Copyright (C) 2013 Intel Corporation
+#
+# Permission is hereby granted, free of charge, to any person obtaining a
+# copy of this software and associated documentation files (the "Software"),
+# to deal in the Software without restriction, including without limitation
+# the rights to use, copy, modify, merge, publish, distribute, sublicense,
+# and/or sell copies of the Software, and to permit persons to whom the
+# Software is furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice (including the next
+# paragraph) shall be included in all copies or substantial portions of the
+# Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+# THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+# FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+# IN THE SOFTWARE.
+
+# This script generates the file marshal_generated.c, which contains the
+# functions that record GL calls into a glthread batch, the functions that
+# replay them on the glthread worker, and _mesa_create_marshal_table().
+#
+# A function is marshalled asynchronously when everything it needs can be
+# copied into the batch: it returns nothing and its only pointer parameters
+# are fixed-size input arrays.  Every other function waits for the worker to
+# drain the queue and then runs on the calling thread.
+
+import license
+import gl_XML
+import sys, getopt
+
+
+# Functions without pointer parameters which nonetheless must not be
+# deferred: they either have to complete before returning, or read client
+# memory (vertex arrays) that the application may change once the call
+# returns.
+sync_functions = set([
+    'Finish',
+    'ArrayElement',
+    'DrawArrays',
+    'DrawArraysInstancedARB',
+    'DrawArraysInstancedBaseInstance',
+    'DrawTransformFeedback',
+    'DrawTransformFeedbackStream',
+    'DrawTransformFeedbackInstanced',
+    'DrawTransformFeedbackStreamInstanced',
+    ])
+
+# Functions that are deferred, but after which the batch is handed to the
+# worker right away rather than when it fills up.
+flush_functions = set([
+    'Flush',
+    ])
+
+
+header = """/**
+ * \\file marshal_generated.c
+ * Marshalling of GL calls for the glthread worker.
+ */
+
+
+#include "main/api_exec.h"
+#include "main/context.h"
+#include "main/dispatch.h"
+#include "main/glthread.h"
+#include "main/imports.h"
+#include "main/marshal.h"
+#include "main/mtypes.h"
+
+#ifdef HAVE_PTHREAD
+"""
+
+
+footer = """
+#endif /* HAVE_PTHREAD */
+"""
+
+
+def api_condition_exists(f):
+    """Whether f is part of any API, as in gl_genexec.py."""
+    return f.desktop or 'es1' in f.api_map or 'es2' in f.api_map
+
+
+def copied_params(f):
+    return [p for p in f.parameterIterator() if not p.is_padding]
+
+
+def array_elements(p):
+    return p.count * p.count_scale
+
+
+def is_async(f):
+    if f.name in sync_functions:
+        return False
+    if f.return_type != 'void':
+        return False
+    for p in copied_params(f):
+        if not p.is_pointer():
+            continue
+        if p.is_output or p.is_image() or p.is_variable_length():
+            return False
+        if p.count <= 0 or p.get_base_type_string() in ('GLvoid', 'void'):
+            return False
+    return True
+
+
+class PrintCode(gl_XML.gl_print_base):
+
+    def __init__(self):
+        gl_XML.gl_print_base.__init__(self)
+
+        self.name = 'gl_marshal.py'
+        self.license = license.bsd_license_template % (
+            'Copyright (C) 2013 Intel Corporation',
+            'Intel Corporation')
+
+    def printRealHeader(self):
+        print header
+
+    def printRealFooter(self):
+        print footer
+
+    def print_async(self, f):
+        params = copied_params(f)
+
+        print '/* %s: marshalled asynchronously */' % (f.name)
+        print 'struct marshal_cmd_%s' % (f.name)
+        print '{'
+        print '   struct marshal_cmd_base cmd_base;'
+        for p in params:
+            if p.is_pointer():
+                print '   %s %s[%d];' % (p.get_base_type_string(), p.name,
+                                        array_elements(p))
+            else:
+                print '   %s %s;' % (p.type_string(), p.name)
+        print '};'
+        print
+
+        print 'static inline void'
+        print '_mesa_unmarshal_%s(struct gl_context *ctx,' % (f.name)
+        print '   const struct marshal_cmd_%s *cmd)' % (f.name)
+        print '{'
+        print '   CALL_%s(ctx->CurrentDispatch, (%s));' % (
+            f.name, ', '.join(['cmd->' + p.name for p in params]))
+        print '}'
+        print
+
+        print 'static void GLAPIENTRY'
+        print '_mesa_marshal_%s(%s)' % (f.name, f.get_parameter_string())
+        print '{'
+        print '   GET_CURRENT_CONTEXT(ctx);'
+        print '   struct marshal_cmd_%s *cmd =' % (f.name)
+        print '      _mesa_glthread_allocate_command(ctx, DISPATCH_CMD_%s,' % (
+            f.name)
+        print '                                      sizeof(*cmd));'
+        for p in params:
+            if p.is_pointer():
+                print '   memcpy(cmd->%s, %s, sizeof(cmd->%s));' % (
+                    p.name, p.name, p.name)
+            else:
+                print '   cmd->%s = %s;' % (p.name, p.name)
+        if f.name in flush_functions:
+            print '   _mesa_glthread_flush_batch(ctx);'
+        print '}'
+        print
+
+    def print_sync(self, f):
+        call = 'CALL_%s(ctx->CurrentDispatch, (%s))' % (
+            f.name, f.get_called_parameter_string())
+
+        print '/* %s: marshalled synchronously */' % (f.name)
+        print 'static %s GLAPIENTRY' % (f.return_type)
+        print '_mesa_marshal_%s(%s)' % (f.name, f.get_parameter_string())
+        print '{'
+        print '   GET_CURRENT_CONTEXT(ctx);'
+        print '   _mesa_glthread_finish(ctx);'
+        if f.return_type != 'void':
+            print '   %s result = %s;' % (f.return_type, call)
+            print '   _mesa_glthread_restore_dispatch(ctx);'
+            print '   return result;'
+        else:
+            print '   %s;' % (call)
+            print '   _mesa_glthread_restore_dispatch(ctx);'
+        print '}'
+        print
+
+    def printBody(self, api):
+        # Only functions with a dispatch table slot can be marshalled.
+        functions = sorted([f for f in api.functionIterateByOffset()
+                            if api_condition_exists(f)],
+                           key=lambda f: f.name)
+        async_functions = [f for f in functions if is_async(f)]
+
+        print 'enum marshal_dispatch_cmd_id'
+        print '{'
+        for f in async_functions:
+            print '   DISPATCH_CMD_%s,' % (f.name)
+        print '   NUM_DISPATCH_CMD'
+        print '};'
+        print
+
+        for f in functions:
+            if is_async(f):
+                self.print_async(f)
+            else:
+                self.print_sync(f)
+
+        print 'size_t'
+        print '_mesa_unmarshal_dispatch_cmd(struct gl_context *ctx,'
+        print '                             const void *cmd)'
+        print '{'
+        print '   const struct marshal_cmd_base *cmd_base = cmd;'
+        print
+        print '   switch (cmd_base->cmd_id) {'
+        for f in async_functions:
+            print '   case DISPATCH_CMD_%s:' % (f.name)
+            print '      _mesa_unmarshal_%s(ctx, cmd);' % (f.name)
+            print '      break;'
+        print '   default:'
+        print '      assert(!"Unrecognized command ID");'
+        print '      break;'
+        print '   }'
+        print
+        print '   return cmd_base->cmd_size;'
+        print '}'
+        print
+
+        print 'struct _glapi_table *'
+        print '_mesa_create_marshal_table(const struct gl_context *ctx)'
+        print '{'
+        print '   struct _glapi_table *table;'
+        print
+        print '   table = _mesa_alloc_dispatch_table();'
+        print '   if (table == NULL)'
+        print '      return NULL;'
+        print
+        for f in functions:
+            print '   SET_%s(table, _mesa_marshal_%s);' % (f.name, f.name)
+        print
+        print '   return table;'
+        print '}'
+
+
+def show_usage():
+    print "Usage: %s [-f input_file_name]" % sys.argv[0]
+    sys.exit(1)
+
+
+if __name__ == '__main__':
+    file_name = "gl_and_es_API.xml"
+
+    try:
+        (args, trail) = getopt.getopt(sys.argv[1:], "m:f:")
+    except Exception,e:
+        show_usage()
+
+    for (arg,val) in args:
+        if arg == "-f":
+            file_name = val
+
+    printer = PrintCode()
+
+    api = gl_XML.parse_GL_API(file_name)
+    printer.Print(api)
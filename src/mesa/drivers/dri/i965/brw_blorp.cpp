@@ -102,10 +102,11 @@ brw_blorp_surface_info::set(struct brw_context *brw,
       this->brw_surfaceformat = BRW_SURFACEFORMAT_R8G8_UNORM;
       break;
    default:
-      /* Blorp blits don't support any sort of format conversion (except
-       * between sRGB and linear), so we can safely assume that the format is
-       * supported as a render target, even if this is the source image.  So
-       * we can convert to a surface format using brw->render_target_format.
+      /* Blorp blits only convert between formats that can both be rendered
+       * to (see color_formats_convertible()), so we can safely assume that
+       * the format is supported as a render target, even if this is the
+       * source image.  So we can convert to a surface format using
+       * brw->render_target_format.
        */
       assert(brw->format_supported_as_render_target[mt->format]);
       this->brw_surfaceformat = brw->render_target_format[mt->format];
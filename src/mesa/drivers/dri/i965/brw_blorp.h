@@ -44,7 +44,7 @@ brw_blorp_blit_miptrees(struct intel_context *intel,
                         float src_x1, float src_y1,
                         float dst_x0, float dst_y0,
                         float dst_x1, float dst_y1,
-                        bool mirror_x, bool mirror_y);
+                        bool mirror_x, bool mirror_y, GLenum filter);
 
 bool
 brw_blorp_clear_color(struct intel_context *intel, struct gl_framebuffer *fb,
@@ -319,6 +319,13 @@ struct brw_blorp_blit_prog_key
     * than one sample per pixel.
     */
    bool persample_msaa_dispatch;
+
+   /* True if the source should be sampled with bilinear filtering at
+    * normalized coordinates rather than fetched from the nearest texel.  If
+    * true, tex_samples must be 0, src_tiled_w must be false and
+    * texture_data_type must be BRW_REGISTER_TYPE_F.
+    */
+   bool bilinear_filter;
 };
 
 class brw_blorp_blit_params : public brw_blorp_params
@@ -333,7 +340,7 @@ public:
                          GLfloat src_x1, GLfloat src_y1,
                          GLfloat dst_x0, GLfloat dst_y0,
                          GLfloat dst_x1, GLfloat dst_y1,
-                         bool mirror_x, bool mirror_y);
+                         bool mirror_x, bool mirror_y, GLenum filter);
 
    virtual uint32_t get_wm_prog(struct brw_context *brw,
                                 brw_blorp_prog_data **prog_data) const;
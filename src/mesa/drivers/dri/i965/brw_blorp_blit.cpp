@@ -22,6 +22,8 @@
  */
 
 #include "main/teximage.h"
+#include "main/mipmap.h"
+#include "main/texobj.h"
 #include "main/fbobject.h"
 #include "main/renderbuffer.h"
 
@@ -133,7 +135,7 @@ brw_blorp_blit_miptrees(struct intel_context *intel,
                         float src_x1, float src_y1,
                         float dst_x0, float dst_y0,
                         float dst_x1, float dst_y1,
-                        bool mirror_x, bool mirror_y)
+                        bool mirror_x, bool mirror_y, GLenum filter)
 {
    /* Get ready to blit.  This includes depth resolving the src and dst
     * buffers if necessary.  Note: it's not necessary to do a color resolve on
@@ -146,13 +148,13 @@ brw_blorp_blit_miptrees(struct intel_context *intel,
    intel_miptree_slice_resolve_depth(intel, dst_mt, dst_level, dst_layer);
 
    DBG("%s from %s mt %p %d %d (%f,%f) (%f,%f)"
-       "to %s mt %p %d %d (%f,%f) (%f,%f) (flip %d,%d)\n",
+       "to %s mt %p %d %d (%f,%f) (%f,%f) (flip %d,%d) (%s)\n",
        __FUNCTION__,
        _mesa_get_format_name(src_mt->format), src_mt,
        src_level, src_layer, src_x0, src_y0, src_x1, src_y1,
        _mesa_get_format_name(dst_mt->format), dst_mt,
        dst_level, dst_layer, dst_x0, dst_y0, dst_x1, dst_y1,
-       mirror_x, mirror_y);
+       mirror_x, mirror_y, filter == GL_LINEAR ? "linear" : "nearest");
 
    brw_blorp_blit_params params(brw_context(&intel->ctx),
                                 src_mt, src_level, src_layer,
@@ -161,7 +163,7 @@ brw_blorp_blit_miptrees(struct intel_context *intel,
                                 src_x1, src_y1,
                                 dst_x0, dst_y0,
                                 dst_x1, dst_y1,
-                                mirror_x, mirror_y);
+                                mirror_x, mirror_y, filter);
    brw_blorp_exec(intel, &params);
 
    intel_miptree_slice_set_needs_hiz_resolve(dst_mt, dst_level, dst_layer);
@@ -173,7 +175,7 @@ do_blorp_blit(struct intel_context *intel, GLbitfield buffer_bit,
               struct intel_renderbuffer *dst_irb,
               GLfloat srcX0, GLfloat srcY0, GLfloat srcX1, GLfloat srcY1,
               GLfloat dstX0, GLfloat dstY0, GLfloat dstX1, GLfloat dstY1,
-              bool mirror_x, bool mirror_y)
+              bool mirror_x, bool mirror_y, GLenum filter)
 {
    /* Find source/dst miptrees */
    struct intel_mipmap_tree *src_mt = find_miptree(buffer_bit, src_irb);
@@ -185,7 +187,7 @@ do_blorp_blit(struct intel_context *intel, GLbitfield buffer_bit,
                            dst_mt, dst_irb->mt_level, dst_irb->mt_layer,
                            srcX0, srcY0, srcX1, srcY1,
                            dstX0, dstY0, dstX1, dstY1,
-                           mirror_x, mirror_y);
+                           mirror_x, mirror_y, filter);
 
    intel_renderbuffer_set_needs_downsample(dst_irb);
 }
@@ -207,6 +209,37 @@ color_formats_match(gl_format src_format, gl_format dst_format)
            linear_dst_format == MESA_FORMAT_XRGB8888);
 }
 
+/**
+ * Can blorp read from a surface of this color format and write the result to
+ * a different one?  The sampler and the render target both work in float for
+ * these formats, so the conversion happens for free on the way through the
+ * shader.  Integer formats, whose values would be reinterpreted, and sRGB
+ * formats, for which we don't want to decode on read without encoding on
+ * write, are excluded.
+ */
+static bool
+color_format_is_convertible(struct brw_context *brw, gl_format format)
+{
+   GLenum base_format = _mesa_get_format_base_format(format);
+
+   return base_format != GL_DEPTH_COMPONENT &&
+          base_format != GL_STENCIL_INDEX &&
+          base_format != GL_DEPTH_STENCIL &&
+          !_mesa_is_format_integer_color(format) &&
+          _mesa_get_format_color_encoding(format) == GL_LINEAR &&
+          brw->format_supported_as_render_target[format] &&
+          brw_format_for_mesa_format(format) != 0;
+}
+
+static bool
+color_formats_convertible(struct brw_context *brw,
+                          gl_format src_format, gl_format dst_format)
+{
+   return color_formats_match(src_format, dst_format) ||
+          (color_format_is_convertible(brw, src_format) &&
+           color_format_is_convertible(brw, dst_format));
+}
+
 static bool
 formats_match(GLbitfield buffer_bit, struct intel_renderbuffer *src_irb,
               struct intel_renderbuffer *dst_irb)
@@ -245,13 +278,13 @@ try_blorp_blit(struct intel_context *intel,
    fixup_mirroring(mirror_y, srcY0, srcY1);
    fixup_mirroring(mirror_y, dstY0, dstY1);
 
-   /* Linear filtering is not yet implemented in blorp engine. So, fallback
-    * to other blit paths.
+   /* Blorp can only filter single-sampled float color buffers; everything
+    * else goes through the nearest texel fetch path.
     */
-   if ((srcX1 - srcX0 != dstX1 - dstX0 ||
-        srcY1 - srcY0 != dstY1 - dstY0) &&
-       filter == GL_LINEAR)
-      return false;
+   bool scaled = srcX1 - srcX0 != dstX1 - dstX0 ||
+                 srcY1 - srcY0 != dstY1 - dstY0;
+   if (!scaled)
+      filter = GL_NEAREST;
 
    /* If the destination rectangle needs to be clipped or scissored, do so.
     */
@@ -294,9 +327,16 @@ try_blorp_blit(struct intel_context *intel,
    switch (buffer_bit) {
    case GL_COLOR_BUFFER_BIT:
       src_irb = intel_renderbuffer(read_fb->_ColorReadBuffer);
+      if (filter == GL_LINEAR &&
+          (src_irb->mt->num_samples > 1 ||
+           _mesa_get_format_datatype(src_irb->mt->format) == GL_INT ||
+           _mesa_get_format_datatype(src_irb->mt->format) == GL_UNSIGNED_INT))
+         return false;
       for (unsigned i = 0; i < ctx->DrawBuffer->_NumColorDrawBuffers; ++i) {
          dst_irb = intel_renderbuffer(ctx->DrawBuffer->_ColorDrawBuffers[i]);
-         if (dst_irb && !formats_match(buffer_bit, src_irb, dst_irb))
+         if (dst_irb &&
+             !color_formats_convertible(brw_context(ctx), src_irb->mt->format,
+                                        dst_irb->mt->format))
             return false;
       }
       for (unsigned i = 0; i < ctx->DrawBuffer->_NumColorDrawBuffers; ++i) {
@@ -304,7 +344,7 @@ try_blorp_blit(struct intel_context *intel,
 	 if (dst_irb)
             do_blorp_blit(intel, buffer_bit, src_irb, dst_irb, srcX0, srcY0,
                           srcX1, srcY1, dstX0, dstY0, dstX1, dstY1,
-                          mirror_x, mirror_y);
+                          mirror_x, mirror_y, filter);
       }
       break;
    case GL_DEPTH_BUFFER_BIT:
@@ -316,7 +356,7 @@ try_blorp_blit(struct intel_context *intel,
          return false;
       do_blorp_blit(intel, buffer_bit, src_irb, dst_irb, srcX0, srcY0,
                     srcX1, srcY1, dstX0, dstY0, dstX1, dstY1,
-                    mirror_x, mirror_y);
+                    mirror_x, mirror_y, GL_NEAREST);
       break;
    case GL_STENCIL_BUFFER_BIT:
       src_irb =
@@ -327,7 +367,7 @@ try_blorp_blit(struct intel_context *intel,
          return false;
       do_blorp_blit(intel, buffer_bit, src_irb, dst_irb, srcX0, srcY0,
                     srcX1, srcY1, dstX0, dstY0, dstX1, dstY1,
-                    mirror_x, mirror_y);
+                    mirror_x, mirror_y, GL_NEAREST);
       break;
    default:
       assert(false);
@@ -361,7 +401,8 @@ brw_blorp_copytexsubimage(struct intel_context *intel,
    if (intel->gen < 6)
       return false;
 
-   if (!color_formats_match(src_mt->format, dst_mt->format)) {
+   if (!color_formats_convertible(brw_context(ctx), src_mt->format,
+                                  dst_mt->format)) {
       return false;
    }
 
@@ -396,7 +437,7 @@ brw_blorp_copytexsubimage(struct intel_context *intel,
                            dst_mt, dst_image->Level, dst_image->Face + slice,
                            srcX0, srcY0, srcX1, srcY1,
                            dstX0, dstY0, dstX1, dstY1,
-                           false, mirror_y);
+                           false, mirror_y, GL_NEAREST);
 
    /* If we're copying to a packed depth stencil texture and the source
     * framebuffer has separate stencil, we need to also copy the stencil data
@@ -420,7 +461,104 @@ brw_blorp_copytexsubimage(struct intel_context *intel,
                                  dst_image->Face + slice,
                                  srcX0, srcY0, srcX1, srcY1,
                                  dstX0, dstY0, dstX1, dstY1,
-                                 false, mirror_y);
+                                 false, mirror_y, GL_NEAREST);
+      }
+   }
+
+   return true;
+}
+
+
+/**
+ * Generate the levels above BaseLevel of a texture by repeatedly bilinearly
+ * downscaling the previous level with a blorp blit, avoiding the state save
+ * and restore and the shader setup of the meta path.
+ *
+ * Returns false, without touching the texture, if blorp can't handle it.
+ */
+bool
+brw_blorp_generate_mipmap(struct intel_context *intel, GLenum target,
+                          struct gl_texture_object *tex_obj)
+{
+   struct gl_context *ctx = &intel->ctx;
+   struct brw_context *brw = brw_context(ctx);
+
+   /* BLORP is not supported before Gen6. */
+   if (intel->gen < 6)
+      return false;
+
+   /* 3D textures would need to filter between slices too, and 1D arrays
+    * store their layers in the height.
+    */
+   switch (target) {
+   case GL_TEXTURE_1D:
+   case GL_TEXTURE_2D:
+   case GL_TEXTURE_CUBE_MAP:
+   case GL_TEXTURE_2D_ARRAY:
+      break;
+   default:
+      return false;
+   }
+
+   const struct gl_texture_image *base_image =
+      tex_obj->Image[0][tex_obj->BaseLevel];
+   if (!base_image || base_image->Border != 0 ||
+       _mesa_is_format_compressed(base_image->TexFormat) ||
+       !color_format_is_convertible(brw, base_image->TexFormat) ||
+       _mesa_get_format_datatype(base_image->TexFormat) == GL_UNSIGNED_INT ||
+       _mesa_get_format_datatype(base_image->TexFormat) == GL_INT)
+      return false;
+
+   const GLuint num_faces = _mesa_num_tex_faces(target);
+   for (GLuint face = 0; face < num_faces; face++) {
+      struct intel_texture_image *intel_image =
+         intel_texture_image(tex_obj->Image[face][tex_obj->BaseLevel]);
+      if (!intel_image || !intel_image->mt)
+         return false;
+   }
+
+   GLuint max_level = MIN2(_mesa_max_texture_levels(ctx, target) - 1,
+                           tex_obj->MaxLevel);
+
+   for (GLuint level = tex_obj->BaseLevel; level < max_level; level++) {
+      const struct gl_texture_image *src_image = tex_obj->Image[0][level];
+      GLint src_width = src_image->Width;
+      GLint src_height = src_image->Height;
+      GLint depth = src_image->Depth;
+      GLint dst_width = MAX2(src_width / 2, 1);
+      GLint dst_height = MAX2(src_height / 2, 1);
+
+      if (dst_width == src_width && dst_height == src_height)
+         break;
+
+      if (!_mesa_prepare_mipmap_level(ctx, tex_obj, level + 1,
+                                      dst_width, dst_height, depth, 0,
+                                      src_image->InternalFormat,
+                                      src_image->TexFormat))
+         break;
+
+      for (GLuint face = 0; face < num_faces; face++) {
+         struct intel_texture_image *src_intel_image =
+            intel_texture_image(tex_obj->Image[face][level]);
+         struct intel_texture_image *dst_intel_image =
+            intel_texture_image(tex_obj->Image[face][level + 1]);
+
+         /* Let the meta path start over if we couldn't get storage. */
+         if (!dst_intel_image || !dst_intel_image->mt)
+            return false;
+
+         for (GLint slice = 0; slice < depth; slice++) {
+            brw_blorp_blit_miptrees(intel,
+                                    src_intel_image->mt,
+                                    src_intel_image->base.Base.Level,
+                                    face + slice,
+                                    dst_intel_image->mt,
+                                    dst_intel_image->base.Base.Level,
+                                    face + slice,
+                                    0, 0, src_width, src_height,
+                                    0, 0, dst_width, dst_height,
+                                    false, false, GL_LINEAR);
+         }
       }
    }
 
@@ -833,6 +971,11 @@ brw_blorp_blit_program::compile(struct brw_context *brw,
          /* Gen7+ hardware doesn't automaticaly blend. */
          manual_blend(key->src_samples);
       }
+   } else if (key->bilinear_filter) {
+      /* X and Y are normalized float coordinates in the single-sampled,
+       * non-W-tiled source, so let the sampler do the filtering.
+       */
+      sample(texture_data[0]);
    } else {
       /* We aren't blending, which means we just want to fetch a single sample
        * from the source surface.  The address that we want to fetch from is
@@ -1378,6 +1521,13 @@ brw_blorp_blit_program::translate_dst_to_src()
    brw_MUL(&func, Y_f, Yp_f, y_transform.multiplier);
    brw_ADD(&func, X_f, X_f, x_transform.offset);
    brw_ADD(&func, Y_f, Y_f, y_transform.offset);
+   if (key->bilinear_filter) {
+      /* Leave the normalized float coordinates in X and Y for the SAMPLE
+       * message.
+       */
+      brw_set_compression_control(&func, BRW_COMPRESSION_NONE);
+      return;
+   }
    /* Round the float coordinates down to nearest integer by moving to
     * UD registers.
     */
@@ -1640,10 +1790,18 @@ brw_blorp_blit_program::texture_lookup(struct brw_reg dst,
    for (int arg = 0; arg < num_args; ++arg) {
       switch (args[arg]) {
       case SAMPLER_MESSAGE_ARG_U_FLOAT:
-         brw_MOV(&func, retype(mrf, BRW_REGISTER_TYPE_F), X);
+         if (key->bilinear_filter)
+            brw_MOV(&func, retype(mrf, BRW_REGISTER_TYPE_F),
+                    retype(X, BRW_REGISTER_TYPE_F));
+         else
+            brw_MOV(&func, retype(mrf, BRW_REGISTER_TYPE_F), X);
          break;
       case SAMPLER_MESSAGE_ARG_V_FLOAT:
-         brw_MOV(&func, retype(mrf, BRW_REGISTER_TYPE_F), Y);
+         if (key->bilinear_filter)
+            brw_MOV(&func, retype(mrf, BRW_REGISTER_TYPE_F),
+                    retype(Y, BRW_REGISTER_TYPE_F));
+         else
+            brw_MOV(&func, retype(mrf, BRW_REGISTER_TYPE_F), Y);
          break;
       case SAMPLER_MESSAGE_ARG_U_INT:
          brw_MOV(&func, mrf, X);
@@ -1817,12 +1975,21 @@ brw_blorp_blit_params::brw_blorp_blit_params(struct brw_context *brw,
                                              GLfloat src_x1, GLfloat src_y1,
                                              GLfloat dst_x0, GLfloat dst_y0,
                                              GLfloat dst_x1, GLfloat dst_y1,
-                                             bool mirror_x, bool mirror_y)
+                                             bool mirror_x, bool mirror_y,
+                                             GLenum filter)
 {
    src.set(brw, src_mt, src_level, src_layer);
    dst.set(brw, dst_mt, dst_level, dst_layer);
 
-   src.brw_surfaceformat = dst.brw_surfaceformat;
+   /* When the formats are equivalent, read the source with the destination's
+    * surface format so that the data is copied through unchanged.  Otherwise
+    * the caller has checked that both are float-based color formats, and the
+    * sampler and render target do the conversion for us.
+    */
+   if (color_formats_match(src_mt->format, dst_mt->format))
+      src.brw_surfaceformat = dst.brw_surfaceformat;
+   else
+      src.brw_surfaceformat = brw_format_for_mesa_format(src_mt->format);
 
    use_wm_prog = true;
    memset(&wm_prog_key, 0, sizeof(wm_prog_key));
@@ -1928,6 +2095,23 @@ brw_blorp_blit_params::brw_blorp_blit_params(struct brw_context *brw,
    wm_push_consts.x_transform.setup(src_x0, src_x1, dst_x0, dst_x1, mirror_x);
    wm_push_consts.y_transform.setup(src_y0, src_y1, dst_y0, dst_y1, mirror_y);
 
+   if (filter == GL_LINEAR &&
+       (src_x1 - src_x0 != dst_x1 - dst_x0 ||
+        src_y1 - src_y0 != dst_y1 - dst_y0) &&
+       src_mt->num_samples <= 1 &&
+       wm_prog_key.texture_data_type == BRW_REGISTER_TYPE_F &&
+       !src.map_stencil_as_y_tiled) {
+      /* The transform already maps destination pixel centers to source pixel
+       * centers; the SAMPLE message needs them normalized to the surface
+       * size.
+       */
+      wm_prog_key.bilinear_filter = true;
+      wm_push_consts.x_transform.multiplier /= src.width;
+      wm_push_consts.x_transform.offset /= src.width;
+      wm_push_consts.y_transform.multiplier /= src.height;
+      wm_push_consts.y_transform.offset /= src.height;
+   }
+
    if (dst.num_samples <= 1 && dst_mt->num_samples > 1) {
       /* We must expand the rectangle we send through the rendering pipeline,
        * to account for the fact that we are mapping the destination region as
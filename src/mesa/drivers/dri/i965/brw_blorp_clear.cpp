@@ -26,6 +26,7 @@ extern "C" {
 #include "main/blend.h"
 #include "main/fbobject.h"
 #include "main/renderbuffer.h"
+#include "main/glformats.h"
 }
 
 #include "glsl/ralloc.h"
@@ -132,21 +133,45 @@ brw_blorp_const_color_program::~brw_blorp_const_color_program()
 }
 
 
+static const GLenum channel_size_pnames[4] = {
+   GL_TEXTURE_RED_SIZE,
+   GL_TEXTURE_GREEN_SIZE,
+   GL_TEXTURE_BLUE_SIZE,
+   GL_TEXTURE_ALPHA_SIZE,
+};
+
+
+/**
+ * Does a buffer of the given base format store channel i (0 = red, ...,
+ * 3 = alpha)?  Channels that aren't stored can be cleared to anything.
+ */
+static bool
+base_format_has_channel(GLenum base_format, int i)
+{
+   return _mesa_base_format_has_channel(base_format, channel_size_pnames[i]);
+}
+
+
 /**
  * Determine if fast color clear supports the given clear color.
  *
- * Fast color clear can only clear to color values of 1.0 or 0.0.  At the
- * moment we only support floating point, unorm, and snorm buffers.
+ * Fast color clear can only clear to color values of 1.0 or 0.0, but only
+ * the channels actually present in the buffer matter (so e.g. an RGBX buffer
+ * can be fast cleared regardless of the alpha clear value).  At the moment
+ * we only support floating point, unorm, and snorm buffers.
  */
 static bool
 is_color_fast_clear_compatible(struct intel_context *intel,
-                               gl_format format,
+                               gl_format format, GLenum base_format,
                                const union gl_color_union *color)
 {
    if (_mesa_is_format_integer_color(format))
       return false;
 
    for (int i = 0; i < 4; i++) {
+      if (!base_format_has_channel(base_format, i))
+         continue;
+
       if (color->f[i] != 0.0 && color->f[i] != 1.0) {
          perf_debug("Clear color unsupported by fast color clear.  "
                     "Falling back to slow clear.");
@@ -160,19 +185,100 @@ is_color_fast_clear_compatible(struct intel_context *intel,
 /**
  * Convert the given color to a bitfield suitable for ORing into DWORD 7 of
  * SURFACE_STATE.
+ *
+ * Channels missing from the buffer are given their default value (0 for
+ * color, 1 for alpha), so that they read back correctly whatever the clear
+ * color said.
  */
 static uint32_t
-compute_fast_clear_color_bits(const union gl_color_union *color)
+compute_fast_clear_color_bits(GLenum base_format,
+                              const union gl_color_union *color)
 {
    uint32_t bits = 0;
    for (int i = 0; i < 4; i++) {
-      if (color->f[i] != 0.0)
+      bool set;
+      if (base_format_has_channel(base_format, i))
+         set = color->f[i] != 0.0;
+      else
+         set = i == 3;
+
+      if (set)
          bits |= 1 << (GEN7_SURFACE_CLEAR_COLOR_SHIFT + (3 - i));
    }
    return bits;
 }
 
 
+/**
+ * Compute the alignment and scaledown factors of the rectangle to send down
+ * the pipeline for a fast clear of the given miptree.
+ */
+static void
+get_fast_clear_rect_factors(struct intel_context *intel,
+                            struct intel_mipmap_tree *mt,
+                            unsigned *x_align, unsigned *y_align,
+                            unsigned *x_scaledown, unsigned *y_scaledown)
+{
+   if (mt->msaa_layout == INTEL_MSAA_LAYOUT_NONE) {
+      /* From the Ivy Bridge PRM, Vol2 Part1 11.7 "MCS Buffer for Render
+       * Target(s)", beneath the "Fast Color Clear" bullet (p327):
+       *
+       *     Clear pass must have a clear rectangle that must follow alignment
+       *     rules in terms of pixels and lines as shown in the table
+       *     below. Further, the clear-rectangle height and width must be
+       *     multiple of the following dimensions. If the height and width of
+       *     the render target being cleared do not meet these requirements,
+       *     an MCS buffer can be created such that it follows the requirement
+       *     and covers the RT.
+       *
+       * The alignment size in the table that follows is related to the
+       * alignment size returned by intel_get_non_msrt_mcs_alignment(), but
+       * with X alignment multiplied by 16 and Y alignment multiplied by 32.
+       */
+      intel_get_non_msrt_mcs_alignment(intel, mt, x_align, y_align);
+      *x_align *= 16;
+      *y_align *= 32;
+
+      /* From the Ivy Bridge PRM, Vol2 Part1 11.7 "MCS Buffer for Render
+       * Target(s)", beneath the "Fast Color Clear" bullet (p327):
+       *
+       *     In order to optimize the performance MCS buffer (when bound to 1X
+       *     RT) clear similarly to MCS buffer clear for MSRT case, clear rect
+       *     is required to be scaled by the following factors in the
+       *     horizontal and vertical directions:
+       *
+       * The X and Y scale down factors in the table that follows are each
+       * equal to half the alignment value computed above.
+       */
+      *x_scaledown = *x_align / 2;
+      *y_scaledown = *y_align / 2;
+   } else {
+      /* From the Ivy Bridge PRM, Vol2 Part1 11.7 "MCS Buffer for Render
+       * Target(s)", beneath the "MSAA Compression" bullet (p326):
+       *
+       *     Clear pass for this case requires that scaled down primitive
+       *     is sent down with upper left co-ordinate to coincide with
+       *     actual rectangle being cleared. For MSAA, clear rectangle's
+       *     height and width need to as show in the following table in
+       *     terms of (width,height) of the RT.
+       *
+       *     MSAA  Width of Clear Rect  Height of Clear Rect
+       *      4X     Ceil(1/8*width)      Ceil(1/2*height)
+       *      8X     Ceil(1/2*width)      Ceil(1/2*height)
+       *
+       * The hardware aligns the rectangle it is given to a multiple of 2x2
+       * blocks before scaling it back up, so the resulting alignment is
+       * twice the scaledown factor in each direction.
+       */
+      assert(mt->msaa_layout == INTEL_MSAA_LAYOUT_CMS);
+      *x_scaledown = mt->num_samples == 8 ? 2 : 8;
+      *y_scaledown = 2;
+      *x_align = *x_scaledown * 2;
+      *y_align = *y_scaledown * 2;
+   }
+}
+
+
 brw_blorp_clear_params::brw_blorp_clear_params(struct brw_context *brw,
                                                struct gl_framebuffer *fb,
                                                struct gl_renderbuffer *rb,
@@ -222,63 +328,47 @@ brw_blorp_clear_params::brw_blorp_clear_params(struct brw_context *brw,
       wm_prog_key.use_simd16_replicated_data = false;
 
    /* Constant color writes ignore everyting in blend and color calculator
-    * state.  This is not documented.
+    * state.  This is not documented.  Masking off a channel the buffer
+    * doesn't store makes no difference, though, so it doesn't prevent
+    * replicated writes.
     */
    for (int i = 0; i < 4; i++) {
       if (!color_mask[i]) {
          color_write_disable[i] = true;
-         wm_prog_key.use_simd16_replicated_data = false;
+         if (base_format_has_channel(rb->_BaseFormat, i))
+            wm_prog_key.use_simd16_replicated_data = false;
       }
    }
 
-   /* If we can do this as a fast color clear, do so. */
+   /* If we can do this as a fast color clear, do so.  Single sampled buffers
+    * use an MCS buffer dedicated to fast clears; CMS multisampled buffers
+    * record the clear in the MCS buffer they already have.
+    */
    if (irb->mt->mcs_state != INTEL_MCS_STATE_NONE && !partial_clear &&
+       (irb->mt->msaa_layout == INTEL_MSAA_LAYOUT_NONE ||
+        irb->mt->msaa_layout == INTEL_MSAA_LAYOUT_CMS) &&
        wm_prog_key.use_simd16_replicated_data &&
-       is_color_fast_clear_compatible(intel, format, &ctx->Color.ClearColor)) {
+       is_color_fast_clear_compatible(intel, format, rb->_BaseFormat,
+                                      &ctx->Color.ClearColor)) {
       memset(push_consts, 0xff, 4*sizeof(float));
       fast_clear_op = GEN7_FAST_CLEAR_OP_FAST_CLEAR;
 
-      /* From the Ivy Bridge PRM, Vol2 Part1 11.7 "MCS Buffer for Render
-       * Target(s)", beneath the "Fast Color Clear" bullet (p327):
-       *
-       *     Clear pass must have a clear rectangle that must follow alignment
-       *     rules in terms of pixels and lines as shown in the table
-       *     below. Further, the clear-rectangle height and width must be
-       *     multiple of the following dimensions. If the height and width of
-       *     the render target being cleared do not meet these requirements,
-       *     an MCS buffer can be created such that it follows the requirement
-       *     and covers the RT.
-       *
-       * The alignment size in the table that follows is related to the
-       * alignment size returned by intel_get_non_msrt_mcs_alignment(), but
-       * with X alignment multiplied by 16 and Y alignment multiplied by 32.
-       */
-      unsigned x_align, y_align;
-      intel_get_non_msrt_mcs_alignment(intel, irb->mt, &x_align, &y_align);
-      x_align *= 16;
-      y_align *= 32;
+      unsigned x_align, y_align, x_scaledown, y_scaledown;
+      get_fast_clear_rect_factors(intel, irb->mt, &x_align, &y_align,
+                                  &x_scaledown, &y_scaledown);
       x0 = ROUND_DOWN_TO(x0, x_align);
       y0 = ROUND_DOWN_TO(y0, y_align);
       x1 = ALIGN(x1, x_align);
       y1 = ALIGN(y1, y_align);
-
-      /* From the Ivy Bridge PRM, Vol2 Part1 11.7 "MCS Buffer for Render
-       * Target(s)", beneath the "Fast Color Clear" bullet (p327):
-       *
-       *     In order to optimize the performance MCS buffer (when bound to 1X
-       *     RT) clear similarly to MCS buffer clear for MSRT case, clear rect
-       *     is required to be scaled by the following factors in the
-       *     horizontal and vertical directions:
-       *
-       * The X and Y scale down factors in the table that follows are each
-       * equal to half the alignment value computed above.
-       */
-      unsigned x_scaledown = x_align / 2;
-      unsigned y_scaledown = y_align / 2;
       x0 /= x_scaledown;
       y0 /= y_scaledown;
       x1 /= x_scaledown;
       y1 /= y_scaledown;
+
+      /* A multisampled clear has to go through a pipeline configured with
+       * the same number of samples as the surface.
+       */
+      num_samples = dst.num_samples;
    }
 }
 
@@ -427,19 +517,23 @@ brw_blorp_clear_color(struct intel_context *intel, struct gl_framebuffer *fb,
    struct gl_context *ctx = &intel->ctx;
    struct brw_context *brw = brw_context(ctx);
 
-   /* The constant color clear code doesn't work for multisampled surfaces, so
-    * we need to support falling back to other clear mechanisms.
-    * Unfortunately, our clear code is based on a bitmask that doesn't
-    * distinguish individual color attachments, so we walk the attachments to
-    * see if any require fallback, and fall back for all if any of them need
-    * to.
+   /* The constant color clear code only works for multisampled surfaces when
+    * it can do a fast clear, so we need to support falling back to other
+    * clear mechanisms.  Unfortunately, our clear code is based on a bitmask
+    * that doesn't distinguish individual color attachments, so we walk the
+    * attachments to see if any require fallback, and fall back for all if
+    * any of them need to.
     */
    for (unsigned buf = 0; buf < ctx->DrawBuffer->_NumColorDrawBuffers; buf++) {
       struct gl_renderbuffer *rb = ctx->DrawBuffer->_ColorDrawBuffers[buf];
       struct intel_renderbuffer *irb = intel_renderbuffer(rb);
 
-      if (irb && irb->mt->msaa_layout != INTEL_MSAA_LAYOUT_NONE)
-         return false;
+      if (irb && irb->mt->msaa_layout != INTEL_MSAA_LAYOUT_NONE) {
+         brw_blorp_clear_params params(brw, fb, rb, ctx->Color.ColorMask[buf],
+                                       partial_clear);
+         if (params.fast_clear_op != GEN7_FAST_CLEAR_OP_FAST_CLEAR)
+            return false;
+      }
    }
 
    for (unsigned buf = 0; buf < ctx->DrawBuffer->_NumColorDrawBuffers; buf++) {
@@ -464,7 +558,8 @@ brw_blorp_clear_color(struct intel_context *intel, struct gl_framebuffer *fb,
           * operations.
           */
          uint32_t new_color_value =
-            compute_fast_clear_color_bits(&ctx->Color.ClearColor);
+            compute_fast_clear_color_bits(rb->_BaseFormat,
+                                          &ctx->Color.ClearColor);
          if (irb->mt->fast_clear_color_value != new_color_value) {
             irb->mt->fast_clear_color_value = new_color_value;
             brw->state.dirty.brw |= BRW_NEW_SURFACES;
@@ -477,7 +572,7 @@ brw_blorp_clear_color(struct intel_context *intel, struct gl_framebuffer *fb,
             continue;
 
          /* If the MCS buffer hasn't been allocated yet, we need to allocate
-          * it now.
+          * it now.  (Multisampled buffers always have one.)
           */
          if (!irb->mt->mcs_mt) {
             if (!intel_miptree_alloc_non_msrt_mcs(intel, irb->mt)) {
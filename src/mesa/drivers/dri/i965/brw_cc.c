@@ -57,6 +57,8 @@ brw_upload_cc_vp(struct brw_context *brw)
       ccv->max_depth = 1.0;
    }
 
+   brw_state_batch_cached(brw, sizeof(*ccv), 32, &brw->cc.vp_offset);
+
    brw->state.dirty.cache |= CACHE_NEW_CC_VP;
 }
 
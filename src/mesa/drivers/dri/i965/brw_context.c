@@ -417,6 +417,9 @@ brwCreateContext(int api,
 
    brw->precompile = driQueryOptionb(&intel->optionCache, "shader_precompile");
 
+   if (driQueryOptionb(&intel->optionCache, "shader_cache"))
+      brw->disk_cache = brw_disk_cache_create(brw);
+
    ctx->Const.NativeIntegers = true;
    ctx->Const.UniformBooleanTrue = 1;
    ctx->Const.UniformBufferOffsetAlignment = 16;
@@ -283,6 +283,12 @@ struct brw_shader {
 
    /** Shader IR transformed for native compile, at link time. */
    struct exec_list *ir;
+
+   /**
+    * Text identifying the linked shader to brw_disk_cache: the sources it
+    * was linked from and the locations assigned to its variables.
+    */
+   char *cache_ident;
 };
 
 /* Data about a particular attempt to compile a program.  Note that
@@ -515,6 +521,9 @@ struct brw_vs_prog_data {
 /** Maximum number of actual buffers used for stream output */
 #define BRW_MAX_SOL_BUFFERS 4
 
+/** Hash buckets for reusing indirect state within a batch */
+#define BRW_STATE_BATCH_CACHE_BUCKETS 256
+
 #define BRW_MAX_WM_UBOS              12
 #define BRW_MAX_VS_UBOS              12
 
@@ -788,6 +797,9 @@ struct brw_context
    struct brw_cache cache;
    struct brw_cached_batch_item *cached_batch_items;
 
+   /** On-disk cache of compiled programs, or NULL if disabled */
+   struct brw_disk_cache *disk_cache;
+
    /* Whether a meta-operation is in progress. */
    bool meta_in_progress;
 
@@ -1068,6 +1080,16 @@ struct brw_context
    int num_atoms;
    const struct brw_tracked_state **atoms;
 
+   /**
+    * For each dirty bit, a mask of the atoms (by index into brw->atoms)
+    * that check it, so brw_upload_state() only visits the atoms it needs to.
+    */
+   struct {
+      uint64_t mesa[32];
+      uint64_t brw[32];
+      uint64_t cache[32];
+   } atom_deps;
+
    /* If (INTEL_DEBUG & DEBUG_BATCH) */
    struct {
       uint32_t offset;
@@ -1076,6 +1098,25 @@ struct brw_context
    } *state_batch_list;
    int state_batch_count;
 
+   /**
+    * Hash table of the indirect state in the current batch that later
+    * allocations may share, see brw_state_batch_cached().
+    */
+   struct {
+      struct brw_state_batch_item {
+         uint32_t hash;
+         uint32_t offset;
+         uint32_t size;
+         int next;               /**< index + 1 of the next item, or 0 */
+      } *items;
+      int n_items;
+      int max_items;
+      int buckets[BRW_STATE_BATCH_CACHE_BUCKETS]; /**< index + 1, or 0 */
+
+      /** batch.state_batch_offset before the last brw_state_batch() call */
+      uint32_t prev_offset;
+   } state_batch_cache;
+
    uint32_t render_target_format[MESA_FORMAT_COUNT];
    bool format_supported_as_render_target[MESA_FORMAT_COUNT];
 
@@ -1171,6 +1212,9 @@ void brw_validate_textures( struct brw_context *brw );
  */
 void brwInitFragProgFuncs( struct dd_function_table *functions );
 
+/** Value for the params that are always zero */
+extern const float brw_param_zero;
+
 int brw_get_scratch_size(int size);
 void brw_get_scratch_bo(struct intel_context *intel,
 			drm_intel_bo **scratch_bo, int size);
@@ -1243,6 +1287,10 @@ brw_blorp_copytexsubimage(struct intel_context *intel,
                           int dstX0, int dstY0,
                           int width, int height);
 
+bool
+brw_blorp_generate_mipmap(struct intel_context *intel, GLenum target,
+                          struct gl_texture_object *tex_obj);
+
 /* gen6_multisample_state.c */
 void
 gen6_emit_3dstate_multisample(struct brw_context *brw,
@@ -0,0 +1,785 @@
+/*
+ * Copyright © 2013 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/** @file brw_disk_cache.cpp
+ *
+ * Keeps the output of the VS and FS backends on disk, so that a GLSL program
+ * seen by an earlier run can go straight into the program cache without
+ * being compiled again.
+ *
+ * Each entry is a file named after a hash of everything the compile depends
+ * on: the driver binary, the device, the linked shader (see
+ * brw_shader::cache_ident) and the program key.  That whole identity is also
+ * stored in the file and compared on load, so a hash collision only costs a
+ * recompile.
+ *
+ * The prog_data can't be stored as is, since its param arrays point at the
+ * uniform storage, program parameters and clip planes of this context.  Each
+ * of those pointers is written out as a reference to the value instead, and
+ * resolved again on load.  Programs using a pointer we can't describe are
+ * simply not stored.
+ *
+ * Next to the programs, each linked shader gets a list of the keys it ended
+ * up being compiled with at draw time.  Link time precompiles build those
+ * variants too, instead of only the key they guess from the default state
+ * (see brw_disk_cache_note_variant()).
+ */
+
+#include <dlfcn.h>
+#include <errno.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+extern "C" {
+#include "main/hash_table.h"
+#include "main/macros.h"
+#include "program/prog_parameter.h"
+#include "program/prog_statevars.h"
+#include "glsl/ralloc.h"
+#include "intel_mipmap_tree.h"
+#include "brw_context.h"
+#include "brw_state.h"
+#include "brw_vs.h"
+}
+#include "glsl/glsl_types.h"
+#include "glsl/ir_uniform.h"
+
+#define FILE_DEBUG_FLAG DEBUG_STATE
+
+#define BRW_DISK_CACHE_MAGIC   0x43575242 /* "BRWC" */
+#define BRW_DISK_CACHE_VERSION 1
+
+/** Largest program we expect to read back, to reject corrupt files. */
+#define BRW_DISK_CACHE_MAX_PROGRAM_SIZE (4 * 1024 * 1024)
+
+/** Most keys remembered per linked shader */
+#define BRW_DISK_CACHE_MAX_VARIANTS 16
+
+struct brw_disk_cache {
+   /** Directory holding the entries */
+   char *path;
+
+   /** Modification time and size of the driver binary */
+   uint64_t driver_mtime;
+   uint64_t driver_size;
+};
+
+struct brw_disk_cache_header {
+   uint32_t magic;
+   uint32_t version;
+   uint32_t ident_size;
+   uint32_t prog_data_size;
+   uint32_t nr_params;
+   uint32_t nr_pull_params;
+   uint32_t program_size;
+};
+
+/** Followed by the identity and up to BRW_DISK_CACHE_MAX_VARIANTS keys. */
+struct brw_disk_cache_variants_header {
+   uint32_t magic;
+   uint32_t version;
+   uint32_t ident_size;
+   uint32_t key_size;
+};
+
+enum brw_param_ref_file {
+   BRW_PARAM_REF_ZERO,            /**< brw_param_zero */
+   BRW_PARAM_REF_UNIFORM,         /**< UniformStorage[index].storage[offset] */
+   BRW_PARAM_REF_PARAMETER,       /**< ParameterValues[index][offset] */
+   BRW_PARAM_REF_EYE_CLIP_PLANE,  /**< Transform.EyeUserPlane[index][offset] */
+   BRW_PARAM_REF_CLIP_PLANE,      /**< Transform._ClipUserPlane[index][offset] */
+};
+
+/**
+ * On-disk form of one entry of prog_data->param or pull_param.
+ */
+struct brw_param_ref {
+   uint32_t file;
+   uint32_t index;
+   uint32_t offset;
+
+   /**
+    * For BRW_PARAM_REF_PARAMETER, the type of the parameter and, for
+    * PROGRAM_STATE_VAR, its state tokens.  The backend may have added the
+    * state reference itself, so it gets added again on load.
+    */
+   uint32_t type;
+   int32_t state[STATE_LENGTH];
+};
+
+
+static void
+make_dir(char *path)
+{
+   /* Create the missing parents first, like mkdir -p. */
+   for (char *p = strchr(path + 1, '/'); p; p = strchr(p + 1, '/')) {
+      *p = '\0';
+      mkdir(path, 0755);
+      *p = '/';
+   }
+   mkdir(path, 0755);
+}
+
+/**
+ * Returns the cache for a new context, or NULL if it can't be used.
+ */
+struct brw_disk_cache *
+brw_disk_cache_create(struct brw_context *brw)
+{
+   struct brw_disk_cache *cache;
+   struct stat st;
+   Dl_info info;
+   const char *dir;
+
+   /* Debug output and shader time are generated by the compile itself. */
+   if (INTEL_DEBUG & (DEBUG_WM | DEBUG_VS | DEBUG_SHADER_TIME | DEBUG_NO16))
+      return NULL;
+
+   /* Programs are only valid for the driver build that generated them, and
+    * we use the driver's own file to tell builds apart.
+    */
+   if (!dladdr((void *) brw_disk_cache_create, &info) ||
+       info.dli_fname == NULL ||
+       stat(info.dli_fname, &st) != 0)
+      return NULL;
+
+   cache = rzalloc(NULL, struct brw_disk_cache);
+   if (!cache)
+      return NULL;
+
+   cache->driver_mtime = st.st_mtime;
+   cache->driver_size = st.st_size;
+
+   if ((dir = getenv("INTEL_SHADER_CACHE_DIR")) != NULL)
+      cache->path = ralloc_strdup(cache, dir);
+   else if ((dir = getenv("XDG_CACHE_HOME")) != NULL)
+      cache->path = ralloc_asprintf(cache, "%s/mesa/i965", dir);
+   else if ((dir = getenv("HOME")) != NULL)
+      cache->path = ralloc_asprintf(cache, "%s/.cache/mesa/i965", dir);
+
+   if (cache->path == NULL || cache->path[0] == '\0') {
+      ralloc_free(cache);
+      return NULL;
+   }
+
+   make_dir(cache->path);
+   if (stat(cache->path, &st) != 0 || !S_ISDIR(st.st_mode) ||
+       access(cache->path, W_OK) != 0) {
+      DBG("%s: can't use %s\n", __FUNCTION__, cache->path);
+      ralloc_free(cache);
+      return NULL;
+   }
+
+   return cache;
+}
+
+void
+brw_disk_cache_destroy(struct brw_disk_cache *cache)
+{
+   ralloc_free(cache);
+}
+
+static void
+append(void *mem_ctx, char **buf, size_t *size, const void *data, size_t len)
+{
+   *buf = (char *) reralloc_size(mem_ctx, *buf, *size + len);
+   memcpy(*buf + *size, data, len);
+   *size += len;
+}
+
+/**
+ * Describes the compile the caller is about to do, or NULL if the program
+ * can't be cached.  With a NULL \p key, this describes all the compiles of
+ * the shader with keys of \p key_size instead.
+ */
+static char *
+make_ident(struct brw_context *brw, void *mem_ctx,
+           enum brw_cache_id cache_id,
+           struct gl_shader_program *prog,
+           const void *key, GLuint key_size, size_t *ident_size)
+{
+   struct intel_context *intel = &brw->intel;
+   struct brw_disk_cache *cache = brw->disk_cache;
+   struct brw_shader *shader;
+   char *ident = NULL;
+   uint32_t header[4];
+
+   if (!prog)
+      return NULL;
+
+   switch (cache_id) {
+   case BRW_VS_PROG:
+      shader = (struct brw_shader *) prog->_LinkedShaders[MESA_SHADER_VERTEX];
+      break;
+   case BRW_WM_PROG:
+      shader = (struct brw_shader *) prog->_LinkedShaders[MESA_SHADER_FRAGMENT];
+      break;
+   default:
+      return NULL;
+   }
+
+   if (!shader || !shader->cache_ident)
+      return NULL;
+
+   *ident_size = 0;
+   append(mem_ctx, &ident, ident_size,
+          &cache->driver_mtime, sizeof(cache->driver_mtime));
+   append(mem_ctx, &ident, ident_size,
+          &cache->driver_size, sizeof(cache->driver_size));
+
+   header[0] = BRW_DISK_CACHE_VERSION;
+   header[1] = intel->intelScreen->deviceID;
+   header[2] = cache_id;
+   header[3] = key_size;
+   append(mem_ctx, &ident, ident_size, header, sizeof(header));
+   if (key)
+      append(mem_ctx, &ident, ident_size, key, key_size);
+   append(mem_ctx, &ident, ident_size,
+          shader->cache_ident, strlen(shader->cache_ident) + 1);
+
+   return ident;
+}
+
+static char *
+make_entry_path(struct brw_disk_cache *cache, void *mem_ctx,
+                const char *ident, size_t ident_size)
+{
+   return ralloc_asprintf(mem_ctx, "%s/%08x", cache->path,
+                          _mesa_hash_data(ident, ident_size));
+}
+
+static bool
+param_ref_from_pointer(struct gl_context *ctx,
+                       struct gl_shader_program *prog,
+                       struct gl_program *glprog,
+                       const float *p, struct brw_param_ref *ref)
+{
+   memset(ref, 0, sizeof(*ref));
+
+   if (p == &brw_param_zero) {
+      ref->file = BRW_PARAM_REF_ZERO;
+      return true;
+   }
+
+   for (unsigned u = 0; u < prog->NumUserUniformStorage; u++) {
+      struct gl_uniform_storage *storage = &prog->UniformStorage[u];
+      const float *base = &storage->storage[0].f;
+      unsigned slots = storage->type->component_slots();
+      if (storage->array_elements)
+         slots *= storage->array_elements;
+
+      if (p >= base && p < base + slots) {
+         ref->file = BRW_PARAM_REF_UNIFORM;
+         ref->index = u;
+         ref->offset = p - base;
+         return true;
+      }
+   }
+
+   const struct gl_program_parameter_list *params = glprog->Parameters;
+   if (params->NumParameters) {
+      const float *base = &params->ParameterValues[0][0].f;
+
+      if (p >= base && p < base + 4 * params->NumParameters) {
+         const struct gl_program_parameter *param;
+
+         ref->file = BRW_PARAM_REF_PARAMETER;
+         ref->index = (p - base) / 4;
+         ref->offset = (p - base) % 4;
+
+         param = &params->Parameters[ref->index];
+         ref->type = param->Type;
+         if (param->Type == PROGRAM_STATE_VAR) {
+            for (unsigned i = 0; i < STATE_LENGTH; i++)
+               ref->state[i] = param->StateIndexes[i];
+         }
+         return true;
+      }
+   }
+
+   const float *eye = &ctx->Transform.EyeUserPlane[0][0];
+   const float *clip = &ctx->Transform._ClipUserPlane[0][0];
+   if (p >= eye && p < eye + 4 * MAX_CLIP_PLANES) {
+      ref->file = BRW_PARAM_REF_EYE_CLIP_PLANE;
+      ref->index = (p - eye) / 4;
+      ref->offset = (p - eye) % 4;
+      return true;
+   }
+   if (p >= clip && p < clip + 4 * MAX_CLIP_PLANES) {
+      ref->file = BRW_PARAM_REF_CLIP_PLANE;
+      ref->index = (p - clip) / 4;
+      ref->offset = (p - clip) % 4;
+      return true;
+   }
+
+   return false;
+}
+
+/**
+ * Adds back the state references named by \p refs, making sure they land on
+ * the same parameters as when the program was compiled.
+ */
+static bool
+add_param_ref_state(struct gl_program *glprog,
+                    const struct brw_param_ref *refs, unsigned count)
+{
+   struct gl_program_parameter_list *params = glprog->Parameters;
+
+   for (unsigned i = 0; i < count; i++) {
+      const struct brw_param_ref *ref = &refs[i];
+
+      if (ref->file != BRW_PARAM_REF_PARAMETER)
+         continue;
+
+      if (ref->type == PROGRAM_STATE_VAR) {
+         gl_state_index tokens[STATE_LENGTH];
+
+         for (unsigned j = 0; j < STATE_LENGTH; j++)
+            tokens[j] = (gl_state_index) ref->state[j];
+
+         if (_mesa_add_state_reference(params, tokens) != (GLint) ref->index)
+            return false;
+      } else if (ref->index >= params->NumParameters ||
+                 params->Parameters[ref->index].Type != ref->type) {
+         return false;
+      }
+   }
+
+   return true;
+}
+
+static bool
+param_ref_to_pointer(struct gl_context *ctx,
+                     struct gl_shader_program *prog,
+                     struct gl_program *glprog,
+                     const struct brw_param_ref *ref, const float **p)
+{
+   if (ref->offset >= 4 && ref->file != BRW_PARAM_REF_UNIFORM)
+      return false;
+
+   switch (ref->file) {
+   case BRW_PARAM_REF_ZERO:
+      *p = &brw_param_zero;
+      return true;
+
+   case BRW_PARAM_REF_UNIFORM: {
+      if (ref->index >= prog->NumUserUniformStorage)
+         return false;
+
+      struct gl_uniform_storage *storage = &prog->UniformStorage[ref->index];
+      unsigned slots = storage->type->component_slots();
+      if (storage->array_elements)
+         slots *= storage->array_elements;
+      if (ref->offset >= slots)
+         return false;
+
+      *p = &storage->storage[ref->offset].f;
+      return true;
+   }
+
+   case BRW_PARAM_REF_PARAMETER:
+      if (ref->index >= glprog->Parameters->NumParameters)
+         return false;
+      *p = &glprog->Parameters->ParameterValues[ref->index][ref->offset].f;
+      return true;
+
+   case BRW_PARAM_REF_EYE_CLIP_PLANE:
+      if (ref->index >= MAX_CLIP_PLANES)
+         return false;
+      *p = &ctx->Transform.EyeUserPlane[ref->index][ref->offset];
+      return true;
+
+   case BRW_PARAM_REF_CLIP_PLANE:
+      if (ref->index >= MAX_CLIP_PLANES)
+         return false;
+      *p = &ctx->Transform._ClipUserPlane[ref->index][ref->offset];
+      return true;
+   }
+
+   return false;
+}
+
+/**
+ * Looks for a stored compile of \p prog with \p key.
+ *
+ * On success, \p prog_data is filled in, with the param and pull_param
+ * arrays it points to (found at \p param and \p pull_param in it, and
+ * holding \p param_count entries each) resolved for this context, and the
+ * program is returned in \p program, allocated out of \p mem_ctx.
+ *
+ * \p key must not contain anything specific to this run, like
+ * program_string_id.
+ */
+bool
+brw_disk_cache_load(struct brw_context *brw,
+                    enum brw_cache_id cache_id,
+                    struct gl_shader_program *prog,
+                    struct gl_program *glprog,
+                    const void *key, GLuint key_size,
+                    void *prog_data, GLuint prog_data_size,
+                    const float ***param, const float ***pull_param,
+                    GLuint param_count,
+                    void *mem_ctx,
+                    const GLuint **program, GLuint *program_size)
+{
+   struct gl_context *ctx = &brw->intel.ctx;
+   struct brw_disk_cache_header header;
+   struct brw_param_ref *refs;
+   size_t ident_size;
+   bool ok = false;
+   FILE *file;
+
+   if (!brw->disk_cache)
+      return false;
+
+   void *tmp_ctx = ralloc_context(NULL);
+   char *ident = make_ident(brw, tmp_ctx, cache_id, prog, key, key_size,
+                            &ident_size);
+   if (!ident) {
+      ralloc_free(tmp_ctx);
+      return false;
+   }
+
+   char *path = make_entry_path(brw->disk_cache, tmp_ctx, ident, ident_size);
+   file = fopen(path, "rb");
+   if (!file) {
+      ralloc_free(tmp_ctx);
+      return false;
+   }
+
+   if (fread(&header, sizeof(header), 1, file) != 1 ||
+       header.magic != BRW_DISK_CACHE_MAGIC ||
+       header.version != BRW_DISK_CACHE_VERSION ||
+       header.ident_size != ident_size ||
+       header.prog_data_size != prog_data_size ||
+       header.nr_params > param_count ||
+       header.nr_pull_params > param_count ||
+       header.program_size == 0 ||
+       header.program_size > BRW_DISK_CACHE_MAX_PROGRAM_SIZE)
+      goto done;
+
+   {
+      char *stored_ident = (char *) ralloc_size(tmp_ctx, ident_size);
+      if (fread(stored_ident, ident_size, 1, file) != 1 ||
+          memcmp(stored_ident, ident, ident_size) != 0)
+         goto done;
+   }
+
+   {
+      const unsigned nr_refs = header.nr_params + header.nr_pull_params;
+      char *stored_prog_data = (char *) ralloc_size(tmp_ctx, prog_data_size);
+      GLuint *stored_program = (GLuint *) ralloc_size(mem_ctx,
+                                                      header.program_size);
+
+      refs = ralloc_array(tmp_ctx, struct brw_param_ref, nr_refs);
+
+      if (fread(stored_prog_data, prog_data_size, 1, file) != 1 ||
+          (nr_refs &&
+           fread(refs, sizeof(*refs), nr_refs, file) != nr_refs) ||
+          fread(stored_program, header.program_size, 1, file) != 1) {
+         ralloc_free(stored_program);
+         goto done;
+      }
+
+      if (!add_param_ref_state(glprog, refs, nr_refs)) {
+         ralloc_free(stored_program);
+         goto done;
+      }
+
+      /* Only now that all the parameters are there, since adding one may
+       * move ParameterValues.
+       */
+      const float **params = *param;
+      const float **pull_params = *pull_param;
+      for (unsigned i = 0; i < nr_refs; i++) {
+         const float **p = i < header.nr_params ?
+            &params[i] : &pull_params[i - header.nr_params];
+
+         if (!param_ref_to_pointer(ctx, prog, glprog, &refs[i], p)) {
+            ralloc_free(stored_program);
+            goto done;
+         }
+      }
+
+      memcpy(prog_data, stored_prog_data, prog_data_size);
+      *param = params;
+      *pull_param = pull_params;
+
+      *program = stored_program;
+      *program_size = header.program_size;
+      ok = true;
+   }
+
+done:
+   DBG("%s: %s %s\n", __FUNCTION__, path, ok ? "hit" : "miss");
+   fclose(file);
+   ralloc_free(tmp_ctx);
+   return ok;
+}
+
+/**
+ * Stores the result of compiling \p prog with \p key, for
+ * brw_disk_cache_load() to find in later runs.
+ */
+void
+brw_disk_cache_store(struct brw_context *brw,
+                     enum brw_cache_id cache_id,
+                     struct gl_shader_program *prog,
+                     struct gl_program *glprog,
+                     const void *key, GLuint key_size,
+                     const void *prog_data, GLuint prog_data_size,
+                     const float **param, GLuint nr_params,
+                     const float **pull_param, GLuint nr_pull_params,
+                     const GLuint *program, GLuint program_size)
+{
+   struct gl_context *ctx = &brw->intel.ctx;
+   struct brw_disk_cache_header header;
+   size_t ident_size;
+   FILE *file;
+
+   if (!brw->disk_cache)
+      return;
+
+   void *tmp_ctx = ralloc_context(NULL);
+   char *ident = make_ident(brw, tmp_ctx, cache_id, prog, key, key_size,
+                            &ident_size);
+   if (!ident) {
+      ralloc_free(tmp_ctx);
+      return;
+   }
+
+   const unsigned nr_refs = nr_params + nr_pull_params;
+   struct brw_param_ref *refs =
+      ralloc_array(tmp_ctx, struct brw_param_ref, MAX2(nr_refs, 1));
+   for (unsigned i = 0; i < nr_refs; i++) {
+      const float *p = i < nr_params ? param[i] : pull_param[i - nr_params];
+
+      if (!param_ref_from_pointer(ctx, prog, glprog, p, &refs[i])) {
+         DBG("%s: can't store a program using param %p\n", __FUNCTION__, p);
+         ralloc_free(tmp_ctx);
+         return;
+      }
+   }
+
+   header.magic = BRW_DISK_CACHE_MAGIC;
+   header.version = BRW_DISK_CACHE_VERSION;
+   header.ident_size = ident_size;
+   header.prog_data_size = prog_data_size;
+   header.nr_params = nr_params;
+   header.nr_pull_params = nr_pull_params;
+   header.program_size = program_size;
+
+   /* Write to a private file and rename it into place, so that other
+    * processes never see a partial entry.
+    */
+   char *path = make_entry_path(brw->disk_cache, tmp_ctx, ident, ident_size);
+   char *tmp_path = ralloc_asprintf(tmp_ctx, "%s.%d.tmp", path, (int) getpid());
+
+   file = fopen(tmp_path, "wb");
+   if (!file) {
+      ralloc_free(tmp_ctx);
+      return;
+   }
+
+   bool ok =
+      fwrite(&header, sizeof(header), 1, file) == 1 &&
+      fwrite(ident, ident_size, 1, file) == 1 &&
+      fwrite(prog_data, prog_data_size, 1, file) == 1 &&
+      (nr_refs == 0 ||
+       fwrite(refs, sizeof(*refs), nr_refs, file) == nr_refs) &&
+      fwrite(program, program_size, 1, file) == 1;
+
+   if (fclose(file) != 0)
+      ok = false;
+
+   if (!ok || rename(tmp_path, path) != 0)
+      unlink(tmp_path);
+
+   DBG("%s: %s %s\n", __FUNCTION__, path, ok ? "stored" : "failed");
+   ralloc_free(tmp_ctx);
+}
+
+/**
+ * Reads the keys stored for the shader described by \p ident, returning how
+ * many there are.
+ */
+static unsigned
+read_variants(const char *path, void *mem_ctx,
+              const char *ident, size_t ident_size,
+              GLuint key_size, char **keys)
+{
+   struct brw_disk_cache_variants_header header;
+   unsigned count = 0;
+   FILE *file;
+
+   *keys = NULL;
+
+   file = fopen(path, "rb");
+   if (!file)
+      return 0;
+
+   char *stored_ident = (char *) ralloc_size(mem_ctx, ident_size);
+
+   if (fread(&header, sizeof(header), 1, file) == 1 &&
+       header.magic == BRW_DISK_CACHE_MAGIC &&
+       header.version == BRW_DISK_CACHE_VERSION &&
+       header.ident_size == ident_size &&
+       header.key_size == key_size &&
+       fread(stored_ident, ident_size, 1, file) == 1 &&
+       memcmp(stored_ident, ident, ident_size) == 0) {
+      *keys = (char *) ralloc_size(mem_ctx,
+                                   BRW_DISK_CACHE_MAX_VARIANTS * key_size);
+
+      /* A partly written key at the end just gets ignored. */
+      count = fread(*keys, key_size, BRW_DISK_CACHE_MAX_VARIANTS, file);
+   }
+
+   fclose(file);
+   return count;
+}
+
+/**
+ * Remembers that \p prog had to be compiled with \p key at draw time, for
+ * brw_disk_cache_load_variants() to return in later runs.
+ *
+ * \p key must not contain anything specific to this run, like
+ * program_string_id.
+ */
+void
+brw_disk_cache_note_variant(struct brw_context *brw,
+                            enum brw_cache_id cache_id,
+                            struct gl_shader_program *prog,
+                            const void *key, GLuint key_size)
+{
+   size_t ident_size;
+   char *keys;
+
+   if (!brw->disk_cache)
+      return;
+
+   void *tmp_ctx = ralloc_context(NULL);
+   char *ident = make_ident(brw, tmp_ctx, cache_id, prog, NULL, key_size,
+                            &ident_size);
+   if (!ident) {
+      ralloc_free(tmp_ctx);
+      return;
+   }
+
+   char *path = ralloc_asprintf(tmp_ctx, "%s.keys",
+                                make_entry_path(brw->disk_cache, tmp_ctx,
+                                                ident, ident_size));
+   unsigned count = read_variants(path, tmp_ctx, ident, ident_size,
+                                  key_size, &keys);
+
+   if (count >= BRW_DISK_CACHE_MAX_VARIANTS) {
+      ralloc_free(tmp_ctx);
+      return;
+   }
+   for (unsigned i = 0; i < count; i++) {
+      if (memcmp(keys + i * key_size, key, key_size) == 0) {
+         ralloc_free(tmp_ctx);
+         return;
+      }
+   }
+
+   if (count) {
+      /* Small appends are atomic, so other processes adding keys at the
+       * same time don't get in the way.
+       */
+      FILE *file = fopen(path, "ab");
+      if (file) {
+         fwrite(key, key_size, 1, file);
+         fclose(file);
+      }
+   } else {
+      struct brw_disk_cache_variants_header header;
+      char *tmp_path = ralloc_asprintf(tmp_ctx, "%s.%d.tmp",
+                                       path, (int) getpid());
+      FILE *file = fopen(tmp_path, "wb");
+
+      header.magic = BRW_DISK_CACHE_MAGIC;
+      header.version = BRW_DISK_CACHE_VERSION;
+      header.ident_size = ident_size;
+      header.key_size = key_size;
+
+      if (file) {
+         bool ok =
+            fwrite(&header, sizeof(header), 1, file) == 1 &&
+            fwrite(ident, ident_size, 1, file) == 1 &&
+            fwrite(key, key_size, 1, file) == 1;
+
+         if (fclose(file) != 0)
+            ok = false;
+
+         if (!ok || rename(tmp_path, path) != 0)
+            unlink(tmp_path);
+      }
+   }
+
+   DBG("%s: %s now has %d keys\n", __FUNCTION__, path, count + 1);
+   ralloc_free(tmp_ctx);
+}
+
+/**
+ * Returns the keys earlier runs compiled \p prog with at draw time, in an
+ * array of \p key_size sized keys allocated out of \p mem_ctx.  Their
+ * program_string_id is left zero for the caller to fill in.
+ */
+unsigned
+brw_disk_cache_load_variants(struct brw_context *brw,
+                             enum brw_cache_id cache_id,
+                             struct gl_shader_program *prog,
+                             GLuint key_size,
+                             void *mem_ctx, void **keys)
+{
+   size_t ident_size;
+   char *stored_keys;
+
+   *keys = NULL;
+
+   if (!brw->disk_cache)
+      return 0;
+
+   void *tmp_ctx = ralloc_context(NULL);
+   char *ident = make_ident(brw, tmp_ctx, cache_id, prog, NULL, key_size,
+                            &ident_size);
+   if (!ident) {
+      ralloc_free(tmp_ctx);
+      return 0;
+   }
+
+   char *path = ralloc_asprintf(tmp_ctx, "%s.keys",
+                                make_entry_path(brw->disk_cache, tmp_ctx,
+                                                ident, ident_size));
+   unsigned count = read_variants(path, tmp_ctx, ident, ident_size,
+                                  key_size, &stored_keys);
+   if (count) {
+      ralloc_steal(mem_ctx, stored_keys);
+      *keys = stored_keys;
+   }
+
+   ralloc_free(tmp_ctx);
+   return count;
+}
@@ -42,9 +42,11 @@ extern "C" {
 #include "program/register_allocate.h"
 #include "program/sampler.h"
 #include "program/hash_table.h"
+#include "intel_mipmap_tree.h"
 #include "brw_context.h"
 #include "brw_eu.h"
 #include "brw_wm.h"
+#include "brw_state.h"
 }
 #include "brw_fs.h"
 #include "glsl/glsl_types.h"
@@ -1160,9 +1162,6 @@ fs_visitor::emit_math(enum opcode opcode, fs_reg dst, fs_reg src0, fs_reg src1)
    switch (opcode) {
    case SHADER_OPCODE_INT_QUOTIENT:
    case SHADER_OPCODE_INT_REMAINDER:
-      if (intel->gen >= 7 && dispatch_width == 16)
-	 fail("16-wide INTDIV unsupported\n");
-      break;
    case SHADER_OPCODE_POW:
       break;
    default:
@@ -2673,10 +2672,10 @@ fs_visitor::lower_uniform_pull_constant_loads()
 
          this->live_intervals_valid = false;
       } else {
-         /* Before register allocation, we didn't tell the scheduler about the
-          * MRF we use.  We know it's safe to use this MRF because nothing
-          * else does except for register spill/unspill, which generates and
-          * uses its MRF within a single IR instruction.
+         /* Until now, we didn't tell the optimizer about the MRF we use.
+          * We know it's safe to use this MRF because nothing else does
+          * except for register spill/unspill, which generates and uses its
+          * MRF within a single IR instruction.
           */
          inst->base_mrf = 14;
          inst->mlen = 1;
@@ -2953,8 +2952,6 @@ fs_visitor::run()
 
       remove_dead_constants();
 
-      schedule_instructions(false);
-
       lower_uniform_pull_constant_loads();
 
       assign_curb_setup();
@@ -2967,10 +2964,34 @@ fs_visitor::run()
 	 }
       }
 
-      if (0)
-	 assign_regs_trivial();
-      else {
-	 while (!assign_regs()) {
+      /* Try the scheduling heuristics in order of decreasing performance
+       * (and increasing register pressure relief), and keep the first
+       * schedule that allocates without spilling.  Only if none does do we
+       * spill, from the schedule that keeps live intervals shortest.
+       */
+      static const instruction_scheduler_mode pre_modes[] = {
+         SCHEDULE_PRE,
+         SCHEDULE_PRE_LIFO,
+      };
+      bool allocated_without_spills = false;
+
+      for (unsigned i = 0; i < ARRAY_SIZE(pre_modes); i++) {
+         schedule_instructions(pre_modes[i]);
+
+         if (0) {
+            assign_regs_trivial();
+            allocated_without_spills = true;
+            break;
+         }
+
+         if (assign_regs(false)) {
+            allocated_without_spills = true;
+            break;
+         }
+      }
+
+      if (!allocated_without_spills) {
+	 while (!assign_regs(true)) {
 	    if (failed)
 	       break;
 	 }
@@ -2988,7 +3009,7 @@ fs_visitor::run()
    if (failed)
       return false;
 
-   schedule_instructions(true);
+   schedule_instructions(SCHEDULE_POST);
 
    if (dispatch_width == 8) {
       c->prog_data.reg_blocks = brw_register_blocks(grf_used);
@@ -3068,6 +3089,9 @@ brw_wm_fs_emit(struct brw_context *brw, struct brw_wm_compile *c,
       } else {
          simd16_instructions = &v2.instructions;
       }
+   } else if (intel->gen >= 5 && c->prog_data.nr_pull_params != 0) {
+      perf_debug("16-wide shader skipped because it uses pull constants, "
+                 "falling back to 8-wide at a 10-20%% performance cost\n");
    }
 
    c->prog_data.dispatch_width = 8;
@@ -3163,6 +3187,24 @@ brw_fs_precompile(struct gl_context *ctx, struct gl_shader_program *prog)
 
    bool success = do_wm_prog(brw, prog, bfp, &key);
 
+   /* Also build the variants that earlier runs had to compile at draw time,
+    * so they don't get compiled during the first frames.
+    */
+   struct brw_wm_prog_key *variants;
+   void *mem_ctx = ralloc_context(NULL);
+   unsigned nr_variants =
+      brw_disk_cache_load_variants(brw, BRW_WM_PROG, prog, sizeof(key),
+                                   mem_ctx, (void **) &variants);
+   for (unsigned i = 0; success && i < nr_variants; i++) {
+      variants[i].program_string_id = bfp->id;
+
+      if (!brw_search_cache(&brw->cache, BRW_WM_PROG,
+                            &variants[i], sizeof(variants[i]),
+                            &brw->wm.prog_offset, &brw->wm.prog_data))
+         do_wm_prog(brw, prog, bfp, &variants[i]);
+   }
+   ralloc_free(mem_ctx);
+
    brw->wm.prog_offset = old_prog_offset;
    brw->wm.prog_data = old_prog_data;
 
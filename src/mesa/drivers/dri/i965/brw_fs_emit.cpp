@@ -252,6 +252,23 @@ fs_generator::generate_math2_gen7(fs_inst *inst,
 			        struct brw_reg src1)
 {
    assert(inst->mlen == 0);
+
+   /* The hardware doesn't do integer division 16 channels at a time, so
+    * do each half separately.
+    */
+   if (dispatch_width == 16 &&
+       (inst->opcode == SHADER_OPCODE_INT_QUOTIENT ||
+	inst->opcode == SHADER_OPCODE_INT_REMAINDER)) {
+      int op = brw_math_function(inst->opcode);
+
+      brw_set_compression_control(p, BRW_COMPRESSION_NONE);
+      brw_math2(p, dst, op, src0, src1);
+      brw_set_compression_control(p, BRW_COMPRESSION_2NDHALF);
+      brw_math2(p, sechalf(dst), op, sechalf(src0), sechalf(src1));
+      brw_set_compression_control(p, BRW_COMPRESSION_COMPRESSED);
+      return;
+   }
+
    brw_math2(p, dst, brw_math_function(inst->opcode), src0, src1);
 }
 
@@ -617,11 +634,21 @@ fs_generator::generate_spill(fs_inst *inst, struct brw_reg src)
 {
    assert(inst->mlen != 0);
 
-   brw_MOV(p,
-	   retype(brw_message_reg(inst->base_mrf + 1), BRW_REGISTER_TYPE_UD),
-	   retype(src, BRW_REGISTER_TYPE_UD));
-   brw_oword_block_write_scratch(p, brw_message_reg(inst->base_mrf), 1,
-				 inst->offset);
+   /* In 16-wide, write each half with a message of its own, so that the
+    * payload still fits in the two MRFs set aside for spilling.
+    */
+   for (unsigned i = 0; i < dispatch_width / 8; i++) {
+      brw_push_insn_state(p);
+      brw_set_compression_control(p, i == 0 ? BRW_COMPRESSION_NONE :
+				  BRW_COMPRESSION_2NDHALF);
+      brw_MOV(p,
+	      retype(brw_message_reg(inst->base_mrf + 1), BRW_REGISTER_TYPE_UD),
+	      retype(i == 0 ? src : sechalf(src), BRW_REGISTER_TYPE_UD));
+      brw_pop_insn_state(p);
+
+      brw_oword_block_write_scratch(p, brw_message_reg(inst->base_mrf), 1,
+				    inst->offset + i * REG_SIZE);
+   }
 }
 
 void
@@ -629,8 +656,11 @@ fs_generator::generate_unspill(fs_inst *inst, struct brw_reg dst)
 {
    assert(inst->mlen != 0);
 
-   brw_oword_block_read_scratch(p, dst, brw_message_reg(inst->base_mrf), 1,
-				inst->offset);
+   for (unsigned i = 0; i < dispatch_width / 8; i++) {
+      brw_oword_block_read_scratch(p, i == 0 ? dst : sechalf(dst),
+				   brw_message_reg(inst->base_mrf), 1,
+				   inst->offset + i * REG_SIZE);
+   }
 }
 
 void
@@ -386,8 +386,15 @@ fs_visitor::setup_mrf_hack_interference(struct ra_graph *g, int first_mrf_node)
    }
 }
 
+/**
+ * Allocates hardware registers for the virtual GRFs.
+ *
+ * If that fails and \p allow_spilling is set, a register is spilled (or the
+ * compile is failed) and false is returned so that the caller can try
+ * again; otherwise the program is left untouched.
+ */
 bool
-fs_visitor::assign_regs()
+fs_visitor::assign_regs(bool allow_spilling)
 {
    /* Most of this allocation was written for a reg_width of 1
     * (dispatch_width == 8).  In extending to 16-wide, the code was
@@ -452,6 +459,11 @@ fs_visitor::assign_regs()
       setup_mrf_hack_interference(g, first_mrf_hack_node);
 
    if (!ra_allocate_no_spills(g)) {
+      if (!allow_spilling) {
+         ralloc_free(g);
+         return false;
+      }
+
       /* Failed to allocate registers.  Spill a reg, and the caller will
        * loop back into here to try again.
        */
@@ -460,9 +472,6 @@ fs_visitor::assign_regs()
       if (reg == -1) {
          fail("no register to spill:\n");
          dump_instructions();
-      } else if (dispatch_width == 16) {
-	 fail("Failure to register allocate.  Reduce number of live scalar "
-              "values to avoid this.");
       } else {
 	 spill_reg(reg);
       }
@@ -598,9 +607,11 @@ void
 fs_visitor::spill_reg(int spill_reg)
 {
    int size = virtual_grf_sizes[spill_reg];
+   /* In 16-wide, each register of a virtual GRF is a pair of hardware ones. */
+   int reg_size = dispatch_width / 8 * REG_SIZE;
    unsigned int spill_offset = c->last_scratch;
    assert(ALIGN(spill_offset, 16) == spill_offset); /* oword read/write req. */
-   c->last_scratch += size * REG_SIZE;
+   c->last_scratch += size * reg_size;
 
    /* Generate spill/unspill instructions for the objects being
     * spilled.  Right now, we spill or unspill the whole thing to a
@@ -615,14 +626,14 @@ fs_visitor::spill_reg(int spill_reg)
 	     inst->src[i].reg == spill_reg) {
 	    inst->src[i].reg = virtual_grf_alloc(1);
 	    emit_unspill(inst, inst->src[i],
-                         spill_offset + REG_SIZE * inst->src[i].reg_offset);
+                         spill_offset + reg_size * inst->src[i].reg_offset);
 	 }
       }
 
       if (inst->dst.file == GRF &&
 	  inst->dst.reg == spill_reg) {
          int subset_spill_offset = (spill_offset +
-                                    REG_SIZE * inst->dst.reg_offset);
+                                    reg_size * inst->dst.reg_offset);
          inst->dst.reg = virtual_grf_alloc(inst->regs_written);
          inst->dst.reg_offset = 0;
 
@@ -634,7 +645,7 @@ fs_visitor::spill_reg(int spill_reg)
             fs_reg unspill_reg = inst->dst;
             for (int chan = 0; chan < inst->regs_written; chan++) {
                emit_unspill(inst, unspill_reg,
-                            subset_spill_offset + REG_SIZE * chan);
+                            subset_spill_offset + reg_size * chan);
                unspill_reg.reg_offset++;
             }
 	 }
@@ -649,7 +660,7 @@ fs_visitor::spill_reg(int spill_reg)
 	    fs_inst *spill_inst = new(mem_ctx) fs_inst(FS_OPCODE_SPILL,
 						       reg_null_f, spill_src);
 	    spill_src.reg_offset++;
-	    spill_inst->offset = subset_spill_offset + chan * REG_SIZE;
+	    spill_inst->offset = subset_spill_offset + chan * reg_size;
 	    spill_inst->ir = inst->ir;
 	    spill_inst->annotation = inst->annotation;
 	    spill_inst->base_mrf = 14;
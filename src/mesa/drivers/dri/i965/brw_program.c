@@ -42,6 +42,9 @@
 #include "brw_context.h"
 #include "brw_wm.h"
 
+/* Shared so that brw_disk_cache can recognize it. */
+const float brw_param_zero = 0.0;
+
 static unsigned
 get_new_program_id(struct intel_screen *screen)
 {
@@ -344,14 +344,16 @@ schedule_node::set_latency_gen7(bool is_haswell)
 
 class instruction_scheduler {
 public:
-   instruction_scheduler(backend_visitor *v, int grf_count, bool post_reg_alloc)
+   instruction_scheduler(backend_visitor *v, int grf_count,
+                         instruction_scheduler_mode mode)
    {
       this->bv = v;
       this->mem_ctx = ralloc_context(v->mem_ctx);
       this->grf_count = grf_count;
       this->instructions.make_empty();
       this->instructions_to_schedule = 0;
-      this->post_reg_alloc = post_reg_alloc;
+      this->post_reg_alloc = (mode == SCHEDULE_POST);
+      this->mode = mode;
       this->time = 0;
    }
 
@@ -377,11 +379,26 @@ public:
     */
    virtual int issue_time(backend_instruction *inst) = 0;
 
+   /**
+    * Sets up register pressure tracking for the block in the instruction
+    * list, which covers IPs block_start_ip to block_end_ip of the program.
+    */
+   virtual void setup_register_pressure(int block_start_ip,
+                                        int block_end_ip) = 0;
+   /** Updates register pressure tracking for a scheduled instruction. */
+   virtual void update_register_pressure(backend_instruction *inst) = 0;
+   /**
+    * Returns how many registers scheduling the instruction now would free
+    * (or, if negative, newly occupy).
+    */
+   virtual int get_register_pressure_benefit(backend_instruction *inst) = 0;
+
    void schedule_instructions(backend_instruction *next_block_header);
 
    void *mem_ctx;
 
    bool post_reg_alloc;
+   instruction_scheduler_mode mode;
    int instructions_to_schedule;
    int grf_count;
    int time;
@@ -392,20 +409,115 @@ public:
 class fs_instruction_scheduler : public instruction_scheduler
 {
 public:
-   fs_instruction_scheduler(fs_visitor *v, int grf_count, bool post_reg_alloc);
+   fs_instruction_scheduler(fs_visitor *v, int grf_count,
+                            instruction_scheduler_mode mode);
    void calculate_deps();
    bool is_compressed(fs_inst *inst);
    schedule_node *choose_instruction_to_schedule();
    int issue_time(backend_instruction *inst);
    fs_visitor *v;
+
+   void setup_register_pressure(int block_start_ip, int block_end_ip);
+   void update_register_pressure(backend_instruction *inst);
+   int get_register_pressure_benefit(backend_instruction *inst);
+
+   /**
+    * Before register allocation, the number of reads of each virtual GRF
+    * still to be scheduled, plus one if it's live out of the block.
+    */
+   int *remaining_grf_uses;
+   /** Whether each virtual GRF currently occupies registers. */
+   bool *grf_active;
 };
 
 fs_instruction_scheduler::fs_instruction_scheduler(fs_visitor *v,
                                                    int grf_count,
-                                                   bool post_reg_alloc)
-   : instruction_scheduler(v, grf_count, post_reg_alloc),
+                                                   instruction_scheduler_mode mode)
+   : instruction_scheduler(v, grf_count, mode),
      v(v)
 {
+   if (!post_reg_alloc) {
+      this->remaining_grf_uses = rzalloc_array(mem_ctx, int, grf_count);
+      this->grf_active = rzalloc_array(mem_ctx, bool, grf_count);
+   } else {
+      this->remaining_grf_uses = NULL;
+      this->grf_active = NULL;
+   }
+}
+
+void
+fs_instruction_scheduler::setup_register_pressure(int block_start_ip,
+                                                  int block_end_ip)
+{
+   if (post_reg_alloc)
+      return;
+
+   /* Use the live intervals to find what's live into and out of the block:
+    * a value live out will never be freed by scheduling inside it, and a
+    * value live in already has its registers.
+    */
+   for (int i = 0; i < grf_count; i++) {
+      remaining_grf_uses[i] = v->virtual_grf_end[i] > block_end_ip;
+      grf_active[i] = v->virtual_grf_start[i] < block_start_ip;
+   }
+
+   foreach_list(node, &instructions) {
+      schedule_node *n = (schedule_node *)node;
+      fs_inst *inst = (fs_inst *)n->inst;
+
+      for (int i = 0; i < 3; i++) {
+         if (inst->src[i].file == GRF)
+            remaining_grf_uses[inst->src[i].reg]++;
+      }
+   }
+}
+
+void
+fs_instruction_scheduler::update_register_pressure(backend_instruction *be)
+{
+   fs_inst *inst = (fs_inst *)be;
+
+   if (post_reg_alloc)
+      return;
+
+   if (inst->dst.file == GRF)
+      grf_active[inst->dst.reg] = true;
+
+   for (int i = 0; i < 3; i++) {
+      if (inst->src[i].file == GRF)
+         remaining_grf_uses[inst->src[i].reg]--;
+   }
+}
+
+int
+fs_instruction_scheduler::get_register_pressure_benefit(backend_instruction *be)
+{
+   fs_inst *inst = (fs_inst *)be;
+   int benefit = 0;
+
+   if (inst->dst.file == GRF && !grf_active[inst->dst.reg])
+      benefit -= v->virtual_grf_sizes[inst->dst.reg];
+
+   for (int i = 0; i < 3; i++) {
+      if (inst->src[i].file != GRF)
+         continue;
+
+      /* Count each virtual GRF once, against all of its reads here. */
+      int uses = 0;
+      bool seen = false;
+      for (int j = 0; j < 3; j++) {
+         if (inst->src[j].file == GRF && inst->src[j].reg == inst->src[i].reg) {
+            if (j < i)
+               seen = true;
+            uses++;
+         }
+      }
+
+      if (!seen && remaining_grf_uses[inst->src[i].reg] == uses)
+         benefit += v->virtual_grf_sizes[inst->src[i].reg];
+   }
+
+   return benefit;
 }
 
 class vec4_instruction_scheduler : public instruction_scheduler
@@ -416,15 +528,39 @@ public:
    schedule_node *choose_instruction_to_schedule();
    int issue_time(backend_instruction *inst);
    vec4_visitor *v;
+
+   void setup_register_pressure(int block_start_ip, int block_end_ip);
+   void update_register_pressure(backend_instruction *inst);
+   int get_register_pressure_benefit(backend_instruction *inst);
 };
 
 vec4_instruction_scheduler::vec4_instruction_scheduler(vec4_visitor *v,
                                                        int grf_count)
-   : instruction_scheduler(v, grf_count, true),
+   : instruction_scheduler(v, grf_count, SCHEDULE_POST),
      v(v)
 {
 }
 
+/* The vec4 backend only schedules after register allocation, where
+ * register pressure no longer matters.
+ */
+void
+vec4_instruction_scheduler::setup_register_pressure(int block_start_ip,
+                                                    int block_end_ip)
+{
+}
+
+void
+vec4_instruction_scheduler::update_register_pressure(backend_instruction *inst)
+{
+}
+
+int
+vec4_instruction_scheduler::get_register_pressure_benefit(backend_instruction *inst)
+{
+   return 0;
+}
+
 void
 instruction_scheduler::add_inst(backend_instruction *inst)
 {
@@ -927,7 +1063,7 @@ fs_instruction_scheduler::choose_instruction_to_schedule()
 {
    schedule_node *chosen = NULL;
 
-   if (post_reg_alloc) {
+   if (mode == SCHEDULE_POST) {
       int chosen_time = 0;
 
       /* Of the instructions closest ready to execute or the closest to
@@ -941,6 +1077,36 @@ fs_instruction_scheduler::choose_instruction_to_schedule()
             chosen_time = n->unblocked_time;
          }
       }
+   } else if (mode == SCHEDULE_PRE) {
+      int chosen_time = 0;
+      int chosen_benefit = 0;
+
+      /* Schedule for latency as after register allocation, except that an
+       * instruction which frees registers goes first, so that we don't
+       * pile up live values while waiting on long-latency results.  If
+       * that still ends up needing to spill, the caller falls back to
+       * SCHEDULE_PRE_LIFO.
+       */
+      foreach_list(node, &instructions) {
+         schedule_node *n = (schedule_node *)node;
+         int benefit = get_register_pressure_benefit(n->inst);
+         bool better;
+
+         if (!chosen)
+            better = true;
+         else if (benefit > 0 || chosen_benefit > 0)
+            better = (benefit > chosen_benefit ||
+                      (benefit == chosen_benefit &&
+                       n->unblocked_time < chosen_time));
+         else
+            better = n->unblocked_time < chosen_time;
+
+         if (better) {
+            chosen = n;
+            chosen_time = n->unblocked_time;
+            chosen_benefit = benefit;
+         }
+      }
    } else {
       /* Before register allocation, we don't care about the latencies of
        * instructions.  All we care about is reducing live intervals of
@@ -1032,6 +1198,7 @@ instruction_scheduler::schedule_instructions(backend_instruction *next_block_hea
       chosen->remove();
       next_block_header->insert_before(chosen->inst);
       instructions_to_schedule--;
+      update_register_pressure(chosen->inst);
 
       /* Update the clock for how soon an instruction could start after the
        * chosen one.
@@ -1101,16 +1268,22 @@ instruction_scheduler::run(exec_list *all_instructions)
       bv->dump_instructions();
    }
 
+   int ip = 0;
+
    while (!next_block_header->is_tail_sentinel()) {
+      int block_start_ip = ip;
+
       /* Add things to be scheduled until we get to a new BB. */
       while (!next_block_header->is_tail_sentinel()) {
 	 backend_instruction *inst = next_block_header;
 	 next_block_header = (backend_instruction *)next_block_header->next;
 
 	 add_inst(inst);
+         ip++;
          if (inst->is_control_flow())
 	    break;
       }
+      setup_register_pressure(block_start_ip, ip - 1);
       calculate_deps();
       schedule_instructions(next_block_header);
    }
@@ -1122,18 +1295,20 @@ instruction_scheduler::run(exec_list *all_instructions)
 }
 
 void
-fs_visitor::schedule_instructions(bool post_reg_alloc)
+fs_visitor::schedule_instructions(instruction_scheduler_mode mode)
 {
    int grf_count;
-   if (post_reg_alloc)
+   if (mode == SCHEDULE_POST) {
       grf_count = grf_used;
-   else
+   } else {
       grf_count = virtual_grf_count;
+      calculate_live_intervals();
+   }
 
-   fs_instruction_scheduler sched(this, grf_count, post_reg_alloc);
+   fs_instruction_scheduler sched(this, grf_count, mode);
    sched.run(&instructions);
 
-   if (unlikely(INTEL_DEBUG & DEBUG_WM) && post_reg_alloc) {
+   if (unlikely(INTEL_DEBUG & DEBUG_WM) && mode == SCHEDULE_POST) {
       printf("fs%d estimated execution time: %d cycles\n",
              dispatch_width, sched.time);
    }
@@ -107,6 +107,46 @@ brw_lower_packing_builtins(struct brw_context *brw,
    lower_packing_builtins(ir, ops);
 }
 
+/**
+ * Sets up brw_shader::cache_ident for a freshly linked shader.
+ *
+ * The program key covers the GL state the backends look at, so this only
+ * has to tell apart linked shaders that would compile differently.
+ */
+static void
+brw_set_cache_ident(struct gl_shader_program *shProg,
+                    struct brw_shader *shader)
+{
+   ralloc_free(shader->cache_ident);
+
+   char *ident = ralloc_asprintf(shader, "%s\n",
+                                 _mesa_glsl_shader_target_name(shader->base.Type));
+
+   for (unsigned i = 0; i < shProg->NumShaders; i++) {
+      const struct gl_shader *sh = shProg->Shaders[i];
+
+      ralloc_asprintf_append(&ident, "%s source:\n%s\n",
+                             _mesa_glsl_shader_target_name(sh->Type),
+                             sh->Source ? sh->Source : "");
+   }
+
+   /* Locations come from the linker, explicit bindings and the other
+    * stages, not just from the source.
+    */
+   foreach_list(node, shader->ir) {
+      ir_variable *var = ((ir_instruction *) node)->as_variable();
+
+      if (!var)
+         continue;
+
+      ralloc_asprintf_append(&ident, "%d %d %s %s %d\n",
+                             var->mode, var->interpolation,
+                             var->type->name, var->name, var->location);
+   }
+
+   shader->cache_ident = ident;
+}
+
 GLboolean
 brw_link_shader(struct gl_context *ctx, struct gl_shader_program *shProg)
 {
@@ -213,6 +253,12 @@ brw_link_shader(struct gl_context *ctx, struct gl_shader_program *shProg)
 	   || progress;
       } while (progress);
 
+      /* The vec4 back-end benefits from having the scalarized operations
+       * packed back together; the FS back-end splits them apart again.
+       */
+      if (stage != MESA_SHADER_FRAGMENT)
+	 do_vectorize(shader->ir);
+
       /* Make a pass over the IR to add state references for any built-in
        * uniforms that are used.  This has to be done now (during linking).
        * Code generation doesn't happen until the first time this shader is
@@ -257,6 +303,8 @@ brw_link_shader(struct gl_context *ctx, struct gl_shader_program *shProg)
        */
       _mesa_associate_uniform_storage(ctx, shProg, prog->Parameters);
 
+      brw_set_cache_ident(shProg, shader);
+
       _mesa_reference_program(ctx, &prog, NULL);
 
       if (ctx->Shader.Flags & GLSL_DUMP) {
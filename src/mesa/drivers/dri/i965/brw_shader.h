@@ -38,6 +38,24 @@ enum register_file {
    UNIFORM, /* prog_data->params[reg] */
 };
 
+/**
+ * The heuristic used by the instruction scheduler.
+ */
+enum instruction_scheduler_mode {
+   /**
+    * Before register allocation: hide latency like the post-RA scheduler
+    * does, but take anything that frees up registers first.
+    */
+   SCHEDULE_PRE,
+   /**
+    * Before register allocation: schedule depth-first to keep live
+    * intervals short, ignoring latency.
+    */
+   SCHEDULE_PRE_LIFO,
+   /** After register allocation: hide latency. */
+   SCHEDULE_POST,
+};
+
 class backend_instruction : public exec_node {
 public:
    bool is_tex();
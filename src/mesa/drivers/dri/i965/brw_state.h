@@ -157,6 +157,44 @@ void brw_state_cache_check_size( struct brw_context *brw );
 void brw_init_caches( struct brw_context *brw );
 void brw_destroy_caches( struct brw_context *brw );
 
+/***********************************************************************
+ * brw_disk_cache.cpp
+ */
+struct brw_disk_cache *brw_disk_cache_create(struct brw_context *brw);
+void brw_disk_cache_destroy(struct brw_disk_cache *cache);
+
+bool brw_disk_cache_load(struct brw_context *brw,
+                         enum brw_cache_id cache_id,
+                         struct gl_shader_program *prog,
+                         struct gl_program *glprog,
+                         const void *key, GLuint key_size,
+                         void *prog_data, GLuint prog_data_size,
+                         const float ***param, const float ***pull_param,
+                         GLuint param_count,
+                         void *mem_ctx,
+                         const GLuint **program, GLuint *program_size);
+
+void brw_disk_cache_store(struct brw_context *brw,
+                          enum brw_cache_id cache_id,
+                          struct gl_shader_program *prog,
+                          struct gl_program *glprog,
+                          const void *key, GLuint key_size,
+                          const void *prog_data, GLuint prog_data_size,
+                          const float **param, GLuint nr_params,
+                          const float **pull_param, GLuint nr_pull_params,
+                          const GLuint *program, GLuint program_size);
+
+void brw_disk_cache_note_variant(struct brw_context *brw,
+                                 enum brw_cache_id cache_id,
+                                 struct gl_shader_program *prog,
+                                 const void *key, GLuint key_size);
+
+unsigned brw_disk_cache_load_variants(struct brw_context *brw,
+                                      enum brw_cache_id cache_id,
+                                      struct gl_shader_program *prog,
+                                      GLuint key_size,
+                                      void *mem_ctx, void **keys);
+
 /***********************************************************************
  * brw_state_batch.c
  */
@@ -168,6 +206,11 @@ void *brw_state_batch(struct brw_context *brw,
 		      int size,
 		      int alignment,
 		      uint32_t *out_offset);
+void brw_state_batch_cached(struct brw_context *brw,
+			    int size,
+			    int alignment,
+			    uint32_t *inout_offset);
+void brw_state_batch_cache_reset(struct brw_context *brw);
 
 /* brw_wm_surface_state.c */
 void gen4_init_vtable_surface_functions(struct brw_context *brw);
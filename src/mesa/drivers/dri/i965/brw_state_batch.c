@@ -32,6 +32,7 @@
 #include "brw_state.h"
 #include "intel_batchbuffer.h"
 #include "main/imports.h"
+#include "main/hash_table.h"
 #include "glsl/ralloc.h"
 
 static void
@@ -139,6 +140,7 @@ brw_state_batch(struct brw_context *brw,
       offset = ROUND_DOWN_TO(batch->state_batch_offset - size, alignment);
    }
 
+   brw->state_batch_cache.prev_offset = batch->state_batch_offset;
    batch->state_batch_offset = offset;
 
    if (unlikely(INTEL_DEBUG & (DEBUG_BATCH | DEBUG_AUB)))
@@ -147,3 +149,85 @@ brw_state_batch(struct brw_context *brw,
    *out_offset = offset;
    return batch->map + (offset>>2);
 }
+
+/**
+ * Shares indirect state with an identical copy earlier in the batch.
+ *
+ * Call this right after filling in the state returned by the last
+ * brw_state_batch() call, with the size, alignment and offset it was
+ * given.  If the same bytes are already in the batch, that space is handed
+ * back and *inout_offset points at the earlier copy instead; otherwise the
+ * new state is remembered for later calls.  This keeps repeated draws with the same
+ * state from filling up the batch (and thus flushing) as quickly, and often
+ * lets the state pointer packets be skipped as unchanged.
+ *
+ * The state must not have relocations: those are tied to the copy they were
+ * emitted for, and equal bytes don't mean equal relocation targets.
+ */
+void
+brw_state_batch_cached(struct brw_context *brw,
+		       int size,
+		       int alignment,
+		       uint32_t *inout_offset)
+{
+   struct intel_batchbuffer *batch = &brw->intel.batch;
+   const uint32_t offset = *inout_offset;
+   const void *data = (char *)batch->map + offset;
+   uint32_t hash;
+   int *bucket;
+   int i;
+
+   /* Only the latest allocation can be given back. */
+   if (offset != batch->state_batch_offset)
+      return;
+
+   hash = _mesa_hash_data(data, size);
+   bucket = &brw->state_batch_cache.buckets[hash %
+					    BRW_STATE_BATCH_CACHE_BUCKETS];
+
+   for (i = *bucket; i; i = brw->state_batch_cache.items[i - 1].next) {
+      struct brw_state_batch_item *item = &brw->state_batch_cache.items[i - 1];
+
+      if (item->hash == hash && item->size == size &&
+	  (item->offset & (alignment - 1)) == 0 &&
+	  memcmp((char *)batch->map + item->offset, data, size) == 0) {
+	 batch->state_batch_offset = brw->state_batch_cache.prev_offset;
+	 if (unlikely(INTEL_DEBUG & (DEBUG_BATCH | DEBUG_AUB)))
+	    brw->state_batch_count--;
+
+	 *inout_offset = item->offset;
+	 return;
+      }
+   }
+
+   if (brw->state_batch_cache.n_items == brw->state_batch_cache.max_items) {
+      int max_items = MAX2(brw->state_batch_cache.max_items * 2, 64);
+      struct brw_state_batch_item *items =
+	 reralloc(brw, brw->state_batch_cache.items,
+		  struct brw_state_batch_item, max_items);
+
+      if (!items)
+	 return;
+
+      brw->state_batch_cache.items = items;
+      brw->state_batch_cache.max_items = max_items;
+   }
+
+   i = brw->state_batch_cache.n_items++;
+   brw->state_batch_cache.items[i].hash = hash;
+   brw->state_batch_cache.items[i].offset = offset;
+   brw->state_batch_cache.items[i].size = size;
+   brw->state_batch_cache.items[i].next = *bucket;
+   *bucket = i + 1;
+}
+
+/**
+ * Forgets the state of the previous batch, called when a new batch starts.
+ */
+void
+brw_state_batch_cache_reset(struct brw_context *brw)
+{
+   brw->state_batch_cache.n_items = 0;
+   memset(brw->state_batch_cache.buckets, 0,
+	  sizeof(brw->state_batch_cache.buckets));
+}
@@ -257,6 +257,7 @@ void brw_init_state( struct brw_context *brw )
 {
    const struct brw_tracked_state **atoms;
    int num_atoms;
+   int i, bit;
 
    brw_init_caches(brw);
 
@@ -274,12 +275,24 @@ void brw_init_state( struct brw_context *brw )
    brw->atoms = atoms;
    brw->num_atoms = num_atoms;
 
-   while (num_atoms--) {
-      assert((*atoms)->dirty.mesa |
-	     (*atoms)->dirty.brw |
-	     (*atoms)->dirty.cache);
-      assert((*atoms)->emit);
-      atoms++;
+   /* The atom masks in brw->atom_deps are 64 bits wide. */
+   assert(num_atoms <= 64);
+
+   memset(&brw->atom_deps, 0, sizeof(brw->atom_deps));
+   for (i = 0; i < num_atoms; i++) {
+      assert(atoms[i]->dirty.mesa |
+	     atoms[i]->dirty.brw |
+	     atoms[i]->dirty.cache);
+      assert(atoms[i]->emit);
+
+      for (bit = 0; bit < 32; bit++) {
+	 if (atoms[i]->dirty.mesa & (1u << bit))
+	    brw->atom_deps.mesa[bit] |= 1ull << i;
+	 if (atoms[i]->dirty.brw & (1u << bit))
+	    brw->atom_deps.brw[bit] |= 1ull << i;
+	 if (atoms[i]->dirty.cache & (1u << bit))
+	    brw->atom_deps.cache[bit] |= 1ull << i;
+      }
    }
 
    brw_upload_initial_gpu_state(brw);
@@ -311,6 +324,31 @@ static void accumulate_state( struct brw_state_flags *a,
 }
 
 
+static uint64_t
+atoms_for_bits(const uint64_t *deps, GLuint bits)
+{
+   uint64_t atoms = 0;
+
+   while (bits) {
+      atoms |= deps[ffs(bits) - 1];
+      bits &= bits - 1;
+   }
+
+   return atoms;
+}
+
+/**
+ * Returns the mask of atoms that check any of the given dirty bits.
+ */
+static uint64_t
+atoms_for_state(const struct brw_context *brw,
+		const struct brw_state_flags *flags)
+{
+   return (atoms_for_bits(brw->atom_deps.mesa, flags->mesa) |
+	   atoms_for_bits(brw->atom_deps.brw, flags->brw) |
+	   atoms_for_bits(brw->atom_deps.cache, flags->cache));
+}
+
 static void xor_states( struct brw_state_flags *result,
 			     const struct brw_state_flags *a,
 			      const struct brw_state_flags *b )
@@ -509,11 +547,31 @@ void brw_upload_state(struct brw_context *brw)
       }
    }
    else {
-      for (i = 0; i < brw->num_atoms; i++) {
-	 const struct brw_tracked_state *atom = brw->atoms[i];
+      /* Rather than checking every atom, walk only the ones that depend on
+       * a dirty bit.  Atoms may flag more state as they run (new programs,
+       * new binding tables, ...), so after each one pick up the atoms
+       * after it that depend on the newly raised bits.  Since atoms only
+       * ever raise bits checked by later atoms (which the debug path above
+       * asserts), this emits exactly what the plain walk over the list
+       * would.
+       */
+      struct brw_state_flags seen = *state;
+      uint64_t pending = atoms_for_state(brw, state);
 
-	 if (check_state(state, &atom->dirty)) {
-	    atom->emit(brw);
+      while (pending) {
+	 struct brw_state_flags raised;
+
+	 i = ffsll(pending) - 1;
+	 pending &= pending - 1;
+
+	 brw->atoms[i]->emit(brw);
+
+	 raised.mesa = state->mesa & ~seen.mesa;
+	 raised.brw = state->brw & ~seen.brw;
+	 raised.cache = state->cache & ~seen.cache;
+	 if (raised.mesa | raised.brw | raised.cache) {
+	    pending |= atoms_for_state(brw, &raised) & ~((2ull << i) - 1);
+	    seen = *state;
 	 }
       }
    }
@@ -1267,8 +1267,7 @@ vec4_visitor::setup_uniforms(int reg)
 
       for (unsigned int i = 0; i < 4; i++) {
 	 unsigned int slot = this->uniforms * 4 + i;
-	 static float zero = 0.0;
-	 prog_data->param[slot] = &zero;
+	 prog_data->param[slot] = &brw_param_zero;
       }
 
       this->uniforms++;
@@ -648,8 +648,7 @@ vec4_visitor::setup_uniform_values(ir_variable *ir)
             components++;
          }
          for (; i < 4; i++) {
-            static float zero = 0;
-            prog_data->param[uniforms * 4 + i] = &zero;
+            prog_data->param[uniforms * 4 + i] = &brw_param_zero;
          }
 
          uniforms++;
@@ -290,33 +290,55 @@ do_vs_prog(struct brw_context *brw,
 			       true);
    }
 
-   /* Emit GEN4 code.
+   /* The disk cache knows the program by its source, not by this run's id.
     */
-   program = brw_vs_emit(brw, prog, &c, &prog_data, mem_ctx, &program_size);
-   if (program == NULL) {
-      ralloc_free(mem_ctx);
-      return false;
-   }
+   struct brw_vs_prog_key disk_key = c.key;
+   disk_key.base.program_string_id = 0;
+
+   if (!brw_disk_cache_load(brw, BRW_VS_PROG, prog, &vp->program.Base,
+                            &disk_key, sizeof(disk_key),
+                            &prog_data, sizeof(prog_data),
+                            &prog_data.base.param, &prog_data.base.pull_param,
+                            param_count, mem_ctx, &program, &program_size)) {
+      /* Emit GEN4 code.
+       */
+      program = brw_vs_emit(brw, prog, &c, &prog_data, mem_ctx,
+                            &program_size);
+      if (program == NULL) {
+         ralloc_free(mem_ctx);
+         return false;
+      }
 
-   if (prog_data.base.nr_pull_params)
-      prog_data.base.num_surfaces = 1;
-   if (c.vp->program.Base.SamplersUsed)
-      prog_data.base.num_surfaces = SURF_INDEX_VS_TEXTURE(BRW_MAX_TEX_UNIT);
-   if (prog &&
-       prog->_LinkedShaders[MESA_SHADER_VERTEX]->NumUniformBlocks) {
-      prog_data.base.num_surfaces =
-	 SURF_INDEX_VS_UBO(prog->_LinkedShaders[MESA_SHADER_VERTEX]->NumUniformBlocks);
-   }
+      if (prog_data.base.nr_pull_params)
+         prog_data.base.num_surfaces = 1;
+      if (c.vp->program.Base.SamplersUsed)
+         prog_data.base.num_surfaces = SURF_INDEX_VS_TEXTURE(BRW_MAX_TEX_UNIT);
+      if (prog &&
+          prog->_LinkedShaders[MESA_SHADER_VERTEX]->NumUniformBlocks) {
+         prog_data.base.num_surfaces =
+            SURF_INDEX_VS_UBO(prog->_LinkedShaders[MESA_SHADER_VERTEX]->NumUniformBlocks);
+      }
+
+      /* Scratch space is used for register spilling */
+      if (c.base.last_scratch) {
+         perf_debug("Vertex shader triggered register spilling.  "
+                    "Try reducing the number of live vec4 values to "
+                    "improve performance.\n");
 
-   /* Scratch space is used for register spilling */
-   if (c.base.last_scratch) {
-      perf_debug("Vertex shader triggered register spilling.  "
-                 "Try reducing the number of live vec4 values to "
-                 "improve performance.\n");
+         prog_data.base.total_scratch
+            = brw_get_scratch_size(c.base.last_scratch*REG_SIZE);
+      }
 
-      prog_data.base.total_scratch
-         = brw_get_scratch_size(c.base.last_scratch*REG_SIZE);
+      brw_disk_cache_store(brw, BRW_VS_PROG, prog, &vp->program.Base,
+                           &disk_key, sizeof(disk_key),
+                           &prog_data, sizeof(prog_data),
+                           prog_data.base.param, prog_data.base.nr_params,
+                           prog_data.base.pull_param,
+                           prog_data.base.nr_pull_params,
+                           program, program_size);
+   }
 
+   if (prog_data.base.total_scratch) {
       brw_get_scratch_bo(intel, &brw->vs.scratch_bo,
 			 prog_data.base.total_scratch * brw->max_vs_threads);
    }
@@ -496,6 +518,13 @@ static void brw_upload_vs_prog(struct brw_context *brw)
    if (!brw_search_cache(&brw->cache, BRW_VS_PROG,
 			 &key, sizeof(key),
 			 &brw->vs.prog_offset, &brw->vs.prog_data)) {
+      /* Have brw_vs_precompile() build this variant in later runs. */
+      struct brw_vs_prog_key disk_key = key;
+      disk_key.base.program_string_id = 0;
+      brw_disk_cache_note_variant(brw, BRW_VS_PROG,
+                                  ctx->Shader.CurrentVertexProgram,
+                                  &disk_key, sizeof(disk_key));
+
       bool success = do_vs_prog(brw, ctx->Shader.CurrentVertexProgram,
 				vp, &key);
 
@@ -556,6 +585,24 @@ brw_vs_precompile(struct gl_context *ctx, struct gl_shader_program *prog)
 
    success = do_vs_prog(brw, prog, bvp, &key);
 
+   /* Also build the variants that earlier runs had to compile at draw time,
+    * so they don't get compiled during the first frames.
+    */
+   struct brw_vs_prog_key *variants;
+   void *mem_ctx = ralloc_context(NULL);
+   unsigned nr_variants =
+      brw_disk_cache_load_variants(brw, BRW_VS_PROG, prog, sizeof(key),
+                                   mem_ctx, (void **) &variants);
+   for (unsigned i = 0; success && i < nr_variants; i++) {
+      variants[i].base.program_string_id = bvp->id;
+
+      if (!brw_search_cache(&brw->cache, BRW_VS_PROG,
+                            &variants[i], sizeof(variants[i]),
+                            &brw->vs.prog_offset, &brw->vs.prog_data))
+         do_vs_prog(brw, prog, bvp, &variants[i]);
+   }
+   ralloc_free(mem_ctx);
+
    brw->vs.prog_offset = old_prog_offset;
    brw->vs.prog_data = old_prog_data;
 
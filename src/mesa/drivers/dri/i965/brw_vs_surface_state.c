@@ -170,6 +170,9 @@ brw_vs_upload_binding_table(struct brw_context *brw)
       bind[i] = brw->vs.surf_offset[i];
    }
 
+   brw_state_batch_cached(brw, sizeof(uint32_t) * BRW_MAX_VS_SURFACES,
+                          32, &brw->vs.bind_bo_offset);
+
    brw->state.dirty.brw |= BRW_NEW_VS_BINDING_TABLE;
 }
 
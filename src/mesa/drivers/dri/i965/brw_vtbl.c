@@ -80,6 +80,7 @@ static void brw_destroy_context( struct intel_context *intel )
 
    brw_destroy_state(brw);
    brw_draw_destroy( brw );
+   brw_disk_cache_destroy(brw->disk_cache);
 
    dri_bo_release(&brw->curbe.curbe_bo);
    dri_bo_release(&brw->vs.const_bo);
@@ -149,6 +150,7 @@ static void brw_new_batch( struct intel_context *intel )
    intel->batch.need_workaround_flush = true;
 
    brw->state_batch_count = 0;
+   brw_state_batch_cache_reset(brw);
 
    brw->ib.type = -1;
 
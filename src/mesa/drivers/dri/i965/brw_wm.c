@@ -172,18 +172,39 @@ bool do_wm_prog(struct brw_context *brw,
       brw_compute_barycentric_interp_modes(brw, c->key.flat_shade,
                                            &fp->program);
 
-   program = brw_wm_fs_emit(brw, c, &fp->program, prog, &program_size);
-   if (program == NULL)
-      return false;
-
-   /* Scratch space is used for register spilling */
-   if (c->last_scratch) {
-      perf_debug("Fragment shader triggered register spilling.  "
-                 "Try reducing the number of live scalar values to "
-                 "improve performance.\n");
+   /* The disk cache knows the program by its source, not by this run's id.
+    */
+   struct brw_wm_prog_key disk_key = c->key;
+   disk_key.program_string_id = 0;
+
+   if (!brw_disk_cache_load(brw, BRW_WM_PROG, prog, &fp->program.Base,
+                            &disk_key, sizeof(disk_key),
+                            &c->prog_data, sizeof(c->prog_data),
+                            &c->prog_data.param, &c->prog_data.pull_param,
+                            param_count, c, &program, &program_size)) {
+      program = brw_wm_fs_emit(brw, c, &fp->program, prog, &program_size);
+      if (program == NULL)
+         return false;
+
+      /* Scratch space is used for register spilling */
+      if (c->last_scratch) {
+         perf_debug("Fragment shader triggered register spilling.  "
+                    "Try reducing the number of live scalar values to "
+                    "improve performance.\n");
+
+         c->prog_data.total_scratch = brw_get_scratch_size(c->last_scratch);
+      }
 
-      c->prog_data.total_scratch = brw_get_scratch_size(c->last_scratch);
+      brw_disk_cache_store(brw, BRW_WM_PROG, prog, &fp->program.Base,
+                           &disk_key, sizeof(disk_key),
+                           &c->prog_data, sizeof(c->prog_data),
+                           c->prog_data.param, c->prog_data.nr_params,
+                           c->prog_data.pull_param,
+                           c->prog_data.nr_pull_params,
+                           program, program_size);
+   }
 
+   if (c->prog_data.total_scratch) {
       brw_get_scratch_bo(intel, &brw->wm.scratch_bo,
 			 c->prog_data.total_scratch * brw->max_wm_threads);
    }
@@ -487,6 +508,13 @@ brw_upload_wm_prog(struct brw_context *brw)
    if (!brw_search_cache(&brw->cache, BRW_WM_PROG,
 			 &key, sizeof(key),
 			 &brw->wm.prog_offset, &brw->wm.prog_data)) {
+      /* Have brw_fs_precompile() build this variant in later runs. */
+      struct brw_wm_prog_key disk_key = key;
+      disk_key.program_string_id = 0;
+      brw_disk_cache_note_variant(brw, BRW_WM_PROG,
+                                  ctx->Shader._CurrentFragmentProgram,
+                                  &disk_key, sizeof(disk_key));
+
       bool success = do_wm_prog(brw, ctx->Shader._CurrentFragmentProgram, fp,
 				&key);
       (void) success;
@@ -1598,6 +1598,9 @@ brw_upload_wm_binding_table(struct brw_context *brw)
       bind[i] = brw->wm.surf_offset[i];
    }
 
+   brw_state_batch_cached(brw, sizeof(uint32_t) * BRW_MAX_WM_SURFACES,
+                          32, &brw->wm.bind_bo_offset);
+
    brw->state.dirty.brw |= BRW_NEW_PS_BINDING_TABLE;
 }
 
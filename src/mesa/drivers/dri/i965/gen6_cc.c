@@ -224,6 +224,8 @@ gen6_upload_blend_state(struct brw_context *brw)
       }
    }
 
+   brw_state_batch_cached(brw, size, 64, &brw->cc.blend_state_offset);
+
    /* Point the GPU at the new indirect state. */
    if (intel->gen == 6) {
       BEGIN_BATCH(4);
@@ -276,6 +278,8 @@ gen6_upload_color_calc_state(struct brw_context *brw)
    cc->constant_b = ctx->Color.BlendColorUnclamped[2];
    cc->constant_a = ctx->Color.BlendColorUnclamped[3];
 
+   brw_state_batch_cached(brw, sizeof(*cc), 64, &brw->cc.state_offset);
+
    /* Point the GPU at the new indirect state. */
    if (intel->gen == 6) {
       BEGIN_BATCH(4);
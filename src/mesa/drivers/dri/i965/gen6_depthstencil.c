@@ -87,6 +87,9 @@ gen6_upload_depth_stencil_state(struct brw_context *brw)
       ds->ds2.depth_write_enable = ctx->Depth.Mask;
    }
 
+   brw_state_batch_cached(brw, sizeof(*ds), 64,
+                          &brw->cc.depth_stencil_state_offset);
+
    /* Point the GPU at the new indirect state. */
    if (intel->gen == 6) {
       BEGIN_BATCH(4);
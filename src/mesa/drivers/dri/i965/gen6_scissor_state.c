@@ -79,6 +79,8 @@ gen6_upload_scissor_state(struct brw_context *brw)
       scissor->ymax = ctx->DrawBuffer->Height - ctx->DrawBuffer->_Ymin - 1;
    }
 
+   brw_state_batch_cached(brw, sizeof(*scissor), 32, &scissor_state_offset);
+
    BEGIN_BATCH(2);
    OUT_BATCH(_3DSTATE_SCISSOR_STATE_POINTERS << 16 | (2 - 2));
    OUT_BATCH(scissor_state_offset);
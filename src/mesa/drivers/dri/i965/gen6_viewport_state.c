@@ -63,6 +63,8 @@ gen6_upload_clip_vp(struct brw_context *brw)
    vp->ymin = -gby;
    vp->ymax = gby;
 
+   brw_state_batch_cached(brw, sizeof(*vp), 32, &brw->clip.vp_offset);
+
    brw->state.dirty.cache |= CACHE_NEW_CLIP_VP;
 }
 
@@ -106,6 +108,8 @@ gen6_upload_sf_vp(struct brw_context *brw)
    sfv->viewport.m31 = v[MAT_TY] * y_scale + y_bias;
    sfv->viewport.m32 = v[MAT_TZ] * depth_scale;
 
+   brw_state_batch_cached(brw, sizeof(*sfv), 32, &brw->sf.vp_offset);
+
    brw->state.dirty.cache |= CACHE_NEW_SF_VP;
 }
 
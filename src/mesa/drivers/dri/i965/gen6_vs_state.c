@@ -71,6 +71,10 @@ gen6_upload_vs_push_constants(struct brw_context *brw)
       }
       params_uploaded = brw->vs.prog_data->base.nr_params / 4;
 
+      brw_state_batch_cached(brw,
+                             brw->vs.prog_data->base.nr_params * sizeof(float),
+                             32, &brw->vs.push_const_offset);
+
       if (0) {
 	 printf("VS constant buffer:\n");
 	 for (i = 0; i < params_uploaded; i++) {
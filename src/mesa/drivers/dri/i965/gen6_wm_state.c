@@ -63,6 +63,10 @@ gen6_upload_wm_push_constants(struct brw_context *brw)
 	 constants[i] = *brw->wm.prog_data->param[i];
       }
 
+      brw_state_batch_cached(brw,
+                             brw->wm.prog_data->nr_params * sizeof(float),
+                             32, &brw->wm.push_const_offset);
+
       if (0) {
 	 printf("WM constants:\n");
 	 for (i = 0; i < brw->wm.prog_data->nr_params; i++) {
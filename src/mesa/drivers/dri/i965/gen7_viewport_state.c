@@ -40,8 +40,7 @@ gen7_upload_sf_clip_viewport(struct brw_context *brw)
 
    vp = brw_state_batch(brw, AUB_TRACE_SF_VP_STATE,
 			sizeof(*vp), 64, &brw->sf.vp_offset);
-   /* Also assign to clip.vp_offset in case something uses it. */
-   brw->clip.vp_offset = brw->sf.vp_offset;
+   memset(vp, 0, sizeof(*vp));
 
    /* According to the "Vertex X,Y Clamping and Quantization" section of the
     * Strips and Fans documentation, objects must not have a screen-space
@@ -80,6 +79,10 @@ gen7_upload_sf_clip_viewport(struct brw_context *brw)
    vp->viewport.m31 = v[MAT_TY] * y_scale + y_bias;
    vp->viewport.m32 = v[MAT_TZ] * depth_scale;
 
+   brw_state_batch_cached(brw, sizeof(*vp), 64, &brw->sf.vp_offset);
+   /* Also assign to clip.vp_offset in case something uses it. */
+   brw->clip.vp_offset = brw->sf.vp_offset;
+
    BEGIN_BATCH(2);
    OUT_BATCH(_3DSTATE_VIEWPORT_STATE_POINTERS_SF_CL << 16 | (2 - 2));
    OUT_BATCH(brw->sf.vp_offset);
@@ -46,6 +46,33 @@
 static GLboolean
 intel_bufferobj_unmap(struct gl_context * ctx, struct gl_buffer_object *obj);
 
+static void
+mark_buffer_valid_data(struct intel_buffer_object *intel_obj,
+		       uint32_t offset, uint32_t size)
+{
+   intel_obj->valid_data_start = MIN2(intel_obj->valid_data_start, offset);
+   intel_obj->valid_data_end = MAX2(intel_obj->valid_data_end, offset + size);
+}
+
+static void
+mark_buffer_invalid(struct intel_buffer_object *intel_obj)
+{
+   intel_obj->valid_data_start = ~0;
+   intel_obj->valid_data_end = 0;
+}
+
+/**
+ * Returns whether [offset, offset + size) lies outside the data written to
+ * the BO so far, so that it can be written without synchronizing.
+ */
+static bool
+range_is_unused(const struct intel_buffer_object *intel_obj,
+		uint32_t offset, uint32_t size)
+{
+   return (offset + size <= intel_obj->valid_data_start ||
+	   offset >= intel_obj->valid_data_end);
+}
+
 /** Allocates a new drm_intel_bo to store the data for the buffer object. */
 static void
 intel_bufferobj_alloc_buffer(struct intel_context *intel,
@@ -53,6 +80,7 @@ intel_bufferobj_alloc_buffer(struct intel_context *intel,
 {
    intel_obj->buffer = drm_intel_bo_alloc(intel->bufmgr, "bufferobj",
 					  intel_obj->Base.Size, 64);
+   mark_buffer_invalid(intel_obj);
 
 #ifndef I915
    /* the buffer might be bound as a uniform buffer, need to update it
@@ -169,8 +197,10 @@ intel_bufferobj_data(struct gl_context * ctx,
       if (!intel_obj->buffer)
          return false;
 
-      if (data != NULL)
+      if (data != NULL) {
 	 drm_intel_bo_subdata(intel_obj->buffer, 0, size, data);
+	 mark_buffer_valid_data(intel_obj, 0, size);
+      }
    }
 
    return true;
@@ -212,7 +242,19 @@ intel_bufferobj_subdata(struct gl_context * ctx,
       intel_obj->sys_buffer = NULL;
    }
 
-   /* Otherwise we need to update the copy in video memory. */
+   /* Otherwise we need to update the copy in video memory.  If nothing has
+    * been stored in this range yet (say, an app filling a buffer
+    * piece by piece while drawing from the parts it already filled), the
+    * GPU can't be using it, so write it without waiting.
+    */
+   if (range_is_unused(intel_obj, offset, size)) {
+      drm_intel_gem_bo_map_unsynchronized(intel_obj->buffer);
+      memcpy((char *)intel_obj->buffer->virtual + offset, data, size);
+      drm_intel_bo_unmap(intel_obj->buffer);
+      mark_buffer_valid_data(intel_obj, offset, size);
+      return;
+   }
+
    busy =
       drm_intel_bo_busy(intel_obj->buffer) ||
       drm_intel_bo_references(intel->batch.bo, intel_obj->buffer);
@@ -224,24 +266,30 @@ intel_bufferobj_subdata(struct gl_context * ctx,
 	 intel_bufferobj_alloc_buffer(intel, intel_obj);
 	 drm_intel_bo_subdata(intel_obj->buffer, 0, size, data);
       } else {
+	 drm_intel_bo *src_bo;
+	 GLuint src_offset;
+
          perf_debug("Using a blit copy to avoid stalling on %ldb "
                     "glBufferSubData() to a busy buffer object.\n",
                     (long)size);
-	 drm_intel_bo *temp_bo =
-	    drm_intel_bo_alloc(intel->bufmgr, "subdata temp", size, 64);
 
-	 drm_intel_bo_subdata(temp_bo, 0, size, data);
+	 /* Stage the data in the upload buffer rather than a BO of its own,
+	  * so that a run of small updates shares one BO and one write.
+	  */
+	 intel_upload_data(intel, data, size, 64, &src_bo, &src_offset);
 
 	 intel_emit_linear_blit(intel,
 				intel_obj->buffer, offset,
-				temp_bo, 0,
+				src_bo, src_offset,
 				size);
 
-	 drm_intel_bo_unreference(temp_bo);
+	 drm_intel_bo_unreference(src_bo);
       }
    } else {
       drm_intel_bo_subdata(intel_obj->buffer, offset, size, data);
    }
+
+   mark_buffer_valid_data(intel_obj, offset, size);
 }
 
 
@@ -324,6 +372,16 @@ intel_bufferobj_map_range(struct gl_context * ctx,
       return NULL;
    }
 
+   /* Nothing has been stored to a range outside the valid data, so the GPU
+    * can't be using it and a write-only mapping doesn't need to wait.
+    */
+   if ((access & (GL_MAP_READ_BIT | GL_MAP_WRITE_BIT)) == GL_MAP_WRITE_BIT &&
+       range_is_unused(intel_obj, offset, length))
+      access |= GL_MAP_UNSYNCHRONIZED_BIT;
+
+   if (access & GL_MAP_WRITE_BIT)
+      mark_buffer_valid_data(intel_obj, offset, length);
+
    /* If the access is synchronized (like a normal buffer mapping), then get
     * things flushed out so the later mapping syncs appropriately through GEM.
     * If the user doesn't care about existing buffer contents and mapping would
@@ -355,6 +413,7 @@ intel_bufferobj_map_range(struct gl_context * ctx,
     * FlushRange time.
     */
    if ((access & GL_MAP_INVALIDATE_RANGE_BIT) &&
+       !(access & GL_MAP_UNSYNCHRONIZED_BIT) &&
        drm_intel_bo_busy(intel_obj->buffer)) {
       if (access & GL_MAP_FLUSH_EXPLICIT_BIT) {
 	 intel_obj->range_map_buffer = malloc(length);
@@ -398,7 +457,8 @@ intel_bufferobj_flush_mapped_range(struct gl_context *ctx,
 {
    struct intel_context *intel = intel_context(ctx);
    struct intel_buffer_object *intel_obj = intel_buffer_object(obj);
-   drm_intel_bo *temp_bo;
+   drm_intel_bo *src_bo;
+   GLuint src_offset;
 
    /* Unless we're in the range map using a temporary system buffer,
     * there's no work to do.
@@ -409,16 +469,15 @@ intel_bufferobj_flush_mapped_range(struct gl_context *ctx,
    if (length == 0)
       return;
 
-   temp_bo = drm_intel_bo_alloc(intel->bufmgr, "range map flush", length, 64);
-
-   drm_intel_bo_subdata(temp_bo, 0, length, intel_obj->range_map_buffer);
+   intel_upload_data(intel, (char *)intel_obj->range_map_buffer + offset,
+		     length, 64, &src_bo, &src_offset);
 
    intel_emit_linear_blit(intel,
 			  intel_obj->buffer, obj->Offset + offset,
-			  temp_bo, 0,
+			  src_bo, src_offset,
 			  length);
 
-   drm_intel_bo_unreference(temp_bo);
+   drm_intel_bo_unreference(src_bo);
 }
 
 
@@ -484,12 +543,17 @@ intel_bufferobj_buffer(struct intel_context *intel,
       drm_intel_bo_subdata(intel_obj->buffer,
 			   0, intel_obj->Base.Size,
 			   intel_obj->sys_buffer);
+      mark_buffer_valid_data(intel_obj, 0, intel_obj->Base.Size);
 
       free(intel_obj->sys_buffer);
       intel_obj->sys_buffer = NULL;
       intel_obj->offset = 0;
    }
 
+   /* The GPU may write anywhere in it from here on. */
+   if (flag & (INTEL_WRITE_PART | INTEL_WRITE_FULL))
+      mark_buffer_valid_data(intel_obj, 0, intel_obj->Base.Size);
+
    return intel_obj->buffer;
 }
 
@@ -51,6 +51,16 @@ struct intel_buffer_object
    unsigned int range_map_offset;
    GLsizei range_map_size;
 
+   /**
+    * The range of the BO that may hold data since it was allocated.
+    *
+    * Storage outside of it has never been written by the CPU or the GPU, so
+    * nothing queued on the GPU can be reading or writing it, and CPU writes
+    * there don't need to wait for the BO to go idle.
+    */
+   unsigned int valid_data_start;
+   unsigned int valid_data_end;
+
    bool source;
 };
 
@@ -1489,7 +1489,12 @@ intel_miptree_resolve_color(struct intel_context *intel,
       break;
    case INTEL_MCS_STATE_UNRESOLVED:
    case INTEL_MCS_STATE_CLEAR:
-      brw_blorp_resolve_color(intel, mt);
+      /* Multisampled buffers keep their fast clear state in the MCS buffer
+       * that the sampler and blorp already read through, so only single
+       * sampled buffers need a render target resolve.
+       */
+      if (mt->msaa_layout == INTEL_MSAA_LAYOUT_NONE)
+         brw_blorp_resolve_color(intel, mt);
       break;
    }
 #endif
@@ -1606,7 +1611,7 @@ intel_miptree_updownsample(struct intel_context *intel,
                            width, height,
                            dst_x0, dst_y0,
                            width, height,
-                           false, false /*mirror x, y*/);
+                           false, false /*mirror x, y*/, GL_NEAREST);
 
    if (src->stencil_mt) {
       brw_blorp_blit_miptrees(intel,
@@ -1616,7 +1621,8 @@ intel_miptree_updownsample(struct intel_context *intel,
                               width, height,
                               dst_x0, dst_y0,
                               width, height,
-                              false, false /*mirror x, y*/);
+                              false, false /*mirror x, y*/,
+                              GL_NEAREST);
    }
 #endif /* I915 */
 }
@@ -1669,8 +1675,9 @@ intel_miptree_upsample(struct intel_context *intel,
                               mt->logical_height0);
 }
 
-void *
-intel_miptree_map_raw(struct intel_context *intel, struct intel_mipmap_tree *mt)
+static drm_intel_bo *
+intel_miptree_prepare_raw_map(struct intel_context *intel,
+                              struct intel_mipmap_tree *mt)
 {
    /* CPU accesses to color buffers don't understand fast color clears, so
     * resolve any pending fast color clears before we map.
@@ -1687,6 +1694,14 @@ intel_miptree_map_raw(struct intel_context *intel, struct intel_mipmap_tree *mt)
 
    intel_flush(&intel->ctx);
 
+   return bo;
+}
+
+void *
+intel_miptree_map_raw(struct intel_context *intel, struct intel_mipmap_tree *mt)
+{
+   drm_intel_bo *bo = intel_miptree_prepare_raw_map(intel, mt);
+
    if (mt->region->tiling != I915_TILING_NONE)
       drm_intel_gem_bo_map_gtt(bo);
    else
@@ -1695,6 +1710,21 @@ intel_miptree_map_raw(struct intel_context *intel, struct intel_mipmap_tree *mt)
    return bo->virtual;
 }
 
+/**
+ * Map the miptree's BO through the CPU, even if it is tiled.
+ */
+static void *
+intel_miptree_map_raw_cpu(struct intel_context *intel,
+                          struct intel_mipmap_tree *mt,
+                          bool write)
+{
+   drm_intel_bo *bo = intel_miptree_prepare_raw_map(intel, mt);
+
+   drm_intel_bo_map(bo, write);
+
+   return bo->virtual;
+}
+
 void
 intel_miptree_unmap_raw(struct intel_context *intel,
                         struct intel_mipmap_tree *mt)
@@ -1821,6 +1851,168 @@ intel_miptree_unmap_blit(struct intel_context *intel,
    intel_miptree_release(&map->mt);
 }
 
+/**
+ * Byte offset of (x, y), x in bytes, within an X or Y tiled surface, with
+ * the given bit 6 swizzling applied.
+ */
+static uint32_t
+intel_offset_tiled(uint32_t tiling, uint32_t swizzle, uint32_t pitch,
+                   uint32_t x, uint32_t y)
+{
+   uint32_t tile, offset;
+
+   if (tiling == I915_TILING_X) {
+      /* 512 bytes x 8 rows, row-major */
+      tile = (y / 8) * (pitch / 512) + x / 512;
+      offset = tile * 4096 + (y % 8) * 512 + x % 512;
+   } else {
+      /* 128 bytes x 32 rows, as columns of 16 byte wide OWords */
+      tile = (y / 32) * (pitch / 128) + x / 128;
+      offset = tile * 4096 + (x % 128) / 16 * 512 + (y % 32) * 16 + x % 16;
+   }
+
+   switch (swizzle) {
+   case I915_BIT_6_SWIZZLE_9:
+      offset ^= (offset >> 3) & 64;
+      break;
+   case I915_BIT_6_SWIZZLE_9_10:
+      offset ^= ((offset >> 3) ^ (offset >> 4)) & 64;
+      break;
+   }
+
+   return offset;
+}
+
+/**
+ * Copy a w x h rectangle (x and w in bytes) between a tiled mapping and a
+ * linear buffer.  Each row is copied in runs which stay contiguous in the
+ * tiled layout: 16 bytes for Y tiling, 64 bytes (the swizzle granularity)
+ * for X tiling.
+ */
+static void
+intel_tiled_memcpy(char *tiled, uint32_t tiling, uint32_t swizzle,
+                   uint32_t pitch, char *linear, uint32_t linear_stride,
+                   uint32_t x0, uint32_t y0, uint32_t w, uint32_t h,
+                   bool to_tiled)
+{
+   const uint32_t span = tiling == I915_TILING_X ? 64 : 16;
+
+   for (uint32_t y = 0; y < h; y++) {
+      char *row = linear + y * linear_stride;
+      uint32_t x = 0;
+
+      while (x < w) {
+         uint32_t tx = x0 + x;
+         uint32_t n = MIN2(w - x, span - tx % span);
+         uint32_t offset = intel_offset_tiled(tiling, swizzle, pitch,
+                                              tx, y0 + y);
+
+         if (to_tiled)
+            memcpy(tiled + offset, row + x, n);
+         else
+            memcpy(row + x, tiled + offset, n);
+
+         x += n;
+      }
+   }
+}
+
+/**
+ * Whether intel_miptree_map_detile() can handle the mapping: reads of
+ * uncompressed X or Y tiled surfaces whose swizzling we know.
+ */
+static bool
+intel_miptree_can_detile(struct intel_mipmap_tree *mt, GLbitfield mode)
+{
+   uint32_t tiling, swizzle;
+
+   if (!(mode & GL_MAP_READ_BIT) || mt->compressed)
+      return false;
+
+   if (mt->region->tiling != I915_TILING_X &&
+       mt->region->tiling != I915_TILING_Y)
+      return false;
+
+   if (drm_intel_bo_get_tiling(mt->region->bo, &tiling, &swizzle) != 0)
+      return false;
+
+   return swizzle == I915_BIT_6_SWIZZLE_NONE ||
+          swizzle == I915_BIT_6_SWIZZLE_9 ||
+          swizzle == I915_BIT_6_SWIZZLE_9_10;
+}
+
+static bool
+intel_miptree_detile_copy(struct intel_context *intel,
+                          struct intel_mipmap_tree *mt,
+                          struct intel_miptree_map *map,
+                          unsigned int level, unsigned int slice,
+                          bool to_tiled)
+{
+   unsigned int image_x, image_y;
+   uint32_t tiling, swizzle;
+   char *tiled;
+
+   drm_intel_bo_get_tiling(mt->region->bo, &tiling, &swizzle);
+   intel_miptree_get_image_offset(mt, level, slice, &image_x, &image_y);
+
+   tiled = intel_miptree_map_raw_cpu(intel, mt, to_tiled);
+   if (!tiled)
+      return false;
+
+   intel_tiled_memcpy(tiled + mt->offset, mt->region->tiling, swizzle,
+                      mt->region->pitch, map->ptr, map->stride,
+                      (map->x + image_x) * mt->cpp, map->y + image_y,
+                      map->w * mt->cpp, map->h, to_tiled);
+
+   intel_miptree_unmap_raw(intel, mt);
+   return true;
+}
+
+/**
+ * Map a tiled miptree by detiling it into a malloced linear buffer through
+ * a CPU mapping, and tiling it back on unmap if written.  This avoids both
+ * reading through the uncached GTT and a synchronous blit to a temporary.
+ */
+static void
+intel_miptree_map_detile(struct intel_context *intel,
+                         struct intel_mipmap_tree *mt,
+                         struct intel_miptree_map *map,
+                         unsigned int level, unsigned int slice)
+{
+   map->stride = ALIGN(map->w * mt->cpp, 16);
+   map->buffer = map->ptr = malloc(map->stride * map->h);
+   if (!map->buffer)
+      return;
+
+   if (!intel_miptree_detile_copy(intel, mt, map, level, slice, false)) {
+      free(map->buffer);
+      map->buffer = map->ptr = NULL;
+      return;
+   }
+
+   DBG("%s: %d,%d %dx%d from mt %p (%s) %d,%d = %p/%d\n", __FUNCTION__,
+       map->x, map->y, map->w, map->h,
+       mt, _mesa_get_format_name(mt->format),
+       level, slice, map->ptr, map->stride);
+}
+
+static void
+intel_miptree_unmap_detile(struct intel_context *intel,
+                           struct intel_mipmap_tree *mt,
+                           struct intel_miptree_map *map,
+                           unsigned int level,
+                           unsigned int slice)
+{
+   struct gl_context *ctx = &intel->ctx;
+
+   if (map->mode & GL_MAP_WRITE_BIT) {
+      bool ok = intel_miptree_detile_copy(intel, mt, map, level, slice, true);
+      WARN_ONCE(!ok, "Failed to map miptree for tiling the mapping back");
+   }
+
+   free(map->buffer);
+}
+
 static void
 intel_miptree_map_s8(struct intel_context *intel,
 		     struct intel_mipmap_tree *mt,
@@ -2171,6 +2363,8 @@ intel_miptree_map_singlesample(struct intel_context *intel,
       intel_miptree_map_etc(intel, mt, map, level, slice);
    } else if (mt->stencil_mt && !(mode & BRW_MAP_DIRECT_BIT)) {
       intel_miptree_map_depthstencil(intel, mt, map, level, slice);
+   } else if (intel_miptree_can_detile(mt, mode)) {
+      intel_miptree_map_detile(intel, mt, map, level, slice);
    }
    /* See intel_miptree_blit() for details on the 32k pitch limit. */
    else if (intel->has_llc &&
@@ -2220,6 +2414,8 @@ intel_miptree_unmap_singlesample(struct intel_context *intel,
       intel_miptree_unmap_depthstencil(intel, mt, map, level, slice);
    } else if (map->mt) {
       intel_miptree_unmap_blit(intel, mt, map, level, slice);
+   } else if (map->buffer) {
+      intel_miptree_unmap_detile(intel, mt, map, level, slice);
    } else {
       intel_miptree_unmap_gtt(intel, mt, map, level, slice);
    }
@@ -227,6 +227,12 @@ enum intel_mcs_state
 
    /**
     * An MCS buffer exists for this miptree, and it is used for MSAA purposes.
+    *
+    * A fast clear of a CMS multisampled buffer moves it to
+    * INTEL_MCS_STATE_CLEAR (and rendering then to INTEL_MCS_STATE_UNRESOLVED)
+    * so that redundant clears can be skipped, but such buffers never need a
+    * render target resolve: the MCS buffer is an integral part of how their
+    * pixel data is stored.
     */
    INTEL_MCS_STATE_MSAA,
 
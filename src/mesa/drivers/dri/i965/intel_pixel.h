@@ -30,6 +30,9 @@
 
 #include "main/mtypes.h"
 
+struct intel_context;
+struct intel_mipmap_tree;
+
 void intelInitPixelFuncs(struct dd_function_table *functions);
 bool intel_check_blit_fragment_ops(struct gl_context * ctx,
 					bool src_alpha_is_one);
@@ -41,6 +44,16 @@ void intelReadPixels(struct gl_context * ctx,
                      const struct gl_pixelstore_attrib *pack,
                      GLvoid * pixels);
 
+bool intel_miptree_read_tiled_memcpy(struct intel_context *intel,
+                                     struct intel_mipmap_tree *mt,
+                                     GLuint level, GLuint slice,
+                                     GLint x, GLint y,
+                                     GLsizei width, GLsizei height,
+                                     bool flip,
+                                     GLenum format, GLenum type,
+                                     GLvoid *pixels,
+                                     const struct gl_pixelstore_attrib *pack);
+
 void intelDrawPixels(struct gl_context * ctx,
                      GLint x, GLint y,
                      GLsizei width, GLsizei height,
@@ -34,6 +34,7 @@
 #include "main/bufferobj.h"
 #include "main/readpix.h"
 #include "main/state.h"
+#include "main/glformats.h"
 
 #include "intel_screen.h"
 #include "intel_context.h"
@@ -44,6 +45,8 @@
 #include "intel_regions.h"
 #include "intel_pixel.h"
 #include "intel_buffer_objects.h"
+#include "intel_batchbuffer.h"
+#include "intel_tiled_memcpy.h"
 
 #define FILE_DEBUG_FLAG DEBUG_PIXEL
 
@@ -69,6 +72,103 @@
  * any case.
  */
 
+/**
+ * \brief Read a rectangle of a miptree slice into client memory with the CPU
+ *
+ * This is the reverse of intel_texsubimage_tiled_memcpy().  The X or Y tiled
+ * memory is mapped without a GTT fence, thus acquiring a tiled view of it,
+ * and the pixels are detiled straight into the destination (see
+ * intel_tiled_to_linear()).  On LLC platforms that mapping is cached, which
+ * makes this much faster than reading the surface through the uncached GTT
+ * or blitting it to a linear temporary first.
+ *
+ * The pixels need no conversion: \p format and \p type must match the
+ * miptree's format.
+ *
+ * \param x, y   position of the rectangle in the slice, with y going down
+ * \param flip   store the rows bottom up, for window system buffers
+ * \return false if the fast path doesn't apply
+ */
+bool
+intel_miptree_read_tiled_memcpy(struct intel_context *intel,
+                                struct intel_mipmap_tree *mt,
+                                GLuint level, GLuint slice,
+                                GLint x, GLint y,
+                                GLsizei width, GLsizei height,
+                                bool flip,
+                                GLenum format, GLenum type,
+                                GLvoid *pixels,
+                                const struct gl_pixelstore_attrib *pack)
+{
+   struct gl_context *ctx = &intel->ctx;
+   drm_intel_bo *bo;
+   GLuint image_x, image_y;
+   int dst_stride;
+   char *dst;
+   int error;
+
+   if (!intel->has_llc ||
+       !mt ||
+       (mt->region->tiling != I915_TILING_X &&
+        mt->region->tiling != I915_TILING_Y) ||
+       mt->num_samples > 1 ||
+       _mesa_is_depth_or_stencil_format(format) ||
+       ctx->_ImageTransferState ||
+       _mesa_is_bufferobj(pack->BufferObj) ||
+       pack->SwapBytes ||
+       pack->LsbFirst ||
+       !_mesa_format_matches_format_and_type(mt->format, format, type,
+                                             false))
+      return false;
+
+   /* Pending fast color clears aren't in the buffer yet */
+   intel_miptree_resolve_color(intel, mt);
+
+   bo = mt->region->bo;
+
+   if (drm_intel_bo_references(intel->batch.bo, bo)) {
+      perf_debug("Flushing before mapping a referenced bo.\n");
+      intel_batchbuffer_flush(intel);
+   }
+
+   if (unlikely(intel->perf_debug)) {
+      if (drm_intel_bo_busy(bo)) {
+         perf_debug("Mapping a busy BO, causing a stall on the GPU.\n");
+      }
+   }
+
+   error = drm_intel_bo_map(bo, false /*write_enable*/);
+   if (error || bo->virtual == NULL) {
+      DBG("%s: failed to map bo\n", __FUNCTION__);
+      return false;
+   }
+
+   DBG("%s: level=%d slice=%d offset=(%d,%d) (w,h)=(%d,%d) flip=%d\n",
+       __FUNCTION__, level, slice, x, y, width, height, flip);
+
+   intel_miptree_get_image_offset(mt, level, slice, &image_x, &image_y);
+   x += image_x;
+   y += image_y;
+
+   /* Both of these account for pack->Invert */
+   dst_stride = _mesa_image_row_stride(pack, width, format, type);
+   dst = _mesa_image_address2d(pack, pixels, width, height,
+                               format, type, 0, 0);
+   if (flip) {
+      dst += (height - 1) * dst_stride;
+      dst_stride = -dst_stride;
+   }
+
+   intel_tiled_to_linear(dst, dst_stride,
+                         bo->virtual, mt->region->pitch,
+                         mt->region->tiling, intel->has_swizzling,
+                         x * mt->cpp, (x + width) * mt->cpp,
+                         y, y + height);
+
+   drm_intel_bo_unmap(bo);
+   return true;
+}
+
 static bool
 do_blit_readpixels(struct gl_context * ctx,
                    GLint x, GLint y, GLsizei width, GLsizei height,
@@ -187,6 +287,32 @@ intelReadPixels(struct gl_context * ctx,
    intel_prepare_render(intel);
    intel->front_buffer_dirty = dirty;
 
+   {
+      struct gl_renderbuffer *rb = ctx->ReadBuffer->_ColorReadBuffer;
+      struct intel_renderbuffer *irb = intel_renderbuffer(rb);
+      struct gl_pixelstore_attrib clipped_pack = *pack;
+      GLint cx = x, cy = y;
+      GLsizei cw = width, ch = height;
+
+      if (irb && irb->mt && rb->Format == irb->mt->format &&
+          _mesa_format_matches_format_and_type(rb->Format, format, type,
+                                               false)) {
+         bool flip = _mesa_is_winsys_fbo(ctx->ReadBuffer);
+
+         if (!_mesa_clip_readpixels(ctx, &cx, &cy, &cw, &ch, &clipped_pack))
+            return;
+
+         if (intel_miptree_read_tiled_memcpy(intel, irb->mt,
+                                             irb->mt_level, irb->mt_layer,
+                                             cx,
+                                             flip ? rb->Height - cy - ch : cy,
+                                             cw, ch, flip,
+                                             format, type, pixels,
+                                             &clipped_pack))
+            return;
+      }
+   }
+
    /* Update Mesa state before calling _mesa_readpixels().
     * XXX this may not be needed since ReadPixels no longer uses the
     * span code.
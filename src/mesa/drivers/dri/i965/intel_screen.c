@@ -79,10 +79,14 @@ PUBLIC const char __driConfigOptions[] =
       DRI_CONF_OPT_BEGIN_B(shader_precompile, "true")
 	 DRI_CONF_DESC(en, "Perform code generation at shader link time.")
       DRI_CONF_OPT_END
+
+      DRI_CONF_OPT_BEGIN_B(shader_cache, "true")
+	 DRI_CONF_DESC(en, "Keep compiled shaders on disk for later runs.")
+      DRI_CONF_OPT_END
    DRI_CONF_SECTION_END
 DRI_CONF_END;
 
-const GLuint __driNConfigOptions = 14;
+const GLuint __driNConfigOptions = 15;
 
 #include "intel_batchbuffer.h"
 #include "intel_buffers.h"
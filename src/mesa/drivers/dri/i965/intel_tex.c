@@ -8,6 +8,9 @@
 #include "intel_mipmap_tree.h"
 #include "intel_tex.h"
 #include "intel_fbo.h"
+#ifndef I915
+#include "brw_context.h"
+#endif
 
 #define FILE_DEBUG_FLAG DEBUG_TEXTURE
 
@@ -175,6 +178,18 @@ intel_unmap_texture_image(struct gl_context *ctx,
    intel_miptree_unmap(intel, mt, tex_image->Level, slice);
 }
 
+#ifndef I915
+static void
+intel_generate_mipmap(struct gl_context *ctx, GLenum target,
+                      struct gl_texture_object *tex_obj)
+{
+   if (brw_blorp_generate_mipmap(intel_context(ctx), target, tex_obj))
+      return;
+
+   _mesa_meta_GenerateMipmap(ctx, target, tex_obj);
+}
+#endif
+
 void
 intelInitTextureFuncs(struct dd_function_table *functions)
 {
@@ -186,4 +201,7 @@ intelInitTextureFuncs(struct dd_function_table *functions)
    functions->FreeTextureImageBuffer = intel_free_texture_image_buffer;
    functions->MapTextureImage = intel_map_texture_image;
    functions->UnmapTextureImage = intel_unmap_texture_image;
+#ifndef I915
+   functions->GenerateMipmap = intel_generate_mipmap;
+#endif
 }
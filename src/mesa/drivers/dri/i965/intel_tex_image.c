@@ -15,6 +15,8 @@
 #include "main/teximage.h"
 #include "main/texstore.h"
 
+#include "drivers/common/meta.h"
+
 #include "intel_context.h"
 #include "intel_mipmap_tree.h"
 #include "intel_buffer_objects.h"
@@ -22,6 +24,7 @@
 #include "intel_tex.h"
 #include "intel_blit.h"
 #include "intel_fbo.h"
+#include "intel_pixel.h"
 
 #ifndef I915
 #include "brw_context.h"
@@ -391,9 +394,34 @@ intel_image_target_texture_2d(struct gl_context *ctx, GLenum target,
                                   image->tile_x, image->tile_y);
 }
 
+static void
+intel_get_tex_image(struct gl_context *ctx,
+                    GLenum format, GLenum type, GLvoid *pixels,
+                    struct gl_texture_image *texImage)
+{
+   struct intel_context *intel = intel_context(ctx);
+   struct intel_texture_image *intelImage = intel_texture_image(texImage);
+
+   /* Try detiling straight into the client's memory before going through
+    * meta, which would render the texture to a temporary.
+    */
+   if ((texImage->TexObject->Target == GL_TEXTURE_2D ||
+        texImage->TexObject->Target == GL_TEXTURE_RECTANGLE) &&
+       intel_miptree_read_tiled_memcpy(intel, intelImage->mt,
+                                       texImage->Level, 0,
+                                       0, 0,
+                                       texImage->Width, texImage->Height,
+                                       false, format, type, pixels,
+                                       &ctx->Pack))
+      return;
+
+   _mesa_meta_GetTexImage(ctx, format, type, pixels, texImage);
+}
+
 void
 intelInitTextureImageFuncs(struct dd_function_table *functions)
 {
    functions->TexImage = intelTexImage;
+   functions->GetTexImage = intel_get_tex_image;
    functions->EGLImageTargetTexture2D = intel_image_target_texture_2d;
 }
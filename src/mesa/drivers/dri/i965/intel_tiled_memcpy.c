@@ -0,0 +1,98 @@
+/*
+ * Copyright © 2013 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <string.h>
+
+#include "main/macros.h"
+#include "drm.h"
+#include "i915_drm.h"
+#include "intel_tiled_memcpy.h"
+
+/**
+ * \file
+ * CPU detiling of X and Y tiled surfaces.
+ *
+ * A tile is 4KB.  Within it, X tiles are 8 rows of 512 bytes, and Y tiles
+ * are 32 rows of 16 byte columns, the columns being laid out one after the
+ * other.  With bit 6 swizzling, bit 6 of the address is XORed with bit 9
+ * (Y tiles) or with bits 9 and 10 (X tiles), which never changes within a
+ * naturally aligned 64 bytes, so the copy is done in spans of 64 bytes for
+ * X tiles and 16 bytes for Y tiles.
+ */
+
+/**
+ * Copy the bytes [x0_bytes, x1_bytes) of the rows [y0, y1) of a tiled
+ * surface into a linear buffer.
+ *
+ * \param dst        where byte x0_bytes of row y0 goes
+ * \param dst_pitch  distance between the destination rows, may be negative
+ * \param src        the mapped tiled surface
+ * \param src_pitch  pitch of the tiled surface in bytes, a multiple of the
+ *                   tile width
+ * \param tiling     I915_TILING_X or I915_TILING_Y
+ */
+void
+intel_tiled_to_linear(char *dst, int dst_pitch,
+                      const char *src, uint32_t src_pitch,
+                      uint32_t tiling, bool has_swizzling,
+                      uint32_t x0_bytes, uint32_t x1_bytes,
+                      uint32_t y0, uint32_t y1)
+{
+   const uint32_t tile_size_bytes = 4096;
+   const bool xtiled = tiling == I915_TILING_X;
+   const uint32_t tile_width_bytes = xtiled ? 512 : 128;
+   const uint32_t tile_height = xtiled ? 8 : 32;
+   const uint32_t span_bytes = xtiled ? 64 : 16;
+   const uint32_t width_tiles = src_pitch / tile_width_bytes;
+
+   assert(tiling == I915_TILING_X || tiling == I915_TILING_Y);
+
+   for (uint32_t y = y0; y < y1; y++) {
+      char *row = dst + (int) (y - y0) * dst_pitch - x0_bytes;
+      const uint32_t tile_row_bytes =
+         (y / tile_height) * width_tiles * tile_size_bytes +
+         (y % tile_height) * (xtiled ? tile_width_bytes : 16);
+
+      for (uint32_t x = x0_bytes; x < x1_bytes; ) {
+         const uint32_t next = MIN2(ALIGN(x + 1, span_bytes), x1_bytes);
+         const uint32_t x_in_tile = x % tile_width_bytes;
+         uint32_t offset = tile_row_bytes + (x / tile_width_bytes) * tile_size_bytes;
+
+         if (xtiled)
+            offset += x_in_tile;
+         else
+            offset += (x_in_tile / 16) * (16 * tile_height) + x_in_tile % 16;
+
+         if (has_swizzling) {
+            if (xtiled)
+               offset ^= ((offset >> 3) ^ (offset >> 4)) & (1 << 6);
+            else
+               offset ^= (offset >> 3) & (1 << 6);
+         }
+
+         memcpy(row + x, src + offset, next - x);
+         x = next;
+      }
+   }
+}
@@ -43,6 +43,7 @@
 #include "texobj.h"
 #include "transformfeedback.h"
 #include "dispatch.h"
+#include "vbo/vbo.h"
 
 
 /* Debug flags */
@@ -305,6 +306,8 @@ _mesa_reference_buffer_object_(struct gl_context *ctx,
 	 ASSERT(ctx->Array.ArrayObj->Vertex.BufferObj != bufObj);
 #endif
 
+         vbo_delete_minmax_cache(oldObj);
+
 	 ASSERT(ctx->Driver.DeleteBuffer);
          ctx->Driver.DeleteBuffer(ctx, oldObj);
       }
@@ -347,6 +350,7 @@ _mesa_initialize_buffer_object( struct gl_context *ctx,
 
    memset(obj, 0, sizeof(struct gl_buffer_object));
    _glthread_INIT_MUTEX(obj->Mutex);
+   _glthread_INIT_MUTEX(obj->MinMaxCacheMutex);
    obj->RefCount = 1;
    obj->Name = name;
    obj->Usage = GL_STATIC_DRAW_ARB;
@@ -608,6 +612,7 @@ _mesa_init_buffer_objects( struct gl_context *ctx )
 
    memset(&DummyBufferObject, 0, sizeof(DummyBufferObject));
    _glthread_INIT_MUTEX(DummyBufferObject.Mutex);
+   _glthread_INIT_MUTEX(DummyBufferObject.MinMaxCacheMutex);
    DummyBufferObject.RefCount = 1000*1000*1000; /* never delete */
 
    _mesa_reference_buffer_object(ctx, &ctx->Array.ArrayBufferObj,
@@ -718,6 +723,10 @@ bind_buffer_object(struct gl_context *ctx, GLenum target, GLuint buffer)
          return;
    }
    
+   /* Pixel pack operations write to the buffer behind our back. */
+   if (target == GL_PIXEL_PACK_BUFFER)
+      newBufObj->MinMaxCacheDisabled = GL_TRUE;
+
    /* bind new buffer */
    _mesa_reference_buffer_object(ctx, bindTarget, newBufObj);
 
@@ -1067,6 +1076,8 @@ _mesa_BufferData(GLenum target, GLsizeiptrARB size,
    size += 100;
 #endif
 
+   bufObj->MinMaxCacheDirty = GL_TRUE;
+
    ASSERT(ctx->Driver.BufferData);
    if (!ctx->Driver.BufferData( ctx, target, size, data, usage, bufObj )) {
       _mesa_error(ctx, GL_OUT_OF_MEMORY, "glBufferDataARB()");
@@ -1091,7 +1102,10 @@ _mesa_BufferSubData(GLenum target, GLintptrARB offset,
    if (size == 0)
       return;
 
+   FLUSH_VERTICES(ctx, 0);
+
    bufObj->Written = GL_TRUE;
+   bufObj->MinMaxCacheDirty = GL_TRUE;
 
    ASSERT(ctx->Driver.BufferSubData);
    ctx->Driver.BufferSubData( ctx, offset, size, data, bufObj );
@@ -1112,6 +1126,9 @@ _mesa_GetBufferSubData(GLenum target, GLintptrARB offset,
       return;
    }
 
+   /* Gathered draws may write to the buffer through transform feedback. */
+   FLUSH_VERTICES(ctx, 0);
+
    ASSERT(ctx->Driver.GetBufferSubData);
    ctx->Driver.GetBufferSubData( ctx, offset, size, data, bufObj );
 }
@@ -1166,6 +1183,12 @@ _mesa_MapBuffer(GLenum target, GLenum access)
       return NULL;
    }
 
+   /* Draws gathered by the vbo module may still read from the buffer. */
+   FLUSH_VERTICES(ctx, 0);
+
+   if (accessFlags & GL_MAP_WRITE_BIT)
+      bufObj->MinMaxCacheDirty = GL_TRUE;
+
    ASSERT(ctx->Driver.MapBufferRange);
    map = ctx->Driver.MapBufferRange(ctx, 0, bufObj->Size, accessFlags, bufObj);
    if (!map) {
@@ -1470,6 +1493,10 @@ _mesa_CopyBufferSubData(GLenum readTarget, GLenum writeTarget,
       }
    }
 
+   FLUSH_VERTICES(ctx, 0);
+
+   dst->MinMaxCacheDirty = GL_TRUE;
+
    ctx->Driver.CopyBufferSubData(ctx, src, dst, readOffset, writeOffset, size);
 }
 
@@ -1583,6 +1610,12 @@ _mesa_MapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length,
       return bufObj->Pointer;
    }
 
+   /* Draws gathered by the vbo module may still read from the buffer. */
+   FLUSH_VERTICES(ctx, 0);
+
+   if (access & GL_MAP_WRITE_BIT)
+      bufObj->MinMaxCacheDirty = GL_TRUE;
+
    ASSERT(ctx->Driver.MapBufferRange);
    map = ctx->Driver.MapBufferRange(ctx, offset, length, access, bufObj);
    if (!map) {
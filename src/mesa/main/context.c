@@ -98,6 +98,7 @@
 #include "fog.h"
 #include "formats.h"
 #include "framebuffer.h"
+#include "main/glthread.h"
 #include "hint.h"
 #include "hash.h"
 #include "light.h"
@@ -105,6 +106,7 @@
 #include "macros.h"
 #include "matrix.h"
 #include "multisample.h"
+#include "parallel.h"
 #include "pixel.h"
 #include "pixelstore.h"
 #include "points.h"
@@ -121,6 +123,7 @@
 #include "stencil.h"
 #include "texcompress_s3tc.h"
 #include "texstate.h"
+#include "texstore.h"
 #include "transformfeedback.h"
 #include "mtypes.h"
 #include "varray.h"
@@ -400,6 +403,8 @@ one_time_init( struct gl_context *ctx )
          _mesa_ubyte_to_float_color_tab[i] = (float) i / 255.0F;
       }
 
+      _mesa_init_texstore();
+
 #if defined(DEBUG) && defined(__DATE__) && defined(__TIME__)
       if (MESA_VERBOSE != 0) {
 	 _mesa_debug(ctx, "Mesa %s DEBUG build %s %s\n",
@@ -1070,6 +1075,8 @@ _mesa_initialize_context(struct gl_context *ctx,
 
    ctx->FirstTimeCurrent = GL_TRUE;
 
+   _mesa_parallel_reference();
+
    return GL_TRUE;
 
 fail:
@@ -1130,6 +1137,11 @@ _mesa_create_context(gl_api api,
 void
 _mesa_free_context_data( struct gl_context *ctx )
 {
+   /* Stop the glthread worker, if any, before tearing down the state it
+    * executes calls against.
+    */
+   _mesa_glthread_destroy(ctx);
+
    if (!_mesa_get_current_context()){
       /* No current context, but we may need one in order to delete
        * texture objs, etc.  So temporarily bind the context now.
@@ -1186,6 +1198,8 @@ _mesa_free_context_data( struct gl_context *ctx )
 
    _mesa_free_errors_data(ctx);
 
+   _mesa_parallel_unreference();
+
    free((void *)ctx->Extensions.String);
 
    free(ctx->VersionString);
@@ -1446,6 +1460,12 @@ _mesa_make_current( struct gl_context *newCtx,
       }
    }
 
+   /* Nothing may touch the context from this thread while its worker is
+    * still running calls.
+    */
+   if (curCtx)
+      _mesa_glthread_finish(curCtx);
+
    if (curCtx && 
       (curCtx->WinSysDrawBuffer || curCtx->WinSysReadBuffer) &&
        /* make sure this context is valid for flushing */
@@ -1453,14 +1473,22 @@ _mesa_make_current( struct gl_context *newCtx,
       _mesa_flush(curCtx);
 
    /* We used to call _glapi_check_multithread() here.  Now do it in drivers */
-   _glapi_set_context((void *) newCtx);
+   if (curCtx != newCtx)
+      _glapi_set_context((void *) newCtx);
    ASSERT(_mesa_get_current_context() == newCtx);
 
    if (!newCtx) {
       _glapi_set_dispatch(NULL);  /* none current */
    }
    else {
-      _glapi_set_dispatch(newCtx->CurrentDispatch);
+      struct _glapi_table *exec = newCtx->GLThread ?
+         newCtx->MarshalExec : newCtx->CurrentDispatch;
+
+      /* Rebinding the current context (e.g. for each frame, to switch
+       * drawables) keeps the dispatch table installed.
+       */
+      if (curCtx != newCtx || _glapi_get_dispatch() != exec)
+         _glapi_set_dispatch(exec);
 
       if (drawBuffer && readBuffer) {
          ASSERT(_mesa_is_winsys_fbo(drawBuffer));
@@ -1378,6 +1378,40 @@ invalidate_saved_current_state(struct gl_context *ctx)
 }
 
 
+/**
+ * Return the bit used in ListState.Current.Enabled/Disabled for the
+ * glEnable/glDisable cap, or 0 if the cap's state isn't tracked.
+ */
+static GLbitfield
+saved_enable_bit(GLenum cap)
+{
+   switch (cap) {
+   case GL_ALPHA_TEST:
+      return DLIST_CAP_ALPHA_TEST;
+   case GL_BLEND:
+      return DLIST_CAP_BLEND;
+   case GL_CULL_FACE:
+      return DLIST_CAP_CULL_FACE;
+   case GL_DEPTH_TEST:
+      return DLIST_CAP_DEPTH_TEST;
+   case GL_FOG:
+      return DLIST_CAP_FOG;
+   case GL_LIGHTING:
+      return DLIST_CAP_LIGHTING;
+   case GL_NORMALIZE:
+      return DLIST_CAP_NORMALIZE;
+   case GL_POLYGON_OFFSET_FILL:
+      return DLIST_CAP_POLYGON_OFFSET_FILL;
+   case GL_SCISSOR_TEST:
+      return DLIST_CAP_SCISSOR_TEST;
+   case GL_STENCIL_TEST:
+      return DLIST_CAP_STENCIL_TEST;
+   default:
+      return 0;
+   }
+}
+
+
 static void GLAPIENTRY
 save_CallList(GLuint list)
 {
@@ -2195,14 +2229,24 @@ save_CullFace(GLenum mode)
 {
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
-   ASSERT_OUTSIDE_SAVE_BEGIN_END_AND_FLUSH(ctx);
+   ASSERT_OUTSIDE_SAVE_BEGIN_END(ctx);
+
+   if (ctx->ExecuteFlag) {
+      CALL_CullFace(ctx->Exec, (mode));
+   }
+
+   /* Don't compile this call if it's a no-op. */
+   if (ctx->ListState.Current.CullFace == mode)
+      return;
+
+   SAVE_FLUSH_VERTICES(ctx);
+
+   ctx->ListState.Current.CullFace = mode;
+
    n = alloc_instruction(ctx, OPCODE_CULL_FACE, 1);
    if (n) {
       n[1].e = mode;
    }
-   if (ctx->ExecuteFlag) {
-      CALL_CullFace(ctx->Exec, (mode));
-   }
 }
 
 
@@ -2211,14 +2255,24 @@ save_DepthFunc(GLenum func)
 {
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
-   ASSERT_OUTSIDE_SAVE_BEGIN_END_AND_FLUSH(ctx);
+   ASSERT_OUTSIDE_SAVE_BEGIN_END(ctx);
+
+   if (ctx->ExecuteFlag) {
+      CALL_DepthFunc(ctx->Exec, (func));
+   }
+
+   /* Don't compile this call if it's a no-op. */
+   if (ctx->ListState.Current.DepthFunc == func)
+      return;
+
+   SAVE_FLUSH_VERTICES(ctx);
+
+   ctx->ListState.Current.DepthFunc = func;
+
    n = alloc_instruction(ctx, OPCODE_DEPTH_FUNC, 1);
    if (n) {
       n[1].e = func;
    }
-   if (ctx->ExecuteFlag) {
-      CALL_DepthFunc(ctx->Exec, (func));
-   }
 }
 
 
@@ -2259,15 +2313,27 @@ static void GLAPIENTRY
 save_Disable(GLenum cap)
 {
    GET_CURRENT_CONTEXT(ctx);
+   const GLbitfield bit = saved_enable_bit(cap);
    Node *n;
-   ASSERT_OUTSIDE_SAVE_BEGIN_END_AND_FLUSH(ctx);
+   ASSERT_OUTSIDE_SAVE_BEGIN_END(ctx);
+
+   if (ctx->ExecuteFlag) {
+      CALL_Disable(ctx->Exec, (cap));
+   }
+
+   /* Don't compile this call if it's a no-op. */
+   if (ctx->ListState.Current.Disabled & bit)
+      return;
+
+   SAVE_FLUSH_VERTICES(ctx);
+
+   ctx->ListState.Current.Disabled |= bit;
+   ctx->ListState.Current.Enabled &= ~bit;
+
    n = alloc_instruction(ctx, OPCODE_DISABLE, 1);
    if (n) {
       n[1].e = cap;
    }
-   if (ctx->ExecuteFlag) {
-      CALL_Disable(ctx->Exec, (cap));
-   }
 }
 
 
@@ -2275,8 +2341,14 @@ static void GLAPIENTRY
 save_DisableIndexed(GLuint index, GLenum cap)
 {
    GET_CURRENT_CONTEXT(ctx);
+   const GLbitfield bit = saved_enable_bit(cap);
    Node *n;
    ASSERT_OUTSIDE_SAVE_BEGIN_END_AND_FLUSH(ctx);
+
+   /* the per-buffer state no longer matches what glEnable/Disable saw */
+   ctx->ListState.Current.Enabled &= ~bit;
+   ctx->ListState.Current.Disabled &= ~bit;
+
    n = alloc_instruction(ctx, OPCODE_DISABLE_INDEXED, 2);
    if (n) {
       n[1].ui = index;
@@ -2333,15 +2405,27 @@ static void GLAPIENTRY
 save_Enable(GLenum cap)
 {
    GET_CURRENT_CONTEXT(ctx);
+   const GLbitfield bit = saved_enable_bit(cap);
    Node *n;
-   ASSERT_OUTSIDE_SAVE_BEGIN_END_AND_FLUSH(ctx);
+   ASSERT_OUTSIDE_SAVE_BEGIN_END(ctx);
+
+   if (ctx->ExecuteFlag) {
+      CALL_Enable(ctx->Exec, (cap));
+   }
+
+   /* Don't compile this call if it's a no-op. */
+   if (ctx->ListState.Current.Enabled & bit)
+      return;
+
+   SAVE_FLUSH_VERTICES(ctx);
+
+   ctx->ListState.Current.Enabled |= bit;
+   ctx->ListState.Current.Disabled &= ~bit;
+
    n = alloc_instruction(ctx, OPCODE_ENABLE, 1);
    if (n) {
       n[1].e = cap;
    }
-   if (ctx->ExecuteFlag) {
-      CALL_Enable(ctx->Exec, (cap));
-   }
 }
 
 
@@ -2350,8 +2434,14 @@ static void GLAPIENTRY
 save_EnableIndexed(GLuint index, GLenum cap)
 {
    GET_CURRENT_CONTEXT(ctx);
+   const GLbitfield bit = saved_enable_bit(cap);
    Node *n;
    ASSERT_OUTSIDE_SAVE_BEGIN_END_AND_FLUSH(ctx);
+
+   /* the per-buffer state no longer matches what glEnable/Disable saw */
+   ctx->ListState.Current.Enabled &= ~bit;
+   ctx->ListState.Current.Disabled &= ~bit;
+
    n = alloc_instruction(ctx, OPCODE_ENABLE_INDEXED, 2);
    if (n) {
       n[1].ui = index;
@@ -2478,14 +2568,24 @@ save_FrontFace(GLenum mode)
 {
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
-   ASSERT_OUTSIDE_SAVE_BEGIN_END_AND_FLUSH(ctx);
+   ASSERT_OUTSIDE_SAVE_BEGIN_END(ctx);
+
+   if (ctx->ExecuteFlag) {
+      CALL_FrontFace(ctx->Exec, (mode));
+   }
+
+   /* Don't compile this call if it's a no-op. */
+   if (ctx->ListState.Current.FrontFace == mode)
+      return;
+
+   SAVE_FLUSH_VERTICES(ctx);
+
+   ctx->ListState.Current.FrontFace = mode;
+
    n = alloc_instruction(ctx, OPCODE_FRONT_FACE, 1);
    if (n) {
       n[1].e = mode;
    }
-   if (ctx->ExecuteFlag) {
-      CALL_FrontFace(ctx->Exec, (mode));
-   }
 }
 
 
@@ -3054,14 +3154,24 @@ save_MatrixMode(GLenum mode)
 {
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
-   ASSERT_OUTSIDE_SAVE_BEGIN_END_AND_FLUSH(ctx);
+   ASSERT_OUTSIDE_SAVE_BEGIN_END(ctx);
+
+   if (ctx->ExecuteFlag) {
+      CALL_MatrixMode(ctx->Exec, (mode));
+   }
+
+   /* Don't compile this call if it's a no-op. */
+   if (ctx->ListState.Current.MatrixMode == mode)
+      return;
+
+   SAVE_FLUSH_VERTICES(ctx);
+
+   ctx->ListState.Current.MatrixMode = mode;
+
    n = alloc_instruction(ctx, OPCODE_MATRIX_MODE, 1);
    if (n) {
       n[1].e = mode;
    }
-   if (ctx->ExecuteFlag) {
-      CALL_MatrixMode(ctx->Exec, (mode));
-   }
 }
 
 
@@ -3377,6 +3487,8 @@ save_PopAttrib(void)
 {
    GET_CURRENT_CONTEXT(ctx);
    ASSERT_OUTSIDE_SAVE_BEGIN_END_AND_FLUSH(ctx);
+   /* any of the state known in ListState.Current may be restored */
+   memset(&ctx->ListState.Current, 0, sizeof ctx->ListState.Current);
    (void) alloc_instruction(ctx, OPCODE_POP_ATTRIB, 0);
    if (ctx->ExecuteFlag) {
       CALL_PopAttrib(ctx->Exec, ());
@@ -37,6 +37,7 @@
 #include "framebuffer.h"
 #include "samplerobj.h"
 #include "stencil.h"
+#include "texobj.h"
 
 /* This is a table driven implemetation of the glGet*v() functions.
  * The basic idea is that most getters just look up an int somewhere
@@ -906,6 +907,20 @@ find_custom_value(struct gl_context *ctx, const struct value_desc *d, union valu
    }
 }
 
+/**
+ * Bring the derived framebuffer state up to date for the values that
+ * depend on it, without a full _mesa_update_state().  _NEW_BUFFERS stays
+ * set, so the rest of the derived state and the driver still get updated
+ * before the next draw.
+ */
+static void
+update_framebuffers(struct gl_context *ctx)
+{
+   _mesa_lock_context_textures(ctx);
+   _mesa_update_framebuffer(ctx);
+   _mesa_unlock_context_textures(ctx);
+}
+
 /**
  * Check extra constraints on a struct value_desc descriptor
  *
@@ -947,8 +962,11 @@ check_extra(struct gl_context *ctx, const char *func, const struct value_desc *d
             api_found = GL_TRUE;
 	 break;
       case EXTRA_NEW_FRAG_CLAMP:
-         if (ctx->NewState & (_NEW_BUFFERS | _NEW_FRAG_CLAMP))
-            _mesa_update_state(ctx);
+         /* The clamp is computed from ClampFragmentColor on the fly, only
+          * the framebuffer's color buffer types need to be current.
+          */
+         if (ctx->NewState & _NEW_BUFFERS)
+            update_framebuffers(ctx);
          break;
       case EXTRA_API_ES2:
          api_check = GL_TRUE;
@@ -972,7 +990,7 @@ check_extra(struct gl_context *ctx, const char *func, const struct value_desc *d
 	 break;
       case EXTRA_NEW_BUFFERS:
 	 if (ctx->NewState & _NEW_BUFFERS)
-	    _mesa_update_state(ctx);
+	    update_framebuffers(ctx);
 	 break;
       case EXTRA_FLUSH_CURRENT:
 	 FLUSH_CURRENT(ctx, 0);
@@ -1122,6 +1140,61 @@ find_value(const char *func, GLenum pname, void **p, union value *v)
    return &error_value;
 }
 
+/**
+ * Look up a few integer values that applications and middleware query
+ * all the time (often every frame) straight from the context, without
+ * the hash walk of find_value(), its extra checks and the switch of
+ * find_custom_value().  The results must be exactly what find_value()
+ * gives, including for the enums that are only valid in some APIs.
+ *
+ * \return the number of values written to \c params, or 0 if \c pname
+ *         isn't one of them and has to go through find_value().
+ */
+static int
+get_integers_fast(struct gl_context *ctx, GLenum pname, GLint *params)
+{
+   switch (pname) {
+   case GL_VIEWPORT:
+      params[0] = ctx->Viewport.X;
+      params[1] = ctx->Viewport.Y;
+      params[2] = ctx->Viewport.Width;
+      params[3] = ctx->Viewport.Height;
+      return 4;
+   case GL_SCISSOR_BOX:
+      params[0] = ctx->Scissor.X;
+      params[1] = ctx->Scissor.Y;
+      params[2] = ctx->Scissor.Width;
+      params[3] = ctx->Scissor.Height;
+      return 4;
+   case GL_ACTIVE_TEXTURE_ARB:
+      params[0] = GL_TEXTURE0_ARB + ctx->Texture.CurrentUnit;
+      return 1;
+   case GL_TEXTURE_BINDING_2D:
+      params[0] = ctx->Texture.Unit[ctx->Texture.CurrentUnit]
+         .CurrentTex[TEXTURE_2D_INDEX]->Name;
+      return 1;
+   case GL_ARRAY_BUFFER_BINDING_ARB:
+      params[0] = ctx->Array.ArrayBufferObj->Name;
+      return 1;
+   case GL_ELEMENT_ARRAY_BUFFER_BINDING_ARB:
+      params[0] = ctx->Array.ArrayObj->ElementArrayBufferObj->Name;
+      return 1;
+   case GL_FRAMEBUFFER_BINDING_EXT:
+      if (!ctx->Extensions.EXT_framebuffer_object)
+         return 0;
+      params[0] = ctx->DrawBuffer->Name;
+      return 1;
+   case GL_CURRENT_PROGRAM:
+      if (ctx->API == API_OPENGLES || !ctx->Extensions.ARB_shader_objects)
+         return 0;
+      params[0] =
+         ctx->Shader.ActiveProgram ? ctx->Shader.ActiveProgram->Name : 0;
+      return 1;
+   default:
+      return 0;
+   }
+}
+
 static const int transpose[] = {
    0, 4,  8, 12,
    1, 5,  9, 13,
@@ -1218,12 +1291,21 @@ _mesa_GetBooleanv(GLenum pname, GLboolean *params)
 void GLAPIENTRY
 _mesa_GetFloatv(GLenum pname, GLfloat *params)
 {
+   GET_CURRENT_CONTEXT(ctx);
    const struct value_desc *d;
    union value v;
    GLmatrix *m;
-   int shift, i;
+   int shift, i, n;
+   GLint ints[4];
    void *p;
 
+   n = get_integers_fast(ctx, pname, ints);
+   if (n) {
+      for (i = 0; i < n; i++)
+         params[i] = (GLfloat) ints[i];
+      return;
+   }
+
    d = find_value("glGetFloatv", pname, &p, &v);
    switch (d->type) {
    case TYPE_INVALID:
@@ -1304,12 +1386,16 @@ _mesa_GetFloatv(GLenum pname, GLfloat *params)
 void GLAPIENTRY
 _mesa_GetIntegerv(GLenum pname, GLint *params)
 {
+   GET_CURRENT_CONTEXT(ctx);
    const struct value_desc *d;
    union value v;
    GLmatrix *m;
    int shift, i;
    void *p;
 
+   if (get_integers_fast(ctx, pname, params))
+      return;
+
    d = find_value("glGetIntegerv", pname, &p, &v);
    switch (d->type) {
    case TYPE_INVALID:
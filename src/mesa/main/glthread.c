@@ -0,0 +1,305 @@
+/*
+ * Copyright © 2013 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file glthread.c
+ * The glthread worker and the queue of batches feeding it.
+ */
+
+#include "main/glheader.h"
+#include "main/context.h"
+#include "main/glthread.h"
+#include "main/imports.h"
+#include "main/marshal.h"
+#include "main/mtypes.h"
+#include "glapi/glapi.h"
+
+#ifdef HAVE_PTHREAD
+
+/**
+ * Number of full batches the application's thread may get ahead of the
+ * worker before it has to wait.
+ */
+#define GLTHREAD_MAX_QUEUED_BATCHES 8
+
+
+static unsigned
+queued_batches(const struct glthread_state *glthread)
+{
+   const struct glthread_batch *batch;
+   unsigned count = 0;
+
+   for (batch = glthread->queue; batch != NULL; batch = batch->next)
+      count++;
+
+   return count;
+}
+
+
+static void
+glthread_unmarshal_batch(struct gl_context *ctx, struct glthread_batch *batch)
+{
+   size_t pos = 0;
+
+   /* The application's thread may have switched the dispatch with a
+    * synchronous call (glCallLists(), for instance) since the last batch.
+    */
+   _glapi_set_dispatch(ctx->CurrentDispatch);
+
+   while (pos < batch->used)
+      pos += _mesa_unmarshal_dispatch_cmd(ctx, (uint8_t *) batch->buffer + pos);
+
+   assert(pos == batch->used);
+   batch->used = 0;
+}
+
+
+static void *
+glthread_worker(void *data)
+{
+   struct gl_context *ctx = data;
+   struct glthread_state *glthread = ctx->GLThread;
+
+   _glapi_set_context(ctx);
+
+   pthread_mutex_lock(&glthread->mutex);
+   while (true) {
+      struct glthread_batch *batch;
+
+      while (glthread->queue == NULL && !glthread->shutdown)
+         pthread_cond_wait(&glthread->new_work, &glthread->mutex);
+
+      if (glthread->queue == NULL)
+         break;
+
+      batch = glthread->queue;
+      glthread->queue = batch->next;
+      if (glthread->queue == NULL)
+         glthread->queue_tail = &glthread->queue;
+      glthread->busy = true;
+      pthread_mutex_unlock(&glthread->mutex);
+
+      glthread_unmarshal_batch(ctx, batch);
+
+      pthread_mutex_lock(&glthread->mutex);
+      batch->next = glthread->free_batches;
+      glthread->free_batches = batch;
+      glthread->busy = false;
+      pthread_cond_broadcast(&glthread->work_done);
+   }
+   pthread_mutex_unlock(&glthread->mutex);
+
+   return NULL;
+}
+
+
+static void
+free_batch_list(struct glthread_batch *batch)
+{
+   while (batch != NULL) {
+      struct glthread_batch *next = batch->next;
+      free(batch);
+      batch = next;
+   }
+}
+
+
+/**
+ * Starts marshalling the GL calls of \c ctx onto a worker thread.
+ *
+ * On failure the context is left executing calls directly.
+ */
+void
+_mesa_glthread_init(struct gl_context *ctx)
+{
+   struct glthread_state *glthread;
+
+   if (ctx->GLThread)
+      return;
+
+   glthread = calloc(1, sizeof(*glthread));
+   if (!glthread)
+      return;
+
+   glthread->batch = calloc(1, sizeof(*glthread->batch));
+   ctx->MarshalExec = _mesa_create_marshal_table(ctx);
+   if (!glthread->batch || !ctx->MarshalExec) {
+      free(ctx->MarshalExec);
+      ctx->MarshalExec = NULL;
+      free(glthread->batch);
+      free(glthread);
+      return;
+   }
+
+   pthread_mutex_init(&glthread->mutex, NULL);
+   pthread_cond_init(&glthread->new_work, NULL);
+   pthread_cond_init(&glthread->work_done, NULL);
+   glthread->queue_tail = &glthread->queue;
+
+   ctx->GLThread = glthread;
+
+   if (pthread_create(&glthread->thread, NULL, glthread_worker, ctx) != 0) {
+      ctx->GLThread = NULL;
+      pthread_cond_destroy(&glthread->work_done);
+      pthread_cond_destroy(&glthread->new_work);
+      pthread_mutex_destroy(&glthread->mutex);
+      free(ctx->MarshalExec);
+      ctx->MarshalExec = NULL;
+      free(glthread->batch);
+      free(glthread);
+      return;
+   }
+
+   _glapi_check_multithread();
+
+   if (_mesa_get_current_context() == ctx)
+      _glapi_set_dispatch(ctx->MarshalExec);
+}
+
+
+/**
+ * Waits for the worker to run all pending calls, stops it and goes back to
+ * executing calls directly.
+ */
+void
+_mesa_glthread_destroy(struct gl_context *ctx)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+
+   if (!glthread)
+      return;
+
+   _mesa_glthread_finish(ctx);
+
+   pthread_mutex_lock(&glthread->mutex);
+   glthread->shutdown = true;
+   pthread_cond_signal(&glthread->new_work);
+   pthread_mutex_unlock(&glthread->mutex);
+
+   pthread_join(glthread->thread, NULL);
+
+   ctx->GLThread = NULL;
+
+   if (_glapi_get_dispatch() == ctx->MarshalExec)
+      _glapi_set_dispatch(ctx->CurrentDispatch);
+
+   free(ctx->MarshalExec);
+   ctx->MarshalExec = NULL;
+
+   free_batch_list(glthread->free_batches);
+   free(glthread->batch);
+   pthread_cond_destroy(&glthread->work_done);
+   pthread_cond_destroy(&glthread->new_work);
+   pthread_mutex_destroy(&glthread->mutex);
+   free(glthread);
+}
+
+
+/**
+ * Hands the batch being filled to the worker and starts a new one.
+ */
+void
+_mesa_glthread_flush_batch(struct gl_context *ctx)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+   struct glthread_batch *batch;
+
+   if (!glthread || glthread->batch->used == 0)
+      return;
+
+   pthread_mutex_lock(&glthread->mutex);
+
+   while (queued_batches(glthread) >= GLTHREAD_MAX_QUEUED_BATCHES)
+      pthread_cond_wait(&glthread->work_done, &glthread->mutex);
+
+   batch = glthread->batch;
+   batch->next = NULL;
+   *glthread->queue_tail = batch;
+   glthread->queue_tail = &batch->next;
+   pthread_cond_signal(&glthread->new_work);
+
+   batch = glthread->free_batches;
+   if (batch)
+      glthread->free_batches = batch->next;
+   pthread_mutex_unlock(&glthread->mutex);
+
+   if (!batch) {
+      batch = malloc(sizeof(*batch));
+
+      /* Out of memory: wait for the worker to give one back. */
+      if (!batch) {
+         pthread_mutex_lock(&glthread->mutex);
+         while (glthread->free_batches == NULL)
+            pthread_cond_wait(&glthread->work_done, &glthread->mutex);
+         batch = glthread->free_batches;
+         glthread->free_batches = batch->next;
+         pthread_mutex_unlock(&glthread->mutex);
+      }
+   }
+
+   batch->used = 0;
+   glthread->batch = batch;
+}
+
+
+/**
+ * Waits until the worker has run every call made so far.
+ *
+ * This is what the synchronous entry points and everything else that
+ * touches the context from the application's thread must call first.
+ */
+void
+_mesa_glthread_finish(struct gl_context *ctx)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+
+   if (!glthread)
+      return;
+
+   /* Calls running on the worker may end up here; they are already in
+    * order with respect to everything queued.
+    */
+   if (pthread_equal(pthread_self(), glthread->thread))
+      return;
+
+   _mesa_glthread_flush_batch(ctx);
+
+   pthread_mutex_lock(&glthread->mutex);
+   while (glthread->queue != NULL || glthread->busy)
+      pthread_cond_wait(&glthread->work_done, &glthread->mutex);
+   pthread_mutex_unlock(&glthread->mutex);
+}
+
+
+/**
+ * Reinstalls the marshalling dispatch table on the application's thread
+ * after a synchronous call that may have installed ctx->CurrentDispatch.
+ */
+void
+_mesa_glthread_restore_dispatch(struct gl_context *ctx)
+{
+   if (ctx->GLThread && _glapi_get_dispatch() != ctx->MarshalExec)
+      _glapi_set_dispatch(ctx->MarshalExec);
+}
+
+#endif /* HAVE_PTHREAD */
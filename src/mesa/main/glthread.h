@@ -0,0 +1,145 @@
+/*
+ * Copyright © 2013 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file glthread.h
+ * Threaded GL dispatch.
+ *
+ * When enabled for a context, the application's thread runs the
+ * ctx->MarshalExec dispatch table, whose entry points (generated by
+ * gl_marshal.py into marshal_generated.c) record each call into a batch.
+ * Full batches are handed to a worker thread which replays them through
+ * ctx->CurrentDispatch, so that API validation, state updates and the
+ * driver's work happen off the application's thread.
+ *
+ * Calls that return a value, write to client memory or read client memory
+ * that cannot be copied into the batch wait for the worker to go idle and
+ * then execute on the application's thread.
+ */
+
+#ifndef MESA_GLTHREAD_H
+#define MESA_GLTHREAD_H
+
+#include "main/glheader.h"
+
+struct gl_context;
+
+#ifdef HAVE_PTHREAD
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/** Size of the command buffer of a batch, in bytes. */
+#define MARSHAL_MAX_CMD_SIZE (8 * 1024)
+
+struct glthread_batch
+{
+   /** Next batch in the worker's queue. */
+   struct glthread_batch *next;
+
+   /** Number of bytes of \c buffer holding commands. */
+   size_t used;
+
+   /** Commands, each starting with a struct marshal_cmd_base. */
+   uint64_t buffer[MARSHAL_MAX_CMD_SIZE / sizeof(uint64_t)];
+};
+
+struct glthread_state
+{
+   pthread_t thread;
+
+   /** Protects everything below except \c batch. */
+   pthread_mutex_t mutex;
+
+   /** Signalled when a batch is queued or shutdown is requested. */
+   pthread_cond_t new_work;
+
+   /** Signalled when the worker finishes a batch. */
+   pthread_cond_t work_done;
+
+   /** Batches waiting for the worker, oldest first. */
+   struct glthread_batch *queue;
+   struct glthread_batch **queue_tail;
+
+   /** Batches the worker is done with, ready to be filled again. */
+   struct glthread_batch *free_batches;
+
+   /** Whether the worker is replaying a batch. */
+   bool busy;
+
+   /** Set when the context is destroyed. */
+   bool shutdown;
+
+   /**
+    * Batch being filled by the application's thread.  Only ever touched
+    * by that thread.
+    */
+   struct glthread_batch *batch;
+};
+
+void
+_mesa_glthread_init(struct gl_context *ctx);
+
+void
+_mesa_glthread_destroy(struct gl_context *ctx);
+
+void
+_mesa_glthread_flush_batch(struct gl_context *ctx);
+
+void
+_mesa_glthread_finish(struct gl_context *ctx);
+
+void
+_mesa_glthread_restore_dispatch(struct gl_context *ctx);
+
+#else /* HAVE_PTHREAD */
+
+static inline void
+_mesa_glthread_init(struct gl_context *ctx)
+{
+}
+
+static inline void
+_mesa_glthread_destroy(struct gl_context *ctx)
+{
+}
+
+static inline void
+_mesa_glthread_flush_batch(struct gl_context *ctx)
+{
+}
+
+static inline void
+_mesa_glthread_finish(struct gl_context *ctx)
+{
+}
+
+static inline void
+_mesa_glthread_restore_dispatch(struct gl_context *ctx)
+{
+}
+
+#endif /* HAVE_PTHREAD */
+
+#endif /* MESA_GLTHREAD_H */
@@ -53,6 +53,38 @@
  */
 #define DELETED_KEY_VALUE 1
 
+/**
+ * Lock-free lookups of small keys.
+ *
+ * Entries whose key is below HASH_FAST_MAX_KEYS are mirrored into a
+ * directly indexed array that _mesa_HashLookup() reads without taking the
+ * table's mutex.  Writers still take the mutex, update the hash table and
+ * then the array slot, which is a single pointer store.  When the array has
+ * to grow, a new copy is published with one pointer store and the old one
+ * is kept until the table is deleted, since readers may still be reading it.
+ *
+ * The only ordering needed is that the stores initializing an object or an
+ * array happen before the store publishing it, which HASH_WRITE_BARRIER()
+ * provides.  Readers only rely on data dependencies.
+ */
+#if defined(__GNUC__)
+#define HASH_WRITE_BARRIER() __sync_synchronize()
+#define HASH_LOCKLESS_LOOKUP 1
+#elif defined(_MSC_VER)
+#include <intrin.h>
+#define HASH_WRITE_BARRIER() _ReadWriteBarrier()
+#define HASH_LOCKLESS_LOOKUP 1
+#endif
+
+#define HASH_FAST_MIN_KEYS 64
+#define HASH_FAST_MAX_KEYS (64 * 1024)
+
+struct hash_fast_array {
+   GLuint size;                          /**< number of entries in data[] */
+   struct hash_fast_array *retired;      /**< older, smaller copies */
+   void *data[1];
+};
+
 /**
  * The hash table data structure.  
  */
@@ -64,6 +96,8 @@ struct _mesa_HashTable {
    GLboolean InDeleteAll;                /**< Debug check */
    /** Value that would be in the table for DELETED_KEY_VALUE. */
    void *deleted_key_data;
+   /** Copy of the entries with small keys, NULL until one is inserted. */
+   struct hash_fast_array * volatile Fast;
 };
 
 /** @{
@@ -144,6 +178,12 @@ _mesa_DeleteHashTable(struct _mesa_HashTable *table)
 
    _mesa_hash_table_destroy(table->ht, NULL);
 
+   while (table->Fast) {
+      struct hash_fast_array *retired = table->Fast->retired;
+      free(table->Fast);
+      table->Fast = retired;
+   }
+
    _glthread_DESTROY_MUTEX(table->Mutex);
    _glthread_DESTROY_MUTEX(table->WalkMutex);
    free(table);
@@ -174,8 +214,54 @@ _mesa_HashLookup_unlocked(struct _mesa_HashTable *table, GLuint key)
 }
 
 
+/**
+ * Store the data of a key into the fast array, growing it if needed.
+ * Called with the table's mutex held.
+ */
+static void
+set_fast_entry(struct _mesa_HashTable *table, GLuint key, void *data)
+{
+   struct hash_fast_array *fast = table->Fast;
+
+   if (key >= HASH_FAST_MAX_KEYS)
+      return;
+
+   if (!fast || key >= fast->size) {
+      struct hash_fast_array *grown;
+      GLuint size = HASH_FAST_MIN_KEYS;
+
+      /* Nothing to clear in an array that doesn't cover the key. */
+      if (!data)
+         return;
+
+      while (size <= key)
+         size *= 2;
+
+      grown = calloc(1, sizeof(*grown) + (size - 1) * sizeof(void *));
+      if (!grown)
+         return;
+
+      grown->size = size;
+      grown->retired = fast;
+      if (fast)
+         memcpy(grown->data, fast->data, fast->size * sizeof(void *));
+
+      grown->data[key] = data;
+
+      HASH_WRITE_BARRIER();
+      table->Fast = grown;
+      return;
+   }
+
+   HASH_WRITE_BARRIER();
+   fast->data[key] = data;
+}
+
+
 /**
  * Lookup an entry in the hash table.
+ *
+ * Keys covered by the fast array are looked up without locking.
  * 
  * \param table the hash table.
  * \param key the key.
@@ -187,6 +273,15 @@ _mesa_HashLookup(struct _mesa_HashTable *table, GLuint key)
 {
    void *res;
    assert(table);
+
+#ifdef HASH_LOCKLESS_LOOKUP
+   {
+      const struct hash_fast_array *fast = table->Fast;
+      if (fast && key < fast->size)
+         return ((void * const volatile *) fast->data)[key];
+   }
+#endif
+
    _glthread_LOCK_MUTEX(table->Mutex);
    res = _mesa_HashLookup_unlocked(table, key);
    _glthread_UNLOCK_MUTEX(table->Mutex);
@@ -227,6 +322,10 @@ _mesa_HashInsert(struct _mesa_HashTable *table, GLuint key, void *data)
       }
    }
 
+#ifdef HASH_LOCKLESS_LOOKUP
+   set_fast_entry(table, key, data);
+#endif
+
    _glthread_UNLOCK_MUTEX(table->Mutex);
 }
 
@@ -263,6 +362,9 @@ _mesa_HashRemove(struct _mesa_HashTable *table, GLuint key)
       entry = _mesa_hash_table_search(table->ht, uint_hash(key), uint_key(key));
       _mesa_hash_table_remove(table->ht, entry);
    }
+#ifdef HASH_LOCKLESS_LOOKUP
+   set_fast_entry(table, key, NULL);
+#endif
    _glthread_UNLOCK_MUTEX(table->Mutex);
 }
 
@@ -296,6 +398,8 @@ _mesa_HashDeleteAll(struct _mesa_HashTable *table,
       callback(DELETED_KEY_VALUE, table->deleted_key_data, userData);
       table->deleted_key_data = NULL;
    }
+   if (table->Fast)
+      memset(table->Fast->data, 0, table->Fast->size * sizeof(void *));
    table->InDeleteAll = GL_FALSE;
    _glthread_UNLOCK_MUTEX(table->Mutex);
 }
@@ -0,0 +1,89 @@
+/*
+ * Copyright © 2013 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file marshal.h
+ * Command format shared by glthread.c and the generated marshal_generated.c.
+ */
+
+#ifndef MARSHAL_H
+#define MARSHAL_H
+
+#include "main/glthread.h"
+
+#ifdef HAVE_PTHREAD
+
+#include "main/compiler.h"
+#include "main/macros.h"
+#include "main/mtypes.h"
+
+struct _glapi_table;
+
+/** Header of every command in a batch. */
+struct marshal_cmd_base
+{
+   /** Value of the marshal_dispatch_cmd_id enum of marshal_generated.c. */
+   uint16_t cmd_id;
+
+   /** Size of the command, header included, in bytes; a multiple of 8. */
+   uint16_t cmd_size;
+};
+
+/**
+ * Reserves room for a command of \c size bytes in the current batch,
+ * handing the batch over to the worker first if it is full.
+ */
+static inline void *
+_mesa_glthread_allocate_command(struct gl_context *ctx,
+                                uint16_t cmd_id,
+                                size_t size)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+   const size_t aligned_size = ALIGN(size, 8);
+   struct marshal_cmd_base *cmd_base;
+
+   assert(aligned_size <= MARSHAL_MAX_CMD_SIZE);
+
+   if (unlikely(glthread->batch->used + aligned_size > MARSHAL_MAX_CMD_SIZE))
+      _mesa_glthread_flush_batch(ctx);
+
+   cmd_base = (struct marshal_cmd_base *)
+      ((uint8_t *) glthread->batch->buffer + glthread->batch->used);
+   glthread->batch->used += aligned_size;
+   cmd_base->cmd_id = cmd_id;
+   cmd_base->cmd_size = aligned_size;
+   return cmd_base;
+}
+
+/**
+ * Replays the command at \c cmd and returns its size.
+ */
+size_t
+_mesa_unmarshal_dispatch_cmd(struct gl_context *ctx, const void *cmd);
+
+struct _glapi_table *
+_mesa_create_marshal_table(const struct gl_context *ctx);
+
+#endif /* HAVE_PTHREAD */
+
+#endif /* MARSHAL_H */
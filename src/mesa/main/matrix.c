@@ -555,13 +555,18 @@ _mesa_MultTransposeMatrixd( const GLdouble *m )
 static void
 update_projection( struct gl_context *ctx )
 {
-   _math_matrix_analyse( ctx->ProjectionMatrixStack.Top );
+   /* The inverse is only needed for the user clip planes below, or by
+    * _mesa_update_clip_plane() and state vars which bring it up to date
+    * themselves.
+    */
+   _math_matrix_analyse_type( ctx->ProjectionMatrixStack.Top );
 
    /* Recompute clip plane positions in clipspace.  This is also done
     * in _mesa_ClipPlane().
     */
    if (ctx->Transform.ClipPlanesEnabled) {
       GLuint p;
+      _math_matrix_analyse( ctx->ProjectionMatrixStack.Top );
       for (p = 0; p < ctx->Const.MaxClipPlanes; p++) {
 	 if (ctx->Transform.ClipPlanesEnabled & (1 << p)) {
 	    _mesa_transform_vector( ctx->Transform._ClipUserPlane[p],
@@ -580,7 +585,7 @@ update_projection( struct gl_context *ctx )
  *
  * Multiplies the top matrices of the projection and model view stacks into
  * __struct gl_contextRec::_ModelProjectMatrix via _math_matrix_mul_matrix()
- * and analyzes the resulting matrix via _math_matrix_analyse().
+ * and analyzes the resulting matrix via _math_matrix_analyse_type().
  */
 static void
 calculate_model_project_matrix( struct gl_context *ctx )
@@ -589,7 +594,10 @@ calculate_model_project_matrix( struct gl_context *ctx )
                             ctx->ProjectionMatrixStack.Top,
                             ctx->ModelviewMatrixStack.Top );
 
-   _math_matrix_analyse( &ctx->_ModelProjectMatrix );
+   /* the inverse is only read through program state vars, which call
+    * _math_matrix_analyse() first
+    */
+   _math_matrix_analyse_type( &ctx->_ModelProjectMatrix );
 }
 
 
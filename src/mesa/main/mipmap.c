@@ -37,6 +37,7 @@
 #include "texstore.h"
 #include "image.h"
 #include "macros.h"
+#include "parallel.h"
 #include "../../gallium/auxiliary/util/u_format_rgb9e5.h"
 #include "../../gallium/auxiliary/util/u_format_r11g11b10f.h"
 
@@ -137,6 +138,64 @@ bytes_per_pixel(GLenum datatype, GLuint comps)
 /*@}*/
 
 
+/**
+ * \name Halving row filters
+ * Specialized versions of do_row() for the common case of the source row
+ * being exactly twice as wide as the dest row.  The column stride is then
+ * a constant, and with \c comps a constant at each call site the compiler
+ * can unroll and vectorize these loops, which it can't do for the generic
+ * loops with their run-time colStride.
+ */
+/*@{*/
+static inline void
+halve_row_ubyte(GLuint comps, const GLubyte *rowA, const GLubyte *rowB,
+                GLuint dstWidth, GLubyte *dst)
+{
+   GLuint i, c;
+   for (i = 0; i < dstWidth; i++) {
+      for (c = 0; c < comps; c++) {
+         const GLuint j = 2 * i * comps + c, k = j + comps;
+         dst[i * comps + c] = (rowA[j] + rowA[k] + rowB[j] + rowB[k]) / 4;
+      }
+   }
+}
+
+static inline void
+halve_row_float(GLuint comps, const GLfloat *rowA, const GLfloat *rowB,
+                GLuint dstWidth, GLfloat *dst)
+{
+   GLuint i, c;
+   for (i = 0; i < dstWidth; i++) {
+      for (c = 0; c < comps; c++) {
+         const GLuint j = 2 * i * comps + c, k = j + comps;
+         dst[i * comps + c] = (rowA[j] + rowA[k] +
+                               rowB[j] + rowB[k]) * 0.25F;
+      }
+   }
+}
+
+#define HALVE_ROW(FUNC, TYPE)                                           \
+   switch (comps) {                                                     \
+   case 1:                                                              \
+      FUNC(1, (const TYPE *) srcRowA, (const TYPE *) srcRowB,           \
+           dstWidth, (TYPE *) dstRow);                                  \
+      break;                                                            \
+   case 2:                                                              \
+      FUNC(2, (const TYPE *) srcRowA, (const TYPE *) srcRowB,           \
+           dstWidth, (TYPE *) dstRow);                                  \
+      break;                                                            \
+   case 3:                                                              \
+      FUNC(3, (const TYPE *) srcRowA, (const TYPE *) srcRowB,           \
+           dstWidth, (TYPE *) dstRow);                                  \
+      break;                                                            \
+   default:                                                             \
+      FUNC(4, (const TYPE *) srcRowA, (const TYPE *) srcRowB,           \
+           dstWidth, (TYPE *) dstRow);                                  \
+      break;                                                            \
+   }
+/*@}*/
+
+
 /**
  * Average together two rows of a source image to produce a single new
  * row in the dest image.  It's legal for the two source rows to point
@@ -160,7 +219,14 @@ do_row(GLenum datatype, GLuint comps, GLint srcWidth,
    assert(srcWidth == dstWidth || srcWidth == 2 * dstWidth);
    */
 
-   if (datatype == GL_UNSIGNED_BYTE && comps == 4) {
+   if (srcWidth == 2 * dstWidth && datatype == GL_UNSIGNED_BYTE) {
+      HALVE_ROW(halve_row_ubyte, GLubyte);
+   }
+   else if (srcWidth == 2 * dstWidth && datatype == GL_FLOAT) {
+      HALVE_ROW(halve_row_float, GLfloat);
+   }
+
+   else if (datatype == GL_UNSIGNED_BYTE && comps == 4) {
       GLuint i, j, k;
       const GLubyte(*rowA)[4] = (const GLubyte(*)[4]) srcRowA;
       const GLubyte(*rowB)[4] = (const GLubyte(*)[4]) srcRowB;
@@ -1441,6 +1507,57 @@ make_1d_mipmap(GLenum datatype, GLuint comps, GLint border,
 }
 
 
+/**
+ * \name Threaded mipmap generation
+ *
+ * Large levels are split into independent pieces, bands of dest rows for
+ * 2D images and dest images for 3D textures, which the worker threads of
+ * parallel.c filter while the calling thread filters pieces too.  Levels
+ * are still generated one after the other since each is the source of the
+ * next one.
+ */
+/*@{*/
+
+/** Levels with fewer source bytes than this are filtered on one thread */
+#define MIPMAP_THREAD_MIN_BYTES (1024 * 1024)
+
+/** Minimum number of dest rows per band */
+#define MIPMAP_THREAD_MIN_ROWS 16
+
+struct mipmap_2d_job {
+   GLenum datatype;
+   GLuint comps;
+   GLint srcWidthNB, dstWidthNB, dstHeightNB;
+   const GLubyte *srcA, *srcB;
+   GLint srcRowStep;         /**< bytes between consecutive src row pairs */
+   GLubyte *dst;
+   GLint dstRowStride;
+   GLint rowsPerBand;
+};
+
+static void
+make_2d_mipmap_band(void *data, GLuint band)
+{
+   const struct mipmap_2d_job *job = (const struct mipmap_2d_job *) data;
+   const GLint firstRow = band * job->rowsPerBand;
+   const GLint lastRow = MIN2(firstRow + job->rowsPerBand, job->dstHeightNB);
+   const GLubyte *srcA = job->srcA + firstRow * job->srcRowStep;
+   const GLubyte *srcB = job->srcB + firstRow * job->srcRowStep;
+   GLubyte *dst = job->dst + firstRow * job->dstRowStride;
+   GLint row;
+
+   for (row = firstRow; row < lastRow; row++) {
+      do_row(job->datatype, job->comps, job->srcWidthNB, srcA, srcB,
+             job->dstWidthNB, dst);
+      srcA += job->srcRowStep;
+      srcB += job->srcRowStep;
+      dst += job->dstRowStride;
+   }
+}
+
+/*@}*/
+
+
 static void
 make_2d_mipmap(GLenum datatype, GLuint comps, GLint border,
                GLint srcWidth, GLint srcHeight,
@@ -1455,6 +1572,8 @@ make_2d_mipmap(GLenum datatype, GLuint comps, GLint border,
    const GLubyte *srcA, *srcB;
    GLubyte *dst;
    GLint row, srcRowStep;
+   struct mipmap_2d_job job;
+   GLint bands = 1;
 
    /* Compute src and dst pointers, skipping any border */
    srcA = srcPtr + border * ((srcWidth + 1) * bpt);
@@ -1471,12 +1590,30 @@ make_2d_mipmap(GLenum datatype, GLuint comps, GLint border,
 
    dst = dstPtr + border * ((dstWidth + 1) * bpt);
 
-   for (row = 0; row < dstHeightNB; row++) {
-      do_row(datatype, comps, srcWidthNB, srcA, srcB,
-             dstWidthNB, dst);
-      srcA += srcRowStep * srcRowStride;
-      srcB += srcRowStep * srcRowStride;
-      dst += dstRowStride;
+   job.datatype = datatype;
+   job.comps = comps;
+   job.srcWidthNB = srcWidthNB;
+   job.dstWidthNB = dstWidthNB;
+   job.dstHeightNB = dstHeightNB;
+   job.srcA = srcA;
+   job.srcB = srcB;
+   job.srcRowStep = srcRowStep * srcRowStride;
+   job.dst = dst;
+   job.dstRowStride = dstRowStride;
+   job.rowsPerBand = dstHeightNB;
+
+   if ((size_t) srcWidth * srcHeight * bpt >= MIPMAP_THREAD_MIN_BYTES)
+      bands = MIN2((GLint) _mesa_parallel_threads(),
+                   dstHeightNB / MIPMAP_THREAD_MIN_ROWS);
+
+   if (bands > 1) {
+      job.rowsPerBand = (dstHeightNB + bands - 1) / bands;
+      bands = (dstHeightNB + job.rowsPerBand - 1) / job.rowsPerBand;
+   }
+
+   if (bands < 2 || !_mesa_parallel_for(bands, make_2d_mipmap_band, &job)) {
+      job.rowsPerBand = dstHeightNB;
+      make_2d_mipmap_band(&job, 0);
    }
 
    /* This is ugly but probably won't be used much */
@@ -1533,6 +1670,63 @@ make_2d_mipmap(GLenum datatype, GLuint comps, GLint border,
 }
 
 
+struct mipmap_3d_job {
+   GLenum datatype;
+   GLuint comps;
+   GLint border, bpt;
+   GLint srcWidthNB, dstWidthNB, dstHeightNB;
+   const GLubyte **srcPtr;
+   GLubyte **dstPtr;
+   GLint bytesPerSrcRow, bytesPerDstRow;
+   GLint srcImageOffset, srcRowOffset;
+};
+
+/**
+ * Filter the two source images of dest image \c img of a 3D level,
+ * skipping the border.
+ */
+static void
+make_3d_mipmap_image(void *data, GLuint img)
+{
+   const struct mipmap_3d_job *job = (const struct mipmap_3d_job *) data;
+   const GLint border = job->border;
+   const GLint srcRowStep = job->bytesPerSrcRow + job->srcRowOffset;
+
+   /* first source image pointer, skipping border */
+   const GLubyte *imgSrcA = job->srcPtr[img * 2 + border]
+      + job->bytesPerSrcRow * border + job->bpt * border;
+   /* second source image pointer, skipping border */
+   const GLubyte *imgSrcB = job->srcPtr[img * 2 + job->srcImageOffset + border]
+      + job->bytesPerSrcRow * border + job->bpt * border;
+
+   /* address of the dest image, skipping border */
+   GLubyte *imgDst = job->dstPtr[img + border]
+      + job->bytesPerDstRow * border + job->bpt * border;
+
+   /* setup the four source row pointers and the dest row pointer */
+   const GLubyte *srcImgARowA = imgSrcA;
+   const GLubyte *srcImgARowB = imgSrcA + job->srcRowOffset;
+   const GLubyte *srcImgBRowA = imgSrcB;
+   const GLubyte *srcImgBRowB = imgSrcB + job->srcRowOffset;
+   GLubyte *dstImgRow = imgDst;
+   GLint row;
+
+   for (row = 0; row < job->dstHeightNB; row++) {
+      do_row_3D(job->datatype, job->comps, job->srcWidthNB,
+                srcImgARowA, srcImgARowB,
+                srcImgBRowA, srcImgBRowB,
+                job->dstWidthNB, dstImgRow);
+
+      /* advance to next rows */
+      srcImgARowA += srcRowStep;
+      srcImgARowB += srcRowStep;
+      srcImgBRowA += srcRowStep;
+      srcImgBRowB += srcRowStep;
+      dstImgRow += job->bytesPerDstRow;
+   }
+}
+
+
 static void
 make_3d_mipmap(GLenum datatype, GLuint comps, GLint border,
                GLint srcWidth, GLint srcHeight, GLint srcDepth,
@@ -1546,10 +1740,11 @@ make_3d_mipmap(GLenum datatype, GLuint comps, GLint border,
    const GLint dstWidthNB = dstWidth - 2 * border;
    const GLint dstHeightNB = dstHeight - 2 * border;
    const GLint dstDepthNB = dstDepth - 2 * border;
-   GLint img, row;
+   GLint img;
    GLint bytesPerSrcImage, bytesPerDstImage;
    GLint bytesPerSrcRow, bytesPerDstRow;
    GLint srcImageOffset, srcRowOffset;
+   struct mipmap_3d_job job;
 
    (void) srcDepthNB; /* silence warnings */
 
@@ -1579,38 +1774,24 @@ make_3d_mipmap(GLenum datatype, GLuint comps, GLint border,
           srcWidth, srcHeight, srcDepth, dstWidth, dstHeight, dstDepth);
    */
 
-   for (img = 0; img < dstDepthNB; img++) {
-      /* first source image pointer, skipping border */
-      const GLubyte *imgSrcA = srcPtr[img * 2 + border]
-         + bytesPerSrcRow * border + bpt * border;
-      /* second source image pointer, skipping border */
-      const GLubyte *imgSrcB = srcPtr[img * 2 + srcImageOffset + border]
-         + bytesPerSrcRow * border + bpt * border;
-
-      /* address of the dest image, skipping border */
-      GLubyte *imgDst = dstPtr[img + border]
-         + bytesPerDstRow * border + bpt * border;
-
-      /* setup the four source row pointers and the dest row pointer */
-      const GLubyte *srcImgARowA = imgSrcA;
-      const GLubyte *srcImgARowB = imgSrcA + srcRowOffset;
-      const GLubyte *srcImgBRowA = imgSrcB;
-      const GLubyte *srcImgBRowB = imgSrcB + srcRowOffset;
-      GLubyte *dstImgRow = imgDst;
-
-      for (row = 0; row < dstHeightNB; row++) {
-         do_row_3D(datatype, comps, srcWidthNB, 
-                   srcImgARowA, srcImgARowB,
-                   srcImgBRowA, srcImgBRowB,
-                   dstWidthNB, dstImgRow);
-
-         /* advance to next rows */
-         srcImgARowA += bytesPerSrcRow + srcRowOffset;
-         srcImgARowB += bytesPerSrcRow + srcRowOffset;
-         srcImgBRowA += bytesPerSrcRow + srcRowOffset;
-         srcImgBRowB += bytesPerSrcRow + srcRowOffset;
-         dstImgRow += bytesPerDstRow;
-      }
+   job.datatype = datatype;
+   job.comps = comps;
+   job.border = border;
+   job.bpt = bpt;
+   job.srcWidthNB = srcWidthNB;
+   job.dstWidthNB = dstWidthNB;
+   job.dstHeightNB = dstHeightNB;
+   job.srcPtr = srcPtr;
+   job.dstPtr = dstPtr;
+   job.bytesPerSrcRow = bytesPerSrcRow;
+   job.bytesPerDstRow = bytesPerDstRow;
+   job.srcImageOffset = srcImageOffset;
+   job.srcRowOffset = srcRowOffset;
+
+   if ((size_t) bytesPerSrcImage * srcDepth < MIPMAP_THREAD_MIN_BYTES ||
+       !_mesa_parallel_for(dstDepthNB, make_3d_mipmap_image, &job)) {
+      for (img = 0; img < dstDepthNB; img++)
+         make_3d_mipmap_image(&job, img);
    }
 
 
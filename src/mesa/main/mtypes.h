@@ -78,6 +78,8 @@ struct st_context;
 struct gl_uniform_storage;
 struct prog_instruction;
 struct gl_program_parameter_list;
+struct glthread_state;
+struct hash_table;
 struct set;
 struct set_entry;
 /*@}*/
@@ -1346,6 +1348,9 @@ struct gl_texture_attrib
    /** Texture units/samplers used by vertex or fragment texturing */
    GLbitfield _EnabledUnits;
 
+   /** Largest index of a texture unit with _ReallyEnabled set, or -1 */
+   GLint _MaxEnabledTexImageUnit;
+
    /** Texture coord units/sets used for fragment texturing */
    GLbitfield _EnabledCoordUnits;
 
@@ -1419,6 +1424,19 @@ struct gl_buffer_object
    GLboolean DeletePending;   /**< true if buffer object is removed from the hash */
    GLboolean Written;   /**< Ever written to? (for debugging) */
    GLboolean Purgeable; /**< Is the buffer purgeable under memory pressure? */
+
+   /**
+    * \name Cache of the min/max index of the index ranges drawn from this
+    * buffer, maintained by vbo_get_minmax_index(), and of their primitive
+    * restart sub-primitives, maintained by vbo_sw_primitive_restart()
+    */
+   /*@{*/
+   _glthread_Mutex MinMaxCacheMutex; /**< Protects both caches */
+   struct hash_table *MinMaxCache;
+   struct hash_table *SubPrimCache;
+   GLboolean MinMaxCacheDirty;    /**< Contents changed since last lookup */
+   GLboolean MinMaxCacheDisabled; /**< Written by the GPU, never cached */
+   /*@}*/
 };
 
 
@@ -2117,6 +2135,13 @@ struct gl_shader
    unsigned Version;       /**< GLSL version used for linking */
    GLboolean IsES;         /**< True if this shader uses GLSL ES */
 
+   /**
+    * Unique number of the compile that produced \c ir, or zero for shaders
+    * not made by the GLSL compiler.  Never reused, so the linker can tell a
+    * recompiled (or reallocated) shader from the one it saw before.
+    */
+   unsigned CompileSerial;
+
    /**
     * \name Sampler tracking
     *
@@ -2366,6 +2391,15 @@ struct gl_shader_program
     */
    struct string_to_uint_map *UniformHash;
 
+   /**
+    * glGetUniformLocation() results, by the exact name queried
+    *
+    * Values are the returned location plus one.  Filled when the program
+    * is linked successfully and read-only afterwards, as the program may
+    * be shared between contexts.
+    */
+   struct string_to_uint_map *UniformLocationCache;
+
    GLboolean LinkStatus;   /**< GL_LINK_STATUS */
    GLboolean Validated;
    GLboolean _Used;        /**< Ever used for drawing? */
@@ -2394,6 +2428,8 @@ struct gl_shader_program
 #define GLSL_NOP_FRAG 0x40  /**< Force no-op fragment shaders */
 #define GLSL_USE_PROG 0x80  /**< Log glUseProgram calls */
 #define GLSL_REPORT_ERRORS 0x100  /**< Print compilation errors */
+#define GLSL_NO_CACHE 0x200  /**< Don't reuse the IR of identical shaders */
+#define GLSL_STATS    0x400  /**< Print per-pass compile and link statistics */
 
 
 /**
@@ -2422,6 +2458,12 @@ struct gl_shader_state
    struct gl_shader_program *ActiveProgram;
 
    GLbitfield Flags;                    /**< Mask of GLSL_x flags */
+
+   /** Compiled shaders by source (see glsl/shader_cache.cpp) */
+   struct glsl_shader_cache *CompileCache;
+
+   /** Linked shader stages by their shaders (see glsl/link_cache.cpp) */
+   struct glsl_link_cache *LinkCache;
 };
 
 
@@ -2460,6 +2502,12 @@ struct gl_shader_compiler_options
    GLboolean PreferDP4;
 
    struct gl_sl_pragmas DefaultPragmas; /**< Default #pragma settings */
+
+   /**
+    * Where the passes report timings during a compile or link that collects
+    * statistics (MESA_GLSL=stats), NULL otherwise.  See glsl/pass_stats.h.
+    */
+   struct glsl_pass_stats *PassStats;
 };
 
 
@@ -3247,6 +3295,24 @@ struct gl_display_list
 };
 
 
+/**
+ * \name Bits for gl_dlist_state::Current.Enabled/Disabled, one per
+ * glEnable/glDisable cap whose state is tracked while compiling a list
+ */
+/*@{*/
+#define DLIST_CAP_ALPHA_TEST             0x1
+#define DLIST_CAP_BLEND                  0x2
+#define DLIST_CAP_CULL_FACE              0x4
+#define DLIST_CAP_DEPTH_TEST             0x8
+#define DLIST_CAP_FOG                    0x10
+#define DLIST_CAP_LIGHTING               0x20
+#define DLIST_CAP_NORMALIZE              0x40
+#define DLIST_CAP_POLYGON_OFFSET_FILL    0x80
+#define DLIST_CAP_SCISSOR_TEST           0x100
+#define DLIST_CAP_STENCIL_TEST           0x200
+/*@}*/
+
+
 /**
  * State used during display list compilation and execution.
  */
@@ -3271,6 +3337,12 @@ struct gl_dlist_state
        * list.  Used to eliminate some redundant state changes.
        */
       GLenum ShadeModel;
+      GLenum MatrixMode;
+      GLenum FrontFace;
+      GLenum CullFace;
+      GLenum DepthFunc;
+      GLbitfield Enabled;   /**< DLIST_CAP_x bits known to be enabled */
+      GLbitfield Disabled;  /**< DLIST_CAP_x bits known to be disabled */
    } Current;
 };
 
@@ -3439,8 +3511,17 @@ struct gl_context
     * re-set on glXMakeCurrent().
     */
    struct _glapi_table *CurrentDispatch;
+   /**
+    * The dispatch table installed on the application's thread when GL
+    * calls are marshalled onto a glthread worker (see glthread.h).  The
+    * worker itself executes them through CurrentDispatch.
+    */
+   struct _glapi_table *MarshalExec;
    /*@}*/
 
+   /** glthread worker state, or NULL if calls are executed directly */
+   struct glthread_state *GLThread;
+
    struct gl_config Visual;
    struct gl_framebuffer *DrawBuffer;	/**< buffer for writing */
    struct gl_framebuffer *ReadBuffer;	/**< buffer for reading */
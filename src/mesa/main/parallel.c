@@ -0,0 +1,244 @@
+/*
+ * Copyright © 2013 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file parallel.c
+ * Worker thread pool running _mesa_parallel_for() jobs.
+ *
+ * There is one job at a time.  The calling thread works on the job too,
+ * and a caller finding the pool busy with another context's job runs its
+ * own work serially instead of waiting.
+ *
+ * The worker threads are started on first use and joined when the last
+ * context goes away, so that none is left running when the driver is
+ * unloaded.
+ */
+
+#include "main/glheader.h"
+#include "main/macros.h"
+#include "main/parallel.h"
+
+#ifdef HAVE_PTHREAD
+
+#include <pthread.h>
+#include <unistd.h>
+
+#define PARALLEL_MAX_THREADS 8
+
+struct parallel_job {
+   void (*func)(void *data, GLuint index);
+   void *data;
+   GLuint count;
+   GLuint next;        /**< next index to be handed out */
+   GLuint done;        /**< number of indices completed */
+};
+
+static struct {
+   pthread_mutex_t mutex;
+   pthread_cond_t newJob;
+   pthread_cond_t jobDone;
+   GLuint users;               /**< contexts referencing the pool */
+   GLboolean started;          /**< worker threads were started */
+   GLboolean exit;             /**< tell the worker threads to quit */
+   GLuint numThreads;          /**< worker threads, not counting callers */
+   pthread_t threads[PARALLEL_MAX_THREADS];
+   struct parallel_job *job;   /**< job being run, or NULL */
+} pool = {
+   PTHREAD_MUTEX_INITIALIZER,
+   PTHREAD_COND_INITIALIZER,
+   PTHREAD_COND_INITIALIZER
+};
+
+
+/**
+ * Run indices of the job until none is left.  Called with the pool's
+ * mutex held.
+ */
+static void
+run_job_locked(struct parallel_job *job)
+{
+   while (job->next < job->count) {
+      const GLuint index = job->next++;
+
+      pthread_mutex_unlock(&pool.mutex);
+      job->func(job->data, index);
+      pthread_mutex_lock(&pool.mutex);
+
+      if (++job->done == job->count)
+         pthread_cond_broadcast(&pool.jobDone);
+   }
+}
+
+
+static void *
+parallel_worker(void *data)
+{
+   (void) data;
+
+   pthread_mutex_lock(&pool.mutex);
+   while (!pool.exit) {
+      struct parallel_job *job = pool.job;
+
+      if (job && job->next < job->count)
+         run_job_locked(job);
+      else
+         pthread_cond_wait(&pool.newJob, &pool.mutex);
+   }
+   pthread_mutex_unlock(&pool.mutex);
+
+   return NULL;
+}
+
+
+/**
+ * Start the worker threads.  Called with the pool's mutex held.
+ */
+static void
+start_workers_locked(void)
+{
+   long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+   GLuint i;
+
+   pool.started = GL_TRUE;
+
+   if (cpus <= 1)
+      return;
+
+   for (i = 0; i < MIN2(cpus - 1, PARALLEL_MAX_THREADS - 1); i++) {
+      if (pthread_create(&pool.threads[pool.numThreads], NULL,
+                         parallel_worker, NULL) != 0)
+         break;
+      pool.numThreads++;
+   }
+}
+
+
+/**
+ * Take a reference on the pool for a new context.
+ */
+void
+_mesa_parallel_reference(void)
+{
+   pthread_mutex_lock(&pool.mutex);
+   pool.users++;
+   pthread_mutex_unlock(&pool.mutex);
+}
+
+
+/**
+ * Drop a context's reference on the pool, joining the worker threads
+ * when it was the last one.
+ */
+void
+_mesa_parallel_unreference(void)
+{
+   pthread_t threads[PARALLEL_MAX_THREADS];
+   GLuint numThreads, i;
+
+   pthread_mutex_lock(&pool.mutex);
+   assert(pool.users > 0);
+   if (--pool.users > 0 || !pool.started) {
+      pthread_mutex_unlock(&pool.mutex);
+      return;
+   }
+
+   pool.exit = GL_TRUE;
+   pthread_cond_broadcast(&pool.newJob);
+   numThreads = pool.numThreads;
+   memcpy(threads, pool.threads, numThreads * sizeof(threads[0]));
+   pool.numThreads = 0;
+   pthread_mutex_unlock(&pool.mutex);
+
+   for (i = 0; i < numThreads; i++)
+      pthread_join(threads[i], NULL);
+
+   pthread_mutex_lock(&pool.mutex);
+   pool.exit = GL_FALSE;
+   pool.started = GL_FALSE;
+   pthread_mutex_unlock(&pool.mutex);
+}
+
+
+/**
+ * Number of threads that run a _mesa_parallel_for() job, the calling
+ * thread included.  Starts the worker threads on first use.
+ */
+GLuint
+_mesa_parallel_threads(void)
+{
+   GLuint numThreads;
+
+   pthread_mutex_lock(&pool.mutex);
+   if (!pool.started && !pool.exit)
+      start_workers_locked();
+   numThreads = pool.numThreads;
+   pthread_mutex_unlock(&pool.mutex);
+
+   return numThreads + 1;
+}
+
+
+/**
+ * Call func(data, i) for each i in [0, count), spread over the worker
+ * threads and the calling thread, and wait for all of them.  The calls
+ * must be independent of each other.
+ *
+ * \return GL_FALSE, without calling func, if there are no worker threads
+ *         or they are busy with another job.
+ */
+GLboolean
+_mesa_parallel_for(GLuint count, void (*func)(void *data, GLuint index),
+                   void *data)
+{
+   struct parallel_job job;
+
+   if (count < 2 || _mesa_parallel_threads() < 2)
+      return GL_FALSE;
+
+   job.func = func;
+   job.data = data;
+   job.count = count;
+   job.next = 0;
+   job.done = 0;
+
+   pthread_mutex_lock(&pool.mutex);
+
+   if (pool.job) {
+      pthread_mutex_unlock(&pool.mutex);
+      return GL_FALSE;
+   }
+
+   pool.job = &job;
+   pthread_cond_broadcast(&pool.newJob);
+
+   run_job_locked(&job);
+   while (job.done < job.count)
+      pthread_cond_wait(&pool.jobDone, &pool.mutex);
+
+   pool.job = NULL;
+   pthread_mutex_unlock(&pool.mutex);
+
+   return GL_TRUE;
+}
+
+#endif /* HAVE_PTHREAD */
@@ -0,0 +1,78 @@
+/*
+ * Copyright © 2013 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file parallel.h
+ * A pool of worker threads, shared by all contexts, for splitting large
+ * CPU-side image operations (texture stores, mipmap generation) into
+ * independent pieces.
+ */
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include "main/glheader.h"
+
+#ifdef HAVE_PTHREAD
+
+extern void
+_mesa_parallel_reference(void);
+
+extern void
+_mesa_parallel_unreference(void);
+
+extern GLuint
+_mesa_parallel_threads(void);
+
+extern GLboolean
+_mesa_parallel_for(GLuint count, void (*func)(void *data, GLuint index),
+                   void *data);
+
+#else /* HAVE_PTHREAD */
+
+static inline void
+_mesa_parallel_reference(void)
+{
+}
+
+static inline void
+_mesa_parallel_unreference(void)
+{
+}
+
+static inline GLuint
+_mesa_parallel_threads(void)
+{
+   return 1;
+}
+
+static inline GLboolean
+_mesa_parallel_for(GLuint count, void (*func)(void *data, GLuint index),
+                   void *data)
+{
+   return GL_FALSE;
+}
+
+#endif /* HAVE_PTHREAD */
+
+#endif /* PARALLEL_H */
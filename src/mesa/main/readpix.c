@@ -408,6 +408,10 @@ read_stencil_pixels( struct gl_context *ctx,
 
 /**
  * Try to do glReadPixels of RGBA data using swizzle.
+ *
+ * This handles 8-bit RGBA/BGRA renderbuffers read as RGBA or BGRA bytes,
+ * which is what screenshot and capture code typically asks for, by
+ * swapping R/B and/or setting alpha in each 32-bit pixel.
  * \return GL_TRUE if successful, GL_FALSE otherwise (use the slow path)
  */
 static GLboolean
@@ -421,25 +425,59 @@ read_rgba_pixels_swizzle(struct gl_context *ctx,
    struct gl_renderbuffer *rb = ctx->ReadBuffer->_ColorReadBuffer;
    GLubyte *dst, *map;
    int dstStride, stride, j;
-   GLboolean swizzle_rb = GL_FALSE, copy_xrgb = GL_FALSE;
-
-   /* XXX we could check for other swizzle/special cases here as needed */
-   if (rb->Format == MESA_FORMAT_RGBA8888_REV &&
-       format == GL_BGRA &&
-       type == GL_UNSIGNED_INT_8_8_8_8_REV &&
-       !ctx->Pack.SwapBytes) {
-      swizzle_rb = GL_TRUE;
-   }
-   else if (rb->Format == MESA_FORMAT_XRGB8888 &&
-       format == GL_BGRA &&
-       type == GL_UNSIGNED_INT_8_8_8_8_REV &&
-       !ctx->Pack.SwapBytes) {
-      copy_xrgb = GL_TRUE;
-   }
-   else {
+   GLboolean src_r_low, dst_r_low, swizzle_rb, set_alpha;
+
+   if (ctx->Pack.SwapBytes)
+      return GL_FALSE;
+
+   if (rb->_BaseFormat != GL_RGBA && rb->_BaseFormat != GL_RGB)
+      return GL_FALSE;
+
+   switch (rb->Format) {
+   case MESA_FORMAT_RGBA8888_REV:
+      src_r_low = GL_TRUE;
+      set_alpha = GL_FALSE;
+      break;
+   case MESA_FORMAT_RGBX8888_REV:
+      src_r_low = GL_TRUE;
+      set_alpha = GL_TRUE;
+      break;
+   case MESA_FORMAT_ARGB8888:
+      src_r_low = GL_FALSE;
+      set_alpha = GL_FALSE;
+      break;
+   case MESA_FORMAT_XRGB8888:
+      src_r_low = GL_FALSE;
+      set_alpha = GL_TRUE;
+      break;
+   default:
       return GL_FALSE;
    }
 
+   if (rb->_BaseFormat == GL_RGB)
+      set_alpha = GL_TRUE;
+
+   /* The pixels are handled as 32-bit words with the first component in
+    * the low byte, which is also the GL_UNSIGNED_BYTE layout on little
+    * endian hosts.
+    */
+   if (type != GL_UNSIGNED_INT_8_8_8_8_REV &&
+       !(type == GL_UNSIGNED_BYTE && _mesa_little_endian()))
+      return GL_FALSE;
+
+   if (format == GL_RGBA)
+      dst_r_low = GL_TRUE;
+   else if (format == GL_BGRA)
+      dst_r_low = GL_FALSE;
+   else
+      return GL_FALSE;
+
+   swizzle_rb = src_r_low != dst_r_low;
+
+   /* nothing to convert, leave that to readpixels_memcpy() */
+   if (!swizzle_rb && !set_alpha)
+      return GL_FALSE;
+
    dstStride = _mesa_image_row_stride(packing, width, format, type);
    dst = (GLubyte *) _mesa_image_address2d(packing, pixels, width, height,
 					   format, type, 0, 0);
@@ -451,12 +489,30 @@ read_rgba_pixels_swizzle(struct gl_context *ctx,
       return GL_TRUE;  /* don't bother trying the slow path */
    }
 
-   if (swizzle_rb) {
+   /* The loops are kept free of branches so that the compiler can
+    * vectorize them.
+    */
+   if (swizzle_rb && set_alpha) {
+      /* swap R/B, set A=0xff */
+      for (j = 0; j < height; j++) {
+         GLuint *dst4 = (GLuint *) dst, *map4 = (GLuint *) map;
+         int i;
+         for (i = 0; i < width; i++) {
+            GLuint pixel = map4[i];
+            dst4[i] = (pixel & 0x0000ff00)
+                   | ((pixel & 0x00ff0000) >> 16)
+                   | ((pixel & 0x000000ff) << 16)
+                   | 0xff000000;
+         }
+         dst += dstStride;
+         map += stride;
+      }
+   } else if (swizzle_rb) {
       /* swap R/B */
       for (j = 0; j < height; j++) {
+         GLuint *dst4 = (GLuint *) dst, *map4 = (GLuint *) map;
          int i;
          for (i = 0; i < width; i++) {
-            GLuint *dst4 = (GLuint *) dst, *map4 = (GLuint *) map;
             GLuint pixel = map4[i];
             dst4[i] = (pixel & 0xff00ff00)
                    | ((pixel & 0x00ff0000) >> 16)
@@ -465,7 +521,7 @@ read_rgba_pixels_swizzle(struct gl_context *ctx,
          dst += dstStride;
          map += stride;
       }
-   } else if (copy_xrgb) {
+   } else {
       /* convert xrgb -> argb */
       for (j = 0; j < height; j++) {
          GLuint *dst4 = (GLuint *) dst, *map4 = (GLuint *) map;
@@ -89,6 +89,10 @@ get_shader_flags(void)
          flags |= GLSL_USE_PROG;
       if (strstr(env, "errors"))
          flags |= GLSL_REPORT_ERRORS;
+      if (strstr(env, "nocache"))
+         flags |= GLSL_NO_CACHE;
+      if (strstr(env, "stats"))
+         flags |= GLSL_STATS;
    }
 
    return flags;
@@ -135,6 +139,8 @@ _mesa_free_shader_state(struct gl_context *ctx)
    _mesa_reference_shader_program(ctx, &ctx->Shader._CurrentFragmentProgram,
 				  NULL);
    _mesa_reference_shader_program(ctx, &ctx->Shader.ActiveProgram, NULL);
+   _mesa_glsl_destroy_shader_cache(ctx);
+   _mesa_glsl_destroy_link_cache(ctx);
 }
 
 
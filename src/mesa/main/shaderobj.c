@@ -291,6 +291,11 @@ _mesa_clear_shader_program_data(struct gl_context *ctx,
       shProg->UniformHash = NULL;
    }
 
+   if (shProg->UniformLocationCache) {
+      string_to_uint_map_dtor(shProg->UniformLocationCache);
+      shProg->UniformLocationCache = NULL;
+   }
+
    assert(shProg->InfoLog != NULL);
    ralloc_free(shProg->InfoLog);
    shProg->InfoLog = ralloc_strdup(shProg, "");
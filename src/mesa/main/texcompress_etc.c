@@ -665,6 +665,103 @@ etc2_rgba8_fetch_texel(const struct etc2_block *block,
    etc2_alpha8_fetch_texel(block, x, y, dst);
 }
 
+/**
+ * Decode the RGB part of a whole block into the top-left width x height
+ * texels at dst_row, with alpha 255 (or 0 for punchthrough texels).
+ * The individual, differential, T and H modes only ever produce eight
+ * distinct colors per block, which are computed once up front; bgra swaps
+ * red and blue for the MESA_FORMAT_SARGB8 destinations.
+ */
+static void
+etc2_rgb8_decode_block(const struct etc2_block *block,
+                       uint8_t *dst_row, unsigned dst_stride,
+                       unsigned width, unsigned height,
+                       GLboolean punchthrough_alpha, GLboolean bgra)
+{
+   const unsigned r = bgra ? 2 : 0, b = bgra ? 0 : 2;
+   uint8_t palette[2][4][4];
+   unsigned blk, idx, i, j;
+
+   if (block->is_planar_mode) {
+      const uint8_t (*c)[3] = block->base_colors;
+
+      for (j = 0; j < height; j++) {
+         uint8_t *dst = dst_row + j * dst_stride;
+
+         for (i = 0; i < width; i++) {
+            const int x = i, y = j;
+
+            dst[r] = etc2_clamp((x * (c[1][0] - c[0][0]) +
+                                 y * (c[2][0] - c[0][0]) +
+                                 4 * c[0][0] + 2) >> 2);
+            dst[1] = etc2_clamp((x * (c[1][1] - c[0][1]) +
+                                 y * (c[2][1] - c[0][1]) +
+                                 4 * c[0][1] + 2) >> 2);
+            dst[b] = etc2_clamp((x * (c[1][2] - c[0][2]) +
+                                 y * (c[2][2] - c[0][2]) +
+                                 4 * c[0][2] + 2) >> 2);
+            dst[3] = 255;
+            dst += 4;
+         }
+      }
+      return;
+   }
+
+   for (blk = 0; blk < 2; blk++) {
+      for (idx = 0; idx < 4; idx++) {
+         uint8_t *color = palette[blk][idx];
+
+         if (punchthrough_alpha && !block->opaque && idx == 2) {
+            color[0] = color[1] = color[2] = color[3] = 0;
+         }
+         else if (block->is_t_mode || block->is_h_mode) {
+            color[r] = block->paint_colors[idx][0];
+            color[1] = block->paint_colors[idx][1];
+            color[b] = block->paint_colors[idx][2];
+            color[3] = 255;
+         }
+         else {
+            const uint8_t *base_color = block->base_colors[blk];
+            const int modifier = block->modifier_tables[blk][idx];
+
+            color[r] = etc2_clamp(base_color[0] + modifier);
+            color[1] = etc2_clamp(base_color[1] + modifier);
+            color[b] = etc2_clamp(base_color[2] + modifier);
+            color[3] = 255;
+         }
+      }
+   }
+
+   /* T and H mode have a single palette, and flipped is only parsed for
+    * individual and differential mode, so the subblock split is harmless.
+    */
+   etc1_write_block(palette, (uint32_t) block->pixel_indices[0],
+                    block->flipped, dst_row, dst_stride, width, height);
+}
+
+/**
+ * Decode a whole RGB8 + EAC alpha block.
+ */
+static void
+etc2_rgba8_decode_block(const struct etc2_block *block,
+                        uint8_t *dst_row, unsigned dst_stride,
+                        unsigned width, unsigned height, GLboolean bgra)
+{
+   unsigned i, j;
+
+   etc2_rgb8_decode_block(block, dst_row, dst_stride, width, height,
+                          false /* punchthrough_alpha */, bgra);
+
+   for (j = 0; j < height; j++) {
+      uint8_t *dst = dst_row + j * dst_stride;
+
+      for (i = 0; i < width; i++) {
+         etc2_alpha8_fetch_texel(block, i, j, dst);
+         dst += 4;
+      }
+   }
+}
+
 static void
 etc2_unpack_rgb8(uint8_t *dst_row,
                  unsigned dst_stride,
@@ -675,7 +772,7 @@ etc2_unpack_rgb8(uint8_t *dst_row,
 {
    const unsigned bw = 4, bh = 4, bs = 8, comps = 4;
    struct etc2_block block;
-   unsigned x, y, i, j;
+   unsigned x, y;
 
    for (y = 0; y < height; y += bh) {
       const uint8_t *src = src_row;
@@ -683,17 +780,9 @@ etc2_unpack_rgb8(uint8_t *dst_row,
       for (x = 0; x < width; x+= bw) {
          etc2_rgb8_parse_block(&block, src,
                                false /* punchthrough_alpha */);
-
-         for (j = 0; j < bh; j++) {
-            uint8_t *dst = dst_row + (y + j) * dst_stride + x * comps;
-            for (i = 0; i < bw; i++) {
-               etc2_rgb8_fetch_texel(&block, i, j, dst,
-                                     false /* punchthrough_alpha */);
-               dst[3] = 255;
-               dst += comps;
-            }
-         }
-
+         etc2_rgb8_decode_block(&block, dst_row + y * dst_stride + x * comps,
+                                dst_stride, MIN2(bw, width - x),
+                                MIN2(bh, height - y), false, false);
          src += bs;
       }
 
@@ -711,8 +800,7 @@ etc2_unpack_srgb8(uint8_t *dst_row,
 {
    const unsigned bw = 4, bh = 4, bs = 8, comps = 4;
    struct etc2_block block;
-   unsigned x, y, i, j;
-   uint8_t tmp;
+   unsigned x, y;
 
    for (y = 0; y < height; y += bh) {
       const uint8_t *src = src_row;
@@ -720,21 +808,9 @@ etc2_unpack_srgb8(uint8_t *dst_row,
       for (x = 0; x < width; x+= bw) {
          etc2_rgb8_parse_block(&block, src,
                                false /* punchthrough_alpha */);
-
-         for (j = 0; j < bh; j++) {
-            uint8_t *dst = dst_row + (y + j) * dst_stride + x * comps;
-            for (i = 0; i < bw; i++) {
-               etc2_rgb8_fetch_texel(&block, i, j, dst,
-                                     false /* punchthrough_alpha */);
-               /* Convert to MESA_FORMAT_SARGB8 */
-               tmp = dst[0];
-               dst[0] = dst[2];
-               dst[2] = tmp;
-               dst[3] = 255;
-
-               dst += comps;
-            }
-         }
+         etc2_rgb8_decode_block(&block, dst_row + y * dst_stride + x * comps,
+                                dst_stride, MIN2(bw, width - x),
+                                MIN2(bh, height - y), false, true);
          src += bs;
       }
 
@@ -756,21 +832,16 @@ etc2_unpack_rgba8(uint8_t *dst_row,
    */
    const unsigned bw = 4, bh = 4, bs = 16, comps = 4;
    struct etc2_block block;
-   unsigned x, y, i, j;
+   unsigned x, y;
 
    for (y = 0; y < height; y += bh) {
       const uint8_t *src = src_row;
 
       for (x = 0; x < width; x+= bw) {
          etc2_rgba8_parse_block(&block, src);
-
-         for (j = 0; j < bh; j++) {
-            uint8_t *dst = dst_row + (y + j) * dst_stride + x * comps;
-            for (i = 0; i < bw; i++) {
-               etc2_rgba8_fetch_texel(&block, i, j, dst);
-               dst += comps;
-            }
-         }
+         etc2_rgba8_decode_block(&block, dst_row + y * dst_stride + x * comps,
+                                 dst_stride, MIN2(bw, width - x),
+                                 MIN2(bh, height - y), false);
          src += bs;
       }
 
@@ -792,29 +863,16 @@ etc2_unpack_srgb8_alpha8(uint8_t *dst_row,
     */
    const unsigned bw = 4, bh = 4, bs = 16, comps = 4;
    struct etc2_block block;
-   unsigned x, y, i, j;
-   uint8_t tmp;
+   unsigned x, y;
 
    for (y = 0; y < height; y += bh) {
       const uint8_t *src = src_row;
 
       for (x = 0; x < width; x+= bw) {
          etc2_rgba8_parse_block(&block, src);
-
-         for (j = 0; j < bh; j++) {
-            uint8_t *dst = dst_row + (y + j) * dst_stride + x * comps;
-            for (i = 0; i < bw; i++) {
-               etc2_rgba8_fetch_texel(&block, i, j, dst);
-
-               /* Convert to MESA_FORMAT_SARGB8 */
-               tmp = dst[0];
-               dst[0] = dst[2];
-               dst[2] = tmp;
-               dst[3] = dst[3];
-
-               dst += comps;
-            }
-         }
+         etc2_rgba8_decode_block(&block, dst_row + y * dst_stride + x * comps,
+                                 dst_stride, MIN2(bw, width - x),
+                                 MIN2(bh, height - y), true);
          src += bs;
       }
 
@@ -999,7 +1057,7 @@ etc2_unpack_rgb8_punchthrough_alpha1(uint8_t *dst_row,
 {
    const unsigned bw = 4, bh = 4, bs = 8, comps = 4;
    struct etc2_block block;
-   unsigned x, y, i, j;
+   unsigned x, y;
 
    for (y = 0; y < height; y += bh) {
       const uint8_t *src = src_row;
@@ -1007,15 +1065,9 @@ etc2_unpack_rgb8_punchthrough_alpha1(uint8_t *dst_row,
       for (x = 0; x < width; x+= bw) {
          etc2_rgb8_parse_block(&block, src,
                                true /* punchthrough_alpha */);
-         for (j = 0; j < bh; j++) {
-            uint8_t *dst = dst_row + (y + j) * dst_stride + x * comps;
-            for (i = 0; i < bw; i++) {
-               etc2_rgb8_fetch_texel(&block, i, j, dst,
-                                     true /* punchthrough_alpha */);
-               dst += comps;
-            }
-         }
-
+         etc2_rgb8_decode_block(&block, dst_row + y * dst_stride + x * comps,
+                                dst_stride, MIN2(bw, width - x),
+                                MIN2(bh, height - y), true, false);
          src += bs;
       }
 
@@ -1033,8 +1085,7 @@ etc2_unpack_srgb8_punchthrough_alpha1(uint8_t *dst_row,
 {
    const unsigned bw = 4, bh = 4, bs = 8, comps = 4;
    struct etc2_block block;
-   unsigned x, y, i, j;
-   uint8_t tmp;
+   unsigned x, y;
 
    for (y = 0; y < height; y += bh) {
       const uint8_t *src = src_row;
@@ -1042,21 +1093,9 @@ etc2_unpack_srgb8_punchthrough_alpha1(uint8_t *dst_row,
       for (x = 0; x < width; x+= bw) {
          etc2_rgb8_parse_block(&block, src,
                                true /* punchthrough_alpha */);
-         for (j = 0; j < bh; j++) {
-            uint8_t *dst = dst_row + (y + j) * dst_stride + x * comps;
-            for (i = 0; i < bw; i++) {
-               etc2_rgb8_fetch_texel(&block, i, j, dst,
-                                     true /* punchthrough_alpha */);
-               /* Convert to MESA_FORMAT_SARGB8 */
-               tmp = dst[0];
-               dst[0] = dst[2];
-               dst[2] = tmp;
-               dst[3] = dst[3];
-
-               dst += comps;
-            }
-         }
-
+         etc2_rgb8_decode_block(&block, dst_row + y * dst_stride + x * comps,
+                                dst_stride, MIN2(bw, width - x),
+                                MIN2(bh, height - y), true, true);
          src += bs;
       }
 
@@ -135,6 +135,62 @@ TAG(etc1_fetch_texel)(const struct TAG(etc1_block) *block,
    dst[2] = TAG(etc1_clamp)(base_color[2], modifier);
 }
 
+/**
+ * Expand the two subblocks of a parsed block into their four RGBA colors
+ * each, so that decoding a whole block clamps 24 values instead of 48.
+ */
+static void
+TAG(etc1_build_palette)(const struct TAG(etc1_block) *block,
+                        UINT8_TYPE palette[2][4][4])
+{
+   int blk, idx;
+
+   for (blk = 0; blk < 2; blk++) {
+      for (idx = 0; idx < 4; idx++) {
+         const int modifier = block->modifier_tables[blk][idx];
+
+         palette[blk][idx][0] =
+            TAG(etc1_clamp)(block->base_colors[blk][0], modifier);
+         palette[blk][idx][1] =
+            TAG(etc1_clamp)(block->base_colors[blk][1], modifier);
+         palette[blk][idx][2] =
+            TAG(etc1_clamp)(block->base_colors[blk][2], modifier);
+         palette[blk][idx][3] = 255;
+      }
+   }
+}
+
+/**
+ * Write the top-left width x height texels of a block whose texels are
+ * selected from a per-subblock palette by the ETC1 index layout.
+ */
+static void
+TAG(etc1_write_block)(UINT8_TYPE palette[2][4][4],
+                      uint32_t pixel_indices, int flipped,
+                      UINT8_TYPE *dst_row, unsigned dst_stride,
+                      unsigned width, unsigned height)
+{
+   unsigned i, j;
+
+   for (j = 0; j < height; j++) {
+      UINT8_TYPE *dst = dst_row + j * dst_stride;
+
+      for (i = 0; i < width; i++) {
+         const int bit = j + i * 4;
+         const int idx = ((pixel_indices >> (15 + bit)) & 0x2) |
+                         ((pixel_indices >>      (bit)) & 0x1);
+         const int blk = flipped ? (j >= 2) : (i >= 2);
+         const UINT8_TYPE *color = palette[blk][idx];
+
+         dst[0] = color[0];
+         dst[1] = color[1];
+         dst[2] = color[2];
+         dst[3] = color[3];
+         dst += 4;
+      }
+   }
+}
+
 static void
 etc1_unpack_rgba8888(uint8_t *dst_row,
                      unsigned dst_stride,
@@ -145,22 +201,18 @@ etc1_unpack_rgba8888(uint8_t *dst_row,
 {
    const unsigned bw = 4, bh = 4, bs = 8, comps = 4;
    struct etc1_block block;
-   unsigned x, y, i, j;
+   uint8_t palette[2][4][4];
+   unsigned x, y;
 
    for (y = 0; y < height; y += bh) {
       const uint8_t *src = src_row;
 
       for (x = 0; x < width; x+= bw) {
          etc1_parse_block(&block, src);
-
-         for (j = 0; j < MIN2(bh, height - y); j++) {
-            uint8_t *dst = dst_row + (y + j) * dst_stride + x * comps;
-            for (i = 0; i < MIN2(bw, width - x); i++) {
-               etc1_fetch_texel(&block, i, j, dst);
-               dst[3] = 255;
-               dst += comps;
-            }
-         }
+         etc1_build_palette(&block, palette);
+         etc1_write_block(palette, block.pixel_indices, block.flipped,
+                          dst_row + y * dst_stride + x * comps, dst_stride,
+                          MIN2(bw, width - x), MIN2(bh, height - y));
 
          src += bs;
       }
@@ -514,6 +514,26 @@ update_texgen(struct gl_context *ctx)
    }
 }
 
+/**
+ * Return the highest texture unit that the program's samplers refer to,
+ * or -1 if the program doesn't sample any texture.
+ */
+static GLint
+max_sampler_unit(const struct gl_program *prog)
+{
+   GLbitfield samplers = prog->SamplersUsed;
+   GLint maxUnit = -1;
+
+   while (samplers) {
+      const GLuint s = ffs(samplers) - 1;
+      maxUnit = MAX2(maxUnit, (GLint) prog->SamplerUnits[s]);
+      samplers &= ~(1 << s);
+   }
+
+   return maxUnit;
+}
+
+
 /**
  * \note This routine refers to derived texture matrix values to
  * compute the ENABLE_TEXMAT flags, but is only called on
@@ -525,7 +545,7 @@ update_texgen(struct gl_context *ctx)
 static void
 update_texture_state( struct gl_context *ctx )
 {
-   GLuint unit;
+   GLint unit, maxUnit;
    struct gl_program *fprog = NULL;
    struct gl_program *vprog = NULL;
    GLbitfield enabledFragUnits = 0x0;
@@ -550,7 +570,20 @@ update_texture_state( struct gl_context *ctx )
    /* TODO: only set this if there are actual changes */
    ctx->NewState |= _NEW_TEXTURE;
 
+   /* Only the units that can be used now, plus those which were enabled
+    * before and have to be turned off, need to be looked at.  That's far
+    * fewer than MaxCombinedTextureImageUnits.
+    */
+   maxUnit = ctx->Texture._MaxEnabledTexImageUnit;
+   if (vprog)
+      maxUnit = MAX2(maxUnit, max_sampler_unit(vprog));
+   if (fprog)
+      maxUnit = MAX2(maxUnit, max_sampler_unit(fprog));
+   else
+      maxUnit = MAX2(maxUnit, (GLint) ctx->Const.MaxTextureUnits - 1);
+
    ctx->Texture._EnabledUnits = 0x0;
+   ctx->Texture._MaxEnabledTexImageUnit = -1;
    ctx->Texture._GenFlags = 0x0;
    ctx->Texture._TexMatEnabled = 0x0;
    ctx->Texture._TexGenEnabled = 0x0;
@@ -558,7 +591,7 @@ update_texture_state( struct gl_context *ctx )
    /*
     * Update texture unit state.
     */
-   for (unit = 0; unit < ctx->Const.MaxCombinedTextureImageUnits; unit++) {
+   for (unit = 0; unit <= maxUnit; unit++) {
       struct gl_texture_unit *texUnit = &ctx->Texture.Unit[unit];
       GLbitfield enabledVertTargets = 0x0;
       GLbitfield enabledFragTargets = 0x0;
@@ -647,6 +680,7 @@ update_texture_state( struct gl_context *ctx )
       /* if we get here, we know this texture unit is enabled */
 
       ctx->Texture._EnabledUnits |= (1 << unit);
+      ctx->Texture._MaxEnabledTexImageUnit = unit;
 
       if (enabledFragTargets)
          enabledFragUnits |= (1 << unit);
@@ -803,6 +837,7 @@ _mesa_init_texture(struct gl_context *ctx)
    /* Texture group */
    ctx->Texture.CurrentUnit = 0;      /* multitexture */
    ctx->Texture._EnabledUnits = 0x0;
+   ctx->Texture._MaxEnabledTexImageUnit = -1;
 
    for (u = 0; u < Elements(ctx->Texture.Unit); u++)
       init_texture_unit(ctx, u);
@@ -71,6 +71,7 @@
 #include "texstore.h"
 #include "enums.h"
 #include "glformats.h"
+#include "parallel.h"
 #include "../../gallium/auxiliary/util/u_format_rgb9e5.h"
 #include "../../gallium/auxiliary/util/u_format_r11g11b10f.h"
 
@@ -706,6 +707,46 @@ swizzle_copy(GLubyte *dst, GLuint dstComponents, const GLubyte *src,
    ASSERT(srcComponents <= 4);
    ASSERT(dstComponents <= 4);
 
+   /* The common RGBA <-> BGRA and RGB -> RGBX swizzles, written with
+    * constant component positions so that the compiler can vectorize them.
+    */
+   if (dstComponents == 4) {
+      GLuint i;
+
+      if (srcComponents == 4 &&
+          map[0] == 2 && map[1] == 1 && map[2] == 0 && map[3] == 3) {
+         for (i = 0; i < count; i++) {
+            dst[4 * i + 0] = src[4 * i + 2];
+            dst[4 * i + 1] = src[4 * i + 1];
+            dst[4 * i + 2] = src[4 * i + 0];
+            dst[4 * i + 3] = src[4 * i + 3];
+         }
+         return;
+      }
+
+      if (srcComponents == 3 &&
+          map[0] == 0 && map[1] == 1 && map[2] == 2 && map[3] == ONE) {
+         for (i = 0; i < count; i++) {
+            dst[4 * i + 0] = src[3 * i + 0];
+            dst[4 * i + 1] = src[3 * i + 1];
+            dst[4 * i + 2] = src[3 * i + 2];
+            dst[4 * i + 3] = 0xff;
+         }
+         return;
+      }
+
+      if (srcComponents == 3 &&
+          map[0] == 2 && map[1] == 1 && map[2] == 0 && map[3] == ONE) {
+         for (i = 0; i < count; i++) {
+            dst[4 * i + 0] = src[3 * i + 2];
+            dst[4 * i + 1] = src[3 * i + 1];
+            dst[4 * i + 2] = src[3 * i + 0];
+            dst[4 * i + 3] = 0xff;
+         }
+         return;
+      }
+   }
+
    switch (dstComponents) {
    case 4:
       switch (srcComponents) {
@@ -2650,6 +2691,67 @@ _mesa_texstore_s8(TEXSTORE_PARAMS)
 }
 
 
+/**
+ * Store 16-bit float texels from GL_FLOAT source data, or 32-bit float
+ * texels from GL_HALF_FLOAT source data, without going through a
+ * temporary float image.  Only for sources whose components are already
+ * in the order of the texture format and need no transfer operations.
+ *
+ * \return GL_FALSE if the direct path doesn't apply.
+ */
+static GLboolean
+texstore_half_float_direct(TEXSTORE_PARAMS, GLboolean toHalf)
+{
+   const GLenum baseFormat = _mesa_get_format_base_format(dstFormat);
+   const GLint components = _mesa_components_in_format(baseFormat);
+   const GLint srcRowStride =
+      _mesa_image_row_stride(srcPacking, srcWidth, srcFormat, srcType);
+   const GLint srcImageStride =
+      _mesa_image_image_stride(srcPacking, srcWidth, srcHeight,
+                               srcFormat, srcType);
+   const GLubyte *srcImage;
+   GLint img, row, i;
+
+   if (ctx->_ImageTransferState ||
+       srcPacking->SwapBytes ||
+       srcType != (toHalf ? GL_FLOAT : GL_HALF_FLOAT_ARB) ||
+       srcFormat != baseFormat ||
+       baseInternalFormat != baseFormat ||
+       components <= 0 ||
+       _mesa_get_format_bytes(dstFormat) !=
+       components * (toHalf ? sizeof(GLhalfARB) : sizeof(GLfloat)))
+      return GL_FALSE;
+
+   srcImage = (const GLubyte *)
+      _mesa_image_address(dims, srcPacking, srcAddr, srcWidth, srcHeight,
+                          srcFormat, srcType, 0, 0, 0);
+
+   for (img = 0; img < srcDepth; img++) {
+      const GLubyte *srcRow = srcImage;
+      GLubyte *dstRow = dstSlices[img];
+      for (row = 0; row < srcHeight; row++) {
+         if (toHalf) {
+            const GLfloat *src = (const GLfloat *) srcRow;
+            GLhalfARB *dst = (GLhalfARB *) dstRow;
+            for (i = 0; i < srcWidth * components; i++)
+               dst[i] = _mesa_float_to_half(src[i]);
+         }
+         else {
+            const GLhalfARB *src = (const GLhalfARB *) srcRow;
+            GLfloat *dst = (GLfloat *) dstRow;
+            for (i = 0; i < srcWidth * components; i++)
+               dst[i] = _mesa_half_to_float(src[i]);
+         }
+         dstRow += dstRowStride;
+         srcRow += srcRowStride;
+      }
+      srcImage += srcImageStride;
+   }
+
+   return GL_TRUE;
+}
+
+
 /**
  * Store an image in any of the formats:
  *   _mesa_texformat_rgba_float32
@@ -2690,6 +2792,13 @@ _mesa_texstore_rgba_float32(TEXSTORE_PARAMS)
           baseInternalFormat == GL_RG);
    ASSERT(_mesa_get_format_bytes(dstFormat) == components * sizeof(GLfloat));
 
+   if (texstore_half_float_direct(ctx, dims, baseInternalFormat, dstFormat,
+                                  dstRowStride, dstSlices,
+                                  srcWidth, srcHeight, srcDepth,
+                                  srcFormat, srcType, srcAddr, srcPacking,
+                                  GL_FALSE))
+      return GL_TRUE;
+
    {
       /* general path */
       const GLfloat *tempImage = _mesa_make_temp_float_image(ctx, dims,
@@ -2755,6 +2864,13 @@ _mesa_texstore_rgba_float16(TEXSTORE_PARAMS)
           baseInternalFormat == GL_RG);
    ASSERT(_mesa_get_format_bytes(dstFormat) == components * sizeof(GLhalfARB));
 
+   if (texstore_half_float_direct(ctx, dims, baseInternalFormat, dstFormat,
+                                  dstRowStride, dstSlices,
+                                  srcWidth, srcHeight, srcDepth,
+                                  srcFormat, srcType, srcAddr, srcPacking,
+                                  GL_TRUE))
+      return GL_TRUE;
+
    {
       /* general path */
       const GLfloat *tempImage = _mesa_make_temp_float_image(ctx, dims,
@@ -3576,217 +3692,225 @@ _mesa_texstore_null(TEXSTORE_PARAMS)
 }
 
 
+/** StoreTexImageFunc of each format, see _mesa_init_texstore() */
+static StoreTexImageFunc texstore_funcs[MESA_FORMAT_COUNT];
+
+
+/**
+ * Fill the table of StoreTexImageFuncs.  Called once, from one_time_init(),
+ * so that the table is only read afterwards, by any thread.
+ */
+void
+_mesa_init_texstore(void)
+{
+   StoreTexImageFunc *table = texstore_funcs;
+
+   table[MESA_FORMAT_NONE] = _mesa_texstore_null;
+
+   table[MESA_FORMAT_RGBA8888] = _mesa_texstore_rgba8888;
+   table[MESA_FORMAT_RGBA8888_REV] = _mesa_texstore_rgba8888;
+   table[MESA_FORMAT_ARGB8888] = _mesa_texstore_argb8888;
+   table[MESA_FORMAT_ARGB8888_REV] = _mesa_texstore_argb8888;
+   table[MESA_FORMAT_RGBX8888] = _mesa_texstore_rgba8888;
+   table[MESA_FORMAT_RGBX8888_REV] = _mesa_texstore_rgba8888;
+   table[MESA_FORMAT_XRGB8888] = _mesa_texstore_argb8888;
+   table[MESA_FORMAT_XRGB8888_REV] = _mesa_texstore_argb8888;
+   table[MESA_FORMAT_RGB888] = _mesa_texstore_rgb888;
+   table[MESA_FORMAT_BGR888] = _mesa_texstore_bgr888;
+   table[MESA_FORMAT_RGB565] = _mesa_texstore_rgb565;
+   table[MESA_FORMAT_RGB565_REV] = _mesa_texstore_rgb565;
+   table[MESA_FORMAT_ARGB4444] = store_ubyte_texture;
+   table[MESA_FORMAT_ARGB4444_REV] = store_ubyte_texture;
+   table[MESA_FORMAT_RGBA5551] = store_ubyte_texture;
+   table[MESA_FORMAT_ARGB1555] = store_ubyte_texture;
+   table[MESA_FORMAT_ARGB1555_REV] = store_ubyte_texture;
+   table[MESA_FORMAT_AL44] = _mesa_texstore_unorm44;
+   table[MESA_FORMAT_AL88] = _mesa_texstore_unorm88;
+   table[MESA_FORMAT_AL88_REV] = _mesa_texstore_unorm88;
+   table[MESA_FORMAT_AL1616] = _mesa_texstore_unorm1616;
+   table[MESA_FORMAT_AL1616_REV] = _mesa_texstore_unorm1616;
+   table[MESA_FORMAT_RGB332] = store_ubyte_texture;
+   table[MESA_FORMAT_A8] = _mesa_texstore_unorm8;
+   table[MESA_FORMAT_A16] = _mesa_texstore_unorm16;
+   table[MESA_FORMAT_L8] = _mesa_texstore_unorm8;
+   table[MESA_FORMAT_L16] = _mesa_texstore_unorm16;
+   table[MESA_FORMAT_I8] = _mesa_texstore_unorm8;
+   table[MESA_FORMAT_I16] = _mesa_texstore_unorm16;
+   table[MESA_FORMAT_YCBCR] = _mesa_texstore_ycbcr;
+   table[MESA_FORMAT_YCBCR_REV] = _mesa_texstore_ycbcr;
+   table[MESA_FORMAT_R8] = _mesa_texstore_unorm8;
+   table[MESA_FORMAT_GR88] = _mesa_texstore_unorm88;
+   table[MESA_FORMAT_RG88] = _mesa_texstore_unorm88;
+   table[MESA_FORMAT_R16] = _mesa_texstore_unorm16;
+   table[MESA_FORMAT_GR1616] = _mesa_texstore_unorm1616;
+   table[MESA_FORMAT_RG1616] = _mesa_texstore_unorm1616;
+   table[MESA_FORMAT_ARGB2101010] = _mesa_texstore_argb2101010;
+   table[MESA_FORMAT_Z24_S8] = _mesa_texstore_z24_s8;
+   table[MESA_FORMAT_S8_Z24] = _mesa_texstore_s8_z24;
+   table[MESA_FORMAT_Z16] = _mesa_texstore_z16;
+   table[MESA_FORMAT_X8_Z24] = _mesa_texstore_x8_z24;
+   table[MESA_FORMAT_Z24_X8] = _mesa_texstore_z24_x8;
+   table[MESA_FORMAT_Z32] = _mesa_texstore_z32;
+   table[MESA_FORMAT_S8] = _mesa_texstore_s8;
+   table[MESA_FORMAT_SRGB8] = _mesa_texstore_srgb8;
+   table[MESA_FORMAT_SRGBA8] = _mesa_texstore_srgba8;
+   table[MESA_FORMAT_SARGB8] = _mesa_texstore_sargb8;
+   table[MESA_FORMAT_SL8] = _mesa_texstore_sl8;
+   table[MESA_FORMAT_SLA8] = _mesa_texstore_sla8;
+   table[MESA_FORMAT_SRGB_DXT1] = _mesa_texstore_rgb_dxt1;
+   table[MESA_FORMAT_SRGBA_DXT1] = _mesa_texstore_rgba_dxt1;
+   table[MESA_FORMAT_SRGBA_DXT3] = _mesa_texstore_rgba_dxt3;
+   table[MESA_FORMAT_SRGBA_DXT5] = _mesa_texstore_rgba_dxt5;
+   table[MESA_FORMAT_RGB_FXT1] = _mesa_texstore_rgb_fxt1;
+   table[MESA_FORMAT_RGBA_FXT1] = _mesa_texstore_rgba_fxt1;
+   table[MESA_FORMAT_RGB_DXT1] = _mesa_texstore_rgb_dxt1;
+   table[MESA_FORMAT_RGBA_DXT1] = _mesa_texstore_rgba_dxt1;
+   table[MESA_FORMAT_RGBA_DXT3] = _mesa_texstore_rgba_dxt3;
+   table[MESA_FORMAT_RGBA_DXT5] = _mesa_texstore_rgba_dxt5;
+   table[MESA_FORMAT_RGBA_FLOAT32] = _mesa_texstore_rgba_float32;
+   table[MESA_FORMAT_RGBA_FLOAT16] = _mesa_texstore_rgba_float16;
+   table[MESA_FORMAT_RGB_FLOAT32] = _mesa_texstore_rgba_float32;
+   table[MESA_FORMAT_RGB_FLOAT16] = _mesa_texstore_rgba_float16;
+   table[MESA_FORMAT_ALPHA_FLOAT32] = _mesa_texstore_rgba_float32;
+   table[MESA_FORMAT_ALPHA_FLOAT16] = _mesa_texstore_rgba_float16;
+   table[MESA_FORMAT_LUMINANCE_FLOAT32] = _mesa_texstore_rgba_float32;
+   table[MESA_FORMAT_LUMINANCE_FLOAT16] = _mesa_texstore_rgba_float16;
+   table[MESA_FORMAT_LUMINANCE_ALPHA_FLOAT32] = _mesa_texstore_rgba_float32;
+   table[MESA_FORMAT_LUMINANCE_ALPHA_FLOAT16] = _mesa_texstore_rgba_float16;
+   table[MESA_FORMAT_INTENSITY_FLOAT32] = _mesa_texstore_rgba_float32;
+   table[MESA_FORMAT_INTENSITY_FLOAT16] = _mesa_texstore_rgba_float16;
+   table[MESA_FORMAT_R_FLOAT32] = _mesa_texstore_rgba_float32;
+   table[MESA_FORMAT_R_FLOAT16] = _mesa_texstore_rgba_float16;
+   table[MESA_FORMAT_RG_FLOAT32] = _mesa_texstore_rgba_float32;
+   table[MESA_FORMAT_RG_FLOAT16] = _mesa_texstore_rgba_float16;
+   table[MESA_FORMAT_DUDV8] = _mesa_texstore_dudv8;
+   table[MESA_FORMAT_SIGNED_R8] = _mesa_texstore_snorm8;
+   table[MESA_FORMAT_SIGNED_RG88_REV] = _mesa_texstore_snorm88;
+   table[MESA_FORMAT_SIGNED_RGBX8888] = _mesa_texstore_signed_rgbx8888;
+   table[MESA_FORMAT_SIGNED_RGBA8888] = _mesa_texstore_signed_rgba8888;
+   table[MESA_FORMAT_SIGNED_RGBA8888_REV] = _mesa_texstore_signed_rgba8888;
+   table[MESA_FORMAT_SIGNED_R16] = _mesa_texstore_snorm16;
+   table[MESA_FORMAT_SIGNED_GR1616] = _mesa_texstore_snorm1616;
+   table[MESA_FORMAT_SIGNED_RGB_16] = _mesa_texstore_signed_rgba_16;
+   table[MESA_FORMAT_SIGNED_RGBA_16] = _mesa_texstore_signed_rgba_16;
+   table[MESA_FORMAT_RGBA_16] = _mesa_texstore_rgba_16;
+   table[MESA_FORMAT_RED_RGTC1] = _mesa_texstore_red_rgtc1;
+   table[MESA_FORMAT_SIGNED_RED_RGTC1] = _mesa_texstore_signed_red_rgtc1;
+   table[MESA_FORMAT_RG_RGTC2] = _mesa_texstore_rg_rgtc2;
+   table[MESA_FORMAT_SIGNED_RG_RGTC2] = _mesa_texstore_signed_rg_rgtc2;
+   table[MESA_FORMAT_L_LATC1] = _mesa_texstore_red_rgtc1;
+   table[MESA_FORMAT_SIGNED_L_LATC1] = _mesa_texstore_signed_red_rgtc1;
+   table[MESA_FORMAT_LA_LATC2] = _mesa_texstore_rg_rgtc2;
+   table[MESA_FORMAT_SIGNED_LA_LATC2] = _mesa_texstore_signed_rg_rgtc2;
+   table[MESA_FORMAT_ETC1_RGB8] = _mesa_texstore_etc1_rgb8;
+   table[MESA_FORMAT_ETC2_RGB8] = _mesa_texstore_etc2_rgb8;
+   table[MESA_FORMAT_ETC2_SRGB8] = _mesa_texstore_etc2_srgb8;
+   table[MESA_FORMAT_ETC2_RGBA8_EAC] = _mesa_texstore_etc2_rgba8_eac;
+   table[MESA_FORMAT_ETC2_SRGB8_ALPHA8_EAC] = _mesa_texstore_etc2_srgb8_alpha8_eac;
+   table[MESA_FORMAT_ETC2_R11_EAC] = _mesa_texstore_etc2_r11_eac;
+   table[MESA_FORMAT_ETC2_RG11_EAC] = _mesa_texstore_etc2_rg11_eac;
+   table[MESA_FORMAT_ETC2_SIGNED_R11_EAC] = _mesa_texstore_etc2_signed_r11_eac;
+   table[MESA_FORMAT_ETC2_SIGNED_RG11_EAC] = _mesa_texstore_etc2_signed_rg11_eac;
+   table[MESA_FORMAT_ETC2_RGB8_PUNCHTHROUGH_ALPHA1] =
+      _mesa_texstore_etc2_rgb8_punchthrough_alpha1;
+   table[MESA_FORMAT_ETC2_SRGB8_PUNCHTHROUGH_ALPHA1] =
+      _mesa_texstore_etc2_srgb8_punchthrough_alpha1;
+   table[MESA_FORMAT_SIGNED_A8] = _mesa_texstore_snorm8;
+   table[MESA_FORMAT_SIGNED_L8] = _mesa_texstore_snorm8;
+   table[MESA_FORMAT_SIGNED_AL88] = _mesa_texstore_snorm88;
+   table[MESA_FORMAT_SIGNED_I8] = _mesa_texstore_snorm8;
+   table[MESA_FORMAT_SIGNED_A16] = _mesa_texstore_snorm16;
+   table[MESA_FORMAT_SIGNED_L16] = _mesa_texstore_snorm16;
+   table[MESA_FORMAT_SIGNED_AL1616] = _mesa_texstore_snorm1616;
+   table[MESA_FORMAT_SIGNED_I16] = _mesa_texstore_snorm16;
+   table[MESA_FORMAT_RGB9_E5_FLOAT] = _mesa_texstore_rgb9_e5;
+   table[MESA_FORMAT_R11_G11_B10_FLOAT] = _mesa_texstore_r11_g11_b10f;
+   table[MESA_FORMAT_Z32_FLOAT] = _mesa_texstore_z32;
+   table[MESA_FORMAT_Z32_FLOAT_X24S8] = _mesa_texstore_z32f_x24s8;
+
+   table[MESA_FORMAT_ALPHA_UINT8] = _mesa_texstore_rgba_uint8;
+   table[MESA_FORMAT_ALPHA_UINT16] = _mesa_texstore_rgba_uint16;
+   table[MESA_FORMAT_ALPHA_UINT32] = _mesa_texstore_rgba_uint32;
+   table[MESA_FORMAT_ALPHA_INT8] = _mesa_texstore_rgba_int8;
+   table[MESA_FORMAT_ALPHA_INT16] = _mesa_texstore_rgba_int16;
+   table[MESA_FORMAT_ALPHA_INT32] = _mesa_texstore_rgba_int32;
+
+   table[MESA_FORMAT_INTENSITY_UINT8] = _mesa_texstore_rgba_uint8;
+   table[MESA_FORMAT_INTENSITY_UINT16] = _mesa_texstore_rgba_uint16;
+   table[MESA_FORMAT_INTENSITY_UINT32] = _mesa_texstore_rgba_uint32;
+   table[MESA_FORMAT_INTENSITY_INT8] = _mesa_texstore_rgba_int8;
+   table[MESA_FORMAT_INTENSITY_INT16] = _mesa_texstore_rgba_int16;
+   table[MESA_FORMAT_INTENSITY_INT32] = _mesa_texstore_rgba_int32;
+
+   table[MESA_FORMAT_LUMINANCE_UINT8] = _mesa_texstore_rgba_uint8;
+   table[MESA_FORMAT_LUMINANCE_UINT16] = _mesa_texstore_rgba_uint16;
+   table[MESA_FORMAT_LUMINANCE_UINT32] = _mesa_texstore_rgba_uint32;
+   table[MESA_FORMAT_LUMINANCE_INT8] = _mesa_texstore_rgba_int8;
+   table[MESA_FORMAT_LUMINANCE_INT16] = _mesa_texstore_rgba_int16;
+   table[MESA_FORMAT_LUMINANCE_INT32] = _mesa_texstore_rgba_int32;
+
+   table[MESA_FORMAT_LUMINANCE_ALPHA_UINT8] = _mesa_texstore_rgba_uint8;
+   table[MESA_FORMAT_LUMINANCE_ALPHA_UINT16] = _mesa_texstore_rgba_uint16;
+   table[MESA_FORMAT_LUMINANCE_ALPHA_UINT32] = _mesa_texstore_rgba_uint32;
+   table[MESA_FORMAT_LUMINANCE_ALPHA_INT8] = _mesa_texstore_rgba_int8;
+   table[MESA_FORMAT_LUMINANCE_ALPHA_INT16] = _mesa_texstore_rgba_int16;
+   table[MESA_FORMAT_LUMINANCE_ALPHA_INT32] = _mesa_texstore_rgba_int32;
+
+   table[MESA_FORMAT_R_INT8] = _mesa_texstore_rgba_int8;
+   table[MESA_FORMAT_RG_INT8] = _mesa_texstore_rgba_int8;
+   table[MESA_FORMAT_RGB_INT8] = _mesa_texstore_rgba_int8;
+   table[MESA_FORMAT_RGBA_INT8] = _mesa_texstore_rgba_int8;
+   table[MESA_FORMAT_R_INT16] = _mesa_texstore_rgba_int16;
+   table[MESA_FORMAT_RG_INT16] = _mesa_texstore_rgba_int16;
+   table[MESA_FORMAT_RGB_INT16] = _mesa_texstore_rgba_int16;
+   table[MESA_FORMAT_RGBA_INT16] = _mesa_texstore_rgba_int16;
+   table[MESA_FORMAT_R_INT32] = _mesa_texstore_rgba_int32;
+   table[MESA_FORMAT_RG_INT32] = _mesa_texstore_rgba_int32;
+   table[MESA_FORMAT_RGB_INT32] = _mesa_texstore_rgba_int32;
+   table[MESA_FORMAT_RGBA_INT32] = _mesa_texstore_rgba_int32;
+
+   table[MESA_FORMAT_R_UINT8] = _mesa_texstore_rgba_uint8;
+   table[MESA_FORMAT_RG_UINT8] = _mesa_texstore_rgba_uint8;
+   table[MESA_FORMAT_RGB_UINT8] = _mesa_texstore_rgba_uint8;
+   table[MESA_FORMAT_RGBA_UINT8] = _mesa_texstore_rgba_uint8;
+   table[MESA_FORMAT_R_UINT16] = _mesa_texstore_rgba_uint16;
+   table[MESA_FORMAT_RG_UINT16] = _mesa_texstore_rgba_uint16;
+   table[MESA_FORMAT_RGB_UINT16] = _mesa_texstore_rgba_uint16;
+   table[MESA_FORMAT_RGBA_UINT16] = _mesa_texstore_rgba_uint16;
+   table[MESA_FORMAT_R_UINT32] = _mesa_texstore_rgba_uint32;
+   table[MESA_FORMAT_RG_UINT32] = _mesa_texstore_rgba_uint32;
+   table[MESA_FORMAT_RGB_UINT32] = _mesa_texstore_rgba_uint32;
+   table[MESA_FORMAT_RGBA_UINT32] = _mesa_texstore_rgba_uint32;
+
+   table[MESA_FORMAT_ARGB2101010_UINT] = _mesa_texstore_argb2101010_uint;
+   table[MESA_FORMAT_ABGR2101010_UINT] = _mesa_texstore_abgr2101010_uint;
+
+   table[MESA_FORMAT_XRGB4444_UNORM] = store_ubyte_texture;
+   table[MESA_FORMAT_XRGB1555_UNORM] = store_ubyte_texture;
+   table[MESA_FORMAT_XBGR8888_SNORM] = _mesa_texstore_signed_rgbx8888;
+   table[MESA_FORMAT_XBGR8888_SRGB] = _mesa_texstore_srgba8;
+   table[MESA_FORMAT_XBGR8888_UINT] = _mesa_texstore_rgba_uint8;
+   table[MESA_FORMAT_XBGR8888_SINT] = _mesa_texstore_rgba_int8;
+   table[MESA_FORMAT_XRGB2101010_UNORM] = _mesa_texstore_argb2101010;
+   table[MESA_FORMAT_XBGR16161616_UNORM] = _mesa_texstore_rgba_16;
+   table[MESA_FORMAT_XBGR16161616_SNORM] = _mesa_texstore_signed_rgba_16;
+   table[MESA_FORMAT_XBGR16161616_FLOAT] = _mesa_texstore_rgba_float16;
+   table[MESA_FORMAT_XBGR16161616_UINT] = _mesa_texstore_rgba_uint16;
+   table[MESA_FORMAT_XBGR16161616_SINT] = _mesa_texstore_rgba_int16;
+   table[MESA_FORMAT_XBGR32323232_FLOAT] = _mesa_texstore_rgba_float32;
+   table[MESA_FORMAT_XBGR32323232_UINT] = _mesa_texstore_rgba_uint32;
+   table[MESA_FORMAT_XBGR32323232_SINT] = _mesa_texstore_rgba_int32;
+}
+
+
 /**
  * Return the StoreTexImageFunc pointer to store an image in the given format.
  */
 static StoreTexImageFunc
 _mesa_get_texstore_func(gl_format format)
 {
-   static StoreTexImageFunc table[MESA_FORMAT_COUNT];
-   static GLboolean initialized = GL_FALSE;
-
-   if (!initialized) {
-      table[MESA_FORMAT_NONE] = _mesa_texstore_null;
-
-      table[MESA_FORMAT_RGBA8888] = _mesa_texstore_rgba8888;
-      table[MESA_FORMAT_RGBA8888_REV] = _mesa_texstore_rgba8888;
-      table[MESA_FORMAT_ARGB8888] = _mesa_texstore_argb8888;
-      table[MESA_FORMAT_ARGB8888_REV] = _mesa_texstore_argb8888;
-      table[MESA_FORMAT_RGBX8888] = _mesa_texstore_rgba8888;
-      table[MESA_FORMAT_RGBX8888_REV] = _mesa_texstore_rgba8888;
-      table[MESA_FORMAT_XRGB8888] = _mesa_texstore_argb8888;
-      table[MESA_FORMAT_XRGB8888_REV] = _mesa_texstore_argb8888;
-      table[MESA_FORMAT_RGB888] = _mesa_texstore_rgb888;
-      table[MESA_FORMAT_BGR888] = _mesa_texstore_bgr888;
-      table[MESA_FORMAT_RGB565] = _mesa_texstore_rgb565;
-      table[MESA_FORMAT_RGB565_REV] = _mesa_texstore_rgb565;
-      table[MESA_FORMAT_ARGB4444] = store_ubyte_texture;
-      table[MESA_FORMAT_ARGB4444_REV] = store_ubyte_texture;
-      table[MESA_FORMAT_RGBA5551] = store_ubyte_texture;
-      table[MESA_FORMAT_ARGB1555] = store_ubyte_texture;
-      table[MESA_FORMAT_ARGB1555_REV] = store_ubyte_texture;
-      table[MESA_FORMAT_AL44] = _mesa_texstore_unorm44;
-      table[MESA_FORMAT_AL88] = _mesa_texstore_unorm88;
-      table[MESA_FORMAT_AL88_REV] = _mesa_texstore_unorm88;
-      table[MESA_FORMAT_AL1616] = _mesa_texstore_unorm1616;
-      table[MESA_FORMAT_AL1616_REV] = _mesa_texstore_unorm1616;
-      table[MESA_FORMAT_RGB332] = store_ubyte_texture;
-      table[MESA_FORMAT_A8] = _mesa_texstore_unorm8;
-      table[MESA_FORMAT_A16] = _mesa_texstore_unorm16;
-      table[MESA_FORMAT_L8] = _mesa_texstore_unorm8;
-      table[MESA_FORMAT_L16] = _mesa_texstore_unorm16;
-      table[MESA_FORMAT_I8] = _mesa_texstore_unorm8;
-      table[MESA_FORMAT_I16] = _mesa_texstore_unorm16;
-      table[MESA_FORMAT_YCBCR] = _mesa_texstore_ycbcr;
-      table[MESA_FORMAT_YCBCR_REV] = _mesa_texstore_ycbcr;
-      table[MESA_FORMAT_R8] = _mesa_texstore_unorm8;
-      table[MESA_FORMAT_GR88] = _mesa_texstore_unorm88;
-      table[MESA_FORMAT_RG88] = _mesa_texstore_unorm88;
-      table[MESA_FORMAT_R16] = _mesa_texstore_unorm16;
-      table[MESA_FORMAT_GR1616] = _mesa_texstore_unorm1616;
-      table[MESA_FORMAT_RG1616] = _mesa_texstore_unorm1616;
-      table[MESA_FORMAT_ARGB2101010] = _mesa_texstore_argb2101010;
-      table[MESA_FORMAT_Z24_S8] = _mesa_texstore_z24_s8;
-      table[MESA_FORMAT_S8_Z24] = _mesa_texstore_s8_z24;
-      table[MESA_FORMAT_Z16] = _mesa_texstore_z16;
-      table[MESA_FORMAT_X8_Z24] = _mesa_texstore_x8_z24;
-      table[MESA_FORMAT_Z24_X8] = _mesa_texstore_z24_x8;
-      table[MESA_FORMAT_Z32] = _mesa_texstore_z32;
-      table[MESA_FORMAT_S8] = _mesa_texstore_s8;
-      table[MESA_FORMAT_SRGB8] = _mesa_texstore_srgb8;
-      table[MESA_FORMAT_SRGBA8] = _mesa_texstore_srgba8;
-      table[MESA_FORMAT_SARGB8] = _mesa_texstore_sargb8;
-      table[MESA_FORMAT_SL8] = _mesa_texstore_sl8;
-      table[MESA_FORMAT_SLA8] = _mesa_texstore_sla8;
-      table[MESA_FORMAT_SRGB_DXT1] = _mesa_texstore_rgb_dxt1;
-      table[MESA_FORMAT_SRGBA_DXT1] = _mesa_texstore_rgba_dxt1;
-      table[MESA_FORMAT_SRGBA_DXT3] = _mesa_texstore_rgba_dxt3;
-      table[MESA_FORMAT_SRGBA_DXT5] = _mesa_texstore_rgba_dxt5;
-      table[MESA_FORMAT_RGB_FXT1] = _mesa_texstore_rgb_fxt1;
-      table[MESA_FORMAT_RGBA_FXT1] = _mesa_texstore_rgba_fxt1;
-      table[MESA_FORMAT_RGB_DXT1] = _mesa_texstore_rgb_dxt1;
-      table[MESA_FORMAT_RGBA_DXT1] = _mesa_texstore_rgba_dxt1;
-      table[MESA_FORMAT_RGBA_DXT3] = _mesa_texstore_rgba_dxt3;
-      table[MESA_FORMAT_RGBA_DXT5] = _mesa_texstore_rgba_dxt5;
-      table[MESA_FORMAT_RGBA_FLOAT32] = _mesa_texstore_rgba_float32;
-      table[MESA_FORMAT_RGBA_FLOAT16] = _mesa_texstore_rgba_float16;
-      table[MESA_FORMAT_RGB_FLOAT32] = _mesa_texstore_rgba_float32;
-      table[MESA_FORMAT_RGB_FLOAT16] = _mesa_texstore_rgba_float16;
-      table[MESA_FORMAT_ALPHA_FLOAT32] = _mesa_texstore_rgba_float32;
-      table[MESA_FORMAT_ALPHA_FLOAT16] = _mesa_texstore_rgba_float16;
-      table[MESA_FORMAT_LUMINANCE_FLOAT32] = _mesa_texstore_rgba_float32;
-      table[MESA_FORMAT_LUMINANCE_FLOAT16] = _mesa_texstore_rgba_float16;
-      table[MESA_FORMAT_LUMINANCE_ALPHA_FLOAT32] = _mesa_texstore_rgba_float32;
-      table[MESA_FORMAT_LUMINANCE_ALPHA_FLOAT16] = _mesa_texstore_rgba_float16;
-      table[MESA_FORMAT_INTENSITY_FLOAT32] = _mesa_texstore_rgba_float32;
-      table[MESA_FORMAT_INTENSITY_FLOAT16] = _mesa_texstore_rgba_float16;
-      table[MESA_FORMAT_R_FLOAT32] = _mesa_texstore_rgba_float32;
-      table[MESA_FORMAT_R_FLOAT16] = _mesa_texstore_rgba_float16;
-      table[MESA_FORMAT_RG_FLOAT32] = _mesa_texstore_rgba_float32;
-      table[MESA_FORMAT_RG_FLOAT16] = _mesa_texstore_rgba_float16;
-      table[MESA_FORMAT_DUDV8] = _mesa_texstore_dudv8;
-      table[MESA_FORMAT_SIGNED_R8] = _mesa_texstore_snorm8;
-      table[MESA_FORMAT_SIGNED_RG88_REV] = _mesa_texstore_snorm88;
-      table[MESA_FORMAT_SIGNED_RGBX8888] = _mesa_texstore_signed_rgbx8888;
-      table[MESA_FORMAT_SIGNED_RGBA8888] = _mesa_texstore_signed_rgba8888;
-      table[MESA_FORMAT_SIGNED_RGBA8888_REV] = _mesa_texstore_signed_rgba8888;
-      table[MESA_FORMAT_SIGNED_R16] = _mesa_texstore_snorm16;
-      table[MESA_FORMAT_SIGNED_GR1616] = _mesa_texstore_snorm1616;
-      table[MESA_FORMAT_SIGNED_RGB_16] = _mesa_texstore_signed_rgba_16;
-      table[MESA_FORMAT_SIGNED_RGBA_16] = _mesa_texstore_signed_rgba_16;
-      table[MESA_FORMAT_RGBA_16] = _mesa_texstore_rgba_16;
-      table[MESA_FORMAT_RED_RGTC1] = _mesa_texstore_red_rgtc1;
-      table[MESA_FORMAT_SIGNED_RED_RGTC1] = _mesa_texstore_signed_red_rgtc1;
-      table[MESA_FORMAT_RG_RGTC2] = _mesa_texstore_rg_rgtc2;
-      table[MESA_FORMAT_SIGNED_RG_RGTC2] = _mesa_texstore_signed_rg_rgtc2;
-      table[MESA_FORMAT_L_LATC1] = _mesa_texstore_red_rgtc1;
-      table[MESA_FORMAT_SIGNED_L_LATC1] = _mesa_texstore_signed_red_rgtc1;
-      table[MESA_FORMAT_LA_LATC2] = _mesa_texstore_rg_rgtc2;
-      table[MESA_FORMAT_SIGNED_LA_LATC2] = _mesa_texstore_signed_rg_rgtc2;
-      table[MESA_FORMAT_ETC1_RGB8] = _mesa_texstore_etc1_rgb8;
-      table[MESA_FORMAT_ETC2_RGB8] = _mesa_texstore_etc2_rgb8;
-      table[MESA_FORMAT_ETC2_SRGB8] = _mesa_texstore_etc2_srgb8;
-      table[MESA_FORMAT_ETC2_RGBA8_EAC] = _mesa_texstore_etc2_rgba8_eac;
-      table[MESA_FORMAT_ETC2_SRGB8_ALPHA8_EAC] = _mesa_texstore_etc2_srgb8_alpha8_eac;
-      table[MESA_FORMAT_ETC2_R11_EAC] = _mesa_texstore_etc2_r11_eac;
-      table[MESA_FORMAT_ETC2_RG11_EAC] = _mesa_texstore_etc2_rg11_eac;
-      table[MESA_FORMAT_ETC2_SIGNED_R11_EAC] = _mesa_texstore_etc2_signed_r11_eac;
-      table[MESA_FORMAT_ETC2_SIGNED_RG11_EAC] = _mesa_texstore_etc2_signed_rg11_eac;
-      table[MESA_FORMAT_ETC2_RGB8_PUNCHTHROUGH_ALPHA1] =
-         _mesa_texstore_etc2_rgb8_punchthrough_alpha1;
-      table[MESA_FORMAT_ETC2_SRGB8_PUNCHTHROUGH_ALPHA1] =
-         _mesa_texstore_etc2_srgb8_punchthrough_alpha1;
-      table[MESA_FORMAT_SIGNED_A8] = _mesa_texstore_snorm8;
-      table[MESA_FORMAT_SIGNED_L8] = _mesa_texstore_snorm8;
-      table[MESA_FORMAT_SIGNED_AL88] = _mesa_texstore_snorm88;
-      table[MESA_FORMAT_SIGNED_I8] = _mesa_texstore_snorm8;
-      table[MESA_FORMAT_SIGNED_A16] = _mesa_texstore_snorm16;
-      table[MESA_FORMAT_SIGNED_L16] = _mesa_texstore_snorm16;
-      table[MESA_FORMAT_SIGNED_AL1616] = _mesa_texstore_snorm1616;
-      table[MESA_FORMAT_SIGNED_I16] = _mesa_texstore_snorm16;
-      table[MESA_FORMAT_RGB9_E5_FLOAT] = _mesa_texstore_rgb9_e5;
-      table[MESA_FORMAT_R11_G11_B10_FLOAT] = _mesa_texstore_r11_g11_b10f;
-      table[MESA_FORMAT_Z32_FLOAT] = _mesa_texstore_z32;
-      table[MESA_FORMAT_Z32_FLOAT_X24S8] = _mesa_texstore_z32f_x24s8;
-
-      table[MESA_FORMAT_ALPHA_UINT8] = _mesa_texstore_rgba_uint8;
-      table[MESA_FORMAT_ALPHA_UINT16] = _mesa_texstore_rgba_uint16;
-      table[MESA_FORMAT_ALPHA_UINT32] = _mesa_texstore_rgba_uint32;
-      table[MESA_FORMAT_ALPHA_INT8] = _mesa_texstore_rgba_int8;
-      table[MESA_FORMAT_ALPHA_INT16] = _mesa_texstore_rgba_int16;
-      table[MESA_FORMAT_ALPHA_INT32] = _mesa_texstore_rgba_int32;
-
-      table[MESA_FORMAT_INTENSITY_UINT8] = _mesa_texstore_rgba_uint8;
-      table[MESA_FORMAT_INTENSITY_UINT16] = _mesa_texstore_rgba_uint16;
-      table[MESA_FORMAT_INTENSITY_UINT32] = _mesa_texstore_rgba_uint32;
-      table[MESA_FORMAT_INTENSITY_INT8] = _mesa_texstore_rgba_int8;
-      table[MESA_FORMAT_INTENSITY_INT16] = _mesa_texstore_rgba_int16;
-      table[MESA_FORMAT_INTENSITY_INT32] = _mesa_texstore_rgba_int32;
-
-      table[MESA_FORMAT_LUMINANCE_UINT8] = _mesa_texstore_rgba_uint8;
-      table[MESA_FORMAT_LUMINANCE_UINT16] = _mesa_texstore_rgba_uint16;
-      table[MESA_FORMAT_LUMINANCE_UINT32] = _mesa_texstore_rgba_uint32;
-      table[MESA_FORMAT_LUMINANCE_INT8] = _mesa_texstore_rgba_int8;
-      table[MESA_FORMAT_LUMINANCE_INT16] = _mesa_texstore_rgba_int16;
-      table[MESA_FORMAT_LUMINANCE_INT32] = _mesa_texstore_rgba_int32;
-
-      table[MESA_FORMAT_LUMINANCE_ALPHA_UINT8] = _mesa_texstore_rgba_uint8;
-      table[MESA_FORMAT_LUMINANCE_ALPHA_UINT16] = _mesa_texstore_rgba_uint16;
-      table[MESA_FORMAT_LUMINANCE_ALPHA_UINT32] = _mesa_texstore_rgba_uint32;
-      table[MESA_FORMAT_LUMINANCE_ALPHA_INT8] = _mesa_texstore_rgba_int8;
-      table[MESA_FORMAT_LUMINANCE_ALPHA_INT16] = _mesa_texstore_rgba_int16;
-      table[MESA_FORMAT_LUMINANCE_ALPHA_INT32] = _mesa_texstore_rgba_int32;
-
-      table[MESA_FORMAT_R_INT8] = _mesa_texstore_rgba_int8;
-      table[MESA_FORMAT_RG_INT8] = _mesa_texstore_rgba_int8;
-      table[MESA_FORMAT_RGB_INT8] = _mesa_texstore_rgba_int8;
-      table[MESA_FORMAT_RGBA_INT8] = _mesa_texstore_rgba_int8;
-      table[MESA_FORMAT_R_INT16] = _mesa_texstore_rgba_int16;
-      table[MESA_FORMAT_RG_INT16] = _mesa_texstore_rgba_int16;
-      table[MESA_FORMAT_RGB_INT16] = _mesa_texstore_rgba_int16;
-      table[MESA_FORMAT_RGBA_INT16] = _mesa_texstore_rgba_int16;
-      table[MESA_FORMAT_R_INT32] = _mesa_texstore_rgba_int32;
-      table[MESA_FORMAT_RG_INT32] = _mesa_texstore_rgba_int32;
-      table[MESA_FORMAT_RGB_INT32] = _mesa_texstore_rgba_int32;
-      table[MESA_FORMAT_RGBA_INT32] = _mesa_texstore_rgba_int32;
-
-      table[MESA_FORMAT_R_UINT8] = _mesa_texstore_rgba_uint8;
-      table[MESA_FORMAT_RG_UINT8] = _mesa_texstore_rgba_uint8;
-      table[MESA_FORMAT_RGB_UINT8] = _mesa_texstore_rgba_uint8;
-      table[MESA_FORMAT_RGBA_UINT8] = _mesa_texstore_rgba_uint8;
-      table[MESA_FORMAT_R_UINT16] = _mesa_texstore_rgba_uint16;
-      table[MESA_FORMAT_RG_UINT16] = _mesa_texstore_rgba_uint16;
-      table[MESA_FORMAT_RGB_UINT16] = _mesa_texstore_rgba_uint16;
-      table[MESA_FORMAT_RGBA_UINT16] = _mesa_texstore_rgba_uint16;
-      table[MESA_FORMAT_R_UINT32] = _mesa_texstore_rgba_uint32;
-      table[MESA_FORMAT_RG_UINT32] = _mesa_texstore_rgba_uint32;
-      table[MESA_FORMAT_RGB_UINT32] = _mesa_texstore_rgba_uint32;
-      table[MESA_FORMAT_RGBA_UINT32] = _mesa_texstore_rgba_uint32;
-
-      table[MESA_FORMAT_ARGB2101010_UINT] = _mesa_texstore_argb2101010_uint;
-      table[MESA_FORMAT_ABGR2101010_UINT] = _mesa_texstore_abgr2101010_uint;
-
-      table[MESA_FORMAT_XRGB4444_UNORM] = store_ubyte_texture;
-      table[MESA_FORMAT_XRGB1555_UNORM] = store_ubyte_texture;
-      table[MESA_FORMAT_XBGR8888_SNORM] = _mesa_texstore_signed_rgbx8888;
-      table[MESA_FORMAT_XBGR8888_SRGB] = _mesa_texstore_srgba8;
-      table[MESA_FORMAT_XBGR8888_UINT] = _mesa_texstore_rgba_uint8;
-      table[MESA_FORMAT_XBGR8888_SINT] = _mesa_texstore_rgba_int8;
-      table[MESA_FORMAT_XRGB2101010_UNORM] = _mesa_texstore_argb2101010;
-      table[MESA_FORMAT_XBGR16161616_UNORM] = _mesa_texstore_rgba_16;
-      table[MESA_FORMAT_XBGR16161616_SNORM] = _mesa_texstore_signed_rgba_16;
-      table[MESA_FORMAT_XBGR16161616_FLOAT] = _mesa_texstore_rgba_float16;
-      table[MESA_FORMAT_XBGR16161616_UINT] = _mesa_texstore_rgba_uint16;
-      table[MESA_FORMAT_XBGR16161616_SINT] = _mesa_texstore_rgba_int16;
-      table[MESA_FORMAT_XBGR32323232_FLOAT] = _mesa_texstore_rgba_float32;
-      table[MESA_FORMAT_XBGR32323232_UINT] = _mesa_texstore_rgba_uint32;
-      table[MESA_FORMAT_XBGR32323232_SINT] = _mesa_texstore_rgba_int32;
-
-      initialized = GL_TRUE;
-   }
-
-   ASSERT(table[format]);
-   return table[format];
+   ASSERT(texstore_funcs[format]);
+   return texstore_funcs[format];
 }
 
 
@@ -3890,6 +4014,118 @@ _mesa_texstore(TEXSTORE_PARAMS)
 }
 
 
+/**
+ * \name Threaded texture stores
+ *
+ * Large converting uploads are split into bands of rows which the worker
+ * threads of parallel.c store with _mesa_texstore() while the calling
+ * thread stores bands too.  Each band is just a smaller image, so the
+ * per-format store functions don't know about it.
+ */
+/*@{*/
+
+/** Uploads smaller than this many bytes are stored on the calling thread */
+#define TEXSTORE_THREAD_MIN_BYTES (4 * 1024 * 1024)
+
+/** Minimum number of rows per band */
+#define TEXSTORE_THREAD_MIN_ROWS 16
+
+struct texstore_job {
+   struct gl_context *ctx;
+   GLuint dims;
+   GLenum baseInternalFormat;
+   gl_format dstFormat;
+   GLint dstRowStride;
+   GLubyte *dstMap;
+   GLint width, height;
+   GLenum format, type;
+   const GLvoid *src;
+   struct gl_pixelstore_attrib packing;
+
+   GLint rowsPerBand;
+   GLboolean success;
+};
+
+
+static void
+store_band(void *data, GLuint band)
+{
+   struct texstore_job *job = (struct texstore_job *) data;
+   const GLint firstRow = band * job->rowsPerBand;
+   const GLint rows = MIN2(job->rowsPerBand, job->height - firstRow);
+   struct gl_pixelstore_attrib packing = job->packing;
+   GLubyte *dstRow = job->dstMap + firstRow * job->dstRowStride;
+
+   packing.SkipRows += firstRow;
+
+   if (!_mesa_texstore(job->ctx, job->dims, job->baseInternalFormat,
+                       job->dstFormat, job->dstRowStride, &dstRow,
+                       job->width, rows, 1,
+                       job->format, job->type, job->src, &packing))
+      job->success = GL_FALSE;
+}
+
+
+/**
+ * Store one mapped slice using the worker threads.
+ *
+ * \return GL_FALSE with nothing stored if the slice should be stored on
+ *         the calling thread instead.
+ */
+static GLboolean
+texstore_threaded(struct gl_context *ctx, GLuint dims,
+                  GLenum baseInternalFormat, gl_format dstFormat,
+                  GLint dstRowStride, GLubyte *dstMap,
+                  GLint width, GLint height,
+                  GLenum format, GLenum type, const GLvoid *src,
+                  const struct gl_pixelstore_attrib *packing,
+                  GLuint numSlices, GLboolean *success)
+{
+   struct texstore_job job;
+   GLint bands;
+
+   /* Compressed formats are stored in whole blocks. */
+   if (_mesa_is_format_compressed(dstFormat) ||
+       (size_t) width * height * numSlices *
+       _mesa_get_format_bytes(dstFormat) < TEXSTORE_THREAD_MIN_BYTES)
+      return GL_FALSE;
+
+   bands = MIN2((GLint) _mesa_parallel_threads(),
+                height / TEXSTORE_THREAD_MIN_ROWS);
+   if (bands < 2)
+      return GL_FALSE;
+
+   job.ctx = ctx;
+   job.dims = dims;
+   job.baseInternalFormat = baseInternalFormat;
+   job.dstFormat = dstFormat;
+   job.dstRowStride = dstRowStride;
+   job.dstMap = dstMap;
+   job.width = width;
+   job.height = height;
+   job.format = format;
+   job.type = type;
+   job.src = src;
+   job.packing = *packing;
+   job.rowsPerBand = (height + bands - 1) / bands;
+   job.success = GL_TRUE;
+
+   /* The image height of 3D sources must not shrink with the bands. */
+   if (job.packing.ImageHeight == 0)
+      job.packing.ImageHeight = height;
+
+   /* Fails if another context is using the pool: store it here. */
+   if (!_mesa_parallel_for((height + job.rowsPerBand - 1) / job.rowsPerBand,
+                           store_band, &job))
+      return GL_FALSE;
+
+   *success = job.success;
+   return GL_TRUE;
+}
+
+/*@}*/
+
+
 /**
  * Normally, we'll only _write_ texel data to a texture when we map it.
  * But if the user is providing depth or stencil values and the texture
@@ -4015,16 +4251,24 @@ store_texsubimage(struct gl_context *ctx,
                                   xoffset, yoffset, width, height,
                                   mapMode, &dstMap, &dstRowStride);
       if (dstMap) {
+         GLboolean stored;
+
+         stored = texstore_threaded(ctx, dims, texImage->_BaseFormat,
+                                    texImage->TexFormat, dstRowStride, dstMap,
+                                    width, height, format, type, src, packing,
+                                    numSlices, &success);
+
          /* Note: we're only storing a 2D (or 1D) slice at a time but we need
           * to pass the right 'dims' value so that GL_UNPACK_SKIP_IMAGES is
           * used for 3D images.
           */
-         success = _mesa_texstore(ctx, dims, texImage->_BaseFormat,
-                                  texImage->TexFormat,
-                                  dstRowStride,
-                                  &dstMap,
-                                  width, height, 1,  /* w, h, d */
-                                  format, type, src, packing);
+         if (!stored)
+            success = _mesa_texstore(ctx, dims, texImage->_BaseFormat,
+                                     texImage->TexFormat,
+                                     dstRowStride,
+                                     &dstMap,
+                                     width, height, 1,  /* w, h, d */
+                                     format, type, src, packing);
 
          ctx->Driver.UnmapTextureImage(ctx, texImage, slice + sliceOffset);
       }
@@ -66,6 +66,9 @@
 	const struct gl_pixelstore_attrib *srcPacking
 
 
+extern void
+_mesa_init_texstore(void);
+
 extern GLboolean
 _mesa_texstore(TEXSTORE_PARAMS);
 
@@ -464,6 +464,9 @@ bind_buffer_range(struct gl_context *ctx, GLuint index,
 
    obj->BufferNames[index] = bufObj->Name;
 
+   /* Transform feedback writes to the buffer behind our back. */
+   bufObj->MinMaxCacheDisabled = GL_TRUE;
+
    obj->Offset[index] = offset;
    obj->RequestedSize[index] = size;
 }
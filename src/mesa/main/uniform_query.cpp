@@ -961,12 +961,16 @@ _mesa_get_uniform_location(struct gl_context *ctx,
    const GLchar *base_name_end;
    long offset = parse_program_resource_name(name, &base_name_end);
    bool array_lookup = offset >= 0;
+   char name_buf[128];
    char *name_copy;
 
    if (array_lookup) {
-      name_copy = (char *) malloc(base_name_end - name + 1);
-      memcpy(name_copy, name, base_name_end - name);
-      name_copy[base_name_end - name] = '\0';
+      const size_t len = base_name_end - name;
+
+      /* Most names fit on the stack */
+      name_copy = len < sizeof(name_buf) ? name_buf : (char *) malloc(len + 1);
+      memcpy(name_copy, name, len);
+      name_copy[len] = '\0';
    } else {
       name_copy = (char *) name;
       offset = 0;
@@ -980,7 +984,7 @@ _mesa_get_uniform_location(struct gl_context *ctx,
 
    /* Free the temporary buffer *before* possibly returning an error.
     */
-   if (name_copy != name)
+   if (name_copy != name && name_copy != name_buf)
       free(name_copy);
 
    if (!found)
@@ -1000,6 +1004,84 @@ _mesa_get_uniform_location(struct gl_context *ctx,
    return location;
 }
 
+static GLint
+get_uniform_location_uncached(struct gl_context *ctx,
+                              struct gl_shader_program *shProg,
+                              const GLchar *name)
+{
+   GLint location = -1;
+   unsigned offset;
+   const unsigned index =
+      _mesa_get_uniform_location(ctx, shProg, name, &offset);
+
+   /* From the GL_ARB_uniform_buffer_object spec:
+    *
+    *     "The value -1 will be returned if <name> does not correspond to an
+    *      active uniform variable name in <program>, if <name> is associated
+    *      with a named uniform block, or if <name> starts with the reserved
+    *      prefix "gl_"."
+    */
+   if (index != GL_INVALID_INDEX &&
+       shProg->UniformStorage[index].block_index == -1)
+      location = _mesa_uniform_merge_location_offset(shProg, index, offset);
+
+   return location;
+}
+
+/**
+ * Fill the glGetUniformLocation() cache of a freshly linked program with the
+ * names of its active uniforms, and of the first element of the arrays.
+ *
+ * The cache is never written afterwards, so that contexts sharing the
+ * program can look it up concurrently.
+ */
+extern "C" void
+_mesa_init_uniform_location_cache(struct gl_context *ctx,
+                                  struct gl_shader_program *shProg)
+{
+   assert(shProg->UniformLocationCache == NULL);
+
+   shProg->UniformLocationCache = new string_to_uint_map;
+
+   for (unsigned i = 0; i < shProg->NumUserUniformStorage; i++) {
+      const struct gl_uniform_storage *const uni = &shProg->UniformStorage[i];
+      GLint location = get_uniform_location_uncached(ctx, shProg, uni->name);
+
+      if (location != -1)
+         shProg->UniformLocationCache->put(location + 1, uni->name);
+
+      if (uni->array_elements) {
+         char *element = ralloc_asprintf(NULL, "%s[0]", uni->name);
+
+         location = get_uniform_location_uncached(ctx, shProg, element);
+         if (location != -1)
+            shProg->UniformLocationCache->put(location + 1, element);
+         ralloc_free(element);
+      }
+   }
+}
+
+/**
+ * glGetUniformLocation() for a linked program.
+ *
+ * Some applications query the locations of all their uniforms every frame,
+ * so the names of the active uniforms are looked up in a cache filled at
+ * link time.  Other names, including unknown ones, take the slow path.
+ */
+extern "C" GLint
+_mesa_get_cached_uniform_location(struct gl_context *ctx,
+                                  struct gl_shader_program *shProg,
+                                  const GLchar *name)
+{
+   unsigned cached;
+
+   if (shProg->UniformLocationCache &&
+       shProg->UniformLocationCache->get(cached, name))
+      return (GLint) cached - 1;
+
+   return get_uniform_location_uncached(ctx, shProg, name);
+}
+
 extern "C" bool
 _mesa_sampler_uniforms_are_valid(const struct gl_shader_program *shProg,
 				 char *errMsg, size_t errMsgLength)
@@ -504,7 +504,6 @@ GLint GLAPIENTRY
 _mesa_GetUniformLocation(GLhandleARB programObj, const GLcharARB *name)
 {
    struct gl_shader_program *shProg;
-   GLuint index, offset;
 
    GET_CURRENT_CONTEXT(ctx);
 
@@ -524,21 +523,7 @@ _mesa_GetUniformLocation(GLhandleARB programObj, const GLcharARB *name)
       return -1;
    }
 
-   index = _mesa_get_uniform_location(ctx, shProg, name, &offset);
-   if (index == GL_INVALID_INDEX)
-      return -1;
-
-   /* From the GL_ARB_uniform_buffer_object spec:
-    *
-    *     "The value -1 will be returned if <name> does not correspond to an
-    *      active uniform variable name in <program>, if <name> is associated
-    *      with a named uniform block, or if <name> starts with the reserved
-    *      prefix "gl_"."
-    */
-   if (shProg->UniformStorage[index].block_index != -1)
-      return -1;
-
-   return _mesa_uniform_merge_location_offset(shProg, index, offset);
+   return _mesa_get_cached_uniform_location(ctx, shProg, name);
 }
 
 GLuint GLAPIENTRY
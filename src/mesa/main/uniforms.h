@@ -176,6 +176,15 @@ unsigned
 _mesa_get_uniform_location(struct gl_context *ctx, struct gl_shader_program *shProg,
 			   const GLchar *name, unsigned *offset);
 
+void
+_mesa_init_uniform_location_cache(struct gl_context *ctx,
+                                  struct gl_shader_program *shProg);
+
+GLint
+_mesa_get_cached_uniform_location(struct gl_context *ctx,
+                                  struct gl_shader_program *shProg,
+                                  const GLchar *name);
+
 void
 _mesa_uniform(struct gl_context *ctx, struct gl_shader_program *shader_program,
 	      GLint location, GLsizei count,
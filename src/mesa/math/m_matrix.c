@@ -40,6 +40,10 @@
 
 #include "m_matrix.h"
 
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
 
 /**
  * \defgroup MatFlags MAT_FLAG_XXX-flags
@@ -162,6 +166,24 @@ static GLfloat Identity[16] = {
  */
 static void matmul4( GLfloat *product, const GLfloat *a, const GLfloat *b )
 {
+#if defined(__SSE__)
+   /* Each column of the product is a linear combination of the columns
+    * of a.  The sums are done in the same order as below so the result
+    * is bit-identical.
+    */
+   const __m128 a0 = _mm_loadu_ps(a + 0);
+   const __m128 a1 = _mm_loadu_ps(a + 4);
+   const __m128 a2 = _mm_loadu_ps(a + 8);
+   const __m128 a3 = _mm_loadu_ps(a + 12);
+   GLint j;
+   for (j = 0; j < 4; j++) {
+      __m128 p = _mm_mul_ps(a0, _mm_set1_ps(B(0,j)));
+      p = _mm_add_ps(p, _mm_mul_ps(a1, _mm_set1_ps(B(1,j))));
+      p = _mm_add_ps(p, _mm_mul_ps(a2, _mm_set1_ps(B(2,j))));
+      p = _mm_add_ps(p, _mm_mul_ps(a3, _mm_set1_ps(B(3,j))));
+      _mm_storeu_ps(&P(0,j), p);
+   }
+#else
    GLint i;
    for (i = 0; i < 4; i++) {
       const GLfloat ai0=A(i,0),  ai1=A(i,1),  ai2=A(i,2),  ai3=A(i,3);
@@ -170,6 +192,7 @@ static void matmul4( GLfloat *product, const GLfloat *a, const GLfloat *b )
       P(i,2) = ai0 * B(0,2) + ai1 * B(1,2) + ai2 * B(2,2) + ai3 * B(3,2);
       P(i,3) = ai0 * B(0,3) + ai1 * B(1,3) + ai2 * B(2,3) + ai3 * B(3,3);
    }
+#endif
 }
 
 /**
@@ -1361,6 +1384,26 @@ static void analyse_from_flags( GLmatrix *mat )
  */
 void
 _math_matrix_analyse( GLmatrix *mat )
+{
+   _math_matrix_analyse_type( mat );
+
+   if (mat->inv && (mat->flags & MAT_DIRTY_INVERSE)) {
+      matrix_invert( mat );
+      mat->flags &= ~MAT_DIRTY_INVERSE;
+   }
+}
+
+/**
+ * Analyze a matrix given that its inverse is not needed yet.
+ *
+ * \param mat matrix.
+ *
+ * Like _math_matrix_analyse() but leaves the inverse dirty, so that it is
+ * only computed by a later _math_matrix_analyse() call from the code that
+ * actually reads GLmatrix::inv.
+ */
+void
+_math_matrix_analyse_type( GLmatrix *mat )
 {
    if (mat->flags & MAT_DIRTY_TYPE) {
       if (mat->flags & MAT_DIRTY_FLAGS)
@@ -1369,11 +1412,6 @@ _math_matrix_analyse( GLmatrix *mat )
 	 analyse_from_flags( mat );
    }
 
-   if (mat->inv && (mat->flags & MAT_DIRTY_INVERSE)) {
-      matrix_invert( mat );
-      mat->flags &= ~MAT_DIRTY_INVERSE;
-   }
-
    mat->flags &= ~(MAT_DIRTY_FLAGS | MAT_DIRTY_TYPE);
 }
 
@@ -134,6 +134,9 @@ _math_matrix_copy( GLmatrix *to, const GLmatrix *from );
 extern void
 _math_matrix_analyse( GLmatrix *mat );
 
+extern void
+_math_matrix_analyse_type( GLmatrix *mat );
+
 extern void
 _math_matrix_print( const GLmatrix *m );
 
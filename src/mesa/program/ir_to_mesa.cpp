@@ -41,6 +41,7 @@
 #include "ir_optimization.h"
 #include "ast.h"
 #include "linker.h"
+#include "pass_stats.h"
 
 #include "main/mtypes.h"
 #include "main/shaderobj.h"
@@ -3061,6 +3062,11 @@ _mesa_ir_link_shader(struct gl_context *ctx, struct gl_shader_program *prog)
          progress = lower_vector_insert(ir, true) || progress;
       } while (progress);
 
+      /* Pack the scalar operations left by the lowering passes back into
+       * vector instructions.
+       */
+      do_vectorize(ir);
+
       validate_ir_tree(ir);
    }
 
@@ -3116,6 +3122,9 @@ _mesa_glsl_link_shader(struct gl_context *ctx, struct gl_shader_program *prog)
       }
    }
 
+   /* Cover the driver's lowering and optimization as well as the linker. */
+   const bool collect_stats = glsl_pass_stats_begin(ctx, "link");
+
    if (prog->LinkStatus) {
       link_shaders(ctx, prog);
    }
@@ -3126,6 +3135,12 @@ _mesa_glsl_link_shader(struct gl_context *ctx, struct gl_shader_program *prog)
       }
    }
 
+   if (prog->LinkStatus)
+      _mesa_init_uniform_location_cache(ctx, prog);
+
+   if (collect_stats)
+      glsl_pass_stats_end(ctx);
+
    if (ctx->Shader.Flags & GLSL_DUMP) {
       if (!prog->LinkStatus) {
 	 printf("GLSL shader program %d failed to link\n", prog->Name);
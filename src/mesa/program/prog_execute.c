@@ -87,6 +87,17 @@ get_src_register_pointer(const struct prog_src_register *source,
    const struct gl_program *prog = machine->CurProgram;
    GLint reg = source->Index;
 
+   if (machine->CurDecodedSrc) {
+      const struct prog_decoded_src *d =
+         &machine->CurDecodedSrc[source - machine->CurSrcReg];
+      ASSERT(source - machine->CurSrcReg < 3);
+      if (d->Ptr) {
+         if (d->PerElement)
+            return d->Ptr + 4 * machine->CurElement;
+         return d->Ptr;
+      }
+   }
+
    if (source->RelAddr) {
       /* add address register value to src index/offset */
       reg += machine->AddressReg[0][0];
@@ -569,6 +580,89 @@ store_vector4ui(const struct prog_instruction *inst,
 
 
 
+/**
+ * Resolve the register pointers of the program's source operands once,
+ * for running the program many times on the same machine, e.g. once for
+ * each fragment of a span.  Operands using relative addressing are still
+ * resolved on each fetch.  The machine's input attribute pointers must be
+ * set up and stay the same until machine->DecodedProgram is reset.
+ *
+ * \return GL_FALSE if out of memory; the program then runs undecoded.
+ */
+GLboolean
+_mesa_decode_program(struct gl_context *ctx,
+                     const struct gl_program *program,
+                     struct gl_program_machine *machine)
+{
+   const GLuint size = program->NumInstructions * 3;
+   GLuint pc;
+
+   machine->DecodedProgram = NULL;
+   machine->CurDecodedSrc = NULL;
+   machine->CurProgram = program;
+
+   if (program->Target == GL_VERTEX_PROGRAM_ARB) {
+      machine->EnvParams = ctx->VertexProgram.Parameters;
+   }
+   else {
+      machine->EnvParams = ctx->FragmentProgram.Parameters;
+   }
+
+   if (size > machine->DecodedSize) {
+      struct prog_decoded_src *decoded =
+         realloc(machine->Decoded, size * sizeof(*decoded));
+      if (!decoded)
+         return GL_FALSE;
+      machine->Decoded = decoded;
+      machine->DecodedSize = size;
+   }
+
+   for (pc = 0; pc < program->NumInstructions; pc++) {
+      const struct prog_instruction *inst = program->Instructions + pc;
+      const GLuint numSrc = _mesa_num_inst_src_regs(inst->Opcode);
+      struct prog_decoded_src *d = machine->Decoded + 3 * pc;
+      GLuint i;
+
+      for (i = 0; i < 3; i++) {
+         const struct prog_src_register *source = &inst->SrcReg[i];
+
+         d[i].Ptr = NULL;
+         d[i].PerElement = GL_FALSE;
+
+         if (i >= numSrc || source->RelAddr)
+            continue;
+
+         switch (source->File) {
+         case PROGRAM_INPUT:
+            if (program->Target == GL_VERTEX_PROGRAM_ARB) {
+               d[i].Ptr = get_src_register_pointer(source, machine);
+            }
+            else if (source->Index < VARYING_SLOT_MAX) {
+               d[i].Ptr = machine->Attribs[source->Index][0];
+               d[i].PerElement = GL_TRUE;
+            }
+            break;
+         case PROGRAM_TEMPORARY:
+         case PROGRAM_OUTPUT:
+         case PROGRAM_LOCAL_PARAM:
+         case PROGRAM_ENV_PARAM:
+         case PROGRAM_STATE_VAR:
+         case PROGRAM_CONSTANT:
+         case PROGRAM_UNIFORM:
+         case PROGRAM_SYSTEM_VALUE:
+            d[i].Ptr = get_src_register_pointer(source, machine);
+            break;
+         default:
+            break;
+         }
+      }
+   }
+
+   machine->DecodedProgram = program;
+   return GL_TRUE;
+}
+
+
 /**
  * Execute the given vertex/fragment program.
  *
@@ -584,6 +678,8 @@ _mesa_execute_program(struct gl_context * ctx,
 {
    const GLuint numInst = program->NumInstructions;
    const GLuint maxExec = 65536;
+   const struct prog_decoded_src *decoded =
+      machine->DecodedProgram == program ? machine->Decoded : NULL;
    GLuint pc, numExec = 0;
 
    machine->CurProgram = program;
@@ -602,6 +698,9 @@ _mesa_execute_program(struct gl_context * ctx,
    for (pc = 0; pc < numInst; pc++) {
       const struct prog_instruction *inst = program->Instructions + pc;
 
+      machine->CurDecodedSrc = decoded ? decoded + 3 * pc : NULL;
+      machine->CurSrcReg = inst->SrcReg;
+
       if (DEBUG_PROG) {
          _mesa_print_instruction(inst);
       }
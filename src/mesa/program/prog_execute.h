@@ -43,6 +43,16 @@ typedef void (*FetchTexelDerivFunc)(struct gl_context *ctx, const GLfloat texcoo
 #define PROG_MAX_WIDTH 16384
 
 
+/**
+ * A source operand's register, resolved once instead of on every fetch.
+ */
+struct prog_decoded_src
+{
+   const GLfloat *Ptr;    /**< register, or NULL if not pre-decoded */
+   GLboolean PerElement;  /**< Ptr is a fragment input, add CurElement */
+};
+
+
 /**
  * Virtual machine state used during execution of vertex/fragment programs.
  */
@@ -75,13 +85,26 @@ struct gl_program_machine
    /** Texture fetch functions */
    FetchTexelLodFunc FetchTexelLod;
    FetchTexelDerivFunc FetchTexelDeriv;
+
+   /** Source operands pre-decoded by _mesa_decode_program() */
+   const struct gl_program *DecodedProgram;
+   struct prog_decoded_src *Decoded;   /**< 3 per instruction */
+   GLuint DecodedSize;
+   const struct prog_decoded_src *CurDecodedSrc; /**< of current instruction */
+   const struct prog_src_register *CurSrcReg;    /**< of current instruction */
 };
 
 
+
 extern void
 _mesa_get_program_register(struct gl_context *ctx, gl_register_file file,
                            GLuint index, GLfloat val[4]);
 
+extern GLboolean
+_mesa_decode_program(struct gl_context *ctx,
+                     const struct gl_program *program,
+                     struct gl_program_machine *machine);
+
 extern GLboolean
 _mesa_execute_program(struct gl_context *ctx,
                       const struct gl_program *program,
@@ -141,6 +141,13 @@ struct ra_node {
     */
    GLboolean in_stack;
 
+   /**
+    * The sum of q(B,C) over the neighbors of this node that are not in
+    * the stack.  Set up at the start of ra_simplify() and updated as
+    * nodes are pushed, so pq_test() doesn't rescan the adjacency list.
+    */
+   unsigned int q_total;
+
    /* For an implementation that needs register spilling, this is the
     * approximate cost of spilling this node.
     */
@@ -397,7 +404,8 @@ ra_add_node_interference(struct ra_graph *g,
    }
 }
 
-static GLboolean pq_test(struct ra_graph *g, unsigned int n)
+static void
+ra_init_q_total(struct ra_graph *g, unsigned int n)
 {
    unsigned int j;
    unsigned int q = 0;
@@ -412,7 +420,40 @@ static GLboolean pq_test(struct ra_graph *g, unsigned int n)
       }
    }
 
-   return q < g->regs->classes[n_class]->p;
+   g->nodes[n].q_total = q;
+}
+
+static GLboolean pq_test(struct ra_graph *g, unsigned int n)
+{
+   int n_class = g->nodes[n].class;
+
+   return g->nodes[n].q_total < g->regs->classes[n_class]->p;
+}
+
+/**
+ * Pushes a node on the stack, removing its edges from the q totals of
+ * its neighbors.
+ */
+static void
+ra_push_node(struct ra_graph *g, unsigned int n)
+{
+   unsigned int j;
+   int n_class = g->nodes[n].class;
+
+   g->stack[g->stack_count] = n;
+   g->stack_count++;
+   g->nodes[n].in_stack = GL_TRUE;
+
+   for (j = 0; j < g->nodes[n].adjacency_count; j++) {
+      unsigned int n2 = g->nodes[n].adjacency_list[j];
+      unsigned int n2_class = g->nodes[n2].class;
+
+      if (n != n2 && !g->nodes[n2].in_stack) {
+	 assert(g->nodes[n2].q_total >=
+		g->regs->classes[n2_class]->q[n_class]);
+	 g->nodes[n2].q_total -= g->regs->classes[n2_class]->q[n_class];
+      }
+   }
 }
 
 /**
@@ -430,6 +471,11 @@ ra_simplify(struct ra_graph *g)
    GLboolean progress = GL_TRUE;
    int i;
 
+   for (i = 0; i < g->count; i++) {
+      if (!g->nodes[i].in_stack)
+	 ra_init_q_total(g, i);
+   }
+
    while (progress) {
       progress = GL_FALSE;
 
@@ -438,9 +484,7 @@ ra_simplify(struct ra_graph *g)
 	    continue;
 
 	 if (pq_test(g, i)) {
-	    g->stack[g->stack_count] = i;
-	    g->stack_count++;
-	    g->nodes[i].in_stack = GL_TRUE;
+	    ra_push_node(g, i);
 	    progress = GL_TRUE;
 	 }
       }
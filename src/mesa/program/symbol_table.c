@@ -23,7 +23,7 @@
 
 #include "main/imports.h"
 #include "symbol_table.h"
-#include "hash_table.h"
+#include "main/hash_table.h"
 
 struct symbol {
     /**
@@ -98,7 +98,16 @@ struct scope_level {
  *
  */
 struct _mesa_symbol_table {
-    /** Hash table containing all symbols in the symbol table. */
+    /**
+     * Hash table containing all symbols in the symbol table.
+     *
+     * This is an open-addressing table that grows with the number of names
+     * and remembers each name's hash, so a lookup only compares strings
+     * once it has found an entry with the right hash.  The built-in
+     * variables, functions and types alone put several hundred names in
+     * every GLSL symbol table, which a fixed number of chained buckets
+     * handled poorly.
+     */
     struct hash_table *ht;
 
     /** Top of scope stack. */
@@ -194,10 +203,21 @@ _mesa_symbol_table_push_scope(struct _mesa_symbol_table *table)
 }
 
 
+static struct symbol_header *
+find_symbol_with_hash(struct _mesa_symbol_table *table, const char *name,
+                      uint32_t hash)
+{
+    struct hash_entry *const entry =
+        _mesa_hash_table_search(table->ht, hash, name);
+
+    return entry ? (struct symbol_header *) entry->data : NULL;
+}
+
+
 static struct symbol_header *
 find_symbol(struct _mesa_symbol_table *table, const char *name)
 {
-    return (struct symbol_header *) hash_table_find(table->ht, name);
+    return find_symbol_with_hash(table, name, _mesa_hash_string(name));
 }
 
 
@@ -327,12 +347,13 @@ _mesa_symbol_table_add_symbol(struct _mesa_symbol_table *table,
                               int name_space, const char *name,
                               void *declaration)
 {
+    const uint32_t hash = _mesa_hash_string(name);
     struct symbol_header *hdr;
     struct symbol *sym;
 
     check_symbol_table(table);
 
-    hdr = find_symbol(table, name);
+    hdr = find_symbol_with_hash(table, name, hash);
 
     check_symbol_table(table);
 
@@ -340,7 +361,7 @@ _mesa_symbol_table_add_symbol(struct _mesa_symbol_table *table,
        hdr = calloc(1, sizeof(*hdr));
        hdr->name = strdup(name);
 
-       hash_table_insert(table->ht, hdr, hdr->name);
+       _mesa_hash_table_insert(table->ht, hash, hdr->name, hdr);
        hdr->next = table->hdr;
        table->hdr = hdr;
     }
@@ -382,6 +403,7 @@ _mesa_symbol_table_add_global_symbol(struct _mesa_symbol_table *table,
 				     int name_space, const char *name,
 				     void *declaration)
 {
+    const uint32_t hash = _mesa_hash_string(name);
     struct symbol_header *hdr;
     struct symbol *sym;
     struct symbol *curr;
@@ -389,7 +411,7 @@ _mesa_symbol_table_add_global_symbol(struct _mesa_symbol_table *table,
 
     check_symbol_table(table);
 
-    hdr = find_symbol(table, name);
+    hdr = find_symbol_with_hash(table, name, hash);
 
     check_symbol_table(table);
 
@@ -397,7 +419,7 @@ _mesa_symbol_table_add_global_symbol(struct _mesa_symbol_table *table,
         hdr = calloc(1, sizeof(*hdr));
         hdr->name = strdup(name);
 
-        hash_table_insert(table->ht, hdr, hdr->name);
+        _mesa_hash_table_insert(table->ht, hash, hdr->name, hdr);
         hdr->next = table->hdr;
         table->hdr = hdr;
     }
@@ -458,8 +480,7 @@ _mesa_symbol_table_ctor(void)
     struct _mesa_symbol_table *table = calloc(1, sizeof(*table));
 
     if (table != NULL) {
-       table->ht = hash_table_ctor(32, hash_table_string_hash,
-				   hash_table_string_compare);
+       table->ht = _mesa_hash_table_create(NULL, _mesa_key_string_equal);
 
        _mesa_symbol_table_push_scope(table);
     }
@@ -484,6 +505,6 @@ _mesa_symbol_table_dtor(struct _mesa_symbol_table *table)
        free(hdr);
    }
 
-   hash_table_dtor(table->ht);
+   _mesa_hash_table_destroy(table->ht, NULL);
    free(table);
 }
@@ -35,6 +35,7 @@
 #include "st_cb_bitmap.h"
 #include "st_program.h"
 #include "st_manager.h"
+#include "util/u_math.h"
 
 
 /**
@@ -75,7 +76,22 @@ static const struct st_tracked_state *atoms[] =
 
 void st_init_atoms( struct st_context *st )
 {
-   /* no-op */
+   GLuint i;
+
+   STATIC_ASSERT(Elements(atoms) <= 32);
+
+   memset(st->atoms_for_mesa_bit, 0, sizeof(st->atoms_for_mesa_bit));
+   memset(st->atoms_for_st_bit, 0, sizeof(st->atoms_for_st_bit));
+
+   for (i = 0; i < Elements(atoms); i++) {
+      unsigned mesa = atoms[i]->dirty.mesa;
+      unsigned st_bits = atoms[i]->dirty.st;
+
+      while (mesa)
+         st->atoms_for_mesa_bit[u_bit_scan(&mesa)] |= 1u << i;
+      while (st_bits)
+         st->atoms_for_st_bit[u_bit_scan(&st_bits)] |= 1u << i;
+   }
 }
 
 
@@ -103,6 +119,25 @@ static void accumulate_state( struct st_state_flags *a,
 }
 
 
+/**
+ * Returns the mask of the atoms depending on any of the flags in \p flags.
+ */
+static GLuint atoms_for_state( const struct st_context *st,
+                               const struct st_state_flags *flags )
+{
+   unsigned mesa = flags->mesa;
+   unsigned st_bits = flags->st;
+   GLuint mask = 0;
+
+   while (mesa)
+      mask |= st->atoms_for_mesa_bit[u_bit_scan(&mesa)];
+   while (st_bits)
+      mask |= st->atoms_for_st_bit[u_bit_scan(&st_bits)];
+
+   return mask;
+}
+
+
 static void xor_states( struct st_state_flags *result,
 			     const struct st_state_flags *a,
 			      const struct st_state_flags *b )
@@ -216,9 +251,22 @@ void st_validate_state( struct st_context *st )
 
    }
    else {
-      for (i = 0; i < Elements(atoms); i++) {	 
-	 if (check_state(state, &atoms[i]->dirty))
-	    atoms[i]->update( st );
+      /* Only visit the atoms depending on the flags that are set.  Atoms
+       * may raise flags for the atoms after them, which then join the
+       * walk; as in the list walk above, earlier atoms are not revisited.
+       */
+      GLuint pending = atoms_for_state(st, state);
+
+      while (pending) {
+         struct st_state_flags prev = *state, generated;
+         GLuint later;
+
+         i = u_bit_scan(&pending);
+         atoms[i]->update( st );
+
+         xor_states(&generated, &prev, state);
+         later = ~0u << i << 1;
+         pending |= atoms_for_state(st, &generated) & later;
       }
    }
 
@@ -43,6 +43,7 @@
 #include "st_program.h"
 
 #include "cso_cache/cso_context.h"
+#include "util/u_inlines.h"
 #include "util/u_math.h"
 
 #include "main/bufferobj.h"
@@ -356,7 +357,8 @@ is_interleaved_arrays(const struct st_vertex_program *vp,
  * \param velements  returns vertex element info
  */
 static boolean
-setup_interleaved_attribs(const struct st_vertex_program *vp,
+setup_interleaved_attribs(struct st_context *st,
+                          const struct st_vertex_program *vp,
                           const struct st_vp_variant *vpv,
                           const struct gl_client_array **arrays,
                           struct pipe_vertex_buffer *vbuffer,
@@ -436,6 +438,7 @@ setup_interleaved_attribs(const struct st_vertex_program *vp,
          return FALSE; /* out-of-memory error probably */
       }
 
+      st_bufferobj_finish_readpixels(st, stobj);
       vbuffer->buffer = stobj->buffer;
       vbuffer->user_buffer = NULL;
       vbuffer->buffer_offset = pointer_to_offset(low_addr);
@@ -488,6 +491,7 @@ setup_non_interleaved_attribs(struct st_context *st,
             return FALSE; /* out-of-memory error probably */
          }
 
+         st_bufferobj_finish_readpixels(st, stobj);
          vbuffer[attr].buffer = stobj->buffer;
          vbuffer[attr].user_buffer = NULL;
          vbuffer[attr].buffer_offset = pointer_to_offset(array->Ptr);
@@ -528,6 +532,63 @@ setup_non_interleaved_attribs(struct st_context *st,
    return TRUE;
 }
 
+/**
+ * Return whether a vertex buffer has to be bound again.  Buffers wrapping
+ * user memory are always rebound, as their contents may have changed.
+ */
+static boolean
+vertex_buffer_changed(const struct pipe_vertex_buffer *old,
+                      const struct pipe_vertex_buffer *vb)
+{
+   return vb->user_buffer || old->user_buffer ||
+          vb->buffer != old->buffer ||
+          vb->buffer_offset != old->buffer_offset ||
+          vb->stride != old->stride;
+}
+
+/**
+ * Bind the vertex buffers, skipping the ones that are unchanged from the
+ * last draw.  That is common when only the vertex program or the array
+ * layout changed, or when VAOs sharing buffers are switched.
+ */
+static void
+set_vertex_buffers(struct st_context *st, unsigned num_vbuffers,
+                   const struct pipe_vertex_buffer *vbuffer)
+{
+   unsigned start = 0, end = num_vbuffers, i;
+
+   if (num_vbuffers == st->last_num_vbuffers) {
+      while (start < end &&
+             !vertex_buffer_changed(&st->last_vbuffers[start], &vbuffer[start]))
+         start++;
+      while (end > start &&
+             !vertex_buffer_changed(&st->last_vbuffers[end - 1], &vbuffer[end - 1]))
+         end--;
+   }
+
+   if (start < end)
+      cso_set_vertex_buffers(st->cso_context, start, end - start,
+                             vbuffer + start);
+
+   if (st->last_num_vbuffers > num_vbuffers) {
+      /* Unbind remaining buffers, if any. */
+      cso_set_vertex_buffers(st->cso_context, num_vbuffers,
+                             st->last_num_vbuffers - num_vbuffers, NULL);
+   }
+
+   for (i = start; i < end; i++) {
+      pipe_resource_reference(&st->last_vbuffers[i].buffer, vbuffer[i].buffer);
+      st->last_vbuffers[i].user_buffer = vbuffer[i].user_buffer;
+      st->last_vbuffers[i].buffer_offset = vbuffer[i].buffer_offset;
+      st->last_vbuffers[i].stride = vbuffer[i].stride;
+   }
+   for (i = num_vbuffers; i < st->last_num_vbuffers; i++) {
+      pipe_resource_reference(&st->last_vbuffers[i].buffer, NULL);
+      st->last_vbuffers[i].user_buffer = NULL;
+   }
+   st->last_num_vbuffers = num_vbuffers;
+}
+
 static void update_array(struct st_context *st)
 {
    struct gl_context *ctx = st->ctx;
@@ -554,7 +615,8 @@ static void update_array(struct st_context *st)
     * Setup the vbuffer[] and velements[] arrays.
     */
    if (is_interleaved_arrays(vp, vpv, arrays)) {
-      if (!setup_interleaved_attribs(vp, vpv, arrays, vbuffer, velements)) {
+      if (!setup_interleaved_attribs(st, vp, vpv, arrays, vbuffer,
+                                     velements)) {
          st->vertex_array_out_of_memory = TRUE;
          return;
       }
@@ -575,13 +637,7 @@ static void update_array(struct st_context *st)
       num_velements = vpv->num_inputs;
    }
 
-   cso_set_vertex_buffers(st->cso_context, 0, num_vbuffers, vbuffer);
-   if (st->last_num_vbuffers > num_vbuffers) {
-      /* Unbind remaining buffers, if any. */
-      cso_set_vertex_buffers(st->cso_context, num_vbuffers,
-                             st->last_num_vbuffers - num_vbuffers, NULL);
-   }
-   st->last_num_vbuffers = num_vbuffers;
+   set_vertex_buffers(st, num_vbuffers, vbuffer);
    cso_set_vertex_elements(st->cso_context, num_velements, velements);
 }
 
@@ -73,6 +73,17 @@ void st_upload_constants( struct st_context *st,
        */
       _mesa_load_state_parameters(st->ctx, params);
 
+      /* _NEW_PROGRAM_CONSTANTS is raised for uniform and state changes of
+       * any stage.  Don't upload and rebind the buffer if this stage's
+       * values are the same as last time.
+       */
+      if (st->state.constants[shader_type].ptr == params->ParameterValues &&
+          st->state.constants[shader_type].size == paramBytes &&
+          st->state.constants[shader_type].uploaded_size == paramBytes &&
+          memcmp(st->state.constants[shader_type].uploaded,
+                 params->ParameterValues, paramBytes) == 0)
+         return;
+
       /* We always need to get a new buffer, to keep the drivers simple and
        * avoid gratuitous rendering synchronization.
        * Let's use a user buffer to avoid an unnecessary copy.
@@ -102,6 +113,17 @@ void st_upload_constants( struct st_context *st,
 
       st->state.constants[shader_type].ptr = params->ParameterValues;
       st->state.constants[shader_type].size = paramBytes;
+
+      /* remember the values for the check above */
+      if (st->state.constants[shader_type].uploaded_size != paramBytes) {
+         free(st->state.constants[shader_type].uploaded);
+         st->state.constants[shader_type].uploaded = malloc(paramBytes);
+         st->state.constants[shader_type].uploaded_size =
+            st->state.constants[shader_type].uploaded ? paramBytes : 0;
+      }
+      if (st->state.constants[shader_type].uploaded)
+         memcpy(st->state.constants[shader_type].uploaded,
+                params->ParameterValues, paramBytes);
    }
    else if (st->state.constants[shader_type].ptr) {
       /* Unbind. */
@@ -194,6 +216,7 @@ static void st_bind_ubos(struct st_context *st,
 
       binding = &st->ctx->UniformBufferBindings[shader->UniformBlocks[i].Binding];
       st_obj = st_buffer_object(binding->BufferObject);
+      st_bufferobj_finish_readpixels(st, st_obj);
 
       cb.buffer = st_obj->buffer;
 
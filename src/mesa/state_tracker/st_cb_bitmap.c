@@ -73,13 +73,15 @@
  * The bitmap cache attempts to accumulate multiple glBitmap calls in a
  * buffer which is then rendered en mass upon a flush, state change, etc.
  * A wide, short buffer is used to target the common case of a series
- * of glBitmap calls being used to draw text.
+ * of glBitmap calls being used to draw text.  It is tall enough to hold
+ * a few lines of text, and only the part that was written to is drawn
+ * when flushing.
  */
 static GLboolean UseBitmapCache = GL_TRUE;
 
 
 #define BITMAP_CACHE_WIDTH  512
-#define BITMAP_CACHE_HEIGHT 32
+#define BITMAP_CACHE_HEIGHT 128
 
 struct bitmap_cache
 {
@@ -324,6 +326,8 @@ make_bitmap_texture(struct gl_context *ctx, GLsizei width, GLsizei height,
 static void
 setup_bitmap_vertex_data(struct st_context *st, bool normalized,
                          int x, int y, int width, int height,
+                         int tex_x, int tex_y,
+                         int tex_width, int tex_height,
                          float z, const float color[4],
 			 struct pipe_resource **vbuf,
 			 unsigned *vbuf_offset)
@@ -334,8 +338,8 @@ setup_bitmap_vertex_data(struct st_context *st, bool normalized,
    const GLfloat x1 = (GLfloat)(x + width);
    const GLfloat y0 = (GLfloat)y;
    const GLfloat y1 = (GLfloat)(y + height);
-   GLfloat sLeft = (GLfloat)0.0, sRight = (GLfloat)1.0;
-   GLfloat tTop = (GLfloat)0.0, tBot = (GLfloat)1.0 - tTop;
+   GLfloat sLeft = (GLfloat)tex_x, sRight = (GLfloat)(tex_x + width);
+   GLfloat tTop = (GLfloat)tex_y, tBot = (GLfloat)(tex_y + height);
    const GLfloat clip_x0 = (GLfloat)(x0 / fb_width * 2.0 - 1.0);
    const GLfloat clip_y0 = (GLfloat)(y0 / fb_height * 2.0 - 1.0);
    const GLfloat clip_x1 = (GLfloat)(x1 / fb_width * 2.0 - 1.0);
@@ -343,10 +347,11 @@ setup_bitmap_vertex_data(struct st_context *st, bool normalized,
    GLuint i;
    float (*vertices)[3][4];  /**< vertex pos + color + texcoord */
 
-   if(!normalized)
-   {
-      sRight = (GLfloat) width;
-      tBot = (GLfloat) height;
+   if (normalized) {
+      sLeft /= tex_width;
+      sRight /= tex_width;
+      tTop /= tex_height;
+      tBot /= tex_height;
    }
 
    if (u_upload_alloc(st->uploader, 0, 4 * sizeof(vertices[0]),
@@ -396,10 +401,13 @@ setup_bitmap_vertex_data(struct st_context *st, bool normalized,
 
 /**
  * Render a glBitmap by drawing a textured quad
+ * \param tex_x, tex_y  position of the quad's lower-left corner in the
+ *                     texture, which may be larger than the quad
  */
 static void
 draw_bitmap_quad(struct gl_context *ctx, GLint x, GLint y, GLfloat z,
                  GLsizei width, GLsizei height,
+                 GLint tex_x, GLint tex_y,
                  struct pipe_sampler_view *sv,
                  const GLfloat *color)
 {
@@ -520,7 +528,9 @@ draw_bitmap_quad(struct gl_context *ctx, GLint x, GLint y, GLfloat z,
 
    /* draw textured quad */
    setup_bitmap_vertex_data(st, sv->texture->target != PIPE_TEXTURE_RECT,
-			    x, y, width, height, z, color, &vbuf, &offset);
+			    x, y, width, height, tex_x, tex_y,
+			    sv->texture->width0, sv->texture->height0,
+			    z, color, &vbuf, &offset);
 
    if (vbuf) {
       util_draw_vertex_buffer(pipe, st->cso_context, vbuf,
@@ -649,11 +659,15 @@ st_flush_bitmap_cache(struct st_context *st)
 
       sv = st_create_texture_sampler_view(st->pipe, cache->texture);
       if (sv) {
+         /* only draw the part of the cache that was written to */
          draw_bitmap_quad(st->ctx,
-                          cache->xpos,
-                          cache->ypos,
+                          cache->xmin,
+                          cache->ymin,
                           cache->zpos,
-                          BITMAP_CACHE_WIDTH, BITMAP_CACHE_HEIGHT,
+                          cache->xmax - cache->xmin,
+                          cache->ymax - cache->ymin,
+                          cache->xmin - cache->xpos,
+                          cache->ymin - cache->ypos,
                           sv,
                           cache->color);
 
@@ -784,7 +798,7 @@ st_Bitmap(struct gl_context *ctx, GLint x, GLint y,
 
       if (sv) {
          draw_bitmap_quad(ctx, x, y, ctx->Current.RasterPos[2],
-                          width, height, sv,
+                          width, height, 0, 0, sv,
                           st->ctx->Current.RasterColor);
 
          pipe_sampler_view_reference(&sv, NULL);
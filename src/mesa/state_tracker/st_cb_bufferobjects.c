@@ -81,6 +81,8 @@ st_bufferobj_free(struct gl_context *ctx, struct gl_buffer_object *obj)
    if (st_obj->buffer) 
       pipe_resource_reference(&st_obj->buffer, NULL);
 
+   pipe_resource_reference(&st_obj->readpix.texture, NULL);
+
    free(st_obj);
 }
 
@@ -121,6 +123,8 @@ st_bufferobj_subdata(struct gl_context *ctx,
       return;
    }
 
+   st_bufferobj_finish_readpixels(st_context(ctx), st_obj);
+
    /* Now that transfers are per-context, we don't have to figure out
     * flushing here.  Usually drivers won't need to flush in this case
     * even if the buffer is currently referenced by hardware - they
@@ -157,6 +161,8 @@ st_bufferobj_get_subdata(struct gl_context *ctx,
       return;
    }
 
+   st_bufferobj_finish_readpixels(st_context(ctx), st_obj);
+
    pipe_buffer_read(st_context(ctx)->pipe, st_obj->buffer,
                     offset, size, data);
 }
@@ -182,6 +188,9 @@ st_bufferobj_data(struct gl_context *ctx,
    struct st_buffer_object *st_obj = st_buffer_object(obj);
    unsigned bind, pipe_usage;
 
+   /* the old contents are being replaced */
+   pipe_resource_reference(&st_obj->readpix.texture, NULL);
+
    if (size && data && st_obj->buffer &&
        st_obj->Base.Size == size && st_obj->Base.Usage == usage) {
       /* Just discard the old contents and write new data.
@@ -283,6 +292,11 @@ st_bufferobj_map_range(struct gl_context *ctx,
    struct st_buffer_object *st_obj = st_buffer_object(obj);
    enum pipe_transfer_usage flags = 0x0;
 
+   if (access & GL_MAP_INVALIDATE_BUFFER_BIT)
+      pipe_resource_reference(&st_obj->readpix.texture, NULL);
+   else
+      st_bufferobj_finish_readpixels(st_context(ctx), st_obj);
+
    if (access & GL_MAP_WRITE_BIT)
       flags |= PIPE_TRANSFER_WRITE;
 
@@ -398,6 +412,9 @@ st_copy_buffer_subdata(struct gl_context *ctx,
    assert(!src->Pointer);
    assert(!dst->Pointer);
 
+   st_bufferobj_finish_readpixels(st_context(ctx), srcObj);
+   st_bufferobj_finish_readpixels(st_context(ctx), dstObj);
+
    u_box_1d(readOffset, size, &box);
 
    pipe->resource_copy_region(pipe, dstObj->buffer, 0, writeOffset, 0, 0,
@@ -405,6 +422,56 @@ st_copy_buffer_subdata(struct gl_context *ctx,
 }
 
 
+/**
+ * Copy the pixels of a deferred glReadPixels (see st_readpixels) from
+ * the staging texture into the buffer.  This is where we finally wait
+ * for the GPU.
+ */
+void
+st_bufferobj_copy_readpixels(struct st_context *st,
+                             struct st_buffer_object *obj)
+{
+   struct pipe_context *pipe = st->pipe;
+   struct pipe_resource *tex = obj->readpix.texture;
+   struct pipe_transfer *tex_xfer, *buf_xfer;
+   const GLuint height = tex->height0;
+   GLintptr start = obj->readpix.offset;
+   const ubyte *src;
+   ubyte *dst;
+   GLuint row;
+
+   if (obj->readpix.stride < 0)
+      start += obj->readpix.stride * (GLint) (height - 1);
+
+   src = pipe_transfer_map(pipe, tex, 0, 0, PIPE_TRANSFER_READ,
+                           0, 0, tex->width0, height, &tex_xfer);
+   if (!src)
+      goto out;
+
+   dst = pipe_buffer_map_range(pipe, obj->buffer, start,
+                               abs(obj->readpix.stride) * (height - 1) +
+                               obj->readpix.row_bytes,
+                               PIPE_TRANSFER_WRITE, &buf_xfer);
+   if (!dst) {
+      pipe_transfer_unmap(pipe, tex_xfer);
+      goto out;
+   }
+
+   dst += obj->readpix.offset - start;
+   for (row = 0; row < height; row++) {
+      memcpy(dst, src, obj->readpix.row_bytes);
+      dst += obj->readpix.stride;
+      src += tex_xfer->stride;
+   }
+
+   pipe_buffer_unmap(pipe, buf_xfer);
+   pipe_transfer_unmap(pipe, tex_xfer);
+
+out:
+   pipe_resource_reference(&obj->readpix.texture, NULL);
+}
+
+
 /* TODO: if buffer wasn't created with appropriate usage flags, need
  * to recreate it now and copy contents -- or possibly create a
  * gallium entrypoint to extend the usage flags and let the driver
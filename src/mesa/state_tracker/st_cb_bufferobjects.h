@@ -44,6 +44,18 @@ struct st_buffer_object
    struct gl_buffer_object Base;
    struct pipe_resource *buffer;     /* GPU storage */
    struct pipe_transfer *transfer; /* In-progress map information */
+
+   /**
+    * Pending glReadPixels result.  The pixels are blitted to a staging
+    * texture and only copied into 'buffer' when the buffer is next used,
+    * so that reading into a PBO doesn't wait for the GPU.
+    */
+   struct {
+      struct pipe_resource *texture; /**< staging texture, or NULL */
+      GLintptr offset;     /**< buffer offset of the first row */
+      GLint stride;        /**< distance between rows, may be negative */
+      GLuint row_bytes;
+   } readpix;
 };
 
 
@@ -55,6 +67,24 @@ st_buffer_object(struct gl_buffer_object *obj)
 }
 
 
+extern void
+st_bufferobj_copy_readpixels(struct st_context *st,
+                             struct st_buffer_object *obj);
+
+
+/**
+ * Store any pending glReadPixels result in the buffer.  Must be called
+ * before the buffer's contents are accessed, by the CPU or the GPU.
+ */
+static INLINE void
+st_bufferobj_finish_readpixels(struct st_context *st,
+                               struct st_buffer_object *obj)
+{
+   if (obj->readpix.texture)
+      st_bufferobj_copy_readpixels(st, obj);
+}
+
+
 extern void
 st_bufferobj_validate_usage(struct st_context *st,
 			    struct st_buffer_object *obj,
@@ -565,6 +565,106 @@ make_texture(struct st_context *st,
 }
 
 
+/**
+ * Return the size in bytes of a glDrawPixels image that can be cached,
+ * or 0 if the image is unpacked in a way which the cache doesn't handle.
+ */
+static GLuint
+drawpixels_cache_image_size(GLsizei width, GLsizei height,
+                            GLenum format, GLenum type,
+                            const struct gl_pixelstore_attrib *unpack)
+{
+   const GLint bpp = _mesa_bytes_per_pixel(format, type);
+
+   if (bpp <= 0 ||
+       unpack->SkipPixels != 0 ||
+       unpack->SkipRows != 0 ||
+       unpack->SwapBytes ||
+       unpack->LsbFirst ||
+       _mesa_is_bufferobj(unpack->BufferObj))
+      return 0;
+
+   return _mesa_image_row_stride(unpack, width, format, type) * (height - 1) +
+          width * bpp;
+}
+
+
+/**
+ * Look for a texture made by an earlier glDrawPixels of the same image.
+ * Applications often draw the same image (a logo, a background) every
+ * frame, which saves a texture allocation and upload each time.
+ * \return  new reference to the texture, or NULL
+ */
+static struct pipe_resource *
+search_drawpixels_cache(struct st_context *st,
+                        GLsizei width, GLsizei height,
+                        GLenum format, GLenum type,
+                        const struct gl_pixelstore_attrib *unpack,
+                        const void *pixels)
+{
+   struct pipe_resource *pt = NULL;
+   const GLuint size = drawpixels_cache_image_size(width, height, format,
+                                                   type, unpack);
+
+   if (size &&
+       st->drawpix_cache.image &&
+       st->drawpix_cache.width == width &&
+       st->drawpix_cache.height == height &&
+       st->drawpix_cache.format == format &&
+       st->drawpix_cache.type == type &&
+       st->drawpix_cache.alignment == unpack->Alignment &&
+       st->drawpix_cache.row_length == unpack->RowLength &&
+       st->drawpix_cache.user_pointer == pixels &&
+       st->drawpix_cache.image_size == size &&
+       memcmp(pixels, st->drawpix_cache.image, size) == 0) {
+      pipe_resource_reference(&pt, st->drawpix_cache.texture);
+   }
+
+   return pt;
+}
+
+
+/**
+ * Remember the image and texture of a glDrawPixels call for
+ * search_drawpixels_cache().
+ */
+static void
+cache_drawpixels_image(struct st_context *st,
+                       GLsizei width, GLsizei height,
+                       GLenum format, GLenum type,
+                       const struct gl_pixelstore_attrib *unpack,
+                       const void *pixels,
+                       struct pipe_resource *pt)
+{
+   const GLuint size = drawpixels_cache_image_size(width, height, format,
+                                                   type, unpack);
+
+   if (!size)
+      return;
+
+   if (st->drawpix_cache.image_size != size) {
+      free(st->drawpix_cache.image);
+      st->drawpix_cache.image = malloc(size);
+      st->drawpix_cache.image_size = st->drawpix_cache.image ? size : 0;
+   }
+
+   if (st->drawpix_cache.image) {
+      memcpy(st->drawpix_cache.image, pixels, size);
+      st->drawpix_cache.width = width;
+      st->drawpix_cache.height = height;
+      st->drawpix_cache.format = format;
+      st->drawpix_cache.type = type;
+      st->drawpix_cache.alignment = unpack->Alignment;
+      st->drawpix_cache.row_length = unpack->RowLength;
+      st->drawpix_cache.user_pointer = pixels;
+      pipe_resource_reference(&st->drawpix_cache.texture, pt);
+   }
+   else {
+      pipe_resource_reference(&st->drawpix_cache.texture, NULL);
+   }
+}
+
+
 /**
  * Draw quad with texcoords and optional color.
  * Coords are gallium window coords with y=0=top.
@@ -1169,7 +1269,14 @@ st_DrawPixels(struct gl_context *ctx, GLint x, GLint y,
    /* draw with textured quad */
    {
       struct pipe_resource *pt
-         = make_texture(st, width, height, format, type, unpack, pixels);
+         = search_drawpixels_cache(st, width, height, format, type,
+                                   unpack, pixels);
+      if (!pt) {
+         pt = make_texture(st, width, height, format, type, unpack, pixels);
+         if (pt)
+            cache_drawpixels_image(st, width, height, format, type,
+                                   unpack, pixels, pt);
+      }
       if (pt) {
          sv[0] = st_create_texture_sampler_view(st->pipe, pt);
 
@@ -1685,6 +1792,10 @@ st_destroy_drawpix(struct st_context *st)
    }
 
    st_reference_fragprog(st, &st->pixel_xfer.combined_prog, NULL);
+
+   free(st->drawpix_cache.image);
+   pipe_resource_reference(&st->drawpix_cache.texture, NULL);
+
    if (st->drawpix.vert_shaders[0])
       cso_delete_vertex_shader(st->cso_context, st->drawpix.vert_shaders[0]);
    if (st->drawpix.vert_shaders[1])
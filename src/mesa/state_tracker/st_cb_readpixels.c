@@ -25,6 +25,7 @@
  * 
  **************************************************************************/
 
+#include "main/bufferobj.h"
 #include "main/image.h"
 #include "main/pbo.h"
 #include "main/imports.h"
@@ -38,6 +39,7 @@
 #include "st_atom.h"
 #include "st_context.h"
 #include "st_cb_bitmap.h"
+#include "st_cb_bufferobjects.h"
 #include "st_cb_readpixels.h"
 #include "state_tracker/st_cb_texture.h"
 #include "state_tracker/st_format.h"
@@ -52,6 +54,10 @@
  *
  * If such a format isn't available, we fall back to _mesa_readpixels.
  *
+ * When reading into a PBO, the copy from the texture into the buffer is
+ * deferred until the buffer is used (see st_bufferobj_finish_readpixels),
+ * so glReadPixels itself doesn't wait for rendering to finish.
+ *
  * NOTE: Some drivers use a blit to convert between tiled and linear
  *       texture layouts during texture uploads/downloads, so the blit
  *       we do here should be free in such cases.
@@ -113,8 +119,10 @@ st_readpixels(struct gl_context *ctx, GLint x, GLint y,
 
    /* See if the texture format already matches the format and type,
     * in which case the memcpy-based fast path will likely be used and
-    * we don't have to blit. */
-   if (_mesa_format_matches_format_and_type(rb->Format, format,
+    * we don't have to blit.  That path maps the renderbuffer though,
+    * which we want to avoid when the destination is a PBO. */
+   if (!_mesa_is_bufferobj(pack->BufferObj) &&
+       _mesa_format_matches_format_and_type(rb->Format, format,
                                             type, pack->SwapBytes)) {
       goto fallback;
    }
@@ -192,6 +200,29 @@ st_readpixels(struct gl_context *ctx, GLint x, GLint y,
    /* blit */
    st->pipe->blit(st->pipe, &blit);
 
+   if (_mesa_is_bufferobj(pack->BufferObj) &&
+       st_buffer_object(pack->BufferObj)->buffer) {
+      struct st_buffer_object *stobj = st_buffer_object(pack->BufferObj);
+      const GLubyte *row0 = _mesa_image_address2d(pack, pixels, width, height,
+                                                   format, type, 0, 0);
+      const GLubyte *row1 = _mesa_image_address2d(pack, pixels, width, height,
+                                                   format, type, 1, 0);
+
+      /* an earlier read into the same buffer must land first */
+      st_bufferobj_finish_readpixels(st, stobj);
+
+      stobj->readpix.texture = dst; /* takes the reference */
+      stobj->readpix.offset = (GLintptr) row0;
+      stobj->readpix.stride = (GLint) (row1 - row0);
+      stobj->readpix.row_bytes = width * util_format_get_blocksize(dst_format);
+
+      /* The buffer may also be bound as a vertex, index, uniform or
+       * texture buffer, make sure the data is there before it's used. */
+      st->dirty.st |= ST_NEW_VERTEX_ARRAYS | ST_NEW_UNIFORM_BUFFER;
+      ctx->NewState |= _NEW_TEXTURE;
+      return;
+   }
+
    /* map resources */
    pixels = _mesa_map_pbo_dest(ctx, pack, pixels);
 
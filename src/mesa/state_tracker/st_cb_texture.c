@@ -611,10 +611,6 @@ st_TexSubImage(struct gl_context *ctx, GLuint dims,
    unsigned bind;
    GLubyte *map;
 
-   if (!st->prefer_blit_based_texture_transfer) {
-      goto fallback;
-   }
-
    if (!dst) {
       goto fallback;
    }
@@ -634,7 +630,13 @@ st_TexSubImage(struct gl_context *ctx, GLuint dims,
 
    /* See if the texture format already matches the format and type,
     * in which case the memcpy-based fast path will likely be used and
-    * we don't have to blit. */
+    * we don't have to blit.
+    *
+    * Otherwise _mesa_texstore would have to convert the pixels on the CPU,
+    * so blit even if the driver doesn't prefer blit-based transfers:
+    * the upload into the staging texture is a plain memcpy and the
+    * conversion is done by the GPU.
+    */
    if (_mesa_format_matches_format_and_type(texImage->TexFormat, format,
                                             type, unpack->SwapBytes)) {
       goto fallback;
@@ -1485,6 +1487,8 @@ st_finalize_texture(struct gl_context *ctx,
    if (tObj->Target == GL_TEXTURE_BUFFER) {
       struct st_buffer_object *st_obj = st_buffer_object(tObj->BufferObject);
 
+      st_bufferobj_finish_readpixels(st, st_obj);
+
       if (st_obj->buffer != stObj->pt) {
          pipe_resource_reference(&stObj->pt, st_obj->buffer);
          pipe_sampler_view_release(st->pipe, &stObj->sampler_view);
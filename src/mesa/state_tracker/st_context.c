@@ -265,6 +265,10 @@ static void st_destroy_context_priv( struct st_context *st )
       }
    }
 
+   for (shader = 0; shader < Elements(st->state.constants); shader++) {
+      free(st->state.constants[shader].uploaded);
+   }
+
    if (st->default_texture) {
       st->ctx->Driver.DeleteTexture(st->ctx, st->default_texture);
       st->default_texture = NULL;
@@ -300,6 +304,10 @@ void st_destroy_context( struct st_context *st )
    }
    pipe_surface_reference(&st->state.framebuffer.zsbuf, NULL);
 
+   for (i = 0; i < Elements(st->last_vbuffers); i++) {
+      pipe_resource_reference(&st->last_vbuffers[i].buffer, NULL);
+   }
+
    pipe->set_index_buffer(pipe, NULL);
 
    for (i = 0; i < PIPE_SHADER_TYPES; i++) {
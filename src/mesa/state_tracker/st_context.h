@@ -113,6 +113,8 @@ struct st_context
       struct {
          void *ptr;
          unsigned size;
+         void *uploaded;     /**< copy of the values last uploaded */
+         unsigned uploaded_size;
       } constants[PIPE_SHADER_TYPES];
       struct pipe_framebuffer_state framebuffer;
       struct pipe_scissor_state scissor;
@@ -129,6 +131,13 @@ struct st_context
 
    struct st_state_flags dirty;
 
+   /**
+    * For each bit of st_state_flags::mesa and st_state_flags::st, the mask
+    * of the state atoms checking it, by index in st_atom.c's atoms[].
+    */
+   GLuint atoms_for_mesa_bit[32];
+   GLuint atoms_for_st_bit[32];
+
    GLboolean missing_textures;
    GLboolean vertdata_edgeflags;
 
@@ -172,6 +181,17 @@ struct st_context
       void *vert_shaders[2];   /**< ureg shaders */
    } drawpix;
 
+   /** Last glDrawPixels image and the texture made from it */
+   struct {
+      GLsizei width, height;
+      GLenum format, type;
+      GLint alignment, row_length;
+      const void *user_pointer;  /**< Last user 'pixels' pointer */
+      void *image;               /**< Copy of the glDrawPixels image data */
+      GLuint image_size;
+      struct pipe_resource *texture;
+   } drawpix_cache;
+
    /** for glClear */
    struct {
       struct pipe_rasterizer_state raster;
@@ -194,6 +214,8 @@ struct st_context
 
    /* The number of vertex buffers from the last call of validate_arrays. */
    unsigned last_num_vbuffers;
+   /* The vertex buffers bound by the last call of validate_arrays. */
+   struct pipe_vertex_buffer last_vbuffers[PIPE_MAX_SHADER_INPUTS];
 
    int32_t draw_stamp;
    int32_t read_stamp;
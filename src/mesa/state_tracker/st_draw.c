@@ -100,7 +100,10 @@ setup_index_buffer(struct st_context *st,
    /* get/create the index buffer object */
    if (_mesa_is_bufferobj(bufobj)) {
       /* indices are in a real VBO */
-      ibuffer->buffer = st_buffer_object(bufobj)->buffer;
+      struct st_buffer_object *stobj = st_buffer_object(bufobj);
+
+      st_bufferobj_finish_readpixels(st, stobj);
+      ibuffer->buffer = stobj->buffer;
       ibuffer->offset = pointer_to_offset(ib->ptr);
    }
    else if (st->indexbuf_uploader) {
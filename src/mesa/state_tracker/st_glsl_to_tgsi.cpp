@@ -437,11 +437,10 @@ public:
 
    void simplify_cmp(void);
 
-   void rename_temp_register(int index, int new_index);
-   int get_first_temp_read(int index);
-   int get_first_temp_write(int index);
-   int get_last_temp_read(int index);
-   int get_last_temp_write(int index);
+   void rename_temp_registers(int *renames);
+   void get_first_temp_read(int *first_reads);
+   void get_last_temp_read_first_temp_write(int *last_reads,
+                                            int *first_writes);
 
    void copy_propagate(void);
    void eliminate_dead_code(void);
@@ -3235,41 +3234,55 @@ glsl_to_tgsi_visitor::simplify_cmp(void)
    delete [] tempWrites;
 }
 
-/* Replaces all references to a temporary register index with another index. */
+/* Replaces all references to temporary registers in one pass over the
+ * instructions.  renames[i] is the new index of temporary i.  A register
+ * may be renamed to one that is itself renamed, the chain is followed. */
 void
-glsl_to_tgsi_visitor::rename_temp_register(int index, int new_index)
+glsl_to_tgsi_visitor::rename_temp_registers(int *renames)
 {
+   int i;
+
+   for (i = 0; i < this->next_temp; i++) {
+      int r = i;
+      while (renames[r] != r)
+         r = renames[r];
+      renames[i] = r;
+   }
+
    foreach_iter(exec_list_iterator, iter, this->instructions) {
       glsl_to_tgsi_instruction *inst = (glsl_to_tgsi_instruction *)iter.get();
       unsigned j;
       
       for (j=0; j < num_inst_src_regs(inst->op); j++) {
-         if (inst->src[j].file == PROGRAM_TEMPORARY && 
-             inst->src[j].index == index) {
-            inst->src[j].index = new_index;
-         }
+         if (inst->src[j].file == PROGRAM_TEMPORARY)
+            inst->src[j].index = renames[inst->src[j].index];
       }
       
-      if (inst->dst.file == PROGRAM_TEMPORARY && inst->dst.index == index) {
-         inst->dst.index = new_index;
-      }
+      if (inst->dst.file == PROGRAM_TEMPORARY)
+         inst->dst.index = renames[inst->dst.index];
    }
 }
 
-int
-glsl_to_tgsi_visitor::get_first_temp_read(int index)
+/* Computes the index of the first instruction reading each temporary
+ * register, or -1 if it's never read.  Reads inside a loop count as being
+ * at the start of the outermost loop.  first_reads must hold next_temp
+ * entries. */
+void
+glsl_to_tgsi_visitor::get_first_temp_read(int *first_reads)
 {
    int depth = 0; /* loop depth */
    int loop_start = -1; /* index of the first active BGNLOOP (if any) */
    unsigned i = 0, j;
    
+   memset(first_reads, -1, sizeof(int) * this->next_temp);
+
    foreach_iter(exec_list_iterator, iter, this->instructions) {
       glsl_to_tgsi_instruction *inst = (glsl_to_tgsi_instruction *)iter.get();
       
       for (j=0; j < num_inst_src_regs(inst->op); j++) {
-         if (inst->src[j].file == PROGRAM_TEMPORARY && 
-             inst->src[j].index == index) {
-            return (depth == 0) ? i : loop_start;
+         if (inst->src[j].file == PROGRAM_TEMPORARY &&
+             first_reads[inst->src[j].index] == -1) {
+            first_reads[inst->src[j].index] = (depth == 0) ? i : loop_start;
          }
       }
       
@@ -3284,95 +3297,60 @@ glsl_to_tgsi_visitor::get_first_temp_read(int index)
       
       i++;
    }
-   
-   return -1;
 }
 
-int
-glsl_to_tgsi_visitor::get_first_temp_write(int index)
+/* Computes, for every temporary register, the index of the last
+ * instruction reading it and of the first instruction writing it, or -1.
+ * Reads inside a loop count as being at the end of the outermost loop and
+ * writes inside a loop as being at its start.  Both arrays must hold
+ * next_temp entries. */
+void
+glsl_to_tgsi_visitor::get_last_temp_read_first_temp_write(int *last_reads,
+                                                          int *first_writes)
 {
    int depth = 0; /* loop depth */
    int loop_start = -1; /* index of the first active BGNLOOP (if any) */
-   int i = 0;
+   bool loop_reads = false; /* any reads pending the end of the loop? */
+   unsigned i = 0, j;
+   int k;
    
+   memset(last_reads, -1, sizeof(int) * this->next_temp);
+   memset(first_writes, -1, sizeof(int) * this->next_temp);
+
    foreach_iter(exec_list_iterator, iter, this->instructions) {
       glsl_to_tgsi_instruction *inst = (glsl_to_tgsi_instruction *)iter.get();
       
-      if (inst->dst.file == PROGRAM_TEMPORARY && inst->dst.index == index) {
-         return (depth == 0) ? i : loop_start;
+      for (j=0; j < num_inst_src_regs(inst->op); j++) {
+         if (inst->src[j].file == PROGRAM_TEMPORARY) {
+            last_reads[inst->src[j].index] = (depth == 0) ? i : -2;
+            loop_reads |= depth != 0;
+         }
+      }
+      
+      if (inst->dst.file == PROGRAM_TEMPORARY &&
+          first_writes[inst->dst.index] == -1) {
+         first_writes[inst->dst.index] = (depth == 0) ? i : loop_start;
       }
       
       if (inst->op == TGSI_OPCODE_BGNLOOP) {
          if(depth++ == 0)
             loop_start = i;
       } else if (inst->op == TGSI_OPCODE_ENDLOOP) {
-         if (--depth == 0)
+         if (--depth == 0) {
             loop_start = -1;
-      }
-      assert(depth >= 0);
-      
-      i++;
-   }
-   
-   return -1;
-}
-
-int
-glsl_to_tgsi_visitor::get_last_temp_read(int index)
-{
-   int depth = 0; /* loop depth */
-   int last = -1; /* index of last instruction that reads the temporary */
-   unsigned i = 0, j;
-   
-   foreach_iter(exec_list_iterator, iter, this->instructions) {
-      glsl_to_tgsi_instruction *inst = (glsl_to_tgsi_instruction *)iter.get();
-      
-      for (j=0; j < num_inst_src_regs(inst->op); j++) {
-         if (inst->src[j].file == PROGRAM_TEMPORARY && 
-             inst->src[j].index == index) {
-            last = (depth == 0) ? i : -2;
+            if (loop_reads) {
+               for (k = 0; k < this->next_temp; k++) {
+                  if (last_reads[k] == -2)
+                     last_reads[k] = i;
+               }
+               loop_reads = false;
+            }
          }
       }
-      
-      if (inst->op == TGSI_OPCODE_BGNLOOP)
-         depth++;
-      else if (inst->op == TGSI_OPCODE_ENDLOOP)
-         if (--depth == 0 && last == -2)
-            last = i;
       assert(depth >= 0);
       
       i++;
    }
-   
-   assert(last >= -1);
-   return last;
-}
-
-int
-glsl_to_tgsi_visitor::get_last_temp_write(int index)
-{
-   int depth = 0; /* loop depth */
-   int last = -1; /* index of last instruction that writes to the temporary */
-   int i = 0;
-   
-   foreach_iter(exec_list_iterator, iter, this->instructions) {
-      glsl_to_tgsi_instruction *inst = (glsl_to_tgsi_instruction *)iter.get();
-      
-      if (inst->dst.file == PROGRAM_TEMPORARY && inst->dst.index == index)
-         last = (depth == 0) ? i : -2;
-      
-      if (inst->op == TGSI_OPCODE_BGNLOOP)
-         depth++;
-      else if (inst->op == TGSI_OPCODE_ENDLOOP)
-         if (--depth == 0 && last == -2)
-            last = i;
-      assert(depth >= 0);
-      
-      i++;
-   }
-   
-   assert(last >= -1);
-   return last;
 }
 
 /*
@@ -3591,25 +3569,27 @@ glsl_to_tgsi_visitor::copy_propagate(void)
 void
 glsl_to_tgsi_visitor::eliminate_dead_code(void)
 {
-   int i;
+   int *last_reads = rzalloc_array(mem_ctx, int, this->next_temp);
+   int *first_writes = rzalloc_array(mem_ctx, int, this->next_temp);
+   int j = 0;
    
-   for (i=0; i < this->next_temp; i++) {
-      int last_read = get_last_temp_read(i);
-      int j = 0;
-      
-      foreach_iter(exec_list_iterator, iter, this->instructions) {
-         glsl_to_tgsi_instruction *inst = (glsl_to_tgsi_instruction *)iter.get();
+   get_last_temp_read_first_temp_write(last_reads, first_writes);
 
-         if (inst->dst.file == PROGRAM_TEMPORARY && inst->dst.index == i &&
-             j > last_read)
-         {
-            iter.remove();
-            delete inst;
-         }
-         
-         j++;
+   foreach_iter(exec_list_iterator, iter, this->instructions) {
+      glsl_to_tgsi_instruction *inst = (glsl_to_tgsi_instruction *)iter.get();
+
+      if (inst->dst.file == PROGRAM_TEMPORARY &&
+          j > last_reads[inst->dst.index])
+      {
+         iter.remove();
+         delete inst;
       }
+      
+      j++;
    }
+
+   ralloc_free(last_reads);
+   ralloc_free(first_writes);
 }
 
 /*
@@ -3771,15 +3751,16 @@ glsl_to_tgsi_visitor::merge_registers(void)
 {
    int *last_reads = rzalloc_array(mem_ctx, int, this->next_temp);
    int *first_writes = rzalloc_array(mem_ctx, int, this->next_temp);
+   int *renames = rzalloc_array(mem_ctx, int, this->next_temp);
    int i, j;
    
    /* Read the indices of the last read and first write to each temp register
     * into an array so that we don't have to traverse the instruction list as 
     * much. */
-   for (i=0; i < this->next_temp; i++) {
-      last_reads[i] = get_last_temp_read(i);
-      first_writes[i] = get_first_temp_write(i);
-   }
+   get_last_temp_read_first_temp_write(last_reads, first_writes);
+
+   for (i=0; i < this->next_temp; i++)
+      renames[i] = i;
    
    /* Start looking for registers with non-overlapping usages that can be 
     * merged together. */
@@ -3798,7 +3779,7 @@ glsl_to_tgsi_visitor::merge_registers(void)
          if (first_writes[i] <= first_writes[j] && 
              last_reads[i] <= first_writes[j])
          {
-            rename_temp_register(j, i); /* Replace all references to j with i.*/
+            renames[j] = i; /* Replace all references to j with i.*/
             
             /* Update the first_writes and last_reads arrays with the new 
              * values for the merged register index, and mark the newly unused 
@@ -3810,8 +3791,12 @@ glsl_to_tgsi_visitor::merge_registers(void)
       }
    }
    
+   /* Rename all merged registers in a single pass. */
+   rename_temp_registers(renames);
+
    ralloc_free(last_reads);
    ralloc_free(first_writes);
+   ralloc_free(renames);
 }
 
 /* Reassign indices to temporary registers by reusing unused indices created 
@@ -3819,17 +3804,26 @@ glsl_to_tgsi_visitor::merge_registers(void)
 void
 glsl_to_tgsi_visitor::renumber_registers(void)
 {
+   int *first_reads = rzalloc_array(mem_ctx, int, this->next_temp);
+   int *renames = rzalloc_array(mem_ctx, int, this->next_temp);
    int i = 0;
    int new_index = 0;
    
+   get_first_temp_read(first_reads);
+
    for (i=0; i < this->next_temp; i++) {
-      if (get_first_temp_read(i) < 0) continue;
-      if (i != new_index)
-         rename_temp_register(i, new_index);
-      new_index++;
+      if (first_reads[i] < 0) {
+         renames[i] = i;
+         continue;
+      }
+      renames[i] = new_index++;
    }
    
+   rename_temp_registers(renames);
    this->next_temp = new_index;
+
+   ralloc_free(first_reads);
+   ralloc_free(renames);
 }
 
 /**
@@ -4937,6 +4931,14 @@ st_translate_program(
 
    /* Emit each instruction in turn:
     */
+   {
+      unsigned num_insns = 0;
+
+      foreach_iter(exec_list_iterator, iter, program->instructions)
+         num_insns++;
+      ureg_reserve_instructions(ureg, num_insns);
+   }
+
    foreach_iter(exec_list_iterator, iter, program->instructions) {
       set_insn_start(t, ureg_get_instruction_number(ureg));
       compile_tgsi_instruction(t, (glsl_to_tgsi_instruction *)iter.get(),
@@ -5076,14 +5078,19 @@ get_mesa_program(struct gl_context *ctx,
 #if 0
    /* Print out some information (for debugging purposes) used by the 
     * optimization passes. */
-   for (i=0; i < v->next_temp; i++) {
-      int fr = v->get_first_temp_read(i);
-      int fw = v->get_first_temp_write(i);
-      int lr = v->get_last_temp_read(i);
-      int lw = v->get_last_temp_write(i);
-      
-      printf("Temp %d: FR=%3d FW=%3d LR=%3d LW=%3d\n", i, fr, fw, lr, lw);
-      assert(fw <= fr);
+   {
+      int *first_reads = rzalloc_array(v->mem_ctx, int, v->next_temp);
+      int *last_reads = rzalloc_array(v->mem_ctx, int, v->next_temp);
+      int *first_writes = rzalloc_array(v->mem_ctx, int, v->next_temp);
+
+      v->get_first_temp_read(first_reads);
+      v->get_last_temp_read_first_temp_write(last_reads, first_writes);
+
+      for (i=0; i < v->next_temp; i++) {
+         printf("Temp %d: FR=%3d FW=%3d LR=%3d\n", i, first_reads[i],
+                first_writes[i], last_reads[i]);
+         assert(first_writes[i] <= first_reads[i]);
+      }
    }
 #endif
 
@@ -5259,6 +5266,11 @@ st_link_shader(struct gl_context *ctx, struct gl_shader_program *prog)
 
       } while (progress);
 
+      /* Pack the scalar operations left by the lowering passes back into
+       * vector instructions.
+       */
+      do_vectorize(ir);
+
       validate_ir_tree(ir);
    }
 
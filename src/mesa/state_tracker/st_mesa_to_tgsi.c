@@ -1042,6 +1042,8 @@ st_translate_mesa_program(
    t->outputMapping = outputMapping;
    t->ureg = ureg;
 
+   ureg_reserve_instructions(ureg, program->NumInstructions);
+
    /*_mesa_print_program(program);*/
 
    /*
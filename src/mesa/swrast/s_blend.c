@@ -1007,3 +1007,56 @@ _swrast_blend_span(struct gl_context *ctx, struct gl_renderbuffer *rb, SWspan *s
    swrast->BlendFunc(ctx, span->end, span->array->mask,
                      span->array->rgba, rbPixels, span->array->ChanType);
 }
+
+
+/**
+ * Blend a horizontal span of GLubyte colors into an 8888 renderbuffer and
+ * store the result, all in one pass over the span.  This replaces the
+ * separate read/blend/write passes for the common
+ * glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA) case.
+ * \return GL_FALSE if the span/renderbuffer can't be handled here.
+ */
+GLboolean
+_swrast_blend_store_span(struct gl_context *ctx, struct gl_renderbuffer *rb,
+                         const SWspan *span)
+{
+   const SWcontext *swrast = CONST_SWRAST_CONTEXT(ctx);
+   const GLubyte (*rgba)[4] = (const GLubyte (*)[4]) span->array->rgba;
+   const GLubyte *mask = span->array->mask;
+   GLuint *dst;
+   GLuint i;
+
+   if (!swrast->_BlendTransparency ||
+       span->array->ChanType != GL_UNSIGNED_BYTE ||
+       (span->arrayMask & SPAN_XY) ||
+       (rb->Format != MESA_FORMAT_ARGB8888 &&
+        rb->Format != MESA_FORMAT_XRGB8888))
+      return GL_FALSE;
+
+   dst = (GLuint *) _swrast_pixel_address(rb, span->x, span->y);
+
+   for (i = 0; i < span->end; i++) {
+      if (mask[i]) {
+         const GLint t = rgba[i][ACOMP];  /* t is in [0, 255] */
+         if (t == 255) {
+            dst[i] = PACK_COLOR_8888(rgba[i][ACOMP], rgba[i][RCOMP],
+                                     rgba[i][GCOMP], rgba[i][BCOMP]);
+         }
+         else if (t != 0) {
+            const GLuint d = dst[i];
+            const GLint dr = (d >> 16) & 0xff;
+            const GLint dg = (d >> 8) & 0xff;
+            const GLint db = d & 0xff;
+            const GLint da = d >> 24;
+            GLint divtemp;
+            const GLint r = DIV255((rgba[i][RCOMP] - dr) * t) + dr;
+            const GLint g = DIV255((rgba[i][GCOMP] - dg) * t) + dg;
+            const GLint b = DIV255((rgba[i][BCOMP] - db) * t) + db;
+            const GLint a = DIV255((rgba[i][ACOMP] - da) * t) + da;
+            dst[i] = PACK_COLOR_8888(a, r, g, b);
+         }
+      }
+   }
+
+   return GL_TRUE;
+}
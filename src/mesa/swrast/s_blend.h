@@ -38,6 +38,11 @@ extern void
 _swrast_blend_span(struct gl_context *ctx, struct gl_renderbuffer *rb, SWspan *span);
 
 
+extern GLboolean
+_swrast_blend_store_span(struct gl_context *ctx, struct gl_renderbuffer *rb,
+                         const SWspan *span);
+
+
 extern void
 _swrast_choose_blend_func(struct gl_context *ctx, GLenum chanType);
 
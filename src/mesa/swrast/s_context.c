@@ -206,6 +206,25 @@ _swrast_update_texture_env( struct gl_context *ctx )
 }
 
 
+/**
+ * Determine if blending is the common glBlendFunc(GL_SRC_ALPHA,
+ * GL_ONE_MINUS_SRC_ALPHA) case which has a fused blend/store span path.
+ */
+static void
+_swrast_update_blend_transparency(struct gl_context *ctx)
+{
+   SWcontext *swrast = SWRAST_CONTEXT(ctx);
+
+   swrast->_BlendTransparency =
+      ctx->Color.Blend[0].EquationRGB == GL_FUNC_ADD &&
+      ctx->Color.Blend[0].EquationA == GL_FUNC_ADD &&
+      ctx->Color.Blend[0].SrcRGB == GL_SRC_ALPHA &&
+      ctx->Color.Blend[0].SrcA == GL_SRC_ALPHA &&
+      ctx->Color.Blend[0].DstRGB == GL_ONE_MINUS_SRC_ALPHA &&
+      ctx->Color.Blend[0].DstA == GL_ONE_MINUS_SRC_ALPHA;
+}
+
+
 /**
  * Determine if we can defer texturing/shading until after Z/stencil
  * testing.  This potentially allows us to skip texturing/shading for
@@ -574,6 +593,9 @@ _swrast_validate_derived( struct gl_context *ctx )
       if (swrast->NewState & (_NEW_COLOR | _NEW_PROGRAM))
          _swrast_update_deferred_texture(ctx);
 
+      if (swrast->NewState & _NEW_COLOR)
+         _swrast_update_blend_transparency(ctx);
+
       if (swrast->NewState & _SWRAST_NEW_RASTERMASK)
  	 _swrast_update_rasterflags( ctx );
 
@@ -827,6 +849,8 @@ _swrast_DestroyContext( struct gl_context *ctx )
 
    free( swrast->SpanArrays );
    free( swrast->ZoomedArrays );
+   free( swrast->BandArrays );
+   free( swrast->FragProgMachine.Decoded );
    free( swrast->TexelBuffer );
 
    free(swrast->stencil_temp.buf1);
@@ -235,6 +235,7 @@ typedef struct
    GLboolean _TextureCombinePrimary;
    GLboolean _FogEnabled;
    GLboolean _DeferredTexture;
+   GLboolean _BlendTransparency; /**< GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA */
 
    /** List/array of the fragment attributes to interpolate */
    GLuint _ActiveAttribs[VARYING_SLOT_MAX];
@@ -303,6 +304,7 @@ typedef struct
     */
    SWspanarrays *SpanArrays;
    SWspanarrays *ZoomedArrays;  /**< For pixel zooming */
+   SWspanarrays *BandArrays;    /**< One per band of banded triangles */
 
    /**
     * Used to buffer N GL_POINTS, instead of rendering one by one.
@@ -215,6 +215,10 @@ run_program(struct gl_context *ctx, SWspan *span, GLuint start, GLuint end)
    struct gl_program_machine *machine = &swrast->FragProgMachine;
    GLuint i;
 
+   /* operands are the same for every fragment of the span */
+   machine->Attribs = span->array->attribs;
+   _mesa_decode_program(ctx, &program->Base, machine);
+
    for (i = start; i < end; i++) {
       if (span->array->mask[i]) {
          init_machine(ctx, machine, program, span, i);
@@ -259,6 +263,8 @@ run_program(struct gl_context *ctx, SWspan *span, GLuint start, GLuint end)
          }
       }
    }
+
+   machine->DecodedProgram = NULL;
 }
 
 
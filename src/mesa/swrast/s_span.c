@@ -1359,6 +1359,11 @@ _swrast_write_rgba_span( struct gl_context *ctx, SWspan *span)
                _swrast_logicop_rgba_span(ctx, rb, span);
             }
             else if ((ctx->Color.BlendEnabled >> buf) & 1) {
+               if (numBuffers == 1 && colorMask[buf] == 0xffffffff &&
+                   _swrast_blend_store_span(ctx, rb, span)) {
+                  /* blended and written in a single pass */
+                  continue;
+               }
                _swrast_blend_span(ctx, rb, span);
             }
 
@@ -35,11 +35,13 @@
 #include "main/imports.h"
 #include "main/macros.h"
 #include "main/mtypes.h"
+#include "main/parallel.h"
 #include "main/state.h"
 #include "main/samplerobj.h"
 #include "program/prog_instruction.h"
 
 #include "s_aatriangle.h"
+#include "s_blend.h"
 #include "s_context.h"
 #include "s_feedback.h"
 #include "s_span.h"
@@ -111,6 +113,155 @@ _swrast_culltriangle( struct gl_context *ctx,
 
 
 
+#if CHAN_BITS == 8
+
+/*
+ * Banded versions of the above, so that tall triangles can be split over
+ * several threads.  See render_banded_triangle().
+ */
+#define NAME flat_rgba_band
+#define BAND_ARGS 1
+#define INTERP_Z 1
+#define SETUP_CODE				\
+   span.interpMask |= SPAN_RGBA;		\
+   span.red = ChanToFixed(v2->color[0]);	\
+   span.green = ChanToFixed(v2->color[1]);	\
+   span.blue = ChanToFixed(v2->color[2]);	\
+   span.alpha = ChanToFixed(v2->color[3]);	\
+   span.redStep = 0;				\
+   span.greenStep = 0;				\
+   span.blueStep = 0;				\
+   span.alphaStep = 0;
+#define RENDER_SPAN( span )  _swrast_write_rgba_span(ctx, &span);
+#include "s_tritemp.h"
+
+#define NAME smooth_rgba_band
+#define BAND_ARGS 1
+#define INTERP_Z 1
+#define INTERP_RGB 1
+#define INTERP_ALPHA 1
+#define RENDER_SPAN( span )  _swrast_write_rgba_span(ctx, &span);
+#include "s_tritemp.h"
+
+
+/** Minimum number of rows a band is worth a thread for */
+#define BAND_MIN_ROWS 32
+
+/** Maximum number of bands a triangle is split into */
+#define MAX_BANDS 8
+
+typedef void (*band_func)(struct gl_context *ctx, const SWvertex *v0,
+                          const SWvertex *v1, const SWvertex *v2,
+                          GLint bandY0, GLint bandY1, SWspanarrays *bandArray);
+
+struct band_job
+{
+   struct gl_context *ctx;
+   const SWvertex *v0, *v1, *v2;
+   band_func func;
+   GLint y0;        /**< first row of the triangle */
+   GLint rows;      /**< rows per band */
+   GLuint bands;
+};
+
+
+static void
+render_band(void *data, GLuint band)
+{
+   const struct band_job *job = (const struct band_job *) data;
+   SWcontext *swrast = SWRAST_CONTEXT(job->ctx);
+   const GLint bandY0 = band == 0 ? 0 : job->y0 + band * job->rows;
+   const GLint bandY1 = band == job->bands - 1 ?
+      INT_MAX : job->y0 + (band + 1) * job->rows;
+
+   job->func(job->ctx, job->v0, job->v1, job->v2,
+             bandY0, bandY1, swrast->BandArrays + band);
+}
+
+
+/**
+ * Render a tall triangle as horizontal bands of rows in parallel.  Each
+ * band writes disjoint rows of the color/depth buffers and uses its own
+ * span arrays.  Only the untextured RGBA paths are banded: stencil
+ * testing and occlusion queries update shared state.
+ *
+ * \return GL_FALSE if the triangle should be rendered serially.
+ */
+static GLboolean
+render_banded_triangle(struct gl_context *ctx, const SWvertex *v0,
+                       const SWvertex *v1, const SWvertex *v2, band_func func)
+{
+   SWcontext *swrast = SWRAST_CONTEXT(ctx);
+   const GLfloat y0 = v0->attrib[VARYING_SLOT_POS][1];
+   const GLfloat y1 = v1->attrib[VARYING_SLOT_POS][1];
+   const GLfloat y2 = v2->attrib[VARYING_SLOT_POS][1];
+   const GLint yMin = IFLOOR(MIN3(y0, y1, y2));
+   const GLint yMax = ICEIL(MAX3(y0, y1, y2));
+   struct band_job job;
+   GLuint i;
+
+   job.bands = MIN2((GLuint) (yMax - yMin) / BAND_MIN_ROWS, MAX_BANDS);
+   if (job.bands < 2)
+      return GL_FALSE;
+
+   job.bands = MIN2(job.bands, _mesa_parallel_threads());
+   if (job.bands < 2 ||
+       ctx->Stencil._Enabled ||
+       ctx->Query.CurrentOcclusionObject)
+      return GL_FALSE;
+
+   if (!swrast->BandArrays) {
+      swrast->BandArrays = malloc(MAX_BANDS * sizeof(SWspanarrays));
+      if (!swrast->BandArrays)
+         return GL_FALSE;
+      for (i = 0; i < MAX_BANDS; i++) {
+         swrast->BandArrays[i].ChanType = CHAN_TYPE;
+         swrast->BandArrays[i].rgba = swrast->BandArrays[i].rgba8;
+      }
+   }
+
+   /* the blend function is otherwise picked lazily by the first span,
+    * which could be on any thread
+    */
+   if (ctx->Color.BlendEnabled & 1) {
+      struct gl_renderbuffer *rb = ctx->DrawBuffer->_ColorDrawBuffers[0];
+      if (rb)
+         _swrast_choose_blend_func(ctx, swrast_renderbuffer(rb)->ColorType);
+   }
+
+   job.ctx = ctx;
+   job.v0 = v0;
+   job.v1 = v1;
+   job.v2 = v2;
+   job.func = func;
+   job.y0 = yMin;
+   job.rows = (yMax - yMin + job.bands - 1) / job.bands;
+
+   return _mesa_parallel_for(job.bands, render_band, &job);
+}
+
+
+static void
+flat_rgba_banded_triangle(struct gl_context *ctx, const SWvertex *v0,
+                          const SWvertex *v1, const SWvertex *v2)
+{
+   if (!render_banded_triangle(ctx, v0, v1, v2, flat_rgba_band))
+      flat_rgba_triangle(ctx, v0, v1, v2);
+}
+
+
+static void
+smooth_rgba_banded_triangle(struct gl_context *ctx, const SWvertex *v0,
+                            const SWvertex *v1, const SWvertex *v2)
+{
+   if (!render_banded_triangle(ctx, v0, v1, v2, smooth_rgba_band))
+      smooth_rgba_triangle(ctx, v0, v1, v2);
+}
+
+#endif /* CHAN_BITS == 8 */
+
+
+
 /*
  * Render an RGB, GL_DECAL, textured triangle.
  * Interpolate S,T only w/out mipmapping or perspective correction.
@@ -1140,7 +1291,7 @@ _swrast_choose_triangle( struct gl_context *ctx )
 #if CHAN_BITS != 8
                USE(general_triangle);
 #else
-               USE(smooth_rgba_triangle);
+               USE(smooth_rgba_banded_triangle);
 #endif
 	 }
 	 else {
@@ -1148,7 +1299,7 @@ _swrast_choose_triangle( struct gl_context *ctx )
 #if CHAN_BITS != 8
             USE(general_triangle);
 #else
-            USE(flat_rgba_triangle);
+            USE(flat_rgba_banded_triangle);
 #endif
 	 }
       }
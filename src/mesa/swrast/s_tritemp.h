@@ -54,6 +54,12 @@
  * Optionally, one may provide one-time setup code per triangle:
  *    SETUP_CODE    - code which is to be executed once per triangle
  *
+ * Optionally, the triangle can be rendered in horizontal bands, one per
+ * thread:
+ *    BAND_ARGS     - adds (GLint bandY0, GLint bandY1, SWspanarrays *bandArray)
+ *                    parameters; only rows bandY0 <= y < bandY1 are
+ *                    rendered, with bandArray as the span arrays
+ *
  * The following macro MUST be defined:
  *    RENDER_SPAN(span) - code to write a span of pixels.
  *
@@ -110,7 +116,12 @@ do {								\
 
 static void NAME(struct gl_context *ctx, const SWvertex *v0,
                                  const SWvertex *v1,
-                                 const SWvertex *v2 )
+                                 const SWvertex *v2
+#ifdef BAND_ARGS
+                                 , GLint bandY0, GLint bandY1,
+                                 SWspanarrays *bandArray
+#endif
+                 )
 {
    typedef struct {
       const SWvertex *v0, *v1;   /* Y(v0) < Y(v1) */
@@ -145,6 +156,9 @@ static void NAME(struct gl_context *ctx, const SWvertex *v0,
 
    INIT_SPAN(span, GL_POLYGON);
    span.y = 0; /* silence warnings */
+#ifdef BAND_ARGS
+   span.array = bandArray;
+#endif
 
 #ifdef INTERP_Z
    (void) fixedToDepthShift;
@@ -804,7 +818,11 @@ static void NAME(struct gl_context *ctx, const SWvertex *v0,
                /* XXX the test for span.y > 0 _shouldn't_ be needed but
                 * it fixes a problem on 64-bit Opterons (bug 4842).
                 */
+#ifdef BAND_ARGS
+               if (span.end > 0 && span.y >= bandY0 && span.y < bandY1) {
+#else
                if (span.end > 0 && span.y >= 0) {
+#endif
                   const GLint len = span.end - 1;
                   (void) len;
 #ifdef INTERP_RGB
@@ -829,6 +847,12 @@ static void NAME(struct gl_context *ctx, const SWvertex *v0,
                span.y++;
                lines--;
 
+#ifdef BAND_ARGS
+               /* rows only increase, the rest belongs to other bands */
+               if (span.y >= bandY1)
+                  return;
+#endif
+
                fxLeftEdge += fdxLeftEdge;
                fxRightEdge += fdxRightEdge;
 
@@ -909,6 +933,7 @@ static void NAME(struct gl_context *ctx, const SWvertex *v0,
 
 #undef SETUP_CODE
 #undef RENDER_SPAN
+#undef BAND_ARGS
 
 #undef PIXEL_TYPE
 #undef BYTES_PER_ROW
@@ -301,6 +301,7 @@ run_vp( struct gl_context *ctx, struct tnl_pipeline_stage *stage )
    struct gl_vertex_program *program = ctx->VertexProgram._Current;
    struct gl_program_machine *machine = &store->machine;
    GLuint outputs[VARYING_SLOT_MAX], numOutputs;
+   GLuint inputs[VERT_ATTRIB_MAX], numInputs;
    GLuint i, j;
 
    if (!program)
@@ -317,6 +318,14 @@ run_vp( struct gl_context *ctx, struct tnl_pipeline_stage *stage )
       }
    }
 
+   /* and of inputs */
+   numInputs = 0;
+   for (i = 0; i < VERT_ATTRIB_MAX; i++) {
+      if (program->Base.InputsRead & BITFIELD64_BIT(i)) {
+         inputs[numInputs++] = i;
+      }
+   }
+
    /* Allocate result vectors.  We delay this until now to avoid allocating
     * memory that would never be used if we don't run the software tnl pipeline.
     */
@@ -330,8 +339,10 @@ run_vp( struct gl_context *ctx, struct tnl_pipeline_stage *stage )
 
    map_textures(ctx, program);
 
+   /* operands resolve to the same registers for every vertex */
+   _mesa_decode_program(ctx, &program->Base, machine);
+
    for (i = 0; i < VB->Count; i++) {
-      GLuint attr;
 
       init_machine(ctx, machine, tnl->CurInstance);
 
@@ -354,20 +365,19 @@ run_vp( struct gl_context *ctx, struct tnl_pipeline_stage *stage )
 #endif
 
       /* the vertex array case */
-      for (attr = 0; attr < VERT_ATTRIB_MAX; attr++) {
-	 if (program->Base.InputsRead & BITFIELD64_BIT(attr)) {
-	    const GLubyte *ptr = (const GLubyte*) VB->AttribPtr[attr]->data;
-	    const GLuint size = VB->AttribPtr[attr]->size;
-	    const GLuint stride = VB->AttribPtr[attr]->stride;
-	    const GLfloat *data = (GLfloat *) (ptr + stride * i);
+      for (j = 0; j < numInputs; j++) {
+         const GLuint attr = inputs[j];
+         const GLubyte *ptr = (const GLubyte*) VB->AttribPtr[attr]->data;
+         const GLuint size = VB->AttribPtr[attr]->size;
+         const GLuint stride = VB->AttribPtr[attr]->stride;
+         const GLfloat *data = (GLfloat *) (ptr + stride * i);
 #ifdef NAN_CHECK
-            check_float(data[0]);
-            check_float(data[1]);
-            check_float(data[2]);
-            check_float(data[3]);
+         check_float(data[0]);
+         check_float(data[1]);
+         check_float(data[2]);
+         check_float(data[3]);
 #endif
-	    COPY_CLEAN_4V(machine->VertAttribs[attr], size, data);
-	 }
+         COPY_CLEAN_4V(machine->VertAttribs[attr], size, data);
       }
 
       /* execute the program */
@@ -403,6 +413,8 @@ run_vp( struct gl_context *ctx, struct tnl_pipeline_stage *stage )
 #endif
    }
 
+   machine->DecodedProgram = NULL;
+
    unmap_textures(ctx, program);
 
    if (program->IsPositionInvariant) {
@@ -509,6 +521,7 @@ dtr(struct tnl_pipeline_stage *stage)
       _mesa_vector4f_free( &store->ndcCoords );
       _mesa_align_free( store->clipmask );
 
+      free( store->machine.Decoded );
       free( store );
       stage->privatePtr = NULL;
    }
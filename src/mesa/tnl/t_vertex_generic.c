@@ -917,14 +917,17 @@ static void NAME( struct gl_context *ctx,					\
 EMIT2(insert_3f_viewport_3, insert_4ub_4f_rgba_4, emit_viewport3_rgba4)
 EMIT2(insert_3f_viewport_3, insert_4ub_4f_bgra_4, emit_viewport3_bgra4)
 EMIT2(insert_3f_3, insert_4ub_4f_rgba_4, emit_xyz3_rgba4)
+EMIT2(insert_4f_4, insert_4ub_4f_rgba_4, emit_xyzw4_rgba4)
 
 EMIT3(insert_4f_viewport_4, insert_4ub_4f_rgba_4, insert_2f_2, emit_viewport4_rgba4_st2)
 EMIT3(insert_4f_viewport_4, insert_4ub_4f_bgra_4, insert_2f_2,  emit_viewport4_bgra4_st2)
 EMIT3(insert_4f_4, insert_4ub_4f_rgba_4, insert_2f_2, emit_xyzw4_rgba4_st2)
+EMIT3(insert_3f_3, insert_4ub_4f_rgba_4, insert_2f_2, emit_xyz3_rgba4_st2)
 
 EMIT4(insert_4f_viewport_4, insert_4ub_4f_rgba_4, insert_2f_2, insert_2f_2, emit_viewport4_rgba4_st2_st2)
 EMIT4(insert_4f_viewport_4, insert_4ub_4f_bgra_4, insert_2f_2, insert_2f_2,  emit_viewport4_bgra4_st2_st2)
 EMIT4(insert_4f_4, insert_4ub_4f_rgba_4, insert_2f_2, insert_2f_2, emit_xyzw4_rgba4_st2_st2)
+EMIT4(insert_3f_3, insert_4ub_4f_rgba_4, insert_2f_2, insert_2f_2, emit_xyz3_rgba4_st2_st2)
 
 
 /* Use the codegen paths to select one of a number of hardwired
@@ -946,9 +949,11 @@ void _tnl_generate_hardwired_emit( struct gl_context *ctx )
 	 else if (vtx->attr[1].emit == insert_4ub_4f_rgba_4) 
 	    func = emit_viewport3_rgba4;
       }
-      else if (vtx->attr[0].emit == insert_3f_3 &&
-	       vtx->attr[1].emit == insert_4ub_4f_rgba_4) {
- 	 func = emit_xyz3_rgba4; 
+      else if (vtx->attr[1].emit == insert_4ub_4f_rgba_4) {
+	 if (vtx->attr[0].emit == insert_3f_3)
+	    func = emit_xyz3_rgba4;
+	 else if (vtx->attr[0].emit == insert_4f_4)
+	    func = emit_xyzw4_rgba4;
       }
       break;
    case 3:
@@ -958,6 +963,8 @@ void _tnl_generate_hardwired_emit( struct gl_context *ctx )
 	       func = emit_viewport4_rgba4_st2;
 	    else if (vtx->attr[0].emit == insert_4f_4) 
 	       func = emit_xyzw4_rgba4_st2;
+	    else if (vtx->attr[0].emit == insert_3f_3)
+	       func = emit_xyz3_rgba4_st2;
 	 }
 	 else if (vtx->attr[1].emit == insert_4ub_4f_bgra_4 &&
 		  vtx->attr[0].emit == insert_4f_viewport_4)
@@ -972,6 +979,8 @@ void _tnl_generate_hardwired_emit( struct gl_context *ctx )
 	       func = emit_viewport4_rgba4_st2_st2;
 	    else if (vtx->attr[0].emit == insert_4f_4) 
 	       func = emit_xyzw4_rgba4_st2_st2;
+	    else if (vtx->attr[0].emit == insert_3f_3)
+	       func = emit_xyz3_rgba4_st2_st2;
 	 }
 	 else if (vtx->attr[1].emit == insert_4ub_4f_bgra_4 &&
 		  vtx->attr[0].emit == insert_4f_viewport_4)
@@ -36,6 +36,7 @@
 #include "main/glheader.h"
 
 struct gl_client_array;
+struct gl_buffer_object;
 struct gl_context;
 struct gl_transform_feedback_object;
 
@@ -155,6 +156,9 @@ vbo_get_minmax_indices(struct gl_context *ctx, const struct _mesa_prim *prim,
                        const struct _mesa_index_buffer *ib,
                        GLuint *min_index, GLuint *max_index, GLuint nr_prims);
 
+void
+vbo_delete_minmax_cache(struct gl_buffer_object *bufferObj);
+
 void vbo_use_buffer_objects(struct gl_context *ctx);
 
 void vbo_always_unmap_buffers(struct gl_context *ctx);
@@ -127,6 +127,10 @@ vbo_draw_method(struct vbo_context *vbo, enum draw_method method)
    if (vbo->last_draw_method != method) {
       struct gl_context *ctx = vbo->exec.ctx;
 
+      /* Gathered array draws must go out before _DrawArrays moves. */
+      if (vbo->last_draw_method == DRAW_ARRAYS)
+         vbo_exec_array_flush(&vbo->exec);
+
       switch (method) {
       case DRAW_ARRAYS:
          ctx->Array._DrawArrays = vbo->exec.array.inputs;
@@ -28,6 +28,7 @@
 
 #include "main/api_arrayelt.h"
 #include "main/glheader.h"
+#include "main/bufferobj.h"
 #include "main/mtypes.h"
 #include "main/vtxfmt.h"
 #include "vbo_context.h"
@@ -67,6 +68,9 @@ void vbo_exec_destroy( struct gl_context *ctx )
    }
 
    vbo_exec_vtx_destroy( exec );
+
+   exec->array.prim_count = 0;
+   _mesa_reference_buffer_object(ctx, &exec->array.ib.obj, NULL);
 }
 
 
@@ -81,6 +85,13 @@ void vbo_exec_invalidate_state( struct gl_context *ctx, GLuint new_state )
    struct vbo_exec_context *exec = &vbo->exec;
 
    if (!exec->validating && new_state & (_NEW_PROGRAM|_NEW_ARRAY)) {
+      /* State changes normally flush gathered draws through
+       * FLUSH_VERTICES() already.  Don't lose them if one didn't, before
+       * _DrawArrays is reset below.
+       */
+      if (vbo->last_draw_method == DRAW_ARRAYS)
+         vbo_exec_array_flush(exec);
+
       exec->array.recalculate_inputs = GL_TRUE;
 
       /* If we ended up here because a VAO was deleted, the _DrawArrays
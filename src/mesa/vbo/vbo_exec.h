@@ -48,7 +48,7 @@ USE OR OTHER DEALINGS IN THE SOFTWARE.
 /**
  * Size of the VBO to use for glBegin/glVertex/glEnd-style rendering.
  */
-#define VBO_VERT_BUFFER_SIZE (1024*64)	/* bytes */
+#define VBO_VERT_BUFFER_SIZE (1024*256)	/* bytes */
 
 
 /** Current vertex program mode */
@@ -104,6 +104,14 @@ struct vbo_exec_context
       GLenum attrtype[VBO_ATTRIB_MAX];
       GLubyte active_sz[VBO_ATTRIB_MAX];
 
+      /* Layout of the last vertices which had a position, installed
+       * again by glBegin so the attribute calls don't have to grow the
+       * vertex one attribute at a time:
+       */
+      GLubyte last_attrsz[VBO_ATTRIB_MAX];
+      GLubyte last_active_sz[VBO_ATTRIB_MAX];
+      GLuint last_vertex_size;
+
       GLfloat *attrptr[VBO_ATTRIB_MAX]; 
       struct gl_client_array arrays[VERT_ATTRIB_MAX];
 
@@ -128,6 +136,16 @@ struct vbo_exec_context
        */
       const struct gl_client_array *inputs[VERT_ATTRIB_MAX];
       GLboolean recalculate_inputs;
+
+      /* Consecutive glDraw*() calls with no state change in between are
+       * gathered here and submitted with a single draw_prims() by
+       * vbo_exec_array_flush():
+       */
+      struct _mesa_prim prim[VBO_MAX_PRIM];
+      GLuint prim_count;
+      struct _mesa_index_buffer ib;  /**< ib.obj is NULL for glDrawArrays */
+      GLboolean index_bounds_valid;
+      GLuint min_index, max_index;
    } array;
 
    /* Which flags to set in vbo_exec_BeginVertices() */
@@ -158,6 +176,7 @@ void vbo_exec_vtx_destroy( struct vbo_exec_context *exec );
 
 
 void vbo_exec_vtx_flush( struct vbo_exec_context *exec, GLboolean unmap );
+void vbo_exec_array_flush( struct vbo_exec_context *exec );
 void vbo_exec_vtx_map( struct vbo_exec_context *exec );
 
 
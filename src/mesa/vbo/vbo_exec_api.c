@@ -226,6 +226,47 @@ vbo_exec_copy_from_current(struct vbo_exec_context *exec)
 }
 
 
+/**
+ * Set up the vertex with the layout of the last vertices drawn, guessing
+ * that the new glBegin/glEnd block specifies the same attributes.  The
+ * ones it doesn't specify just carry their current value.
+ */
+static void
+vbo_exec_predict_vertex(struct vbo_exec_context *exec)
+{
+   struct vbo_context *vbo = vbo_context(exec->ctx);
+   GLfloat *tmp = exec->vtx.vertex;
+   GLuint i;
+
+   assert(exec->vtx.vert_count == 0);
+
+   memcpy(exec->vtx.attrsz, exec->vtx.last_attrsz,
+          sizeof(exec->vtx.attrsz));
+   memcpy(exec->vtx.active_sz, exec->vtx.last_active_sz,
+          sizeof(exec->vtx.active_sz));
+   exec->vtx.vertex_size = exec->vtx.last_vertex_size;
+
+   for (i = 0 ; i < VBO_ATTRIB_MAX ; i++) {
+      if (exec->vtx.attrsz[i]) {
+         exec->vtx.attrptr[i] = tmp;
+         exec->vtx.attrtype[i] = vbo->currval[i].Type;
+         tmp += exec->vtx.attrsz[i];
+      }
+      else
+         exec->vtx.attrptr[i] = NULL; /* will not be dereferenced */
+   }
+
+   vbo_exec_copy_from_current( exec );
+
+   /* If the buffer isn't mapped yet, vbo_exec_vtx_map() does this */
+   if (exec->vtx.buffer_map) {
+      exec->vtx.buffer_ptr = exec->vtx.buffer_map;
+      exec->vtx.max_vert = ((VBO_VERT_BUFFER_SIZE - exec->vtx.buffer_used) /
+                            (exec->vtx.vertex_size * sizeof(GLfloat)));
+   }
+}
+
+
 /**
  * Flush existing data, set new attrib size, replay copied vertices.
  * This is called when we transition from a small vertex attribute size
@@ -691,6 +732,9 @@ static void GLAPIENTRY vbo_exec_Begin( GLenum mode )
    if (exec->vtx.vertex_size && !exec->vtx.attrsz[0])
       vbo_exec_FlushVertices_internal(exec, GL_FALSE);
 
+   if (!exec->vtx.vertex_size && exec->vtx.last_vertex_size)
+      vbo_exec_predict_vertex(exec);
+
    i = exec->vtx.prim_count++;
    exec->vtx.prim[i].mode = mode;
    exec->vtx.prim[i].begin = 1;
@@ -1081,6 +1125,7 @@ void vbo_exec_vtx_init( struct vbo_exec_context *exec )
    }
 
    exec->vtx.vertex_size = 0;
+   exec->vtx.last_vertex_size = 0;
 
    exec->begin_vertices_flags = FLUSH_UPDATE_CURRENT;
 }
@@ -1160,6 +1205,9 @@ void vbo_exec_FlushVertices( struct gl_context *ctx, GLuint flags )
       return;
    }
 
+   /* Submit gathered array draws before anything drawn after them */
+   vbo_exec_array_flush(exec);
+
    /* Flush (draw), and make sure VBO is left unmapped when done */
    vbo_exec_FlushVertices_internal(exec, GL_TRUE);
 
@@ -1178,6 +1226,14 @@ static void reset_attrfv( struct vbo_exec_context *exec )
 {   
    GLuint i;
 
+   if (exec->vtx.attrsz[VBO_ATTRIB_POS]) {
+      memcpy(exec->vtx.last_attrsz, exec->vtx.attrsz,
+             sizeof(exec->vtx.last_attrsz));
+      memcpy(exec->vtx.last_active_sz, exec->vtx.active_sz,
+             sizeof(exec->vtx.last_active_sz));
+      exec->vtx.last_vertex_size = exec->vtx.vertex_size;
+   }
+
    for (i = 0 ; i < VBO_ATTRIB_MAX ; i++) {
       exec->vtx.attrsz[i] = 0;
       exec->vtx.attrtype[i] = GL_FLOAT;
@@ -34,6 +34,7 @@
 #include "main/varray.h"
 #include "main/bufferobj.h"
 #include "main/enums.h"
+#include "main/hash_table.h"
 #include "main/macros.h"
 #include "main/transformfeedback.h"
 
@@ -78,11 +79,157 @@ vbo_check_buffers_are_unmapped(struct gl_context *ctx)
 
 
 
+/**
+ * Largest number of index ranges each buffer object's min/max cache holds;
+ * the cache starts over when it is full.
+ */
+#define VBO_MINMAX_CACHE_MAX_SIZE 64
+
+struct minmax_cache_key {
+   GLintptr offset;
+   GLuint count;
+   GLenum type;
+   GLuint restart;        /**< primitive restart enabled? */
+   GLuint restart_index;
+};
+
+struct minmax_cache_entry {
+   struct minmax_cache_key key;
+   GLuint min;
+   GLuint max;
+};
+
+
+static bool
+vbo_minmax_cache_key_equal(const void *a, const void *b)
+{
+   return memcmp(a, b, sizeof(struct minmax_cache_key)) == 0;
+}
+
+
+static void
+vbo_minmax_cache_delete_entry(struct hash_entry *entry)
+{
+   free(entry->data);
+}
+
+
+static void
+vbo_delete_minmax_table(struct gl_buffer_object *bufferObj)
+{
+   _mesa_hash_table_destroy(bufferObj->MinMaxCache,
+                            vbo_minmax_cache_delete_entry);
+   bufferObj->MinMaxCache = NULL;
+}
+
+
+/**
+ * Free the min/max index and sub-primitive caches of a buffer object.
+ * Called when the buffer object is deleted or its contents changed.
+ */
+void
+vbo_delete_minmax_cache(struct gl_buffer_object *bufferObj)
+{
+   vbo_delete_minmax_table(bufferObj);
+
+   /* The sub-primitive entries are single allocations too. */
+   _mesa_hash_table_destroy(bufferObj->SubPrimCache,
+                            vbo_minmax_cache_delete_entry);
+   bufferObj->SubPrimCache = NULL;
+}
+
+
+/**
+ * Look up the min/max index of an index range of a buffer object.
+ *
+ * The cache is dropped first if the buffer contents changed since the
+ * last lookup.
+ */
+static GLboolean
+vbo_get_minmax_cached(struct gl_buffer_object *bufferObj,
+                      const struct minmax_cache_key *key,
+                      GLuint *min_index, GLuint *max_index)
+{
+   GLboolean found = GL_FALSE;
+
+   if (bufferObj->MinMaxCacheDisabled)
+      return GL_FALSE;
+
+   _glthread_LOCK_MUTEX(bufferObj->MinMaxCacheMutex);
+
+   if (bufferObj->MinMaxCacheDirty) {
+      vbo_delete_minmax_cache(bufferObj);
+      bufferObj->MinMaxCacheDirty = GL_FALSE;
+   }
+   else if (bufferObj->MinMaxCache) {
+      struct hash_entry *result =
+         _mesa_hash_table_search(bufferObj->MinMaxCache,
+                                 _mesa_hash_data(key, sizeof(*key)), key);
+      if (result) {
+         const struct minmax_cache_entry *entry = result->data;
+         *min_index = entry->min;
+         *max_index = entry->max;
+         found = GL_TRUE;
+      }
+   }
+
+   _glthread_UNLOCK_MUTEX(bufferObj->MinMaxCacheMutex);
+
+   return found;
+}
+
+
+static void
+vbo_minmax_cache_store(struct gl_buffer_object *bufferObj,
+                       const struct minmax_cache_key *key,
+                       GLuint min_index, GLuint max_index)
+{
+   const uint32_t hash = _mesa_hash_data(key, sizeof(*key));
+   struct minmax_cache_entry *entry;
+
+   if (bufferObj->MinMaxCacheDisabled)
+      return;
+
+   entry = malloc(sizeof(*entry));
+   if (!entry)
+      return;
+
+   entry->key = *key;
+   entry->min = min_index;
+   entry->max = max_index;
+
+   _glthread_LOCK_MUTEX(bufferObj->MinMaxCacheMutex);
+
+   if (bufferObj->MinMaxCache &&
+       bufferObj->MinMaxCache->entries >= VBO_MINMAX_CACHE_MAX_SIZE)
+      vbo_delete_minmax_table(bufferObj);
+
+   if (!bufferObj->MinMaxCache)
+      bufferObj->MinMaxCache =
+         _mesa_hash_table_create(NULL, vbo_minmax_cache_key_equal);
+
+   /* Another context sharing the buffer may have stored the range first. */
+   if (!bufferObj->MinMaxCache ||
+       _mesa_hash_table_search(bufferObj->MinMaxCache, hash, key)) {
+      free(entry);
+   }
+   else {
+      _mesa_hash_table_insert(bufferObj->MinMaxCache, hash, &entry->key,
+                              entry);
+   }
+
+   _glthread_UNLOCK_MUTEX(bufferObj->MinMaxCacheMutex);
+}
+
+
 /**
  * Compute min and max elements by scanning the index buffer for
  * glDraw[Range]Elements() calls.
  * If primitive restart is enabled, we need to ignore restart
  * indexes when computing min/max.
+ *
+ * Results for index buffer objects are cached per buffer object, until
+ * the buffer contents change.
  */
 static void
 vbo_get_minmax_index(struct gl_context *ctx,
@@ -94,16 +241,31 @@ vbo_get_minmax_index(struct gl_context *ctx,
    const GLboolean restart = ctx->Array._PrimitiveRestart;
    const GLuint restartIndex = _mesa_primitive_restart_index(ctx, ib->type);
    const int index_size = vbo_sizeof_ib_type(ib->type);
+   struct minmax_cache_key key;
    const char *indices;
    GLuint i;
 
    indices = (char *) ib->ptr + prim->start * index_size;
    if (_mesa_is_bufferobj(ib->obj)) {
       GLsizeiptr size = MIN2(count * index_size, ib->obj->Size);
+
+      memset(&key, 0, sizeof(key));
+      key.offset = (GLintptr) indices;
+      key.count = count;
+      key.type = ib->type;
+      key.restart = restart;
+      key.restart_index = restart ? restartIndex : 0;
+
+      if (vbo_get_minmax_cached(ib->obj, &key, min_index, max_index))
+         return;
+
       indices = ctx->Driver.MapBufferRange(ctx, (GLintptr) indices, size,
                                            GL_MAP_READ_BIT, ib->obj);
    }
 
+   /* The restart-free loops are written as plain min/max reductions so that
+    * the compiler can vectorize them.
+    */
    switch (ib->type) {
    case GL_UNSIGNED_INT: {
       const GLuint *ui_indices = (const GLuint *)indices;
@@ -119,8 +281,8 @@ vbo_get_minmax_index(struct gl_context *ctx,
       }
       else {
          for (i = 0; i < count; i++) {
-            if (ui_indices[i] > max_ui) max_ui = ui_indices[i];
-            if (ui_indices[i] < min_ui) min_ui = ui_indices[i];
+            max_ui = MAX2(max_ui, ui_indices[i]);
+            min_ui = MIN2(min_ui, ui_indices[i]);
          }
       }
       *min_index = min_ui;
@@ -141,8 +303,8 @@ vbo_get_minmax_index(struct gl_context *ctx,
       }
       else {
          for (i = 0; i < count; i++) {
-            if (us_indices[i] > max_us) max_us = us_indices[i];
-            if (us_indices[i] < min_us) min_us = us_indices[i];
+            max_us = MAX2(max_us, us_indices[i]);
+            min_us = MIN2(min_us, us_indices[i]);
          }
       }
       *min_index = min_us;
@@ -163,8 +325,8 @@ vbo_get_minmax_index(struct gl_context *ctx,
       }
       else {
          for (i = 0; i < count; i++) {
-            if (ub_indices[i] > max_ub) max_ub = ub_indices[i];
-            if (ub_indices[i] < min_ub) min_ub = ub_indices[i];
+            max_ub = MAX2(max_ub, ub_indices[i]);
+            min_ub = MIN2(min_ub, ub_indices[i]);
          }
       }
       *min_index = min_ub;
@@ -178,6 +340,7 @@ vbo_get_minmax_index(struct gl_context *ctx,
 
    if (_mesa_is_bufferobj(ib->obj)) {
       ctx->Driver.UnmapBuffer(ctx, ib->obj);
+      vbo_minmax_cache_store(ib->obj, &key, *min_index, *max_index);
    }
 }
 
@@ -501,6 +664,7 @@ vbo_bind_arrays(struct gl_context *ctx)
    vbo_draw_method(vbo, DRAW_ARRAYS);
 
    if (exec->array.recalculate_inputs) {
+      vbo_exec_array_flush(exec);
       recalculate_input_bindings(ctx);
       exec->array.recalculate_inputs = GL_FALSE;
 
@@ -552,6 +716,152 @@ vbo_handle_primitive_restart(struct gl_context *ctx,
 }
 
 
+/**
+ * Submit the draws gathered by vbo_exec_draw_prims() with one
+ * draw_prims() call.
+ */
+void
+vbo_exec_array_flush(struct vbo_exec_context *exec)
+{
+   struct gl_context *ctx = exec->ctx;
+
+   if (exec->array.prim_count == 0)
+      return;
+
+   vbo_handle_primitive_restart(ctx, exec->array.prim, exec->array.prim_count,
+                                exec->array.ib.obj ? &exec->array.ib : NULL,
+                                exec->array.index_bounds_valid,
+                                exec->array.min_index, exec->array.max_index);
+
+   exec->array.prim_count = 0;
+   _mesa_reference_buffer_object(ctx, &exec->array.ib.obj, NULL);
+}
+
+
+/**
+ * Whether the prims of a draw call can wait in exec->array.prim[] for the
+ * next draw call or state change.  Client memory may change as soon as
+ * the call returns, so everything the draw reads must be in buffer objects.
+ */
+static GLboolean
+vbo_can_gather_draw(struct gl_context *ctx,
+                    GLuint nr_prims,
+                    const struct _mesa_index_buffer *ib)
+{
+   struct vbo_exec_context *exec = &vbo_context(ctx)->exec;
+
+   if (nr_prims > VBO_MAX_PRIM)
+      return GL_FALSE;
+
+   if (ib) {
+      if (!_mesa_is_bufferobj(ib->obj))
+         return GL_FALSE;
+
+      if ((GLintptr) ib->ptr % vbo_sizeof_ib_type(ib->type) != 0)
+         return GL_FALSE;
+
+      if (ctx->Const.PrimitiveRestartInSoftware &&
+          ctx->Array._PrimitiveRestart)
+         return GL_FALSE;
+   }
+
+   return vbo_all_varyings_in_vbos(exec->array.inputs);
+}
+
+
+/**
+ * Whether a draw can be added to the ones already in exec->array.prim[].
+ * All of them must share one index buffer, and the prims address it
+ * relative to the first draw's index pointer.
+ */
+static GLboolean
+vbo_draw_fits_gathered(const struct vbo_exec_context *exec,
+                       GLuint nr_prims,
+                       const struct _mesa_index_buffer *ib)
+{
+   if (exec->array.prim_count + nr_prims > VBO_MAX_PRIM)
+      return GL_FALSE;
+
+   if (!ib)
+      return exec->array.ib.obj == NULL;
+
+   return exec->array.ib.obj == ib->obj &&
+          exec->array.ib.type == ib->type &&
+          (const GLubyte *) ib->ptr >= (const GLubyte *) exec->array.ib.ptr;
+}
+
+
+/**
+ * Draw, or gather the prims for drawing together with the following draw
+ * calls.  The gathered prims are submitted by vbo_exec_array_flush(), from
+ * FLUSH_VERTICES() on the next state change or when a draw can't be added.
+ */
+static void
+vbo_exec_draw_prims(struct gl_context *ctx,
+                    const struct _mesa_prim *prim,
+                    GLuint nr_prims,
+                    const struct _mesa_index_buffer *ib,
+                    GLboolean index_bounds_valid,
+                    GLuint min_index,
+                    GLuint max_index)
+{
+   struct vbo_exec_context *exec = &vbo_context(ctx)->exec;
+   GLuint start_offset = 0;
+   GLuint i;
+
+   check_buffers_are_unmapped(exec->array.inputs);
+
+   if (!vbo_can_gather_draw(ctx, nr_prims, ib)) {
+      vbo_exec_array_flush(exec);
+      vbo_handle_primitive_restart(ctx, prim, nr_prims, ib,
+                                   index_bounds_valid, min_index, max_index);
+      return;
+   }
+
+   if (exec->array.prim_count && !vbo_draw_fits_gathered(exec, nr_prims, ib))
+      vbo_exec_array_flush(exec);
+
+   if (exec->array.prim_count == 0) {
+      exec->array.index_bounds_valid = index_bounds_valid;
+      exec->array.min_index = min_index;
+      exec->array.max_index = max_index;
+
+      if (ib) {
+         exec->array.ib.count = 0;
+         exec->array.ib.type = ib->type;
+         exec->array.ib.ptr = ib->ptr;
+         _mesa_reference_buffer_object(ctx, &exec->array.ib.obj, ib->obj);
+      }
+   }
+   else if (exec->array.index_bounds_valid && index_bounds_valid) {
+      exec->array.min_index = MIN2(exec->array.min_index, min_index);
+      exec->array.max_index = MAX2(exec->array.max_index, max_index);
+   }
+   else {
+      exec->array.index_bounds_valid = GL_FALSE;
+   }
+
+   if (ib) {
+      start_offset = ((const GLubyte *) ib->ptr -
+                      (const GLubyte *) exec->array.ib.ptr) /
+                     vbo_sizeof_ib_type(ib->type);
+   }
+
+   for (i = 0; i < nr_prims; i++) {
+      struct _mesa_prim *p = &exec->array.prim[exec->array.prim_count++];
+
+      *p = prim[i];
+      if (ib) {
+         p->start += start_offset;
+         exec->array.ib.count = MAX2(exec->array.ib.count,
+                                     p->start + p->count);
+      }
+   }
+
+   ctx->Driver.NeedFlush |= FLUSH_STORED_VERTICES;
+}
+
+
 /**
  * Helper function called by the other DrawArrays() functions below.
  * This is where we handle primitive restart for drawing non-indexed
@@ -562,8 +872,6 @@ static void
 vbo_draw_arrays(struct gl_context *ctx, GLenum mode, GLint start,
                 GLsizei count, GLuint numInstances, GLuint baseInstance)
 {
-   struct vbo_context *vbo = vbo_context(ctx);
-   struct vbo_exec_context *exec = &vbo->exec;
    struct _mesa_prim prim[2];
 
    vbo_bind_arrays(ctx);
@@ -610,9 +918,8 @@ vbo_draw_arrays(struct gl_context *ctx, GLenum mode, GLint start,
 
       if (primCount > 0) {
          /* draw one or two prims */
-         check_buffers_are_unmapped(exec->array.inputs);
-         vbo->draw_prims(ctx, prim, primCount, NULL,
-                         GL_TRUE, start, start + count - 1, NULL);
+         vbo_exec_draw_prims(ctx, prim, primCount, NULL,
+                             GL_TRUE, start, start + count - 1);
       }
    }
    else {
@@ -620,10 +927,8 @@ vbo_draw_arrays(struct gl_context *ctx, GLenum mode, GLint start,
       prim[0].start = start;
       prim[0].count = count;
 
-      check_buffers_are_unmapped(exec->array.inputs);
-      vbo->draw_prims(ctx, prim, 1, NULL,
-                      GL_TRUE, start, start + count - 1,
-                      NULL);
+      vbo_exec_draw_prims(ctx, prim, 1, NULL,
+                          GL_TRUE, start, start + count - 1);
    }
 
    if (MESA_DEBUG_FLAGS & DEBUG_ALWAYS_FLUSH) {
@@ -909,8 +1214,6 @@ vbo_validated_drawrangeelements(struct gl_context *ctx, GLenum mode,
 				GLint basevertex, GLuint numInstances,
 				GLuint baseInstance)
 {
-   struct vbo_context *vbo = vbo_context(ctx);
-   struct vbo_exec_context *exec = &vbo->exec;
    struct _mesa_index_buffer ib;
    struct _mesa_prim prim[1];
 
@@ -964,9 +1267,7 @@ vbo_validated_drawrangeelements(struct gl_context *ctx, GLenum mode,
     * for the latter case elsewhere.
     */
 
-   check_buffers_are_unmapped(exec->array.inputs);
-   vbo_handle_primitive_restart(ctx, prim, 1, &ib,
-                                index_bounds_valid, start, end);
+   vbo_exec_draw_prims(ctx, prim, 1, &ib, index_bounds_valid, start, end);
 
    if (MESA_DEBUG_FLAGS & DEBUG_ALWAYS_FLUSH) {
       _mesa_flush(ctx);
@@ -1255,8 +1556,6 @@ vbo_validated_multidrawelements(struct gl_context *ctx, GLenum mode,
 				GLsizei primcount,
 				const GLint *basevertex)
 {
-   struct vbo_context *vbo = vbo_context(ctx);
-   struct vbo_exec_context *exec = &vbo->exec;
    struct _mesa_index_buffer ib;
    struct _mesa_prim *prim;
    unsigned int index_type_size = vbo_sizeof_ib_type(type);
@@ -1328,9 +1627,7 @@ vbo_validated_multidrawelements(struct gl_context *ctx, GLenum mode,
 	    prim[i].basevertex = 0;
       }
 
-      check_buffers_are_unmapped(exec->array.inputs);
-      vbo_handle_primitive_restart(ctx, prim, primcount, &ib,
-                                   GL_FALSE, ~0, ~0);
+      vbo_exec_draw_prims(ctx, prim, primcount, &ib, GL_FALSE, ~0, ~0);
    } else {
       /* render one prim at a time */
       for (i = 0; i < primcount; i++) {
@@ -1354,9 +1651,7 @@ vbo_validated_multidrawelements(struct gl_context *ctx, GLenum mode,
 	 else
 	    prim[0].basevertex = 0;
 
-         check_buffers_are_unmapped(exec->array.inputs);
-         vbo_handle_primitive_restart(ctx, prim, 1, &ib,
-                                      GL_FALSE, ~0, ~0);
+         vbo_exec_draw_prims(ctx, prim, 1, &ib, GL_FALSE, ~0, ~0);
       }
    }
 
@@ -1430,6 +1725,7 @@ vbo_draw_transform_feedback(struct gl_context *ctx, GLenum mode,
     * (like in DrawArrays), but we have no way to know how many vertices
     * will be rendered. */
 
+   vbo_exec_array_flush(exec);
    check_buffers_are_unmapped(exec->array.inputs);
    vbo->draw_prims(ctx, prim, 1, NULL,
                    GL_TRUE, 0, 0, obj);
@@ -342,6 +342,12 @@ vbo_exec_vtx_map( struct vbo_exec_context *exec )
 
    exec->vtx.buffer_ptr = exec->vtx.buffer_map;
 
+   if (exec->vtx.buffer_map && exec->vtx.vertex_size) {
+      /* The vertex layout was set up by glBegin before mapping */
+      exec->vtx.max_vert = ((VBO_VERT_BUFFER_SIZE - exec->vtx.buffer_used) /
+                            (exec->vtx.vertex_size * sizeof(GLfloat)));
+   }
+
    if (!exec->vtx.buffer_map) {
       /* out of memory */
       _mesa_install_exec_vtxfmt( ctx, &exec->vtxfmt_noop );
@@ -30,6 +30,7 @@
 
 #include "main/imports.h"
 #include "main/bufferobj.h"
+#include "main/hash_table.h"
 #include "main/macros.h"
 #include "main/varray.h"
 
@@ -47,14 +48,15 @@
  * We map the index buffer, find the restart indexes, unmap
  * the index buffer then draw the sub-primitives delineated by the restarts.
  *
- * A couple possible optimizations:
- * 1. Save the list of sub-primitive (start, count) values in a list attached
- *    to the index buffer for re-use in subsequent draws.  The list would be
- *    invalidated when the contents of the buffer changed.
- * 2. If drawing triangle strips or quad strips, create a new index buffer
- *    that uses duplicated vertices to render the disjoint strips as one
- *    long strip.  We'd have to be careful to avoid using too much memory
- *    for this.
+ * The list of sub-primitives found in an index buffer object is cached
+ * with the buffer (see sub_prim_cache_lookup()), so drawing the same range
+ * again doesn't map and scan the buffer.  The cache shares the min/max
+ * index cache's invalidation: it's dropped when the contents change.
+ *
+ * A possible optimization: if drawing triangle strips or quad strips,
+ * create a new index buffer that uses duplicated vertices to render the
+ * disjoint strips as one long strip.  We'd have to be careful to avoid
+ * using too much memory for this.
  *
  * Finally, some apps might perform better if they don't use primitive restart
  * at all rather than this fallback path.  Set MESA_EXTENSION_OVERRIDE to
@@ -153,6 +155,134 @@ find_sub_primitives(const void *elements, unsigned element_size,
 }
 
 
+/**
+ * Largest number of index ranges each buffer object's sub-primitive cache
+ * holds; the cache starts over when it is full.
+ */
+#define SUB_PRIM_CACHE_MAX_SIZE 64
+
+struct sub_prim_cache_key
+{
+   GLintptr offset;
+   GLuint count;
+   GLenum type;
+   GLuint restart_index;
+};
+
+struct sub_prim_cache_entry
+{
+   struct sub_prim_cache_key key;
+   GLuint num_sub_prims;
+   struct sub_primitive sub_prims[1];   /**< num_sub_prims entries */
+};
+
+
+static bool
+sub_prim_cache_key_equal(const void *a, const void *b)
+{
+   return memcmp(a, b, sizeof(struct sub_prim_cache_key)) == 0;
+}
+
+
+static void
+sub_prim_cache_delete_entry(struct hash_entry *entry)
+{
+   free(entry->data);
+}
+
+
+/**
+ * Look up the sub-primitives of an index range of a buffer object.
+ * \return a malloc'd copy of the sub-primitives, or NULL if not cached
+ */
+static struct sub_primitive *
+sub_prim_cache_lookup(struct gl_buffer_object *bufferObj,
+                      const struct sub_prim_cache_key *key,
+                      GLuint *num_sub_prims)
+{
+   struct sub_primitive *sub_prims = NULL;
+
+   if (bufferObj->MinMaxCacheDisabled)
+      return NULL;
+
+   _glthread_LOCK_MUTEX(bufferObj->MinMaxCacheMutex);
+
+   if (bufferObj->MinMaxCacheDirty) {
+      vbo_delete_minmax_cache(bufferObj);
+      bufferObj->MinMaxCacheDirty = GL_FALSE;
+   }
+   else if (bufferObj->SubPrimCache) {
+      struct hash_entry *result =
+         _mesa_hash_table_search(bufferObj->SubPrimCache,
+                                 _mesa_hash_data(key, sizeof(*key)), key);
+      if (result) {
+         const struct sub_prim_cache_entry *entry = result->data;
+         const size_t size = entry->num_sub_prims * sizeof(*sub_prims);
+
+         /* Copied, as another context may drop the entry meanwhile. */
+         sub_prims = malloc(MAX2(size, 1));
+         if (sub_prims) {
+            memcpy(sub_prims, entry->sub_prims, size);
+            *num_sub_prims = entry->num_sub_prims;
+         }
+      }
+   }
+
+   _glthread_UNLOCK_MUTEX(bufferObj->MinMaxCacheMutex);
+
+   return sub_prims;
+}
+
+
+static void
+sub_prim_cache_store(struct gl_buffer_object *bufferObj,
+                     const struct sub_prim_cache_key *key,
+                     const struct sub_primitive *sub_prims,
+                     GLuint num_sub_prims)
+{
+   const uint32_t hash = _mesa_hash_data(key, sizeof(*key));
+   struct sub_prim_cache_entry *entry;
+
+   if (bufferObj->MinMaxCacheDisabled)
+      return;
+
+   entry = malloc(sizeof(*entry) +
+                  MAX2(num_sub_prims, 1) * sizeof(*sub_prims) -
+                  sizeof(entry->sub_prims));
+   if (!entry)
+      return;
+
+   entry->key = *key;
+   entry->num_sub_prims = num_sub_prims;
+   memcpy(entry->sub_prims, sub_prims, num_sub_prims * sizeof(*sub_prims));
+
+   _glthread_LOCK_MUTEX(bufferObj->MinMaxCacheMutex);
+
+   if (bufferObj->SubPrimCache &&
+       bufferObj->SubPrimCache->entries >= SUB_PRIM_CACHE_MAX_SIZE) {
+      _mesa_hash_table_destroy(bufferObj->SubPrimCache,
+                               sub_prim_cache_delete_entry);
+      bufferObj->SubPrimCache = NULL;
+   }
+
+   if (!bufferObj->SubPrimCache)
+      bufferObj->SubPrimCache =
+         _mesa_hash_table_create(NULL, sub_prim_cache_key_equal);
+
+   /* Another context sharing the buffer may have stored the range first. */
+   if (!bufferObj->SubPrimCache ||
+       _mesa_hash_table_search(bufferObj->SubPrimCache, hash, key)) {
+      free(entry);
+   }
+   else {
+      _mesa_hash_table_insert(bufferObj->SubPrimCache, hash, &entry->key,
+                              entry);
+   }
+
+   _glthread_UNLOCK_MUTEX(bufferObj->MinMaxCacheMutex);
+}
+
+
 /**
  * Handle primitive restart in software.
  *
@@ -177,24 +307,45 @@ vbo_sw_primitive_restart(struct gl_context *ctx,
    struct vbo_context *vbo = vbo_context(ctx);
    vbo_draw_func draw_prims_func = vbo->draw_prims;
    GLboolean map_ib = ib->obj->Name && !ib->obj->Pointer;
+   struct sub_prim_cache_key key;
    void *ptr;
 
+   if (ib->obj->Name) {
+      memset(&key, 0, sizeof(key));
+      key.offset = (GLintptr) ib->ptr;
+      key.count = ib->count;
+      key.type = ib->type;
+      key.restart_index = restart_index;
+
+      sub_prims = sub_prim_cache_lookup(ib->obj, &key, &num_sub_prims);
+      if (sub_prims)
+         map_ib = GL_FALSE;
+   }
+   else {
+      sub_prims = NULL;
+   }
+
    /* Find the sub-primitives. These are regions in the index buffer which
     * are split based on the primitive restart index value.
     */
-   if (map_ib) {
-      ctx->Driver.MapBufferRange(ctx, 0, ib->obj->Size, GL_MAP_READ_BIT,
-                                 ib->obj);
-   }
+   if (!sub_prims) {
+      if (map_ib) {
+         ctx->Driver.MapBufferRange(ctx, 0, ib->obj->Size, GL_MAP_READ_BIT,
+                                    ib->obj);
+      }
 
-   ptr = ADD_POINTERS(ib->obj->Pointer, ib->ptr);
+      ptr = ADD_POINTERS(ib->obj->Pointer, ib->ptr);
 
-   sub_prims = find_sub_primitives(ptr, vbo_sizeof_ib_type(ib->type),
-                                   0, ib->count, restart_index,
-                                   &num_sub_prims);
+      sub_prims = find_sub_primitives(ptr, vbo_sizeof_ib_type(ib->type),
+                                      0, ib->count, restart_index,
+                                      &num_sub_prims);
+
+      if (map_ib) {
+         ctx->Driver.UnmapBuffer(ctx, ib->obj);
+      }
 
-   if (map_ib) {
-      ctx->Driver.UnmapBuffer(ctx, ib->obj);
+      if (sub_prims && ib->obj->Name)
+         sub_prim_cache_store(ib->obj, &key, sub_prims, num_sub_prims);
    }
 
    /* Loop over the primitives, and use the located sub-primitives to draw
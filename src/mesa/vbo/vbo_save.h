@@ -81,6 +81,13 @@ struct vbo_save_vertex_list {
    struct _mesa_prim *prim;
    GLuint prim_count;
 
+   /* The prims as a single indexed GL_TRIANGLES list, with duplicated
+    * vertices referred to by one index.  Built when the list is compiled,
+    * NULL if the prims couldn't be converted.
+    */
+   struct gl_buffer_object *merged_index_obj;
+   GLuint merged_index_count;
+
    struct vbo_save_vertex_store *vertex_store;
    struct vbo_save_primitive_store *prim_store;
 };
@@ -73,6 +73,7 @@ USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "main/dlist.h"
 #include "main/enums.h"
 #include "main/eval.h"
+#include "main/hash_table.h"
 #include "main/macros.h"
 #include "main/api_validate.h"
 #include "main/api_arrayelt.h"
@@ -336,6 +337,169 @@ merge_prims(struct gl_context *ctx,
    *prim_count = prev_prim - prim_list + 1;
 }
 
+/**
+ * Number of GL_TRIANGLES indices needed to draw a prim, or -1 if the prim
+ * can't be drawn as independent triangles.
+ */
+static GLint
+merged_index_count(const struct _mesa_prim *prim)
+{
+   if (!prim->begin || !prim->end ||
+       prim->basevertex != 0 || prim->num_instances != 1)
+      return -1;
+
+   switch (prim->mode) {
+   case GL_TRIANGLES:
+      return prim->count - prim->count % 3;
+   case GL_TRIANGLE_STRIP:
+   case GL_TRIANGLE_FAN:
+      return prim->count >= 3 ? 3 * (prim->count - 2) : 0;
+   default:
+      return -1;
+   }
+}
+
+
+/**
+ * Find, for each vertex of the node, the first vertex with identical
+ * contents.
+ */
+static void
+find_duplicate_vertices(const GLfloat *vertices, GLuint count,
+                        GLuint vertex_size, GLushort *remap)
+{
+   const GLuint vertex_bytes = vertex_size * sizeof(GLfloat);
+   GLuint table_size = 1;
+   GLint *table;
+   GLuint i;
+
+   while (table_size < 2 * count)
+      table_size <<= 1;
+
+   table = malloc(table_size * sizeof(GLint));
+   if (!table) {
+      for (i = 0; i < count; i++)
+         remap[i] = i;
+      return;
+   }
+
+   memset(table, 0xff, table_size * sizeof(GLint));
+
+   for (i = 0; i < count; i++) {
+      const GLfloat *v = vertices + i * vertex_size;
+      GLuint slot = _mesa_hash_data(v, vertex_bytes) & (table_size - 1);
+
+      while (table[slot] >= 0 &&
+             memcmp(vertices + table[slot] * vertex_size, v,
+                    vertex_bytes) != 0)
+         slot = (slot + 1) & (table_size - 1);
+
+      if (table[slot] < 0)
+         table[slot] = i;
+
+      remap[i] = table[slot];
+   }
+
+   free(table);
+}
+
+
+/**
+ * Convert the triangle prims of a node into one indexed GL_TRIANGLES
+ * list, so that playback is a single draw however many glBegin/glEnd
+ * pairs the list was compiled from.
+ *
+ * Strips are unrolled with the vertex order of last vertex provoking, so
+ * playback uses the original prims under GL_FIRST_VERTEX_CONVENTION.
+ */
+static void
+build_merged_indices(struct gl_context *ctx,
+                     struct vbo_save_vertex_list *node,
+                     const GLfloat *vertices)
+{
+   GLushort *remap, *indices;
+   GLuint total = 0, n = 0;
+   GLuint i, j;
+
+   node->merged_index_obj = NULL;
+   node->merged_index_count = 0;
+
+   /* A single prim is already a single draw.  Edge flags only apply to
+    * independent triangles, so strips and fans carrying them must stay.
+    */
+   if (node->prim_count < 2 || node->attrsz[VBO_ATTRIB_EDGEFLAG] ||
+       node->count == 0 || node->count > 0xffff)
+      return;
+
+   for (i = 0; i < node->prim_count; i++) {
+      GLint count = merged_index_count(&node->prim[i]);
+      if (count < 0)
+         return;
+      total += count;
+   }
+
+   if (total == 0)
+      return;
+
+   remap = malloc(node->count * sizeof(GLushort));
+   indices = malloc(total * sizeof(GLushort));
+   if (!remap || !indices)
+      goto done;
+
+   find_duplicate_vertices(vertices, node->count, node->vertex_size, remap);
+
+   for (i = 0; i < node->prim_count; i++) {
+      const struct _mesa_prim *prim = &node->prim[i];
+      const GLushort *v = remap + prim->start;
+
+      switch (prim->mode) {
+      case GL_TRIANGLES:
+         for (j = 0; j + 2 < prim->count; j += 3) {
+            indices[n++] = v[j];
+            indices[n++] = v[j + 1];
+            indices[n++] = v[j + 2];
+         }
+         break;
+      case GL_TRIANGLE_STRIP:
+         for (j = 0; j + 2 < prim->count; j++) {
+            /* keep the winding of odd triangles */
+            indices[n++] = v[j + (j & 1)];
+            indices[n++] = v[j + 1 - (j & 1)];
+            indices[n++] = v[j + 2];
+         }
+         break;
+      case GL_TRIANGLE_FAN:
+         for (j = 0; j + 2 < prim->count; j++) {
+            indices[n++] = v[0];
+            indices[n++] = v[j + 1];
+            indices[n++] = v[j + 2];
+         }
+         break;
+      }
+   }
+
+   assert(n == total);
+
+   node->merged_index_obj =
+      ctx->Driver.NewBufferObject(ctx, VBO_BUF_ID, GL_ELEMENT_ARRAY_BUFFER_ARB);
+   if (node->merged_index_obj) {
+      if (ctx->Driver.BufferData(ctx, GL_ELEMENT_ARRAY_BUFFER_ARB,
+                                 total * sizeof(GLushort), indices,
+                                 GL_STATIC_DRAW_ARB,
+                                 node->merged_index_obj)) {
+         node->merged_index_count = total;
+      }
+      else {
+         _mesa_reference_buffer_object(ctx, &node->merged_index_obj, NULL);
+      }
+   }
+
+done:
+   free(indices);
+   free(remap);
+}
+
+
 /**
  * Insert the active immediate struct onto the display list currently
  * being built.
@@ -416,6 +580,8 @@ _save_compile_vertex_list(struct gl_context *ctx)
 
    merge_prims(ctx, node->prim, &node->prim_count);
 
+   build_merged_indices(ctx, node, save->buffer);
+
    /* Deal with GL_COMPILE_AND_EXECUTE:
     */
    if (ctx->ExecuteFlag) {
@@ -1491,6 +1657,8 @@ vbo_destroy_vertex_list(struct gl_context *ctx, void *data)
 
    free(node->current_data);
    node->current_data = NULL;
+
+   _mesa_reference_buffer_object(ctx, &node->merged_index_obj, NULL);
 }
 
 
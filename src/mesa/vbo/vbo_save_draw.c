@@ -305,7 +305,32 @@ vbo_save_playback_vertex_list(struct gl_context *ctx, void *data)
       if (ctx->NewState)
 	 _mesa_update_state( ctx );
 
-      if (node->count > 0) {
+      /* The merged triangle list is indexed, so primitive restart would
+       * cut it wherever a vertex happens to have the restart index.
+       */
+      if (node->merged_index_obj &&
+          ctx->Light.ProvokingVertex != GL_FIRST_VERTEX_CONVENTION &&
+          !ctx->Array._PrimitiveRestart) {
+         struct _mesa_index_buffer ib;
+         struct _mesa_prim prim;
+
+         memset(&prim, 0, sizeof(prim));
+         prim.mode = GL_TRIANGLES;
+         prim.indexed = 1;
+         prim.begin = 1;
+         prim.end = 1;
+         prim.count = node->merged_index_count;
+         prim.num_instances = 1;
+
+         ib.count = node->merged_index_count;
+         ib.type = GL_UNSIGNED_SHORT;
+         ib.obj = node->merged_index_obj;
+         ib.ptr = NULL;
+
+         vbo_context(ctx)->draw_prims(ctx, &prim, 1, &ib,
+                                      GL_TRUE, 0, node->count - 1, NULL);
+      }
+      else if (node->count > 0) {
          vbo_context(ctx)->draw_prims(ctx, 
                                       node->prim,
                                       node->prim_count,
@@ -43,6 +43,7 @@
 
 extern void _mesa_x86_64_cpuid(unsigned int *regs);
 
+DECLARE_XFORM_GROUP( x86_64, 3 )
 DECLARE_XFORM_GROUP( x86_64, 4 )
 DECLARE_XFORM_GROUP( 3dnow, 4 )
 
@@ -90,6 +91,11 @@ void _mesa_init_all_x86_64_transform_asm(void)
    _mesa_transform_tab[4][MATRIX_3D] =
       _mesa_x86_64_transform_points4_3d;
 
+   _mesa_transform_tab[3][MATRIX_GENERAL] =
+      _mesa_x86_64_transform_points3_general;
+   _mesa_transform_tab[3][MATRIX_3D] =
+      _mesa_x86_64_transform_points3_3d;
+
    regs[0] = 0x80000001;
    regs[1] = 0x00000000;
    regs[2] = 0x00000000;